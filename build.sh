@@ -13,6 +13,7 @@ ANTLR_DIR=$ROOT_DIR/third_party/antlr/lib/cpp
 
 CONFIG=Debug
 MAKE_CONFIG_RELEASE=false
+MAKE_OPTIMIZATION_ARGS=
 REBUILD=
 while (( "$#" )); do
   if [[ "$1" == "--release" ]]
@@ -25,6 +26,27 @@ while (( "$#" )); do
   elif [[ "$1" == "--rebuild" ]]
   then 
     REBUILD=--always-make
+  # Link time optimization of the debugger, its library and ANTLR.
+  elif [[ "$1" == "--lto" ]]
+  then
+    MAKE_OPTIMIZATION_ARGS+=" LTO=true"
+  # Instruments the debugger to collect a profile, see the pgo_training
+  # target of google_cloud_debugger_test.
+  elif [[ "$1" == "--pgo-generate" ]]
+  then
+    MAKE_OPTIMIZATION_ARGS+=" PGO_GENERATE=true"
+  # Optimizes the debugger with a profile collected by pgo_training.
+  elif [[ "$1" == --pgo-use=* ]]
+  then
+    MAKE_OPTIMIZATION_ARGS+=" PGO_USE=$(readlink -f "${1#--pgo-use=}")"
+  # Compiles in the trace spans that --trace-file writes.
+  elif [[ "$1" == "--tracing" ]]
+  then
+    MAKE_OPTIMIZATION_ARGS+=" TRACING=true"
+  # Parses expressions with the ANTLR generated parser.
+  elif [[ "$1" == "--antlr-parser" ]]
+  then
+    MAKE_OPTIMIZATION_ARGS+=" ANTLR_PARSER=true"
   fi
   shift
 done
@@ -42,8 +64,8 @@ then
   fi
   msbuild $DEBUGGER_DIR/google_cloud_debugger.sln //p:Configuration=$CONFIG //p:Platform=x64
 else
-  make $REBUILD -C $ANTLR_DIR RELEASE=$MAKE_CONFIG_RELEASE
-  make $REBUILD -C $DEBUGGER_DIR/google_cloud_debugger_lib RELEASE=$MAKE_CONFIG_RELEASE 
-  make $REBUILD -C $DEBUGGER_DIR/google_cloud_debugger RELEASE=$MAKE_CONFIG_RELEASE
-  make $REBUILD -C $DEBUGGER_DIR/google_cloud_debugger_test RELEASE=$MAKE_CONFIG_RELEASE
+  make $REBUILD -C $ANTLR_DIR RELEASE=$MAKE_CONFIG_RELEASE $MAKE_OPTIMIZATION_ARGS
+  make $REBUILD -C $DEBUGGER_DIR/google_cloud_debugger_lib RELEASE=$MAKE_CONFIG_RELEASE $MAKE_OPTIMIZATION_ARGS
+  make $REBUILD -C $DEBUGGER_DIR/google_cloud_debugger RELEASE=$MAKE_CONFIG_RELEASE $MAKE_OPTIMIZATION_ARGS
+  make $REBUILD -C $DEBUGGER_DIR/google_cloud_debugger_test RELEASE=$MAKE_CONFIG_RELEASE $MAKE_OPTIMIZATION_ARGS
 fi
@@ -0,0 +1,76 @@
+#!/bin/bash
+
+# This script runs the benchmarks of the debugger and compares their
+# results with the baselines in benchmark_baselines. It fails if a result
+# regressed beyond its tolerance.
+# This script assumes that build.sh and build-deps.sh have been run, with
+# --release to compare with the baselines.
+#
+# --update-baselines replaces the baselines with the results of this run.
+# Only do that on the machine the baselines were recorded on.
+
+set -e
+
+SCRIPT=$(readlink -f "$0")
+ROOT_DIR=$(dirname "$SCRIPT")
+
+AGENT_DIR=$ROOT_DIR/src/Google.Cloud.Diagnostics.Debug
+TEST_DIR=$ROOT_DIR/src/google_cloud_debugger/google_cloud_debugger_test
+BASELINE_DIR=$TEST_DIR/benchmark_baselines
+
+CONFIG=Debug
+MAKE_CONFIG_RELEASE=false
+UPDATE_BASELINES=false
+while (( "$#" )); do
+  if [[ "$1" == "--release" ]]
+  then
+    CONFIG=Release
+    MAKE_CONFIG_RELEASE=true
+  elif [[ "$1" == "--update-baselines" ]]
+  then
+    UPDATE_BASELINES=true
+  fi
+  shift
+done
+
+export LD_LIBRARY_PATH=$ROOT_DIR/third_party/coreclr/bin/Product/Linux.x64.$CONFIG
+
+make -C $TEST_DIR RELEASE=$MAKE_CONFIG_RELEASE benchmarks
+
+# The PDBs of the agent and the test application are parsed.
+dotnet publish $AGENT_DIR/Google.Cloud.Diagnostics.Debug --configuration $CONFIG
+dotnet publish $AGENT_DIR/Google.Cloud.Diagnostics.Debug.TestApp --configuration $CONFIG
+ASSEMBLIES="$AGENT_DIR/Google.Cloud.Diagnostics.Debug/bin/$CONFIG/netcoreapp2.0/publish/Google.Cloud.Diagnostics.Debug.dll
+  $AGENT_DIR/Google.Cloud.Diagnostics.Debug.TestApp/bin/$CONFIG/netcoreapp2.0/publish/Google.Cloud.Diagnostics.Debug.TestApp.dll"
+
+export BENCHMARK_RESULTS_DIR=$(mktemp -d)
+trap "rm -rf $BENCHMARK_RESULTS_DIR" EXIT
+
+cd $TEST_DIR
+./breakpoint_client_benchmark
+./breakpoint_client_benchmark --length-prefixed-framing
+./string_conversion_benchmark
+./pdb_parsing_benchmark $ASSEMBLIES
+./expression_benchmark
+./snapshot_benchmark
+./number_format_benchmark
+
+echo
+REGRESSED=false
+for RESULTS in $BENCHMARK_RESULTS_DIR/*.json
+do
+  if ! ./benchmark_regression $BASELINE_DIR/$(basename $RESULTS) $RESULTS
+  then
+    REGRESSED=true
+  fi
+done
+
+if [[ "$UPDATE_BASELINES" == true ]]
+then
+  cp $BENCHMARK_RESULTS_DIR/*.json $BASELINE_DIR/
+  echo "Updated the baselines in $BASELINE_DIR."
+elif [[ "$REGRESSED" == true ]]
+then
+  echo "Some benchmarks regressed."
+  exit 1
+fi
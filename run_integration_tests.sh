@@ -12,6 +12,7 @@ AGENT_DIR=$ROOT_DIR/src/Google.Cloud.Diagnostics.Debug
 
 PERFORMANCE_TESTS=false
 LONG_RUNNING_TESTS=false
+SOAK_TESTS=false
 INTEGRATION_TESTS=true
 CONFIG=Debug
 
@@ -25,6 +26,13 @@ while (( "$#" )); do
   elif [[ "$1" == "--long-running-tests" ]]
   then
     LONG_RUNNING_TESTS=true
+  # Hammers the debugger with log points and snapshots for the given
+  # number of minutes and checks that its memory, threads and handles
+  # stay flat.
+  elif [[ "$1" == --soak-tests=* ]]
+  then
+    SOAK_TESTS=true
+    export SOAK_TEST_DURATION_MINUTES=${1#--soak-tests=}
   elif [[ "$1" == "--release" ]]
   then
     CONFIG=Release
@@ -52,5 +60,10 @@ fi
 
 if [[ "$LONG_RUNNING_TESTS" == true ]]
 then
-  dotnet test $AGENT_DIR/Google.Cloud.Diagnostics.Debug.LongRunningTests --configuration $CONFIG
+  dotnet test $AGENT_DIR/Google.Cloud.Diagnostics.Debug.LongRunningTests --configuration $CONFIG --filter "FullyQualifiedName!~SoakTests"
+fi
+
+if [[ "$SOAK_TESTS" == true ]]
+then
+  dotnet test $AGENT_DIR/Google.Cloud.Diagnostics.Debug.LongRunningTests --configuration $CONFIG --filter "FullyQualifiedName~SoakTests"
 fi
@@ -78,6 +78,47 @@ namespace Google.Cloud.Diagnostics.Debug.IntegrationTests
             return Polling.Client.GrpcClient.SetBreakpoint(request).Breakpoint;
         }
 
+        /// <summary>
+        /// Set a log point at a file and line for a given debuggee that logs
+        /// <paramref name="logMessageFormat"/> with the values of the expressions.
+        /// </summary>
+        public Debugger.V2.Breakpoint SetLogPoint(
+            string debuggeeId, string path, int line,
+            string logMessageFormat, string[] expressions = null)
+        {
+            SetBreakpointRequest request = new SetBreakpointRequest
+            {
+                DebuggeeId = debuggeeId,
+                Breakpoint = new Debugger.V2.Breakpoint
+                {
+                    Location = new Debugger.V2.SourceLocation
+                    {
+                        Path = path,
+                        Line = line,
+                    },
+                    Action = Debugger.V2.Breakpoint.Types.Action.Log,
+                    LogMessageFormat = logMessageFormat,
+                    LogLevel = Debugger.V2.Breakpoint.Types.LogLevel.Info,
+                    Expressions = { expressions }
+                }
+            };
+
+            return Polling.Client.GrpcClient.SetBreakpoint(request).Breakpoint;
+        }
+
+        /// <summary>
+        /// Delete a breakpoint or log point of a given debuggee.
+        /// </summary>
+        public void DeleteBreakpoint(string debuggeeId, string breakpointId)
+        {
+            DeleteBreakpointRequest request = new DeleteBreakpointRequest
+            {
+                DebuggeeId = debuggeeId,
+                BreakpointId = breakpointId,
+            };
+            Polling.Client.GrpcClient.DeleteBreakpoint(request);
+        }
+
         /// <summary>
         /// Start the test application.
         /// </summary>
@@ -204,7 +204,7 @@ namespace Google.Cloud.Diagnostics.Debug.IntegrationTests
                 // Check the constant double.
                 DebuggerVariable constantDoubleVar = locals.Where(m => m.Name == "constDouble").Single();
                 Assert.Equal(typeof(System.Double).ToString(), constantDoubleVar.Type);
-                Assert.Equal("3.500000", constantDoubleVar.Value);
+                Assert.Equal("3.5", constantDoubleVar.Value);
 
                 // Check the constant string.
                 DebuggerVariable constantStringVar = locals.Where(m => m.Name == "constString").Single();
@@ -775,19 +775,18 @@ namespace Google.Cloud.Diagnostics.Debug.IntegrationTests
                 Assert.Equal("5", collectionCount.Value);
                 for (int i = 0; i < 5; i += 1)
                 {
-                    DebuggerVariable item = collection.Members.FirstOrDefault(member => member.Name == $"[{i}]");
-                    Assert.NotNull(item);
                     if (collectionName == "Dictionary")
                     {
-                        DebuggerVariable key = item.Members.FirstOrDefault(member => member.Name == "key");
-                        DebuggerVariable value = item.Members.FirstOrDefault(member => member.Name == "value");
-                        Assert.NotNull(key);
-                        Assert.NotNull(value);
-                        Assert.Equal($"Key{collectionKey}{i}", key.Value);
-                        Assert.Equal($"{i}", value.Value);
+                        // String keys are shown as the names of the items.
+                        DebuggerVariable item = collection.Members.FirstOrDefault(
+                            member => member.Name == $"[\"Key{collectionKey}{i}\"]");
+                        Assert.NotNull(item);
+                        Assert.Equal($"{i}", item.Value);
                     }
                     else
                     {
+                        DebuggerVariable item = collection.Members.FirstOrDefault(member => member.Name == $"[{i}]");
+                        Assert.NotNull(item);
                         Assert.Equal($"{collectionName}{collectionKey}{i}", item.Value);
                     }
                 }
@@ -0,0 +1,180 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Google.Cloud.Diagnostics.Debug.IntegrationTests;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace Google.Cloud.Diagnostics.Debug.LongRunningTests
+{
+    /// <summary>
+    /// A test that only runs when the environment variable
+    /// 'SOAK_TEST_DURATION_MINUTES' is set, as it runs for that long.
+    /// </summary>
+    public class SoakFactAttribute : FactAttribute
+    {
+        public SoakFactAttribute()
+        {
+            if (SoakTests.GetDuration() == null)
+            {
+                Skip = "Set SOAK_TEST_DURATION_MINUTES to run the soak tests.";
+            }
+        }
+    }
+
+    public class SoakTests : DebuggerTestBase
+    {
+        /// <summary>The time between two samples of the debugger process.</summary>
+        private static readonly TimeSpan _sampleInterval = TimeSpan.FromSeconds(30);
+
+        /// <summary>
+        /// The fraction of the test at the start whose samples are ignored, while
+        /// the caches of the debugger fill up.
+        /// </summary>
+        private const double WarmUpFraction = 0.2;
+
+        /// <summary>The acceptable memory growth (10MB) of the debugger in steady state.</summary>
+        private const double AddedMemoryMB = 10;
+
+        /// <summary>
+        /// The acceptable growth of the threads of the debugger in steady state. Threads
+        /// started for concurrent breakpoint hits exit after a minute.
+        /// </summary>
+        private const double AddedThreads = 2;
+
+        /// <summary>The acceptable growth of the handles of the debugger in steady state.</summary>
+        private const double AddedHandles = 10;
+
+        /// <summary>The number of requests to the application per iteration.</summary>
+        private const int RequestsPerIteration = 10;
+
+        /// <summary>A sample of the resources used by the debugger process.</summary>
+        private class Sample
+        {
+            public TimeSpan Elapsed;
+            public double MemoryMB;
+            public int Threads;
+            public int Handles;
+        }
+
+        /// <summary>
+        /// Gets the duration of the soak test from the environment variable
+        /// 'SOAK_TEST_DURATION_MINUTES', or null if it is not set.
+        /// </summary>
+        public static TimeSpan? GetDuration()
+        {
+            var minutes = Environment.GetEnvironmentVariable("SOAK_TEST_DURATION_MINUTES");
+            return string.IsNullOrWhiteSpace(minutes) ?
+                (TimeSpan?) null : TimeSpan.FromMinutes(double.Parse(minutes));
+        }
+
+        /// <summary>
+        /// This test sets log points and snapshots and hits them for
+        /// SOAK_TEST_DURATION_MINUTES while it samples the memory, threads and handles
+        /// of the debugger. It ensures they do not grow once the debugger is warmed up.
+        /// </summary>
+        [SoakFact]
+        public async Task LogPointsAndSnapshots_SteadyState()
+        {
+            var duration = GetDuration().Value;
+            var samples = new List<Sample>();
+            using (var app = StartTestApp(debugEnabled: true))
+            using (HttpClient client = new HttpClient())
+            {
+                var debuggee = Polling.GetDebuggee(app.Module, app.Version);
+                var debugProcess = app.GetDebuggerProcess();
+
+                Console.WriteLine("Elapsed (s), memory (MB), threads, handles");
+                var stopwatch = Stopwatch.StartNew();
+                var nextSample = TimeSpan.Zero;
+                for (int i = 0; stopwatch.Elapsed < duration; i++)
+                {
+                    var logPoint = SetLogPoint(debuggee.Id, TestApplication.MainClass,
+                        TestApplication.EchoBottomLine, "Echo $0 of $1", new[] { "message", "testList" });
+                    var snapshot = SetBreakpointAndSleep(debuggee.Id, TestApplication.MainClass,
+                        TestApplication.EchoTopLine, expressions: new[] { "testDictionary" });
+
+                    for (int j = 0; j < RequestsPerIteration; j++)
+                    {
+                        await client.GetAsync($"{app.AppUrlEcho}/{i * RequestsPerIteration + j}");
+                    }
+
+                    var newBp = Polling.GetBreakpoint(debuggee.Id, snapshot.Id);
+                    Assert.True(newBp.IsFinalState);
+                    DeleteBreakpoint(debuggee.Id, logPoint.Id);
+
+                    if (stopwatch.Elapsed >= nextSample)
+                    {
+                        var sample = TakeSample(debugProcess, stopwatch.Elapsed);
+                        samples.Add(sample);
+                        Console.WriteLine($"{sample.Elapsed.TotalSeconds:F0}, {sample.MemoryMB:F1}, " +
+                            $"{sample.Threads}, {sample.Handles}");
+                        nextSample += _sampleInterval;
+                    }
+                }
+            }
+
+            // Compares the first and the last third of the samples after the warm up.
+            var steadySamples = samples
+                .Where(s => s.Elapsed.TotalSeconds >= duration.TotalSeconds * WarmUpFraction)
+                .ToList();
+            Assert.True(steadySamples.Count >= 3, "The soak test is too short to have enough samples.");
+            int third = steadySamples.Count / 3;
+            var first = steadySamples.Take(third).ToList();
+            var last = steadySamples.Skip(steadySamples.Count - third).ToList();
+
+            AssertNoGrowth("Memory (MB)", first.Average(s => s.MemoryMB),
+                last.Average(s => s.MemoryMB), AddedMemoryMB);
+            AssertNoGrowth("Threads", first.Average(s => s.Threads),
+                last.Average(s => s.Threads), AddedThreads);
+            AssertNoGrowth("Handles", first.Average(s => s.Handles),
+                last.Average(s => s.Handles), AddedHandles);
+        }
+
+        /// <summary>
+        /// Samples the memory, threads and handles of the debugger process.
+        /// </summary>
+        private static Sample TakeSample(Process debugProcess, TimeSpan elapsed)
+        {
+            debugProcess.Refresh();
+            return new Sample
+            {
+                Elapsed = elapsed,
+                MemoryMB = debugProcess.WorkingSet64 / Math.Pow(2, 20),
+                Threads = debugProcess.Threads.Count,
+                // The handles of a process on Linux are its file descriptors.
+                Handles = Utils.IsWindows ? debugProcess.HandleCount :
+                    Directory.GetFiles($"/proc/{debugProcess.Id}/fd").Length,
+            };
+        }
+
+        /// <summary>
+        /// Asserts that the average of a resource at the end of the soak test is at
+        /// most <paramref name="allowed"/> more than after the warm up.
+        /// </summary>
+        private static void AssertNoGrowth(string resource, double start, double end, double allowed)
+        {
+            Console.WriteLine($"{resource} after the warm up: {start}, at the end: {end}");
+            Assert.True(end <= start + allowed,
+                $"{resource} grew from {start} after the warm up to {end} at the end.\n" +
+                $"This is {end - start - allowed} more than expectable.");
+        }
+    }
+}
@@ -61,6 +61,86 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             Assert.Equal(_expressions, breakpoint.Expressions);
             Assert.Equal(breakpoint.LogMessageFormat, sdBreakpoint.LogMessageFormat);
             Assert.Equal(Breakpoint.Types.LogLevel.Err, breakpoint.LogLevel);
+            Assert.Equal(1, breakpoint.HitLimit);
+            Assert.Equal(sdBreakpoint.CreateTime.ToDateTime() + Constants.SnapshotExpiration,
+                breakpoint.ExpireTime.ToDateTime());
+            Assert.Equal("", breakpoint.Location.ContentHash);
+        }
+
+        [Fact]
+        public void Convert_Breakpoint_ContentHash()
+        {
+            var sdBreakpoint = new StackdriverBreakpoint
+            {
+                Id = _id,
+                Location = new StackdriverSourceLocation
+                {
+                    Path = _path,
+                    Line = _line
+                },
+                Labels = { { Constants.ContentHashLabel, "0A1B2C" } }
+            };
+
+            var breakpoint = sdBreakpoint.Convert();
+            Assert.Equal(_path, breakpoint.Location.Path);
+            Assert.Equal("0A1B2C", breakpoint.Location.ContentHash);
+        }
+
+        [Fact]
+        public void Convert_Breakpoint_Sampling()
+        {
+            var sdBreakpoint = new StackdriverBreakpoint
+            {
+                Id = _id,
+                Labels =
+                {
+                    { Constants.SampleEveryLabel, "1000" },
+                    { Constants.SampleRateLabel, "0.01" },
+                }
+            };
+
+            var breakpoint = sdBreakpoint.Convert();
+            Assert.Equal(1000, breakpoint.SampleEvery);
+            Assert.Equal(0.01, breakpoint.SampleRate);
+
+            sdBreakpoint.Labels[Constants.SampleEveryLabel] = "-1";
+            sdBreakpoint.Labels[Constants.SampleRateLabel] = "2";
+            breakpoint = sdBreakpoint.Convert();
+            Assert.Equal(0, breakpoint.SampleEvery);
+            Assert.Equal(0, breakpoint.SampleRate);
+        }
+
+        [Fact]
+        public void Convert_Breakpoint_StaticExpressionTtl()
+        {
+            var sdBreakpoint = new StackdriverBreakpoint
+            {
+                Id = _id,
+                Labels = { { Constants.StaticExpressionTtlLabel, "60000" } }
+            };
+
+            var breakpoint = sdBreakpoint.Convert();
+            Assert.Equal(60000, breakpoint.StaticExpressionTtlMs);
+
+            sdBreakpoint.Labels[Constants.StaticExpressionTtlLabel] = "-5";
+            breakpoint = sdBreakpoint.Convert();
+            Assert.Equal(0, breakpoint.StaticExpressionTtlMs);
+        }
+
+        [Fact]
+        public void Convert_Breakpoint_LogPoint()
+        {
+            var sdBreakpoint = new StackdriverBreakpoint
+            {
+                Id = _id,
+                CreateTime = Timestamp.FromDateTime(DateTime.UtcNow),
+                Action = StackdriverBreakpoint.Types.Action.Log
+            };
+
+            var breakpoint = sdBreakpoint.Convert();
+            Assert.True(breakpoint.LogPoint);
+            Assert.Equal(0, breakpoint.HitLimit);
+            Assert.Null(breakpoint.ExpireTime);
         }
 
         [Fact]
@@ -126,6 +126,25 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             Assert.Equal(5, response.Removed.Count());
         }
 
+        [Fact]
+        public void UpdateBreakpoints_Active()
+        {
+            var breakpoints = CreateBreakpoints(3);
+            var response = _manager.UpdateBreakpoints(breakpoints.GetRange(0, 2));
+            Assert.True(response.Changed);
+            Assert.Equal(breakpoints.GetRange(0, 2), response.Active);
+
+            response = _manager.UpdateBreakpoints(breakpoints.GetRange(0, 2));
+            Assert.False(response.Changed);
+            Assert.Equal(breakpoints.GetRange(0, 2), response.Active);
+
+            response = _manager.UpdateBreakpoints(breakpoints.GetRange(1, 2));
+            Assert.True(response.Changed);
+            Assert.Equal(breakpoints.GetRange(1, 2), response.Active);
+            Assert.Equal(breakpoints[2], response.New.Single());
+            Assert.Equal(breakpoints[0], response.Removed.Single());
+        }
+
         /// <summary>
         /// Create a list of <see cref="StackdriverBreakpoint"/>s.
         /// </summary>
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 using Moq;
+using System;
+using System.Collections.Generic;
 using System.Threading;
 using System.Threading.Tasks;
 using Xunit;
@@ -78,6 +80,55 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             Assert.True(_cts.IsCancellationRequested);
         }
 
+        [Fact]
+        public void MainAction_Metrics()
+        {
+            var breakpoint = new Breakpoint
+            {
+                Id = Constants.MetricsBreakpointId,
+            };
+            breakpoint.EvaluatedExpressions.Add(new Variable { Name = "breakpoint_hits", Value = "3" });
+            var histogram = new Variable { Name = "breakpoint_stop_time_us", Value = "2" };
+            histogram.Members.Add(new Variable { Name = "count", Value = "2" });
+            histogram.Members.Add(new Variable { Name = "max", Value = "200" });
+            breakpoint.EvaluatedExpressions.Add(histogram);
+
+            _mockBreakpointServer.Setup(s => s.ReadBreakpointAsync(It.IsAny<CancellationToken>()))
+                .Returns(Task.FromResult(breakpoint));
+            _server.MainAction();
+
+            _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(
+                It.IsAny<Debugger.V2.Breakpoint>()), Times.Never);
+            _mockLoggingClient.Verify(c => c.WriteLogEntry(
+                It.IsAny<Debugger.V2.Breakpoint>()), Times.Never);
+            Assert.False(_cts.IsCancellationRequested);
+            Assert.Equal("Debugger metrics: breakpoint_hits=3 breakpoint_stop_time_us=(count=2 max=200)",
+                BreakpointReadActionServer.FormatMetrics(breakpoint));
+        }
+
+        [Fact]
+        public void MainAction_Ready()
+        {
+            var breakpoint = new Breakpoint
+            {
+                Id = Constants.ReadyBreakpointId,
+            };
+            breakpoint.EvaluatedExpressions.Add(new Variable { Name = "runtime_registration_us", Value = "1500" });
+            breakpoint.EvaluatedExpressions.Add(new Variable { Name = "total_us", Value = "2500" });
+
+            _mockBreakpointServer.Setup(s => s.ReadBreakpointAsync(It.IsAny<CancellationToken>()))
+                .Returns(Task.FromResult(breakpoint));
+            _server.MainAction();
+
+            _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(
+                It.IsAny<Debugger.V2.Breakpoint>()), Times.Never);
+            _mockLoggingClient.Verify(c => c.WriteLogEntry(
+                It.IsAny<Debugger.V2.Breakpoint>()), Times.Never);
+            Assert.False(_cts.IsCancellationRequested);
+            Assert.Equal("Debugger ready: runtime_registration_us=1500 total_us=2500",
+                BreakpointReadActionServer.FormatReady(breakpoint));
+        }
+
         [Fact]
         public void MainAction_LogPoint()
         {
@@ -99,5 +150,40 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(sdBreakpoint), Times.Once);
             _mockLoggingClient.Verify(c => c.WriteLogEntry(sdBreakpoint), Times.Once);
         }
+
+        [Fact]
+        public void MainAction_LogPointWithUploader()
+        {
+            var breakpoint = new Breakpoint
+            {
+                Id = "some-id",
+                Location = new SourceLocation
+                {
+                    Line = 1,
+                    Path = "some-path"
+                },
+                LogPoint = true
+            };
+            var sdBreakpoint = breakpoint.Convert();
+            var record = new LogRecord("some-id", DateTime.UtcNow, Breakpoint.Types.LogLevel.Info, "message");
+            var written = new List<LogRecord>();
+            _mockLoggingClient.Setup(c => c.CreateLogRecord(sdBreakpoint)).Returns(record);
+            _mockLoggingClient.Setup(c => c.WriteLogRecords(It.IsAny<IList<LogRecord>>()))
+                .Callback<IList<LogRecord>>(records => written.AddRange(records));
+            _mockBreakpointServer.Setup(s => s.ReadBreakpointAsync(It.IsAny<CancellationToken>()))
+                .Returns(Task.FromResult(breakpoint));
+
+            using (var uploader = new LogEntryUploader(_mockLoggingClient.Object))
+            {
+                var server = new BreakpointReadActionServer(_mockBreakpointServer.Object,
+                    _cts, _mockDebuggerClient.Object, _mockLoggingClient.Object,
+                    _breakpointManager, uploader);
+                server.MainAction();
+            }
+
+            _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(sdBreakpoint), Times.Once);
+            _mockLoggingClient.Verify(c => c.WriteLogEntry(It.IsAny<Debugger.V2.Breakpoint>()), Times.Never);
+            Assert.Equal(new[] { record }, written);
+        }
     }
 }
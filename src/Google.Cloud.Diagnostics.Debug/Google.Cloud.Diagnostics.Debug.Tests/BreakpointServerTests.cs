@@ -16,6 +16,8 @@ using Google.Protobuf;
 using Moq;
 using System;
 using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
 using System.Linq;
 using System.Text;
 using System.Threading;
@@ -208,6 +210,212 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             _pipeMock.Verify(p => p.WriteAsync(It.IsAny<byte[]>(), _cts.Token), Times.Once());
         }
 
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixed()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var breakpoint1 = new Breakpoint
+            {
+                Id = "some-id-1"
+            };
+            var breakpoint2 = new Breakpoint
+            {
+                Id = "some-id-2"
+            };
+
+            // Split the frames so that a header and a message each span reads.
+            var frames = CreateBreakpointFrame(breakpoint1).Concat(CreateBreakpointFrame(breakpoint2)).ToArray();
+            _pipeMock.SetupSequence(p => p.ReadAsync(_cts.Token))
+                .Returns(Task.FromResult(frames.Take(3).ToArray()))
+                .Returns(Task.FromResult(frames.Skip(3).Take(10).ToArray()))
+                .Returns(Task.FromResult(frames.Skip(13).ToArray()));
+
+            Assert.Equal(breakpoint1, await server.ReadBreakpointAsync(_cts.Token));
+            Assert.Equal(breakpoint2, await server.ReadBreakpointAsync(_cts.Token));
+            _pipeMock.Verify(p => p.ReadAsync(_cts.Token), Times.Exactly(3));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_ManyBreakpointsInOneRead()
+        {
+            // More breakpoints than fit the initial buffer, written at once as the
+            // debugger does when it batches its writes.
+            var breakpoints = Enumerable.Range(0, 1000)
+                .Select(i => new Breakpoint { Id = $"some-id-{i}" }).ToList();
+            var messages = breakpoints.SelectMany(b => CreateBreakpointMessage(b)).ToArray();
+            var frames = breakpoints.SelectMany(b => CreateBreakpointFrame(b)).ToArray();
+            var framedServer = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+
+            _pipeMock.SetupSequence(p => p.ReadAsync(_cts.Token))
+                .Returns(Task.FromResult(messages))
+                .Returns(Task.FromResult(frames));
+
+            foreach (var breakpoint in breakpoints)
+            {
+                Assert.Equal(breakpoint, await _server.ReadBreakpointAsync(_cts.Token));
+            }
+            foreach (var breakpoint in breakpoints)
+            {
+                Assert.Equal(breakpoint, await framedServer.ReadBreakpointAsync(_cts.Token));
+            }
+            _pipeMock.Verify(p => p.ReadAsync(_cts.Token), Times.Exactly(2));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_EndMarkerSplitAcrossReads()
+        {
+            var breakpoint = new Breakpoint
+            {
+                Id = "some-id"
+            };
+            var breakpointMessage = CreateBreakpointMessage(breakpoint);
+            int split = breakpointMessage.Length - 2;
+
+            _pipeMock.SetupSequence(p => p.ReadAsync(_cts.Token))
+                .Returns(Task.FromResult(breakpointMessage.Take(split).ToArray()))
+                .Returns(Task.FromResult(breakpointMessage.Skip(split).ToArray()));
+
+            Assert.Equal(breakpoint, await _server.ReadBreakpointAsync(_cts.Token));
+            _pipeMock.Verify(p => p.ReadAsync(_cts.Token), Times.Exactly(2));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixedInvalidVersion()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var frame = CreateBreakpointFrame(new Breakpoint { Id = "some-id" });
+            frame[0] = Constants.FrameVersion + 1;
+            _pipeMock.Setup(p => p.ReadAsync(_cts.Token)).Returns(Task.FromResult(frame));
+
+            await Assert.ThrowsAsync<InvalidOperationException>
+                (async () => await server.ReadBreakpointAsync(_cts.Token));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixedCompressed()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var breakpoint = new Breakpoint
+            {
+                Id = "some-id"
+            };
+            for (int i = 0; i < 100; i++)
+            {
+                var stackFrame = new StackFrame();
+                stackFrame.Locals.Add(new Variable { Name = "TestVariable", Value = "TestValue" });
+                breakpoint.StackFrames.Add(stackFrame);
+            }
+
+            var frame = CreateCompressedBreakpointFrame(breakpoint);
+            Assert.True(frame.Length < breakpoint.CalculateSize());
+            _pipeMock.Setup(p => p.ReadAsync(_cts.Token)).Returns(Task.FromResult(frame));
+
+            Assert.Equal(breakpoint, await server.ReadBreakpointAsync(_cts.Token));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixedCompressedTruncated()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var frame = CreateCompressedBreakpointFrame(new Breakpoint { Id = "some-id" });
+            // Claim the breakpoint is larger than what the compressed data holds.
+            frame[Constants.FrameHeaderSize] += 1;
+            _pipeMock.Setup(p => p.ReadAsync(_cts.Token)).Returns(Task.FromResult(frame));
+
+            await Assert.ThrowsAsync<InvalidOperationException>
+                (async () => await server.ReadBreakpointAsync(_cts.Token));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixedChunked()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var header = new Breakpoint { Id = "some-id" };
+            var stackFrames = new Breakpoint();
+            stackFrames.StackFrames.Add(new StackFrame { MethodName = "Method1" });
+            stackFrames.StackFrames.Add(new StackFrame { MethodName = "Method2" });
+            var expressions = new Breakpoint();
+            expressions.EvaluatedExpressions.Add(new Variable { Name = "Expression" });
+
+            var chunks = new List<byte>();
+            foreach (var chunk in new[] { header, stackFrames })
+            {
+                var frame = CreateBreakpointFrame(chunk);
+                frame[0] |= Constants.FrameChunkFlag;
+                chunks.AddRange(frame);
+            }
+            chunks.AddRange(CreateCompressedBreakpointFrame(expressions));
+            _pipeMock.Setup(p => p.ReadAsync(_cts.Token)).Returns(Task.FromResult(chunks.ToArray()));
+
+            var breakpoint = header.Clone();
+            breakpoint.MergeFrom(stackFrames);
+            breakpoint.MergeFrom(expressions);
+            Assert.Equal(breakpoint, await server.ReadBreakpointAsync(_cts.Token));
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixedLogRecords()
+        {
+            var batches = new List<IList<LogRecord>>();
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed, batches.Add);
+            var breakpoint = new Breakpoint { Id = "some-id" };
+
+            // Two records, the second one at 1.5 seconds after the epoch.
+            var records = new List<byte>();
+            records.AddRange(new byte[] { 3 });
+            records.AddRange(Encoding.UTF8.GetBytes("id1"));
+            records.AddRange(BitConverter.GetBytes(0L));
+            records.AddRange(new byte[] { 2, 5 });
+            records.AddRange(Encoding.UTF8.GetBytes("hello"));
+            records.AddRange(new byte[] { 3 });
+            records.AddRange(Encoding.UTF8.GetBytes("id2"));
+            records.AddRange(BitConverter.GetBytes(1500000L));
+            records.AddRange(new byte[] { 0, 0 });
+
+            var frames = new List<byte> { Constants.FrameVersion | Constants.FrameLogRecordsFlag };
+            frames.AddRange(BitConverter.GetBytes(records.Count));
+            frames.AddRange(records);
+            frames.AddRange(CreateBreakpointFrame(breakpoint));
+            _pipeMock.Setup(p => p.ReadAsync(_cts.Token)).Returns(Task.FromResult(frames.ToArray()));
+
+            Assert.Equal(breakpoint, await server.ReadBreakpointAsync(_cts.Token));
+            var batch = Assert.Single(batches);
+            Assert.Equal(2, batch.Count);
+            Assert.Equal("id1", batch[0].BreakpointId);
+            Assert.Equal(Breakpoint.Types.LogLevel.Err, batch[0].Level);
+            Assert.Equal("hello", batch[0].Message);
+            Assert.Equal("id2", batch[1].BreakpointId);
+            Assert.Equal(new DateTime(1970, 1, 1, 0, 0, 1, 500, DateTimeKind.Utc), batch[1].Timestamp);
+            Assert.Equal(Breakpoint.Types.LogLevel.Info, batch[1].Level);
+            Assert.Equal("", batch[1].Message);
+        }
+
+        [Fact]
+        public async Task ReadBreakpointAsync_LengthPrefixedLogRecordsWithoutHandler()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var frame = new byte[] { Constants.FrameVersion | Constants.FrameLogRecordsFlag, 0, 0, 0, 0 };
+            _pipeMock.Setup(p => p.ReadAsync(_cts.Token)).Returns(Task.FromResult(frame));
+
+            await Assert.ThrowsAsync<InvalidOperationException>
+                (async () => await server.ReadBreakpointAsync(_cts.Token));
+        }
+
+        [Fact]
+        public void WriteBreakpointAsync_LengthPrefixed()
+        {
+            var server = new BreakpointServer(_pipeMock.Object, MessageFraming.LengthPrefixed);
+            var breakpoint = new Breakpoint
+            {
+                Id = "some-id"
+            };
+
+            _pipeMock.Setup(p => p.WriteAsync(CreateBreakpointFrame(breakpoint), _cts.Token));
+            server.WriteBreakpointAsync(breakpoint, _cts.Token);
+            _pipeMock.VerifyAll();
+            _pipeMock.Verify(p => p.WriteAsync(It.IsAny<byte[]>(), _cts.Token), Times.Once());
+        }
+
         [Fact]
         public void IndexOfSequence()
         {
@@ -245,5 +453,30 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             bytes.AddRange(Constants.EndBreakpointMessage);
             return bytes.ToArray();
         }
+
+        private byte[] CreateBreakpointFrame(Breakpoint breakpoint)
+        {
+            byte[] message = breakpoint.ToByteArray();
+            List<byte> bytes = new List<byte> { Constants.FrameVersion };
+            bytes.AddRange(BitConverter.GetBytes(message.Length));
+            bytes.AddRange(message);
+            return bytes.ToArray();
+        }
+
+        private byte[] CreateCompressedBreakpointFrame(Breakpoint breakpoint)
+        {
+            byte[] message = breakpoint.ToByteArray();
+            var compressed = new MemoryStream();
+            compressed.Write(BitConverter.GetBytes(message.Length), 0, sizeof(int));
+            using (var stream = new DeflateStream(compressed, CompressionMode.Compress, leaveOpen: true))
+            {
+                stream.Write(message, 0, message.Length);
+            }
+
+            List<byte> bytes = new List<byte> { Constants.FrameVersion | Constants.FrameCompressedFlag };
+            bytes.AddRange(BitConverter.GetBytes((int)compressed.Length));
+            bytes.AddRange(compressed.ToArray());
+            return bytes.ToArray();
+        }
     }
 }
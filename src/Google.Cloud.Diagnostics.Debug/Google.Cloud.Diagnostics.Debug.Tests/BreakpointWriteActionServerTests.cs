@@ -82,7 +82,20 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             _mockDebuggerClient.Verify(c => c.ListBreakpoints(), Times.Once);
             _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(It.IsAny<StackdriverBreakpoint>()), Times.Never);
             _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
-                breakpoints.Single().Convert(), It.IsAny<CancellationToken>()), Times.Once);
+                CreateSync(breakpoints.Single().Convert()), It.IsAny<CancellationToken>()), Times.Once);
+        }
+
+        [Fact]
+        public void MainAction_UnchangedBreakpoints()
+        {
+            var breakpoints = CreateBreakpoints(2);
+            _mockDebuggerClient.Setup(c => c.ListBreakpoints()).Returns(breakpoints);
+            _server.MainAction();
+            _server.MainAction();
+
+            _mockDebuggerClient.Verify(c => c.ListBreakpoints(), Times.Exactly(2));
+            _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
+                It.IsAny<Breakpoint>(), It.IsAny<CancellationToken>()), Times.Once);
         }
 
         [Fact]
@@ -96,7 +109,7 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             _mockDebuggerClient.Verify(c => c.ListBreakpoints(), Times.Once);
             _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(It.IsAny<StackdriverBreakpoint>()), Times.Never);
             _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
-                breakpoints.Single().Convert(), It.IsAny<CancellationToken>()), Times.Once);
+                CreateSync(breakpoints.Single().Convert()), It.IsAny<CancellationToken>()), Times.Once);
         }
 
         [Fact]
@@ -111,9 +124,8 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
 
             _mockDebuggerClient.Verify(c => c.ListBreakpoints(), Times.Exactly(2));
             _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(It.IsAny<StackdriverBreakpoint>()), Times.Never);
-            breakpoints.Single().IsFinalState = true;
             _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
-                breakpoints.Single().Convert(), It.IsAny<CancellationToken>()), Times.Once);
+                CreateSync(), It.IsAny<CancellationToken>()), Times.Once);
         }
 
         [Fact]
@@ -125,16 +137,24 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             _server.MainAction();
 
             _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
-                It.IsAny<Breakpoint>(), It.IsAny<CancellationToken>()), Times.Exactly(5));
+                CreateSync(breakpoints.Select(b => b.Convert()).ToArray()),
+                It.IsAny<CancellationToken>()), Times.Once);
 
             _mockDebuggerClient.Reset();
             _mockBreakpointServer.Reset();
-            _mockDebuggerClient.Setup(c => c.ListBreakpoints()).Returns(breakpoints.GetRange(4, 1));
+            var newBreakpoint = CreateBreakpoints(6)[5];
+            _mockDebuggerClient.Setup(c => c.ListBreakpoints()).Returns(
+                new List<StackdriverBreakpoint> { breakpoints[4], newBreakpoint });
             _server.MainAction();
 
+            // The breakpoint the debugger already has is only sent with its ID.
             _mockDebuggerClient.Verify(c => c.UpdateBreakpoint(It.IsAny<StackdriverBreakpoint>()), Times.Never);
+            var sync = CreateSync(
+                new Breakpoint { Id = breakpoints[4].Id, Activated = true }, newBreakpoint.Convert());
             _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
-                Match.Create((Breakpoint b) => !b.Activated), It.IsAny<CancellationToken>()), Times.Exactly(4));
+                sync, It.IsAny<CancellationToken>()), Times.Once);
+            _mockBreakpointServer.Verify(s => s.WriteBreakpointAsync(
+                It.IsAny<Breakpoint>(), It.IsAny<CancellationToken>()), Times.Once);
         }
 
         /// <summary>
@@ -148,6 +168,16 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
                 b.Status.Description.Format == errorMessage;
         }
 
+        /// <summary>
+        /// Creates a sync message holding breakpoints.
+        /// </summary>
+        private static Breakpoint CreateSync(params Breakpoint[] breakpoints)
+        {
+            var sync = new Breakpoint { Id = Constants.SyncBreakpointsId };
+            sync.Breakpoints.Add(breakpoints);
+            return sync;
+        }
+
         /// <summary>
         /// Create a list of <see cref="StackdriverBreakpoint"/>s.
         /// </summary>
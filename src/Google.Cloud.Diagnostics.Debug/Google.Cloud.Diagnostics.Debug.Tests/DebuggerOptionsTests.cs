@@ -36,6 +36,8 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             Assert.Null(options.ApplicationStartCommand);
             Assert.Equal(_processId, options.ApplicationId);
             Assert.StartsWith(Constants.PipeName, options.PipeName);
+            Assert.Equal(MessageFraming.LengthPrefixed, options.MessageFraming);
+            Assert.True(options.DuplexPipe);
         }
 
         [Fact]
@@ -103,7 +105,123 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
             Assert.Contains($"{DebuggerOptions.ApplicationIdOption}={_processId}", optionsString);
             Assert.Contains($"{DebuggerOptions.PropertyEvaluationOption}", optionsString);
             Assert.Contains($"{DebuggerOptions.MethodEvaluationOption}", optionsString);
+            Assert.Contains($"{DebuggerOptions.LengthPrefixedFramingOption}", optionsString);
+            Assert.Contains($"{DebuggerOptions.DuplexPipeOption}", optionsString);
+            Assert.Contains($"{DebuggerOptions.LogRecordsOption}", optionsString);
+            Assert.Contains($"{DebuggerOptions.StringTableOption}", optionsString);
+            Assert.Contains($"{DebuggerOptions.DeltaSnapshotsOption}", optionsString);
+            Assert.Contains($"{DebuggerOptions.FilterCallbacksOption}", optionsString);
             Assert.DoesNotContain(DebuggerOptions.ApplicationStartCommandOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.DropLogPointsWhenQueueFullOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.CompressBreakpointsOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.AsyncLogPointsOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.CoalesceLogPointHitsOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.ReportBreakpointCostsOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.EvalTimeoutOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.EvalBudgetOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.MaxFuncEvalsOption, optionsString);
+            Assert.DoesNotContain(DebuggerOptions.MetricsIntervalOption, optionsString);
+        }
+
+        [Fact]
+        public void ToString_CompressBreakpoints()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                CompressBreakpoints = true,
+            };
+            var options = DebuggerOptions.FromAgentOptions(agentOptions);
+
+            Assert.True(options.CompressBreakpoints);
+            Assert.Contains(DebuggerOptions.CompressBreakpointsOption, options.ToString());
+        }
+
+        [Fact]
+        public void ToString_AsyncLogPoints()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                AsyncLogPoints = true,
+            };
+            var options = DebuggerOptions.FromAgentOptions(agentOptions);
+
+            Assert.True(options.AsyncLogPoints);
+            Assert.Contains(DebuggerOptions.AsyncLogPointsOption, options.ToString());
+        }
+
+        [Fact]
+        public void ToString_CoalesceLogPointHits()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                CoalesceLogPointHits = true,
+            };
+            var options = DebuggerOptions.FromAgentOptions(agentOptions);
+
+            Assert.True(options.CoalesceLogPointHits);
+            Assert.Contains(DebuggerOptions.CoalesceLogPointHitsOption, options.ToString());
+        }
+
+        [Fact]
+        public void ToString_ReportBreakpointCosts()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                ReportBreakpointCosts = true,
+            };
+            var options = DebuggerOptions.FromAgentOptions(agentOptions);
+
+            Assert.True(options.ReportBreakpointCosts);
+            Assert.Contains(DebuggerOptions.ReportBreakpointCostsOption, options.ToString());
+        }
+
+        [Fact]
+        public void ToString_EvaluationBudget()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                EvalTimeoutMs = 500,
+                EvalBudgetMs = 2000,
+                MaxFuncEvals = 10,
+            };
+            var optionsString = DebuggerOptions.FromAgentOptions(agentOptions).ToString();
+
+            Assert.Contains($"{DebuggerOptions.EvalTimeoutOption}=500", optionsString);
+            Assert.Contains($"{DebuggerOptions.EvalBudgetOption}=2000", optionsString);
+            Assert.Contains($"{DebuggerOptions.MaxFuncEvalsOption}=10", optionsString);
+        }
+
+        [Fact]
+        public void ToString_MetricsInterval()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                MetricsIntervalMs = 60000,
+            };
+            var options = DebuggerOptions.FromAgentOptions(agentOptions);
+
+            Assert.Equal(60000, options.MetricsIntervalMs);
+            Assert.Contains($"{DebuggerOptions.MetricsIntervalOption}=60000", options.ToString());
+        }
+
+        [Fact]
+        public void ToString_DropLogPointsWhenQueueFull()
+        {
+            var agentOptions = new AgentOptions
+            {
+                ApplicationId = _processId,
+                DropLogPointsWhenQueueFull = true,
+            };
+            var options = DebuggerOptions.FromAgentOptions(agentOptions);
+
+            Assert.True(options.DropLogPointsWhenQueueFull);
+            Assert.Contains(DebuggerOptions.DropLogPointsWhenQueueFullOption, options.ToString());
         }
 
         [Fact]
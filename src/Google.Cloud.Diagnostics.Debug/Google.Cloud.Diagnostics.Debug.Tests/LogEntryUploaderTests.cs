@@ -0,0 +1,91 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Grpc.Core;
+using Moq;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+using Xunit;
+
+namespace Google.Cloud.Diagnostics.Debug.Tests
+{
+    public class LogEntryUploaderTests
+    {
+        private readonly Mock<ILoggingClient> _mockLoggingClient = new Mock<ILoggingClient>();
+
+        private static LogRecord CreateRecord(int i) =>
+            new LogRecord($"id-{i}", DateTime.UtcNow, Breakpoint.Types.LogLevel.Info, $"message {i}");
+
+        [Fact]
+        public void Add_WritesAllRecordsInBatches()
+        {
+            var batches = new List<List<LogRecord>>();
+            _mockLoggingClient.Setup(c => c.WriteLogRecords(It.IsAny<IList<LogRecord>>()))
+                .Callback<IList<LogRecord>>(records => batches.Add(records.ToList()));
+            var records = Enumerable.Range(0, LogEntryUploader.MaxBatchSize * 3).Select(CreateRecord).ToList();
+
+            using (var uploader = new LogEntryUploader(_mockLoggingClient.Object))
+            {
+                foreach (var record in records)
+                {
+                    uploader.Add(new[] { record });
+                }
+            }
+
+            Assert.Equal(records, batches.SelectMany(b => b));
+            Assert.All(batches, b => Assert.InRange(b.Count, 1, LogEntryUploader.MaxBatchSize));
+        }
+
+        [Fact]
+        public void Add_BatchesRecordsAddedDuringWrite()
+        {
+            var batches = new List<int>();
+            var writing = new ManualResetEventSlim();
+            var release = new ManualResetEventSlim();
+            _mockLoggingClient.Setup(c => c.WriteLogRecords(It.IsAny<IList<LogRecord>>()))
+                .Callback<IList<LogRecord>>(records =>
+                {
+                    batches.Add(records.Count);
+                    writing.Set();
+                    release.Wait();
+                });
+
+            using (var uploader = new LogEntryUploader(_mockLoggingClient.Object))
+            {
+                uploader.Add(new[] { CreateRecord(0) });
+                Assert.True(writing.Wait(TimeSpan.FromSeconds(10)));
+                // These are added while the first record is being written.
+                uploader.Add(Enumerable.Range(1, 10).Select(CreateRecord).ToList());
+                release.Set();
+            }
+
+            Assert.Equal(new[] { 1, 10 }, batches);
+        }
+
+        [Fact]
+        public void Dispose_DropsFailedBatch()
+        {
+            _mockLoggingClient.Setup(c => c.WriteLogRecords(It.IsAny<IList<LogRecord>>()))
+                .Throws(new RpcException(new Grpc.Core.Status(StatusCode.Unavailable, "unavailable")));
+
+            var uploader = new LogEntryUploader(_mockLoggingClient.Object);
+            uploader.Add(new[] { CreateRecord(0) });
+            uploader.Dispose();
+
+            _mockLoggingClient.Verify(c => c.WriteLogRecords(It.IsAny<IList<LogRecord>>()), Times.AtLeastOnce());
+        }
+    }
+}
@@ -0,0 +1,71 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using System.Collections.Generic;
+using System.Text;
+using StackdriverVariable = Google.Cloud.Debugger.V2.Variable;
+using Xunit;
+
+namespace Google.Cloud.Diagnostics.Debug.Tests
+{
+    public class LogMessageTemplateTests
+    {
+        private static string Render(string messageFormat, params StackdriverVariable[] evaluatedExpressions)
+        {
+            StringBuilder builder = new StringBuilder();
+            LogMessageTemplate.Parse(messageFormat).Render(builder, new List<StackdriverVariable>(evaluatedExpressions));
+            return builder.ToString();
+        }
+
+        [Fact]
+        public void Render_Literal()
+        {
+            Assert.Equal("This is a log", Render("This is a log"));
+            Assert.Equal("", Render(""));
+        }
+
+        [Fact]
+        public void Render_Substitution()
+        {
+            StackdriverVariable first = new StackdriverVariable { Value = "1" };
+            StackdriverVariable second = new StackdriverVariable { Value = "2" };
+            Assert.Equal("a 2 b 1 c 1", Render("a $1 b $0 c $0", first, second));
+            Assert.Equal("12", Render("$0$1", first, second));
+        }
+
+        [Fact]
+        public void Render_Dollars()
+        {
+            StackdriverVariable first = new StackdriverVariable { Value = "1" };
+            Assert.Equal("$0 costs $1", Render("$$0 costs $$$0", first));
+            Assert.Equal("$a $", Render("$a $", first));
+        }
+
+        [Fact]
+        public void Render_MissingExpression()
+        {
+            Assert.Equal("x {2 cannot be evaluated}", Render("x $2"));
+        }
+
+        [Fact]
+        public void Render_ReusesTemplate()
+        {
+            LogMessageTemplate template = LogMessageTemplate.Parse("value: $0");
+            StringBuilder builder = new StringBuilder();
+            template.Render(builder, new List<StackdriverVariable> { new StackdriverVariable { Value = "1" } });
+            template.Render(builder, new List<StackdriverVariable> { new StackdriverVariable { Value = "2" } });
+            Assert.Equal("value: 1value: 2", builder.ToString());
+        }
+    }
+}
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 using Google.Cloud.Logging.V2;
+using System;
+using System.Collections.Generic;
 using StackdriverVariable = Google.Cloud.Debugger.V2.Variable;
 using Moq;
 using Xunit;
@@ -276,5 +278,59 @@ namespace Google.Cloud.Diagnostics.Debug.Tests
                 client.WriteLogEntries(LogNameOneof.From(_logNameObj), _resource, null, new[] { logEntry }, null),
                 Times.Once());
         }
+
+        [Fact]
+        public void WriteLogRecords()
+        {
+            DateTime timestamp = new DateTime(2018, 5, 1, 12, 0, 0, DateTimeKind.Utc);
+            LogRecord[] records = new[]
+            {
+                new LogRecord("id1", timestamp, Breakpoint.Types.LogLevel.Info, "first"),
+                new LogRecord("id2", timestamp, Breakpoint.Types.LogLevel.Err, "second"),
+            };
+            LogEntry[] logEntries = new[]
+            {
+                new LogEntry
+                {
+                    LogName = _logNameObj.ToString(),
+                    Severity = Logging.Type.LogSeverity.Info,
+                    Timestamp = Protobuf.WellKnownTypes.Timestamp.FromDateTime(timestamp),
+                    TextPayload = "LOGPOINT: first"
+                },
+                new LogEntry
+                {
+                    LogName = _logNameObj.ToString(),
+                    Severity = Logging.Type.LogSeverity.Error,
+                    Timestamp = Protobuf.WellKnownTypes.Timestamp.FromDateTime(timestamp),
+                    TextPayload = "LOGPOINT: second"
+                },
+            };
+
+            _client.WriteLogRecords(records);
+            _mockLoggingClient.Verify(client =>
+                client.WriteLogEntries(LogNameOneof.From(_logNameObj), _resource, null, logEntries, null),
+                Times.Once());
+        }
+
+        [Fact]
+        public void CreateLogRecord()
+        {
+            Debugger.V2.Breakpoint breakpoint = new Debugger.V2.Breakpoint()
+            {
+                Id = "some-id",
+                LogLevel = Debugger.V2.Breakpoint.Types.LogLevel.Warning,
+                LogMessageFormat = "This is a log $0",
+                EvaluatedExpressions = { new StackdriverVariable() { Value = "test1" } },
+            };
+
+            LogRecord record = _client.CreateLogRecord(breakpoint);
+            Assert.Equal("some-id", record.BreakpointId);
+            Assert.Equal(Breakpoint.Types.LogLevel.Warning, record.Level);
+            Assert.Equal("This is a log test1", record.Message);
+            _mockLoggingClient.Verify(client =>
+                client.WriteLogEntries(It.IsAny<LogNameOneof>(), It.IsAny<MonitoredResource>(),
+                    It.IsAny<IDictionary<string, string>>(), It.IsAny<IEnumerable<LogEntry>>(), null),
+                Times.Never());
+        }
     }
 }
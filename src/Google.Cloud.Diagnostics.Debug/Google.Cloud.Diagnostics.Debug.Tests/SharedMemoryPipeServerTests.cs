@@ -0,0 +1,138 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Moq;
+using System;
+using System.IO;
+using System.IO.Pipes;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace Google.Cloud.Diagnostics.Debug.Tests
+{
+    public class SharedMemoryPipeServerTests : IDisposable
+    {
+        // Small enough for writes to wrap around the end of a ring.
+        private const int Capacity = 16;
+
+        // The rings of the agent and of the debugger.
+        private const long AgentRing = Constants.SharedMemoryHeaderSize;
+        private const long DebuggerRing = AgentRing + Constants.SharedMemoryRingControlSize + Capacity;
+
+        private readonly Mock<PipeStream> _mockDoorbell;
+        private readonly SharedMemoryPipeServer _server;
+
+        public SharedMemoryPipeServerTests()
+        {
+            _mockDoorbell = new Mock<PipeStream>(PipeDirection.InOut, 1024);
+            _server = new SharedMemoryPipeServer(() => _mockDoorbell.Object, Path.GetTempFileName(), Capacity);
+        }
+
+        public void Dispose() => _server.Dispose();
+
+        [Fact]
+        public void Header()
+        {
+            Assert.Equal(Constants.SharedMemoryMagic, _server.Memory.ReadUInt32(0));
+            Assert.Equal((uint)Capacity, _server.Memory.ReadUInt32(sizeof(uint)));
+        }
+
+        [Fact]
+        public async Task WriteAsync()
+        {
+            await _server.WriteAsync(Encoding.ASCII.GetBytes("hello"));
+
+            Assert.Equal(5, _server.Memory.ReadInt64(AgentRing));
+            Assert.Equal("hello", ReadData(AgentRing, 0, 5));
+            _mockDoorbell.Verify(d => d.WriteAsync(
+                It.IsAny<byte[]>(), It.IsAny<int>(), It.IsAny<int>(), It.IsAny<CancellationToken>()), Times.Never());
+        }
+
+        [Fact]
+        public async Task WriteAsync_DebuggerWaits()
+        {
+            // The debugger read the first 10 bytes and waits for more.
+            _server.Memory.Write(AgentRing, 10L);
+            _server.Memory.Write(AgentRing + 64, 10L);
+            _server.Memory.Write(AgentRing + 128, 1);
+            _mockDoorbell.Setup(d => d.WriteAsync(It.IsAny<byte[]>(), 0, 1, It.IsAny<CancellationToken>()))
+                .Returns(Task.FromResult(true));
+            _mockDoorbell.Setup(d => d.FlushAsync(It.IsAny<CancellationToken>())).Returns(Task.FromResult(true));
+
+            await _server.WriteAsync(Encoding.ASCII.GetBytes("wrapped around"));
+
+            Assert.Equal(24, _server.Memory.ReadInt64(AgentRing));
+            Assert.Equal("wrapped", ReadData(AgentRing, 10, 6) + ReadData(AgentRing, 0, 1));
+            _mockDoorbell.VerifyAll();
+        }
+
+        [Fact]
+        public async Task ReadAsync()
+        {
+            _server.Memory.Write(DebuggerRing + 64, 14L);
+            WriteData(DebuggerRing, 14, "abcd");
+            _server.Memory.Write(DebuggerRing, 18L);
+
+            Assert.Equal("abcd", Encoding.ASCII.GetString(await _server.ReadAsync()));
+            Assert.Equal(18, _server.Memory.ReadInt64(DebuggerRing + 64));
+            _mockDoorbell.Verify(d => d.ReadAsync(
+                It.IsAny<byte[]>(), It.IsAny<int>(), It.IsAny<int>(), It.IsAny<CancellationToken>()), Times.Never());
+        }
+
+        [Fact]
+        public async Task ReadAsync_WaitsForDoorbell()
+        {
+            _mockDoorbell.Setup(d => d.ReadAsync(
+                It.IsAny<byte[]>(), It.IsAny<int>(), It.IsAny<int>(), It.IsAny<CancellationToken>()))
+                .Callback(() =>
+                {
+                    Assert.Equal(1, _server.Memory.ReadInt32(DebuggerRing + 128));
+                    WriteData(DebuggerRing, 0, "xyz");
+                    _server.Memory.Write(DebuggerRing, 3L);
+                })
+                .Returns(Task.FromResult(1));
+
+            Assert.Equal("xyz", Encoding.ASCII.GetString(await _server.ReadAsync()));
+            Assert.Equal(0, _server.Memory.ReadInt32(DebuggerRing + 128));
+        }
+
+        [Fact]
+        public async Task ReadAsync_Closed()
+        {
+            _mockDoorbell.Setup(d => d.ReadAsync(
+                It.IsAny<byte[]>(), It.IsAny<int>(), It.IsAny<int>(), It.IsAny<CancellationToken>()))
+                .Returns(Task.FromResult(0));
+
+            await Assert.ThrowsAsync<IOException>(() => _server.ReadAsync());
+        }
+
+        private string ReadData(long ring, int index, int count)
+        {
+            byte[] bytes = new byte[count];
+            _server.Memory.ReadArray(ring + Constants.SharedMemoryRingControlSize + index, bytes, 0, count);
+            return Encoding.ASCII.GetString(bytes);
+        }
+
+        private void WriteData(long ring, int index, string data)
+        {
+            byte[] bytes = Encoding.ASCII.GetBytes(data);
+            for (int i = 0; i < bytes.Length; i++)
+            {
+                _server.Memory.Write(ring + Constants.SharedMemoryRingControlSize + (index + i) % Capacity, bytes[i]);
+            }
+        }
+    }
+}
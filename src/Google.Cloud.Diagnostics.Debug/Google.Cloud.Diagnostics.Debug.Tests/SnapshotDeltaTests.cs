@@ -0,0 +1,104 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using System;
+using Xunit;
+
+namespace Google.Cloud.Diagnostics.Debug.Tests
+{
+    public class SnapshotDeltaTests
+    {
+        private static Variable Unchanged() => new Variable { Name = Constants.UnchangedVariableName };
+
+        private static Breakpoint CreateSnapshot(string id, params Variable[] locals) => new Breakpoint
+        {
+            Id = id,
+            StackFrames = { new StackFrame { MethodName = "Main", Locals = { locals } } }
+        };
+
+        private static Variable CreateConfig(string count) => new Variable
+        {
+            Name = "config",
+            Type = "App.Config",
+            Members =
+            {
+                new Variable { Name = "Name", Value = "app" },
+                new Variable { Name = "Count", Value = count },
+            }
+        };
+
+        [Fact]
+        public void Decode()
+        {
+            var delta = new SnapshotDelta();
+            var first = CreateSnapshot("snapshot", CreateConfig("1"), new Variable { Name = "counter", Value = "1" });
+            var expected = first.Clone();
+            Assert.Equal(expected, delta.Decode(first));
+
+            var second = CreateSnapshot("snapshot", Unchanged(), new Variable { Name = "counter", Value = "2" });
+            Assert.Same(second, delta.Decode(second));
+            Assert.Equal(CreateConfig("1"), second.StackFrames[0].Locals[0]);
+            Assert.Equal("2", second.StackFrames[0].Locals[1].Value);
+
+            // Members are compared with the members of the previous snapshot.
+            var changedConfig = new Variable
+            {
+                Name = "config",
+                Type = "App.Config",
+                Members = { Unchanged(), new Variable { Name = "Count", Value = "3" } }
+            };
+            var third = CreateSnapshot("snapshot", changedConfig, Unchanged());
+            delta.Decode(third);
+            Assert.Equal(CreateConfig("3"), third.StackFrames[0].Locals[0]);
+            Assert.Equal("2", third.StackFrames[0].Locals[1].Value);
+        }
+
+        [Fact]
+        public void Decode_NoStackFrames()
+        {
+            var delta = new SnapshotDelta();
+            var breakpoint = new Breakpoint
+            {
+                Id = "log point",
+                EvaluatedExpressions = { Unchanged() }
+            };
+            var expected = breakpoint.Clone();
+            Assert.Equal(expected, delta.Decode(breakpoint));
+        }
+
+        [Fact]
+        public void Decode_NoPreviousSnapshot()
+        {
+            var delta = new SnapshotDelta();
+            delta.Decode(CreateSnapshot("first", CreateConfig("1")));
+            Assert.Throws<InvalidOperationException>(
+                () => delta.Decode(CreateSnapshot("second", Unchanged())));
+        }
+
+        [Fact]
+        public void Decode_ForgetsSnapshotsWhenFull()
+        {
+            var delta = new SnapshotDelta();
+            for (int i = 0; i < Constants.MaximumDeltaSnapshotBreakpoints; i++)
+            {
+                delta.Decode(CreateSnapshot(i.ToString(), CreateConfig("1")));
+            }
+            delta.Decode(CreateSnapshot("0", Unchanged()));
+
+            delta.Decode(CreateSnapshot("new", CreateConfig("1")));
+            Assert.Throws<InvalidOperationException>(
+                () => delta.Decode(CreateSnapshot("0", Unchanged())));
+        }
+    }
+}
@@ -0,0 +1,103 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using System;
+using Xunit;
+
+namespace Google.Cloud.Diagnostics.Debug.Tests
+{
+    public class SnapshotStringTableTests
+    {
+        private const string ItemType = "System.Collections.Generic.KeyValuePair`2";
+
+        private static string Reference(int index) => $"{Constants.StringTableReferencePrefix}{index}";
+
+        [Fact]
+        public void Decode()
+        {
+            var breakpoint = new Breakpoint
+            {
+                StackFrames =
+                {
+                    new StackFrame
+                    {
+                        MethodName = Reference(1),
+                        Location = new SourceLocation { Path = "Program.cs", Line = 10 },
+                        Locals =
+                        {
+                            new Variable
+                            {
+                                Name = "dictionary",
+                                Members =
+                                {
+                                    new Variable { Name = "[0]", Type = Reference(0), Value = Reference(0) },
+                                }
+                            }
+                        }
+                    }
+                },
+                EvaluatedExpressions =
+                {
+                    new Variable { Name = "x", Type = Reference(0) },
+                    new Variable
+                    {
+                        Name = Constants.StringTableExpressionName,
+                        Members = { new Variable { Value = ItemType }, new Variable { Value = "Main" } }
+                    }
+                }
+            };
+
+            Assert.Same(breakpoint, SnapshotStringTable.Decode(breakpoint));
+            Assert.Equal(1, breakpoint.EvaluatedExpressions.Count);
+            Assert.Equal(ItemType, breakpoint.EvaluatedExpressions[0].Type);
+            StackFrame frame = breakpoint.StackFrames[0];
+            Assert.Equal("Main", frame.MethodName);
+            Assert.Equal("Program.cs", frame.Location.Path);
+            Variable item = frame.Locals[0].Members[0];
+            Assert.Equal("[0]", item.Name);
+            Assert.Equal(ItemType, item.Type);
+            // Values are never replaced.
+            Assert.Equal(Reference(0), item.Value);
+        }
+
+        [Fact]
+        public void Decode_NoTable()
+        {
+            var breakpoint = new Breakpoint
+            {
+                EvaluatedExpressions = { new Variable { Name = "x", Type = "System.Int32" } }
+            };
+            var expected = breakpoint.Clone();
+            Assert.Equal(expected, SnapshotStringTable.Decode(breakpoint));
+        }
+
+        [Fact]
+        public void Decode_InvalidReference()
+        {
+            var breakpoint = new Breakpoint
+            {
+                EvaluatedExpressions =
+                {
+                    new Variable { Name = "x", Type = Reference(1) },
+                    new Variable
+                    {
+                        Name = Constants.StringTableExpressionName,
+                        Members = { new Variable { Value = ItemType } }
+                    }
+                }
+            };
+            Assert.Throws<InvalidOperationException>(() => SnapshotStringTable.Decode(breakpoint));
+        }
+    }
+}
@@ -15,6 +15,7 @@
 using Google.Api.Gax;
 using Google.Cloud.Debugger.V2;
 using System;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.Threading;
 using System.Threading.Tasks;
@@ -35,6 +36,7 @@ namespace Google.Cloud.Diagnostics.Debug
         private readonly AgentOptions _agentOptions;
         private readonly DebuggerClient _debuggerClient;
         private readonly LoggingClient _loggingClient;
+        private readonly LogEntryUploader _logUploader;
         private readonly CancellationTokenSource _cts;
         private readonly TaskCompletionSource<bool> _tcs;
         private readonly BreakpointManager _breakpointManager;
@@ -51,6 +53,7 @@ namespace Google.Cloud.Diagnostics.Debug
             _agentOptions = GaxPreconditions.CheckNotNull(options, nameof(options));
             _debuggerClient = new DebuggerClient(options, controlClient);
             _loggingClient = new LoggingClient(options, loggingClient);
+            _logUploader = new LogEntryUploader(_loggingClient);
             _cts = new CancellationTokenSource();
             _tcs = new TaskCompletionSource<bool>();
             _breakpointManager = new BreakpointManager();
@@ -70,9 +73,22 @@ namespace Google.Cloud.Diagnostics.Debug
                 _agentOptions.Debugger, _debuggerOptions.ToString(), null);
             _process = Process.Start(startInfo);
 
-            // The write server needs to connect first due to initialization logic in the debugger.
-            StartWriteLoopAsync(_cts.Token).Wait();
-            StartReadLoopAsync(_cts.Token).Wait();
+            if (_debuggerOptions.DuplexPipe)
+            {
+                // The debugger reads and writes breakpoints through one connection.
+                var breakpointServer = new BreakpointServer(
+                    CreateDuplexPipeServer(), _debuggerOptions.MessageFraming, WriteLogRecords,
+                    _debuggerOptions.DeltaSnapshots);
+                TryAction(() => breakpointServer.WaitForConnectionAsync().Wait());
+                StartWriteLoopAsync(_cts.Token, breakpointServer).Wait();
+                StartReadLoopAsync(_cts.Token, breakpointServer).Wait();
+            }
+            else
+            {
+                // The write server needs to connect first due to initialization logic in the debugger.
+                StartWriteLoopAsync(_cts.Token).Wait();
+                StartReadLoopAsync(_cts.Token).Wait();
+            }
 
             // Start blocking.
             _tcs.Task.Wait();
@@ -83,25 +99,52 @@ namespace Google.Cloud.Diagnostics.Debug
         {
             _process?.Kill();
             _cts.Cancel();
+            _logUploader.Dispose();
+        }
+
+        /// <summary>
+        /// Queues the hits of log points the debugger sends as log records to be written
+        /// to the log, so that the pipe is read again without waiting for the write.
+        /// </summary>
+        private void WriteLogRecords(IList<LogRecord> records) => _logUploader.Add(records);
+
+        /// <summary>
+        /// Creates the server of the single connection the debugger reads and writes
+        /// breakpoints through.
+        /// </summary>
+        private INamedPipeServer CreateDuplexPipeServer()
+        {
+            if (_debuggerOptions.SharedMemoryPipe)
+            {
+                return new SharedMemoryPipeServer(_debuggerOptions.PipeName);
+            }
+            return new NamedPipeServer(_debuggerOptions.PipeName);
         }
 
         /// <summary>
         /// Starts a new <see cref="Thread"/>, will poll the Stackdriver Debugger API for new
         /// breakpoints and reports them to the debugger via a <see cref="NamedPipeServer"/>.
         /// </summary>
+        /// <param name="cancellationToken">The token to stop the loop.</param>
+        /// <param name="connectedServer">A server that is already connected to the debugger, or null
+        /// to create a server and wait for it to connect.</param>
         /// <returns>A task representing the asynchronous operation which will be completed when the
         /// named pipe server is connected.</returns>
-        public Task StartWriteLoopAsync(CancellationToken cancellationToken)
+        public Task StartWriteLoopAsync(CancellationToken cancellationToken, IBreakpointServer connectedServer = null)
         {
             TaskCompletionSource<bool> tcs = new TaskCompletionSource<bool>();
             new Thread(() =>
             {
-                var breakpointServer = new BreakpointServer(new NamedPipeServer(_debuggerOptions.PipeName));
+                var breakpointServer = connectedServer ?? new BreakpointServer(
+                    new NamedPipeServer(_debuggerOptions.PipeName), _debuggerOptions.MessageFraming);
                 using (var server = new BreakpointWriteActionServer(breakpointServer, _cts, _debuggerClient, _breakpointManager))
                 {
                     TryAction(() =>
                     {
-                        server.WaitForConnection();
+                        if (connectedServer == null)
+                        {
+                            server.WaitForConnection();
+                        }
                         tcs.SetResult(true);
                         server.StartActionLoop(TimeSpan.Zero, cancellationToken);
                     });
@@ -118,20 +161,29 @@ namespace Google.Cloud.Diagnostics.Debug
         /// Starts a new <see cref="Thread"/>>, will poll the debugger (via a <see cref="NamedPipeServer"/>)
         /// for hit breakpoints and reports them to the Stackdriver Debugger API.
         /// </summary>
+        /// <param name="cancellationToken">The token to stop the loop.</param>
+        /// <param name="connectedServer">A server that is already connected to the debugger, or null
+        /// to create a server and wait for it to connect.</param>
         /// <returns>A task representing the asynchronous operation which will be completed when the
         /// named pipe server is connected.</returns>
-        public Task StartReadLoopAsync(CancellationToken cancellationToken)
+        public Task StartReadLoopAsync(CancellationToken cancellationToken, IBreakpointServer connectedServer = null)
         {
             TaskCompletionSource<bool> tcs = new TaskCompletionSource<bool>();
             new Thread(() =>
             {
-                var breakpointServer = new BreakpointServer(new NamedPipeServer(_debuggerOptions.PipeName));
+                var breakpointServer = connectedServer ?? new BreakpointServer(
+                    new NamedPipeServer(_debuggerOptions.PipeName), _debuggerOptions.MessageFraming,
+                    WriteLogRecords, _debuggerOptions.DeltaSnapshots);
                 using (var server = new BreakpointReadActionServer(
-                    breakpointServer, _cts, _debuggerClient, _loggingClient, _breakpointManager))
+                    breakpointServer, _cts, _debuggerClient, _loggingClient, _breakpointManager,
+                    _logUploader))
                 {
                     TryAction(() => 
                     { 
-                        server.WaitForConnection();
+                        if (connectedServer == null)
+                        {
+                            server.WaitForConnection();
+                        }
                         tcs.SetResult(true);
                         server.StartActionLoop(TimeSpan.Zero, cancellationToken);
                     });
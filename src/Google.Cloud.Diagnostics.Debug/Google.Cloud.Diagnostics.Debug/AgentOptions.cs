@@ -80,6 +80,62 @@ namespace Google.Cloud.Diagnostics.Debug
             " evaluating breakpoint's condition or expression.")]
         public bool MethodEvaluation { get; set; }
 
+        [Option("pdb-index-cache-dir",
+            HelpText = "If set, the debugger will cache the methods parsed from the" +
+            " application's PDB files in this directory and reuse them on restart.")]
+        public string PdbIndexCacheDir { get; set; }
+
+        [Option("drop-log-points-when-queue-full",
+            HelpText = "If set, the debugger will drop log point messages instead of" +
+            " waiting when too many breakpoint messages are waiting to be sent to the agent.")]
+        public bool DropLogPointsWhenQueueFull { get; set; }
+
+        [Option("compress-breakpoints",
+            HelpText = "If set, the debugger will compress large breakpoint messages, such as" +
+            " snapshots with many variables, before sending them to the agent.")]
+        public bool CompressBreakpoints { get; set; }
+
+        [Option("shared-memory-pipe",
+            HelpText = "If set, breakpoint messages will go through memory shared with the debugger" +
+            " instead of through the named pipe, which then only wakes up the side waiting for them." +
+            " Only supported on Linux.")]
+        public bool SharedMemoryPipe { get; set; }
+
+        [Option("async-log-points",
+            HelpText = "If set, the debugger will let the application continue before it sends" +
+            " log points whose expressions need no evaluation in the application.")]
+        public bool AsyncLogPoints { get; set; }
+
+        [Option("coalesce-log-point-hits",
+            HelpText = "If set, the debugger will skip a hit of a log point while another thread" +
+            " is stopped at the same log point.")]
+        public bool CoalesceLogPointHits { get; set; }
+
+        [Option("report-breakpoint-costs",
+            HelpText = "If set, the status of snapshots and log points will report how many hits," +
+            " stopped time, function evaluations and bytes their breakpoint cost so far.")]
+        public bool ReportBreakpointCosts { get; set; }
+
+        [Option("eval-timeout-ms",
+            HelpText = "The maximum time in milliseconds a function evaluation, such as a" +
+            " property getter, can take before the debugger aborts it. Defaults to one minute.")]
+        public int? EvalTimeoutMs { get; set; }
+
+        [Option("eval-budget-ms",
+            HelpText = "The maximum total time in milliseconds the function evaluations of a" +
+            " breakpoint can take. Evaluations past it are reported as errors on the variables.")]
+        public int? EvalBudgetMs { get; set; }
+
+        [Option("max-func-evals",
+            HelpText = "The maximum number of function evaluations of a breakpoint." +
+            " Evaluations past it are reported as errors on the variables.")]
+        public int? MaxFuncEvals { get; set; }
+
+        [Option("metrics-interval-ms",
+            HelpText = "If set, the debugger will send its counters and latency histograms" +
+            " every this many milliseconds, and the agent will write them to the console.")]
+        public int? MetricsIntervalMs { get; set; }
+
         [Option("source-context",
             HelpText = "The location of the source context file. See: " +
             "https://cloud.google.com/debugger/docs/source-context")]
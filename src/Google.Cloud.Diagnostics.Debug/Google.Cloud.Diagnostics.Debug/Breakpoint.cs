@@ -1,4 +1,4 @@
-// Generated by the protocol buffer compiler.  DO NOT EDIT!
+﻿// Generated by the protocol buffer compiler.  DO NOT EDIT!
 // source: breakpoint.proto
 #pragma warning disable 1591, 0612, 3021
 #region Designer generated code
@@ -23,7 +23,7 @@ namespace Google.Cloud.Diagnostics.Debug {
       byte[] descriptorData = global::System.Convert.FromBase64String(
           string.Concat(
             "ChBicmVha3BvaW50LnByb3RvEh5nb29nbGUuY2xvdWQuZGlhZ25vc3RpY3Mu",
-            "ZGVidWcaH2dvb2dsZS9wcm90b2J1Zi90aW1lc3RhbXAucHJvdG8i8QQKCkJy",
+            "ZGVidWcaH2dvb2dsZS9wcm90b2J1Zi90aW1lc3RhbXAucHJvdG8iwwYKCkJy",
             "ZWFrcG9pbnQSCgoCaWQYASABKAkSQAoIbG9jYXRpb24YAiABKAsyLi5nb29n",
             "bGUuY2xvdWQuZGlhZ25vc3RpY3MuZGVidWcuU291cmNlTG9jYXRpb24SQAoM",
             "c3RhY2tfZnJhbWVzGAMgAygLMiouZ29vZ2xlLmNsb3VkLmRpYWdub3N0aWNz",
@@ -36,25 +36,30 @@ namespace Google.Cloud.Diagnostics.Debug {
             "BnN0YXR1cxgLIAEoCzImLmdvb2dsZS5jbG91ZC5kaWFnbm9zdGljcy5kZWJ1",
             "Zy5TdGF0dXMSEQoJbG9nX3BvaW50GAwgASgIEhoKEmxvZ19tZXNzYWdlX2Zv",
             "cm1hdBgNIAEoCRJGCglsb2dfbGV2ZWwYDiABKA4yMy5nb29nbGUuY2xvdWQu",
-            "ZGlhZ25vc3RpY3MuZGVidWcuQnJlYWtwb2ludC5Mb2dMZXZlbCIqCghMb2dM",
-            "ZXZlbBIICgRJTkZPEAASCwoHV0FSTklORxABEgcKA0VSUhACItoBCgpTdGFj",
-            "a0ZyYW1lEhMKC21ldGhvZF9uYW1lGAEgASgJEkAKCGxvY2F0aW9uGAIgASgL",
-            "Mi4uZ29vZ2xlLmNsb3VkLmRpYWdub3N0aWNzLmRlYnVnLlNvdXJjZUxvY2F0",
-            "aW9uEjsKCWFyZ3VtZW50cxgDIAMoCzIoLmdvb2dsZS5jbG91ZC5kaWFnbm9z",
-            "dGljcy5kZWJ1Zy5WYXJpYWJsZRI4CgZsb2NhbHMYBCADKAsyKC5nb29nbGUu",
-            "Y2xvdWQuZGlhZ25vc3RpY3MuZGVidWcuVmFyaWFibGUiLAoOU291cmNlTG9j",
-            "YXRpb24SDAoEcGF0aBgBIAEoCRIMCgRsaW5lGAIgASgFIqgBCghWYXJpYWJs",
-            "ZRIMCgRuYW1lGAEgASgJEgwKBHR5cGUYAiABKAkSDQoFdmFsdWUYAyABKAkS",
-            "OQoHbWVtYmVycxgEIAMoCzIoLmdvb2dsZS5jbG91ZC5kaWFnbm9zdGljcy5k",
-            "ZWJ1Zy5WYXJpYWJsZRI2CgZzdGF0dXMYBSABKAsyJi5nb29nbGUuY2xvdWQu",
-            "ZGlhZ25vc3RpY3MuZGVidWcuU3RhdHVzIioKBlN0YXR1cxIPCgdpc2Vycm9y",
-            "GAEgASgIEg8KB21lc3NhZ2UYAiABKAliBnByb3RvMw=="));
+            "ZGlhZ25vc3RpY3MuZGVidWcuQnJlYWtwb2ludC5Mb2dMZXZlbBIRCgloaXRf",
+            "bGltaXQYDyABKAUSLwoLZXhwaXJlX3RpbWUYECABKAsyGi5nb29nbGUucHJv",
+            "dG9idWYuVGltZXN0YW1wEj8KC2JyZWFrcG9pbnRzGBEgAygLMiouZ29vZ2xl",
+            "LmNsb3VkLmRpYWdub3N0aWNzLmRlYnVnLkJyZWFrcG9pbnQSFAoMc2FtcGxl",
+            "X2V2ZXJ5GBIgASgFEhMKC3NhbXBsZV9yYXRlGBMgASgBEiAKGHN0YXRpY19l",
+            "eHByZXNzaW9uX3R0bF9tcxgUIAEoBSIqCghMb2dMZXZlbBIICgRJTkZPEAAS",
+            "CwoHV0FSTklORxABEgcKA0VSUhACItoBCgpTdGFja0ZyYW1lEhMKC21ldGhv",
+            "ZF9uYW1lGAEgASgJEkAKCGxvY2F0aW9uGAIgASgLMi4uZ29vZ2xlLmNsb3Vk",
+            "LmRpYWdub3N0aWNzLmRlYnVnLlNvdXJjZUxvY2F0aW9uEjsKCWFyZ3VtZW50",
+            "cxgDIAMoCzIoLmdvb2dsZS5jbG91ZC5kaWFnbm9zdGljcy5kZWJ1Zy5WYXJp",
+            "YWJsZRI4CgZsb2NhbHMYBCADKAsyKC5nb29nbGUuY2xvdWQuZGlhZ25vc3Rp",
+            "Y3MuZGVidWcuVmFyaWFibGUiQgoOU291cmNlTG9jYXRpb24SDAoEcGF0aBgB",
+            "IAEoCRIMCgRsaW5lGAIgASgFEhQKDGNvbnRlbnRfaGFzaBgDIAEoCSKoAQoI",
+            "VmFyaWFibGUSDAoEbmFtZRgBIAEoCRIMCgR0eXBlGAIgASgJEg0KBXZhbHVl",
+            "GAMgASgJEjkKB21lbWJlcnMYBCADKAsyKC5nb29nbGUuY2xvdWQuZGlhZ25v",
+            "c3RpY3MuZGVidWcuVmFyaWFibGUSNgoGc3RhdHVzGAUgASgLMiYuZ29vZ2xl",
+            "LmNsb3VkLmRpYWdub3N0aWNzLmRlYnVnLlN0YXR1cyIqCgZTdGF0dXMSDwoH",
+            "aXNlcnJvchgBIAEoCBIPCgdtZXNzYWdlGAIgASgJYgZwcm90bzM="));
       descriptor = pbr::FileDescriptor.FromGeneratedCode(descriptorData,
           new pbr::FileDescriptor[] { global::Google.Protobuf.WellKnownTypes.TimestampReflection.Descriptor, },
           new pbr::GeneratedClrTypeInfo(null, new pbr::GeneratedClrTypeInfo[] {
-            new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.Breakpoint), global::Google.Cloud.Diagnostics.Debug.Breakpoint.Parser, new[]{ "Id", "Location", "StackFrames", "Activated", "CreateTime", "FinalTime", "KillServer", "Expressions", "Condition", "EvaluatedExpressions", "Status", "LogPoint", "LogMessageFormat", "LogLevel" }, null, new[]{ typeof(global::Google.Cloud.Diagnostics.Debug.Breakpoint.Types.LogLevel) }, null),
+            new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.Breakpoint), global::Google.Cloud.Diagnostics.Debug.Breakpoint.Parser, new[]{ "Id", "Location", "StackFrames", "Activated", "CreateTime", "FinalTime", "KillServer", "Expressions", "Condition", "EvaluatedExpressions", "Status", "LogPoint", "LogMessageFormat", "LogLevel", "HitLimit", "ExpireTime", "Breakpoints", "SampleEvery", "SampleRate", "StaticExpressionTtlMs" }, null, new[]{ typeof(global::Google.Cloud.Diagnostics.Debug.Breakpoint.Types.LogLevel) }, null),
             new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.StackFrame), global::Google.Cloud.Diagnostics.Debug.StackFrame.Parser, new[]{ "MethodName", "Location", "Arguments", "Locals" }, null, null, null),
-            new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.SourceLocation), global::Google.Cloud.Diagnostics.Debug.SourceLocation.Parser, new[]{ "Path", "Line" }, null, null, null),
+            new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.SourceLocation), global::Google.Cloud.Diagnostics.Debug.SourceLocation.Parser, new[]{ "Path", "Line", "ContentHash" }, null, null, null),
             new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.Variable), global::Google.Cloud.Diagnostics.Debug.Variable.Parser, new[]{ "Name", "Type", "Value", "Members", "Status" }, null, null, null),
             new pbr::GeneratedClrTypeInfo(typeof(global::Google.Cloud.Diagnostics.Debug.Status), global::Google.Cloud.Diagnostics.Debug.Status.Parser, new[]{ "Iserror", "Message" }, null, null, null)
           }));
@@ -101,6 +106,12 @@ namespace Google.Cloud.Diagnostics.Debug {
       logPoint_ = other.logPoint_;
       logMessageFormat_ = other.logMessageFormat_;
       logLevel_ = other.logLevel_;
+      hitLimit_ = other.hitLimit_;
+      ExpireTime = other.expireTime_ != null ? other.ExpireTime.Clone() : null;
+      breakpoints_ = other.breakpoints_.Clone();
+      sampleEvery_ = other.sampleEvery_;
+      sampleRate_ = other.sampleRate_;
+      staticExpressionTtlMs_ = other.staticExpressionTtlMs_;
     }
 
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
@@ -259,6 +270,85 @@ namespace Google.Cloud.Diagnostics.Debug {
       }
     }
 
+    /// <summary>Field number for the "hit_limit" field.</summary>
+    public const int HitLimitFieldNumber = 15;
+    private int hitLimit_;
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public int HitLimit {
+      get { return hitLimit_; }
+      set {
+        hitLimit_ = value;
+      }
+    }
+
+    /// <summary>Field number for the "expire_time" field.</summary>
+    public const int ExpireTimeFieldNumber = 16;
+    private global::Google.Protobuf.WellKnownTypes.Timestamp expireTime_;
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public global::Google.Protobuf.WellKnownTypes.Timestamp ExpireTime {
+      get { return expireTime_; }
+      set {
+        expireTime_ = value;
+      }
+    }
+
+    /// <summary>Field number for the "breakpoints" field.</summary>
+    public const int BreakpointsFieldNumber = 17;
+    private static readonly pb::FieldCodec<global::Google.Cloud.Diagnostics.Debug.Breakpoint> _repeated_breakpoints_codec
+        = pb::FieldCodec.ForMessage(138, global::Google.Cloud.Diagnostics.Debug.Breakpoint.Parser);
+    private readonly pbc::RepeatedField<global::Google.Cloud.Diagnostics.Debug.Breakpoint> breakpoints_ = new pbc::RepeatedField<global::Google.Cloud.Diagnostics.Debug.Breakpoint>();
+    /// <summary>
+    /// Only set on a sync breakpoint, which holds every active breakpoint.
+    /// </summary>
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public pbc::RepeatedField<global::Google.Cloud.Diagnostics.Debug.Breakpoint> Breakpoints {
+      get { return breakpoints_; }
+    }
+
+    /// <summary>Field number for the "sample_every" field.</summary>
+    public const int SampleEveryFieldNumber = 18;
+    private int sampleEvery_;
+    /// <summary>
+    /// If set, only every sample_every-th hit of the breakpoint is processed.
+    /// </summary>
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public int SampleEvery {
+      get { return sampleEvery_; }
+      set {
+        sampleEvery_ = value;
+      }
+    }
+
+    /// <summary>Field number for the "sample_rate" field.</summary>
+    public const int SampleRateFieldNumber = 19;
+    private double sampleRate_;
+    /// <summary>
+    /// If set, only this fraction of the hits of the breakpoint is processed,
+    /// chosen at random.
+    /// </summary>
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public double SampleRate {
+      get { return sampleRate_; }
+      set {
+        sampleRate_ = value;
+      }
+    }
+
+    /// <summary>Field number for the "static_expression_ttl_ms" field.</summary>
+    public const int StaticExpressionTtlMsFieldNumber = 20;
+    private int staticExpressionTtlMs_;
+    /// <summary>
+    /// If set, the evaluated expressions that only read static members and
+    /// constants are reused by the hits for this many milliseconds.
+    /// </summary>
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public int StaticExpressionTtlMs {
+      get { return staticExpressionTtlMs_; }
+      set {
+        staticExpressionTtlMs_ = value;
+      }
+    }
+
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
     public override bool Equals(object other) {
       return Equals(other as Breakpoint);
@@ -286,6 +376,12 @@ namespace Google.Cloud.Diagnostics.Debug {
       if (LogPoint != other.LogPoint) return false;
       if (LogMessageFormat != other.LogMessageFormat) return false;
       if (LogLevel != other.LogLevel) return false;
+      if (HitLimit != other.HitLimit) return false;
+      if (!object.Equals(ExpireTime, other.ExpireTime)) return false;
+      if(!breakpoints_.Equals(other.breakpoints_)) return false;
+      if (SampleEvery != other.SampleEvery) return false;
+      if (SampleRate != other.SampleRate) return false;
+      if (StaticExpressionTtlMs != other.StaticExpressionTtlMs) return false;
       return true;
     }
 
@@ -306,6 +402,12 @@ namespace Google.Cloud.Diagnostics.Debug {
       if (LogPoint != false) hash ^= LogPoint.GetHashCode();
       if (LogMessageFormat.Length != 0) hash ^= LogMessageFormat.GetHashCode();
       if (LogLevel != 0) hash ^= LogLevel.GetHashCode();
+      if (HitLimit != 0) hash ^= HitLimit.GetHashCode();
+      if (expireTime_ != null) hash ^= ExpireTime.GetHashCode();
+      hash ^= breakpoints_.GetHashCode();
+      if (SampleEvery != 0) hash ^= SampleEvery.GetHashCode();
+      if (SampleRate != 0D) hash ^= SampleRate.GetHashCode();
+      if (StaticExpressionTtlMs != 0) hash ^= StaticExpressionTtlMs.GetHashCode();
       return hash;
     }
 
@@ -363,6 +465,27 @@ namespace Google.Cloud.Diagnostics.Debug {
         output.WriteRawTag(112);
         output.WriteEnum((int) LogLevel);
       }
+      if (HitLimit != 0) {
+        output.WriteRawTag(120);
+        output.WriteInt32(HitLimit);
+      }
+      if (expireTime_ != null) {
+        output.WriteRawTag(130, 1);
+        output.WriteMessage(ExpireTime);
+      }
+      breakpoints_.WriteTo(output, _repeated_breakpoints_codec);
+      if (SampleEvery != 0) {
+        output.WriteRawTag(144, 1);
+        output.WriteInt32(SampleEvery);
+      }
+      if (SampleRate != 0D) {
+        output.WriteRawTag(153, 1);
+        output.WriteDouble(SampleRate);
+      }
+      if (StaticExpressionTtlMs != 0) {
+        output.WriteRawTag(160, 1);
+        output.WriteInt32(StaticExpressionTtlMs);
+      }
     }
 
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
@@ -404,6 +527,22 @@ namespace Google.Cloud.Diagnostics.Debug {
       if (LogLevel != 0) {
         size += 1 + pb::CodedOutputStream.ComputeEnumSize((int) LogLevel);
       }
+      if (HitLimit != 0) {
+        size += 1 + pb::CodedOutputStream.ComputeInt32Size(HitLimit);
+      }
+      if (expireTime_ != null) {
+        size += 2 + pb::CodedOutputStream.ComputeMessageSize(ExpireTime);
+      }
+      size += breakpoints_.CalculateSize(_repeated_breakpoints_codec);
+      if (SampleEvery != 0) {
+        size += 2 + pb::CodedOutputStream.ComputeInt32Size(SampleEvery);
+      }
+      if (SampleRate != 0D) {
+        size += 2 + 8;
+      }
+      if (StaticExpressionTtlMs != 0) {
+        size += 2 + pb::CodedOutputStream.ComputeInt32Size(StaticExpressionTtlMs);
+      }
       return size;
     }
 
@@ -460,6 +599,25 @@ namespace Google.Cloud.Diagnostics.Debug {
       if (other.LogLevel != 0) {
         LogLevel = other.LogLevel;
       }
+      if (other.HitLimit != 0) {
+        HitLimit = other.HitLimit;
+      }
+      if (other.expireTime_ != null) {
+        if (expireTime_ == null) {
+          expireTime_ = new global::Google.Protobuf.WellKnownTypes.Timestamp();
+        }
+        ExpireTime.MergeFrom(other.ExpireTime);
+      }
+      breakpoints_.Add(other.breakpoints_);
+      if (other.SampleEvery != 0) {
+        SampleEvery = other.SampleEvery;
+      }
+      if (other.SampleRate != 0D) {
+        SampleRate = other.SampleRate;
+      }
+      if (other.StaticExpressionTtlMs != 0) {
+        StaticExpressionTtlMs = other.StaticExpressionTtlMs;
+      }
     }
 
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
@@ -538,6 +696,33 @@ namespace Google.Cloud.Diagnostics.Debug {
             logLevel_ = (global::Google.Cloud.Diagnostics.Debug.Breakpoint.Types.LogLevel) input.ReadEnum();
             break;
           }
+          case 120: {
+            HitLimit = input.ReadInt32();
+            break;
+          }
+          case 130: {
+            if (expireTime_ == null) {
+              expireTime_ = new global::Google.Protobuf.WellKnownTypes.Timestamp();
+            }
+            input.ReadMessage(expireTime_);
+            break;
+          }
+          case 138: {
+            breakpoints_.AddEntriesFrom(input, _repeated_breakpoints_codec);
+            break;
+          }
+          case 144: {
+            SampleEvery = input.ReadInt32();
+            break;
+          }
+          case 153: {
+            SampleRate = input.ReadDouble();
+            break;
+          }
+          case 160: {
+            StaticExpressionTtlMs = input.ReadInt32();
+            break;
+          }
         }
       }
     }
@@ -774,6 +959,7 @@ namespace Google.Cloud.Diagnostics.Debug {
     public SourceLocation(SourceLocation other) : this() {
       path_ = other.path_;
       line_ = other.line_;
+      contentHash_ = other.contentHash_;
     }
 
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
@@ -803,6 +989,22 @@ namespace Google.Cloud.Diagnostics.Debug {
       }
     }
 
+    /// <summary>Field number for the "content_hash" field.</summary>
+    public const int ContentHashFieldNumber = 3;
+    private string contentHash_ = "";
+    /// <summary>
+    /// Hex encoded hash of the content of the source file, as the PDB records
+    /// it. Optional; used to find the document of a breakpoint when several
+    /// files share the same path suffix.
+    /// </summary>
+    [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
+    public string ContentHash {
+      get { return contentHash_; }
+      set {
+        contentHash_ = pb::ProtoPreconditions.CheckNotNull(value, "value");
+      }
+    }
+
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
     public override bool Equals(object other) {
       return Equals(other as SourceLocation);
@@ -818,6 +1020,7 @@ namespace Google.Cloud.Diagnostics.Debug {
       }
       if (Path != other.Path) return false;
       if (Line != other.Line) return false;
+      if (ContentHash != other.ContentHash) return false;
       return true;
     }
 
@@ -826,6 +1029,7 @@ namespace Google.Cloud.Diagnostics.Debug {
       int hash = 1;
       if (Path.Length != 0) hash ^= Path.GetHashCode();
       if (Line != 0) hash ^= Line.GetHashCode();
+      if (ContentHash.Length != 0) hash ^= ContentHash.GetHashCode();
       return hash;
     }
 
@@ -844,6 +1048,10 @@ namespace Google.Cloud.Diagnostics.Debug {
         output.WriteRawTag(16);
         output.WriteInt32(Line);
       }
+      if (ContentHash.Length != 0) {
+        output.WriteRawTag(26);
+        output.WriteString(ContentHash);
+      }
     }
 
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
@@ -855,6 +1063,9 @@ namespace Google.Cloud.Diagnostics.Debug {
       if (Line != 0) {
         size += 1 + pb::CodedOutputStream.ComputeInt32Size(Line);
       }
+      if (ContentHash.Length != 0) {
+        size += 1 + pb::CodedOutputStream.ComputeStringSize(ContentHash);
+      }
       return size;
     }
 
@@ -869,6 +1080,9 @@ namespace Google.Cloud.Diagnostics.Debug {
       if (other.Line != 0) {
         Line = other.Line;
       }
+      if (other.ContentHash.Length != 0) {
+        ContentHash = other.ContentHash;
+      }
     }
 
     [global::System.Diagnostics.DebuggerNonUserCodeAttribute]
@@ -887,6 +1101,10 @@ namespace Google.Cloud.Diagnostics.Debug {
             Line = input.ReadInt32();
             break;
           }
+          case 26: {
+            ContentHash = input.ReadString();
+            break;
+          }
         }
       }
     }
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 using Google.Api.Gax;
+using Google.Protobuf.WellKnownTypes;
+using System.Globalization;
 using System.Linq;
 using StackdriverBreakpoint = Google.Cloud.Debugger.V2.Breakpoint;
 using StackdriverSourceLocation = Google.Cloud.Debugger.V2.SourceLocation;
@@ -26,11 +28,20 @@ namespace Google.Cloud.Diagnostics.Debug
     {
         /// <summary>
         /// Converts a <see cref="StackdriverBreakpoint"/> to a <see cref="Breakpoint"/>.
-        /// Converts ID and location and sets "Activated" to true.
+        /// Converts ID and location, with the content hash from the
+        /// <see cref="Constants.ContentHashLabel"/> label, and sets "Activated" to true.
+        /// The sampling of the hits comes from the <see cref="Constants.SampleEveryLabel"/>
+        /// and <see cref="Constants.SampleRateLabel"/> labels, and how long the values of
+        /// static-only expressions are reused from the <see cref="Constants.StaticExpressionTtlLabel"/>
+        /// label.
+        /// A snapshot is finished by its first hit and expires
+        /// <see cref="Constants.SnapshotExpiration"/> after it is created, which the
+        /// debugger enforces without waiting for the agent.
         /// </summary>
         public static Breakpoint Convert(this StackdriverBreakpoint breakpoint)
         {
             GaxPreconditions.CheckNotNull(breakpoint, nameof(breakpoint));
+            bool logPoint = breakpoint.Action == StackdriverBreakpoint.Types.Action.Log;
             return new Breakpoint
             {
                 Id = breakpoint.Id,
@@ -39,15 +50,73 @@ namespace Google.Cloud.Diagnostics.Debug
                 {
                     Line = breakpoint.Location?.Line ?? 0,
                     Path = breakpoint.Location?.Path,
+                    ContentHash = GetContentHash(breakpoint),
                 },
                 Condition = breakpoint.Condition,
                 Expressions = { breakpoint.Expressions },
-                LogPoint = breakpoint.Action == StackdriverBreakpoint.Types.Action.Log,
+                LogPoint = logPoint,
                 LogMessageFormat = breakpoint.LogMessageFormat,
-                LogLevel = (Breakpoint.Types.LogLevel)breakpoint.LogLevel
+                LogLevel = (Breakpoint.Types.LogLevel)breakpoint.LogLevel,
+                HitLimit = logPoint ? 0 : 1,
+                SampleEvery = GetSampleEvery(breakpoint),
+                SampleRate = GetSampleRate(breakpoint),
+                StaticExpressionTtlMs = GetStaticExpressionTtlMs(breakpoint),
+                ExpireTime = logPoint || breakpoint.CreateTime == null ? null
+                    : Timestamp.FromDateTime(breakpoint.CreateTime.ToDateTime() + Constants.SnapshotExpiration)
             };
         }
 
+        /// <summary>
+        /// Returns the value of the <see cref="Constants.ContentHashLabel"/> label of the
+        /// breakpoint, or an empty string if it has none.
+        /// </summary>
+        private static string GetContentHash(StackdriverBreakpoint breakpoint)
+        {
+            string contentHash;
+            return breakpoint.Labels.TryGetValue(Constants.ContentHashLabel, out contentHash)
+                ? contentHash : string.Empty;
+        }
+
+        /// <summary>
+        /// Returns the value of the <see cref="Constants.SampleEveryLabel"/> label of the
+        /// breakpoint, or 0 if it has none or it is not a positive integer.
+        /// </summary>
+        private static int GetSampleEvery(StackdriverBreakpoint breakpoint)
+        {
+            string label;
+            int sampleEvery;
+            return breakpoint.Labels.TryGetValue(Constants.SampleEveryLabel, out label)
+                && int.TryParse(label, NumberStyles.None, CultureInfo.InvariantCulture, out sampleEvery)
+                ? sampleEvery : 0;
+        }
+
+        /// <summary>
+        /// Returns the value of the <see cref="Constants.SampleRateLabel"/> label of the
+        /// breakpoint, or 0 if it has none or it is not a fraction between 0 and 1.
+        /// </summary>
+        private static double GetSampleRate(StackdriverBreakpoint breakpoint)
+        {
+            string label;
+            double sampleRate;
+            return breakpoint.Labels.TryGetValue(Constants.SampleRateLabel, out label)
+                && double.TryParse(label, NumberStyles.Float, CultureInfo.InvariantCulture, out sampleRate)
+                && sampleRate > 0 && sampleRate <= 1
+                ? sampleRate : 0;
+        }
+
+        /// <summary>
+        /// Returns the value of the <see cref="Constants.StaticExpressionTtlLabel"/> label of
+        /// the breakpoint, or 0 if it has none or it is not a positive integer.
+        /// </summary>
+        private static int GetStaticExpressionTtlMs(StackdriverBreakpoint breakpoint)
+        {
+            string label;
+            int ttl;
+            return breakpoint.Labels.TryGetValue(Constants.StaticExpressionTtlLabel, out label)
+                && int.TryParse(label, NumberStyles.None, CultureInfo.InvariantCulture, out ttl)
+                ? ttl : 0;
+        }
+
         /// <summary>
         /// Converts a <see cref="Breakpoint"/> to a <see cref="StackdriverBreakpoint"/>.
         /// </summary>
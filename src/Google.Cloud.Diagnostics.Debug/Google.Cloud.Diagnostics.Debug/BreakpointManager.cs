@@ -13,7 +13,6 @@
 // limitations under the License.
 
 using System.Collections.Generic;
-using System.Linq;
 using StackdriverBreakpoint = Google.Cloud.Debugger.V2.Breakpoint;
 
 namespace Google.Cloud.Diagnostics.Debug
@@ -37,12 +36,22 @@ namespace Google.Cloud.Diagnostics.Debug
             /// Breakpoints from during this update.
             /// </summary>
             public IEnumerable<StackdriverBreakpoint> Removed { get; set; }
+
+            /// <summary>
+            /// All active breakpoints after this update, in the order they were listed.
+            /// </summary>
+            public IEnumerable<StackdriverBreakpoint> Active { get; set; }
+
+            /// <summary>
+            /// True if there are new or removed breakpoints.
+            /// </summary>
+            public bool Changed { get; set; }
         }
 
         /// <summary>
         /// The list of current breakpoints.
         /// </summary>
-        private readonly Dictionary<string, StackdriverBreakpoint> _breakpointDictionary =
+        private Dictionary<string, StackdriverBreakpoint> _breakpointDictionary =
             new Dictionary<string, StackdriverBreakpoint>();
 
         /// <summary>A lock to protect the breakpoint dictionary.</summary>
@@ -51,40 +60,60 @@ namespace Google.Cloud.Diagnostics.Debug
         /// <summary>
         /// Update the current set of active breakpoints.
         /// </summary>
+        /// <remarks>
+        /// This runs on every poll of the debugger API, so it makes a single pass over
+        /// the active breakpoints and only looks for removed ones if some are missing.
+        /// </remarks>
         /// <param name="activeBreakpoints">The current set of active breakpoints from the debugger API.</param>
         public BreakpointManagerResponse UpdateBreakpoints(IEnumerable<StackdriverBreakpoint> activeBreakpoints)
         {
             lock (_mutex)
             {
-                var identifiersToBreakpoint = new Dictionary<string, StackdriverBreakpoint>();
+                var identifiersToBreakpoint = new Dictionary<string, StackdriverBreakpoint>(
+                    _breakpointDictionary.Count);
+                var active = new List<StackdriverBreakpoint>();
+                var newBreakpoints = new List<StackdriverBreakpoint>();
                 foreach (var breakpoint in activeBreakpoints)
                 {
-                    if (!identifiersToBreakpoint.ContainsKey(breakpoint.Id))
+                    if (identifiersToBreakpoint.ContainsKey(breakpoint.Id))
                     {
-                        identifiersToBreakpoint.Add(breakpoint.Id, breakpoint);
+                        continue;
                     }
-                }
 
-                var newBreakpoints = identifiersToBreakpoint.Values.Where(
-                    b => !_breakpointDictionary.ContainsKey(b.Id)).ToList();
-                foreach (var newBreakpoint in newBreakpoints)
-                {
-                    _breakpointDictionary[newBreakpoint.Id] = newBreakpoint;
+                    active.Add(breakpoint);
+                    StackdriverBreakpoint existing;
+                    if (_breakpointDictionary.TryGetValue(breakpoint.Id, out existing))
+                    {
+                        identifiersToBreakpoint.Add(breakpoint.Id, existing);
+                    }
+                    else
+                    {
+                        identifiersToBreakpoint.Add(breakpoint.Id, breakpoint);
+                        newBreakpoints.Add(breakpoint);
+                    }
                 }
 
-                var removedBreakpoints = _breakpointDictionary.Keys
-                    .Where(identifier => !identifiersToBreakpoint.ContainsKey(identifier))
-                    .Select(id => _breakpointDictionary[id])
-                    .ToList();
-                foreach (var removedBreakpoint in removedBreakpoints)
+                // Every known breakpoint that is still active was found above, so none
+                // were removed if all of them were.
+                var removedBreakpoints = new List<StackdriverBreakpoint>();
+                if (active.Count - newBreakpoints.Count != _breakpointDictionary.Count)
                 {
-                    _breakpointDictionary.Remove(removedBreakpoint.Id);
+                    foreach (var entry in _breakpointDictionary)
+                    {
+                        if (!identifiersToBreakpoint.ContainsKey(entry.Key))
+                        {
+                            removedBreakpoints.Add(entry.Value);
+                        }
+                    }
                 }
+                _breakpointDictionary = identifiersToBreakpoint;
 
                 return new BreakpointManagerResponse
                 {
                     New = newBreakpoints,
-                    Removed = removedBreakpoints
+                    Removed = removedBreakpoints,
+                    Active = active,
+                    Changed = newBreakpoints.Count > 0 || removedBreakpoints.Count > 0
                 };
             }
         }
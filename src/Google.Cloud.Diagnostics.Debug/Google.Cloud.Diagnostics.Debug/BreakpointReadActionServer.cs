@@ -15,6 +15,8 @@
 using Google.Api.Gax;
 using Google.Cloud.Logging.V2;
 using Google.Cloud.Logging.Type;
+using System;
+using System.Linq;
 using System.Threading;
 using StackdriverBreakpoint = Google.Cloud.Debugger.V2.Breakpoint;
 using Google.Api;
@@ -31,6 +33,7 @@ namespace Google.Cloud.Diagnostics.Debug
         private readonly IDebuggerClient _debuggerClient;
         private readonly ILoggingClient _loggingClient;
         private readonly BreakpointManager _breakpointManager;
+        private readonly LogEntryUploader _logUploader;
 
         /// <summary>
         /// Create a new <see cref="BreakpointReadActionServer"/>.
@@ -39,13 +42,16 @@ namespace Google.Cloud.Diagnostics.Debug
         /// <param name="cts"> A cancellation token source to cancel if the server receives a shutdown command.</param>
         /// <param name="client">The debugger client to send updated breakpoints to.</param>
         /// <param name="breakpointManager">A shared breakpoint manager.</param>
+        /// <param name="logUploader">Writes the hits of log points together off the thread
+        ///     reading breakpoints, or null to write each hit as it is read.</param>
         public BreakpointReadActionServer(IBreakpointServer server, CancellationTokenSource cts,
             IDebuggerClient debuggerClient, ILoggingClient loggingClient,
-            BreakpointManager breakpointManager) : base(server, cts)
+            BreakpointManager breakpointManager, LogEntryUploader logUploader = null) : base(server, cts)
         {
             _debuggerClient = GaxPreconditions.CheckNotNull(debuggerClient, nameof(debuggerClient));
             _loggingClient = GaxPreconditions.CheckNotNull(loggingClient, nameof(loggingClient));
             _breakpointManager = GaxPreconditions.CheckNotNull(breakpointManager, nameof(breakpointManager));
+            _logUploader = logUploader;
         }
 
         /// <summary>
@@ -60,10 +66,27 @@ namespace Google.Cloud.Diagnostics.Debug
                 _cts.Cancel();
                 return;
             }
+            if (readBreakpoint.Id == Constants.MetricsBreakpointId)
+            {
+                Console.WriteLine(FormatMetrics(readBreakpoint));
+                return;
+            }
+            if (readBreakpoint.Id == Constants.ReadyBreakpointId)
+            {
+                Console.WriteLine(FormatReady(readBreakpoint));
+                return;
+            }
             StackdriverBreakpoint breakpoint = readBreakpoint.Convert();
             if (breakpoint.Action == StackdriverBreakpoint.Types.Action.Log)
             {
-                _loggingClient.WriteLogEntry(breakpoint);
+                if (_logUploader != null)
+                {
+                    _logUploader.Add(new[] { _loggingClient.CreateLogRecord(breakpoint) });
+                }
+                else
+                {
+                    _loggingClient.WriteLogEntry(breakpoint);
+                }
             }
             else
             {
@@ -71,5 +94,27 @@ namespace Google.Cloud.Diagnostics.Debug
             }
             _debuggerClient.UpdateBreakpoint(breakpoint);
         }
+
+        /// <summary>
+        /// Formats the metrics reported by the debugger on one line, with the
+        /// members of histograms in parentheses.
+        /// </summary>
+        internal static string FormatMetrics(Breakpoint metrics) =>
+            $"Debugger metrics: {FormatVariables(metrics)}";
+
+        /// <summary>
+        /// Formats the startup timings the debugger reports once it is ready on one line.
+        /// </summary>
+        internal static string FormatReady(Breakpoint ready) =>
+            $"Debugger ready: {FormatVariables(ready)}";
+
+        private static string FormatVariables(Breakpoint breakpoint)
+        {
+            var formatted = breakpoint.EvaluatedExpressions.Select(metric =>
+                metric.Members.Count == 0
+                    ? $"{metric.Name}={metric.Value}"
+                    : $"{metric.Name}=({string.Join(" ", metric.Members.Select(m => $"{m.Name}={m.Value}"))})");
+            return string.Join(" ", formatted);
+        }
     }
 }
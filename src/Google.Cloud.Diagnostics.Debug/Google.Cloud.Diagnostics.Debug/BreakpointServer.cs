@@ -15,7 +15,8 @@
 using Google.Protobuf;
 using System;
 using System.Collections.Generic;
-using System.Linq;
+using System.IO;
+using System.IO.Compression;
 using System.Threading;
 using System.Threading.Tasks;
 
@@ -29,17 +30,59 @@ namespace Google.Cloud.Diagnostics.Debug
         /// <summary>A semaphore to protect the buffer.</summary>
         private readonly SemaphoreSlim _semaphore = new SemaphoreSlim(1);
 
-        /// <summary>A buffer to store partial breakpoint messages.</summary>
-        private List<byte> _buffer = new List<byte>();
+        /// <summary>The initial size of the buffer.</summary>
+        private const int InitialBufferSize = 4096;
+
+        /// <summary>
+        /// A buffer to store partial breakpoint messages. The bytes read but not consumed
+        /// yet are those from <see cref="_bufferStart"/> to <see cref="_bufferEnd"/>, so
+        /// that a message is consumed without moving the ones after it.
+        /// </summary>
+        private byte[] _buffer = new byte[InitialBufferSize];
+
+        /// <summary>The index of the first byte in the buffer not consumed yet.</summary>
+        private int _bufferStart;
+
+        /// <summary>The index past the last byte read into the buffer.</summary>
+        private int _bufferEnd;
+
+        /// <summary>
+        /// The number of bytes from <see cref="_bufferStart"/> already searched for
+        /// <see cref="Constants.EndBreakpointMessage"/> without a match.
+        /// </summary>
+        private int _bufferScanned;
 
         /// <summary>The pipe to send and receive breakpoint messages with.</summary>
         private readonly INamedPipeServer _pipe;
 
+        /// <summary>How breakpoint messages are delimited on the pipe.</summary>
+        private readonly MessageFraming _framing;
+
+        /// <summary>Handles the batches of log records read from the pipe, or null.</summary>
+        private readonly Action<IList<LogRecord>> _onLogRecords;
+
+        /// <summary>Reads back the unchanged variables of snapshots, or null.</summary>
+        private readonly SnapshotDelta _delta;
+
         /// <summary>
         /// Create a <see cref="BreakpointServer"/>.
         /// </summary>
         /// <param name="pipe">The named pipe to send and receive breakpoint messages with.</param>
-        public BreakpointServer(INamedPipeServer pipe) =>_pipe = pipe;
+        /// <param name="framing">How breakpoint messages are delimited on the pipe. This must
+        ///     match the framing the debugger was started with.</param>
+        /// <param name="onLogRecords">Handles the hits of log points the debugger sends as
+        ///     log records, which <see cref="ReadBreakpointAsync"/> does not return. Required if
+        ///     the debugger was started with <see cref="DebuggerOptions.LogRecordsOption"/>.</param>
+        /// <param name="deltaSnapshots">True if the debugger was started with
+        ///     <see cref="DebuggerOptions.DeltaSnapshotsOption"/>.</param>
+        public BreakpointServer(INamedPipeServer pipe, MessageFraming framing = MessageFraming.Markers,
+            Action<IList<LogRecord>> onLogRecords = null, bool deltaSnapshots = false)
+        {
+            _pipe = pipe;
+            _framing = framing;
+            _onLogRecords = onLogRecords;
+            _delta = deltaSnapshots ? new SnapshotDelta() : null;
+        }
 
         /// <inheritdoc />
         public Task WaitForConnectionAsync() => _pipe.WaitForConnectionAsync();
@@ -50,34 +93,40 @@ namespace Google.Cloud.Diagnostics.Debug
             await _semaphore.WaitAsync(cancellationToken).ConfigureAwait(false);
             try
             {
-                List<byte> previousBuffer = _buffer;
-                _buffer = new List<byte>();
+                if (_framing == MessageFraming.LengthPrefixed)
+                {
+                    return Decode(await ReadLengthPrefixedBreakpointAsync(cancellationToken).ConfigureAwait(false));
+                }
 
-                int bytesWrittenSoFar = 0;
                 // Check if we have a full breakpoint message in the buffer.
                 // If so just use it and do not try and read another breakpoint.
-                int endIndex = IndexOfSequence(previousBuffer.ToArray(), Constants.EndBreakpointMessage);
+                // Only the bytes read since the last search are searched again.
+                int endIndex = IndexOfSequence(_buffer, _bufferStart + _bufferScanned,
+                    _bufferEnd, Constants.EndBreakpointMessage);
                 while (endIndex == -1)
                 {
-                    byte[] bytes = await _pipe.ReadAsync(cancellationToken);
-                    bytesWrittenSoFar = previousBuffer.Count;
-                    previousBuffer.AddRange(bytes);
-                    endIndex = IndexOfSequence(previousBuffer.ToArray(),
-                                               Constants.EndBreakpointMessage);
+                    // The end of the message may start in the last bytes searched.
+                    _bufferScanned = Math.Max(0,
+                        _bufferEnd - _bufferStart - Constants.EndBreakpointMessage.Length + 1);
+                    AppendToBuffer(await _pipe.ReadAsync(cancellationToken));
+                    endIndex = IndexOfSequence(_buffer, _bufferStart + _bufferScanned,
+                        _bufferEnd, Constants.EndBreakpointMessage);
                 }
 
                 // Ensure we have a start to the breakpoint message.
-                int startIndex = IndexOfSequence(previousBuffer.ToArray(),
+                int startIndex = IndexOfSequence(_buffer, _bufferStart, endIndex,
                                                  Constants.StartBreakpointMessage);
                 if (startIndex == -1)
                 {
                     throw new InvalidOperationException("Invalid breakpoint message.");
                 }
 
-                var newBytes = previousBuffer.GetRange(
-                    startIndex + Constants.StartBreakpointMessage.Length, endIndex - startIndex - Constants.StartBreakpointMessage.Length);
-                _buffer.AddRange(previousBuffer.Skip(endIndex + Constants.EndBreakpointMessage.Length));
-                return Breakpoint.Parser.ParseFrom(newBytes.ToArray());
+                int messageStart = startIndex + Constants.StartBreakpointMessage.Length;
+                byte[] message = new byte[endIndex - messageStart];
+                Buffer.BlockCopy(_buffer, messageStart, message, 0, message.Length);
+                _bufferStart = endIndex + Constants.EndBreakpointMessage.Length;
+                _bufferScanned = 0;
+                return Decode(Breakpoint.Parser.ParseFrom(message));
             }
             finally
             {
@@ -85,9 +134,178 @@ namespace Google.Cloud.Diagnostics.Debug
             }
         }
 
+        /// <summary>
+        /// Reads back the strings of the string table and the unchanged variables of a
+        /// breakpoint read from the pipe, in the reverse order the debugger encoded them.
+        /// </summary>
+        private Breakpoint Decode(Breakpoint breakpoint)
+        {
+            breakpoint = SnapshotStringTable.Decode(breakpoint);
+            return _delta == null ? breakpoint : _delta.Decode(breakpoint);
+        }
+
+        /// <summary>
+        /// Reads a frame header and then the number of bytes in it, and parses
+        /// the breakpoint from them. A breakpoint written in chunks is merged from
+        /// the frames up to the first one without <see cref="Constants.FrameChunkFlag"/>.
+        /// Frames of log records are passed to the handler of log records and skipped.
+        /// Must be called with the semaphore held.
+        /// </summary>
+        private async Task<Breakpoint> ReadLengthPrefixedBreakpointAsync(CancellationToken cancellationToken)
+        {
+            Breakpoint breakpoint = new Breakpoint();
+            long chunkedSize = 0;
+            while (true)
+            {
+                await FillBufferAsync(Constants.FrameHeaderSize, cancellationToken).ConfigureAwait(false);
+                bool chunk = (_buffer[_bufferStart] & Constants.FrameChunkFlag) != 0;
+                bool logRecords = (_buffer[_bufferStart] & Constants.FrameLogRecordsFlag) != 0;
+                byte[] message = await ReadFrameAsync(cancellationToken).ConfigureAwait(false);
+                if (logRecords)
+                {
+                    if (_onLogRecords == null || chunkedSize > 0)
+                    {
+                        throw new InvalidOperationException("Unexpected log records frame.");
+                    }
+                    _onLogRecords(LogRecord.ParseBatch(message));
+                    continue;
+                }
+
+                chunkedSize += message.Length;
+                if (chunkedSize > Constants.MaximumChunkedBreakpointSize)
+                {
+                    throw new InvalidOperationException($"Invalid chunked breakpoint size {chunkedSize}.");
+                }
+
+                breakpoint.MergeFrom(message);
+                if (!chunk)
+                {
+                    return breakpoint;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Reads a frame header and then the number of bytes in it, and returns
+        /// the serialized breakpoint they hold. Must be called with the semaphore held.
+        /// </summary>
+        private async Task<byte[]> ReadFrameAsync(CancellationToken cancellationToken)
+        {
+            await FillBufferAsync(Constants.FrameHeaderSize, cancellationToken).ConfigureAwait(false);
+            byte version = _buffer[_bufferStart];
+            bool compressed = (version & Constants.FrameCompressedFlag) != 0;
+            byte flags = Constants.FrameCompressedFlag | Constants.FrameChunkFlag | Constants.FrameLogRecordsFlag;
+            if ((version & ~flags) != Constants.FrameVersion)
+            {
+                throw new InvalidOperationException($"Unsupported breakpoint frame version {version}.");
+            }
+
+            int header = _bufferStart;
+            uint size = (uint)(_buffer[header + 1] | _buffer[header + 2] << 8 |
+                _buffer[header + 3] << 16 | _buffer[header + 4] << 24);
+            if (size > Constants.MaximumFrameSize)
+            {
+                throw new InvalidOperationException($"Invalid breakpoint frame size {size}.");
+            }
+
+            int frameSize = Constants.FrameHeaderSize + (int)size;
+            await FillBufferAsync(frameSize, cancellationToken).ConfigureAwait(false);
+            byte[] message = new byte[size];
+            // Filling the buffer may have moved the frame to the front of it.
+            Buffer.BlockCopy(_buffer, _bufferStart + Constants.FrameHeaderSize, message, 0, (int)size);
+            _bufferStart += frameSize;
+            return compressed ? DecompressBreakpoint(message) : message;
+        }
+
+        /// <summary>
+        /// Decompresses the serialized breakpoint of a message of a frame with
+        /// <see cref="Constants.FrameCompressedFlag"/> set.
+        /// </summary>
+        private static byte[] DecompressBreakpoint(byte[] message)
+        {
+            if (message.Length < sizeof(uint))
+            {
+                throw new InvalidOperationException("Invalid compressed breakpoint frame.");
+            }
+
+            uint size = (uint)(message[0] | message[1] << 8 | message[2] << 16 | message[3] << 24);
+            if (size > Constants.MaximumFrameSize)
+            {
+                throw new InvalidOperationException($"Invalid compressed breakpoint size {size}.");
+            }
+
+            byte[] breakpoint = new byte[size];
+            int read = 0;
+            using (var compressedStream = new MemoryStream(message, sizeof(uint), message.Length - sizeof(uint)))
+            using (var stream = new DeflateStream(compressedStream, CompressionMode.Decompress))
+            {
+                int count;
+                while (read < breakpoint.Length &&
+                    (count = stream.Read(breakpoint, read, breakpoint.Length - read)) > 0)
+                {
+                    read += count;
+                }
+            }
+
+            if (read != breakpoint.Length)
+            {
+                throw new InvalidOperationException("Truncated compressed breakpoint frame.");
+            }
+            return breakpoint;
+        }
+
+        /// <summary>
+        /// Reads from the pipe until the buffer holds at least count bytes.
+        /// </summary>
+        private async Task FillBufferAsync(int count, CancellationToken cancellationToken)
+        {
+            while (_bufferEnd - _bufferStart < count)
+            {
+                AppendToBuffer(await _pipe.ReadAsync(cancellationToken).ConfigureAwait(false));
+            }
+        }
+
+        /// <summary>
+        /// Appends bytes read from the pipe to the buffer. The bytes not consumed yet are
+        /// moved to the front of the buffer only when there is no room after them, and the
+        /// buffer grows only when they fill it, so a read holding many messages is copied
+        /// once rather than once per message.
+        /// </summary>
+        private void AppendToBuffer(byte[] bytes)
+        {
+            int count = _bufferEnd - _bufferStart;
+            if (bytes.Length > _buffer.Length - _bufferEnd)
+            {
+                byte[] buffer = _buffer;
+                if (count + bytes.Length > _buffer.Length)
+                {
+                    buffer = new byte[Math.Max(_buffer.Length * 2, count + bytes.Length)];
+                }
+                Buffer.BlockCopy(_buffer, _bufferStart, buffer, 0, count);
+                _buffer = buffer;
+                _bufferStart = 0;
+                _bufferEnd = count;
+            }
+            Buffer.BlockCopy(bytes, 0, _buffer, _bufferEnd, bytes.Length);
+            _bufferEnd += bytes.Length;
+        }
+
         /// <inheritdoc />
         public Task WriteBreakpointAsync(Breakpoint breakpoint, CancellationToken cancellationToken = default(CancellationToken))
         {
+            if (_framing == MessageFraming.LengthPrefixed)
+            {
+                byte[] message = breakpoint.ToByteArray();
+                byte[] frame = new byte[Constants.FrameHeaderSize + message.Length];
+                frame[0] = Constants.FrameVersion;
+                frame[1] = (byte)message.Length;
+                frame[2] = (byte)(message.Length >> 8);
+                frame[3] = (byte)(message.Length >> 16);
+                frame[4] = (byte)(message.Length >> 24);
+                Buffer.BlockCopy(message, 0, frame, Constants.FrameHeaderSize, message.Length);
+                return _pipe.WriteAsync(frame, cancellationToken);
+            }
+
             List<byte> bytes = new List<byte>();
             bytes.AddRange(Constants.StartBreakpointMessage);
             bytes.AddRange(breakpoint.ToByteArray());
@@ -101,9 +319,20 @@ namespace Google.Cloud.Diagnostics.Debug
         /// <param name="array">The array of bytes to look for a sequence in.</param>
         /// <param name="sequence">The sequence to search for.</param>
         /// <returns>The start index of the first sequence or -1 if none is found.</returns>
-        internal static int IndexOfSequence(byte[] array, byte[] sequence)
+        internal static int IndexOfSequence(byte[] array, byte[] sequence) =>
+            IndexOfSequence(array, 0, array.Length, sequence);
+
+        /// <summary>
+        /// Get the start index of a sequence that lies within a range of an array.
+        /// </summary>
+        /// <param name="array">The array of bytes to look for a sequence in.</param>
+        /// <param name="start">The index to start looking at.</param>
+        /// <param name="end">The index the sequence must end by.</param>
+        /// <param name="sequence">The sequence to search for.</param>
+        /// <returns>The start index of the first sequence or -1 if none is found.</returns>
+        internal static int IndexOfSequence(byte[] array, int start, int end, byte[] sequence)
         {
-            for (int i = 0; i < array.Length - sequence.Length + 1; i++)
+            for (int i = start; i < end - sequence.Length + 1; i++)
             {
                 // This check could be slightly more efficient if we tracked
                 // looked for the start of the sequence inside the match.
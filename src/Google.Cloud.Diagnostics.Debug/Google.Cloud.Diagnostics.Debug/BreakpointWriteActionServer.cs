@@ -13,6 +13,7 @@
 // limitations under the License.
 
 using Google.Api.Gax;
+using System.Collections.Generic;
 using System.Threading;
 
 namespace Google.Cloud.Diagnostics.Debug
@@ -42,9 +43,11 @@ namespace Google.Cloud.Diagnostics.Debug
         }
 
         /// <summary>
-        /// Lists breakpoints from the debugger API.  Stale breakpoints are removed,
-        /// new breakpoints are sent to the <see cref="IBreakpointServer"/> and 
-        /// breakpoints that cannot be processed are returned with an error.
+        /// Lists breakpoints from the debugger API.  If breakpoints were added or
+        /// removed, a single sync message with all active breakpoints is sent to the
+        /// <see cref="IBreakpointServer"/>.  Only new breakpoints are sent in full;
+        /// the debugger already has the others and deactivates the ones that are
+        /// missing from the message.
         /// </summary>
         internal override void MainAction()
         {
@@ -54,18 +57,25 @@ namespace Google.Cloud.Diagnostics.Debug
                 return;
             }
             var bpmResponse = _breakpointManager.UpdateBreakpoints(serverBreakpoints);
-
-            foreach (var breakpointToBeRemoved in bpmResponse.Removed)
+            if (!bpmResponse.Changed)
             {
-                var breakpoint = breakpointToBeRemoved.Convert();
-                breakpoint.Activated = false;
-                _server.WriteBreakpointAsync(breakpoint).Wait();
+                return;
             }
 
+            var newIds = new HashSet<string>();
             foreach (var breakpoint in bpmResponse.New)
             {
-                _server.WriteBreakpointAsync(breakpoint.Convert()).Wait();
+                newIds.Add(breakpoint.Id);
+            }
+
+            var sync = new Breakpoint { Id = Constants.SyncBreakpointsId };
+            foreach (var breakpoint in bpmResponse.Active)
+            {
+                sync.Breakpoints.Add(newIds.Contains(breakpoint.Id)
+                    ? breakpoint.Convert()
+                    : new Breakpoint { Id = breakpoint.Id, Activated = true });
             }
+            _server.WriteBreakpointAsync(sync).Wait();
         }
     }
 }
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+using System;
 using System.Text;
 
 namespace Google.Cloud.Diagnostics.Debug
@@ -29,5 +30,140 @@ namespace Google.Cloud.Diagnostics.Debug
 
         /// <summary>The end of a breakpoint message.</summary>
         public static readonly byte[] EndBreakpointMessage = Encoding.ASCII.GetBytes("END_DEBUG_MESSAGE");
+
+        /// <summary>The version of the frame header of length-prefixed messages.</summary>
+        public const byte FrameVersion = 1;
+
+        /// <summary>
+        /// Set in the version byte of a frame header if the message is the size of the
+        /// breakpoint as a little-endian uint32 followed by the breakpoint compressed
+        /// with raw deflate.
+        /// </summary>
+        public const byte FrameCompressedFlag = 0x80;
+
+        /// <summary>
+        /// Set in the version byte of a frame header if the message is a chunk of a
+        /// breakpoint that the messages of the following frames complete. Every chunk
+        /// is a serialized breakpoint and the breakpoint is all of them merged.
+        /// </summary>
+        public const byte FrameChunkFlag = 0x40;
+
+        /// <summary>
+        /// Set in the version byte of a frame header if the message is a batch of hits of
+        /// log points with their messages already formatted. See <see cref="LogRecord"/>.
+        /// </summary>
+        public const byte FrameLogRecordsFlag = 0x20;
+
+        /// <summary>The maximum total size of the chunks of a breakpoint.</summary>
+        public const int MaximumChunkedBreakpointSize = 64 * 1024 * 1024;
+
+        /// <summary>The size of the frame header of length-prefixed messages.</summary>
+        public const int FrameHeaderSize = 5;
+
+        /// <summary>The maximum size of a length-prefixed message.</summary>
+        public const int MaximumFrameSize = 16 * 1024 * 1024;
+
+        /// <summary>
+        /// The magic number at the start of the shared memory of a <see cref="SharedMemoryPipeServer"/>.
+        /// The shared memory is a header followed by the ring of the agent to the debugger and then
+        /// the ring of the debugger to the agent. The header is this number and the capacity of each
+        /// ring, both uint32 in the byte order of the machine. Each ring is a control block of three
+        /// cache lines, holding the write position, the read position and whether the reader waits
+        /// for the doorbell, and then capacity bytes of data.
+        /// </summary>
+        public const uint SharedMemoryMagic = 0x4D534443;
+
+        /// <summary>The size of the header of the shared memory of a shared memory pipe.</summary>
+        public const int SharedMemoryHeaderSize = 64;
+
+        /// <summary>The size of the control block of a ring of a shared memory pipe.</summary>
+        public const int SharedMemoryRingControlSize = 192;
+
+        /// <summary>The number of data bytes of each ring of a shared memory pipe.</summary>
+        public const int SharedMemoryRingCapacity = 1024 * 1024;
+
+        /// <summary>The files of shared memory pipes are this followed by the pipe name.</summary>
+        public const string SharedMemoryPathPrefix = "/dev/shm/CloudDebugger_";
+
+        /// <summary>
+        /// The time in milliseconds between checks of a full ring while waiting for the debugger
+        /// to read from it.
+        /// </summary>
+        public const int SharedMemoryFullRetryIntervalMs = 1;
+
+        /// <summary>
+        /// The ID of the messages the debugger reports its metrics in. Their evaluated
+        /// expressions are the metrics; they are not breakpoints.
+        /// </summary>
+        public const string MetricsBreakpointId = "_debugger_metrics";
+
+        /// <summary>
+        /// The ID of the message the debugger sends once it is attached to the application
+        /// and connected to the agent. Its evaluated expressions are how long the phases of
+        /// its startup took; it is not a breakpoint.
+        /// </summary>
+        public const string ReadyBreakpointId = "_debugger_ready";
+
+        /// <summary>
+        /// The ID of the message the agent syncs its breakpoints with. Its breakpoints are
+        /// every active breakpoint: in full if the debugger does not have them yet and only
+        /// with their ID otherwise. The debugger deactivates the breakpoints it has that are
+        /// not among them.
+        /// </summary>
+        public const string SyncBreakpointsId = "_sync_breakpoints";
+
+        /// <summary>
+        /// The label of a breakpoint that holds the hash of the content of its source file
+        /// in hex, as the PDB records it. The debugger uses it to find the document of the
+        /// breakpoint among documents that share its path suffix.
+        /// </summary>
+        public const string ContentHashLabel = "content_hash";
+
+        /// <summary>
+        /// The label of a breakpoint that samples its hits: only every Nth hit, N being
+        /// its value, is processed by the debugger.
+        /// </summary>
+        public const string SampleEveryLabel = "sample_every";
+
+        /// <summary>
+        /// The label of a breakpoint that samples its hits: only this fraction of its
+        /// hits, chosen at random, is processed by the debugger, such as "0.01" for 1%.
+        /// </summary>
+        public const string SampleRateLabel = "sample_rate";
+
+        /// <summary>
+        /// The label of a breakpoint whose expressions that only read static members and
+        /// constants are evaluated once and reused by its hits for this many milliseconds.
+        /// </summary>
+        public const string StaticExpressionTtlLabel = "static_expression_ttl_ms";
+
+        /// <summary>
+        /// The name of the last evaluated expression of a snapshot sent with a string table.
+        /// See <see cref="SnapshotStringTable"/>.
+        /// </summary>
+        public const string StringTableExpressionName = "_string_table";
+
+        /// <summary>
+        /// The first character of the strings of a snapshot that reference its string table.
+        /// </summary>
+        public const char StringTableReferencePrefix = '\x01';
+
+        /// <summary>
+        /// The name of the variables of a snapshot that did not change since the previous
+        /// snapshot of its breakpoint. See <see cref="SnapshotDelta"/>.
+        /// </summary>
+        public const string UnchangedVariableName = "\x02";
+
+        /// <summary>
+        /// The maximum number of breakpoints whose previous snapshot is kept to read back
+        /// the unchanged variables of their next snapshot. This must match the debugger.
+        /// </summary>
+        public const int MaximumDeltaSnapshotBreakpoints = 64;
+
+        /// <summary>
+        /// How long a snapshot is active after it is created. The Stackdriver Debugger
+        /// expires snapshots that are not hit within this time.
+        /// </summary>
+        public static readonly TimeSpan SnapshotExpiration = TimeSpan.FromHours(24);
     }
 }
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 using System;
+using System.Runtime.InteropServices;
 
 namespace Google.Cloud.Diagnostics.Debug
 {
@@ -36,6 +37,57 @@ namespace Google.Cloud.Diagnostics.Debug
         // The name of the pipe the debugger will attach to.
         public const string PipeNameOption = "--pipe-name";
 
+        // If given this option, the debugger will cache parsed PDB files in this directory.
+        public const string PdbIndexCacheDirOption = "--pdb-index-cache-dir";
+
+        // If given this option, the debugger will use length-prefixed breakpoint messages.
+        public const string LengthPrefixedFramingOption = "--length-prefixed-framing";
+
+        // If given this option, the debugger will read and write breakpoints through a single connection.
+        public const string DuplexPipeOption = "--duplex-pipe";
+
+        // If given this option, the bytes of the duplex pipe will go through memory shared with the agent.
+        public const string SharedMemoryPipeOption = "--shared-memory-pipe";
+
+        // If given this option, the debugger will drop log point messages when its write queue is full.
+        public const string DropLogPointsWhenQueueFullOption = "--drop-log-points-when-queue-full";
+
+        // If given this option, the debugger will compress large breakpoint messages.
+        public const string CompressBreakpointsOption = "--compress-breakpoints";
+
+        // If given this option, the debugger will send hits of log points as log records.
+        public const string LogRecordsOption = "--log-records";
+
+        // If given this option, the debugger will send the strings that snapshots repeat once.
+        public const string StringTableOption = "--string-table";
+
+        // If given this option, the debugger will send the variables of a snapshot that did not change as references.
+        public const string DeltaSnapshotsOption = "--delta-snapshots";
+
+        // If given this option, the debugger will not be notified of events it does not use.
+        public const string FilterCallbacksOption = "--filter-callbacks";
+
+        // If given this option, the debugger will send log points after the application continues.
+        public const string AsyncLogPointsOption = "--async-log-points";
+
+        // If given this option, the debugger will skip hits of a log point while another one is processed.
+        public const string CoalesceLogPointHitsOption = "--coalesce-log-point-hits";
+
+        // If given this option, the debugger will report the cost of breakpoints in their status.
+        public const string ReportBreakpointCostsOption = "--report-breakpoint-costs";
+
+        // The maximum time in milliseconds a function evaluation can take before the debugger aborts it.
+        public const string EvalTimeoutOption = "--eval-timeout-ms";
+
+        // The maximum total time in milliseconds of the function evaluations of a breakpoint.
+        public const string EvalBudgetOption = "--eval-budget-ms";
+
+        // The maximum number of function evaluations of a breakpoint.
+        public const string MaxFuncEvalsOption = "--max-func-evals";
+
+        // How often in milliseconds the debugger will send its metrics.
+        public const string MetricsIntervalOption = "--metrics-interval-ms";
+
         /// <summary>
         /// If true, the debugger will evaluate properties.
         /// </summary>
@@ -62,6 +114,109 @@ namespace Google.Cloud.Diagnostics.Debug
         /// </summary>
         public string PipeName { get; private set; }
 
+        /// <summary>
+        /// The directory where the debugger caches parsed PDB files, or null
+        /// to disable the cache.
+        /// </summary>
+        public string PdbIndexCacheDir { get; private set; }
+
+        /// <summary>
+        /// How breakpoint messages are delimited on the pipe between
+        /// the <see cref="Agent"/> and the debugger.
+        /// </summary>
+        public MessageFraming MessageFraming { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will read and write breakpoints through a single
+        /// connection to the <see cref="Agent"/> instead of one connection for each.
+        /// </summary>
+        public bool DuplexPipe { get; private set; }
+
+        /// <summary>
+        /// If true, the bytes of the duplex pipe go through memory shared with the debugger
+        /// and the connection only wakes up the side that waits for them.
+        /// See <see cref="SharedMemoryPipeServer"/>.
+        /// </summary>
+        public bool SharedMemoryPipe { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will drop log point messages instead of waiting
+        /// when too many breakpoint messages are waiting to be sent to the <see cref="Agent"/>.
+        /// </summary>
+        public bool DropLogPointsWhenQueueFull { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will compress large breakpoint messages, such as
+        /// snapshots with many variables, before sending them to the <see cref="Agent"/>.
+        /// </summary>
+        public bool CompressBreakpoints { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will send hits of log points as batches of <see cref="LogRecord"/>s
+        /// with their messages already formatted instead of as breakpoints. Requires
+        /// <see cref="MessageFraming.LengthPrefixed"/>.
+        /// </summary>
+        public bool LogRecords { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will send the names and types that a snapshot repeats once, in a
+        /// string table of the snapshot. See <see cref="SnapshotStringTable"/>.
+        /// </summary>
+        public bool StringTable { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will send the variables of a snapshot that did not change since
+        /// the previous snapshot of its breakpoint as references to it. See <see cref="SnapshotDelta"/>.
+        /// </summary>
+        public bool DeltaSnapshots { get; private set; }
+
+        /// <summary>
+        /// If true, the runtime will not notify the debugger of log messages, or of first-chance
+        /// exceptions while no exception point is set.
+        /// </summary>
+        public bool FilterCallbacks { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will let the application continue before it formats and
+        /// sends log points whose expressions need no evaluation in the application.
+        /// </summary>
+        public bool AsyncLogPoints { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will skip a hit of a log point while a hit of the same
+        /// log point on another thread is processed.
+        /// </summary>
+        public bool CoalesceLogPointHits { get; private set; }
+
+        /// <summary>
+        /// If true, the debugger will report in the status of breakpoint messages what
+        /// the hits of their breakpoint cost the application so far.
+        /// </summary>
+        public bool ReportBreakpointCosts { get; private set; }
+
+        /// <summary>
+        /// The maximum time in milliseconds a function evaluation can take before the
+        /// debugger aborts it, or null to use the debugger's default.
+        /// </summary>
+        public int? EvalTimeoutMs { get; private set; }
+
+        /// <summary>
+        /// The maximum total time in milliseconds of the function evaluations of a
+        /// breakpoint, or null for no limit.
+        /// </summary>
+        public int? EvalBudgetMs { get; private set; }
+
+        /// <summary>
+        /// The maximum number of function evaluations of a breakpoint, or null for no limit.
+        /// </summary>
+        public int? MaxFuncEvals { get; private set; }
+
+        /// <summary>
+        /// How often in milliseconds the debugger will send its metrics to the
+        /// <see cref="Agent"/>, or null to not send them.
+        /// </summary>
+        public int? MetricsIntervalMs { get; private set; }
+
         /// <summary>
         /// Create <see cref="DebuggerOptions"/> from <see cref="AgentOptions"/>.
         /// </summary>
@@ -74,13 +229,35 @@ namespace Google.Cloud.Diagnostics.Debug
                     "must be set but not both.");
             }
 
+            if (options.SharedMemoryPipe && !RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            {
+                throw new ArgumentException($"{nameof(SharedMemoryPipe)} is only supported on Linux.");
+            }
+
             return new DebuggerOptions
             {
                 PropertyEvaluation = options.PropertyEvaluation,
                 MethodEvaluation = options.MethodEvaluation,
                 ApplicationStartCommand = options.ApplicationStartCommand,
                 ApplicationId = options.ApplicationId,
-                PipeName = CreatePipeName()
+                PipeName = CreatePipeName(),
+                PdbIndexCacheDir = options.PdbIndexCacheDir,
+                MessageFraming = MessageFraming.LengthPrefixed,
+                DuplexPipe = true,
+                SharedMemoryPipe = options.SharedMemoryPipe,
+                DropLogPointsWhenQueueFull = options.DropLogPointsWhenQueueFull,
+                CompressBreakpoints = options.CompressBreakpoints,
+                LogRecords = true,
+                StringTable = true,
+                DeltaSnapshots = true,
+                FilterCallbacks = true,
+                AsyncLogPoints = options.AsyncLogPoints,
+                CoalesceLogPointHits = options.CoalesceLogPointHits,
+                ReportBreakpointCosts = options.ReportBreakpointCosts,
+                EvalTimeoutMs = options.EvalTimeoutMs,
+                EvalBudgetMs = options.EvalBudgetMs,
+                MaxFuncEvals = options.MaxFuncEvals,
+                MetricsIntervalMs = options.MetricsIntervalMs
             };
         }
 
@@ -119,6 +296,91 @@ namespace Google.Cloud.Diagnostics.Debug
             {
                 options += $"{MethodEvaluationOption} ";
             }
+
+            if (MessageFraming == MessageFraming.LengthPrefixed)
+            {
+                options += $"{LengthPrefixedFramingOption} ";
+            }
+
+            if (DuplexPipe)
+            {
+                options += $"{DuplexPipeOption} ";
+            }
+
+            if (SharedMemoryPipe)
+            {
+                options += $"{SharedMemoryPipeOption} ";
+            }
+
+            if (DropLogPointsWhenQueueFull)
+            {
+                options += $"{DropLogPointsWhenQueueFullOption} ";
+            }
+
+            if (CompressBreakpoints)
+            {
+                options += $"{CompressBreakpointsOption} ";
+            }
+
+            if (LogRecords)
+            {
+                options += $"{LogRecordsOption} ";
+            }
+
+            if (StringTable)
+            {
+                options += $"{StringTableOption} ";
+            }
+
+            if (DeltaSnapshots)
+            {
+                options += $"{DeltaSnapshotsOption} ";
+            }
+
+            if (FilterCallbacks)
+            {
+                options += $"{FilterCallbacksOption} ";
+            }
+
+            if (AsyncLogPoints)
+            {
+                options += $"{AsyncLogPointsOption} ";
+            }
+
+            if (CoalesceLogPointHits)
+            {
+                options += $"{CoalesceLogPointHitsOption} ";
+            }
+
+            if (ReportBreakpointCosts)
+            {
+                options += $"{ReportBreakpointCostsOption} ";
+            }
+
+            if (EvalTimeoutMs.HasValue)
+            {
+                options += $"{EvalTimeoutOption}={EvalTimeoutMs} ";
+            }
+
+            if (EvalBudgetMs.HasValue)
+            {
+                options += $"{EvalBudgetOption}={EvalBudgetMs} ";
+            }
+
+            if (MaxFuncEvals.HasValue)
+            {
+                options += $"{MaxFuncEvalsOption}={MaxFuncEvals} ";
+            }
+
+            if (MetricsIntervalMs.HasValue)
+            {
+                options += $"{MetricsIntervalOption}={MetricsIntervalMs} ";
+            }
+
+            if (!string.IsNullOrWhiteSpace(PdbIndexCacheDir))
+            {
+                options += $"{PdbIndexCacheDirOption}=\"{PdbIndexCacheDir}\" ";
+            }
             return options;
         }
 
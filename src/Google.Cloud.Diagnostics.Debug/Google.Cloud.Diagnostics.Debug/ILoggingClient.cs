@@ -14,6 +14,7 @@
 
 using StackdriverBreakpoint = Google.Cloud.Debugger.V2.Breakpoint;
 using Google.Cloud.Logging.V2;
+using System.Collections.Generic;
 
 namespace Google.Cloud.Diagnostics.Debug
 {
@@ -28,5 +29,18 @@ namespace Google.Cloud.Diagnostics.Debug
         /// </summary>
         /// <returns>WriteLogEntriesResponse from the API.</returns>
         WriteLogEntriesResponse WriteLogEntry(StackdriverBreakpoint breakpoint);
+
+        /// <summary>
+        /// Formats the log message in breakpoint into a log record, so that
+        /// it can be written with others by <see cref="WriteLogRecords"/>.
+        /// </summary>
+        LogRecord CreateLogRecord(StackdriverBreakpoint breakpoint);
+
+        /// <summary>
+        /// Writes the log records, whose messages the debugger already
+        /// formatted, to the Stackdriver Logging API in one request.
+        /// </summary>
+        /// <returns>WriteLogEntriesResponse from the API.</returns>
+        WriteLogEntriesResponse WriteLogRecords(IList<LogRecord> records);
     }
 }
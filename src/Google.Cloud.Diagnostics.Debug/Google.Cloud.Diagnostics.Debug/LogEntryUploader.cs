@@ -0,0 +1,132 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Google.Api.Gax;
+using Grpc.Core;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Threading;
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// Writes the hits of log points to the Stackdriver Logging API on a thread of its own.
+    /// The records added while a write is in flight are written together by the next one,
+    /// so the reader of the pipe never waits for the API and the number of writes does not
+    /// grow with the number of hits.
+    /// </summary>
+    public sealed class LogEntryUploader : IDisposable
+    {
+        /// <summary>The maximum number of log entries written in one request.</summary>
+        internal const int MaxBatchSize = 1000;
+
+        /// <summary>
+        /// The maximum number of records waiting to be written. Adding more blocks until
+        /// a write finishes, so that the debugger holds the hits instead of the agent.
+        /// </summary>
+        internal const int MaxPendingRecords = 10000;
+
+        /// <summary>The minimum amount of time to wait before retrying a failed write.</summary>
+        private static readonly TimeSpan _minBackOffWaitTime = TimeSpan.FromSeconds(1);
+
+        /// <summary>The maximum amount of time to wait before retrying a failed write.</summary>
+        private static readonly TimeSpan _maxBackOffWaitTime = TimeSpan.FromSeconds(10);
+
+        private readonly ILoggingClient _client;
+        private readonly BlockingCollection<LogRecord> _pending =
+            new BlockingCollection<LogRecord>(MaxPendingRecords);
+        private readonly Thread _thread;
+
+        /// <summary>
+        /// Create a <see cref="LogEntryUploader"/> and start its thread.
+        /// </summary>
+        /// <param name="client">The logging client to write the records with.</param>
+        public LogEntryUploader(ILoggingClient client)
+        {
+            _client = GaxPreconditions.CheckNotNull(client, nameof(client));
+            _thread = new Thread(WriteLoop) { IsBackground = true, Name = nameof(LogEntryUploader) };
+            _thread.Start();
+        }
+
+        /// <summary>
+        /// Queues records to be written. Blocks while <see cref="MaxPendingRecords"/> records
+        /// are waiting.
+        /// </summary>
+        public void Add(IEnumerable<LogRecord> records)
+        {
+            foreach (var record in records)
+            {
+                _pending.Add(record);
+            }
+        }
+
+        /// <summary>
+        /// Writes every record waiting, up to <see cref="MaxBatchSize"/> at a time, until
+        /// the uploader is disposed.
+        /// </summary>
+        private void WriteLoop()
+        {
+            var batch = new List<LogRecord>();
+            LogRecord record;
+            while (_pending.TryTake(out record, Timeout.Infinite))
+            {
+                batch.Add(record);
+                while (batch.Count < MaxBatchSize && _pending.TryTake(out record))
+                {
+                    batch.Add(record);
+                }
+                Write(batch);
+                batch.Clear();
+            }
+        }
+
+        /// <summary>
+        /// Writes batch, retrying with a doubling wait while the API fails. Once the
+        /// uploader is disposed, a failed batch is dropped instead.
+        /// </summary>
+        private void Write(List<LogRecord> batch)
+        {
+            TimeSpan waitTime = _minBackOffWaitTime;
+            while (true)
+            {
+                try
+                {
+                    _client.WriteLogRecords(batch);
+                    return;
+                }
+                catch (RpcException e)
+                {
+                    Console.WriteLine($"RpcException with status code '{e.Status.StatusCode}' writing {batch.Count} log entries \n {e}");
+                    if (_pending.IsAddingCompleted)
+                    {
+                        return;
+                    }
+                }
+                Thread.Sleep(waitTime);
+                waitTime = TimeSpan.FromTicks(Math.Min(waitTime.Ticks * 2, _maxBackOffWaitTime.Ticks));
+            }
+        }
+
+        /// <summary>
+        /// Writes the records still waiting and stops the thread.
+        /// </summary>
+        public void Dispose()
+        {
+            _pending.CompleteAdding();
+            _thread.Join();
+            _pending.Dispose();
+        }
+    }
+}
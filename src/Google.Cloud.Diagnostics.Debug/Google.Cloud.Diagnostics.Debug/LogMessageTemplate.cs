@@ -0,0 +1,167 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using System;
+using System.Collections.Generic;
+using System.Text;
+using StackdriverVariable = Google.Cloud.Debugger.V2.Variable;
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// A log message format parsed into literal segments and the indices
+    /// of the expressions substituted between them. "$0", "$1", etc. refer
+    /// to the evaluated expressions of the log point and "$$" is a '$'.
+    /// A format is parsed once and rendered for every hit of its log point.
+    /// </summary>
+    internal class LogMessageTemplate
+    {
+        /// <summary>
+        /// A literal or, if <see cref="ExpressionIndex"/> is not negative,
+        /// the expression with that index.
+        /// </summary>
+        private struct Segment
+        {
+            public string Literal;
+            public int ExpressionIndex;
+        }
+
+        private readonly List<Segment> _segments = new List<Segment>();
+
+        private LogMessageTemplate()
+        {
+        }
+
+        /// <summary>
+        /// Parses messageFormat into a template.
+        /// </summary>
+        public static LogMessageTemplate Parse(string messageFormat)
+        {
+            LogMessageTemplate template = new LogMessageTemplate();
+            StringBuilder literal = new StringBuilder();
+            int i = 0;
+            while (i < messageFormat.Length)
+            {
+                char currentChar = messageFormat[i];
+                char nextChar = i + 1 < messageFormat.Length ? messageFormat[i + 1] : '\0';
+                if (currentChar != '$' || (nextChar != '$' && !Char.IsDigit(nextChar)))
+                {
+                    literal.Append(currentChar);
+                    i += 1;
+                    continue;
+                }
+
+                if (nextChar == '$')
+                {
+                    // Escape the current $.
+                    literal.Append('$');
+                    i += 2;
+                    continue;
+                }
+
+                // We have a number followed by a $.
+                template.AddLiteral(literal);
+                i += 1;
+                int start = i;
+                while (i < messageFormat.Length && Char.IsDigit(messageFormat[i]))
+                {
+                    i += 1;
+                }
+
+                int expressionIndex;
+                if (!Int32.TryParse(messageFormat.Substring(start, i - start), out expressionIndex))
+                {
+                    expressionIndex = Int32.MaxValue;
+                }
+                template._segments.Add(new Segment { ExpressionIndex = expressionIndex });
+            }
+
+            template.AddLiteral(literal);
+            return template;
+        }
+
+        /// <summary>
+        /// Appends the message with the expressions substituted by
+        /// evaluatedExpressions to builder.
+        /// </summary>
+        public void Render(StringBuilder builder, IList<StackdriverVariable> evaluatedExpressions)
+        {
+            foreach (Segment segment in _segments)
+            {
+                if (segment.ExpressionIndex < 0)
+                {
+                    builder.Append(segment.Literal);
+                }
+                else if (segment.ExpressionIndex < evaluatedExpressions.Count)
+                {
+                    AppendVariable(builder, evaluatedExpressions[segment.ExpressionIndex]);
+                }
+                else
+                {
+                    builder.Append($"{{{segment.ExpressionIndex} cannot be evaluated}}");
+                }
+            }
+        }
+
+        /// <summary>
+        /// Appends the variable to builder in a more readable form,
+        /// especially if the variable only has members and no value.
+        /// </summary>
+        private static void AppendVariable(StringBuilder builder, StackdriverVariable variable)
+        {
+            if (variable.Status?.IsError ?? false)
+            {
+                builder.Append($"\"Error evaluating {variable.Name}: {variable.Status?.Description?.Format}\"");
+                return;
+            }
+
+            if (!string.IsNullOrWhiteSpace(variable.Value))
+            {
+                builder.Append(variable.Value);
+                return;
+            }
+
+            int start = builder.Length;
+            builder.Append("[ ");
+            foreach (StackdriverVariable member in variable.Members)
+            {
+                builder.Append($"{member.Name} ({member.Type}): ");
+                AppendVariable(builder, member);
+                builder.Append(", ");
+            }
+
+            // Trims the separator after the last member.
+            while (builder.Length > start + 1 &&
+                (builder[builder.Length - 1] == ',' || builder[builder.Length - 1] == ' '))
+            {
+                builder.Length -= 1;
+            }
+            builder.Append(']');
+        }
+
+        /// <summary>
+        /// Adds the characters in literal as a segment and clears it.
+        /// </summary>
+        private void AddLiteral(StringBuilder literal)
+        {
+            if (literal.Length == 0)
+            {
+                return;
+            }
+
+            _segments.Add(new Segment { Literal = literal.ToString(), ExpressionIndex = -1 });
+            literal.Clear();
+        }
+    }
+}
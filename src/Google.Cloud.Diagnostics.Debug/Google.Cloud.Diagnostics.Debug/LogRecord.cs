@@ -0,0 +1,78 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Google.Protobuf;
+using System;
+using System.Collections.Generic;
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// A hit of a log point that the debugger sends with its message already formatted,
+    /// instead of as a <see cref="Breakpoint"/> with the evaluated expressions.
+    /// </summary>
+    public sealed class LogRecord
+    {
+        private static readonly DateTime UnixEpoch = new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+
+        internal LogRecord(string breakpointId, DateTime timestamp, Breakpoint.Types.LogLevel level, string message)
+        {
+            BreakpointId = breakpointId;
+            Timestamp = timestamp;
+            Level = level;
+            Message = message;
+        }
+
+        /// <summary>The ID of the log point.</summary>
+        public string BreakpointId { get; }
+
+        /// <summary>When the log point was hit, in UTC.</summary>
+        public DateTime Timestamp { get; }
+
+        /// <summary>The log level of the log point.</summary>
+        public Breakpoint.Types.LogLevel Level { get; }
+
+        /// <summary>The formatted message, without the prefix of log point messages.</summary>
+        public string Message { get; }
+
+        /// <summary>
+        /// Parses the records in the message of a frame with <see cref="Constants.FrameLogRecordsFlag"/>.
+        /// Every record is the breakpoint ID as a length-prefixed UTF-8 string, the time of the hit in
+        /// microseconds since the epoch as a little-endian uint64, the log level as a varint and the
+        /// message as a length-prefixed UTF-8 string.
+        /// </summary>
+        internal static IList<LogRecord> ParseBatch(byte[] message)
+        {
+            var records = new List<LogRecord>();
+            try
+            {
+                var input = new CodedInputStream(message);
+                while (!input.IsAtEnd)
+                {
+                    string breakpointId = input.ReadString();
+                    long timestampUs = (long)input.ReadFixed64();
+                    var level = (Breakpoint.Types.LogLevel)input.ReadUInt32();
+                    string text = input.ReadString();
+                    records.Add(new LogRecord(breakpointId,
+                        UnixEpoch.AddTicks(timestampUs * (TimeSpan.TicksPerMillisecond / 1000)), level, text));
+                }
+            }
+            catch (InvalidProtocolBufferException e)
+            {
+                throw new InvalidOperationException("Invalid log records frame.", e);
+            }
+            return records;
+        }
+    }
+}
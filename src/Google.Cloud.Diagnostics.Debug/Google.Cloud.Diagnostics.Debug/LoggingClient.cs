@@ -13,7 +13,9 @@
 // limitations under the License.
 
 using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
+using System.Text;
 using Google.Cloud.Logging.V2;
 using StackdriverBreakpoint = Google.Cloud.Debugger.V2.Breakpoint;
 using Google.Cloud.Logging.Type;
@@ -39,6 +41,18 @@ namespace Google.Cloud.Diagnostics.Debug
         // "View Logs" on the Stackdriver Debug client, this will show up.
         private static readonly string LogpointMessageStart = "LOGPOINT: ";
 
+        // Maximum number of parsed log message formats kept in _templates.
+        private const int MaxCachedTemplates = 1000;
+
+        // Parsed log message formats, so that a format is not scanned again
+        // every time its log point is hit.
+        private readonly ConcurrentDictionary<string, LogMessageTemplate> _templates =
+            new ConcurrentDictionary<string, LogMessageTemplate>();
+
+        // Buffer the log messages are rendered in, reused across hits.
+        [ThreadStatic]
+        private static StringBuilder _messageBuilder;
+
         internal LoggingClient(AgentOptions options, LoggingServiceV2Client loggingClient = null)
         {
             _logClient = loggingClient ?? LoggingServiceV2Client.Create();
@@ -60,17 +74,7 @@ namespace Google.Cloud.Diagnostics.Debug
                 Severity = _logSeverityConversion[breakpoint.LogLevel],
             };
 
-            if (breakpoint.Status?.IsError ?? false)
-            {
-                // The .NET Debugger does not use parameters field so we can just use format directly.
-                logEntry.TextPayload = $"{LogpointMessageStart}Error evaluating logpoint \"{breakpoint.LogMessageFormat}\": {breakpoint.Status?.Description?.Format}.";
-            }
-            else
-            {
-                logEntry.TextPayload = SubstituteLogMessageFormat(
-                    breakpoint.LogMessageFormat,
-                    breakpoint.EvaluatedExpressions.ToList());
-            }
+            logEntry.TextPayload = FormatLogMessage(breakpoint, LogpointMessageStart);
 
             // TODO(quoct): Detect whether we are on gke and use gke_container.
             MonitoredResource resource = new MonitoredResource { Type = "global" };
@@ -78,98 +82,70 @@ namespace Google.Cloud.Diagnostics.Debug
         }
 
         /// <summary>
-        /// Substitutes the $0, $1, etc. in messageFormat with expressions
-        /// from evaluatedExpressions.
+        /// Substitutes the log message format in breakpoint into a record
+        /// hit now, which <see cref="WriteLogRecords"/> can write with others.
         /// </summary>
-        /// <returns>Formatted log message with expressions substituted.</returns>
-        private string SubstituteLogMessageFormat(string messageFormat, List<Debugger.V2.Variable> evaluatedExpressions)
-        {
-            string result = LogpointMessageStart;
-            int offset = 0;
-            int i = 0;
-            while (i < messageFormat.Length)
-            {
-                if (messageFormat[i] != '$')
-                {
-                    i += 1;
-                    continue;
-                }
+        public LogRecord CreateLogRecord(StackdriverBreakpoint breakpoint) =>
+            new LogRecord(breakpoint.Id, DateTime.UtcNow, (Breakpoint.Types.LogLevel)breakpoint.LogLevel,
+                FormatLogMessage(breakpoint, ""));
 
-                // We encounter a $.
-                result += messageFormat.Substring(offset, i - offset);
-
-                char nextChar = messageFormat[i + 1];
-                if (nextChar == '$')
-                {
-                    // Escape the current $.
-                    result += '$';
-                    i += 2;
-                    offset = i;
-                    continue;
-                }
-
-                if (!Char.IsDigit(nextChar))
-                {
-                    offset = i;
-                    i += 1;
-                    continue;
-                }
-
-                // We have a number followed by a $. Time to substitute!
-                string currentNumberString = "";
-                i += 1;
-                while (i < messageFormat.Length && Char.IsDigit(messageFormat[i]))
-                {
-                    currentNumberString += messageFormat[i];
-                    i += 1;
-                }
-                offset = i;
-
-                int currentNumber = Int32.Parse(currentNumberString);
-                if (currentNumber < evaluatedExpressions.Count)
-                {
-                    result += FormatVariable(evaluatedExpressions[currentNumber]);
-                }
-                else
-                {
-                    result += $"{{{currentNumber} cannot be evaluated}}";
-                }
-            }
-
-            if (offset < messageFormat.Length)
+        /// <summary>
+        /// Writes the log records as log entries to the log _logName.
+        /// </summary>
+        /// <returns>WriteLogEntriesResponse from the API.</returns>
+        public WriteLogEntriesResponse WriteLogRecords(IList<LogRecord> records)
+        {
+            var logEntries = records.Select(record => new LogEntry
             {
-                result += messageFormat.Substring(offset);
-            }
+                LogName = _logName.ToString(),
+                Severity = _logSeverityConversion[(StackdriverBreakpoint.Types.LogLevel)record.Level],
+                Timestamp = Protobuf.WellKnownTypes.Timestamp.FromDateTime(record.Timestamp),
+                TextPayload = LogpointMessageStart + record.Message,
+            }).ToList();
 
-            return result;
+            MonitoredResource resource = new MonitoredResource { Type = "global" };
+            return _logClient.WriteLogEntries(LogNameOneof.From(_logName), resource, null, logEntries);
         }
 
         /// <summary>
-        /// Formats the variable into a more readable string,
-        /// especially if the variable only has members and no value.
+        /// Formats the log message of breakpoint, or the error evaluating it, after prefix.
         /// </summary>
-        /// <returns>Formatted string representing the variable.</returns>
-        private string FormatVariable(Debugger.V2.Variable variable)
+        private string FormatLogMessage(StackdriverBreakpoint breakpoint, string prefix)
         {
-            if (variable.Status?.IsError ?? false)
-            {
-                return $"\"Error evaluating {variable.Name}: {variable.Status?.Description?.Format}\"";
-            }
-
-            if (!string.IsNullOrWhiteSpace(variable.Value))
+            if (breakpoint.Status?.IsError ?? false)
             {
-                return variable.Value;
+                // The .NET Debugger does not use parameters field so we can just use format directly.
+                return $"{prefix}Error evaluating logpoint \"{breakpoint.LogMessageFormat}\": {breakpoint.Status?.Description?.Format}.";
             }
+            return SubstituteLogMessageFormat(prefix, breakpoint.LogMessageFormat,
+                breakpoint.EvaluatedExpressions.ToList());
+        }
 
-            string result = "[ ";
-            foreach (Debugger.V2.Variable member in variable.Members)
+        /// <summary>
+        /// Substitutes the $0, $1, etc. in messageFormat with expressions
+        /// from evaluatedExpressions.
+        /// </summary>
+        /// <returns>Formatted log message with expressions substituted, after prefix.</returns>
+        private string SubstituteLogMessageFormat(string prefix, string messageFormat,
+            List<Debugger.V2.Variable> evaluatedExpressions)
+        {
+            LogMessageTemplate template;
+            if (!_templates.TryGetValue(messageFormat, out template))
             {
-                result += $"{member.Name} ({member.Type}): {FormatVariable(member)}, ";
+                // Log points are few, so this only happens if formats keep changing.
+                if (_templates.Count >= MaxCachedTemplates)
+                {
+                    _templates.Clear();
+                }
+                template = LogMessageTemplate.Parse(messageFormat);
+                _templates[messageFormat] = template;
             }
-            result = result.TrimEnd(new char[] { ',', ' ' });
-            result += "]";
 
-            return result;
+            StringBuilder builder = _messageBuilder ?? (_messageBuilder = new StringBuilder());
+            builder.Clear();
+            builder.Append(prefix);
+            template.Render(builder, evaluatedExpressions);
+            return builder.ToString();
         }
     }
 }
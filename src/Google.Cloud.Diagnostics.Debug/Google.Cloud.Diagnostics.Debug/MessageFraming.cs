@@ -0,0 +1,35 @@
+﻿// Copyright 2017 Google Inc. All Rights Reserved.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//     http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// How breakpoint messages are delimited on a pipe.
+    /// </summary>
+    public enum MessageFraming
+    {
+        /// <summary>
+        /// Every message is surrounded by <see cref="Constants.StartBreakpointMessage"/>
+        /// and <see cref="Constants.EndBreakpointMessage"/>.
+        /// </summary>
+        Markers,
+
+        /// <summary>
+        /// Every message is preceded by a frame header of <see cref="Constants.FrameHeaderSize"/>
+        /// bytes: the byte <see cref="Constants.FrameVersion"/>, then the size of the message
+        /// as a little-endian 32-bit integer.
+        /// </summary>
+        LengthPrefixed
+    }
+}
@@ -26,6 +26,7 @@ namespace Google.Cloud.Diagnostics.Debug
     {
         private readonly INamedPipe _pipe;
         private readonly NamedPipeServerStream _server;
+        private bool _disposed;
 
         /// <summary>
         /// Create a new <see cref="NamedPipeServer"/>.
@@ -56,7 +57,15 @@ namespace Google.Cloud.Diagnostics.Debug
 
         /// <inheritdoc />
         public void Dispose()
-        {            
+        {
+            // A duplex server is shared by the read and the write loops,
+            // which both dispose it.
+            if (_disposed)
+            {
+                return;
+            }
+            _disposed = true;
+
             if (_server.IsConnected)
             {
                 _server.Disconnect();
@@ -0,0 +1,244 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Google.Api.Gax;
+using System;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.IO.Pipes;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// A named pipe server whose bytes go through two rings in memory shared with the
+    /// debugger, one for each direction, instead of through the kernel. The named pipe
+    /// connects the debugger and then only carries the bytes that wake up a side that
+    /// waits for its ring to be written to. See <see cref="Constants.SharedMemoryMagic"/>
+    /// for the layout of the shared memory, which this server creates.
+    /// </summary>
+    public class SharedMemoryPipeServer : INamedPipeServer
+    {
+        // Offsets in the control block of a ring.
+        private const int WritePositionOffset = 0;
+        private const int ReadPositionOffset = 64;
+        private const int ReaderWaitingOffset = 128;
+
+        private static readonly byte[] Doorbell = new byte[1];
+
+        private readonly PipeStream _doorbell;
+        private readonly string _path;
+        private readonly MemoryMappedFile _file;
+        private readonly MemoryMappedViewAccessor _memory;
+        private readonly long _capacity;
+        private readonly byte[] _doorbellBuffer = new byte[Constants.BufferSize];
+        private readonly SemaphoreSlim _writeSemaphore = new SemaphoreSlim(1);
+
+        // The offsets of the ring the debugger writes to and of the one this writes to.
+        private readonly long _incoming;
+        private readonly long _outgoing;
+
+        private bool _disposed;
+
+        /// <summary>
+        /// Create a new <see cref="SharedMemoryPipeServer"/> and its shared memory.
+        /// </summary>
+        /// <param name="pipeName">The name of the pipe.</param>
+        public SharedMemoryPipeServer(string pipeName)
+            : this(() => new NamedPipeServerStream(
+                pipeName: pipeName,
+                direction: PipeDirection.InOut,
+                maxNumberOfServerInstances: NamedPipeServerStream.MaxAllowedServerInstances,
+                transmissionMode: PipeTransmissionMode.Byte,
+                options: PipeOptions.Asynchronous),
+                Constants.SharedMemoryPathPrefix + GaxPreconditions.CheckNotNullOrEmpty(pipeName, nameof(pipeName)),
+                Constants.SharedMemoryRingCapacity)
+        {
+        }
+
+        /// <summary>
+        /// Create a new <see cref="SharedMemoryPipeServer"/> that creates its shared memory at
+        /// path with rings of capacity bytes and then the named pipe that wakes up the debugger.
+        /// The shared memory exists before the debugger can connect to the named pipe.
+        /// </summary>
+        internal SharedMemoryPipeServer(Func<PipeStream> createDoorbell, string path, int capacity)
+        {
+            GaxPreconditions.CheckNotNull(createDoorbell, nameof(createDoorbell));
+            GaxPreconditions.CheckArgument(capacity > 0 && (capacity & (capacity - 1)) == 0,
+                nameof(capacity), "The capacity has to be a power of two.");
+            _path = GaxPreconditions.CheckNotNullOrEmpty(path, nameof(path));
+            _capacity = capacity;
+            _incoming = Constants.SharedMemoryHeaderSize + Constants.SharedMemoryRingControlSize + capacity;
+            _outgoing = Constants.SharedMemoryHeaderSize;
+
+            long size = Constants.SharedMemoryHeaderSize + 2 * (Constants.SharedMemoryRingControlSize + capacity);
+            _file = MemoryMappedFile.CreateFromFile(_path, FileMode.Create, null, size, MemoryMappedFileAccess.ReadWrite);
+            _memory = _file.CreateViewAccessor(0, size);
+            _memory.Write(0, Constants.SharedMemoryMagic);
+            _memory.Write(sizeof(uint), (uint)capacity);
+            _memory.Flush();
+            _doorbell = createDoorbell();
+        }
+
+        /// <summary>The shared memory, for tests that act as the debugger.</summary>
+        internal MemoryMappedViewAccessor Memory => _memory;
+
+        /// <inheritdoc />
+        public Task WaitForConnectionAsync(CancellationToken cancellationToken = default(CancellationToken))
+            => ((NamedPipeServerStream)_doorbell).WaitForConnectionAsync(cancellationToken);
+
+        /// <inheritdoc />
+        public async Task<byte[]> ReadAsync(CancellationToken cancellationToken = default(CancellationToken))
+        {
+            while (true)
+            {
+                byte[] bytes = ReadAvailable();
+                if (bytes.Length > 0)
+                {
+                    return bytes;
+                }
+
+                // The flag is set before the ring is checked again and the debugger checks the
+                // flag after it moves its write position, so either this sees the new bytes or
+                // the debugger rings the doorbell.
+                _memory.Write(_incoming + ReaderWaitingOffset, 1);
+                Interlocked.MemoryBarrier();
+                if (GetReadableCount() == 0)
+                {
+                    int read = await _doorbell.ReadAsync(
+                        _doorbellBuffer, 0, _doorbellBuffer.Length, cancellationToken).ConfigureAwait(false);
+                    if (read == 0 && GetReadableCount() == 0)
+                    {
+                        _memory.Write(_incoming + ReaderWaitingOffset, 0);
+                        throw new IOException("The debugger closed the pipe.");
+                    }
+                }
+                _memory.Write(_incoming + ReaderWaitingOffset, 0);
+            }
+        }
+
+        /// <inheritdoc />
+        public async Task WriteAsync(byte[] bytes, CancellationToken cancellationToken = default(CancellationToken))
+        {
+            await _writeSemaphore.WaitAsync(cancellationToken).ConfigureAwait(false);
+            try
+            {
+                int offset = 0;
+                while (offset < bytes.Length)
+                {
+                    long write = _memory.ReadInt64(_outgoing + WritePositionOffset);
+                    long read = _memory.ReadInt64(_outgoing + ReadPositionOffset);
+                    Interlocked.MemoryBarrier();
+                    long space = _capacity - (write - read);
+                    if (space == 0)
+                    {
+                        // The debugger may be waiting with the part that was already written.
+                        await RingDoorbellAsync(cancellationToken).ConfigureAwait(false);
+                        await Task.Delay(Constants.SharedMemoryFullRetryIntervalMs, cancellationToken).ConfigureAwait(false);
+                        continue;
+                    }
+
+                    int count = (int)Math.Min(space, bytes.Length - offset);
+                    int index = (int)(write & (_capacity - 1));
+                    int first = (int)Math.Min(count, _capacity - index);
+                    long data = _outgoing + Constants.SharedMemoryRingControlSize;
+                    _memory.WriteArray(data + index, bytes, offset, first);
+                    _memory.WriteArray(data, bytes, offset + first, count - first);
+
+                    // The bytes have to be visible before the position that publishes them.
+                    Interlocked.MemoryBarrier();
+                    _memory.Write(_outgoing + WritePositionOffset, write + count);
+                    offset += count;
+                }
+                await RingDoorbellAsync(cancellationToken).ConfigureAwait(false);
+            }
+            finally
+            {
+                _writeSemaphore.Release();
+            }
+        }
+
+        /// <summary>
+        /// Returns the bytes the debugger wrote and frees their space, without waiting.
+        /// </summary>
+        private byte[] ReadAvailable()
+        {
+            long read = _memory.ReadInt64(_incoming + ReadPositionOffset);
+            int count = GetReadableCount();
+            byte[] bytes = new byte[count];
+            if (count == 0)
+            {
+                return bytes;
+            }
+
+            int index = (int)(read & (_capacity - 1));
+            int first = (int)Math.Min(count, _capacity - index);
+            long data = _incoming + Constants.SharedMemoryRingControlSize;
+            _memory.ReadArray(data + index, bytes, 0, first);
+            _memory.ReadArray(data, bytes, first, count - first);
+
+            // The bytes have to be read before their space is given back to the debugger.
+            Interlocked.MemoryBarrier();
+            _memory.Write(_incoming + ReadPositionOffset, read + count);
+            return bytes;
+        }
+
+        /// <summary>
+        /// Returns how many bytes the debugger wrote that were not read yet.
+        /// </summary>
+        private int GetReadableCount()
+        {
+            long write = _memory.ReadInt64(_incoming + WritePositionOffset);
+            long read = _memory.ReadInt64(_incoming + ReadPositionOffset);
+            Interlocked.MemoryBarrier();
+            return (int)(write - read);
+        }
+
+        /// <summary>
+        /// Writes to the named pipe if the debugger waits for the ring this writes to.
+        /// </summary>
+        private async Task RingDoorbellAsync(CancellationToken cancellationToken)
+        {
+            Interlocked.MemoryBarrier();
+            if (_memory.ReadInt32(_outgoing + ReaderWaitingOffset) == 0)
+            {
+                return;
+            }
+            await _doorbell.WriteAsync(Doorbell, 0, Doorbell.Length, cancellationToken).ConfigureAwait(false);
+            await _doorbell.FlushAsync(cancellationToken).ConfigureAwait(false);
+        }
+
+        /// <inheritdoc />
+        public void Dispose()
+        {
+            // A duplex server is shared by the read and the write loops,
+            // which both dispose it.
+            if (_disposed)
+            {
+                return;
+            }
+            _disposed = true;
+
+            if (_doorbell is NamedPipeServerStream server && server.IsConnected)
+            {
+                server.Disconnect();
+            }
+            _doorbell.Dispose();
+            _memory.Dispose();
+            _file.Dispose();
+            File.Delete(_path);
+        }
+    }
+}
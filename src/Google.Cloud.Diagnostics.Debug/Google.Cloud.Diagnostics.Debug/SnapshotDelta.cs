@@ -0,0 +1,94 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using Google.Protobuf.Collections;
+using System;
+using System.Collections.Generic;
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// Reads back the variables of snapshots that the debugger replaced because they did not
+    /// change since the previous snapshot of their breakpoint. A variable named
+    /// <see cref="Constants.UnchangedVariableName"/> is the variable at the same position of the
+    /// previous snapshot: at the same index of the arguments or locals of the frame at the same
+    /// index, of the evaluated expressions, or of the members of the variable at the same
+    /// position. The previous snapshots of at most
+    /// <see cref="Constants.MaximumDeltaSnapshotBreakpoints"/> breakpoints are kept, and all of
+    /// them are forgotten when a snapshot of another breakpoint comes, like the debugger does.
+    /// </summary>
+    internal sealed class SnapshotDelta
+    {
+        /// <summary>The previous snapshot of each breakpoint, by ID.</summary>
+        private readonly Dictionary<string, Breakpoint> _snapshots = new Dictionary<string, Breakpoint>();
+
+        /// <summary>
+        /// Replaces the unchanged variables of the breakpoint with the variables of the previous
+        /// snapshot, and keeps the breakpoint as the previous snapshot. Breakpoints without
+        /// stack frames are returned as they are.
+        /// </summary>
+        public Breakpoint Decode(Breakpoint breakpoint)
+        {
+            if (breakpoint.StackFrames.Count == 0)
+            {
+                return breakpoint;
+            }
+
+            Breakpoint previous;
+            if (!_snapshots.TryGetValue(breakpoint.Id, out previous) &&
+                _snapshots.Count >= Constants.MaximumDeltaSnapshotBreakpoints)
+            {
+                _snapshots.Clear();
+            }
+
+            for (int i = 0; i < breakpoint.StackFrames.Count; i++)
+            {
+                StackFrame frame = breakpoint.StackFrames[i];
+                StackFrame previousFrame = previous != null && i < previous.StackFrames.Count
+                    ? previous.StackFrames[i] : null;
+                Decode(frame.Arguments, previousFrame?.Arguments);
+                Decode(frame.Locals, previousFrame?.Locals);
+            }
+            Decode(breakpoint.EvaluatedExpressions, previous?.EvaluatedExpressions);
+
+            _snapshots[breakpoint.Id] = breakpoint.Clone();
+            return breakpoint;
+        }
+
+        /// <summary>
+        /// Replaces the unchanged variables among the variables and their members with the
+        /// variables at the same position of the previous variables, which may be null.
+        /// </summary>
+        private static void Decode(RepeatedField<Variable> variables, IList<Variable> previous)
+        {
+            for (int i = 0; i < variables.Count; i++)
+            {
+                Variable previousVariable = previous != null && i < previous.Count ? previous[i] : null;
+                if (variables[i].Name == Constants.UnchangedVariableName)
+                {
+                    if (previousVariable == null)
+                    {
+                        throw new InvalidOperationException(
+                            "Unchanged variable without a variable in the previous snapshot.");
+                    }
+                    variables[i] = previousVariable.Clone();
+                }
+                else
+                {
+                    Decode(variables[i].Members, previousVariable?.Members);
+                }
+            }
+        }
+    }
+}
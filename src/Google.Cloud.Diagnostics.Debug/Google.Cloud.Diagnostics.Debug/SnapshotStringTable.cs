@@ -0,0 +1,90 @@
+﻿// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+using System;
+using System.Collections.Generic;
+
+namespace Google.Cloud.Diagnostics.Debug
+{
+    /// <summary>
+    /// Reads back the strings of a snapshot that the debugger replaced with references into
+    /// its string table. The table is the last evaluated expression, named
+    /// <see cref="Constants.StringTableExpressionName"/>, and its members hold the strings as
+    /// their values. A name or type of a variable, or a method name or path of a stack frame,
+    /// that starts with <see cref="Constants.StringTableReferencePrefix"/> is the string of the
+    /// table at the decimal index that follows the prefix.
+    /// </summary>
+    internal static class SnapshotStringTable
+    {
+        /// <summary>
+        /// Replaces the references of the breakpoint with their strings and removes the table.
+        /// Breakpoints without a table are returned as they are.
+        /// </summary>
+        public static Breakpoint Decode(Breakpoint breakpoint)
+        {
+            int count = breakpoint.EvaluatedExpressions.Count;
+            if (count == 0 || breakpoint.EvaluatedExpressions[count - 1].Name != Constants.StringTableExpressionName)
+            {
+                return breakpoint;
+            }
+
+            var table = new List<string>();
+            foreach (Variable member in breakpoint.EvaluatedExpressions[count - 1].Members)
+            {
+                table.Add(member.Value);
+            }
+            breakpoint.EvaluatedExpressions.RemoveAt(count - 1);
+
+            foreach (StackFrame frame in breakpoint.StackFrames)
+            {
+                frame.MethodName = Resolve(frame.MethodName, table);
+                if (frame.Location != null)
+                {
+                    frame.Location.Path = Resolve(frame.Location.Path, table);
+                }
+                Decode(frame.Arguments, table);
+                Decode(frame.Locals, table);
+            }
+            Decode(breakpoint.EvaluatedExpressions, table);
+            return breakpoint;
+        }
+
+        private static void Decode(IEnumerable<Variable> variables, IList<string> table)
+        {
+            foreach (Variable variable in variables)
+            {
+                variable.Name = Resolve(variable.Name, table);
+                variable.Type = Resolve(variable.Type, table);
+                Decode(variable.Members, table);
+            }
+        }
+
+        /// <summary>
+        /// Returns the string of the table that value references, or value if it is not a reference.
+        /// </summary>
+        private static string Resolve(string value, IList<string> table)
+        {
+            if (value.Length < 2 || value[0] != Constants.StringTableReferencePrefix)
+            {
+                return value;
+            }
+
+            if (!int.TryParse(value.Substring(1), out int index) || index < 0 || index >= table.Count)
+            {
+                throw new InvalidOperationException($"Invalid string table reference {value.Substring(1)}.");
+            }
+            return table[index];
+        }
+    }
+}
@@ -3,18 +3,43 @@
 
 // TODO: Add cleanup to release pointer.
 
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "breakpoint_collection.h"
+#include "cpu_sampler.h"
 #include "debugger.h"
+#include "metadata_cache.h"
+#include "metrics.h"
 #include "optionparser.h"
+#include "overhead_governor.h"
 #include "string_stream_wrapper.h"
+#include "trace.h"
 #include "winerror.h"
 
+using google::cloud::diagnostics::debug::Breakpoint;
+using google_cloud_debugger::ArrayCaptureMode;
+using google_cloud_debugger::BreakpointCollection;
+using google_cloud_debugger::CaptureLimits;
+using google_cloud_debugger::CaptureMask;
 using google_cloud_debugger::ConvertStringToWCharPtr;
+using google_cloud_debugger::CpuSampler;
 using google_cloud_debugger::Debugger;
+using google_cloud_debugger::DebuggerMetrics;
+using google_cloud_debugger::LatencyHistogram;
+using google_cloud_debugger::BreakpointWriteOverflow;
+using google_cloud_debugger::MessageFraming;
+using google_cloud_debugger::MetadataCache;
+using google_cloud_debugger::ModuleFilter;
+using google_cloud_debugger::OverheadGovernor;
+using google_cloud_debugger::TraceLog;
 using std::cerr;
 using std::cin;
 using std::endl;
@@ -33,19 +58,407 @@ const string kMethodEvaluation = "method-evaluation";
 const string kApplicationStartCommandOption = "application-start-command";
 
 // If given this option, the debugger will attach to the running application
-// with this process ID.
+// with this process ID, or to every application of a comma-separated list
+// of process IDs.
 const string kApplicationIDOption = "application-id";
 
-// The name of the pipe the debugger will use to communicate with the agent.
+// The name of the pipe the debugger will use to communicate with the agent,
+// or a comma-separated list of one pipe name per application ID.
 const string kPipeNameOption = "pipe-name";
 
+// If given this option, the debugger will cache the parsed PDB files in
+// this directory so they do not have to be parsed again after a restart.
+const string kPdbIndexCacheDirOption = "pdb-index-cache-dir";
+
+// If given this option, the debugger evicts the parsed methods of the
+// least recently used PDB files once they take more memory than this.
+const string kPdbMemoryLimitOption = "pdb-memory-limit-mb";
+
+// If given this option, the debugger looks up the PDB files that are not
+// next to their modules in this symbol store directory.
+const string kSymbolStoreDirOption = "symbol-store-dir";
+
+// If given this option, the debugger downloads the PDB files that are not
+// in the symbol store directory from this symbol server.
+const string kSymbolServerUrlOption = "symbol-server-url";
+
+// If given this option, the debugger parses the PDB files of the modules
+// the application has already loaded in parallel when it attaches.
+const string kPreloadModulesOption = "preload-modules";
+
+// The patterns of the file names of the modules whose PDB files are parsed
+// as soon as they are loaded.
+const string kIncludeModulesOption = "include-modules";
+
+// The patterns of the file names of the modules whose PDB files are only
+// parsed when they are needed.
+const string kExcludeModulesOption = "exclude-modules";
+
+// If given this option, only the modules with a PDB file next to them have
+// it parsed as soon as they are loaded.
+const string kOnlyModulesWithPdbOption = "only-modules-with-pdb";
+
+// If given this option, breakpoint messages on the pipe are length-prefixed
+// frames instead of being surrounded by start and end markers.
+const string kLengthPrefixedFramingOption = "length-prefixed-framing";
+
+// If given this option, breakpoints are read from and written to the agent
+// through a single connection instead of one connection for each.
+const string kDuplexPipeOption = "duplex-pipe";
+
+// If given this option, the bytes of the duplex pipe go through memory
+// shared with the agent instead of through the connection.
+const string kSharedMemoryPipeOption = "shared-memory-pipe";
+
+// If given this option, log point messages are dropped instead of waiting
+// when too many breakpoint messages are waiting to be written to the agent.
+const string kDropLogPointsWhenQueueFullOption =
+    "drop-log-points-when-queue-full";
+
+// If given this option, breakpoint messages that do not fit in the write
+// queue are appended to this file until the agent catches up.
+const string kSpillFileOption = "spill-file";
+
+// If given this option, large breakpoint messages are compressed before
+// they are written to the agent.
+const string kCompressBreakpointsOption = "compress-breakpoints";
+
+// If given this option, hits of log points are written to the agent as
+// log records with their formatted messages instead of as breakpoints.
+const string kLogRecordsOption = "log-records";
+
+// If given this option, the strings that snapshots repeat are written
+// once in a string table.
+const string kStringTableOption = "string-table";
+
+// If given this option, the variables of a snapshot that did not change
+// since the previous snapshot of its breakpoint are written as
+// references to it.
+const string kDeltaSnapshotsOption = "delta-snapshots";
+
+// If given this option, the runtime does not deliver the notifications
+// the debugger does not use, such as log messages and first-chance
+// exceptions while no exception point is set.
+const string kFilterCallbacksOption = "filter-callbacks";
+
+// If given this option, log points are written after the application
+// continues when their expressions need no evaluation in it.
+const string kAsyncLogPointsOption = "async-log-points";
+
+// If given this option, a hit of a log point is skipped while another
+// hit of it is processed.
+const string kCoalesceLogPointHitsOption = "coalesce-log-point-hits";
+
+// If given this option, the names of stack frames without variables are
+// resolved in parallel.
+const string kParallelStackFramesOption = "parallel-stack-frames";
+
+// If given this option, the callers of async methods resumed after an
+// await are the async methods awaiting them.
+const string kLogicalAsyncStacksOption = "logical-async-stacks";
+
+// If given this option, the status of breakpoint messages reports the
+// cost of their breakpoint.
+const string kReportBreakpointCostsOption = "report-breakpoint-costs";
+
+// The maximum amount of time a function evaluation can take.
+const string kEvalTimeoutOption = "eval-timeout-ms";
+
+// The maximum total time of the function evaluations of a breakpoint.
+const string kEvalBudgetOption = "eval-budget-ms";
+
+// The maximum number of function evaluations of a breakpoint.
+const string kMaxFuncEvalsOption = "max-func-evals";
+
+// The maximum number of items of a collection captured in a snapshot.
+const string kMaxCollectionItemsOption = "max-collection-items";
+
+// The maximum number of levels of members captured below a variable.
+const string kMaxObjectDepthOption = "max-object-depth";
+
+// The maximum length of a value captured in a snapshot.
+const string kMaxStringLengthOption = "max-string-length";
+
+// The maximum size of an object whose members are captured in a snapshot.
+const string kMaxObjectBytesOption = "max-object-bytes";
+
+// Which items of a long array are captured in a snapshot.
+const string kArrayCaptureOption = "array-capture";
+
+// The maximum time a snapshot is captured for.
+const string kMaxCaptureTimeOption = "max-capture-time-ms";
+
+// The maximum number of stack frames captured in a snapshot.
+const string kMaxStackFramesOption = "max-stack-frames";
+
+// The maximum number of stack frames captured with their variables.
+const string kMaxStackFramesWithVariablesOption =
+    "max-stack-frames-with-variables";
+
+// If given this option, objects with a DebuggerDisplay attribute are
+// captured as the string of its format.
+const string kDebuggerDisplayOption = "debugger-display";
+
+// The member paths of the variables that are captured in full.
+const string kCapturePathsOption = "capture-paths";
+
+// How often the metrics of the debugger are written to the agent.
+const string kMetricsIntervalOption = "metrics-interval-ms";
+
+// How often the CPU time of the threads of the debugger is sampled.
+const string kCpuSampleIntervalOption = "cpu-sample-interval-ms";
+
+// The share of the wall time the debugger may cost the application before
+// it degrades the work done at breakpoint hits.
+const string kOverheadBudgetOption = "overhead-budget-percent";
+
+// The comma-separated cores the background threads of the debugger are
+// pinned to.
+const string kBackgroundCoresOption = "background-cores";
+
+// How much lower than normal the priority of the background threads of the
+// debugger is.
+const string kBackgroundPriorityOption = "background-priority";
+
+// The file the trace spans of the debugger are written to when it exits.
+const string kTraceFileOption = "trace-file";
+
+// The file the snapshots captured are recorded to for snapshot_benchmark.
+const string kRecordSnapshotsOption = "record-snapshots";
+
+// The file of the breakpoints the debugger sets without an agent to
+// benchmark the hit path of the application.
+const string kBenchmarkBreakpointsOption = "benchmark-breakpoints";
+
+// How long the debugger benchmarks the application before it exits.
+const string kBenchmarkDurationOption = "benchmark-duration-ms";
+
+// Parses the non-negative number given to option. Returns false if the
+// option is given without a valid number.
+bool ParseNonNegativeOption(const option::Option &option, int *value) {
+  if (!option.count()) {
+    return true;
+  }
+
+  try {
+    *value = option.arg ? stoi(string(option.arg)) : -1;
+  } catch (std::exception &ex) {
+    *value = -1;
+  }
+
+  if (*value < 0) {
+    cerr << "Option --" << option.desc->longopt
+         << " has to be a non-negative number.";
+    return false;
+  }
+  return true;
+}
+
+// Parses the --array-capture option into limits. Returns false if it is
+// not a valid mode.
+bool ParseArrayCaptureOption(const option::Option &option,
+                             CaptureLimits *limits) {
+  if (!option.count()) {
+    return true;
+  }
+
+  const string mode = option.arg ? option.arg : "";
+  const string range_prefix = "range:";
+  if (mode == "head") {
+    limits->array_capture_mode = ArrayCaptureMode::kHead;
+    return true;
+  } else if (mode == "head-tail") {
+    limits->array_capture_mode = ArrayCaptureMode::kHeadAndTail;
+    return true;
+  } else if (mode == "strided") {
+    limits->array_capture_mode = ArrayCaptureMode::kStrided;
+    return true;
+  } else if (mode.compare(0, range_prefix.size(), range_prefix) == 0) {
+    int start = -1;
+    try {
+      start = stoi(mode.substr(range_prefix.size()));
+    } catch (std::exception &ex) {
+      start = -1;
+    }
+    if (start >= 0) {
+      limits->array_capture_mode = ArrayCaptureMode::kRange;
+      limits->array_range_start = start;
+      return true;
+    }
+  }
+
+  cerr << "Option --" << option.desc->longopt
+       << " has to be head, head-tail, strided or range:<index>.";
+  return false;
+}
+
+// Splits the comma-separated list into its items.
+std::vector<string> SplitList(const string &list) {
+  std::vector<string> items;
+  size_t start = 0;
+  while (true) {
+    size_t end = list.find(',', start);
+    items.push_back(list.substr(start, end - start));
+    if (end == string::npos) {
+      return items;
+    }
+    start = end + 1;
+  }
+}
+
+// Parses the comma-separated process IDs of option into app_ids. Returns
+// false if one of them is not a non-negative number.
+bool ParseApplicationIds(const option::Option &option,
+                         std::vector<DWORD> *app_ids) {
+  for (const string &item : SplitList(option.arg ? option.arg : "")) {
+    int app_id;
+    try {
+      app_id = stoi(item);
+    } catch (std::exception &ex) {
+      app_id = -1;
+    }
+
+    if (app_id < 0) {
+      cerr << "Application ID is not a valid positive number.";
+      return false;
+    }
+    app_ids->push_back(app_id);
+  }
+  return true;
+}
+
+// Parses the comma-separated cores of option into cores. Returns false if
+// one of them is not a non-negative number.
+bool ParseCores(const option::Option &option,
+                std::vector<std::uint32_t> *cores) {
+  if (!option.count()) {
+    return true;
+  }
+
+  for (const string &item : SplitList(option.arg ? option.arg : "")) {
+    int core;
+    try {
+      core = stoi(item);
+    } catch (std::exception &ex) {
+      core = -1;
+    }
+
+    if (core < 0) {
+      cerr << "Option --" << option.desc->longopt
+           << " has to be a comma-separated list of cores.";
+      return false;
+    }
+    cores->push_back(core);
+  }
+  return true;
+}
+
+// Reads the breakpoints of the file at path into breakpoints.
+HRESULT ReadBenchmarkBreakpoints(const string &path,
+                                 std::vector<Breakpoint> *breakpoints) {
+  std::ifstream input(path);
+  if (!input) {
+    cerr << "Cannot open the benchmark breakpoints file " << path << endl;
+    return E_FAIL;
+  }
+
+  HRESULT hr = BreakpointCollection::ParseLocalBreakpoints(&input, breakpoints);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (breakpoints->empty()) {
+    cerr << "The benchmark breakpoints file " << path << " has no breakpoints."
+         << endl;
+    return E_INVALIDARG;
+  }
+  return S_OK;
+}
+
+// Prints the percentiles of the latencies in histogram.
+void PrintLatencies(const string &name, const LatencyHistogram &histogram) {
+  std::cout << name << " (us): p50 " << histogram.GetPercentile(50)
+            << ", p90 " << histogram.GetPercentile(90) << ", p99 "
+            << histogram.GetPercentile(99) << ", p99.9 "
+            << histogram.GetPercentile(99.9) << ", max "
+            << histogram.GetMaximum() << endl;
+}
+
+// Prints what the breakpoints of a benchmark cost the application over
+// the elapsed time.
+void PrintBenchmarkReport(std::chrono::steady_clock::duration elapsed) {
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  std::uint64_t hits = metrics.breakpoint_hits.GetValue();
+
+  std::cout << "Breakpoint hits: " << hits << " in " << seconds << " s";
+  if (seconds > 0) {
+    std::cout << " (" << hits / seconds << " per second)";
+  }
+  std::cout << endl;
+  PrintLatencies("Stopped time per hit", metrics.breakpoint_stop_time_us);
+  std::cout << "Function evaluations: " << metrics.func_evals.GetValue()
+            << ", timed out " << metrics.func_eval_timeouts.GetValue()
+            << endl;
+  PrintLatencies("Function evaluation time", metrics.func_eval_time_us);
+  std::cout << "Breakpoint messages: "
+            << metrics.pipe_messages_written.GetValue() << ", "
+            << metrics.pipe_bytes_written.GetValue() << " bytes"
+            << endl;
+}
+
 enum optionIndex {
   UNKNOWN,
   APPLICATIONSTARTCOMMAND,
   APPLICATIONID,
   PROPERTYEVALUATION,
   METHODEVALUATION,
-  PIPENAME
+  PIPENAME,
+  PDBINDEXCACHEDIR,
+  PDBMEMORYLIMIT,
+  SYMBOLSTOREDIR,
+  SYMBOLSERVERURL,
+  PRELOADMODULES,
+  INCLUDEMODULES,
+  EXCLUDEMODULES,
+  ONLYMODULESWITHPDB,
+  LENGTHPREFIXEDFRAMING,
+  DROPLOGPOINTSWHENQUEUEFULL,
+  SPILLFILE,
+  DUPLEXPIPE,
+  SHAREDMEMORYPIPE,
+  COMPRESSBREAKPOINTS,
+  LOGRECORDS,
+  STRINGTABLE,
+  DELTASNAPSHOTS,
+  FILTERCALLBACKS,
+  ASYNCLOGPOINTS,
+  COALESCELOGPOINTHITS,
+  PARALLELSTACKFRAMES,
+  LOGICALASYNCSTACKS,
+  REPORTBREAKPOINTCOSTS,
+  EVALTIMEOUT,
+  EVALBUDGET,
+  MAXFUNCEVALS,
+  MAXCOLLECTIONITEMS,
+  MAXOBJECTDEPTH,
+  MAXSTRINGLENGTH,
+  MAXOBJECTBYTES,
+  ARRAYCAPTURE,
+  MAXCAPTURETIME,
+  MAXSTACKFRAMES,
+  MAXSTACKFRAMESWITHVARIABLES,
+  CAPTUREPATHS,
+  DEBUGGERDISPLAY,
+  METRICSINTERVAL,
+  CPUSAMPLEINTERVAL,
+  OVERHEADBUDGET,
+  BACKGROUNDCORES,
+  BACKGROUNDPRIORITY,
+  TRACEFILE,
+  RECORDSNAPSHOTS,
+  BENCHMARKBREAKPOINTS,
+  BENCHMARKDURATION
 };
 const option::Descriptor usage[] = {
     // The first dummy Descriptor is used for unknown options,
@@ -61,7 +474,9 @@ const option::Descriptor usage[] = {
     {APPLICATIONID, 0, "", kApplicationIDOption.c_str(), option::Arg::Optional,
      "  --application-id  \tProcess ID of the application to be debugged. If "
      "used, the debugger will attach to the running application using this "
-     "ID."},
+     "ID. If this is a comma-separated list of process IDs, the debugger "
+     "attaches to every one of them, and the applications that run the same "
+     "build share the methods parsed from their PDB files."},
     {PROPERTYEVALUATION, 0, "", kEvaluationOption.c_str(), option::Arg::None,
      "  --property-evaluation  \tIf used, the debugger will attempt to "
      "evaluate property of classes. This may modify the state of the "
@@ -73,7 +488,240 @@ const option::Descriptor usage[] = {
      "the application."},
     {PIPENAME, 0, "", kPipeNameOption.c_str(), option::Arg::Optional,
      "  --pipe-name  \tThe name of the pipe the debugger will use to"
-     "communicate with the agent."},
+     "communicate with the agent. With several application IDs, a "
+     "comma-separated list of the pipe of each application in the same "
+     "order."},
+    {PDBINDEXCACHEDIR, 0, "", kPdbIndexCacheDirOption.c_str(),
+     option::Arg::Optional,
+     "  --pdb-index-cache-dir  \tIf used, the debugger will cache the methods "
+     "parsed from the PDB files of the application and the locations its "
+     "breakpoints are found at in this directory and reuse them the next "
+     "time it debugs the same build."},
+    {PDBMEMORYLIMIT, 0, "", kPdbMemoryLimitOption.c_str(),
+     option::Arg::Optional,
+     "  --pdb-memory-limit-mb  \tIf used, the debugger frees the methods "
+     "and local scopes parsed from the PDB files of the least recently used "
+     "modules without breakpoints once the ones of all the modules take "
+     "more than this many megabytes, and parses them again when they are "
+     "needed."},
+    {SYMBOLSTOREDIR, 0, "", kSymbolStoreDirOption.c_str(),
+     option::Arg::Optional,
+     "  --symbol-store-dir  \tIf used, the debugger looks up the PDB files "
+     "that are neither embedded in nor next to their modules in this "
+     "directory, which has the layout of a symbol server."},
+    {SYMBOLSERVERURL, 0, "", kSymbolServerUrlOption.c_str(),
+     option::Arg::Optional,
+     "  --symbol-server-url  \tIf used with --symbol-store-dir, the debugger "
+     "downloads the PDB files that are not in the symbol store directory "
+     "from this http:// symbol server in the background."},
+    {PRELOADMODULES, 0, "", kPreloadModulesOption.c_str(), option::Arg::None,
+     "  --preload-modules  \tIf used with --application-id, the debugger "
+     "parses the PDB files of the modules already loaded by the application "
+     "in parallel when it attaches, instead of one after the other."},
+    {INCLUDEMODULES, 0, "", kIncludeModulesOption.c_str(),
+     option::Arg::Optional,
+     "  --include-modules  \tIf used, only the modules whose file names match "
+     "these comma-separated patterns, like \"MyApp*.dll\", have their PDB "
+     "files parsed when they are loaded. '*' matches any characters and '?' "
+     "matches one. The PDB files of the other modules are parsed only when "
+     "a breakpoint is not found in any other module or a stack frame in them "
+     "is captured."},
+    {EXCLUDEMODULES, 0, "", kExcludeModulesOption.c_str(),
+     option::Arg::Optional,
+     "  --exclude-modules  \tIf used, the modules whose file names match "
+     "these comma-separated patterns, like \"System.*,Microsoft.*\", have "
+     "their PDB files parsed only when they are needed, as with "
+     "--include-modules."},
+    {ONLYMODULESWITHPDB, 0, "", kOnlyModulesWithPdbOption.c_str(),
+     option::Arg::None,
+     "  --only-modules-with-pdb  \tIf used, only the modules with an "
+     "embedded PDB or a PDB file next to them have it parsed when they are "
+     "loaded."},
+    {LENGTHPREFIXEDFRAMING, 0, "", kLengthPrefixedFramingOption.c_str(),
+     option::Arg::None,
+     "  --length-prefixed-framing  \tIf used, every breakpoint message sent "
+     "to or received from the agent is preceded by its size instead of being "
+     "surrounded by start and end markers. The agent has to use the same "
+     "framing."},
+    {DROPLOGPOINTSWHENQUEUEFULL, 0, "",
+     kDropLogPointsWhenQueueFullOption.c_str(), option::Arg::None,
+     "  --drop-log-points-when-queue-full  \tIf used, log point messages are "
+     "dropped instead of slowing down the application when the agent does "
+     "not read breakpoint messages as fast as they are produced."},
+    {SPILLFILE, 0, "", kSpillFileOption.c_str(), option::Arg::Optional,
+     "  --spill-file  \tIf used, breakpoint messages that the agent is too "
+     "slow to read are appended to this file, up to 256 MB, and written "
+     "from it in order once the agent catches up, instead of slowing down "
+     "the application."},
+    {DUPLEXPIPE, 0, "", kDuplexPipeOption.c_str(), option::Arg::None,
+     "  --duplex-pipe  \tIf used, the debugger makes a single connection to "
+     "the agent to both read and write breakpoints. The agent has to accept "
+     "a single connection."},
+    {SHAREDMEMORYPIPE, 0, "", kSharedMemoryPipeOption.c_str(),
+     option::Arg::None,
+     "  --shared-memory-pipe  \tIf used, the bytes of the duplex pipe go "
+     "through memory shared with the agent, which the agent creates, and "
+     "the connection only wakes up the side that waits for them. Requires "
+     "--duplex-pipe and is not supported on Windows."},
+    {COMPRESSBREAKPOINTS, 0, "", kCompressBreakpointsOption.c_str(),
+     option::Arg::None,
+     "  --compress-breakpoints  \tIf used, large breakpoint messages are "
+     "compressed before they are written to the agent. Only applies to "
+     "length-prefixed framing."},
+    {LOGRECORDS, 0, "", kLogRecordsOption.c_str(), option::Arg::None,
+     "  --log-records  \tIf used, hits of log points are written to the "
+     "agent as batches of log records with their formatted messages "
+     "instead of as breakpoints. Requires --length-prefixed-framing."},
+    {STRINGTABLE, 0, "", kStringTableOption.c_str(), option::Arg::None,
+     "  --string-table  \tIf used, the names and types that snapshots "
+     "repeat are written once in a string table of the snapshot."},
+    {DELTASNAPSHOTS, 0, "", kDeltaSnapshotsOption.c_str(), option::Arg::None,
+     "  --delta-snapshots  \tIf used, the variables of a snapshot that did "
+     "not change since the previous snapshot of its breakpoint are written "
+     "as references to it."},
+    {FILTERCALLBACKS, 0, "", kFilterCallbacksOption.c_str(),
+     option::Arg::None,
+     "  --filter-callbacks  \tIf used, the runtime does not notify the "
+     "debugger of log messages, or of first-chance exceptions while no "
+     "exception point is set."},
+    {ASYNCLOGPOINTS, 0, "", kAsyncLogPointsOption.c_str(), option::Arg::None,
+     "  --async-log-points  \tIf used, log points are written after the "
+     "application continues when their expressions need no evaluation in "
+     "the application. Only applies without property and method "
+     "evaluation."},
+    {COALESCELOGPOINTHITS, 0, "", kCoalesceLogPointHitsOption.c_str(),
+     option::Arg::None,
+     "  --coalesce-log-point-hits  \tIf used, a hit of a log point on a "
+     "thread is skipped while a hit of the same log point on another "
+     "thread is processed."},
+    {PARALLELSTACKFRAMES, 0, "", kParallelStackFramesOption.c_str(),
+     option::Arg::None,
+     "  --parallel-stack-frames  \tIf used, the names of the stack frames "
+     "reported without variables are resolved in parallel."},
+    {LOGICALASYNCSTACKS, 0, "", kLogicalAsyncStacksOption.c_str(),
+     option::Arg::None,
+     "  --logical-async-stacks  \tIf used, the callers of an async method "
+     "resumed after an await are reported as the async methods awaiting "
+     "it instead of the frames of the thread pool."},
+    {REPORTBREAKPOINTCOSTS, 0, "", kReportBreakpointCostsOption.c_str(),
+     option::Arg::None,
+     "  --report-breakpoint-costs  \tIf used, breakpoint messages report "
+     "in their status how many hits, stopped time, function evaluations "
+     "and bytes their breakpoint cost so far."},
+    {EVALTIMEOUT, 0, "", kEvalTimeoutOption.c_str(), option::Arg::Optional,
+     "  --eval-timeout-ms  \tThe maximum amount of time in milliseconds a "
+     "function evaluation can take before it is aborted. Defaults to one "
+     "minute."},
+    {EVALBUDGET, 0, "", kEvalBudgetOption.c_str(), option::Arg::Optional,
+     "  --eval-budget-ms  \tThe maximum total time in milliseconds the "
+     "function evaluations of a breakpoint can take. Zero means no limit."},
+    {MAXFUNCEVALS, 0, "", kMaxFuncEvalsOption.c_str(), option::Arg::Optional,
+     "  --max-func-evals  \tThe maximum number of function evaluations a "
+     "breakpoint can make. Zero means no limit."},
+    {MAXCOLLECTIONITEMS, 0, "", kMaxCollectionItemsOption.c_str(),
+     option::Arg::Optional,
+     "  --max-collection-items  \tThe maximum number of items of a "
+     "collection captured in a snapshot. Defaults to 10. Collections in "
+     "breakpoint expressions are captured in full."},
+    {MAXOBJECTDEPTH, 0, "", kMaxObjectDepthOption.c_str(),
+     option::Arg::Optional,
+     "  --max-object-depth  \tThe maximum number of levels of members "
+     "captured below a variable in a snapshot. Defaults to 5."},
+    {MAXSTRINGLENGTH, 0, "", kMaxStringLengthOption.c_str(),
+     option::Arg::Optional,
+     "  --max-string-length  \tThe maximum length in bytes of a value "
+     "captured in a snapshot. Longer values are truncated. Zero means no "
+     "limit, which is the default."},
+    {MAXOBJECTBYTES, 0, "", kMaxObjectBytesOption.c_str(),
+     option::Arg::Optional,
+     "  --max-object-bytes  \tThe maximum size in bytes of an object or "
+     "array whose members are captured in a snapshot. Larger ones are "
+     "captured with their type and size only. Zero means no limit, which "
+     "is the default."},
+    {ARRAYCAPTURE, 0, "", kArrayCaptureOption.c_str(), option::Arg::Optional,
+     "  --array-capture  \tWhich items of an array or list longer than "
+     "--max-collection-items are captured: head (the first items, the "
+     "default), head-tail (the first and the last items), strided (items "
+     "spread evenly over the array) or range:<index> (the items starting "
+     "at index)."},
+    {MAXCAPTURETIME, 0, "", kMaxCaptureTimeOption.c_str(),
+     option::Arg::Optional,
+     "  --max-capture-time-ms  \tThe maximum time in milliseconds a snapshot "
+     "is captured for while the thread is stopped. The snapshot is written "
+     "with what was captured by then, and the variables that were not are "
+     "marked as past the deadline. Zero means no limit, which is the "
+     "default."},
+    {MAXSTACKFRAMES, 0, "", kMaxStackFramesOption.c_str(),
+     option::Arg::Optional,
+     "  --max-stack-frames  \tThe maximum number of stack frames captured "
+     "in a snapshot. Defaults to 20."},
+    {MAXSTACKFRAMESWITHVARIABLES, 0, "",
+     kMaxStackFramesWithVariablesOption.c_str(), option::Arg::Optional,
+     "  --max-stack-frames-with-variables  \tThe maximum number of stack "
+     "frames captured with their local variables and method arguments. "
+     "Defaults to 4."},
+    {CAPTUREPATHS, 0, "", kCapturePathsOption.c_str(), option::Arg::Optional,
+     "  --capture-paths  \tIf used, only the local variables and method "
+     "arguments on these comma-separated member paths, like "
+     "\"request.Headers:2,order.Items[0].Price\", are captured in full. "
+     "A path can end with the number of levels of members captured below "
+     "it. Other variables are captured with just their names and types."},
+    {DEBUGGERDISPLAY, 0, "", kDebuggerDisplayOption.c_str(),
+     option::Arg::None,
+     "  --debugger-display  \tIf used, objects of classes with a "
+     "DebuggerDisplay attribute are captured as the string of its format, "
+     "like \"{Id} {Name}\", instead of with their members. Formats with "
+     "expressions other than members of the object are not used."},
+    {METRICSINTERVAL, 0, "", kMetricsIntervalOption.c_str(),
+     option::Arg::Optional,
+     "  --metrics-interval-ms  \tIf used, the debugger writes its counters "
+     "and latency histograms to the agent every this many milliseconds."},
+    {CPUSAMPLEINTERVAL, 0, "", kCpuSampleIntervalOption.c_str(),
+     option::Arg::Optional,
+     "  --cpu-sample-interval-ms  \tIf used, the debugger samples the CPU "
+     "time of its threads every this many milliseconds and reports it with "
+     "its metrics, split by thread and by the phase the threads are in."},
+    {OVERHEADBUDGET, 0, "", kOverheadBudgetOption.c_str(),
+     option::Arg::Optional,
+     "  --overhead-budget-percent  \tIf used, the debugger degrades the work "
+     "it does at breakpoint hits while its CPU time or the time it keeps "
+     "threads stopped exceeds this percentage of the wall time. It stops "
+     "evaluating properties first, then captures fewer stack frames and "
+     "collection items, then skips some hits of log points and finally "
+     "pauses snapshots."},
+    {BACKGROUNDCORES, 0, "", kBackgroundCoresOption.c_str(),
+     option::Arg::Optional,
+     "  --background-cores  \tIf used, the debugger pins the threads that "
+     "parse PDB files, write breakpoints and report metrics to this "
+     "comma-separated list of cores. The thread that processes the threads "
+     "stopped at breakpoints still runs on any core."},
+    {BACKGROUNDPRIORITY, 0, "", kBackgroundPriorityOption.c_str(),
+     option::Arg::Optional,
+     "  --background-priority  \tIf used, the debugger lowers the priority "
+     "of the threads that parse PDB files, write breakpoints and report "
+     "metrics by this much, from 0 to 19. On Linux this is added to their "
+     "nice value. The thread that processes the threads stopped at "
+     "breakpoints keeps its priority."},
+    {TRACEFILE, 0, "", kTraceFileOption.c_str(), option::Arg::Optional,
+     "  --trace-file  \tIf used, the debugger writes the spans it traced on "
+     "the breakpoint hit path to this file as a Chrome trace when it exits. "
+     "Spans are only traced by a debugger built with TRACING=true."},
+    {RECORDSNAPSHOTS, 0, "", kRecordSnapshotsOption.c_str(),
+     option::Arg::Optional,
+     "  --record-snapshots  \tIf used, the debugger appends the snapshots "
+     "it captures to this file, which snapshot_benchmark --replay reads to "
+     "measure populating the same variables without the application."},
+    {BENCHMARKBREAKPOINTS, 0, "", kBenchmarkBreakpointsOption.c_str(),
+     option::Arg::Optional,
+     "  --benchmark-breakpoints  \tIf used, the debugger sets the breakpoints "
+     "of this file without an agent and prints what their hits cost the "
+     "application when it exits. Each line is <path>:<line>, followed by a "
+     "space and a message for a log point. The pipe name is not needed."},
+    {BENCHMARKDURATION, 0, "", kBenchmarkDurationOption.c_str(),
+     option::Arg::Optional,
+     "  --benchmark-duration-ms  \tIf used with --benchmark-breakpoints, the "
+     "debugger stops after this many milliseconds instead of when the "
+     "application exits."},
     {0, 0, 0, 0, 0, 0}  // Needs this, otherwise the parser throws error.
 };
 
@@ -116,53 +764,349 @@ int main(int argc, char *argv[]) {
     return -1;
   }
 
-  if (!options[PIPENAME].count()) {
+  bool benchmark = options[BENCHMARKBREAKPOINTS].count() &&
+                   options[BENCHMARKBREAKPOINTS].arg;
+  if (!benchmark && (!options[PIPENAME].count() || !options[PIPENAME].arg)) {
     cerr << "The debugger must be given a pipe name to connect to.";
     return -1;
   }
 
-  string pipe_name = string(options[PIPENAME].arg);
-  Debugger debugger(pipe_name);
-  HRESULT hr;
+  int eval_timeout_ms = google_cloud_debugger::kDefaultEvalTimeoutMs;
+  int eval_budget_ms = 0;
+  int max_func_evals = 0;
+  int metrics_interval_ms = 0;
+  int cpu_sample_interval_ms = 0;
+  int overhead_budget_percent = 0;
+  int benchmark_duration_ms = 0;
+  int pdb_memory_limit_mb = 0;
+  int background_priority = 0;
+  CaptureLimits capture_limits;
+  int max_collection_items = capture_limits.max_collection_items;
+  int max_object_depth = capture_limits.max_depth;
+  int max_string_length = capture_limits.max_string_length;
+  int max_object_bytes = capture_limits.max_object_bytes;
+  int max_capture_time_ms = capture_limits.max_capture_time_ms;
+  int max_stack_frames = capture_limits.max_stack_frames;
+  int max_stack_frames_with_variables =
+      capture_limits.max_stack_frames_with_variables;
+  if (!ParseNonNegativeOption(options[EVALTIMEOUT], &eval_timeout_ms) ||
+      !ParseNonNegativeOption(options[EVALBUDGET], &eval_budget_ms) ||
+      !ParseNonNegativeOption(options[MAXFUNCEVALS], &max_func_evals) ||
+      !ParseNonNegativeOption(options[MAXCOLLECTIONITEMS],
+                              &max_collection_items) ||
+      !ParseNonNegativeOption(options[MAXOBJECTDEPTH], &max_object_depth) ||
+      !ParseNonNegativeOption(options[MAXSTRINGLENGTH], &max_string_length) ||
+      !ParseNonNegativeOption(options[MAXOBJECTBYTES], &max_object_bytes) ||
+      !ParseNonNegativeOption(options[MAXCAPTURETIME],
+                              &max_capture_time_ms) ||
+      !ParseNonNegativeOption(options[MAXSTACKFRAMES], &max_stack_frames) ||
+      !ParseNonNegativeOption(options[MAXSTACKFRAMESWITHVARIABLES],
+                              &max_stack_frames_with_variables) ||
+      !ParseNonNegativeOption(options[METRICSINTERVAL],
+                              &metrics_interval_ms) ||
+      !ParseNonNegativeOption(options[CPUSAMPLEINTERVAL],
+                              &cpu_sample_interval_ms) ||
+      !ParseNonNegativeOption(options[OVERHEADBUDGET],
+                              &overhead_budget_percent) ||
+      !ParseNonNegativeOption(options[BENCHMARKDURATION],
+                              &benchmark_duration_ms) ||
+      !ParseNonNegativeOption(options[PDBMEMORYLIMIT],
+                              &pdb_memory_limit_mb) ||
+      !ParseNonNegativeOption(options[BACKGROUNDPRIORITY],
+                              &background_priority)) {
+    return -1;
+  }
+  if (background_priority >
+      static_cast<int>(google_cloud_debugger::kMaxBackgroundThreadPriority)) {
+    cerr << "Option --" << kBackgroundPriorityOption
+         << " has to be at most "
+         << google_cloud_debugger::kMaxBackgroundThreadPriority << ".";
+    return -1;
+  }
+  std::vector<std::uint32_t> background_cores;
+  if (!ParseCores(options[BACKGROUNDCORES], &background_cores)) {
+    return -1;
+  }
+  capture_limits.max_collection_items = max_collection_items;
+  capture_limits.max_depth = max_object_depth;
+  capture_limits.max_string_length = max_string_length;
+  capture_limits.max_object_bytes = max_object_bytes;
+  capture_limits.max_capture_time_ms = max_capture_time_ms;
+  if (!ParseArrayCaptureOption(options[ARRAYCAPTURE], &capture_limits)) {
+    return -1;
+  }
+  capture_limits.max_stack_frames = max_stack_frames;
+  capture_limits.max_stack_frames_with_variables =
+      max_stack_frames_with_variables;
+  if (options[CAPTUREPATHS].count() && options[CAPTUREPATHS].arg) {
+    std::shared_ptr<CaptureMask> capture_mask(new CaptureMask());
+    if (!CaptureMask::Parse(string(options[CAPTUREPATHS].arg),
+                            capture_mask.get())) {
+      cerr << "Option --" << kCapturePathsOption
+           << " has to be a list of member paths.";
+      return -1;
+    }
+    capture_limits.capture_mask = std::move(capture_mask);
+  }
+  capture_limits.debugger_display = options[DEBUGGERDISPLAY].count();
+
+  std::vector<Breakpoint> benchmark_breakpoints;
+  if (benchmark &&
+      FAILED(ReadBenchmarkBreakpoints(string(options[BENCHMARKBREAKPOINTS].arg),
+                                      &benchmark_breakpoints))) {
+    return -1;
+  }
+
+  std::vector<DWORD> app_ids;
+  if (options[APPLICATIONID].count() &&
+      !ParseApplicationIds(options[APPLICATIONID], &app_ids)) {
+    return -1;
+  }
+
+  // With several applications, the pipe names are a list as well.
+  string pipe_name =
+      options[PIPENAME].arg ? string(options[PIPENAME].arg) : string();
+  std::vector<string> pipe_names = {pipe_name};
+  if (app_ids.size() > 1) {
+    pipe_names = SplitList(pipe_name);
+    if (benchmark) {
+      cerr << "Option --" << kBenchmarkBreakpointsOption
+           << " requires a single application ID.";
+      return -1;
+    }
+    if (pipe_names.size() != app_ids.size()) {
+      cerr << "Option --" << kPipeNameOption
+           << " has to have one pipe name per application ID.";
+      return -1;
+    }
+  }
+
+  if (options[SYMBOLSERVERURL].count() &&
+      (!options[SYMBOLSERVERURL].arg || !options[SYMBOLSTOREDIR].count() ||
+       !options[SYMBOLSTOREDIR].arg)) {
+    cerr << "Option --" << kSymbolServerUrlOption << " has to be a URL and "
+         << "requires --" << kSymbolStoreDirOption << ".";
+    return -1;
+  }
+
+  if (options[SHAREDMEMORYPIPE].count() && !options[DUPLEXPIPE].count()) {
+    cerr << "Option --" << kSharedMemoryPipeOption << " requires --"
+         << kDuplexPipeOption << ".";
+    return -1;
+  }
+
+  if (options[LOGRECORDS].count() && !options[LENGTHPREFIXEDFRAMING].count()) {
+    cerr << "Option --" << kLogRecordsOption << " requires --"
+         << kLengthPrefixedFramingOption << ".";
+    return -1;
+  }
 
+  ModuleFilter module_filter;
+  if (options[INCLUDEMODULES].count() &&
+      (!options[INCLUDEMODULES].arg ||
+       !module_filter.SetIncludePatterns(
+           string(options[INCLUDEMODULES].arg)))) {
+    cerr << "Option --" << kIncludeModulesOption
+         << " has to be a list of module name patterns.";
+    return -1;
+  }
+  if (options[EXCLUDEMODULES].count() &&
+      (!options[EXCLUDEMODULES].arg ||
+       !module_filter.SetExcludePatterns(
+           string(options[EXCLUDEMODULES].arg)))) {
+    cerr << "Option --" << kExcludeModulesOption
+         << " has to be a list of module name patterns.";
+    return -1;
+  }
+  module_filter.SetRequirePdbFile(options[ONLYMODULESWITHPDB].count() > 0);
+
+  std::vector<WCHAR> wchar_command_line;
   if (options[APPLICATIONSTARTCOMMAND].count()) {
     string command_line = string(options[APPLICATIONSTARTCOMMAND].arg);
-    std::vector<WCHAR> wchar_command_line =
-        ConvertStringToWCharPtr(command_line);
+    wchar_command_line = ConvertStringToWCharPtr(command_line);
 
     if (wchar_command_line.size() == 0) {
       cerr << "Application's name is not valid." << endl;
       return -1;
     }
+  }
 
-    hr = debugger.StartDebugging(wchar_command_line);
-  } else {
-    try {
-      int app_id = stoi(string(options[APPLICATIONID].arg));
-      if (app_id < 0) {
-        cerr << "Application ID has to be a positive.";
-      }
-      hr = debugger.StartDebugging(app_id);
-    } catch (std::invalid_argument &ex) {
-      cerr << "Application ID is not a valid positive number.";
+  // One Debugger per application. They share the process-wide state of
+  // the debugger: the PDB index store and caches, the metrics and the
+  // overhead budget.
+  std::vector<std::unique_ptr<Debugger>> debuggers;
+  for (size_t i = 0; i < pipe_names.size(); ++i) {
+    std::unique_ptr<Debugger> debugger(new (std::nothrow)
+                                           Debugger(pipe_names[i]));
+    if (!debugger) {
+      cerr << "Failed to create the debugger." << endl;
       return -1;
     }
-  }
 
-  if (FAILED(hr)) {
-    cerr << "Debugger fails with HRESULT " << hex << hr << endl;
-    return -1;
+    if (options[PDBINDEXCACHEDIR].count() && options[PDBINDEXCACHEDIR].arg) {
+      debugger->SetPdbIndexCacheDirectory(
+          string(options[PDBINDEXCACHEDIR].arg));
+    }
+
+    if (pdb_memory_limit_mb > 0) {
+      debugger->SetPdbMemoryLimit(
+          static_cast<std::size_t>(pdb_memory_limit_mb) * 1024 * 1024);
+    }
+
+    debugger->SetBackgroundThreadScheduling(background_cores,
+                                            background_priority);
+
+    if (options[SYMBOLSTOREDIR].count() && options[SYMBOLSTOREDIR].arg) {
+      debugger->SetSymbolStore(string(options[SYMBOLSTOREDIR].arg),
+                               options[SYMBOLSERVERURL].arg
+                                   ? string(options[SYMBOLSERVERURL].arg)
+                                   : string());
+    }
+
+    if (options[PRELOADMODULES].count()) {
+      debugger->SetPreloadModules(true);
+    }
+    debugger->SetModuleFilter(module_filter);
+
+    HRESULT hr;
+    if (options[APPLICATIONSTARTCOMMAND].count()) {
+      hr = debugger->StartDebugging(wchar_command_line);
+    } else {
+      hr = debugger->StartDebugging(app_ids[i]);
+    }
+
+    if (FAILED(hr)) {
+      cerr << "Debugger fails with HRESULT " << hex << hr << endl;
+      return -1;
+    }
+
+    // Sets property and condition evaluation.
+    debugger->SetPropertyEvaluation(property_evaluation);
+    debugger->SetMethodEvaluation(method_evaluation);
+    if (options[LENGTHPREFIXEDFRAMING].count()) {
+      debugger->SetMessageFraming(MessageFraming::kLengthPrefixed);
+    }
+    if (options[DUPLEXPIPE].count()) {
+      debugger->SetDuplexPipe(true);
+    }
+    if (options[SHAREDMEMORYPIPE].count()) {
+      debugger->SetSharedMemoryPipe(true);
+    }
+    if (options[COMPRESSBREAKPOINTS].count()) {
+      debugger->SetCompressBreakpoints(true);
+    }
+    if (options[LOGRECORDS].count()) {
+      debugger->SetLogRecords(true);
+    }
+    if (options[STRINGTABLE].count()) {
+      debugger->SetStringTable(true);
+    }
+    if (options[DELTASNAPSHOTS].count()) {
+      debugger->SetDeltaSnapshots(true);
+    }
+    if (options[RECORDSNAPSHOTS].count() && options[RECORDSNAPSHOTS].arg) {
+      debugger->SetSnapshotRecordFile(string(options[RECORDSNAPSHOTS].arg));
+    }
+    if (options[FILTERCALLBACKS].count()) {
+      debugger->SetFilterCallbacks(true);
+    }
+    if (options[ASYNCLOGPOINTS].count()) {
+      debugger->SetAsyncLogPoints(true);
+    }
+    if (options[COALESCELOGPOINTHITS].count()) {
+      debugger->SetCoalesceLogPointHits(true);
+    }
+    if (options[PARALLELSTACKFRAMES].count()) {
+      debugger->SetParallelStackFrames(true);
+    }
+    if (options[LOGICALASYNCSTACKS].count()) {
+      debugger->SetLogicalAsyncStacks(true);
+    }
+    if (options[REPORTBREAKPOINTCOSTS].count()) {
+      debugger->SetReportBreakpointCosts(true);
+    }
+    debugger->SetEvaluationTimeout(std::chrono::milliseconds(eval_timeout_ms));
+    debugger->SetEvaluationBudget(std::chrono::milliseconds(eval_budget_ms),
+                                  max_func_evals);
+    debugger->SetCaptureLimits(capture_limits);
+    debugger->SetMetricsInterval(
+        std::chrono::milliseconds(metrics_interval_ms));
+    if (options[DROPLOGPOINTSWHENQUEUEFULL].count()) {
+      debugger->SetBreakpointWriteOverflow(
+          BreakpointWriteOverflow::kDropLogPoints);
+    }
+    if (options[SPILLFILE].count() && options[SPILLFILE].arg) {
+      debugger->SetSpillFile(string(options[SPILLFILE].arg));
+    }
+    if (benchmark) {
+      debugger->SetLocalBreakpoints(std::move(benchmark_breakpoints));
+    }
+    debuggers.push_back(std::move(debugger));
   }
+  Debugger &debugger = *debuggers.front();
 
-  // Sets property and condition evaluation.
-  debugger.SetPropertyEvaluation(property_evaluation);
-  debugger.SetMethodEvaluation(method_evaluation);
+  // Stops the benchmark after its duration unless the application exits
+  // before.
+  std::mutex benchmark_mutex;
+  std::condition_variable benchmark_cv;
+  bool benchmark_done = false;
+  std::thread benchmark_timer;
+  if (benchmark && benchmark_duration_ms > 0) {
+    benchmark_timer = std::thread([&]() {
+      std::unique_lock<std::mutex> lock(benchmark_mutex);
+      if (!benchmark_cv.wait_for(
+              lock, std::chrono::milliseconds(benchmark_duration_ms),
+              [&]() { return benchmark_done; })) {
+        lock.unlock();
+        debugger.CancelSyncBreakpoints();
+      }
+    });
+  }
+  std::chrono::steady_clock::time_point benchmark_start =
+      std::chrono::steady_clock::now();
+  CpuSampler::Global().Start(
+      std::chrono::milliseconds(cpu_sample_interval_ms));
+  OverheadGovernor::Global().SetBudget(overhead_budget_percent / 100.0);
+  MetadataCache::Global().SetEnabled(true);
 
   // This will launch an infinite while loop to wait and read.
   // When the server connection of the named pipe breaks, the loop
   // will be broken and the application process will be terminated
   // in the debugger's destructor.
-  debugger.SyncBreakpoints();
+  if (debuggers.size() == 1) {
+    debugger.SyncBreakpoints();
+  } else {
+    // The debugger exits once every application exits or disconnects.
+    std::vector<std::thread> sync_threads;
+    for (auto &&app_debugger : debuggers) {
+      Debugger *sync_debugger = app_debugger.get();
+      sync_threads.push_back(std::thread(
+          [sync_debugger]() { sync_debugger->SyncBreakpoints(); }));
+    }
+    for (std::thread &sync_thread : sync_threads) {
+      sync_thread.join();
+    }
+  }
+  CpuSampler::Global().Stop();
+
+  // Releases the cached metadata imports before the debuggers detach.
+  MetadataCache::Global().SetEnabled(false);
+
+  if (benchmark) {
+    PrintBenchmarkReport(std::chrono::steady_clock::now() - benchmark_start);
+    if (benchmark_timer.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(benchmark_mutex);
+        benchmark_done = true;
+      }
+      benchmark_cv.notify_all();
+      benchmark_timer.join();
+    }
+  }
+
+  if (options[TRACEFILE].count() && options[TRACEFILE].arg) {
+    TraceLog::WriteChromeTrace(string(options[TRACEFILE].arg));
+  }
 
   return 0;
 }
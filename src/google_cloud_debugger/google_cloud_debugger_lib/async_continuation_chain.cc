@@ -0,0 +1,346 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "async_continuation_chain.h"
+
+#include <iostream>
+
+#include "dbg_stack_frame.h"
+#include "i_cor_debug_helper.h"
+#include "string_stream_wrapper.h"
+
+using std::cerr;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// The builders wrap each other, for example AsyncTaskMethodBuilder wraps
+// AsyncTaskMethodBuilder<VoidTaskResult> before .NET Core 3.0, so the
+// task is at most this many builders away from the state machine.
+const int kMaxNestedBuilders = 3;
+
+// Number of objects between a task and the state machine its
+// continuation resumes, for example a TaskContinuation, its delegate
+// and the MoveNextRunner the delegate calls before .NET Core 2.1.
+const int kMaxContinuationObjects = 4;
+
+// Fields of the builders that hold the builder they wrap.
+const char *kNestedBuilderFields[] = {"m_builder", "_methodBuilder"};
+
+// Fields of the objects between a task and a state machine that lead to
+// the state machine: the target of a delegate, the delegate of a
+// TaskContinuation and the delegate of a ContinuationWrapper.
+const char *kContinuationFields[] = {"_target", "m_action", "_continuation"};
+
+// Fields that hold a state machine: the one of AsyncStateMachineBox
+// since .NET Core 2.1 and the one of MoveNextRunner before.
+const char *kStateMachineFields[] = {"StateMachine", "m_stateMachine"};
+
+}  // namespace
+
+HRESULT AsyncContinuationChain::GetAwaitingStateMachines(
+    ICorDebugValue *state_machine, std::size_t max_depth,
+    vector<CComPtr<ICorDebugValue>> *awaiters) {
+  if (!state_machine || !awaiters) {
+    return E_INVALIDARG;
+  }
+
+  CComPtr<ICorDebugValue> current;
+  current = state_machine;
+  for (std::size_t depth = 0; depth < max_depth; ++depth) {
+    CComPtr<ICorDebugValue> task;
+    HRESULT hr = GetBuilderTask(current, &task);
+    if (hr != S_OK) {
+      return hr;
+    }
+
+    CComPtr<ICorDebugValue> awaiter;
+    hr = GetContinuationStateMachine(task, &awaiter);
+    if (hr != S_OK) {
+      return hr;
+    }
+
+    awaiters->push_back(awaiter);
+    current = awaiter;
+  }
+  return S_OK;
+}
+
+HRESULT AsyncContinuationChain::PopulateAsyncMethodNames(
+    ICorDebugValue *state_machine, DbgStackFrame *frame) {
+  if (!state_machine || !frame) {
+    return E_INVALIDARG;
+  }
+
+  BOOL is_null = FALSE;
+  CComPtr<ICorDebugValue> value;
+  HRESULT hr = debug_helper_->DereferenceAndUnbox(state_machine, &value,
+                                                  &is_null, &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (is_null) {
+    return E_INVALIDARG;
+  }
+
+  CComPtr<ICorDebugObjectValue> object_value;
+  hr = value->QueryInterface(__uuidof(ICorDebugObjectValue),
+                             reinterpret_cast<void **>(&object_value));
+  if (FAILED(hr)) {
+    cerr << "Failed to get the state machine object.";
+    return hr;
+  }
+
+  CComPtr<ICorDebugClass> debug_class;
+  hr = object_value->GetClass(&debug_class);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the class of the state machine.";
+    return hr;
+  }
+
+  mdTypeDef state_machine_token;
+  hr = debug_class->GetToken(&state_machine_token);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the token of the state machine.";
+    return hr;
+  }
+
+  CComPtr<ICorDebugModule> debug_module;
+  hr = debug_class->GetModule(&debug_module);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the module of the state machine.";
+    return hr;
+  }
+
+  vector<WCHAR> module_name;
+  hr = debug_helper_->GetModuleNameFromICorDebugModule(debug_module,
+                                                       &module_name, &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  CComPtr<IMetaDataImport> metadata_import;
+  hr = debug_helper_->GetMetadataImportFromICorDebugModule(
+      debug_module, &metadata_import, &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  string state_machine_class;
+  mdToken base_token;
+  hr = debug_helper_->GetTypeNameFromMdTypeDef(
+      state_machine_token, metadata_import, &state_machine_class, &base_token,
+      &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  frame->SetModuleName(module_name);
+
+  // The async method is in the class the state machine is nested in.
+  string method_name = GetAsyncMethodName(state_machine_class);
+  mdTypeDef enclosing_class_token = 0;
+  string enclosing_class;
+  if (method_name.empty() ||
+      FAILED(metadata_import->GetNestedClassProps(state_machine_token,
+                                                  &enclosing_class_token)) ||
+      FAILED(debug_helper_->GetTypeNameFromMdTypeDef(
+          enclosing_class_token, metadata_import, &enclosing_class,
+          &base_token, &cerr))) {
+    frame->SetClass(state_machine_class);
+    frame->SetClassToken(state_machine_token);
+    frame->SetMethod(string("MoveNext"));
+    return S_OK;
+  }
+
+  frame->SetClass(enclosing_class);
+  frame->SetClassToken(enclosing_class_token);
+  frame->SetMethod(method_name);
+  return S_OK;
+}
+
+string AsyncContinuationChain::GetAsyncMethodName(
+    const string &state_machine_class) {
+  // The name is in angle brackets, which are nested for lambdas.
+  if (state_machine_class.empty() || state_machine_class[0] != '<') {
+    return string();
+  }
+
+  std::size_t close = state_machine_class.rfind('>');
+  if (close == string::npos || close < 2) {
+    return string();
+  }
+  return state_machine_class.substr(1, close - 1);
+}
+
+HRESULT AsyncContinuationChain::GetField(ICorDebugValue *value,
+                                         const string &field_name,
+                                         ICorDebugValue **field_value) {
+  BOOL is_null = FALSE;
+  CComPtr<ICorDebugValue> object;
+  HRESULT hr =
+      debug_helper_->DereferenceAndUnbox(value, &object, &is_null, &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (is_null) {
+    return S_FALSE;
+  }
+
+  CComPtr<ICorDebugObjectValue> object_value;
+  CComPtr<ICorDebugValue2> object_value_2;
+  if (FAILED(object->QueryInterface(
+          __uuidof(ICorDebugObjectValue),
+          reinterpret_cast<void **>(&object_value))) ||
+      FAILED(object->QueryInterface(
+          __uuidof(ICorDebugValue2),
+          reinterpret_cast<void **>(&object_value_2)))) {
+    // Not an object, so it has no fields.
+    return S_FALSE;
+  }
+
+  CComPtr<ICorDebugType> debug_type;
+  hr = object_value_2->GetExactType(&debug_type);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the type of an object.";
+    return hr;
+  }
+
+  vector<WCHAR> wchar_field_name = ConvertStringToWCharPtr(field_name);
+  while (debug_type) {
+    CComPtr<ICorDebugClass> debug_class;
+    hr = debug_type->GetClass(&debug_class);
+    if (FAILED(hr)) {
+      return S_FALSE;
+    }
+
+    mdTypeDef class_token;
+    hr = debug_class->GetToken(&class_token);
+    if (FAILED(hr)) {
+      cerr << "Failed to get class token.";
+      return hr;
+    }
+
+    CComPtr<IMetaDataImport> metadata_import;
+    hr = debug_helper_->GetMetadataImportFromICorDebugClass(
+        debug_class, &metadata_import, &cerr);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    mdFieldDef field_def;
+    if (SUCCEEDED(metadata_import->FindField(
+            class_token, wchar_field_name.data(), nullptr, 0, &field_def))) {
+      return object_value->GetFieldValue(debug_class, field_def, field_value);
+    }
+
+    CComPtr<ICorDebugType> base_type;
+    hr = debug_type->GetBase(&base_type);
+    if (FAILED(hr)) {
+      return S_FALSE;
+    }
+    debug_type = base_type;
+  }
+  return S_FALSE;
+}
+
+HRESULT AsyncContinuationChain::GetBuilderTask(ICorDebugValue *state_machine,
+                                               ICorDebugValue **task) {
+  CComPtr<ICorDebugValue> builder;
+  HRESULT hr = GetField(state_machine, "<>t__builder", &builder);
+  if (hr != S_OK) {
+    return hr;
+  }
+
+  for (int nested = 0; nested < kMaxNestedBuilders; ++nested) {
+    hr = GetField(builder, "m_task", task);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    if (hr == S_FALSE) {
+      // A builder without a task is a wrapper, or the builder of an async
+      // void method, which no async method awaits.
+      CComPtr<ICorDebugValue> nested_builder;
+      for (const char *field : kNestedBuilderFields) {
+        hr = GetField(builder, field, &nested_builder);
+        if (FAILED(hr)) {
+          return hr;
+        }
+        if (hr == S_OK) {
+          break;
+        }
+      }
+      if (!nested_builder) {
+        return S_FALSE;
+      }
+      builder = nested_builder;
+      continue;
+    }
+
+    // The task is only created once the async method first awaits.
+    BOOL is_null = FALSE;
+    CComPtr<ICorDebugValue> dereferenced_task;
+    hr = debug_helper_->Dereference(*task, &dereferenced_task, &is_null,
+                                    &cerr);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    return is_null ? S_FALSE : S_OK;
+  }
+  return S_FALSE;
+}
+
+HRESULT AsyncContinuationChain::GetContinuationStateMachine(
+    ICorDebugValue *task, ICorDebugValue **state_machine) {
+  CComPtr<ICorDebugValue> current;
+  HRESULT hr = GetField(task, "m_continuationObject", &current);
+  if (hr != S_OK) {
+    return hr;
+  }
+
+  for (int step = 0; step < kMaxContinuationObjects; ++step) {
+    for (const char *field : kStateMachineFields) {
+      hr = GetField(current, field, state_machine);
+      if (hr != S_FALSE) {
+        return hr;
+      }
+    }
+
+    // Several continuations or a continuation that is not a delegate,
+    // for example a List<object> or ContinueWith, is not followed.
+    CComPtr<ICorDebugValue> next;
+    for (const char *field : kContinuationFields) {
+      hr = GetField(current, field, &next);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      if (hr == S_OK) {
+        break;
+      }
+    }
+    if (!next) {
+      return S_FALSE;
+    }
+    current = next;
+  }
+  return S_FALSE;
+}
+
+}  //  namespace google_cloud_debugger
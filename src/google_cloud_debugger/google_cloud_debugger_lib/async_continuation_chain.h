@@ -0,0 +1,91 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ASYNC_CONTINUATION_CHAIN_H_
+#define ASYNC_CONTINUATION_CHAIN_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ccomptr.h"
+#include "cor.h"
+#include "cordebug.h"
+
+namespace google_cloud_debugger {
+
+class DbgStackFrame;
+class ICorDebugHelper;
+
+// Follows the continuations of the task of an async method to the async
+// methods awaiting it. Once an async method is resumed after an await,
+// the frames above it are the thread pool that resumed it, while the
+// methods that await it only exist as the state machines the
+// continuations of its task resume:
+//   state machine -> <>t__builder -> m_task -> m_continuationObject
+//     -> (delegate _target, TaskContinuation m_action, ...)
+//     -> AsyncStateMachineBox.StateMachine, the awaiting state machine.
+// The fields are read from the debuggee, so it has to be stopped.
+class AsyncContinuationChain {
+ public:
+  explicit AsyncContinuationChain(
+      std::shared_ptr<ICorDebugHelper> debug_helper)
+      : debug_helper_(debug_helper) {}
+
+  // Appends to awaiters the state machines of the async methods awaiting
+  // state_machine, the state machine of an async method, the closest
+  // first. Stops after max_depth of them, or at a task that is not
+  // awaited by a single async method.
+  HRESULT GetAwaitingStateMachines(
+      ICorDebugValue *state_machine, std::size_t max_depth,
+      std::vector<CComPtr<ICorDebugValue>> *awaiters);
+
+  // Gives frame the module, class and method names of the async method
+  // whose state machine is state_machine.
+  HRESULT PopulateAsyncMethodNames(ICorDebugValue *state_machine,
+                                   DbgStackFrame *frame);
+
+  // Returns the name of the async method whose state machine class is
+  // state_machine_class, for example Run for <Run>d__3 and <Main>b__0_0
+  // for <<Main>b__0_0>d. Returns an empty string if state_machine_class
+  // is not the name the compiler gives state machines.
+  static std::string GetAsyncMethodName(
+      const std::string &state_machine_class);
+
+ private:
+  // Gets the field field_name of value, which is looked up in the class
+  // of value and its base classes. Returns S_FALSE if value is null or
+  // there is no such field.
+  HRESULT GetField(ICorDebugValue *value, const std::string &field_name,
+                   ICorDebugValue **field_value);
+
+  // Gets the task of the builder of state_machine. Returns S_FALSE if
+  // it has none, for example for async void methods.
+  HRESULT GetBuilderTask(ICorDebugValue *state_machine,
+                         ICorDebugValue **task);
+
+  // Gets the state machine the continuation of task resumes. Returns
+  // S_FALSE if task has no continuation, or one that does not resume a
+  // state machine.
+  HRESULT GetContinuationStateMachine(ICorDebugValue *task,
+                                      ICorDebugValue **state_machine);
+
+  // Helper for ICorDebug objects.
+  std::shared_ptr<ICorDebugHelper> debug_helper_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  ASYNC_CONTINUATION_CHAIN_H_
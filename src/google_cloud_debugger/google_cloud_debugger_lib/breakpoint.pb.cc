@@ -80,6 +80,12 @@ const ::google::protobuf::uint32 TableStruct::offsets[] = {
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, log_point_),
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, log_message_format_),
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, log_level_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, hit_limit_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, expire_time_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, breakpoints_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, sample_every_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, sample_rate_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Breakpoint, static_expression_ttl_ms_),
   ~0u,  // no _has_bits_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(StackFrame, _internal_metadata_),
   ~0u,  // no _extensions_
@@ -96,6 +102,7 @@ const ::google::protobuf::uint32 TableStruct::offsets[] = {
   ~0u,  // no _weak_field_map_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SourceLocation, path_),
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SourceLocation, line_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(SourceLocation, content_hash_),
   ~0u,  // no _has_bits_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Variable, _internal_metadata_),
   ~0u,  // no _extensions_
@@ -117,10 +124,10 @@ const ::google::protobuf::uint32 TableStruct::offsets[] = {
 
 static const ::google::protobuf::internal::MigrationSchema schemas[] = {
   { 0, -1, sizeof(Breakpoint)},
-  { 19, -1, sizeof(StackFrame)},
-  { 28, -1, sizeof(SourceLocation)},
-  { 35, -1, sizeof(Variable)},
-  { 45, -1, sizeof(Status)},
+  { 25, -1, sizeof(StackFrame)},
+  { 34, -1, sizeof(SourceLocation)},
+  { 42, -1, sizeof(Variable)},
+  { 52, -1, sizeof(Status)},
 };
 
 static ::google::protobuf::Message const * const file_default_instances[] = {
@@ -185,6 +192,8 @@ void TableStruct::InitDefaultsImpl() {
       ::google::protobuf::Timestamp::internal_default_instance());
   _Breakpoint_default_instance_.get_mutable()->status_ = const_cast< ::google::cloud::diagnostics::debug::Status*>(
       ::google::cloud::diagnostics::debug::Status::internal_default_instance());
+  _Breakpoint_default_instance_.get_mutable()->expire_time_ = const_cast< ::google::protobuf::Timestamp*>(
+      ::google::protobuf::Timestamp::internal_default_instance());
   _StackFrame_default_instance_.get_mutable()->location_ = const_cast< ::google::cloud::diagnostics::debug::SourceLocation*>(
       ::google::cloud::diagnostics::debug::SourceLocation::internal_default_instance());
   _Variable_default_instance_.get_mutable()->status_ = const_cast< ::google::cloud::diagnostics::debug::Status*>(
@@ -200,7 +209,7 @@ void AddDescriptorsImpl() {
   static const char descriptor[] = {
       "\n\020breakpoint.proto\022\036google.cloud.diagnos"
       "tics.debug\032\037google/protobuf/timestamp.pr"
-      "oto\"\361\004\n\nBreakpoint\022\n\n\002id\030\001 \001(\t\022@\n\010locati"
+      "oto\"\303\006\n\nBreakpoint\022\n\n\002id\030\001 \001(\t\022@\n\010locati"
       "on\030\002 \001(\0132..google.cloud.diagnostics.debu"
       "g.SourceLocation\022@\n\014stack_frames\030\003 \003(\0132*"
       ".google.cloud.diagnostics.debug.StackFra"
@@ -214,24 +223,29 @@ void AddDescriptorsImpl() {
       "oud.diagnostics.debug.Status\022\021\n\tlog_poin"
       "t\030\014 \001(\010\022\032\n\022log_message_format\030\r \001(\t\022F\n\tl"
       "og_level\030\016 \001(\01623.google.cloud.diagnostic"
-      "s.debug.Breakpoint.LogLevel\"*\n\010LogLevel\022"
-      "\010\n\004INFO\020\000\022\013\n\007WARNING\020\001\022\007\n\003ERR\020\002\"\332\001\n\nStac"
-      "kFrame\022\023\n\013method_name\030\001 \001(\t\022@\n\010location\030"
-      "\002 \001(\0132..google.cloud.diagnostics.debug.S"
-      "ourceLocation\022;\n\targuments\030\003 \003(\0132(.googl"
-      "e.cloud.diagnostics.debug.Variable\0228\n\006lo"
-      "cals\030\004 \003(\0132(.google.cloud.diagnostics.de"
-      "bug.Variable\",\n\016SourceLocation\022\014\n\004path\030\001"
-      " \001(\t\022\014\n\004line\030\002 \001(\005\"\250\001\n\010Variable\022\014\n\004name\030"
-      "\001 \001(\t\022\014\n\004type\030\002 \001(\t\022\r\n\005value\030\003 \001(\t\0229\n\007me"
-      "mbers\030\004 \003(\0132(.google.cloud.diagnostics.d"
-      "ebug.Variable\0226\n\006status\030\005 \001(\0132&.google.c"
-      "loud.diagnostics.debug.Status\"*\n\006Status\022"
-      "\017\n\007iserror\030\001 \001(\010\022\017\n\007message\030\002 \001(\tb\006proto"
-      "3"
+      "s.debug.Breakpoint.LogLevel\022\021\n\thit_limit"
+      "\030\017 \001(\005\022/\n\013expire_time\030\020 \001(\0132\032.google.pro"
+      "tobuf.Timestamp\022?\n\013breakpoints\030\021 \003(\0132*.g"
+      "oogle.cloud.diagnostics.debug.Breakpoint"
+      "\022\024\n\014sample_every\030\022 \001(\005\022\023\n\013sample_rate\030\023 "
+      "\001(\001\022 \n\030static_expression_ttl_ms\030\024 \001(\005\"*\n"
+      "\010LogLevel\022\010\n\004INFO\020\000\022\013\n\007WARNING\020\001\022\007\n\003ERR\020"
+      "\002\"\332\001\n\nStackFrame\022\023\n\013method_name\030\001 \001(\t\022@\n"
+      "\010location\030\002 \001(\0132..google.cloud.diagnosti"
+      "cs.debug.SourceLocation\022;\n\targuments\030\003 \003"
+      "(\0132(.google.cloud.diagnostics.debug.Vari"
+      "able\0228\n\006locals\030\004 \003(\0132(.google.cloud.diag"
+      "nostics.debug.Variable\"B\n\016SourceLocation"
+      "\022\014\n\004path\030\001 \001(\t\022\014\n\004line\030\002 \001(\005\022\024\n\014content_"
+      "hash\030\003 \001(\t\"\250\001\n\010Variable\022\014\n\004name\030\001 \001(\t\022\014\n"
+      "\004type\030\002 \001(\t\022\r\n\005value\030\003 \001(\t\0229\n\007members\030\004 "
+      "\003(\0132(.google.cloud.diagnostics.debug.Var"
+      "iable\0226\n\006status\030\005 \001(\0132&.google.cloud.dia"
+      "gnostics.debug.Status\"*\n\006Status\022\017\n\007iserr"
+      "or\030\001 \001(\010\022\017\n\007message\030\002 \001(\tb\006proto3"
   };
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-      descriptor, 1201);
+      descriptor, 1433);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "breakpoint.proto", &protobuf_RegisterTypes);
   ::google::protobuf::protobuf_google_2fprotobuf_2ftimestamp_2eproto::AddDescriptors();
@@ -308,6 +322,7 @@ Breakpoint::Breakpoint(const Breakpoint& from)
       stack_frames_(from.stack_frames_),
       expressions_(from.expressions_),
       evaluated_expressions_(from.evaluated_expressions_),
+      breakpoints_(from.breakpoints_),
       _cached_size_(0) {
   _internal_metadata_.MergeFrom(from._internal_metadata_);
   id_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
@@ -342,9 +357,14 @@ Breakpoint::Breakpoint(const Breakpoint& from)
   } else {
     status_ = NULL;
   }
-  ::memcpy(&activated_, &from.activated_,
-    reinterpret_cast<char*>(&log_level_) -
-    reinterpret_cast<char*>(&activated_) + sizeof(log_level_));
+  if (from.has_expire_time()) {
+    expire_time_ = new ::google::protobuf::Timestamp(*from.expire_time_);
+  } else {
+    expire_time_ = NULL;
+  }
+  ::memcpy(&sample_rate_, &from.sample_rate_,
+    reinterpret_cast<char*>(&static_expression_ttl_ms_) -
+    reinterpret_cast<char*>(&sample_rate_) + sizeof(static_expression_ttl_ms_));
   // @@protoc_insertion_point(copy_constructor:google.cloud.diagnostics.debug.Breakpoint)
 }
 
@@ -352,8 +372,8 @@ void Breakpoint::SharedCtor() {
   id_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   condition_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   log_message_format_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  ::memset(&location_, 0, reinterpret_cast<char*>(&log_level_) -
-    reinterpret_cast<char*>(&location_) + sizeof(log_level_));
+  ::memset(&location_, 0, reinterpret_cast<char*>(&static_expression_ttl_ms_) -
+    reinterpret_cast<char*>(&location_) + sizeof(static_expression_ttl_ms_));
   _cached_size_ = 0;
 }
 
@@ -378,6 +398,9 @@ void Breakpoint::SharedDtor() {
   if (this != internal_default_instance()) {
     delete status_;
   }
+  if (this != internal_default_instance()) {
+    delete expire_time_;
+  }
 }
 
 void Breakpoint::SetCachedSize(int size) const {
@@ -408,6 +431,7 @@ void Breakpoint::Clear() {
   stack_frames_.Clear();
   expressions_.Clear();
   evaluated_expressions_.Clear();
+  breakpoints_.Clear();
   id_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   condition_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   log_message_format_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
@@ -427,8 +451,12 @@ void Breakpoint::Clear() {
     delete status_;
   }
   status_ = NULL;
-  ::memset(&activated_, 0, reinterpret_cast<char*>(&log_level_) -
-    reinterpret_cast<char*>(&activated_) + sizeof(log_level_));
+  if (GetArenaNoVirtual() == NULL && expire_time_ != NULL) {
+    delete expire_time_;
+  }
+  expire_time_ = NULL;
+  ::memset(&sample_rate_, 0, reinterpret_cast<char*>(&static_expression_ttl_ms_) -
+    reinterpret_cast<char*>(&sample_rate_) + sizeof(static_expression_ttl_ms_));
 }
 
 bool Breakpoint::MergePartialFromCodedStream(
@@ -437,7 +465,7 @@ bool Breakpoint::MergePartialFromCodedStream(
   ::google::protobuf::uint32 tag;
   // @@protoc_insertion_point(parse_start:google.cloud.diagnostics.debug.Breakpoint)
   for (;;) {
-    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoffNoLastTag(127u);
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoffNoLastTag(16383u);
     tag = p.first;
     if (!p.second) goto handle_unusual;
     switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
@@ -635,6 +663,86 @@ bool Breakpoint::MergePartialFromCodedStream(
         break;
       }
 
+      // int32 hit_limit = 15;
+      case 15: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(120u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &hit_limit_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // .google.protobuf.Timestamp expire_time = 16;
+      case 16: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(130u)) {
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+               input, mutable_expire_time()));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+      case 17: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(138u)) {
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_breakpoints()));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // int32 sample_every = 18;
+      case 18: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(144u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &sample_every_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // double sample_rate = 19;
+      case 19: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(153u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   double, ::google::protobuf::internal::WireFormatLite::TYPE_DOUBLE>(
+                 input, &sample_rate_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // int32 static_expression_ttl_ms = 20;
+      case 20: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(160u)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &static_expression_ttl_ms_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0 ||
@@ -759,6 +867,38 @@ void Breakpoint::SerializeWithCachedSizes(
       14, this->log_level(), output);
   }
 
+  // int32 hit_limit = 15;
+  if (this->hit_limit() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(15, this->hit_limit(), output);
+  }
+
+  // .google.protobuf.Timestamp expire_time = 16;
+  if (this->has_expire_time()) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      16, *this->expire_time_, output);
+  }
+
+  // repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+  for (unsigned int i = 0, n = this->breakpoints_size(); i < n; i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      17, this->breakpoints(i), output);
+  }
+
+  // int32 sample_every = 18;
+  if (this->sample_every() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(18, this->sample_every(), output);
+  }
+
+  // double sample_rate = 19;
+  if (this->sample_rate() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteDouble(19, this->sample_rate(), output);
+  }
+
+  // int32 static_expression_ttl_ms = 20;
+  if (this->static_expression_ttl_ms() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(20, this->static_expression_ttl_ms(), output);
+  }
+
   // @@protoc_insertion_point(serialize_end:google.cloud.diagnostics.debug.Breakpoint)
 }
 
@@ -874,6 +1014,40 @@ void Breakpoint::SerializeWithCachedSizes(
       14, this->log_level(), target);
   }
 
+  // int32 hit_limit = 15;
+  if (this->hit_limit() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(15, this->hit_limit(), target);
+  }
+
+  // .google.protobuf.Timestamp expire_time = 16;
+  if (this->has_expire_time()) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      InternalWriteMessageNoVirtualToArray(
+        16, *this->expire_time_, deterministic, target);
+  }
+
+  // repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+  for (unsigned int i = 0, n = this->breakpoints_size(); i < n; i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      InternalWriteMessageNoVirtualToArray(
+        17, this->breakpoints(i), deterministic, target);
+  }
+
+  // int32 sample_every = 18;
+  if (this->sample_every() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(18, this->sample_every(), target);
+  }
+
+  // double sample_rate = 19;
+  if (this->sample_rate() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteDoubleToArray(19, this->sample_rate(), target);
+  }
+
+  // int32 static_expression_ttl_ms = 20;
+  if (this->static_expression_ttl_ms() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(20, this->static_expression_ttl_ms(), target);
+  }
+
   // @@protoc_insertion_point(serialize_to_array_end:google.cloud.diagnostics.debug.Breakpoint)
   return target;
 }
@@ -912,6 +1086,17 @@ size_t Breakpoint::ByteSizeLong() const {
     }
   }
 
+  // repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+  {
+    unsigned int count = this->breakpoints_size();
+    total_size += 2UL * count;
+    for (unsigned int i = 0; i < count; i++) {
+      total_size +=
+        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+          this->breakpoints(i));
+    }
+  }
+
   // string id = 1;
   if (this->id().size() > 0) {
     total_size += 1 +
@@ -961,6 +1146,18 @@ size_t Breakpoint::ByteSizeLong() const {
         *this->status_);
   }
 
+  // .google.protobuf.Timestamp expire_time = 16;
+  if (this->has_expire_time()) {
+    total_size += 2 +
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        *this->expire_time_);
+  }
+
+  // double sample_rate = 19;
+  if (this->sample_rate() != 0) {
+    total_size += 2 + 8;
+  }
+
   // bool activated = 4;
   if (this->activated() != 0) {
     total_size += 1 + 1;
@@ -982,6 +1179,27 @@ size_t Breakpoint::ByteSizeLong() const {
       ::google::protobuf::internal::WireFormatLite::EnumSize(this->log_level());
   }
 
+  // int32 hit_limit = 15;
+  if (this->hit_limit() != 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::Int32Size(
+        this->hit_limit());
+  }
+
+  // int32 sample_every = 18;
+  if (this->sample_every() != 0) {
+    total_size += 2 +
+      ::google::protobuf::internal::WireFormatLite::Int32Size(
+        this->sample_every());
+  }
+
+  // int32 static_expression_ttl_ms = 20;
+  if (this->static_expression_ttl_ms() != 0) {
+    total_size += 2 +
+      ::google::protobuf::internal::WireFormatLite::Int32Size(
+        this->static_expression_ttl_ms());
+  }
+
   int cached_size = ::google::protobuf::internal::ToCachedSize(total_size);
   GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
   _cached_size_ = cached_size;
@@ -1014,6 +1232,7 @@ void Breakpoint::MergeFrom(const Breakpoint& from) {
   stack_frames_.MergeFrom(from.stack_frames_);
   expressions_.MergeFrom(from.expressions_);
   evaluated_expressions_.MergeFrom(from.evaluated_expressions_);
+  breakpoints_.MergeFrom(from.breakpoints_);
   if (from.id().size() > 0) {
 
     id_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.id_);
@@ -1038,6 +1257,12 @@ void Breakpoint::MergeFrom(const Breakpoint& from) {
   if (from.has_status()) {
     mutable_status()->::google::cloud::diagnostics::debug::Status::MergeFrom(from.status());
   }
+  if (from.has_expire_time()) {
+    mutable_expire_time()->::google::protobuf::Timestamp::MergeFrom(from.expire_time());
+  }
+  if (from.sample_rate() != 0) {
+    set_sample_rate(from.sample_rate());
+  }
   if (from.activated() != 0) {
     set_activated(from.activated());
   }
@@ -1050,6 +1275,15 @@ void Breakpoint::MergeFrom(const Breakpoint& from) {
   if (from.log_level() != 0) {
     set_log_level(from.log_level());
   }
+  if (from.hit_limit() != 0) {
+    set_hit_limit(from.hit_limit());
+  }
+  if (from.sample_every() != 0) {
+    set_sample_every(from.sample_every());
+  }
+  if (from.static_expression_ttl_ms() != 0) {
+    set_static_expression_ttl_ms(from.static_expression_ttl_ms());
+  }
 }
 
 void Breakpoint::CopyFrom(const ::google::protobuf::Message& from) {
@@ -1078,6 +1312,7 @@ void Breakpoint::InternalSwap(Breakpoint* other) {
   stack_frames_.InternalSwap(&other->stack_frames_);
   expressions_.InternalSwap(&other->expressions_);
   evaluated_expressions_.InternalSwap(&other->evaluated_expressions_);
+  breakpoints_.InternalSwap(&other->breakpoints_);
   id_.Swap(&other->id_);
   condition_.Swap(&other->condition_);
   log_message_format_.Swap(&other->log_message_format_);
@@ -1085,10 +1320,15 @@ void Breakpoint::InternalSwap(Breakpoint* other) {
   std::swap(create_time_, other->create_time_);
   std::swap(final_time_, other->final_time_);
   std::swap(status_, other->status_);
+  std::swap(expire_time_, other->expire_time_);
+  std::swap(sample_rate_, other->sample_rate_);
   std::swap(activated_, other->activated_);
   std::swap(kill_server_, other->kill_server_);
   std::swap(log_point_, other->log_point_);
   std::swap(log_level_, other->log_level_);
+  std::swap(hit_limit_, other->hit_limit_);
+  std::swap(sample_every_, other->sample_every_);
+  std::swap(static_expression_ttl_ms_, other->static_expression_ttl_ms_);
   std::swap(_cached_size_, other->_cached_size_);
 }
 
@@ -1610,6 +1850,136 @@ void Breakpoint::set_log_level(::google::cloud::diagnostics::debug::Breakpoint_L
   // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.log_level)
 }
 
+// int32 hit_limit = 15;
+void Breakpoint::clear_hit_limit() {
+  hit_limit_ = 0;
+}
+::google::protobuf::int32 Breakpoint::hit_limit() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.hit_limit)
+  return hit_limit_;
+}
+void Breakpoint::set_hit_limit(::google::protobuf::int32 value) {
+  
+  hit_limit_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.hit_limit)
+}
+
+// .google.protobuf.Timestamp expire_time = 16;
+bool Breakpoint::has_expire_time() const {
+  return this != internal_default_instance() && expire_time_ != NULL;
+}
+void Breakpoint::clear_expire_time() {
+  if (GetArenaNoVirtual() == NULL && expire_time_ != NULL) delete expire_time_;
+  expire_time_ = NULL;
+}
+const ::google::protobuf::Timestamp& Breakpoint::expire_time() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+  return expire_time_ != NULL ? *expire_time_
+                         : *::google::protobuf::Timestamp::internal_default_instance();
+}
+::google::protobuf::Timestamp* Breakpoint::mutable_expire_time() {
+  
+  if (expire_time_ == NULL) {
+    expire_time_ = new ::google::protobuf::Timestamp;
+  }
+  // @@protoc_insertion_point(field_mutable:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+  return expire_time_;
+}
+::google::protobuf::Timestamp* Breakpoint::release_expire_time() {
+  // @@protoc_insertion_point(field_release:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+  
+  ::google::protobuf::Timestamp* temp = expire_time_;
+  expire_time_ = NULL;
+  return temp;
+}
+void Breakpoint::set_allocated_expire_time(::google::protobuf::Timestamp* expire_time) {
+  delete expire_time_;
+  if (expire_time != NULL && expire_time->GetArena() != NULL) {
+    ::google::protobuf::Timestamp* new_expire_time = new ::google::protobuf::Timestamp;
+    new_expire_time->CopyFrom(*expire_time);
+    expire_time = new_expire_time;
+  }
+  expire_time_ = expire_time;
+  if (expire_time) {
+    
+  } else {
+    
+  }
+  // @@protoc_insertion_point(field_set_allocated:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+}
+
+// repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+int Breakpoint::breakpoints_size() const {
+  return breakpoints_.size();
+}
+void Breakpoint::clear_breakpoints() {
+  breakpoints_.Clear();
+}
+const ::google::cloud::diagnostics::debug::Breakpoint& Breakpoint::breakpoints(int index) const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_.Get(index);
+}
+::google::cloud::diagnostics::debug::Breakpoint* Breakpoint::mutable_breakpoints(int index) {
+  // @@protoc_insertion_point(field_mutable:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_.Mutable(index);
+}
+::google::cloud::diagnostics::debug::Breakpoint* Breakpoint::add_breakpoints() {
+  // @@protoc_insertion_point(field_add:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_.Add();
+}
+::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint >*
+Breakpoint::mutable_breakpoints() {
+  // @@protoc_insertion_point(field_mutable_list:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return &breakpoints_;
+}
+const ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint >&
+Breakpoint::breakpoints() const {
+  // @@protoc_insertion_point(field_list:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_;
+}
+
+// int32 sample_every = 18;
+void Breakpoint::clear_sample_every() {
+  sample_every_ = 0;
+}
+::google::protobuf::int32 Breakpoint::sample_every() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.sample_every)
+  return sample_every_;
+}
+void Breakpoint::set_sample_every(::google::protobuf::int32 value) {
+  
+  sample_every_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.sample_every)
+}
+
+// double sample_rate = 19;
+void Breakpoint::clear_sample_rate() {
+  sample_rate_ = 0;
+}
+double Breakpoint::sample_rate() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.sample_rate)
+  return sample_rate_;
+}
+void Breakpoint::set_sample_rate(double value) {
+  
+  sample_rate_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.sample_rate)
+}
+
+// int32 static_expression_ttl_ms = 20;
+void Breakpoint::clear_static_expression_ttl_ms() {
+  static_expression_ttl_ms_ = 0;
+}
+::google::protobuf::int32 Breakpoint::static_expression_ttl_ms() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.static_expression_ttl_ms)
+  return static_expression_ttl_ms_;
+}
+void Breakpoint::set_static_expression_ttl_ms(::google::protobuf::int32 value) {
+  
+  static_expression_ttl_ms_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.static_expression_ttl_ms)
+}
+
 #endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
 
 // ===================================================================
@@ -2139,6 +2509,7 @@ StackFrame::locals() const {
 #if !defined(_MSC_VER) || _MSC_VER >= 1900
 const int SourceLocation::kPathFieldNumber;
 const int SourceLocation::kLineFieldNumber;
+const int SourceLocation::kContentHashFieldNumber;
 #endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
 
 SourceLocation::SourceLocation()
@@ -2158,12 +2529,17 @@ SourceLocation::SourceLocation(const SourceLocation& from)
   if (from.path().size() > 0) {
     path_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.path_);
   }
+  content_hash_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  if (from.content_hash().size() > 0) {
+    content_hash_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.content_hash_);
+  }
   line_ = from.line_;
   // @@protoc_insertion_point(copy_constructor:google.cloud.diagnostics.debug.SourceLocation)
 }
 
 void SourceLocation::SharedCtor() {
   path_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  content_hash_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   line_ = 0;
   _cached_size_ = 0;
 }
@@ -2175,6 +2551,7 @@ SourceLocation::~SourceLocation() {
 
 void SourceLocation::SharedDtor() {
   path_.DestroyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  content_hash_.DestroyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
 }
 
 void SourceLocation::SetCachedSize(int size) const {
@@ -2203,6 +2580,7 @@ SourceLocation* SourceLocation::New(::google::protobuf::Arena* arena) const {
 void SourceLocation::Clear() {
 // @@protoc_insertion_point(message_clear_start:google.cloud.diagnostics.debug.SourceLocation)
   path_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  content_hash_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   line_ = 0;
 }
 
@@ -2246,6 +2624,22 @@ bool SourceLocation::MergePartialFromCodedStream(
         break;
       }
 
+      // string content_hash = 3;
+      case 3: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(26u)) {
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_content_hash()));
+          DO_(::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+            this->content_hash().data(), this->content_hash().length(),
+            ::google::protobuf::internal::WireFormatLite::PARSE,
+            "google.cloud.diagnostics.debug.SourceLocation.content_hash"));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0 ||
@@ -2288,6 +2682,16 @@ void SourceLocation::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteInt32(2, this->line(), output);
   }
 
+  // string content_hash = 3;
+  if (this->content_hash().size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+      this->content_hash().data(), this->content_hash().length(),
+      ::google::protobuf::internal::WireFormatLite::SERIALIZE,
+      "google.cloud.diagnostics.debug.SourceLocation.content_hash");
+    ::google::protobuf::internal::WireFormatLite::WriteStringMaybeAliased(
+      3, this->content_hash(), output);
+  }
+
   // @@protoc_insertion_point(serialize_end:google.cloud.diagnostics.debug.SourceLocation)
 }
 
@@ -2313,6 +2717,17 @@ void SourceLocation::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(2, this->line(), target);
   }
 
+  // string content_hash = 3;
+  if (this->content_hash().size() > 0) {
+    ::google::protobuf::internal::WireFormatLite::VerifyUtf8String(
+      this->content_hash().data(), this->content_hash().length(),
+      ::google::protobuf::internal::WireFormatLite::SERIALIZE,
+      "google.cloud.diagnostics.debug.SourceLocation.content_hash");
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        3, this->content_hash(), target);
+  }
+
   // @@protoc_insertion_point(serialize_to_array_end:google.cloud.diagnostics.debug.SourceLocation)
   return target;
 }
@@ -2328,6 +2743,13 @@ size_t SourceLocation::ByteSizeLong() const {
         this->path());
   }
 
+  // string content_hash = 3;
+  if (this->content_hash().size() > 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::StringSize(
+        this->content_hash());
+  }
+
   // int32 line = 2;
   if (this->line() != 0) {
     total_size += 1 +
@@ -2368,6 +2790,10 @@ void SourceLocation::MergeFrom(const SourceLocation& from) {
 
     path_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.path_);
   }
+  if (from.content_hash().size() > 0) {
+
+    content_hash_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.content_hash_);
+  }
   if (from.line() != 0) {
     set_line(from.line());
   }
@@ -2397,6 +2823,7 @@ void SourceLocation::Swap(SourceLocation* other) {
 }
 void SourceLocation::InternalSwap(SourceLocation* other) {
   path_.Swap(&other->path_);
+  content_hash_.Swap(&other->content_hash_);
   std::swap(line_, other->line_);
   std::swap(_cached_size_, other->_cached_size_);
 }
@@ -2476,6 +2903,59 @@ void SourceLocation::set_line(::google::protobuf::int32 value) {
   // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.SourceLocation.line)
 }
 
+// string content_hash = 3;
+void SourceLocation::clear_content_hash() {
+  content_hash_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+const ::std::string& SourceLocation::content_hash() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+  return content_hash_.GetNoArena();
+}
+void SourceLocation::set_content_hash(const ::std::string& value) {
+  
+  content_hash_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), value);
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+#if LANG_CXX11
+void SourceLocation::set_content_hash(::std::string&& value) {
+  
+  content_hash_.SetNoArena(
+    &::google::protobuf::internal::GetEmptyStringAlreadyInited(), ::std::move(value));
+  // @@protoc_insertion_point(field_set_rvalue:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+#endif
+void SourceLocation::set_content_hash(const char* value) {
+  GOOGLE_DCHECK(value != NULL);
+  
+  content_hash_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), ::std::string(value));
+  // @@protoc_insertion_point(field_set_char:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+void SourceLocation::set_content_hash(const char* value, size_t size) {
+  
+  content_hash_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(),
+      ::std::string(reinterpret_cast<const char*>(value), size));
+  // @@protoc_insertion_point(field_set_pointer:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+::std::string* SourceLocation::mutable_content_hash() {
+  
+  // @@protoc_insertion_point(field_mutable:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+  return content_hash_.MutableNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+::std::string* SourceLocation::release_content_hash() {
+  // @@protoc_insertion_point(field_release:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+  
+  return content_hash_.ReleaseNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+void SourceLocation::set_allocated_content_hash(::std::string* content_hash) {
+  if (content_hash != NULL) {
+    
+  } else {
+    
+  }
+  content_hash_.SetAllocatedNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), content_hash);
+  // @@protoc_insertion_point(field_set_allocated:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+
 #endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
 
 // ===================================================================
@@ -242,6 +242,18 @@ class Breakpoint : public ::google::protobuf::Message /* @@protoc_insertion_poin
   const ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Variable >&
       evaluated_expressions() const;
 
+  // repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+  int breakpoints_size() const;
+  void clear_breakpoints();
+  static const int kBreakpointsFieldNumber = 17;
+  const ::google::cloud::diagnostics::debug::Breakpoint& breakpoints(int index) const;
+  ::google::cloud::diagnostics::debug::Breakpoint* mutable_breakpoints(int index);
+  ::google::cloud::diagnostics::debug::Breakpoint* add_breakpoints();
+  ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint >*
+      mutable_breakpoints();
+  const ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint >&
+      breakpoints() const;
+
   // string id = 1;
   void clear_id();
   static const int kIdFieldNumber = 1;
@@ -320,6 +332,21 @@ class Breakpoint : public ::google::protobuf::Message /* @@protoc_insertion_poin
   ::google::cloud::diagnostics::debug::Status* release_status();
   void set_allocated_status(::google::cloud::diagnostics::debug::Status* status);
 
+  // .google.protobuf.Timestamp expire_time = 16;
+  bool has_expire_time() const;
+  void clear_expire_time();
+  static const int kExpireTimeFieldNumber = 16;
+  const ::google::protobuf::Timestamp& expire_time() const;
+  ::google::protobuf::Timestamp* mutable_expire_time();
+  ::google::protobuf::Timestamp* release_expire_time();
+  void set_allocated_expire_time(::google::protobuf::Timestamp* expire_time);
+
+  // double sample_rate = 19;
+  void clear_sample_rate();
+  static const int kSampleRateFieldNumber = 19;
+  double sample_rate() const;
+  void set_sample_rate(double value);
+
   // bool activated = 4;
   void clear_activated();
   static const int kActivatedFieldNumber = 4;
@@ -344,6 +371,24 @@ class Breakpoint : public ::google::protobuf::Message /* @@protoc_insertion_poin
   ::google::cloud::diagnostics::debug::Breakpoint_LogLevel log_level() const;
   void set_log_level(::google::cloud::diagnostics::debug::Breakpoint_LogLevel value);
 
+  // int32 hit_limit = 15;
+  void clear_hit_limit();
+  static const int kHitLimitFieldNumber = 15;
+  ::google::protobuf::int32 hit_limit() const;
+  void set_hit_limit(::google::protobuf::int32 value);
+
+  // int32 sample_every = 18;
+  void clear_sample_every();
+  static const int kSampleEveryFieldNumber = 18;
+  ::google::protobuf::int32 sample_every() const;
+  void set_sample_every(::google::protobuf::int32 value);
+
+  // int32 static_expression_ttl_ms = 20;
+  void clear_static_expression_ttl_ms();
+  static const int kStaticExpressionTtlMsFieldNumber = 20;
+  ::google::protobuf::int32 static_expression_ttl_ms() const;
+  void set_static_expression_ttl_ms(::google::protobuf::int32 value);
+
   // @@protoc_insertion_point(class_scope:google.cloud.diagnostics.debug.Breakpoint)
  private:
 
@@ -351,6 +396,7 @@ class Breakpoint : public ::google::protobuf::Message /* @@protoc_insertion_poin
   ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::StackFrame > stack_frames_;
   ::google::protobuf::RepeatedPtrField< ::std::string> expressions_;
   ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Variable > evaluated_expressions_;
+  ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint > breakpoints_;
   ::google::protobuf::internal::ArenaStringPtr id_;
   ::google::protobuf::internal::ArenaStringPtr condition_;
   ::google::protobuf::internal::ArenaStringPtr log_message_format_;
@@ -358,10 +404,15 @@ class Breakpoint : public ::google::protobuf::Message /* @@protoc_insertion_poin
   ::google::protobuf::Timestamp* create_time_;
   ::google::protobuf::Timestamp* final_time_;
   ::google::cloud::diagnostics::debug::Status* status_;
+  ::google::protobuf::Timestamp* expire_time_;
+  double sample_rate_;
   bool activated_;
   bool kill_server_;
   bool log_point_;
   int log_level_;
+  ::google::protobuf::int32 hit_limit_;
+  ::google::protobuf::int32 sample_every_;
+  ::google::protobuf::int32 static_expression_ttl_ms_;
   mutable int _cached_size_;
   friend struct protobuf_breakpoint_2eproto::TableStruct;
 };
@@ -569,6 +620,20 @@ class SourceLocation : public ::google::protobuf::Message /* @@protoc_insertion_
   ::std::string* release_path();
   void set_allocated_path(::std::string* path);
 
+  // string content_hash = 3;
+  void clear_content_hash();
+  static const int kContentHashFieldNumber = 3;
+  const ::std::string& content_hash() const;
+  void set_content_hash(const ::std::string& value);
+  #if LANG_CXX11
+  void set_content_hash(::std::string&& value);
+  #endif
+  void set_content_hash(const char* value);
+  void set_content_hash(const char* value, size_t size);
+  ::std::string* mutable_content_hash();
+  ::std::string* release_content_hash();
+  void set_allocated_content_hash(::std::string* content_hash);
+
   // int32 line = 2;
   void clear_line();
   static const int kLineFieldNumber = 2;
@@ -580,6 +645,7 @@ class SourceLocation : public ::google::protobuf::Message /* @@protoc_insertion_
 
   ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
   ::google::protobuf::internal::ArenaStringPtr path_;
+  ::google::protobuf::internal::ArenaStringPtr content_hash_;
   ::google::protobuf::int32 line_;
   mutable int _cached_size_;
   friend struct protobuf_breakpoint_2eproto::TableStruct;
@@ -1338,6 +1404,136 @@ inline void Breakpoint::set_log_level(::google::cloud::diagnostics::debug::Break
   // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.log_level)
 }
 
+// int32 hit_limit = 15;
+inline void Breakpoint::clear_hit_limit() {
+  hit_limit_ = 0;
+}
+inline ::google::protobuf::int32 Breakpoint::hit_limit() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.hit_limit)
+  return hit_limit_;
+}
+inline void Breakpoint::set_hit_limit(::google::protobuf::int32 value) {
+  
+  hit_limit_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.hit_limit)
+}
+
+// .google.protobuf.Timestamp expire_time = 16;
+inline bool Breakpoint::has_expire_time() const {
+  return this != internal_default_instance() && expire_time_ != NULL;
+}
+inline void Breakpoint::clear_expire_time() {
+  if (GetArenaNoVirtual() == NULL && expire_time_ != NULL) delete expire_time_;
+  expire_time_ = NULL;
+}
+inline const ::google::protobuf::Timestamp& Breakpoint::expire_time() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+  return expire_time_ != NULL ? *expire_time_
+                         : *::google::protobuf::Timestamp::internal_default_instance();
+}
+inline ::google::protobuf::Timestamp* Breakpoint::mutable_expire_time() {
+  
+  if (expire_time_ == NULL) {
+    expire_time_ = new ::google::protobuf::Timestamp;
+  }
+  // @@protoc_insertion_point(field_mutable:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+  return expire_time_;
+}
+inline ::google::protobuf::Timestamp* Breakpoint::release_expire_time() {
+  // @@protoc_insertion_point(field_release:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+  
+  ::google::protobuf::Timestamp* temp = expire_time_;
+  expire_time_ = NULL;
+  return temp;
+}
+inline void Breakpoint::set_allocated_expire_time(::google::protobuf::Timestamp* expire_time) {
+  delete expire_time_;
+  if (expire_time != NULL && expire_time->GetArena() != NULL) {
+    ::google::protobuf::Timestamp* new_expire_time = new ::google::protobuf::Timestamp;
+    new_expire_time->CopyFrom(*expire_time);
+    expire_time = new_expire_time;
+  }
+  expire_time_ = expire_time;
+  if (expire_time) {
+    
+  } else {
+    
+  }
+  // @@protoc_insertion_point(field_set_allocated:google.cloud.diagnostics.debug.Breakpoint.expire_time)
+}
+
+// repeated .google.cloud.diagnostics.debug.Breakpoint breakpoints = 17;
+inline int Breakpoint::breakpoints_size() const {
+  return breakpoints_.size();
+}
+inline void Breakpoint::clear_breakpoints() {
+  breakpoints_.Clear();
+}
+inline const ::google::cloud::diagnostics::debug::Breakpoint& Breakpoint::breakpoints(int index) const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_.Get(index);
+}
+inline ::google::cloud::diagnostics::debug::Breakpoint* Breakpoint::mutable_breakpoints(int index) {
+  // @@protoc_insertion_point(field_mutable:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_.Mutable(index);
+}
+inline ::google::cloud::diagnostics::debug::Breakpoint* Breakpoint::add_breakpoints() {
+  // @@protoc_insertion_point(field_add:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_.Add();
+}
+inline ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint >*
+Breakpoint::mutable_breakpoints() {
+  // @@protoc_insertion_point(field_mutable_list:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return &breakpoints_;
+}
+inline const ::google::protobuf::RepeatedPtrField< ::google::cloud::diagnostics::debug::Breakpoint >&
+Breakpoint::breakpoints() const {
+  // @@protoc_insertion_point(field_list:google.cloud.diagnostics.debug.Breakpoint.breakpoints)
+  return breakpoints_;
+}
+
+// int32 sample_every = 18;
+inline void Breakpoint::clear_sample_every() {
+  sample_every_ = 0;
+}
+inline ::google::protobuf::int32 Breakpoint::sample_every() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.sample_every)
+  return sample_every_;
+}
+inline void Breakpoint::set_sample_every(::google::protobuf::int32 value) {
+  
+  sample_every_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.sample_every)
+}
+
+// double sample_rate = 19;
+inline void Breakpoint::clear_sample_rate() {
+  sample_rate_ = 0;
+}
+inline double Breakpoint::sample_rate() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.sample_rate)
+  return sample_rate_;
+}
+inline void Breakpoint::set_sample_rate(double value) {
+  
+  sample_rate_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.sample_rate)
+}
+
+// int32 static_expression_ttl_ms = 20;
+inline void Breakpoint::clear_static_expression_ttl_ms() {
+  static_expression_ttl_ms_ = 0;
+}
+inline ::google::protobuf::int32 Breakpoint::static_expression_ttl_ms() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.Breakpoint.static_expression_ttl_ms)
+  return static_expression_ttl_ms_;
+}
+inline void Breakpoint::set_static_expression_ttl_ms(::google::protobuf::int32 value) {
+  
+  static_expression_ttl_ms_ = value;
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.Breakpoint.static_expression_ttl_ms)
+}
+
 // -------------------------------------------------------------------
 
 // StackFrame
@@ -1565,6 +1761,59 @@ inline void SourceLocation::set_line(::google::protobuf::int32 value) {
   // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.SourceLocation.line)
 }
 
+// string content_hash = 3;
+inline void SourceLocation::clear_content_hash() {
+  content_hash_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+inline const ::std::string& SourceLocation::content_hash() const {
+  // @@protoc_insertion_point(field_get:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+  return content_hash_.GetNoArena();
+}
+inline void SourceLocation::set_content_hash(const ::std::string& value) {
+  
+  content_hash_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), value);
+  // @@protoc_insertion_point(field_set:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+#if LANG_CXX11
+inline void SourceLocation::set_content_hash(::std::string&& value) {
+  
+  content_hash_.SetNoArena(
+    &::google::protobuf::internal::GetEmptyStringAlreadyInited(), ::std::move(value));
+  // @@protoc_insertion_point(field_set_rvalue:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+#endif
+inline void SourceLocation::set_content_hash(const char* value) {
+  GOOGLE_DCHECK(value != NULL);
+  
+  content_hash_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), ::std::string(value));
+  // @@protoc_insertion_point(field_set_char:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+inline void SourceLocation::set_content_hash(const char* value, size_t size) {
+  
+  content_hash_.SetNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(),
+      ::std::string(reinterpret_cast<const char*>(value), size));
+  // @@protoc_insertion_point(field_set_pointer:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+inline ::std::string* SourceLocation::mutable_content_hash() {
+  
+  // @@protoc_insertion_point(field_mutable:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+  return content_hash_.MutableNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+inline ::std::string* SourceLocation::release_content_hash() {
+  // @@protoc_insertion_point(field_release:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+  
+  return content_hash_.ReleaseNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+}
+inline void SourceLocation::set_allocated_content_hash(::std::string* content_hash) {
+  if (content_hash != NULL) {
+    
+  } else {
+    
+  }
+  content_hash_.SetAllocatedNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), content_hash);
+  // @@protoc_insertion_point(field_set_allocated:google.cloud.diagnostics.debug.SourceLocation.content_hash)
+}
+
 // -------------------------------------------------------------------
 
 // Variable
@@ -0,0 +1,147 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "breakpoint_activation_queue.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "cpu_sampler.h"
+#include "thread_scheduling.h"
+
+using std::cerr;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+BreakpointActivationQueue::BreakpointActivationQueue(ActivateFunction activate,
+                                                     std::size_t batch_size,
+                                                     MetricCounter *cancelled)
+    : activate_(std::move(activate)),
+      batch_size_(batch_size == 0 ? 1 : batch_size),
+      cancelled_(cancelled) {}
+
+BreakpointActivationQueue::~BreakpointActivationQueue() { Stop(); }
+
+HRESULT BreakpointActivationQueue::Enqueue(
+    const vector<shared_ptr<DbgBreakpoint>> &breakpoints) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return E_ABORT;
+    }
+
+    for (const shared_ptr<DbgBreakpoint> &breakpoint : breakpoints) {
+      if (!breakpoint) {
+        continue;
+      }
+      RemoveQueued(breakpoint->GetId());
+      queue_.push_back(breakpoint);
+    }
+
+    if (!thread_.joinable()) {
+      thread_ =
+          std::thread(&BreakpointActivationQueue::ActivateBreakpoints, this);
+    }
+  }
+
+  queued_cv_.notify_one();
+  return S_OK;
+}
+
+bool BreakpointActivationQueue::Cancel(const string &id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (RemoveQueued(id)) {
+    return true;
+  }
+
+  activated_cv_.wait(lock, [this, &id] {
+    return activating_.find(id) == activating_.end();
+  });
+  return false;
+}
+
+void BreakpointActivationQueue::Stop() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    queue_.clear();
+    std::swap(thread, thread_);
+  }
+  queued_cv_.notify_all();
+
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+std::size_t BreakpointActivationQueue::GetQueuedCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+void BreakpointActivationQueue::ActivateBreakpoints() {
+  CpuSampler::RegisterThread("breakpoint_activation");
+  ThreadScheduling::Global().ApplyToBackgroundThread();
+
+  vector<shared_ptr<DbgBreakpoint>> batch;
+  batch.reserve(batch_size_);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      activating_.clear();
+      batch.clear();
+      activated_cv_.notify_all();
+
+      queued_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (stopping_) {
+        return;
+      }
+
+      std::size_t count = std::min(queue_.size(), batch_size_);
+      for (std::size_t i = 0; i < count; ++i) {
+        activating_.insert(queue_.front()->GetId());
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+    }
+
+    HRESULT hr = activate_(batch);
+    if (FAILED(hr)) {
+      cerr << "Failed to activate " << batch.size()
+           << " breakpoints: " << std::hex << hr << std::dec << std::endl;
+    }
+  }
+}
+
+bool BreakpointActivationQueue::RemoveQueued(const string &id) {
+  auto queued = std::find_if(
+      queue_.begin(), queue_.end(),
+      [&id](const shared_ptr<DbgBreakpoint> &breakpoint) {
+        return breakpoint->GetId() == id;
+      });
+  if (queued == queue_.end()) {
+    return false;
+  }
+  queue_.erase(queued);
+  if (cancelled_) {
+    cancelled_->Increment();
+  }
+  return true;
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,122 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BREAKPOINT_ACTIVATION_QUEUE_H_
+#define BREAKPOINT_ACTIVATION_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "cor.h"
+#include "dbg_breakpoint.h"
+#include "metrics.h"
+
+namespace google_cloud_debugger {
+
+// Activates breakpoints on a dedicated thread, so that the thread reading
+// breakpoints from the agent can apply deactivations right away instead
+// of waiting behind activations that search PDBs. Activations are taken
+// from the queue in batches of at most a given size, and the lock of the
+// breakpoint collection is released between batches.
+//
+// A deactivation has to cancel the queued activation of the same
+// breakpoint first, otherwise the activation would be applied after it.
+// The thread is started by the first call to Enqueue.
+class BreakpointActivationQueue {
+ public:
+  // Activates a batch of breakpoints and returns an HRESULT.
+  typedef std::function<HRESULT(
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &)>
+      ActivateFunction;
+
+  // Creates a queue that activates with activate, at most batch_size
+  // breakpoints (at least 1) at a time, and counts the queued activations
+  // that are cancelled or replaced in cancelled.
+  BreakpointActivationQueue(ActivateFunction activate, std::size_t batch_size,
+                            MetricCounter *cancelled);
+  BreakpointActivationQueue(const BreakpointActivationQueue &) = delete;
+  BreakpointActivationQueue &operator=(const BreakpointActivationQueue &) =
+      delete;
+
+  // Calls Stop.
+  ~BreakpointActivationQueue();
+
+  // Queues breakpoints to be activated. A queued activation of a
+  // breakpoint with the same ID is replaced. Returns E_ABORT if the queue
+  // is stopped.
+  HRESULT Enqueue(
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints);
+
+  // Removes the queued activation of the breakpoint with id. If the
+  // breakpoint is being activated, waits until the activation is done.
+  // Returns true if a queued activation was removed.
+  bool Cancel(const std::string &id);
+
+  // Stops accepting breakpoints, drops the queued ones, waits for the
+  // batch being activated and joins the thread.
+  void Stop();
+
+  // Returns the number of breakpoints waiting to be activated.
+  std::size_t GetQueuedCount();
+
+ private:
+  // Loop of the activation thread: activates the queued breakpoints until
+  // the queue is stopped.
+  void ActivateBreakpoints();
+
+  // Removes the queued activation of id. Must be called with mutex_ held.
+  bool RemoveQueued(const std::string &id);
+
+  // Activates the batches of breakpoints.
+  ActivateFunction activate_;
+
+  // Maximum number of breakpoints activated at a time.
+  std::size_t batch_size_;
+
+  // Breakpoints waiting to be activated, in the order they were queued.
+  std::deque<std::shared_ptr<DbgBreakpoint>> queue_;
+
+  // IDs of the breakpoints of the batch being activated.
+  std::unordered_set<std::string> activating_;
+
+  // True once Stop is called.
+  bool stopping_ = false;
+
+  // The activation thread.
+  std::thread thread_;
+
+  // Protects queue_, activating_, stopping_ and thread_.
+  std::mutex mutex_;
+
+  // Signaled when breakpoints are queued or the queue is stopped.
+  std::condition_variable queued_cv_;
+
+  // Signaled when a batch is activated.
+  std::condition_variable activated_cv_;
+
+  // Counts the cancelled and replaced activations.
+  MetricCounter *cancelled_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  BREAKPOINT_ACTIVATION_QUEUE_H_
@@ -14,9 +14,16 @@
 
 #include "breakpoint_client.h"
 
+#include <chrono>
+#include <cstring>
 #include <mutex>
 
+#include <google/protobuf/io/coded_stream.h>
+
 #include "constants.h"
+#include "metrics.h"
+#include "trace.h"
+#include "variable_encoder.h"
 
 using std::cerr;
 using std::string;
@@ -24,8 +31,84 @@ using namespace google::cloud::diagnostics::debug;
 
 namespace google_cloud_debugger {
 
-BreakpointClient::BreakpointClient(std::unique_ptr<INamedPipe> pipe)
-    : pipe_(std::move(pipe)) {}
+namespace {
+
+// Writes the frame header of a message of size bytes into header.
+void WriteFrameHeader(uint8_t version, size_t size, uint8_t *header) {
+  header[0] = version;
+  header[1] = static_cast<uint8_t>(size);
+  header[2] = static_cast<uint8_t>(size >> 8);
+  header[3] = static_cast<uint8_t>(size >> 16);
+  header[4] = static_cast<uint8_t>(size >> 24);
+}
+
+// Fills in the frame header at frame_start of buffer, which is followed
+// by the rest of buffer as the message. Returns false if the message is
+// too large for a frame.
+bool FinishFrame(uint8_t version, size_t frame_start, string *buffer) {
+  size_t size = buffer->size() - frame_start - kFrameHeaderSize;
+  if (size > kMaximumFrameSize) {
+    cerr << "log records are too large to be sent: " << size << std::endl;
+    return false;
+  }
+
+  WriteFrameHeader(version, size,
+                   reinterpret_cast<uint8_t *>(&(*buffer)[frame_start]));
+  return true;
+}
+
+// Copies the fields of breakpoint other than its stack frames and its
+// evaluated expressions into header.
+void CopyBreakpointHeader(const Breakpoint &breakpoint, Breakpoint *header) {
+  header->set_id(breakpoint.id());
+  if (breakpoint.has_location()) {
+    *header->mutable_location() = breakpoint.location();
+  }
+  header->set_activated(breakpoint.activated());
+  if (breakpoint.has_create_time()) {
+    *header->mutable_create_time() = breakpoint.create_time();
+  }
+  if (breakpoint.has_final_time()) {
+    *header->mutable_final_time() = breakpoint.final_time();
+  }
+  header->set_kill_server(breakpoint.kill_server());
+  *header->mutable_expressions() = breakpoint.expressions();
+  header->set_condition(breakpoint.condition());
+  if (breakpoint.has_status()) {
+    *header->mutable_status() = breakpoint.status();
+  }
+  header->set_log_point(breakpoint.log_point());
+  header->set_log_message_format(breakpoint.log_message_format());
+  header->set_log_level(breakpoint.log_level());
+}
+
+// Appends message, whose size ByteSizeLong cached, to buffer serialized
+// as the field field_number of its parent message.
+void AppendField(int field_number, const google::protobuf::MessageLite &message,
+                 string *buffer) {
+  using google::protobuf::io::CodedOutputStream;
+
+  // The tag of a length-delimited field and the size, two varints of at
+  // most five bytes each.
+  uint8_t prefix[10];
+  size_t size = message.GetCachedSize();
+  uint8_t *end =
+      CodedOutputStream::WriteVarint32ToArray(field_number << 3 | 2, prefix);
+  end = CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(size),
+                                                end);
+  buffer->append(reinterpret_cast<const char *>(prefix), end - prefix);
+
+  size_t offset = buffer->size();
+  buffer->resize(offset + size);
+  message.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t *>(&(*buffer)[offset]));
+}
+
+}  // namespace
+
+BreakpointClient::BreakpointClient(std::unique_ptr<INamedPipe> pipe,
+                                   MessageFraming framing)
+    : pipe_(std::move(pipe)), framing_(framing) {}
 
 HRESULT BreakpointClient::Initialize() { return pipe_->Initialize(); }
 
@@ -35,6 +118,53 @@ HRESULT BreakpointClient::WaitForConnection() {
 
 HRESULT BreakpointClient::ReadBreakpoint(Breakpoint *breakpoint) {
   std::lock_guard<std::mutex> lock(mutex_);
+  if (framing_ == MessageFraming::kLengthPrefixed) {
+    return ReadLengthPrefixedBreakpoint(breakpoint);
+  }
+
+  return ReadMarkedBreakpoint(breakpoint);
+}
+
+HRESULT BreakpointClient::ReadLengthPrefixedBreakpoint(
+    Breakpoint *breakpoint) {
+  HRESULT hr = pipe_->ReadExactly(kFrameHeaderSize, &buffer_);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  const uint8_t *header = reinterpret_cast<const uint8_t *>(buffer_.data());
+  if (header[0] != kFrameVersion) {
+    cerr << "unsupported breakpoint frame version "
+         << static_cast<uint32_t>(header[0]) << std::endl;
+    return E_FAIL;
+  }
+
+  uint32_t size = static_cast<uint32_t>(header[1]) |
+                  static_cast<uint32_t>(header[2]) << 8 |
+                  static_cast<uint32_t>(header[3]) << 16 |
+                  static_cast<uint32_t>(header[4]) << 24;
+  if (size > kMaximumFrameSize) {
+    cerr << "invalid breakpoint frame size " << size << std::endl;
+    return E_FAIL;
+  }
+
+  hr = pipe_->ReadExactly(size, &buffer_);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (!breakpoint->ParseFromArray(buffer_.data(), size)) {
+    cerr << "failed to serialize from protobuf" << std::endl;
+    return E_FAIL;
+  }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.pipe_messages_read.Increment();
+  metrics.pipe_bytes_read.Increment(kFrameHeaderSize + size);
+  return S_OK;
+}
+
+HRESULT BreakpointClient::ReadMarkedBreakpoint(Breakpoint *breakpoint) {
   string buffer;
   std::swap(buffer, buffer_);
   string str;
@@ -68,18 +198,290 @@ HRESULT BreakpointClient::ReadBreakpoint(Breakpoint *breakpoint) {
     cerr << "failed to serialize from protobuf" << std::endl;
     return E_FAIL;
   }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.pipe_messages_read.Increment();
+  metrics.pipe_bytes_read.Increment(kStartBreakpointMessage.size() +
+                                    newStr.size() +
+                                    kEndBreakpointMessage.size());
   return S_OK;
 }
 
 HRESULT BreakpointClient::WriteBreakpoint(const Breakpoint &breakpoint) {
-  string bp_str;
-  if (!breakpoint.SerializeToString(&bp_str)) {
-    cerr << "failed to serialize to protobuf" << std::endl;
+  return WriteBreakpoints(&breakpoint, 1);
+}
+
+HRESULT BreakpointClient::WriteBreakpoints(const Breakpoint *breakpoints,
+                                           size_t count) {
+  DEBUGGER_TRACE_SPAN("BreakpointClient::WriteBreakpoints");
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  bool length_prefixed = framing_ == MessageFraming::kLengthPrefixed;
+  size_t first = 0;
+  for (size_t i = 0; i < count; ++i) {
+    bool log_record =
+        length_prefixed && log_records_ &&
+        LogRecordEncoder::CanEncode(breakpoints[i]);
+    if (!log_record) {
+      size_t size = breakpoints[i].ByteSizeLong();
+      if (!length_prefixed || size <= kBreakpointChunkSize) {
+        continue;
+      }
+    }
+
+    // The breakpoints before a large one or a log record are written
+    // before it, so that the breakpoints stay in order.
+    HRESULT hr;
+    if (i > first) {
+      hr = WriteBreakpointsInOneWrite(breakpoints + first, i - first);
+      if (FAILED(hr)) {
+        return hr;
+      }
+    }
+
+    if (log_record) {
+      // Consecutive log records are written together.
+      size_t end = i + 1;
+      while (end < count && LogRecordEncoder::CanEncode(breakpoints[end])) {
+        ++end;
+      }
+      hr = WriteLogRecords(breakpoints + i, end - i);
+      i = end - 1;
+    } else {
+      hr = WriteChunkedBreakpoint(breakpoints[i]);
+    }
+    if (FAILED(hr)) {
+      return hr;
+    }
+    first = i + 1;
+  }
+
+  if (first == count && count > 0) {
+    return S_OK;
+  }
+  return WriteBreakpointsInOneWrite(breakpoints + first, count - first);
+}
+
+HRESULT BreakpointClient::WriteBreakpointsInOneWrite(
+    const Breakpoint *breakpoints, size_t count) {
+  bool length_prefixed = framing_ == MessageFraming::kLengthPrefixed;
+  size_t total_size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    total_size += breakpoints[i].GetCachedSize();
+  }
+
+  // Serializes into the pooled buffer and sends the framing around the
+  // messages as separate buffers, so no message is copied to insert them.
+  // Frame headers are small enough to be serialized into the pooled
+  // buffer in front of their messages.
+  if (length_prefixed) {
+    total_size += count * kFrameHeaderSize;
+  }
+  write_buffer_.resize(total_size);
+  write_buffers_.clear();
+
+  uint8_t *buffer_start = reinterpret_cast<uint8_t *>(&write_buffer_[0]);
+  uint8_t *target = buffer_start;
+  for (size_t i = 0; i < count; ++i) {
+    // WriteBreakpoints cached the sizes.
+    size_t size = breakpoints[i].GetCachedSize();
+    const char *start = reinterpret_cast<const char *>(target);
+    if (length_prefixed) {
+      uint8_t *header = target;
+      uint8_t version = kFrameVersion;
+      target += kFrameHeaderSize;
+      if (compress_ && size >= kMinimumCompressedBreakpointSize) {
+        // A compressed breakpoint is smaller than the space reserved
+        // for it, so it still fits in place.
+        compress_buffer_.resize(size);
+        breakpoints[i].SerializeWithCachedSizesToArray(
+            reinterpret_cast<uint8_t *>(&compress_buffer_[0]));
+        size_t compressed_size = 0;
+        if (compressor_.Compress(compress_buffer_.data(), size, target,
+                                 &compressed_size)) {
+          version |= kFrameCompressedFlag;
+          size = compressed_size;
+        } else {
+          memcpy(target, compress_buffer_.data(), size);
+        }
+        target += size;
+      } else {
+        target = breakpoints[i].SerializeWithCachedSizesToArray(target);
+      }
+
+      WriteFrameHeader(version, size, header);
+      continue;
+    }
+
+    target = breakpoints[i].SerializeWithCachedSizesToArray(target);
+    write_buffers_.push_back(
+        {kStartBreakpointMessage.data(), kStartBreakpointMessage.size()});
+    write_buffers_.push_back({start, size});
+    write_buffers_.push_back(
+        {kEndBreakpointMessage.data(), kEndBreakpointMessage.size()});
+  }
+
+  if (length_prefixed) {
+    write_buffers_.push_back(
+        {write_buffer_.data(), static_cast<size_t>(target - buffer_start)});
+  }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HRESULT hr =
+      pipe_->WriteBuffers(write_buffers_.data(), write_buffers_.size());
+  metrics.pipe_write_time_us.RecordSince(start);
+  if (SUCCEEDED(hr)) {
+    size_t written_size = 0;
+    for (const auto &write_buffer : write_buffers_) {
+      written_size += write_buffer.size;
+    }
+    metrics.pipe_messages_written.Increment(count);
+    metrics.pipe_bytes_written.Increment(written_size);
+  }
+
+  // Does not keep the memory of an unusually large snapshot around.
+  if (write_buffer_.capacity() > kMaximumPooledWriteBufferSize) {
+    string().swap(write_buffer_);
+  }
+  if (compress_buffer_.capacity() > kMaximumPooledWriteBufferSize) {
+    string().swap(compress_buffer_);
+  }
+  return hr;
+}
+
+HRESULT BreakpointClient::WriteChunkedBreakpoint(const Breakpoint &breakpoint) {
+  Breakpoint header;
+  CopyBreakpointHeader(breakpoint, &header);
+  chunk_buffer_.resize(header.ByteSizeLong());
+  header.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t *>(&chunk_buffer_[0]));
+  HRESULT hr = WriteChunk(kFrameChunkFlag);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // Stack frames and evaluated expressions are never split, so a chunk
+  // is larger than kBreakpointChunkSize by at most one of them.
+  chunk_buffer_.clear();
+  for (const StackFrame &stack_frame : breakpoint.stack_frames()) {
+    if (chunk_buffer_.size() >= kBreakpointChunkSize) {
+      hr = WriteChunk(kFrameChunkFlag);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      chunk_buffer_.clear();
+    }
+    AppendField(Breakpoint::kStackFramesFieldNumber, stack_frame,
+                &chunk_buffer_);
+  }
+
+  // Evaluated expressions are encoded in one pass, as their sizes are
+  // only needed to fill in their lengths.
+  VariableEncoder encoder(&chunk_buffer_);
+  for (const Variable &expression : breakpoint.evaluated_expressions()) {
+    if (encoder.GetSize() >= kBreakpointChunkSize) {
+      hr = WriteChunk(kFrameChunkFlag);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      chunk_buffer_.clear();
+    }
+    encoder.AppendVariable(Breakpoint::kEvaluatedExpressionsFieldNumber,
+                           expression);
+  }
+
+  hr = WriteChunk(0);
+  if (SUCCEEDED(hr)) {
+    DebuggerMetrics::Global().pipe_messages_written.Increment();
+  }
+
+  if (chunk_buffer_.capacity() > kMaximumPooledWriteBufferSize) {
+    string().swap(chunk_buffer_);
+  }
+  if (write_buffer_.capacity() > kMaximumPooledWriteBufferSize) {
+    string().swap(write_buffer_);
+  }
+  return hr;
+}
+
+HRESULT BreakpointClient::WriteLogRecords(const Breakpoint *breakpoints,
+                                          size_t count) {
+  // The hits were queued moments ago, so the time they are written at
+  // stands in for the time they happened at.
+  std::uint64_t timestamp_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  uint8_t version = kFrameVersion | kFrameLogRecordsFlag;
+
+  write_buffer_.clear();
+  size_t frame_start = 0;
+  write_buffer_.resize(kFrameHeaderSize);
+  for (size_t i = 0; i < count; ++i) {
+    if (write_buffer_.size() - frame_start >
+        kFrameHeaderSize + kBreakpointChunkSize) {
+      if (!FinishFrame(version, frame_start, &write_buffer_)) {
+        return E_FAIL;
+      }
+      frame_start = write_buffer_.size();
+      write_buffer_.resize(frame_start + kFrameHeaderSize);
+    }
+    log_record_encoder_.Append(breakpoints[i], timestamp_us, &write_buffer_);
+  }
+  if (!FinishFrame(version, frame_start, &write_buffer_)) {
     return E_FAIL;
   }
-  bp_str.insert(0, kStartBreakpointMessage);
-  bp_str.append(kEndBreakpointMessage);
-  return pipe_->Write(bp_str);
+
+  PipeBuffer frames = {write_buffer_.data(), write_buffer_.size()};
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HRESULT hr = pipe_->WriteBuffers(&frames, 1);
+  metrics.pipe_write_time_us.RecordSince(start);
+  if (SUCCEEDED(hr)) {
+    metrics.pipe_messages_written.Increment(count);
+    metrics.pipe_bytes_written.Increment(frames.size);
+  }
+
+  if (write_buffer_.capacity() > kMaximumPooledWriteBufferSize) {
+    string().swap(write_buffer_);
+  }
+  return hr;
+}
+
+HRESULT BreakpointClient::WriteChunk(uint8_t flags) {
+  size_t size = chunk_buffer_.size();
+  if (size > kMaximumFrameSize) {
+    cerr << "breakpoint chunk is too large to be sent: " << size << std::endl;
+    return E_FAIL;
+  }
+
+  write_buffer_.resize(kFrameHeaderSize + size);
+  uint8_t *header = reinterpret_cast<uint8_t *>(&write_buffer_[0]);
+  uint8_t *target = header + kFrameHeaderSize;
+  uint8_t version = kFrameVersion | flags;
+  size_t compressed_size = 0;
+  if (compress_ && size >= kMinimumCompressedBreakpointSize &&
+      compressor_.Compress(chunk_buffer_.data(), size, target,
+                           &compressed_size)) {
+    version |= kFrameCompressedFlag;
+    size = compressed_size;
+  } else {
+    memcpy(target, chunk_buffer_.data(), size);
+  }
+  WriteFrameHeader(version, size, header);
+
+  PipeBuffer frame = {write_buffer_.data(), kFrameHeaderSize + size};
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HRESULT hr = pipe_->WriteBuffers(&frame, 1);
+  metrics.pipe_write_time_us.RecordSince(start);
+  if (SUCCEEDED(hr)) {
+    metrics.pipe_bytes_written.Increment(frame.size);
+  }
+  return hr;
 }
 
 HRESULT BreakpointClient::ShutDown() {
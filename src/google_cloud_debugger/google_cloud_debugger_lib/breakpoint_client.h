@@ -20,17 +20,22 @@
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <vector>
 
+#include "breakpoint_compressor.h"
 #include "dbg_breakpoint.h"
 #include "constants.h"
 #include "i_named_pipe.h"
+#include "log_record_encoder.h"
 
 namespace google_cloud_debugger {
 
 class BreakpointClient {
  public:
   // Creates a breakpoint client and accepts a NamedPipeClient.
-  BreakpointClient(std::unique_ptr<INamedPipe> pipe);
+  // framing has to match the framing used by the breakpoint server.
+  BreakpointClient(std::unique_ptr<INamedPipe> pipe,
+                   MessageFraming framing = MessageFraming::kMarkers);
 
   // Initializes the client and returns an HRESULT.
   HRESULT Initialize();
@@ -51,18 +56,100 @@ class BreakpointClient {
   HRESULT WriteBreakpoint(
       const google::cloud::diagnostics::debug::Breakpoint &breakpoint);
 
+  // Writes count breakpoints to a breakpoint server in a single
+  // pipe write and returns an HRESULT.
+  HRESULT WriteBreakpoints(
+      const google::cloud::diagnostics::debug::Breakpoint *breakpoints,
+      size_t count);
+
+  // Sets whether breakpoints of at least kMinimumCompressedBreakpointSize
+  // bytes are written compressed. Only applies to length-prefixed framing.
+  void SetCompressBreakpoints(bool compress) { compress_ = compress; }
+
+  // Sets whether hits of log points that LogRecordEncoder can encode are
+  // written as batches of log records instead of as breakpoints. Only
+  // applies to length-prefixed framing.
+  void SetLogRecords(bool log_records) { log_records_ = log_records; }
+
   // Shuts down the pipe.
   HRESULT ShutDown();
 
  private:
+  // Reads a breakpoint surrounded by kStartBreakpointMessage and
+  // kEndBreakpointMessage.
+  HRESULT ReadMarkedBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+  // Reads a frame header and then exactly the number of bytes
+  // in it, and parses the breakpoint from them.
+  HRESULT ReadLengthPrefixedBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+  // Writes count breakpoints, whose sizes ByteSizeLong cached, in a
+  // single pipe write. Must be called with write_mutex_ held.
+  HRESULT WriteBreakpointsInOneWrite(
+      const google::cloud::diagnostics::debug::Breakpoint *breakpoints,
+      size_t count);
+
+  // Writes breakpoint, whose size ByteSizeLong cached, as frames of at
+  // most about kBreakpointChunkSize bytes with kFrameChunkFlag set in all
+  // but the last. Must be called with write_mutex_ held.
+  HRESULT WriteChunkedBreakpoint(
+      const google::cloud::diagnostics::debug::Breakpoint &breakpoint);
+
+  // Writes count hits of log points, which LogRecordEncoder can encode,
+  // as frames with kFrameLogRecordsFlag of about kBreakpointChunkSize
+  // bytes at most, in a single pipe write. Must be called with
+  // write_mutex_ held.
+  HRESULT WriteLogRecords(
+      const google::cloud::diagnostics::debug::Breakpoint *breakpoints,
+      size_t count);
+
+  // Writes chunk_buffer_ as a length-prefixed frame whose version has
+  // flags set, compressing it if compress_ is set.
+  HRESULT WriteChunk(std::uint8_t flags);
+
   // The pipe client to send messages.
   std::unique_ptr<INamedPipe> pipe_;
 
-  // A buffer to hold partial breakpoint messages.
+  // How messages are delimited on the pipe.
+  MessageFraming framing_;
+
+  // A buffer to hold partial breakpoint messages. With length-prefixed
+  // framing, holds the last message read so that its memory is reused.
   std::string buffer_;
 
   // Mutex to protect the buffer.
   std::mutex mutex_;
+
+  // Buffer that breakpoints are serialized into before they are written.
+  // It is reused across writes to avoid an allocation per breakpoint.
+  std::string write_buffer_;
+
+  // The buffers of the current write, reused across writes.
+  std::vector<PipeBuffer> write_buffers_;
+
+  // Mutex to protect write_buffer_, write_buffers_, compress_buffer_,
+  // chunk_buffer_, compressor_ and log_record_encoder_.
+  std::mutex write_mutex_;
+
+  // True if large breakpoints are written compressed.
+  bool compress_ = false;
+
+  // Buffer that a breakpoint is serialized into before it is compressed.
+  std::string compress_buffer_;
+
+  // Buffer that the chunks of a large breakpoint are serialized into.
+  std::string chunk_buffer_;
+
+  // Compresses large breakpoints.
+  BreakpointCompressor compressor_;
+
+  // True if hits of log points are written as log records.
+  bool log_records_ = false;
+
+  // Encodes the hits of log points written as log records.
+  LogRecordEncoder log_record_encoder_;
 };
 
 }  // namespace google_cloud_debugger
@@ -17,16 +17,37 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <thread>
+#include <unordered_set>
 
 #include "breakpoint_location_collection.h"
+#include "cpu_sampler.h"
 #include "dbg_object.h"
+#include "cor_debug_helper.h"
 #include "debugger_callback.h"
+#include "document_path_index.h"
 #include "i_eval_coordinator.h"
+#include "i_portable_pdb_file.h"
+#include "memory_usage.h"
+#include "metrics.h"
 #include "named_pipe_client.h"
+#include "overhead_governor.h"
+#include "portable_pdb_file.h"
+#include "shared_memory_pipe_unix.h"
+#include "snapshot_delta.h"
+#include "snapshot_recorder.h"
+#include "snapshot_string_table.h"
+#include "thread_pool.h"
+#include "thread_scheduling.h"
 
 using google::cloud::diagnostics::debug::Breakpoint;
 using google::cloud::diagnostics::debug::SourceLocation;
+using google_cloud_debugger_portable_pdb::DocumentPathIndex;
+using google_cloud_debugger_portable_pdb::IPortablePdbFile;
+using google_cloud_debugger_portable_pdb::PortablePdbFile;
+using google_cloud_debugger_portable_pdb::SequencePointLocation;
 using std::cerr;
 using std::cout;
 using std::string;
@@ -35,6 +56,23 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+namespace {
+
+// Returns the memory used by breakpoint and its entry in a map of synced
+// breakpoints. The serialized size of the breakpoint stands in for the
+// size of its fields.
+size_t GetSyncedBreakpointMemoryUsage(const Breakpoint &breakpoint) {
+  return GetHashNodeMemoryUsage<std::unordered_map<string, Breakpoint>>() +
+         GetMemoryUsage(breakpoint.id()) + breakpoint.ByteSizeLong();
+}
+
+}  // namespace
+
+BreakpointCollection::~BreakpointCollection() {
+  activation_queue_.Stop();
+  StopReportingMetrics();
+}
+
 HRESULT BreakpointCollection::SetDebuggerCallback(
     DebuggerCallback *debugger_callback) {
   if (!debugger_callback) {
@@ -46,231 +84,1600 @@ HRESULT BreakpointCollection::SetDebuggerCallback(
   return S_OK;
 }
 
+HRESULT BreakpointCollection::ConnectBreakpointClient(
+    std::shared_ptr<BreakpointClient> *client) {
+  if (!debugger_callback_->GetDuplexPipe()) {
+    return CreateAndInitializeBreakpointClient(
+        client, debugger_callback_->GetPipeName(),
+        debugger_callback_->GetMessageFraming(),
+        debugger_callback_->GetCompressBreakpoints(), false);
+  }
+
+  // Reads and writes share one connection. Whichever needs it first
+  // connects it.
+  std::lock_guard<std::mutex> lock(duplex_client_mutex_);
+  if (!duplex_client_) {
+    HRESULT hr = CreateAndInitializeBreakpointClient(
+        &duplex_client_, debugger_callback_->GetPipeName(),
+        debugger_callback_->GetMessageFraming(),
+        debugger_callback_->GetCompressBreakpoints(),
+        debugger_callback_->GetSharedMemoryPipe());
+    if (FAILED(hr)) {
+      return hr;
+    }
+  }
+
+  *client = duplex_client_;
+  return S_OK;
+}
+
 HRESULT BreakpointCollection::CreateAndInitializeBreakpointClient(
-    unique_ptr<BreakpointClient> *client, std::string pipe_name) {
+    std::shared_ptr<BreakpointClient> *client, std::string pipe_name,
+    MessageFraming framing, bool compress_breakpoints, bool shared_memory) {
   if (client == nullptr) {
     return E_INVALIDARG;
   }
 
-  unique_ptr<NamedPipeClient> pipe(new (std::nothrow)
-                                       NamedPipeClient(pipe_name));
-  if (!pipe) {
-    cerr << "Cannot create named pipe client.";
-    return E_OUTOFMEMORY;
+  unique_ptr<INamedPipe> pipe(new (std::nothrow) NamedPipeClient(pipe_name));
+  if (!pipe) {
+    cerr << "Cannot create named pipe client.";
+    return E_OUTOFMEMORY;
+  }
+
+  if (shared_memory) {
+#ifdef PLATFORM_UNIX
+    // The named pipe only connects and wakes up the readers.
+    pipe.reset(new (std::nothrow) SharedMemoryPipe(
+        std::move(pipe), string(kSharedMemoryPathPrefix) + pipe_name));
+    if (!pipe) {
+      cerr << "Cannot create shared memory pipe.";
+      return E_OUTOFMEMORY;
+    }
+#else
+    cerr << "Shared memory pipes are not supported on this platform.";
+    return E_NOTIMPL;
+#endif
+  }
+
+  std::shared_ptr<BreakpointClient> result(
+      new (std::nothrow) BreakpointClient(std::move(pipe), framing));
+  if (!result) {
+    cerr << "Cannot create breakpoint client.";
+    return E_OUTOFMEMORY;
+  }
+  result->SetCompressBreakpoints(compress_breakpoints);
+
+  HRESULT hr = result->Initialize();
+  if (FAILED(hr)) {
+    cerr << "Failed to initialize breakpoint client.";
+    return hr;
+  }
+
+  hr = result->WaitForConnection();
+  if (FAILED(hr)) {
+    cerr << "Failed to connect with client.";
+    return hr;
+  }
+
+  (*client) = std::move(result);
+
+  return S_OK;
+}
+
+HRESULT BreakpointCollection::WriteBreakpoint(const Breakpoint &breakpoint) {
+  BreakpointWriter *writer;
+  HRESULT hr = GetBreakpointWriter(&writer);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  return ReportDroppedBreakpoints(writer, writer->Enqueue(breakpoint));
+}
+
+HRESULT BreakpointCollection::WriteAndClearBreakpoint(Breakpoint *breakpoint) {
+  BreakpointWriter *writer;
+  HRESULT hr = GetBreakpointWriter(&writer);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  return ReportDroppedBreakpoints(writer, writer->EnqueueSwapped(breakpoint));
+}
+
+HRESULT BreakpointCollection::GetBreakpointWriter(BreakpointWriter **writer) {
+  std::lock_guard<std::mutex> lock(writer_mutex_);
+  if (!breakpoint_writer_) {
+    BreakpointWriter::WriteFunction write;
+    if (debugger_callback_->GetLocalBreakpoints()) {
+      // Without an agent, the breakpoints are serialized as they would
+      // be for the agent and dropped.
+      string message;
+      write = [message](const vector<Breakpoint> &breakpoints) mutable {
+        DebuggerMetrics &metrics = DebuggerMetrics::Global();
+        for (const Breakpoint &breakpoint : breakpoints) {
+          if (!breakpoint.SerializeToString(&message)) {
+            return E_FAIL;
+          }
+          metrics.pipe_messages_written.Increment();
+          metrics.pipe_bytes_written.Increment(message.size());
+        }
+        return S_OK;
+      };
+    } else {
+      HRESULT hr = ConnectBreakpointClient(&breakpoint_client_write_);
+      if (FAILED(hr)) {
+        cerr << "Failed to initialize breakpoint client for writing "
+                "breakpoints.";
+        return hr;
+      }
+
+      BreakpointClient *client = breakpoint_client_write_.get();
+      client->SetLogRecords(debugger_callback_->GetLogRecords());
+      write = [client](const vector<Breakpoint> &breakpoints) {
+        return client->WriteBreakpoints(breakpoints.data(),
+                                        breakpoints.size());
+      };
+    }
+
+    if (debugger_callback_->GetStringTable()) {
+      SnapshotStringTable string_table;
+      write = [write, string_table](
+                  vector<Breakpoint> &breakpoints) mutable {
+        for (Breakpoint &breakpoint : breakpoints) {
+          string_table.Encode(&breakpoint);
+        }
+        return write(breakpoints);
+      };
+    }
+
+    // Deltas are computed before the string table replaces the names
+    // and types, and the agent reads them back after it.
+    if (debugger_callback_->GetDeltaSnapshots()) {
+      SnapshotDelta delta;
+      write = [write, delta](vector<Breakpoint> &breakpoints) mutable {
+        for (Breakpoint &breakpoint : breakpoints) {
+          delta.Encode(&breakpoint);
+        }
+        return write(breakpoints);
+      };
+    }
+
+    // Snapshots are recorded as they are captured, before the deltas
+    // and the string table.
+    const string &record_file = debugger_callback_->GetSnapshotRecordFile();
+    if (!record_file.empty()) {
+      std::shared_ptr<SnapshotRecorder> recorder(
+          new (std::nothrow) SnapshotRecorder());
+      if (!recorder || !recorder->Open(record_file)) {
+        cerr << "Cannot open the snapshot record file " << record_file;
+      } else {
+        write = [write, recorder](vector<Breakpoint> &breakpoints) mutable {
+          for (const Breakpoint &breakpoint : breakpoints) {
+            recorder->Record(breakpoint);
+          }
+          return write(breakpoints);
+        };
+      }
+    }
+
+    breakpoint_writer_.reset(new (std::nothrow) BreakpointWriter(
+        std::move(write), kBreakpointWriteQueueCapacity,
+        debugger_callback_->GetBreakpointWriteOverflow()));
+    if (!breakpoint_writer_) {
+      cerr << "Cannot create breakpoint writer.";
+      return E_OUTOFMEMORY;
+    }
+
+    const string &spill_file = debugger_callback_->GetSpillFile();
+    if (!spill_file.empty() &&
+        !breakpoint_writer_->SetSpillFile(spill_file, kMaximumSpillFileBytes)) {
+      cerr << "Cannot create the spill file " << spill_file;
+    }
+  }
+  *writer = breakpoint_writer_.get();
+  return S_OK;
+}
+
+HRESULT BreakpointCollection::ReportDroppedBreakpoints(BreakpointWriter *writer,
+                                                       HRESULT enqueue_hr) {
+  if (enqueue_hr == S_FALSE) {
+    // Reports the drops every kBreakpointWriteQueueCapacity drops
+    // so that a hot log point does not flood the output.
+    uint64_t dropped = writer->GetDroppedCount();
+    if (dropped % kBreakpointWriteQueueCapacity == 1) {
+      cerr << "Dropped " << dropped
+           << " log point messages because the agent is not reading "
+              "them fast enough."
+           << std::endl;
+    }
+  }
+  return enqueue_hr;
+}
+
+HRESULT BreakpointCollection::ReadBreakpoint(Breakpoint *breakpoint) {
+  std::shared_ptr<const vector<Breakpoint>> local_breakpoints =
+      debugger_callback_ ? debugger_callback_->GetLocalBreakpoints()
+                         : nullptr;
+  if (local_breakpoints) {
+    if (next_local_breakpoint_ < local_breakpoints->size()) {
+      *breakpoint = (*local_breakpoints)[next_local_breakpoint_++];
+      return S_OK;
+    }
+
+    std::unique_lock<std::mutex> lock(local_breakpoints_mutex_);
+    local_breakpoints_cv_.wait(
+        lock, [this]() { return local_breakpoints_cancelled_; });
+    breakpoint->Clear();
+    breakpoint->set_kill_server(true);
+    return S_OK;
+  }
+
+  if (!breakpoint_client_read_) {
+    HRESULT hr = ConnectBreakpointClient(&breakpoint_client_read_);
+    if (FAILED(hr)) {
+      cerr << "Failed to initialize breakpoint client for reading breakpoints.";
+      return hr;
+    }
+  }
+
+  return breakpoint_client_read_->ReadBreakpoint(breakpoint);
+}
+
+HRESULT BreakpointCollection::EvaluateAndPrintBreakpoint(
+    CORDB_ADDRESS module_base_address, mdMethodDef function_token,
+    ULONG32 il_offset, IEvalCoordinator *eval_coordinator,
+    ICorDebugThread *debug_thread,
+    std::shared_ptr<const ModuleSnapshot> modules) {
+  std::vector<std::shared_ptr<DbgBreakpoint>> matched_breakpoints;
+
+  {
+    // This does not block on UpdateBreakpoint since the table
+    // is never modified once published.
+    std::shared_ptr<const BreakpointTable> table = GetBreakpointTable();
+
+    // Since the breakpoints are grouped by location, if
+    // one matches, all of them do.
+    BreakpointLocationKey key = {module_base_address, function_token,
+                                 il_offset};
+    const auto &location = table->location_index.find(key);
+    if (location == table->location_index.end()) {
+      cerr << "No breakpoint found at IL offset " << il_offset
+           << " of method " << function_token << " (searched "
+           << table->location_index.size() << " indexed locations).";
+      return S_FALSE;
+    }
+
+    matched_breakpoints = location->second->GetBreakpoints();
+  }
+
+  return ProcessMatchedBreakpoints(std::move(matched_breakpoints),
+                                   eval_coordinator, debug_thread,
+                                   std::move(modules));
+}
+
+HRESULT BreakpointCollection::EvaluateExceptionPoints(
+    IEvalCoordinator *eval_coordinator, ICorDebugThread *debug_thread,
+    std::shared_ptr<const ModuleSnapshot> modules) {
+  std::shared_ptr<ExceptionPointFilter> filter =
+      std::atomic_load(&exception_point_filter_);
+  if (!filter) {
+    return S_FALSE;
+  }
+
+  CorDebugHelper debug_helper;
+  CORDB_ADDRESS module_base_address = 0;
+  mdTypeDef class_token = 0;
+  CComPtr<IMetaDataImport> metadata_import;
+  HRESULT hr = GetExceptionClass(debug_thread, &debug_helper,
+                                 &module_base_address, &class_token,
+                                 &metadata_import);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // Only the exceptions of the classes that exception points want get
+  // past the cache of the filter.
+  std::vector<std::shared_ptr<DbgBreakpoint>> matched_breakpoints;
+  hr = filter->Match(
+      module_base_address, class_token,
+      [&](string *class_name) -> HRESULT {
+        mdToken base_token;
+        return debug_helper.GetTypeNameFromMdTypeDef(
+            class_token, metadata_import, class_name, &base_token, &cerr);
+      },
+      [&](string *module_name) -> HRESULT {
+        CComPtr<ICorDebugFrame> frame;
+        HRESULT frame_hr = debug_thread->GetActiveFrame(&frame);
+        if (FAILED(frame_hr) || !frame) {
+          return FAILED(frame_hr) ? frame_hr : E_FAIL;
+        }
+
+        CComPtr<ICorDebugModule> debug_module;
+        frame_hr = debug_helper.GetICorDebugModuleFromICorDebugFrame(
+            frame, &debug_module, &cerr);
+        if (FAILED(frame_hr)) {
+          return frame_hr;
+        }
+
+        CORDB_ADDRESS throw_base_address = 0;
+        frame_hr = debug_module->GetBaseAddress(&throw_base_address);
+        if (FAILED(frame_hr)) {
+          return frame_hr;
+        }
+
+        // Modules without a PDB have no name here and match no module.
+        module_name->clear();
+        std::shared_ptr<IPortablePdbFile> pdb_file =
+            modules->FindByBaseAddress(throw_base_address);
+        if (pdb_file) {
+          *module_name = pdb_file->GetModuleName();
+        }
+        return S_OK;
+      },
+      &matched_breakpoints);
+  if (FAILED(hr)) {
+    cerr << "Failed to match the exception with exception points.";
+    return hr;
+  }
+
+  if (matched_breakpoints.empty()) {
+    return S_FALSE;
+  }
+
+  DebuggerMetrics::Global().exception_point_hits.Increment();
+  return ProcessMatchedBreakpoints(std::move(matched_breakpoints),
+                                   eval_coordinator, debug_thread,
+                                   std::move(modules));
+}
+
+HRESULT BreakpointCollection::GetExceptionClass(
+    ICorDebugThread *debug_thread, ICorDebugHelper *debug_helper,
+    CORDB_ADDRESS *module_base_address, mdTypeDef *class_token,
+    IMetaDataImport **metadata_import) {
+  CComPtr<ICorDebugValue> exception;
+  HRESULT hr = debug_thread->GetCurrentException(&exception);
+  if (FAILED(hr) || !exception) {
+    cerr << "Failed to get the current exception.";
+    return FAILED(hr) ? hr : E_FAIL;
+  }
+
+  CComPtr<ICorDebugValue> dereferenced_exception;
+  BOOL is_null = FALSE;
+  hr = debug_helper->Dereference(exception, &dereferenced_exception,
+                                 &is_null, &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (is_null) {
+    return E_FAIL;
+  }
+
+  CComPtr<ICorDebugObjectValue> object_value;
+  hr = dereferenced_exception->QueryInterface(
+      __uuidof(ICorDebugObjectValue),
+      reinterpret_cast<void **>(&object_value));
+  if (FAILED(hr)) {
+    cerr << "Failed to get the exception object.";
+    return hr;
+  }
+
+  CComPtr<ICorDebugClass> debug_class;
+  hr = object_value->GetClass(&debug_class);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the class of the exception.";
+    return hr;
+  }
+
+  hr = debug_class->GetToken(class_token);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the token of the exception class.";
+    return hr;
+  }
+
+  CComPtr<ICorDebugModule> debug_module;
+  hr = debug_class->GetModule(&debug_module);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the module of the exception class.";
+    return hr;
+  }
+
+  hr = debug_module->GetBaseAddress(module_base_address);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the base address of the module.";
+    return hr;
+  }
+
+  return debug_helper->GetMetadataImportFromICorDebugModule(
+      debug_module, metadata_import, &cerr);
+}
+
+HRESULT BreakpointCollection::ProcessMatchedBreakpoints(
+    std::vector<std::shared_ptr<DbgBreakpoint>> matched_breakpoints,
+    IEvalCoordinator *eval_coordinator, ICorDebugThread *debug_thread,
+    std::shared_ptr<const ModuleSnapshot> modules) {
+  HRESULT hr = S_FALSE;
+  std::vector<std::shared_ptr<DbgBreakpoint>> limited_breakpoints;
+  SkipFinishedBreakpoints(&matched_breakpoints, &limited_breakpoints);
+  SkipUnsampledHits(&matched_breakpoints);
+  OverheadGovernor::Global().Update(std::chrono::steady_clock::now());
+  bool has_log_point = false;
+  SkipRateLimitedHits(&matched_breakpoints, &has_log_point);
+  PrefilterConditions(debug_thread, &matched_breakpoints);
+  std::vector<std::shared_ptr<DbgBreakpoint>> capturing_breakpoints;
+  SkipConcurrentCaptures(&matched_breakpoints, &capturing_breakpoints);
+  if (matched_breakpoints.empty()) {
+    DeactivateFinishedBreakpoints(limited_breakpoints);
+    return S_FALSE;
+  }
+  has_log_point = std::any_of(
+      matched_breakpoints.begin(), matched_breakpoints.end(),
+      [](const std::shared_ptr<DbgBreakpoint> &breakpoint) {
+        return breakpoint->IsLogPoint();
+      });
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  hr = eval_coordinator->ProcessBreakpoints(
+      debug_thread, this, std::move(matched_breakpoints), std::move(modules));
+  if (FAILED(hr)) {
+    cerr << "Failed to get stack frame's information.";
+  }
+  for (const auto &breakpoint : capturing_breakpoints) {
+    breakpoint->EndCapture();
+  }
+
+  // The cost of log points is how long they keep the debuggee stopped.
+  if (has_log_point) {
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    log_point_cost_limiter_.ConsumeTokens(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count(),
+        end);
+  }
+
+  DeactivateFinishedBreakpoints(limited_breakpoints);
+  return hr;
+}
+
+void BreakpointCollection::SkipUnsampledHits(
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints) {
+  auto skipped = std::remove_if(
+      breakpoints->begin(), breakpoints->end(),
+      [](const std::shared_ptr<DbgBreakpoint> &breakpoint) {
+        return breakpoint->IsSampled() && !breakpoint->SampleHit();
+      });
+  breakpoints->erase(skipped, breakpoints->end());
+}
+
+void BreakpointCollection::SkipConcurrentCaptures(
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints,
+    std::vector<std::shared_ptr<DbgBreakpoint>> *capturing_breakpoints) {
+  auto skipped = std::remove_if(
+      breakpoints->begin(), breakpoints->end(),
+      [&](const std::shared_ptr<DbgBreakpoint> &breakpoint) {
+        if (!breakpoint->HasSingleCapture()) {
+          return false;
+        }
+        if (!breakpoint->BeginCapture()) {
+          return true;
+        }
+        capturing_breakpoints->push_back(breakpoint);
+        return false;
+      });
+  breakpoints->erase(skipped, breakpoints->end());
+}
+
+void BreakpointCollection::SkipFinishedBreakpoints(
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints,
+    std::vector<std::shared_ptr<DbgBreakpoint>> *limited_breakpoints) {
+  // The clock is only read if a breakpoint has a hit limit or expires.
+  std::chrono::system_clock::time_point now;
+  bool now_read = false;
+  auto finished = std::remove_if(
+      breakpoints->begin(), breakpoints->end(),
+      [&](const std::shared_ptr<DbgBreakpoint> &breakpoint) {
+        if (!breakpoint->HasHitLimitOrExpiry()) {
+          return false;
+        }
+
+        if (!now_read) {
+          now_read = true;
+          now = std::chrono::system_clock::now();
+        }
+        limited_breakpoints->push_back(breakpoint);
+        return breakpoint->IsFinished(now);
+      });
+  breakpoints->erase(finished, breakpoints->end());
+}
+
+void BreakpointCollection::DeactivateFinishedBreakpoints(
+    const std::vector<std::shared_ptr<DbgBreakpoint>> &limited_breakpoints) {
+  if (limited_breakpoints.empty()) {
+    return;
+  }
+
+  std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+  for (const auto &breakpoint : limited_breakpoints) {
+    if (!breakpoint->IsFinished(now)) {
+      continue;
+    }
+
+    // The breakpoint is deactivated as if the agent had, which also
+    // deactivates the ICorDebugBreakpoint if no other breakpoint is left
+    // at the location. Hits on other threads may deactivate it as well,
+    // which does nothing once it is removed.
+    DbgBreakpoint deactivated;
+    deactivated.Initialize(*breakpoint);
+    deactivated.SetActivated(false);
+    HRESULT hr = UpdateBreakpoint(deactivated);
+    if (FAILED(hr)) {
+      cerr << "Failed to deactivate finished breakpoint "
+           << breakpoint->GetId() << std::endl;
+    }
+  }
+}
+
+void BreakpointCollection::PrefilterConditions(
+    ICorDebugThread *debug_thread,
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints) {
+  // The active frame is only read if a breakpoint has a condition.
+  CComPtr<ICorDebugILFrame> il_frame;
+  bool frame_read = false;
+  auto rejected = std::remove_if(
+      breakpoints->begin(), breakpoints->end(),
+      [&](const std::shared_ptr<DbgBreakpoint> &breakpoint) {
+        if (breakpoint->GetCondition().empty()) {
+          return false;
+        }
+
+        if (!frame_read) {
+          frame_read = true;
+          CComPtr<ICorDebugFrame> frame;
+          if (debug_thread &&
+              SUCCEEDED(debug_thread->GetActiveFrame(&frame)) && frame) {
+            frame->QueryInterface(__uuidof(ICorDebugILFrame),
+                                  reinterpret_cast<void **>(&il_frame));
+          }
+        }
+
+        bool condition = true;
+        if (breakpoint->PrefilterCondition(il_frame, &condition) != S_OK ||
+            condition) {
+          return false;
+        }
+
+        DebuggerMetrics::Global().conditions_prefiltered.Increment();
+        return true;
+      });
+  breakpoints->erase(rejected, breakpoints->end());
+}
+
+void BreakpointCollection::SkipRateLimitedHits(
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints,
+    bool *has_log_point) {
+  bool log_points_paused = !log_point_cost_limiter_.HasTokens();
+  OverheadGovernor &governor = OverheadGovernor::Global();
+  bool snapshots_paused =
+      governor.GetLevel() >= OverheadGovernor::kPausedSnapshots;
+  auto skipped = std::remove_if(
+      breakpoints->begin(), breakpoints->end(),
+      [&](const std::shared_ptr<DbgBreakpoint> &breakpoint) {
+        std::string reason;
+        if (breakpoint->IsLogPoint() && log_points_paused) {
+          reason = kLogPointsPausedMessage;
+        } else if (!breakpoint->IsLogPoint() && snapshots_paused) {
+          // The snapshot stays active and is captured again once the
+          // governor restores snapshots.
+          return true;
+        } else if (breakpoint->IsLogPoint() &&
+                   !governor.ShouldProcessLogPoint()) {
+          reason = OverheadGovernor::GetStatusMessage(governor.GetLevel());
+        } else if (!breakpoint->RequestHit()) {
+          reason = kBreakpointHitRateExceededMessage;
+        } else {
+          *has_log_point = *has_log_point || breakpoint->IsLogPoint();
+          return false;
+        }
+
+        // A status would finalize a snapshot, so only log points report
+        // their skipped hits.
+        if (breakpoint->IsLogPoint() && breakpoint->ShouldReportSkippedHits()) {
+          Breakpoint status;
+          if (SUCCEEDED(breakpoint->PopulateErrorStatus(&status, reason))) {
+            WriteBreakpoint(status);
+          }
+        }
+        return true;
+      });
+  breakpoints->erase(skipped, breakpoints->end());
+}
+
+HRESULT BreakpointCollection::ReadAndParseBreakpoints(
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints) {
+  assert(breakpoints != nullptr);
+
+  Breakpoint breakpoint_read;
+  HRESULT hr = ReadBreakpoint(&breakpoint_read);
+  if (FAILED(hr)) {
+    cerr << "Failed to parse breakpoint.";
+    return hr;
+  }
+
+  if (breakpoint_read.id() == kSyncBreakpointsId &&
+      !breakpoint_read.kill_server()) {
+    hr = ParseSyncBreakpoints(&breakpoint_read, breakpoints);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    return breakpoints->empty() ? S_FALSE : S_OK;
+  }
+
+  std::shared_ptr<DbgBreakpoint> breakpoint(new (std::nothrow) DbgBreakpoint);
+  if (!breakpoint) {
+    return E_OUTOFMEMORY;
+  }
+
+  hr = ParseBreakpoint(&breakpoint_read, breakpoint.get());
+  if (hr != S_OK) {
+    return hr;
+  }
+  breakpoints->push_back(std::move(breakpoint));
+  return S_OK;
+}
+
+HRESULT BreakpointCollection::ParseSyncBreakpoints(
+    Breakpoint *sync,
+    std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints) {
+  std::unordered_set<string> active_ids;
+  active_ids.reserve(sync->breakpoints_size());
+  for (Breakpoint &entry : *sync->mutable_breakpoints()) {
+    active_ids.insert(entry.id());
+
+    // Breakpoints the debugger already has are only sent with their ID.
+    if (!entry.has_location()) {
+      if (synced_breakpoints_.find(entry.id()) == synced_breakpoints_.end()) {
+        cerr << "Received a sync for unknown breakpoint " << entry.id()
+             << std::endl;
+      }
+      continue;
+    }
+
+    std::shared_ptr<DbgBreakpoint> breakpoint(new (std::nothrow)
+                                                  DbgBreakpoint);
+    if (!breakpoint) {
+      return E_OUTOFMEMORY;
+    }
+    if (ParseBreakpoint(&entry, breakpoint.get()) == S_OK) {
+      breakpoints->push_back(std::move(breakpoint));
+    }
+  }
+
+  // The IDs are collected first since deactivating a breakpoint erases
+  // it from synced_breakpoints_.
+  vector<string> removed_ids;
+  for (const auto &synced : synced_breakpoints_) {
+    if (active_ids.find(synced.first) == active_ids.end()) {
+      removed_ids.push_back(synced.first);
+    }
+  }
+
+  for (const string &id : removed_ids) {
+    std::shared_ptr<DbgBreakpoint> breakpoint(new (std::nothrow)
+                                                  DbgBreakpoint);
+    if (!breakpoint) {
+      return E_OUTOFMEMORY;
+    }
+
+    Breakpoint delta;
+    delta.set_id(id);
+    delta.set_activated(false);
+    if (ParseBreakpoint(&delta, breakpoint.get()) == S_OK) {
+      breakpoints->push_back(std::move(breakpoint));
+    }
+  }
+  return S_OK;
+}
+
+HRESULT BreakpointCollection::ParseBreakpoint(Breakpoint *breakpoint_read,
+                                              DbgBreakpoint *breakpoint) {
+  assert(breakpoint_read != nullptr);
+  assert(breakpoint != nullptr);
+
+  // A breakpoint without a location is a delta that only carries the id
+  // and the activated flag of a breakpoint sent in full before.
+  if (!breakpoint_read->has_location() && !breakpoint_read->kill_server()) {
+    const auto &synced = synced_breakpoints_.find(breakpoint_read->id());
+    if (synced == synced_breakpoints_.end()) {
+      cerr << "Received a delta for unknown breakpoint "
+           << breakpoint_read->id() << std::endl;
+      return S_FALSE;
+    }
+
+    bool activated = breakpoint_read->activated();
+    *breakpoint_read = synced->second;
+    breakpoint_read->set_activated(activated);
+  }
+
+  // Deactivated breakpoints are only ever activated again in full.
+  const auto &previous = synced_breakpoints_.find(breakpoint_read->id());
+  if (previous != synced_breakpoints_.end()) {
+    synced_breakpoints_memory_.Set(
+        synced_breakpoints_memory_.Get() -
+        GetSyncedBreakpointMemoryUsage(previous->second));
+  }
+  if (breakpoint_read->activated()) {
+    synced_breakpoints_[breakpoint_read->id()] = *breakpoint_read;
+    synced_breakpoints_memory_.Add(
+        GetSyncedBreakpointMemoryUsage(*breakpoint_read));
+  } else {
+    synced_breakpoints_.erase(breakpoint_read->id());
+  }
+
+  SourceLocation location = breakpoint_read->location();
+
+  // For now, we don't have a use for column so we just assign it to 0.
+  breakpoint->Initialize(
+      location.path(), breakpoint_read->id(), location.line(), 0,
+      breakpoint_read->log_point(),
+      breakpoint_read->log_message_format(),
+      breakpoint_read->log_level(),
+      breakpoint_read->condition(),
+      std::vector<std::string>(breakpoint_read->expressions().begin(),
+                               breakpoint_read->expressions().end()));
+  breakpoint->SetActivated(breakpoint_read->activated());
+  breakpoint->SetKillServer(breakpoint_read->kill_server());
+  breakpoint->SetContentHash(location.content_hash());
+  breakpoint->SetHitLimit(breakpoint_read->hit_limit());
+  breakpoint->SetSampling(breakpoint_read->sample_every(),
+                          breakpoint_read->sample_rate());
+  breakpoint->SetStaticExpressionTtl(std::chrono::milliseconds(
+      std::max(breakpoint_read->static_expression_ttl_ms(), 0)));
+  if (breakpoint_read->has_expire_time()) {
+    const google::protobuf::Timestamp &expire_time =
+        breakpoint_read->expire_time();
+    breakpoint->SetExpireTime(
+        std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::seconds(expire_time.seconds()) +
+                std::chrono::nanoseconds(expire_time.nanos()))));
+  }
+  if (debugger_callback_) {
+    breakpoint->SetCaptureLimits(debugger_callback_->GetCaptureLimits());
+    breakpoint->SetCoalesceHits(breakpoint->IsLogPoint() &&
+                                debugger_callback_->GetCoalesceLogPointHits());
+  }
+
+  return S_OK;
+}
+
+HRESULT BreakpointCollection::UpdateBreakpoint(
+    const DbgBreakpoint &breakpoint) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::shared_ptr<const ModuleSnapshot> modules =
+      debugger_callback_->GetModules();
+  HRESULT hr = UpdateBreakpointsHelper({&breakpoint},
+                                       modules->GetBreakpointSearchOrder());
+  RemoveDeactivatedLocations();
+  SaveLocationCache();
+  AccountMemory();
+  return hr;
+}
+
+HRESULT BreakpointCollection::UpdateBreakpoints(
+    const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints) {
+  std::vector<const DbgBreakpoint *> breakpoint_pointers;
+  breakpoint_pointers.reserve(breakpoints.size());
+  for (const auto &breakpoint : breakpoints) {
+    if (breakpoint) {
+      breakpoint_pointers.push_back(breakpoint.get());
+    }
+  }
+
+  // Only one writer at a time. Breakpoint hits read the published
+  // table and are not blocked by this lock.
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::shared_ptr<const ModuleSnapshot> modules =
+      debugger_callback_->GetModules();
+  HRESULT hr = UpdateBreakpointsHelper(breakpoint_pointers,
+                                       modules->GetBreakpointSearchOrder());
+  RemoveDeactivatedLocations();
+  SaveLocationCache();
+  AccountMemory();
+  return hr;
+}
+
+HRESULT BreakpointCollection::UpdatePendingBreakpoints(
+    const std::shared_ptr<IPortablePdbFile> &pdb_file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!pdb_file || pending_breakpoints_.empty()) {
+    return S_OK;
+  }
+
+  if (!pdb_file->ParsePdbFile()) {
+    return E_FAIL;
+  }
+
+  // The pending breakpoints are copied because setting them removes
+  // them from pending_breakpoints_.
+  std::vector<std::shared_ptr<DbgBreakpoint>> matched_breakpoints;
+  std::unordered_set<std::string> matched_keys;
+  for (const auto &document : pdb_file->GetDocumentIndexTable()) {
+    std::string key = GetPendingBreakpointKey(document->GetFilePath());
+    const auto &pending = pending_breakpoints_.find(key);
+    if (pending == pending_breakpoints_.end() ||
+        !matched_keys.insert(key).second) {
+      continue;
+    }
+
+    matched_breakpoints.insert(matched_breakpoints.end(),
+                               pending->second.begin(), pending->second.end());
+  }
+
+  if (matched_breakpoints.empty()) {
+    return S_OK;
+  }
+
+  std::vector<const DbgBreakpoint *> breakpoint_pointers;
+  breakpoint_pointers.reserve(matched_breakpoints.size());
+  for (const auto &breakpoint : matched_breakpoints) {
+    breakpoint_pointers.push_back(breakpoint.get());
+  }
+  HRESULT hr = UpdateBreakpointsHelper(breakpoint_pointers, {pdb_file});
+  SaveLocationCache();
+  AccountMemory();
+  return hr;
+}
+
+HRESULT BreakpointCollection::RemoveModuleBreakpoints(
+    CORDB_ADDRESS module_base_address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::shared_ptr<ExceptionPointFilter> filter =
+      std::atomic_load(&exception_point_filter_);
+  if (filter) {
+    filter->RemoveModule(module_base_address);
+  }
+
+  std::shared_ptr<const BreakpointTable> table = GetBreakpointTable();
+  if (std::none_of(
+          table->location_to_breakpoints.begin(),
+          table->location_to_breakpoints.end(),
+          [module_base_address](
+              const std::pair<const std::string,
+                              std::shared_ptr<BreakpointLocationCollection>>
+                  &location) {
+            return location.second->GetModuleBaseAddress() ==
+                   module_base_address;
+          })) {
+    return S_OK;
+  }
+
+  std::shared_ptr<BreakpointTable> new_table(new (std::nothrow)
+                                                 BreakpointTable(*table));
+  if (!new_table) {
+    return E_OUTOFMEMORY;
+  }
+
+  HRESULT result = S_OK;
+  auto location = new_table->location_to_breakpoints.begin();
+  while (location != new_table->location_to_breakpoints.end()) {
+    const auto &collection = location->second;
+    if (collection->GetModuleBaseAddress() != module_base_address) {
+      ++location;
+      continue;
+    }
+
+    for (const auto &breakpoint : collection->GetBreakpoints()) {
+      if (!breakpoint->Activated()) {
+        continue;
+      }
+
+      HRESULT hr = AddPendingBreakpoint(*breakpoint);
+      if (FAILED(hr)) {
+        result = hr;
+      }
+    }
+
+    BreakpointLocationKey key = {collection->GetModuleBaseAddress(),
+                                 collection->GetMethodToken(),
+                                 collection->GetILOffset()};
+    new_table->location_index.erase(key);
+    location = new_table->location_to_breakpoints.erase(location);
+  }
+  PublishBreakpointTable(std::move(new_table));
+  AccountMemory();
+
+  return result;
+}
+
+void BreakpointCollection::RemoveDeactivatedLocations() {
+  std::chrono::steady_clock::time_point deactivated_before =
+      std::chrono::steady_clock::now() -
+      std::chrono::milliseconds(kDeactivatedBreakpointRetentionMs);
+  std::shared_ptr<const BreakpointTable> table = GetBreakpointTable();
+  std::shared_ptr<BreakpointTable> new_table;
+  for (const auto &location : table->location_to_breakpoints) {
+    const auto &collection = location.second;
+    if (!collection->DeactivatedBefore(deactivated_before)) {
+      continue;
+    }
+
+    if (!new_table) {
+      new_table.reset(new (std::nothrow) BreakpointTable(*table));
+      if (!new_table) {
+        return;
+      }
+    }
+
+    // The index may already point to a newer collection at the same
+    // method and IL offset.
+    BreakpointLocationKey key = {collection->GetModuleBaseAddress(),
+                                 collection->GetMethodToken(),
+                                 collection->GetILOffset()};
+    const auto &indexed = new_table->location_index.find(key);
+    if (indexed != new_table->location_index.end() &&
+        indexed->second == collection) {
+      new_table->location_index.erase(indexed);
+    }
+    new_table->location_to_breakpoints.erase(location.first);
+  }
+
+  if (new_table) {
+    PublishBreakpointTable(std::move(new_table));
+  }
+}
+
+void BreakpointCollection::AccountMemory() {
+  std::shared_ptr<const BreakpointTable> table = GetBreakpointTable();
+  size_t bytes = GetMemoryUsage(table->location_to_breakpoints) +
+                 GetMemoryUsage(table->location_index);
+  for (const auto &location : table->location_to_breakpoints) {
+    bytes += GetMemoryUsage(location.first) +
+             sizeof(BreakpointLocationCollection) +
+             location.second->GetBreakpoints().size() * sizeof(DbgBreakpoint);
+  }
+
+  bytes += GetMemoryUsage(pending_breakpoints_);
+  for (const auto &pending : pending_breakpoints_) {
+    bytes += GetMemoryUsage(pending.first) + GetMemoryUsage(pending.second) +
+             pending.second.size() * sizeof(DbgBreakpoint);
+  }
+  breakpoints_memory_.Set(bytes);
+}
+
+std::string BreakpointCollection::GetPendingBreakpointKey(
+    const std::string &file_path) {
+  return DocumentPathIndex::SplitFilePath(
+             DocumentPathIndex::NormalizeFilePath(file_path))
+      .front();
+}
+
+HRESULT BreakpointCollection::AddPendingBreakpoint(
+    const DbgBreakpoint &breakpoint) {
+  std::vector<std::shared_ptr<DbgBreakpoint>> &pending =
+      pending_breakpoints_[GetPendingBreakpointKey(breakpoint.GetFilePath())];
+  auto existing = std::find_if(
+      pending.begin(), pending.end(),
+      [&breakpoint](const std::shared_ptr<DbgBreakpoint> &pending_breakpoint) {
+        return pending_breakpoint->GetId() == breakpoint.GetId();
+      });
+
+  // A pending breakpoint that is still not found stays as it is.
+  if (existing != pending.end() && existing->get() == &breakpoint) {
+    return S_OK;
+  }
+
+  std::shared_ptr<DbgBreakpoint> pending_breakpoint(new (std::nothrow)
+                                                        DbgBreakpoint);
+  if (!pending_breakpoint) {
+    return E_OUTOFMEMORY;
+  }
+
+  pending_breakpoint->Initialize(breakpoint);
+  pending_breakpoint->SetActivated(breakpoint.Activated());
+  pending_breakpoint->SetKillServer(breakpoint.GetKillServer());
+  if (existing != pending.end()) {
+    *existing = std::move(pending_breakpoint);
+  } else {
+    pending.push_back(std::move(pending_breakpoint));
+  }
+  return S_OK;
+}
+
+void BreakpointCollection::RemovePendingBreakpoint(
+    const DbgBreakpoint &breakpoint) {
+  const auto &pending = pending_breakpoints_.find(
+      GetPendingBreakpointKey(breakpoint.GetFilePath()));
+  if (pending == pending_breakpoints_.end()) {
+    return;
+  }
+
+  std::string id = breakpoint.GetId();
+  std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints = pending->second;
+  breakpoints.erase(
+      std::remove_if(breakpoints.begin(), breakpoints.end(),
+                     [&id](const std::shared_ptr<DbgBreakpoint> &existing) {
+                       return existing->GetId() == id;
+                     }),
+      breakpoints.end());
+  if (breakpoints.empty()) {
+    pending_breakpoints_.erase(pending);
+  }
+}
+
+HRESULT BreakpointCollection::UpdateBreakpointsHelper(
+    const std::vector<const DbgBreakpoint *> &breakpoints,
+    const std::vector<std::shared_ptr<IPortablePdbFile>> &pdb_files) {
+  HRESULT hr;
+  HRESULT result = S_OK;
+
+  std::shared_ptr<const BreakpointTable> table = GetBreakpointTable();
+  LoadLocationCache();
+
+  // Breakpoints at locations that are not in the table yet, grouped by
+  // location in the order they arrived.
+  std::vector<NewBreakpointLocation> new_locations;
+  std::unordered_map<std::string, size_t> new_location_indices;
+
+  // Exception points have no location to set them at.
+  std::vector<const DbgBreakpoint *> exception_points;
+  for (const DbgBreakpoint *breakpoint : breakpoints) {
+    if (breakpoint->IsExceptionPoint()) {
+      exception_points.push_back(breakpoint);
+    }
+  }
+  if (!exception_points.empty()) {
+    hr = UpdateExceptionPoints(exception_points);
+    if (FAILED(hr)) {
+      cerr << "Failed to activate exception points.";
+      result = hr;
+    }
+  }
+
+  for (const DbgBreakpoint *breakpoint : breakpoints) {
+    if (breakpoint->IsExceptionPoint()) {
+      continue;
+    }
+
+    if (!breakpoint->Activated()) {
+      RemovePendingBreakpoint(*breakpoint);
+      if (location_cache_.Remove(breakpoint->GetId())) {
+        location_cache_changed_ = true;
+      }
+    }
+
+    // Find group of breakpoints at the same location.
+    std::string breakpoint_location = breakpoint->GetBreakpointLocation();
+    const auto &existing_location =
+        table->location_to_breakpoints.find(breakpoint_location);
+    if (existing_location != table->location_to_breakpoints.end()) {
+      hr = existing_location->second->UpdateBreakpoints(*breakpoint);
+      if (FAILED(hr)) {
+        cerr << "Failed to activate breakpoint.";
+        result = SUCCEEDED(result) ? hr : result;
+        continue;
+      }
+
+      if (hr == S_OK) {
+        continue;
+      }
+    }
+
+    // There is nothing to deactivate at a new location.
+    if (!breakpoint->Activated()) {
+      continue;
+    }
+
+    const auto &new_location = new_location_indices.find(breakpoint_location);
+    if (new_location != new_location_indices.end()) {
+      new_locations[new_location->second].breakpoints.push_back(breakpoint);
+      continue;
+    }
+
+    new_location_indices[breakpoint_location] = new_locations.size();
+    new_locations.push_back({breakpoint_location, {breakpoint}, nullptr});
+  }
+
+  if (new_locations.empty()) {
+    return result;
+  }
+
+  // Otherwise, we have to create the new breakpoints from scratch.
+  // Each of them is set and activated by searching through the PDB files
+  // for a matching location. A PDB is only parsed once for the whole batch
+  // and its module metadata is shared by the breakpoints found in it.
+  std::vector<std::shared_ptr<DbgBreakpoint>> unresolved;
+  for (const NewBreakpointLocation &new_location : new_locations) {
+    std::shared_ptr<DbgBreakpoint> new_breakpoint(new (std::nothrow)
+                                                      DbgBreakpoint);
+    if (!new_breakpoint) {
+      return E_OUTOFMEMORY;
+    }
+
+    const DbgBreakpoint *breakpoint = new_location.breakpoints.front();
+    new_breakpoint->Initialize(*breakpoint);
+    new_breakpoint->SetActivated(breakpoint->Activated());
+    new_breakpoint->SetKillServer(breakpoint->GetKillServer());
+    unresolved.push_back(std::move(new_breakpoint));
+  }
+
+  // The PDB files are searched for every breakpoint first, in parallel.
+  // Each breakpoint is then set in the first PDB file it was found in,
+  // in the order of pdb_files, so that the result does not depend on
+  // which thread searched which PDB file.
+  std::shared_ptr<BreakpointSearch> search(new (std::nothrow)
+                                               BreakpointSearch);
+  if (!search) {
+    return E_OUTOFMEMORY;
+  }
+  search->pdb_files = pdb_files;
+  search->breakpoints = unresolved;
+  FindBreakpointLocations(search);
+
+  size_t unresolved_count = unresolved.size();
+  for (size_t pdb_index = 0; pdb_index < pdb_files.size(); ++pdb_index) {
+    if (unresolved_count == 0) {
+      break;
+    }
+
+    const std::shared_ptr<IPortablePdbFile> &pdb_file = pdb_files[pdb_index];
+    if (!pdb_file) {
+      continue;
+    }
+
+    // The matches are sorted by breakpoint index.
+    const auto &matches = search->matches[pdb_index];
+    auto match = matches.begin();
+    std::unique_ptr<ModuleMetadata> module_metadata;
+    for (size_t i = 0; i < new_locations.size(); ++i) {
+      while (match != matches.end() && match->first < i) {
+        ++match;
+      }
+      if (!unresolved[i]) {
+        continue;
+      }
+
+      if (match != matches.end() && match->first == i) {
+        unresolved[i]->SetLocation(match->second);
+      } else if (pdb_index < search->first_matches[i] ||
+                 !pdb_file->ParsePdbFile() ||
+                 (!TrySetCachedLocation(unresolved[i].get(), *pdb_file) &&
+                  !unresolved[i]->TrySetBreakpoint(pdb_file.get()))) {
+        // The PDB files after the first match of a breakpoint were not
+        // searched for it, so they are searched here if it could not
+        // be set in that one.
+        continue;
+      }
+
+      if (!module_metadata) {
+        module_metadata.reset(new (std::nothrow) ModuleMetadata);
+        if (!module_metadata) {
+          return E_OUTOFMEMORY;
+        }
+
+        hr = GetModuleMetadata(pdb_file.get(), module_metadata.get());
+        if (FAILED(hr)) {
+          cerr << "Failed to activate breakpoint.";
+          result = SUCCEEDED(result) ? hr : result;
+          break;
+        }
+      }
+
+      std::shared_ptr<DbgBreakpoint> new_breakpoint = std::move(unresolved[i]);
+      new_breakpoint->PinMethods(pdb_file);
+      --unresolved_count;
+      hr = ActivateBreakpointHelper(new_breakpoint.get(),
+                                    module_metadata.get());
+      if (FAILED(hr)) {
+        cerr << "Failed to activate breakpoint.";
+        result = SUCCEEDED(result) ? hr : result;
+        continue;
+      }
+
+      if (!location_cache_file_.empty()) {
+        CachedBreakpointLocation cached_location;
+        cached_location.pdb_id = pdb_file->GetPdbId();
+        cached_location.method_def = new_breakpoint->GetMethodDef();
+        cached_location.il_offset = new_breakpoint->GetILOffset();
+        cached_location.resolved_line = new_breakpoint->GetLine();
+        for (const DbgBreakpoint *breakpoint : new_locations[i].breakpoints) {
+          cached_location.file_path = breakpoint->GetFilePath();
+          cached_location.line = breakpoint->GetLine();
+          if (location_cache_.Set(breakpoint->GetId(), cached_location)) {
+            location_cache_changed_ = true;
+          }
+        }
+      }
+
+      // Create a new location collection.
+      std::shared_ptr<BreakpointLocationCollection> bp_location(
+          new (std::nothrow) BreakpointLocationCollection());
+      if (!bp_location) {
+        return E_OUTOFMEMORY;
+      }
+
+      hr = bp_location->AddFirstBreakpoint(std::move(new_breakpoint));
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      // The other breakpoints at this location are added from the cache
+      // of the location collection.
+      const std::vector<const DbgBreakpoint *> &location_breakpoints =
+          new_locations[i].breakpoints;
+      for (size_t j = 1; j < location_breakpoints.size(); ++j) {
+        hr = bp_location->UpdateBreakpoints(*location_breakpoints[j]);
+        if (FAILED(hr)) {
+          cerr << "Failed to activate breakpoint.";
+          result = SUCCEEDED(result) ? hr : result;
+        }
+      }
+      new_locations[i].collection = std::move(bp_location);
+    }
+  }
+
+  // The breakpoints that are not found are set once the module with
+  // their file is loaded.
+  size_t found_count = 0;
+  for (const NewBreakpointLocation &new_location : new_locations) {
+    found_count += new_location.collection ? 1 : 0;
+    for (const DbgBreakpoint *breakpoint : new_location.breakpoints) {
+      if (new_location.collection) {
+        RemovePendingBreakpoint(*breakpoint);
+        continue;
+      }
+
+      hr = AddPendingBreakpoint(*breakpoint);
+      if (FAILED(hr)) {
+        return hr;
+      }
+    }
+  }
+
+  if (found_count == 0) {
+    return FAILED(result) ? result : S_FALSE;
   }
 
-  unique_ptr<BreakpointClient> result = unique_ptr<BreakpointClient>(
-      new (std::nothrow) BreakpointClient(std::move(pipe)));
-  if (!result) {
-    cerr << "Cannot create breakpoint client.";
+  // Publishes a new version of the table with all the new locations.
+  std::shared_ptr<BreakpointTable> new_table(new (std::nothrow)
+                                                 BreakpointTable(*table));
+  if (!new_table) {
     return E_OUTOFMEMORY;
   }
 
-  HRESULT hr = result->Initialize();
-  if (FAILED(hr)) {
-    cerr << "Failed to initialize breakpoint client.";
-    return hr;
-  }
+  for (NewBreakpointLocation &new_location : new_locations) {
+    if (!new_location.collection) {
+      continue;
+    }
 
-  hr = result->WaitForConnection();
-  if (FAILED(hr)) {
-    cerr << "Failed to connect with client.";
-    return hr;
-  }
+    // If there is an existing collection for this location, drop it
+    // from the index before it is replaced.
+    const auto &replaced_location =
+        new_table->location_to_breakpoints.find(new_location.location);
+    if (replaced_location != new_table->location_to_breakpoints.end()) {
+      BreakpointLocationKey replaced_key = {
+          replaced_location->second->GetModuleBaseAddress(),
+          replaced_location->second->GetMethodToken(),
+          replaced_location->second->GetILOffset()};
+      new_table->location_index.erase(replaced_key);
+    }
 
-  (*client) = std::move(result);
+    const auto &collection = new_location.collection;
+    BreakpointLocationKey key = {collection->GetModuleBaseAddress(),
+                                 collection->GetMethodToken(),
+                                 collection->GetILOffset()};
+    new_table->location_index[key] = new_location.collection;
+    new_table->location_to_breakpoints[new_location.location] =
+        std::move(new_location.collection);
+  }
+  PublishBreakpointTable(std::move(new_table));
 
-  return S_OK;
+  if (FAILED(result)) {
+    return result;
+  }
+  return found_count == new_locations.size() ? S_OK : S_FALSE;
 }
 
-HRESULT BreakpointCollection::WriteBreakpoint(const Breakpoint &breakpoint) {
-  if (!breakpoint_client_write_) {
-    HRESULT hr = CreateAndInitializeBreakpointClient(
-        &breakpoint_client_write_, debugger_callback_->GetPipeName());
-    if (FAILED(hr)) {
-      cerr << "Failed to initialize breakpoint client for writing breakpoints.";
-      return hr;
-    }
+void BreakpointCollection::LoadLocationCache() {
+  string directory = PortablePdbFile::GetIndexCacheDirectory();
+  string file;
+  if (!directory.empty()) {
+    file = BreakpointLocationCache::GetCacheFilePath(directory);
   }
 
-  return breakpoint_client_write_->WriteBreakpoint(breakpoint);
-}
-
-HRESULT BreakpointCollection::ReadBreakpoint(Breakpoint *breakpoint) {
-  if (!breakpoint_client_read_) {
-    HRESULT hr = CreateAndInitializeBreakpointClient(
-        &breakpoint_client_read_, debugger_callback_->GetPipeName());
-    if (FAILED(hr)) {
-      cerr << "Failed to initialize breakpoint client for reading breakpoints.";
-      return hr;
-    }
+  if (file == location_cache_file_) {
+    return;
   }
 
-  return breakpoint_client_read_->ReadBreakpoint(breakpoint);
+  location_cache_file_ = file;
+  location_cache_changed_ = false;
+  if (file.empty()) {
+    location_cache_ = BreakpointLocationCache();
+    return;
+  }
+  location_cache_.Read(file);
 }
 
-HRESULT BreakpointCollection::EvaluateAndPrintBreakpoint(
-    mdMethodDef function_token, ULONG32 il_offset,
-    IEvalCoordinator *eval_coordinator, ICorDebugThread *debug_thread,
-    const std::vector<
-        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-        &pdb_files) {
-  HRESULT hr = S_FALSE;
-  std::vector<std::shared_ptr<DbgBreakpoint>> matched_breakpoints;
-
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto &&kvp : location_to_breakpoints_) {
-      // Since the breakpoints are grouped by location, if
-      // one matches, all of them do.
-      if (kvp.second->GetMethodToken() == function_token
-        && kvp.second->GetILOffset() == il_offset) {
-        matched_breakpoints = kvp.second->GetBreakpoints();
-        break;
-      }
-    }
+void BreakpointCollection::SaveLocationCache() {
+  if (!location_cache_changed_ || location_cache_file_.empty()) {
+    return;
   }
 
-  if (matched_breakpoints.empty()) {
-    return S_FALSE;
+  location_cache_changed_ = false;
+  if (!location_cache_.Write(location_cache_file_)) {
+    cerr << "Failed to cache the locations of the breakpoints.";
   }
+}
 
-  hr = eval_coordinator->ProcessBreakpoints(
-      debug_thread, this, std::move(matched_breakpoints), pdb_files);
-  if (FAILED(hr)) {
-    cerr << "Failed to get stack frame's information.";
+bool BreakpointCollection::TrySetCachedLocation(
+    DbgBreakpoint *breakpoint, const IPortablePdbFile &pdb_file) {
+  const CachedBreakpointLocation *location =
+      FindCachedLocation(*breakpoint, pdb_file);
+  if (!location) {
+    return false;
   }
 
-  return hr;
+  breakpoint->SetMethodDef(location->method_def);
+  breakpoint->SetILOffset(location->il_offset);
+  breakpoint->SetLine(location->resolved_line);
+  return true;
 }
 
-HRESULT BreakpointCollection::ReadAndParseBreakpoint(
-    DbgBreakpoint *breakpoint) {
-  assert(breakpoint != nullptr);
-
-  Breakpoint breakpoint_read;
-  HRESULT hr = ReadBreakpoint(&breakpoint_read);
-  if (FAILED(hr)) {
-    cerr << "Failed to parse breakpoint.";
-    return hr;
+const CachedBreakpointLocation *BreakpointCollection::FindCachedLocation(
+    const DbgBreakpoint &breakpoint, const IPortablePdbFile &pdb_file) const {
+  if (location_cache_file_.empty()) {
+    return nullptr;
   }
 
-  SourceLocation location = breakpoint_read.location();
-
-  // For now, we don't have a use for column so we just assign it to 0.
-  breakpoint->Initialize(
-      location.path(), breakpoint_read.id(), location.line(), 0,
-      breakpoint_read.log_point(),
-      breakpoint_read.log_message_format(),
-      breakpoint_read.log_level(),
-      breakpoint_read.condition(),
-      std::vector<std::string>(breakpoint_read.expressions().begin(),
-                               breakpoint_read.expressions().end()));
-  breakpoint->SetActivated(breakpoint_read.activated());
-  breakpoint->SetKillServer(breakpoint_read.kill_server());
-
-  return S_OK;
+  // A different PDB id means the module was rebuilt, so the breakpoint
+  // may be somewhere else.
+  const CachedBreakpointLocation *location =
+      location_cache_.Find(breakpoint.GetId());
+  if (!location || location->file_path != breakpoint.GetFilePath() ||
+      location->line != breakpoint.GetLine() ||
+      location->pdb_id != pdb_file.GetPdbId()) {
+    return nullptr;
+  }
+  return location;
 }
 
-HRESULT BreakpointCollection::UpdateBreakpoint(
-    const DbgBreakpoint &breakpoint) {
-  HRESULT hr;
-  // Find group of breakpoints at the same location.
-  std::string breakpoint_location = breakpoint.GetBreakpointLocation();
-
-  {
-    std::lock_guard<std::mutex> lock(mutex_);  
-    if (location_to_breakpoints_.find(breakpoint_location)
-      != location_to_breakpoints_.end()) {
-      hr = location_to_breakpoints_[breakpoint_location]->UpdateBreakpoints(breakpoint);
-      if (FAILED(hr)) {
-        cerr << "Failed to activate breakpoint.";
-        return hr;
+void BreakpointCollection::FindBreakpointLocations(
+    const std::shared_ptr<BreakpointSearch> &search) {
+  size_t pdb_count = search->pdb_files.size();
+  search->first_matches =
+      std::vector<std::atomic<size_t>>(search->breakpoints.size());
+  for (std::atomic<size_t> &first_match : search->first_matches) {
+    first_match = pdb_count;
+  }
+  search->matches.resize(pdb_count);
+
+  // hardware_concurrency returns 0 if it is unknown.
+  ThreadPool *pool =
+      debugger_callback_ ? debugger_callback_->GetPdbParsingPool() : nullptr;
+  size_t threads = std::min<size_t>(
+      std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                       kMaxPdbParsingThreads),
+      pdb_count);
+  for (size_t helper = 1; pool && helper < threads; ++helper) {
+    std::shared_ptr<BreakpointSearch> helper_search = search;
+    bool scheduled = pool->Schedule([this, helper_search]() {
+      {
+        std::lock_guard<std::mutex> lock(helper_search->mutex);
+        if (helper_search->finished) {
+          return;
+        }
+        ++helper_search->running_helpers;
       }
 
-      if (hr == S_OK) {
-        return hr;
+      SearchPdbFiles(helper_search.get());
+      std::lock_guard<std::mutex> lock(helper_search->mutex);
+      if (--helper_search->running_helpers == 0) {
+        helper_search->done_cv.notify_one();
       }
+    });
+    if (!scheduled) {
+      break;
     }
   }
 
-  // Otherwise, we have to create a new breakpoint from scratch.
-  std::shared_ptr<DbgBreakpoint> new_breakpoint(new (std::nothrow)
-                                                    DbgBreakpoint);
-  if (!new_breakpoint) {
-    return E_OUTOFMEMORY;
-  }
+  // This thread searches too, so the search does not wait for the pool
+  // if it is busy parsing PDB files in the background.
+  SearchPdbFiles(search.get());
 
-  new_breakpoint->Initialize(breakpoint);
+  std::unique_lock<std::mutex> lock(search->mutex);
+  search->finished = true;
+  search->done_cv.wait(lock,
+                       [&search]() { return search->running_helpers == 0; });
+}
 
-  // No existing breakpoint with the same location so we have to
-  // try to set and activate the breakpoint by searching through PDB files
-  // for a matching location.
-  bool found_bp = false;
-  for (auto pdb_file : debugger_callback_->GetPdbFiles()) {
-    if (!pdb_file) {
-      continue;
+void BreakpointCollection::SearchPdbFiles(BreakpointSearch *search) {
+  size_t pdb_count = search->pdb_files.size();
+  size_t breakpoint_count = search->breakpoints.size();
+  for (size_t pdb_index = search->next_pdb++; pdb_index < pdb_count;
+       pdb_index = search->next_pdb++) {
+    // A PDB file is not parsed if every breakpoint was found in an
+    // earlier one.
+    bool needed = false;
+    for (size_t i = 0; i < breakpoint_count && !needed; ++i) {
+      needed = pdb_index < search->first_matches[i];
     }
 
-    if (!pdb_file->ParsePdbFile()) {
+    const std::shared_ptr<IPortablePdbFile> &pdb_file =
+        search->pdb_files[pdb_index];
+    if (!needed || !pdb_file || !pdb_file->ParsePdbFile()) {
       continue;
     }
 
-    if (!new_breakpoint->TrySetBreakpoint(pdb_file.get())) {
+    for (size_t i = 0; i < breakpoint_count; ++i) {
+      std::atomic<size_t> &first_match = search->first_matches[i];
+      if (first_match < pdb_index) {
+        continue;
+      }
+
+      SequencePointLocation location;
+      const CachedBreakpointLocation *cached_location =
+          FindCachedLocation(*search->breakpoints[i], *pdb_file);
+      if (cached_location) {
+        location.method_def = cached_location->method_def;
+        location.il_offset = cached_location->il_offset;
+        location.start_line = cached_location->resolved_line;
+      } else if (!search->breakpoints[i]->FindLocation(pdb_file.get(),
+                                                       &location)) {
+        continue;
+      }
+
+      search->matches[pdb_index].emplace_back(i, location);
+      size_t earliest = first_match;
+      while (pdb_index < earliest &&
+             !first_match.compare_exchange_weak(earliest, pdb_index)) {
+      }
+    }
+  }
+}
+
+HRESULT BreakpointCollection::UpdateExceptionPoints(
+    const std::vector<const DbgBreakpoint *> &exception_points) {
+  for (const DbgBreakpoint *exception_point : exception_points) {
+    if (!exception_point->Activated()) {
+      exception_points_.erase(exception_point->GetId());
       continue;
     }
 
-    hr = ActivateBreakpointHelper(new_breakpoint.get(), pdb_file.get());
-    if (FAILED(hr)) {
-      cerr << "Failed to activate breakpoint.";
-      return hr;
+    std::shared_ptr<DbgBreakpoint> new_exception_point(new (std::nothrow)
+                                                           DbgBreakpoint);
+    if (!new_exception_point) {
+      return E_OUTOFMEMORY;
     }
-    found_bp = true;
-    break;
-  }
 
-  if (!found_bp) {
-    return S_FALSE;
+    new_exception_point->Initialize(*exception_point);
+    new_exception_point->SetActivated(true);
+    exception_points_[exception_point->GetId()] =
+        std::move(new_exception_point);
   }
 
-  // Create a new location collection.
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::unique_ptr<BreakpointLocationCollection> bp_location(new BreakpointLocationCollection());
-    hr = bp_location->AddFirstBreakpoint(std::move(new_breakpoint));
-    if (FAILED(hr)) {
-      return hr;
+  // The filter of the exception points is built once here, so that
+  // exceptions are matched against it without looking at every
+  // exception point.
+  std::shared_ptr<ExceptionPointFilter> filter;
+  if (!exception_points_.empty()) {
+    filter.reset(new (std::nothrow) ExceptionPointFilter());
+    if (!filter) {
+      return E_OUTOFMEMORY;
+    }
+
+    for (const auto &exception_point : exception_points_) {
+      filter->Add(exception_point.second->GetExceptionType(),
+                  exception_point.second->GetExceptionModule(),
+                  exception_point.second);
     }
+  }
+
+  bool had_exception_points =
+      has_exception_points_.exchange(filter != nullptr);
+  bool has_exception_points = filter != nullptr;
+  std::atomic_store(&exception_point_filter_, std::move(filter));
 
-    location_to_breakpoints_[breakpoint.GetBreakpointLocation()]
-      = std::move(bp_location);
+  // The runtime only needs to deliver first-chance exceptions while an
+  // exception point is active.
+  if (debugger_callback_ && had_exception_points != has_exception_points) {
+    debugger_callback_->EnableExceptionCallbacks(has_exception_points);
   }
   return S_OK;
 }
 
 HRESULT BreakpointCollection::SyncBreakpoints() {
-  DbgBreakpoint breakpoint;
+  CpuSampler::RegisterThread("sync_breakpoints");
   HRESULT hr = S_OK;
 
+  if (debugger_callback_ &&
+      debugger_callback_->GetMetricsInterval().count() > 0) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    if (!stop_reporting_metrics_ && !metrics_thread_.joinable()) {
+      metrics_thread_ = std::thread(&BreakpointCollection::ReportMetrics, this,
+                                    debugger_callback_->GetMetricsInterval());
+    }
+  }
+
+  // Connects to the agent before the first read, which blocks until the
+  // agent has a breakpoint, so that the agent can be told the debugger
+  // is ready.
+  if (debugger_callback_ && !debugger_callback_->GetLocalBreakpoints() &&
+      !breakpoint_client_read_) {
+    std::chrono::steady_clock::time_point connection_start =
+        std::chrono::steady_clock::now();
+    hr = ConnectBreakpointClient(&breakpoint_client_read_);
+    if (FAILED(hr)) {
+      cerr << "Failed to initialize breakpoint client for reading breakpoints.";
+      return hr;
+    }
+    DebuggerMetrics::Global().startup.breakpoint_client_connection_us.SetSince(
+        connection_start);
+  }
+  UpdateReadyState(false, true);
+
+  // Deactivations are applied on this thread as soon as they are read,
+  // activations are queued for activation_queue_.
+  std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints;
+  std::vector<std::shared_ptr<DbgBreakpoint>> deactivations;
+  std::vector<std::shared_ptr<DbgBreakpoint>> activations;
   while (true) {
-    hr = ReadAndParseBreakpoint(&breakpoint);
+    breakpoints.clear();
+    hr = ReadAndParseBreakpoints(&breakpoints);
     if (FAILED(hr)) {
+      activation_queue_.Stop();
       return hr;
     }
 
-    if (breakpoint.GetKillServer()) {
+    if (hr == S_FALSE) {
+      continue;
+    }
+
+    if (breakpoints.size() == 1 && breakpoints.front()->GetKillServer()) {
+      activation_queue_.Stop();
       return S_OK;
     }
 
-    hr = UpdateBreakpoint(breakpoint);
-    if (FAILED(hr)) {
-      cerr << "Failed to activate breakpoint.";
+    deactivations.clear();
+    activations.clear();
+    for (std::shared_ptr<DbgBreakpoint> &breakpoint : breakpoints) {
+      if (breakpoint->Activated()) {
+        activations.push_back(std::move(breakpoint));
+      } else {
+        // The activation has to be dropped or finished first, otherwise
+        // it would be applied after the deactivation.
+        activation_queue_.Cancel(breakpoint->GetId());
+        deactivations.push_back(std::move(breakpoint));
+      }
+    }
+
+    if (!deactivations.empty()) {
+      ApplyBreakpointUpdates(deactivations);
+    }
+    if (!activations.empty() &&
+        FAILED(activation_queue_.Enqueue(activations))) {
+      cerr << "Failed to queue " << activations.size()
+           << " breakpoints for activation." << std::endl;
     }
   }
 
   return S_OK;
 }
 
+HRESULT BreakpointCollection::ApplyBreakpointUpdates(
+    const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints) {
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.breakpoint_updates.Increment(breakpoints.size());
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HRESULT hr = UpdateBreakpoints(breakpoints);
+  metrics.breakpoint_update_time_us.RecordSince(start);
+  if (FAILED(hr)) {
+    cerr << "Failed to activate breakpoint.";
+  }
+  return hr;
+}
+
 HRESULT BreakpointCollection::CancelSyncBreakpoints() {
   HRESULT hr = S_OK;
 
@@ -278,6 +1685,25 @@ HRESULT BreakpointCollection::CancelSyncBreakpoints() {
   // to shutdown as well.
   Breakpoint kill_breakpoint;
   kill_breakpoint.set_kill_server(true);
+  StopReportingMetrics();
+  {
+    // Writes the queued breakpoints before the agent shuts down.
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    if (breakpoint_writer_) {
+      breakpoint_writer_->Stop();
+    }
+  }
+
+  // Without an agent, only SyncBreakpoints has to stop.
+  if (debugger_callback_ && debugger_callback_->GetLocalBreakpoints()) {
+    {
+      std::lock_guard<std::mutex> lock(local_breakpoints_mutex_);
+      local_breakpoints_cancelled_ = true;
+    }
+    local_breakpoints_cv_.notify_all();
+    return S_OK;
+  }
+
   hr = breakpoint_client_write_->WriteBreakpoint(kill_breakpoint);
 
   if (FAILED(hr)) {
@@ -292,66 +1718,229 @@ HRESULT BreakpointCollection::CancelSyncBreakpoints() {
 	return hr;
   }
 
-  if (breakpoint_client_write_) {
+  // With a duplex pipe, the read client is also the write client.
+  if (breakpoint_client_write_ &&
+      breakpoint_client_write_ != breakpoint_client_read_) {
 	hr = breakpoint_client_write_->ShutDown();
   }
 
   return hr;
 }
 
-HRESULT BreakpointCollection::ActivateBreakpointHelper(
-    DbgBreakpoint *breakpoint,
-    google_cloud_debugger_portable_pdb::IPortablePdbFile *portable_pdb) {
-  if (!breakpoint) {
-    cerr << "Null breakpoint argument for ActivateBreakpoint.";
+HRESULT BreakpointCollection::ParseLocalBreakpoints(
+    std::istream *input, vector<Breakpoint> *breakpoints) {
+  if (!input || !breakpoints) {
     return E_INVALIDARG;
   }
 
+  string line;
+  int line_number = 0;
+  while (std::getline(*input, line)) {
+    ++line_number;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    // The path can have colons, like C:\\app\\Program.cs:42, so the line
+    // is after the last colon before the log message.
+    size_t space = line.find(' ');
+    string location = line.substr(0, space);
+    size_t colon = location.rfind(':');
+    int breakpoint_line = 0;
+    if (colon != string::npos && colon > 0 && colon + 1 < location.size() &&
+        location.find_first_not_of("0123456789", colon + 1) ==
+            string::npos) {
+      breakpoint_line = atoi(location.c_str() + colon + 1);
+    }
+    if (breakpoint_line <= 0) {
+      cerr << "Line " << line_number << " of the local breakpoints is not "
+           << "<path>:<line>." << std::endl;
+      return E_INVALIDARG;
+    }
+
+    Breakpoint breakpoint;
+    breakpoint.set_id("local-" + std::to_string(breakpoints->size() + 1));
+    breakpoint.mutable_location()->set_path(location.substr(0, colon));
+    breakpoint.mutable_location()->set_line(breakpoint_line);
+    breakpoint.set_activated(true);
+    if (space != string::npos && space + 1 < line.size()) {
+      breakpoint.set_log_point(true);
+      breakpoint.set_log_message_format(line.substr(space + 1));
+    }
+    breakpoints->push_back(std::move(breakpoint));
+  }
+
+  return S_OK;
+}
+
+void BreakpointCollection::ReportMetrics(std::chrono::milliseconds interval) {
+  CpuSampler::RegisterThread("metrics");
+  ThreadScheduling::Global().ApplyToBackgroundThread();
+  Breakpoint metrics;
+  std::unique_lock<std::mutex> lock(metrics_mutex_);
+  while (!metrics_cv_.wait_for(lock, interval,
+                               [this] { return stop_reporting_metrics_; })) {
+    lock.unlock();
+    DebuggerMetrics::Global().PopulateBreakpoint(&metrics);
+    CpuSampler::Global().AddToBreakpoint(&metrics);
+    if (FAILED(WriteBreakpoint(metrics))) {
+      cerr << "Failed to write the debugger metrics." << std::endl;
+    }
+    lock.lock();
+  }
+}
+
+void BreakpointCollection::SetAttached() { UpdateReadyState(true, false); }
+
+void BreakpointCollection::UpdateReadyState(bool attached, bool connected) {
+  {
+    std::lock_guard<std::mutex> lock(ready_mutex_);
+    attached_ = attached_ || attached;
+    connected_ = connected_ || connected;
+    if (!attached_ || !connected_ || ready_written_) {
+      return;
+    }
+    ready_written_ = true;
+  }
+
+  StartupTimings &startup = DebuggerMetrics::Global().startup;
+  startup.total_us.SetSince(startup.start);
+  Breakpoint ready;
+  startup.PopulateBreakpoint(&ready);
+  if (FAILED(WriteBreakpoint(ready))) {
+    cerr << "Failed to tell the agent the debugger is ready." << std::endl;
+  }
+}
+
+void BreakpointCollection::StopReportingMetrics() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    stop_reporting_metrics_ = true;
+    std::swap(thread, metrics_thread_);
+  }
+  metrics_cv_.notify_all();
+
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+HRESULT BreakpointCollection::GetModuleMetadata(
+    google_cloud_debugger_portable_pdb::IPortablePdbFile *portable_pdb,
+    ModuleMetadata *module_metadata) {
   if (!portable_pdb) {
     cerr << "Null Portable PDB File.";
     return E_INVALIDARG;
   }
 
-  CComPtr<ICorDebugModule> debug_module;
-  CComPtr<IUnknown> temp_import;
+  if (!module_metadata) {
+    return E_INVALIDARG;
+  }
 
-  HRESULT hr = portable_pdb->GetDebugModule(&debug_module);
+  HRESULT hr = portable_pdb->GetDebugModule(&module_metadata->debug_module);
   if (FAILED(hr)) {
     cout << "Failed to get ICorDebugModule from portable PDB.";
     return hr;
   }
 
-  CComPtr<IMetaDataImport> metadata_import;
-  hr = portable_pdb->GetMetaDataImport(&metadata_import);
+  hr = module_metadata->debug_module->GetBaseAddress(
+      &module_metadata->module_base_address);
+  if (FAILED(hr)) {
+    cerr << "Failed to get base address of ICorDebugModule.";
+    return hr;
+  }
+
+  hr = portable_pdb->GetMetaDataImport(&module_metadata->metadata_import);
   if (FAILED(hr)) {
     cout << "Failed to get IMetaDataImport from portable PDB.";
     return hr;
   }
 
+  return S_OK;
+}
+
+HRESULT BreakpointCollection::ResolveMethod(uint32_t method_def,
+                                            ModuleMetadata *module_metadata,
+                                            const ResolvedMethod **method) {
+  const auto &resolved = module_metadata->methods.find(method_def);
+  if (resolved != module_metadata->methods.end()) {
+    *method = &resolved->second;
+    return S_OK;
+  }
+
+  IMetaDataImport *metadata_import = module_metadata->metadata_import;
   mdTypeDef type_def;
   vector<WCHAR> method_name;
   PCCOR_SIGNATURE signature;
   ULONG method_virtual_addr;
-  hr = GetMethodData(metadata_import, breakpoint->GetMethodDef(), &type_def,
-                     &signature, &method_virtual_addr, &method_name);
+  HRESULT hr = GetMethodData(metadata_import, method_def, &type_def,
+                             &signature, &method_virtual_addr, &method_name);
+
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // The rows of the MethodDebugInformation table of the PDB are the rows
+  // of the MethodDef table of the module, so the token of the method
+  // usually does not have to be looked up.
+  ResolvedMethod resolved_method;
+  mdMethodDef method_token = TokenFromRid(method_def, mdtMethodDef);
+  hr = GetMethodCode(method_token, module_metadata->debug_module,
+                     &resolved_method.debug_code);
+  if (SUCCEEDED(hr)) {
+    resolved_method.method_token = method_token;
+  } else {
+    hr = FindMethodByName(metadata_import, module_metadata->debug_module,
+                          type_def, signature, method_virtual_addr,
+                          method_name, &resolved_method);
+    if (FAILED(hr)) {
+      return hr;
+    }
+  }
+
+  resolved_method.method_name = std::move(method_name);
+  *method = &(module_metadata->methods[method_def] =
+                  std::move(resolved_method));
+  return S_OK;
+}
 
+HRESULT BreakpointCollection::GetMethodCode(mdMethodDef method_token,
+                                            ICorDebugModule *debug_module,
+                                            ICorDebugCode **debug_code) {
+  CComPtr<ICorDebugFunction> debug_function;
+  HRESULT hr =
+      debug_module->GetFunctionFromToken(method_token, &debug_function);
   if (FAILED(hr)) {
+    cerr << "Failed to get function from function token " << method_token
+         << " with HRESULT " << std::hex << hr;
     return hr;
   }
 
+  hr = debug_function->GetILCode(debug_code);
+  if (FAILED(hr)) {
+    cerr << "Failed to get ICorDebugCode from function with hr " << std::hex
+         << hr;
+  }
+
+  return hr;
+}
+
+HRESULT BreakpointCollection::FindMethodByName(
+    IMetaDataImport *metadata_import, ICorDebugModule *debug_module,
+    mdTypeDef type_def, PCCOR_SIGNATURE signature, ULONG method_virtual_addr,
+    const vector<WCHAR> &method_name, ResolvedMethod *resolved_method) {
+  HRESULT hr = S_OK;
   HCORENUM cor_enum = nullptr;
   bool method_found = false;
   bool has_error = false;
 
   while (!method_found && !has_error) {
-    // Enumerate all the methods with the same name as this.
-    // We have to do this because given a method definition (that is parsed
-    // from a PDB file), there seems to be no function to translate
-    // that to a method token (from IMetaDataImport) and we need the
-    // method token to set a breakpoint.
-    // So what we have to do here is search for a method in
-    // IMetaDataImport->EnumMethodsWithName that has the same signature
-    // and use its method token.
+    // Enumerate all the methods with the same name as this and search
+    // for the one that has the same signature and use its method token.
     vector<mdMethodDef> method_tokens(100, 0);
     ULONG method_defs_returned = 0;
     hr = metadata_import->EnumMethodsWithName(
@@ -365,8 +1954,8 @@ HRESULT BreakpointCollection::ActivateBreakpointHelper(
     }
 
     // For all the methods with the same name, search for the method
-    // that has the same signature and virtual address and uses its method token
-    // to activate the breakpoint.
+    // that has the same signature and virtual address and uses its method
+    // token to get the code of the method.
     for (size_t i = 0; i < method_defs_returned; ++i) {
       ULONG temp_method_name_length;
       DWORD temp_flags1;
@@ -384,52 +1973,14 @@ HRESULT BreakpointCollection::ActivateBreakpointHelper(
         continue;
       }
 
-      // Activates the breakpoint in this method.
-      CComPtr<ICorDebugFunction> debug_function;
-      breakpoint->SetMethodToken(method_tokens[i]);
-      hr =
-          debug_module->GetFunctionFromToken(method_tokens[i], &debug_function);
-      if (FAILED(hr)) {
-        cerr << "Failed to get function from function token "
-             << method_tokens[i] << " with HRESULT " << std::hex << hr;
-        has_error = true;
-        break;
-      }
-
-      CComPtr<ICorDebugCode> debug_code;
-      hr = debug_function->GetILCode(&debug_code);
-      if (FAILED(hr)) {
-        cerr << "Failed to get ICorDebugCode from function with hr " << std::hex
-             << hr;
-        has_error = true;
-        break;
-      }
-
-      CComPtr<ICorDebugFunctionBreakpoint> function_breakpoint;
-      hr = debug_code->CreateBreakpoint(breakpoint->GetILOffset(),
-                                        &function_breakpoint);
-
-      if (FAILED(hr)) {
-        cerr << "Failed to set breakpoint in at offset "
-             << breakpoint->GetILOffset() << " in function "
-             << breakpoint->GetMethodToken() << " with HRESULT " << std::hex
-             << hr;
-        has_error = true;
-        break;
-      }
-
-      hr = function_breakpoint->Activate(TRUE);
+      hr = GetMethodCode(method_tokens[i], debug_module,
+                         &resolved_method->debug_code);
       if (FAILED(hr)) {
-        cerr << "Failed to activate breakpoint in at offset "
-             << breakpoint->GetILOffset() << " in function "
-             << breakpoint->GetMethodToken() << " with HRESULT " << std::hex
-             << hr;
         has_error = true;
         break;
       }
 
-      breakpoint->SetMethodName(std::move(method_name));
-      breakpoint->SetCorDebugBreakpoint(function_breakpoint);
+      resolved_method->method_token = method_tokens[i];
       method_found = true;
       break;
     }
@@ -450,6 +2001,52 @@ HRESULT BreakpointCollection::ActivateBreakpointHelper(
   return S_OK;
 }
 
+HRESULT BreakpointCollection::ActivateBreakpointHelper(
+    DbgBreakpoint *breakpoint, ModuleMetadata *module_metadata) {
+  if (!breakpoint) {
+    cerr << "Null breakpoint argument for ActivateBreakpoint.";
+    return E_INVALIDARG;
+  }
+
+  if (!module_metadata) {
+    return E_INVALIDARG;
+  }
+
+  breakpoint->SetModuleBaseAddress(module_metadata->module_base_address);
+
+  const ResolvedMethod *method;
+  HRESULT hr =
+      ResolveMethod(breakpoint->GetMethodDef(), module_metadata, &method);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // Activates the breakpoint in this method.
+  breakpoint->SetMethodToken(method->method_token);
+  CComPtr<ICorDebugFunctionBreakpoint> function_breakpoint;
+  hr = method->debug_code->CreateBreakpoint(breakpoint->GetILOffset(),
+                                            &function_breakpoint);
+
+  if (FAILED(hr)) {
+    cerr << "Failed to set breakpoint in at offset "
+         << breakpoint->GetILOffset() << " in function "
+         << breakpoint->GetMethodToken() << " with HRESULT " << std::hex << hr;
+    return hr;
+  }
+
+  hr = function_breakpoint->Activate(TRUE);
+  if (FAILED(hr)) {
+    cerr << "Failed to activate breakpoint in at offset "
+         << breakpoint->GetILOffset() << " in function "
+         << breakpoint->GetMethodToken() << " with HRESULT " << std::hex << hr;
+    return hr;
+  }
+
+  breakpoint->SetMethodName(method->method_name);
+  breakpoint->SetCorDebugBreakpoint(function_breakpoint);
+  return S_OK;
+}
+
 HRESULT BreakpointCollection::GetMethodData(IMetaDataImport *metadata_import,
                                             uint32_t method_def,
                                             mdTypeDef *type_def,
@@ -488,19 +2085,4 @@ HRESULT BreakpointCollection::GetMethodData(IMetaDataImport *metadata_import,
   return hr;
 }
 
-bool EqualsIgnoreCase(const std::string &first_string,
-                      const std::string &second_string) {
-  if (first_string.size() != second_string.size()) {
-    return false;
-  }
-
-  for (size_t i = 0; i < first_string.size(); ++i) {
-    if (tolower(first_string[i]) != tolower(second_string[i])) {
-      return false;
-    }
-  }
-
-  return true;
-}
-
 }  // namespace google_cloud_debugger
@@ -15,25 +15,73 @@
 #ifndef BREAKPOINT_COLLECTION_H_
 #define BREAKPOINT_COLLECTION_H_
 
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <istream>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "breakpoint_activation_queue.h"
 #include "breakpoint_client.h"
+#include "breakpoint_location_cache.h"
 #include "ccomptr.h"
 #include "dbg_breakpoint.h"
+#include "exception_point_filter.h"
 #include "i_breakpoint_collection.h"
 #include "breakpoint_location_collection.h"
+#include "breakpoint_writer.h"
+#include "metrics.h"
+#include "rate_limiter.h"
+#include "sequence_point_index.h"
 
 namespace google_cloud_debugger {
 
 class DebuggerCallback;
+class ICorDebugHelper;
 class IEvalCoordinator;
 
+// Identifies the location of a breakpoint in the debuggee by the base
+// address of the module, the token of the method and the IL offset
+// inside that method. This is what the ICorDebug breakpoint callback
+// gives us so we can look up breakpoints without comparing paths.
+struct BreakpointLocationKey {
+  // Base address of the module the breakpoint is in.
+  CORDB_ADDRESS module_base_address;
+
+  // Token of the method the breakpoint is in.
+  mdMethodDef method_token;
+
+  // IL offset of the breakpoint inside the method.
+  ULONG32 il_offset;
+
+  bool operator==(const BreakpointLocationKey &other) const {
+    return module_base_address == other.module_base_address &&
+           method_token == other.method_token && il_offset == other.il_offset;
+  }
+};
+
+// Hash function for BreakpointLocationKey.
+struct BreakpointLocationKeyHash {
+  std::size_t operator()(const BreakpointLocationKey &key) const {
+    std::size_t result = std::hash<CORDB_ADDRESS>()(key.module_base_address);
+    result = result * 31 + std::hash<mdMethodDef>()(key.method_token);
+    return result * 31 + std::hash<ULONG32>()(key.il_offset);
+  }
+};
+
 // Class for managing a collection of breakpoints.
 class BreakpointCollection : public IBreakpointCollection {
  public:
+  // Stops reporting metrics.
+  ~BreakpointCollection() override;
+
   // Sets the Debugger Callback field, which is used to get a list of
   // Portable PDB files applicable to this collection.
   HRESULT SetDebuggerCallback(DebuggerCallback *debugger_callback) override;
@@ -48,53 +96,402 @@ class BreakpointCollection : public IBreakpointCollection {
   // This means duplicate breakpoints will be silently rejected.
   HRESULT UpdateBreakpoint(const DbgBreakpoint &breakpoint) override;
 
+  // Updates a batch of breakpoints like UpdateBreakpoint. Breakpoints at
+  // new locations are resolved together: each PDB is searched once for
+  // all of them, its module metadata is read once and each method is
+  // only looked up once. Returns S_FALSE if some breakpoints could not
+  // be set.
+  HRESULT UpdateBreakpoints(
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints) override;
+
+  // Sets the pending breakpoints whose file name is the file name of a
+  // document of pdb_file. Only the documents of pdb_file are searched.
+  HRESULT UpdatePendingBreakpoints(
+      const std::shared_ptr<
+          google_cloud_debugger_portable_pdb::IPortablePdbFile> &pdb_file)
+      override;
+
+  // Removes the locations in the module loaded at module_base_address
+  // from the breakpoint table. Their active breakpoints become pending.
+  HRESULT RemoveModuleBreakpoints(CORDB_ADDRESS module_base_address) override;
+
   // Using the breakpoint_client_read_ name pipe, try to read and parse
   // any incoming breakpoints that are written to the named pipe.
   // This method will then try to activate or deactivate these breakpoints.
   // This method will block and wait until a breakpoint arrives.
   // It will only terminate if the connection to the named pipe server
-  // is cut off.
+  // is cut off. If the debugger callback has a metrics interval, the
+  // DebuggerMetrics are written to the agent every interval meanwhile.
+  // Connects to the agent before it reads the first breakpoint, so that
+  // the agent can be told the debugger is ready.
   HRESULT SyncBreakpoints() override;
 
   // Cancel SyncBreakpoints operation (should be called from another thread).
   HRESULT CancelSyncBreakpoints() override;
 
-  // Writes a breakpoint to the named pipe server.
+  // Writes the message with ID kReadyBreakpointId to the agent if
+  // SyncBreakpoints is connected to it, or else once it is.
+  void SetAttached() override;
+
+  // Queues a breakpoint to be written to the named pipe server by
+  // breakpoint_writer_. Returns S_FALSE if the breakpoint is a log point
+  // that is dropped because too many breakpoints are waiting to be written.
   HRESULT WriteBreakpoint(
       const google::cloud::diagnostics::debug::Breakpoint &breakpoint) override;
 
-  // Reads a breakpoint from the named pipe server.
+  // Queues a breakpoint like WriteBreakpoint, swapping its contents into
+  // the queue of breakpoint_writer_ instead of copying them.
+  HRESULT WriteAndClearBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) override;
+
+  // Reads a breakpoint from the named pipe server, or the next local
+  // breakpoint of the debugger callback if it has local breakpoints.
+  // Once all the local breakpoints are read, blocks until
+  // CancelSyncBreakpoints is called and reads a breakpoint that kills
+  // the server.
   HRESULT ReadBreakpoint(
       google::cloud::diagnostics::debug::Breakpoint *breakpoint) override;
 
   // Evaluates and prints out the breakpoint that corresponds to
   // the IL offset il_offset inside the function with token
-  // function_token.
+  // function_token of the module loaded at module_base_address.
+  // Hits above the hit rate of a breakpoint, and log point hits while
+  // log points cost more than log_point_cost_limiter_ allows, are skipped.
+  // Breakpoints that reached their hit limit or expired are skipped and
+  // deactivated without waiting for the agent.
   HRESULT EvaluateAndPrintBreakpoint(
-      mdMethodDef function_token, ULONG32 il_offset,
+      CORDB_ADDRESS module_base_address, mdMethodDef function_token,
+      ULONG32 il_offset, IEvalCoordinator *eval_coordinator,
+      ICorDebugThread *debug_thread,
+      std::shared_ptr<const ModuleSnapshot> modules) override;
+
+  // Returns true if an exception point is activated.
+  bool HasExceptionPoints() override {
+    return has_exception_points_.load(std::memory_order_relaxed);
+  }
+
+  // Evaluates and prints out the exception points hit by the exception
+  // being thrown on debug_thread, which are found with
+  // exception_point_filter_. Exceptions of classes that no exception
+  // point wants are only looked up in its cache.
+  HRESULT EvaluateExceptionPoints(
       IEvalCoordinator *eval_coordinator, ICorDebugThread *debug_thread,
-      const std::vector<
-          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-          &pdb_files) override;
+      std::shared_ptr<const ModuleSnapshot> modules) override;
+
+  // Parses the breakpoints of input for DebuggerCallback::SetLocalBreakpoints.
+  // Every line is a breakpoint "<path>:<line>", where the path has no
+  // spaces. It is a log point if it is followed by a space and a log
+  // message format. Empty lines and
+  // lines that start with # are skipped. Returns E_INVALIDARG if a line
+  // is not a breakpoint.
+  static HRESULT ParseLocalBreakpoints(
+      std::istream *input,
+      std::vector<google::cloud::diagnostics::debug::Breakpoint>
+          *breakpoints);
 
  private:
-  // Reads an incoming breakpoint from the named pipe and populates
-  // The DbgBreakpoint object based on that.
-  HRESULT ReadAndParseBreakpoint(DbgBreakpoint *breakpoint);
+  // Loop of metrics_thread_: writes DebuggerMetrics to the agent every
+  // interval until StopReportingMetrics is called.
+  void ReportMetrics(std::chrono::milliseconds interval);
+
+  // Stops and joins metrics_thread_. Metrics are not reported afterwards.
+  void StopReportingMetrics();
+
+  // Records that the debugger is attached or connected to the agent, and
+  // writes the StartupTimings to the agent once it is both.
+  void UpdateReadyState(bool attached, bool connected);
+
+  // Removes the breakpoints whose condition is false on the active frame
+  // of debug_thread from breakpoints, using their pre-filters (see
+  // DbgBreakpoint::PrefilterCondition).
+  void PrefilterConditions(
+      ICorDebugThread *debug_thread,
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints);
+
+  // Removes the breakpoints whose hit should be skipped from breakpoints
+  // and reports the skipped log points to the agent. Sets has_log_point
+  // to true if a log point is left.
+  void SkipRateLimitedHits(
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints,
+      bool *has_log_point);
+
+  // Removes the breakpoints whose hit is not sampled (see
+  // DbgBreakpoint::SampleHit) from breakpoints, before their condition is
+  // evaluated or their hit takes from any rate limit.
+  void SkipUnsampledHits(
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints);
+
+  // Removes the breakpoints whose capture slot another thread holds from
+  // breakpoints, so that their hit continues without evaluation. Appends
+  // the breakpoints whose slot this thread claimed to
+  // capturing_breakpoints; their slot is released with
+  // DbgBreakpoint::EndCapture once they are processed.
+  void SkipConcurrentCaptures(
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints,
+      std::vector<std::shared_ptr<DbgBreakpoint>> *capturing_breakpoints);
 
-  // The underlying list of breakpoints that this collection manages.
-  // std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints_;
+  // Removes the breakpoints that reached their hit limit or expired from
+  // breakpoints. Appends the breakpoints that have a hit limit or expire
+  // to limited_breakpoints, including the removed ones.
+  void SkipFinishedBreakpoints(
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints,
+      std::vector<std::shared_ptr<DbgBreakpoint>> *limited_breakpoints);
 
-  // A map of location to a collection of breakpoint at that location.
-  std::unordered_map<std::string, std::unique_ptr<BreakpointLocationCollection>>
-    location_to_breakpoints_;
+  // Deactivates the breakpoints of limited_breakpoints that reached their
+  // hit limit or expired.
+  void DeactivateFinishedBreakpoints(
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &limited_breakpoints);
+
+  // Skips the hits of matched_breakpoints that should be skipped and
+  // evaluates and prints out the others. Shared by breakpoints and
+  // exception points.
+  HRESULT ProcessMatchedBreakpoints(
+      std::vector<std::shared_ptr<DbgBreakpoint>> matched_breakpoints,
+      IEvalCoordinator *eval_coordinator, ICorDebugThread *debug_thread,
+      std::shared_ptr<const ModuleSnapshot> modules);
+
+  // Activates or deactivates exception_points and publishes a new
+  // exception_point_filter_. Must be called with mutex_ held.
+  HRESULT UpdateExceptionPoints(
+      const std::vector<const DbgBreakpoint *> &exception_points);
+
+  // Gets the module, token and metadata of the class of the exception
+  // being thrown on debug_thread.
+  HRESULT GetExceptionClass(ICorDebugThread *debug_thread,
+                            ICorDebugHelper *debug_helper,
+                            CORDB_ADDRESS *module_base_address,
+                            mdTypeDef *class_token,
+                            IMetaDataImport **metadata_import);
+
+  // Reads an incoming message from the named pipe and appends the
+  // breakpoints it updates to breakpoints. A sync message (see
+  // kSyncBreakpointsId) is reconciled with synced_breakpoints_ in one
+  // pass. Returns S_FALSE if the message does not update any breakpoint.
+  HRESULT ReadAndParseBreakpoints(
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints);
+
+  // Populates breakpoint from breakpoint_read. A delta is completed in
+  // place from synced_breakpoints_. Returns S_FALSE if the delta is for a
+  // breakpoint that is not known.
+  HRESULT ParseBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint_read,
+      DbgBreakpoint *breakpoint);
+
+  // Applies breakpoints read from the agent with UpdateBreakpoints and
+  // records the breakpoint update metrics.
+  HRESULT ApplyBreakpointUpdates(
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints);
+
+  // Appends to breakpoints the new breakpoints of sync and a
+  // deactivation of every synced breakpoint that is not in sync.
+  HRESULT ParseSyncBreakpoints(
+      google::cloud::diagnostics::debug::Breakpoint *sync,
+      std::vector<std::shared_ptr<DbgBreakpoint>> *breakpoints);
+
+  // An immutable version of the breakpoint locations managed by this
+  // collection. Writers never modify a published table. Instead, they copy
+  // the current table, modify the copy and atomically swap it in, so
+  // readers on the breakpoint hit path never wait for writers.
+  struct BreakpointTable {
+    // A map of location to a collection of breakpoint at that location.
+    std::unordered_map<std::string,
+                       std::shared_ptr<BreakpointLocationCollection>>
+        location_to_breakpoints;
+
+    // Secondary index of location_to_breakpoints keyed on the module,
+    // method token and IL offset of each location. This is used by
+    // EvaluateAndPrintBreakpoint so that a breakpoint hit does not have to
+    // scan every location. It must be updated together with
+    // location_to_breakpoints.
+    std::unordered_map<BreakpointLocationKey,
+                       std::shared_ptr<BreakpointLocationCollection>,
+                       BreakpointLocationKeyHash>
+        location_index;
+  };
+
+  // Returns the current version of the breakpoint table.
+  // This does not take any locks.
+  std::shared_ptr<const BreakpointTable> GetBreakpointTable() const {
+    return std::atomic_load(&breakpoint_table_);
+  }
+
+  // Publishes a new version of the breakpoint table. Must be called with
+  // mutex_ held.
+  void PublishBreakpointTable(std::shared_ptr<const BreakpointTable> table) {
+    std::atomic_store(&breakpoint_table_, std::move(table));
+  }
+
+  // The current version of the breakpoint table. Only accessed through
+  // GetBreakpointTable and PublishBreakpointTable.
+  std::shared_ptr<const BreakpointTable> breakpoint_table_ =
+      std::make_shared<BreakpointTable>();
+
+  // Breakpoints of a batch that are at the same location that is not
+  // in the breakpoint table yet.
+  struct NewBreakpointLocation {
+    // String that represents the location.
+    std::string location;
+
+    // The breakpoints at this location, in the order they arrived.
+    std::vector<const DbgBreakpoint *> breakpoints;
+
+    // The collection created for this location once the first breakpoint
+    // is set.
+    std::shared_ptr<BreakpointLocationCollection> collection;
+  };
+
+  // A method that breakpoints can be set in.
+  struct ResolvedMethod {
+    // Token of the method.
+    mdMethodDef method_token = 0;
+
+    // Name of the method.
+    std::vector<WCHAR> method_name;
+
+    // IL code of the method.
+    CComPtr<ICorDebugCode> debug_code;
+  };
+
+  // Metadata of the module of a portable PDB used to set breakpoints in it.
+  // It is shared by the breakpoints of a batch that are in the same module.
+  struct ModuleMetadata {
+    CComPtr<ICorDebugModule> debug_module;
+    CORDB_ADDRESS module_base_address = 0;
+    CComPtr<IMetaDataImport> metadata_import;
+
+    // Methods resolved so far, keyed by method definition.
+    std::unordered_map<uint32_t, ResolvedMethod> methods;
+  };
+
+  // Reads location_cache_ from the directory of the PDB index cache if
+  // that directory changed. The cache is disabled while the PDB index
+  // cache is. Must be called with mutex_ held.
+  void LoadLocationCache();
+
+  // Writes location_cache_ if it changed. Must be called with mutex_ held.
+  void SaveLocationCache();
+
+  // Sets the location of breakpoint to its location in location_cache_ if
+  // one is cached for pdb_file. Returns false if there is none, in which
+  // case the breakpoint has to be searched for in pdb_file. Must be
+  // called with mutex_ held.
+  bool TrySetCachedLocation(
+      DbgBreakpoint *breakpoint,
+      const google_cloud_debugger_portable_pdb::IPortablePdbFile &pdb_file);
 
-  // Activate a breakpoint in a portable pdb file.
+  // The locations in the PDB files of pdb_files of the breakpoints of a
+  // batch at new locations. The PDB files are searched in parallel by the
+  // thread that updates the breakpoints and the threads of the PDB
+  // parsing pool, which keep it alive while they run.
+  struct BreakpointSearch {
+    std::vector<
+        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+        pdb_files;
+    std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints;
+
+    // For every breakpoint, the index of the first PDB file it was found
+    // in so far, or the number of PDB files. The PDB files after it are
+    // not searched for the breakpoint.
+    std::vector<std::atomic<std::size_t>> first_matches;
+
+    // For every PDB file, the indices of the breakpoints found in it with
+    // their locations. Only written by the thread that took the PDB file.
+    typedef std::pair<std::size_t,
+                      google_cloud_debugger_portable_pdb::SequencePointLocation>
+        Match;
+    std::vector<std::vector<Match>> matches;
+
+    // Index of the next PDB file that no thread took yet.
+    std::atomic<std::size_t> next_pdb{0};
+
+    // The number of pool threads searching, and whether the search is
+    // over. The pool threads that start once it is over do nothing.
+    std::size_t running_helpers = 0;
+    bool finished = false;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+  };
+
+  // Fills the matches of search, searching its PDB files on this thread
+  // and on the PDB parsing pool. Returns once the search is over. The
+  // breakpoints of search must not change meanwhile. Must be called with
+  // mutex_ held.
+  void FindBreakpointLocations(const std::shared_ptr<BreakpointSearch> &search);
+
+  // Searches the PDB files of search that no other thread took, until
+  // there is none left.
+  void SearchPdbFiles(BreakpointSearch *search);
+
+  // Returns the location of breakpoint in location_cache_ if one is
+  // cached for pdb_file, or nullptr. Reads location_cache_ only, so the
+  // threads of a search can call it while mutex_ is held by the thread
+  // that started the search.
+  const CachedBreakpointLocation *FindCachedLocation(
+      const DbgBreakpoint &breakpoint,
+      const google_cloud_debugger_portable_pdb::IPortablePdbFile &pdb_file)
+      const;
+
+  // Implements UpdateBreakpoint, UpdateBreakpoints and
+  // UpdatePendingBreakpoints. Breakpoints at new locations are searched
+  // for in pdb_files. The ones that are not found are kept as pending
+  // breakpoints. Must be called with mutex_ held.
+  HRESULT UpdateBreakpointsHelper(
+      const std::vector<const DbgBreakpoint *> &breakpoints,
+      const std::vector<std::shared_ptr<
+          google_cloud_debugger_portable_pdb::IPortablePdbFile>> &pdb_files);
+
+  // Returns the normalized file name of file_path, which is the key of
+  // pending_breakpoints_.
+  static std::string GetPendingBreakpointKey(const std::string &file_path);
+
+  // Adds a copy of breakpoint to pending_breakpoints_, replacing the
+  // pending breakpoint with the same id. Must be called with mutex_ held.
+  HRESULT AddPendingBreakpoint(const DbgBreakpoint &breakpoint);
+
+  // Removes the pending breakpoint with the id of breakpoint, if any.
+  // Must be called with mutex_ held.
+  void RemovePendingBreakpoint(const DbgBreakpoint &breakpoint);
+
+  // Removes the locations whose ICorDebugBreakpoint has been deactivated
+  // for longer than kDeactivatedBreakpointRetentionMs, which releases it.
+  // Must be called with mutex_ held.
+  void RemoveDeactivatedLocations();
+
+  // Charges the memory of the breakpoint table and the pending breakpoints
+  // to breakpoints_memory_. Must be called with mutex_ held.
+  void AccountMemory();
+
+  // Gets the module metadata of portable_pdb.
+  HRESULT GetModuleMetadata(
+      google_cloud_debugger_portable_pdb::IPortablePdbFile *portable_pdb,
+      ModuleMetadata *module_metadata);
+
+  // Finds the method with method definition method_def in the module,
+  // using the methods already resolved in module_metadata if possible.
+  HRESULT ResolveMethod(uint32_t method_def, ModuleMetadata *module_metadata,
+                        const ResolvedMethod **method);
+
+  // Gets the IL code of the method with token method_token in debug_module.
+  HRESULT GetMethodCode(mdMethodDef method_token,
+                        ICorDebugModule *debug_module,
+                        ICorDebugCode **debug_code);
+
+  // Finds the method of type type_def named method_name that has the given
+  // signature and virtual address by enumerating the methods with that
+  // name. Used if the method definition from the PDB is not a method
+  // token of the module. Sets the token and the code of resolved_method.
+  HRESULT FindMethodByName(IMetaDataImport *metadata_import,
+                           ICorDebugModule *debug_module, mdTypeDef type_def,
+                           PCCOR_SIGNATURE signature,
+                           ULONG method_virtual_addr,
+                           const std::vector<WCHAR> &method_name,
+                           ResolvedMethod *resolved_method);
+
+  // Activate a breakpoint in the module of module_metadata.
   // This function should only be used if breakpoint is already set, i.e.
   // the TryGetBreakpoint method is called on the breakpoint.
-  HRESULT ActivateBreakpointHelper(
-      DbgBreakpoint *breakpoint,
-      google_cloud_debugger_portable_pdb::IPortablePdbFile *portable_pdb);
+  HRESULT ActivateBreakpointHelper(DbgBreakpoint *breakpoint,
+                                   ModuleMetadata *module_metadata);
 
   // Helper function to get type definition token, signature, virtual address
   // and name of a method (identified using method_def).
@@ -103,9 +500,27 @@ class BreakpointCollection : public IBreakpointCollection {
                         ULONG *virtual_address,
                         std::vector<WCHAR> *method_name);
 
-  // Helper function to create and initialize a breakpoint client.
+  // Sets writer to breakpoint_writer_, creating it with the encodings
+  // the debugger is configured with the first time.
+  HRESULT GetBreakpointWriter(BreakpointWriter **writer);
+
+  // Reports the log points dropped by writer once in a while if
+  // enqueue_hr, the result of queuing a breakpoint, says it was dropped.
+  // Returns enqueue_hr.
+  HRESULT ReportDroppedBreakpoints(BreakpointWriter *writer,
+                                   HRESULT enqueue_hr);
+
+  // Connects client to the agent. With a duplex pipe, the read and write
+  // clients are the same client.
+  HRESULT ConnectBreakpointClient(std::shared_ptr<BreakpointClient> *client);
+
+  // Helper function to create and initialize a breakpoint client. If
+  // compress_breakpoints is true, the client compresses large breakpoints.
+  // If shared_memory is true, the bytes of the pipe go through memory
+  // shared with the agent.
   static HRESULT CreateAndInitializeBreakpointClient(
-      std::unique_ptr<BreakpointClient> *client, std::string pipe_name);
+      std::shared_ptr<BreakpointClient> *client, std::string pipe_name,
+      MessageFraming framing, bool compress_breakpoints, bool shared_memory);
 
   // COM Pointer to the DebuggerCallback that this breakpoint collection
   // is associated with. This is used to get the list of Portable PDB Files
@@ -113,18 +528,124 @@ class BreakpointCollection : public IBreakpointCollection {
   CComPtr<DebuggerCallback> debugger_callback_;
 
   // Named pipe server for reading breakpoints.
-  std::unique_ptr<BreakpointClient> breakpoint_client_read_;
+  std::shared_ptr<BreakpointClient> breakpoint_client_read_;
 
   // Named pipe server for writing breakpoints.
-  std::unique_ptr<BreakpointClient> breakpoint_client_write_;
+  std::shared_ptr<BreakpointClient> breakpoint_client_write_;
+
+  // The connection shared by breakpoint_client_read_ and
+  // breakpoint_client_write_ when the pipe is duplex.
+  std::shared_ptr<BreakpointClient> duplex_client_;
+
+  // Protects the creation of duplex_client_.
+  std::mutex duplex_client_mutex_;
+
+  // Writes breakpoints with breakpoint_client_write_ on its own thread.
+  // Declared after breakpoint_client_write_ so that it is destroyed,
+  // and its thread stopped, before the client.
+  std::unique_ptr<BreakpointWriter> breakpoint_writer_;
 
+  // Protects the creation of breakpoint_client_write_ and
+  // breakpoint_writer_.
+  std::mutex writer_mutex_;
+
+  // Serializes writers of breakpoint_table_ and pending_breakpoints_.
+  // Readers of breakpoint_table_ do not take this lock.
   std::mutex mutex_;
-};
 
-// Returns true if the first string and the second string are equal
-// ignoring case.
-bool EqualsIgnoreCase(const std::string &first_string,
-                      const std::string &second_string);
+  // Locations where breakpoints were found, kept across restarts of the
+  // debugger, and the file they are kept in or an empty string if they
+  // are not. location_cache_changed_ is true if location_cache_ was not
+  // written since it changed. Guarded by mutex_.
+  BreakpointLocationCache location_cache_;
+  std::string location_cache_file_;
+  bool location_cache_changed_ = false;
+
+  // Activated exception points keyed by ID. Guarded by mutex_.
+  std::unordered_map<std::string, std::shared_ptr<DbgBreakpoint>>
+      exception_points_;
+
+  // The filter of the activated exception points, or null if there are
+  // none. Only accessed with std::atomic_load and std::atomic_store.
+  std::shared_ptr<ExceptionPointFilter> exception_point_filter_;
+
+  // True if exception_point_filter_ is not null, so that exceptions are
+  // continued right away while there are no exception points.
+  std::atomic<bool> has_exception_points_{false};
+
+  // Activated breakpoints that are not in any PDB loaded so far, keyed
+  // by the normalized file name of their path. They are set when the
+  // module with their file is loaded.
+  std::unordered_map<std::string, std::vector<std::shared_ptr<DbgBreakpoint>>>
+      pending_breakpoints_;
+
+  // Time in microseconds the debuggee can spend stopped at log points.
+  RateLimiter log_point_cost_limiter_{kLogPointCostPerSecondUs,
+                                      kLogPointCostBurstUs};
+
+  // The last full version of each activated breakpoint read from the
+  // agent, keyed by ID. Used to complete the deltas the agent sends
+  // afterwards. Only accessed by SyncBreakpoints.
+  std::unordered_map<std::string,
+                     google::cloud::diagnostics::debug::Breakpoint>
+      synced_breakpoints_;
+
+  // Memory of breakpoint_table_ and pending_breakpoints_, not counting
+  // what the breakpoints point to.
+  ScopedMemoryCharge breakpoints_memory_{
+      &DebuggerMetrics::Global().breakpoint_collection_bytes};
+
+  // Memory of synced_breakpoints_, not counting its buckets.
+  ScopedMemoryCharge synced_breakpoints_memory_{
+      &DebuggerMetrics::Global().breakpoint_collection_bytes};
+
+  // Thread that reports the metrics of the debugger to the agent.
+  std::thread metrics_thread_;
+
+  // True once StopReportingMetrics is called.
+  bool stop_reporting_metrics_ = false;
+
+  // Protects metrics_thread_ and stop_reporting_metrics_.
+  std::mutex metrics_mutex_;
+
+  // Signaled when StopReportingMetrics is called.
+  std::condition_variable metrics_cv_;
+
+  // True once SetAttached is called.
+  bool attached_ = false;
+
+  // True once SyncBreakpoints is connected to the agent.
+  bool connected_ = false;
+
+  // True once the message with ID kReadyBreakpointId is written.
+  bool ready_written_ = false;
+
+  // Protects attached_, connected_ and ready_written_.
+  std::mutex ready_mutex_;
+
+  // Index of the next local breakpoint ReadBreakpoint reads. Only
+  // accessed by SyncBreakpoints.
+  std::size_t next_local_breakpoint_ = 0;
+
+  // True once CancelSyncBreakpoints is called with local breakpoints.
+  bool local_breakpoints_cancelled_ = false;
+
+  // Protects local_breakpoints_cancelled_.
+  std::mutex local_breakpoints_mutex_;
+
+  // Signaled when local_breakpoints_cancelled_ becomes true.
+  std::condition_variable local_breakpoints_cv_;
+
+  // Activates the breakpoints read by SyncBreakpoints, so that it can
+  // apply deactivations while activations search the PDBs. Declared last
+  // so that its thread is stopped before the members it uses are gone.
+  BreakpointActivationQueue activation_queue_{
+      [this](const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints) {
+        return ApplyBreakpointUpdates(breakpoints);
+      },
+      kMaximumBreakpointActivationBatch,
+      &DebuggerMetrics::Global().breakpoint_activations_cancelled};
+};
 
 }  // namespace google_cloud_debugger
 
@@ -0,0 +1,80 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "breakpoint_compressor.h"
+
+#include <iostream>
+
+using std::cerr;
+
+namespace google_cloud_debugger {
+
+// Size of the uncompressed size in front of the deflated bytes.
+static const std::size_t kUncompressedSizeSize = 4;
+
+BreakpointCompressor::~BreakpointCompressor() {
+#ifdef PLATFORM_UNIX
+  if (initialized_) {
+    deflateEnd(&stream_);
+  }
+#endif
+}
+
+bool BreakpointCompressor::Compress(const char *data, std::size_t size,
+                                    std::uint8_t *target,
+                                    std::size_t *written) {
+#ifdef PLATFORM_UNIX
+  // Compressing is only useful if the result is smaller than data.
+  if (!data || !target || !written || size <= kUncompressedSizeSize + 1 ||
+      size > UINT32_MAX) {
+    return false;
+  }
+
+  if (!initialized_) {
+    stream_ = z_stream();
+    // Negative window bits produce raw deflate without a zlib header.
+    int result = deflateInit2(&stream_, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS,
+                              8, Z_DEFAULT_STRATEGY);
+    if (result != Z_OK) {
+      cerr << "deflateInit2 error: " << result << std::endl;
+      return false;
+    }
+    initialized_ = true;
+  } else if (deflateReset(&stream_) != Z_OK) {
+    return false;
+  }
+
+  target[0] = static_cast<uint8_t>(size);
+  target[1] = static_cast<uint8_t>(size >> 8);
+  target[2] = static_cast<uint8_t>(size >> 16);
+  target[3] = static_cast<uint8_t>(size >> 24);
+
+  // deflate runs out of room, and fails, if the result would not be
+  // smaller than data.
+  stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  stream_.avail_in = static_cast<uInt>(size);
+  stream_.next_out = target + kUncompressedSizeSize;
+  stream_.avail_out = static_cast<uInt>(size - 1 - kUncompressedSizeSize);
+  if (deflate(&stream_, Z_FINISH) != Z_STREAM_END) {
+    return false;
+  }
+
+  *written = kUncompressedSizeSize + stream_.total_out;
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  //  namespace google_cloud_debugger
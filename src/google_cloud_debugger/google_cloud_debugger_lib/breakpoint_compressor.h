@@ -0,0 +1,61 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BREAKPOINT_COMPRESSOR_H_
+#define BREAKPOINT_COMPRESSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef PLATFORM_UNIX
+#include <zlib.h>
+#endif
+
+namespace google_cloud_debugger {
+
+// Compresses serialized breakpoints so that large snapshots take less
+// space on the pipe. A compressed breakpoint is the size of the serialized
+// breakpoint as a little-endian uint32 followed by the serialized
+// breakpoint compressed with raw deflate (RFC 1951).
+//
+// Compression uses zlib, which is only linked on unix. On other platforms
+// Compress always returns false and breakpoints are sent uncompressed.
+class BreakpointCompressor {
+ public:
+  BreakpointCompressor() = default;
+  BreakpointCompressor(const BreakpointCompressor &) = delete;
+  BreakpointCompressor &operator=(const BreakpointCompressor &) = delete;
+  ~BreakpointCompressor();
+
+  // Compresses size bytes of data into target, which must have room for
+  // size bytes, and sets written to the number of bytes written, which is
+  // less than size. Returns false if data cannot be compressed or would
+  // not get smaller, in which case it should be sent uncompressed.
+  bool Compress(const char *data, std::size_t size, std::uint8_t *target,
+                std::size_t *written);
+
+ private:
+#ifdef PLATFORM_UNIX
+  // The deflate stream, reused across breakpoints so that its state
+  // is only allocated once.
+  z_stream stream_;
+
+  // True once stream_ is initialized.
+  bool initialized_ = false;
+#endif
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  BREAKPOINT_COMPRESSOR_H_
@@ -0,0 +1,203 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "breakpoint_location_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "custom_binary_reader.h"
+
+using google_cloud_debugger_portable_pdb::CustomBinaryStream;
+using std::cerr;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Identifies a cache file.
+const char kCacheMagic[] = {'G', 'C', 'D', 'B', 'G', 'B', 'P', 'L'};
+
+// Version of the format of the cache file. Has to be incremented whenever
+// the format or the content of CachedBreakpointLocation changes.
+const uint32_t kCacheVersion = 1;
+
+// Name of the cache file.
+const string kCacheFileName = "breakpoint_locations.cache";
+
+// Size of a location with empty strings in the cache file.
+const uint32_t kMinimumLocationSize = 4 + 20 + 4 + 4 * 4;
+
+void AppendUInt32(uint32_t value, string *buffer) {
+  buffer->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void AppendString(const string &value, string *buffer) {
+  AppendUInt32(value.size(), buffer);
+  buffer->append(value);
+}
+
+bool ReadString(CustomBinaryStream *stream, uint32_t stream_size,
+                string *value) {
+  uint32_t size;
+  if (!stream->ReadUInt32(&size) || size > stream_size) {
+    return false;
+  }
+
+  value->resize(size);
+  uint32_t bytes_read;
+  return size == 0 ||
+         stream->ReadBytes(reinterpret_cast<uint8_t *>(&(*value)[0]), size,
+                           &bytes_read);
+}
+
+}  // namespace
+
+string BreakpointLocationCache::GetCacheFilePath(const string &directory) {
+  if (directory.empty() || directory.back() == '/' ||
+      directory.back() == '\\') {
+    return directory + kCacheFileName;
+  }
+  return directory + "/" + kCacheFileName;
+}
+
+bool BreakpointLocationCache::Read(const string &file) {
+  locations_.clear();
+
+  CustomBinaryStream stream;
+  if (!stream.ConsumeFile(file)) {
+    return false;
+  }
+
+  // Bound for the counts in the file.
+  uint32_t stream_size = stream.GetLength();
+
+  char magic[sizeof(kCacheMagic)];
+  uint32_t bytes_read;
+  uint32_t version;
+  uint32_t count;
+  if (!stream.ReadBytes(reinterpret_cast<uint8_t *>(magic), sizeof(magic),
+                        &bytes_read) ||
+      !std::equal(magic, magic + sizeof(magic), kCacheMagic) ||
+      !stream.ReadUInt32(&version) || version != kCacheVersion ||
+      !stream.ReadUInt32(&count) ||
+      static_cast<uint64_t>(count) * kMinimumLocationSize > stream_size) {
+    cerr << "Ignoring invalid breakpoint location cache file " << file;
+    return false;
+  }
+
+  std::unordered_map<string, CachedBreakpointLocation> locations;
+  for (uint32_t i = 0; i < count; ++i) {
+    string id;
+    CachedBreakpointLocation location;
+    if (!ReadString(&stream, stream_size, &id) ||
+        !stream.ReadBytes(location.pdb_id.data(), location.pdb_id.size(),
+                          &bytes_read) ||
+        !ReadString(&stream, stream_size, &location.file_path) ||
+        !stream.ReadUInt32(&location.line) ||
+        !stream.ReadUInt32(&location.method_def) ||
+        !stream.ReadUInt32(&location.il_offset) ||
+        !stream.ReadUInt32(&location.resolved_line)) {
+      cerr << "Ignoring invalid breakpoint location cache file " << file;
+      return false;
+    }
+    locations[id] = std::move(location);
+  }
+
+  locations_ = std::move(locations);
+  return true;
+}
+
+bool BreakpointLocationCache::Write(const string &file) const {
+  string buffer(kCacheMagic, sizeof(kCacheMagic));
+  AppendUInt32(kCacheVersion, &buffer);
+  AppendUInt32(locations_.size(), &buffer);
+  for (auto &&entry : locations_) {
+    const CachedBreakpointLocation &location = entry.second;
+    AppendString(entry.first, &buffer);
+    buffer.append(reinterpret_cast<const char *>(location.pdb_id.data()),
+                  location.pdb_id.size());
+    AppendString(location.file_path, &buffer);
+    AppendUInt32(location.line, &buffer);
+    AppendUInt32(location.method_def, &buffer);
+    AppendUInt32(location.il_offset, &buffer);
+    AppendUInt32(location.resolved_line, &buffer);
+  }
+
+  string temporary_file = file + ".tmp";
+  {
+    std::ofstream output(temporary_file,
+                         std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+      cerr << "Failed to open breakpoint location cache file "
+           << temporary_file;
+      return false;
+    }
+
+    output.write(buffer.data(), buffer.size());
+    if (!output.good()) {
+      cerr << "Failed to write breakpoint location cache file "
+           << temporary_file;
+      output.close();
+      std::remove(temporary_file.c_str());
+      return false;
+    }
+  }
+
+  // Unlike the PDB index cache, the content changes, so an existing file
+  // is replaced on Windows as well.
+  if (std::rename(temporary_file.c_str(), file.c_str()) != 0) {
+    std::remove(file.c_str());
+    if (std::rename(temporary_file.c_str(), file.c_str()) != 0) {
+      std::remove(temporary_file.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+const CachedBreakpointLocation *BreakpointLocationCache::Find(
+    const string &id) const {
+  const auto &location = locations_.find(id);
+  if (location == locations_.end()) {
+    return nullptr;
+  }
+  return &location->second;
+}
+
+bool BreakpointLocationCache::Set(const string &id,
+                                  const CachedBreakpointLocation &location) {
+  const auto &cached = locations_.find(id);
+  if (cached != locations_.end() &&
+      cached->second.pdb_id == location.pdb_id &&
+      cached->second.file_path == location.file_path &&
+      cached->second.line == location.line &&
+      cached->second.method_def == location.method_def &&
+      cached->second.il_offset == location.il_offset &&
+      cached->second.resolved_line == location.resolved_line) {
+    return false;
+  }
+
+  locations_[id] = location;
+  return true;
+}
+
+bool BreakpointLocationCache::Remove(const string &id) {
+  return locations_.erase(id) != 0;
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,83 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BREAKPOINT_LOCATION_CACHE_H_
+#define BREAKPOINT_LOCATION_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace google_cloud_debugger {
+
+// Where a breakpoint was found in the PDB of a module.
+struct CachedBreakpointLocation {
+  // The id of the PDB, which identifies the build of the module.
+  std::array<std::uint8_t, 20> pdb_id;
+
+  // The lowercase file path and the line the breakpoint was set at.
+  std::string file_path;
+  std::uint32_t line = 0;
+
+  // The method, IL offset and line of the sequence point the breakpoint
+  // was found at.
+  std::uint32_t method_def = 0;
+  std::uint32_t il_offset = 0;
+  std::uint32_t resolved_line = 0;
+};
+
+// On-disk cache of the locations breakpoints were found at, keyed by
+// breakpoint id.
+//
+// The cache is kept next to the PDB index cache (see PdbIndexCache). After
+// a restart of the debugger, the agent sets the same breakpoints again, and
+// a breakpoint whose module has the PDB id that is cached for it is set at
+// the cached location without searching the documents and sequence points
+// of the PDB. The file starts with a format version, so a stale or foreign
+// cache file is ignored.
+class BreakpointLocationCache {
+ public:
+  // Returns the path of the cache file in directory.
+  static std::string GetCacheFilePath(const std::string &directory);
+
+  // Replaces the locations of this cache with the ones saved in file.
+  // Returns false and leaves the cache empty if the file does not exist
+  // or is invalid.
+  bool Read(const std::string &file);
+
+  // Writes the locations of this cache to file. The content is written to
+  // a temporary file first and then renamed, so readers never see a
+  // partial file.
+  bool Write(const std::string &file) const;
+
+  // Returns the cached location of the breakpoint with id, or null if
+  // there is none.
+  const CachedBreakpointLocation *Find(const std::string &id) const;
+
+  // Caches location for the breakpoint with id. Returns false if that
+  // location is already cached.
+  bool Set(const std::string &id, const CachedBreakpointLocation &location);
+
+  // Removes the location of the breakpoint with id. Returns false if
+  // there is none.
+  bool Remove(const std::string &id);
+
+ private:
+  std::unordered_map<std::string, CachedBreakpointLocation> locations_;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // BREAKPOINT_LOCATION_CACHE_H_
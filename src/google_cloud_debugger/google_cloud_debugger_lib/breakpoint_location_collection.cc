@@ -20,17 +20,19 @@ namespace google_cloud_debugger {
 
 std::vector<std::shared_ptr<DbgBreakpoint>>
 BreakpointLocationCollection::GetBreakpoints() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<std::shared_ptr<DbgBreakpoint>> return_val = breakpoints_;
-  return return_val;
+  std::shared_ptr<const BreakpointVector> breakpoints =
+      std::atomic_load(&breakpoints_);
+  return *breakpoints;
 }
 
 HRESULT BreakpointLocationCollection::AddFirstBreakpoint(
     std::shared_ptr<DbgBreakpoint> breakpoint) {
+  std::lock_guard<std::mutex> lock(mutex_);
   // Initializes the cache.
   il_offset_ = breakpoint->GetILOffset();
   method_def_ = breakpoint->GetMethodDef();
   method_token_ = breakpoint->GetMethodToken();
+  module_base_address_ = breakpoint->GetModuleBaseAddress();
   method_name_ = breakpoint->GetMethodName();
   location_string_ = breakpoint->GetBreakpointLocation();
   HRESULT hr = breakpoint->GetCorDebugBreakpoint(&debug_breakpoint_);
@@ -38,12 +40,22 @@ HRESULT BreakpointLocationCollection::AddFirstBreakpoint(
     return hr;
   }
 
-  breakpoints_.push_back(std::move(breakpoint));
+  std::shared_ptr<BreakpointVector> new_breakpoints(
+      new (std::nothrow) BreakpointVector(*breakpoints_));
+  if (!new_breakpoints) {
+    return E_OUTOFMEMORY;
+  }
+
+  new_breakpoints->push_back(std::move(breakpoint));
+  std::atomic_store(&breakpoints_,
+                    std::shared_ptr<const BreakpointVector>(
+                        std::move(new_breakpoints)));
   return S_OK;
 }
 
 HRESULT BreakpointLocationCollection::UpdateBreakpoints(
     const DbgBreakpoint &breakpoint) {
+  std::lock_guard<std::mutex> lock(mutex_);
   HRESULT hr = UpdateExistingBreakpoint(breakpoint);
   if (FAILED(hr)) {
     cerr << "Failed to activate breakpoint.";
@@ -77,6 +89,7 @@ HRESULT BreakpointLocationCollection::UpdateBreakpoints(
   new_breakpoint->SetILOffset(il_offset_);
   new_breakpoint->SetMethodDef(method_def_);
   new_breakpoint->SetMethodToken(method_token_);
+  new_breakpoint->SetModuleBaseAddress(module_base_address_);
   new_breakpoint->SetMethodName(method_name_);
   new_breakpoint->SetCorDebugBreakpoint(debug_breakpoint_);
 
@@ -85,37 +98,66 @@ HRESULT BreakpointLocationCollection::UpdateBreakpoints(
     return hr;
   }
 
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    breakpoints_.push_back(std::move(new_breakpoint));
+  std::shared_ptr<BreakpointVector> new_breakpoints(
+      new (std::nothrow) BreakpointVector(*breakpoints_));
+  if (!new_breakpoints) {
+    return E_OUTOFMEMORY;
   }
+
+  new_breakpoints->push_back(std::move(new_breakpoint));
+  std::atomic_store(&breakpoints_,
+                    std::shared_ptr<const BreakpointVector>(
+                        std::move(new_breakpoints)));
   return hr;
 }
 
+bool BreakpointLocationCollection::DeactivatedBefore(
+    std::chrono::steady_clock::time_point time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return deactivated_ && breakpoints_->empty() && deactivated_at_ <= time;
+}
+
 HRESULT BreakpointLocationCollection::UpdateExistingBreakpoint(
     const DbgBreakpoint &breakpoint) {
-  std::lock_guard<std::mutex> lock(mutex_);
   const auto &existing_breakpoint = std::find_if(
-      breakpoints_.begin(), breakpoints_.end(),
-      [&](std::shared_ptr<DbgBreakpoint> &existing_bp) {
+      breakpoints_->begin(), breakpoints_->end(),
+      [&](const std::shared_ptr<DbgBreakpoint> &existing_bp) {
         return existing_bp->GetId().compare(breakpoint.GetId()) == 0;
       });
 
-  if (existing_breakpoint == breakpoints_.end()) {
+  if (existing_breakpoint == breakpoints_->end()) {
     return S_FALSE;
   }
 
-  HRESULT hr = ActivateCorDebugBreakpointHelper(breakpoint.Activated());
-  if (FAILED(hr)) {
-    return hr;
+  // Breakpoints in breakpoints_ are active, so re-sending an active
+  // breakpoint does not change anything.
+  if (breakpoint.Activated() && (*existing_breakpoint)->Activated()) {
+    return S_OK;
   }
 
-  // Remove deactivated breakpoint.
-  if (!breakpoint.Activated()) {
-    breakpoints_.erase(existing_breakpoint);
+  if (breakpoint.Activated()) {
+    return ActivateCorDebugBreakpointHelper(TRUE);
   }
 
-  return hr;
+  // Remove deactivated breakpoint. It is removed before the
+  // ICorDebugBreakpoint is deactivated, which only happens once no
+  // active breakpoint is left.
+  std::shared_ptr<BreakpointVector> new_breakpoints(
+      new (std::nothrow) BreakpointVector());
+  if (!new_breakpoints) {
+    return E_OUTOFMEMORY;
+  }
+
+  new_breakpoints->reserve(breakpoints_->size() - 1);
+  for (auto it = breakpoints_->begin(); it != breakpoints_->end(); ++it) {
+    if (it != existing_breakpoint) {
+      new_breakpoints->push_back(*it);
+    }
+  }
+  std::atomic_store(&breakpoints_,
+                    std::shared_ptr<const BreakpointVector>(
+                        std::move(new_breakpoints)));
+  return ActivateCorDebugBreakpointHelper(FALSE);
 }
 
 HRESULT BreakpointLocationCollection::ActivateCorDebugBreakpointHelper(
@@ -139,11 +181,11 @@ HRESULT BreakpointLocationCollection::ActivateCorDebugBreakpointHelper(
     // ICorDebugBreakpoint.
     if (!activation_state) {
       const auto &existing_active_breakpoint =
-          std::find_if(breakpoints_.begin(), breakpoints_.end(),
-                       [&](std::shared_ptr<DbgBreakpoint> &existing_bp) {
+          std::find_if(breakpoints_->begin(), breakpoints_->end(),
+                       [&](const std::shared_ptr<DbgBreakpoint> &existing_bp) {
                          return existing_bp->Activated();
                        });
-      if (existing_active_breakpoint != breakpoints_.end()) {
+      if (existing_active_breakpoint != breakpoints_->end()) {
         return S_OK;
       }
 
@@ -157,6 +199,10 @@ HRESULT BreakpointLocationCollection::ActivateCorDebugBreakpointHelper(
     }
   }
 
+  if (!activation_state && !deactivated_) {
+    deactivated_at_ = std::chrono::steady_clock::now();
+  }
+  deactivated_ = !activation_state;
   return S_OK;
 }
 
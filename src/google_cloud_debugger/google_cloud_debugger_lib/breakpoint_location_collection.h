@@ -15,6 +15,7 @@
 #ifndef BREAKPOINT_LOCATION_COLLECTION_H_
 #define BREAKPOINT_LOCATION_COLLECTION_H_
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -30,6 +31,7 @@ namespace google_cloud_debugger {
 class BreakpointLocationCollection {
  public:
   // Returns a vector containing all the breakpoints at this location.
+  // This does not block on UpdateBreakpoints.
   std::vector<std::shared_ptr<DbgBreakpoint>> GetBreakpoints();
 
   // Add the first breakpoint at this location to this collection.
@@ -60,22 +62,39 @@ class BreakpointLocationCollection {
   // Returns the method token of breakpoints at this location.
   mdMethodDef GetMethodToken() { return method_token_; }
 
+  // Returns the base address of the module of breakpoints at this location.
+  CORDB_ADDRESS GetModuleBaseAddress() { return module_base_address_; }
+
+  // Returns true if there has been no breakpoint at this location, and its
+  // ICorDebugBreakpoint has been deactivated, since before time. Until
+  // then, the location is kept so that a breakpoint set at it again
+  // reactivates the ICorDebugBreakpoint instead of creating a new one.
+  bool DeactivatedBefore(std::chrono::steady_clock::time_point time);
+
  private:
-  // Mutex to protect breakpoints_ vector from multiple access.
+  // Vector of breakpoints. Published versions are never modified.
+  typedef std::vector<std::shared_ptr<DbgBreakpoint>> BreakpointVector;
+
+  // Mutex to serialize writers of breakpoints_. Readers do not take it.
   std::mutex mutex_;
 
   // Helper function to update an existing breakpoint in breakpoints_ that
   // has the same ID as that of an existing breakpoint.
+  // Must be called with mutex_ held.
   HRESULT UpdateExistingBreakpoint(const DbgBreakpoint &breakpoint);
 
   // Activate the ICorDebugBreakpoint at this location.
   // Provide FALSE to deactivate the breakpoint.
   // Deactivation will only succeed if none of the existing breakpoints
   // are in an active state.
+  // Must be called with mutex_ held.
   HRESULT ActivateCorDebugBreakpointHelper(BOOL activation_state);
 
-  // Collection of breakpoints at this location.
-  std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints_;
+  // Collection of breakpoints at this location. Writers copy the vector,
+  // modify the copy and atomically swap it in so a breakpoint hit can
+  // read it without waiting on the writers.
+  std::shared_ptr<const BreakpointVector> breakpoints_ =
+      std::make_shared<BreakpointVector>();
 
   // The IL Offset of breakpoints at this location.
   uint32_t il_offset_;
@@ -86,6 +105,9 @@ class BreakpointLocationCollection {
   // The method token of the method of breakpoints at this location.
   mdMethodDef method_token_;
 
+  // The base address of the module of breakpoints at this location.
+  CORDB_ADDRESS module_base_address_ = 0;
+
   // The name of the method of breakpoints at this location.
   std::vector<WCHAR> method_name_;
 
@@ -93,6 +115,11 @@ class BreakpointLocationCollection {
   // location.
   CComPtr<ICorDebugBreakpoint> debug_breakpoint_;
 
+  // True if debug_breakpoint_ was deactivated because there are no
+  // breakpoints at this location, and when it was.
+  bool deactivated_ = false;
+  std::chrono::steady_clock::time_point deactivated_at_;
+
   // String that represents the location.
   std::string location_string_;
 };
@@ -0,0 +1,54 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "breakpoint_pool.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using std::unique_ptr;
+
+namespace google_cloud_debugger {
+
+unique_ptr<Breakpoint> BreakpointPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pool_.empty()) {
+      unique_ptr<Breakpoint> breakpoint = std::move(pool_.back());
+      pool_.pop_back();
+      return breakpoint;
+    }
+  }
+
+  return unique_ptr<Breakpoint>(new (std::nothrow) Breakpoint());
+}
+
+void BreakpointPool::Release(unique_ptr<Breakpoint> breakpoint) {
+  if (!breakpoint ||
+      breakpoint->ByteSizeLong() > kMaximumPooledBreakpointSize) {
+    return;
+  }
+
+  // Clears outside of the lock.
+  breakpoint->Clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pool_.size() < capacity_) {
+    pool_.push_back(std::move(breakpoint));
+  }
+}
+
+std::size_t BreakpointPool::GetSize() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pool_.size();
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,69 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BREAKPOINT_POOL_H_
+#define BREAKPOINT_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "breakpoint.pb.h"
+#include "constants.h"
+
+namespace google_cloud_debugger {
+
+// A pool of cleared Breakpoint messages. Clearing a protobuf message keeps
+// the memory of its strings and of the elements of its repeated fields,
+// so a snapshot built in a message taken from the pool reuses the
+// StackFrame and Variable messages of the snapshot it held before instead
+// of allocating them again.
+class BreakpointPool {
+ public:
+  // Creates a pool that keeps at most capacity breakpoints.
+  explicit BreakpointPool(std::size_t capacity) : capacity_(capacity) {}
+  BreakpointPool(const BreakpointPool &) = delete;
+  BreakpointPool &operator=(const BreakpointPool &) = delete;
+
+  // Returns an empty breakpoint, reusing a pooled one if there is any.
+  // Returns nullptr if it runs out of memory.
+  std::unique_ptr<google::cloud::diagnostics::debug::Breakpoint> Acquire();
+
+  // Clears breakpoint and keeps it for reuse. The breakpoint is freed
+  // instead if the pool is full or if it is larger than
+  // kMaximumPooledBreakpointSize, so that an unusually large snapshot
+  // does not keep its memory around.
+  void Release(
+      std::unique_ptr<google::cloud::diagnostics::debug::Breakpoint>
+          breakpoint);
+
+  // Returns the number of breakpoints in the pool.
+  std::size_t GetSize();
+
+ private:
+  // Maximum number of breakpoints in pool_.
+  std::size_t capacity_;
+
+  // Cleared breakpoints waiting to be reused.
+  std::vector<std::unique_ptr<google::cloud::diagnostics::debug::Breakpoint>>
+      pool_;
+
+  // Protects pool_.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  BREAKPOINT_POOL_H_
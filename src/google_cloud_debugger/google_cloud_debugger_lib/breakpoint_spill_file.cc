@@ -0,0 +1,97 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "breakpoint_spill_file.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using std::string;
+
+namespace google_cloud_debugger {
+
+// The size of the length that precedes each breakpoint.
+static const std::uint64_t kSpillLengthSize = 4;
+
+bool BreakpointSpillFile::Open(const string &path, std::uint64_t capacity) {
+  file_.open(path, std::ios::in | std::ios::out | std::ios::binary |
+                       std::ios::trunc);
+  capacity_ = capacity;
+  Clear();
+  return file_.is_open();
+}
+
+bool BreakpointSpillFile::Append(const Breakpoint &breakpoint) {
+  if (!file_.is_open() || !breakpoint.SerializeToString(&message_)) {
+    return false;
+  }
+  if (write_offset_ + kSpillLengthSize + message_.size() > capacity_) {
+    return false;
+  }
+
+  std::uint32_t size = static_cast<std::uint32_t>(message_.size());
+  char length[kSpillLengthSize];
+  for (std::uint64_t i = 0; i < kSpillLengthSize; ++i) {
+    length[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+  }
+  file_.seekp(write_offset_);
+  file_.write(length, sizeof(length));
+  file_.write(message_.data(), message_.size());
+  if (!file_.good()) {
+    // The breakpoints appended before are still readable, as only
+    // write_offset_ tells where they end.
+    file_.clear();
+    return false;
+  }
+
+  write_offset_ += kSpillLengthSize + message_.size();
+  return true;
+}
+
+bool BreakpointSpillFile::ReadNext(Breakpoint *breakpoint) {
+  if (Empty()) {
+    return false;
+  }
+
+  unsigned char length[kSpillLengthSize];
+  file_.seekg(read_offset_);
+  file_.read(reinterpret_cast<char *>(length), sizeof(length));
+  std::uint32_t size = 0;
+  for (std::uint64_t i = 0; i < kSpillLengthSize; ++i) {
+    size |= static_cast<std::uint32_t>(length[i]) << (8 * i);
+  }
+  bool read =
+      file_.good() && read_offset_ + kSpillLengthSize + size <= write_offset_;
+  if (read) {
+    message_.resize(size);
+    file_.read(&message_[0], size);
+    read = file_.good() && breakpoint->ParseFromString(message_);
+  }
+  if (!read) {
+    file_.clear();
+    Clear();
+    return false;
+  }
+
+  read_offset_ += kSpillLengthSize + size;
+  if (Empty()) {
+    Clear();
+  }
+  return true;
+}
+
+void BreakpointSpillFile::Clear() {
+  read_offset_ = 0;
+  write_offset_ = 0;
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,76 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BREAKPOINT_SPILL_FILE_H_
+#define BREAKPOINT_SPILL_FILE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// A bounded first-in first-out queue of breakpoints on disk. BreakpointWriter
+// appends the breakpoints that do not fit in its queue to it while the agent
+// is slow to read them, and writes them once it catches up.
+//
+// Each breakpoint is stored as in SnapshotRecorder: its 4-byte little-endian
+// length followed by the serialized Breakpoint. The file is reused from its
+// start every time it is drained.
+//
+// Not thread-safe.
+class BreakpointSpillFile {
+ public:
+  // Creates or truncates the file at path, which holds at most capacity
+  // bytes of breakpoints. Returns false if it cannot be created.
+  bool Open(const std::string &path, std::uint64_t capacity);
+
+  // Appends breakpoint to the file. Returns false if the file is full or
+  // cannot be written.
+  bool Append(const google::cloud::diagnostics::debug::Breakpoint &breakpoint);
+
+  // Reads the oldest breakpoint appended into breakpoint and removes it from
+  // the file. Returns false if the file is empty or cannot be read, in which
+  // case the breakpoints still in the file are discarded.
+  bool ReadNext(google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+  // Returns true if no breakpoint is waiting in the file.
+  bool Empty() const { return read_offset_ == write_offset_; }
+
+  // Returns the number of bytes of the breakpoints waiting in the file.
+  std::uint64_t GetSize() const { return write_offset_ - read_offset_; }
+
+ private:
+  // Discards the breakpoints in the file.
+  void Clear();
+
+  // The spill file, read and written at the offsets below.
+  std::fstream file_;
+
+  // The maximum value of write_offset_.
+  std::uint64_t capacity_ = 0;
+
+  // Where the oldest breakpoint starts and where the next one is appended.
+  std::uint64_t read_offset_ = 0;
+  std::uint64_t write_offset_ = 0;
+
+  // Buffer of the serialized breakpoint, reused across breakpoints.
+  std::string message_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  BREAKPOINT_SPILL_FILE_H_
@@ -0,0 +1,216 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "breakpoint_writer.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "cpu_sampler.h"
+#include "thread_scheduling.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using std::cerr;
+using std::unique_ptr;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+BreakpointWriter::BreakpointWriter(WriteFunction write, std::size_t capacity,
+                                   BreakpointWriteOverflow overflow)
+    : write_(std::move(write)),
+      capacity_(capacity == 0 ? 1 : capacity),
+      overflow_(overflow) {}
+
+BreakpointWriter::~BreakpointWriter() { Stop(); }
+
+bool BreakpointWriter::SetSpillFile(const std::string &path,
+                                    std::uint64_t capacity) {
+  unique_ptr<BreakpointSpillFile> spill(new (std::nothrow)
+                                            BreakpointSpillFile());
+  if (!spill || !spill->Open(path, capacity)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  spill_ = std::move(spill);
+  return true;
+}
+
+HRESULT BreakpointWriter::Enqueue(const Breakpoint &breakpoint) {
+  // Copies outside of the lock into a message that reuses the memory of
+  // a breakpoint written before.
+  unique_ptr<Breakpoint> queued = pool_.Acquire();
+  if (!queued) {
+    return E_OUTOFMEMORY;
+  }
+  queued->CopyFrom(breakpoint);
+  return EnqueueMessage(std::move(queued));
+}
+
+HRESULT BreakpointWriter::EnqueueSwapped(Breakpoint *breakpoint) {
+  if (!breakpoint) {
+    return E_INVALIDARG;
+  }
+
+  // Both messages are on the heap, so swapping them only swaps their
+  // pointers. breakpoint gets the cleared message from the pool.
+  unique_ptr<Breakpoint> queued = pool_.Acquire();
+  if (!queued) {
+    return E_OUTOFMEMORY;
+  }
+  queued->Swap(breakpoint);
+  return EnqueueMessage(std::move(queued));
+}
+
+HRESULT BreakpointWriter::EnqueueMessage(unique_ptr<Breakpoint> queued) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return E_ABORT;
+    }
+
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&BreakpointWriter::WriteBreakpoints, this);
+    }
+
+    if (!HasRoom()) {
+      // Appending to the file takes far less than waiting for an agent
+      // that is not reading.
+      if (spill_ && spill_->Append(*queued)) {
+        ++spilled_count_;
+        lock.unlock();
+        pool_.Release(std::move(queued));
+        queued_cv_.notify_one();
+        return S_OK;
+      }
+
+      if (overflow_ == BreakpointWriteOverflow::kDropLogPoints &&
+          queued->log_point()) {
+        ++dropped_count_;
+        return S_FALSE;
+      }
+
+      space_cv_.wait(lock, [this] { return stopping_ || HasRoom(); });
+      if (stopping_) {
+        return E_ABORT;
+      }
+    }
+
+    queue_.push_back(std::move(queued));
+  }
+
+  queued_cv_.notify_one();
+  return S_OK;
+}
+
+void BreakpointWriter::Stop() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    std::swap(thread, thread_);
+  }
+  queued_cv_.notify_all();
+  space_cv_.notify_all();
+
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool BreakpointWriter::HasRoom() const {
+  return queue_.size() < capacity_ && (!spill_ || spill_->Empty());
+}
+
+void BreakpointWriter::ReadSpilledBreakpoints(
+    vector<unique_ptr<Breakpoint>> *taken) {
+  while (taken->size() < kMaximumBreakpointWriteBatch && !spill_->Empty()) {
+    unique_ptr<Breakpoint> spilled = pool_.Acquire();
+    if (!spilled) {
+      return;
+    }
+
+    std::uint64_t size = spill_->GetSize();
+    if (!spill_->ReadNext(spilled.get())) {
+      cerr << "Failed to read spilled breakpoints; " << size
+           << " bytes of them are discarded." << std::endl;
+      pool_.Release(std::move(spilled));
+      return;
+    }
+    taken->push_back(std::move(spilled));
+  }
+}
+
+void BreakpointWriter::WriteBreakpoints() {
+  CpuSampler::RegisterThread("breakpoint_writer");
+  ThreadScheduling::Global().ApplyToBackgroundThread();
+
+  // Protobuf messages have no move constructor, so the queued breakpoints
+  // are swapped into batch to be written and swapped back afterwards.
+  vector<unique_ptr<Breakpoint>> taken;
+  vector<Breakpoint> batch;
+  batch.reserve(kMaximumBreakpointWriteBatch);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queued_cv_.wait(lock, [this] {
+        return stopping_ || !queue_.empty() || (spill_ && !spill_->Empty());
+      });
+      if (queue_.empty() && (!spill_ || spill_->Empty())) {
+        // Only reached when stopping, after everything queued is written.
+        return;
+      }
+
+      std::size_t count =
+          std::min<std::size_t>(queue_.size(), kMaximumBreakpointWriteBatch);
+      taken.clear();
+      for (std::size_t i = 0; i < count; ++i) {
+        taken.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+
+      // The spilled breakpoints are only written after the queued ones.
+      if (taken.empty()) {
+        ReadSpilledBreakpoints(&taken);
+      }
+    }
+    space_cv_.notify_all();
+    if (taken.empty()) {
+      continue;
+    }
+
+    batch.resize(taken.size());
+    for (std::size_t i = 0; i < taken.size(); ++i) {
+      batch[i].Swap(taken[i].get());
+    }
+
+    HRESULT hr = write_(batch);
+    ++batch_count_;
+    if (FAILED(hr)) {
+      cerr << "Failed to write " << batch.size()
+           << " breakpoints: " << std::hex << hr << std::dec << std::endl;
+      failed_count_ += batch.size();
+    } else {
+      written_count_ += batch.size();
+    }
+
+    for (std::size_t i = 0; i < taken.size(); ++i) {
+      taken[i]->Swap(&batch[i]);
+      pool_.Release(std::move(taken[i]));
+    }
+  }
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,168 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BREAKPOINT_WRITER_H_
+#define BREAKPOINT_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpoint.pb.h"
+#include "breakpoint_pool.h"
+#include "breakpoint_spill_file.h"
+#include "constants.h"
+#include "cor.h"
+
+namespace google_cloud_debugger {
+
+// Writes breakpoints to the agent on a dedicated thread so that the threads
+// evaluating breakpoints do not wait for the agent to read them.
+// Breakpoints are kept in a bounded queue; all the breakpoints queued while
+// a write is in progress are written together by the next write.
+// The thread is started by the first call to Enqueue.
+class BreakpointWriter {
+ public:
+  // Writes a batch of breakpoints to the agent and returns an HRESULT.
+  // The breakpoints are cleared once written, so it may change them.
+  typedef std::function<HRESULT(
+      std::vector<google::cloud::diagnostics::debug::Breakpoint> &)>
+      WriteFunction;
+
+  // Creates a writer that writes with write and queues at most
+  // capacity breakpoints (at least 1).
+  BreakpointWriter(WriteFunction write, std::size_t capacity,
+                   BreakpointWriteOverflow overflow);
+  BreakpointWriter(const BreakpointWriter &) = delete;
+  BreakpointWriter &operator=(const BreakpointWriter &) = delete;
+
+  // Calls Stop.
+  ~BreakpointWriter();
+
+  // Makes Enqueue append breakpoints to the file at path while the queue
+  // is full, up to capacity bytes, instead of waiting or dropping them.
+  // Once a breakpoint is spilled, the next ones are spilled too until the
+  // writer thread drains the file, so that they are written in order.
+  // Has to be called before the first Enqueue. Returns false if the file
+  // cannot be created.
+  bool SetSpillFile(const std::string &path, std::uint64_t capacity);
+
+  // Queues a copy of breakpoint to be written. Returns S_OK if it is
+  // queued or spilled, S_FALSE if it is dropped because the queue and the
+  // spill file are full and E_ABORT if the writer is stopped.
+  HRESULT Enqueue(
+      const google::cloud::diagnostics::debug::Breakpoint &breakpoint);
+
+  // Queues breakpoint like Enqueue, but takes its contents instead of
+  // copying them, so that a large snapshot is handed over in constant
+  // time. breakpoint is left empty, even if it is dropped.
+  HRESULT EnqueueSwapped(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+  // Stops accepting breakpoints, waits for the queued breakpoints to be
+  // written and joins the writer thread.
+  void Stop();
+
+  // Returns the number of breakpoints written successfully.
+  std::uint64_t GetWrittenCount() const { return written_count_; }
+
+  // Returns the number of breakpoints dropped because the queue was full.
+  std::uint64_t GetDroppedCount() const { return dropped_count_; }
+
+  // Returns the number of breakpoints appended to the spill file.
+  std::uint64_t GetSpilledCount() const { return spilled_count_; }
+
+  // Returns the number of breakpoints whose write failed.
+  std::uint64_t GetFailedCount() const { return failed_count_; }
+
+  // Returns the number of writes, each of which writes a batch
+  // of breakpoints.
+  std::uint64_t GetBatchCount() const { return batch_count_; }
+
+ private:
+  // Queues queued, a message taken from pool_, or drops it. Implements
+  // Enqueue and EnqueueSwapped.
+  HRESULT EnqueueMessage(
+      std::unique_ptr<google::cloud::diagnostics::debug::Breakpoint> queued);
+
+  // Returns true if a breakpoint can be added to queue_. Has to be called
+  // with mutex_ held.
+  bool HasRoom() const;
+
+  // Moves up to kMaximumBreakpointWriteBatch breakpoints from the spill
+  // file into taken. Has to be called with mutex_ held.
+  void ReadSpilledBreakpoints(
+      std::vector<
+          std::unique_ptr<google::cloud::diagnostics::debug::Breakpoint>>
+          *taken);
+
+  // Loop of the writer thread: writes the queued breakpoints until
+  // the writer is stopped and the queue is empty.
+  void WriteBreakpoints();
+
+  // Writes the batches of breakpoints.
+  WriteFunction write_;
+
+  // Maximum number of breakpoints in queue_.
+  std::size_t capacity_;
+
+  // What Enqueue does when queue_ is full.
+  BreakpointWriteOverflow overflow_;
+
+  // Breakpoints waiting to be written. They are copied into messages
+  // taken from pool_ and given back to it once written.
+  std::deque<std::unique_ptr<google::cloud::diagnostics::debug::Breakpoint>>
+      queue_;
+
+  // Written breakpoints kept for reuse by Enqueue.
+  BreakpointPool pool_{kMaximumBreakpointWriteBatch};
+
+  // Breakpoints enqueued while queue_ is full, if a spill file is set.
+  // They are newer than the ones in queue_.
+  std::unique_ptr<BreakpointSpillFile> spill_;
+
+  // True once Stop is called.
+  bool stopping_ = false;
+
+  // The writer thread.
+  std::thread thread_;
+
+  // Protects queue_, spill_, stopping_ and thread_.
+  std::mutex mutex_;
+
+  // Signaled when a breakpoint is queued or the writer is stopped.
+  std::condition_variable queued_cv_;
+
+  // Signaled when the writer thread takes breakpoints out of queue_.
+  std::condition_variable space_cv_;
+
+  // Counters of breakpoints and writes.
+  std::atomic<std::uint64_t> written_count_{0};
+  std::atomic<std::uint64_t> dropped_count_{0};
+  std::atomic<std::uint64_t> spilled_count_{0};
+  std::atomic<std::uint64_t> failed_count_{0};
+  std::atomic<std::uint64_t> batch_count_{0};
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  BREAKPOINT_WRITER_H_
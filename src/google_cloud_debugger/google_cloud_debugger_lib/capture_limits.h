@@ -0,0 +1,132 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CAPTURE_LIMITS_H_
+#define CAPTURE_LIMITS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "capture_mask.h"
+#include "constants.h"
+
+namespace google_cloud_debugger {
+
+// Which items of an array or a list longer than max_collection_items are
+// captured.
+enum class ArrayCaptureMode {
+  // The first items.
+  kHead,
+  // The first and the last items, half of them each.
+  kHeadAndTail,
+  // Items evenly spread over the whole array, starting with the first.
+  kStrided,
+  // The items starting at array_range_start.
+  kRange,
+};
+
+// Limits on how much of the variables is captured in one snapshot.
+// Every capture uses its own limits, which are passed down to the
+// objects that are being captured, so that breakpoints can be captured
+// with different limits at the same time.
+struct CaptureLimits {
+  // Maximum number of items of a collection that is captured.
+  std::uint32_t max_collection_items = kDefaultMaxCollectionItems;
+
+  // Which items of a collection with more than max_collection_items
+  // items are captured. Only applies to arrays and to the collections
+  // backed by one, like List<T>.
+  ArrayCaptureMode array_capture_mode = ArrayCaptureMode::kHead;
+
+  // Index of the first item captured with ArrayCaptureMode::kRange.
+  std::uint32_t array_range_start = 0;
+
+  // Maximum number of levels of members that is captured below a
+  // variable.
+  int max_depth = kDefaultObjectEvalDepth;
+
+  // Maximum number of bytes of a value that is captured. Longer values
+  // are truncated. Zero means no limit.
+  std::uint32_t max_string_length = 0;
+
+  // Maximum size in bytes of an object or array whose members are
+  // captured. Larger ones are captured with their type and size only.
+  // Zero means no limit.
+  std::uint32_t max_object_bytes = 0;
+
+  // Maximum size of the breakpoint message in bytes.
+  std::uint32_t max_bytes = kDefaultMaxSnapshotBytes;
+
+  // Maximum number of stack frames captured.
+  std::uint32_t max_stack_frames = kDefaultMaxStackFrames;
+
+  // Maximum number of the stack frames captured with their local
+  // variables and method arguments.
+  std::uint32_t max_stack_frames_with_variables =
+      kDefaultMaxStackFramesWithVariables;
+
+  // Maximum time in milliseconds the snapshot is captured for while the
+  // thread is stopped. What is captured by then is written, and the
+  // variables that are not are marked with kCaptureDeadlineExceeded.
+  // Zero means no limit, which is the default.
+  std::uint32_t max_capture_time_ms = 0;
+
+  // When the capture has to stop, which StartDeadline sets from
+  // max_capture_time_ms. The maximum time point means never.
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+
+  // Starts the capture time of a snapshot captured with these limits.
+  void StartDeadline() {
+    if (max_capture_time_ms != 0) {
+      deadline = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(max_capture_time_ms);
+    }
+  }
+
+  // Returns true if the deadline of the capture passed. Only reads the
+  // clock if there is a deadline.
+  bool DeadlineExceeded() const {
+    return deadline != std::chrono::steady_clock::time_point::max() &&
+           std::chrono::steady_clock::now() >= deadline;
+  }
+
+  // If set, only the local variables and method arguments on the paths
+  // of the mask are captured in full. The others are captured with just
+  // their names and types.
+  std::shared_ptr<const CaptureMask> capture_mask;
+
+  // If set, objects of classes with a DebuggerDisplay attribute whose
+  // format only reads members are captured as the string the format
+  // gives, instead of with their members.
+  bool debugger_display = false;
+
+  // Default maximum number of items of a collection captured when not
+  // evaluating an expression.
+  static const std::uint32_t kDefaultMaxCollectionItems = 10;
+
+  // Default maximum size of a breakpoint message (65536 bytes = 64kb).
+  static const std::uint32_t kDefaultMaxSnapshotBytes = 65536;
+
+  // Default maximum number of stack frames captured.
+  static const std::uint32_t kDefaultMaxStackFrames = 20;
+
+  // Default maximum number of stack frames captured with variables.
+  static const std::uint32_t kDefaultMaxStackFramesWithVariables = 4;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // CAPTURE_LIMITS_H_
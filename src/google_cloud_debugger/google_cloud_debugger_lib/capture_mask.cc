@@ -0,0 +1,152 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "capture_mask.h"
+
+#include <cctype>
+#include <new>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+// Splits path into the names of its members, the way they are named in
+// variable protos. "order.Items[0].Price" becomes "order", "Items", "[0]"
+// and "Price". Returns false if path is not valid.
+static bool SplitPath(const string &path, vector<string> *names) {
+  size_t position = 0;
+  while (position < path.size()) {
+    if (path[position] == '[') {
+      size_t end = path.find(']', position);
+      if (end == string::npos || end == position + 1) {
+        return false;
+      }
+      names->push_back(path.substr(position, end - position + 1));
+      position = end + 1;
+    } else {
+      size_t end = path.find_first_of(".[", position);
+      if (end == string::npos) {
+        end = path.size();
+      }
+      if (end == position) {
+        return false;
+      }
+      names->push_back(path.substr(position, end - position));
+      position = end;
+    }
+
+    if (position < path.size() && path[position] == '.') {
+      ++position;
+      // The path cannot end with a period.
+      if (position == path.size()) {
+        return false;
+      }
+    }
+  }
+
+  return !names->empty();
+}
+
+// Removes the spaces at the beginning and the end of text.
+static string Trim(const string &text) {
+  size_t first = 0;
+  while (first < text.size() &&
+         isspace(static_cast<unsigned char>(text[first]))) {
+    ++first;
+  }
+  size_t last = text.size();
+  while (last > first && isspace(static_cast<unsigned char>(text[last - 1]))) {
+    --last;
+  }
+  return text.substr(first, last - first);
+}
+
+bool CaptureMask::Parse(const string &paths, CaptureMask *mask) {
+  if (!mask) {
+    return false;
+  }
+
+  size_t position = 0;
+  while (position <= paths.size()) {
+    size_t end = paths.find(',', position);
+    if (end == string::npos) {
+      end = paths.size();
+    }
+    if (!mask->AddPath(Trim(paths.substr(position, end - position)))) {
+      return false;
+    }
+    position = end + 1;
+  }
+  return true;
+}
+
+const CaptureMask *CaptureMask::GetMember(const string &name) const {
+  auto member = members_.find(name);
+  if (member == members_.end()) {
+    return nullptr;
+  }
+  return member->second.get();
+}
+
+bool CaptureMask::AddPath(const string &path) {
+  string member_path = path;
+  int depth = 0;
+  size_t colon = path.rfind(':');
+  if (colon != string::npos) {
+    string depth_string = Trim(path.substr(colon + 1));
+    if (depth_string.empty() || depth_string.size() > 4) {
+      return false;
+    }
+    for (char digit : depth_string) {
+      if (!isdigit(static_cast<unsigned char>(digit))) {
+        return false;
+      }
+    }
+    depth = std::stoi(depth_string);
+    if (depth == 0) {
+      return false;
+    }
+    member_path = Trim(path.substr(0, colon));
+  }
+
+  vector<string> names;
+  if (!SplitPath(member_path, &names)) {
+    return false;
+  }
+
+  CaptureMask *node = this;
+  for (const string &name : names) {
+    std::unique_ptr<CaptureMask> &member = node->members_[name];
+    if (!member) {
+      member.reset(new (std::nothrow) CaptureMask());
+      if (!member) {
+        return false;
+      }
+    }
+    node = member.get();
+  }
+
+  // Of two paths to the same member, the deeper one wins. A path without
+  // a depth uses the depth of the capture, which wins over both.
+  if (!node->target_ || depth == 0 ||
+      (node->depth_ != 0 && depth > node->depth_)) {
+    node->depth_ = depth;
+  }
+  node->target_ = true;
+  return true;
+}
+
+}  // namespace google_cloud_debugger
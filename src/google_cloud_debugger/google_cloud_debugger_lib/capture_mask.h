@@ -0,0 +1,69 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CAPTURE_MASK_H_
+#define CAPTURE_MASK_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace google_cloud_debugger {
+
+// The member paths of the variables of a snapshot that are captured when
+// not all of them are, for example "request.Headers" or
+// "order.Items[0].Price". Every node of the mask is the member of its
+// parent with the same name. A node that a path ends at is a target:
+// the variable is captured in full, down to the depth of the path.
+// Variables on the way to a target only have their members on a path
+// captured, and their other members are captured with name and type.
+class CaptureMask {
+ public:
+  // Parses paths, which are separated by commas, into mask. A path can
+  // end with ":depth", which is the number of levels of members captured
+  // like CaptureLimits::max_depth for a local variable. Returns false if
+  // any of the paths is not valid.
+  static bool Parse(const std::string &paths, CaptureMask *mask);
+
+  // Returns the node of member name, or nullptr if no path goes through
+  // the member.
+  const CaptureMask *GetMember(const std::string &name) const;
+
+  // Returns true if a path ends at this node.
+  bool IsTarget() const { return target_; }
+
+  // Returns the depth the variable of a target is captured to, or 0 to
+  // use the depth of the capture.
+  int GetDepth() const { return depth_; }
+
+  // Returns true if the mask has no paths.
+  bool IsEmpty() const { return members_.empty(); }
+
+ private:
+  // Adds path to the mask. Returns false if the path is not valid.
+  bool AddPath(const std::string &path);
+
+  // Nodes of the members that paths go through.
+  std::map<std::string, std::unique_ptr<CaptureMask>> members_;
+
+  // True if a path ends here.
+  bool target_ = false;
+
+  // See GetDepth.
+  int depth_ = 0;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // CAPTURE_MASK_H_
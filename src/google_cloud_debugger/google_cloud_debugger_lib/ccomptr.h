@@ -30,6 +30,7 @@ class CComPtr {
   CComPtr(CComPtr<TInterface>&& other) {
     Release();
     ptr_ = other.ptr_;
+    other.ptr_ = nullptr;
   }
 
   ~CComPtr() { Release(); }
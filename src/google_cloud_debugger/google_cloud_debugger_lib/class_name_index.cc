@@ -0,0 +1,96 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "class_name_index.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "module_type_dictionary.h"
+
+using google_cloud_debugger_portable_pdb::IPortablePdbFile;
+using std::cerr;
+using std::shared_ptr;
+
+namespace google_cloud_debugger {
+
+void ClassNameIndex::AddModule(shared_ptr<IPortablePdbFile> pdb_file) {
+  if (!pdb_file) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  modules_.push_back(std::move(pdb_file));
+}
+
+void ClassNameIndex::RemoveModule(
+    const shared_ptr<IPortablePdbFile> &pdb_file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto module = std::find(modules_.begin(), modules_.end(), pdb_file);
+  if (module == modules_.end()) {
+    return;
+  }
+
+  modules_.erase(module);
+  type_defs_.clear();
+  indexed_modules_ = 0;
+}
+
+HRESULT ClassNameIndex::FindTypeDef(const std::string &class_name,
+                                    ICorDebugHelper *debug_helper,
+                                    shared_ptr<IPortablePdbFile> *pdb_file,
+                                    mdTypeDef *type_def) {
+  if (!debug_helper || !pdb_file || !type_def) {
+    return E_INVALIDARG;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  IndexPendingModules(debug_helper);
+
+  auto type_def_info = type_defs_.find(class_name);
+  if (type_def_info == type_defs_.end()) {
+    return S_FALSE;
+  }
+
+  *pdb_file = type_def_info->second.pdb_file;
+  *type_def = type_def_info->second.type_def;
+  return S_OK;
+}
+
+void ClassNameIndex::IndexPendingModules(ICorDebugHelper *debug_helper) {
+  for (; indexed_modules_ < modules_.size(); ++indexed_modules_) {
+    const shared_ptr<IPortablePdbFile> &pdb_file = modules_[indexed_modules_];
+    shared_ptr<ModuleTypeDictionary> dictionary =
+        pdb_file->GetTypeDictionary();
+    CComPtr<IMetaDataImport> metadata_import;
+    HRESULT hr = pdb_file->GetMetaDataImport(&metadata_import);
+    if (SUCCEEDED(hr) && dictionary) {
+      hr = dictionary->Populate(metadata_import, debug_helper);
+    }
+    if (FAILED(hr) || !dictionary) {
+      cerr << "Failed to index the types of module "
+           << pdb_file->GetModuleName();
+      continue;
+    }
+
+    for (auto &&type_def : dictionary->GetTypeDefs()) {
+      TypeDefInfo info;
+      info.pdb_file = pdb_file;
+      info.type_def = type_def.second;
+      type_defs_.emplace(type_def.first, std::move(info));
+    }
+  }
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,88 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CLASS_NAME_INDEX_H_
+#define CLASS_NAME_INDEX_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cor.h"
+#include "i_portable_pdb_file.h"
+
+namespace google_cloud_debugger {
+
+class ICorDebugHelper;
+
+// Index from the names of the types defined in all the loaded modules to
+// the module and the mdTypeDef that define them. Modules are only
+// enumerated by the first lookup after they are added, using the type
+// dictionary of their PDB file, so a type from another assembly is found
+// without searching every module once the index is warm. If several
+// modules define a type, the one loaded first wins.
+class ClassNameIndex {
+ public:
+  // Adds the module of pdb_file to the index.
+  void AddModule(
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+          pdb_file);
+
+  // Removes the module of pdb_file. The remaining modules are indexed
+  // again by the next lookup, so the types it shadowed are found again.
+  void RemoveModule(
+      const std::shared_ptr<
+          google_cloud_debugger_portable_pdb::IPortablePdbFile> &pdb_file);
+
+  // Looks up the module that defines the type class_name and stores its
+  // PDB file in pdb_file and the token of the type in type_def. Returns
+  // S_FALSE if no loaded module defines class_name.
+  HRESULT FindTypeDef(
+      const std::string &class_name, ICorDebugHelper *debug_helper,
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+          *pdb_file,
+      mdTypeDef *type_def);
+
+ private:
+  // The module and the token of a type.
+  struct TypeDefInfo {
+    std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+        pdb_file;
+    mdTypeDef type_def;
+  };
+
+  // Adds the types of the modules that are not indexed yet to type_defs_.
+  // mutex_ has to be held.
+  void IndexPendingModules(ICorDebugHelper *debug_helper);
+
+  // The added modules, in the order they were added.
+  std::vector<
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+      modules_;
+
+  // Number of leading modules in modules_ whose types are in type_defs_.
+  size_t indexed_modules_ = 0;
+
+  // Dictionary from the name of a type to the module that defines it.
+  std::unordered_map<std::string, TypeDefInfo> type_defs_;
+
+  // Serializes access to all of the above.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  CLASS_NAME_INDEX_H_
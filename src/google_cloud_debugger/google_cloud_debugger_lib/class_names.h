@@ -55,6 +55,15 @@ static const std::string kHashSetClassName =
     "System.Collections.Generic.HashSet`1";
 static const std::string kDictionaryClassName =
     "System.Collections.Generic.Dictionary`2";
+static const std::string kQueueClassName =
+    "System.Collections.Generic.Queue`1";
+static const std::string kStackClassName =
+    "System.Collections.Generic.Stack`1";
+static const std::string kArraySegmentClassName = "System.ArraySegment`1";
+static const std::string kImmutableArrayClassName =
+    "System.Collections.Immutable.ImmutableArray`1";
+static const std::string kConcurrentDictionaryClassName =
+    "System.Collections.Concurrent.ConcurrentDictionary`2";
 
 }  // namespace google_cloud_debugger
 
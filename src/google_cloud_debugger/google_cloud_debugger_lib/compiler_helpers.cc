@@ -16,246 +16,116 @@
 
 #include "class_names.h"
 #include "compiler_helpers.h"
+#include "constants.h"
 #include "dbg_primitive.h"
 #include "i_cor_debug_helper.h"
 #include "type_signature.h"
 
 namespace google_cloud_debugger {
 
-bool NumericCompilerHelper::IsImplicitNumericConversionable(
-    const TypeSignature &source, const TypeSignature &target) {
-  const CorElementType &source_type = source.cor_type;
-  const CorElementType &target_type = target.cor_type;
-  // Most of the logic here is from implicit numeric conversions:
-  // https://docs.microsoft.com/en-us/dotnet/csharp/language-reference/language-specification/conversions#implicit-conversions
-  switch (source_type) {
-    case CorElementType::ELEMENT_TYPE_I1: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_I1:
-        case CorElementType::ELEMENT_TYPE_I2:
-        case CorElementType::ELEMENT_TYPE_I4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_U1: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_U1:
-        case CorElementType::ELEMENT_TYPE_I2:
-        case CorElementType::ELEMENT_TYPE_U2:
-        case CorElementType::ELEMENT_TYPE_I4:
-        case CorElementType::ELEMENT_TYPE_U4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_U8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_I2: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_I2:
-        case CorElementType::ELEMENT_TYPE_I4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_U2: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_U2:
-        case CorElementType::ELEMENT_TYPE_I4:
-        case CorElementType::ELEMENT_TYPE_U4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_U8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_I4: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_I4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_U4: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_U4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_U8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_I8: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_U8: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_U8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_CHAR: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_CHAR:
-        case CorElementType::ELEMENT_TYPE_U2:
-        case CorElementType::ELEMENT_TYPE_I4:
-        case CorElementType::ELEMENT_TYPE_U4:
-        case CorElementType::ELEMENT_TYPE_I8:
-        case CorElementType::ELEMENT_TYPE_U8:
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_R4: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_R4:
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    case CorElementType::ELEMENT_TYPE_R8: {
-      switch (target_type) {
-        case CorElementType::ELEMENT_TYPE_R8:
-          return true;
-        default:
-          return false;
-      }
-    }
-    default:
-      return false;
-  }
-}
-
-bool NumericCompilerHelper::IsNumericallyPromotedToInt(
-    const CorElementType &source) {
-  return source == CorElementType::ELEMENT_TYPE_CHAR ||
-         source == CorElementType::ELEMENT_TYPE_I1 ||
-         source == CorElementType::ELEMENT_TYPE_U1 ||
-         source == CorElementType::ELEMENT_TYPE_I2;
-}
-
-// Returns true for I1, I2, I4 and I8 types.
-inline bool IsSignedIntegralType(const CorElementType &element_type) {
-  return element_type == CorElementType::ELEMENT_TYPE_I1 ||
-         element_type == CorElementType::ELEMENT_TYPE_I2 ||
-         element_type == CorElementType::ELEMENT_TYPE_I4 ||
-         element_type == CorElementType::ELEMENT_TYPE_I8;
-}
+// The tables follow the C# specification:
+// https://docs.microsoft.com/en-us/dotnet/csharp/language-reference/language-specification/conversions#implicit-numeric-conversions
+// https://docs.microsoft.com/en-us/dotnet/csharp/language-reference/language-specification/expressions#binary-numeric-promotions
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_I1, ELEMENT_TYPE_I2) &&
+        LookUpConversion(ELEMENT_TYPE_I1, ELEMENT_TYPE_R4) &&
+        !LookUpConversion(ELEMENT_TYPE_I1, ELEMENT_TYPE_U2) &&
+        !LookUpConversion(ELEMENT_TYPE_I1, ELEMENT_TYPE_CHAR),
+    "sbyte converts to short, int, long, float and double.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_U1, ELEMENT_TYPE_I2) &&
+        LookUpConversion(ELEMENT_TYPE_U1, ELEMENT_TYPE_U8) &&
+        !LookUpConversion(ELEMENT_TYPE_U1, ELEMENT_TYPE_I1) &&
+        !LookUpConversion(ELEMENT_TYPE_U1, ELEMENT_TYPE_CHAR),
+    "byte converts to every wider integral type but char.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_I2, ELEMENT_TYPE_I4) &&
+        !LookUpConversion(ELEMENT_TYPE_I2, ELEMENT_TYPE_U2) &&
+        !LookUpConversion(ELEMENT_TYPE_I2, ELEMENT_TYPE_U8),
+    "short only converts to wider signed types.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_U2, ELEMENT_TYPE_I4) &&
+        LookUpConversion(ELEMENT_TYPE_U2, ELEMENT_TYPE_U4) &&
+        !LookUpConversion(ELEMENT_TYPE_U2, ELEMENT_TYPE_I2) &&
+        !LookUpConversion(ELEMENT_TYPE_U2, ELEMENT_TYPE_CHAR),
+    "ushort converts to int, uint, long, ulong, float and double.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_I4, ELEMENT_TYPE_I8) &&
+        LookUpConversion(ELEMENT_TYPE_I4, ELEMENT_TYPE_R4) &&
+        !LookUpConversion(ELEMENT_TYPE_I4, ELEMENT_TYPE_U4) &&
+        !LookUpConversion(ELEMENT_TYPE_I4, ELEMENT_TYPE_I2),
+    "int converts to long, float and double.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_U4, ELEMENT_TYPE_I8) &&
+        LookUpConversion(ELEMENT_TYPE_U4, ELEMENT_TYPE_U8) &&
+        !LookUpConversion(ELEMENT_TYPE_U4, ELEMENT_TYPE_I4),
+    "uint converts to long, ulong, float and double.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_I8, ELEMENT_TYPE_R4) &&
+        !LookUpConversion(ELEMENT_TYPE_I8, ELEMENT_TYPE_U8) &&
+        LookUpConversion(ELEMENT_TYPE_U8, ELEMENT_TYPE_R8) &&
+        !LookUpConversion(ELEMENT_TYPE_U8, ELEMENT_TYPE_I8),
+    "long and ulong only convert to float and double.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_CHAR, ELEMENT_TYPE_U2) &&
+        LookUpConversion(ELEMENT_TYPE_CHAR, ELEMENT_TYPE_I4) &&
+        !LookUpConversion(ELEMENT_TYPE_CHAR, ELEMENT_TYPE_I2) &&
+        !LookUpConversion(ELEMENT_TYPE_U2, ELEMENT_TYPE_CHAR),
+    "char converts to ushort and wider types, and nothing converts to it.");
+static_assert(
+    LookUpConversion(ELEMENT_TYPE_R4, ELEMENT_TYPE_R8) &&
+        !LookUpConversion(ELEMENT_TYPE_R8, ELEMENT_TYPE_R4) &&
+        !LookUpConversion(ELEMENT_TYPE_R4, ELEMENT_TYPE_I8),
+    "float converts to double, and double to nothing else.");
+
+static_assert(
+    LookUpPromotion(ELEMENT_TYPE_I1, ELEMENT_TYPE_U1) == ELEMENT_TYPE_I4 &&
+        LookUpPromotion(ELEMENT_TYPE_CHAR, ELEMENT_TYPE_U2) == ELEMENT_TYPE_I4,
+    "The types narrower than int are promoted to int.");
+static_assert(
+    LookUpPromotion(ELEMENT_TYPE_U4, ELEMENT_TYPE_I2) == ELEMENT_TYPE_I8 &&
+        LookUpPromotion(ELEMENT_TYPE_U4, ELEMENT_TYPE_U2) == ELEMENT_TYPE_U4,
+    "uint and a signed type are promoted to long.");
+static_assert(
+    LookUpPromotion(ELEMENT_TYPE_U8, ELEMENT_TYPE_I4) == ELEMENT_TYPE_END &&
+        LookUpPromotion(ELEMENT_TYPE_U8, ELEMENT_TYPE_U4) == ELEMENT_TYPE_U8 &&
+        LookUpPromotion(ELEMENT_TYPE_I8, ELEMENT_TYPE_U4) == ELEMENT_TYPE_I8,
+    "ulong and a signed type cannot be promoted.");
+static_assert(
+    LookUpPromotion(ELEMENT_TYPE_U8, ELEMENT_TYPE_R4) == ELEMENT_TYPE_R4 &&
+        LookUpPromotion(ELEMENT_TYPE_R4, ELEMENT_TYPE_R8) == ELEMENT_TYPE_R8,
+    "A floating-point type promotes the other type to it.");
+
+static_assert(
+    kCorTypeTraits[ELEMENT_TYPE_CHAR] ==
+            (kIntegralCorType | kNumericalCorType | kPromotedToIntCorType) &&
+        kCorTypeTraits[ELEMENT_TYPE_I8] ==
+            (kIntegralCorType | kNumericalCorType | kSignedIntegralCorType) &&
+        kCorTypeTraits[ELEMENT_TYPE_R8] == kNumericalCorType &&
+        kCorTypeTraits[ELEMENT_TYPE_BOOLEAN] == 0 &&
+        kCorTypeTraits[ELEMENT_TYPE_I] == 0,
+    "Only char and the integer types are integral.");
 
 bool NumericCompilerHelper::BinaryNumericalPromotion(const CorElementType &arg1,
                                                      const CorElementType &arg2,
                                                      CorElementType *result,
                                                      std::ostream *err_stream) {
-  if (!TypeCompilerHelper::IsNumericalType(arg1) &&
-      !TypeCompilerHelper::IsNumericalType(arg2)) {
+  if (!IsNumericCorType(arg1) || !IsNumericCorType(arg2)) {
     *err_stream << "Both arguments has to be of numerical types.";
     return false;
   }
 
-  // TODO(quoct): Add support for Decimal.
-  if (arg1 == CorElementType::ELEMENT_TYPE_R8 ||
-      arg2 == CorElementType::ELEMENT_TYPE_R8) {
-    *result = CorElementType::ELEMENT_TYPE_R8;
-    return true;
-  } else if (arg1 == CorElementType::ELEMENT_TYPE_R4 ||
-             arg2 == CorElementType::ELEMENT_TYPE_R4) {
-    *result = CorElementType::ELEMENT_TYPE_R4;
-    return true;
-  } else if (arg1 == CorElementType::ELEMENT_TYPE_U8 ||
-             arg2 == CorElementType::ELEMENT_TYPE_U8) {
-    // If the other operand is of type sbyte, short, int or long,
-    // an error will occur. This is because no integral type exists that can
-    // represent the full range of ulong as well as the signed integral types.
-    if (IsSignedIntegralType(arg1) || IsSignedIntegralType(arg2)) {
-      *err_stream << "If one of the argument is an unsigned long, "
-                  << "the other cannot be a signed integral type.";
-      return false;
-    }
-    *result = CorElementType::ELEMENT_TYPE_U8;
-    return true;
-  } else if (arg1 == CorElementType::ELEMENT_TYPE_I8 ||
-             arg2 == CorElementType::ELEMENT_TYPE_I8) {
-    *result = CorElementType::ELEMENT_TYPE_I8;
-    return true;
-  } else if (arg1 == CorElementType::ELEMENT_TYPE_U4 ||
-             arg2 == CorElementType::ELEMENT_TYPE_U4) {
-    // If 1 of the operand is sbyte, short or int,
-    // the result will be long. We can simply call
-    // IsSignedIntegralType without worrying about arg1
-    // being an I8 type because that is already checked above.
-    if (IsSignedIntegralType(arg1)) {
-      *result = CorElementType::ELEMENT_TYPE_I8;
-      return true;
-    }
-
-    if (IsSignedIntegralType(arg2)) {
-      *result = CorElementType::ELEMENT_TYPE_I8;
-      return true;
-    }
-
-    *result = CorElementType::ELEMENT_TYPE_U4;
-    return true;
-  } else {
-    // Otherwise, both operands are converted to int.
-    *result = CorElementType::ELEMENT_TYPE_I4;
-    return true;
+  CorElementType promoted = LookUpPromotion(arg1, arg2);
+  if (promoted == CorElementType::ELEMENT_TYPE_END) {
+    // No integral type can represent the full range of ulong as well as
+    // the signed integral types.
+    *err_stream << "If one of the argument is an unsigned long, "
+                << "the other cannot be a signed integral type.";
+    return false;
   }
-}
-
-bool TypeCompilerHelper::IsNumericalType(const CorElementType &cor_type) {
-  return IsIntegralType(cor_type) ||
-         cor_type == CorElementType::ELEMENT_TYPE_R4 ||
-         cor_type == CorElementType::ELEMENT_TYPE_R8;
-}
 
-bool TypeCompilerHelper::IsIntegralType(const CorElementType &cor_type) {
-  return cor_type == CorElementType::ELEMENT_TYPE_I1 ||
-         cor_type == CorElementType::ELEMENT_TYPE_U1 ||
-         cor_type == CorElementType::ELEMENT_TYPE_I2 ||
-         cor_type == CorElementType::ELEMENT_TYPE_U2 ||
-         cor_type == CorElementType::ELEMENT_TYPE_I4 ||
-         cor_type == CorElementType::ELEMENT_TYPE_U4 ||
-         cor_type == CorElementType::ELEMENT_TYPE_I8 ||
-         cor_type == CorElementType::ELEMENT_TYPE_U8 ||
-         cor_type == CorElementType::ELEMENT_TYPE_CHAR;
+  *result = promoted;
+  return true;
 }
 
 bool TypeCompilerHelper::IsArrayType(const CorElementType &array_type) {
@@ -311,49 +181,72 @@ CorElementType TypeCompilerHelper::ConvertStringToCorElementType(
   }
 }
 
-struct CorElementTypeHash {
-  std::size_t operator()(CorElementType cor_type) const {
-    return static_cast<std::size_t>(cor_type);
-  }
-};
-
 HRESULT TypeCompilerHelper::ConvertCorElementTypeToString(
     const CorElementType &cor_type, std::string *result) {
-  static std::unordered_map<CorElementType, std::string, CorElementTypeHash> cor_type_to_string{
-      {CorElementType::ELEMENT_TYPE_BOOLEAN, kBooleanClassName},
-      {CorElementType::ELEMENT_TYPE_I1, kSByteClassName},
-      {CorElementType::ELEMENT_TYPE_CHAR, kCharClassName},
-      {CorElementType::ELEMENT_TYPE_U1, kByteClassName},
-      {CorElementType::ELEMENT_TYPE_I2, kInt16ClassName},
-      {CorElementType::ELEMENT_TYPE_U2, kUInt16ClassName},
-      {CorElementType::ELEMENT_TYPE_I4, kInt32ClassName},
-      {CorElementType::ELEMENT_TYPE_U4, kUInt32ClassName},
-      {CorElementType::ELEMENT_TYPE_I8, kInt64ClassName},
-      {CorElementType::ELEMENT_TYPE_U8, kUInt64ClassName},
-      {CorElementType::ELEMENT_TYPE_R4, kSingleClassName},
-      {CorElementType::ELEMENT_TYPE_R8, kDoubleClassName},
-      {CorElementType::ELEMENT_TYPE_I, kIntPtrClassName},
-      {CorElementType::ELEMENT_TYPE_U, kUIntPtrClassName},
-      {CorElementType::ELEMENT_TYPE_STRING, kStringClassName},
-      {CorElementType::ELEMENT_TYPE_OBJECT, kObjectClassName}};
-
   if (result == nullptr) {
     return E_INVALIDARG;
   }
 
-  if (cor_type_to_string.find(cor_type) != cor_type_to_string.end()) {
-    *result = cor_type_to_string[cor_type];
-    return S_OK;
+  if (static_cast<std::size_t>(cor_type) >= kTabledCorTypes ||
+      !kCorTypeClassNames[cor_type]) {
+    return E_FAIL;
   }
 
-  return E_FAIL;
+  *result = *kCorTypeClassNames[cor_type];
+  return S_OK;
 }
 
+std::map<TypeCompilerHelper::BaseClassKey, HRESULT>
+    TypeCompilerHelper::base_class_results_;
+
+std::mutex TypeCompilerHelper::base_class_results_mutex_;
+
 HRESULT TypeCompilerHelper::IsBaseClass(
     mdTypeDef source_class, IMetaDataImport *source_class_metadata,
     const std::vector<CComPtr<ICorDebugAssembly>> &loaded_assemblies,
     const std::string &target_class, ICorDebugHelper *debug_helper,
     std::ostream *err_stream) {
+  BaseClassKey key(source_class_metadata, source_class, target_class);
+  {
+    std::lock_guard<std::mutex> lock(base_class_results_mutex_);
+    auto result = base_class_results_.find(key);
+    if (result != base_class_results_.end()) {
+      return result->second;
+    }
+  }
+
+  HRESULT hr =
+      WalkBaseClasses(source_class, source_class_metadata, loaded_assemblies,
+                      target_class, debug_helper, err_stream);
+  // Other failures come from the metadata and may not happen again.
+  if (hr != S_OK && hr != E_FAIL) {
+    return hr;
+  }
+
+  std::lock_guard<std::mutex> lock(base_class_results_mutex_);
+  if (base_class_results_.size() >= kMaximumCachedBaseClassResults) {
+    base_class_results_.clear();
+  }
+  base_class_results_[key] = hr;
+  return hr;
+}
+
+void TypeCompilerHelper::RemoveBaseClassResults(
+    IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(base_class_results_mutex_);
+  auto result = base_class_results_.lower_bound(
+      BaseClassKey(metadata_import, 0, std::string()));
+  while (result != base_class_results_.end() &&
+         std::get<0>(result->first) == metadata_import) {
+    result = base_class_results_.erase(result);
+  }
+}
+
+HRESULT TypeCompilerHelper::WalkBaseClasses(
+    mdTypeDef source_class, IMetaDataImport *source_class_metadata,
+    const std::vector<CComPtr<ICorDebugAssembly>> &loaded_assemblies,
+    const std::string &target_class, ICorDebugHelper *debug_helper,
+    std::ostream *err_stream) {
   HRESULT hr;
   mdTypeDef current_class_token = source_class;
   CComPtr<IMetaDataImport> current_metadata_import;
@@ -16,7 +16,12 @@
 #define COMPILER_HELPERS_H_
 
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include "common_headers.h"
+#include "cor_type_tables.h"
 #include "dbg_primitive.h"
 
 // Various helper functions for compiling such as numeric conversions,
@@ -35,10 +40,16 @@ class NumericCompilerHelper {
   // will also return true.
   // TODO(quoct): Add support for decimal type.
   static bool IsImplicitNumericConversionable(const TypeSignature &source,
-                                              const TypeSignature &target);
+                                              const TypeSignature &target) {
+    return IsNumericCorType(source.cor_type) &&
+           IsNumericCorType(target.cor_type) &&
+           LookUpConversion(source.cor_type, target.cor_type);
+  }
 
   // Returns true if source can be numerically promoted to int.
-  static bool IsNumericallyPromotedToInt(const CorElementType &source);
+  static bool IsNumericallyPromotedToInt(const CorElementType &source) {
+    return (LookUpCorTypeTraits(source) & kPromotedToIntCorType) != 0;
+  }
 
   // Apply numeric promotions for +,-,*,/,%, &, |, ^, ==, !=, >, <, >= and <=
   // based on:
@@ -183,10 +194,14 @@ class TypeCompilerHelper {
  public:
   // Returns true if CorElementType is a numerical type.
   // TODO(quoct): This does not handle Decimal.
-  static bool IsNumericalType(const CorElementType &cor_type);
+  static bool IsNumericalType(const CorElementType &cor_type) {
+    return (LookUpCorTypeTraits(cor_type) & kNumericalCorType) != 0;
+  }
 
   // Returns true if CorElementType is an integral type.
-  static bool IsIntegralType(const CorElementType &cor_type);
+  static bool IsIntegralType(const CorElementType &cor_type) {
+    return (LookUpCorTypeTraits(cor_type) & kIntegralCorType) != 0;
+  }
 
   // Returns true if CorElementType is an array type.
   static bool IsArrayType(const CorElementType &array_type);
@@ -211,6 +226,8 @@ class TypeCompilerHelper {
   // to System.Object to check whether any of them matches
   // target_class.
   // Returns S_OK if there is a match and E_FAIL otherwise.
+  // Both results are cached across breakpoint hits, so the base classes
+  // of a class are only walked once for each target_class.
   // TODO(quoct): Verify that whether this works on multiple
   // interfaces.
   static HRESULT IsBaseClass(
@@ -218,6 +235,36 @@ class TypeCompilerHelper {
       const std::vector<CComPtr<ICorDebugAssembly>> &loaded_assemblies,
       const std::string &target_class, ICorDebugHelper *debug_helper,
       std::ostream *err_stream);
+
+  // Removes the cached IsBaseClass results of the classes of the module
+  // of metadata_import, which is being unloaded.
+  static void RemoveBaseClassResults(IMetaDataImport *metadata_import);
+
+  // Clears the cached IsBaseClass results.
+  static void ClearBaseClassResults() {
+    std::lock_guard<std::mutex> lock(base_class_results_mutex_);
+    base_class_results_.clear();
+  }
+
+ private:
+  // A source class, identified by the IMetaDataImport of its module and
+  // its token, and the name of a target class.
+  typedef std::tuple<IMetaDataImport *, mdTypeDef, std::string>
+      BaseClassKey;
+
+  // Walks the base classes of source_class without looking at the cache.
+  static HRESULT WalkBaseClasses(
+      mdTypeDef source_class, IMetaDataImport *source_class_metadata,
+      const std::vector<CComPtr<ICorDebugAssembly>> &loaded_assemblies,
+      const std::string &target_class, ICorDebugHelper *debug_helper,
+      std::ostream *err_stream);
+
+  // Cache of the results of IsBaseClass. It is cleared once it has
+  // kMaximumCachedBaseClassResults results.
+  static std::map<BaseClassKey, HRESULT> base_class_results_;
+
+  // Protects base_class_results_.
+  static std::mutex base_class_results_mutex_;
 };
 
 }  //  namespace google_cloud_debugger
@@ -15,6 +15,8 @@
 #ifndef CONSTANTS_H_
 #define CONSTANTS_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace google_cloud_debugger {
@@ -25,8 +27,21 @@ static const int kBufferSize = 1024;
 // The maximum amount of time to wait for a pipe connection in milliseconds.
 static const int kConnectionWaitTimeoutMs = 60000;
 
-// The amount of time to wait between checks for a pipe connection in milliseconds.
-static const int kConnectionSleepTimeoutMs = 2000;
+// The maximum amount of time to wait for the agent to read a breakpoint
+// message written to the pipe in milliseconds.
+static const int kPipeWriteTimeoutMs = 60000;
+
+// The amount of time to wait before retrying a pipe connection that the
+// agent is not ready to accept yet, in milliseconds.
+static const int kConnectionRetryIntervalMs = 10;
+
+// The default maximum amount of time a single function evaluation can
+// take before it is aborted, in milliseconds.
+static const int kDefaultEvalTimeoutMs = 60000;
+
+// The maximum amount of time to wait for an aborted function evaluation
+// to stop, in milliseconds.
+static const int kEvalAbortTimeoutMs = 1000;
 
 // The default evaluation depth for an object.
 static const int kDefaultObjectEvalDepth = 5;
@@ -37,16 +52,309 @@ static const std::string kStartBreakpointMessage = "START_DEBUG_MESSAGE";
 // The end of a breakpoint message.
 static const std::string kEndBreakpointMessage = "END_DEBUG_MESSAGE";
 
+// How breakpoint messages are delimited on the pipe.
+enum class MessageFraming {
+  // Every message is surrounded by kStartBreakpointMessage and
+  // kEndBreakpointMessage.
+  kMarkers,
+
+  // Every message is preceded by a frame header of kFrameHeaderSize bytes:
+  // the byte kFrameVersion, then the size of the message as a little-endian
+  // 32-bit integer.
+  kLengthPrefixed
+};
+
+// What BreakpointWriter::Enqueue does when the queue is full.
+enum class BreakpointWriteOverflow {
+  // Waits until the writer thread makes room in the queue.
+  kBlock,
+
+  // Drops log point messages. Other breakpoints still wait for room,
+  // since a dropped snapshot would never be reported to the agent.
+  kDropLogPoints
+};
+
+// Version of the frame header of length-prefixed messages.
+static const std::uint8_t kFrameVersion = 1;
+
+// Set in the version byte of a frame header if the message is compressed
+// with BreakpointCompressor.
+static const std::uint8_t kFrameCompressedFlag = 0x80;
+
+// Set in the version byte of a frame header if the message is a chunk of
+// a breakpoint that the messages of the following frames complete. Every
+// chunk is a serialized Breakpoint and the breakpoint is all of them
+// merged, so the server appends the stack frames and evaluated
+// expressions of each chunk to the ones it read before.
+static const std::uint8_t kFrameChunkFlag = 0x40;
+
+// Set in the version byte of a frame header if the message is a batch of
+// log point hits encoded by LogRecordEncoder instead of a Breakpoint.
+static const std::uint8_t kFrameLogRecordsFlag = 0x20;
+
+// Length-prefixed breakpoints larger than this are written in chunks of
+// about this size: their fields other than the stack frames and the
+// evaluated expressions, then those in groups. A breakpoint is then never
+// serialized into a single buffer of its whole size.
+static const std::size_t kBreakpointChunkSize = 256 * 1024;
+
+// The shared memory of a shared memory pipe is a header followed by the
+// ring of the agent to the debugger and then the ring of the debugger to
+// the agent. The header starts with this magic number and the capacity
+// of each ring, both uint32 in the byte order of the machine. Each ring
+// is a control block of three cache lines, holding the write position,
+// the read position and whether the reader waits for the doorbell, and
+// then capacity bytes of data.
+static const std::uint32_t kSharedMemoryMagic = 0x4D534443;
+static const std::size_t kSharedMemoryHeaderSize = 64;
+static const std::size_t kSharedMemoryRingControlSize = 192;
+
+// The files of shared memory pipes are this followed by the pipe name.
+static const char kSharedMemoryPathPrefix[] = "/dev/shm/CloudDebugger_";
+
+// The time between checks of a full ring while waiting for the agent to
+// read from it, in microseconds.
+static const int kSharedMemoryFullRetryIntervalUs = 100;
+
+// Breakpoints smaller than this are never compressed, since deflating
+// them would not save enough to be worth it.
+static const std::size_t kMinimumCompressedBreakpointSize = 4096;
+
+// Size of the frame header of length-prefixed messages.
+static const std::uint32_t kFrameHeaderSize = 5;
+
+// The maximum size of a length-prefixed message. Larger sizes in a frame
+// header are treated as a corrupted stream.
+static const std::uint32_t kMaximumFrameSize = 16 * 1024 * 1024;
+
+// Breakpoint clients keep the buffer they serialize breakpoints into
+// between writes unless it grew larger than this.
+static const std::size_t kMaximumPooledWriteBufferSize = 1024 * 1024;
+
+// Breakpoint messages are cleared and reused for other snapshots unless
+// they grew larger than this when serialized.
+static const std::size_t kMaximumPooledBreakpointSize = 64 * 1024;
+
+// The maximum number of breakpoint messages an EvalCoordinator keeps
+// for reuse.
+static const std::size_t kMaximumPooledSnapshotBreakpoints = 4;
+
+// The maximum number of stack frame names and source locations an
+// EvalCoordinator caches across breakpoint hits.
+static const std::size_t kMaximumCachedFrameInfos = 1024;
+
+// The maximum number of classes whose member metadata is cached across
+// breakpoint hits.
+static const std::size_t kMaximumCachedClassLayouts = 1024;
+
+// The maximum number of methods whose variable names and local constants
+// are cached across breakpoint hits, per set of local scopes.
+static const std::size_t kMaximumCachedMethodFrameLayouts = 1024;
+
+// The maximum number of parsed type signatures that are cached across
+// breakpoint hits.
+static const std::size_t kMaximumCachedTypeSignatures = 4096;
+
+// The maximum number of generic parameter counts of methods and classes
+// that are cached across breakpoint hits.
+static const std::size_t kMaximumCachedGenericParamCounts = 4096;
+
+// The maximum number of types whose field layouts are cached to read the
+// primitive fields of their objects from memory.
+static const std::size_t kMaximumCachedTypeFieldLayouts = 1024;
+
+// The size of the pages of debuggee memory that DebuggeeMemoryCache reads.
+static const std::size_t kDebuggeeMemoryPageSize = 4096;
+
+// The maximum number of pages of debuggee memory cached during a hit.
+static const std::size_t kMaximumCachedDebuggeeMemoryPages = 256;
+
+// Reads of debuggee memory that span more pages than this are not cached.
+static const std::size_t kMaximumCachedDebuggeeMemoryReadPages = 16;
+
+// The maximum number of base class checks whose results are cached
+// across breakpoint hits.
+static const std::size_t kMaximumCachedBaseClassResults = 1024;
+
+// The maximum number of methods found from their name and argument types
+// that are cached across breakpoint hits.
+static const std::size_t kMaximumCachedResolvedMethods = 1024;
+
+// The maximum number of classes whose kind of DbgObject is cached across
+// breakpoint hits.
+static const std::size_t kMaximumCachedClassDispatches = 1024;
+
+// The maximum number of property getters whose IL is checked for a
+// returned field that are cached across breakpoint hits.
+static const std::size_t kMaximumCachedPropertyGetters = 4096;
+
+// The maximum number of properties of methods, types and fields of each
+// kind that MetadataCache keeps.
+static const std::size_t kMaximumCachedMetadataProps = 16384;
+
+// The maximum number of parsed log message formats that are cached by the
+// writer of log records.
+static const std::size_t kMaximumCachedLogMessageTemplates = 256;
+
+// The number of hits a second a breakpoint is processed for. Hits above
+// this rate are skipped once the burst of kBreakpointHitBurst hits is
+// used up.
+static const double kBreakpointHitsPerSecond = 20;
+static const double kBreakpointHitBurst = 40;
+
+// The number of microseconds a second the debuggee can spend stopped at
+// log points, and how many it can spend in a burst. Log points are
+// paused while they cost more than this.
+static const double kLogPointCostPerSecondUs = 100000;
+static const double kLogPointCostBurstUs = 1000000;
+
+// The minimum time between two reports that hits of a log point are
+// skipped, in milliseconds.
+static const int kSkippedHitsReportIntervalMs = 60000;
+
+// Status messages of log point hits skipped by the limits above.
+static const std::string kBreakpointHitRateExceededMessage =
+    "Some hits of the log point are skipped because it is hit too often.";
+static const std::string kLogPointsPausedMessage =
+    "Some hits of the log point are skipped because log points slow down "
+    "the application too much.";
+
+// The length of the windows over which OverheadGovernor measures the
+// overhead of the debugger, in milliseconds.
+static const int kOverheadWindowMs = 1000;
+
+// While OverheadGovernor samples log points, one of every this many hits
+// of log points is processed.
+static const std::uint64_t kOverheadSampledLogPointHits = 10;
+
+// Status messages of hits degraded by OverheadGovernor.
+static const std::string kOverheadNoPropertyEvaluationMessage =
+    "Properties are not evaluated because the debugger exceeds its "
+    "overhead budget.";
+static const std::string kOverheadReducedLimitsMessage =
+    "Properties are not evaluated and fewer stack frames and collection "
+    "items are captured because the debugger exceeds its overhead budget.";
+static const std::string kOverheadSampledLogPointsMessage =
+    "Some hits of the log point are skipped and fewer values are captured "
+    "because the debugger exceeds its overhead budget.";
+static const std::string kOverheadPausedSnapshotsMessage =
+    "Snapshots are paused, some hits of the log point are skipped and fewer "
+    "values are captured because the debugger exceeds its overhead budget.";
+
+// The maximum number of breakpoints waiting to be written to the agent.
+static const std::size_t kBreakpointWriteQueueCapacity = 1024;
+
+// The maximum number of bytes of breakpoints kept in the spill file of
+// BreakpointWriter.
+static const std::uint64_t kMaximumSpillFileBytes = 256 * 1024 * 1024;
+
+// The maximum number of breakpoints written to the agent in one write.
+static const std::size_t kMaximumBreakpointWriteBatch = 64;
+
+// The maximum number of breakpoints read from the agent that are activated
+// together. Deactivations wait for at most one such batch.
+static const std::size_t kMaximumBreakpointActivationBatch = 16;
+
+// The ID of the messages that report DebuggerMetrics to the agent.
+// The agent logs them instead of treating them as breakpoints.
+static const std::string kMetricsBreakpointId = "_debugger_metrics";
+
+// The name of the evaluated expression that SnapshotStringTable appends to
+// a snapshot. Its members hold the strings of the table in order, and a
+// name, type, method name or path that starts with
+// kStringTableReferencePrefix is replaced by the string at the decimal
+// index that follows it.
+static const std::string kStringTableExpressionName = "_string_table";
+static const char kStringTableReferencePrefix = '\x01';
+
+// The name of the variables that SnapshotDelta sends instead of variables
+// that did not change since the previous snapshot of their breakpoint.
+static const std::string kUnchangedVariableName = "\x02";
+
+// The maximum number of breakpoints whose previous snapshot SnapshotDelta
+// and the agent keep. Has to match the agent.
+static const std::size_t kMaximumDeltaSnapshotBreakpoints = 64;
+
+// The ID of the message that tells the agent the debugger is attached to
+// the application and connected to the agent. Its evaluated expressions
+// are the StartupTimings.
+static const std::string kReadyBreakpointId = "_debugger_ready";
+
+// The ID of the message the agent syncs its breakpoints with. Its
+// breakpoints are every active breakpoint: in full if the debugger does
+// not have them yet and only with their ID otherwise. Synced breakpoints
+// that are not among them are deactivated.
+static const std::string kSyncBreakpointsId = "_sync_breakpoints";
+
+// Breakpoints whose location path starts with this are exception points:
+// a snapshot is captured when an exception of the type after the prefix
+// is thrown, or "type@module" to only capture exceptions thrown by code
+// of that module. Their line is ignored.
+static const std::string kExceptionPointPathPrefix = "exception:";
+
+// Log points whose message format starts with this are metric points:
+// their hits add the value of their first expression to a summary, which
+// is written as the message of the log point every
+// kMetricPointFlushIntervalMs, instead of writing a message for each hit.
+static const std::string kMetricPointFormatPrefix = "metric:";
+
+// How often a metric point writes the summary of its hits, in
+// milliseconds. The summary is written by the first hit after that.
+static const int kMetricPointFlushIntervalMs = 10000;
+
+// The number of buckets of the histograms of metric points.
+static const std::size_t kMetricPointHistogramBuckets = 32;
+
+// The maximum number of exception classes whose matching exception points
+// are cached while exception points are active.
+static const std::size_t kMaximumCachedExceptionClasses = 1024;
+
+// The time a location without breakpoints keeps its deactivated
+// ICorDebugBreakpoint, in milliseconds. A breakpoint set at the location
+// again in that time reactivates it instead of creating a new one.
+static const int kDeactivatedBreakpointRetentionMs = 600000;
+
+// The number of trace spans each thread keeps for TraceLog. Older spans
+// are overwritten.
+static const std::size_t kTraceEventsPerThread = 4096;
+
 // File extension for dll file.
 static const std::string kDllExtension = ".dll";
 
 // File extension for pdb file.
 static const std::string kPdbExtension = ".pdb";
 
+// Attribute that sets how the debugger displays a member.
+static const std::string kDebuggerBrowsableAttribute =
+    "System.Diagnostics.DebuggerBrowsableAttribute";
+
+// Attribute that sets the string the debugger displays for an object.
+static const std::string kDebuggerDisplayAttribute =
+    "System.Diagnostics.DebuggerDisplayAttribute";
+
 // If a field is a backing field of a property, its name will
 // end with this.
 static const std::string kBackingField = ">k__BackingField";
 
+// The maximum number of threads that parse PDB files in the background.
+static const std::uint32_t kMaxPdbParsingThreads = 4;
+
+// The maximum number of threads that download PDB files from the symbol
+// server in the background.
+static const std::uint32_t kMaxSymbolFetchThreads = 4;
+
+// The maximum number of threads that resolve the names of stack frames
+// without variables.
+static const std::uint32_t kMaxFrameResolutionThreads = 4;
+
+// The time in milliseconds after which the evaluation threads that
+// concurrent breakpoint hits started exit if no hit needs them.
+static const int kEvaluationThreadIdleTimeoutMs = 60000;
+
+// The largest amount the priority of background threads can be lowered
+// by, which is the largest nice value on Linux.
+static const std::uint32_t kMaxBackgroundThreadPriority = 19;
+
 // Default size of a vector that we use to retrieve objects from ICorDebugEnum.
 static const std::uint32_t kDefaultVectorSize = 100;
 
@@ -29,7 +29,10 @@
 #include "dbg_primitive.h"
 #include "dbg_stack_frame.h"
 #include "dbg_string.h"
+#include "dereference_cache.h"
 #include "error_messages.h"
+#include "metadata_cache.h"
+#include "strong_handle_pool.h"
 #include "string_stream_wrapper.h"
 
 using std::cerr;
@@ -76,6 +79,11 @@ HRESULT CorDebugHelper::GetMetadataImportFromICorDebugModule(
     return E_INVALIDARG;
   }
 
+  if (MetadataCache::Global().FindMetadataImport(debug_module,
+                                                 metadata_import)) {
+    return S_OK;
+  }
+
   CComPtr<IUnknown> temp_import;
   HRESULT hr;
 
@@ -86,6 +94,11 @@ HRESULT CorDebugHelper::GetMetadataImportFromICorDebugModule(
     return hr;
   }
 
+  if (!temp_import) {
+    *err_stream << "Failed to get metadata import.";
+    return E_FAIL;
+  }
+
   hr = temp_import->QueryInterface(IID_IMetaDataImport,
                                    reinterpret_cast<void **>(metadata_import));
   if (FAILED(hr)) {
@@ -93,6 +106,7 @@ HRESULT CorDebugHelper::GetMetadataImportFromICorDebugModule(
     return hr;
   }
 
+  MetadataCache::Global().AddMetadataImport(debug_module, *metadata_import);
   return S_OK;
 }
 
@@ -188,6 +202,22 @@ HRESULT CorDebugHelper::Dereference(ICorDebugValue *debug_value,
     return E_INVALIDARG;
   }
 
+  // During a hit, a reference to an object that was already
+  // dereferenced gets the same value.
+  DereferenceCache *cache = DereferenceCache::GetCurrent();
+  CORDB_ADDRESS object_address = 0;
+  if (cache) {
+    CComPtr<ICorDebugReferenceValue> debug_reference;
+    if (SUCCEEDED(debug_value->QueryInterface(
+            __uuidof(ICorDebugReferenceValue),
+            reinterpret_cast<void **>(&debug_reference))) &&
+        SUCCEEDED(debug_reference->GetValue(&object_address)) &&
+        cache->Find(object_address, dereferenced_value)) {
+      *is_null = FALSE;
+      return S_OK;
+    }
+  }
+
   BOOL local_is_null = FALSE;
   HRESULT hr;
   int reference_depth = 0;
@@ -237,6 +267,10 @@ HRESULT CorDebugHelper::Dereference(ICorDebugValue *debug_value,
     return E_FAIL;
   }
 
+  if (cache && !local_is_null && reference_depth > 0) {
+    cache->Add(object_address, temp_value);
+  }
+
   *is_null = local_is_null;
   (*dereferenced_value) = temp_value;
   temp_value->AddRef();
@@ -327,13 +361,43 @@ HRESULT CorDebugHelper::CreateStrongHandle(ICorDebugValue *debug_value,
     return hr;
   }
 
-  return heap_value->CreateHandle(CorDebugHandleType::HANDLE_STRONG, handle);
+  // During a hit, the objects share the handles of the hit.
+  StrongHandlePool *pool = StrongHandlePool::GetCurrent();
+  if (!pool) {
+    return heap_value->CreateHandle(CorDebugHandleType::HANDLE_STRONG,
+                                    handle);
+  }
+
+  CORDB_ADDRESS address = 0;
+  if (FAILED(debug_value->GetAddress(&address))) {
+    address = 0;
+  }
+
+  if (pool->Find(address, handle)) {
+    return S_OK;
+  }
+
+  hr = heap_value->CreateHandle(CorDebugHandleType::HANDLE_STRONG, handle);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  pool->Add(address, *handle);
+  return S_OK;
 }
 
 HRESULT CorDebugHelper::ExtractStringFromICorDebugStringValue(
     ICorDebugStringValue *debug_string, std::string *returned_string,
     std::ostream *err_stream) {
-  if (!returned_string || !debug_string || !err_stream) {
+  ULONG32 str_len;
+  return ExtractStringPrefixFromICorDebugStringValue(
+      debug_string, 0, returned_string, &str_len, err_stream);
+}
+
+HRESULT CorDebugHelper::ExtractStringPrefixFromICorDebugStringValue(
+    ICorDebugStringValue *debug_string, ULONG32 max_length,
+    std::string *returned_string, ULONG32 *length, std::ostream *err_stream) {
+  if (!returned_string || !debug_string || !length || !err_stream) {
     return E_INVALIDARG;
   }
 
@@ -347,21 +411,28 @@ HRESULT CorDebugHelper::ExtractStringFromICorDebugStringValue(
     return hr;
   }
 
+  *length = str_len;
   if (str_len == 0) {
     *returned_string = "";
     return S_OK;
   }
 
-  // Plus 1 for the NULL at the end of the string.
-  str_len += 1;
-  std::vector<WCHAR> string_value(str_len, 0);
+  if (max_length != 0 && str_len > max_length) {
+    str_len = max_length;
+  }
+
+  // Plus 1 for the NULL at the end of the string. If only a prefix is
+  // read, GetString copies just the characters that fit in the buffer.
+  std::vector<WCHAR> string_value(str_len + 1, 0);
 
-  hr = debug_string->GetString(str_len, &str_returned_len, string_value.data());
+  hr = debug_string->GetString(str_len + 1, &str_returned_len,
+                               string_value.data());
   if (FAILED(hr)) {
     *err_stream << "Failed to extract the string.";
     return hr;
   }
 
+  string_value[str_len] = 0;
   *returned_string = ConvertWCharPtrToString(string_value);
   return S_OK;
 }
@@ -483,11 +554,71 @@ HRESULT CorDebugHelper::ParsePropertySig(
                           generic_class_types, type_signature);
 }
 
+std::map<CorDebugHelper::TypeSignatureKey,
+         CorDebugHelper::ParsedTypeSignature>
+    CorDebugHelper::parsed_type_signatures_;
+
+std::mutex CorDebugHelper::parsed_type_signatures_mutex_;
+
 HRESULT CorDebugHelper::ParseTypeFromSig(
     PCCOR_SIGNATURE *signature, ULONG *sig_len,
     IMetaDataImport *metadata_import,
     const std::vector<TypeSignature> &generic_class_types,
     TypeSignature *type_signature) {
+  // A type may refer to the generic types of its class through
+  // ELEMENT_TYPE_VAR, so only types parsed without them are cached.
+  if (!metadata_import || !generic_class_types.empty()) {
+    return ParseTypeFromSigUncached(signature, sig_len, metadata_import,
+                                    generic_class_types, type_signature);
+  }
+
+  TypeSignatureKey key(metadata_import, *signature, *sig_len);
+  {
+    std::lock_guard<std::mutex> lock(parsed_type_signatures_mutex_);
+    auto parsed = parsed_type_signatures_.find(key);
+    if (parsed != parsed_type_signatures_.end()) {
+      *type_signature = parsed->second.type_signature;
+      *signature += parsed->second.sig_bytes;
+      *sig_len -= parsed->second.sig_bytes;
+      return S_OK;
+    }
+  }
+
+  ULONG original_sig_len = *sig_len;
+  HRESULT hr = ParseTypeFromSigUncached(signature, sig_len, metadata_import,
+                                        generic_class_types, type_signature);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  ParsedTypeSignature parsed;
+  parsed.type_signature = *type_signature;
+  parsed.sig_bytes = original_sig_len - *sig_len;
+
+  std::lock_guard<std::mutex> lock(parsed_type_signatures_mutex_);
+  if (parsed_type_signatures_.size() >= kMaximumCachedTypeSignatures) {
+    parsed_type_signatures_.clear();
+  }
+  parsed_type_signatures_[key] = std::move(parsed);
+  return hr;
+}
+
+void CorDebugHelper::RemoveParsedTypeSignatures(
+    IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(parsed_type_signatures_mutex_);
+  auto parsed = parsed_type_signatures_.lower_bound(
+      TypeSignatureKey(metadata_import, nullptr, 0));
+  while (parsed != parsed_type_signatures_.end() &&
+         std::get<0>(parsed->first) == metadata_import) {
+    parsed = parsed_type_signatures_.erase(parsed);
+  }
+}
+
+HRESULT CorDebugHelper::ParseTypeFromSigUncached(
+    PCCOR_SIGNATURE *signature, ULONG *sig_len,
+    IMetaDataImport *metadata_import,
+    const std::vector<TypeSignature> &generic_class_types,
+    TypeSignature *type_signature) {
   HRESULT hr;
   type_signature->cor_type = CorSigUncompressElementType(*signature);
   *sig_len -= 1;
@@ -509,8 +640,8 @@ HRESULT CorDebugHelper::ParseTypeFromSig(
     case CorElementType::ELEMENT_TYPE_SZARRAY: {
       // Extracts the array type.
       TypeSignature array_type;
-      hr = ParseTypeFromSig(signature, sig_len, metadata_import,
-                            generic_class_types, &array_type);
+      hr = ParseTypeFromSigUncached(signature, sig_len, metadata_import,
+                                    generic_class_types, &array_type);
       if (FAILED(hr)) {
         return hr;
       }
@@ -522,8 +653,8 @@ HRESULT CorDebugHelper::ParseTypeFromSig(
     case CorElementType::ELEMENT_TYPE_ARRAY: {
       // First we read the type.
       TypeSignature array_type;
-      hr = ParseTypeFromSig(signature, sig_len, metadata_import,
-                            generic_class_types, &array_type);
+      hr = ParseTypeFromSigUncached(signature, sig_len, metadata_import,
+                                    generic_class_types, &array_type);
       if (FAILED(hr)) {
         return hr;
       }
@@ -559,8 +690,8 @@ HRESULT CorDebugHelper::ParseTypeFromSig(
     case CorElementType::ELEMENT_TYPE_GENERICINST: {
       // First we read the type without generics.
       TypeSignature main_type;
-      hr = ParseTypeFromSig(signature, sig_len, metadata_import,
-                            generic_class_types, &main_type);
+      hr = ParseTypeFromSigUncached(signature, sig_len, metadata_import,
+                                    generic_class_types, &main_type);
       if (FAILED(hr)) {
         return hr;
       }
@@ -577,8 +708,8 @@ HRESULT CorDebugHelper::ParseTypeFromSig(
       // Now we get the generic arguments.
       for (size_t i = 0; i < generic_param_count; ++i) {
         TypeSignature generic_type;
-        hr = ParseTypeFromSig(signature, sig_len, metadata_import,
-                              generic_class_types, &generic_type);
+        hr = ParseTypeFromSigUncached(signature, sig_len, metadata_import,
+                                      generic_class_types, &generic_type);
         if (FAILED(hr)) {
           return hr;
         }
@@ -682,28 +813,24 @@ HRESULT CorDebugHelper::GetFieldInfo(IMetaDataImport *metadata_import,
                                      PCCOR_SIGNATURE *field_sig,
                                      ULONG *signature_len,
                                      std::ostream *err_stream) {
-  std::vector<WCHAR> wchar_field_name = ConvertStringToWCharPtr(field_name);
-  HRESULT hr = metadata_import->FindField(class_token, wchar_field_name.data(),
-                                          nullptr, 0, field_def);
+  MetadataCache &metadata_cache = MetadataCache::Global();
+  HRESULT hr = metadata_cache.FindField(metadata_import, class_token,
+                                        field_name, field_def);
   if (FAILED(hr)) {
     return hr;
   }
 
-  ULONG len_field;
-  DWORD field_attributes;
-  DWORD default_value_flags = 0;
-  UVCP_CONSTANT default_value;
-  ULONG default_value_len = 0;
   // Now we need to sets whether the field is static.
-  hr = metadata_import->GetFieldProps(*field_def, &class_token, nullptr, 0,
-                                      &len_field, &field_attributes, field_sig,
-                                      signature_len, &default_value_flags,
-                                      &default_value, &default_value_len);
+  FieldProps field_props;
+  hr = metadata_cache.GetFieldProps(metadata_import, *field_def, false,
+                                    &field_props);
   if (FAILED(hr)) {
     return hr;
   }
 
-  *is_static = IsFdStatic(field_attributes);
+  *field_sig = field_props.signature;
+  *signature_len = field_props.signature_length;
+  *is_static = IsFdStatic(field_props.attributes);
   return S_OK;
 }
 
@@ -711,6 +838,37 @@ HRESULT CorDebugHelper::GetPropertyInfo(
     IMetaDataImport *metadata_import, mdProperty class_token,
     const std::string &prop_name, std::unique_ptr<DbgClassProperty> *result,
     ICorDebugModule *debug_module, std::ostream *err_stream) {
+  // The property found for the name before is initialized without
+  // enumerating the properties of the class again.
+  MetadataCache &metadata_cache = MetadataCache::Global();
+  mdProperty cached_property;
+  if (metadata_cache.FindProperty(metadata_import, class_token, prop_name,
+                                  &cached_property)) {
+    if (cached_property == mdPropertyNil) {
+      return S_FALSE;
+    }
+
+    std::shared_ptr<ICorDebugHelper> debug_helper(new CorDebugHelper());
+    std::shared_ptr<IDbgObjectFactory> obj_factory(new DbgObjectFactory());
+    std::unique_ptr<DbgClassProperty> class_property(
+        new (std::nothrow) DbgClassProperty(debug_helper, obj_factory));
+    if (!class_property) {
+      *err_stream
+          << "Ran out of memory while trying to initialize class property ";
+      return E_OUTOFMEMORY;
+    }
+
+    class_property->Initialize(cached_property, metadata_import, debug_module,
+                               kDefaultObjectEvalDepth);
+    if (FAILED(class_property->GetInitializeHr())) {
+      *err_stream << "Failed to get property information.";
+      return class_property->GetInitializeHr();
+    }
+
+    *result = std::move(class_property);
+    return S_OK;
+  }
+
   HRESULT hr;
   std::vector<mdProperty> property_defs(kDefaultVectorSize, 0);
   HCORENUM cor_enum = nullptr;
@@ -752,6 +910,8 @@ HRESULT CorDebugHelper::GetPropertyInfo(
       }
 
       if (prop_name.compare(class_property->GetMemberName()) == 0) {
+        metadata_cache.AddProperty(metadata_import, class_token, prop_name,
+                                   property_defs[i]);
         *result = std::move(class_property);
         metadata_import->CloseEnum(cor_enum);
         return S_OK;
@@ -763,6 +923,8 @@ HRESULT CorDebugHelper::GetPropertyInfo(
     metadata_import->CloseEnum(cor_enum);
   }
 
+  metadata_cache.AddProperty(metadata_import, class_token, prop_name,
+                             mdPropertyNil);
   return S_FALSE;
 }
 
@@ -773,29 +935,22 @@ HRESULT CorDebugHelper::GetTypeNameFromMdTypeDef(
     return E_INVALIDARG;
   }
 
-  ULONG type_name_len = 0;
-  DWORD type_flags = 0;
-  HRESULT hr = metadata_import->GetTypeDefProps(
-      type_token, nullptr, 0, &type_name_len, &type_flags, base_token);
+  TypeProps type_props;
+  HRESULT hr = MetadataCache::Global().GetTypeProps(
+      metadata_import, type_token, true, &type_props);
   if (hr == S_FALSE) {
     hr = E_FAIL;
   }
 
-  if (FAILED(hr)) {
-    *err_stream << "Failed to get type name's length.";
-    return hr;
-  }
-
-  vector<WCHAR> wchar_type_name(type_name_len, 0);
-  hr = metadata_import->GetTypeDefProps(type_token, wchar_type_name.data(),
-                                        wchar_type_name.size(), &type_name_len,
-                                        &type_flags, base_token);
   if (FAILED(hr)) {
     *err_stream << "Failed to get type name.";
     return hr;
   }
 
-  *type_name = ConvertWCharPtrToString(wchar_type_name);
+  if (base_token) {
+    *base_token = type_props.extends;
+  }
+  *type_name = ConvertWCharPtrToString(type_props.name);
   return hr;
 }
 
@@ -806,28 +961,19 @@ HRESULT CorDebugHelper::GetTypeNameFromMdTypeRef(
     return E_INVALIDARG;
   }
 
-  ULONG type_name_len = 0;
-  HRESULT hr = metadata_import->GetTypeRefProps(type_token, nullptr, nullptr, 0,
-                                                &type_name_len);
+  TypeRefProps type_ref_props;
+  HRESULT hr = MetadataCache::Global().GetTypeRefProps(
+      metadata_import, type_token, true, &type_ref_props);
   if (hr == S_FALSE) {
     hr = E_FAIL;
   }
 
-  if (FAILED(hr)) {
-    *err_stream << "Failed to get type name's length.";
-    return hr;
-  }
-
-  vector<WCHAR> wchar_type_name(type_name_len, 0);
-  hr = metadata_import->GetTypeRefProps(type_token, nullptr,
-                                        wchar_type_name.data(),
-                                        wchar_type_name.size(), &type_name_len);
   if (FAILED(hr)) {
     *err_stream << "Failed to get type name.";
     return hr;
   }
 
-  *type_name = ConvertWCharPtrToString(wchar_type_name);
+  *type_name = ConvertWCharPtrToString(type_ref_props.name);
   return hr;
 }
 
@@ -859,23 +1005,25 @@ HRESULT CorDebugHelper::GetMdTypeDefAndMetaDataFromTypeRef(
   // We cannot use ResolveTypeRef here. It will just return a E_NOTIMPL
   // See
   // https://blogs.msdn.microsoft.com/davbr/2011/10/17/metadata-tokens-run-time-ids-and-type-loading/
-  mdToken assembly_ref;
-  ULONG type_ref_name_len = 0;
-  HRESULT hr = type_ref_token_metadata->GetTypeRefProps(
-      type_ref_token, &assembly_ref, nullptr, 0, &type_ref_name_len);
-  if (FAILED(hr)) {
-    *err_stream << "Failed to get type name's length.";
-    return hr;
+  MetadataCache &metadata_cache = MetadataCache::Global();
+  if (metadata_cache.FindResolvedTypeRef(type_ref_token_metadata,
+                                         type_ref_token, result_type_def,
+                                         result_type_def_metadata)) {
+    return S_OK;
+  }
+
+  TypeRefProps type_ref_props;
+  HRESULT hr = metadata_cache.GetTypeRefProps(
+      type_ref_token_metadata, type_ref_token, true, &type_ref_props);
+  if (hr == S_FALSE) {
+    hr = E_FAIL;
   }
 
-  std::vector<WCHAR> type_ref_name_wchar(type_ref_name_len, 0);
-  hr = type_ref_token_metadata->GetTypeRefProps(
-      type_ref_token, &assembly_ref, type_ref_name_wchar.data(),
-      type_ref_name_wchar.size(), &type_ref_name_len);
   if (FAILED(hr)) {
     *err_stream << "Failed to get type name.";
     return hr;
   }
+  const std::vector<WCHAR> &type_ref_name_wchar = type_ref_props.name;
 
   // Look through all available modules in all loaded assemblies and check
   // for a type name that matches type_ref_name_wchar.
@@ -910,6 +1058,9 @@ HRESULT CorDebugHelper::GetMdTypeDefAndMetaDataFromTypeRef(
         continue;
       }
 
+      metadata_cache.AddResolvedTypeRef(type_ref_token_metadata,
+                                        type_ref_token, *result_type_def,
+                                        metadata_import);
       *result_type_def_metadata = metadata_import;
       metadata_import->AddRef();
       return S_OK;
@@ -951,9 +1102,24 @@ HRESULT CorDebugHelper::GetAppDomainFromICorDebugFrame(
   return hr;
 }
 
+std::map<std::pair<IMetaDataImport *, mdToken>, uint32_t>
+    CorDebugHelper::generic_param_counts_;
+
+std::mutex CorDebugHelper::generic_param_counts_mutex_;
+
 HRESULT CorDebugHelper::CountGenericParams(IMetaDataImport *metadata_import,
                                            const mdToken &token,
                                            uint32_t *result) {
+  std::pair<IMetaDataImport *, mdToken> key(metadata_import, token);
+  {
+    std::lock_guard<std::mutex> lock(generic_param_counts_mutex_);
+    auto count = generic_param_counts_.find(key);
+    if (count != generic_param_counts_.end()) {
+      *result = count->second;
+      return S_OK;
+    }
+  }
+
   HRESULT hr;
   CComPtr<IMetaDataImport2> metadata_import_2;
 
@@ -983,9 +1149,26 @@ HRESULT CorDebugHelper::CountGenericParams(IMetaDataImport *metadata_import,
   }
 
   metadata_import_2->CloseEnum(cor_enum);
+
+  std::lock_guard<std::mutex> lock(generic_param_counts_mutex_);
+  if (generic_param_counts_.size() >= kMaximumCachedGenericParamCounts) {
+    generic_param_counts_.clear();
+  }
+  generic_param_counts_[key] = *result;
   return S_OK;
 }
 
+void CorDebugHelper::RemoveGenericParamCounts(
+    IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(generic_param_counts_mutex_);
+  auto count = generic_param_counts_.lower_bound(
+      std::make_pair(metadata_import, static_cast<mdToken>(0)));
+  while (count != generic_param_counts_.end() &&
+         count->first.first == metadata_import) {
+    count = generic_param_counts_.erase(count);
+  }
+}
+
 HRESULT CorDebugHelper::GetInstantiatedClassType(
     ICorDebugClass *debug_class,
     std::vector<CComPtr<ICorDebugType>> *parameter_types,
@@ -1054,6 +1237,14 @@ HRESULT CorDebugHelper::GetTypeInfoFromEncodedToken(
                                     &base_token, &std::cerr);
   }
 
+  // A type reference resolved before does not need the assemblies.
+  if (MetadataCache::Global().FindResolvedTypeRef(
+          metadata_import, decoded_token, type_def,
+          resolved_metadata_import)) {
+    return GetTypeNameFromMdTypeDef(*type_def, *resolved_metadata_import,
+                                    type_name, &base_token, &std::cerr);
+  }
+
   // We have to get all the assemblies in order to get
   // the IMetaDataImport and mdTypeDef that corresponds with the
   // mdTypeRef.
@@ -1123,7 +1314,7 @@ HRESULT CorDebugHelper::PopulateGenericClassTypesFromClassObject(
 }
 
 HRESULT CorDebugHelper::ProcessConstantSigBlob(
-    const std::vector<uint8_t> &signature_blob,
+    const uint8_t *signature_blob, uint32_t signature_size,
     CorElementType *cor_type,
     UVCP_CONSTANT *constant_value,
     ULONG *value_len,
@@ -1145,7 +1336,7 @@ HRESULT CorDebugHelper::ProcessConstantSigBlob(
       {CorElementType::ELEMENT_TYPE_U, 1},
       {CorElementType::ELEMENT_TYPE_STRING, 0}};
 
-  if (signature_blob.empty()) {
+  if (signature_size == 0) {
     cerr << "Signature blob of constant is empty.";
     return E_INVALIDARG;
   }
@@ -1164,7 +1355,7 @@ HRESULT CorDebugHelper::ProcessConstantSigBlob(
   // Check that there are enough bytes in the signature to read
   // the constant value.
   uint32_t const_size = cor_type_to_bytes_size[*cor_type];
-  if (signature_blob.size() <= const_size) {
+  if (signature_size <= const_size) {
     cerr << "Not enough bytes to retrieve constant value.";
     return E_FAIL;
   }
@@ -1172,28 +1363,28 @@ HRESULT CorDebugHelper::ProcessConstantSigBlob(
   // If this is a string, we need the data in the signature to be
   // divisible by sizeof(WCHAR) and get the length of the string.
   if (*cor_type == CorElementType::ELEMENT_TYPE_STRING) {
-    if ((signature_blob.size() - 1) % sizeof(WCHAR) != 0) {
+    if ((signature_size - 1) % sizeof(WCHAR) != 0) {
       cerr << "Not enough bytes to read string value for constant.";
       return E_FAIL;
     }
-    *value_len = (signature_blob.size() - 1) / sizeof(WCHAR);
+    *value_len = (signature_size - 1) / sizeof(WCHAR);
   }
 
   // The first byte of the blob is the CorElementType and the next
   // few bytes will be the constant_value.
-  *constant_value = (UVCP_CONSTANT)(signature_blob.data() + 1);
+  *constant_value = (UVCP_CONSTANT)(signature_blob + 1);
 
   // If there are bytes left, and the constant is not a string,
   // then this constant is an Enum and the remaining bytes are the metadata
   // token for the Enum class.
-  uint32_t bytes_left = signature_blob.size() - 1 - const_size;
+  uint32_t bytes_left = signature_size - 1 - const_size;
   if (bytes_left == 0 ||
       *cor_type == CorElementType::ELEMENT_TYPE_STRING) {
     return S_OK;
   }
 
-  remaining_bytes->assign(signature_blob.end() - bytes_left,
-                          signature_blob.end());
+  const uint8_t *signature_end = signature_blob + signature_size;
+  remaining_bytes->assign(signature_end - bytes_left, signature_end);
   return S_OK;
 }
 
@@ -15,13 +15,18 @@
 #ifndef COR_DEBUG_HELPER_H_
 #define COR_DEBUG_HELPER_H_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "cor.h"
 #include "cordebug.h"
 #include "i_cor_debug_helper.h"
+#include "type_signature.h"
 
 namespace google_cloud_debugger {
 
@@ -84,7 +89,9 @@ class CorDebugHelper : public ICorDebugHelper {
 
   // Given an ICorDebugValue, creates a strong handle to the underlying
   // object. ICorDebugValue must represents an object type that can
-  // be stored on the heap.
+  // be stored on the heap. While the calling thread has a current
+  // StrongHandlePool, the handle of an object is created once and
+  // shared until the pool disposes it.
   virtual HRESULT CreateStrongHandle(ICorDebugValue *debug_value,
                                      ICorDebugHandleValue **handle,
                                      std::ostream *err_stream) override;
@@ -94,6 +101,14 @@ class CorDebugHelper : public ICorDebugHelper {
       ICorDebugStringValue *debug_string, std::string *returned_string,
       std::ostream *err_stream) override;
 
+  // Extracts out at most the first max_length characters of a string
+  // from ICorDebugStringValue. Only that many characters are read from
+  // the debuggee.
+  virtual HRESULT ExtractStringPrefixFromICorDebugStringValue(
+      ICorDebugStringValue *debug_string, ULONG32 max_length,
+      std::string *returned_string, ULONG32 *length,
+      std::ostream *err_stream) override;
+
   // Given a metadata token for the parameter param_token,
   // extracts out the parameter name.
   // metadata_import is the MetaDataImport of the module
@@ -136,6 +151,8 @@ class CorDebugHelper : public ICorDebugHelper {
   // Given a PCCOR_SIGNATURE signature, parses the type
   // and stores the result in type_name. Also update the sig_len.
   // Will modify the signature pointer PCCOR_SIGNATURE.
+  // Types that do not depend on generic_class_types are parsed once
+  // per signature and module and then copied from a cache.
   virtual HRESULT ParseTypeFromSig(
       PCCOR_SIGNATURE *signature, ULONG *sig_len,
       IMetaDataImport *metadata_import,
@@ -200,6 +217,7 @@ class CorDebugHelper : public ICorDebugHelper {
       std::ostream *err_stream) override;
 
   // Count generic params of method/class referred to by mdToken.
+  // The counts are cached until the module of metadata_import is unloaded.
   virtual HRESULT CountGenericParams(IMetaDataImport *metadata_import,
                                      const mdToken &token,
                                      uint32_t *result) override;
@@ -246,13 +264,46 @@ class CorDebugHelper : public ICorDebugHelper {
   // If the constant is an enum, remaining_bytes will contain the enum
   // class metadata token.
   virtual HRESULT ProcessConstantSigBlob(
-      const std::vector<uint8_t> &signature_blob,
+      const uint8_t *signature_blob, uint32_t signature_size,
       CorElementType *cor_type,
       UVCP_CONSTANT *constant_value,
       ULONG *value_len,
       std::vector<uint8_t> *remaining_bytes) override;
 
+  // Clears the cache of the types parsed from signatures.
+  static void ClearParsedTypeSignatures() {
+    std::lock_guard<std::mutex> lock(parsed_type_signatures_mutex_);
+    parsed_type_signatures_.clear();
+  }
+
+  // Removes the parsed type signatures of the module of metadata_import,
+  // which is being unloaded.
+  static void RemoveParsedTypeSignatures(IMetaDataImport *metadata_import);
+
+  // Removes the cached generic parameter counts of the module of
+  // metadata_import, which is being unloaded.
+  static void RemoveGenericParamCounts(IMetaDataImport *metadata_import);
+
  private:
+  // Signature of a type in a module, identified by the IMetaDataImport of
+  // the module, the start of the signature and its remaining length.
+  typedef std::tuple<IMetaDataImport *, PCCOR_SIGNATURE, ULONG>
+      TypeSignatureKey;
+
+  // A type parsed from a signature and the number of bytes it took.
+  struct ParsedTypeSignature {
+    TypeSignature type_signature;
+    ULONG sig_bytes = 0;
+  };
+
+  // Parses the type at signature without looking at the cache. Called
+  // by ParseTypeFromSig and for the types nested in a type.
+  HRESULT ParseTypeFromSigUncached(
+      PCCOR_SIGNATURE *signature, ULONG *sig_len,
+      IMetaDataImport *metadata_import,
+      const std::vector<TypeSignature> &generic_class_types,
+      TypeSignature *type_signature);
+
   // Given a PCCOR_SIGNATURE signature, parses the next byte A.
   // Then, parses and skips the next A bytes.
   // Will modify the signature pointer PCCOR_SIGNATURE.
@@ -264,6 +315,26 @@ class CorDebugHelper : public ICorDebugHelper {
   // Will modify the signature pointer PCCOR_SIGNATURE.
   HRESULT ParseAndCheckFirstByte(PCCOR_SIGNATURE *signature, ULONG *sig_len,
                                  CorCallingConvention calling_convention);
+
+  // Cache of the types parsed from signatures, which is kept across
+  // breakpoint hits. The signatures stay valid until their module is
+  // unloaded. It is cleared once it has kMaximumCachedTypeSignatures
+  // types.
+  static std::map<TypeSignatureKey, ParsedTypeSignature>
+      parsed_type_signatures_;
+
+  // Protects parsed_type_signatures_.
+  static std::mutex parsed_type_signatures_mutex_;
+
+  // Cache of the number of generic parameters of the methods and classes
+  // of each module, which saves enumerating them for every frame in a
+  // generic class. It is cleared once it has
+  // kMaximumCachedGenericParamCounts counts.
+  static std::map<std::pair<IMetaDataImport *, mdToken>, uint32_t>
+      generic_param_counts_;
+
+  // Protects generic_param_counts_.
+  static std::mutex generic_param_counts_mutex_;
 };
 
 }  // namespace google_cloud_debugger
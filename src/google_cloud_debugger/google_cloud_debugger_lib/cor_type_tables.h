@@ -0,0 +1,276 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COR_TYPE_TABLES_H_
+#define COR_TYPE_TABLES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "class_names.h"
+#include "cor.h"
+
+// Tables of the C# type rules over CorElementType, generated at compile
+// time from the rules of the C# specification, so that the compiler
+// helpers and the evaluators look a rule up with a single load instead
+// of walking branches on every compile and evaluation.
+namespace google_cloud_debugger {
+
+// The numeric types are contiguous in CorElementType, from char to double,
+// so that the conversion and promotion tables are indexed by the distance
+// of a type from char.
+static_assert(CorElementType::ELEMENT_TYPE_I1 ==
+                      CorElementType::ELEMENT_TYPE_CHAR + 1 &&
+                  CorElementType::ELEMENT_TYPE_U8 ==
+                      CorElementType::ELEMENT_TYPE_CHAR + 8 &&
+                  CorElementType::ELEMENT_TYPE_R8 ==
+                      CorElementType::ELEMENT_TYPE_CHAR + 10,
+              "The numeric CorElementTypes are not contiguous.");
+
+// The number of numeric types, and the number of CorElementTypes the
+// trait and name tables cover.
+constexpr std::size_t kNumericCorTypes = CorElementType::ELEMENT_TYPE_R8 -
+                                         CorElementType::ELEMENT_TYPE_CHAR + 1;
+constexpr std::size_t kTabledCorTypes = CorElementType::ELEMENT_TYPE_MAX;
+
+// Traits of a CorElementType, as bits of a byte.
+constexpr std::uint8_t kIntegralCorType = 1;
+constexpr std::uint8_t kNumericalCorType = 2;
+constexpr std::uint8_t kSignedIntegralCorType = 4;
+constexpr std::uint8_t kPromotedToIntCorType = 8;
+
+// Returns true if cor_type is one of the numeric types.
+constexpr bool IsNumericCorType(int cor_type) {
+  return cor_type >= CorElementType::ELEMENT_TYPE_CHAR &&
+         cor_type <= CorElementType::ELEMENT_TYPE_R8;
+}
+
+// Returns the size in bits of the integral type cor_type, char being an
+// unsigned 16-bit type.
+constexpr int IntegralCorTypeBits(int cor_type) {
+  return cor_type == CorElementType::ELEMENT_TYPE_I1 ||
+                 cor_type == CorElementType::ELEMENT_TYPE_U1
+             ? 8
+             : cor_type == CorElementType::ELEMENT_TYPE_I2 ||
+                       cor_type == CorElementType::ELEMENT_TYPE_U2 ||
+                       cor_type == CorElementType::ELEMENT_TYPE_CHAR
+                   ? 16
+                   : cor_type == CorElementType::ELEMENT_TYPE_I4 ||
+                             cor_type == CorElementType::ELEMENT_TYPE_U4
+                         ? 32
+                         : 64;
+}
+
+// Returns the traits of cor_type.
+constexpr std::uint8_t CorTypeTraits(int cor_type) {
+  return !IsNumericCorType(cor_type)
+             ? 0
+             : cor_type >= CorElementType::ELEMENT_TYPE_R4
+                   ? kNumericalCorType
+                   : kIntegralCorType | kNumericalCorType |
+                         (cor_type == CorElementType::ELEMENT_TYPE_I1 ||
+                                  cor_type == CorElementType::ELEMENT_TYPE_I2 ||
+                                  cor_type == CorElementType::ELEMENT_TYPE_I4 ||
+                                  cor_type == CorElementType::ELEMENT_TYPE_I8
+                              ? kSignedIntegralCorType
+                              : 0) |
+                         (IntegralCorTypeBits(cor_type) < 32
+                              ? kPromotedToIntCorType
+                              : 0);
+}
+
+// Returns true if the numeric type source converts implicitly to the
+// numeric type target, following the implicit numeric conversions of
+// the C# specification:
+// https://docs.microsoft.com/en-us/dotnet/csharp/language-reference/language-specification/conversions#implicit-numeric-conversions
+// Every numeric type converts to double, and every one but double to
+// float. An integral type converts to an integral type that holds all
+// of its values, except that nothing but char converts to char.
+constexpr bool ConvertsImplicitly(int source, int target) {
+  return target == CorElementType::ELEMENT_TYPE_R8 ||
+         (target == CorElementType::ELEMENT_TYPE_R4
+              ? source != CorElementType::ELEMENT_TYPE_R8
+              : source == target ||
+                    (target != CorElementType::ELEMENT_TYPE_CHAR &&
+                     (CorTypeTraits(source) & kIntegralCorType) &&
+                     (CorTypeTraits(source) & kSignedIntegralCorType
+                          ? (CorTypeTraits(target) & kSignedIntegralCorType) &&
+                                IntegralCorTypeBits(target) >
+                                    IntegralCorTypeBits(source)
+                          : IntegralCorTypeBits(target) >
+                                    IntegralCorTypeBits(source) ||
+                                (!(CorTypeTraits(target) &
+                                   kSignedIntegralCorType) &&
+                                 IntegralCorTypeBits(target) ==
+                                     IntegralCorTypeBits(source)))));
+}
+
+// Returns true if either of the types is type.
+constexpr bool EitherCorTypeIs(int first, int second, int type) {
+  return first == type || second == type;
+}
+
+// Returns true if either of the types is a signed integral type.
+constexpr bool EitherCorTypeIsSigned(int first, int second) {
+  return ((CorTypeTraits(first) | CorTypeTraits(second)) &
+          kSignedIntegralCorType) != 0;
+}
+
+// Returns the type both numeric types first and second are promoted to
+// by the binary numeric promotions of the C# specification:
+// https://docs.microsoft.com/en-us/dotnet/csharp/language-reference/language-specification/expressions#binary-numeric-promotions
+// Returns ELEMENT_TYPE_END if they cannot be promoted, which is the case
+// of ulong and a signed integral type.
+// TODO(quoct): Add support for Decimal.
+constexpr CorElementType PromoteCorTypes(int first, int second) {
+  return EitherCorTypeIs(first, second, CorElementType::ELEMENT_TYPE_R8)
+             ? CorElementType::ELEMENT_TYPE_R8
+         : EitherCorTypeIs(first, second, CorElementType::ELEMENT_TYPE_R4)
+             ? CorElementType::ELEMENT_TYPE_R4
+         : EitherCorTypeIs(first, second, CorElementType::ELEMENT_TYPE_U8)
+             ? (EitherCorTypeIsSigned(first, second)
+                    ? CorElementType::ELEMENT_TYPE_END
+                    : CorElementType::ELEMENT_TYPE_U8)
+         : EitherCorTypeIs(first, second, CorElementType::ELEMENT_TYPE_I8)
+             ? CorElementType::ELEMENT_TYPE_I8
+         : EitherCorTypeIs(first, second, CorElementType::ELEMENT_TYPE_U4)
+             ? (EitherCorTypeIsSigned(first, second)
+                    ? CorElementType::ELEMENT_TYPE_I8
+                    : CorElementType::ELEMENT_TYPE_U4)
+             : CorElementType::ELEMENT_TYPE_I4;
+}
+
+// Returns the name of the class of cor_type, or null if it has no
+// single class.
+constexpr const std::string *CorTypeClassName(int cor_type) {
+  return cor_type == CorElementType::ELEMENT_TYPE_BOOLEAN ? &kBooleanClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_CHAR  ? &kCharClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_I1    ? &kSByteClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_U1    ? &kByteClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_I2    ? &kInt16ClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_U2    ? &kUInt16ClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_I4    ? &kInt32ClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_U4    ? &kUInt32ClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_I8    ? &kInt64ClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_U8    ? &kUInt64ClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_R4    ? &kSingleClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_R8    ? &kDoubleClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_I     ? &kIntPtrClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_U     ? &kUIntPtrClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_STRING
+             ? &kStringClassName
+         : cor_type == CorElementType::ELEMENT_TYPE_OBJECT
+             ? &kObjectClassName
+             : nullptr;
+}
+
+// A table of N values of type T.
+template <typename T, std::size_t N>
+struct CorTypeTable {
+  constexpr T operator[](std::size_t index) const { return values[index]; }
+
+  T values[N];
+};
+
+// The sequence of indices 0, 1, ..., N - 1, to generate the tables with.
+template <std::size_t... I>
+struct CorTypeIndices {};
+
+template <std::size_t N, std::size_t... I>
+struct MakeCorTypeIndices : MakeCorTypeIndices<N - 1, N - 1, I...> {};
+
+template <std::size_t... I>
+struct MakeCorTypeIndices<0, I...> {
+  typedef CorTypeIndices<I...> type;
+};
+
+template <std::size_t... I>
+constexpr CorTypeTable<std::uint8_t, sizeof...(I)> MakeCorTypeTraitsTable(
+    CorTypeIndices<I...>) {
+  return {{CorTypeTraits(I)...}};
+}
+
+template <std::size_t... I>
+constexpr CorTypeTable<const std::string *, sizeof...(I)>
+MakeCorTypeClassNameTable(CorTypeIndices<I...>) {
+  return {{CorTypeClassName(I)...}};
+}
+
+// The numeric conversion and promotion matrices are indexed by
+// source * kNumericCorTypes + target, and first * kNumericCorTypes + second.
+template <std::size_t... I>
+constexpr CorTypeTable<bool, sizeof...(I)> MakeImplicitConversionTable(
+    CorTypeIndices<I...>) {
+  return {{ConvertsImplicitly(
+      CorElementType::ELEMENT_TYPE_CHAR + I / kNumericCorTypes,
+      CorElementType::ELEMENT_TYPE_CHAR + I % kNumericCorTypes)...}};
+}
+
+template <std::size_t... I>
+constexpr CorTypeTable<CorElementType, sizeof...(I)> MakePromotionTable(
+    CorTypeIndices<I...>) {
+  return {{PromoteCorTypes(
+      CorElementType::ELEMENT_TYPE_CHAR + I / kNumericCorTypes,
+      CorElementType::ELEMENT_TYPE_CHAR + I % kNumericCorTypes)...}};
+}
+
+// The traits and class names of the CorElementTypes.
+constexpr CorTypeTable<std::uint8_t, kTabledCorTypes> kCorTypeTraits =
+    MakeCorTypeTraitsTable(MakeCorTypeIndices<kTabledCorTypes>::type());
+constexpr CorTypeTable<const std::string *, kTabledCorTypes>
+    kCorTypeClassNames =
+        MakeCorTypeClassNameTable(MakeCorTypeIndices<kTabledCorTypes>::type());
+
+// The implicit numeric conversion and binary numeric promotion matrices.
+constexpr CorTypeTable<bool, kNumericCorTypes * kNumericCorTypes>
+    kImplicitNumericConversions = MakeImplicitConversionTable(
+        MakeCorTypeIndices<kNumericCorTypes * kNumericCorTypes>::type());
+constexpr CorTypeTable<CorElementType, kNumericCorTypes * kNumericCorTypes>
+    kBinaryNumericPromotions = MakePromotionTable(
+        MakeCorTypeIndices<kNumericCorTypes * kNumericCorTypes>::type());
+
+// Returns the traits of cor_type from kCorTypeTraits.
+constexpr std::uint8_t LookUpCorTypeTraits(CorElementType cor_type) {
+  return static_cast<std::size_t>(cor_type) < kTabledCorTypes
+             ? kCorTypeTraits[cor_type]
+             : 0;
+}
+
+// Returns the index of the numeric type cor_type in the matrices.
+constexpr std::size_t NumericCorTypeIndex(CorElementType cor_type) {
+  return cor_type - CorElementType::ELEMENT_TYPE_CHAR;
+}
+
+// Returns true if the numeric type source converts implicitly to the
+// numeric type target, from kImplicitNumericConversions.
+constexpr bool LookUpConversion(CorElementType source,
+                                CorElementType target) {
+  return kImplicitNumericConversions[NumericCorTypeIndex(source) *
+                                         kNumericCorTypes +
+                                     NumericCorTypeIndex(target)];
+}
+
+// Returns the type the numeric types first and second are promoted to,
+// from kBinaryNumericPromotions.
+constexpr CorElementType LookUpPromotion(CorElementType first,
+                                         CorElementType second) {
+  return kBinaryNumericPromotions[NumericCorTypeIndex(first) *
+                                      kNumericCorTypes +
+                                  NumericCorTypeIndex(second)];
+}
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  COR_TYPE_TABLES_H_
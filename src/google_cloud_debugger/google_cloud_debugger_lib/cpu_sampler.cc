@@ -0,0 +1,339 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "cpu_sampler.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include "breakpoint.pb.h"
+#include "thread_scheduling.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Variable;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// A thread registered with CpuSampler::RegisterThread.
+struct ThreadCpuState {
+  const char *role = nullptr;
+
+  // The phase the thread is in, set by the thread and read by samples.
+  std::atomic<const char *> phase{nullptr};
+
+  // Reads the CPU time of the thread from any thread.
+#ifdef _WIN32
+  HANDLE thread = nullptr;
+#else
+  clockid_t clock;
+#endif
+
+  // CPU time of the thread in microseconds read by the previous sample.
+  std::uint64_t sampled_us = 0;
+
+  // Set when the thread exits, with its CPU time at that point, since
+  // it cannot be read afterwards.
+  bool exited = false;
+  std::uint64_t exit_us = 0;
+};
+
+// The threads registered and not sampled since they exited. Never freed
+// so that threads can exit while the process exits.
+struct CpuRegistry {
+  std::vector<std::shared_ptr<ThreadCpuState>> threads;
+  std::mutex mutex;
+};
+
+CpuRegistry *GetCpuRegistry() {
+  static CpuRegistry *registry = new CpuRegistry();
+  return registry;
+}
+
+#ifdef _WIN32
+// Returns the microseconds in the 100-nanosecond intervals of time.
+std::uint64_t FileTimeToUs(const FILETIME &time) {
+  ULARGE_INTEGER intervals;
+  intervals.LowPart = time.dwLowDateTime;
+  intervals.HighPart = time.dwHighDateTime;
+  return intervals.QuadPart / 10;
+}
+#else
+// Reads clock in microseconds into time_us.
+bool ReadClockUs(clockid_t clock, std::uint64_t *time_us) {
+  struct timespec time;
+  if (clock_gettime(clock, &time) != 0) {
+    return false;
+  }
+  *time_us = static_cast<std::uint64_t>(time.tv_sec) * 1000000 +
+             static_cast<std::uint64_t>(time.tv_nsec) / 1000;
+  return true;
+}
+#endif
+
+// Reads the CPU time of the thread of state in microseconds.
+bool ReadThreadCpuUs(const ThreadCpuState &state, std::uint64_t *time_us) {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(state.thread, &creation, &exit, &kernel, &user)) {
+    return false;
+  }
+  *time_us = FileTimeToUs(kernel) + FileTimeToUs(user);
+  return true;
+#else
+  return ReadClockUs(state.clock, time_us);
+#endif
+}
+
+// Reads the CPU time of the process in microseconds.
+bool ReadProcessCpuUs(std::uint64_t *time_us) {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel,
+                       &user)) {
+    return false;
+  }
+  *time_us = FileTimeToUs(kernel) + FileTimeToUs(user);
+  return true;
+#else
+  return ReadClockUs(CLOCK_PROCESS_CPUTIME_ID, time_us);
+#endif
+}
+
+// Marks the state of a registered thread as exited when the thread exits.
+class ThreadCpuRegistration {
+ public:
+  ~ThreadCpuRegistration() {
+    if (!state) {
+      return;
+    }
+
+    std::uint64_t time_us = state->sampled_us;
+    CpuRegistry *registry = GetCpuRegistry();
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    ReadThreadCpuUs(*state, &time_us);
+    state->exit_us = time_us;
+    state->exited = true;
+  }
+
+  std::shared_ptr<ThreadCpuState> state;
+};
+
+// The state of the calling thread. thread_state is what SetPhase reads,
+// since it needs no guard to be accessed.
+thread_local ThreadCpuRegistration thread_registration;
+thread_local ThreadCpuState *thread_state = nullptr;
+
+// Adds a variable named name with value value to variables.
+Variable *AddVariable(const string &name, std::uint64_t value,
+                      google::protobuf::RepeatedPtrField<Variable> *variables) {
+  Variable *variable = variables->Add();
+  variable->set_name(name);
+  variable->set_value(std::to_string(value));
+  return variable;
+}
+
+// Adds a variable named name with value total and a member for each
+// entry of times to variables.
+void AddTimes(const string &name, std::uint64_t total,
+              const std::map<string, std::uint64_t> &times,
+              google::protobuf::RepeatedPtrField<Variable> *variables) {
+  Variable *variable = AddVariable(name, total, variables);
+  for (const auto &time : times) {
+    AddVariable(time.first, time.second, variable->mutable_members());
+  }
+}
+
+}  // namespace
+
+CpuSampler::~CpuSampler() { Stop(); }
+
+CpuSampler &CpuSampler::Global() {
+  static CpuSampler sampler;
+  return sampler;
+}
+
+void CpuSampler::RegisterThread(const char *role) {
+  if (thread_state) {
+    return;
+  }
+
+  std::shared_ptr<ThreadCpuState> state(new (std::nothrow) ThreadCpuState());
+  if (!state) {
+    return;
+  }
+  state->role = role;
+#ifdef _WIN32
+  if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(),
+                       GetCurrentProcess(), &state->thread,
+                       THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0)) {
+    return;
+  }
+#else
+  if (pthread_getcpuclockid(pthread_self(), &state->clock) != 0) {
+    return;
+  }
+#endif
+  // Time used before the thread is registered is not attributed to it.
+  ReadThreadCpuUs(*state, &state->sampled_us);
+
+  CpuRegistry *registry = GetCpuRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  registry->threads.push_back(state);
+  thread_registration.state = state;
+  thread_state = state.get();
+}
+
+const char *CpuSampler::SetPhase(const char *phase) {
+  if (!thread_state) {
+    return nullptr;
+  }
+  return thread_state->phase.exchange(phase, std::memory_order_relaxed);
+}
+
+bool CpuSampler::ReadProcessCpuTime(std::uint64_t *time_us) {
+  return ReadProcessCpuUs(time_us);
+}
+
+void CpuSampler::Start(std::chrono::milliseconds interval) {
+  if (interval.count() <= 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> thread_lock(thread_mutex_);
+  if (thread_.joinable() || stop_) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SampleLocked(false);
+    start_time_ = sample_time_;
+    started_ = true;
+  }
+  thread_ = std::thread(&CpuSampler::SampleEvery, this, interval);
+}
+
+void CpuSampler::Stop() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    stop_ = true;
+    std::swap(thread, thread_);
+  }
+  stop_cv_.notify_all();
+
+  if (thread.joinable()) {
+    thread.join();
+    Sample();
+  }
+}
+
+void CpuSampler::Sample() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  SampleLocked(true);
+}
+
+void CpuSampler::SampleEvery(std::chrono::milliseconds interval) {
+  RegisterThread("cpu_sampler");
+  ThreadScheduling::Global().ApplyToBackgroundThread();
+  std::unique_lock<std::mutex> lock(thread_mutex_);
+  while (!stop_cv_.wait_for(lock, interval, [this] { return stop_; })) {
+    lock.unlock();
+    Sample();
+    lock.lock();
+  }
+}
+
+void CpuSampler::SampleLocked(bool record) {
+  std::uint64_t threads_us = 0;
+  CpuRegistry *registry = GetCpuRegistry();
+  {
+    std::lock_guard<std::mutex> registry_lock(registry->mutex);
+    auto thread = registry->threads.begin();
+    while (thread != registry->threads.end()) {
+      ThreadCpuState &state = **thread;
+      std::uint64_t time_us = state.exit_us;
+      if (!state.exited && !ReadThreadCpuUs(state, &time_us)) {
+        ++thread;
+        continue;
+      }
+
+      std::uint64_t used_us =
+          time_us > state.sampled_us ? time_us - state.sampled_us : 0;
+      state.sampled_us = time_us;
+      if (record) {
+        const char *phase = state.phase.load(std::memory_order_relaxed);
+        role_time_us_[state.role] += used_us;
+        phase_time_us_[phase ? phase : "none"] += used_us;
+        threads_us += used_us;
+      }
+
+      if (!state.exited) {
+        ++thread;
+        continue;
+      }
+#ifdef _WIN32
+      CloseHandle(state.thread);
+#endif
+      thread = registry->threads.erase(thread);
+    }
+  }
+
+  std::uint64_t process_us = process_sampled_us_;
+  ReadProcessCpuUs(&process_us);
+  std::uint64_t used_us =
+      process_us > process_sampled_us_ ? process_us - process_sampled_us_ : 0;
+  process_sampled_us_ = process_us;
+  sample_time_ = std::chrono::steady_clock::now();
+  if (record) {
+    process_time_us_ += used_us;
+    role_time_us_["other"] += used_us > threads_us ? used_us - threads_us : 0;
+  }
+}
+
+void CpuSampler::AddToBreakpoint(Breakpoint *breakpoint) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!started_) {
+    return;
+  }
+
+  std::uint64_t threads_us = 0;
+  for (const auto &phase : phase_time_us_) {
+    threads_us += phase.second;
+  }
+
+  google::protobuf::RepeatedPtrField<Variable> *variables =
+      breakpoint->mutable_evaluated_expressions();
+  AddTimes("cpu_time_us", process_time_us_, role_time_us_, variables);
+  AddTimes("cpu_phase_time_us", threads_us, phase_time_us_, variables);
+  AddVariable("cpu_wall_time_us",
+              duration_cast<microseconds>(sample_time_ - start_time_).count(),
+              variables);
+}
+
+}  // namespace google_cloud_debugger
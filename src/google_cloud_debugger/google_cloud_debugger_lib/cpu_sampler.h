@@ -0,0 +1,149 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef CPU_SAMPLER_H_
+#define CPU_SAMPLER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace google {
+namespace cloud {
+namespace diagnostics {
+namespace debug {
+class Breakpoint;
+}  // namespace debug
+}  // namespace diagnostics
+}  // namespace cloud
+}  // namespace google
+
+namespace google_cloud_debugger {
+
+// Samples the CPU time used by the threads of the debugger. Threads
+// register themselves with a role, like the thread of the debugger
+// callbacks or a worker of the evaluation pool, and mark the phases of
+// their work with DEBUGGER_TRACE_SPAN. Every sample attributes the CPU
+// time each thread used since the previous sample to its role and to the
+// phase it is in when the sample is taken. The time of a role is exact,
+// while its split between phases is statistical and gets more precise
+// with shorter intervals. CPU time of threads that are not registered is
+// attributed to the role "other".
+class CpuSampler {
+ public:
+  CpuSampler() = default;
+  CpuSampler(const CpuSampler &) = delete;
+  CpuSampler &operator=(const CpuSampler &) = delete;
+
+  // Stops sampling.
+  ~CpuSampler();
+
+  // Returns the sampler of this debugger, which is the one that
+  // BreakpointCollection reports to the agent with the metrics.
+  static CpuSampler &Global();
+
+  // Registers the calling thread under role, which has to be a string
+  // literal. Does nothing if the thread is already registered.
+  static void RegisterThread(const char *role);
+
+  // Sets the phase of the calling thread to phase, which has to be a
+  // string literal or null for no phase, and returns the previous phase.
+  // Does nothing and returns null if the thread is not registered.
+  static const char *SetPhase(const char *phase);
+
+  // Reads the CPU time of the process in microseconds into time_us.
+  // Returns false if it cannot be read.
+  static bool ReadProcessCpuTime(std::uint64_t *time_us);
+
+  // Starts a thread that samples every interval until Stop is called.
+  // Does nothing if interval is 0 or the sampler was started before.
+  void Start(std::chrono::milliseconds interval);
+
+  // Takes a last sample and stops the thread started by Start.
+  void Stop();
+
+  // Attributes the CPU time used since the previous sample. Called by the
+  // thread started by Start.
+  void Sample();
+
+  // Adds the CPU time sampled since Start to the evaluated expressions of
+  // breakpoint: cpu_time_us is the CPU time of the debugger, with the
+  // time of each role as members, cpu_phase_time_us is the CPU time of
+  // the registered threads, with the time of each phase as members, and
+  // cpu_wall_time_us is the time elapsed. Adds nothing before Start.
+  void AddToBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) const;
+
+ private:
+  // Samples every interval until stop_ is set.
+  void SampleEvery(std::chrono::milliseconds interval);
+
+  // Implements Sample. The time since the previous sample is only
+  // attributed if record is true. Must be called with mutex_ held.
+  void SampleLocked(bool record);
+
+  // CPU time in microseconds attributed to each role and each phase.
+  // Time of registered threads outside of any phase is in phase "none".
+  std::map<std::string, std::uint64_t> role_time_us_;
+  std::map<std::string, std::uint64_t> phase_time_us_;
+
+  // CPU time of the process in microseconds read by the previous sample,
+  // and the time attributed since Start.
+  std::uint64_t process_sampled_us_ = 0;
+  std::uint64_t process_time_us_ = 0;
+
+  // When Start was called and when the previous sample was taken.
+  std::chrono::steady_clock::time_point start_time_;
+  std::chrono::steady_clock::time_point sample_time_;
+
+  // True once Start is called.
+  bool started_ = false;
+
+  // Protects everything above.
+  mutable std::mutex mutex_;
+
+  // The thread started by Start and whether it has to stop.
+  std::thread thread_;
+  bool stop_ = false;
+
+  // Protects thread_ and stop_.
+  std::mutex thread_mutex_;
+
+  // Signaled when stop_ is set.
+  std::condition_variable stop_cv_;
+};
+
+// Sets the phase of the calling thread for the rest of the enclosing
+// scope. Use it through DEBUGGER_TRACE_SPAN.
+class CpuPhase {
+ public:
+  explicit CpuPhase(const char *name)
+      : previous_(CpuSampler::SetPhase(name)) {}
+  CpuPhase(const CpuPhase &) = delete;
+  CpuPhase &operator=(const CpuPhase &) = delete;
+
+  ~CpuPhase() { CpuSampler::SetPhase(previous_); }
+
+ private:
+  const char *previous_;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  //  CPU_SAMPLER_H_
@@ -16,10 +16,12 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <vector>
 
+#include "embedded_pdb.h"
 #include "metadata_headers.h"
 
 #include "cor_debug_helper.h"
@@ -29,8 +31,6 @@
 using std::cerr;
 using std::ifstream;
 using std::ios;
-using std::min;
-using std::streampos;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -51,30 +51,64 @@ const std::uint32_t kCompressedSignedIntOneByteUncompressMask = 0xFFFFFFC0;
 const std::uint32_t kCompressedSignedIntTwoByteUncompressMask = 0xFFFFE000;
 const std::uint32_t kCompressedSignedIntFourByteUncompressMask = 0xF0000000;
 
-// Size of the buffer used by GetString to read characters into.
-const std::uint32_t kStringBufferSize = 100;
+namespace {
+
+// The number of bytes a compressed integer is encoded in, indexed by the
+// first three bits of its first byte. 0 if the first byte is invalid.
+const uint8_t kCompressedIntSizes[8] = {1, 1, 1, 1, 2, 2, 4, 0};
+
+// Returns the number of bytes of the compressed integer that starts with
+// first_byte, or 0 if first_byte is invalid.
+uint8_t GetCompressedIntSize(uint8_t first_byte) {
+  return kCompressedIntSizes[first_byte >> 5];
+}
+
+}  // namespace
 
 bool CustomBinaryStream::ConsumeStream(std::istream *stream) {
   assert(stream != nullptr);
 
-  stream_.reset(stream);
+  unique_ptr<std::istream> owned_stream(stream);
+  if (!owned_stream->good()) {
+    cerr << "Invalid stream.";
+    return false;
+  }
 
-  if (stream_->good()) {
-    stream_->unsetf(std::ios::skipws);
-    stream_->seekg(0, stream_->end);
-    absolute_end_ = stream_->tellg();
-    relative_end_ = absolute_end_;
-    stream_->seekg(0, stream_->beg);
-    begin_ = stream_->tellg();
+  owned_stream->unsetf(std::ios::skipws);
+  owned_stream->seekg(0, owned_stream->end);
+  std::streamoff size = owned_stream->tellg();
+  owned_stream->seekg(0, owned_stream->beg);
+  if (size < 0) {
+    cerr << "Invalid stream.";
+    return false;
+  }
 
-    return true;
+  mapped_file_.reset();
+  buffer_.resize(static_cast<size_t>(size));
+  if (!buffer_.empty()) {
+    owned_stream->read(reinterpret_cast<char *>(buffer_.data()),
+                       buffer_.size());
+    if (owned_stream->gcount() != static_cast<std::streamsize>(size)) {
+      cerr << "Failed to read the stream.";
+      return false;
+    }
   }
 
-  cerr << "Invalid stream.";
-  return false;
+  SetContent(buffer_.data(), buffer_.size());
+  return true;
 }
 
 bool CustomBinaryStream::ConsumeFile(const string &file) {
+  unique_ptr<MemoryMappedFile> mapped_file(new (std::nothrow)
+                                               MemoryMappedFile());
+  if (mapped_file && mapped_file->Open(file)) {
+    buffer_.clear();
+    mapped_file_ = std::move(mapped_file);
+    SetContent(mapped_file_->GetData(), mapped_file_->GetSize());
+    return true;
+  }
+
+  // Falls back to reading the whole file into memory.
   unique_ptr<std::ifstream> file_stream = unique_ptr<std::ifstream>(
       new (std::nothrow) ifstream(file, ios::in | ios::binary | ios::ate));
   // Let the caller throws the error.
@@ -85,180 +119,166 @@ bool CustomBinaryStream::ConsumeFile(const string &file) {
   return ConsumeStream(file_stream.release());
 }
 
+bool CustomBinaryStream::ConsumeEmbeddedPdb(const string &module_file) {
+  MemoryMappedFile module;
+  if (!module.Open(module_file)) {
+    return false;
+  }
+
+  EmbeddedPdb embedded_pdb;
+  if (!embedded_pdb.Find(module.GetData(), module.GetSize())) {
+    return false;
+  }
+
+  vector<uint8_t> pdb(embedded_pdb.GetPdbSize());
+  if (!embedded_pdb.Inflate(pdb.data())) {
+    return false;
+  }
+
+  mapped_file_.reset();
+  buffer_.swap(pdb);
+  SetContent(buffer_.data(), buffer_.size());
+  return true;
+}
+
+void CustomBinaryStream::SetContent(const uint8_t *bytes, size_t size) {
+  data_ = bytes;
+  absolute_end_ = static_cast<uint32_t>(size);
+  relative_end_ = absolute_end_;
+  position_ = 0;
+}
+
 bool CustomBinaryStream::ReadBytes(uint8_t *result, uint32_t bytes_to_read,
                                    uint32_t *bytes_read) {
-  assert(stream_ != nullptr);
-  if (relative_end_ - stream_->tellg() < bytes_to_read) {
+  if (relative_end_ - position_ < bytes_to_read) {
     cerr << "End of stream reached.";
     return false;
   }
 
-  stream_->read(reinterpret_cast<char *>(result), bytes_to_read);
-  *bytes_read = stream_->gcount();
-  return *bytes_read == bytes_to_read;
+  memcpy(result, data_ + position_, bytes_to_read);
+  position_ += bytes_to_read;
+  *bytes_read = bytes_to_read;
+  return true;
 }
 
-bool CustomBinaryStream::HasNext() const {
-  assert(stream_ != nullptr);
-  return stream_->tellg() < relative_end_;
-}
+bool CustomBinaryStream::HasNext() const { return position_ < relative_end_; }
 
 bool CustomBinaryStream::Peek(uint8_t *result) const {
-  assert(stream_ != nullptr);
   if (!HasNext()) {
     cerr << "End of stream reached.";
     return false;
   }
 
-  *result = stream_->peek();
+  *result = data_[position_];
   return true;
 }
 
 bool CustomBinaryStream::SeekFromCurrent(uint32_t index) {
-  assert(stream_ != nullptr);
   // Have to take into account the end_ based on the stream
   // length that we set.
-  if (relative_end_ - stream_->tellg() < index) {
+  if (relative_end_ - position_ < index) {
     cerr << "Seeking to a position out of range of the stream.";
     return false;
   }
 
-  stream_->seekg(index, stream_->cur);
-  if (stream_->fail()) {
-    cerr << "Seek operation failed.";
-    stream_->clear();
-    return false;
-  }
-
+  position_ += index;
   return true;
 }
 
 bool CustomBinaryStream::SeekFromOrigin(uint32_t position) {
-  assert(stream_ != nullptr);
-
-  stream_->seekg(position, stream_->beg);
-  if (stream_->fail()) {
+  if (position > absolute_end_) {
     cerr << "Seek operation failed.";
-    stream_->clear();
     return false;
   }
+
+  position_ = position;
   return true;
 }
 
 bool CustomBinaryStream::SetStreamLength(uint32_t length) {
-  assert(stream_ != nullptr);
-
-  streampos cur_pos = stream_->tellg();
-  stream_->seekg(length, stream_->cur);
-  if (stream_->fail()) {
-    stream_->clear();
-    stream_->seekg(cur_pos);
+  if (absolute_end_ - position_ < length) {
     cerr << "Setting stream length to " << length
          << " will set the relative end of the stream to a position"
          << " outside the absolute end of the stream.";
     return false;
   }
 
-  if (stream_->tellg() > relative_end_) {
-    stream_->seekg(cur_pos);
+  if (position_ + length > relative_end_) {
     cerr << "Setting stream length to " << length
          << " will set the relative end of the stream to a position"
          << " outside the relative end of the stream.";
     return false;
   }
 
-  // Sets the relative end and sets the stream back.
-  relative_end_ = stream_->tellg();
-  stream_->seekg(cur_pos);
+  relative_end_ = position_ + length;
   return true;
 }
 
-void CustomBinaryStream::ResetStreamLength() {
-  assert(stream_ != nullptr);
+void CustomBinaryStream::ResetStreamLength() { relative_end_ = absolute_end_; }
 
-  relative_end_ = absolute_end_;
-}
-
-bool CustomBinaryStream::GetString(std::string *result, std::uint32_t offset) {
-  result->clear();
-  assert(stream_ != nullptr);
-
-  // Makes a copy of the current position so we can restores the stream.
-  streampos previous_pos = stream_->tellg();
-  stream_->seekg(offset, stream_->beg);
-  if (stream_->fail()) {
-    stream_->clear();
-    stream_->seekg(previous_pos);
+bool CustomBinaryStream::GetStringSpan(uint32_t offset, const char **data,
+                                       uint32_t *length) const {
+  if (offset > relative_end_) {
     cerr << "Failed to seek to the offset point.";
     return false;
   }
 
-  // Read 100 characters at a time or until the end of the stream,
-  // whichever is smaller.
-  uint32_t chars_left = relative_end_ - stream_->tellg();
-  uint32_t char_to_read = min(kStringBufferSize, chars_left);
-  vector<char> buffer(char_to_read, 0);
-
-  while (char_to_read != 0) {
-    // Reads char_to_read bytes from the buffer.
-    stream_->read(buffer.data(), char_to_read);
-    if (stream_->fail()) {
-      stream_->clear();
-      stream_->seekg(previous_pos);
-      cerr << "Failed to read characters from the stream.";
-      return false;
-    }
+  const char *start = reinterpret_cast<const char *>(data_ + offset);
+  uint32_t chars_left = relative_end_ - offset;
+  const void *null_char = memchr(start, 0, chars_left);
 
-    // Finds the null character.
-    vector<char>::iterator null_char_pos =
-        std::find(buffer.begin(), buffer.end(), 0);
+  *data = start;
+  *length = null_char ? static_cast<const char *>(null_char) - start
+                      : chars_left;
+  return true;
+}
 
-    result->append(buffer.begin(), null_char_pos);
-    // Stop reading if we found the null character.
-    if (null_char_pos != buffer.end()) {
-      break;
-    }
+bool CustomBinaryStream::GetString(std::string *result,
+                                   std::uint32_t offset) const {
+  result->clear();
 
-    // If we didn't find the null character, continue reading.
-    chars_left = relative_end_ - stream_->tellg();
-    char_to_read = min((uint32_t)buffer.size(), chars_left);
+  const char *data;
+  uint32_t length;
+  if (!GetStringSpan(offset, &data, &length)) {
+    return false;
   }
 
-  stream_->seekg(previous_pos);
+  result->assign(data, length);
   return true;
 }
 
-bool CustomBinaryStream::GetBlobBytes(
-    std::uint32_t offset, std::vector<uint8_t> *result) {
-  result->clear();
-  assert(stream_ != nullptr);
-
-  // Makes a copy of the current position so we can restores the stream.
-  streampos previous_pos = stream_->tellg();
-  stream_->seekg(offset, stream_->beg);
-  if (stream_->fail()) {
-    stream_->clear();
-    stream_->seekg(previous_pos);
+bool CustomBinaryStream::GetBlobSpan(uint32_t offset, const uint8_t **data,
+                                     uint32_t *length) const {
+  if (offset > absolute_end_) {
     cerr << "Failed to seek to the offset point.";
     return false;
   }
 
-  uint32_t const_size = 0;
-  if (!ReadCompressedUInt32(&const_size)) {
-      stream_->clear();
-      stream_->seekg(previous_pos);
-      cerr << "Failed to get length of blob.";
-      return false;
+  uint32_t position = offset;
+  uint32_t blob_size = 0;
+  if (!ReadCompressedUInt32At(&position, &blob_size)) {
+    cerr << "Failed to get length of blob.";
+    return false;
   }
 
-  uint32_t bytes_read;
-  result->resize(const_size);
-  if (!ReadBytes(result->data(), const_size, &bytes_read)) {
-    stream_->seekg(previous_pos);
+  if (relative_end_ - position < blob_size) {
+    cerr << "End of stream reached.";
     return false;
   }
 
-  stream_->seekg(previous_pos);
+  *data = data_ + position;
+  *length = blob_size;
+  return true;
+}
+
+bool CustomBinaryStream::GetSpan(uint32_t offset, uint32_t length,
+                                 const uint8_t **data) const {
+  if (offset > relative_end_ || relative_end_ - offset < length) {
+    cerr << "End of stream reached.";
+    return false;
+  }
+
+  *data = data_ + offset;
   return true;
 }
 
@@ -269,58 +289,59 @@ bool CustomBinaryStream::ReadByte(uint8_t *result) {
 
 bool CustomBinaryStream::ReadUInt16(uint16_t *result) {
   uint32_t bytes_read = 0;
-  vector<uint8_t> buffer(2, 0);
-  if (!ReadBytes(buffer.data(), 2, &bytes_read)) {
-    return false;
-  }
-
-  memcpy(result, buffer.data(), 2);
-  return true;
+  return ReadBytes(reinterpret_cast<uint8_t *>(result), 2, &bytes_read);
 }
 
 bool CustomBinaryStream::ReadUInt32(uint32_t *result) {
   uint32_t bytes_read = 0;
-  vector<uint8_t> buffer(4, 0);
-  if (!ReadBytes(buffer.data(), 4, &bytes_read)) {
-    return false;
-  }
-
-  memcpy(result, buffer.data(), 4);
-  return true;
+  return ReadBytes(reinterpret_cast<uint8_t *>(result), 4, &bytes_read);
 }
 
 bool CustomBinaryStream::ReadCompressedUInt32(uint32_t *uncompress_int) {
-  uint8_t first_byte;
-  if (!ReadByte(&first_byte)) {
+  return ReadCompressedUInt32At(&position_, uncompress_int);
+}
+
+bool CustomBinaryStream::ReadCompressedUInt32At(
+    uint32_t *position, uint32_t *uncompress_int) const {
+  if (*position >= relative_end_) {
+    cerr << "End of stream reached.";
     return false;
   }
 
+  uint8_t first_byte = data_[*position];
+
   // If the first bit is a 0, return the value. Range 0 - 0x7F.
   if ((first_byte & kCompressedIntOneByteMask) == 0) {
     *uncompress_int = first_byte;
+    *position += 1;
     return true;
   }
 
-  uint8_t second_byte;
-  if (!ReadByte(&second_byte)) {
+  if (relative_end_ - *position < 2) {
+    cerr << "End of stream reached.";
     return false;
   }
 
+  uint8_t second_byte = data_[*position + 1];
+
   // If the first two bits are "10", return the first two bytes.
   // Mask it with 0b11000000 (0xC0) and confirm the result is 0b10000000 (0x80).
   // Result should be in the range 0x80 - 0x3FFF.
   if ((first_byte & kCompressedIntTwoByteMask) == kCompressedIntOneByteMask) {
     *uncompress_int = ((first_byte << 8) | second_byte) &
                       kCompressedUIntTwoByteUncompressMask;
+    *position += 2;
     return true;
   }
 
-  uint8_t third_byte;
-  uint8_t fourth_byte;
-  if (!ReadByte(&third_byte) || !ReadByte(&fourth_byte)) {
+  if (relative_end_ - *position < 4) {
+    cerr << "End of stream reached.";
     return false;
   }
 
+  uint8_t third_byte = data_[*position + 2];
+  uint8_t fourth_byte = data_[*position + 3];
+
   // If the first three bits are "110", return the first four bytes.
   // Mask it with 0b11100000 (0xE0) and confirm the result is 0b11000000 (0xC0).
   // Result should be in the range 0x4000 - 0x1FFFFFFF.
@@ -328,6 +349,7 @@ bool CustomBinaryStream::ReadCompressedUInt32(uint32_t *uncompress_int) {
     *uncompress_int = ((first_byte << 24) | (second_byte << 16) |
                        (third_byte << 8) | fourth_byte) &
                       kCompressedUIntFourByteUncompressMask;
+    *position += 4;
     return true;
   }
 
@@ -352,36 +374,24 @@ bool CustomBinaryStream::ReadCompressSignedInt32(int32_t *uncompressed_int) {
     return false;
   }
 
-  int32_t result = (int32_t)raw_bytes;
-  // Bits are rotated by 1 so 2 complement bit is at the end.
-  bool negative = ((result & 0x1) != 0);
-  result >>= 1;
-
-  if (negative) {
-    // To apply two's complement we merge the bits in based on the width.
-    // 1 byte uses 6 bits, 2 byte values use 14 bits, and 4 byte values use 28
-    // bits. Get the width by checking the first byte again.
-    if ((first_byte & kCompressedIntOneByteMask) == 0) {
-      result |= kCompressedSignedIntOneByteUncompressMask;
-    } else if ((first_byte & kCompressedIntTwoByteMask) ==
-               kCompressedIntOneByteMask) {
-      result |= kCompressedSignedIntTwoByteUncompressMask;
-    } else if ((first_byte & kCompressedIntFourByteMask) ==
-               kCompressedIntTwoByteMask) {
-      result |= kCompressedSignedIntFourByteUncompressMask;
-    } else {
-      return false;
-    }
-  }
-
-  *uncompressed_int = result;
+  *uncompressed_int =
+      ToCompressedSignedInt32(raw_bytes, GetCompressedIntSize(first_byte));
   return true;
 }
 
 bool CustomBinaryStream::ReadTableIndex(Heap heap, uint8_t heap_size,
                                         uint32_t *table_index) {
-  // The Heap enum also encodes the bit mask into the heapSize value.
-  if ((heap & heap_size) != 0x0) {
+  return ReadIndex(GetIndexSize(heap, heap_size), table_index);
+}
+
+bool CustomBinaryStream::ReadTableIndex(
+    MetadataTable table, const CompressedMetadataTableHeader &metadata_header,
+    uint32_t *table_index) {
+  return ReadIndex(GetIndexSize(table, metadata_header), table_index);
+}
+
+bool CustomBinaryStream::ReadIndex(uint8_t width, uint32_t *table_index) {
+  if (width == 4) {
     return ReadUInt32(table_index);
   }
 
@@ -394,51 +404,108 @@ bool CustomBinaryStream::ReadTableIndex(Heap heap, uint8_t heap_size,
   return true;
 }
 
-bool CustomBinaryStream::ReadTableIndex(
-    MetadataTable table, const CompressedMetadataTableHeader &metadata_header,
-    uint32_t *table_index) {
-  if (!metadata_header.valid_mask[static_cast<int>(table)]) {
-    // WARNING: If you are reading a table index into a metadata table that
-    // isn't present, something is wrong.
-    //
-    // In practice, this happens when you only load the PDB metadata tables and
-    // not the primary assembly's too. Since the PDB doesn't contain the rest of
-    // the metadata. If the table happens to contain more than 2^16 entries, we
-    // will read the wrong number of bytes and TERRIBLE THINGS will happen since
-    // all future reads will be corrupt.
-    //
-    // BUG: Read assembly metadata (headers at least) in addition to PDB
-    // metadata. For now we assume everything is less than 2^16.
-    uint16_t temp;
-    if (!ReadUInt16(&temp)) {
-      return false;
+bool CustomBinaryStream::ReadSpan(uint32_t length, const uint8_t **data) {
+  if (relative_end_ - position_ < length) {
+    cerr << "End of stream reached.";
+    return false;
+  }
+
+  *data = data_ + position_;
+  position_ += length;
+  return true;
+}
+
+bool DecodeCompressedInts(const uint8_t *data, uint32_t length,
+                          CompressedInts *result) {
+  assert(result != nullptr);
+
+  // There are at most length integers, so values and sizes are only
+  // allocated once.
+  vector<uint32_t> &values = result->values;
+  vector<uint8_t> &sizes = result->sizes;
+  values.clear();
+  sizes.clear();
+  values.reserve(length);
+  sizes.reserve(length);
+
+  uint32_t position = 0;
+  while (position < length) {
+    // Most integers of sequence point blobs are small deltas encoded in one
+    // byte. While the next 8 bytes have their first bit cleared, they are 8
+    // of those and are copied as they are.
+    while (length - position >= 8) {
+      uint64_t word;
+      memcpy(&word, data + position, sizeof(word));
+      if ((word & 0x8080808080808080ULL) != 0) {
+        break;
+      }
+
+      size_t count = values.size();
+      values.resize(count + 8);
+      sizes.resize(count + 8, 1);
+      for (size_t i = 0; i < 8; ++i) {
+        values[count + i] = data[position + i];
+      }
+      position += 8;
     }
 
-    *table_index = temp;
-    return true;
-  }
+    if (position == length) {
+      break;
+    }
 
-  uint32_t present_table_index = 0;
-  for (size_t index = 0; index < static_cast<int>(table); ++index) {
-    if (metadata_header.valid_mask[index]) {
-      ++present_table_index;
+    uint8_t first_byte = data[position];
+    uint8_t size = GetCompressedIntSize(first_byte);
+    if (size == 0) {
+      cerr << "Invalid compressed integer.";
+      return false;
     }
-  }
 
-  uint32_t rows_present = metadata_header.num_rows[present_table_index];
-  // If the table has less than 2^16 rows then it is stored using 2 bytes.
-  // Otherwise, 4 bytes.
-  if (rows_present < 0x10000) {  // 2^16
-    uint16_t temp;
-    if (!ReadUInt16(&temp)) {
+    if (length - position < size) {
+      cerr << "End of stream reached.";
       return false;
     }
 
-    *table_index = temp;
-    return true;
+    const uint8_t *bytes = data + position;
+    uint32_t value;
+    if (size == 1) {
+      value = first_byte;
+    } else if (size == 2) {
+      value = ((first_byte << 8) | bytes[1]) &
+              kCompressedUIntTwoByteUncompressMask;
+    } else {
+      value = ((first_byte << 24) | (bytes[1] << 16) | (bytes[2] << 8) |
+               bytes[3]) &
+              kCompressedUIntFourByteUncompressMask;
+    }
+
+    values.push_back(value);
+    sizes.push_back(size);
+    position += size;
+  }
+
+  return true;
+}
+
+int32_t ToCompressedSignedInt32(uint32_t value, uint8_t size) {
+  int32_t result = (int32_t)value;
+  // Bits are rotated by 1 so 2 complement bit is at the end.
+  bool negative = ((result & 0x1) != 0);
+  result >>= 1;
+
+  if (negative) {
+    // To apply two's complement we merge the bits in based on the width.
+    // 1 byte uses 6 bits, 2 byte values use 14 bits, and 4 byte values use 28
+    // bits.
+    if (size == 1) {
+      result |= kCompressedSignedIntOneByteUncompressMask;
+    } else if (size == 2) {
+      result |= kCompressedSignedIntTwoByteUncompressMask;
+    } else {
+      result |= kCompressedSignedIntFourByteUncompressMask;
+    }
   }
 
-  return ReadUInt32(table_index);
+  return result;
 }
 
 }  // namespace google_cloud_debugger_portable_pdb
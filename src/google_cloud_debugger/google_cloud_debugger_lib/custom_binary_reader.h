@@ -15,6 +15,7 @@
 #ifndef CUSTOM_BINARY_READER_H_
 #define CUSTOM_BINARY_READER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <iterator>
@@ -24,6 +25,7 @@
 
 #include "cor.h"
 
+#include "memory_mapped_file.h"
 #include "metadata_tables.h"
 
 // typedef std::vector<uint8_t>::const_iterator binary_stream_iter;
@@ -31,25 +33,31 @@
 namespace google_cloud_debugger_portable_pdb {
 struct CompressedMetadataTableHeader;
 
-enum Heap : std::uint8_t {
-  StringsHeap = 0x01,
-  GuidsHeap = 0x02,
-  BlobsHeap = 0x04
-};
-
-// Class that consumes a file or a uint8_t vector and produces a
+// Class that consumes a file or a stream and produces a
 // binary stream. This stream is used to read byte, integers,
 // compressed integers and table index.
+//
+// The content is accessed directly in memory: a file is memory-mapped
+// and a stream is read into a buffer once. Reads are then bounds checks
+// and copies out of that memory, and GetStringSpan/GetBlobSpan return
+// pointers into it without copying.
 class CustomBinaryStream {
  public:
-  // Consumes a binary stream pointer, takes ownership
-  // of the underlying stream and makes it the underlying
-  // stream of this class.
+  // Consumes a binary stream pointer and takes ownership of it.
+  // The content of the stream is read into a buffer owned by this class.
   bool ConsumeStream(std::istream *stream);
 
   // Consumes a file and exposes the file content as a binary stream.
+  // The file is memory-mapped. If it cannot be mapped, it is read
+  // into a buffer instead.
   bool ConsumeFile(const std::string &file);
 
+  // Consumes the Portable PDB embedded in the module file module_file
+  // (see EmbeddedPdb). The PDB is decompressed from the memory-mapped
+  // module into a buffer owned by this class. Returns false, and keeps
+  // the current content, if the module has no embedded PDB.
+  bool ConsumeEmbeddedPdb(const std::string &module_file);
+
   // Returns true if there is a next byte in the stream.
   bool HasNext() const;
 
@@ -73,12 +81,27 @@ class CustomBinaryStream {
 
   // Gets a string starting from the offset to a null terminating character or the end of the stream.
   // This function does not change the stream pointer.
-  bool GetString(std::string *result, std::uint32_t offset);
-
-  // Gets blob bytes starting from offset in the stream.
-  // The first byte will tell us the length of the blob.
-  // This function does not change the stream pointer.
-  bool GetBlobBytes(std::uint32_t offset, std::vector<uint8_t> *result);
+  bool GetString(std::string *result, std::uint32_t offset) const;
+
+  // Same as GetString but returns a pointer to the characters in the
+  // stream instead of copying them. The characters are not null terminated
+  // if the string ends at the end of the stream. The pointer is valid as
+  // long as this stream is.
+  bool GetStringSpan(std::uint32_t offset, const char **data,
+                     std::uint32_t *length) const;
+
+  // Gets a pointer to the length bytes starting from offset in the stream.
+  // This function does not change the stream pointer. The pointer is valid
+  // as long as this stream is.
+  bool GetSpan(std::uint32_t offset, std::uint32_t length,
+               const std::uint8_t **data) const;
+
+  // Gets a pointer to the blob bytes starting from offset in the stream.
+  // The first byte will tell us the length of the blob, which is returned
+  // in length. This function does not change the stream pointer. The
+  // pointer is valid as long as this stream is.
+  bool GetBlobSpan(std::uint32_t offset, const std::uint8_t **data,
+                   std::uint32_t *length) const;
 
   // Reads the next byte in the stream. Returns false if the byte
   // cannot be read.
@@ -89,6 +112,11 @@ class CustomBinaryStream {
   bool ReadBytes(std::uint8_t *result, std::uint32_t bytes_to_read,
                  std::uint32_t *bytes_read);
 
+  // Same as ReadBytes but returns a pointer to the length bytes in the
+  // stream instead of copying them, and advances the stream past them.
+  // The pointer is valid as long as this stream is.
+  bool ReadSpan(std::uint32_t length, const std::uint8_t **data);
+
   // Reads the next UInt16 from the stream. Returns false if the UInt16
   // cannot be read.
   bool ReadUInt16(std::uint16_t *result);
@@ -124,23 +152,66 @@ class CustomBinaryStream {
                       std::uint32_t *table_index);
 
   // Returns the current position of the stream.
-  std::streampos Current() { return stream_->tellg(); }
+  std::streampos Current() const { return position_; }
+
+  // Returns the length of the whole stream, ignoring SetStreamLength.
+  std::uint32_t GetLength() const { return absolute_end_; }
+
+  // Returns the bytes of the heap used for the content. A memory-mapped
+  // content is not counted, because the system can drop its pages.
+  std::size_t GetMemoryUsage() const { return buffer_.capacity(); }
 
  private:
-  // The underlying binary stream.
-  std::unique_ptr<std::istream> stream_;
+  // Points data_ and the end positions at bytes.
+  void SetContent(const std::uint8_t *bytes, std::size_t size);
+
+  // Reads an index of width (2 or 4) bytes.
+  bool ReadIndex(std::uint8_t width, std::uint32_t *table_index);
 
-  // The begin position of the stream.
-  std::streampos begin_;
+  // Reads a compressed unsigned integer starting at *position, which is
+  // advanced past it. Does not read past relative_end_.
+  bool ReadCompressedUInt32At(std::uint32_t *position,
+                              std::uint32_t *result) const;
+
+  // Buffer that holds the content when it is not memory-mapped.
+  std::vector<std::uint8_t> buffer_;
+
+  // The memory-mapped file, if the content comes from one.
+  std::unique_ptr<MemoryMappedFile> mapped_file_;
+
+  // The content of the stream, either mapped_file_ or buffer_.
+  const std::uint8_t *data_ = nullptr;
+
+  // The current position of the stream.
+  std::uint32_t position_ = 0;
 
   // The absolute end position of the stream.
-  std::streampos absolute_end_;
+  std::uint32_t absolute_end_ = 0;
 
   // The relative end position of the stream (sets by SetStreamLength), which
   // is as far in a PDB file as we need to read.
-  std::streampos relative_end_;
+  std::uint32_t relative_end_ = 0;
 };
 
+// The compressed integers of a blob, decoded by DecodeCompressedInts.
+struct CompressedInts {
+  // The integers, decoded as unsigned integers.
+  std::vector<std::uint32_t> values;
+
+  // The number of bytes (1, 2 or 4) each integer in values is encoded in.
+  std::vector<std::uint8_t> sizes;
+};
+
+// Decodes the length bytes at data, which have to be a sequence of
+// compressed unsigned integers (see ReadCompressedUInt32), in one pass.
+// Runs of integers encoded in one byte are decoded 8 at a time.
+bool DecodeCompressedInts(const std::uint8_t *data, std::uint32_t length,
+                          CompressedInts *result);
+
+// Returns the signed integer encoded by value, a compressed integer
+// decoded as unsigned from size bytes (see ReadCompressSignedInt32).
+std::int32_t ToCompressedSignedInt32(std::uint32_t value, std::uint8_t size);
+
 }  // namespace google_cloud_debugger_portable_pdb
 
 #endif
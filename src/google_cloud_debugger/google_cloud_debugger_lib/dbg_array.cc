@@ -14,12 +14,17 @@
 
 #include "dbg_array.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "class_names.h"
-#include "dbg_breakpoint.h"
+#include "dbg_primitive.h"
+#include "debuggee_memory_cache.h"
 #include "i_dbg_object_factory.h"
 #include "i_cor_debug_helper.h"
+#include "i_eval_coordinator.h"
+#include "number_format.h"
 #include "type_signature.h"
 #include "variable_wrapper.h"
 
@@ -30,6 +35,52 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+// Returns the size of an item of primitive type cor_type in an array,
+// or 0 if arrays of cor_type cannot be read directly from memory.
+// System.Char is not included since DbgPrimitive<char> holds 1 byte.
+static ULONG32 GetPrimitiveItemSize(CorElementType cor_type) {
+  switch (cor_type) {
+    case ELEMENT_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case ELEMENT_TYPE_I1:
+    case ELEMENT_TYPE_U1:
+      return 1;
+    case ELEMENT_TYPE_I2:
+    case ELEMENT_TYPE_U2:
+      return 2;
+    case ELEMENT_TYPE_I4:
+    case ELEMENT_TYPE_U4:
+    case ELEMENT_TYPE_R4:
+      return 4;
+    case ELEMENT_TYPE_I8:
+    case ELEMENT_TYPE_U8:
+    case ELEMENT_TYPE_R8:
+      return 8;
+    case ELEMENT_TYPE_I:
+    case ELEMENT_TYPE_U:
+      return sizeof(intptr_t);
+    default:
+      return 0;
+  }
+}
+
+// Creates a DbgPrimitive<T> of type debug_type with the value at
+// item_memory.
+template <typename T>
+static HRESULT CreatePrimitive(ICorDebugType *debug_type,
+                               const BYTE *item_memory,
+                               unique_ptr<DbgObject> *item) {
+  T value;
+  memcpy(&value, item_memory, sizeof(T));
+  item->reset(new (std::nothrow) DbgPrimitive<T>(debug_type, value));
+  if (!*item) {
+    return E_OUTOFMEMORY;
+  }
+
+  (*item)->Initialize(nullptr, FALSE);
+  return (*item)->GetInitializeHr();
+}
+
 void DbgArray::Initialize(ICorDebugValue *debug_value, BOOL is_null) {
   SetIsNull(is_null);
   CComPtr<ICorDebugType> debug_type;
@@ -140,9 +191,267 @@ HRESULT DbgArray::GetArrayItem(int position, ICorDebugValue **array_item) {
   return array_value->GetElementAtPosition(position, array_item);
 }
 
+// Failures of the direct read are not written to the error stream since
+// the items are then read one at a time.
+HRESULT DbgArray::ReadItemsMemory(int first_item, int item_count,
+                                  IEvalCoordinator *eval_coordinator,
+                                  vector<BYTE> *items_memory,
+                                  ULONG32 *item_size) {
+  if (!eval_coordinator || !items_memory || !item_size || !object_handle_ ||
+      first_item < 0 || item_count <= 0 ||
+      first_item + item_count > GetArraySize()) {
+    return E_INVALIDARG;
+  }
+
+  HRESULT hr;
+  CComPtr<ICorDebugThread> debug_thread;
+  CComPtr<ICorDebugProcess> debug_process;
+  hr = eval_coordinator->GetActiveDebugThread(&debug_thread);
+  if (FAILED(hr) || !debug_thread) {
+    return E_FAIL;
+  }
+
+  hr = debug_thread->GetProcess(&debug_process);
+  if (FAILED(hr) || !debug_process) {
+    return E_FAIL;
+  }
+
+  // The items are stored one after another, also in multi-dimensional
+  // arrays, and the size of an item is the size of its value.
+  CComPtr<ICorDebugValue> item;
+  hr = GetArrayItem(first_item, &item);
+  if (FAILED(hr) || !item) {
+    return E_FAIL;
+  }
+
+  CORDB_ADDRESS address;
+  hr = item->GetAddress(&address);
+  if (FAILED(hr) || address == 0) {
+    return E_FAIL;
+  }
+
+  hr = item->GetSize(item_size);
+  if (FAILED(hr) || *item_size == 0) {
+    return E_FAIL;
+  }
+
+  items_memory->resize(item_count * *item_size);
+  hr = DebuggeeMemoryCache::ReadMemory(debug_process, address,
+                                       items_memory->size(),
+                                       items_memory->data());
+  if (FAILED(hr)) {
+    return E_FAIL;
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgArray::GetItemFieldOffset(IMetaDataImport *metadata_import,
+                                     const std::string &field_name,
+                                     ULONG32 *offset) {
+  if (!metadata_import || !offset) {
+    return E_INVALIDARG;
+  }
+
+  HRESULT hr;
+  CComPtr<ICorDebugValue> item;
+  hr = GetArrayItem(0, &item);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  CComPtr<ICorDebugObjectValue> item_object;
+  hr = item->QueryInterface(__uuidof(ICorDebugObjectValue),
+                            reinterpret_cast<void **>(&item_object));
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  CComPtr<ICorDebugClass> item_class;
+  mdTypeDef item_class_token;
+  hr = item_object->GetClass(&item_class);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  hr = item_class->GetToken(&item_class_token);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  mdFieldDef field_def;
+  vector<WCHAR> wchar_field_name = ConvertStringToWCharPtr(field_name);
+  hr = metadata_import->FindField(item_class_token, wchar_field_name.data(),
+                                  nullptr, 0, &field_def);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  CComPtr<ICorDebugValue> field_value;
+  hr = item_object->GetFieldValue(item_class, field_def, &field_value);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  CORDB_ADDRESS item_address;
+  CORDB_ADDRESS field_address;
+  hr = item->GetAddress(&item_address);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  hr = field_value->GetAddress(&field_address);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (item_address == 0 || field_address < item_address) {
+    return E_FAIL;
+  }
+
+  *offset = static_cast<ULONG32>(field_address - item_address);
+  return S_OK;
+}
+
+HRESULT DbgArray::ReadPrimitiveItems(int first_item, int item_count,
+                                     IEvalCoordinator *eval_coordinator,
+                                     vector<BYTE> *items_memory,
+                                     ULONG32 *item_size) {
+  if (!empty_object_) {
+    return E_FAIL;
+  }
+
+  ULONG32 primitive_size =
+      GetPrimitiveItemSize(empty_object_->GetCorElementType());
+  if (primitive_size == 0) {
+    return E_FAIL;
+  }
+
+  HRESULT hr = ReadItemsMemory(first_item, item_count, eval_coordinator,
+                               items_memory, item_size);
+  if (FAILED(hr) || *item_size != primitive_size) {
+    return E_FAIL;
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgArray::CreatePrimitiveItem(const BYTE *item_memory,
+                                      unique_ptr<DbgObject> *item) {
+  switch (empty_object_->GetCorElementType()) {
+    case ELEMENT_TYPE_BOOLEAN:
+      return CreatePrimitive<bool>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_I1:
+      return CreatePrimitive<int8_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_U1:
+      return CreatePrimitive<uint8_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_I2:
+      return CreatePrimitive<int16_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_U2:
+      return CreatePrimitive<uint16_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_I4:
+      return CreatePrimitive<int32_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_U4:
+      return CreatePrimitive<uint32_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_I8:
+      return CreatePrimitive<int64_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_U8:
+      return CreatePrimitive<uint64_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_R4:
+      return CreatePrimitive<float>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_R8:
+      return CreatePrimitive<double>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_I:
+      return CreatePrimitive<intptr_t>(array_type_, item_memory, item);
+    case ELEMENT_TYPE_U:
+      return CreatePrimitive<uintptr_t>(array_type_, item_memory, item);
+    default:
+      return E_NOTIMPL;
+  }
+}
+
+void DbgArray::SelectItemPositions(int length, std::uint32_t max_items,
+                                   const CaptureLimits &limits,
+                                   vector<int> *positions) {
+  positions->clear();
+  if (length <= 0) {
+    return;
+  }
+
+  int count = length;
+  if (static_cast<std::uint32_t>(count) > max_items) {
+    count = max_items;
+  }
+
+  if (count == length) {
+    for (int i = 0; i < length; ++i) {
+      positions->push_back(i);
+    }
+    return;
+  }
+
+  switch (limits.array_capture_mode) {
+    case ArrayCaptureMode::kHeadAndTail: {
+      // The extra item of an odd count goes to the head.
+      int head_count = (count + 1) / 2;
+      for (int i = 0; i < head_count; ++i) {
+        positions->push_back(i);
+      }
+      for (int i = length - (count - head_count); i < length; ++i) {
+        positions->push_back(i);
+      }
+      return;
+    }
+    case ArrayCaptureMode::kStrided:
+      for (int i = 0; i < count; ++i) {
+        positions->push_back(static_cast<int>(
+            static_cast<std::int64_t>(i) * length / count));
+      }
+      return;
+    case ArrayCaptureMode::kRange: {
+      int first = length;
+      if (limits.array_range_start < static_cast<std::uint32_t>(length)) {
+        first = limits.array_range_start;
+      }
+      for (int i = first; i < length && i < first + count; ++i) {
+        positions->push_back(i);
+      }
+      return;
+    }
+    default:
+      for (int i = 0; i < count; ++i) {
+        positions->push_back(i);
+      }
+      return;
+  }
+}
+
+string DbgArray::GetItemName(int position) const {
+  // The last dimension changes the fastest. For example, the items of a
+  // 2x3 array are [0, 0], [0, 1], [0, 2], [1, 0], [1, 1] and [1, 2].
+  vector<ULONG32> indices(dimensions_.size(), 0);
+  for (int i = static_cast<int>(dimensions_.size()) - 1; i >= 0; --i) {
+    if (dimensions_[i] == 0) {
+      break;
+    }
+    indices[i] = position % dimensions_[i];
+    position /= dimensions_[i];
+  }
+
+  string name = "[";
+  for (size_t i = 0; i < indices.size(); ++i) {
+    AppendNumber(indices[i], &name);
+    if (i != indices.size() - 1) {
+      name += ", ";
+    }
+  }
+  name += "]";
+  return name;
+}
+
 HRESULT DbgArray::PopulateMembers(
     google::cloud::diagnostics::debug::Variable *variable_proto,
-    std::vector<VariableWrapper> *members,
+    std::vector<VariableWrapper> *members, const CaptureLimits &limits,
     IEvalCoordinator *eval_coordinator) {
   if (FAILED(initialize_hr_)) {
     return initialize_hr_;
@@ -156,97 +465,201 @@ HRESULT DbgArray::PopulateMembers(
     return S_OK;
   }
 
-  int total_items = 1;
-  for (int i = 0; i < dimensions_.size(); ++i) {
-    total_items *= dimensions_[i];
-  }
-
-  // We use this dimensions_tracker to help us track which combination
-  // of the array dimensions we are currently at (see comments just before the
-  // while loop).
-  vector<ULONG32> dimensions_tracker(dimensions_.size(), 0);
-
-  int current_index = 0;
-  // If this was not set yet, use the current maximum collection size
-  // from DbgBreakpoint.
-  if (max_items_to_retrieved_ == 0) {
-    max_items_to_retrieved_ = DbgBreakpoint::GetMaximumCollectionSize();
-  }
-
-  // In this while loop, we visit all possible combinations of the dimensions_
-  // array to print out all the items. For example, let's assume that the array
-  // has dimensions 2x3x4, then the while loop will go in this direction:
-  // 0 0 0 -> 0 0 1 -> 0 0 2 -> 0 0 3 ->
-  // 0 1 0 -> 0 1 1 -> 0 1 2 -> 0 1 3 ->
-  // 0 2 0 -> 0 2 1 -> 0 2 2 -> 0 2 3 ->
-  // 1 0 0 -> 1 0 1 -> 1 0 2 -> 1 0 3 ->
-  // 1 1 0 -> 1 1 1 -> 1 1 2 -> 1 1 3 ->
-  // 1 2 0 -> 1 2 1 -> 1 2 2 -> 1 2 3 ->
-  // 2 0 0 -> 2 0 1 -> 2 0 2 -> 2 0 3 ->
-  // 2 1 0 -> 2 1 1 -> 2 1 2 -> 2 1 3 ->
-  // 2 2 0 -> 2 2 1 -> 2 2 2 -> 2 2 3
-  while (current_index < total_items &&
-         current_index < max_items_to_retrieved_) {
-    // Uses the current combination as the name.
-    string name = "[";
-    for (int index = 0; index < dimensions_tracker.size(); ++index) {
-      name += std::to_string(dimensions_tracker[index]);
-      if (index != dimensions_tracker.size() - 1) {
-        name += ", ";
+  std::uint32_t max_items = limits.max_collection_items;
+  if (max_items_to_capture_ != 0 && max_items_to_capture_ < max_items) {
+    max_items = max_items_to_capture_;
+  }
+
+  if (dimensions_.size() > 1) {
+    vector<ULONG32> counts;
+    SelectDimensionCounts(dimensions_, max_items, &counts);
+    PopulateDimension(0, 0, counts, variable_proto, members,
+                      eval_coordinator);
+    return S_OK;
+  }
+
+  // A collection backed by the array, like List<T>, only uses the first
+  // max_items_to_retrieved_ items of it.
+  int length = GetArraySize();
+  if (max_items_to_retrieved_ != 0 &&
+      max_items_to_retrieved_ < static_cast<std::uint32_t>(length)) {
+    length = max_items_to_retrieved_;
+  }
+
+  vector<int> positions;
+  SelectItemPositions(length, max_items, limits, &positions);
+
+  // The arrays of a jagged array share its limit, so that capturing it
+  // does not create max_items items for each of them.
+  std::uint32_t max_item_items = 0;
+  if (!positions.empty()) {
+    max_item_items = std::max<std::uint32_t>(
+        1, max_items / static_cast<std::uint32_t>(positions.size()));
+  }
+
+  // Arrays of primitives are read with a single read of the memory of
+  // the debuggee for every run of consecutive items that are captured,
+  // instead of an ICorDebugValue for every item.
+  vector<BYTE> items_memory;
+  ULONG32 item_size = 0;
+  int run_first = -1;
+  int run_count = 0;
+  bool items_read = false;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    int position = positions[i];
+    if (position >= run_first + run_count || position < run_first) {
+      // Starts a new run with the captured items after this one.
+      run_first = position;
+      run_count = 1;
+      while (i + run_count < positions.size() &&
+             positions[i + run_count] == run_first + run_count) {
+        ++run_count;
       }
+      items_read = SUCCEEDED(ReadPrimitiveItems(
+          run_first, run_count, eval_coordinator, &items_memory, &item_size));
+    }
+
+    Variable *member = variable_proto->add_members();
+    member->set_name(GetItemName(position));
+    const BYTE *item_memory =
+        items_read ? items_memory.data() + (position - run_first) * item_size
+                   : nullptr;
+    AddItem(position, item_memory, max_item_items, member, members);
+  }
+
+  return S_OK;
+}
+
+void DbgArray::SelectDimensionCounts(const vector<ULONG32> &dimensions,
+                                     std::uint32_t max_items,
+                                     vector<ULONG32> *counts) {
+  counts->assign(dimensions.size(), 0);
+  for (ULONG32 dimension : dimensions) {
+    if (dimension == 0) {
+      return;
     }
-    name += "]";
-
-    ++current_index;
-    // Increase the combination by 1. For example: 0 0 0 becomes 0 0 1,
-    // 0 1 0 becomes 0 1 1, 0 1 1 becomes 1 0 0.
-    // First, we will find an index that we can increase.
-    if (current_index < total_items) {
-      int current_dimension_index = dimensions_.size() - 1;
-      while (current_dimension_index >= 0) {
-        // Spill over the addition until we can't.
-        ++dimensions_tracker[current_dimension_index];
-        if (dimensions_tracker[current_dimension_index] ==
-            dimensions_[current_dimension_index]) {
-          dimensions_tracker[current_dimension_index] = 0;
-          current_dimension_index -= 1;
-        } else {
+  }
+
+  // The shortest dimensions are given their counts first, so that the
+  // items they leave are shared by the longer ones.
+  vector<size_t> order(dimensions.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&dimensions](size_t a,
+                                                             size_t b) {
+    return dimensions[a] < dimensions[b];
+  });
+
+  std::uint64_t remaining = max_items;
+  for (size_t i = 0; i < order.size() && remaining > 0; ++i) {
+    std::uint64_t dimension = dimensions[order[i]];
+    std::uint64_t dimensions_left = order.size() - i;
+    std::uint64_t count = 1;
+    if (dimensions_left == 1) {
+      count = std::min(remaining, dimension);
+    } else {
+      // The largest count, up to the dimension, that the dimensions left
+      // can all have.
+      while (count < dimension) {
+        std::uint64_t product = 1;
+        for (std::uint64_t j = 0; j < dimensions_left && product <= remaining;
+             ++j) {
+          product *= count + 1;
+        }
+        if (product > remaining) {
           break;
         }
+        ++count;
       }
     }
 
-    // Adds a member at this index.
-    Variable *member = variable_proto->add_members();
-    member->set_name(name);
+    (*counts)[order[i]] = static_cast<ULONG32>(count);
+    remaining /= count;
+  }
+}
 
-    CComPtr<ICorDebugValue> array_item;
-    // Minus one here since we increase it above.
-    HRESULT hr = GetArrayItem(current_index - 1, &array_item);
+void DbgArray::PopulateDimension(size_t dimension, int first_position,
+                                 const vector<ULONG32> &counts,
+                                 Variable *variable_proto,
+                                 vector<VariableWrapper> *members,
+                                 IEvalCoordinator *eval_coordinator) {
+  // The number of items between consecutive indices of this dimension.
+  int stride = 1;
+  for (size_t i = dimension + 1; i < dimensions_.size(); ++i) {
+    stride *= dimensions_[i];
+  }
 
-    if (FAILED(hr)) {
-      // Output the error on why we failed to print out.
-      SetErrorStatusMessage(member, this);
-      continue;
+  if (dimension + 1 < dimensions_.size()) {
+    for (ULONG32 i = 0; i < counts[dimension]; ++i) {
+      Variable *member = variable_proto->add_members();
+      AssignIndexName(i, member->mutable_name());
+      PopulateDimension(dimension + 1,
+                        first_position + static_cast<int>(i) * stride, counts,
+                        member, members, eval_coordinator);
     }
+    return;
+  }
+
+  // The captured items of the last dimension are next to each other.
+  vector<BYTE> items_memory;
+  ULONG32 item_size = 0;
+  bool items_read = counts[dimension] > 0 &&
+                    SUCCEEDED(ReadPrimitiveItems(
+                        first_position, counts[dimension], eval_coordinator,
+                        &items_memory, &item_size));
+  for (ULONG32 i = 0; i < counts[dimension]; ++i) {
+    Variable *member = variable_proto->add_members();
+    AssignIndexName(i, member->mutable_name());
+    const BYTE *item_memory =
+        items_read ? items_memory.data() + i * item_size : nullptr;
+    AddItem(first_position + static_cast<int>(i), item_memory, 0, member,
+            members);
+  }
+}
 
-    unique_ptr<DbgObject> result_object;
-    hr = object_factory_->CreateDbgObject(
-        array_item, GetCreationDepth() - 1,
-        &result_object, GetErrorStream());
+void DbgArray::AddItem(int position, const BYTE *item_memory,
+                       std::uint32_t max_item_items, Variable *member,
+                       vector<VariableWrapper> *members) {
+  unique_ptr<DbgObject> result_object;
+  if (item_memory) {
+    HRESULT hr = CreatePrimitiveItem(item_memory, &result_object);
     if (FAILED(hr)) {
-      if (result_object) {
-        WriteError(result_object->GetErrorString());
-      }
-      // Output the error on why we failed to print out.
       SetErrorStatusMessage(member, this);
-      continue;
+      return;
     }
 
     members->push_back(VariableWrapper(member, std::move(result_object)));
+    return;
   }
 
-  return S_OK;
+  CComPtr<ICorDebugValue> array_item;
+  HRESULT hr = GetArrayItem(position, &array_item);
+
+  if (FAILED(hr)) {
+    // Output the error on why we failed to print out.
+    SetErrorStatusMessage(member, this);
+    return;
+  }
+
+  hr = object_factory_->CreateDbgObject(
+      array_item, GetCreationDepth() - 1,
+      &result_object, GetErrorStream());
+  if (FAILED(hr)) {
+    if (result_object) {
+      WriteError(result_object->GetErrorString());
+    }
+    // Output the error on why we failed to print out.
+    SetErrorStatusMessage(member, this);
+    return;
+  }
+
+  DbgArray *item_array = dynamic_cast<DbgArray *>(result_object.get());
+  if (item_array && max_item_items != 0) {
+    item_array->SetMaxItemsToCapture(max_item_items);
+  }
+
+  members->push_back(VariableWrapper(member, std::move(result_object)));
 }
 
 HRESULT DbgArray::GetTypeString(std::string *type_string) {
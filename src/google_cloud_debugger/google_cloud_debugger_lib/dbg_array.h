@@ -71,7 +71,7 @@ class DbgArray : public DbgReferenceObject {
   // be used to populate the members vector.
   HRESULT PopulateMembers(
       google::cloud::diagnostics::debug::Variable *variable_proto,
-      std::vector<VariableWrapper> *members,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
       IEvalCoordinator *eval_coordinator) override;
 
   // Gets the type of the array.
@@ -79,12 +79,21 @@ class DbgArray : public DbgReferenceObject {
   // type_string will be set to int[].
   HRESULT GetTypeString(std::string *type_string) override;
 
-  // Sets the maximum amount of items that the array will retrieve
-  // when PopulateMembers is called.
+  // Sets the number of items of the array that are in use, like the
+  // count of the List<T> it backs, so that PopulateMembers only captures
+  // items among them. The array never retrieves more items than the
+  // max_collection_items limit it is populated with.
   void SetMaxArrayItemsToRetrieve(std::uint32_t target) {
     max_items_to_retrieved_ = target;
   }
 
+  // Sets the number of items that PopulateMembers captures at most if it
+  // is lower than the max_collection_items limit. The arrays of a jagged
+  // array are given a share of the limit of the jagged array.
+  void SetMaxItemsToCapture(std::uint32_t max_items) {
+    max_items_to_capture_ = max_items;
+  }
+
   // Returns the size of the array.
   // This is calculated as the product of all the array dimensions.
   // For example:
@@ -93,10 +102,79 @@ class DbgArray : public DbgReferenceObject {
   //   3D array of 3x3x3 would have a size of 27.
   int GetArraySize();
 
+  // Sets positions to the positions of the items that are captured out
+  // of the first length items of an array, in increasing order. At most
+  // max_items are captured, chosen by the array_capture_mode of limits.
+  static void SelectItemPositions(int length, std::uint32_t max_items,
+                                  const CaptureLimits &limits,
+                                  std::vector<int> *positions);
+
+  // Sets counts to the number of items captured along each of the
+  // dimensions of a multi-dimensional array, so that at most max_items
+  // items are captured in total. The items left by short dimensions are
+  // shared by the longer ones.
+  static void SelectDimensionCounts(const std::vector<ULONG32> &dimensions,
+                                    std::uint32_t max_items,
+                                    std::vector<ULONG32> *counts);
+
   // Returns TypeSignature of this array.
   HRESULT GetTypeSignature(TypeSignature *type_signature) override;
 
+  // Reads item_count items starting at position first_item with a single
+  // read of the memory of the debuggee into items_memory, and sets
+  // item_size to the number of bytes of an item. The items must be
+  // values, not references. eval_coordinator gives the debuggee process.
+  HRESULT ReadItemsMemory(int first_item, int item_count,
+                          IEvalCoordinator *eval_coordinator,
+                          std::vector<BYTE> *items_memory,
+                          ULONG32 *item_size);
+
+  // If the items of the array are structs, sets offset to the offset of
+  // their field field_name from the start of an item. metadata_import
+  // has to be the metadata of the module of the struct.
+  HRESULT GetItemFieldOffset(IMetaDataImport *metadata_import,
+                             const std::string &field_name,
+                             ULONG32 *offset);
+
  private:
+  // Returns the name of the item at position, like "[1, 2]".
+  std::string GetItemName(int position) const;
+
+  // Populates variable_proto with a member for each of the first
+  // counts[dimension] indices of dimension of a multi-dimensional array,
+  // starting at first_position. The members of the last dimension are
+  // the items, which are read from the memory of the debuggee together
+  // if they are primitives.
+  void PopulateDimension(
+      size_t dimension, int first_position,
+      const std::vector<ULONG32> &counts,
+      google::cloud::diagnostics::debug::Variable *variable_proto,
+      std::vector<VariableWrapper> *members,
+      IEvalCoordinator *eval_coordinator);
+
+  // Adds the item at position to members as member. The item is created
+  // from item_memory if it is not null, and from its ICorDebugValue
+  // otherwise. An item that is an array captures at most max_item_items
+  // items, unless that is 0.
+  void AddItem(int position, const BYTE *item_memory,
+               std::uint32_t max_item_items,
+               google::cloud::diagnostics::debug::Variable *member,
+               std::vector<VariableWrapper> *members);
+
+  // If the items of the array are primitives, reads item_count of them
+  // starting at first_item from the memory of the debuggee with a single
+  // read into items_memory and sets item_size to the size of an item.
+  // Returns a failed HRESULT if they have to be read one at a time.
+  HRESULT ReadPrimitiveItems(int first_item, int item_count,
+                             IEvalCoordinator *eval_coordinator,
+                             std::vector<BYTE> *items_memory,
+                             ULONG32 *item_size);
+
+  // Creates a DbgObject for the primitive item that ReadPrimitiveItems
+  // read into item_memory.
+  HRESULT CreatePrimitiveItem(const BYTE *item_memory,
+                              std::unique_ptr<DbgObject> *item);
+
   // The type of the array.
   CComPtr<ICorDebugType> array_type_;
 
@@ -109,8 +187,13 @@ class DbgArray : public DbgReferenceObject {
   // a dimension in this array.
   std::vector<ULONG32> dimensions_;
 
-  // The maximum amount of items to retrieve in an array.
+  // The number of items of the array that are in use.
+  // 0 if all of them are.
   std::uint32_t max_items_to_retrieved_ = 0;
+
+  // The number of items PopulateMembers captures at most, if lower than
+  // the max_collection_items limit. 0 if there is no such limit.
+  std::uint32_t max_items_to_capture_ = 0;
 };
 
 }  //  namespace google_cloud_debugger
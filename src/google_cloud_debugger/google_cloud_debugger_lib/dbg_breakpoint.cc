@@ -16,11 +16,17 @@
 
 #include <algorithm>
 #include <cctype>
-#include <queue>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
 
 #include "compiler_helpers.h"
+#include "condition_program.h"
+#include "csharp_expression.h"
 #include "dbg_class_property.h"
 #include "document_index.h"
+#include "document_path_index.h"
 #include "expression_evaluator.h"
 #include "expression_util.h"
 #include "i_dbg_stack_frame.h"
@@ -31,11 +37,16 @@
 
 using google::cloud::diagnostics::debug::Breakpoint;
 using google::cloud::diagnostics::debug::SourceLocation;
+using google::cloud::diagnostics::debug::Status;
 using google::cloud::diagnostics::debug::Variable;
 using google_cloud_debugger_portable_pdb::DocumentIndex;
+using google_cloud_debugger_portable_pdb::DocumentPathIndex;
+using google_cloud_debugger_portable_pdb::IPortablePdbFile;
 using google_cloud_debugger_portable_pdb::LocalConstantRow;
 using google_cloud_debugger_portable_pdb::LocalScopeRow;
 using google_cloud_debugger_portable_pdb::LocalVariableRow;
+using google_cloud_debugger_portable_pdb::ScopedMethodsPin;
+using google_cloud_debugger_portable_pdb::SequencePointLocation;
 using google::cloud::diagnostics::debug::Breakpoint_LogLevel;
 using std::string;
 using std::unique_ptr;
@@ -43,13 +54,32 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
-std::int32_t DbgBreakpoint::current_max_collection_size_ =
-    DbgBreakpoint::kMaximumCollectionSize;
+namespace {
+
+// Tells in the status of expression that its value was evaluated age ago
+// by an earlier hit and reused.
+void PopulateReusedStatus(std::chrono::milliseconds age,
+                          Variable *expression) {
+  Status *status = expression->mutable_status();
+  status->set_iserror(false);
+  status->set_message("Value evaluated " + std::to_string(age.count()) +
+                      " ms ago by an earlier hit.");
+}
+
+}  // namespace
 
 void DbgBreakpoint::Initialize(const DbgBreakpoint &other) {
   Initialize(other.file_path_, other.id_, other.line_, other.column_,
              other.log_point_, other.log_message_format_, other.log_level_,
              other.condition_, other.expressions_);
+  capture_limits_ = other.capture_limits_;
+  content_hash_ = other.content_hash_;
+  hit_limit_ = other.hit_limit_;
+  expire_time_ = other.expire_time_;
+  coalesce_hits_ = other.coalesce_hits_;
+  sample_every_ = other.sample_every_;
+  sample_rate_ = other.sample_rate_;
+  static_expression_ttl_ = other.static_expression_ttl_;
 }
 
 void DbgBreakpoint::Initialize(const string &file_path, const string &id,
@@ -63,16 +93,78 @@ void DbgBreakpoint::Initialize(const string &file_path, const string &id,
   std::transform(
       file_path_.begin(), file_path_.end(), file_path_.begin(),
       [](unsigned char c) -> unsigned char { return std::tolower(c); });
-  file_path_segments_ = SplitFilePath(file_path_);
+  file_path_key_ = DocumentPathIndex::CreatePathKey(file_path_);
+
+  exception_point_ = file_path_.compare(0, kExceptionPointPathPrefix.size(),
+                                        kExceptionPointPathPrefix) == 0;
+  exception_type_.clear();
+  exception_module_.clear();
+  if (exception_point_) {
+    string exception = file_path_.substr(kExceptionPointPathPrefix.size());
+    size_t module_start = exception.find('@');
+    exception_type_ = exception.substr(0, module_start);
+    if (module_start != string::npos) {
+      exception_module_ = exception.substr(module_start + 1);
+    }
+  }
 
   id_ = id;
   log_point_ = log_point;
+  metric_point_ =
+      log_point && log_message_format.compare(
+                       0, kMetricPointFormatPrefix.size(),
+                       kMetricPointFormatPrefix) == 0;
   line_ = line;
   column_ = column;
   condition_ = condition;
   expressions_ = expressions;
+  parsed_condition_.reset();
+  parsed_expressions_.clear();
+  SetConditionProgram(nullptr);
   log_message_format_ = log_message_format;
   log_level_ = log_level;
+  hit_limit_ = 0;
+  expire_time_ = std::chrono::system_clock::time_point();
+  coalesce_hits_ = false;
+  sample_every_ = 0;
+  sample_rate_ = 0;
+  static_expression_ttl_ = std::chrono::milliseconds(0);
+  static_expression_values_.clear();
+  reused_expression_ages_.clear();
+}
+
+bool DbgBreakpoint::CountHit() {
+  if (hit_limit_ <= 0) {
+    return true;
+  }
+  return hits_.fetch_add(1, std::memory_order_relaxed) < hit_limit_;
+}
+
+bool DbgBreakpoint::SampleHit() {
+  if (sample_every_ > 1 &&
+      (sampled_hits_.fetch_add(1, std::memory_order_relaxed) + 1) %
+              sample_every_ !=
+          0) {
+    return false;
+  }
+
+  if (sample_rate_ > 0 && sample_rate_ < 1) {
+    // Each thread draws from its own generator so that hits on different
+    // threads do not contend.
+    thread_local std::minstd_rand generator(std::random_device{}());
+    std::uniform_real_distribution<double> distribution(0, 1);
+    return distribution(generator) < sample_rate_;
+  }
+  return true;
+}
+
+bool DbgBreakpoint::IsFinished(
+    std::chrono::system_clock::time_point now) const {
+  if (hit_limit_ > 0 && hits_.load(std::memory_order_relaxed) >= hit_limit_) {
+    return true;
+  }
+  return expire_time_ != std::chrono::system_clock::time_point() &&
+         now >= expire_time_;
 }
 
 HRESULT DbgBreakpoint::GetCorDebugBreakpoint(
@@ -90,95 +182,107 @@ HRESULT DbgBreakpoint::GetCorDebugBreakpoint(
   return E_FAIL;
 }
 
+void DbgBreakpoint::SetContentHash(const string &content_hash) {
+  content_hash_ = content_hash;
+  std::transform(
+      content_hash_.begin(), content_hash_.end(), content_hash_.begin(),
+      [](unsigned char c) -> unsigned char { return std::tolower(c); });
+}
+
 bool DbgBreakpoint::TrySetBreakpoint(
     google_cloud_debugger_portable_pdb::IPortablePdbFile *pdb_file) {
-  if (!pdb_file) {
+  SequencePointLocation location;
+  if (!FindLocation(pdb_file, &location)) {
     return false;
   }
 
-  int32_t current_doc_index_index = -1;
-  int32_t best_match_doc_index = -1;
-  int32_t longest_match = -1;
-
-  // Loop through all the documents and try to find the one that
-  // best matches the breakpoint's file name.
-  for (auto &&document_index : pdb_file->GetDocumentIndexTable()) {
-    ++current_doc_index_index;
-    string document_name = document_index->GetFilePath();
-    // Normalize path separators. The PDB may use either Unix or Windows-style
-    // paths, but the Cloud Debugger only uses Unix.
-    std::replace(document_name.begin(), document_name.end(), '\\', '/');
-    std::transform(
-        document_name.begin(), document_name.end(), document_name.begin(),
-        [](unsigned char c) -> unsigned char { return std::tolower(c); });
-
-    std::vector<std::string> document_name_segments = SplitFilePath(document_name);
-
-    // Loop and see how many segments matches.
-    int segments_matches = 0;
-    int document_segment_idx = 0;
-    for (auto &&segment : file_path_segments_) {
-      if (document_segment_idx == document_name_segments.size()) {
-        break;
-      }
+  SetLocation(location);
+  return true;
+}
 
-      if (segment.compare(document_name_segments[document_segment_idx]) == 0) {
-        segments_matches += 1;
-      }
+bool DbgBreakpoint::FindLocation(
+    google_cloud_debugger_portable_pdb::IPortablePdbFile *pdb_file,
+    SequencePointLocation *location) const {
+  if (!pdb_file || !location) {
+    return false;
+  }
 
-      document_segment_idx += 1;
-    }
+  // The document index that best matches the breakpoint's file name
+  // and content hash is looked up in the path index built when the PDB
+  // was parsed.
+  int32_t best_match_doc_index =
+      pdb_file->GetDocumentPathIndex().FindDocument(file_path_key_,
+                                                    content_hash_);
 
-    if (segments_matches > 0 && segments_matches > longest_match) {
-      best_match_doc_index = current_doc_index_index;
-      longest_match = segments_matches;
-    }
+  if (best_match_doc_index == -1) {
+    return false;
   }
 
-  if (best_match_doc_index == -1) {
+  // The methods of a document are only parsed once a breakpoint resolves
+  // to it.
+  ScopedMethodsPin methods_pin(pdb_file);
+  if (!pdb_file->ParseDocumentMethods(best_match_doc_index)) {
     return false;
   }
 
   auto &&best_document_index =
       pdb_file->GetDocumentIndexTable()[best_match_doc_index];
-  // Try to find the best matched method.
-  // This is because the breakpoint can be inside method A but if
-  // method A is defined inside method B then we should use method A
+  // The sequence point index picks the innermost method that spans the
+  // breakpoint. This is because the breakpoint can be inside method A but
+  // if method A is defined inside method B then we should use method A
   // to get the local variables instead of method B. An example is a
   // delegate function that is defined inside a normal function.
-  bool found_breakpoint = false;
-  uint32_t best_matched_method_first_line = 0;
-  for (auto &&method : best_document_index->GetMethods()) {
-    if (method.first_line > line_ || method.last_line < line_) {
-      continue;
-    }
+  return best_document_index->GetSequencePointIndex().FindSequencePoint(
+      line_, location);
+}
 
-    // If this method's first line is greater than the previous one,
-    // this means that this method is inside it.
-    if (method.first_line > best_matched_method_first_line) {
-      // If this is false, it means no sequence points in the method
-      // corresponds to this breakpoint.
-      if (TrySetBreakpointInMethod(method)) {
-        best_matched_method_first_line = method.first_line;
-        found_breakpoint = true;
-      }
-    }
+void DbgBreakpoint::SetLocation(const SequencePointLocation &location) {
+  il_offset_ = location.il_offset;
+  line_ = location.start_line;
+  method_def_ = location.method_def;
+}
+
+void DbgBreakpoint::PinMethods(std::shared_ptr<IPortablePdbFile> pdb_file) {
+  if (!pdb_file) {
+    return;
   }
 
-  return found_breakpoint;
+  // The deleter keeps the PDB alive and unpins it once the last copy of
+  // pinned_pdb_ is gone.
+  pdb_file->PinMethods();
+  IPortablePdbFile *pdb = pdb_file.get();
+  pinned_pdb_ = std::shared_ptr<IPortablePdbFile>(
+      pdb, [pdb_file](IPortablePdbFile *pinned) { pinned->UnpinMethods(); });
 }
 
 HRESULT DbgBreakpoint::EvaluateExpressions(IDbgStackFrame *stack_frame,
                                            IEvalCoordinator *eval_coordinator,
                                            IDbgObjectFactory *obj_factory) {
-  for (auto &expression : expressions_) {
-    CompiledExpression compiled_expression = CompileExpression(expression);
-    if (compiled_expression.evaluator == nullptr) {
+  parsed_expressions_.resize(expressions_.size());
+  static_expression_values_.resize(expressions_.size());
+  reused_expression_ages_.clear();
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < expressions_.size(); ++i) {
+    const std::string &expression = expressions_[i];
+    StaticExpressionValue &static_value = static_expression_values_[i];
+    if (static_value.value &&
+        now - static_value.time < static_expression_ttl_) {
+      expressions_map_[expression] = static_value.value;
+      reused_expression_ages_[expression] =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              now - static_value.time);
+      continue;
+    }
+    static_value.value.reset();
+
+    std::unique_ptr<ExpressionEvaluator> evaluator =
+        CreateEvaluator(expression, &parsed_expressions_[i]);
+    if (evaluator == nullptr) {
       WriteError("Failed to compile expression: " + expression);
       return E_FAIL;
     }
 
-    // When we call compiled_expression.evaluator->Evaluate below,
+    // When we call evaluator->Evaluate below,
     // this may affect variables in the frame.
     // Because of that, we gets a fresh active frame for each iteration.
     CComPtr<ICorDebugILFrame> active_frame;
@@ -188,27 +292,60 @@ HRESULT DbgBreakpoint::EvaluateExpressions(IDbgStackFrame *stack_frame,
       return hr;
     }
 
-    hr = compiled_expression.evaluator->Compile(stack_frame, active_frame,
-                                                GetErrorStream());
+    hr = evaluator->Compile(stack_frame, active_frame, GetErrorStream());
     if (FAILED(hr)) {
       WriteError("Failed to evaluate expression: " + expression + ".");
       return hr;
     }
 
     std::shared_ptr<DbgObject> expression_obj;
-    hr = compiled_expression.evaluator->Evaluate(
-        &expression_obj, eval_coordinator, obj_factory, GetErrorStream());
+    hr = evaluator->Evaluate(&expression_obj, eval_coordinator, obj_factory,
+                             GetErrorStream());
     if (FAILED(hr)) {
       WriteError("Failed to evaluate expression: " + expression + ".");
       return hr;
     }
 
     expressions_map_[expression] = expression_obj;
+
+    // Only values read in full from the debuggee can outlive the hit.
+    if (static_expression_ttl_.count() > 0 && expression_obj &&
+        evaluator->IsStaticOnly() && expression_obj->CaptureValue()) {
+      static_value.value = std::move(expression_obj);
+      static_value.time = now;
+    }
   }
 
   return S_OK;
 }
 
+HRESULT DbgBreakpoint::PrefilterCondition(ICorDebugILFrame *il_frame,
+                                          bool *condition) const {
+  std::shared_ptr<const ConditionProgram> filter =
+      std::atomic_load(&condition_filter_);
+  if (!filter || !il_frame || !condition) {
+    return S_FALSE;
+  }
+
+  // The failures are reproduced when the hit is processed.
+  if (FAILED(filter->RunOnFrame(il_frame, condition))) {
+    return S_FALSE;
+  }
+
+  return S_OK;
+}
+
+void DbgBreakpoint::SetConditionProgram(
+    std::shared_ptr<ConditionProgram> program) {
+  std::shared_ptr<const ConditionProgram> filter;
+  if (program && program->CanRunOnFrame()) {
+    filter = program;
+  }
+
+  condition_program_ = std::move(program);
+  std::atomic_store(&condition_filter_, std::move(filter));
+}
+
 HRESULT DbgBreakpoint::EvaluateCondition(IDbgStackFrame *stack_frame,
                                          IEvalCoordinator *eval_coordinator,
                                          IDbgObjectFactory *obj_factory) {
@@ -217,8 +354,20 @@ HRESULT DbgBreakpoint::EvaluateCondition(IDbgStackFrame *stack_frame,
     return S_OK;
   }
 
-  CompiledExpression compiled_expression = CompileExpression(condition_);
-  if (compiled_expression.evaluator == nullptr) {
+  if (condition_program_) {
+    HRESULT hr = condition_program_->Run(stack_frame, &evaluated_condition_);
+    if (SUCCEEDED(hr)) {
+      return hr;
+    }
+
+    // The evaluators reproduce the error, or handle variables whose types
+    // changed since the program was built.
+    SetConditionProgram(nullptr);
+  }
+
+  std::unique_ptr<ExpressionEvaluator> evaluator =
+      CreateEvaluator(condition_, &parsed_condition_);
+  if (evaluator == nullptr) {
     // TODO(quoct): Get the error from CompileExpression.
     return E_FAIL;
   }
@@ -229,22 +378,27 @@ HRESULT DbgBreakpoint::EvaluateCondition(IDbgStackFrame *stack_frame,
     return hr;
   }
 
-  hr = compiled_expression.evaluator->Compile(stack_frame, active_frame,
-                                              GetErrorStream());
+  hr = evaluator->Compile(stack_frame, active_frame, GetErrorStream());
   if (FAILED(hr)) {
     return hr;
   }
 
-  const TypeSignature &type_sig =
-      compiled_expression.evaluator->GetStaticType();
+  const TypeSignature &type_sig = evaluator->GetStaticType();
   if (type_sig.cor_type != CorElementType::ELEMENT_TYPE_BOOLEAN) {
     WriteError("Condition of the breakpoint must be of type boolean.");
     return E_FAIL;
   }
 
+  std::shared_ptr<ConditionProgram> program(new (std::nothrow)
+                                                ConditionProgram());
+  if (program && evaluator->Lower(program.get(), type_sig.cor_type,
+                                  program->AllocateRegister())) {
+    SetConditionProgram(std::move(program));
+  }
+
   std::shared_ptr<DbgObject> condition_result;
-  hr = compiled_expression.evaluator->Evaluate(
-      &condition_result, eval_coordinator, obj_factory, GetErrorStream());
+  hr = evaluator->Evaluate(&condition_result, eval_coordinator, obj_factory,
+                           GetErrorStream());
   if (FAILED(hr)) {
     return hr;
   }
@@ -253,6 +407,23 @@ HRESULT DbgBreakpoint::EvaluateCondition(IDbgStackFrame *stack_frame,
       condition_result.get(), &evaluated_condition_);
 }
 
+std::unique_ptr<ExpressionEvaluator> DbgBreakpoint::CreateEvaluator(
+    const std::string &expression, std::shared_ptr<CSharpExpression> *parsed) {
+  if (!*parsed) {
+    *parsed = ParseExpression(expression);
+    if (!*parsed) {
+      return nullptr;
+    }
+  }
+
+  CompiledExpression compiled_expression = (*parsed)->CreateEvaluator();
+  if (compiled_expression.evaluator == nullptr) {
+    std::cerr << "Expression not supported by the evaluator: " << expression;
+  }
+
+  return std::move(compiled_expression.evaluator);
+}
+
 HRESULT DbgBreakpoint::PopulateBreakpoint(Breakpoint *breakpoint,
                                           IStackFrameCollection *stack_frames,
                                           IEvalCoordinator *eval_coordinator) {
@@ -273,17 +444,151 @@ HRESULT DbgBreakpoint::PopulateBreakpoint(Breakpoint *breakpoint,
 
   eval_coordinator->WaitForReadySignal();
 
-  if (!expressions_map_.empty()) {
-    HRESULT hr = PopulateExpression(breakpoint, eval_coordinator);
-    if (FAILED(hr)) {
-      return hr;
-    }
+  // The deadline covers the expressions and the stack frames together.
+  CaptureLimits limits = capture_limits_;
+  limits.StartDeadline();
+
+  // The expressions are queued ahead of the variables of the first frame
+  // captured with variables, which is the top frame, and captured in the
+  // same BFS. So the expressions and the top-frame locals are expanded
+  // before any of their members or any outer frame when the size or the
+  // deadline runs out.
+  CaptureLimits expression_limits = limits;
+  expression_limits.max_collection_items = kMaximumCollectionExpressionSize;
+  VariableQueue &bfs_queue = *VariableQueue::GetThreadQueue();
+  QueueExpressions(breakpoint, &expression_limits, &bfs_queue);
+
+  hr = stack_frames->PopulateStackFrames(breakpoint, limits,
+                                         eval_coordinator);
+  if (FAILED(hr)) {
+    bfs_queue.clear();
+    return hr;
+  }
+
+  // No frame was captured with variables, so the expressions are captured
+  // on their own.
+  if (!bfs_queue.empty()) {
+    SnapshotSizeTracker size_tracker(breakpoint->ByteSizeLong(),
+                                     limits.max_bytes);
+    return VariableWrapper::PerformBFS(&bfs_queue, expression_limits,
+                                       &size_tracker, eval_coordinator);
   }
 
-  return stack_frames->PopulateStackFrames(breakpoint, eval_coordinator);
+  return S_OK;
+}
+
+HRESULT DbgBreakpoint::PopulateLogPoint(Breakpoint *breakpoint,
+                                        IEvalCoordinator *eval_coordinator) {
+  HRESULT hr = PopulateBreakpoint(breakpoint);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (!eval_coordinator) {
+    std::cerr << "Eval coordinator is null.";
+    return E_INVALIDARG;
+  }
+
+  eval_coordinator->WaitForReadySignal();
+
+  if (expressions_map_.empty()) {
+    return S_OK;
+  }
+
+  CaptureLimits limits = capture_limits_;
+  limits.StartDeadline();
+  return PopulateExpression(breakpoint, limits, eval_coordinator);
 }
 
 HRESULT DbgBreakpoint::PopulateBreakpoint(Breakpoint *breakpoint) {
+  HRESULT hr = PopulateBreakpointFields(breakpoint);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::string error_string = GetErrorString();
+  if (!error_string.empty()) {
+    SetErrorStatusMessage(breakpoint, GetErrorString());
+    ResetErrorStream();
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgBreakpoint::PopulateErrorStatus(Breakpoint *breakpoint,
+                                           const std::string &message) const {
+  HRESULT hr = PopulateBreakpointFields(breakpoint);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  SetErrorStatusMessage(breakpoint, message);
+  return S_OK;
+}
+
+void DbgBreakpoint::RecordHitCost(std::chrono::microseconds stop_time,
+                                  std::uint32_t func_evals) {
+  std::uint64_t stop_time_us =
+      static_cast<std::uint64_t>(std::max<std::int64_t>(stop_time.count(), 0));
+  cost_hits_.fetch_add(1, std::memory_order_relaxed);
+  cost_total_stop_time_us_.fetch_add(stop_time_us, std::memory_order_relaxed);
+  cost_func_evals_.fetch_add(func_evals, std::memory_order_relaxed);
+
+  std::uint64_t max_stop_time_us =
+      cost_max_stop_time_us_.load(std::memory_order_relaxed);
+  while (stop_time_us > max_stop_time_us &&
+         !cost_max_stop_time_us_.compare_exchange_weak(
+             max_stop_time_us, stop_time_us, std::memory_order_relaxed)) {
+  }
+}
+
+BreakpointCost DbgBreakpoint::GetCost() const {
+  BreakpointCost cost;
+  cost.hits = cost_hits_.load(std::memory_order_relaxed);
+  cost.total_stop_time_us =
+      cost_total_stop_time_us_.load(std::memory_order_relaxed);
+  cost.max_stop_time_us =
+      cost_max_stop_time_us_.load(std::memory_order_relaxed);
+  cost.func_evals = cost_func_evals_.load(std::memory_order_relaxed);
+  cost.payload_bytes = cost_payload_bytes_.load(std::memory_order_relaxed);
+  return cost;
+}
+
+void DbgBreakpoint::PopulateCostStatus(Breakpoint *breakpoint) const {
+  if (!breakpoint || breakpoint->has_status()) {
+    return;
+  }
+
+  BreakpointCost cost = GetCost();
+  unique_ptr<Status> status(new (std::nothrow) Status());
+  if (!status) {
+    return;
+  }
+  status->set_iserror(false);
+  status->set_message(
+      "Cost of " + std::to_string(cost.hits) + " hits: " +
+      std::to_string(cost.total_stop_time_us) + " us stopped in total, " +
+      std::to_string(cost.max_stop_time_us) + " us at most, " +
+      std::to_string(cost.func_evals) + " function evaluations, " +
+      std::to_string(cost.payload_bytes) +
+      " bytes written for the hits before this one.");
+  breakpoint->set_allocated_status(status.release());
+}
+
+bool DbgBreakpoint::ShouldReportSkippedHits() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (skipped_hits_reported_ &&
+      now - skipped_hits_report_time_ <
+          std::chrono::milliseconds(kSkippedHitsReportIntervalMs)) {
+    return false;
+  }
+
+  skipped_hits_reported_ = true;
+  skipped_hits_report_time_ = now;
+  return true;
+}
+
+HRESULT DbgBreakpoint::PopulateBreakpointFields(Breakpoint *breakpoint) const {
   if (!breakpoint) {
     std::cerr << "Breakpoint proto is null";
     return E_INVALIDARG;
@@ -294,12 +599,6 @@ HRESULT DbgBreakpoint::PopulateBreakpoint(Breakpoint *breakpoint) {
   breakpoint->set_log_message_format(log_message_format_);
   breakpoint->set_log_level(log_level_);
 
-  std::string error_string = GetErrorString();
-  if (!error_string.empty()) {
-    SetErrorStatusMessage(breakpoint, GetErrorString());
-    ResetErrorStream();
-  }
-
   for (auto &&expression : expressions_) {
     std::string *expression_proto = breakpoint->add_expressions();
     *expression_proto = expression;
@@ -316,71 +615,157 @@ HRESULT DbgBreakpoint::PopulateBreakpoint(Breakpoint *breakpoint) {
   return S_OK;
 }
 
-HRESULT DbgBreakpoint::PopulateExpression(Breakpoint *breakpoint,
-                                          IEvalCoordinator *eval_coordinator) {
-  std::queue<VariableWrapper> bfs_queue;
-
-  for (auto &&kvp : expressions_map_) {
-    Variable *expression_proto = breakpoint->add_evaluated_expressions();
-
-    expression_proto->set_name(kvp.first);
-    const std::shared_ptr<DbgObject> &expression_value = kvp.second;
-    if (!expression_value) {
-      continue;
-    }
+HRESULT DbgBreakpoint::AddMetricHit(std::chrono::steady_clock::time_point now,
+                                    Breakpoint *breakpoint) {
+  if (!breakpoint) {
+    return E_INVALIDARG;
+  }
 
-    bfs_queue.push(VariableWrapper(expression_proto, expression_value));
+  double value;
+  if (ReadMetricValue(&value)) {
+    metric_summary_.AddValue(value);
+  } else {
+    metric_summary_.AddHit();
+  }
+  expressions_map_.clear();
+  ResetErrorStream();
+
+  std::string summary;
+  if (!metric_summary_.Flush(
+          now, std::chrono::milliseconds(kMetricPointFlushIntervalMs),
+          &summary)) {
+    return S_FALSE;
   }
 
-  if (bfs_queue.size() != 0) {
-    current_max_collection_size_ = kMaximumCollectionExpressionSize;
-    HRESULT hr = VariableWrapper::PerformBFS(
-        &bfs_queue,
-        [breakpoint]() {
-          return breakpoint->ByteSize() > DbgBreakpoint::kMaximumBreakpointSize;
-        },
-        eval_coordinator);
-    current_max_collection_size_ = kMaximumCollectionSize;
+  HRESULT hr = PopulateBreakpointFields(breakpoint);
+  if (FAILED(hr)) {
     return hr;
   }
 
+  // The summary replaces the placeholders of the expressions, which
+  // are left out with everything after them.
+  std::string name = log_message_format_.substr(
+      0, log_message_format_.find('$'));
+  name.erase(name.find_last_not_of(' ') + 1);
+  breakpoint->set_log_message_format(name + " " + summary);
   return S_OK;
 }
 
-bool DbgBreakpoint::TrySetBreakpointInMethod(
-    const google_cloud_debugger_portable_pdb::MethodInfo &method) {
-  const auto &find_seq = std::find_if(
-      method.sequence_points.begin(), method.sequence_points.end(),
-      [&](const google_cloud_debugger_portable_pdb::SequencePoint &seq) {
-        return !seq.is_hidden && seq.start_line >= line_;
-      });
+bool DbgBreakpoint::ReadMetricValue(double *value) {
+  if (expressions_.empty()) {
+    return false;
+  }
 
-  if (find_seq == method.sequence_points.end()) {
+  const auto &expression_value = expressions_map_.find(expressions_.front());
+  if (expression_value == expressions_map_.end() ||
+      !expression_value->second || !expression_value->second->CaptureValue()) {
     return false;
   }
 
-  il_offset_ = find_seq->il_offset;
-  line_ = find_seq->start_line;
-  method_def_ = method.method_def;
-  return true;
+  Variable variable;
+  if (expression_value->second->PopulateValue(&variable) != S_OK ||
+      variable.value().empty()) {
+    return false;
+  }
+
+  char *end;
+  *value = std::strtod(variable.value().c_str(), &end);
+  return *end == '\0' && std::isfinite(*value);
 }
 
-std::vector<std::string> DbgBreakpoint::SplitFilePath(const std::string &path) {
-  std::vector<std::string> result;
+HRESULT DbgBreakpoint::CaptureExpressionValues(ExpressionValues *values,
+                                               ExpressionAges *ages) {
+  if (!values) {
+    return E_INVALIDARG;
+  }
+
+  for (auto &&kvp : expressions_map_) {
+    if (kvp.second && !kvp.second->CaptureValue()) {
+      return S_FALSE;
+    }
+  }
 
-  static const std::string delimiter = "/";
-  size_t delimiter_position = path.find(delimiter);
-  size_t start_offset = 0;
+  *values = std::move(expressions_map_);
+  expressions_map_.clear();
+  if (ages) {
+    *ages = std::move(reused_expression_ages_);
+  }
+  reused_expression_ages_.clear();
+  return S_OK;
+}
 
-  while (delimiter_position != std::string::npos) {
-    result.push_back(path.substr(start_offset, delimiter_position - start_offset));
-    start_offset = delimiter_position + delimiter.length();
-    delimiter_position = path.find(delimiter, start_offset);
+HRESULT DbgBreakpoint::PopulateCapturedExpressions(
+    Breakpoint *breakpoint, const ExpressionValues &values,
+    const CaptureLimits &limits, IEvalCoordinator *eval_coordinator,
+    const ExpressionAges *ages) {
+  if (!breakpoint) {
+    std::cerr << "Breakpoint proto is null";
+    return E_INVALIDARG;
   }
 
-  result.push_back(path.substr(start_offset, delimiter_position));
-  std::reverse(result.begin(), result.end());
-  return result;
+  VariableQueue &bfs_queue = *VariableQueue::GetThreadQueue();
+  for (auto &&kvp : values) {
+    Variable *expression_proto = breakpoint->add_evaluated_expressions();
+
+    expression_proto->set_name(kvp.first);
+    if (ages) {
+      auto age = ages->find(kvp.first);
+      if (age != ages->end()) {
+        PopulateReusedStatus(age->second, expression_proto);
+      }
+    }
+    if (kvp.second) {
+      bfs_queue.push(VariableWrapper(expression_proto, kvp.second));
+    }
+  }
+
+  // The captured values have no members so the collection size
+  // does not matter here.
+  SnapshotSizeTracker size_tracker(breakpoint->ByteSizeLong(),
+                                   limits.max_bytes);
+  return VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                     eval_coordinator);
+}
+
+void DbgBreakpoint::QueueExpressions(Breakpoint *breakpoint,
+                                     const CaptureLimits *limits,
+                                     VariableQueue *bfs_queue) {
+  for (auto &&kvp : expressions_map_) {
+    Variable *expression_proto = breakpoint->add_evaluated_expressions();
+
+    expression_proto->set_name(kvp.first);
+    auto age = reused_expression_ages_.find(kvp.first);
+    if (age != reused_expression_ages_.end()) {
+      PopulateReusedStatus(age->second, expression_proto);
+    }
+    const std::shared_ptr<DbgObject> &expression_value = kvp.second;
+    if (!expression_value) {
+      continue;
+    }
+
+    VariableWrapper expression(expression_proto, expression_value);
+    expression.SetLimits(limits);
+    bfs_queue->push(std::move(expression));
+  }
+}
+
+HRESULT DbgBreakpoint::PopulateExpression(Breakpoint *breakpoint,
+                                          const CaptureLimits &limits,
+                                          IEvalCoordinator *eval_coordinator) {
+  VariableQueue &bfs_queue = *VariableQueue::GetThreadQueue();
+  QueueExpressions(breakpoint, nullptr, &bfs_queue);
+
+  if (bfs_queue.size() != 0) {
+    // Collections in expressions are expanded in full.
+    CaptureLimits expression_limits = limits;
+    expression_limits.max_collection_items = kMaximumCollectionExpressionSize;
+    SnapshotSizeTracker size_tracker(breakpoint->ByteSizeLong(),
+                                     expression_limits.max_bytes);
+    return VariableWrapper::PerformBFS(&bfs_queue, expression_limits,
+                                       &size_tracker, eval_coordinator);
+  }
+
+  return S_OK;
 }
 
 }  // namespace google_cloud_debugger
@@ -15,20 +15,29 @@
 #ifndef DBG_BREAKPOINT_H_
 #define DBG_BREAKPOINT_H_
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "breakpoint.pb.h"
+#include "capture_limits.h"
 #include "ccomptr.h"
 #include "cor.h"
+#include "constants.h"
 #include "cordebug.h"
+#include "document_path_index.h"
+#include "metric_summary.h"
+#include "rate_limiter.h"
 #include "string_stream_wrapper.h"
 
 namespace google_cloud_debugger_portable_pdb {
 class IPortablePdbFile;
 struct MethodInfo;
+struct SequencePointLocation;
 };  // namespace google_cloud_debugger_portable_pdb
 
 namespace google_cloud_debugger {
@@ -38,6 +47,27 @@ class IStackFrameCollection;
 class IDbgStackFrame;
 class IDbgObjectFactory;
 class DbgObject;
+class CSharpExpression;
+class ConditionProgram;
+class ExpressionEvaluator;
+class VariableQueue;
+
+// What the hits of a breakpoint cost the debuggee so far.
+struct BreakpointCost {
+  // Number of hits processed.
+  std::uint64_t hits = 0;
+
+  // Total and longest time a hit kept the debuggee thread stopped,
+  // in microseconds.
+  std::uint64_t total_stop_time_us = 0;
+  std::uint64_t max_stop_time_us = 0;
+
+  // Number of function evaluations made for the hits.
+  std::uint64_t func_evals = 0;
+
+  // Size of the messages written to the agent for the hits.
+  std::uint64_t payload_bytes = 0;
+};
 
 // This class represents a breakpoint in the Debugger.
 // To use the class, call the Initialize method to populate the
@@ -65,6 +95,27 @@ class DbgBreakpoint : public StringStreamWrapper {
   bool TrySetBreakpoint(
       google_cloud_debugger_portable_pdb::IPortablePdbFile *pdb_file);
 
+  // Looks for the location of this breakpoint in pdb_file like
+  // TrySetBreakpoint, but only returns it in location without setting
+  // it, so that several threads can search different PDB files for the
+  // same breakpoint.
+  bool FindLocation(
+      google_cloud_debugger_portable_pdb::IPortablePdbFile *pdb_file,
+      google_cloud_debugger_portable_pdb::SequencePointLocation *location)
+      const;
+
+  // Sets the method, IL offset and line of this breakpoint to location.
+  void SetLocation(
+      const google_cloud_debugger_portable_pdb::SequencePointLocation
+          &location);
+
+  // Keeps the parsed methods of pdb_file, the PDB of the module this
+  // breakpoint is set in, from being evicted (see PdbMemoryLimiter) as
+  // long as the breakpoint exists.
+  void PinMethods(
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+          pdb_file);
+
   // Returns the IL Offset that corresponds to this breakpoint location.
   uint32_t GetILOffset() { return il_offset_; }
 
@@ -85,9 +136,25 @@ class DbgBreakpoint : public StringStreamWrapper {
     method_token_ = method_token;
   }
 
+  // Returns the base address of the module this breakpoint is in.
+  CORDB_ADDRESS GetModuleBaseAddress() const { return module_base_address_; }
+
+  // Sets the base address of the module this breakpoint is in.
+  void SetModuleBaseAddress(CORDB_ADDRESS module_base_address) {
+    module_base_address_ = module_base_address;
+  }
+
   // Returns the path of the file this breakpoint is in.
   const std::string &GetFilePath() const { return file_path_; }
 
+  // Sets the hash of the content of the file this breakpoint is in, in
+  // hex, which finds the document of the breakpoint among documents with
+  // the same path suffix. Empty if the breakpoint does not carry one.
+  void SetContentHash(const std::string &content_hash);
+
+  // Returns the hash of the content of the file, in lower case hex.
+  const std::string &GetContentHash() const { return content_hash_; }
+
   // Returns the name of the method this breakpoint is in.
   const std::vector<WCHAR> &GetMethodName() const { return method_name_; }
 
@@ -96,9 +163,24 @@ class DbgBreakpoint : public StringStreamWrapper {
     method_name_ = method_name;
   }
 
+  // Returns true if this is an exception point (see
+  // kExceptionPointPathPrefix).
+  bool IsExceptionPoint() const { return exception_point_; }
+
+  // Returns the lowercase type name of the exceptions of an exception
+  // point.
+  const std::string &GetExceptionType() const { return exception_type_; }
+
+  // Returns the lowercase name of the module that an exception point is
+  // restricted to, or an empty string if it is not.
+  const std::string &GetExceptionModule() const { return exception_module_; }
+
   // Gets the line number of this breakpoint.
   uint32_t GetLine() const { return line_; }
 
+  // Sets the line number of this breakpoint.
+  void SetLine(uint32_t line) { line_ = line; }
+
   // Gets the column number of this breakpoint.
   uint32_t GetColumn() const { return column_; }
 
@@ -128,8 +210,12 @@ class DbgBreakpoint : public StringStreamWrapper {
   // Returns whether this breakpoint is a logpoint.
   bool IsLogPoint() const { return log_point_; }
 
+  // Returns true if this log point is a metric point (see
+  // kMetricPointFormatPrefix).
+  bool IsMetricPoint() const { return metric_point_; }
+
   // The log message format of the breakpoint.
-  std::string LogMessageFormat() const { return log_message_format_; }
+  const std::string &LogMessageFormat() const { return log_message_format_; }
 
   // The log level of the breakpoint.
   google::cloud::diagnostics::debug::Breakpoint_LogLevel LogLevel() const { return log_level_; }
@@ -138,7 +224,11 @@ class DbgBreakpoint : public StringStreamWrapper {
   const std::string &GetCondition() const { return condition_; }
 
   // Sets the condition of the breakpoint.
-  void SetCondition(const std::string &condition) { condition_ = condition; }
+  void SetCondition(const std::string &condition) {
+    condition_ = condition;
+    parsed_condition_.reset();
+    SetConditionProgram(nullptr);
+  }
 
   // Gets the result of the evaluated condition.
   // This should only be called after EvaluateCondition is called.
@@ -152,12 +242,108 @@ class DbgBreakpoint : public StringStreamWrapper {
   // Sets the expressions of the breakpoint.
   void SetExpressions(const std::vector<std::string> &expressions) {
     expressions_ = expressions;
+    parsed_expressions_.clear();
+    static_expression_values_.clear();
+  }
+
+  // Sets how long the values of the expressions that only read static
+  // members and constants are reused by later hits instead of being
+  // evaluated again. Zero, the default, evaluates them on every hit.
+  void SetStaticExpressionTtl(std::chrono::milliseconds ttl) {
+    static_expression_ttl_ = ttl;
+  }
+
+  // Sets the number of hits after which the breakpoint is finished, or 0
+  // if it has no hit limit.
+  void SetHitLimit(std::int32_t hit_limit) { hit_limit_ = hit_limit; }
+
+  // Returns the number of hits after which the breakpoint is finished.
+  std::int32_t GetHitLimit() const { return hit_limit_; }
+
+  // Sets the time the breakpoint expires at. The epoch of the clock, the
+  // default, means the breakpoint does not expire.
+  void SetExpireTime(std::chrono::system_clock::time_point expire_time) {
+    expire_time_ = expire_time;
+  }
+
+  // Returns true if the breakpoint has a hit limit or expires.
+  bool HasHitLimitOrExpiry() const {
+    return hit_limit_ > 0 ||
+           expire_time_ != std::chrono::system_clock::time_point();
+  }
+
+  // Counts a hit whose condition is met against the hit limit. Returns
+  // false if other hits already reached the limit, in which case the hit
+  // is not reported. Hits of the breakpoint on different threads can
+  // call this at the same time.
+  bool CountHit();
+
+  // Returns true if the breakpoint reached its hit limit or expired at
+  // now, so that its hits are not processed anymore.
+  bool IsFinished(std::chrono::system_clock::time_point now) const;
+
+  // Sets the sampling of the hits of the breakpoint: only every
+  // sample_every-th hit is processed if it is more than 1, and only the
+  // fraction sample_rate of the hits, chosen at random, if it is between
+  // 0 and 1 exclusive. Both apply if both are set.
+  void SetSampling(std::int32_t sample_every, double sample_rate) {
+    sample_every_ = sample_every;
+    sample_rate_ = sample_rate;
+  }
+
+  // Returns true if the hits of the breakpoint are sampled.
+  bool IsSampled() const {
+    return sample_every_ > 1 || (sample_rate_ > 0 && sample_rate_ < 1);
+  }
+
+  // Returns true if a hit is sampled and should be processed. Every hit
+  // counts, whether or not the condition is met, as this is checked
+  // before the condition is evaluated. Hits of the breakpoint on
+  // different threads can call this at the same time.
+  bool SampleHit();
+
+  // Sets whether a hit of the log point is skipped while another hit of
+  // it is processed.
+  void SetCoalesceHits(bool coalesce_hits) { coalesce_hits_ = coalesce_hits; }
+
+  // Returns true if only one hit of the breakpoint is processed at a
+  // time: snapshots with a hit limit, which only need the snapshot of
+  // the hit that is already being captured, and log points that coalesce
+  // their hits.
+  bool HasSingleCapture() const {
+    return log_point_ ? coalesce_hits_ : hit_limit_ > 0;
+  }
+
+  // Claims the capture slot of a breakpoint that HasSingleCapture for a
+  // hit. Returns false if a hit on another thread holds it, in which case
+  // the hit is continued without evaluating the breakpoint. Hits that
+  // claimed the slot release it with EndCapture once they are processed,
+  // whether or not the condition was met.
+  bool BeginCapture() {
+    bool capturing = false;
+    return capturing_.compare_exchange_strong(capturing, true,
+                                              std::memory_order_acquire);
+  }
+
+  // Releases the capture slot claimed by BeginCapture.
+  void EndCapture() { capturing_.store(false, std::memory_order_release); }
+
+  // Gets the limits the snapshots of the breakpoint are captured with.
+  const CaptureLimits &GetCaptureLimits() const { return capture_limits_; }
+
+  // Sets the limits the snapshots of the breakpoint are captured with.
+  void SetCaptureLimits(const CaptureLimits &limits) {
+    capture_limits_ = limits;
   }
 
   // Returns a string representation of the breakpoint location
-  // by concatenating file path and line number.
+  // by concatenating file path, line number and content hash, if any.
   std::string GetBreakpointLocation() const {
-    return file_path_ + "##" + std::to_string(line_);
+    std::string location = file_path_ + "##" + std::to_string(line_);
+    if (!content_hash_.empty()) {
+      location += "##" + content_hash_;
+    }
+    return location;
   }
 
   // Evaluates condition condition_ using the provided stack frame
@@ -166,6 +352,17 @@ class DbgBreakpoint : public StringStreamWrapper {
                             IEvalCoordinator *eval_coordinator,
                             IDbgObjectFactory *obj_factory);
 
+  // Evaluates the condition of a hit before the hit is processed, so
+  // that a hit whose condition is false is rejected without walking the
+  // stack. The compiled condition is run on the values of the variables
+  // read straight from il_frame, the active frame of the hit, if it only
+  // reads primitive variables from their slots. Returns S_FALSE if the
+  // condition cannot be evaluated this way, in which case the hit is
+  // processed as usual. This can be called while the breakpoint is
+  // processed for another thread.
+  HRESULT PrefilterCondition(ICorDebugILFrame *il_frame,
+                             bool *condition) const;
+
   // Evaluates expressions and stores the result in expression_map_.
   HRESULT EvaluateExpressions(IDbgStackFrame *stack_frame,
                               IEvalCoordinator *eval_coordinator,
@@ -188,32 +385,125 @@ class DbgBreakpoint : public StringStreamWrapper {
   HRESULT PopulateBreakpoint(
       google::cloud::diagnostics::debug::Breakpoint *breakpoint);
 
-  // Breakpoint proto's size should not contain more bytes of
-  // information than this number. (65536 bytes = 64kb).
-  static const std::uint32_t kMaximumBreakpointSize = 65536;
+  // Populates a Breakpoint proto of a log point with this breakpoint
+  // information and the evaluated expressions of the log message.
+  // Log points only report their expressions, so unlike the
+  // PopulateBreakpoint above this needs no stack frames.
+  HRESULT PopulateLogPoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint,
+      IEvalCoordinator *eval_coordinator);
 
-  // Gets the maximum collection size for breakpoints.
-  static std::uint32_t GetMaximumCollectionSize() {
-    return current_max_collection_size_;
+  // Populates a Breakpoint proto with this breakpoint information and an
+  // error status with message. Unlike PopulateBreakpoint, this leaves
+  // the error stream alone, so it can be called while the breakpoint is
+  // processed for a hit on another thread.
+  HRESULT PopulateErrorStatus(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint,
+      const std::string &message) const;
+
+  // Takes a hit from the hit rate budget of this breakpoint. Returns
+  // false if the breakpoint is hit more often than
+  // kBreakpointHitsPerSecond and the hit should be skipped.
+  bool RequestHit() { return hit_limiter_.RequestTokens(1); }
+
+  // Returns true if the user should be told that hits of this breakpoint
+  // are skipped, which is at most once every kSkippedHitsReportIntervalMs.
+  // Has to be called from the debugger callback thread.
+  bool ShouldReportSkippedHits();
+
+  // Adds a hit that kept the debuggee thread stopped for stop_time and
+  // made func_evals function evaluations to the cost of this breakpoint.
+  void RecordHitCost(std::chrono::microseconds stop_time,
+                     std::uint32_t func_evals);
+
+  // Adds the size of a message written to the agent for a hit to the
+  // cost of this breakpoint.
+  void RecordPayloadBytes(std::uint64_t bytes) {
+    cost_payload_bytes_.fetch_add(bytes, std::memory_order_relaxed);
   }
 
+  // Returns what the hits of this breakpoint cost so far.
+  BreakpointCost GetCost() const;
+
+  // Sets the status of breakpoint to a message that is not an error and
+  // reports the cost of this breakpoint, unless breakpoint already has
+  // a status.
+  void PopulateCostStatus(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) const;
+
+  // Adds the value of the first expression of a metric point, evaluated
+  // for a hit whose condition is met, to the summary of its hits. Once
+  // kMetricPointFlushIntervalMs passed since the summary started,
+  // populates breakpoint as a hit of the log point whose message is the
+  // summary, starts a new summary and returns S_OK. Returns S_FALSE if
+  // the summary is not written yet. Hits on different threads can call
+  // this at the same time.
+  HRESULT AddMetricHit(
+      std::chrono::steady_clock::time_point now,
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+  // Map where key is an expression and value is its evaluated value.
+  typedef std::unordered_map<std::string, std::shared_ptr<DbgObject>>
+      ExpressionValues;
+
+  // Map where key is an expression whose value was reused from an earlier
+  // hit and value is how long ago it was evaluated.
+  typedef std::unordered_map<std::string, std::chrono::milliseconds>
+      ExpressionAges;
+
+  // Moves the evaluated expressions into values, and the ages of the
+  // reused ones into ages if it is not null, after reading them
+  // from the debuggee, so that they can be populated with
+  // PopulateCapturedExpressions once the debuggee continues.
+  // Has to be called while the debuggee is stopped. Returns S_FALSE
+  // and leaves the evaluated expressions alone if any of them has
+  // members or cannot be read.
+  HRESULT CaptureExpressionValues(ExpressionValues *values,
+                                  ExpressionAges *ages = nullptr);
+
+  // Populates breakpoint with expression values captured by
+  // CaptureExpressionValues within limits, telling the age of the reused
+  // ones in ages in their status. This does not need the debuggee.
+  static HRESULT PopulateCapturedExpressions(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint,
+      const ExpressionValues &values, const CaptureLimits &limits,
+      IEvalCoordinator *eval_coordinator,
+      const ExpressionAges *ages = nullptr);
+
  private:
+  // Creates an evaluator for expression. The expression is parsed into
+  // parsed the first time, and later calls create the evaluator from
+  // the parsed tree. Returns null if the expression can't be compiled.
+  std::unique_ptr<ExpressionEvaluator> CreateEvaluator(
+      const std::string &expression,
+      std::shared_ptr<CSharpExpression> *parsed);
+
+  // Sets condition_program_ to program, and condition_filter_ to it if
+  // it can be run on the values of a frame.
+  void SetConditionProgram(std::shared_ptr<ConditionProgram> program);
+
+  // Reads the value of the first expression of a metric point as a
+  // number into value. Returns false if it has no numeric value.
+  bool ReadMetricValue(double *value);
+
+  // Populates breakpoint with the fields of this breakpoint that do not
+  // change when it is hit.
+  HRESULT PopulateBreakpointFields(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) const;
+
+  // Adds the evaluated expressions stored in the dictionary
+  // expression_map_ to breakpoint and pushes the ones with values into
+  // bfs_queue, to be captured within limits if it is not null.
+  void QueueExpressions(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint,
+      const CaptureLimits *limits, VariableQueue *bfs_queue);
+
   // Populates breakpoint with the evaluated expressions stored
-  // in the dictionary expression_map_.
+  // in the dictionary expression_map_, within limits.
   // This will sets the maximum collection size of DbgBreakpoint to 1000.
   HRESULT PopulateExpression(
       google::cloud::diagnostics::debug::Breakpoint *breakpoint,
-      IEvalCoordinator *eval_coordinator);
-
-  // Given a method, try to see whether we can set this breakpoint in
-  // the method.
-  bool TrySetBreakpointInMethod(
-      const google_cloud_debugger_portable_pdb::MethodInfo &method);
-
-  // Split up file path into segments (using '/' as delimiter).
-  // The returned vector will be reversed with the file name
-  // as the first item.
-  std::vector<std::string> SplitFilePath(const std::string &path);
+      const CaptureLimits &limits, IEvalCoordinator *eval_coordinator);
 
   // The line number of the breakpoint.
   uint32_t line_;
@@ -224,9 +514,19 @@ class DbgBreakpoint : public StringStreamWrapper {
   // The file path of the breakpoint.
   std::string file_path_;
 
-  // Segments of the file path (when file_path_ is split by '/').
-  // First item is the file name and last item is the root.
-  std::vector<std::string> file_path_segments_;
+  // True if this is an exception point, and the exception type and module
+  // its file path names.
+  bool exception_point_ = false;
+  std::string exception_type_;
+  std::string exception_module_;
+
+  // Normalized segments of the file path and their hashes, matched
+  // against the documents of the PDBs. The first segment is the file
+  // name and the last one is the root.
+  google_cloud_debugger_portable_pdb::DocumentPathKey file_path_key_;
+
+  // Hash of the content of the file, in lower case hex, or empty.
+  std::string content_hash_;
 
   // The unique ID of the breakpoint.
   std::string id_;
@@ -237,17 +537,58 @@ class DbgBreakpoint : public StringStreamWrapper {
   // The method definition of the method this breakpoint is in.
   uint32_t method_def_;
 
+  // The PDB pinned by PinMethods, unpinned when the breakpoint is
+  // destroyed.
+  std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+      pinned_pdb_;
+
   // The method token of the method this breakpoint is in.
   mdMethodDef method_token_;
 
+  // The base address of the module this breakpoint is in. Together with
+  // the method token and IL offset, this uniquely identifies the location
+  // of the breakpoint in the debuggee.
+  CORDB_ADDRESS module_base_address_ = 0;
+
   // Condition of a breakpoint. If false, don't report information back.
   std::string condition_;
 
   // Expressions of a breakpoint.
   std::vector<std::string> expressions_;
 
+  // condition_ and expressions_ parsed on the first hit, so that later
+  // hits only create evaluators from them. An evaluator binds to the
+  // variables of the frame it is compiled in, so it is not kept.
+  std::shared_ptr<CSharpExpression> parsed_condition_;
+  std::vector<std::shared_ptr<CSharpExpression>> parsed_expressions_;
+
+  // condition_ lowered into a program after it is first compiled, if all
+  // of its operations are supported. Later hits run the program instead
+  // of compiling and evaluating the condition.
+  std::shared_ptr<ConditionProgram> condition_program_;
+
+  // condition_program_ if it can be run on the values of a frame, for
+  // PrefilterCondition. It is read by the debugger callback thread while
+  // the breakpoint may be processed on an evaluation thread, so it is
+  // only accessed with std::atomic_load and std::atomic_store.
+  std::shared_ptr<const ConditionProgram> condition_filter_;
+
   // Map where key is the expression and value is its evaluated value.
-  std::unordered_map<std::string, std::shared_ptr<DbgObject>> expressions_map_;
+  ExpressionValues expressions_map_;
+
+  // A value of an expression that only reads static members and
+  // constants, and when it was evaluated.
+  struct StaticExpressionValue {
+    std::shared_ptr<DbgObject> value;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  // How long the values of static-only expressions are reused (see
+  // SetStaticExpressionTtl), the values indexed like expressions_, and
+  // the ages of the values the last hit reused.
+  std::chrono::milliseconds static_expression_ttl_{0};
+  std::vector<StaticExpressionValue> static_expression_values_;
+  ExpressionAges reused_expression_ages_;
 
   // True if the condition_ of the breakpoint is empty or evaluated to true.
   bool evaluated_condition_ = true;
@@ -267,22 +608,57 @@ class DbgBreakpoint : public StringStreamWrapper {
   // True if this breakpoint is a log point.
   bool log_point_ = false;
 
+  // True if this log point is a metric point, and the summary of its hits.
+  bool metric_point_ = false;
+  MetricSummary metric_summary_;
+
   // The format of the log message of this breakpoint.
   std::string log_message_format_;
 
   // Log level of the breakpoint.
   google::cloud::diagnostics::debug::Breakpoint_LogLevel log_level_;
 
-  // The current maximum number of items in a collection that we will expand.
-  static std::int32_t current_max_collection_size_;
+  // Limits how often hits of this breakpoint are processed.
+  RateLimiter hit_limiter_{kBreakpointHitsPerSecond, kBreakpointHitBurst};
 
-  // Maximum amount of items returned in a collection when not evaluating
-  // an expression.
-  static const std::int32_t kMaximumCollectionSize = 10;
+  // True if skipped hits were reported, and when.
+  bool skipped_hits_reported_ = false;
+  std::chrono::steady_clock::time_point skipped_hits_report_time_;
+
+  // Limits the snapshots of the breakpoint are captured with.
+  CaptureLimits capture_limits_;
+
+  // The number of hits after which the breakpoint is finished, 0 if it
+  // has none, and the hits counted against it by CountHit.
+  std::int32_t hit_limit_ = 0;
+  std::atomic<std::int32_t> hits_{0};
+
+  // The sampling of the hits (see SetSampling), and the hits counted
+  // against sample_every_ by SampleHit.
+  std::int32_t sample_every_ = 0;
+  double sample_rate_ = 0;
+  std::atomic<std::uint64_t> sampled_hits_{0};
+
+  // True if the hits of the log point are coalesced, and true while a
+  // hit holds the capture slot.
+  bool coalesce_hits_ = false;
+  std::atomic<bool> capturing_{false};
+
+  // When the breakpoint expires, or the epoch if it does not.
+  std::chrono::system_clock::time_point expire_time_;
+
+  // What the hits of this breakpoint cost so far. See BreakpointCost.
+  // Hits of a breakpoint are processed one at a time, but its messages
+  // can be written while the next hit is processed.
+  std::atomic<std::uint64_t> cost_hits_{0};
+  std::atomic<std::uint64_t> cost_total_stop_time_us_{0};
+  std::atomic<std::uint64_t> cost_max_stop_time_us_{0};
+  std::atomic<std::uint64_t> cost_func_evals_{0};
+  std::atomic<std::uint64_t> cost_payload_bytes_{0};
 
   // Maximum amount of items returned in a collection when evaluating
   // an expression.
-  static const std::int32_t kMaximumCollectionExpressionSize = INT32_MAX;
+  static const std::uint32_t kMaximumCollectionExpressionSize = INT32_MAX;
 };
 
 }  // namespace google_cloud_debugger
@@ -17,14 +17,16 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 
 #include "class_names.h"
 #include "dbg_array.h"
-#include "dbg_breakpoint.h"
+#include "dbg_string.h"
 #include "i_cor_debug_helper.h"
 #include "i_dbg_object_factory.h"
 #include "i_eval_coordinator.h"
+#include "number_format.h"
 #include "variable_wrapper.h"
 
 using google::cloud::diagnostics::debug::Variable;
@@ -47,7 +49,31 @@ const string DbgBuiltinCollection::kDictionaryKeyFieldName = "key";
 const string DbgBuiltinCollection::kHashSetAndDictValueFieldName = "value";
 const string DbgBuiltinCollection::kHashSetAndDictHashCodeFieldName =
     "hashCode";
+const string DbgBuiltinCollection::kArrayFieldName = "_array";
+const string DbgBuiltinCollection::kQueueHeadFieldName = "_head";
+const string DbgBuiltinCollection::kArraySegmentOffsetFieldName = "_offset";
+const string DbgBuiltinCollection::kArraySegmentCountFieldName = "_count";
+const string DbgBuiltinCollection::kImmutableArrayItemsFieldName = "array";
+const string DbgBuiltinCollection::kConcurrentTablesFieldName = "_tables";
+const string DbgBuiltinCollection::kConcurrentBucketsFieldName = "_buckets";
+const string DbgBuiltinCollection::kConcurrentCountPerLockFieldName =
+    "_countPerLock";
+const string DbgBuiltinCollection::kConcurrentKeyFieldName = "_key";
+const string DbgBuiltinCollection::kConcurrentValueFieldName = "_value";
+const string DbgBuiltinCollection::kConcurrentNextFieldName = "_next";
 const string DbgBuiltinCollection::kCountProtoFieldName = "Count";
+const int32_t DbgBuiltinCollection::kHashCodesPerRead;
+
+bool DbgBuiltinCollection::IsBuiltinCollection(const string &class_name) {
+  return kListClassName.compare(class_name) == 0 ||
+         kHashSetClassName.compare(class_name) == 0 ||
+         kDictionaryClassName.compare(class_name) == 0 ||
+         kQueueClassName.compare(class_name) == 0 ||
+         kStackClassName.compare(class_name) == 0 ||
+         kArraySegmentClassName.compare(class_name) == 0 ||
+         kImmutableArrayClassName.compare(class_name) == 0 ||
+         kConcurrentDictionaryClassName.compare(class_name) == 0;
+}
 
 HRESULT DbgBuiltinCollection::ProcessClassMembersHelper(
     ICorDebugValue *debug_value, ICorDebugClass *debug_class,
@@ -69,11 +95,9 @@ HRESULT DbgBuiltinCollection::ProcessClassMembersHelper(
     if (SUCCEEDED(hr)) {
       // Makes sure we don't grab more items than we need (this can happen
       // because if a list size is 2, the underlying items_ array can have 4
-      // items).
-      if (count_ < DbgBreakpoint::GetMaximumCollectionSize()) {
-        (reinterpret_cast<DbgArray *>(collection_items_.get()))
-            ->SetMaxArrayItemsToRetrieve(count_);
-      }
+      // items). The limits of the capture are applied on top of this.
+      (reinterpret_cast<DbgArray *>(collection_items_.get()))
+          ->SetMaxArrayItemsToRetrieve(count_);
     }
     return hr;
   }
@@ -102,6 +126,7 @@ HRESULT DbgBuiltinCollection::ProcessClassMembersHelper(
       hashset_last_index_ =
           reinterpret_cast<DbgPrimitive<int32_t> *>(last_index.get())
               ->GetValue();
+      ProcessHashCodeOffset(metadata_import);
     }
     return hr;
   }
@@ -109,14 +134,208 @@ HRESULT DbgBuiltinCollection::ProcessClassMembersHelper(
   // This is a dictionary.
   if (kDictionaryClassName.compare(class_name_) == 0) {
     class_type_ = ClassType::DICTIONARY;
-    return ProcessCollectionType(debug_obj_value, debug_class, metadata_import,
-                                 kDictionaryCountFieldName,
-                                 kDictionaryItemsFieldName);
+    hr = ProcessCollectionType(debug_obj_value, debug_class, metadata_import,
+                               kDictionaryCountFieldName,
+                               kDictionaryItemsFieldName);
+    if (SUCCEEDED(hr)) {
+      ProcessHashCodeOffset(metadata_import);
+    }
+    return hr;
+  }
+
+  // A queue is a circular buffer whose first item is at _head.
+  if (kQueueClassName.compare(class_name_) == 0) {
+    class_type_ = ClassType::QUEUE;
+    hr = ProcessCollectionType(debug_obj_value, debug_class, metadata_import,
+                               kListSizeFieldName, kArrayFieldName);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    return ExtractInt32Field(debug_obj_value, debug_class, metadata_import,
+                             kQueueHeadFieldName, &first_item_position_);
+  }
+
+  // A stack is shown from its top, which is the last item of _array.
+  if (kStackClassName.compare(class_name_) == 0) {
+    class_type_ = ClassType::STACK;
+    hr = ProcessCollectionType(debug_obj_value, debug_class, metadata_import,
+                               kListSizeFieldName, kArrayFieldName);
+    if (SUCCEEDED(hr)) {
+      first_item_position_ = count_ - 1;
+    }
+    return hr;
+  }
+
+  if (kArraySegmentClassName.compare(class_name_) == 0) {
+    class_type_ = ClassType::ARRAY_SEGMENT;
+    hr = ProcessCollectionType(debug_obj_value, debug_class, metadata_import,
+                               kArraySegmentCountFieldName, kArrayFieldName);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    return ExtractInt32Field(debug_obj_value, debug_class, metadata_import,
+                             kArraySegmentOffsetFieldName,
+                             &first_item_position_);
+  }
+
+  // An immutable array only wraps an array, which is null for a default
+  // ImmutableArray.
+  if (kImmutableArrayClassName.compare(class_name_) == 0) {
+    class_type_ = ClassType::IMMUTABLE_ARRAY;
+    hr = ExtractField(debug_obj_value, debug_class, metadata_import,
+                      kImmutableArrayItemsFieldName, &collection_items_);
+    if (FAILED(hr)) {
+      WriteError("Failed to get the items of the collection.");
+      return hr;
+    }
+
+    DbgArray *items = dynamic_cast<DbgArray *>(collection_items_.get());
+    count_ = (items && !items->GetIsNull()) ? items->GetArraySize() : 0;
+    return S_OK;
+  }
+
+  if (kConcurrentDictionaryClassName.compare(class_name_) == 0) {
+    class_type_ = ClassType::CONCURRENT_DICTIONARY;
+    return ProcessConcurrentDictionary(debug_obj_value, debug_class,
+                                       metadata_import);
   }
 
   return E_NOTIMPL;
 }
 
+HRESULT DbgBuiltinCollection::ExtractInt32Field(
+    ICorDebugObjectValue *debug_obj_value, ICorDebugClass *debug_class,
+    IMetaDataImport *metadata_import, const std::string &field_name,
+    int32_t *value) {
+  unique_ptr<DbgObject> field_value;
+  HRESULT hr = ExtractField(debug_obj_value, debug_class, metadata_import,
+                            field_name, &field_value);
+  if (FAILED(hr)) {
+    WriteError("Failed to find field " + field_name + " of the collection.");
+    return hr;
+  }
+
+  hr = DbgPrimitive<int32_t>::GetValue(field_value.get(), value);
+  if (FAILED(hr)) {
+    WriteError("Field " + field_name + " of the collection is not an int.");
+  }
+  return hr;
+}
+
+HRESULT DbgBuiltinCollection::ProcessConcurrentDictionary(
+    ICorDebugObjectValue *debug_obj_value, ICorDebugClass *debug_class,
+    IMetaDataImport *metadata_import) {
+  unique_ptr<DbgObject> tables_obj;
+  HRESULT hr = ExtractField(debug_obj_value, debug_class, metadata_import,
+                            kConcurrentTablesFieldName, &tables_obj);
+  if (FAILED(hr)) {
+    WriteError("Failed to get the tables of the concurrent dictionary.");
+    return hr;
+  }
+
+  DbgReferenceObject *tables =
+      dynamic_cast<DbgReferenceObject *>(tables_obj.get());
+  if (!tables) {
+    WriteError("Failed to get the tables of the concurrent dictionary.");
+    return E_FAIL;
+  }
+
+  hr = tables->GetNonStaticField(kConcurrentBucketsFieldName,
+                                 &concurrent_buckets_);
+  if (FAILED(hr)) {
+    WriteError("Failed to get the buckets of the concurrent dictionary.");
+    return hr;
+  }
+
+  // The dictionary keeps a count of items for each of its locks.
+  shared_ptr<DbgObject> count_per_lock_obj;
+  hr = tables->GetNonStaticField(kConcurrentCountPerLockFieldName,
+                                 &count_per_lock_obj);
+  if (FAILED(hr)) {
+    WriteError("Failed to get the count of the concurrent dictionary.");
+    return hr;
+  }
+
+  DbgArray *count_per_lock = dynamic_cast<DbgArray *>(count_per_lock_obj.get());
+  if (!count_per_lock) {
+    WriteError("Failed to get the count of the concurrent dictionary.");
+    return E_FAIL;
+  }
+
+  count_ = 0;
+  int locks = count_per_lock->GetIsNull() ? 0 : count_per_lock->GetArraySize();
+  for (int i = 0; i < locks; ++i) {
+    CComPtr<ICorDebugValue> lock_count_value;
+    CComPtr<ICorDebugGenericValue> lock_count_generic;
+    int32_t lock_count = 0;
+    hr = count_per_lock->GetArrayItem(i, &lock_count_value);
+    if (SUCCEEDED(hr)) {
+      hr = lock_count_value->QueryInterface(
+          __uuidof(ICorDebugGenericValue),
+          reinterpret_cast<void **>(&lock_count_generic));
+    }
+    if (SUCCEEDED(hr)) {
+      hr = lock_count_generic->GetValue(&lock_count);
+    }
+    if (FAILED(hr)) {
+      WriteError("Failed to get the count of the concurrent dictionary.");
+      return hr;
+    }
+    count_ += lock_count;
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgBuiltinCollection::GetObjectFieldValue(
+    ICorDebugValue *debug_value, const std::string &field_name,
+    ICorDebugValue **field_value) {
+  HRESULT hr;
+  CComPtr<ICorDebugObjectValue> object_value;
+  hr = debug_value->QueryInterface(__uuidof(ICorDebugObjectValue),
+                                   reinterpret_cast<void **>(&object_value));
+  if (FAILED(hr)) {
+    WriteError("Failed to cast to ICorDebugObjectValue.");
+    return hr;
+  }
+
+  CComPtr<ICorDebugClass> debug_class;
+  mdTypeDef class_token;
+  hr = object_value->GetClass(&debug_class);
+  if (FAILED(hr)) {
+    WriteError("Failed to get ICorDebugClass.");
+    return hr;
+  }
+
+  hr = debug_class->GetToken(&class_token);
+  if (FAILED(hr)) {
+    WriteError("Failed to get the token of the class.");
+    return hr;
+  }
+
+  CComPtr<IMetaDataImport> metadata_import;
+  hr = debug_helper_->GetMetadataImportFromICorDebugClass(
+      debug_class, &metadata_import, GetErrorStream());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  mdFieldDef field_def;
+  vector<WCHAR> wchar_field_name = ConvertStringToWCharPtr(field_name);
+  hr = metadata_import->FindField(class_token, wchar_field_name.data(),
+                                  nullptr, 0, &field_def);
+  if (FAILED(hr)) {
+    WriteError("Failed to find field " + field_name);
+    return hr;
+  }
+
+  hr = object_value->GetFieldValue(debug_class, field_def, field_value);
+  if (FAILED(hr)) {
+    WriteError("Failed to get the value of field " + field_name);
+  }
+  return hr;
+}
+
 HRESULT DbgBuiltinCollection::ProcessCollectionType(
     ICorDebugObjectValue *debug_obj_value, ICorDebugClass *debug_class,
     IMetaDataImport *metadata_import, const std::string &count_field,
@@ -147,9 +366,54 @@ HRESULT DbgBuiltinCollection::ProcessCollectionType(
   return hr;
 }
 
+void DbgBuiltinCollection::ProcessHashCodeOffset(
+    IMetaDataImport *metadata_import) {
+  DbgArray *entries_array = dynamic_cast<DbgArray *>(collection_items_.get());
+  if (!entries_array || entries_array->GetIsNull() ||
+      entries_array->GetArraySize() == 0) {
+    return;
+  }
+
+  // The entries are read one at a time if the offset is not found.
+  has_hash_code_offset_ = SUCCEEDED(entries_array->GetItemFieldOffset(
+      metadata_import, kHashSetAndDictHashCodeFieldName, &hash_code_offset_));
+}
+
+HRESULT DbgBuiltinCollection::ReadHashCodes(int32_t first_entry,
+                                            int32_t entry_count,
+                                            IEvalCoordinator *eval_coordinator,
+                                            vector<int32_t> *hash_codes) {
+  if (!has_hash_code_offset_) {
+    return E_FAIL;
+  }
+
+  DbgArray *entries_array = reinterpret_cast<DbgArray *>(
+      collection_items_.get());
+  vector<BYTE> entries_memory;
+  ULONG32 entry_size;
+  HRESULT hr = entries_array->ReadItemsMemory(
+      first_entry, entry_count, eval_coordinator, &entries_memory,
+      &entry_size);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (hash_code_offset_ + sizeof(int32_t) > entry_size) {
+    return E_FAIL;
+  }
+
+  hash_codes->resize(entry_count);
+  for (int32_t i = 0; i < entry_count; ++i) {
+    memcpy(&(*hash_codes)[i],
+           entries_memory.data() + i * entry_size + hash_code_offset_,
+           sizeof(int32_t));
+  }
+  return S_OK;
+}
+
 HRESULT DbgBuiltinCollection::PopulateMembers(
     Variable *variable_proto, vector<VariableWrapper> *members,
-    IEvalCoordinator *eval_coordinator) {
+    const CaptureLimits &limits, IEvalCoordinator *eval_coordinator) {
   if (!members) {
     return E_INVALIDARG;
   }
@@ -180,20 +444,41 @@ HRESULT DbgBuiltinCollection::PopulateMembers(
   // Sets the Count property of the collection.
   Variable *list_count = variable_proto->add_members();
   list_count->set_name(kCountProtoFieldName);
-  list_count->set_value(std::to_string(count_));
+  AssignNumber(count_, list_count->mutable_value());
   list_count->set_type(kInt32ClassName);
 
   if (class_type_ == ClassType::LIST && collection_items_) {
-    return collection_items_->PopulateMembers(variable_proto, members,
+    return collection_items_->PopulateMembers(variable_proto, members, limits,
                                               eval_coordinator);
   }
 
   if ((class_type_ == ClassType::SET || class_type_ == ClassType::DICTIONARY) &&
       collection_items_) {
-    return PopulateHashSetOrDictionary(variable_proto, members,
+    return PopulateHashSetOrDictionary(variable_proto, members, limits,
                                        eval_coordinator);
   }
 
+  if (class_type_ == ClassType::IMMUTABLE_ARRAY && collection_items_) {
+    return collection_items_->PopulateMembers(variable_proto, members, limits,
+                                              eval_coordinator);
+  }
+
+  if ((class_type_ == ClassType::QUEUE ||
+       class_type_ == ClassType::ARRAY_SEGMENT) &&
+      collection_items_) {
+    return PopulateArrayRange(variable_proto, members, limits,
+                              first_item_position_, false);
+  }
+
+  if (class_type_ == ClassType::STACK && collection_items_) {
+    return PopulateArrayRange(variable_proto, members, limits,
+                              first_item_position_, true);
+  }
+
+  if (class_type_ == ClassType::CONCURRENT_DICTIONARY && concurrent_buckets_) {
+    return PopulateConcurrentDictionary(variable_proto, members, limits);
+  }
+
   WriteError("Unknown collection.");
 
   return E_NOTIMPL;
@@ -201,15 +486,15 @@ HRESULT DbgBuiltinCollection::PopulateMembers(
 
 HRESULT DbgBuiltinCollection::PopulateHashSetOrDictionary(
     google::cloud::diagnostics::debug::Variable *variable_proto,
-    vector<VariableWrapper> *members, IEvalCoordinator *eval_coordinator) {
+    vector<VariableWrapper> *members, const CaptureLimits &limits,
+    IEvalCoordinator *eval_coordinator) {
   // Start fetching items from the hash set or dictionary.
   HRESULT hr;
   int32_t index = 0;
-  int32_t current_max_size = DbgBreakpoint::GetMaximumCollectionSize();
+  int32_t current_max_size = static_cast<int32_t>(
+      min<uint32_t>(limits.max_collection_items, INT32_MAX));
   int32_t max_items_to_fetch = min(count_, current_max_size);
   int32_t items_fetched_so_far = 0;
-  // Casts the collection_items_ to an array.
-  DbgArray *slots_array = reinterpret_cast<DbgArray *>(collection_items_.get());
   // We get items from the _items array. If this is a hash set, we have to make
   // sure we don't go beyond the hashset_last_index_ because items at this point
   // onwards will either be invalid or out of bound of the array.
@@ -219,103 +504,351 @@ HRESULT DbgBuiltinCollection::PopulateHashSetOrDictionary(
   int32_t max_index =
       (class_type_ == ClassType::SET) ? hashset_last_index_ : count_;
 
+  // The hash codes of the entries are read in blocks from the memory of
+  // the debuggee when possible, so that free entries are skipped without
+  // creating objects for them.
+  vector<int32_t> hash_codes;
+  int32_t hash_codes_start = 0;
+  bool read_hash_codes = has_hash_code_offset_;
+
   for (int32_t index = 0; index < max_index; ++index) {
-    // Extracts out the item from the array.
-    CComPtr<ICorDebugValue> array_item;
-    hr = slots_array->GetArrayItem(index, &array_item);
+    if (read_hash_codes &&
+        index >= hash_codes_start + static_cast<int32_t>(hash_codes.size())) {
+      hash_codes_start = index;
+      hr = ReadHashCodes(index, min(kHashCodesPerRead, max_index - index),
+                         eval_coordinator, &hash_codes);
+      if (FAILED(hr)) {
+        read_hash_codes = false;
+        hash_codes.clear();
+      }
+    }
+
+    if (read_hash_codes && hash_codes[index - hash_codes_start] < 0) {
+      continue;
+    }
+
+    bool is_free = false;
+    hr = AddHashSetOrDictionaryEntry(index, items_fetched_so_far,
+                                     variable_proto, members, limits,
+                                     &is_free);
     if (FAILED(hr)) {
-      WriteError("Failed to get hash set item at index " +
-                 std::to_string(index));
       return hr;
     }
 
-    // Now creates a DbgObject that represents the Slot object from the
-    // array_item we got above. Each Slot has the form struct Slot { int
-    // hashCode; T value; int next; }
-    // If this is a dictionary, then we will have Entry object with
-    // the form Entry { int hashCode; TKey key; TValue value; int next; }
-    // So a dictionary entry is essentially the same as a set slot except
-    // that the dictionary entry has a key.
-    unique_ptr<DbgObject> slot_item_obj;
-    hr = object_factory_->CreateDbgObject(array_item, GetCreationDepth(),
-                                          &slot_item_obj, GetErrorStream());
+    if (is_free) {
+      continue;
+    }
+
+    items_fetched_so_far++;
+    if (items_fetched_so_far >= max_items_to_fetch) {
+      break;
+    }
+  }
+  return S_OK;
+}
+
+HRESULT DbgBuiltinCollection::AddHashSetOrDictionaryEntry(
+    int32_t index, int32_t item_index, Variable *variable_proto,
+    vector<VariableWrapper> *members, const CaptureLimits &limits,
+    bool *is_free) {
+  HRESULT hr;
+  // Casts the collection_items_ to an array.
+  DbgArray *slots_array = reinterpret_cast<DbgArray *>(collection_items_.get());
+
+  // Extracts out the item from the array.
+  CComPtr<ICorDebugValue> array_item;
+  hr = slots_array->GetArrayItem(index, &array_item);
+  if (FAILED(hr)) {
+    WriteError("Failed to get hash set item at index " +
+               std::to_string(index));
+    return hr;
+  }
+
+  // Now creates a DbgObject that represents the Slot object from the
+  // array_item we got above. Each Slot has the form struct Slot { int
+  // hashCode; T value; int next; }
+  // If this is a dictionary, then we will have Entry object with
+  // the form Entry { int hashCode; TKey key; TValue value; int next; }
+  // So a dictionary entry is essentially the same as a set slot except
+  // that the dictionary entry has a key.
+  unique_ptr<DbgObject> slot_item_obj;
+  hr = object_factory_->CreateDbgObject(array_item, GetCreationDepth(),
+                                        &slot_item_obj, GetErrorStream());
+  if (FAILED(hr)) {
+    WriteError("Failed to create DbgObject for item at index " +
+               std::to_string(index));
+    return hr;
+  }
+
+  // Casts the DbgObject to a class.
+  DbgClass *slot_item = reinterpret_cast<DbgClass *>(slot_item_obj.get());
+  // Try to find the hashCode field of the struct.
+  shared_ptr<DbgObject> hash_code_obj = nullptr;
+  hr = slot_item->GetNonStaticField(kHashSetAndDictHashCodeFieldName,
+                                    &hash_code_obj);
+  if (FAILED(hr)) {
+    WriteError("Failed to evaluate hash code for item at index " +
+               std::to_string(index));
+    return hr;
+  }
+
+  // Since hashCode is an int, we cast it to a DbgPrimitive<int32_t>.
+  DbgPrimitive<int32_t> *hash_code_primitive_obj =
+      reinterpret_cast<DbgPrimitive<int32_t> *>(hash_code_obj.get());
+  int32_t hash_code_value = hash_code_primitive_obj->GetValue();
+  // Now the hashCode of the struct is actually processed in such a way that
+  // they can only be greater than or equal to 0. If they are negative, then
+  // this means this is not a valid item (probably removed), so we continue to
+  // the next index. This is true for both hash set and dictionary.
+  if (hash_code_value < 0) {
+    *is_free = true;
+    return S_OK;
+  }
+
+  // Gets the underlying DbgObject that represents value field.
+  shared_ptr<DbgObject> value_obj = nullptr;
+  hr = slot_item->GetNonStaticField(kHashSetAndDictValueFieldName, &value_obj);
+  if (FAILED(hr)) {
+    WriteError("Failed to evaluate the value of item at index " +
+               std::to_string(index));
+    return hr;
+  }
+
+  shared_ptr<DbgObject> key_obj = nullptr;
+  // If this is a dictionary, we have to find the key field of the struct.
+  if (class_type_ == ClassType::DICTIONARY) {
+    hr = slot_item->GetNonStaticField(kDictionaryKeyFieldName, &key_obj);
     if (FAILED(hr)) {
-      WriteError("Failed to create DbgObject for item at index " +
+      WriteError("Failed to evaluate the value of the key at index " +
                  std::to_string(index));
       return hr;
     }
+  }
+
+  // Now creates a member that represents this item.
+  Variable *item_proto = variable_proto->add_members();
+
+  // For hash set, just display item as [index]: value.
+  if (class_type_ == ClassType::SET) {
+    AssignIndexName(item_index, item_proto->mutable_name());
+    // We don't have to worry about errors since PopulateVariableValue
+    // will automatically sets error in item_proto.
+    members->push_back(VariableWrapper(item_proto, value_obj));
+    return S_OK;
+  }
+
+  // For dictionary, a primitive or string key is displayed as the name
+  // of the item, so an item would be [Key]: Value. Other keys are
+  // displayed as [index]: { "key": Key, "value": Value }.
+  string key_name;
+  if (FormatInlineKey(key_obj.get(), limits, &key_name)) {
+    item_proto->set_name(key_name);
+    members->push_back(VariableWrapper(item_proto, value_obj));
+    return S_OK;
+  }
+
+  AssignIndexName(item_index, item_proto->mutable_name());
+  Variable *key_proto = item_proto->add_members();
+  key_proto->set_name(kDictionaryKeyFieldName);
+  members->push_back(VariableWrapper(key_proto, key_obj));
+
+  Variable *value_proto = item_proto->add_members();
+  value_proto->set_name(kHashSetAndDictValueFieldName);
+  members->push_back(VariableWrapper(value_proto, value_obj));
+
+  return S_OK;
+}
+
+bool DbgBuiltinCollection::FormatInlineKey(DbgObject *key_obj,
+                                           const CaptureLimits &limits,
+                                           string *key_name) {
+  if (!key_obj || FAILED(key_obj->GetInitializeHr())) {
+    return false;
+  }
+
+  Variable key_proto;
+  if (dynamic_cast<DbgString *>(key_obj)) {
+    if (key_obj->GetIsNull() ||
+        FAILED(key_obj->PopulateValueWithinLimits(&key_proto, limits)) ||
+        key_proto.has_status()) {
+      // A key that is only partly read keeps its status as a member.
+      return false;
+    }
+    *key_name = "[\"" + key_proto.value() + "\"]";
+    return true;
+  }
 
-    // Casts the DbgObject to a class.
-    DbgClass *slot_item = reinterpret_cast<DbgClass *>(slot_item_obj.get());
-    // Try to find the hashCode field of the struct.
-    shared_ptr<DbgObject> hash_code_obj = nullptr;
-    hr = slot_item->GetNonStaticField(kHashSetAndDictHashCodeFieldName,
-                                      &hash_code_obj);
+  // Only primitives capture their value without reading the debuggee.
+  if (!key_obj->CaptureValue() || FAILED(key_obj->PopulateValue(&key_proto))) {
+    return false;
+  }
+  *key_name = "[" + key_proto.value() + "]";
+  return true;
+}
+
+HRESULT DbgBuiltinCollection::PopulateArrayRange(
+    Variable *variable_proto, vector<VariableWrapper> *members,
+    const CaptureLimits &limits, int32_t first, bool reverse) {
+  DbgArray *items_array = dynamic_cast<DbgArray *>(collection_items_.get());
+  if (!items_array) {
+    WriteError("Failed to get the items of the collection.");
+    return E_FAIL;
+  }
+
+  if (items_array->GetIsNull()) {
+    return S_OK;
+  }
+
+  int32_t array_size = items_array->GetArraySize();
+  int32_t max_items = static_cast<int32_t>(
+      min<uint32_t>(limits.max_collection_items, INT32_MAX));
+  int32_t items_to_fetch = min(count_, max_items);
+  if (items_to_fetch <= 0) {
+    return S_OK;
+  }
+
+  if (first < 0 || first >= array_size || count_ > array_size) {
+    WriteError("The items of the collection are out of range.");
+    return E_FAIL;
+  }
+
+  for (int32_t i = 0; i < items_to_fetch; ++i) {
+    int32_t position = reverse ? first - i : first + i;
+    position = (position % array_size + array_size) % array_size;
+
+    Variable *member = variable_proto->add_members();
+    AssignIndexName(i, member->mutable_name());
+
+    CComPtr<ICorDebugValue> array_item;
+    HRESULT hr = items_array->GetArrayItem(position, &array_item);
     if (FAILED(hr)) {
-      WriteError("Failed to evaluate hash code for item at index " +
-                 std::to_string(index));
-      return hr;
+      SetErrorStatusMessage(member, items_array);
+      continue;
     }
 
-    // Since hashCode is an int, we cast it to a DbgPrimitive<int32_t>.
-    DbgPrimitive<int32_t> *hash_code_primitive_obj =
-        reinterpret_cast<DbgPrimitive<int32_t> *>(hash_code_obj.get());
-    int32_t hash_code_value = hash_code_primitive_obj->GetValue();
-    // Now the hashCode of the struct is actually processed in such a way that
-    // they can only be greater than or equal to 0. If they are -1, then this
-    // means this is not a valid item (probably removed), so we continue to the
-    // next index. This is true for both hash set and dictionary.
-    if (hash_code_value == -1) {
+    unique_ptr<DbgObject> item;
+    hr = object_factory_->CreateDbgObject(
+        array_item, items_array->GetCreationDepth() - 1, &item,
+        GetErrorStream());
+    if (FAILED(hr)) {
+      if (item) {
+        WriteError(item->GetErrorString());
+      }
+      SetErrorStatusMessage(member, this);
       continue;
     }
 
-    // Gets the underlying DbgObject that represents value field.
-    shared_ptr<DbgObject> value_obj = nullptr;
-    hr =
-        slot_item->GetNonStaticField(kHashSetAndDictValueFieldName, &value_obj);
+    members->push_back(VariableWrapper(member, std::move(item)));
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgBuiltinCollection::PopulateConcurrentDictionary(
+    Variable *variable_proto, vector<VariableWrapper> *members,
+    const CaptureLimits &limits) {
+  DbgArray *buckets = dynamic_cast<DbgArray *>(concurrent_buckets_.get());
+  if (!buckets) {
+    WriteError("Failed to get the buckets of the concurrent dictionary.");
+    return E_FAIL;
+  }
+
+  if (buckets->GetIsNull()) {
+    return S_OK;
+  }
+
+  int32_t max_items = static_cast<int32_t>(
+      min<uint32_t>(limits.max_collection_items, INT32_MAX));
+  int32_t items_to_fetch = min(count_, max_items);
+  int32_t items_fetched_so_far = 0;
+  int32_t bucket_count = buckets->GetArraySize();
+
+  HRESULT hr;
+  for (int32_t bucket = 0;
+       bucket < bucket_count && items_fetched_so_far < items_to_fetch;
+       ++bucket) {
+    CComPtr<ICorDebugValue> node_reference;
+    hr = buckets->GetArrayItem(bucket, &node_reference);
     if (FAILED(hr)) {
-      WriteError("Failed to evaluate the value of item at index " +
-                 std::to_string(index));
+      WriteError("Failed to get bucket " + std::to_string(bucket));
       return hr;
     }
 
-    shared_ptr<DbgObject> key_obj = nullptr;
-    // If this is a dictionary, we have to find the key field of the struct.
-    if (class_type_ == ClassType::DICTIONARY) {
-      hr = slot_item->GetNonStaticField(kDictionaryKeyFieldName, &key_obj);
+    // Follows the chain of nodes of the bucket through their _next field.
+    while (items_fetched_so_far < items_to_fetch) {
+      BOOL is_null = FALSE;
+      CComPtr<ICorDebugValue> node;
+      hr = debug_helper_->Dereference(node_reference, &node, &is_null,
+                                      GetErrorStream());
       if (FAILED(hr)) {
-        WriteError("Failed to evaluate the value of the key at index " +
-                   std::to_string(index));
         return hr;
       }
-    }
 
-    // Now creates a member that represents this item.
-    Variable *item_proto = variable_proto->add_members();
-    item_proto->set_name("[" + std::to_string(items_fetched_so_far) + "]");
-
-    // For hash set, just display item as [index]: value.
-    if (class_type_ == ClassType::SET) {
-      // We don't have to worry about errors since PopulateVariableValue
-      // will automatically sets error in item_proto.
-      members->push_back(VariableWrapper(item_proto, value_obj));
-    } else {
-      // For dictionary, we also display the key. So an item would be
-      // [index]: { "key": Key, "value": Value }
-      Variable *key_proto = item_proto->add_members();
-      key_proto->set_name(kDictionaryKeyFieldName);
-      members->push_back(VariableWrapper(key_proto, key_obj));
-
-      Variable *value_proto = item_proto->add_members();
-      value_proto->set_name(kHashSetAndDictValueFieldName);
-      members->push_back(VariableWrapper(value_proto, value_obj));
-    }
+      if (is_null) {
+        break;
+      }
 
-    items_fetched_so_far++;
-    if (items_fetched_so_far >= max_items_to_fetch) {
-      break;
+      CComPtr<ICorDebugValue> key_value;
+      CComPtr<ICorDebugValue> value_value;
+      hr = GetObjectFieldValue(node, kConcurrentKeyFieldName, &key_value);
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      hr = GetObjectFieldValue(node, kConcurrentValueFieldName, &value_value);
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      Variable *item_proto = variable_proto->add_members();
+
+      // An item is shown as [Key]: Value or as
+      // [index]: { "key": Key, "value": Value }, like the item of a
+      // dictionary.
+      unique_ptr<DbgObject> key_obj;
+      unique_ptr<DbgObject> value_obj;
+      HRESULT key_hr = object_factory_->CreateDbgObject(
+          key_value, GetCreationDepth() - 1, &key_obj, GetErrorStream());
+      string key_name;
+      Variable *value_proto = item_proto;
+      if (SUCCEEDED(key_hr) &&
+          FormatInlineKey(key_obj.get(), limits, &key_name)) {
+        item_proto->set_name(key_name);
+      } else {
+        AssignIndexName(items_fetched_so_far, item_proto->mutable_name());
+        Variable *key_proto = item_proto->add_members();
+        key_proto->set_name(kDictionaryKeyFieldName);
+        if (FAILED(key_hr)) {
+          SetErrorStatusMessage(key_proto, this);
+        } else {
+          members->push_back(VariableWrapper(key_proto, std::move(key_obj)));
+        }
+
+        value_proto = item_proto->add_members();
+        value_proto->set_name(kHashSetAndDictValueFieldName);
+      }
+
+      hr = object_factory_->CreateDbgObject(value_value,
+                                            GetCreationDepth() - 1,
+                                            &value_obj, GetErrorStream());
+      if (FAILED(hr)) {
+        SetErrorStatusMessage(value_proto, this);
+      } else {
+        members->push_back(VariableWrapper(value_proto, std::move(value_obj)));
+      }
+
+      items_fetched_so_far++;
+
+      CComPtr<ICorDebugValue> next_reference;
+      hr = GetObjectFieldValue(node, kConcurrentNextFieldName,
+                               &next_reference);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      node_reference = next_reference;
     }
   }
+
   return S_OK;
 }
 
@@ -23,7 +23,9 @@
 namespace google_cloud_debugger {
 
 // Class that represents a .NET built-in collection (List, HashSet,
-// Dictionary).
+// Dictionary, Queue, Stack, ArraySegment, ImmutableArray and
+// ConcurrentDictionary). Only the count and the items of the collection
+// are captured instead of its internal fields.
 class DbgBuiltinCollection : public DbgClass {
  public:
   DbgBuiltinCollection(ICorDebugType *debug_type, int depth,
@@ -31,9 +33,13 @@ class DbgBuiltinCollection : public DbgClass {
                        std::shared_ptr<IDbgObjectFactory> obj_factory)
       : DbgClass(debug_type, depth, debug_helper, obj_factory) {}
 
+  // Returns true if class_name is the name of a collection that this
+  // class represents.
+  static bool IsBuiltinCollection(const std::string &class_name);
+
   HRESULT PopulateMembers(
       google::cloud::diagnostics::debug::Variable *variable_proto,
-      std::vector<VariableWrapper> *members,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
       IEvalCoordinator *eval_coordinator) override;
 
  protected:
@@ -47,10 +53,44 @@ class DbgBuiltinCollection : public DbgClass {
   // or dictionary) and the members of this hash set or dictionary.
   HRESULT PopulateHashSetOrDictionary(
       google::cloud::diagnostics::debug::Variable *variable_proto,
-      std::vector<VariableWrapper> *members,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
       IEvalCoordinator *eval_coordinator);
 
  private:
+  // Populates members with the items of a collection that stores them in
+  // the array collection_items_. The i-th item is at position first + i
+  // of the array, or first - i if reverse is true, wrapping around the
+  // end of the array.
+  HRESULT PopulateArrayRange(
+      google::cloud::diagnostics::debug::Variable *variable_proto,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
+      std::int32_t first, bool reverse);
+
+  // Populates members with the items of a ConcurrentDictionary by
+  // following the chains of nodes of its buckets.
+  HRESULT PopulateConcurrentDictionary(
+      google::cloud::diagnostics::debug::Variable *variable_proto,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits);
+
+  // Extracts the int field field_name of debug_obj_value into value.
+  HRESULT ExtractInt32Field(ICorDebugObjectValue *debug_obj_value,
+                            ICorDebugClass *debug_class,
+                            IMetaDataImport *metadata_import,
+                            const std::string &field_name,
+                            std::int32_t *value);
+
+  // Processes the _tables field of a ConcurrentDictionary, which holds
+  // its buckets and the counts of items per lock.
+  HRESULT ProcessConcurrentDictionary(ICorDebugObjectValue *debug_obj_value,
+                                      ICorDebugClass *debug_class,
+                                      IMetaDataImport *metadata_import);
+
+  // Gets the value of field field_name of the object debug_value, which
+  // does not have to be of the class of this collection.
+  HRESULT GetObjectFieldValue(ICorDebugValue *debug_value,
+                              const std::string &field_name,
+                              ICorDebugValue **field_value);
+
   // Processes the case where the object is a collection (list, hash set
   // or a dictionary).
   // This function extracts out these fields:
@@ -65,6 +105,32 @@ class DbgBuiltinCollection : public DbgClass {
                                 const std::string &count_field,
                                 const std::string &entries_field);
 
+  // Finds the offset of the hashCode field in the entries of a hash set
+  // or dictionary, so that PopulateHashSetOrDictionary can read the hash
+  // codes directly from the memory of the debuggee.
+  void ProcessHashCodeOffset(IMetaDataImport *metadata_import);
+
+  // Reads the hash codes of entry_count entries starting at first_entry
+  // into hash_codes with a single memory read.
+  HRESULT ReadHashCodes(int32_t first_entry, int32_t entry_count,
+                        IEvalCoordinator *eval_coordinator,
+                        std::vector<int32_t> *hash_codes);
+
+  // Creates the members of the entry at index of a hash set or
+  // dictionary. Sets is_free to true, without creating members, if
+  // the entry does not hold an item.
+  HRESULT AddHashSetOrDictionaryEntry(
+      int32_t index, int32_t item_index,
+      google::cloud::diagnostics::debug::Variable *variable_proto,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
+      bool *is_free);
+
+  // Sets key_name to "[Key]" if key_obj is a primitive or a string that
+  // can be shown inline as the name of a dictionary item, with strings
+  // in quotes. Returns false otherwise.
+  static bool FormatInlineKey(DbgObject *key_obj, const CaptureLimits &limits,
+                              std::string *key_name);
+
   // Number of items in this object if this is a list, dictionary or hash set.
   std::int32_t count_;
 
@@ -72,6 +138,18 @@ class DbgBuiltinCollection : public DbgClass {
   // into the _slots array.= of the hash set.
   std::int32_t hashset_last_index_;
 
+  // Position in collection_items_ of the first item of a queue or an
+  // array segment.
+  std::int32_t first_item_position_ = 0;
+
+  // Buckets of a ConcurrentDictionary. Each bucket is a chain of nodes.
+  std::shared_ptr<DbgObject> concurrent_buckets_;
+
+  // Offset of the hashCode field in an entry of a hash set or dictionary.
+  // Only valid if has_hash_code_offset_ is true.
+  ULONG32 hash_code_offset_ = 0;
+  bool has_hash_code_offset_ = false;
+
   // Pointer to an array of items of this class if this class object is a
   // collection type (list, hashset, etc.).
   std::unique_ptr<DbgObject> collection_items_;
@@ -110,9 +188,32 @@ class DbgBuiltinCollection : public DbgClass {
   // struct of a dictionary/set.
   static const std::string kHashSetAndDictHashCodeFieldName;
 
+  // "_array", "_head" and "_size" fields of a queue or a stack and
+  // "_offset" and "_count" fields of an array segment.
+  static const std::string kArrayFieldName;
+  static const std::string kQueueHeadFieldName;
+  static const std::string kArraySegmentOffsetFieldName;
+  static const std::string kArraySegmentCountFieldName;
+
+  // "array", which is the field that contains items in an immutable
+  // array. It is null for a default ImmutableArray.
+  static const std::string kImmutableArrayItemsFieldName;
+
+  // Fields of ConcurrentDictionary, its Tables and its Node classes.
+  static const std::string kConcurrentTablesFieldName;
+  static const std::string kConcurrentBucketsFieldName;
+  static const std::string kConcurrentCountPerLockFieldName;
+  static const std::string kConcurrentKeyFieldName;
+  static const std::string kConcurrentValueFieldName;
+  static const std::string kConcurrentNextFieldName;
+
   // "Count", which is the proto field that represents the number
   // of items in this object.
   static const std::string kCountProtoFieldName;
+
+  // Number of entries of a hash set or dictionary whose hash codes are
+  // read from the debuggee at a time.
+  static const std::int32_t kHashCodesPerRead = 256;
 };
 
 }  //  namespace google_cloud_debugger
@@ -21,10 +21,12 @@
 
 #include "dbg_array.h"
 #include "dbg_builtin_collection.h"
+#include "dbg_class_field.h"
 #include "dbg_enum.h"
 #include "i_cor_debug_helper.h"
 #include "i_dbg_object_factory.h"
 #include "i_eval_coordinator.h"
+#include "memory_usage.h"
 #include "variable_wrapper.h"
 
 using google::cloud::diagnostics::debug::Variable;
@@ -38,11 +40,23 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
-std::unordered_map<
+thread_local std::unordered_map<
     std::string,
     std::unordered_map<std::string, std::shared_ptr<IDbgClassMember>>>
     DbgClass::static_class_members_;
 
+std::map<DbgClass::ClassLayoutKey,
+         std::shared_ptr<const DbgClass::ClassLayout>>
+    DbgClass::class_layouts_;
+
+std::mutex DbgClass::class_layouts_mutex_;
+
+thread_local ScopedMemoryCharge DbgClass::static_class_members_memory_(
+    &DebuggerMetrics::Global().static_member_cache_bytes);
+
+ScopedMemoryCharge DbgClass::class_layouts_memory_(
+    &DebuggerMetrics::Global().class_layout_cache_bytes);
+
 HRESULT DbgClass::GetNonStaticField(const std::string &field_name,
                                     std::shared_ptr<DbgObject> *field_value) {
   if (!class_fields_.empty()) {
@@ -57,6 +71,17 @@ HRESULT DbgClass::GetNonStaticField(const std::string &field_name,
       return E_FAIL;
     }
 
+    // The values of non-static fields are read when they are needed.
+    DbgClassField *class_field =
+        dynamic_cast<DbgClassField *>(find_field->get());
+    if (class_field) {
+      HRESULT hr = class_field->ExtractFieldValue();
+      if (FAILED(hr)) {
+        WriteError("Failed to evaluate value for field " + field_name);
+        return hr;
+      }
+    }
+
     // Gets the underlying DbgObject that represents the field field_name
     // of this object.
     *field_value = (*find_field)->GetMemberValue();
@@ -71,6 +96,18 @@ HRESULT DbgClass::GetNonStaticField(const std::string &field_name,
   return DbgReferenceObject::GetNonStaticField(field_name, field_value);
 }
 
+HRESULT DbgClass::GetNonStaticFieldByToken(
+    const std::string &field_name, ICorDebugModule *debug_module,
+    mdTypeDef class_token, mdFieldDef field_def,
+    std::shared_ptr<DbgObject> *field_value) {
+  if (!class_fields_.empty()) {
+    return GetNonStaticField(field_name, field_value);
+  }
+
+  return DbgReferenceObject::GetNonStaticFieldByToken(
+      field_name, debug_module, class_token, field_def, field_value);
+}
+
 HRESULT DbgClass::ProcessParameterizedType() {
   HRESULT hr;
   CComPtr<ICorDebugTypeEnum> type_enum;
@@ -148,15 +185,11 @@ HRESULT DbgClass::GetGenericTypes(
   return S_OK;
 }
 
-HRESULT DbgClass::ProcessFields(IMetaDataImport *metadata_import,
-                                ICorDebugObjectValue *debug_obj_value,
-                                ICorDebugClass *debug_class) {
-  CComPtr<ICorDebugType> debug_type;
+HRESULT DbgClass::BuildClassLayout(IMetaDataImport *metadata_import,
+                                   ClassLayout *layout) {
+  HRESULT hr;
   HCORENUM cor_enum = nullptr;
-
-  debug_type = GetDebugType();
   while (true) {
-    HRESULT hr;
     array<mdFieldDef, 100> field_defs;
     ULONG field_defs_returned = 0;
 
@@ -167,48 +200,36 @@ HRESULT DbgClass::ProcessFields(IMetaDataImport *metadata_import,
       return hr;
     }
 
-    if (field_defs_returned != 0) {
-      class_fields_.reserve(class_fields_.size() + field_defs_returned);
-
-      for (int i = 0; i < field_defs_returned; ++i) {
-        unique_ptr<DbgClassField> class_field(new (std::nothrow) DbgClassField(
-            field_defs[i], GetCreationDepth() - 1, debug_type, debug_helper_,
-            object_factory_));
-        if (!class_field) {
-          WriteError("Run out of memory when trying to create field ");
-          WriteError(std::to_string(field_defs[i]));
-          return E_OUTOFMEMORY;
-        }
-
-        class_field->Initialize(debug_module_, metadata_import, debug_obj_value,
-                                debug_class);
-        if (class_field->IsBackingField()) {
-          // Insert class names into set so we can use it to check later
-          // for backing fields.
-          class_backing_fields_names_.insert(class_field->GetMemberName());
-        }
+    if (field_defs_returned == 0) {
+      break;
+    }
 
-        AddStaticClassMemberToVector(std::move(class_field), &class_fields_);
+    layout->fields.reserve(layout->fields.size() + field_defs_returned);
+    for (int i = 0; i < field_defs_returned; ++i) {
+      unique_ptr<DbgClassField> class_field(new (std::nothrow) DbgClassField(
+          field_defs[i], 0, nullptr, debug_helper_, object_factory_));
+      if (!class_field) {
+        WriteError("Run out of memory when trying to create field ");
+        WriteError(std::to_string(field_defs[i]));
+        return E_OUTOFMEMORY;
       }
-    } else {
-      break;
+
+      class_field->InitializeMetadata(debug_module_, metadata_import);
+      class_field->SetBrowsableState(
+          ReadBrowsableState(metadata_import, field_defs[i]));
+      layout->fields.push_back(std::move(class_field));
     }
   }
 
   if (cor_enum) {
     metadata_import->CloseEnum(cor_enum);
+    cor_enum = nullptr;
   }
 
-  return S_OK;
-}
-
-HRESULT DbgClass::ProcessProperties(IMetaDataImport *metadata_import) {
-  HRESULT hr;
-  array<mdProperty, 100> property_defs;
-  HCORENUM cor_enum = nullptr;
-  ULONG property_defs_returned = 0;
-
   while (true) {
+    array<mdProperty, 100> property_defs;
+    ULONG property_defs_returned = 0;
+
     hr = metadata_import->EnumProperties(
         &cor_enum, class_token_, property_defs.data(), property_defs.size(),
         &property_defs_returned);
@@ -217,59 +238,280 @@ HRESULT DbgClass::ProcessProperties(IMetaDataImport *metadata_import) {
       return hr;
     }
 
-    if (property_defs_returned != 0) {
-      class_properties_.reserve(class_properties_.size() +
-                                property_defs_returned);
+    if (property_defs_returned == 0) {
+      break;
+    }
 
-      for (int i = 0; i < property_defs_returned; ++i) {
-        unique_ptr<DbgClassProperty> class_property(new (
-            std::nothrow) DbgClassProperty(debug_helper_, object_factory_));
-        if (!class_property) {
-          WriteError(
-              "Ran out of memory while trying to initialize class property ");
-          WriteError(std::to_string(property_defs[i]));
-          return E_OUTOFMEMORY;
-        }
+    layout->properties.reserve(layout->properties.size() +
+                               property_defs_returned);
+    for (int i = 0; i < property_defs_returned; ++i) {
+      unique_ptr<DbgClassProperty> class_property(new (
+          std::nothrow) DbgClassProperty(debug_helper_, object_factory_));
+      if (!class_property) {
+        WriteError(
+            "Ran out of memory while trying to initialize class property ");
+        WriteError(std::to_string(property_defs[i]));
+        return E_OUTOFMEMORY;
+      }
 
-        class_property->Initialize(property_defs[i], metadata_import,
-                                   debug_module_, GetCreationDepth() - 1);
-        // If property name is MyProperty, checks whether there is a backing
-        // field with the name <MyProperty>k__BackingField. Note that we have
-        // logic to process backing fields' names to strip out the "<" and
-        // ">k__BackingField" of the field name and places them in the set
-        // class_backing_fields_names. Hence, we only need to check whether
-        // MyProperty is in this set or not. If it is, then it is backed
-        // by a field already, so don't add it to class_properties_.
-        if (class_backing_fields_names_.find(class_property->GetMemberName()) !=
-            class_backing_fields_names_.end()) {
-          continue;
-        }
+      class_property->Initialize(property_defs[i], metadata_import,
+                                 debug_module_, 0);
+      class_property->SetBrowsableState(
+          ReadBrowsableState(metadata_import, property_defs[i]));
+      layout->properties.push_back(std::move(class_property));
+    }
+  }
 
-        if (class_property->IsStatic()) {
-          // Checks whether we already have a shared pointer of this property
-          // in the cache. If not, moves the unique_ptr there.
-          shared_ptr<IDbgClassMember> static_property_value =
-              GetStaticClassMember(module_name_, class_name_,
-                                   class_property->GetMemberName());
-          if (!static_property_value) {
-            std::string property_name = class_property->GetMemberName();
-            static_property_value =
-                shared_ptr<IDbgClassMember>(class_property.release());
-            StoreStaticClassMember(module_name_, class_name_, property_name,
-                                   static_property_value);
-          }
-          class_properties_.emplace_back(static_property_value);
-        } else {
-          class_properties_.push_back(std::move(class_property));
-        }
+  if (cor_enum) {
+    metadata_import->CloseEnum(cor_enum);
+  }
+
+  // The attribute of an auto-implemented property is not on its backing
+  // field, which is what is displayed for the property.
+  for (const auto &class_property : layout->properties) {
+    if (class_property->GetBrowsableState() == BrowsableState::kCollapsed) {
+      continue;
+    }
+
+    for (const auto &class_field : layout->fields) {
+      if (class_field->IsBackingField() &&
+          class_field->GetBrowsableState() == BrowsableState::kCollapsed &&
+          class_field->GetMemberName() == class_property->GetMemberName()) {
+        class_field->SetBrowsableState(class_property->GetBrowsableState());
       }
-    } else {
-      break;
     }
   }
 
-  if (cor_enum != nullptr) {
-    metadata_import->CloseEnum(cor_enum);
+  layout->debugger_display = ReadDebuggerDisplay(metadata_import, class_token_);
+  layout->metadata_import = metadata_import;
+  return S_OK;
+}
+
+BrowsableState DbgClass::ReadBrowsableState(IMetaDataImport *metadata_import,
+                                            mdToken token) {
+  static const vector<WCHAR> attribute_name =
+      ConvertStringToWCharPtr(kDebuggerBrowsableAttribute);
+  const void *attribute_data = nullptr;
+  ULONG attribute_size = 0;
+  HRESULT hr = metadata_import->GetCustomAttributeByName(
+      token, attribute_name.data(), &attribute_data, &attribute_size);
+  if (hr != S_OK || !attribute_data) {
+    return BrowsableState::kCollapsed;
+  }
+
+  // The blob is the prolog 0x0001 and the DebuggerBrowsableState as an
+  // int32, followed by the number of named arguments.
+  const uint8_t *blob = static_cast<const uint8_t *>(attribute_data);
+  if (attribute_size < 6 || blob[0] != 0x01 || blob[1] != 0x00) {
+    return BrowsableState::kCollapsed;
+  }
+
+  int32_t state = blob[2] | (blob[3] << 8) | (blob[4] << 16) |
+                  (static_cast<uint32_t>(blob[5]) << 24);
+  switch (state) {
+    case 0:
+      return BrowsableState::kNever;
+    case 3:
+      return BrowsableState::kRootHidden;
+    default:
+      return BrowsableState::kCollapsed;
+  }
+}
+
+shared_ptr<const DebuggerDisplayFormat> DbgClass::ReadDebuggerDisplay(
+    IMetaDataImport *metadata_import, mdTypeDef class_token) {
+  static const vector<WCHAR> attribute_name =
+      ConvertStringToWCharPtr(kDebuggerDisplayAttribute);
+  const void *attribute_data = nullptr;
+  ULONG attribute_size = 0;
+  HRESULT hr = metadata_import->GetCustomAttributeByName(
+      class_token, attribute_name.data(), &attribute_data, &attribute_size);
+  string format;
+  if (hr != S_OK || !DebuggerDisplayFormat::ReadAttributeArgument(
+                        attribute_data, attribute_size, &format)) {
+    return nullptr;
+  }
+
+  shared_ptr<DebuggerDisplayFormat> debugger_display(
+      new (std::nothrow) DebuggerDisplayFormat());
+  if (!debugger_display || !debugger_display->Parse(format)) {
+    return nullptr;
+  }
+  return debugger_display;
+}
+
+HRESULT DbgClass::GetClassLayout(IMetaDataImport *metadata_import,
+                                 shared_ptr<const ClassLayout> *layout) {
+  // The layout holds a reference to metadata_import, so the pointer
+  // cannot be reused by another module while the layout is cached.
+  ClassLayoutKey key(metadata_import, class_token_);
+  {
+    std::lock_guard<std::mutex> lock(class_layouts_mutex_);
+    auto cached_layout = class_layouts_.find(key);
+    if (cached_layout != class_layouts_.end()) {
+      *layout = cached_layout->second;
+      return S_OK;
+    }
+  }
+
+  shared_ptr<ClassLayout> new_layout(new (std::nothrow) ClassLayout());
+  if (!new_layout) {
+    WriteError("Ran out of memory while trying to create class layout.");
+    return E_OUTOFMEMORY;
+  }
+
+  HRESULT hr = BuildClassLayout(metadata_import, new_layout.get());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::lock_guard<std::mutex> lock(class_layouts_mutex_);
+  if (class_layouts_.size() >= kMaximumCachedClassLayouts) {
+    class_layouts_.clear();
+    class_layouts_memory_.Set(0);
+  }
+  auto cached_layout = class_layouts_.find(key);
+  if (cached_layout != class_layouts_.end()) {
+    // Another thread built the same layout in the meantime.
+    class_layouts_memory_.Set(
+        class_layouts_memory_.Get() -
+        GetClassLayoutMemoryUsage(*cached_layout->second));
+  }
+  class_layouts_[key] = new_layout;
+  class_layouts_memory_.Add(GetClassLayoutMemoryUsage(*new_layout));
+  *layout = std::move(new_layout);
+  return S_OK;
+}
+
+void DbgClass::RemoveClassLayouts(IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(class_layouts_mutex_);
+  auto layout = class_layouts_.lower_bound(ClassLayoutKey(metadata_import, 0));
+  while (layout != class_layouts_.end() &&
+         layout->first.first == metadata_import) {
+    class_layouts_memory_.Set(class_layouts_memory_.Get() -
+                              GetClassLayoutMemoryUsage(*layout->second));
+    layout = class_layouts_.erase(layout);
+  }
+}
+
+size_t DbgClass::GetClassLayoutMemoryUsage(const ClassLayout &layout) {
+  // The entry is a node of a red-black tree, see GetMemoryUsage.
+  return sizeof(decltype(class_layouts_)::value_type) + 4 * sizeof(void *) +
+         sizeof(ClassLayout) +
+         GetMemoryUsage(layout.fields) + GetMemoryUsage(layout.properties) +
+         layout.fields.size() * sizeof(DbgClassField) +
+         layout.properties.size() * sizeof(DbgClassProperty) +
+         (layout.debugger_display
+              ? sizeof(DebuggerDisplayFormat) +
+                    layout.debugger_display->GetMemoryUsage()
+              : 0);
+}
+
+HRESULT DbgClass::ProcessFields(IMetaDataImport *metadata_import,
+                                ICorDebugObjectValue *debug_obj_value,
+                                ICorDebugClass *debug_class) {
+  shared_ptr<const ClassLayout> layout;
+  HRESULT hr = GetClassLayout(metadata_import, &layout);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  debugger_display_ = layout->debugger_display;
+
+  CComPtr<ICorDebugType> debug_type;
+  debug_type = GetDebugType();
+  class_fields_.reserve(class_fields_.size() + layout->fields.size());
+
+  // The primitive fields of the object are read from one copy of its
+  // memory the first time one of them is extracted.
+  shared_ptr<ObjectFieldsMemory> fields_memory;
+  if (debug_obj_value && !layout->fields.empty()) {
+    fields_memory.reset(new (std::nothrow)
+                            ObjectFieldsMemory(debug_obj_value, debug_module_));
+  }
+
+  for (const auto &layout_field : layout->fields) {
+    unique_ptr<DbgClassField> class_field(new (std::nothrow) DbgClassField(
+        layout_field->GetFieldDef(), GetCreationDepth() - 1, debug_type,
+        debug_helper_, object_factory_));
+    if (!class_field) {
+      WriteError("Run out of memory when trying to create field ");
+      WriteError(std::to_string(layout_field->GetFieldDef()));
+      return E_OUTOFMEMORY;
+    }
+
+    class_field->Initialize(*layout_field, debug_obj_value, debug_class,
+                            fields_memory);
+    class_field->SetBrowsableState(layout_field->GetBrowsableState());
+    if (class_field->IsBackingField()) {
+      // Insert class names into set so we can use it to check later
+      // for backing fields.
+      class_backing_fields_names_.insert(class_field->GetMemberName());
+    }
+
+    AddStaticClassMemberToVector(std::move(class_field), &class_fields_);
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgClass::ProcessProperties(IMetaDataImport *metadata_import) {
+  shared_ptr<const ClassLayout> layout;
+  HRESULT hr = GetClassLayout(metadata_import, &layout);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  class_properties_.reserve(class_properties_.size() +
+                            layout->properties.size());
+  for (const auto &layout_property : layout->properties) {
+    // If property name is MyProperty, checks whether there is a backing
+    // field with the name <MyProperty>k__BackingField. Note that we have
+    // logic to process backing fields' names to strip out the "<" and
+    // ">k__BackingField" of the field name and places them in the set
+    // class_backing_fields_names. Hence, we only need to check whether
+    // MyProperty is in this set or not. If it is, then it is backed
+    // by a field already, so don't add it to class_properties_.
+    if (class_backing_fields_names_.find(layout_property->GetMemberName()) !=
+        class_backing_fields_names_.end()) {
+      continue;
+    }
+
+    if (layout_property->IsStatic()) {
+      // Checks whether we already have a shared pointer of this property
+      // in the cache. If not, creates one and stores it there.
+      shared_ptr<IDbgClassMember> static_property_value =
+          GetStaticClassMember(module_name_, class_name_,
+                               layout_property->GetMemberName());
+      if (static_property_value) {
+        class_properties_.emplace_back(static_property_value);
+        continue;
+      }
+    }
+
+    unique_ptr<DbgClassProperty> class_property(new (
+        std::nothrow) DbgClassProperty(debug_helper_, object_factory_));
+    if (!class_property) {
+      WriteError(
+          "Ran out of memory while trying to initialize class property ");
+      WriteError(layout_property->GetMemberName());
+      return E_OUTOFMEMORY;
+    }
+
+    class_property->Initialize(*layout_property, debug_module_,
+                               GetCreationDepth() - 1);
+    class_property->SetBrowsableState(layout_property->GetBrowsableState());
+    class_property->SetObjectAddress(GetAddress());
+    if (class_property->IsStatic()) {
+      std::string property_name = class_property->GetMemberName();
+      shared_ptr<IDbgClassMember> static_property_value(
+          class_property.release());
+      StoreStaticClassMember(module_name_, class_name_, property_name,
+                             static_property_value);
+      class_properties_.emplace_back(static_property_value);
+    } else {
+      class_properties_.push_back(std::move(class_property));
+    }
   }
 
   return S_OK;
@@ -466,9 +708,19 @@ void DbgClass::StoreStaticClassMember(const string &module_name,
   if (static_class_members_.find(key) == static_class_members_.end()) {
     static_class_members_[key] =
         std::unordered_map<string, shared_ptr<IDbgClassMember>>();
+    static_class_members_memory_.Add(
+        GetHashNodeMemoryUsage<decltype(static_class_members_)>() +
+        GetMemoryUsage(key));
   }
 
-  static_class_members_[key][member_name] = object;
+  auto &class_members = static_class_members_[key];
+  if (class_members.find(member_name) == class_members.end()) {
+    static_class_members_memory_.Add(
+        GetHashNodeMemoryUsage<
+            std::unordered_map<string, shared_ptr<IDbgClassMember>>>() +
+        GetMemoryUsage(member_name));
+  }
+  class_members[member_name] = object;
 }
 
 void DbgClass::AddStaticClassMemberToVector(
@@ -494,13 +746,55 @@ void DbgClass::AddStaticClassMemberToVector(
 
 void DbgClass::PopulateClassMembers(
     Variable *variable_proto, std::vector<VariableWrapper> *members,
-    IEvalCoordinator *eval_coordinator,
-    vector<shared_ptr<IDbgClassMember>> *class_members) {
+    const CaptureLimits &limits, IEvalCoordinator *eval_coordinator,
+    vector<shared_ptr<IDbgClassMember>> *class_members,
+    bool defer_evaluation) {
+  // The deferred wrappers share a copy of the generic types so that they
+  // do not depend on the lifetime of this object.
+  shared_ptr<vector<CComPtr<ICorDebugType>>> generic_types;
+  if (defer_evaluation) {
+    generic_types = std::make_shared<vector<CComPtr<ICorDebugType>>>(
+        generic_types_);
+  }
+
   for (auto it = class_members->begin(); it != class_members->end(); ++it) {
     if (*it) {
+      BrowsableState browsable_state = (*it)->GetBrowsableState();
+      if (browsable_state == BrowsableState::kNever) {
+        continue;
+      }
+
+      if (browsable_state == BrowsableState::kRootHidden &&
+          PopulateRootHiddenMember(variable_proto, members, limits,
+                                   eval_coordinator, it->get()) == S_OK) {
+        continue;
+      }
+
       Variable *class_member_var = variable_proto->add_members();
       class_member_var->set_name((*it)->GetMemberName());
 
+      if (defer_evaluation) {
+        shared_ptr<IDbgClassMember> member = *it;
+        CComPtr<ICorDebugValue> object_handle;
+        object_handle = object_handle_;
+        VariableWrapper member_wrapper(class_member_var, nullptr);
+        member_wrapper.SetValueResolver(
+            [member, object_handle, eval_coordinator, generic_types,
+             class_member_var](shared_ptr<DbgObject> *value) -> HRESULT {
+              HRESULT hr = member->Evaluate(object_handle, eval_coordinator,
+                                            generic_types.get());
+              if (FAILED(hr)) {
+                SetErrorStatusMessage(class_member_var, member.get());
+                return hr;
+              }
+
+              *value = member->GetMemberValue();
+              return S_OK;
+            });
+        members->push_back(std::move(member_wrapper));
+        continue;
+      }
+
       HRESULT hr =
           (*it)->Evaluate(object_handle_, eval_coordinator, &generic_types_);
       if (FAILED(hr)) {
@@ -514,6 +808,36 @@ void DbgClass::PopulateClassMembers(
   }
 }
 
+HRESULT DbgClass::PopulateRootHiddenMember(
+    Variable *variable_proto, std::vector<VariableWrapper> *members,
+    const CaptureLimits &limits, IEvalCoordinator *eval_coordinator,
+    IDbgClassMember *class_member) {
+  HRESULT hr =
+      class_member->Evaluate(object_handle_, eval_coordinator, &generic_types_);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  shared_ptr<DbgObject> member_value = class_member->GetMemberValue();
+  if (!member_value || member_value->GetIsNull()) {
+    return S_FALSE;
+  }
+
+  // A member that has no members or fails is displayed as a whole, so
+  // what it added is removed.
+  int first_member = variable_proto->members_size();
+  size_t first_wrapper = members->size();
+  hr = member_value->PopulateMembers(variable_proto, members, limits,
+                                     eval_coordinator);
+  if (hr != S_OK || variable_proto->members_size() == first_member) {
+    members->erase(members->begin() + first_wrapper, members->end());
+    variable_proto->mutable_members()->DeleteSubrange(
+        first_member, variable_proto->members_size() - first_member);
+    return FAILED(hr) ? hr : S_FALSE;
+  }
+  return S_OK;
+}
+
 shared_ptr<IDbgClassMember> DbgClass::GetStaticClassMember(
     const string &module_name, const string &class_name,
     const string &member_name) {
@@ -529,6 +853,7 @@ shared_ptr<IDbgClassMember> DbgClass::GetStaticClassMember(
 
 HRESULT DbgClass::PopulateMembers(Variable *variable_proto,
                                   std::vector<VariableWrapper> *members,
+                                  const CaptureLimits &limits,
                                   IEvalCoordinator *eval_coordinator) {
   if (!members || !variable_proto) {
     return E_INVALIDARG;
@@ -564,17 +889,100 @@ HRESULT DbgClass::PopulateMembers(Variable *variable_proto,
     return hr;
   }
 
-  PopulateClassMembers(variable_proto, members, eval_coordinator,
-                       &class_fields_);
+  if (limits.debugger_display && debugger_display_ &&
+      class_type_ == ClassType::DEFAULT) {
+    string display;
+    if (SUCCEEDED(RenderDebuggerDisplay(limits, &display))) {
+      debugger_display_value_ = std::move(display);
+      captured_debugger_display_ = true;
+      return S_FALSE;
+    }
+  }
+
+  // Fields are read only when they are captured. A large object often
+  // has many more fields than the limits let through.
+  PopulateClassMembers(variable_proto, members, limits, eval_coordinator,
+                       &class_fields_, true);
 
   // Don't evaluate class properties if we don't need to.
   if (!eval_coordinator->PropertyEvaluation()) {
     return S_OK;
   }
 
-  PopulateClassMembers(variable_proto, members, eval_coordinator,
-                       &class_properties_);
+  PopulateClassMembers(variable_proto, members, limits, eval_coordinator,
+                       &class_properties_, false);
+
+  return S_OK;
+}
+
+HRESULT DbgClass::PopulateValue(Variable *variable_proto) {
+  if (!variable_proto) {
+    return E_INVALIDARG;
+  }
+
+  if (captured_debugger_display_) {
+    variable_proto->set_value(debugger_display_value_);
+  }
+  return S_OK;
+}
+
+HRESULT DbgClass::RenderDebuggerDisplay(const CaptureLimits &limits,
+                                        string *display) {
+  for (const DebuggerDisplayFormat::Segment &segment :
+       debugger_display_->GetSegments()) {
+    display->append(segment.text);
+    if (segment.member_path.empty()) {
+      continue;
+    }
+
+    shared_ptr<DbgObject> member_value;
+    DbgReferenceObject *current = this;
+    for (const string &member_name : segment.member_path) {
+      // Primitives and null objects have no members.
+      if (!current || current->GetIsNull()) {
+        return E_FAIL;
+      }
+
+      HRESULT hr = current->GetNonStaticField(member_name, &member_value);
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      if (!member_value) {
+        return E_FAIL;
+      }
+      current = dynamic_cast<DbgReferenceObject *>(member_value.get());
+    }
 
+    if (member_value->GetIsNull()) {
+      display->append("null");
+      continue;
+    }
+
+    Variable member_proto;
+    HRESULT hr =
+        member_value->PopulateValueWithinLimits(&member_proto, limits);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    // Strings are quoted unless the format says nq, and objects without
+    // a value are displayed as their type, like Visual Studio does.
+    bool is_string = member_value->GetCorElementType() ==
+                     CorElementType::ELEMENT_TYPE_STRING;
+    if (is_string && segment.quote_strings) {
+      display->append("\"" + member_proto.value() + "\"");
+    } else if (is_string || !member_proto.value().empty()) {
+      display->append(member_proto.value());
+    } else {
+      string type_string;
+      hr = member_value->GetTypeString(&type_string);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      display->append("{" + type_string + "}");
+    }
+  }
   return S_OK;
 }
 
@@ -15,7 +15,9 @@
 #ifndef DBG_CLASS_H_
 #define DBG_CLASS_H_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -24,6 +26,8 @@
 #include "dbg_class_property.h"
 #include "dbg_primitive.h"
 #include "dbg_reference_object.h"
+#include "debugger_display_format.h"
+#include "metrics.h"
 
 namespace google_cloud_debugger {
 
@@ -48,11 +52,19 @@ class DbgClass : public DbgReferenceObject {
   // represent members of the class. These protos, together with the
   // DbgObjects (which represents underlying objects of the members
   // of the class) will be used to populate the members vector.
+  // If limits.debugger_display is set and the class has a DebuggerDisplay
+  // attribute, the object is captured as the string of its format
+  // instead, and S_FALSE is returned.
   HRESULT PopulateMembers(
       google::cloud::diagnostics::debug::Variable *variable_proto,
-      std::vector<VariableWrapper> *members,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
       IEvalCoordinator *eval_coordinator) override;
 
+  // Sets the value of variable_proto to the DebuggerDisplay string of the
+  // object if PopulateMembers captured the object as it.
+  HRESULT PopulateValue(
+      google::cloud::diagnostics::debug::Variable *variable_proto) override;
+
   // Returns the TypeSignature represented by this class.
   // This function will also populate the generic_types vector
   // of type_signature with the instantiated generic types
@@ -74,6 +86,13 @@ class DbgClass : public DbgReferenceObject {
   HRESULT GetNonStaticField(const std::string &field_name,
                             std::shared_ptr<DbgObject> *field_value) override;
 
+  // Same as GetNonStaticField if class_fields_ are populated. Otherwise,
+  // reads the field by its token (see DbgReferenceObject).
+  HRESULT GetNonStaticFieldByToken(
+      const std::string &field_name, ICorDebugModule *debug_module,
+      mdTypeDef class_token, mdFieldDef field_def,
+      std::shared_ptr<DbgObject> *field_value) override;
+
   // Returns an ICorDebugType vector that represents the generic
   // types of the class.
   HRESULT GetGenericTypes(std::vector<CComPtr<ICorDebugType>> *debug_types);
@@ -96,16 +115,38 @@ class DbgClass : public DbgReferenceObject {
   // Various .NET class types that we need to process differently
   // rather than just printing out fields and properties.
   enum ClassType {
-    DEFAULT,        // Default class type.
-    PRIMITIVETYPE,  // Integral type and bool.
-    ENUM,           // Enum type.
-    LIST,           // System.Collections.Generic.List type.
-    SET,            // System.Collections.Generic.HashSet type.
-    DICTIONARY      // System.Collections.Generic.Dictionary type.
+    DEFAULT,                // Default class type.
+    PRIMITIVETYPE,          // Integral type and bool.
+    ENUM,                   // Enum type.
+    LIST,                   // System.Collections.Generic.List type.
+    SET,                    // System.Collections.Generic.HashSet type.
+    DICTIONARY,             // System.Collections.Generic.Dictionary type.
+    QUEUE,                  // System.Collections.Generic.Queue type.
+    STACK,                  // System.Collections.Generic.Stack type.
+    ARRAY_SEGMENT,          // System.ArraySegment type.
+    IMMUTABLE_ARRAY,        // System.Collections.Immutable.ImmutableArray.
+    CONCURRENT_DICTIONARY   // System.Collections.Concurrent dictionary.
   };
 
-  // Clear cache of static field and properties.
-  static void ClearStaticCache() { static_class_members_.clear(); }
+  // Clears the cache of static fields and properties of the calling
+  // thread. Should be called when the thread has captured a breakpoint
+  // hit, because the values of the cached members are only valid while
+  // the debuggee is stopped. Their metadata stays in the class layouts.
+  static void ClearStaticCache() {
+    static_class_members_.clear();
+    static_class_members_memory_.Set(0);
+  }
+
+  // Clears the cache of the metadata of the members of classes.
+  static void ClearClassLayouts() {
+    std::lock_guard<std::mutex> lock(class_layouts_mutex_);
+    class_layouts_.clear();
+    class_layouts_memory_.Set(0);
+  }
+
+  // Removes the cached metadata of the classes of the module of
+  // metadata_import, which is being unloaded.
+  static void RemoveClassLayouts(IMetaDataImport *metadata_import);
 
   // Sets the name of the module this class is in.
   void SetModuleName(const std::string &module_name) {
@@ -172,10 +213,42 @@ class DbgClass : public DbgReferenceObject {
   // the members if applicable.
   // If there are errors, this function will also set the error
   // status in variable.
+  // If defer_evaluation is true, the members are evaluated only when
+  // their VariableWrapper is populated, so that members that are not
+  // captured because of the limits are never evaluated.
+  // Members that are never browsable are skipped, and the members of
+  // root hidden members are added in their place.
   void PopulateClassMembers(
       google::cloud::diagnostics::debug::Variable *variable_proto,
-      std::vector<VariableWrapper> *members, IEvalCoordinator *eval_coordinator,
-      std::vector<std::shared_ptr<IDbgClassMember>> *class_members);
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
+      IEvalCoordinator *eval_coordinator,
+      std::vector<std::shared_ptr<IDbgClassMember>> *class_members,
+      bool defer_evaluation);
+
+  // Evaluates class_member, which is root hidden, and adds its members
+  // to variable_proto and members. Returns S_FALSE if it has none, in
+  // which case the member is added as usual.
+  HRESULT PopulateRootHiddenMember(
+      google::cloud::diagnostics::debug::Variable *variable_proto,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
+      IEvalCoordinator *eval_coordinator, IDbgClassMember *class_member);
+
+  // Returns the state of the DebuggerBrowsable attribute of the member
+  // token, or kCollapsed if it has none.
+  static BrowsableState ReadBrowsableState(IMetaDataImport *metadata_import,
+                                           mdToken token);
+
+  // Returns the compiled format of the DebuggerDisplay attribute of the
+  // class class_token, or null if it has none or the format is not
+  // supported by DebuggerDisplayFormat.
+  static std::shared_ptr<const DebuggerDisplayFormat> ReadDebuggerDisplay(
+      IMetaDataImport *metadata_import, mdTypeDef class_token);
+
+  // Renders the DebuggerDisplay format of the class with the fields of
+  // this object into display. Fails if a member of the format is not a
+  // field, because properties would need function evaluations.
+  HRESULT RenderDebuggerDisplay(const CaptureLimits &limits,
+                                std::string *display);
 
   // Extracts the static field member_name of class class_name in module
   // module_name in the static cache.
@@ -183,6 +256,41 @@ class DbgClass : public DbgReferenceObject {
       const std::string &module_name, const std::string &class_name,
       const std::string &member_name);
 
+  // Metadata of the fields and properties of a class. It is read once
+  // and shared by every object of the class, so that processing the
+  // members of an object only reads their values.
+  struct ClassLayout {
+    // Keeps the metadata that the signatures and default values of the
+    // members point into alive.
+    CComPtr<IMetaDataImport> metadata_import;
+
+    // Fields and properties initialized without an object, in the
+    // order of the metadata.
+    std::vector<std::unique_ptr<DbgClassField>> fields;
+    std::vector<std::unique_ptr<DbgClassProperty>> properties;
+
+    // Format of the DebuggerDisplay attribute of the class, if it has a
+    // supported one.
+    std::shared_ptr<const DebuggerDisplayFormat> debugger_display;
+  };
+
+  // Key of a class layout. The metadata is the same for every generic
+  // instantiation of a class, so the type definition is enough.
+  typedef std::pair<IMetaDataImport *, mdTypeDef> ClassLayoutKey;
+
+  // Reads the fields and properties of this class from metadata_import
+  // into layout.
+  HRESULT BuildClassLayout(IMetaDataImport *metadata_import,
+                           ClassLayout *layout);
+
+  // Gets the layout of this class from the cache, building it if it is
+  // not there.
+  HRESULT GetClassLayout(IMetaDataImport *metadata_import,
+                         std::shared_ptr<const ClassLayout> *layout);
+
+  // Returns the memory used by layout and its entry in class_layouts_.
+  static std::size_t GetClassLayoutMemoryUsage(const ClassLayout &layout);
+
   // Processes the class fields and stores the fields in class_fields_.
   HRESULT ProcessFields(IMetaDataImport *metadata_import,
                         ICorDebugObjectValue *debug_obj_value,
@@ -226,6 +334,14 @@ class DbgClass : public DbgReferenceObject {
   std::vector<std::shared_ptr<IDbgClassMember>> class_fields_;
   std::vector<std::shared_ptr<IDbgClassMember>> class_properties_;
 
+  // Format of the DebuggerDisplay attribute of the class, from its layout.
+  std::shared_ptr<const DebuggerDisplayFormat> debugger_display_;
+
+  // String of debugger_display_ for this object, and whether
+  // PopulateMembers captured the object as it.
+  std::string debugger_display_value_;
+  bool captured_debugger_display_ = false;
+
   // Sets of all the fields' names.
   std::unordered_set<std::string> class_backing_fields_names_;
 
@@ -243,13 +359,33 @@ class DbgClass : public DbgReferenceObject {
   // ProcessClassMembers multiple times.
   bool processed_ = false;
 
-  // Cache of static class members.
+  // Cache of static class members, so that the objects of a class
+  // captured on a thread share the values of its static members.
+  // Every thread has its own cache because the members are not
+  // thread-safe and breakpoint hits of different threads are captured
+  // at the same time.
   // First key is the module name and class name.
   // Second key is the member name.
-  static std::unordered_map<
+  static thread_local std::unordered_map<
       std::string,
       std::unordered_map<std::string, std::shared_ptr<IDbgClassMember>>>
       static_class_members_;
+
+  // Memory of static_class_members_ of the calling thread, not counting
+  // the values of the members.
+  static thread_local ScopedMemoryCharge static_class_members_memory_;
+
+  // Cache of class layouts, which is kept across breakpoint hits.
+  // It is cleared once it has kMaximumCachedClassLayouts layouts.
+  static std::map<ClassLayoutKey, std::shared_ptr<const ClassLayout>>
+      class_layouts_;
+
+  // Protects class_layouts_, which objects captured on different threads
+  // share.
+  static std::mutex class_layouts_mutex_;
+
+  // Memory of class_layouts_. Protected by class_layouts_mutex_.
+  static ScopedMemoryCharge class_layouts_memory_;
 };
 
 }  //  namespace google_cloud_debugger
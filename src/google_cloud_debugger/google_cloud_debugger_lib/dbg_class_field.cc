@@ -24,6 +24,7 @@
 #include "i_cor_debug_helper.h"
 #include "i_dbg_object_factory.h"
 #include "i_eval_coordinator.h"
+#include "metadata_cache.h"
 #include "type_signature.h"
 
 using google::cloud::diagnostics::debug::Variable;
@@ -50,39 +51,67 @@ void DbgClassField::Initialize(ICorDebugModule *debug_module,
                                IMetaDataImport *metadata_import,
                                ICorDebugObjectValue *debug_obj_value,
                                ICorDebugClass *debug_class) {
-  if (metadata_import == nullptr) {
-    WriteError("MetaDataImport is null.");
-    initialized_hr_ = E_INVALIDARG;
-    return;
+  InitializeMetadata(debug_module, metadata_import);
+  if (SUCCEEDED(initialized_hr_)) {
+    initialized_hr_ = SetObject(debug_obj_value, debug_class);
   }
+}
 
-  CComPtr<ICorDebugValue> field_value;
-  ULONG len_field_name;
-
-  // First call to get length of array.
-  initialized_hr_ = metadata_import->GetFieldProps(
-      field_def_, &parent_token_, nullptr, 0, &len_field_name,
-      &member_attributes_, &signature_metadata_, &sig_metadata_length_,
-      &default_value_type_flags_, &default_value_, &default_value_len_);
+void DbgClassField::Initialize(
+    const DbgClassField &layout_field, ICorDebugObjectValue *debug_obj_value,
+    ICorDebugClass *debug_class,
+    std::shared_ptr<ObjectFieldsMemory> fields_memory) {
+  field_def_ = layout_field.field_def_;
+  parent_token_ = layout_field.parent_token_;
+  member_attributes_ = layout_field.member_attributes_;
+  signature_metadata_ = layout_field.signature_metadata_;
+  sig_metadata_length_ = layout_field.sig_metadata_length_;
+  default_value_type_flags_ = layout_field.default_value_type_flags_;
+  default_value_ = layout_field.default_value_;
+  default_value_len_ = layout_field.default_value_len_;
+  member_name_ = layout_field.member_name_;
+  is_backing_field_ = layout_field.is_backing_field_;
+  is_enum_ = layout_field.is_enum_;
+
+  // The value of a constant is the same for every object.
+  member_value_ = layout_field.member_value_;
+
+  initialized_hr_ = layout_field.initialized_hr_;
   if (FAILED(initialized_hr_)) {
-    WriteError("Failed to populate field metadata.");
+    WriteError(layout_field.GetErrorString());
     return;
   }
 
-  std::vector<WCHAR> wchar_field_name(len_field_name, 0);
+  initialized_hr_ = SetObject(debug_obj_value, debug_class);
+  if (SUCCEEDED(initialized_hr_) && debug_obj_value_) {
+    fields_memory_ = std::move(fields_memory);
+  }
+}
+
+void DbgClassField::InitializeMetadata(ICorDebugModule *debug_module,
+                                       IMetaDataImport *metadata_import) {
+  if (metadata_import == nullptr) {
+    WriteError("MetaDataImport is null.");
+    initialized_hr_ = E_INVALIDARG;
+    return;
+  }
 
-  // Second call to get the actual name.
-  initialized_hr_ = metadata_import->GetFieldProps(
-      field_def_, &parent_token_, wchar_field_name.data(), len_field_name,
-      &len_field_name, &member_attributes_, &signature_metadata_,
-      &sig_metadata_length_, &default_value_type_flags_, &default_value_,
-      &default_value_len_);
+  FieldProps field_props;
+  initialized_hr_ = MetadataCache::Global().GetFieldProps(
+      metadata_import, field_def_, true, &field_props);
   if (FAILED(initialized_hr_)) {
     WriteError("Failed to populate field metadata.");
     return;
   }
 
-  member_name_ = ConvertWCharPtrToString(wchar_field_name);
+  parent_token_ = field_props.class_token;
+  member_attributes_ = field_props.attributes;
+  signature_metadata_ = field_props.signature;
+  sig_metadata_length_ = field_props.signature_length;
+  default_value_type_flags_ = field_props.default_value_flags;
+  default_value_ = field_props.default_value;
+  default_value_len_ = field_props.default_value_length;
+  member_name_ = ConvertWCharPtrToString(field_props.name);
 
   // If field name is <MyProperty>k__BackingField, change it to
   // MyProperty because it is the backing field of a property.
@@ -102,49 +131,80 @@ void DbgClassField::Initialize(ICorDebugModule *debug_module,
   }
 
   // This will point to the value of the field if the field is const.
-  if (default_value_ && IsFdLiteral(member_attributes_)) {
+  if (IsConst()) {
     initialized_hr_ = ProcessConstField(debug_module, metadata_import);
     return;
   }
 
-  if (IsStatic()) {
-    initialized_hr_ = S_OK;
-    return;
+  initialized_hr_ = S_OK;
+}
+
+HRESULT DbgClassField::SetObject(ICorDebugObjectValue *debug_obj_value,
+                                 ICorDebugClass *debug_class) {
+  if (IsConst() || IsStatic()) {
+    return S_OK;
   }
 
   if (debug_obj_value == nullptr) {
     WriteError("ICorDebugObjectValue is null.");
-    initialized_hr_ = E_INVALIDARG;
-    return;
+    return E_INVALIDARG;
   }
 
   if (debug_class == nullptr) {
     WriteError("ICorDebugClass is null.");
-    initialized_hr_ = E_INVALIDARG;
-    return;
+    return E_INVALIDARG;
+  }
+
+  // The value is read when the field is evaluated, so that the fields
+  // of an object that are never captured cost no calls to the debuggee.
+  debug_obj_value_ = debug_obj_value;
+  debug_class_ = debug_class;
+  return S_OK;
+}
+
+HRESULT DbgClassField::ExtractFieldValue() {
+  if (FAILED(initialized_hr_) || !debug_obj_value_) {
+    return initialized_hr_;
+  }
+
+  if (fields_memory_) {
+    unique_ptr<DbgObject> member_value;
+    HRESULT hr =
+        fields_memory_->CreatePrimitiveField(field_def_, &member_value);
+    fields_memory_.reset();
+    if (hr == S_OK) {
+      debug_obj_value_.Release();
+      debug_class_.Release();
+      member_value_ = std::move(member_value);
+      initialized_hr_ = S_OK;
+      return initialized_hr_;
+    }
   }
 
+  CComPtr<ICorDebugValue> field_value;
   initialized_hr_ =
-      debug_obj_value->GetFieldValue(debug_class, field_def_, &field_value);
+      debug_obj_value_->GetFieldValue(debug_class_, field_def_, &field_value);
+  debug_obj_value_.Release();
+  debug_class_.Release();
   if (initialized_hr_ == CORDBG_E_FIELD_NOT_AVAILABLE) {
     WriteError("Field is optimized away");
-    return;
+    return initialized_hr_;
   }
 
   if (initialized_hr_ == CORDBG_E_CLASS_NOT_LOADED) {
     WriteError("Class of the field is not loaded.");
-    return;
+    return initialized_hr_;
   }
 
   if (initialized_hr_ == CORDBG_E_VARIABLE_IS_ACTUALLY_LITERAL) {
     WriteError(
         "Field is a literal. It is optimized away and is not available.");
-    return;
+    return initialized_hr_;
   }
 
   if (FAILED(initialized_hr_)) {
     WriteError("Failed to get field value.");
-    return;
+    return initialized_hr_;
   }
 
   unique_ptr<DbgObject> member_value;
@@ -159,6 +219,7 @@ void DbgClassField::Initialize(ICorDebugModule *debug_module,
   }
 
   member_value_ = std::move(member_value);
+  return initialized_hr_;
 }
 
 HRESULT DbgClassField::Evaluate(
@@ -172,7 +233,11 @@ HRESULT DbgClassField::Evaluate(
     return E_INVALIDARG;
   }
 
-  HRESULT hr;
+  HRESULT hr = ExtractFieldValue();
+  if (FAILED(hr)) {
+    return hr;
+  }
+
   if (IsStatic() && !member_value_) {
     hr = ExtractStaticFieldValue(eval_coordinator);
     if (FAILED(hr)) {
@@ -20,6 +20,7 @@
 
 #include "dbg_object.h"
 #include "i_dbg_class_member.h"
+#include "object_fields_memory.h"
 
 namespace google_cloud_debugger {
 
@@ -35,7 +36,9 @@ class DbgClassField : public IDbgClassMember {
                 std::shared_ptr<ICorDebugHelper> debug_helper,
                 std::shared_ptr<IDbgObjectFactory> obj_factory);
 
-  // Initialize the field names, metadata signature, flags and values.
+  // Initialize the field names, metadata signature, flags and the values
+  // of constant fields. The value of a non-static field is not read from
+  // the object until it is needed (see ExtractFieldValue).
   // HRESULT will be stored in initialized_hr_.
   // metadata_import is used to extract metadata from the field.
   // debug_obj_value represents the class object.
@@ -45,6 +48,22 @@ class DbgClassField : public IDbgClassMember {
                   ICorDebugObjectValue *debug_obj_value,
                   ICorDebugClass *debug_class);
 
+  // Initialize the field names, metadata signature, flags and the values
+  // of constant fields without an object. The field can then be used as
+  // the layout_field of the fields of the objects of the class.
+  // HRESULT will be stored in initialized_hr_.
+  void InitializeMetadata(ICorDebugModule *debug_module,
+                          IMetaDataImport *metadata_import);
+
+  // Same as Initialize but copies the metadata from layout_field, which
+  // was initialized with InitializeMetadata for the same field, instead
+  // of reading it again. If fields_memory is not null, the value of a
+  // primitive field is read from it instead of with GetFieldValue.
+  void Initialize(
+      const DbgClassField &layout_field, ICorDebugObjectValue *debug_obj_value,
+      ICorDebugClass *debug_class,
+      std::shared_ptr<ObjectFieldsMemory> fields_memory = nullptr);
+
   // Evaluates and sets member_value_ to the value of the field
   // that is represented by this class.
   // Reference_value and generic_types are ignored.
@@ -52,6 +71,15 @@ class DbgClassField : public IDbgClassMember {
                    IEvalCoordinator *eval_coordinator,
                    std::vector<CComPtr<ICorDebugType>> *generic_types) override;
 
+  // Reads the value of a non-static field from the object this field
+  // was initialized with and sets member_value_ to it, unless it has
+  // already been read. Does nothing for static and constant fields.
+  // The HRESULT is also stored in initialized_hr_.
+  HRESULT ExtractFieldValue();
+
+  // Returns the token of this field.
+  mdFieldDef GetFieldDef() const { return field_def_; }
+
   // Returns true if this is a backing field for a property.
   const bool IsBackingField() const { return is_backing_field_; }
 
@@ -71,6 +99,16 @@ class DbgClassField : public IDbgClassMember {
                                 const CorElementType &enum_type,
                                 ULONG64 enum_numerical_value);
 
+  // Returns true if the field is a constant with a default value.
+  bool IsConst() const {
+    return default_value_ && IsFdLiteral(member_attributes_);
+  }
+
+  // Sets the object and the class that the value of a non-static field
+  // is read from.
+  HRESULT SetObject(ICorDebugObjectValue *debug_obj_value,
+                    ICorDebugClass *debug_class);
+
   // Extracts out static field value (with name field_name_) using the
   // ICorDebugValue class_value that represents the class object (may be null
   // since this is a static field). Depth of the static field object will
@@ -88,6 +126,14 @@ class DbgClassField : public IDbgClassMember {
 
   // Debug type of the class that this field belongs to.
   CComPtr<ICorDebugType> class_type_;
+
+  // The object and the class that the value of a non-static field is
+  // read from. Released once the value is read.
+  CComPtr<ICorDebugObjectValue> debug_obj_value_;
+  CComPtr<ICorDebugClass> debug_class_;
+
+  // Memory of the object shared by the fields of the object.
+  std::shared_ptr<ObjectFieldsMemory> fields_memory_;
 };
 
 }  //  namespace google_cloud_debugger
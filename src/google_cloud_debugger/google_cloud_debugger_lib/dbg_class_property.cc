@@ -14,9 +14,12 @@
 
 #include "dbg_class_property.h"
 
+#include <algorithm>
 #include <condition_variable>
+#include <cstring>
 #include <iostream>
 #include <mutex>
+#include <sstream>
 
 #include "breakpoint.pb.h"
 #include "compiler_helpers.h"
@@ -30,6 +33,81 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+namespace {
+
+// Opcodes of the getters that only return a field or a constant.
+const std::uint8_t kNop = 0x00;
+const std::uint8_t kLdarg0 = 0x02;
+const std::uint8_t kStloc0 = 0x0A;
+const std::uint8_t kLdloc0 = 0x06;
+const std::uint8_t kLdcI4M1 = 0x15;
+const std::uint8_t kLdcI40 = 0x16;
+const std::uint8_t kLdcI48 = 0x1E;
+const std::uint8_t kLdcI4S = 0x1F;
+const std::uint8_t kLdcI4 = 0x20;
+const std::uint8_t kLdcI8 = 0x21;
+const std::uint8_t kLdcR4 = 0x22;
+const std::uint8_t kLdcR8 = 0x23;
+const std::uint8_t kBrS = 0x2B;
+const std::uint8_t kRet = 0x2A;
+const std::uint8_t kConvI8 = 0x6A;
+const std::uint8_t kConvU8 = 0x6E;
+const std::uint8_t kLdstr = 0x72;
+const std::uint8_t kLdfld = 0x7B;
+
+// Getters longer than this do more than return a field or a constant.
+const ULONG32 kMaxGetterFieldILSize = 16;
+
+// Returns the index of the first instruction of il that is not a nop.
+std::size_t SkipNops(const vector<std::uint8_t> &il) {
+  std::size_t i = 0;
+  while (i < il.size() && il[i] == kNop) {
+    ++i;
+  }
+  return i;
+}
+
+// Returns the size bytes of il at index i as a little-endian number.
+std::uint64_t ReadLittleEndian(const vector<std::uint8_t> &il, std::size_t i,
+                               std::size_t size) {
+  std::uint64_t value = 0;
+  for (std::size_t byte = 0; byte < size; ++byte) {
+    value |= static_cast<std::uint64_t>(il[i + byte]) << (8 * byte);
+  }
+  return value;
+}
+
+// Returns true if the instructions of il from index i only return the
+// value on the stack.
+bool ReturnsAt(const vector<std::uint8_t> &il, std::size_t i) {
+  // Debug builds store the value in a local and branch to the return:
+  // stloc.0, br.s 0, ldloc.0.
+  const std::uint8_t kStoreAndLoad[] = {kStloc0, kBrS, 0x00, kLdloc0};
+  if (il.size() >= i + sizeof(kStoreAndLoad) &&
+      std::equal(kStoreAndLoad, kStoreAndLoad + sizeof(kStoreAndLoad),
+                 il.begin() + i)) {
+    i += sizeof(kStoreAndLoad);
+  }
+
+  return il.size() == i + 1 && il[i] == kRet;
+}
+
+// Creates the object of type, which T holds, with value.
+template <typename T>
+HRESULT CreateLiteral(IDbgObjectFactory *obj_factory, CorElementType type,
+                      T value, std::unique_ptr<DbgObject> *dbg_object) {
+  ULONG64 numerical_value = 0;
+  return obj_factory->CreateDbgObjectFromLiteralConst(
+      type, &value, 0, &numerical_value, dbg_object);
+}
+
+}  // namespace
+
+std::map<DbgClassProperty::GetterFieldKey, DbgClassProperty::GetterField>
+    DbgClassProperty::getter_fields_;
+
+std::mutex DbgClassProperty::getter_fields_mutex_;
+
 void DbgClassProperty::Initialize(mdProperty property_def,
                                   IMetaDataImport *metadata_import,
                                   ICorDebugModule *debug_module,
@@ -77,6 +155,31 @@ void DbgClassProperty::Initialize(mdProperty property_def,
   debug_module_ = debug_module;
 }
 
+void DbgClassProperty::Initialize(const DbgClassProperty &layout_property,
+                                  ICorDebugModule *debug_module,
+                                  int creation_depth) {
+  property_def_ = layout_property.property_def_;
+  parent_token_ = layout_property.parent_token_;
+  member_attributes_ = layout_property.member_attributes_;
+  signature_metadata_ = layout_property.signature_metadata_;
+  sig_metadata_length_ = layout_property.sig_metadata_length_;
+  default_value_type_flags_ = layout_property.default_value_type_flags_;
+  default_value_ = layout_property.default_value_;
+  default_value_len_ = layout_property.default_value_len_;
+  property_getter_function = layout_property.property_getter_function;
+  property_setter_function = layout_property.property_setter_function;
+  other_methods_ = layout_property.other_methods_;
+  member_name_ = layout_property.member_name_;
+
+  initialized_hr_ = layout_property.initialized_hr_;
+  if (FAILED(initialized_hr_)) {
+    WriteError(layout_property.GetErrorString());
+  }
+
+  creation_depth_ = creation_depth;
+  debug_module_ = debug_module;
+}
+
 HRESULT DbgClassProperty::Evaluate(
     ICorDebugValue *debug_value, IEvalCoordinator *eval_coordinator,
     vector<CComPtr<ICorDebugType>> *generic_types) {
@@ -109,6 +212,15 @@ HRESULT DbgClassProperty::Evaluate(
     return E_FAIL;
   }
 
+  // The same property of the same object may be read by the condition,
+  // the expressions and the variables of the breakpoints at a location.
+  bool memoize = !IsStatic() && object_address_ != 0;
+  if (memoize &&
+      eval_coordinator->GetCachedPropertyValue(
+          object_address_, debug_module_, property_def_, &member_value_)) {
+    return S_OK;
+  }
+
   hr = debug_module_->GetFunctionFromToken(property_getter_function,
                                            &debug_function);
   if (FAILED(hr)) {
@@ -116,7 +228,25 @@ HRESULT DbgClassProperty::Evaluate(
     return hr;
   }
 
+  // A getter that only returns a constant or a field, like the one of a
+  // property with a backing field that is not named after it, is not
+  // evaluated.
+  std::unique_ptr<DbgObject> emulated_value;
+  if (EmulateGetter(debug_function, debug_value, &emulated_value) == S_OK) {
+    member_value_ = std::move(emulated_value);
+    if (memoize) {
+      eval_coordinator->CachePropertyValue(object_address_, debug_module_,
+                                           property_def_, member_value_);
+    }
+    return S_OK;
+  }
+
   hr = eval_coordinator->CreateEval(&debug_eval);
+  if (hr == E_ABORT) {
+    WriteError("Evaluation budget of the breakpoint is used up.");
+    return hr;
+  }
+
   if (FAILED(hr)) {
     WriteError("Failed to create ICorDebugEval.");
     return hr;
@@ -150,9 +280,346 @@ HRESULT DbgClassProperty::Evaluate(
   }
 
   member_value_ = std::move(member_value);
+  if (memoize) {
+    eval_coordinator->CachePropertyValue(object_address_, debug_module_,
+                                         property_def_, member_value_);
+  }
   return S_OK;
 }
 
+mdFieldDef DbgClassProperty::GetReturnedField(
+    const vector<std::uint8_t> &il) {
+  std::size_t i = SkipNops(il);
+
+  // ldarg.0, ldfld <field>.
+  if (il.size() < i + 6 || il[i] != kLdarg0 || il[i + 1] != kLdfld) {
+    return 0;
+  }
+
+  mdToken field_token = il[i + 2] | (il[i + 3] << 8) | (il[i + 4] << 16) |
+                        (static_cast<mdToken>(il[i + 5]) << 24);
+  if (TypeFromToken(field_token) != mdtFieldDef) {
+    return 0;
+  }
+  i += 6;
+
+  if (!ReturnsAt(il, i)) {
+    return 0;
+  }
+  return field_token;
+}
+
+bool DbgClassProperty::GetReturnedConstant(const vector<std::uint8_t> &il,
+                                           ILConstant *constant) {
+  std::size_t i = SkipNops(il);
+  if (i >= il.size()) {
+    return false;
+  }
+
+  ILConstant result;
+  std::uint8_t opcode = il[i++];
+  if (opcode >= kLdcI4M1 && opcode <= kLdcI48) {
+    result.type = ELEMENT_TYPE_I4;
+    result.integer = static_cast<int>(opcode) - kLdcI40;
+  } else if (opcode == kLdcI4S && il.size() >= i + 1) {
+    result.type = ELEMENT_TYPE_I4;
+    result.integer = static_cast<std::int8_t>(il[i]);
+    i += 1;
+  } else if (opcode == kLdcI4 && il.size() >= i + 4) {
+    result.type = ELEMENT_TYPE_I4;
+    result.integer = static_cast<std::int32_t>(ReadLittleEndian(il, i, 4));
+    i += 4;
+  } else if (opcode == kLdcI8 && il.size() >= i + 8) {
+    result.type = ELEMENT_TYPE_I8;
+    result.integer = static_cast<std::int64_t>(ReadLittleEndian(il, i, 8));
+    i += 8;
+  } else if (opcode == kLdcR4 && il.size() >= i + 4) {
+    std::uint32_t bits = static_cast<std::uint32_t>(ReadLittleEndian(il, i, 4));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    result.type = ELEMENT_TYPE_R4;
+    result.real = value;
+    i += 4;
+  } else if (opcode == kLdcR8 && il.size() >= i + 8) {
+    std::uint64_t bits = ReadLittleEndian(il, i, 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    result.type = ELEMENT_TYPE_R8;
+    result.real = value;
+    i += 8;
+  } else if (opcode == kLdstr && il.size() >= i + 4) {
+    result.type = ELEMENT_TYPE_STRING;
+    result.string_token = static_cast<mdString>(ReadLittleEndian(il, i, 4));
+    if (TypeFromToken(result.string_token) != mdtString) {
+      return false;
+    }
+    i += 4;
+  } else {
+    return false;
+  }
+
+  // The getter of a long property returns a small constant as ldc.i4
+  // followed by conv.i8, or conv.u8 for an unsigned one.
+  if (result.type == ELEMENT_TYPE_I4 && i < il.size() &&
+      (il[i] == kConvI8 || il[i] == kConvU8)) {
+    if (il[i] == kConvU8) {
+      result.integer = static_cast<std::uint32_t>(result.integer);
+    }
+    result.type = ELEMENT_TYPE_I8;
+    i += 1;
+  }
+
+  if (!ReturnsAt(il, i)) {
+    return false;
+  }
+  *constant = result;
+  return true;
+}
+
+void DbgClassProperty::RemoveGetterFields(IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(getter_fields_mutex_);
+  auto getter = getter_fields_.lower_bound(GetterFieldKey(metadata_import, 0));
+  while (getter != getter_fields_.end() &&
+         getter->first.first == metadata_import) {
+    getter = getter_fields_.erase(getter);
+  }
+}
+
+HRESULT DbgClassProperty::EmulateGetter(
+    ICorDebugFunction *debug_function, ICorDebugValue *debug_value,
+    std::unique_ptr<DbgObject> *member_value) {
+  // Errors only make the getter evaluated, so they are not written.
+  std::ostringstream err_stream;
+  CComPtr<IMetaDataImport> metadata_import;
+  HRESULT hr = debug_helper_->GetMetadataImportFromICorDebugModule(
+      debug_module_, &metadata_import, &err_stream);
+  if (FAILED(hr) || !metadata_import) {
+    return FAILED(hr) ? hr : E_FAIL;
+  }
+
+  GetterField getter_field;
+  hr = GetGetterField(debug_function, metadata_import, &getter_field);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (getter_field.constant.type != ELEMENT_TYPE_END) {
+    return CreateConstantValue(getter_field.constant, metadata_import,
+                               member_value);
+  }
+
+  mdFieldDef field_def = getter_field.field_def;
+  if (field_def == 0 || IsStatic() || !debug_value) {
+    return S_FALSE;
+  }
+
+  // The field may be declared in a base class of the property's class.
+  mdTypeDef field_class_token = 0;
+  hr = metadata_import->GetFieldProps(field_def, &field_class_token, nullptr,
+                                      0, nullptr, nullptr, nullptr, nullptr,
+                                      nullptr, nullptr, nullptr);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  CComPtr<ICorDebugClass> debug_class;
+  hr = debug_module_->GetClassFromToken(field_class_token, &debug_class);
+  if (FAILED(hr) || !debug_class) {
+    return FAILED(hr) ? hr : E_FAIL;
+  }
+
+  BOOL is_null = FALSE;
+  CComPtr<ICorDebugValue> dereferenced_value;
+  hr = debug_helper_->DereferenceAndUnbox(debug_value, &dereferenced_value,
+                                          &is_null, &err_stream);
+  if (FAILED(hr) || is_null || !dereferenced_value) {
+    return FAILED(hr) ? hr : S_FALSE;
+  }
+
+  CComPtr<ICorDebugObjectValue> object_value;
+  hr = dereferenced_value->QueryInterface(
+      __uuidof(ICorDebugObjectValue), reinterpret_cast<void **>(&object_value));
+  if (FAILED(hr) || !object_value) {
+    return FAILED(hr) ? hr : E_FAIL;
+  }
+
+  CComPtr<ICorDebugValue> field_value;
+  hr = object_value->GetFieldValue(debug_class, field_def, &field_value);
+  if (FAILED(hr) || !field_value) {
+    return FAILED(hr) ? hr : E_FAIL;
+  }
+
+  return obj_factory_->CreateDbgObject(field_value, creation_depth_,
+                                       member_value, &err_stream);
+}
+
+HRESULT DbgClassProperty::CreateConstantValue(
+    const ILConstant &constant, IMetaDataImport *metadata_import,
+    std::unique_ptr<DbgObject> *member_value) {
+  // The signature of a property without parameters is its calling
+  // convention, 0 parameters and the type.
+  if (sig_metadata_length_ < 3 || signature_metadata_[1] != 0) {
+    return S_FALSE;
+  }
+
+  IDbgObjectFactory *factory = obj_factory_.get();
+  CorElementType type = static_cast<CorElementType>(signature_metadata_[2]);
+  std::int64_t integer = constant.integer;
+  if (constant.type == ELEMENT_TYPE_I4) {
+    // The runtime truncates the int32 on the stack to the return type.
+    switch (type) {
+      case ELEMENT_TYPE_BOOLEAN:
+        return CreateLiteral<bool>(factory, type,
+                                   static_cast<std::uint8_t>(integer) != 0,
+                                   member_value);
+      case ELEMENT_TYPE_CHAR:
+        return CreateLiteral<char>(factory, type, static_cast<char>(integer),
+                                   member_value);
+      case ELEMENT_TYPE_I1:
+        return CreateLiteral<std::int8_t>(
+            factory, type, static_cast<std::int8_t>(integer), member_value);
+      case ELEMENT_TYPE_U1:
+        return CreateLiteral<std::uint8_t>(
+            factory, type, static_cast<std::uint8_t>(integer), member_value);
+      case ELEMENT_TYPE_I2:
+        return CreateLiteral<std::int16_t>(
+            factory, type, static_cast<std::int16_t>(integer), member_value);
+      case ELEMENT_TYPE_U2:
+        return CreateLiteral<std::uint16_t>(
+            factory, type, static_cast<std::uint16_t>(integer), member_value);
+      case ELEMENT_TYPE_I4:
+        return CreateLiteral<std::int32_t>(
+            factory, type, static_cast<std::int32_t>(integer), member_value);
+      case ELEMENT_TYPE_U4:
+        return CreateLiteral<std::uint32_t>(
+            factory, type, static_cast<std::uint32_t>(integer), member_value);
+      default:
+        return S_FALSE;
+    }
+  }
+
+  if (constant.type == ELEMENT_TYPE_I8 && type == ELEMENT_TYPE_I8) {
+    return CreateLiteral<std::int64_t>(factory, type, integer, member_value);
+  }
+  if (constant.type == ELEMENT_TYPE_I8 && type == ELEMENT_TYPE_U8) {
+    return CreateLiteral<std::uint64_t>(
+        factory, type, static_cast<std::uint64_t>(integer), member_value);
+  }
+  if (constant.type == ELEMENT_TYPE_R4 && type == ELEMENT_TYPE_R4) {
+    return CreateLiteral<float>(factory, type,
+                                static_cast<float>(constant.real),
+                                member_value);
+  }
+  if (constant.type == ELEMENT_TYPE_R8 && type == ELEMENT_TYPE_R8) {
+    return CreateLiteral<double>(factory, type, constant.real, member_value);
+  }
+
+  if (constant.type != ELEMENT_TYPE_STRING || type != ELEMENT_TYPE_STRING) {
+    return S_FALSE;
+  }
+
+  ULONG string_length = 0;
+  HRESULT hr = metadata_import->GetUserString(constant.string_token, nullptr,
+                                              0, &string_length);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  vector<WCHAR> chars(string_length + 1, 0);
+  hr = metadata_import->GetUserString(constant.string_token, chars.data(),
+                                      chars.size(), &string_length);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  ULONG64 numerical_value = 0;
+  return factory->CreateDbgObjectFromLiteralConst(
+      ELEMENT_TYPE_STRING, chars.data(),
+      std::min<ULONG>(string_length, chars.size()), &numerical_value,
+      member_value);
+}
+
+HRESULT DbgClassProperty::GetGetterField(ICorDebugFunction *debug_function,
+                                         IMetaDataImport *metadata_import,
+                                         GetterField *getter_field) {
+  GetterFieldKey key(metadata_import, property_getter_function);
+  {
+    std::lock_guard<std::mutex> lock(getter_fields_mutex_);
+    auto cached = getter_fields_.find(key);
+    if (cached != getter_fields_.end()) {
+      *getter_field = cached->second;
+      return S_OK;
+    }
+  }
+
+  CComPtr<ICorDebugCode> debug_code;
+  HRESULT hr = debug_function->GetILCode(&debug_code);
+  if (FAILED(hr) || !debug_code) {
+    return FAILED(hr) ? hr : E_FAIL;
+  }
+
+  ULONG32 code_size = 0;
+  hr = debug_code->GetSize(&code_size);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  GetterField read_getter;
+  read_getter.metadata_import = metadata_import;
+  if (code_size <= kMaxGetterFieldILSize) {
+    vector<std::uint8_t> il(code_size, 0);
+    ULONG32 read_size = 0;
+    hr = debug_code->GetCode(0, code_size, code_size, il.data(), &read_size);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    il.resize(read_size);
+    read_getter.field_def = GetReturnedField(il);
+    if (read_getter.field_def != 0 &&
+        !HasPropertyType(metadata_import, read_getter.field_def)) {
+      read_getter.field_def = 0;
+    }
+    if (read_getter.field_def == 0) {
+      GetReturnedConstant(il, &read_getter.constant);
+    }
+  }
+
+  *getter_field = read_getter;
+  std::lock_guard<std::mutex> lock(getter_fields_mutex_);
+  if (getter_fields_.size() >= kMaximumCachedPropertyGetters) {
+    getter_fields_.clear();
+  }
+  getter_fields_[key] = read_getter;
+  return S_OK;
+}
+
+bool DbgClassProperty::HasPropertyType(IMetaDataImport *metadata_import,
+                                       mdFieldDef field_def) {
+  PCCOR_SIGNATURE field_signature = nullptr;
+  ULONG field_signature_length = 0;
+  DWORD field_attributes = 0;
+  HRESULT hr = metadata_import->GetFieldProps(
+      field_def, nullptr, nullptr, 0, nullptr, &field_attributes,
+      &field_signature, &field_signature_length, nullptr, nullptr, nullptr);
+  if (FAILED(hr) || IsFdStatic(field_attributes) ||
+      field_signature_length < 2 || sig_metadata_length_ < 3) {
+    return false;
+  }
+
+  // A field signature is its calling convention followed by the type,
+  // and the signature of a property without parameters is its calling
+  // convention, 0 parameters and the type. The stack widens a field
+  // like a short returned as an int, so the types have to be the same.
+  if (signature_metadata_[1] != 0) {
+    return false;
+  }
+  return field_signature_length - 1 == sig_metadata_length_ - 2 &&
+         std::equal(field_signature + 1,
+                    field_signature + field_signature_length,
+                    signature_metadata_ + 2);
+}
+
 HRESULT DbgClassProperty::SetTypeSignature(
     IMetaDataImport *metadata_import,
     const std::vector<TypeSignature> &generic_class_types) {
@@ -15,7 +15,11 @@
 #ifndef DBG_CLASS_PROPERTY_H_
 #define DBG_CLASS_PROPERTY_H_
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include "dbg_object.h"
@@ -43,6 +47,12 @@ class DbgClassProperty : public IDbgClassMember {
   void Initialize(mdProperty property_def, IMetaDataImport *metadata_import,
                   ICorDebugModule *debug_module, int creation_depth);
 
+  // Same as Initialize but copies the metadata from layout_property,
+  // which was initialized for the same property of another object of
+  // the class, instead of reading it again.
+  void Initialize(const DbgClassProperty &layout_property,
+                  ICorDebugModule *debug_module, int creation_depth);
+
   // Evaluates the property and stores the value in member_value_.
   // reference_value is a reference to the class object that this property
   // belongs to. eval_coordinator is needed to perform the function
@@ -54,6 +64,13 @@ class DbgClassProperty : public IDbgClassMember {
                    IEvalCoordinator *eval_coordinator,
                    std::vector<CComPtr<ICorDebugType>> *generic_types) override;
 
+  // Sets the address of the object this property belongs to. The value
+  // of a non-static property is only evaluated once per breakpoint hit
+  // for the object at a non-zero address.
+  void SetObjectAddress(CORDB_ADDRESS object_address) {
+    object_address_ = object_address;
+  }
+
   // Sets the TypeSignature of the property.
   HRESULT SetTypeSignature(
       IMetaDataImport *metadata_import,
@@ -69,6 +86,39 @@ class DbgClassProperty : public IDbgClassMember {
   // Will fail if this is not set.
   HRESULT GetTypeSignature(TypeSignature *type_signature);
 
+  // Returns the field that a getter whose IL is il returns, as in
+  // "get { return _field; }" or "=> _field", or 0 if it does anything
+  // else. The field is only a FieldDef, not a MemberRef of a generic
+  // class.
+  static mdFieldDef GetReturnedField(const std::vector<std::uint8_t> &il);
+
+  // A constant loaded by the IL of a getter.
+  struct ILConstant {
+    // The type the constant has on the evaluation stack: ELEMENT_TYPE_I4,
+    // ELEMENT_TYPE_I8, ELEMENT_TYPE_R4, ELEMENT_TYPE_R8 or
+    // ELEMENT_TYPE_STRING, or ELEMENT_TYPE_END if there is no constant.
+    CorElementType type = ELEMENT_TYPE_END;
+
+    // The value of an integer constant.
+    std::int64_t integer = 0;
+
+    // The value of a floating point constant.
+    double real = 0;
+
+    // The user string of a string constant.
+    mdString string_token = 0;
+  };
+
+  // Returns true and sets constant to the constant that a getter whose
+  // IL is il returns, as in "get { return 5; }" or "=> 1.5", or
+  // returns false if it does anything else.
+  static bool GetReturnedConstant(const std::vector<std::uint8_t> &il,
+                                  ILConstant *constant);
+
+  // Removes the cached getters of the module whose metadata is
+  // metadata_import, which is unloaded.
+  static void RemoveGetterFields(IMetaDataImport *metadata_import);
+
   // Returns true if the property is static.
   // If the property is static, the signature metadata won't have the bit
   // corresponding to IMAGE_CEE_CS_CALLCONV_HASTHIS at the start.
@@ -78,6 +128,52 @@ class DbgClassProperty : public IDbgClassMember {
   }
 
  private:
+  // The field or constant a getter returns. Neither is set if the
+  // getter has to be evaluated.
+  struct GetterField {
+    // Keeps the key of the getter from being reused by another module.
+    CComPtr<IMetaDataImport> metadata_import;
+
+    mdFieldDef field_def = 0;
+
+    ILConstant constant;
+  };
+
+  // Emulates the getter of this property instead of evaluating it if it
+  // only returns a constant, or if the property is not static and its
+  // getter only returns a field of the object debug_value. Returns
+  // S_FALSE if the getter does more.
+  HRESULT EmulateGetter(ICorDebugFunction *debug_function,
+                        ICorDebugValue *debug_value,
+                        std::unique_ptr<DbgObject> *member_value);
+
+  // Creates the value of this property from constant, converted to the
+  // type of the property as the getter does when it returns it. Returns
+  // S_FALSE if the constant cannot have the type of the property.
+  HRESULT CreateConstantValue(const ILConstant &constant,
+                              IMetaDataImport *metadata_import,
+                              std::unique_ptr<DbgObject> *member_value);
+
+  // Gets the field or constant the getter of this property returns. The
+  // getters of each module are only read once.
+  HRESULT GetGetterField(ICorDebugFunction *debug_function,
+                         IMetaDataImport *metadata_import,
+                         GetterField *getter_field);
+
+  // Returns true if field_def has the type of the property.
+  bool HasPropertyType(IMetaDataImport *metadata_import,
+                       mdFieldDef field_def);
+
+  // Key to getter_fields_: the metadata of the module of a getter and
+  // the token of the getter.
+  typedef std::pair<IMetaDataImport *, mdMethodDef> GetterFieldKey;
+
+  // The fields and constants that the getters read so far return.
+  static std::map<GetterFieldKey, GetterField> getter_fields_;
+
+  // Protects getter_fields_.
+  static std::mutex getter_fields_mutex_;
+
   // The token that represents the property getter.
   mdMethodDef property_getter_function = 0;
 
@@ -98,6 +194,9 @@ class DbgClassProperty : public IDbgClassMember {
 
   // The ICorDebugModule this property is in.
   CComPtr<ICorDebugModule> debug_module_;
+
+  // The address of the object this property belongs to, or 0 if unknown.
+  CORDB_ADDRESS object_address_ = 0;
 };
 
 }  //  namespace google_cloud_debugger
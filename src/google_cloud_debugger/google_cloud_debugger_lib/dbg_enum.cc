@@ -14,22 +14,30 @@
 
 #include "dbg_enum.h"
 
+#include <algorithm>
+
 #include "class_names.h"
+#include "constants.h"
+#include "dbg_class_field.h"
 #include "i_eval_coordinator.h"
+#include "number_format.h"
 
 using google::cloud::diagnostics::debug::Variable;
 using std::array;
 using std::char_traits;
 using std::min;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
 namespace google_cloud_debugger {
 
 const string DbgEnum::kEnumValue = "value__";
-std::unordered_map<std::string,
-                   std::vector<std::tuple<UVCP_CONSTANT, std::string>>>
-    DbgEnum::enum_values_dict;
+
+std::map<DbgEnum::EnumLayoutKey, std::shared_ptr<const DbgEnum::EnumLayout>>
+    DbgEnum::enum_layouts_;
+
+std::mutex DbgEnum::enum_layouts_mutex_;
 
 HRESULT DbgEnum::PopulateValue(Variable *variable) {
   if (!variable) {
@@ -54,44 +62,12 @@ HRESULT DbgEnum::PopulateValue(Variable *variable) {
     return E_FAIL;
   }
 
-  if (enum_values_dict.find(class_name_) == enum_values_dict.end()) {
+  if (!enum_layout_) {
     WriteError("Cannot find enum " + class_name_);
     return E_FAIL;
   }
 
-  // This mutable enum value may be zeroed out during the loop.
-  ULONG64 mutable_enum_value = enum_value_;
-  for (auto &&enum_value_tuple : enum_values_dict[class_name_]) {
-    UVCP_CONSTANT raw_default_value = std::get<0>(enum_value_tuple);
-    ULONG64 const_value =
-        ExtractEnumValue(enum_type_, (void *)raw_default_value);
-
-    // If the original_enum_value matches the const_value exactly,
-    // uses that instead of the "|" string.
-    if (enum_value_ == const_value) {
-      enum_string_ = std::get<1>(enum_value_tuple);
-      break;
-    }
-
-    // If mutable_enum_value is different from const_value, but const_value
-    // corresponds to bits in mutable_enum_value, then this const_value string
-    // is part of the mutable_enum_value string representation.
-    if (mutable_enum_value != const_value &&
-        (const_value == 0 ||
-         (const_value & mutable_enum_value) != const_value)) {
-      continue;
-    }
-
-    // Zero out the bits of const_value in enum_value;
-    mutable_enum_value = mutable_enum_value & (~const_value);
-
-    if (enum_string_.empty()) {
-      enum_string_.append(std::get<1>(enum_value_tuple));
-    } else {
-      enum_string_.append(" | " + std::get<1>(enum_value_tuple));
-    }
-  }
-
+  enum_string_ = GetValueName(*enum_layout_, enum_value_);
   variable->set_value(enum_string_);
   return S_OK;
 }
@@ -131,55 +107,167 @@ HRESULT DbgEnum::ProcessEnum(ICorDebugValue *debug_value,
 
   // Sets the underlying enum type.
   // This is from the non-static field __value.
-  for (auto &class_field : class_fields_) {
-    if (!class_field || class_field->IsStatic()) {
-      continue;
+  enum_type_ = enum_layout_->enum_type;
+  if (enum_type_ == CorElementType::ELEMENT_TYPE_END) {
+    initialize_hr_ = E_FAIL;
+  }
+
+  enum_value_ = ExtractEnumValue(enum_type_, enum_value_array_.data());
+
+  return S_OK;
+}
+
+HRESULT DbgEnum::ProcessEnumFields(IMetaDataImport *metadata_import) {
+  HRESULT hr = GetEnumLayout(metadata_import, &enum_layout_);
+  if (FAILED(hr)) {
+    WriteError("Failed to process enum fields.");
+    return hr;
+  }
+  return S_OK;
+}
+
+HRESULT DbgEnum::BuildEnumLayout(IMetaDataImport *metadata_import,
+                                 EnumLayout *layout) {
+  shared_ptr<const ClassLayout> class_layout;
+  HRESULT hr = GetClassLayout(metadata_import, &class_layout);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  for (const auto &class_field : class_layout->fields) {
+    if (!class_field->IsStatic() &&
+        kEnumValue.compare(class_field->GetMemberName()) == 0) {
+      PCCOR_SIGNATURE field_signature = class_field->GetSignature();
+      layout->enum_type = CorSigUncompressElementType(field_signature);
+      break;
     }
+  }
 
-    if (kEnumValue.compare(class_field->GetMemberName()) != 0) {
+  // The values of the constants are only read once the type is known.
+  layout->values.reserve(class_layout->fields.size());
+  for (const auto &class_field : class_layout->fields) {
+    UVCP_CONSTANT raw_default_value = class_field->GetDefaultValue();
+    if (!class_field->IsStatic() || !raw_default_value) {
       continue;
     }
 
-    PCCOR_SIGNATURE field_signature = class_field->GetSignature();
-    enum_type_ = CorSigUncompressElementType(field_signature);
-    break;
+    ULONG64 value =
+        ExtractEnumValue(layout->enum_type, (void *)raw_default_value);
+    layout->values.push_back(
+        std::make_pair(value, class_field->GetMemberName()));
   }
 
-  if (enum_type_ == CorElementType::ELEMENT_TYPE_END) {
-    initialize_hr_ = E_FAIL;
+  layout->sorted_values.reserve(layout->values.size());
+  for (std::size_t i = 0; i < layout->values.size(); ++i) {
+    layout->sorted_values.push_back(
+        std::make_pair(layout->values[i].first, i));
+    if (layout->values[i].first == 0) {
+      layout->zero_values_end = i + 1;
+    }
   }
+  std::sort(layout->sorted_values.begin(), layout->sorted_values.end());
 
-  enum_value_ = ExtractEnumValue(enum_type_, enum_value_array_.data());
-
+  layout->metadata_import = metadata_import;
   return S_OK;
 }
 
-HRESULT DbgEnum::ProcessEnumFields(IMetaDataImport *metadata_import) {
-  HRESULT hr = ProcessFields(metadata_import, nullptr, nullptr);
+HRESULT DbgEnum::GetEnumLayout(IMetaDataImport *metadata_import,
+                               shared_ptr<const EnumLayout> *layout) {
+  // The layout holds a reference to metadata_import, so the pointer
+  // cannot be reused by another module while the layout is cached.
+  EnumLayoutKey key(metadata_import, class_token_);
+  {
+    std::lock_guard<std::mutex> lock(enum_layouts_mutex_);
+    auto cached_layout = enum_layouts_.find(key);
+    if (cached_layout != enum_layouts_.end()) {
+      *layout = cached_layout->second;
+      return S_OK;
+    }
+  }
+
+  shared_ptr<EnumLayout> new_layout(new (std::nothrow) EnumLayout());
+  if (!new_layout) {
+    WriteError("Ran out of memory while trying to create enum layout.");
+    return E_OUTOFMEMORY;
+  }
+
+  HRESULT hr = BuildEnumLayout(metadata_import, new_layout.get());
   if (FAILED(hr)) {
-    WriteError("Failed to process enum fields.");
     return hr;
   }
 
-  AddEnumValuesToDict();
+  std::lock_guard<std::mutex> lock(enum_layouts_mutex_);
+  if (enum_layouts_.size() >= kMaximumCachedClassLayouts) {
+    enum_layouts_.clear();
+  }
+  enum_layouts_[key] = new_layout;
+  *layout = std::move(new_layout);
   return S_OK;
 }
 
-void DbgEnum::AddEnumValuesToDict() {
-  if (enum_values_dict.find(class_name_) == enum_values_dict.end()) {
-    std::vector<std::tuple<UVCP_CONSTANT, std::string>> enum_values;
-    for (auto &class_field : class_fields_) {
-      if (!class_field || !class_field->IsStatic()) {
-        continue;
-      }
-
-      UVCP_CONSTANT raw_default_value = class_field->GetDefaultValue();
-      std::string value_name = class_field->GetMemberName();
-      enum_values.push_back(std::make_tuple<UVCP_CONSTANT, std::string>(
-          std::move(raw_default_value), std::move(value_name)));
+void DbgEnum::RemoveEnumLayouts(IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(enum_layouts_mutex_);
+  auto layout = enum_layouts_.lower_bound(EnumLayoutKey(metadata_import, 0));
+  while (layout != enum_layouts_.end() &&
+         layout->first.first == metadata_import) {
+    layout = enum_layouts_.erase(layout);
+  }
+}
+
+string DbgEnum::GetValueName(const EnumLayout &layout, ULONG64 value) {
+  // A value with a name of its own uses it instead of the "|" string.
+  auto named_value = std::lower_bound(
+      layout.sorted_values.begin(), layout.sorted_values.end(),
+      std::make_pair(value, static_cast<std::size_t>(0)));
+  if (named_value != layout.sorted_values.end() &&
+      named_value->first == value) {
+    return layout.values[named_value->second].second;
+  }
+
+  // This mutable enum value is zeroed out during the loop.
+  string name;
+  ULONG64 mutable_enum_value = value;
+  for (std::size_t i = 0; i < layout.values.size(); ++i) {
+    if (mutable_enum_value == 0 && i >= layout.zero_values_end) {
+      break;
+    }
+
+    // If mutable_enum_value is different from const_value, but const_value
+    // corresponds to bits in mutable_enum_value, then this const_value string
+    // is part of the mutable_enum_value string representation.
+    ULONG64 const_value = layout.values[i].first;
+    if (mutable_enum_value != const_value &&
+        (const_value == 0 ||
+         (const_value & mutable_enum_value) != const_value)) {
+      continue;
+    }
+
+    // Zero out the bits of const_value in enum_value;
+    mutable_enum_value = mutable_enum_value & (~const_value);
+
+    if (name.empty()) {
+      name.append(layout.values[i].second);
+    } else {
+      name.append(" | " + layout.values[i].second);
+    }
+  }
+
+  // A value that no name covers is printed as a number.
+  if (name.empty()) {
+    switch (layout.enum_type) {
+      case ELEMENT_TYPE_I:
+      case ELEMENT_TYPE_CHAR:
+      case ELEMENT_TYPE_I1:
+      case ELEMENT_TYPE_I2:
+      case ELEMENT_TYPE_I4:
+      case ELEMENT_TYPE_I8:
+        AssignNumber(static_cast<std::int64_t>(value), &name);
+        break;
+      default:
+        AssignNumber(value, &name);
     }
-    enum_values_dict[class_name_] = std::move(enum_values);
   }
+  return name;
 }
 
 ULONG64 DbgEnum::ExtractEnumValue(CorElementType enum_type, void *enum_value) {
@@ -15,9 +15,12 @@
 #ifndef DBG_ENUM_H_
 #define DBG_ENUM_H_
 
+#include <cstddef>
+#include <map>
 #include <memory>
-#include <tuple>
-#include <unordered_map>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "dbg_class.h"
@@ -67,7 +70,8 @@ class DbgEnum : public DbgClass {
   HRESULT ProcessEnum(ICorDebugValue *debug_value,
                       IMetaDataImport *metadata_import);
 
-  // Processes the fields of this enum.
+  // Gets the named values of this enum, which are cached for the enum
+  // across breakpoint hits.
   HRESULT ProcessEnumFields(IMetaDataImport *metadata_import);
 
   // Sets the underlying integral value of the enum.
@@ -76,18 +80,72 @@ class DbgEnum : public DbgClass {
   // Sets the underlying enum type.
   void SetEnumType(const CorElementType &enum_type) { enum_type_ = enum_type; }
 
+  // Removes the cached layouts of the enums of the module of
+  // metadata_import, which is being unloaded.
+  static void RemoveEnumLayouts(IMetaDataImport *metadata_import);
+
+  // Clears the cached layouts of all enums.
+  static void ClearEnumLayouts() {
+    std::lock_guard<std::mutex> lock(enum_layouts_mutex_);
+    enum_layouts_.clear();
+  }
+
  private:
-  // Assuming the fields of this enum has been processed,
-  // add their values to the enum_values_dict.
-  void AddEnumValuesToDict();
-
-  // Key in the dictionary is the name of the enum.
-  // Values are the list of possible values of that enum.
-  // For example, enum Week { Monday, Tuesday } will have key
-  // as Week and values as (0, "Monday") and (1, "Tuesday").
-  static std::unordered_map<std::string,
-                            std::vector<std::tuple<UVCP_CONSTANT, std::string>>>
-      enum_values_dict;
+  // The named values of an enum, read once from the metadata of the
+  // enum for every value of it that is captured.
+  // For example, enum Week { Monday, Tuesday } has the values
+  // (0, "Monday") and (1, "Tuesday").
+  struct EnumLayout {
+    // Keeps the metadata alive so that its pointer in the key of the
+    // layout is not reused by another module.
+    CComPtr<IMetaDataImport> metadata_import;
+
+    // The integral type of the enum, the type of its value__ field.
+    CorElementType enum_type = CorElementType::ELEMENT_TYPE_END;
+
+    // The named values in the order of the metadata, which is the order
+    // the names of a combination of flags are printed in.
+    std::vector<std::pair<ULONG64, std::string>> values;
+
+    // The values with the indices of their names in values, sorted by
+    // value and then index, so the first name of a value is found with
+    // a binary search.
+    std::vector<std::pair<ULONG64, std::size_t>> sorted_values;
+
+    // Index in values past the last name of 0, or 0 if there is none.
+    // Combinations of flags are named with the names of 0 that come
+    // after the flags, so the search for flags stops once the value is
+    // covered and there is no such name left.
+    std::size_t zero_values_end = 0;
+  };
+
+  typedef std::pair<IMetaDataImport *, mdTypeDef> EnumLayoutKey;
+
+  // Reads the named values of this enum from the fields of its class
+  // layout into layout.
+  HRESULT BuildEnumLayout(IMetaDataImport *metadata_import,
+                          EnumLayout *layout);
+
+  // Gets the layout of this enum from the cache, building it if it is
+  // not there.
+  HRESULT GetEnumLayout(IMetaDataImport *metadata_import,
+                        std::shared_ptr<const EnumLayout> *layout);
+
+  // Returns the name of value in layout, or the names of the flags it
+  // combines joined by " | ", or the number if no name covers it.
+  static std::string GetValueName(const EnumLayout &layout, ULONG64 value);
+
+  // Cache of enum layouts. It is cleared once it has
+  // kMaximumCachedClassLayouts layouts.
+  static std::map<EnumLayoutKey, std::shared_ptr<const EnumLayout>>
+      enum_layouts_;
+
+  // Protects enum_layouts_, which objects captured on different threads
+  // share.
+  static std::mutex enum_layouts_mutex_;
+
+  // The layout of this enum, once ProcessEnumFields succeeded.
+  std::shared_ptr<const EnumLayout> enum_layout_;
 
   // Given a void pointer and type of the enum, extract out the enum
   // value.
@@ -15,13 +15,16 @@
 #ifndef DBG_OBJECT_H_
 #define DBG_OBJECT_H_
 
+#include <new>
 #include <string>
 #include <vector>
 
 #include "breakpoint.pb.h"
+#include "capture_limits.h"
 #include "ccomptr.h"
 #include "cor.h"
 #include "cordebug.h"
+#include "dbg_object_pool.h"
 #include "string_stream_wrapper.h"
 
 namespace google_cloud_debugger {
@@ -45,6 +48,25 @@ class DbgObject : public StringStreamWrapper {
 
   virtual ~DbgObject() {}
 
+  // DbgObjects are allocated from DbgObjectPool::GetDefault(), since a
+  // snapshot creates and frees many of them at once.
+  static void *operator new(std::size_t size) {
+    void *object = DbgObjectPool::GetDefault()->Allocate(size);
+    if (!object) {
+      throw std::bad_alloc();
+    }
+    return object;
+  }
+
+  static void *operator new(std::size_t size,
+                            const std::nothrow_t &) noexcept {
+    return DbgObjectPool::GetDefault()->Allocate(size);
+  }
+
+  static void operator delete(void *object, std::size_t size) noexcept {
+    DbgObjectPool::GetDefault()->Free(object, size);
+  }
+
   // Initialize the DbgObject based on an ICorDebugValue object
   // and a boolean that indicates whether the object is null or not.
   // This function will set initialize_hr_ if there is any error.
@@ -67,18 +89,34 @@ class DbgObject : public StringStreamWrapper {
     return S_OK;
   }
 
+  // Sets the value of proto variable like PopulateValue, but may read
+  // only as much of the value from the debuggee as limits allow. The
+  // caller still truncates the value to limits.max_string_length.
+  virtual HRESULT PopulateValueWithinLimits(
+      google::cloud::diagnostics::debug::Variable *variable,
+      const CaptureLimits &limits) {
+    return PopulateValue(variable);
+  }
+
   // Extracts the type signature of this object.
   virtual HRESULT GetTypeSignature(TypeSignature *type_signature);
 
+  // Reads everything PopulateType and PopulateValue need from the
+  // debuggee, so that they can be called after the debuggee continues.
+  // Returns false if this object cannot do that, for example because
+  // it has members, which is the default.
+  virtual bool CaptureValue() { return false; }
+
   // Populates the members vector using this object's members.
   // Returns S_FALSE by default (no members).
   // Variable_proto is used to create children variable protos.
   // These protos, combined with this object's members' values
   // will be used to populate members vector.
+  // limits are the limits of the snapshot the members are captured in.
   // object_factory is needed to create new DbgObjects for members.
   virtual HRESULT PopulateMembers(
       google::cloud::diagnostics::debug::Variable *variable_proto,
-      std::vector<VariableWrapper> *members,
+      std::vector<VariableWrapper> *members, const CaptureLimits &limits,
       IEvalCoordinator *eval_coordinator) {
     return S_FALSE;
   }
@@ -87,6 +125,11 @@ class DbgObject : public StringStreamWrapper {
   virtual HRESULT GetICorDebugValue(ICorDebugValue **debug_value,
                                     ICorDebugEval *debug_eval) = 0;
 
+  // Returns the strong handle to the object, or null if the object is
+  // not a reference type. During a hit, the DbgObjects holding the same
+  // object share their handle, which then identifies the object.
+  virtual ICorDebugHandleValue *GetObjectHandle() const { return nullptr; }
+
   // Returns the ICorDebugType of the object.
   ICorDebugType *GetDebugType() const { return debug_type_; }
 
@@ -117,6 +160,12 @@ class DbgObject : public StringStreamWrapper {
   // Sets the address of the object.
   void SetAddress(const CORDB_ADDRESS &address) { address_ = address; }
 
+  // Returns the size of the object in bytes, or 0 if it is not known.
+  ULONG32 GetObjectSize() const { return object_size_; }
+
+  // Sets the size of the object in bytes.
+  void SetObjectSize(ULONG32 object_size) { object_size_ = object_size; }
+
  private:
   // The underlying type of the object.
   CComPtr<ICorDebugType> debug_type_;
@@ -127,6 +176,9 @@ class DbgObject : public StringStreamWrapper {
   // The address of the object.
   CORDB_ADDRESS address_ = 0;
 
+  // The size of the object in bytes, or 0 if it is not known.
+  ULONG32 object_size_ = 0;
+
   // The depth of creation for this object.
   // Once this is 0, we don't create the fields and properties of the object.
   // Note that even though we use BFS in dbg_stack_frame to control how deep
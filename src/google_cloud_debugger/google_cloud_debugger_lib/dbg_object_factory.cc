@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <cstdint>
 #include <iostream>
+#include <map>
 
 #include "cor_debug_helper.h"
 #include "dbg_array.h"
@@ -36,6 +37,12 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+std::map<DbgObjectFactory::ClassDispatchKey,
+         std::shared_ptr<const DbgObjectFactory::ClassDispatch>>
+    DbgObjectFactory::class_dispatches_;
+
+std::mutex DbgObjectFactory::class_dispatches_mutex_;
+
 DbgObjectFactory::DbgObjectFactory() : debug_helper_(new CorDebugHelper()) {}
 
 DbgObjectFactory::DbgObjectFactory(
@@ -151,6 +158,19 @@ HRESULT DbgObjectFactory::CreateDbgObjectHelper(
       return hr;
     }
     temp_object->SetAddress(address);
+
+    // The size of an array or a class object is known to ICorDebug
+    // without reading the debuggee. It lets the capture leave out the
+    // members of objects that are too large.
+    bool has_members = cor_element_type == ELEMENT_TYPE_SZARRAY ||
+                       cor_element_type == ELEMENT_TYPE_ARRAY ||
+                       cor_element_type == ELEMENT_TYPE_CLASS ||
+                       cor_element_type == ELEMENT_TYPE_OBJECT;
+    ULONG32 object_size = 0;
+    if (has_members && !is_null &&
+        SUCCEEDED(debug_value->GetSize(&object_size))) {
+      temp_object->SetObjectSize(object_size);
+    }
   }
 
   (*result_object) = std::move(temp_object);
@@ -252,28 +272,14 @@ HRESULT DbgObjectFactory::CreateDbgClassObject(
     return hr;
   }
 
-  CComPtr<IMetaDataImport> metadata_import;
-  hr = debug_helper_->GetMetadataImportFromICorDebugModule(
-      debug_module, &metadata_import, err_stream);
+  std::shared_ptr<const ClassDispatch> dispatch;
+  hr = GetClassDispatch(debug_module, class_token, &dispatch, err_stream);
   if (FAILED(hr)) {
-    *err_stream << "Failed to get metadata";
     return hr;
   }
 
-  string class_name;
-  hr = ProcessClassName(class_token, metadata_import, &class_name, err_stream);
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  std::vector<WCHAR> wchar_module_name;
-  hr = debug_helper_->GetModuleNameFromICorDebugModule(
-      debug_module, &wchar_module_name, err_stream);
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  string module_name = ConvertWCharPtrToString(wchar_module_name);
+  const string &class_name = dispatch->class_name;
+  const string &module_name = dispatch->module_name;
 
   if (is_null) {
     unique_ptr<DbgClass> null_obj(new (std::nothrow) DbgClass(
@@ -291,84 +297,189 @@ HRESULT DbgObjectFactory::CreateDbgClassObject(
     return S_OK;
   }
 
-  hr = ProcessPrimitiveType(debug_value, class_name, result_object, err_stream);
-  if (SUCCEEDED(hr)) {
-    // Nothing to do here as ProcessPrimitiveType already creates
-    // a primitive object.
-    return hr;
-  } else if (hr == E_NOTIMPL) {
-    string base_class_name;
-    hr = ProcessBaseClassName(debug_type, &base_class_name, err_stream);
+  if (dispatch->kind == ClassKind::kUnresolved) {
+    hr = ResolveClassKind(debug_type, class_token, &dispatch, err_stream);
     if (FAILED(hr)) {
-      *err_stream << "Failed to get the base class.";
       return hr;
     }
+  }
 
-    unique_ptr<DbgClass> class_obj;
-
-    if (kEnumClassName.compare(base_class_name) == 0) {
-      unique_ptr<DbgEnum> enum_obj =
-          unique_ptr<DbgEnum>(new (std::nothrow) DbgEnum(
-              debug_type, depth, class_name, class_token, debug_helper_,
-              std::shared_ptr<DbgObjectFactory>(new DbgObjectFactory())));
-      // Only process class type for enum (since it is ValueType and we don't
-      // store reference to the class object). Delay processing fields and
-      // properties of non-ValueType class until we need them.
-      hr = enum_obj->ProcessEnum(debug_value, metadata_import);
-      if (FAILED(hr)) {
-        *err_stream << "Failed to process class based on their types.";
-        return hr;
-      }
-      class_obj = std::move(enum_obj);
-    } else if (kListClassName.compare(class_name) == 0 ||
-               kHashSetClassName.compare(class_name) == 0 ||
-               kDictionaryClassName.compare(class_name) == 0) {
-      class_obj = unique_ptr<DbgBuiltinCollection>(
-          new (std::nothrow) DbgBuiltinCollection(
-              debug_type, depth, debug_helper_,
-              std::shared_ptr<DbgObjectFactory>(new DbgObjectFactory())));
-    } else {
-      class_obj = unique_ptr<DbgClass>(new (std::nothrow) DbgClass(
-          debug_type, depth, debug_helper_,
-          std::shared_ptr<DbgObjectFactory>(new DbgObjectFactory())));
+  if (dispatch->kind == ClassKind::kPrimitive) {
+    hr = ProcessPrimitiveType(debug_value, dispatch->primitive_type,
+                              result_object, err_stream);
+    if (FAILED(hr)) {
+      *err_stream << "Failed to process value type.";
     }
+    return hr;
+  }
 
-    if (!class_obj) {
+  unique_ptr<DbgClass> class_obj;
+  if (dispatch->kind == ClassKind::kEnum) {
+    unique_ptr<DbgEnum> enum_obj =
+        unique_ptr<DbgEnum>(new (std::nothrow) DbgEnum(
+            debug_type, depth, class_name, class_token, debug_helper_,
+            std::shared_ptr<DbgObjectFactory>(new DbgObjectFactory())));
+    if (!enum_obj) {
       *err_stream << "Ran out of memory to create class object.";
       return E_OUTOFMEMORY;
     }
+    // Only process class type for enum (since it is ValueType and we don't
+    // store reference to the class object). Delay processing fields and
+    // properties of non-ValueType class until we need them.
+    hr = enum_obj->ProcessEnum(debug_value, dispatch->metadata_import);
+    if (FAILED(hr)) {
+      *err_stream << "Failed to process class based on their types.";
+      return hr;
+    }
+    class_obj = std::move(enum_obj);
+  } else if (dispatch->kind == ClassKind::kBuiltinCollection) {
+    class_obj = unique_ptr<DbgBuiltinCollection>(
+        new (std::nothrow) DbgBuiltinCollection(
+            debug_type, depth, debug_helper_,
+            std::shared_ptr<DbgObjectFactory>(new DbgObjectFactory())));
+  } else {
+    class_obj = unique_ptr<DbgClass>(new (std::nothrow) DbgClass(
+        debug_type, depth, debug_helper_,
+        std::shared_ptr<DbgObjectFactory>(new DbgObjectFactory())));
+  }
+
+  if (!class_obj) {
+    *err_stream << "Ran out of memory to create class object.";
+    return E_OUTOFMEMORY;
+  }
+
+  class_obj->SetModuleName(module_name);
+  class_obj->SetClassName(class_name);
+  class_obj->SetClassToken(class_token);
+  class_obj->SetICorDebugModule(debug_module);
 
-    class_obj->SetModuleName(module_name);
-    class_obj->SetClassName(class_name);
-    class_obj->SetClassToken(class_token);
-    class_obj->SetICorDebugModule(debug_module);
+  // If this is a ValueType class, we have to process its members
+  // because we can't store the reference to this class.
+  CorElementType element_type;
+  hr = debug_value->GetType(&element_type);
+  if (FAILED(hr)) {
+    *err_stream << "Failed to extract CorElementType.";
+    return hr;
+  }
 
-    // If this is a ValueType class, we have to process its members
-    // because we can't store the reference to this class.
-    CorElementType element_type;
-    hr = debug_value->GetType(&element_type);
+  if (element_type == CorElementType::ELEMENT_TYPE_VALUETYPE &&
+      dispatch->kind != ClassKind::kEnum) {
+    hr = class_obj->ProcessClassMembersHelper(debug_value, debug_class,
+                                              dispatch->metadata_import);
     if (FAILED(hr)) {
-      *err_stream << "Failed to extract CorElementType.";
+      *err_stream << "Failed to process class members for ValueType.";
       return hr;
     }
+    class_obj->SetProcessedClassMembers(true);
+  }
 
-    if (element_type == CorElementType::ELEMENT_TYPE_VALUETYPE &&
-        kEnumClassName.compare(base_class_name) != 0) {
-      hr = class_obj->ProcessClassMembersHelper(debug_value, debug_class,
-                                                metadata_import);
-      if (FAILED(hr)) {
-        *err_stream << "Failed to process class members for ValueType.";
-        return hr;
-      }
-      class_obj->SetProcessedClassMembers(true);
+  *result_object = std::move(class_obj);
+  return hr;
+}
+
+HRESULT DbgObjectFactory::GetClassDispatch(
+    ICorDebugModule *debug_module, mdTypeDef class_token,
+    std::shared_ptr<const ClassDispatch> *dispatch, ostream *err_stream) {
+  {
+    std::lock_guard<std::mutex> lock(class_dispatches_mutex_);
+    auto cached_dispatch =
+        class_dispatches_.find(ClassDispatchKey(debug_module, class_token));
+    if (cached_dispatch != class_dispatches_.end()) {
+      *dispatch = cached_dispatch->second;
+      return S_OK;
     }
+  }
+
+  std::shared_ptr<ClassDispatch> new_dispatch(new (std::nothrow)
+                                                  ClassDispatch());
+  if (!new_dispatch) {
+    *err_stream << "Ran out of memory to cache class information.";
+    return E_OUTOFMEMORY;
+  }
+  new_dispatch->debug_module = debug_module;
 
-    *result_object = std::move(class_obj);
+  HRESULT hr = debug_helper_->GetMetadataImportFromICorDebugModule(
+      debug_module, &new_dispatch->metadata_import, err_stream);
+  if (FAILED(hr)) {
+    *err_stream << "Failed to get metadata";
     return hr;
-  } else {
-    *err_stream << "Failed to process value type.";
+  }
+
+  hr = ProcessClassName(class_token, new_dispatch->metadata_import,
+                        &new_dispatch->class_name, err_stream);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::vector<WCHAR> wchar_module_name;
+  hr = debug_helper_->GetModuleNameFromICorDebugModule(
+      debug_module, &wchar_module_name, err_stream);
+  if (FAILED(hr)) {
     return hr;
   }
+  new_dispatch->module_name = ConvertWCharPtrToString(wchar_module_name);
+
+  // The kind of primitive classes is known from the name alone.
+  new_dispatch->primitive_type = GetPrimitiveType(new_dispatch->class_name);
+  if (new_dispatch->primitive_type != CorElementType::ELEMENT_TYPE_END) {
+    new_dispatch->kind = ClassKind::kPrimitive;
+  }
+
+  CacheClassDispatch(class_token, new_dispatch);
+  *dispatch = std::move(new_dispatch);
+  return S_OK;
+}
+
+HRESULT DbgObjectFactory::ResolveClassKind(
+    ICorDebugType *debug_type, mdTypeDef class_token,
+    std::shared_ptr<const ClassDispatch> *dispatch, ostream *err_stream) {
+  string base_class_name;
+  HRESULT hr = ProcessBaseClassName(debug_type, &base_class_name, err_stream);
+  if (FAILED(hr)) {
+    *err_stream << "Failed to get the base class.";
+    return hr;
+  }
+
+  std::shared_ptr<ClassDispatch> resolved_dispatch(
+      new (std::nothrow) ClassDispatch(**dispatch));
+  if (!resolved_dispatch) {
+    *err_stream << "Ran out of memory to cache class information.";
+    return E_OUTOFMEMORY;
+  }
+
+  if (kEnumClassName.compare(base_class_name) == 0) {
+    resolved_dispatch->kind = ClassKind::kEnum;
+  } else if (DbgBuiltinCollection::IsBuiltinCollection(
+                 resolved_dispatch->class_name)) {
+    resolved_dispatch->kind = ClassKind::kBuiltinCollection;
+  } else {
+    resolved_dispatch->kind = ClassKind::kClass;
+  }
+
+  CacheClassDispatch(class_token, resolved_dispatch);
+  *dispatch = std::move(resolved_dispatch);
+  return S_OK;
+}
+
+void DbgObjectFactory::CacheClassDispatch(
+    mdTypeDef class_token, std::shared_ptr<const ClassDispatch> dispatch) {
+  ClassDispatchKey key(dispatch->debug_module, class_token);
+  std::lock_guard<std::mutex> lock(class_dispatches_mutex_);
+  if (class_dispatches_.size() >= kMaximumCachedClassDispatches &&
+      class_dispatches_.find(key) == class_dispatches_.end()) {
+    class_dispatches_.clear();
+  }
+  class_dispatches_[key] = std::move(dispatch);
+}
+
+void DbgObjectFactory::RemoveClassDispatches(ICorDebugModule *debug_module) {
+  std::lock_guard<std::mutex> lock(class_dispatches_mutex_);
+  auto dispatch =
+      class_dispatches_.lower_bound(ClassDispatchKey(debug_module, 0));
+  while (dispatch != class_dispatches_.end() &&
+         dispatch->first.first == debug_module) {
+    dispatch = class_dispatches_.erase(dispatch);
+  }
 }
 
 HRESULT DbgObjectFactory::EvaluateAndCreateDbgObject(
@@ -397,6 +508,11 @@ HRESULT DbgObjectFactory::EvaluateAndCreateDbgObject(
   BOOL exception_occurred = FALSE;
   hr = eval_coordinator->WaitForEval(&exception_occurred, debug_eval,
                                      &eval_result);
+  if (hr == CORDBG_E_FUNC_EVAL_NOT_COMPLETE) {
+    *err_stream << "Function evaluation timed out and was aborted.";
+    return hr;
+  }
+
   if (FAILED(hr)) {
     return hr;
   }
@@ -603,54 +719,79 @@ HRESULT DbgObjectFactory::ProcessBaseClassName(ICorDebugType *debug_type,
                           err_stream);
 }
 
+CorElementType DbgObjectFactory::GetPrimitiveType(const string &class_name) {
+  static const std::map<string, CorElementType> primitive_types = {
+      {kCharClassName, CorElementType::ELEMENT_TYPE_CHAR},
+      {kBooleanClassName, CorElementType::ELEMENT_TYPE_BOOLEAN},
+      {kSByteClassName, CorElementType::ELEMENT_TYPE_I1},
+      {kByteClassName, CorElementType::ELEMENT_TYPE_U1},
+      {kInt16ClassName, CorElementType::ELEMENT_TYPE_I2},
+      {kUInt16ClassName, CorElementType::ELEMENT_TYPE_U2},
+      {kInt32ClassName, CorElementType::ELEMENT_TYPE_I4},
+      {kUInt32ClassName, CorElementType::ELEMENT_TYPE_U4},
+      {kInt64ClassName, CorElementType::ELEMENT_TYPE_I8},
+      {kUInt64ClassName, CorElementType::ELEMENT_TYPE_U8},
+      {kSingleClassName, CorElementType::ELEMENT_TYPE_R4},
+      {kDoubleClassName, CorElementType::ELEMENT_TYPE_R8},
+      {kIntPtrClassName, CorElementType::ELEMENT_TYPE_I},
+      {kUIntPtrClassName, CorElementType::ELEMENT_TYPE_U}};
+
+  auto primitive_type = primitive_types.find(class_name);
+  if (primitive_type == primitive_types.end()) {
+    return CorElementType::ELEMENT_TYPE_END;
+  }
+  return primitive_type->second;
+}
+
 HRESULT DbgObjectFactory::ProcessPrimitiveType(
-    ICorDebugValue *debug_value, const std::string &class_name,
+    ICorDebugValue *debug_value, CorElementType primitive_type,
     unique_ptr<DbgObject> *result_class_obj, std::ostream *err_stream) {
-  if (kCharClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<char>(debug_value, result_class_obj,
-                                        err_stream);
-  } else if (kBooleanClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<bool>(debug_value, result_class_obj,
-                                        err_stream);
-  } else if (kSByteClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<int8_t>(debug_value, result_class_obj,
+  switch (primitive_type) {
+    case CorElementType::ELEMENT_TYPE_CHAR:
+      return ProcessValueTypeHelper<char>(debug_value, result_class_obj,
                                           err_stream);
-  } else if (kByteClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<uint8_t>(debug_value, result_class_obj,
-                                           err_stream);
-  } else if (kInt16ClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<int16_t>(debug_value, result_class_obj,
-                                           err_stream);
-  } else if (kUInt16ClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<uint16_t>(debug_value, result_class_obj,
-                                            err_stream);
-  } else if (kInt32ClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<int32_t>(debug_value, result_class_obj,
-                                           err_stream);
-  } else if (kUInt32ClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<uint32_t>(debug_value, result_class_obj,
-                                            err_stream);
-  } else if (kInt64ClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<int64_t>(debug_value, result_class_obj,
-                                           err_stream);
-  } else if (kUInt64ClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<uint64_t>(debug_value, result_class_obj,
-                                            err_stream);
-  } else if (kSingleClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<float>(debug_value, result_class_obj,
-                                         err_stream);
-  } else if (kDoubleClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<double>(debug_value, result_class_obj,
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      return ProcessValueTypeHelper<bool>(debug_value, result_class_obj,
                                           err_stream);
-  } else if (kIntPtrClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<intptr_t>(debug_value, result_class_obj,
+    case CorElementType::ELEMENT_TYPE_I1:
+      return ProcessValueTypeHelper<int8_t>(debug_value, result_class_obj,
                                             err_stream);
-  } else if (kUIntPtrClassName.compare(class_name) == 0) {
-    return ProcessValueTypeHelper<uintptr_t>(debug_value, result_class_obj,
+    case CorElementType::ELEMENT_TYPE_U1:
+      return ProcessValueTypeHelper<uint8_t>(debug_value, result_class_obj,
+                                             err_stream);
+    case CorElementType::ELEMENT_TYPE_I2:
+      return ProcessValueTypeHelper<int16_t>(debug_value, result_class_obj,
                                              err_stream);
+    case CorElementType::ELEMENT_TYPE_U2:
+      return ProcessValueTypeHelper<uint16_t>(debug_value, result_class_obj,
+                                              err_stream);
+    case CorElementType::ELEMENT_TYPE_I4:
+      return ProcessValueTypeHelper<int32_t>(debug_value, result_class_obj,
+                                             err_stream);
+    case CorElementType::ELEMENT_TYPE_U4:
+      return ProcessValueTypeHelper<uint32_t>(debug_value, result_class_obj,
+                                              err_stream);
+    case CorElementType::ELEMENT_TYPE_I8:
+      return ProcessValueTypeHelper<int64_t>(debug_value, result_class_obj,
+                                             err_stream);
+    case CorElementType::ELEMENT_TYPE_U8:
+      return ProcessValueTypeHelper<uint64_t>(debug_value, result_class_obj,
+                                              err_stream);
+    case CorElementType::ELEMENT_TYPE_R4:
+      return ProcessValueTypeHelper<float>(debug_value, result_class_obj,
+                                           err_stream);
+    case CorElementType::ELEMENT_TYPE_R8:
+      return ProcessValueTypeHelper<double>(debug_value, result_class_obj,
+                                            err_stream);
+    case CorElementType::ELEMENT_TYPE_I:
+      return ProcessValueTypeHelper<intptr_t>(debug_value, result_class_obj,
+                                              err_stream);
+    case CorElementType::ELEMENT_TYPE_U:
+      return ProcessValueTypeHelper<uintptr_t>(debug_value, result_class_obj,
+                                               err_stream);
+    default:
+      return E_NOTIMPL;
   }
-
-  return E_NOTIMPL;
 }
 
 }  //  namespace google_cloud_debugger
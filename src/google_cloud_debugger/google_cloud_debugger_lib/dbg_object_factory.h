@@ -15,6 +15,11 @@
 #ifndef DBG_OBJECT_FACTORY_H__
 #define DBG_OBJECT_FACTORY_H__
 
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "ccomptr.h"
 #include "dbg_primitive.h"
 #include "i_dbg_object_factory.h"
 
@@ -70,7 +75,65 @@ class DbgObjectFactory : public IDbgObjectFactory {
       std::unique_ptr<DbgObject> *evaluate_result,
       std::ostream *err_stream) override;
 
+  // Clears the cached kinds of the classes. Used by tests.
+  static void ClearClassDispatches() {
+    std::lock_guard<std::mutex> lock(class_dispatches_mutex_);
+    class_dispatches_.clear();
+  }
+
+  // Removes the cached kinds of the classes of debug_module, which is
+  // being unloaded.
+  static void RemoveClassDispatches(ICorDebugModule *debug_module);
+
  private:
+  // The kind of DbgObject that is created for the values of a class.
+  enum class ClassKind {
+    // Not known yet, for example because only null values of the class
+    // have been created.
+    kUnresolved,
+    // A primitive type like System.Int32 that is wrapped in a class.
+    kPrimitive,
+    kEnum,
+    kBuiltinCollection,
+    kClass
+  };
+
+  // What CreateDbgClassObject has found out about a class, so that
+  // more values of the class can be created without reading the names
+  // of the class, its module and its base class from the metadata.
+  struct ClassDispatch {
+    // Keeps the module in the key of the cache alive.
+    CComPtr<ICorDebugModule> debug_module;
+
+    CComPtr<IMetaDataImport> metadata_import;
+    std::string class_name;
+    std::string module_name;
+    ClassKind kind = ClassKind::kUnresolved;
+
+    // The type values of a kPrimitive class are read as.
+    CorElementType primitive_type = CorElementType::ELEMENT_TYPE_END;
+  };
+
+  typedef std::pair<ICorDebugModule *, mdTypeDef> ClassDispatchKey;
+
+  // Sets dispatch to the cached ClassDispatch of the class class_token
+  // in debug_module, reading the names of the class and the module if
+  // it has not been cached yet.
+  HRESULT GetClassDispatch(ICorDebugModule *debug_module,
+                           mdTypeDef class_token,
+                           std::shared_ptr<const ClassDispatch> *dispatch,
+                           std::ostream *err_stream);
+
+  // Resolves the kind of the class of dispatch, whose type is
+  // debug_type, and caches it.
+  HRESULT ResolveClassKind(ICorDebugType *debug_type, mdTypeDef class_token,
+                           std::shared_ptr<const ClassDispatch> *dispatch,
+                           std::ostream *err_stream);
+
+  // Adds dispatch to the cache of the class class_token.
+  static void CacheClassDispatch(
+      mdTypeDef class_token, std::shared_ptr<const ClassDispatch> dispatch);
+
   // This will be injected into the DbgObject created by this factory.
   std::shared_ptr<ICorDebugHelper> debug_helper_;
 
@@ -92,11 +155,16 @@ class DbgObjectFactory : public IDbgObjectFactory {
                                std::string *base_class_name,
                                std::ostream *err_stream);
 
-  // Evaluates and creates a DbgPrimitive object and stores it
-  // in result_class_obj if this class is an integral types
-  // (int, short, long, double).
+  // Returns the CorElementType the values of class class_name are read
+  // as if it is an integral type (int, short, long, double), or
+  // ELEMENT_TYPE_END otherwise.
+  static CorElementType GetPrimitiveType(const std::string &class_name);
+
+  // Evaluates and creates a DbgPrimitive object of type primitive_type,
+  // which is returned by GetPrimitiveType, and stores it in
+  // result_class_obj.
   HRESULT ProcessPrimitiveType(ICorDebugValue *debug_value,
-                               const std::string &class_name,
+                               CorElementType primitive_type,
                                std::unique_ptr<DbgObject> *result_class_obj,
                                std::ostream *err_stream);
 
@@ -125,6 +193,14 @@ class DbgObjectFactory : public IDbgObjectFactory {
     *result_class_obj = std::move(primitive_value);
     return S_OK;
   }
+
+  // Cache of the kinds of the classes whose values have been created.
+  static std::map<ClassDispatchKey, std::shared_ptr<const ClassDispatch>>
+      class_dispatches_;
+
+  // Protects class_dispatches_, which factories on different threads
+  // share.
+  static std::mutex class_dispatches_mutex_;
 };
 
 }  //  namespace google_cloud_debugger
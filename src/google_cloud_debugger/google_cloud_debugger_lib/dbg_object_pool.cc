@@ -0,0 +1,114 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dbg_object_pool.h"
+
+#include <new>
+
+namespace google_cloud_debugger {
+
+const std::size_t DbgObjectPool::kAlignment;
+const std::size_t DbgObjectPool::kMaxObjectSize;
+const std::size_t DbgObjectPool::kSlabSize;
+
+DbgObjectPool::~DbgObjectPool() { FreeSlabs(); }
+
+DbgObjectPool *DbgObjectPool::GetDefault() {
+  static DbgObjectPool *pool = new DbgObjectPool();
+  return pool;
+}
+
+void *DbgObjectPool::Allocate(std::size_t size) {
+  if (size > kMaxObjectSize) {
+    return ::operator new(size, std::nothrow);
+  }
+
+  std::size_t size_class = size == 0 ? 0 : (size - 1) / kAlignment;
+  std::lock_guard<std::mutex> lock(mutex_);
+  FreeObject *free_object = free_lists_[size_class];
+  if (free_object) {
+    free_lists_[size_class] = free_object->next;
+    ++live_objects_;
+    return free_object;
+  }
+
+  std::size_t rounded_size = (size_class + 1) * kAlignment;
+  if (static_cast<std::size_t>(slab_end_ - slab_next_) < rounded_size) {
+    // The rest of the current slab is too small and is left unused.
+    char *slab = new (std::nothrow) char[kSlabSize];
+    if (!slab) {
+      return nullptr;
+    }
+    slabs_.push_back(slab);
+    slab_next_ = slab;
+    slab_end_ = slab + kSlabSize;
+  }
+
+  void *object = slab_next_;
+  slab_next_ += rounded_size;
+  ++live_objects_;
+  return object;
+}
+
+void DbgObjectPool::Free(void *object, std::size_t size) {
+  if (!object) {
+    return;
+  }
+
+  if (size > kMaxObjectSize) {
+    ::operator delete(object);
+    return;
+  }
+
+  std::size_t size_class = size == 0 ? 0 : (size - 1) / kAlignment;
+  FreeObject *free_object = static_cast<FreeObject *>(object);
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_object->next = free_lists_[size_class];
+  free_lists_[size_class] = free_object;
+  --live_objects_;
+}
+
+bool DbgObjectPool::ReleaseIfUnused() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (live_objects_ != 0) {
+    return false;
+  }
+
+  FreeSlabs();
+  return true;
+}
+
+std::size_t DbgObjectPool::GetLiveObjects() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return live_objects_;
+}
+
+std::size_t DbgObjectPool::GetSlabCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slabs_.size();
+}
+
+void DbgObjectPool::FreeSlabs() {
+  for (char *slab : slabs_) {
+    delete[] slab;
+  }
+  slabs_.clear();
+  for (FreeObject *&free_list : free_lists_) {
+    free_list = nullptr;
+  }
+  slab_next_ = nullptr;
+  slab_end_ = nullptr;
+}
+
+}  //  namespace google_cloud_debugger
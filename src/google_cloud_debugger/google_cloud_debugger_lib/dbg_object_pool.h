@@ -0,0 +1,98 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DBG_OBJECT_POOL_H_
+#define DBG_OBJECT_POOL_H_
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace google_cloud_debugger {
+
+// Memory for the DbgObjects of snapshots. A snapshot creates many small
+// objects that are freed together once the breakpoint is written, so the
+// pool carves them out of large slabs and keeps freed objects in free
+// lists by size instead of going to the heap for each of them. The slabs
+// are freed with ReleaseIfUnused once no object of the pool is alive.
+class DbgObjectPool {
+ public:
+  DbgObjectPool() = default;
+  DbgObjectPool(const DbgObjectPool &) = delete;
+  DbgObjectPool &operator=(const DbgObjectPool &) = delete;
+  ~DbgObjectPool();
+
+  // Returns the pool DbgObjects are allocated from. It is never
+  // destroyed, so objects can be freed during static destruction.
+  static DbgObjectPool *GetDefault();
+
+  // Returns memory for an object of size bytes, which is aligned to
+  // kAlignment. Objects larger than kMaxObjectSize come from the heap.
+  // Returns nullptr if it runs out of memory.
+  void *Allocate(std::size_t size);
+
+  // Frees object, which was returned by Allocate(size).
+  void Free(void *object, std::size_t size);
+
+  // Frees the slabs of the pool if none of its objects are alive and
+  // returns whether it did. Objects that are still alive, for example
+  // because they are cached across snapshots, keep the slabs for reuse.
+  bool ReleaseIfUnused();
+
+  // Returns the number of objects allocated from the slabs that have not
+  // been freed yet.
+  std::size_t GetLiveObjects();
+
+  // Returns the number of slabs of the pool.
+  std::size_t GetSlabCount();
+
+  // Objects are sized and aligned to a multiple of this.
+  static const std::size_t kAlignment = 16;
+
+  // Objects larger than this are allocated from the heap.
+  static const std::size_t kMaxObjectSize = 512;
+
+  // Size of the slabs the objects are carved out of.
+  static const std::size_t kSlabSize = 64 * 1024;
+
+ private:
+  // A freed object, linked into the free list of its size.
+  struct FreeObject {
+    FreeObject *next;
+  };
+
+  // Free lists of the objects of kAlignment, 2 * kAlignment, ... bytes.
+  FreeObject *free_lists_[kMaxObjectSize / kAlignment] = {};
+
+  // Slabs allocated so far.
+  std::vector<char *> slabs_;
+
+  // The part of the last slab that has not been handed out yet.
+  char *slab_next_ = nullptr;
+  char *slab_end_ = nullptr;
+
+  // Number of objects allocated from the slabs and not freed.
+  std::size_t live_objects_ = 0;
+
+  // Protects the members above, since objects are created and freed on
+  // different threads.
+  std::mutex mutex_;
+
+  // Frees the slabs. mutex_ has to be held.
+  void FreeSlabs();
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  DBG_OBJECT_POOL_H_
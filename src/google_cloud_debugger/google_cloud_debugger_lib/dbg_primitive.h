@@ -23,6 +23,7 @@
 #include "class_names.h"
 #include "dbg_object.h"
 #include "i_cor_debug_helper.h"
+#include "number_format.h"
 
 namespace google_cloud_debugger {
 // Template class for DbgObject of primitive type.
@@ -45,6 +46,14 @@ class DbgPrimitive : public DbgObject {
     SetCorElementType(value);
   }
 
+  // Creates an object of type debug_type that holds value, for values
+  // that are read from the debuggee without an ICorDebugValue.
+  // Initialize still has to be called to get the element type.
+  DbgPrimitive(ICorDebugType *debug_type, T value)
+      : DbgObject(debug_type, 0, std::shared_ptr<ICorDebugHelper>()) {
+    value_ = value;
+  }
+
   // debug_value can be a null pointer, in which case value_ is just the default
   // value for the type.
   void Initialize(ICorDebugValue *debug_value, BOOL is_null) override {
@@ -102,6 +111,9 @@ class DbgPrimitive : public DbgObject {
   // Returns the primitive value stored.
   T GetValue() { return value_; }
 
+  // The value is copied when the object is initialized.
+  bool CaptureValue() override { return true; }
+
   // No evaluation is needed!
   HRESULT PopulateValue(
       google::cloud::diagnostics::debug::Variable *variable) override {
@@ -113,7 +125,7 @@ class DbgPrimitive : public DbgObject {
       return E_INVALIDARG;
     }
 
-    variable->set_value(std::to_string(value_));
+    AssignNumber(value_, variable->mutable_value());
     return S_OK;
   }
 
@@ -21,30 +21,9 @@ namespace google_cloud_debugger {
 HRESULT DbgReferenceObject::GetNonStaticField(
     const std::string &field_name,
     std::shared_ptr<DbgObject> *field_value) {
-  if (!object_handle_) {
-    return E_INVALIDARG;
-  }
-
-  HRESULT hr;
-
-  // Dereferences the object to get ICorDebugObjectValue.
-  BOOL is_null = FALSE;
-  CComPtr<ICorDebugValue> debug_value;
-  hr = debug_helper_->Dereference(object_handle_, &debug_value,
-                   &is_null, GetErrorStream());
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  if (is_null) {
-    return E_FAIL;
-  }
-
   CComPtr<ICorDebugObjectValue> object_value;
-  hr = debug_value->QueryInterface(__uuidof(ICorDebugObjectValue),
-      reinterpret_cast<void **>(&object_value));
+  HRESULT hr = GetObjectValue(&object_value);
   if (FAILED(hr)) {
-    WriteError("Failed to cast to ICorDebugObjectValue.");
     return hr;
   }
 
@@ -86,8 +65,84 @@ HRESULT DbgReferenceObject::GetNonStaticField(
     return E_FAIL;
   }
 
+  return CreateFieldObject(object_value, debug_class, field_def, field_value);
+}
+
+HRESULT DbgReferenceObject::GetNonStaticFieldByToken(
+    const std::string &field_name, ICorDebugModule *debug_module,
+    mdTypeDef class_token, mdFieldDef field_def,
+    std::shared_ptr<DbgObject> *field_value) {
+  CComPtr<ICorDebugObjectValue> object_value;
+  HRESULT hr = GetObjectValue(&object_value);
+  if (FAILED(hr)) {
+    // Derived classes may still find the field by name without the handle.
+    return GetNonStaticField(field_name, field_value);
+  }
+
+  CComPtr<ICorDebugClass> debug_class;
+  hr = object_value->GetClass(&debug_class);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // The token is only valid if the object is of class class_token
+  // of module debug_module. Otherwise, looks the field up by name.
+  mdTypeDef object_class_token;
+  hr = debug_class->GetToken(&object_class_token);
+  if (FAILED(hr)) {
+    WriteError("Failed to get class token.");
+    return hr;
+  }
+
+  CComPtr<ICorDebugModule> object_module;
+  hr = debug_class->GetModule(&object_module);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (object_class_token != class_token || object_module != debug_module) {
+    return GetNonStaticField(field_name, field_value);
+  }
+
+  return CreateFieldObject(object_value, debug_class, field_def, field_value);
+}
+
+HRESULT DbgReferenceObject::GetObjectValue(
+    ICorDebugObjectValue **object_value) {
+  if (!object_handle_) {
+    return E_INVALIDARG;
+  }
+
+  HRESULT hr;
+
+  // Dereferences the object to get ICorDebugObjectValue.
+  BOOL is_null = FALSE;
+  CComPtr<ICorDebugValue> debug_value;
+  hr = debug_helper_->Dereference(object_handle_, &debug_value,
+                   &is_null, GetErrorStream());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (is_null) {
+    return E_FAIL;
+  }
+
+  hr = debug_value->QueryInterface(__uuidof(ICorDebugObjectValue),
+      reinterpret_cast<void **>(object_value));
+  if (FAILED(hr)) {
+    WriteError("Failed to cast to ICorDebugObjectValue.");
+  }
+
+  return hr;
+}
+
+HRESULT DbgReferenceObject::CreateFieldObject(
+    ICorDebugObjectValue *object_value, ICorDebugClass *debug_class,
+    mdFieldDef field_def, std::shared_ptr<DbgObject> *field_value) {
   CComPtr<ICorDebugValue> field_debug_value;
-  hr = object_value->GetFieldValue(debug_class, field_def, &field_debug_value);
+  HRESULT hr = object_value->GetFieldValue(debug_class, field_def,
+                                           &field_debug_value);
   if (FAILED(hr)) {
     return hr;
   }
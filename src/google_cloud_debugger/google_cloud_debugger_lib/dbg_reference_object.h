@@ -37,6 +37,15 @@ class DbgReferenceObject : public DbgObject {
   virtual HRESULT GetNonStaticField(const std::string &field_name,
                                     std::shared_ptr<DbgObject> *field_value);
 
+  // Reads the non-static field field_def, which was resolved from
+  // field_name in class class_token of module debug_module, from the
+  // object and returns the value in field_value. This skips the lookup of
+  // the field by name unless the object is of another class.
+  virtual HRESULT GetNonStaticFieldByToken(
+      const std::string &field_name, ICorDebugModule *debug_module,
+      mdTypeDef class_token, mdFieldDef field_def,
+      std::shared_ptr<DbgObject> *field_value);
+
   // Returns object_handle_.
   virtual HRESULT GetICorDebugValue(ICorDebugValue **debug_value,
                                     ICorDebugEval *debug_eval) override;
@@ -44,7 +53,21 @@ class DbgReferenceObject : public DbgObject {
   // Returns the underlying ICorDebugHandleValue for this object.
   HRESULT GetDebugHandle(ICorDebugHandleValue **result);
 
+  // Returns object_handle_.
+  ICorDebugHandleValue *GetObjectHandle() const override {
+    return object_handle_;
+  }
+
  protected:
+  // Dereferences object_handle_ and returns the object in object_value.
+  HRESULT GetObjectValue(ICorDebugObjectValue **object_value);
+
+  // Reads field field_def of class debug_class from object_value and
+  // returns the value in field_value.
+  HRESULT CreateFieldObject(ICorDebugObjectValue *object_value,
+                            ICorDebugClass *debug_class, mdFieldDef field_def,
+                            std::shared_ptr<DbgObject> *field_value);
+
   // Handle for the object.
   // Only applicable for class, array and string.
   CComPtr<ICorDebugHandleValue> object_handle_;
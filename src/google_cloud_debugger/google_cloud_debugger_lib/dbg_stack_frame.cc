@@ -14,14 +14,15 @@
 
 #include "dbg_stack_frame.h"
 
+#include <array>
 #include <iostream>
-#include <queue>
 #include <vector>
 
 #include "compiler_helpers.h"
 #include "constants.h"
 #include "dbg_breakpoint.h"
 #include "dbg_class.h"
+#include "dbg_class_field.h"
 #include "dbg_enum.h"
 #include "dbg_reference_object.h"
 #include "debugger_callback.h"
@@ -29,6 +30,7 @@
 #include "i_dbg_object_factory.h"
 #include "i_eval_coordinator.h"
 #include "method_info.h"
+#include "module_registry.h"
 #include "type_signature.h"
 #include "variable_wrapper.h"
 
@@ -39,8 +41,6 @@ using google_cloud_debugger_portable_pdb::LocalConstantInfo;
 using google_cloud_debugger_portable_pdb::LocalVariableInfo;
 using std::cerr;
 using std::cout;
-using std::ostringstream;
-using std::queue;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -48,6 +48,18 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+std::map<DbgStackFrame::AsyncStateMachineKey,
+         std::shared_ptr<const DbgStackFrame::AsyncStateMachineLayout>>
+    DbgStackFrame::async_state_machine_layouts_;
+
+std::mutex DbgStackFrame::async_state_machine_layouts_mutex_;
+
+std::map<DbgStackFrame::MethodFrameKey,
+         std::shared_ptr<const DbgStackFrame::MethodFrameLayout>>
+    DbgStackFrame::method_frame_layouts_;
+
+std::mutex DbgStackFrame::method_frame_layouts_mutex_;
+
 HRESULT DbgStackFrame::Initialize(
     ICorDebugILFrame *il_frame,
     const std::vector<LocalVariableInfo> &variable_infos,
@@ -75,25 +87,15 @@ HRESULT DbgStackFrame::Initialize(
     return hr;
   }
 
-  // We need to determine whether this frame is in a static
-  // method or not and set is_static_method_ correspondingly.
-  ULONG method_name_len;
-  PCCOR_SIGNATURE method_signature;
-  ULONG method_signature_blob;
-  ULONG method_rva;
-  DWORD method_flag;
-  DWORD method_flags2;
-
-  hr = metadata_import->GetMethodProps(
-      method_token, &class_token_, nullptr, 0, &method_name_len, &method_flag,
-      &method_signature, &method_signature_blob, &method_rva, &method_flags2);
-
+  shared_ptr<const MethodFrameLayout> layout;
+  hr = GetMethodFrameLayout(variable_infos, constant_infos, method_token,
+                            metadata_import, &layout);
   if (FAILED(hr)) {
-    cerr << "Failed to retrieve method flags.";
     return hr;
   }
 
-  is_static_method_ = IsMdStatic(method_flag);
+  class_token_ = layout->class_token;
+  is_static_method_ = layout->is_static_method;
 
   CComPtr<ICorDebugValueEnum> method_arg_enum;
   // Even if we are not in a method (no arguments), this will return S_OK.
@@ -103,7 +105,7 @@ HRESULT DbgStackFrame::Initialize(
     return hr;
   }
 
-  hr = ProcessMethodArguments(method_arg_enum, method_token, metadata_import);
+  hr = ProcessMethodArguments(method_arg_enum, *layout, metadata_import);
   if (FAILED(hr)) {
     return hr;
   }
@@ -117,13 +119,13 @@ HRESULT DbgStackFrame::Initialize(
     }
 
     // The populate methods will write errors.
-    hr = ProcessLocalVariables(local_enum, variable_infos);
+    hr = ProcessLocalVariables(local_enum, *layout);
     if (FAILED(hr)) {
       return hr;
     }
   }
 
-  hr = ProcessLocalConstants(constant_infos);
+  hr = ProcessLocalConstants(*layout);
   if (FAILED(hr)) {
     return hr;
   }
@@ -137,9 +139,201 @@ HRESULT DbgStackFrame::Initialize(
   return S_OK;
 }
 
+HRESULT DbgStackFrame::BuildMethodFrameLayout(
+    const vector<LocalVariableInfo> &variable_infos,
+    const vector<LocalConstantInfo> &constant_infos, mdMethodDef method_token,
+    IMetaDataImport *metadata_import, MethodFrameLayout *layout) {
+  layout->metadata_import = metadata_import;
+
+  // We need to determine whether this frame is in a static
+  // method or not.
+  ULONG method_name_len;
+  PCCOR_SIGNATURE method_signature;
+  ULONG method_signature_blob;
+  ULONG method_rva;
+  DWORD method_flag;
+  DWORD method_flags2;
+
+  HRESULT hr = metadata_import->GetMethodProps(
+      method_token, &layout->class_token, nullptr, 0, &method_name_len,
+      &method_flag, &method_signature, &method_signature_blob, &method_rva,
+      &method_flags2);
+
+  if (FAILED(hr)) {
+    cerr << "Failed to retrieve method flags.";
+    return hr;
+  }
+
+  layout->is_static_method = IsMdStatic(method_flag);
+
+  // Add "this" if method is not static.
+  if (!layout->is_static_method) {
+    layout->argument_names.push_back("this");
+  }
+
+  hr = S_OK;
+  HCORENUM cor_enum = nullptr;
+  vector<mdParamDef> method_args(100, 0);
+  while (hr == S_OK) {
+    ULONG method_args_returned = 0;
+    hr =
+        metadata_import->EnumParams(&cor_enum, method_token, method_args.data(),
+                                    method_args.size(), &method_args_returned);
+    if (FAILED(hr)) {
+      cerr << "Failed to get method arguments for method: " << method_token
+           << " with hr: " << std::hex << hr;
+      metadata_import->CloseEnum(cor_enum);
+      return hr;
+    }
+
+    // No arguments to evaluate.
+    if (method_args_returned == 0) {
+      break;
+    }
+
+    method_args.resize(method_args_returned);
+
+    for (auto const &method_arg_token : method_args) {
+      std::string param_name;
+      hr = debug_helper_->ExtractParamName(metadata_import, method_arg_token,
+                                           &param_name, &cerr);
+      if (FAILED(hr)) {
+        continue;
+      }
+
+      layout->argument_names.push_back(param_name);
+    }
+  }
+
+  metadata_import->CloseEnum(cor_enum);
+
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // The first info of a slot names it.
+  for (const LocalVariableInfo &variable_info : variable_infos) {
+    if (variable_info.slot >= layout->local_variable_names.size()) {
+      layout->local_variable_names.resize(variable_info.slot + 1);
+    }
+
+    LocalVariableName &variable_name =
+        layout->local_variable_names[variable_info.slot];
+    if (!variable_name.name.empty() || variable_name.hidden) {
+      continue;
+    }
+    variable_name.name = variable_info.name.str();
+    variable_name.hidden = variable_info.debugger_hidden;
+  }
+
+  for (const LocalConstantInfo &constant_info : constant_infos) {
+    LocalConstant constant;
+    constant.name = constant_info.name.str();
+
+    UVCP_CONSTANT const_value;
+    vector<uint8_t> remaining_buffer;
+    hr = debug_helper_->ProcessConstantSigBlob(
+        constant_info.signature, constant_info.signature_size, &constant.type,
+        &const_value, &constant.value_len, &remaining_buffer);
+    if (FAILED(hr)) {
+      cerr << "Cannot process constant " << constant.name;
+      continue;
+    }
+
+    // The value runs up to the enum token, if there is one. It is padded
+    // with zeros since native integers are read at their full width.
+    const uint8_t *value_begin = static_cast<const uint8_t *>(const_value);
+    const uint8_t *value_end = constant_info.signature +
+                               constant_info.signature_size -
+                               remaining_buffer.size();
+    constant.value.assign(value_begin, value_end);
+    if (constant.value.size() < sizeof(ULONG64)) {
+      constant.value.resize(sizeof(ULONG64), 0);
+    }
+
+    // If there are no bytes left or cor type is ELEMENT_TYPE_STRING,
+    // then this constant is not an enum.
+    if (remaining_buffer.size() != 0 &&
+        constant.type != CorElementType::ELEMENT_TYPE_STRING) {
+      switch (remaining_buffer.size()) {
+        case 1:
+          constant.encoded_enum_token = *((uint8_t *)remaining_buffer.data());
+          break;
+        case 2:
+          constant.encoded_enum_token = *((uint16_t *)remaining_buffer.data());
+          break;
+        case 4:
+          constant.encoded_enum_token = *((uint32_t *)remaining_buffer.data());
+          break;
+        case 8:
+          constant.encoded_enum_token = *((uint64_t *)remaining_buffer.data());
+          break;
+        default:
+          cerr << "Cannot read metadata token for constant enum "
+               << constant.name;
+          continue;
+      }
+      constant.is_enum = true;
+    }
+
+    layout->local_constants.push_back(std::move(constant));
+  }
+
+  return S_OK;
+}
+
+HRESULT DbgStackFrame::GetMethodFrameLayout(
+    const vector<LocalVariableInfo> &variable_infos,
+    const vector<LocalConstantInfo> &constant_infos, mdMethodDef method_token,
+    IMetaDataImport *metadata_import,
+    shared_ptr<const MethodFrameLayout> *layout) {
+  MethodFrameKey key(metadata_import, method_token, local_scope_indices_);
+  if (has_local_scope_indices_) {
+    std::lock_guard<std::mutex> lock(method_frame_layouts_mutex_);
+    auto cached_layout = method_frame_layouts_.find(key);
+    if (cached_layout != method_frame_layouts_.end()) {
+      *layout = cached_layout->second;
+      return S_OK;
+    }
+  }
+
+  shared_ptr<MethodFrameLayout> new_layout(new (std::nothrow)
+                                               MethodFrameLayout());
+  if (!new_layout) {
+    return E_OUTOFMEMORY;
+  }
+
+  HRESULT hr = BuildMethodFrameLayout(variable_infos, constant_infos,
+                                      method_token, metadata_import,
+                                      new_layout.get());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (has_local_scope_indices_) {
+    std::lock_guard<std::mutex> lock(method_frame_layouts_mutex_);
+    if (method_frame_layouts_.size() >= kMaximumCachedMethodFrameLayouts) {
+      method_frame_layouts_.clear();
+    }
+    method_frame_layouts_[std::move(key)] = new_layout;
+  }
+  *layout = std::move(new_layout);
+  return S_OK;
+}
+
+void DbgStackFrame::RemoveMethodFrameLayouts(
+    IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(method_frame_layouts_mutex_);
+  auto layout = method_frame_layouts_.lower_bound(
+      MethodFrameKey(metadata_import, 0, vector<std::uint32_t>()));
+  while (layout != method_frame_layouts_.end() &&
+         std::get<0>(layout->first) == metadata_import) {
+    layout = method_frame_layouts_.erase(layout);
+  }
+}
+
 HRESULT DbgStackFrame::ProcessLocalVariables(
-    ICorDebugValueEnum *local_enum,
-    const vector<LocalVariableInfo> &variable_infos) {
+    ICorDebugValueEnum *local_enum, const MethodFrameLayout &layout) {
   HRESULT hr;
 
   vector<CComPtr<ICorDebugValue>> debug_values;
@@ -160,31 +354,29 @@ HRESULT DbgStackFrame::ProcessLocalVariables(
     return S_OK;
   }
 
+  local_variable_indices_.assign(debug_values.size(), -1);
   for (size_t i = 0; i < debug_values.size(); ++i) {
     unique_ptr<DbgObject> variable_value;
     string variable_name;
-    unique_ptr<ostringstream> err_stream(new (std::nothrow) ostringstream);
-    bool variable_hidden = false;
 
-    // Default name if we can't get the name.
-    variable_name = "variable_" + std::to_string(i);
-    for (auto &&local_variable : variable_infos) {
-      if (local_variable.slot > i) {
-        break;
+    if (i < layout.local_variable_names.size()) {
+      if (layout.local_variable_names[i].hidden) {
+        continue;
       }
+      variable_name = layout.local_variable_names[i].name;
+    }
 
-      if (local_variable.slot == i) {
-        if (local_variable.debugger_hidden) {
-          variable_hidden = true;
-          break;
-        }
-
-        variable_name = local_variable.name;
-        break;
-      }
+    // Default name if we can't get the name.
+    if (variable_name.empty()) {
+      variable_name = "variable_" + std::to_string(i);
     }
 
-    if (variable_hidden) {
+    local_variable_indices_[i] = variables_.size();
+    if (defer_variable_creation_) {
+      variables_.push_back(
+          VariableTuple(std::move(variable_name), nullptr));
+      deferred_variable_values_.resize(variables_.size());
+      deferred_variable_values_.back() = debug_values[i];
       continue;
     }
 
@@ -203,48 +395,30 @@ HRESULT DbgStackFrame::ProcessLocalVariables(
 }
 
 HRESULT DbgStackFrame::ProcessLocalConstants(
-    const std::vector<google_cloud_debugger_portable_pdb::LocalConstantInfo>
-        &constant_infos) {
+    const MethodFrameLayout &layout) {
   HRESULT hr;
-  for (auto &constant_info : constant_infos) {
-    UVCP_CONSTANT const_value;
-    ULONG value_len = 0;
-    CorElementType const_type;
-    vector<uint8_t> remaining_buffer;
-
-    hr = debug_helper_->ProcessConstantSigBlob(
-        constant_info.signature_data, &const_type,
-        &const_value, &value_len, &remaining_buffer);
-    if (FAILED(hr)) {
-      cerr << "Cannot process constant " << constant_info.name;
-      continue;
-    }
-
+  for (const LocalConstant &constant : layout.local_constants) {
     ULONG64 const_numerical_value = 0;
     std::unique_ptr<DbgObject> const_obj;
     hr = obj_factory_->CreateDbgObjectFromLiteralConst(
-        const_type, const_value, value_len, &const_numerical_value, &const_obj);
+        constant.type, constant.value.data(), constant.value_len,
+        &const_numerical_value, &const_obj);
     if (FAILED(hr)) {
-      cerr << "Failed to create constant " << constant_info.name;
+      cerr << "Failed to create constant " << constant.name;
       continue;
     }
 
-    // If there are no bytes left or cor type is ELEMENT_TYPE_STRING,
-    // then this constant is not an enum.
-    if (remaining_buffer.size() == 0
-      || const_type == CorElementType::ELEMENT_TYPE_STRING) {
+    if (!constant.is_enum) {
       variables_.push_back(
-          std::make_tuple(constant_info.name, std::move(const_obj)));
+          std::make_tuple(constant.name, std::move(const_obj)));
       continue;
     }
 
-
-    hr = ProcessLocalEnumConstant(
-        constant_info.name, const_type,
-        const_numerical_value, remaining_buffer);
+    hr = ProcessLocalEnumConstant(constant.name, constant.type,
+                                  const_numerical_value,
+                                  constant.encoded_enum_token);
     if (FAILED(hr)) {
-      cerr << "Failed to process enum value for constant "
-            << constant_info.name;
+      cerr << "Failed to process enum value for constant " << constant.name;
     }
   }
   return S_OK;
@@ -252,27 +426,7 @@ HRESULT DbgStackFrame::ProcessLocalConstants(
 
 HRESULT DbgStackFrame::ProcessLocalEnumConstant(
     const std::string &constant_name, const CorElementType &enum_type,
-    ULONG64 enum_value, const std::vector<uint8_t> &enum_metadata_buffer) {
-  ULONG encoded_token = 0;
-  size_t buffer_size = enum_metadata_buffer.size();
-  switch (buffer_size) {
-    case 1:
-      encoded_token = *((uint8_t *)enum_metadata_buffer.data());
-      break;
-    case 2:
-      encoded_token = *((uint16_t *)enum_metadata_buffer.data());
-      break;
-    case 4:
-      encoded_token = *((uint32_t *)enum_metadata_buffer.data());
-      break;
-    case 8:
-      encoded_token = *((uint64_t *)enum_metadata_buffer.data());
-      break;
-    default:
-      cerr << "Cannot read metadata token for constant enum " << constant_name;
-      return E_FAIL;
-  }
-
+    ULONG64 enum_value, ULONG encoded_token) {
   // Now we retrieve the name, metadata token and metadata import
   // for the enum.
   std::string enum_name;
@@ -312,7 +466,7 @@ HRESULT DbgStackFrame::ProcessLocalEnumConstant(
 }
 
 HRESULT DbgStackFrame::ProcessMethodArguments(
-    ICorDebugValueEnum *method_arg_enum, mdMethodDef method_token,
+    ICorDebugValueEnum *method_arg_enum, const MethodFrameLayout &layout,
     IMetaDataImport *metadata_import) {
   static const string kMethodArg = "method_argument";
   HRESULT hr = S_OK;
@@ -331,13 +485,7 @@ HRESULT DbgStackFrame::ProcessMethodArguments(
     return hr;
   }
 
-  vector<string> method_argument_names;
-  HCORENUM cor_enum = nullptr;
-
-  // Add "this" if method is not static.
   if (!is_static_method_) {
-    method_argument_names.push_back("this");
-
     // If we are in an async method, ProcessAsyncMethod will populate
     // local variables and method arguments for us. Otherwise, S_FALSE
     // wlil be returned and we proceed to process method arguments as normal.
@@ -347,54 +495,23 @@ HRESULT DbgStackFrame::ProcessMethodArguments(
     }
   }
 
-  hr = S_OK;
-  vector<mdParamDef> method_args(100, 0);
-  while (hr == S_OK) {
-    ULONG method_args_returned = 0;
-    hr =
-        metadata_import->EnumParams(&cor_enum, method_token, method_args.data(),
-                                    method_args.size(), &method_args_returned);
-    if (FAILED(hr)) {
-      cerr << "Failed to get method arguments for method: " << method_token
-           << " with hr: " << std::hex << hr;
-      metadata_import->CloseEnum(cor_enum);
-      return hr;
-    }
-
-    // No arguments to evaluate.
-    if (method_args_returned == 0) {
-      break;
-    }
-
-    method_args.resize(method_args_returned);
-
-    for (auto const &method_arg_token : method_args) {
-      std::string param_name;
-      hr = debug_helper_->ExtractParamName(metadata_import, method_arg_token,
-                                           &param_name, &cerr);
-      if (FAILED(hr)) {
-        continue;
-      }
-
-      method_argument_names.push_back(param_name);
-    }
-  }
-
-  metadata_import->CloseEnum(cor_enum);
-
-  if (FAILED(hr)) {
-    return hr;
-  }
-
   for (size_t i = 0; i < method_arg_values.size(); ++i) {
     unique_ptr<DbgObject> method_arg_value;
     string method_arg_name;
 
-    if (i >= method_argument_names.size()) {
+    if (i >= layout.argument_names.size()) {
       // Default name if we can't get the name.
       method_arg_name = kMethodArg + std::to_string(i);
     } else {
-      method_arg_name = method_argument_names[i];
+      method_arg_name = layout.argument_names[i];
+    }
+
+    if (defer_variable_creation_) {
+      method_arguments_.push_back(
+          VariableTuple(std::move(method_arg_name), nullptr));
+      deferred_method_argument_values_.resize(method_arguments_.size());
+      deferred_method_argument_values_.back() = method_arg_values[i];
+      continue;
     }
 
     hr = obj_factory_->CreateDbgObject(method_arg_values[i], object_depth_,
@@ -413,78 +530,217 @@ HRESULT DbgStackFrame::ProcessMethodArguments(
 
 HRESULT DbgStackFrame::ProcessAsyncMethod(ICorDebugValue *async_state_obj,
                                           IMetaDataImport *metadata_import) {
-  CComPtr<ICorDebugType> debug_type;
-  HRESULT hr =
-      debug_helper_->CheckAsyncStateObj(class_token_, metadata_import);
+  shared_ptr<const AsyncStateMachineLayout> layout;
+  HRESULT hr = GetAsyncStateMachineLayout(metadata_import, &layout);
   if (FAILED(hr)) {
     cerr << "Failed to check whether method is async or not.";
     return hr;
   }
 
-  if (hr == S_FALSE) {
-    return hr;
+  if (!layout->is_state_machine) {
+    return S_FALSE;
   }
 
-  // We are inside an async method. We create a DbgObject that represents
-  // the state machine. Within this object, there are fields that represent
-  // local variable and method arguments. We will populate
-  // variables_ and method_arguments_ with these fields.
+  // We are inside an async method. Within the state machine, there are
+  // fields that represent local variable and method arguments. We will
+  // populate variables_ and method_arguments_ with these fields.
   is_async_method_ = true;
-  std::unique_ptr<DbgObject> state_machine_obj;
-  hr = obj_factory_->CreateDbgObject(async_state_obj, object_depth_ + 1,
-                                     &state_machine_obj, &std::cerr);
+  BOOL is_null = FALSE;
+  CComPtr<ICorDebugValue> state_machine_value;
+  hr = debug_helper_->Dereference(async_state_obj, &state_machine_value,
+                                  &is_null, &cerr);
   if (FAILED(hr)) {
-    cerr << "Failed to create state machine object for async method.";
+    cerr << "Failed to dereference state machine object for async method.";
     return hr;
   }
 
-  DbgClass *class_obj = dynamic_cast<DbgClass *>(state_machine_obj.get());
-  if (!class_obj) {
+  is_static_method_ = true;
+  if (is_null) {
+    return S_OK;
+  }
+  async_state_machine_ = state_machine_value;
+
+  CComPtr<ICorDebugObjectValue> object_value;
+  hr = state_machine_value->QueryInterface(
+      __uuidof(ICorDebugObjectValue), reinterpret_cast<void **>(&object_value));
+  if (FAILED(hr)) {
     cerr << "Failed to retrieve state machine object class.";
     return hr;
   }
 
-  hr = class_obj->ProcessClassMembers();
+  CComPtr<ICorDebugClass> debug_class;
+  hr = object_value->GetClass(&debug_class);
   if (FAILED(hr)) {
-    cerr << "Failed to process async state machine members.";
+    cerr << "Failed to retrieve state machine object class.";
     return hr;
   }
 
-  is_static_method_ = true;
-  ProcessAsyncVariablesAndMethodArgs(class_obj->GetFields());
+  // The state machine of an async method with generic parameters is
+  // generic, and its fields need the instantiated type.
+  CComPtr<ICorDebugType> debug_type;
+  CComPtr<ICorDebugValue2> state_machine_value_2;
+  hr = state_machine_value->QueryInterface(
+      __uuidof(ICorDebugValue2),
+      reinterpret_cast<void **>(&state_machine_value_2));
+  if (SUCCEEDED(hr)) {
+    state_machine_value_2->GetExactType(&debug_type);
+  }
+
+  ProcessAsyncVariablesAndMethodArgs(*layout, object_value, debug_class,
+                                     debug_type);
   return S_OK;
 }
 
-void DbgStackFrame::ProcessAsyncVariablesAndMethodArgs(
-    const std::vector<std::shared_ptr<IDbgClassMember>> &async_fields) {
+HRESULT DbgStackFrame::BuildAsyncStateMachineLayout(
+    IMetaDataImport *metadata_import, AsyncStateMachineLayout *layout) {
   // This is the name of the field that represents "this" object.
   static const std::string async_this = "<>4__this";
 
   // Variable will be stored as field <name>5__1, <name>5__2, etc.
   static const std::string async_variable_name = ">5__";
 
-  for (auto &class_field : async_fields) {
-    std::string field_name = class_field->GetMemberName();
-    if (field_name[0] != '<') {
-      method_arguments_.push_back(std::make_tuple(
-          class_field->GetMemberName(), class_field->GetMemberValue()));
-      continue;
+  layout->metadata_import = metadata_import;
+  HRESULT hr =
+      debug_helper_->CheckAsyncStateObj(class_token_, metadata_import);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  layout->is_state_machine = hr == S_OK;
+  if (!layout->is_state_machine) {
+    return S_OK;
+  }
+
+  HCORENUM cor_enum = nullptr;
+  while (true) {
+    std::array<mdFieldDef, 100> field_defs;
+    ULONG field_defs_returned = 0;
+    hr = metadata_import->EnumFields(&cor_enum, class_token_, field_defs.data(),
+                                     field_defs.size(), &field_defs_returned);
+    if (FAILED(hr)) {
+      cerr << "Failed to enumerate async state machine fields.";
+      metadata_import->CloseEnum(cor_enum);
+      return hr;
     }
 
-    if (field_name.compare(async_this) == 0) {
-      method_arguments_.push_back(
-          std::make_tuple("this", class_field->GetMemberValue()));
-      is_static_method_ = false;
-      continue;
+    if (field_defs_returned == 0) {
+      break;
     }
 
-    size_t end_bracket_position = field_name.find(async_variable_name);
-    // Extracts out the field name.
-    if (end_bracket_position != string::npos) {
-      std::string variable_name =
-          field_name.substr(1, end_bracket_position - 1);
-      variables_.push_back(
-          std::make_tuple(variable_name, class_field->GetMemberValue()));
+    for (ULONG i = 0; i < field_defs_returned; ++i) {
+      shared_ptr<DbgClassField> field(new (std::nothrow) DbgClassField(
+          field_defs[i], 0, nullptr, debug_helper_, obj_factory_));
+      if (!field) {
+        metadata_import->CloseEnum(cor_enum);
+        return E_OUTOFMEMORY;
+      }
+      field->InitializeMetadata(debug_module_, metadata_import);
+
+      HoistedVariable variable;
+      const std::string &field_name = field->GetMemberName();
+      if (field_name.empty() || field_name[0] != '<') {
+        variable.kind = HoistedVariable::kArgument;
+        variable.name = field_name;
+      } else if (field_name.compare(async_this) == 0) {
+        variable.kind = HoistedVariable::kThis;
+        variable.name = "this";
+      } else {
+        // Extracts out the variable name.
+        size_t end_bracket_position = field_name.find(async_variable_name);
+        if (end_bracket_position == string::npos) {
+          continue;
+        }
+        variable.kind = HoistedVariable::kLocal;
+        variable.name = field_name.substr(1, end_bracket_position - 1);
+      }
+
+      variable.field = std::move(field);
+      layout->variables.push_back(std::move(variable));
+    }
+  }
+
+  if (cor_enum) {
+    metadata_import->CloseEnum(cor_enum);
+  }
+  return S_OK;
+}
+
+HRESULT DbgStackFrame::GetAsyncStateMachineLayout(
+    IMetaDataImport *metadata_import,
+    shared_ptr<const AsyncStateMachineLayout> *layout) {
+  // The layout holds a reference to metadata_import, so the pointer
+  // cannot be reused by another module while the layout is cached.
+  AsyncStateMachineKey key(metadata_import, class_token_);
+  {
+    std::lock_guard<std::mutex> lock(async_state_machine_layouts_mutex_);
+    auto cached_layout = async_state_machine_layouts_.find(key);
+    if (cached_layout != async_state_machine_layouts_.end()) {
+      *layout = cached_layout->second;
+      return S_OK;
+    }
+  }
+
+  shared_ptr<AsyncStateMachineLayout> new_layout(
+      new (std::nothrow) AsyncStateMachineLayout());
+  if (!new_layout) {
+    return E_OUTOFMEMORY;
+  }
+
+  HRESULT hr = BuildAsyncStateMachineLayout(metadata_import, new_layout.get());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::lock_guard<std::mutex> lock(async_state_machine_layouts_mutex_);
+  if (async_state_machine_layouts_.size() >= kMaximumCachedClassLayouts) {
+    async_state_machine_layouts_.clear();
+  }
+  async_state_machine_layouts_[key] = new_layout;
+  *layout = std::move(new_layout);
+  return S_OK;
+}
+
+void DbgStackFrame::RemoveAsyncStateMachineLayouts(
+    IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(async_state_machine_layouts_mutex_);
+  auto layout = async_state_machine_layouts_.lower_bound(
+      AsyncStateMachineKey(metadata_import, 0));
+  while (layout != async_state_machine_layouts_.end() &&
+         layout->first.first == metadata_import) {
+    layout = async_state_machine_layouts_.erase(layout);
+  }
+}
+
+void DbgStackFrame::ProcessAsyncVariablesAndMethodArgs(
+    const AsyncStateMachineLayout &layout, ICorDebugObjectValue *object_value,
+    ICorDebugClass *debug_class, ICorDebugType *debug_type) {
+  for (const HoistedVariable &variable : layout.variables) {
+    // The fields of the state machine are the variables of the frame,
+    // so their values are all needed.
+    unique_ptr<DbgClassField> field(new (std::nothrow) DbgClassField(
+        variable.field->GetFieldDef(), object_depth_, debug_type,
+        debug_helper_, obj_factory_));
+    if (!field) {
+      cerr << "Ran out of memory while reading async method variables.";
+      return;
+    }
+    field->Initialize(*variable.field, object_value, debug_class);
+    field->ExtractFieldValue();
+
+    switch (variable.kind) {
+      case HoistedVariable::kThis:
+        is_static_method_ = false;
+        method_arguments_.push_back(
+            std::make_tuple(variable.name, field->GetMemberValue()));
+        break;
+      case HoistedVariable::kArgument:
+        method_arguments_.push_back(
+            std::make_tuple(variable.name, field->GetMemberValue()));
+        break;
+      case HoistedVariable::kLocal:
+        variables_.push_back(
+            std::make_tuple(variable.name, field->GetMemberValue()));
+        break;
     }
   }
 }
@@ -599,78 +855,17 @@ HRESULT DbgStackFrame::InitializeClassGenericTypeParameters(
 }
 
 HRESULT DbgStackFrame::PopulateTypeDict() {
-  if (type_dict_populated_) {
-    return S_OK;
-  }
-
   CComPtr<IMetaDataImport> metadata_import;
   HRESULT hr = GetMetaDataImport(&metadata_import);
   if (FAILED(hr)) {
     return hr;
   }
 
-  HCORENUM cor_enum = nullptr;
-
-  vector<mdTypeDef> type_defs(100, 0);
-  while (hr == S_OK) {
-    ULONG type_defs_returned = 0;
-    hr = metadata_import->EnumTypeDefs(&cor_enum, type_defs.data(),
-                                       type_defs.size(), &type_defs_returned);
-    if (FAILED(hr)) {
-      cerr << "Failed to get enumerate types with hr: " << std::hex << hr;
-      metadata_import->CloseEnum(cor_enum);
-      return hr;
-    }
-
-    // No type defs.
-    if (type_defs_returned == 0) {
-      break;
-    }
-    type_defs.resize(type_defs_returned);
-
-    for (auto const &type_def_token : type_defs) {
-      std::string type_name;
-      mdToken base_token;
-      hr = debug_helper_->GetTypeNameFromMdTypeDef(
-          type_def_token, metadata_import, &type_name, &base_token, &std::cerr);
-      if (FAILED(hr)) {
-        continue;
-      }
-      type_def_dict_[type_name] = type_def_token;
-    }
-  }
-
-  metadata_import->CloseEnum(cor_enum);
-  cor_enum = nullptr;
-
-  hr = S_OK;
-  vector<mdTypeRef> type_refs(100, 0);
-  while (hr == S_OK) {
-    ULONG type_refs_returned = 0;
-    hr = metadata_import->EnumTypeRefs(&cor_enum, type_refs.data(),
-                                       type_refs.size(), &type_refs_returned);
-    if (FAILED(hr)) {
-      cerr << "Failed to get enumerate types with hr: " << std::hex << hr;
-      return hr;
-    }
-
-    // No type defs.
-    if (type_refs_returned == 0) {
-      break;
-    }
-    type_refs.resize(type_refs_returned);
-
-    for (auto const &type_ref_token : type_refs) {
-      std::string type_name;
-      hr = debug_helper_->GetTypeNameFromMdTypeRef(
-          type_ref_token, metadata_import, &type_name, &std::cerr);
-      type_ref_dict_[type_name] = type_ref_token;
-    }
+  if (!type_dictionary_) {
+    type_dictionary_ = std::make_shared<ModuleTypeDictionary>();
   }
 
-  metadata_import->CloseEnum(cor_enum);
-  type_dict_populated_ = true;
-  return S_OK;
+  return type_dictionary_->Populate(metadata_import, debug_helper_.get());
 }
 
 HRESULT DbgStackFrame::PopulateDebugAssemblies() {
@@ -717,39 +912,67 @@ HRESULT DbgStackFrame::GetClassTokenAndModule(
   }
 
   // First, we search the dictionary of mdTypeDef.
-  auto type_def_info = type_def_dict_.find(class_name);
-  if (type_def_info != type_def_dict_.end()) {
+  if (type_dictionary_->FindTypeDef(class_name, class_token)) {
     *debug_module = debug_module_;
     debug_module_->AddRef();
     *metadata_import = frame_metadata_import;
     frame_metadata_import->AddRef();
-    *class_token = type_def_info->second;
     return S_OK;
   }
 
+  // If we didn't find the class, we search the dictionary of mdTypeRef.
+  mdTypeRef type_ref;
+  if (!type_dictionary_->FindTypeRef(class_name, &type_ref)) {
+    return S_FALSE;
+  }
+
+  // The index of the loaded modules finds the module that defines the
+  // type without searching every module of every assembly.
+  if (modules_ && modules_->class_names) {
+    std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+        pdb_file;
+    hr = modules_->class_names->FindTypeDef(class_name, debug_helper_.get(),
+                                            &pdb_file, class_token);
+    if (hr == S_OK) {
+      CComPtr<ICorDebugModule> type_module;
+      CComPtr<IMetaDataImport> type_metadata_import;
+      if (SUCCEEDED(pdb_file->GetDebugModule(&type_module)) &&
+          SUCCEEDED(pdb_file->GetMetaDataImport(&type_metadata_import)) &&
+          type_module && type_metadata_import) {
+        *debug_module = type_module;
+        type_module->AddRef();
+        *metadata_import = type_metadata_import;
+        type_metadata_import->AddRef();
+        return S_OK;
+      }
+    }
+  }
+
   hr = PopulateDebugAssemblies();
   if (FAILED(hr)) {
     return hr;
   }
 
-  // If we didn't find the class, we search the dictionary of mdTypeRef.
-  auto type_ref_info = type_ref_dict_.find(class_name);
-  if (type_ref_info != type_ref_dict_.end()) {
-    hr = debug_helper_->GetMdTypeDefAndMetaDataFromTypeRef(
-        type_ref_info->second, debug_assemblies_, frame_metadata_import,
-        class_token, metadata_import, &cerr);
-    if (FAILED(hr)) {
-      return hr;
-    }
+  hr = debug_helper_->GetMdTypeDefAndMetaDataFromTypeRef(
+      type_ref, debug_assemblies_, frame_metadata_import, class_token,
+      metadata_import, &cerr);
+  if (FAILED(hr)) {
+    return hr;
+  }
 
-    // Then we have to get an ICorDebugModule that corresponds with that
-    // IMetaDataImport. We will first have to get ICorDebugAppDomain
-    // to help us with that.
-    return app_domain_->GetModuleFromMetaDataInterface(*metadata_import,
-                                                       debug_module);
+  // Then we have to get an ICorDebugModule that corresponds with that
+  // IMetaDataImport. The loaded modules are checked first, otherwise
+  // we ask ICorDebugAppDomain.
+  if (modules_) {
+    std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+        pdb_file = modules_->FindByMetaDataImport(*metadata_import);
+    if (pdb_file && SUCCEEDED(pdb_file->GetDebugModule(debug_module))) {
+      return S_OK;
+    }
   }
 
-  return S_FALSE;
+  return app_domain_->GetModuleFromMetaDataInterface(*metadata_import,
+                                                     debug_module);
 }
 
 // TODO(quoct): Checks that this logic work with Generic Type.
@@ -810,9 +1033,26 @@ HRESULT DbgStackFrame::GetFieldAndAutoPropertyInfo(
   return hr;
 }
 
+// Limits the capture of variable, which is a local variable or a method
+// argument, to the paths of the capture mask of limits if there is one.
+static void ApplyCaptureMask(const CaptureLimits &limits,
+                             VariableWrapper *variable) {
+  if (!limits.capture_mask || limits.capture_mask->IsEmpty()) {
+    return;
+  }
+
+  const CaptureMask *capture_mask = limits.capture_mask->GetMember(
+      variable->GetVariableProto()->name());
+  if (capture_mask) {
+    variable->SetCaptureMask(capture_mask);
+  } else {
+    variable->SetTypeOnly();
+  }
+}
+
 HRESULT DbgStackFrame::PopulateStackFrame(
     StackFrame *stack_frame, int stack_frame_size,
-    IEvalCoordinator *eval_coordinator) const {
+    const CaptureLimits &limits, IEvalCoordinator *eval_coordinator) const {
   if (!stack_frame || !eval_coordinator) {
     return E_INVALIDARG;
   }
@@ -827,7 +1067,7 @@ HRESULT DbgStackFrame::PopulateStackFrame(
   location->set_line(line_number_);
   location->set_path(file_name_);
 
-  queue<VariableWrapper> bfs_queue;
+  VariableQueue &bfs_queue = *VariableQueue::GetThreadQueue();
 
   // Processes the local variables and put them into the BFS queue.
   for (const auto &variable_tuple : variables_) {
@@ -840,7 +1080,9 @@ HRESULT DbgStackFrame::PopulateStackFrame(
       continue;
     }
 
-    bfs_queue.push(VariableWrapper(variable_proto, variable_value));
+    VariableWrapper variable(variable_proto, variable_value);
+    ApplyCaptureMask(limits, &variable);
+    bfs_queue.push(std::move(variable));
   }
 
   // Processes the method arguments and put them into the BFS queue.
@@ -854,17 +1096,16 @@ HRESULT DbgStackFrame::PopulateStackFrame(
       continue;
     }
 
-    bfs_queue.push(VariableWrapper(variable_proto, variable_value));
+    VariableWrapper variable(variable_proto, variable_value);
+    ApplyCaptureMask(limits, &variable);
+    bfs_queue.push(std::move(variable));
   }
 
   if (bfs_queue.size() != 0) {
-    return VariableWrapper::PerformBFS(&bfs_queue,
-                                       [stack_frame, stack_frame_size]() {
-                                         // Terminates the BFS if stack frame
-                                         // reaches the maximum size.
-                                         return stack_frame->ByteSize() >
-                                                stack_frame_size;
-                                       },
+    // Terminates the BFS if stack frame reaches the maximum size.
+    SnapshotSizeTracker size_tracker(stack_frame->ByteSizeLong(),
+                                     stack_frame_size);
+    return VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
                                        eval_coordinator);
   }
 
@@ -889,6 +1130,8 @@ HRESULT DbgStackFrame::GetLocalVariable(const std::string &variable_name,
     // If we found a match, we'll create a DbgObject and return it.
     hr = S_OK;
     if (local_var != variables_.end()) {
+      CreateDeferredVariable(local_var - variables_.begin(), &variables_,
+                             &deferred_variable_values_);
       *dbg_object = std::get<1>(*local_var);
       return S_OK;
     }
@@ -903,6 +1146,9 @@ HRESULT DbgStackFrame::GetLocalVariable(const std::string &variable_name,
       });
 
   if (method_arg != method_arguments_.end()) {
+    CreateDeferredVariable(method_arg - method_arguments_.begin(),
+                           &method_arguments_,
+                           &deferred_method_argument_values_);
     *dbg_object = std::get<1>(*method_arg);
     return S_OK;
   }
@@ -910,6 +1156,82 @@ HRESULT DbgStackFrame::GetLocalVariable(const std::string &variable_name,
   return S_FALSE;
 }
 
+HRESULT DbgStackFrame::GetLocalVariableSlot(const std::string &variable_name,
+                                            VariableSlot *slot) {
+  static const std::string this_var = "this";
+  if (is_async_method_) {
+    return S_FALSE;
+  }
+
+  // Searches in the same order as GetLocalVariable. A local constant
+  // shadows the method arguments but has no slot.
+  if (variable_name.compare(this_var) != 0) {
+    auto local_var = std::find_if(
+        variables_.begin(), variables_.end(),
+        [&variable_name](const VariableTuple &variable_tuple) {
+          return variable_name.compare(std::get<0>(variable_tuple)) == 0;
+        });
+    if (local_var != variables_.end()) {
+      auto local_slot = std::find(local_variable_indices_.begin(),
+                                  local_variable_indices_.end(),
+                                  local_var - variables_.begin());
+      if (local_slot == local_variable_indices_.end()) {
+        return S_FALSE;
+      }
+
+      slot->kind = VariableSlot::Kind::kLocalVariable;
+      slot->index = local_slot - local_variable_indices_.begin();
+      return S_OK;
+    }
+  }
+
+  auto method_arg = std::find_if(
+      method_arguments_.begin(), method_arguments_.end(),
+      [&variable_name](const VariableTuple &variable_tuple) {
+        return variable_name.compare(std::get<0>(variable_tuple)) == 0;
+      });
+  if (method_arg == method_arguments_.end()) {
+    return S_FALSE;
+  }
+
+  slot->kind = VariableSlot::Kind::kMethodArgument;
+  slot->index = method_arg - method_arguments_.begin();
+  return S_OK;
+}
+
+HRESULT DbgStackFrame::GetLocalVariableBySlot(
+    const VariableSlot &slot, std::shared_ptr<DbgObject> *dbg_object) {
+  if (is_async_method_) {
+    return S_FALSE;
+  }
+
+  switch (slot.kind) {
+    case VariableSlot::Kind::kLocalVariable: {
+      if (slot.index >= local_variable_indices_.size() ||
+          local_variable_indices_[slot.index] < 0) {
+        return S_FALSE;
+      }
+
+      size_t index = local_variable_indices_[slot.index];
+      CreateDeferredVariable(index, &variables_, &deferred_variable_values_);
+      *dbg_object = std::get<1>(variables_[index]);
+      return S_OK;
+    }
+    case VariableSlot::Kind::kMethodArgument: {
+      if (slot.index >= method_arguments_.size()) {
+        return S_FALSE;
+      }
+
+      CreateDeferredVariable(slot.index, &method_arguments_,
+                             &deferred_method_argument_values_);
+      *dbg_object = std::get<1>(method_arguments_[slot.index]);
+      return S_OK;
+    }
+    default:
+      return S_FALSE;
+  }
+}
+
 // TODO(quoct): This only finds members defined directly in a class or an
 // interface. Therefore, inherited fields won't be found.
 HRESULT DbgStackFrame::GetFieldAndAutoPropFromFrame(
@@ -952,17 +1274,21 @@ HRESULT DbgStackFrame::GetFieldAndAutoPropFromFrame(
       // If we are inside a generic class, ICorDebugClass will not be able to
       // get us the static field value. This is because it only represents
       // an uninstantiated class. So we have to construct an ICorDebugType
-      // for the instantiated type using class_generic_types_.
-      CComPtr<ICorDebugType> class_type;
-      hr = debug_helper_->GetInstantiatedClassType(
-          debug_class, &class_generic_types_, &class_type, err_stream);
-      if (FAILED(hr)) {
-        *err_stream << "Failed to get instantiated type from ICorDebugClass.";
-        return hr;
+      // for the instantiated type using class_generic_types_. The type is
+      // kept for the other static fields read from this frame.
+      if (!instantiated_class_type_) {
+        hr = debug_helper_->GetInstantiatedClassType(
+            debug_class, &class_generic_types_, &instantiated_class_type_,
+            err_stream);
+        if (FAILED(hr)) {
+          *err_stream
+              << "Failed to get instantiated type from ICorDebugClass.";
+          return hr;
+        }
       }
 
-      hr =
-          class_type->GetStaticFieldValue(field_def, debug_frame, &field_value);
+      hr = instantiated_class_type_->GetStaticFieldValue(
+          field_def, debug_frame, &field_value);
       if (FAILED(hr)) {
         return hr;
       }
@@ -1033,6 +1359,10 @@ std::shared_ptr<DbgObject> DbgStackFrame::GetThisObject() {
   if (this_obj == method_arguments_.end()) {
     return std::shared_ptr<DbgObject>();
   }
+
+  CreateDeferredVariable(this_obj - method_arguments_.begin(),
+                         &method_arguments_,
+                         &deferred_method_argument_values_);
   return std::get<1>(*this_obj);
 }
 
@@ -1076,6 +1406,35 @@ HRESULT DbgStackFrame::GetPropertyFromClass(
       ->SetTypeSignature(metadata_import, generic_signatures);
 }
 
+void DbgStackFrame::CreateDeferredVariables() {
+  for (size_t i = 0; i < deferred_variable_values_.size(); ++i) {
+    CreateDeferredVariable(i, &variables_, &deferred_variable_values_);
+  }
+
+  for (size_t i = 0; i < deferred_method_argument_values_.size(); ++i) {
+    CreateDeferredVariable(i, &method_arguments_,
+                           &deferred_method_argument_values_);
+  }
+}
+
+void DbgStackFrame::CreateDeferredVariable(
+    size_t index, std::vector<VariableTuple> *variables,
+    std::vector<CComPtr<ICorDebugValue>> *debug_values) {
+  if (index >= debug_values->size() || !(*debug_values)[index]) {
+    return;
+  }
+
+  unique_ptr<DbgObject> value;
+  HRESULT hr = obj_factory_->CreateDbgObject(
+      (*debug_values)[index], object_depth_, &value, &std::cerr);
+  if (SUCCEEDED(hr)) {
+    std::get<1>((*variables)[index]) = std::move(value);
+  }
+
+  // Only tries once, like Initialize does.
+  (*debug_values)[index].Release();
+}
+
 void DbgStackFrame::SetObjectInspectionDepth(int depth) {
   object_depth_ = depth;
 }
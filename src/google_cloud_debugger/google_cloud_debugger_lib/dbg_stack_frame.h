@@ -15,21 +15,28 @@
 #ifndef DBG_STACK_FRAME_H_
 #define DBG_STACK_FRAME_H_
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <sstream>
 #include <string>
 #include <tuple>
+#include <vector>
 
+#include "capture_limits.h"
 #include "document_index.h"
 #include "i_dbg_stack_frame.h"
+#include "module_type_dictionary.h"
 #include "type_signature.h"
 
 namespace google_cloud_debugger {
 
 // TODO(quoct): Add error stream into the tuple.
 typedef std::tuple<std::string, std::shared_ptr<DbgObject>> VariableTuple;
+class DbgClassField;
 class IDbgClassMember;
+struct ModuleSnapshot;
 
 // This class is represents a stack frame at a breakpoint.
 // It is used to populate and print out variables and method arguments
@@ -56,10 +63,12 @@ class DbgStackFrame : public IDbgStackFrame {
   // method name, class name, file name and line number.
   // This method may perform function evaluation using eval_coordinator.
   // This method should not fill up the proto stack_frame with more kbs of
-  // information than stack_frame_size.
+  // information than stack_frame_size. The variables are captured within
+  // limits.
   HRESULT PopulateStackFrame(
       google::cloud::diagnostics::debug::StackFrame *stack_frame,
-      int stack_frame_size, IEvalCoordinator *eval_coordinator) const;
+      int stack_frame_size, const CaptureLimits &limits,
+      IEvalCoordinator *eval_coordinator) const;
 
   // Gets a local variable or method arguments with name
   // variable_name.
@@ -67,6 +76,17 @@ class DbgStackFrame : public IDbgStackFrame {
                            std::shared_ptr<DbgObject> *dbg_object,
                            std::ostream *err_stream);
 
+  // Finds the IL slot of the local variable or the index of the method
+  // argument with name variable_name. Variables of async methods have no
+  // slots since they are fields of the state machine.
+  HRESULT GetLocalVariableSlot(const std::string &variable_name,
+                               VariableSlot *slot) override;
+
+  // Gets the local variable or method argument in slot.
+  HRESULT GetLocalVariableBySlot(
+      const VariableSlot &slot,
+      std::shared_ptr<DbgObject> *dbg_object) override;
+
   // Gets out any field or auto-implemented property with the name
   // member_name of the class this frame is in.
   HRESULT GetFieldAndAutoPropFromFrame(const std::string &member_name,
@@ -127,6 +147,42 @@ class DbgStackFrame : public IDbgStackFrame {
   // Sets how deep an object will be inspected.
   void SetObjectInspectionDepth(int depth);
 
+  // Sets whether Initialize defers creating the DbgObjects of local
+  // variables and method arguments until they are looked up by
+  // GetLocalVariable or created by CreateDeferredVariables. This keeps
+  // a condition that only reads a few variables from creating all of them.
+  void SetDeferVariableCreation(bool defer) {
+    defer_variable_creation_ = defer;
+  }
+
+  // Sets the type dictionary of the module this frame is in, which is
+  // shared with the other frames in the module. If it is not set, the
+  // frame builds its own dictionary when it first looks up a class.
+  void SetTypeDictionary(std::shared_ptr<ModuleTypeDictionary> dictionary) {
+    type_dictionary_ = dictionary;
+  }
+
+  // Sets the snapshot of the loaded modules. If it is set, the module of
+  // a class from another assembly is looked up in it before asking the
+  // app domain.
+  void SetModules(std::shared_ptr<const ModuleSnapshot> modules) {
+    modules_ = std::move(modules);
+  }
+
+  // Sets the indices of the local scopes that the variable and constant
+  // infos passed to Initialize come from. If they are set, the names of
+  // the arguments and local variables and the decoded constants of the
+  // method are cached by module, method and scopes, and the next frames
+  // at the same scopes only read the values from the frame.
+  void SetLocalScopeIndices(std::vector<std::uint32_t> scope_indices) {
+    local_scope_indices_ = std::move(scope_indices);
+    has_local_scope_indices_ = true;
+  }
+
+  // Creates the DbgObjects whose creation was deferred. Has to be called
+  // before PopulateStackFrame and while the debuggee is still stopped.
+  void CreateDeferredVariables();
+
   // Sets the name of the file this stack frame is in.
   void SetFile(const std::string &file_name) { file_name_ = file_name; }
 
@@ -210,6 +266,19 @@ class DbgStackFrame : public IDbgStackFrame {
   // Returns true if the method this frame is in is an async method.
   bool IsAsyncMethod() { return is_async_method_; }
 
+  // Returns the state machine of the async method this frame is in, or
+  // null. It is only valid while the debuggee is stopped.
+  ICorDebugValue *GetAsyncStateMachine() { return async_state_machine_; }
+
+  // Removes the cached async state machine layouts of the classes of the
+  // module of metadata_import, which is being unloaded.
+  static void RemoveAsyncStateMachineLayouts(
+      IMetaDataImport *metadata_import);
+
+  // Removes the cached frame layouts of the methods of the module of
+  // metadata_import, which is being unloaded.
+  static void RemoveMethodFrameLayouts(IMetaDataImport *metadata_import);
+
   // Gets the ICorDebugFunction that corresponds with method represented by
   // method_info in the class class_token. This function will
   // also check the methods against the arguments vector to
@@ -252,6 +321,10 @@ class DbgStackFrame : public IDbgStackFrame {
   // Type Signature of the generic types of the class the frame is in.
   std::vector<TypeSignature> generic_type_signatures_;
 
+  // The class the frame is in, instantiated with class_generic_types_.
+  // It is created by the first static field read from a generic class.
+  CComPtr<ICorDebugType> instantiated_class_type_;
+
   // Gets the metadata import of the module this frame is in.
   // We cannot store the IMetaDataImport directly because
   // they may be invalidated.
@@ -262,28 +335,102 @@ class DbgStackFrame : public IDbgStackFrame {
   HRESULT InitializeClassGenericTypeParameters(IMetaDataImport *metadata_import,
                                                ICorDebugILFrame *debug_frame);
 
-  // Extract local variables from local_enum.
-  // DbgBreakpoint object is used to get the variables' names.
-  HRESULT ProcessLocalVariables(
-      ICorDebugValueEnum *local_enum,
+  // The name of the local variable in an IL slot.
+  struct LocalVariableName {
+    // Empty if the PDB does not name the slot.
+    std::string name;
+
+    // True if the variable should be hidden from the debugger.
+    bool hidden = false;
+  };
+
+  // A local constant, decoded from its signature in the PDB by
+  // ICorDebugHelper::ProcessConstantSigBlob.
+  struct LocalConstant {
+    std::string name;
+
+    CorElementType type = CorElementType::ELEMENT_TYPE_END;
+
+    // The bytes of the value, copied out of the signature.
+    std::vector<std::uint8_t> value;
+
+    // The length of a string value in characters.
+    ULONG value_len = 0;
+
+    // True if the constant is an enum whose type is encoded_enum_token.
+    bool is_enum = false;
+    ULONG encoded_enum_token = 0;
+  };
+
+  // What a frame needs from the metadata and the PDB to read its values:
+  // the names of the arguments and local variables and the decoded local
+  // constants of a method at a set of local scopes. It is built once and
+  // kept across breakpoint hits.
+  struct MethodFrameLayout {
+    // Keeps the metadata import alive, so that its address is not reused
+    // by another module while the layout is cached.
+    CComPtr<IMetaDataImport> metadata_import;
+
+    // The class the method is in.
+    mdTypeDef class_token = 0;
+
+    bool is_static_method = false;
+
+    // Names of the arguments, starting with "this" if the method is not
+    // static.
+    std::vector<std::string> argument_names;
+
+    // Names of the local variables, indexed by IL slot.
+    std::vector<LocalVariableName> local_variable_names;
+
+    std::vector<LocalConstant> local_constants;
+  };
+
+  // Key of a method frame layout: the metadata import, the method token
+  // and the indices of the local scopes.
+  typedef std::tuple<IMetaDataImport *, mdMethodDef,
+                     std::vector<std::uint32_t>>
+      MethodFrameKey;
+
+  // Builds the layout of method_token from its metadata and from the
+  // variable and constant infos of the PDB.
+  HRESULT BuildMethodFrameLayout(
       const std::vector<google_cloud_debugger_portable_pdb::LocalVariableInfo>
-          &variable_infos);
+          &variable_infos,
+      const std::vector<google_cloud_debugger_portable_pdb::LocalConstantInfo>
+          &constant_infos,
+      mdMethodDef method_token, IMetaDataImport *metadata_import,
+      MethodFrameLayout *layout);
 
-  // Parses the local constant from constant_infos.
-  HRESULT ProcessLocalConstants(
+  // Gets the layout of method_token from the cache, building it if it is
+  // not there. The layout is only cached if the local scope indices are
+  // set.
+  HRESULT GetMethodFrameLayout(
+      const std::vector<google_cloud_debugger_portable_pdb::LocalVariableInfo>
+          &variable_infos,
       const std::vector<google_cloud_debugger_portable_pdb::LocalConstantInfo>
-          &constant_infos);
+          &constant_infos,
+      mdMethodDef method_token, IMetaDataImport *metadata_import,
+      std::shared_ptr<const MethodFrameLayout> *layout);
+
+  // Extract local variables from local_enum.
+  // The names of the variables are looked up by slot in layout.
+  HRESULT ProcessLocalVariables(ICorDebugValueEnum *local_enum,
+                                const MethodFrameLayout &layout);
+
+  // Creates the local constants of layout.
+  HRESULT ProcessLocalConstants(const MethodFrameLayout &layout);
 
-  // Parses local constant that is an enum.
-  HRESULT ProcessLocalEnumConstant(
-      const std::string &constant_name, const CorElementType &enum_type,
-      ULONG64 enum_value, const std::vector<uint8_t> &enum_metadata_buffer);
+  // Creates local constant that is an enum. The enum class is given by
+  // encoded_token.
+  HRESULT ProcessLocalEnumConstant(const std::string &constant_name,
+                                   const CorElementType &enum_type,
+                                   ULONG64 enum_value, ULONG encoded_token);
 
   // Extract method arguments from method_arg_enum.
-  // DbgBreakpoint and IMetaDataImport objects are used
-  // to get the variables' names.
+  // The names of the arguments are taken from layout.
   HRESULT ProcessMethodArguments(ICorDebugValueEnum *method_arg_enum,
-                                 mdMethodDef method_token,
+                                 const MethodFrameLayout &layout,
                                  IMetaDataImport *metadata_import);
 
   // Checks whether the method this frame is in is an async method.
@@ -293,20 +440,85 @@ class DbgStackFrame : public IDbgStackFrame {
   HRESULT ProcessAsyncMethod(ICorDebugValue *async_state_obj,
                              IMetaDataImport *metadata_import);
 
-  // Given the fields of the async state machine this frame is in,
-  // populates local variables and method arguments of this stack frame.
-  // Some of the fields of the async state machine represents local
+  // A field of an async state machine that holds a method argument, a
+  // local variable or "this" of the async method.
+  struct HoistedVariable {
+    enum Kind { kArgument, kLocal, kThis };
+
+    Kind kind = kArgument;
+
+    // The name of the argument or local variable.
+    std::string name;
+
+    // The field, initialized without an object (see
+    // DbgClassField::InitializeMetadata).
+    std::shared_ptr<const DbgClassField> field;
+  };
+
+  // The hoisted variables of the state machine class of an async method,
+  // read from its metadata once and kept across breakpoint hits, so that
+  // a hit only reads the values of these fields by token.
+  struct AsyncStateMachineLayout {
+    // Keeps the metadata the fields point into alive.
+    CComPtr<IMetaDataImport> metadata_import;
+
+    // False if the class is not an async state machine.
+    bool is_state_machine = false;
+
+    // The hoisted variables, in the order of the metadata.
+    std::vector<HoistedVariable> variables;
+  };
+
+  // Key of an async state machine layout.
+  typedef std::pair<IMetaDataImport *, mdTypeDef> AsyncStateMachineKey;
+
+  // Reads the hoisted variables of the class this frame is in into
+  // layout. Some of the fields of the async state machine represent local
   // variables and method arguments.
   // If the field doesn't start with "<", then it is just a method argument.
   // If the field is <>4__this, then the field represents "this" object.
   // If the field is <name>5__1, <name>5__2, etc., then it represents
   // a local variable.
-  // Note that fields do not contain constant local variable..
+  // The other fields, for example the state and the awaiters, are
+  // skipped. Note that fields do not contain constant local variables.
+  HRESULT BuildAsyncStateMachineLayout(IMetaDataImport *metadata_import,
+                                       AsyncStateMachineLayout *layout);
+
+  // Gets the layout of the class this frame is in from the cache,
+  // building it if it is not there.
+  HRESULT GetAsyncStateMachineLayout(
+      IMetaDataImport *metadata_import,
+      std::shared_ptr<const AsyncStateMachineLayout> *layout);
+
+  // Populates local variables and method arguments of this stack frame
+  // with the values of the hoisted variables of layout in the state
+  // machine object_value, whose class is debug_class and whose exact type
+  // is debug_type (which may be null).
   void ProcessAsyncVariablesAndMethodArgs(
-      const std::vector<std::shared_ptr<IDbgClassMember>> &async_fields);
-
-  // Populates the type_def_dict_ and type_ref_dict_ with all
-  // the types loaded in this frame.
+      const AsyncStateMachineLayout &layout,
+      ICorDebugObjectValue *object_value, ICorDebugClass *debug_class,
+      ICorDebugType *debug_type);
+
+  // Cache of async state machine layouts. It is cleared once it has
+  // kMaximumCachedClassLayouts layouts.
+  static std::map<AsyncStateMachineKey,
+                  std::shared_ptr<const AsyncStateMachineLayout>>
+      async_state_machine_layouts_;
+
+  // Protects async_state_machine_layouts_, which frames captured on
+  // different threads share.
+  static std::mutex async_state_machine_layouts_mutex_;
+
+  // Cache of method frame layouts. It is cleared once it has
+  // kMaximumCachedMethodFrameLayouts layouts.
+  static std::map<MethodFrameKey, std::shared_ptr<const MethodFrameLayout>>
+      method_frame_layouts_;
+
+  // Protects method_frame_layouts_.
+  static std::mutex method_frame_layouts_mutex_;
+
+  // Populates type_dictionary_ with all the types of the module
+  // this frame is in.
   HRESULT PopulateTypeDict();
 
   // Populate debug_assemblies_ with all loaded assemblies
@@ -330,12 +542,35 @@ class DbgStackFrame : public IDbgStackFrame {
                                       ULONG *signature_len,
                                       std::ostream *err_stream);
 
+  // Creates the DbgObject of the variable at index of variables if
+  // debug_values has its deferred ICorDebugValue at the same index.
+  void CreateDeferredVariable(
+      size_t index, std::vector<VariableTuple> *variables,
+      std::vector<CComPtr<ICorDebugValue>> *debug_values);
+
   // Tuple that contains variable's name, variable's value and the error stream.
   std::vector<VariableTuple> variables_;
 
   // Tuple that contains method argument's name, value and the error stream.
   std::vector<VariableTuple> method_arguments_;
 
+  // Index in variables_ of the local variable in each IL slot, or -1 if
+  // the variable is hidden.
+  std::vector<int> local_variable_indices_;
+
+  // ICorDebugValues of the entries of variables_ and method_arguments_
+  // at the same index whose DbgObjects are not created yet.
+  std::vector<CComPtr<ICorDebugValue>> deferred_variable_values_;
+  std::vector<CComPtr<ICorDebugValue>> deferred_method_argument_values_;
+
+  // Indices of the local scopes the variable infos of this frame come
+  // from, if has_local_scope_indices_ is true.
+  std::vector<std::uint32_t> local_scope_indices_;
+  bool has_local_scope_indices_ = false;
+
+  // True if Initialize defers creating DbgObjects of variables.
+  bool defer_variable_creation_ = false;
+
   // Determines how deep to inspect the object.
   int object_depth_ = kDefaultObjectEvalDepth;
 
@@ -366,6 +601,9 @@ class DbgStackFrame : public IDbgStackFrame {
   // True if this frame is in an async method.
   bool is_async_method_ = false;
 
+  // The state machine of the async method this frame is in, or null.
+  CComPtr<ICorDebugValue> async_state_machine_;
+
   // Returns true if this is an IL frame that has been processed.
   // This is set after a successful call to Initialize.
   bool is_processed_il_frame_ = false;
@@ -379,21 +617,11 @@ class DbgStackFrame : public IDbgStackFrame {
   // The module this stack frame is in.
   CComPtr<ICorDebugModule> debug_module_;
 
-  // Dictionary whose key is class name and whose value
-  // is the metadata token mdTypeDef of that class.
-  std::map<std::string, mdTypeDef> type_def_dict_;
-
-  // Dictionary whose key is class name and whose value
-  // is the metadata token mdTypeRef of that class.
-  // The difference between mdTypeDef and mdTypeRef
-  // is that mdTypeDef type is found in the current module
-  // whereas mdTypeRef is found in other modules.
-  // Hence, mdTypeRef may needs to be resolved to mdTypeDef
-  // when needed.
-  std::map<std::string, mdTypeRef> type_ref_dict_;
-
-  // True if type_def_dict_ and type_ref_dict_ have been populated.
-  bool type_dict_populated_ = false;
+  // Names of the types of the module this frame is in.
+  std::shared_ptr<ModuleTypeDictionary> type_dictionary_;
+
+  // Snapshot of the loaded modules, or null.
+  std::shared_ptr<const ModuleSnapshot> modules_;
 
   // Cache of loaded debug assemblies.
   std::vector<CComPtr<ICorDebugAssembly>> debug_assemblies_;
@@ -62,6 +62,65 @@ HRESULT DbgString::PopulateValue(Variable *variable) {
   return S_OK;
 }
 
+HRESULT DbgString::PopulateValueWithinLimits(Variable *variable,
+                                             const CaptureLimits &limits) {
+  if (string_obj_set_ || limits.max_string_length == 0) {
+    return PopulateValue(variable);
+  }
+
+  if (!variable) {
+    return E_INVALIDARG;
+  }
+
+  if (FAILED(initialize_hr_)) {
+    return initialize_hr_;
+  }
+
+  if (GetIsNull()) {
+    variable->clear_value();
+    return S_OK;
+  }
+
+  CComPtr<ICorDebugStringValue> debug_string;
+  HRESULT hr = GetStringValue(&debug_string);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // Every character takes at least a byte, so one more character than
+  // the limit is enough for the caller to truncate the value.
+  ULONG32 length;
+  string prefix;
+  hr = debug_helper_->ExtractStringPrefixFromICorDebugStringValue(
+      debug_string, limits.max_string_length + 1, &prefix, &length,
+      GetErrorStream());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (length <= limits.max_string_length + 1) {
+    // The whole string was read, so keep it for expressions.
+    string_obj_ = prefix;
+    string_obj_set_ = true;
+    variable->set_value(string_obj_);
+    return S_OK;
+  }
+
+  variable->set_value(prefix);
+  variable->mutable_status()->set_message(
+      "Only the beginning of the string of " + std::to_string(length) +
+      " characters was captured.");
+  return S_OK;
+}
+
+bool DbgString::CaptureValue() {
+  if (FAILED(initialize_hr_)) {
+    return false;
+  }
+
+  return GetIsNull() || SUCCEEDED(ExtractStringFromReference());
+}
+
 HRESULT DbgString::GetTypeString(std::string *type_string) {
   if (!type_string) {
     return E_INVALIDARG;
@@ -72,6 +131,22 @@ HRESULT DbgString::GetTypeString(std::string *type_string) {
 }
 
 HRESULT DbgString::GetString(DbgObject *object, string *returned_string) {
+  if (returned_string == nullptr) {
+    return E_INVALIDARG;
+  }
+
+  const string *string_reference;
+  HRESULT hr = GetStringReference(object, &string_reference);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  *returned_string = *string_reference;
+  return S_OK;
+}
+
+HRESULT DbgString::GetStringReference(DbgObject *object,
+                                      const string **returned_string) {
   if (object == nullptr || returned_string == nullptr) {
     return E_INVALIDARG;
   }
@@ -86,7 +161,7 @@ HRESULT DbgString::GetString(DbgObject *object, string *returned_string) {
     return hr;
   }
 
-  *returned_string = dbg_string->string_obj_;
+  *returned_string = &dbg_string->string_obj_;
   return S_OK;
 }
 
@@ -99,9 +174,29 @@ HRESULT DbgString::ExtractStringFromReference() {
     return E_INVALIDARG;
   }
 
+  CComPtr<ICorDebugStringValue> debug_string;
+  HRESULT hr = GetStringValue(&debug_string);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  hr = debug_helper_->ExtractStringFromICorDebugStringValue(
+      debug_string, &string_obj_, GetErrorStream());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  string_obj_set_ = true;
+  return S_OK;
+}
+
+HRESULT DbgString::GetStringValue(ICorDebugStringValue **debug_string) {
+  if (!object_handle_) {
+    return E_INVALIDARG;
+  }
+
   HRESULT hr;
   CComPtr<ICorDebugValue> debug_value;
-  CComPtr<ICorDebugStringValue> debug_string;
 
   hr = object_handle_->Dereference(&debug_value);
 
@@ -111,20 +206,13 @@ HRESULT DbgString::ExtractStringFromReference() {
   }
 
   hr = debug_value->QueryInterface(__uuidof(ICorDebugStringValue),
-                                   reinterpret_cast<void **>(&debug_string));
+                                   reinterpret_cast<void **>(debug_string));
 
   if (FAILED(hr)) {
     WriteError("Failed to convert to ICorDebugStringValue.");
     return hr;
   }
 
-  hr = debug_helper_->ExtractStringFromICorDebugStringValue(
-      debug_string, &string_obj_, GetErrorStream());
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  string_obj_set_ = true;
   return S_OK;
 }
 
@@ -46,18 +46,38 @@ class DbgString : public DbgReferenceObject {
   HRESULT PopulateValue(
       google::cloud::diagnostics::debug::Variable *variable) override;
 
+  // Reads only the first limits.max_string_length characters of the
+  // string from the debuggee if it is longer than that, and sets an
+  // informational status with the length of the whole string.
+  HRESULT PopulateValueWithinLimits(
+      google::cloud::diagnostics::debug::Variable *variable,
+      const CaptureLimits &limits) override;
+
   // Sets type of variable to System.String.
   HRESULT GetTypeString(std::string *type_string) override;
 
+  // Extracts the string from the handle so that PopulateValue does
+  // not need the debuggee.
+  bool CaptureValue() override;
+
   // Extracts string from DbgObject.
   // Fails if DbgObject is not a DbgString.
   static HRESULT GetString(DbgObject *object, std::string *returned_string);
 
+  // Points returned_string to the string of DbgObject without copying
+  // it. The string is owned by object.
+  // Fails if DbgObject is not a DbgString.
+  static HRESULT GetStringReference(DbgObject *object,
+                                    const std::string **returned_string);
+
  private:
   // Dereferences the string handle and extracts out the string
   // into string_obj_. Will not do anything if string_obj_set_ is true.
   HRESULT ExtractStringFromReference();
 
+  // Dereferences the string handle into debug_string.
+  HRESULT GetStringValue(ICorDebugStringValue **debug_string);
+
   // The underlying string object.
   std::string string_obj_;
 
@@ -0,0 +1,126 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "debuggee_memory_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "constants.h"
+
+namespace google_cloud_debugger {
+
+thread_local DebuggeeMemoryCache *DebuggeeMemoryCache::current_ = nullptr;
+
+HRESULT DebuggeeMemoryCache::ReadMemory(ICorDebugProcess *debug_process,
+                                        CORDB_ADDRESS address,
+                                        std::size_t size, BYTE *buffer) {
+  DebuggeeMemoryCache *cache = GetCurrent();
+  if (cache) {
+    return cache->Read(debug_process, address, size, buffer);
+  }
+
+  return ReadUncached(debug_process, address, size, buffer);
+}
+
+HRESULT DebuggeeMemoryCache::Read(ICorDebugProcess *debug_process,
+                                  CORDB_ADDRESS address, std::size_t size,
+                                  BYTE *buffer) {
+  if (!debug_process || !buffer || address == 0) {
+    return E_INVALIDARG;
+  }
+
+  if (size == 0) {
+    return S_OK;
+  }
+
+  const CORDB_ADDRESS page_mask =
+      ~static_cast<CORDB_ADDRESS>(kDebuggeeMemoryPageSize - 1);
+  CORDB_ADDRESS first_page = address & page_mask;
+  CORDB_ADDRESS last_page = (address + size - 1) & page_mask;
+  std::size_t page_count =
+      (last_page - first_page) / kDebuggeeMemoryPageSize + 1;
+  if (page_count > kMaximumCachedDebuggeeMemoryReadPages) {
+    return ReadUncached(debug_process, address, size, buffer);
+  }
+
+  if (pages_.size() + page_count > kMaximumCachedDebuggeeMemoryPages) {
+    pages_.clear();
+  }
+
+  // Reads each run of pages that are not cached with one call.
+  CORDB_ADDRESS page = first_page;
+  while (page <= last_page) {
+    if (pages_.find(page) != pages_.end()) {
+      page += kDebuggeeMemoryPageSize;
+      continue;
+    }
+
+    CORDB_ADDRESS run_end = page + kDebuggeeMemoryPageSize;
+    while (run_end <= last_page && pages_.find(run_end) == pages_.end()) {
+      run_end += kDebuggeeMemoryPageSize;
+    }
+
+    std::vector<BYTE> run_memory(run_end - page);
+    SIZE_T read = 0;
+    HRESULT hr = debug_process->ReadMemory(page, run_memory.size(),
+                                           run_memory.data(), &read);
+    if (FAILED(hr) || read != run_memory.size()) {
+      // A page around the requested bytes may not be readable, so only
+      // the bytes themselves are read.
+      return ReadUncached(debug_process, address, size, buffer);
+    }
+
+    for (CORDB_ADDRESS offset = 0; offset < run_memory.size();
+         offset += kDebuggeeMemoryPageSize) {
+      pages_[page + offset].assign(
+          run_memory.begin() + offset,
+          run_memory.begin() + offset + kDebuggeeMemoryPageSize);
+    }
+    page = run_end;
+  }
+
+  CORDB_ADDRESS current = address;
+  std::size_t copied = 0;
+  while (copied < size) {
+    CORDB_ADDRESS current_page = current & page_mask;
+    std::size_t page_offset = current - current_page;
+    std::size_t to_copy =
+        std::min(size - copied, kDebuggeeMemoryPageSize - page_offset);
+    memcpy(buffer + copied, pages_[current_page].data() + page_offset,
+           to_copy);
+    copied += to_copy;
+    current += to_copy;
+  }
+
+  return S_OK;
+}
+
+HRESULT DebuggeeMemoryCache::ReadUncached(ICorDebugProcess *debug_process,
+                                          CORDB_ADDRESS address,
+                                          std::size_t size, BYTE *buffer) {
+  if (!debug_process || !buffer) {
+    return E_INVALIDARG;
+  }
+
+  SIZE_T read = 0;
+  HRESULT hr = debug_process->ReadMemory(address, size, buffer, &read);
+  if (FAILED(hr) || read != size) {
+    return E_FAIL;
+  }
+
+  return S_OK;
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,86 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEBUGGEE_MEMORY_CACHE_H_
+#define DEBUGGEE_MEMORY_CACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "ccomptr.h"
+#include "cor.h"
+#include "cordebug.h"
+
+namespace google_cloud_debugger {
+
+// The pages of debuggee memory read while a debuggee thread is stopped at
+// breakpoints, by their address. Objects next to each other, like the
+// items of an array and the objects they were allocated with, are then
+// read with one ICorDebugProcess::ReadMemory call.
+//
+// The memory is only valid while the debuggee is stopped, so the cache is
+// cleared before every function evaluation and once the hit is done. It
+// keeps at most kMaximumCachedDebuggeeMemoryPages pages, and reads that
+// span more than kMaximumCachedDebuggeeMemoryReadPages pages are not
+// cached.
+class DebuggeeMemoryCache {
+ public:
+  DebuggeeMemoryCache() = default;
+  DebuggeeMemoryCache(const DebuggeeMemoryCache &) = delete;
+  DebuggeeMemoryCache &operator=(const DebuggeeMemoryCache &) = delete;
+
+  // Returns the cache of the hit the calling thread is processing, or
+  // null if there is none.
+  static DebuggeeMemoryCache *GetCurrent() { return current_; }
+
+  // Sets the cache of the hit the calling thread is processing.
+  static void SetCurrent(DebuggeeMemoryCache *cache) { current_ = cache; }
+
+  // Reads size bytes at address from debug_process into buffer, through
+  // the cache of the calling thread if it has one. Returns E_FAIL unless
+  // all of the bytes are read.
+  static HRESULT ReadMemory(ICorDebugProcess *debug_process,
+                            CORDB_ADDRESS address, std::size_t size,
+                            BYTE *buffer);
+
+  // Reads size bytes at address into buffer from the cached pages,
+  // reading the pages that are not cached from debug_process. Returns
+  // E_FAIL unless all of the bytes are read.
+  HRESULT Read(ICorDebugProcess *debug_process, CORDB_ADDRESS address,
+               std::size_t size, BYTE *buffer);
+
+  // Clears the cache.
+  void Clear() { pages_.clear(); }
+
+  // Returns the number of pages cached.
+  std::size_t GetPageCount() const { return pages_.size(); }
+
+ private:
+  // Reads size bytes at address from debug_process into buffer without
+  // the cache.
+  static HRESULT ReadUncached(ICorDebugProcess *debug_process,
+                              CORDB_ADDRESS address, std::size_t size,
+                              BYTE *buffer);
+
+  // The pages read, by their address.
+  std::map<CORDB_ADDRESS, std::vector<BYTE>> pages_;
+
+  // The cache of the hit each thread is processing.
+  static thread_local DebuggeeMemoryCache *current_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  DEBUGGEE_MEMORY_CACHE_H_
@@ -22,7 +22,11 @@
 #include "cordebug.h"
 #include "dbgshim.h"
 #include "debugger_callback.h"
+#include "directory_listing.h"
 #include "i_cor_debug_helper.h"
+#include "metrics.h"
+#include "string_stream_wrapper.h"
+#include "symbol_store_pdb_provider.h"
 
 #ifdef PLATFORM_UNIX
 // PAL is Platform Adaptation Layer which provides an abstraction
@@ -114,12 +118,14 @@ HRESULT Debugger::StartDebugging(DWORD process_id, bool kill_proc) {
     cerr << "Failed to initialize debugger_callback_." << endl;
     return hr;
   }
+  debugger_callback_->SetModuleFilter(module_filter_);
 
   // Using the processId, we register for debugging. If the process is ready,
   // it will call the CallbackFunction that we passed to
   // RegisterForRuntimeStartup.
   proc_id_ = process_id;
   kill_proc_ = kill_proc;
+  DebuggerMetrics::Global().startup.start = std::chrono::steady_clock::now();
   return RegisterForRuntimeStartup(proc_id_, CallbackFunction, this,
                                    &unregister_token_);
 }
@@ -146,6 +152,11 @@ HRESULT Debugger::StartDebugging(vector<WCHAR> command_line) {
     return hr;
   }
 
+  // Parses the PDBs of the application while the runtime starts, so
+  // that its breakpoints can be set as soon as its modules are loaded.
+  debugger_callback_->WarmPdbs(GetApplicationDirectory(
+      ConvertWCharPtrToString(command_line)));
+
   // Resumes the process.
   hr = ResumeProcess(resume_handle);
   if (FAILED(hr)) {
@@ -217,6 +228,24 @@ void Debugger::CallbackFunction(IUnknown *unknown, void *parameter,
   }
 
   debugger->debugger_callback_->SetDebugProcess(debugger->cordebug_process_);
+  hr = debugger->debugger_callback_->FilterCallbacks();
+  if (FAILED(hr)) {
+    cerr << "Failed to filter the callbacks of process " << process_id
+         << " with HRESULT " << hex << hr << endl;
+  }
+  StartupTimings &startup = DebuggerMetrics::Global().startup;
+  startup.runtime_registration_us.SetSince(startup.start);
+
+  if (debugger->preload_modules_) {
+    hr = debugger->debugger_callback_->LoadExistingModules(
+        debugger->cordebug_process_);
+    if (FAILED(hr)) {
+      cerr << "Failed to load the modules of process " << process_id
+           << " with HRESULT " << hex << hr << endl;
+    }
+  }
+
+  debugger->debugger_callback_->SetAttached();
 }
 
 void Debugger::DeactivateBreakpoints() {
@@ -272,4 +301,12 @@ void Debugger::DeactivateBreakpoints() {
   }
 }
 
+void Debugger::SetSymbolStore(const string &directory,
+                              const string &server_url) {
+  google_cloud_debugger_portable_pdb::PortablePdbFile::SetPdbProvider(
+      std::make_shared<
+          google_cloud_debugger_portable_pdb::SymbolStorePdbProvider>(
+          directory, server_url));
+}
+
 }  // namespace google_cloud_debugger
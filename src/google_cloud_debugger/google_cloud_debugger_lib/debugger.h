@@ -15,10 +15,16 @@
 #ifndef DEBUGGER_H_
 #define DEBUGGER_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "ccomptr.h"
 #include "debugger_callback.h"
+#include "module_filter.h"
+#include "pdb_memory_limiter.h"
+#include "portable_pdb_file.h"
+#include "thread_scheduling.h"
 
 namespace google_cloud_debugger {
 
@@ -66,6 +72,191 @@ class Debugger final {
     debugger_callback_->SetMethodEvaluation(eval);
   }
 
+  // Sets whether log points are formatted and written after the debuggee
+  // is released when they need no evaluation in the debuggee.
+  void SetAsyncLogPoints(bool async_log_points) {
+    debugger_callback_->SetAsyncLogPoints(async_log_points);
+  }
+
+  // Sets whether a hit of a log point is skipped while another hit of
+  // the same log point is processed.
+  void SetCoalesceLogPointHits(bool coalesce) {
+    debugger_callback_->SetCoalesceLogPointHits(coalesce);
+  }
+
+  // Sets whether the messages of breakpoint hits report how much the
+  // hits of their breakpoint cost the debuggee so far.
+  void SetReportBreakpointCosts(bool report_breakpoint_costs) {
+    debugger_callback_->SetReportBreakpointCosts(report_breakpoint_costs);
+  }
+
+  // Sets whether the names of the stack frames that are reported without
+  // variables are resolved in parallel after the stack is walked.
+  void SetParallelStackFrames(bool parallel_stack_frames) {
+    debugger_callback_->SetParallelStackFrames(parallel_stack_frames);
+  }
+
+  // Sets whether the stack frames above an async method that was resumed
+  // after an await are the async methods awaiting it, found through the
+  // continuations of its task, instead of the thread pool that resumed
+  // it.
+  void SetLogicalAsyncStacks(bool logical_async_stacks) {
+    debugger_callback_->SetLogicalAsyncStacks(logical_async_stacks);
+  }
+
+  // Sets how long a single function evaluation can take before it is
+  // aborted.
+  void SetEvaluationTimeout(std::chrono::milliseconds timeout) {
+    debugger_callback_->SetEvaluationTimeout(timeout);
+  }
+
+  // Sets the total time the function evaluations of a breakpoint can
+  // take and how many of them it can make. Zero means no limit.
+  void SetEvaluationBudget(std::chrono::milliseconds time,
+                           std::uint32_t func_evals) {
+    debugger_callback_->SetEvaluationBudget(time, func_evals);
+  }
+
+  // Sets how breakpoint messages are delimited on the pipe. Has to match
+  // the framing used by the agent.
+  void SetMessageFraming(MessageFraming framing) {
+    debugger_callback_->SetMessageFraming(framing);
+  }
+
+  // Sets whether breakpoints are read and written through a single
+  // connection to the agent. Has to match what the agent expects.
+  void SetDuplexPipe(bool duplex) {
+    debugger_callback_->SetDuplexPipe(duplex);
+  }
+
+  // Sets whether the bytes of the duplex pipe go through memory shared
+  // with the agent. Has to match what the agent expects.
+  void SetSharedMemoryPipe(bool shared_memory) {
+    debugger_callback_->SetSharedMemoryPipe(shared_memory);
+  }
+
+  // Sets whether large breakpoint messages are compressed before they
+  // are written to the agent.
+  void SetCompressBreakpoints(bool compress) {
+    debugger_callback_->SetCompressBreakpoints(compress);
+  }
+
+  // Sets whether hits of log points are written to the agent as log
+  // records instead of as breakpoints. Has to match what the agent
+  // expects.
+  void SetLogRecords(bool log_records) {
+    debugger_callback_->SetLogRecords(log_records);
+  }
+
+  // Sets whether the strings that snapshots repeat are written once in
+  // a string table. Has to match what the agent expects.
+  void SetStringTable(bool string_table) {
+    debugger_callback_->SetStringTable(string_table);
+  }
+
+  // Sets whether the variables of a snapshot that did not change since
+  // the previous snapshot of its breakpoint are written as references.
+  // Has to match what the agent expects.
+  void SetDeltaSnapshots(bool delta_snapshots) {
+    debugger_callback_->SetDeltaSnapshots(delta_snapshots);
+  }
+
+  // Sets the file the snapshots captured are recorded to so that
+  // snapshot_benchmark can replay them (see SnapshotRecorder).
+  void SetSnapshotRecordFile(const std::string &path) {
+    debugger_callback_->SetSnapshotRecordFile(path);
+  }
+
+  // Sets whether the runtime only delivers the notifications the
+  // debugger uses. See DebuggerCallback::FilterCallbacks.
+  void SetFilterCallbacks(bool filter) {
+    debugger_callback_->SetFilterCallbacks(filter);
+  }
+
+  // Sets what happens to breakpoint messages when too many of them are
+  // waiting to be written to the agent.
+  void SetBreakpointWriteOverflow(BreakpointWriteOverflow overflow) {
+    debugger_callback_->SetBreakpointWriteOverflow(overflow);
+  }
+
+  // Sets the file breakpoint messages are spilled to while too many of
+  // them are waiting to be written to the agent.
+  void SetSpillFile(const std::string &path) {
+    debugger_callback_->SetSpillFile(path);
+  }
+
+  // Sets the limits the snapshots of breakpoints are captured with.
+  // Applies to breakpoints read from the agent afterwards.
+  void SetCaptureLimits(const CaptureLimits &limits) {
+    debugger_callback_->SetCaptureLimits(limits);
+  }
+
+  // Sets how often the metrics of the debugger are written to the agent.
+  // Zero means they are not written.
+  void SetMetricsInterval(std::chrono::milliseconds interval) {
+    debugger_callback_->SetMetricsInterval(interval);
+  }
+
+  // Sets breakpoints that are used instead of the ones of the agent.
+  // The debugger then runs without an agent: what it would write to the
+  // agent is only serialized.
+  void SetLocalBreakpoints(
+      std::vector<google::cloud::diagnostics::debug::Breakpoint>
+          breakpoints) {
+    debugger_callback_->SetLocalBreakpoints(
+        std::make_shared<
+            const std::vector<google::cloud::diagnostics::debug::Breakpoint>>(
+            std::move(breakpoints)));
+  }
+
+  // Sets whether the modules already loaded in the process are registered
+  // and their PDB files parsed in parallel right after the debugger
+  // attaches, instead of one after the other by the LoadModule callbacks.
+  // Should be called before StartDebugging.
+  void SetPreloadModules(bool preload_modules) {
+    preload_modules_ = preload_modules;
+  }
+
+  // Sets which modules have their PDB files parsed as soon as they are
+  // loaded. The others are only parsed when they are needed. Should be
+  // called before StartDebugging.
+  void SetModuleFilter(const ModuleFilter &module_filter) {
+    module_filter_ = module_filter;
+  }
+
+  // Sets the directory where parsed PDB methods are cached across runs.
+  // Should be called before StartDebugging so that it applies to every
+  // module.
+  void SetPdbIndexCacheDirectory(const std::string &directory) {
+    google_cloud_debugger_portable_pdb::PortablePdbFile::SetIndexCacheDirectory(
+        directory);
+  }
+
+  // Sets how many bytes the parsed methods of every PDB may take before
+  // the ones of the least recently used PDBs are evicted (see
+  // PdbMemoryLimiter). Should be called before StartDebugging.
+  void SetPdbMemoryLimit(std::size_t bytes) {
+    google_cloud_debugger_portable_pdb::PdbMemoryLimiter::Global().SetLimit(
+        bytes);
+  }
+
+  // Pins the background threads of the debugger to cores, if there are
+  // any, and lowers their priority by priority (see ThreadScheduling).
+  // Should be called before StartDebugging.
+  void SetBackgroundThreadScheduling(const std::vector<std::uint32_t> &cores,
+                                     std::uint32_t priority) {
+    ThreadScheduling::Global().SetBackgroundCores(cores);
+    ThreadScheduling::Global().SetBackgroundPriority(priority);
+  }
+
+  // Sets the symbol store directory in which the PDB files of modules
+  // that have neither an embedded PDB nor a PDB file next to them are
+  // looked up, and the http:// URL of the symbol server they are
+  // downloaded from in the background (which may be empty). Should be
+  // called before StartDebugging.
+  void SetSymbolStore(const std::string &directory,
+                      const std::string &server_url);
+
  private:
   // The name of the pipe the debugger will use to communicate with the agent.
   std::string pipe_name_;
@@ -103,6 +294,12 @@ class Debugger final {
 
   // True if we should kill the process upon termination.
   bool kill_proc_;
+
+  // True if the loaded modules are registered when the debugger attaches.
+  bool preload_modules_ = false;
+
+  // Which modules have their PDB files parsed when they are loaded.
+  ModuleFilter module_filter_;
 };
 
 }  // namespace google_cloud_debugger
@@ -16,17 +16,35 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "breakpoint_collection.h"
 #include "ccomptr.h"
+#include "compiler_helpers.h"
 #include "constants.h"
+#include "dbg_class.h"
+#include "dbg_class_property.h"
+#include "dbg_enum.h"
+#include "dbg_object_factory.h"
 #include "dbg_stack_frame.h"
+#include "directory_listing.h"
 #include "cor_debug_helper.h"
+#include "cpu_sampler.h"
 #include "portable_pdb_file.h"
 #include "eval_coordinator.h"
+#include "metadata_cache.h"
+#include "method_info.h"
+#include "object_fields_memory.h"
+#include "metrics.h"
+#include "thread_pool.h"
+#include "trace.h"
 
 using google_cloud_debugger_portable_pdb::IPortablePdbFile;
 using google_cloud_debugger_portable_pdb::PortablePdbFile;
@@ -37,6 +55,12 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+DebuggerCallback::DebuggerCallback(std::string pipe_name)
+    : pipe_name_(pipe_name) {}
+
+// Defined here so that ThreadPool is a complete type.
+DebuggerCallback::~DebuggerCallback() = default;
+
 HRESULT DebuggerCallback::Initialize() {
   if (initialized_success_) {
     return S_OK;
@@ -61,6 +85,24 @@ HRESULT DebuggerCallback::Initialize() {
 
   debug_helper_ = std::shared_ptr<ICorDebugHelper>(new CorDebugHelper());
 
+  // hardware_concurrency returns 0 if it is unknown.
+  uint32_t parsing_threads = std::min<uint32_t>(
+      std::max<uint32_t>(std::thread::hardware_concurrency(), 1),
+      kMaxPdbParsingThreads);
+  pdb_parsing_pool_ = std::unique_ptr<ThreadPool>(
+      new (std::nothrow) ThreadPool(parsing_threads, "pdb_parsing"));
+  if (!pdb_parsing_pool_) {
+    cerr << "Failed to create PDB parsing thread pool.";
+    return E_OUTOFMEMORY;
+  }
+
+  symbol_fetch_pool_ = std::unique_ptr<ThreadPool>(
+      new (std::nothrow) ThreadPool(kMaxSymbolFetchThreads, "symbol_fetch"));
+  if (!symbol_fetch_pool_) {
+    cerr << "Failed to create symbol fetch thread pool.";
+    return E_OUTOFMEMORY;
+  }
+
   initialized_success_ = true;
   return S_OK;
 }
@@ -117,7 +159,8 @@ HRESULT STDMETHODCALLTYPE DebuggerCallback::ExitProcess(ICorDebugProcess *proces
 HRESULT STDMETHODCALLTYPE DebuggerCallback::Breakpoint(
     ICorDebugAppDomain *appdomain, ICorDebugThread *debug_thread,
     ICorDebugBreakpoint *debug_breakpoint) {
-  // If a function evaluation is going on, we don't hit breakpoint.
+  // If a function evaluation is going on on this thread, we don't hit
+  // breakpoint. Other threads are processed as usual.
   // Otherwise, this can lead to infinite loop situation. For example,
   // if a user sets a breakpoint in a getter method of property X and we
   // performs function evaluation to get property X, this breakpoint will
@@ -128,18 +171,27 @@ HRESULT STDMETHODCALLTYPE DebuggerCallback::Breakpoint(
   //
   // Visual Studio also seems to skip a breakpoint if it is hit during function
   // evaluation.
-  if (eval_coordinator_->WaitingForEval()) {
+  CpuSampler::RegisterThread("debugger_callback");
+  if (eval_coordinator_->WaitingForEval(debug_thread)) {
     return appdomain->Continue(FALSE);
   }
 
+  // Measures until the debuggee is continued on return.
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.breakpoint_hits.Increment();
+  ScopedLatencyTimer stop_timer(&metrics.breakpoint_stop_time_us);
+  DEBUGGER_TRACE_SPAN("DebuggerCallback::Breakpoint");
+
   // We will get the IL frame to enumerate and print out all local variables.
   HRESULT hr;
   CComPtr<IMetaDataImport> metadata_import;
 
   mdMethodDef function_token;
   ULONG32 il_offset = 0;
+  CORDB_ADDRESS module_base_address = 0;
   hr = GetFunctionTokenAndILOffset(debug_breakpoint, &function_token,
-                                   &il_offset, &metadata_import);
+                                   &il_offset, &metadata_import,
+                                   &module_base_address);
   if (FAILED(hr)) {
     cerr << "Failed to get function token and IL Offset from breakpoint.";
     appdomain->Continue(FALSE);
@@ -147,8 +199,8 @@ HRESULT STDMETHODCALLTYPE DebuggerCallback::Breakpoint(
   }
 
   hr = breakpoint_collection_->EvaluateAndPrintBreakpoint(
-      function_token, il_offset, eval_coordinator_.get(),
-      debug_thread, portable_pdbs_);
+      module_base_address, function_token, il_offset, eval_coordinator_.get(),
+      debug_thread, module_registry_.GetSnapshot());
   if (FAILED(hr)) {
     cerr << "Failed to get stack frame's information.";
     appdomain->Continue(FALSE);
@@ -161,10 +213,80 @@ HRESULT STDMETHODCALLTYPE DebuggerCallback::Breakpoint(
 HRESULT STDMETHODCALLTYPE
 DebuggerCallback::Exception(ICorDebugAppDomain *appdomain,
                             ICorDebugThread *debug_thread, BOOL unhandled) {
-  eval_coordinator_->HandleException();
+  eval_coordinator_->HandleException(debug_thread);
+  DebuggerMetrics::Global().exceptions.Increment();
+
+  // First-chance exceptions are frequent, so they are continued right
+  // away unless an exception point may want them. Exceptions thrown by
+  // a function evaluation are not captured either.
+  if (!breakpoint_collection_->HasExceptionPoints() ||
+      eval_coordinator_->WaitingForEval(debug_thread)) {
+    return appdomain->Continue(FALSE);
+  }
+
+  CpuSampler::RegisterThread("debugger_callback");
+  HRESULT hr = breakpoint_collection_->EvaluateExceptionPoints(
+      eval_coordinator_.get(), debug_thread, module_registry_.GetSnapshot());
+  if (FAILED(hr)) {
+    cerr << "Failed to evaluate exception points.";
+  }
   return appdomain->Continue(FALSE);
 }
 
+HRESULT DebuggerCallback::FilterCallbacks() {
+  if (!filter_callbacks_ || !debug_process_) {
+    return S_FALSE;
+  }
+
+  HRESULT hr = debug_process_->EnableLogMessages(FALSE);
+  if (FAILED(hr)) {
+    cerr << "Failed to disable log message callbacks: " << std::hex << hr
+         << std::dec << std::endl;
+  }
+
+  std::lock_guard<std::mutex> lock(exception_callbacks_mutex_);
+  callbacks_filtered_ = true;
+  return SetExceptionCallbacks(breakpoint_collection_->HasExceptionPoints());
+}
+
+HRESULT DebuggerCallback::EnableExceptionCallbacks(bool enable) {
+  std::lock_guard<std::mutex> lock(exception_callbacks_mutex_);
+  // Before the callbacks are filtered, the runtime delivers every
+  // exception and FilterCallbacks picks up the exception points.
+  if (!callbacks_filtered_) {
+    return S_FALSE;
+  }
+
+  if (exception_callbacks_ == enable) {
+    return S_OK;
+  }
+  return SetExceptionCallbacks(enable);
+}
+
+HRESULT DebuggerCallback::SetExceptionCallbacks(bool enable) {
+  // No module is marked as user code, so without the exceptions outside
+  // of it the runtime only delivers unhandled exceptions.
+  CComPtr<ICorDebugProcess8> debug_process8;
+  HRESULT hr = debug_process_->QueryInterface(
+      __uuidof(ICorDebugProcess8), reinterpret_cast<void **>(&debug_process8));
+  if (FAILED(hr)) {
+    cerr << "The runtime cannot filter exception callbacks." << std::endl;
+    return hr;
+  }
+
+  hr = debug_process8->EnableExceptionCallbacksOutsideOfMyCode(
+      enable ? TRUE : FALSE);
+  if (FAILED(hr)) {
+    cerr << "Failed to " << (enable ? "enable" : "disable")
+         << " exception callbacks: " << std::hex << hr << std::dec
+         << std::endl;
+    return hr;
+  }
+
+  exception_callbacks_ = enable;
+  return S_OK;
+}
+
 HRESULT STDMETHODCALLTYPE DebuggerCallback::EvalComplete(
     ICorDebugAppDomain *appdomain, ICorDebugThread *debug_thread,
     ICorDebugEval *eval) {
@@ -177,13 +299,31 @@ HRESULT STDMETHODCALLTYPE DebuggerCallback::EvalComplete(
 HRESULT STDMETHODCALLTYPE DebuggerCallback::EvalException(
     ICorDebugAppDomain *appdomain, ICorDebugThread *debug_thread,
     ICorDebugEval *eval) {
-  eval_coordinator_->HandleException();
+  eval_coordinator_->HandleException(debug_thread);
   eval_coordinator_->SignalFinishedEval(debug_thread);
   return appdomain->Continue(FALSE);
 }
 
 HRESULT DebuggerCallback::LoadModule(ICorDebugAppDomain *appdomain,
                                      ICorDebugModule *debug_module) {
+  CpuSampler::RegisterThread("debugger_callback");
+  CORDB_ADDRESS module_base_address = 0;
+  HRESULT hr = debug_module->GetBaseAddress(&module_base_address);
+  if (FAILED(hr)) {
+    cerr << "Failed to get base address of the loaded module.";
+    return appdomain->Continue(FALSE);
+  }
+
+  // The module was registered by LoadExistingModules.
+  if (module_registry_.GetSnapshot()->FindByBaseAddress(module_base_address)) {
+    return appdomain->Continue(FALSE);
+  }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.modules_loaded.Increment();
+  ScopedLatencyTimer load_timer(&metrics.module_load_time_us);
+  DEBUGGER_TRACE_SPAN("DebuggerCallback::LoadModule");
+
   std::unique_ptr<IPortablePdbFile> portable_pdb(new (std::nothrow)
                                                      PortablePdbFile());
   if (!portable_pdb) {
@@ -192,13 +332,352 @@ HRESULT DebuggerCallback::LoadModule(ICorDebugAppDomain *appdomain,
     return E_OUTOFMEMORY;
   }
 
-  HRESULT hr = portable_pdb->Initialize(debug_module, debug_helper_.get());
+  hr = portable_pdb->Initialize(debug_module, debug_helper_.get());
   if (FAILED(hr)) {
     cerr << "Failed set debug module for PortablePdbFile.";
     return appdomain->Continue(FALSE);
   }
 
-  portable_pdbs_.push_back(std::move(portable_pdb));
+  std::shared_ptr<IPortablePdbFile> shared_pdb(std::move(portable_pdb));
+
+  // Uses the PDB that WarmPdbs started parsing for the module, if any.
+  {
+    std::lock_guard<std::mutex> lock(warmed_pdbs_mutex_);
+    auto warmed_pdb = warmed_pdbs_.find(shared_pdb->GetModuleName());
+    if (warmed_pdb != warmed_pdbs_.end()) {
+      if (SUCCEEDED(warmed_pdb->second->Initialize(debug_module,
+                                                   debug_helper_.get()))) {
+        shared_pdb = warmed_pdb->second;
+      }
+      warmed_pdbs_.erase(warmed_pdb);
+    }
+  }
+
+  bool filtered = !module_filter_.ShouldParse(shared_pdb->GetModuleName());
+  hr = module_registry_.AddModule(shared_pdb, module_base_address, filtered);
+  if (FAILED(hr)) {
+    cerr << "Failed to add the PDB of module " << shared_pdb->GetModuleName();
+    return appdomain->Continue(FALSE);
+  }
+
+  // LoadExistingModules registered the module meanwhile.
+  if (hr == S_FALSE) {
+    return appdomain->Continue(FALSE);
+  }
+
+  // Parses the PDB in the background. If it is needed first, the caller
+  // parses it itself (or waits for the background parse to finish).
+  // Filtered PDBs are only parsed when they are needed.
+  if (filtered) {
+    metrics.modules_filtered.Increment();
+  } else if (!pdb_parsing_pool_ ||
+             !pdb_parsing_pool_->Schedule(
+                 [shared_pdb]() { shared_pdb->ParsePdbFile(); })) {
+    cerr << "Failed to schedule parsing of PDB for module "
+         << shared_pdb->GetModuleName();
+  }
+
+  // Downloads the PDB meanwhile if the module has none of its own.
+  if (!filtered) {
+    ScheduleSymbolFetch(shared_pdb, module_base_address);
+  }
+
+  // Breakpoints in the files of the module are set before its code runs.
+  if (breakpoint_collection_) {
+    hr = breakpoint_collection_->UpdatePendingBreakpoints(shared_pdb);
+    if (FAILED(hr)) {
+      cerr << "Failed to set pending breakpoints in module "
+           << shared_pdb->GetModuleName();
+    }
+  }
+
+  return appdomain->Continue(FALSE);
+}
+
+void DebuggerCallback::WarmPdbs(const string &directory) {
+  string full_directory = GetFullPath(directory);
+  vector<string> files;
+  if (!pdb_parsing_pool_ || full_directory.empty() ||
+      !ListDirectory(full_directory, &files)) {
+    return;
+  }
+
+  for (const string &module_name : files) {
+    // Only the PDB files next to their modules are parsed: the ones of
+    // the modules that are never loaded would be downloaded otherwise.
+    std::shared_ptr<PortablePdbFile> pdb(new (std::nothrow)
+                                             PortablePdbFile());
+    if (!pdb || FAILED(pdb->InitializeFromModuleFile(module_name)) ||
+        !module_filter_.ShouldParse(module_name)) {
+      continue;
+    }
+
+    string pdb_name = module_name.substr(
+        0, module_name.size() - kDllExtension.size()) + kPdbExtension;
+    if (!std::ifstream(pdb_name, std::ios::in | std::ios::binary).good()) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(warmed_pdbs_mutex_);
+    if (pdb_parsing_pool_->Schedule([pdb]() { pdb->ParsePdbFile(); })) {
+      warmed_pdbs_[module_name] = pdb;
+    }
+  }
+}
+
+HRESULT DebuggerCallback::LoadExistingModules(
+    ICorDebugProcess *debug_process) {
+  if (!debug_process) {
+    return E_INVALIDARG;
+  }
+
+  DEBUGGER_TRACE_SPAN("DebuggerCallback::LoadExistingModules");
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  std::chrono::steady_clock::time_point enumeration_start =
+      std::chrono::steady_clock::now();
+
+  // The process is stopped so that no module is loaded or unloaded while
+  // the modules are enumerated and registered.
+  HRESULT hr = debug_process->Stop(-1);
+  if (FAILED(hr)) {
+    cerr << "Failed to stop the process to enumerate its modules: "
+         << std::hex << hr;
+    return hr;
+  }
+
+  vector<CComPtr<ICorDebugModule>> debug_modules;
+  hr = EnumerateModules(debug_process, &debug_modules);
+  if (FAILED(hr)) {
+    cerr << "Failed to enumerate some of the loaded modules: " << std::hex
+         << hr;
+  }
+
+  vector<std::shared_ptr<IPortablePdbFile>> pdb_files;
+  vector<std::shared_ptr<IPortablePdbFile>> filtered_pdb_files;
+  for (const auto &debug_module : debug_modules) {
+    CORDB_ADDRESS module_base_address = 0;
+    hr = debug_module->GetBaseAddress(&module_base_address);
+    if (FAILED(hr)) {
+      cerr << "Failed to get base address of a loaded module.";
+      continue;
+    }
+
+    if (module_registry_.GetSnapshot()->FindByBaseAddress(
+            module_base_address)) {
+      continue;
+    }
+
+    std::unique_ptr<IPortablePdbFile> portable_pdb(new (std::nothrow)
+                                                       PortablePdbFile());
+    if (!portable_pdb) {
+      cerr << "Cannot create PortablePdbFile object.";
+      break;
+    }
+
+    hr = portable_pdb->Initialize(debug_module, debug_helper_.get());
+    if (FAILED(hr)) {
+      cerr << "Failed set debug module for PortablePdbFile.";
+      continue;
+    }
+
+    std::shared_ptr<IPortablePdbFile> shared_pdb(std::move(portable_pdb));
+    bool filtered = !module_filter_.ShouldParse(shared_pdb->GetModuleName());
+    if (module_registry_.AddModule(shared_pdb, module_base_address,
+                                   filtered) != S_OK) {
+      continue;
+    }
+
+    metrics.modules_loaded.Increment();
+    metrics.startup.modules_enumerated.Increment();
+    if (filtered) {
+      metrics.modules_filtered.Increment();
+      filtered_pdb_files.push_back(std::move(shared_pdb));
+    } else {
+      ScheduleSymbolFetch(shared_pdb, module_base_address);
+      pdb_files.push_back(std::move(shared_pdb));
+    }
+  }
+
+  hr = debug_process->Continue(FALSE);
+  if (FAILED(hr)) {
+    cerr << "Failed to continue the process after enumerating its modules: "
+         << std::hex << hr;
+  }
+  metrics.startup.module_enumeration_us.SetSince(enumeration_start);
+  std::chrono::steady_clock::time_point parsing_start =
+      std::chrono::steady_clock::now();
+
+  // Parses the PDB files in parallel and waits until all of them are
+  // parsed. A PDB file whose parse cannot be scheduled is parsed when it
+  // is needed.
+  std::mutex parse_mutex;
+  std::condition_variable parse_cv;
+  size_t pending_parses = 0;
+  for (const auto &pdb_file : pdb_files) {
+    {
+      std::lock_guard<std::mutex> lock(parse_mutex);
+      ++pending_parses;
+    }
+    if (!pdb_parsing_pool_ ||
+        !pdb_parsing_pool_->Schedule(
+            [pdb_file, &parse_mutex, &parse_cv, &pending_parses]() {
+              pdb_file->ParsePdbFile();
+              std::lock_guard<std::mutex> lock(parse_mutex);
+              --pending_parses;
+              parse_cv.notify_all();
+            })) {
+      cerr << "Failed to schedule parsing of PDB for module "
+           << pdb_file->GetModuleName();
+      std::lock_guard<std::mutex> lock(parse_mutex);
+      --pending_parses;
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(parse_mutex);
+    parse_cv.wait(lock, [&pending_parses]() { return pending_parses == 0; });
+  }
+
+  if (breakpoint_collection_) {
+    pdb_files.insert(pdb_files.end(), filtered_pdb_files.begin(),
+                     filtered_pdb_files.end());
+    for (const auto &pdb_file : pdb_files) {
+      hr = breakpoint_collection_->UpdatePendingBreakpoints(pdb_file);
+      if (FAILED(hr)) {
+        cerr << "Failed to set pending breakpoints in module "
+             << pdb_file->GetModuleName();
+      }
+    }
+  }
+
+  metrics.startup.pdb_parsing_us.SetSince(parsing_start);
+  return S_OK;
+}
+
+void DebuggerCallback::ScheduleSymbolFetch(
+    const std::shared_ptr<IPortablePdbFile> &pdb_file,
+    CORDB_ADDRESS module_base_address) {
+  if (!PortablePdbFile::GetPdbProvider()) {
+    return;
+  }
+
+  if (!symbol_fetch_pool_ ||
+      !symbol_fetch_pool_->Schedule([this, pdb_file, module_base_address]() {
+        if (!PortablePdbFile::FetchPdb(pdb_file->GetModuleName())) {
+          return;
+        }
+
+        // The module may have been unloaded during the download.
+        if (module_registry_.GetSnapshot()->FindByBaseAddress(
+                module_base_address) != pdb_file ||
+            !breakpoint_collection_) {
+          return;
+        }
+
+        HRESULT hr =
+            breakpoint_collection_->UpdatePendingBreakpoints(pdb_file);
+        if (FAILED(hr)) {
+          cerr << "Failed to set pending breakpoints in module "
+               << pdb_file->GetModuleName();
+        }
+      })) {
+    cerr << "Failed to schedule fetching of PDB for module "
+         << pdb_file->GetModuleName();
+  }
+}
+
+HRESULT DebuggerCallback::EnumerateModules(
+    ICorDebugProcess *debug_process,
+    vector<CComPtr<ICorDebugModule>> *debug_modules) {
+  CComPtr<ICorDebugAppDomainEnum> appdomain_enum;
+  HRESULT hr = debug_process->EnumerateAppDomains(&appdomain_enum);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  vector<CComPtr<ICorDebugAppDomain>> appdomains;
+  hr = ICorDebugHelper::EnumerateICorDebugSpecifiedType<ICorDebugAppDomainEnum,
+                                                        ICorDebugAppDomain>(
+      appdomain_enum, &appdomains);
+
+  // Enumerates as many modules as possible and returns the last failure.
+  for (const auto &appdomain : appdomains) {
+    CComPtr<ICorDebugAssemblyEnum> assembly_enum;
+    HRESULT assembly_hr = appdomain->EnumerateAssemblies(&assembly_enum);
+    if (FAILED(assembly_hr)) {
+      hr = assembly_hr;
+      continue;
+    }
+
+    vector<CComPtr<ICorDebugAssembly>> assemblies;
+    assembly_hr = ICorDebugHelper::EnumerateICorDebugSpecifiedType<
+        ICorDebugAssemblyEnum, ICorDebugAssembly>(assembly_enum, &assemblies);
+    if (FAILED(assembly_hr)) {
+      hr = assembly_hr;
+    }
+
+    for (const auto &assembly : assemblies) {
+      CComPtr<ICorDebugModuleEnum> module_enum;
+      HRESULT module_hr = assembly->EnumerateModules(&module_enum);
+      if (FAILED(module_hr)) {
+        hr = module_hr;
+        continue;
+      }
+
+      vector<CComPtr<ICorDebugModule>> modules;
+      module_hr = ICorDebugHelper::EnumerateICorDebugSpecifiedType<
+          ICorDebugModuleEnum, ICorDebugModule>(module_enum, &modules);
+      if (FAILED(module_hr)) {
+        hr = module_hr;
+      }
+      debug_modules->insert(debug_modules->end(), modules.begin(),
+                            modules.end());
+    }
+  }
+
+  return hr;
+}
+
+HRESULT DebuggerCallback::UnloadModule(ICorDebugAppDomain *appdomain,
+                                       ICorDebugModule *debug_module) {
+  CORDB_ADDRESS module_base_address = 0;
+  HRESULT hr = debug_module->GetBaseAddress(&module_base_address);
+  if (FAILED(hr)) {
+    cerr << "Failed to get base address of the unloaded module.";
+    return appdomain->Continue(FALSE);
+  }
+
+  if (breakpoint_collection_) {
+    hr = breakpoint_collection_->RemoveModuleBreakpoints(module_base_address);
+    if (FAILED(hr)) {
+      cerr << "Failed to remove the breakpoints of the unloaded module.";
+    }
+  }
+
+  // The PDB is freed once the breakpoint hits that use it are done.
+  std::shared_ptr<IPortablePdbFile> unloaded_pdb;
+  hr = module_registry_.RemoveModule(module_base_address, &unloaded_pdb);
+  if (hr == S_OK && eval_coordinator_) {
+    eval_coordinator_->RemoveModuleFrames(unloaded_pdb->GetModuleName());
+  }
+
+  DbgObjectFactory::RemoveClassDispatches(debug_module);
+  ObjectFieldsMemory::ClearTypeLayouts();
+  CComPtr<IMetaDataImport> metadata_import;
+  hr = debug_helper_->GetMetadataImportFromICorDebugModule(
+      debug_module, &metadata_import, &cerr);
+  if (SUCCEEDED(hr)) {
+    DbgClass::RemoveClassLayouts(metadata_import);
+    DbgClassProperty::RemoveGetterFields(metadata_import);
+    DbgEnum::RemoveEnumLayouts(metadata_import);
+    DbgStackFrame::RemoveAsyncStateMachineLayouts(metadata_import);
+    DbgStackFrame::RemoveMethodFrameLayouts(metadata_import);
+    CorDebugHelper::RemoveParsedTypeSignatures(metadata_import);
+    CorDebugHelper::RemoveGenericParamCounts(metadata_import);
+    TypeCompilerHelper::RemoveBaseClassResults(metadata_import);
+    MethodInfo::RemoveResolvedMethods(metadata_import);
+    MetadataCache::Global().RemoveModule(debug_module, metadata_import);
+  }
 
   return appdomain->Continue(FALSE);
 }
@@ -210,7 +689,8 @@ HRESULT STDMETHODCALLTYPE DebuggerCallback::CustomNotification(
 
 HRESULT DebuggerCallback::GetFunctionTokenAndILOffset(
     ICorDebugBreakpoint *debug_breakpoint, mdMethodDef *function_token,
-    ULONG32 *il_offset, IMetaDataImport **metadata_import) {
+    ULONG32 *il_offset, IMetaDataImport **metadata_import,
+    CORDB_ADDRESS *module_base_address) {
   CComPtr<ICorDebugFunctionBreakpoint> function_breakpoint;
   CComPtr<ICorDebugFunction> debug_function;
 
@@ -248,6 +728,12 @@ HRESULT DebuggerCallback::GetFunctionTokenAndILOffset(
     return hr;
   }
 
+  hr = debug_module->GetBaseAddress(module_base_address);
+  if (FAILED(hr)) {
+    cerr << "Failed to get base address of debug module.";
+    return hr;
+  }
+
   hr = debug_helper_->GetMetadataImportFromICorDebugModule(debug_module, metadata_import,
                                             &cerr);
   if (FAILED(hr)) {
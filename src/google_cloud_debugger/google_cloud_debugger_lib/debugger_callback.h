@@ -16,18 +16,28 @@
 #define DEBUGGERCALLBACK_H_
 
 #include <atomic>
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
+#include "capture_limits.h"
 #include "i_breakpoint_collection.h"
 #include "cor.h"
 #include "cordebug.h"
 #include "corsym.h"
+#include "constants.h"
 #include "i_eval_coordinator.h"
+#include "module_filter.h"
+#include "module_registry.h"
 
 namespace google_cloud_debugger {
 
 class BreakpointClient;
+class ThreadPool;
 
 // A DebuggerCallback object is used to set the managed handler of an ICorDebug
 // interface. Whenever an interesting event happens, the ICorDebug object
@@ -38,7 +48,8 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
                                ICorDebugManagedCallback2,
                                ICorDebugManagedCallback3 {
  public:
-  DebuggerCallback(std::string pipe_name) : pipe_name_(pipe_name) {} 
+  DebuggerCallback(std::string pipe_name);
+  ~DebuggerCallback();
   HRESULT Initialize();
 
   // IUnknown interface.
@@ -67,6 +78,12 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
   HRESULT STDMETHODCALLTYPE LoadModule(ICorDebugAppDomain *appdomain,
                                        ICorDebugModule *debug_module) override;
 
+  // This method is called when a module is unloaded, for example when a
+  // collectible AssemblyLoadContext is collected. Drops the PDB of the
+  // module and everything cached about it.
+  HRESULT STDMETHODCALLTYPE UnloadModule(
+      ICorDebugAppDomain *appdomain, ICorDebugModule *debug_module) override;
+
   // This method is called when the process the debugger is watching exits.
   HRESULT STDMETHODCALLTYPE ExitProcess(ICorDebugProcess *process) override;
 
@@ -96,8 +113,6 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
                         ICorDebugThread *debug_thread);
   DEBUGGERCALLBACK_STUB(ExitThread, ICorDebugAppDomain,
                         ICorDebugThread *debug_thread);
-  DEBUGGERCALLBACK_STUB(UnloadModule, ICorDebugAppDomain,
-                        ICorDebugModule *debug_module);
   DEBUGGERCALLBACK_STUB(LoadClass, ICorDebugAppDomain,
                         ICorDebugClass *debug_class);
   DEBUGGERCALLBACK_STUB(UnloadClass, ICorDebugAppDomain,
@@ -168,13 +183,34 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
     debug_process_ = debug_process;
   };
 
-  // Returns all the PDB files that are parsed.
-  const std::vector<
-      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-      &GetPdbFiles() const {
-    return portable_pdbs_;
+  // Tells the runtime not to deliver the notifications the debugger does
+  // not use if SetFilterCallbacks(true) was called: log messages, and
+  // first-chance exceptions while no exception point is active (see
+  // EnableExceptionCallbacks). Called once SetDebugProcess is.
+  HRESULT FilterCallbacks();
+
+  // Tells the runtime whether to deliver first-chance exceptions if
+  // callbacks are filtered. Exceptions are only needed by exception
+  // points, so they are enabled while one is active.
+  HRESULT EnableExceptionCallbacks(bool enable);
+
+  // Registers the modules already loaded in debug_process, for example
+  // when the debugger attaches to a running application, and parses
+  // their PDB files in parallel on pdb_parsing_pool_. Returns once all of
+  // them are parsed and the pending breakpoints are set in them. The
+  // process is only stopped while its modules are enumerated. The
+  // LoadModule callbacks of these modules are then ignored.
+  HRESULT LoadExistingModules(ICorDebugProcess *debug_process);
+
+  // Returns the current snapshot of the PDB files of the loaded modules.
+  std::shared_ptr<const ModuleSnapshot> GetModules() const {
+    return module_registry_.GetSnapshot();
   }
 
+  // Returns the threads that parse PDB files, which also search them for
+  // the locations of new breakpoints, or nullptr before Initialize.
+  ThreadPool *GetPdbParsingPool() const { return pdb_parsing_pool_.get(); }
+
   // Reads, parses and activates/deactivates incoming breakpoints.
   HRESULT SyncBreakpoints() {
     return breakpoint_collection_->SyncBreakpoints();
@@ -185,6 +221,10 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
     return breakpoint_collection_->CancelSyncBreakpoints();
   }
 
+  // Tells the breakpoint collection that the debugger is attached, so
+  // that it tells the agent the debugger is ready.
+  void SetAttached() { breakpoint_collection_->SetAttached(); }
+
   // Sets whether property evaluation should be performed.
   void SetPropertyEvaluation(BOOL eval) {
     eval_coordinator_->SetPropertyEvaluation(eval);
@@ -195,17 +235,220 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
     eval_coordinator_->SetMethodEvaluation(eval);
   }
 
+  // Sets whether log points are written after the debuggee continues.
+  void SetAsyncLogPoints(bool async_log_points) {
+    eval_coordinator_->SetAsyncLogPoints(async_log_points);
+  }
+
+  // Sets whether the messages of breakpoint hits report the cost of
+  // their breakpoint in their status.
+  void SetReportBreakpointCosts(bool report_breakpoint_costs) {
+    eval_coordinator_->SetReportBreakpointCosts(report_breakpoint_costs);
+  }
+
+  // Sets whether the names of the stack frames without variables are
+  // resolved in parallel.
+  void SetParallelStackFrames(bool parallel_stack_frames) {
+    eval_coordinator_->SetParallelStackFrames(parallel_stack_frames);
+  }
+
+  // Sets whether the callers of async methods resumed after an await are
+  // the async methods awaiting them.
+  void SetLogicalAsyncStacks(bool logical_async_stacks) {
+    eval_coordinator_->SetLogicalAsyncStacks(logical_async_stacks);
+  }
+
+  // Sets how long a single function evaluation can take.
+  void SetEvaluationTimeout(std::chrono::milliseconds timeout) {
+    eval_coordinator_->SetEvaluationTimeout(timeout);
+  }
+
+  // Sets the total time and number of function evaluations of a
+  // breakpoint. Zero means no limit.
+  void SetEvaluationBudget(std::chrono::milliseconds time,
+                           std::uint32_t func_evals) {
+    eval_coordinator_->SetEvaluationBudget(time, func_evals);
+  }
+
   // Gets the name of the pipe the debugger will use to communicate with
   // the agent.
   std::string GetPipeName() { return pipe_name_; }
+
+  // Sets how breakpoint messages are delimited on the pipe.
+  void SetMessageFraming(MessageFraming framing) { message_framing_ = framing; }
+
+  // Gets how breakpoint messages are delimited on the pipe.
+  MessageFraming GetMessageFraming() { return message_framing_; }
+
+  // Sets whether breakpoints are read and written through a single
+  // connection to the agent instead of one connection for each.
+  void SetDuplexPipe(bool duplex) { duplex_pipe_ = duplex; }
+
+  // Gets whether breakpoints are read and written through a single
+  // connection to the agent.
+  bool GetDuplexPipe() { return duplex_pipe_; }
+
+  // Sets whether the bytes of the duplex pipe go through memory shared
+  // with the agent instead of through the connection.
+  void SetSharedMemoryPipe(bool shared_memory) {
+    shared_memory_pipe_ = shared_memory;
+  }
+
+  // Gets whether the bytes of the duplex pipe go through shared memory.
+  bool GetSharedMemoryPipe() { return shared_memory_pipe_; }
+
+  // Sets whether large breakpoint messages are compressed before they
+  // are written to the agent.
+  void SetCompressBreakpoints(bool compress) {
+    compress_breakpoints_ = compress;
+  }
+
+  // Gets whether large breakpoint messages are compressed.
+  bool GetCompressBreakpoints() { return compress_breakpoints_; }
+
+  // Sets whether hits of log points are written to the agent as log
+  // records instead of as breakpoints.
+  void SetLogRecords(bool log_records) { log_records_ = log_records; }
+
+  // Gets whether hits of log points are written as log records.
+  bool GetLogRecords() { return log_records_; }
+
+  // Sets whether the strings that snapshots repeat are written once in
+  // a string table.
+  void SetStringTable(bool string_table) { string_table_ = string_table; }
+
+  // Gets whether snapshots are written with a string table.
+  bool GetStringTable() { return string_table_; }
+
+  // Sets whether the variables of a snapshot that did not change since
+  // the previous snapshot of its breakpoint are written as references.
+  void SetDeltaSnapshots(bool delta_snapshots) {
+    delta_snapshots_ = delta_snapshots;
+  }
+
+  // Gets whether snapshots are written as deltas of the previous one.
+  bool GetDeltaSnapshots() { return delta_snapshots_; }
+
+  // Sets the file snapshots are recorded to for snapshot_benchmark (see
+  // SnapshotRecorder), or an empty path to not record them.
+  void SetSnapshotRecordFile(const std::string &path) {
+    snapshot_record_file_ = path;
+  }
+
+  // Gets the file snapshots are recorded to.
+  const std::string &GetSnapshotRecordFile() { return snapshot_record_file_; }
+
+  // Sets whether a hit of a log point is skipped while another hit of
+  // the same log point is processed.
+  void SetCoalesceLogPointHits(bool coalesce) {
+    coalesce_log_point_hits_ = coalesce;
+  }
+
+  // Gets whether concurrent hits of log points are coalesced.
+  bool GetCoalesceLogPointHits() { return coalesce_log_point_hits_; }
+
+  // Sets whether the runtime only delivers the notifications the
+  // debugger uses.
+  void SetFilterCallbacks(bool filter) { filter_callbacks_ = filter; }
+
+  // Sets what happens to breakpoint messages when too many of them are
+  // waiting to be written to the agent.
+  void SetBreakpointWriteOverflow(BreakpointWriteOverflow overflow) {
+    breakpoint_write_overflow_ = overflow;
+  }
+
+  // Gets what happens to breakpoint messages when too many of them are
+  // waiting to be written to the agent.
+  BreakpointWriteOverflow GetBreakpointWriteOverflow() {
+    return breakpoint_write_overflow_;
+  }
+
+  // Sets the file breakpoint messages are spilled to while the write
+  // queue is full (see BreakpointSpillFile), or an empty path to not
+  // spill them.
+  void SetSpillFile(const std::string &path) { spill_file_ = path; }
+
+  // Gets the file breakpoint messages are spilled to.
+  const std::string &GetSpillFile() { return spill_file_; }
+
+  // Sets the limits the snapshots of breakpoints read from the agent
+  // are captured with.
+  void SetCaptureLimits(const CaptureLimits &limits) {
+    capture_limits_ = limits;
+  }
+
+  // Gets the limits the snapshots of breakpoints read from the agent
+  // are captured with.
+  const CaptureLimits &GetCaptureLimits() { return capture_limits_; }
+
+  // Sets how often DebuggerMetrics are written to the agent. Zero means
+  // they are not written.
+  void SetMetricsInterval(std::chrono::milliseconds interval) {
+    metrics_interval_ = interval;
+  }
+
+  // Gets how often DebuggerMetrics are written to the agent.
+  std::chrono::milliseconds GetMetricsInterval() { return metrics_interval_; }
+
+  // Makes the breakpoint collection read breakpoints from breakpoints
+  // instead of the agent, and serialize and drop the breakpoints it
+  // writes, so that the debugger can run without an agent. Has to be
+  // called before SyncBreakpoints.
+  void SetLocalBreakpoints(
+      std::shared_ptr<const std::vector<
+          google::cloud::diagnostics::debug::Breakpoint>>
+          breakpoints) {
+    local_breakpoints_ = std::move(breakpoints);
+  }
+
+  // Sets which loaded modules have their PDB files parsed as soon as they
+  // are loaded. Has to be called before the debugger attaches.
+  void SetModuleFilter(const ModuleFilter &module_filter) {
+    module_filter_ = module_filter;
+  }
+
+  // Starts parsing the PDB files next to the modules in directory that
+  // the module filter selects on the PDB parsing threads, so that they
+  // are ready when the modules are loaded. Used when the debugger starts
+  // the application, before it runs. Has to be called after Initialize.
+  void WarmPdbs(const std::string &directory);
+
+  // Gets the local breakpoints, or null if breakpoints are read from
+  // the agent.
+  std::shared_ptr<
+      const std::vector<google::cloud::diagnostics::debug::Breakpoint>>
+  GetLocalBreakpoints() {
+    return local_breakpoints_;
+  }
   
  private:
-  // Given an ICorDebugBreakpoint, gets the function token, IL offset
-  // and metadata of the function that the breakpoint is in.
+  // Given an ICorDebugBreakpoint, gets the function token, IL offset,
+  // metadata and module base address of the function that the breakpoint
+  // is in.
   HRESULT GetFunctionTokenAndILOffset(ICorDebugBreakpoint *debug_breakpoint,
                                       mdMethodDef *function_token,
                                       ULONG32 *il_offset,
-                                      IMetaDataImport **metadata_import);
+                                      IMetaDataImport **metadata_import,
+                                      CORDB_ADDRESS *module_base_address);
+
+  // Tells the runtime whether to deliver first-chance exceptions and
+  // records it in exception_callbacks_. Requires
+  // exception_callbacks_mutex_.
+  HRESULT SetExceptionCallbacks(bool enable);
+
+  // Fetches the PDB of the module at module_base_address through the PDB
+  // provider (see PortablePdbFile::SetPdbProvider) on symbol_fetch_pool_,
+  // and sets the pending breakpoints in it once it is fetched. Does
+  // nothing if there is no PDB provider.
+  void ScheduleSymbolFetch(
+      const std::shared_ptr<IPortablePdbFile> &pdb_file,
+      CORDB_ADDRESS module_base_address);
+
+  // Stores the modules of all the assemblies of all the app domains of
+  // debug_process in debug_modules.
+  HRESULT EnumerateModules(
+      ICorDebugProcess *debug_process,
+      std::vector<CComPtr<ICorDebugModule>> *debug_modules);
 
   // An EvalCoordinator is used to coordinate between DebuggerCallback object
   // and a StackFrame object when an evaluation is needed. See the
@@ -215,10 +458,19 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
   // This field is used for reference counting (AddRef and Release).
   std::atomic<ULONG> ref_count_;
 
-  // Vector containing all the portable PDB files that are parsed.
-  std::vector<
-      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-      portable_pdbs_;
+  // The portable PDB files of the loaded modules.
+  ModuleRegistry module_registry_;
+
+  // Threads that parse the PDB files of loaded modules so that the
+  // LoadModule callback does not keep the debuggee stopped. A caller that
+  // needs a PDB before its background parse is done parses it or waits for
+  // it through IPortablePdbFile::ParsePdbFile.
+  std::unique_ptr<ThreadPool> pdb_parsing_pool_;
+
+  // The PDBs started by WarmPdbs that LoadModule has not used yet, by
+  // the paths of their modules. Guarded by warmed_pdbs_mutex_.
+  std::map<std::string, std::shared_ptr<IPortablePdbFile>> warmed_pdbs_;
+  std::mutex warmed_pdbs_mutex_;
 
   // The ICorDebugProcess of the debugged process.
   CComPtr<ICorDebugProcess> debug_process_;
@@ -227,6 +479,12 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
   // manage breakpoints.
   std::unique_ptr<IBreakpointCollection> breakpoint_collection_;
 
+  // Threads that fetch the PDB files that are not next to their modules
+  // from the PDB provider, so that downloads overlap with parsing and do
+  // not keep the debuggee stopped. Declared after the members its tasks
+  // use so that it is destroyed first.
+  std::unique_ptr<ThreadPool> symbol_fetch_pool_;
+
   // Helper methods for ICorDebug objects.
   std::shared_ptr<ICorDebugHelper> debug_helper_;
 
@@ -234,6 +492,65 @@ class DebuggerCallback final : public ICorDebugManagedCallback,
 
   // The name of the pipe the debugger will use to communicate with the agent.
   std::string pipe_name_;
+
+  // How breakpoint messages are delimited on the pipe.
+  MessageFraming message_framing_ = MessageFraming::kMarkers;
+
+  // True if breakpoints are read and written through one connection.
+  bool duplex_pipe_ = false;
+
+  // True if the bytes of the duplex pipe go through shared memory.
+  bool shared_memory_pipe_ = false;
+
+  // True if large breakpoint messages are compressed.
+  bool compress_breakpoints_ = false;
+
+  // True if hits of log points are written as log records.
+  bool log_records_ = false;
+
+  // True if snapshots are written with a string table.
+  bool string_table_ = false;
+
+  // True if snapshots are written as deltas of the previous one.
+  bool delta_snapshots_ = false;
+
+  // The file snapshots are recorded to, if any.
+  std::string snapshot_record_file_;
+
+  // True if concurrent hits of log points are coalesced.
+  bool coalesce_log_point_hits_ = false;
+
+  // True if the runtime only delivers the notifications the debugger
+  // uses.
+  bool filter_callbacks_ = false;
+
+  // True once FilterCallbacks is called, and whether the runtime is told
+  // to deliver first-chance exceptions. Guarded by
+  // exception_callbacks_mutex_.
+  bool callbacks_filtered_ = false;
+  bool exception_callbacks_ = false;
+  std::mutex exception_callbacks_mutex_;
+
+  // What happens to breakpoint messages when the write queue is full.
+  BreakpointWriteOverflow breakpoint_write_overflow_ =
+      BreakpointWriteOverflow::kBlock;
+
+  // The file breakpoint messages are spilled to, if any.
+  std::string spill_file_;
+
+  // Limits of the snapshots of breakpoints read from the agent.
+  CaptureLimits capture_limits_;
+
+  // How often DebuggerMetrics are written to the agent, or zero.
+  std::chrono::milliseconds metrics_interval_{0};
+
+  // Which modules have their PDB files parsed when they are loaded.
+  ModuleFilter module_filter_;
+
+  // Breakpoints read instead of the ones of the agent, if not null.
+  std::shared_ptr<
+      const std::vector<google::cloud::diagnostics::debug::Breakpoint>>
+      local_breakpoints_;
 };
 
 }  //  namespace google_cloud_debugger
@@ -0,0 +1,159 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "debugger_display_format.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "csharp_expression.h"
+#include "expression_util.h"
+#include "memory_usage.h"
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Removes the spaces and tabs at both ends of value.
+string Trim(const string &value) {
+  const char *white_space = " \t";
+  std::size_t first = value.find_first_not_of(white_space);
+  if (first == string::npos) {
+    return string();
+  }
+
+  std::size_t last = value.find_last_not_of(white_space);
+  return value.substr(first, last - first + 1);
+}
+
+}  // namespace
+
+bool DebuggerDisplayFormat::Parse(const string &format) {
+  segments_.clear();
+  Segment segment;
+  std::size_t i = 0;
+  while (i < format.size()) {
+    // Escaped braces are displayed as they are.
+    if (format[i] == '\\' && i + 1 < format.size() &&
+        (format[i + 1] == '{' || format[i + 1] == '}')) {
+      segment.text += format[i + 1];
+      i += 2;
+      continue;
+    }
+
+    if (format[i] != '{') {
+      segment.text += format[i];
+      ++i;
+      continue;
+    }
+
+    std::size_t close = format.find('}', i + 1);
+    if (close == string::npos ||
+        !ParseMember(format.substr(i + 1, close - i - 1), &segment)) {
+      segments_.clear();
+      return false;
+    }
+
+    segments_.push_back(std::move(segment));
+    segment = Segment();
+    i = close + 1;
+  }
+
+  if (!segment.text.empty() || segments_.empty()) {
+    segments_.push_back(std::move(segment));
+  }
+  return true;
+}
+
+bool DebuggerDisplayFormat::ParseMember(const string &expression,
+                                        Segment *segment) {
+  string member = expression;
+  std::size_t comma = expression.find(',');
+  if (comma != string::npos) {
+    if (Trim(expression.substr(comma + 1)) != "nq") {
+      return false;
+    }
+    segment->quote_strings = false;
+    member = expression.substr(0, comma);
+  }
+
+  // Identifiers and member selectors are the only expressions that have
+  // a dotted name, like Address.City.
+  std::unique_ptr<CSharpExpression> parsed =
+      google_cloud_debugger::ParseExpression(member);
+  string path;
+  if (!parsed || !parsed->TryGetTypeName(&path)) {
+    return false;
+  }
+
+  std::size_t start = 0;
+  while (true) {
+    std::size_t dot = path.find('.', start);
+    segment->member_path.push_back(path.substr(start, dot - start));
+    if (dot == string::npos) {
+      break;
+    }
+    start = dot + 1;
+  }
+
+  if (segment->member_path.size() > 1 && segment->member_path[0] == "this") {
+    segment->member_path.erase(segment->member_path.begin());
+  }
+  return true;
+}
+
+bool DebuggerDisplayFormat::ReadAttributeArgument(const void *blob,
+                                                  ULONG blob_size,
+                                                  string *format) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(blob);
+  if (!bytes || blob_size < 3 || bytes[0] != 0x01 || bytes[1] != 0x00) {
+    return false;
+  }
+
+  // A serialized string is its length in bytes, compressed like the
+  // numbers of signatures, followed by its UTF-8 characters. 0xFF is a
+  // null string.
+  if (bytes[2] == 0xFF) {
+    return false;
+  }
+
+  ULONG length = 0;
+  ULONG length_size = 0;
+  if (FAILED(CorSigUncompressData(bytes + 2, blob_size - 2, &length,
+                                  &length_size)) ||
+      length > blob_size - 2 - length_size) {
+    return false;
+  }
+
+  format->assign(reinterpret_cast<const char *>(bytes + 2 + length_size),
+                 length);
+  return true;
+}
+
+std::size_t DebuggerDisplayFormat::GetMemoryUsage() const {
+  std::size_t usage = google_cloud_debugger::GetMemoryUsage(segments_);
+  for (const Segment &segment : segments_) {
+    usage += google_cloud_debugger::GetMemoryUsage(segment.text) +
+             google_cloud_debugger::GetMemoryUsage(segment.member_path);
+    for (const string &member : segment.member_path) {
+      usage += google_cloud_debugger::GetMemoryUsage(member);
+    }
+  }
+  return usage;
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,75 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEBUGGER_DISPLAY_FORMAT_H_
+#define DEBUGGER_DISPLAY_FORMAT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "cor.h"
+
+namespace google_cloud_debugger {
+
+// The format string of a DebuggerDisplay attribute, like
+// "{Id} {Name,nq}", compiled into its text and the members of the
+// object it shows. A format is compiled once per class and used for
+// every object of the class.
+class DebuggerDisplayFormat {
+ public:
+  // A piece of text followed by the value of a member of the object.
+  struct Segment {
+    // Text that is displayed as it is.
+    std::string text;
+
+    // Names of the member and the members of it the value is read
+    // from, like {"Address", "City"} for {Address.City}. Empty for the
+    // text at the end of the format.
+    std::vector<std::string> member_path;
+
+    // False if the value is a string that is displayed without quotes,
+    // which the format specifier nq asks for.
+    bool quote_strings = true;
+  };
+
+  // Compiles format. The expressions between braces are parsed by the
+  // expression compiler of conditions. Returns false if one of them is
+  // not a member of the object or a chain of members, which are read
+  // without function evaluations, or has a format specifier other than
+  // nq.
+  bool Parse(const std::string &format);
+
+  // Reads the format string from the blob of a DebuggerDisplay
+  // attribute, which is the prolog 0x0001 followed by the format as a
+  // serialized string. Returns false if the blob is not that.
+  static bool ReadAttributeArgument(const void *blob, ULONG blob_size,
+                                    std::string *format);
+
+  // Returns the segments of the format, in order.
+  const std::vector<Segment> &GetSegments() const { return segments_; }
+
+  // Returns the memory used by the segments.
+  std::size_t GetMemoryUsage() const;
+
+ private:
+  // Parses the expression between the braces of a segment into segment.
+  static bool ParseMember(const std::string &expression, Segment *segment);
+
+  std::vector<Segment> segments_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  DEBUGGER_DISPLAY_FORMAT_H_
@@ -0,0 +1,47 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dereference_cache.h"
+
+namespace google_cloud_debugger {
+
+thread_local DereferenceCache *DereferenceCache::current_ = nullptr;
+
+bool DereferenceCache::Find(CORDB_ADDRESS address,
+                            ICorDebugValue **value) const {
+  if (address == 0) {
+    return false;
+  }
+
+  auto found = values_.find(address);
+  if (found == values_.end()) {
+    return false;
+  }
+
+  *value = found->second;
+  (*value)->AddRef();
+  return true;
+}
+
+void DereferenceCache::Add(CORDB_ADDRESS address, ICorDebugValue *value) {
+  if (address == 0 || !value) {
+    return;
+  }
+
+  CComPtr<ICorDebugValue> cached_value;
+  cached_value = value;
+  values_[address] = cached_value;
+}
+
+}  //  namespace google_cloud_debugger
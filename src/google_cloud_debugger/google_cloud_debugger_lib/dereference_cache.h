@@ -0,0 +1,72 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEREFERENCE_CACHE_H_
+#define DEREFERENCE_CACHE_H_
+
+#include <cstddef>
+#include <map>
+
+#include "ccomptr.h"
+#include "cor.h"
+#include "cordebug.h"
+
+namespace google_cloud_debugger {
+
+// The values that the references read while a debuggee thread is
+// stopped at breakpoints dereference to, by the address of the object
+// they refer to. Objects that many references point to, like the parent
+// of the children it holds, are then only dereferenced once.
+//
+// The dereferenced values and the addresses are only valid while the
+// debuggee is stopped, so the cache is cleared before every function
+// evaluation and once the hit is done.
+class DereferenceCache {
+ public:
+  DereferenceCache() = default;
+  DereferenceCache(const DereferenceCache &) = delete;
+  DereferenceCache &operator=(const DereferenceCache &) = delete;
+
+  // Returns the cache of the hit the calling thread is processing, or
+  // null if there is none.
+  static DereferenceCache *GetCurrent() { return current_; }
+
+  // Sets the cache of the hit the calling thread is processing.
+  static void SetCurrent(DereferenceCache *cache) { current_ = cache; }
+
+  // Gets the value that a reference to the object at address
+  // dereferences to. Returns false if it is not cached.
+  bool Find(CORDB_ADDRESS address, ICorDebugValue **value) const;
+
+  // Caches value, what a reference to the object at address
+  // dereferences to. Null references, at address 0, are not cached.
+  void Add(CORDB_ADDRESS address, ICorDebugValue *value);
+
+  // Clears the cache.
+  void Clear() { values_.clear(); }
+
+  // Returns the number of values cached.
+  std::size_t GetSize() const { return values_.size(); }
+
+ private:
+  // The dereferenced values by the address of their object.
+  std::map<CORDB_ADDRESS, CComPtr<ICorDebugValue>> values_;
+
+  // The cache of the hit each thread is processing.
+  static thread_local DereferenceCache *current_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  DEREFERENCE_CACHE_H_
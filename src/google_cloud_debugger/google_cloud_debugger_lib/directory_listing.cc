@@ -0,0 +1,79 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "directory_listing.h"
+
+#include "constants.h"
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+// Splits command_line into its arguments. Double quotes group the
+// characters between them into one argument and are dropped.
+static vector<string> SplitCommandLine(const string &command_line) {
+  vector<string> arguments;
+  string argument;
+  bool quoted = false;
+  bool in_argument = false;
+  for (char c : command_line) {
+    if (c == '"') {
+      quoted = !quoted;
+      in_argument = true;
+    } else if (!quoted && (c == ' ' || c == '\t')) {
+      if (in_argument) {
+        arguments.push_back(std::move(argument));
+        argument.clear();
+        in_argument = false;
+      }
+    } else {
+      argument += c;
+      in_argument = true;
+    }
+  }
+
+  if (in_argument) {
+    arguments.push_back(std::move(argument));
+  }
+  return arguments;
+}
+
+string GetApplicationDirectory(const string &command_line) {
+  vector<string> arguments = SplitCommandLine(command_line);
+  if (arguments.empty()) {
+    return ".";
+  }
+
+  string application = arguments[0];
+  for (const string &argument : arguments) {
+    if (argument.size() > kDllExtension.size() &&
+        argument.compare(argument.size() - kDllExtension.size(),
+                         kDllExtension.size(), kDllExtension) == 0) {
+      application = argument;
+      break;
+    }
+  }
+
+  size_t separator = application.find_last_of("/\\");
+  if (separator == string::npos) {
+    return ".";
+  }
+  if (separator == 0) {
+    return application.substr(0, 1);
+  }
+  return application.substr(0, separator);
+}
+
+}  //  namespace google_cloud_debugger
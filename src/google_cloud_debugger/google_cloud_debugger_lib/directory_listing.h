@@ -0,0 +1,41 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIRECTORY_LISTING_H_
+#define DIRECTORY_LISTING_H_
+
+#include <string>
+#include <vector>
+
+namespace google_cloud_debugger {
+
+// Stores the paths of the regular files in directory (not the ones of its
+// subdirectories) in files, in no particular order. Returns false if the
+// directory cannot be read.
+bool ListDirectory(const std::string &directory,
+                   std::vector<std::string> *files);
+
+// Returns the absolute path of path, with symbolic links and relative
+// components resolved, or an empty string if path does not exist.
+std::string GetFullPath(const std::string &path);
+
+// Returns the directory of the application that command_line starts, or
+// "." if it is the current directory. The application is the first
+// argument that ends with ".dll" (as in "dotnet bin/App.dll"), or the
+// program if there is none (as in "bin/App"). Arguments can be quoted.
+std::string GetApplicationDirectory(const std::string &command_line);
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  DIRECTORY_LISTING_H_
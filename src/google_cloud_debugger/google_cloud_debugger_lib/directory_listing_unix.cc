@@ -0,0 +1,57 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PLATFORM_UNIX
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "directory_listing.h"
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+bool ListDirectory(const string &directory, vector<string> *files) {
+  DIR *dir = opendir(directory.c_str());
+  if (!dir) {
+    return false;
+  }
+
+  while (struct dirent *entry = readdir(dir)) {
+    string path = directory + "/" + entry->d_name;
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+      files->push_back(std::move(path));
+    }
+  }
+
+  closedir(dir);
+  return true;
+}
+
+string GetFullPath(const string &path) {
+  char full_path[PATH_MAX];
+  if (!realpath(path.c_str(), full_path)) {
+    return string();
+  }
+  return full_path;
+}
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  PLATFORM_UNIX
@@ -0,0 +1,56 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#include "directory_listing.h"
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+bool ListDirectory(const string &directory, vector<string> *files) {
+  WIN32_FIND_DATAA find_data;
+  HANDLE find_handle =
+      FindFirstFileA((directory + "\\*").c_str(), &find_data);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  do {
+    if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      files->push_back(directory + "\\" + find_data.cFileName);
+    }
+  } while (FindNextFileA(find_handle, &find_data));
+
+  FindClose(find_handle);
+  return true;
+}
+
+string GetFullPath(const string &path) {
+  char full_path[MAX_PATH];
+  DWORD length = GetFullPathNameA(path.c_str(), MAX_PATH, full_path, nullptr);
+  if (length == 0 || length >= MAX_PATH ||
+      GetFileAttributesA(full_path) == INVALID_FILE_ATTRIBUTES) {
+    return string();
+  }
+  return full_path;
+}
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  _WIN32
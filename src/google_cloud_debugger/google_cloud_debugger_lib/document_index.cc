@@ -29,77 +29,165 @@ using std::vector;
 
 namespace google_cloud_debugger_portable_pdb {
 
+void MethodsMemoryFootprint::Add(const MethodInfo &method) {
+  ++methods;
+  sequence_points += method.sequence_points.size();
+  sequence_point_bytes += method.sequence_points.GetMemoryUsage();
+  uncompressed_sequence_point_bytes +=
+      method.sequence_points.size() * sizeof(SequencePoint);
+
+}
+
+void MethodsMemoryFootprint::Add(const vector<Scope> &scopes) {
+  scope_bytes += scopes.capacity() * sizeof(Scope);
+  for (const Scope &scope : scopes) {
+    scope_bytes +=
+        scope.local_variables.capacity() * sizeof(LocalVariableInfo) +
+        scope.local_constants.capacity() * sizeof(LocalConstantInfo);
+  }
+}
+
 bool DocumentIndex::Initialize(const IPortablePdbFile &pdb, int doc_index) {
   if (doc_index == 0) {
     cerr << "Document index has to be larger than 0.";
     return false;
   }
 
-  const vector<DocumentRow> &document_table = pdb.GetDocumentTable();
+  MetadataTableView<DocumentRow> document_table = pdb.GetDocumentTable();
   if (document_table.size() <= doc_index) {
     cerr << "Document index " << std::to_string(doc_index)
          << " is larger than the Document Table size.";
     return false;
   }
 
-  const DocumentRow &doc_row = document_table[doc_index];
+  DocumentRow doc_row = document_table[doc_index];
 
-  if (!pdb.GetDocumentName(doc_row.name, &file_path_)) {
-    cerr << "Failed to get document name for file " << file_path_ << std::endl;
+  string file_path;
+  if (!pdb.GetDocumentName(doc_row.name, &file_path)) {
+    cerr << "Failed to get document name for file " << file_path << std::endl;
     return false;
   }
+  file_path_ = std::move(file_path);
 
   // See:
   // https://github.com/dotnet/corefx/blob/master/src/System.Reflection.Metadata/specs/PortablePdb-Metadata.md#document-table-0x30
   // for the various GUIDs.
-  string language_guid;
-  if (!pdb.GetHeapGuid(doc_row.language, &language_guid)) {
+  const uint8_t *language_guid;
+  if (!pdb.GetHeapGuidSpan(doc_row.language, &language_guid)) {
     cerr << "Failed to get language GUID.";
     return false;
   }
 
   source_language_ = GetLanguageName(language_guid);
 
-  string hash_guid;
-  if (!pdb.GetHeapGuid(doc_row.hash_algorithm, &hash_guid)) {
+  const uint8_t *hash_guid;
+  if (!pdb.GetHeapGuidSpan(doc_row.hash_algorithm, &hash_guid)) {
     cerr << "Failed to get hash GUID.";
     return false;
   }
 
   hash_algorithm_ = GetHashAlgorithmName(hash_guid);
 
-  if (!pdb.GetHash(doc_row.hash, &hash_)) {
+  if (!pdb.GetBlobSpan(doc_row.hash, &hash_, &hash_size_)) {
     cerr << "Failed to get heap blob stream.";
     return false;
   }
 
+  static const char kHexDigits[] = "0123456789abcdef";
+  content_hash_.clear();
+  content_hash_.reserve(hash_size_ * 2);
+  for (uint32_t i = 0; i < hash_size_; ++i) {
+    content_hash_.push_back(kHexDigits[hash_[i] >> 4]);
+    content_hash_.push_back(kHexDigits[hash_[i] & 0xf]);
+  }
+
+  doc_index_ = doc_index;
+  return true;
+}
+
+bool DocumentIndex::ParseMethods(const IPortablePdbFile &pdb,
+                                 const vector<uint32_t> &method_defs) {
   // We rely on the 1:1 mapping between the Method and MethodDebugInfo tables.
-  vector<MethodDebugInformationRow> method_debug_info_rows =
+  MetadataTableView<MethodDebugInformationRow> method_debug_info_rows =
       pdb.GetMethodDebugInfoTable();
-  size_t num_of_methods = method_debug_info_rows.size();
-  methods_.reserve(num_of_methods);
+  std::shared_ptr<DocumentMethods> parsed(new (std::nothrow)
+                                             DocumentMethods());
+  if (!parsed) {
+    cerr << "Failed to allocate the methods of document "
+         << std::to_string(doc_index_);
+    return false;
+  }
+  vector<MethodInfo> &methods = parsed->methods;
+  methods.reserve(method_defs.size());
+
+  for (uint32_t method_def : method_defs) {
+    if (method_def == 0 || method_def >= method_debug_info_rows.size()) {
+      cerr << "Method " << std::to_string(method_def)
+           << " is not in the MethodDebugInformation table.";
+      return false;
+    }
 
-  for (size_t method_def = 1; method_def < num_of_methods; ++method_def) {
     MethodDebugInformationRow debug_info_row =
         method_debug_info_rows[method_def];
     // Pedantically we are ignoring methods that span multiple files.
-    if (debug_info_row.document != doc_index) {
+    if (debug_info_row.document != doc_index_) {
       continue;
     }
 
     MethodInfo method;
-    if (!ParseMethod(&method, pdb, debug_info_row, method_def, doc_index)) {
+    if (!ParseMethod(&method, pdb, debug_info_row, method_def, doc_index_)) {
       cerr << "Failed to parse the method " << std::to_string(method_def)
-           << " in document " << std::to_string(doc_index);
+           << " in document " << std::to_string(doc_index_);
       return false;
     }
 
-    methods_.push_back(std::move(method));
+    methods.push_back(std::move(method));
   }
 
+  parsed->sequence_point_index.Initialize(methods);
+  methods_ = std::move(parsed);
   return true;
 }
 
+void DocumentIndex::SetMethods(vector<MethodInfo> methods) {
+  std::shared_ptr<DocumentMethods> parsed(new (std::nothrow)
+                                             DocumentMethods());
+  if (!parsed) {
+    cerr << "Failed to allocate the methods of document "
+         << std::to_string(doc_index_);
+    return;
+  }
+  parsed->methods = std::move(methods);
+  parsed->sequence_point_index.Initialize(parsed->methods);
+  methods_ = std::move(parsed);
+}
+
+void DocumentIndex::SetSharedMethods(
+    std::shared_ptr<const DocumentMethods> methods) {
+  methods_ = std::move(methods);
+}
+
+void DocumentIndex::SetPathTable(const FrontCodedStringTable *paths,
+                                 uint32_t position) {
+  paths_ = paths;
+  path_position_ = position;
+  string().swap(file_path_);
+}
+
+string DocumentIndex::GetFilePath() const {
+  return paths_ ? paths_->Get(path_position_) : file_path_;
+}
+
+const vector<MethodInfo> &DocumentIndex::GetMethods() const {
+  static const vector<MethodInfo> kNoMethods;
+  return methods_ ? methods_->methods : kNoMethods;
+}
+
+const SequencePointIndex &DocumentIndex::GetSequencePointIndex() const {
+  static const SequencePointIndex kNoSequencePoints;
+  return methods_ ? methods_->sequence_point_index : kNoSequencePoints;
+}
+
 bool DocumentIndex::ParseMethod(MethodInfo *method, const IPortablePdbFile &pdb,
                                 const MethodDebugInformationRow &debug_info_row,
                                 uint32_t method_def, uint32_t doc_index) {
@@ -117,7 +205,6 @@ bool DocumentIndex::ParseMethod(MethodInfo *method, const IPortablePdbFile &pdb,
   }
 
   uint32_t il_offset = 0;
-  method->sequence_points.reserve(sequence_point_info.records.size());
 
   for (const auto &seq_point_record : sequence_point_info.records) {
     if (IsDocumentChange(seq_point_record)) {
@@ -140,19 +227,43 @@ bool DocumentIndex::ParseMethod(MethodInfo *method, const IPortablePdbFile &pdb,
       method->last_line = max(seq_point_record.end_line, method->last_line);
     }
 
-    method->sequence_points.push_back(std::move(seq_point));
+    method->sequence_points.push_back(seq_point);
   }
+  method->sequence_points.ShrinkToFit();
 
-  bool first_scope = true;
-  const vector<LocalScopeRow> &local_scope_table = pdb.GetLocalScopeTable();
-  const vector<LocalVariableRow> &local_variable_table =
+  return true;
+}
+
+bool DocumentIndex::ParseScopes(const IPortablePdbFile &pdb,
+                                uint32_t method_def, vector<Scope> *scopes) {
+  assert(scopes != nullptr);
+
+  MetadataTableView<LocalScopeRow> local_scope_table =
+      pdb.GetLocalScopeTable();
+  MetadataTableView<LocalVariableRow> local_variable_table =
       pdb.GetLocalVariableTable();
-  const vector<LocalConstantRow> &local_constant_table =
+  MetadataTableView<LocalConstantRow> local_constant_table =
       pdb.GetLocalConstantTable();
-  for (size_t index = 1; index < local_scope_table.size(); ++index) {
-    const LocalScopeRow &local_scope_row = local_scope_table[index];
+
+  // The LocalScope table is sorted by method, so the scopes of method_def
+  // are a run of rows that starts at the first row whose method is not
+  // smaller than method_def.
+  size_t first = 1;
+  size_t last = local_scope_table.size();
+  while (first < last) {
+    size_t middle = first + (last - first) / 2;
+    if (local_scope_table[middle].method_def < method_def) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+
+  scopes->clear();
+  for (size_t index = first; index < local_scope_table.size(); ++index) {
+    LocalScopeRow local_scope_row = local_scope_table[index];
     if (local_scope_row.method_def != method_def) {
-      continue;
+      break;
     }
 
     Scope local_scope;
@@ -162,7 +273,7 @@ bool DocumentIndex::ParseMethod(MethodInfo *method, const IPortablePdbFile &pdb,
       cerr << "Failed to parse local scope at index " << std::to_string(index);
     }
 
-    method->local_scope.push_back(std::move(local_scope));
+    scopes->push_back(std::move(local_scope));
   }
 
   return true;
@@ -171,9 +282,9 @@ bool DocumentIndex::ParseMethod(MethodInfo *method, const IPortablePdbFile &pdb,
 bool DocumentIndex::ParseScope(
     Scope *local_scope, const IPortablePdbFile &pdb,
     const LocalScopeRow &local_scope_row,
-    const std::vector<LocalScopeRow> &local_scope_table,
-    const std::vector<LocalVariableRow> &local_variable_table,
-    const std::vector<LocalConstantRow> &local_constant_table,
+    const MetadataTableView<LocalScopeRow> &local_scope_table,
+    const MetadataTableView<LocalVariableRow> &local_variable_table,
+    const MetadataTableView<LocalConstantRow> &local_constant_table,
     uint32_t method_def, uint32_t scope_index) {
   if (scope_index >= local_scope_table.size()) {
     cerr << "Scope index is out of range for Local Scope table.";
@@ -195,7 +306,7 @@ bool DocumentIndex::ParseScope(
     //  - The next run of LocalVariables, found by inspecting the
     //  VariableList of the next row in this LocalScope table.
     // Note that the next scope does not have to have the same method!
-    const LocalScopeRow &next_scope_row = local_scope_table[scope_index + 1];
+    LocalScopeRow next_scope_row = local_scope_table[scope_index + 1];
     local_scope->local_var_row_end_index =
         min(local_scope->local_var_row_end_index, next_scope_row.variable_list);
     local_scope->local_const_row_end_index = min(
@@ -211,14 +322,16 @@ bool DocumentIndex::ParseScope(
 
   for (size_t var_idx = local_scope->local_var_row_start_index;
        var_idx < local_scope->local_var_row_end_index; ++var_idx) {
-    const LocalVariableRow &local_variable_row = local_variable_table[var_idx];
+    LocalVariableRow local_variable_row = local_variable_table[var_idx];
     LocalVariableInfo new_variable;
     new_variable.debugger_hidden =
         (local_variable_row.attributes == kDebuggerHidden);
     new_variable.slot = local_variable_row.index;
-    if (!pdb.GetHeapString(local_variable_row.name, &new_variable.name)) {
+    string variable_name;
+    if (!pdb.GetHeapString(local_variable_row.name, &variable_name)) {
       return false;
     }
+    new_variable.name = StringPool::Intern(variable_name);
 
     local_scope->local_variables.push_back(std::move(new_variable));
   }
@@ -233,15 +346,16 @@ bool DocumentIndex::ParseScope(
   // Local constants.
   for (size_t const_idx = local_scope->local_const_row_start_index;
        const_idx < local_scope->local_const_row_end_index; ++const_idx) {
-    const LocalConstantRow &local_constant_row =
-        local_constant_table[const_idx];
+    LocalConstantRow local_constant_row = local_constant_table[const_idx];
     LocalConstantInfo new_const;
-    if (!pdb.GetHeapString(local_constant_row.name, &new_const.name)) {
+    string constant_name;
+    if (!pdb.GetHeapString(local_constant_row.name, &constant_name)) {
       return false;
     }
+    new_const.name = StringPool::Intern(constant_name);
 
-    if (!pdb.GetBlobBytes(local_constant_row.signature,
-                          &(new_const.signature_data))) {
+    if (!pdb.GetBlobSpan(local_constant_row.signature, &new_const.signature,
+                         &new_const.signature_size)) {
       return false;
     }
 
@@ -15,46 +15,29 @@
 #ifndef DOCUMENT_INDEX_H_
 #define DOCUMENT_INDEX_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "front_coded_string_table.h"
 #include "metadata_tables.h"
+#include "sequence_point_index.h"
+#include "sequence_point_list.h"
+#include "string_pool.h"
 
 namespace google_cloud_debugger_portable_pdb {
 
 class IPortablePdbFile;
 
-// Struct that represents a sequence point in a method.
-// Unlike SequencePointRecord struct, this struct has
-// the absoluate IL Offset.
-struct SequencePoint {
-  // IL Offset of this sequence point.
-  std::uint32_t il_offset = 0;
-
-  // Start line of this sequence point.
-  std::uint32_t start_line = 0;
-
-  // Start column of this sequence point.
-  std::uint32_t start_col = 0;
-
-  // End line of this sequence point.
-  std::uint32_t end_line = 0;
-
-  // End column of this sequence point.
-  std::uint32_t end_col = 0;
-
-  // True if this is a hidden or document change sequence point.
-  bool is_hidden = false;
-};
-
 // Struct that represents a local variable in a method.
 struct LocalVariableInfo {
   // The slot (index) of the variable in the method.
   std::uint16_t slot = 0;
 
   // Name of the variable.
-  std::string name;
+  InternedString name;
 
   // True if the variable should be hidden from the debugger.
   bool debugger_hidden = false;
@@ -62,10 +45,14 @@ struct LocalVariableInfo {
 
 // Struct that represents constant in a method.
 struct LocalConstantInfo {
-  std::string name;
+  // Name of the constant.
+  InternedString name;
 
-  // Bytes containing signature data.
-  std::vector<uint8_t> signature_data;
+  // Bytes containing signature data, in the blob heap of the PDB.
+  const std::uint8_t *signature = nullptr;
+
+  // Number of bytes in signature.
+  std::uint32_t signature_size = 0;
 };
 
 // Struct that represents the local scope of a method.
@@ -113,16 +100,52 @@ struct MethodInfo {
   std::uint32_t last_line = 0;
 
   // Vector of sequence points of this method.
-  std::vector<SequencePoint> sequence_points;
+  SequencePointList sequence_points;
+};
+
+// Memory used by the parsed methods of a module.
+struct MethodsMemoryFootprint {
+  // Adds the memory used by method to the footprint. Its local scopes
+  // are decoded separately and added with the other overload.
+  void Add(const MethodInfo &method);
+
+  // Adds the memory used by the local scopes of a method to the footprint.
+  void Add(const std::vector<Scope> &scopes);
+
+  // Number of methods.
+  std::size_t methods = 0;
+
+  // Number of sequence points of the methods.
+  std::size_t sequence_points = 0;
+
+  // Bytes used by the encoded sequence points of the methods.
+  std::size_t sequence_point_bytes = 0;
+
+  // Bytes the sequence points would take as arrays of SequencePoint.
+  std::size_t uncompressed_sequence_point_bytes = 0;
+
+  // Bytes used by the local scopes, variables and constants of the methods,
+  // not counting the interned names.
+  std::size_t scope_bytes = 0;
+};
 
-  // Vector of local scopes of this method.
-  std::vector<Scope> local_scope;
+// The parsed methods of a document and the index of their sequence points.
+// They do not change once parsed, so the documents of every PortablePdbFile
+// with the same PDB id can share them (see PdbIndexStore).
+struct DocumentMethods {
+  // The methods of the document.
+  std::vector<MethodInfo> methods;
+
+  // Index of the sequence points in methods by line.
+  SequencePointIndex sequence_point_index;
 };
 
 // Index for a single source file described in a Portable PDB. Essentially a
 // user-friendly copy of all the data encoded in the PDB's metadata table.
 //
-// A document index is initialized by calling the Initialize method.
+// A document index is initialized by calling the Initialize method, which
+// only reads the document's name, language and hash. Its methods are only
+// available after ParseMethods is called.
 class IDocumentIndex {
  public:
   // Destructor.
@@ -132,11 +155,38 @@ class IDocumentIndex {
   // in the DocumentTable of the Portable PDB file pdb.
   virtual bool Initialize(const IPortablePdbFile &pdb, int doc_index) = 0;
 
+  // Parses the methods in method_defs, which must be the methods whose
+  // MethodDebugInformation rows belong to this document.
+  virtual bool ParseMethods(const IPortablePdbFile &pdb,
+                            const std::vector<std::uint32_t> &method_defs) = 0;
+
+  // Sets the methods of this document to methods parsed earlier
+  // (for example, loaded from PdbIndexCache) instead of parsing them.
+  virtual void SetMethods(std::vector<MethodInfo> methods) = 0;
+
+  // Sets the methods of this document to methods that another document
+  // with the same content parsed.
+  virtual void SetSharedMethods(
+      std::shared_ptr<const DocumentMethods> methods) = 0;
+
+  // Returns the methods of this document so that other documents with the
+  // same content can share them, or null if they are not parsed.
+  virtual std::shared_ptr<const DocumentMethods> GetSharedMethods()
+      const = 0;
+
   // Returns the file path of this document.
-  virtual const std::string &GetFilePath() const = 0;
+  virtual std::string GetFilePath() const = 0;
+
+  // Returns the hash of the content of this document in lower case hex,
+  // or an empty string if the PDB has none.
+  virtual const std::string &GetContentHash() const = 0;
 
   // Returns all the methods in this document.
   virtual const std::vector<MethodInfo> &GetMethods() const = 0;
+
+  // Returns the index that resolves lines in this document to
+  // sequence points of its methods.
+  virtual const SequencePointIndex &GetSequencePointIndex() const = 0;
 };
 
 // Implementation of IDocumentIndex interface.
@@ -146,11 +196,51 @@ class DocumentIndex : public IDocumentIndex {
   // in the DocumentTable of the Portable PDB file pdb.
   bool Initialize(const IPortablePdbFile &pdb, int doc_index);
 
+  // Parses the methods in method_defs, which must be the methods whose
+  // MethodDebugInformation rows belong to this document.
+  bool ParseMethods(const IPortablePdbFile &pdb,
+                    const std::vector<std::uint32_t> &method_defs);
+
+  // Sets the methods of this document to methods parsed earlier
+  // (for example, loaded from PdbIndexCache) instead of parsing them.
+  void SetMethods(std::vector<MethodInfo> methods);
+
+  // Sets the methods of this document to methods that another document
+  // with the same content parsed.
+  void SetSharedMethods(std::shared_ptr<const DocumentMethods> methods);
+
+  // Returns the methods of this document, or null if they are not parsed.
+  std::shared_ptr<const DocumentMethods> GetSharedMethods() const {
+    return methods_;
+  }
+
+  // Moves the file path of this document to the string at position of
+  // paths, which has to outlive this document. The PDB stores the paths
+  // of all its documents in one front-coded table.
+  void SetPathTable(const FrontCodedStringTable *paths,
+                    std::uint32_t position);
+
   // Returns the file path of this document.
-  const std::string &GetFilePath() const { return file_path_; }
+  std::string GetFilePath() const;
+
+  // Returns the hash of the content of this document in lower case hex,
+  // or an empty string if the PDB has none.
+  const std::string &GetContentHash() const { return content_hash_; }
 
   // Returns all the methods in this document.
-  const std::vector<MethodInfo> &GetMethods() const { return methods_; }
+  const std::vector<MethodInfo> &GetMethods() const;
+
+  // Returns the index that resolves lines in this document to
+  // sequence points of its methods.
+  const SequencePointIndex &GetSequencePointIndex() const;
+
+  // Parses the local scopes of method method_def, with their variables
+  // and constants, from the LocalScope table of pdb. The scopes are not
+  // parsed with the methods of a document since only the methods of
+  // captured stack frames need them.
+  static bool ParseScopes(const IPortablePdbFile &pdb,
+                          std::uint32_t method_def,
+                          std::vector<Scope> *scopes);
 
  private:
   // Populate a method object that corresponds to MethodDebugInformationRow
@@ -164,15 +254,22 @@ class DocumentIndex : public IDocumentIndex {
   // local_scope_row. The Scope object will have its variable
   // and constant tables filled up with variables and constants that
   // belong to the scope.
-  bool ParseScope(Scope *scope, const IPortablePdbFile &pdb,
-                  const LocalScopeRow &local_scope_row,
-                  const std::vector<LocalScopeRow> &local_scope_table,
-                  const std::vector<LocalVariableRow> &local_variable_table,
-                  const std::vector<LocalConstantRow> &local_constant_table,
-                  std::uint32_t method_def, std::uint32_t scope_index);
-
-  // The file path of this document.
+  static bool ParseScope(
+      Scope *scope, const IPortablePdbFile &pdb,
+      const LocalScopeRow &local_scope_row,
+      const MetadataTableView<LocalScopeRow> &local_scope_table,
+      const MetadataTableView<LocalVariableRow> &local_variable_table,
+      const MetadataTableView<LocalConstantRow> &local_constant_table,
+      std::uint32_t method_def, std::uint32_t scope_index);
+
+  // The index of this document in the DocumentTable.
+  std::uint32_t doc_index_ = 0;
+
+  // The file path of this document until SetPathTable moves it to
+  // paths_, where it is at path_position_.
   std::string file_path_;
+  const FrontCodedStringTable *paths_ = nullptr;
+  std::uint32_t path_position_ = 0;
 
   // The source language of this document.
   std::string source_language_;
@@ -180,11 +277,18 @@ class DocumentIndex : public IDocumentIndex {
   // The hash algorithm of this document.
   std::string hash_algorithm_;
 
-  // The hash of this document.
-  std::vector<uint8_t> hash_;
+  // The hash of this document, in the blob heap of the PDB.
+  const std::uint8_t *hash_ = nullptr;
+
+  // Number of bytes in hash_.
+  std::uint32_t hash_size_ = 0;
+
+  // hash_ in lower case hex, which is how breakpoints carry it.
+  std::string content_hash_;
 
-  // The methods of this document.
-  std::vector<MethodInfo> methods_;
+  // The methods of this document and their index, or null if they are
+  // not parsed.
+  std::shared_ptr<const DocumentMethods> methods_;
 };
 
 }  // namespace google_cloud_debugger_portable_pdb
@@ -0,0 +1,200 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "document_path_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+#include "document_index.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace google_cloud_debugger_portable_pdb {
+
+void DocumentPathIndex::Initialize(
+    const vector<unique_ptr<IDocumentIndex>> &document_indices) {
+  nodes_.clear();
+  nodes_.emplace_back();
+  document_nodes_.clear();
+  document_nodes_.reserve(document_indices.size());
+  documents_by_hash_.clear();
+
+  for (size_t i = 0; i < document_indices.size(); ++i) {
+    DocumentPathKey key = CreatePathKey(document_indices[i]->GetFilePath());
+
+    uint32_t current = 0;
+    for (size_t j = 0; j < key.reversed_segments.size(); ++j) {
+      string &segment = key.reversed_segments[j];
+      size_t hash = key.segment_hashes[j];
+      int64_t child = FindChild(current, segment, hash);
+      if (child == -1) {
+        uint32_t new_node = nodes_.size();
+        nodes_[current].children.emplace(hash, new_node);
+        nodes_.emplace_back();
+        nodes_[new_node].segment = std::move(segment);
+        nodes_[new_node].parent = current;
+        current = new_node;
+      } else {
+        current = child;
+      }
+
+      // Documents are inserted in order so the first one to reach
+      // a node is the one with the smallest position.
+      if (nodes_[current].first_document == -1) {
+        nodes_[current].first_document = i;
+      }
+    }
+    document_nodes_.push_back(current);
+
+    const string &content_hash = document_indices[i]->GetContentHash();
+    if (!content_hash.empty()) {
+      documents_by_hash_[content_hash].push_back(i);
+    }
+  }
+}
+
+int32_t DocumentPathIndex::FindBestMatch(const DocumentPathKey &key) const {
+  if (nodes_.empty()) {
+    return -1;
+  }
+
+  int32_t best_match = -1;
+  uint32_t current = 0;
+  for (size_t i = 0; i < key.reversed_segments.size(); ++i) {
+    int64_t child =
+        FindChild(current, key.reversed_segments[i], key.segment_hashes[i]);
+    if (child == -1) {
+      break;
+    }
+
+    current = child;
+    best_match = nodes_[current].first_document;
+  }
+
+  return best_match;
+}
+
+int32_t DocumentPathIndex::FindDocument(const DocumentPathKey &key,
+                                        const string &content_hash) const {
+  auto documents = content_hash.empty() ? documents_by_hash_.end()
+                                        : documents_by_hash_.find(content_hash);
+  if (documents == documents_by_hash_.end()) {
+    return FindBestMatch(key);
+  }
+
+  vector<uint32_t> matched_nodes;
+  uint32_t current = 0;
+  for (size_t i = 0; i < key.reversed_segments.size(); ++i) {
+    int64_t child =
+        FindChild(current, key.reversed_segments[i], key.segment_hashes[i]);
+    if (child == -1) {
+      break;
+    }
+    current = child;
+    matched_nodes.push_back(current);
+  }
+
+  // Documents with the same content but another file name are skipped,
+  // as identical files (empty ones, for example) are common.
+  int32_t best_match = -1;
+  size_t best_length = 0;
+  for (uint32_t document : documents->second) {
+    size_t length = GetMatchLength(document, matched_nodes);
+    if (length > best_length) {
+      best_match = document;
+      best_length = length;
+    }
+  }
+
+  return best_match == -1 ? FindBestMatch(key) : best_match;
+}
+
+DocumentPathKey DocumentPathIndex::CreatePathKey(const string &path) {
+  DocumentPathKey key;
+  key.reversed_segments = SplitFilePath(NormalizeFilePath(path));
+  key.segment_hashes.reserve(key.reversed_segments.size());
+  std::hash<string> hasher;
+  for (auto &&segment : key.reversed_segments) {
+    key.segment_hashes.push_back(hasher(segment));
+  }
+  return key;
+}
+
+string DocumentPathIndex::NormalizeFilePath(const string &path) {
+  string result = path;
+  // The PDB may use either Unix or Windows-style paths, but the
+  // Cloud Debugger only uses Unix.
+  std::replace(result.begin(), result.end(), '\\', '/');
+  std::transform(
+      result.begin(), result.end(), result.begin(),
+      [](unsigned char c) -> unsigned char { return std::tolower(c); });
+  return result;
+}
+
+vector<string> DocumentPathIndex::SplitFilePath(const string &path) {
+  vector<string> result;
+
+  static const string delimiter = "/";
+  size_t delimiter_position = path.find(delimiter);
+  size_t start_offset = 0;
+
+  while (delimiter_position != string::npos) {
+    result.push_back(
+        path.substr(start_offset, delimiter_position - start_offset));
+    start_offset = delimiter_position + delimiter.length();
+    delimiter_position = path.find(delimiter, start_offset);
+  }
+
+  result.push_back(path.substr(start_offset));
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+
+size_t DocumentPathIndex::GetMatchLength(
+    uint32_t document, const vector<uint32_t> &matched_nodes) const {
+  // The nodes of the path of the document, from its file name to its
+  // root.
+  vector<uint32_t> path;
+  for (uint32_t node = document_nodes_[document]; node != 0;
+       node = nodes_[node].parent) {
+    path.push_back(node);
+  }
+  std::reverse(path.begin(), path.end());
+
+  // Paths in the trie share their nodes up to the first trailing segment
+  // that differs.
+  size_t length = 0;
+  while (length < matched_nodes.size() && length < path.size() &&
+         path[length] == matched_nodes[length]) {
+    ++length;
+  }
+  return length;
+}
+
+int64_t DocumentPathIndex::FindChild(uint32_t node, const string &segment,
+                                     size_t hash) const {
+  auto children = nodes_[node].children.equal_range(hash);
+  for (auto child = children.first; child != children.second; ++child) {
+    if (nodes_[child->second].segment == segment) {
+      return child->second;
+    }
+  }
+  return -1;
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
@@ -0,0 +1,128 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DOCUMENT_PATH_INDEX_H_
+#define DOCUMENT_PATH_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace google_cloud_debugger_portable_pdb {
+
+class IDocumentIndex;
+
+// A normalized file path split into segments in reverse order, with the
+// hash of every segment. Breakpoints and documents compute their keys
+// once, so matching compares hashes and only compares the segments
+// themselves when the hashes are equal.
+struct DocumentPathKey {
+  std::vector<std::string> reversed_segments;
+  std::vector<std::size_t> segment_hashes;
+};
+
+// Index of the file paths of the documents in a Portable PDB.
+//
+// Every path is normalized (lower case, '/' as separator) and inserted
+// into a trie with its segments in reverse order, so the file name is
+// the first level of the trie. Finding the document whose path shares the
+// longest suffix with a breakpoint location is then a single walk down
+// the trie instead of a comparison against every document. The documents
+// are also indexed by the hash of their content, which tells apart files
+// that share a path suffix, like the many Program.cs of a monorepo.
+class DocumentPathIndex {
+ public:
+  // Builds the index from document_indices. Positions returned by
+  // FindBestMatch are positions in this vector.
+  void Initialize(
+      const std::vector<std::unique_ptr<IDocumentIndex>> &document_indices);
+
+  // Given the key of a path (as returned by CreatePathKey), returns the
+  // position of the document that matches the most trailing segments.
+  // If several documents match equally well, the one that comes first is
+  // returned. Returns -1 if no document has the same file name.
+  std::int32_t FindBestMatch(const DocumentPathKey &key) const;
+
+  // Returns the position of the document of a breakpoint at the path of
+  // key whose file has the content hash content_hash (lower case hex).
+  // Of the documents with that hash and the same file name, the one that
+  // matches the most trailing segments is returned. If there is none or
+  // content_hash is empty, falls back to FindBestMatch.
+  std::int32_t FindDocument(const DocumentPathKey &key,
+                            const std::string &content_hash) const;
+
+  // Normalizes path, splits it up and hashes its segments.
+  static DocumentPathKey CreatePathKey(const std::string &path);
+
+  // Lower cases path and replaces '\' with '/'.
+  static std::string NormalizeFilePath(const std::string &path);
+
+  // Split up file path into segments (using '/' as delimiter).
+  // The returned vector will be reversed with the file name
+  // as the first item.
+  static std::vector<std::string> SplitFilePath(const std::string &path);
+
+ private:
+  // The segment hashes are already hashes, so they index the children
+  // as they are.
+  struct SegmentHash {
+    std::size_t operator()(std::size_t hash) const { return hash; }
+  };
+
+  struct TrieNode {
+    // The path segment leading to this node.
+    std::string segment;
+
+    // Position of the parent node in nodes_.
+    std::uint32_t parent = 0;
+
+    // Maps the hash of a path segment to the positions of the child nodes
+    // in nodes_. Segments with the same hash share an entry.
+    std::unordered_multimap<std::size_t, std::uint32_t, SegmentHash>
+        children;
+
+    // Smallest position of a document whose path goes through this node.
+    std::int32_t first_document = -1;
+  };
+
+  // Returns the position of the child of node for the segment with the
+  // given hash, or -1 if there is none.
+  std::int64_t FindChild(std::uint32_t node, const std::string &segment,
+                         std::size_t hash) const;
+
+  // Returns the number of trailing segments the path of document shares
+  // with the path that led to matched_nodes, the nodes of the trie
+  // matched by each of its segments.
+  std::size_t GetMatchLength(
+      std::uint32_t document,
+      const std::vector<std::uint32_t> &matched_nodes) const;
+
+  // Nodes of the trie. The first node is the root.
+  std::vector<TrieNode> nodes_;
+
+  // The node of the first segment of the path of each document, which
+  // is the deepest node of the path.
+  std::vector<std::uint32_t> document_nodes_;
+
+  // Maps the content hash of documents to their positions, in order.
+  std::unordered_map<std::string, std::vector<std::uint32_t>>
+      documents_by_hash_;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // DOCUMENT_PATH_INDEX_H_
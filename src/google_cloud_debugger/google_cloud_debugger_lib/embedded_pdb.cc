@@ -0,0 +1,106 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "embedded_pdb.h"
+
+#include <iostream>
+#include <vector>
+
+#ifdef PLATFORM_UNIX
+#include <zlib.h>
+#endif
+
+#include "pe_debug_directory.h"
+
+using std::cerr;
+
+namespace google_cloud_debugger_portable_pdb {
+
+namespace {
+
+// Signature "MPDB" of the data of an embedded Portable PDB.
+const std::uint32_t kEmbeddedPdbSignature = 0x4244504D;
+
+// Size of the signature and of the PDB size in front of the deflated PDB.
+const std::size_t kEmbeddedPdbHeaderSize = 8;
+
+// Reads the little-endian uint32 at data.
+std::uint32_t ReadUInt32(const std::uint8_t *data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+         (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+}  // namespace
+
+bool EmbeddedPdb::Find(const std::uint8_t *image, std::size_t size) {
+  compressed_ = nullptr;
+  compressed_size_ = 0;
+  pdb_size_ = 0;
+
+  std::vector<DebugDirectoryEntry> entries;
+  if (!ReadDebugDirectory(image, size, &entries)) {
+    return false;
+  }
+
+  for (const DebugDirectoryEntry &entry : entries) {
+    if (entry.type != kEmbeddedPortablePdbDebugType) {
+      continue;
+    }
+
+    if (entry.data_size < kEmbeddedPdbHeaderSize ||
+        ReadUInt32(entry.data) != kEmbeddedPdbSignature) {
+      cerr << "Invalid embedded PDB." << std::endl;
+      return false;
+    }
+
+    pdb_size_ = ReadUInt32(entry.data + 4);
+    compressed_ = entry.data + kEmbeddedPdbHeaderSize;
+    compressed_size_ = entry.data_size - kEmbeddedPdbHeaderSize;
+    return true;
+  }
+
+  return false;
+}
+
+bool EmbeddedPdb::Inflate(std::uint8_t *target) const {
+#ifdef PLATFORM_UNIX
+  if (!compressed_ || !target) {
+    return false;
+  }
+
+  z_stream stream = z_stream();
+  // Negative window bits read raw deflate without a zlib header.
+  int result = inflateInit2(&stream, -MAX_WBITS);
+  if (result != Z_OK) {
+    cerr << "inflateInit2 error: " << result << std::endl;
+    return false;
+  }
+
+  stream.next_in = const_cast<Bytef *>(compressed_);
+  stream.avail_in = compressed_size_;
+  stream.next_out = target;
+  stream.avail_out = pdb_size_;
+  result = inflate(&stream, Z_FINISH);
+  bool complete = result == Z_STREAM_END && stream.total_out == pdb_size_;
+  inflateEnd(&stream);
+  if (!complete) {
+    cerr << "Failed to inflate the embedded PDB: " << result << std::endl;
+  }
+  return complete;
+#else
+  return false;
+#endif
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
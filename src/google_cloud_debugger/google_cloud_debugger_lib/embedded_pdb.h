@@ -0,0 +1,60 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMBEDDED_PDB_H_
+#define EMBEDDED_PDB_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace google_cloud_debugger_portable_pdb {
+
+// Portable PDB embedded in a module built with DebugType=embedded. The
+// debug directory of the PE file of such a module has an entry of type
+// EmbeddedPortablePdb, whose data is the signature "MPDB", the size of
+// the PDB as a little-endian uint32 and the PDB compressed with raw
+// deflate (RFC 1951). See
+// https://github.com/dotnet/corefx/blob/master/src/System.Reflection.Metadata/specs/PE-COFF.md
+//
+// Decompression uses zlib, which is only linked on unix. On other
+// platforms Inflate always returns false.
+class EmbeddedPdb {
+ public:
+  // Finds the embedded PDB in the size bytes of the PE file at image,
+  // which must outlive this object. Returns false if image is not a PE
+  // file or has no embedded PDB.
+  bool Find(const std::uint8_t *image, std::size_t size);
+
+  // Returns the size of the decompressed PDB.
+  std::uint32_t GetPdbSize() const { return pdb_size_; }
+
+  // Decompresses the PDB into target, which must have room for
+  // GetPdbSize() bytes. The compressed bytes are inflated straight from
+  // the image into target.
+  bool Inflate(std::uint8_t *target) const;
+
+ private:
+  // The deflated PDB in the image.
+  const std::uint8_t *compressed_ = nullptr;
+
+  // Size of compressed_.
+  std::uint32_t compressed_size_ = 0;
+
+  // Size of the decompressed PDB.
+  std::uint32_t pdb_size_ = 0;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // EMBEDDED_PDB_H_
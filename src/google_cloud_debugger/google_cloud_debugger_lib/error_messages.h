@@ -20,6 +20,9 @@
 // This file contains error messages used by the Debugger.
 namespace google_cloud_debugger {
 
+static const std::string kCaptureDeadlineExceeded =
+    "Capture deadline exceeded.";
+
 static const std::string kFailedEvalCreation =
     "Failed to create ICorDebugEval.";
 
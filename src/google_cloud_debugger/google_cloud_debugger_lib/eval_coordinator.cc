@@ -14,8 +14,9 @@
 
 #include "eval_coordinator.h"
 
+#include <algorithm>
 #include <chrono>
-#include <future>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -26,34 +27,113 @@
 #include "dbg_breakpoint.h"
 #include "dbg_class.h"
 #include "dbg_object_factory.h"
+#include "dbg_object_pool.h"
+#include "metrics.h"
+#include "module_registry.h"
 #include "stack_frame_collection.h"
+#include "trace.h"
 
 using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Status;
 using std::cerr;
 using std::lock_guard;
 using std::mutex;
+using std::shared_ptr;
 using std::unique_lock;
 using std::unique_ptr;
 using std::chrono::high_resolution_clock;
-using std::chrono::minutes;
+using std::chrono::milliseconds;
 
 namespace google_cloud_debugger {
 
-minutes EvalCoordinator::one_minute = minutes(1);
+namespace {
+
+// A log point whose expression values were read while the debuggee was
+// stopped and are written after it continues.
+struct CapturedLogPoint {
+  std::shared_ptr<DbgBreakpoint> breakpoint;
+  std::unique_ptr<Breakpoint> proto_breakpoint;
+  DbgBreakpoint::ExpressionValues values;
+  DbgBreakpoint::ExpressionAges ages;
+  CaptureLimits limits;
+};
+
+// A snapshot or log point whose values were all read while the debuggee
+// was stopped. It is measured and handed to the writer after the
+// debuggee continues.
+struct PopulatedBreakpoint {
+  std::shared_ptr<DbgBreakpoint> breakpoint;
+  std::unique_ptr<Breakpoint> proto_breakpoint;
+};
+
+// Captures a breakpoint with reduced limits for the rest of the
+// enclosing scope if reduce is true.
+class ScopedReducedLimits {
+ public:
+  ScopedReducedLimits(DbgBreakpoint *breakpoint, bool reduce)
+      : breakpoint_(reduce ? breakpoint : nullptr) {
+    if (breakpoint_) {
+      limits_ = breakpoint_->GetCaptureLimits();
+      breakpoint_->SetCaptureLimits(OverheadGovernor::ReduceLimits(limits_));
+    }
+  }
+  ScopedReducedLimits(const ScopedReducedLimits &) = delete;
+  ScopedReducedLimits &operator=(const ScopedReducedLimits &) = delete;
+
+  ~ScopedReducedLimits() {
+    if (breakpoint_) {
+      breakpoint_->SetCaptureLimits(limits_);
+    }
+  }
+
+ private:
+  DbgBreakpoint *breakpoint_;
+  CaptureLimits limits_;
+};
+
+// Tells in the status of breakpoint that its hit was degraded at level.
+void PopulateDegradedStatus(OverheadGovernor::Level level,
+                            Breakpoint *breakpoint) {
+  if (level == OverheadGovernor::kNone || breakpoint->has_status()) {
+    return;
+  }
+  unique_ptr<Status> status(new (std::nothrow) Status());
+  if (!status) {
+    return;
+  }
+  status->set_iserror(false);
+  status->set_message(OverheadGovernor::GetStatusMessage(level));
+  breakpoint->set_allocated_status(status.release());
+}
+
+}  // namespace
+
+thread_local EvalCoordinator::ThreadState *EvalCoordinator::caller_state_ =
+    nullptr;
 
 HRESULT EvalCoordinator::CreateEval(ICorDebugEval **eval) {
   lock_guard<mutex> lk(mutex_);
 
-  if (active_debug_thread_ == nullptr) {
+  ThreadState *thread_state = GetCallerState();
+  if (thread_state->debug_thread == nullptr) {
     std::cerr << "Active debug thread is missing";
     return E_FAIL;
   }
-  return active_debug_thread_->CreateEval(eval);
+
+  if ((max_func_evals_ != 0 && thread_state->func_evals >= max_func_evals_) ||
+      GetEvaluationTimeout(thread_state).count() <= 0) {
+    std::cerr << "Evaluation budget of the breakpoint is used up.";
+    return E_ABORT;
+  }
+
+  thread_state->func_evals += 1;
+  return thread_state->debug_thread->CreateEval(eval);
 }
 
 HRESULT EvalCoordinator::CreateStackWalk(
     ICorDebugStackWalk **debug_stack_walk) {
-  if (!active_debug_thread_) {
+  ThreadState *thread_state = GetCallerState();
+  if (!thread_state->debug_thread) {
     cerr << "Active debug thread is missing";
     return E_FAIL;
   }
@@ -61,7 +141,7 @@ HRESULT EvalCoordinator::CreateStackWalk(
   HRESULT hr;
   CComPtr<ICorDebugThread3> debug_thread3;
 
-  hr = active_debug_thread_->QueryInterface(
+  hr = thread_state->debug_thread->QueryInterface(
       __uuidof(ICorDebugThread3), reinterpret_cast<void **>(&debug_thread3));
   if (FAILED(hr)) {
     cerr << "Failed to cast ICorDebugThread to ICorDebugThread3.";
@@ -74,23 +154,52 @@ HRESULT EvalCoordinator::CreateStackWalk(
 HRESULT EvalCoordinator::WaitForEval(BOOL *exception_thrown,
                                      ICorDebugEval *eval,
                                      ICorDebugValue **eval_result) {
+  DEBUGGER_TRACE_SPAN("EvalCoordinator::WaitForEval");
+
   // Let the debugger continue so we can get back the eval result.
   unique_lock<mutex> lk(mutex_);
 
-  waiting_for_eval_ = TRUE;
-  debuggercallback_can_continue_ = TRUE;
-  eval_exception_occurred_ = FALSE;
+  ThreadState *thread_state = GetCallerState();
+  thread_state->waiting_for_eval = TRUE;
+  thread_state->debuggercallback_can_continue = TRUE;
+  thread_state->eval_exception_occurred = FALSE;
+
+  // The evaluation may move the objects the handles hold, and the
+  // dereferenced values and the memory read are not valid once the
+  // debuggee runs.
+  thread_state->strong_handles.ForgetAddresses();
+  thread_state->dereferenced_values.Clear();
+  thread_state->memory_pages.Clear();
   HRESULT hr = CORDBG_E_FUNC_EVAL_NOT_COMPLETE;
+  std::chrono::steady_clock::time_point eval_start =
+      std::chrono::steady_clock::now();
   auto start = high_resolution_clock::now();
+  milliseconds timeout = std::max(GetEvaluationTimeout(thread_state),
+                                  milliseconds(0));
+  bool aborted = false;
 
   // Wait until evaluation is done.
   while (hr == CORDBG_E_FUNC_EVAL_NOT_COMPLETE ||
          hr == CORDBG_E_PROCESS_NOT_SYNCHRONIZED) {
     auto current = high_resolution_clock::now();
-    if (current - start > one_minute) {
+    if (current - start > timeout) {
       hr = CORDBG_E_FUNC_EVAL_NOT_COMPLETE;
+      if (aborted) {
+        cerr << "Timed out while trying to abort function evaluation.";
+        break;
+      }
+
+      // Gives the evaluation some time to stop once it is aborted so
+      // that the thread does not keep running it.
       cerr << "Timed out while trying to evaluate function.";
-      break;
+      aborted = true;
+      if (FAILED(eval->Abort())) {
+        cerr << "Failed to abort function evaluation.";
+        break;
+      }
+      start = current;
+      timeout = milliseconds(kEvalAbortTimeoutMs);
+      continue;
     }
 
     hr = eval->GetResult(eval_result);
@@ -98,79 +207,153 @@ HRESULT EvalCoordinator::WaitForEval(BOOL *exception_thrown,
     if (hr == CORDBG_E_FUNC_EVAL_NOT_COMPLETE ||
         hr == CORDBG_E_PROCESS_NOT_SYNCHRONIZED) {
       // Wake up the debugger thread to do the evaluation.
-      debugger_callback_cv_.notify_one();
-      variable_threads_cv_.wait_for(lk, one_minute);
+      debugger_callback_cv_.notify_all();
+      thread_state->variable_thread_cv.wait_for(lk,
+                                                timeout - (current - start));
     } else {
       break;
     }
   }
 
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.func_evals.Increment();
+  metrics.func_eval_time_us.RecordSince(eval_start);
+
+  // The result of an aborted evaluation is not used.
+  if (aborted) {
+    metrics.func_eval_timeouts.Increment();
+    hr = CORDBG_E_FUNC_EVAL_NOT_COMPLETE;
+  }
+
   // We got our lock back!
   // Tells the debugger to chill out until our next eval call or we reach the
   // end.
-  debuggercallback_can_continue_ = FALSE;
-  waiting_for_eval_ = FALSE;
+  thread_state->debuggercallback_can_continue = FALSE;
+  thread_state->waiting_for_eval = FALSE;
 
-  *exception_thrown = eval_exception_occurred_;
+  *exception_thrown = thread_state->eval_exception_occurred;
   return hr;
 }
 
 void EvalCoordinator::SignalFinishedEval(ICorDebugThread *debug_thread) {
   unique_lock<mutex> lk(mutex_);
 
-  debuggercallback_can_continue_ = FALSE;
-  active_debug_thread_ = debug_thread;
-  // Wake up all variable threads and so one of them can
-  // use the evaluation result.
-  variable_threads_cv_.notify_all();
-
-  // finished_printing_variables_ is set to true if the StackFrame
-  // decides to call SignalFinishedPrintingVariable to signal that it has
-  // finished printing the variables.
-  // debuggercallback_can_continue_ is set to true if the StackFrame
-  // makes another evaluation by calling WaitForEval.
-  debugger_callback_cv_.wait(lk,
-                             [&] { return debuggercallback_can_continue_; });
+  std::shared_ptr<ThreadState> thread_state = FindThreadState(debug_thread);
+  if (!thread_state) {
+    cerr << "No breakpoint is being processed for the evaluation thread.";
+    return;
+  }
+
+  thread_state->debuggercallback_can_continue = FALSE;
+  thread_state->debug_thread = debug_thread;
+  // Wake up the task of this thread so it can use the evaluation result.
+  thread_state->variable_thread_cv.notify_all();
+
+  // debuggercallback_can_continue is set to true once the task either
+  // makes another evaluation by calling WaitForEval or calls
+  // SignalFinishedPrintingVariable to signal that it has finished
+  // printing the variables.
+  debugger_callback_cv_.wait(
+      lk, [&] { return thread_state->debuggercallback_can_continue; });
 }
 
 HRESULT EvalCoordinator::ProcessBreakpoints(
     ICorDebugThread *debug_thread, IBreakpointCollection *breakpoint_collection,
     std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints,
-    const std::vector<
-        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-        &pdb_files) {
+    std::shared_ptr<const ModuleSnapshot> modules) {
+  DEBUGGER_TRACE_SPAN("EvalCoordinator::ProcessBreakpoints");
+
   if (!debug_thread) {
     cerr << "Debug stack walk is null.";
     return E_INVALIDARG;
   }
 
-  active_debug_thread_ = debug_thread;
+  DWORD thread_id = 0;
+  HRESULT hr = debug_thread->GetID(&thread_id);
+  if (FAILED(hr)) {
+    cerr << "Failed to get the ID of the debug thread.";
+    return hr;
+  }
 
   unique_lock<mutex> lk(mutex_);
 
-  std::future<HRESULT> print_breakpoint_task = std::async(
-      std::launch::async, &EvalCoordinator::ProcessBreakpointsTask, this,
-      breakpoint_collection, std::move(breakpoints), pdb_files);
-  print_breakpoint_tasks_.push_back(std::move(print_breakpoint_task));
+  // The breakpoints of this thread are already being processed, which
+  // happens when an evaluation for them hits a breakpoint.
+  if (thread_states_.find(thread_id) != thread_states_.end()) {
+    return S_OK;
+  }
 
-  ready_to_print_variables_ = TRUE;
-  debuggercallback_can_continue_ = FALSE;
+  std::shared_ptr<ThreadState> thread_state(new (std::nothrow) ThreadState());
+  if (!thread_state) {
+    cerr << "Failed to create the state of the debug thread.";
+    return E_OUTOFMEMORY;
+  }
+
+  // A DbgBreakpoint holds the results of one hit at a time, so a
+  // breakpoint that is being processed for another thread is skipped.
+  for (auto &&breakpoint : breakpoints) {
+    bool in_use = false;
+    for (auto &&other_state : thread_states_) {
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &other_breakpoints =
+          other_state.second->breakpoints;
+      if (std::find(other_breakpoints.begin(), other_breakpoints.end(),
+                    breakpoint) != other_breakpoints.end()) {
+        in_use = true;
+        break;
+      }
+    }
+
+    if (!in_use) {
+      thread_state->breakpoints.push_back(std::move(breakpoint));
+    }
+  }
+
+  if (thread_state->breakpoints.empty()) {
+    return S_OK;
+  }
+
+  thread_state->thread_id = thread_id;
+  thread_state->debug_thread = debug_thread;
+  thread_state->hit_start = std::chrono::steady_clock::now();
+  thread_states_[thread_id] = thread_state;
+
+  // The task reports its own errors, so its HRESULT is dropped.
+  std::function<void()> print_breakpoint_task =
+      std::bind(&EvalCoordinator::ProcessBreakpointsTask, this,
+                breakpoint_collection, std::move(modules), thread_state);
+  if (!evaluation_pool_.ScheduleWithoutWaiting(
+          std::move(print_breakpoint_task))) {
+    thread_states_.erase(thread_id);
+    cerr << "Failed to schedule breakpoint processing.";
+    return E_FAIL;
+  }
+
+  std::size_t evaluation_threads = evaluation_pool_.GetThreadCount();
+  if (evaluation_threads != reported_evaluation_threads_) {
+    reported_evaluation_threads_ = evaluation_threads;
+    cerr << "Breakpoints are processed on " << evaluation_threads
+         << " evaluation threads." << std::endl;
+  }
 
-  // Notify the StackFrame threads we are ready.
-  variable_threads_cv_.notify_all();
+  thread_state->ready_to_print_variables = TRUE;
 
-  // The StackFrame in active_debug_thread_ will have to set
-  // debuggerCallBackCanContinue to TRUE by either calling WaitForEval
-  // or SignalFinishPrintingVariable.
-  debugger_callback_cv_.wait(lk,
-                             [&] { return debuggercallback_can_continue_; });
+  // Notify the task we are ready.
+  thread_state->variable_thread_cv.notify_all();
+
+  // The task will have to set debuggercallback_can_continue to TRUE by
+  // either calling WaitForEval or SignalFinishPrintingVariable.
+  debugger_callback_cv_.wait(
+      lk, [&] { return thread_state->debuggercallback_can_continue; });
 
   return S_OK;
 }
 
-void EvalCoordinator::HandleException() {
+void EvalCoordinator::HandleException(ICorDebugThread *debug_thread) {
   lock_guard<mutex> lk(mutex_);
-  eval_exception_occurred_ = TRUE;
+  std::shared_ptr<ThreadState> thread_state = FindThreadState(debug_thread);
+  if (thread_state) {
+    thread_state->eval_exception_occurred = TRUE;
+  }
 }
 
 void EvalCoordinator::WaitForReadySignal() {
@@ -178,17 +361,37 @@ void EvalCoordinator::WaitForReadySignal() {
     unique_lock<mutex> lk(mutex_);
 
     // Wait for ready signal from debugger calback.
-    variable_threads_cv_.wait(lk, [&] { return ready_to_print_variables_; });
+    ThreadState *thread_state = GetCallerState();
+    thread_state->variable_thread_cv.wait(
+        lk, [&] { return thread_state->ready_to_print_variables; });
   }
 }
 
 void EvalCoordinator::SignalFinishedPrintingVariable() {
+  // The static members cached by this thread are only valid until the
+  // debuggee continues. Other threads keep theirs.
+  DbgClass::ClearStaticCache();
   {
     lock_guard<mutex> lk(mutex_);
-    DbgClass::ClearStaticCache();
-    debuggercallback_can_continue_ = TRUE;
+    ThreadState *thread_state = GetCallerState();
+
+    // So are the handles, the dereferenced values and the memory read
+    // during the hit.
+    thread_state->strong_handles.DisposeAll();
+    StrongHandlePool::SetCurrent(nullptr);
+    thread_state->dereferenced_values.Clear();
+    DereferenceCache::SetCurrent(nullptr);
+    thread_state->memory_pages.Clear();
+    DebuggeeMemoryCache::SetCurrent(nullptr);
+
+    thread_state->debuggercallback_can_continue = TRUE;
+
+    // The thread is done, so its next hit gets a new state.
+    if (thread_state != &default_state_) {
+      thread_states_.erase(thread_state->thread_id);
+    }
   }
-  debugger_callback_cv_.notify_one();
+  debugger_callback_cv_.notify_all();
 }
 
 HRESULT EvalCoordinator::GetActiveDebugThread(ICorDebugThread **debug_thread) {
@@ -196,9 +399,10 @@ HRESULT EvalCoordinator::GetActiveDebugThread(ICorDebugThread **debug_thread) {
     return E_INVALIDARG;
   }
 
-  if (active_debug_thread_) {
-    (*debug_thread) = active_debug_thread_;
-    active_debug_thread_->AddRef();
+  ThreadState *thread_state = GetCallerState();
+  if (thread_state->debug_thread) {
+    (*debug_thread) = thread_state->debug_thread;
+    thread_state->debug_thread->AddRef();
     return S_OK;
   }
 
@@ -211,9 +415,10 @@ HRESULT EvalCoordinator::GetActiveDebugFrame(
     return E_INVALIDARG;
   }
 
-  if (active_debug_thread_) {
+  ThreadState *thread_state = GetCallerState();
+  if (thread_state->debug_thread) {
     CComPtr<ICorDebugFrame> debug_frame;
-    HRESULT hr = active_debug_thread_->GetActiveFrame(&debug_frame);
+    HRESULT hr = thread_state->debug_thread->GetActiveFrame(&debug_frame);
     if (FAILED(hr)) {
       cerr << "Failed to get active frame.";
       return hr;
@@ -226,47 +431,184 @@ HRESULT EvalCoordinator::GetActiveDebugFrame(
   return E_FAIL;
 }
 
-BOOL EvalCoordinator::WaitingForEval() {
+BOOL EvalCoordinator::WaitingForEval(ICorDebugThread *debug_thread) {
+  lock_guard<mutex> lk(mutex_);
+  std::shared_ptr<ThreadState> thread_state = FindThreadState(debug_thread);
+  return thread_state && thread_state->waiting_for_eval;
+}
+
+bool EvalCoordinator::GetCachedPropertyValue(CORDB_ADDRESS object_address,
+                                             ICorDebugModule *debug_module,
+                                             mdProperty property_def,
+                                             shared_ptr<DbgObject> *value) {
+  ThreadState *thread_state = GetCallerState();
+  auto cached_value = thread_state->property_values.find(
+      PropertyValueKey(object_address, debug_module, property_def));
+  if (cached_value == thread_state->property_values.end()) {
+    return false;
+  }
+
+  *value = cached_value->second;
+  return true;
+}
+
+void EvalCoordinator::CachePropertyValue(CORDB_ADDRESS object_address,
+                                         ICorDebugModule *debug_module,
+                                         mdProperty property_def,
+                                         shared_ptr<DbgObject> value) {
+  GetCallerState()->property_values[PropertyValueKey(
+      object_address, debug_module, property_def)] = std::move(value);
+}
+
+bool EvalCoordinator::GetCachedExpressionValue(const std::string &key,
+                                               shared_ptr<DbgObject> *value) {
+  ThreadState *thread_state = GetCallerState();
+  auto cached_value = thread_state->expression_values.find(key);
+  if (cached_value == thread_state->expression_values.end()) {
+    return false;
+  }
+
+  *value = cached_value->second;
+  return true;
+}
+
+void EvalCoordinator::CacheExpressionValue(const std::string &key,
+                                           shared_ptr<DbgObject> value) {
+  GetCallerState()->expression_values[key] = std::move(value);
+}
+
+void EvalCoordinator::ResetEvaluationBudget() {
   lock_guard<mutex> lk(mutex_);
-  return waiting_for_eval_;
+  ThreadState *thread_state = GetCallerState();
+  thread_state->budget_start = high_resolution_clock::now();
+  thread_state->func_evals = 0;
+}
+
+milliseconds EvalCoordinator::GetEvaluationTimeout(ThreadState *thread_state) {
+  if (eval_budget_.count() == 0) {
+    return eval_timeout_;
+  }
+
+  milliseconds budget_used = std::chrono::duration_cast<milliseconds>(
+      high_resolution_clock::now() - thread_state->budget_start);
+  return std::min(eval_timeout_, eval_budget_ - budget_used);
+}
+
+EvalCoordinator::ThreadState *EvalCoordinator::GetCallerState() {
+  return caller_state_ ? caller_state_ : &default_state_;
+}
+
+std::shared_ptr<EvalCoordinator::ThreadState> EvalCoordinator::FindThreadState(
+    ICorDebugThread *debug_thread) {
+  DWORD thread_id = 0;
+  if (!debug_thread || FAILED(debug_thread->GetID(&thread_id))) {
+    return nullptr;
+  }
+
+  auto thread_state = thread_states_.find(thread_id);
+  if (thread_state == thread_states_.end()) {
+    return nullptr;
+  }
+  return thread_state->second;
 }
 
 HRESULT EvalCoordinator::ProcessBreakpointsTask(
     IBreakpointCollection *breakpoint_collection,
-    std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints,
-    const std::vector<
-        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-        &pdb_files) {
-  // Vector of PDB files that are parsed successfully.
-  std::vector<
+    std::shared_ptr<const ModuleSnapshot> modules,
+    std::shared_ptr<ThreadState> thread_state) {
+  DEBUGGER_TRACE_SPAN("EvalCoordinator::ProcessBreakpointsTask");
+  caller_state_ = thread_state.get();
+  StrongHandlePool::SetCurrent(&thread_state->strong_handles);
+  DereferenceCache::SetCurrent(&thread_state->dereferenced_values);
+  DebuggeeMemoryCache::SetCurrent(&thread_state->memory_pages);
+
+  // The stack frames only parse the PDB files of their own modules.
+  const std::vector<
       std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-      parsed_pdb_files;
-  for (auto &&pdb_file : pdb_files) {
-    if (!pdb_file) {
-      continue;
-    }
-
-    if (pdb_file->ParsePdbFile()) {
-      parsed_pdb_files.push_back(pdb_file);
-    }
-  }
+      &pdb_files = modules->pdb_files;
 
   // Creates and initializes stack frame collection based on the
   // ICorDebugStackWalk object.
-  unique_ptr<IStackFrameCollection> stack_frames(
+  unique_ptr<StackFrameCollection> frame_collection(
       new (std::nothrow) StackFrameCollection(
           std::shared_ptr<ICorDebugHelper>(new CorDebugHelper()),
           std::shared_ptr<IDbgObjectFactory>(new DbgObjectFactory())));
-  if (!stack_frames) {
+  if (!frame_collection) {
     cerr << "Failed to create DbgStack.";
+    SignalFinishedPrintingVariable();
+    caller_state_ = nullptr;
     return E_OUTOFMEMORY;
   }
 
+  frame_collection->SetFrameInfoCache(&frame_info_cache_);
+  frame_collection->SetModules(modules);
+
+  // The stack is walked once for all the breakpoints of this hit, so it
+  // is walked as deep as the breakpoint that captures the most frames.
+  // Log points only need the top frame, which is read without the walk.
+  OverheadGovernor::Level overhead_level =
+      OverheadGovernor::Global().GetLevel();
+  bool reduce_limits = overhead_level >= OverheadGovernor::kReducedLimits;
+  if (overhead_level == OverheadGovernor::kNoPropertyEvaluation &&
+      !property_evaluation_) {
+    // Nothing is degraded if properties are not evaluated anyway.
+    overhead_level = OverheadGovernor::kNone;
+  }
+  CaptureLimits walk_limits;
+  walk_limits.max_stack_frames = 0;
+  walk_limits.max_stack_frames_with_variables = 0;
+  for (auto &&breakpoint : thread_state->breakpoints) {
+    if (breakpoint->IsLogPoint()) {
+      continue;
+    }
+    CaptureLimits limits = breakpoint->GetCaptureLimits();
+    if (reduce_limits) {
+      limits = OverheadGovernor::ReduceLimits(limits);
+    }
+    walk_limits.max_stack_frames =
+        std::max(walk_limits.max_stack_frames, limits.max_stack_frames);
+    walk_limits.max_stack_frames_with_variables =
+        std::max(walk_limits.max_stack_frames_with_variables,
+                 limits.max_stack_frames_with_variables);
+  }
+  frame_collection->SetWalkLimits(walk_limits);
+  frame_collection->SetLogicalAsyncStacks(logical_async_stacks_);
+  if (parallel_stack_frames_) {
+    frame_collection->SetFrameResolutionPool(&frame_resolution_pool_);
+  }
+  unique_ptr<IStackFrameCollection> stack_frames(std::move(frame_collection));
+
+  // Log points only report their evaluated expressions, so without
+  // func-evals they can be written once the debuggee continues.
+  bool capture_log_points =
+      async_log_points_ && !PropertyEvaluation() && !condition_evaluation_;
+  std::vector<CapturedLogPoint> captured_log_points;
+  std::vector<PopulatedBreakpoint> populated_breakpoints;
+
+  // A hit costs a breakpoint how long the thread has been stopped when
+  // the breakpoint is done, which includes the breakpoints before it.
+  auto record_hit_cost = [&thread_state](DbgBreakpoint *breakpoint) {
+    breakpoint->RecordHitCost(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - thread_state->hit_start),
+        thread_state->func_evals);
+  };
+
   HRESULT hr = S_OK;
-  for (auto &&breakpoint : breakpoints) {
-    hr = stack_frames->ProcessBreakpoint(parsed_pdb_files, breakpoint.get(),
-                                         this);
+  for (auto &&breakpoint : thread_state->breakpoints) {
+    ResetEvaluationBudget();
+    ScopedReducedLimits reduced_limits(breakpoint.get(), reduce_limits);
+    bool log_point = breakpoint->IsLogPoint();
+    bool capture = capture_log_points && log_point;
+    if (log_point) {
+      hr = stack_frames->EvaluateConditionAndExpressions(
+          pdb_files, breakpoint.get(), this);
+    } else {
+      hr = stack_frames->ProcessBreakpoint(pdb_files, breakpoint.get(),
+                                           this);
+    }
     if (FAILED(hr)) {
+      record_hit_cost(breakpoint.get());
       std::cerr << "Failed to process breakpoint \"" << breakpoint->GetId()
                 << "\" with HRESULT: " << std::hex << hr;
       Breakpoint error_breakpoint;
@@ -281,29 +623,148 @@ HRESULT EvalCoordinator::ProcessBreakpointsTask(
     }
 
     if (!breakpoint->GetEvaluatedCondition()) {
+      record_hit_cost(breakpoint.get());
       std::cerr << "Breakpoint condition \"" << breakpoint->GetCondition()
                 << "\" for breakpoint \"" << breakpoint->GetId()
                 << "\" is not met.";
       continue;
     }
 
-    Breakpoint proto_breakpoint;
-    hr = breakpoint->PopulateBreakpoint(&proto_breakpoint, stack_frames.get(),
-                                        this);
+    // Another thread may have taken the last hit of the hit limit while
+    // this one evaluated the condition.
+    if (!breakpoint->CountHit()) {
+      record_hit_cost(breakpoint.get());
+      continue;
+    }
+
+    std::unique_ptr<Breakpoint> proto_breakpoint = breakpoint_pool_.Acquire();
+    if (!proto_breakpoint) {
+      hr = E_OUTOFMEMORY;
+      break;
+    }
+
+    // A metric point only writes the summary of its hits once in a while.
+    if (breakpoint->IsMetricPoint()) {
+      hr = breakpoint->AddMetricHit(std::chrono::steady_clock::now(),
+                                    proto_breakpoint.get());
+      record_hit_cost(breakpoint.get());
+      if (hr == S_OK) {
+        hr = breakpoint_collection->WriteBreakpoint(*proto_breakpoint);
+      }
+      breakpoint_pool_.Release(std::move(proto_breakpoint));
+      if (FAILED(hr)) {
+        cerr << "Failed to write metric point: " << std::hex << hr;
+        break;
+      }
+      hr = S_OK;
+      continue;
+    }
+
+    if (capture) {
+      CapturedLogPoint captured;
+      hr = breakpoint->CaptureExpressionValues(&captured.values,
+                                               &captured.ages);
+      if (hr == S_OK) {
+        hr = breakpoint->PopulateBreakpoint(proto_breakpoint.get());
+        if (FAILED(hr)) {
+          cerr << "Failed to populate log point: " << std::hex << hr;
+        }
+        record_hit_cost(breakpoint.get());
+        PopulateDegradedStatus(overhead_level, proto_breakpoint.get());
+        if (report_breakpoint_costs_) {
+          breakpoint->PopulateCostStatus(proto_breakpoint.get());
+        }
+        captured.breakpoint = breakpoint;
+        captured.proto_breakpoint = std::move(proto_breakpoint);
+        captured.limits = breakpoint->GetCaptureLimits();
+        captured_log_points.push_back(std::move(captured));
+        continue;
+      }
+
+      // Some of the values still need the debuggee, so the log point
+      // is populated and written while it is stopped.
+    }
+
+    if (log_point) {
+      hr = breakpoint->PopulateLogPoint(proto_breakpoint.get(), this);
+    } else {
+      hr = breakpoint->PopulateBreakpoint(proto_breakpoint.get(),
+                                          stack_frames.get(), this);
+    }
     if (FAILED(hr)) {
       // We should still write the breakpoint to report the error to the user.
       cerr << "Failed to print out variables: " << std::hex << hr;
     }
 
-    hr = breakpoint_collection->WriteBreakpoint(proto_breakpoint);
-    if (FAILED(hr)) {
-      cerr << "Failed to write breakpoint: " << std::hex << hr;
-      break;
+    record_hit_cost(breakpoint.get());
+    PopulateDegradedStatus(overhead_level, proto_breakpoint.get());
+    if (report_breakpoint_costs_) {
+      breakpoint->PopulateCostStatus(proto_breakpoint.get());
     }
+
+    PopulatedBreakpoint populated;
+    populated.breakpoint = breakpoint;
+    populated.proto_breakpoint = std::move(proto_breakpoint);
+    populated_breakpoints.push_back(std::move(populated));
+    hr = S_OK;
   }
 
   stack_frames.reset();
+  thread_state->property_values.clear();
+  thread_state->expression_values.clear();
   SignalFinishedPrintingVariable();
+  caller_state_ = nullptr;
+
+  // The debuggee may be running from here on. The populated breakpoints
+  // are measured and swapped into the queue of the writer, whose thread
+  // encodes and serializes them, without copying them.
+  for (PopulatedBreakpoint &populated : populated_breakpoints) {
+    Breakpoint *proto_breakpoint = populated.proto_breakpoint.get();
+    if (report_breakpoint_costs_) {
+      populated.breakpoint->RecordPayloadBytes(
+          proto_breakpoint->ByteSizeLong());
+    }
+
+    HRESULT write_hr =
+        breakpoint_collection->WriteAndClearBreakpoint(proto_breakpoint);
+    breakpoint_pool_.Release(std::move(populated.proto_breakpoint));
+    if (FAILED(write_hr)) {
+      cerr << "Failed to write breakpoint: " << std::hex << write_hr;
+      hr = SUCCEEDED(hr) ? write_hr : hr;
+      break;
+    }
+  }
+  populated_breakpoints.clear();
+
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  for (auto &&captured : captured_log_points) {
+    Breakpoint *proto_breakpoint = captured.proto_breakpoint.get();
+    hr = DbgBreakpoint::PopulateCapturedExpressions(
+        proto_breakpoint, captured.values, captured.limits, this,
+        &captured.ages);
+    if (FAILED(hr)) {
+      cerr << "Failed to print out log point expressions: " << std::hex << hr;
+    }
+    if (report_breakpoint_costs_) {
+      captured.breakpoint->RecordPayloadBytes(
+          proto_breakpoint->ByteSizeLong());
+    }
+
+    hr = breakpoint_collection->WriteAndClearBreakpoint(proto_breakpoint);
+    breakpoint_pool_.Release(std::move(captured.proto_breakpoint));
+    if (FAILED(hr)) {
+      cerr << "Failed to write log point: " << std::hex << hr;
+      break;
+    }
+  }
+
+  // The DbgObjects of the snapshots are gone once they are written, so the
+  // memory they were allocated from can be freed all at once.
+  captured_log_points.clear();
+  DbgObjectPool::GetDefault()->ReleaseIfUnused();
   return hr;
 }
 
@@ -16,9 +16,19 @@
 #define EVAL_COORDINATOR_H_
 
 #include <chrono>
-#include <future>
-
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+#include "breakpoint_pool.h"
+#include "constants.h"
+#include "debuggee_memory_cache.h"
+#include "dereference_cache.h"
+#include "frame_info_cache.h"
 #include "i_eval_coordinator.h"
+#include "overhead_governor.h"
+#include "strong_handle_pool.h"
+#include "thread_pool.h"
 
 namespace google_cloud_debugger {
 
@@ -65,8 +75,8 @@ class EvalCoordinator : public IEvalCoordinator {
   void SignalFinishedEval(ICorDebugThread *debug_thread) override;
 
   // DebuggerCallback calls this function to signal that an exception has
-  // occurred.
-  void HandleException() override;
+  // occurred on debug_thread.
+  void HandleException(ICorDebugThread *debug_thread) override;
 
   // Processes a vector of breakpoints set at the SAME location (they
   // can have different conditions and expressions).
@@ -76,9 +86,7 @@ class EvalCoordinator : public IEvalCoordinator {
       ICorDebugThread *debug_thread,
       IBreakpointCollection *breakpoint_collection,
       std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints,
-      const std::vector<
-          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-          &pdb_files) override;
+      std::shared_ptr<const ModuleSnapshot> modules) override;
 
   // StackFrame calls this to signal that it already processed all the
   // variables and it is just waiting to perform evaluation (if necessary) and
@@ -95,8 +103,9 @@ class EvalCoordinator : public IEvalCoordinator {
   // Returns the active debug thread.
   HRESULT GetActiveDebugFrame(ICorDebugILFrame **debug_frame) override;
 
-  // Returns true if we are waiting for an evaluation result.
-  BOOL WaitingForEval() override;
+  // Returns true if we are waiting for an evaluation result on
+  // debug_thread.
+  BOOL WaitingForEval(ICorDebugThread *debug_thread) override;
 
   // Sets whether property evaluation should be performed.
   void SetPropertyEvaluation(BOOL eval) override {
@@ -108,23 +117,166 @@ class EvalCoordinator : public IEvalCoordinator {
     condition_evaluation_ = eval;
   }
 
-  // Returns whether property evaluation should be performed.
-  BOOL PropertyEvaluation() override { return property_evaluation_; }
+  // Sets whether log points whose expressions can be read while the
+  // debuggee is stopped are written after the debuggee continues.
+  // Only applies when neither property nor method evaluation is on.
+  void SetAsyncLogPoints(bool async_log_points) {
+    async_log_points_ = async_log_points;
+  }
+
+  // Sets whether the messages written for breakpoint hits report the
+  // cost of their breakpoint in their status, unless they have an error
+  // status. The sizes of the messages are only added to the costs then.
+  void SetReportBreakpointCosts(bool report_breakpoint_costs) {
+    report_breakpoint_costs_ = report_breakpoint_costs;
+  }
+
+  // Sets whether the names of the stack frames without variables are
+  // resolved in parallel after the stack is walked.
+  void SetParallelStackFrames(bool parallel_stack_frames) {
+    parallel_stack_frames_ = parallel_stack_frames;
+  }
+
+  // Sets whether the callers of async methods resumed after an await are
+  // the async methods awaiting them instead of the thread pool.
+  void SetLogicalAsyncStacks(bool logical_async_stacks) {
+    logical_async_stacks_ = logical_async_stacks;
+  }
+
+  // Returns whether property evaluation should be performed. It is not
+  // while OverheadGovernor degrades the hits.
+  BOOL PropertyEvaluation() override {
+    return property_evaluation_ && OverheadGovernor::Global().GetLevel() ==
+                                       OverheadGovernor::kNone;
+  }
 
   // Returns whether method call should be performed when evaluating condition.
   BOOL MethodEvaluation() override { return condition_evaluation_; }
 
+  bool GetCachedPropertyValue(CORDB_ADDRESS object_address,
+                              ICorDebugModule *debug_module,
+                              mdProperty property_def,
+                              std::shared_ptr<DbgObject> *value) override;
+
+  void CachePropertyValue(CORDB_ADDRESS object_address,
+                          ICorDebugModule *debug_module,
+                          mdProperty property_def,
+                          std::shared_ptr<DbgObject> value) override;
+
+  bool GetCachedExpressionValue(const std::string &key,
+                                std::shared_ptr<DbgObject> *value) override;
+
+  void CacheExpressionValue(const std::string &key,
+                            std::shared_ptr<DbgObject> value) override;
+
+  void RemoveModuleFrames(const std::string &module_name) override {
+    frame_info_cache_.RemoveModule(module_name);
+  }
+
+  // Sets the maximum amount of time a single function evaluation can take
+  // before it is aborted.
+  void SetEvaluationTimeout(std::chrono::milliseconds timeout) {
+    eval_timeout_ = timeout;
+  }
+
+  // Sets the total amount of time the function evaluations of a
+  // breakpoint can take and how many of them it can make. Zero means
+  // no limit. Evaluations past the budget fail with E_ABORT.
+  void SetEvaluationBudget(std::chrono::milliseconds time,
+                           std::uint32_t func_evals) {
+    eval_budget_ = time;
+    max_func_evals_ = func_evals;
+  }
+
+  // Returns the number of threads started to process breakpoints.
+  std::size_t GetEvaluationThreadsCreated() {
+    return evaluation_pool_.GetThreadsCreated();
+  }
+
  private:
-  // Helper function to process a vector of multiple breakpoints at the same location
-  // using the stack frame collection. The stack frame collection
-  // will first be used to evaluate the breakpoint condition. If this succeeds,
-  // the function will proceed to get stack frame information at the breakpoint.
+  // The object address, module and token of an evaluated property.
+  typedef std::tuple<CORDB_ADDRESS, ICorDebugModule *, mdProperty>
+      PropertyValueKey;
+
+  // Coordination between the DebuggerCallback and the task processing
+  // the breakpoints hit by one debuggee thread. Every debuggee thread
+  // that stopped at a breakpoint has its own, so a thread that hits a
+  // breakpoint while another one waits for a function evaluation does
+  // not have to wait for that thread's snapshot.
+  struct ThreadState {
+    // The ID of debug_thread.
+    DWORD thread_id = 0;
+
+    // The ICorDebugThread that the StackFrame is on.
+    CComPtr<ICorDebugThread> debug_thread;
+
+    // The breakpoints that are being processed for this thread.
+    std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints;
+
+    // The task waits on this for the DebuggerCallback.
+    std::condition_variable variable_thread_cv;
+
+    BOOL ready_to_print_variables = FALSE;
+    BOOL debuggercallback_can_continue = FALSE;
+    BOOL eval_exception_occurred = FALSE;
+    BOOL waiting_for_eval = FALSE;
+
+    // When the debuggee thread stopped at the breakpoints.
+    std::chrono::steady_clock::time_point hit_start;
+
+    // When the evaluation budget of the current breakpoint started and
+    // how many function evaluations it made since.
+    std::chrono::high_resolution_clock::time_point budget_start;
+    std::uint32_t func_evals = 0;
+
+    // Results of the property getters evaluated during the hit, so that
+    // a property is evaluated once per object even if the condition,
+    // the expressions and the variables of the breakpoints all read it.
+    // Only used by the task processing the breakpoints.
+    std::map<PropertyValueKey, std::shared_ptr<DbgObject>> property_values;
+
+    // Results of the member accesses evaluated during the hit, keyed by
+    // their printed expression, so that the breakpoints at the location
+    // share a subexpression like "request.User.Id" instead of each
+    // evaluating it. Only used by the task processing the breakpoints.
+    std::map<std::string, std::shared_ptr<DbgObject>> expression_values;
+
+    // The strong handles created during the hit, which the DbgObjects
+    // holding the same object share. Disposed once the hit is done.
+    StrongHandlePool strong_handles;
+
+    // The values the references read during the hit dereference to.
+    DereferenceCache dereferenced_values;
+
+    // The pages of debuggee memory read during the hit.
+    DebuggeeMemoryCache memory_pages;
+  };
+
+  // Returns the state of the debuggee thread that the calling task is
+  // processing. Outside of a task, this is default_state_.
+  ThreadState *GetCallerState();
+
+  // Starts a new evaluation budget for the breakpoint the calling task
+  // is about to process.
+  void ResetEvaluationBudget();
+
+  // Returns how long the next function evaluation of thread_state can
+  // take. Has to be called with mutex_ held.
+  std::chrono::milliseconds GetEvaluationTimeout(ThreadState *thread_state);
+
+  // Returns the state of debug_thread, or nullptr if none of its
+  // breakpoints is being processed. Has to be called with mutex_ held.
+  std::shared_ptr<ThreadState> FindThreadState(ICorDebugThread *debug_thread);
+
+  // Helper function to process the breakpoints of thread_state, which
+  // are at the same location, using the stack frame collection. The
+  // stack frame collection will first be used to evaluate the breakpoint
+  // condition. If this succeeds, the function will proceed to get stack
+  // frame information at the breakpoint.
   HRESULT ProcessBreakpointsTask(
       IBreakpointCollection *breakpoint_collection,
-      std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints,
-      const std::vector<
-          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-          &pdb_files);
+      std::shared_ptr<const ModuleSnapshot> modules,
+      std::shared_ptr<ThreadState> thread_state);
 
   // If sets to true, object evaluation will be performed when evaluating property.
   BOOL property_evaluation_ = FALSE;
@@ -133,26 +285,75 @@ class EvalCoordinator : public IEvalCoordinator {
   // when evaluating condition.
   BOOL condition_evaluation_ = FALSE;
 
-  // The tasks that help us enumerate and print out variables.
-  std::vector<std::future<HRESULT>> print_breakpoint_tasks_;
+  // If true, log points are formatted and written after the debuggee
+  // is released instead of while it is stopped.
+  bool async_log_points_ = false;
+
+  // If true, the messages of breakpoint hits report the cost of their
+  // breakpoint.
+  bool report_breakpoint_costs_ = false;
+
+  // If true, the names of the stack frames without variables are
+  // resolved on frame_resolution_pool_.
+  bool parallel_stack_frames_ = false;
 
-  // The ICorDebugThread that the active StackFrame is on.
-  CComPtr<ICorDebugThread> active_debug_thread_;
+  // If true, the stack frame collections follow the continuations of
+  // resumed async methods to the async methods awaiting them.
+  bool logical_async_stacks_ = false;
 
-  // variable_thread_ and the thread that DebuggerCallback object is on
-  // will use this condition_variable_ and mutex_ to communicate.
-  std::condition_variable variable_threads_cv_;
+  // The maximum amount of time a single function evaluation can take.
+  std::chrono::milliseconds eval_timeout_{kDefaultEvalTimeoutMs};
 
+  // The maximum total time of the function evaluations of a breakpoint.
+  // Zero means no limit.
+  std::chrono::milliseconds eval_budget_{0};
+
+  // The maximum number of function evaluations of a breakpoint. Zero
+  // means no limit.
+  std::uint32_t max_func_evals_ = 0;
+
+  // Messages that the snapshots of breakpoints are built in. Reusing them
+  // avoids allocating every StackFrame and Variable of each snapshot.
+  BreakpointPool breakpoint_pool_{kMaximumPooledSnapshotBreakpoints};
+
+  // Names and source locations of the stack frames captured so far, so
+  // that the frames of later breakpoint hits skip most metadata lookups.
+  FrameInfoCache frame_info_cache_{kMaximumCachedFrameInfos};
+
+  // States of the debuggee threads whose breakpoints are being
+  // processed, keyed by the ID of the ICorDebugThread.
+  std::unordered_map<DWORD, std::shared_ptr<ThreadState>> thread_states_;
+
+  // State used when the methods a task calls are called elsewhere.
+  ThreadState default_state_;
+
+  // The state of the debuggee thread the current task is processing.
+  static thread_local ThreadState *caller_state_;
+
+  // The tasks and the thread that DebuggerCallback object is on use
+  // the condition variables and mutex_ to communicate.
   std::condition_variable debugger_callback_cv_;
 
   std::mutex mutex_;
 
-  BOOL ready_to_print_variables_ = FALSE;
-  BOOL debuggercallback_can_continue_ = FALSE;
-  BOOL eval_exception_occurred_ = FALSE;
-  BOOL waiting_for_eval_ = FALSE;
-
-  static std::chrono::minutes one_minute;
+  // Number of evaluation threads last reported.
+  std::size_t reported_evaluation_threads_ = 0;
+
+  // The threads that resolve the names of stack frames without variables.
+  // Declared before evaluation_pool_ since its tasks use it.
+  ThreadPool frame_resolution_pool_{kMaxFrameResolutionThreads,
+                                    "frame_resolution"};
+
+  // The threads that enumerate and print out variables. They are kept
+  // across breakpoint hits instead of starting a thread for every hit.
+  // A task waits for evaluations done on the debugger callback thread,
+  // so a hit that finds every thread busy starts another one, which
+  // exits once it has been idle for kEvaluationThreadIdleTimeoutMs.
+  // Declared last so that the running tasks are joined before the
+  // members they use are destroyed.
+  ThreadPool evaluation_pool_{
+      1, "evaluation",
+      std::chrono::milliseconds(kEvaluationThreadIdleTimeoutMs)};
 };
 
 }  //  namespace google_cloud_debugger
@@ -0,0 +1,129 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "exception_point_filter.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "constants.h"
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+void ExceptionPointFilter::Add(const string &exception_type,
+                               const string &exception_module,
+                               std::shared_ptr<DbgBreakpoint> exception_point) {
+  types_[exception_type].push_back(exception_points_.size());
+  exception_points_.push_back({exception_module, std::move(exception_point)});
+}
+
+HRESULT ExceptionPointFilter::Match(
+    CORDB_ADDRESS module_base_address, mdTypeDef class_token,
+    const NameFunction &get_class_name, const NameFunction &get_throw_module,
+    vector<std::shared_ptr<DbgBreakpoint>> *exception_points) {
+  if (!exception_points) {
+    return E_INVALIDARG;
+  }
+  exception_points->clear();
+
+  vector<std::size_t> indices;
+  std::pair<CORDB_ADDRESS, mdTypeDef> key(module_base_address, class_token);
+  bool cached = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto &found = classes_.find(key);
+    if (found != classes_.end()) {
+      indices = found->second;
+      cached = true;
+    }
+  }
+
+  if (!cached) {
+    string class_name;
+    HRESULT hr = get_class_name(&class_name);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    std::transform(
+        class_name.begin(), class_name.end(), class_name.begin(),
+        [](unsigned char c) -> unsigned char { return std::tolower(c); });
+
+    const auto &type = types_.find(class_name);
+    if (type != types_.end()) {
+      indices = type->second;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (classes_.size() >= kMaximumCachedExceptionClasses) {
+      classes_.clear();
+    }
+    classes_[key] = indices;
+  }
+
+  if (indices.empty()) {
+    return S_OK;
+  }
+
+  bool has_throw_module = false;
+  string throw_module;
+  for (std::size_t index : indices) {
+    const ExceptionPoint &exception_point = exception_points_[index];
+    if (!exception_point.module.empty()) {
+      if (!has_throw_module) {
+        HRESULT hr = get_throw_module(&throw_module);
+        if (FAILED(hr)) {
+          return hr;
+        }
+        std::transform(
+            throw_module.begin(), throw_module.end(), throw_module.begin(),
+            [](unsigned char c) -> unsigned char { return std::tolower(c); });
+        has_throw_module = true;
+      }
+
+      if (!ModuleMatches(throw_module, exception_point.module)) {
+        continue;
+      }
+    }
+    exception_points->push_back(exception_point.breakpoint);
+  }
+  return S_OK;
+}
+
+void ExceptionPointFilter::RemoveModule(CORDB_ADDRESS module_base_address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = classes_.lower_bound(
+      std::pair<CORDB_ADDRESS, mdTypeDef>(module_base_address, 0));
+  while (it != classes_.end() && it->first.first == module_base_address) {
+    it = classes_.erase(it);
+  }
+}
+
+bool ExceptionPointFilter::ModuleMatches(const string &module_name,
+                                         const string &module) {
+  size_t name_start = module_name.find_last_of("/\\");
+  name_start = name_start == string::npos ? 0 : name_start + 1;
+  string file_name = module_name.substr(name_start);
+  if (file_name == module) {
+    return true;
+  }
+
+  size_t extension_start = file_name.rfind('.');
+  return extension_start != string::npos &&
+         file_name.substr(0, extension_start) == module;
+}
+
+}  //  namespace google_cloud_debugger
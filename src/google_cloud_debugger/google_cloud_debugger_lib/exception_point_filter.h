@@ -0,0 +1,99 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EXCEPTION_POINT_FILTER_H_
+#define EXCEPTION_POINT_FILTER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cor.h"
+
+namespace google_cloud_debugger {
+
+class DbgBreakpoint;
+
+// Finds the exception points hit by a first-chance exception. A filter is
+// built whenever exception points are activated or deactivated and is not
+// changed afterwards, except for its cache: most exceptions of a process
+// are of a few classes that no exception point wants, so the exception
+// points of a class are cached by module and class token and the name of
+// the class is only read from the metadata the first time it is thrown.
+// Can be used from multiple threads.
+class ExceptionPointFilter {
+ public:
+  // Returns the name of a class or of a module in name.
+  typedef std::function<HRESULT(std::string *name)> NameFunction;
+
+  // Adds exception_point, which is hit by exceptions of exception_type
+  // thrown by code of exception_module, or of any module if it is empty.
+  // Both are lowercase (see DbgBreakpoint::GetExceptionType).
+  void Add(const std::string &exception_type,
+           const std::string &exception_module,
+           std::shared_ptr<DbgBreakpoint> exception_point);
+
+  // Returns true if no exception point was added.
+  bool Empty() const { return exception_points_.empty(); }
+
+  // Stores in exception_points the exception points hit by an exception
+  // of the class class_token of the module at module_base_address.
+  // get_class_name is only called the first time the class is seen and
+  // get_throw_module, which gets the name of the module of the code that
+  // threw the exception, only if an exception point of the class is
+  // restricted to a module. Returns the first error of either of them.
+  HRESULT Match(
+      CORDB_ADDRESS module_base_address, mdTypeDef class_token,
+      const NameFunction &get_class_name, const NameFunction &get_throw_module,
+      std::vector<std::shared_ptr<DbgBreakpoint>> *exception_points);
+
+  // Drops the cached classes of the module at module_base_address, for
+  // example because the module was unloaded.
+  void RemoveModule(CORDB_ADDRESS module_base_address);
+
+  // Returns true if module_name, a path to a module file, names module,
+  // with or without its extension. Both are lowercase.
+  static bool ModuleMatches(const std::string &module_name,
+                            const std::string &module);
+
+ private:
+  // An exception point and the module it is restricted to.
+  struct ExceptionPoint {
+    std::string module;
+    std::shared_ptr<DbgBreakpoint> breakpoint;
+  };
+
+  std::vector<ExceptionPoint> exception_points_;
+
+  // Indices in exception_points_ of the exception points of every
+  // exception type.
+  std::unordered_map<std::string, std::vector<std::size_t>> types_;
+
+  // The exception points of the classes seen so far, keyed by the base
+  // address of their module and their token. Most are empty.
+  std::map<std::pair<CORDB_ADDRESS, mdTypeDef>, std::vector<std::size_t>>
+      classes_;
+
+  // Protects classes_.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  EXCEPTION_POINT_FILTER_H_
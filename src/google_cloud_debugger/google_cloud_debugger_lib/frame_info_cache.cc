@@ -0,0 +1,76 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "frame_info_cache.h"
+
+namespace google_cloud_debugger {
+
+const ULONG32 FrameInfoCache::kNoILOffset;
+
+bool FrameInfoCache::Find(const std::string &module_name,
+                          mdMethodDef method_token, ULONG32 il_offset,
+                          FrameInfo *info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto position = index_.find(Key(module_name, method_token, il_offset));
+  if (position == index_.end()) {
+    return false;
+  }
+
+  // Moves the entry to the front as it is now the most recently used.
+  entries_.splice(entries_.begin(), entries_, position->second);
+  *info = position->second->second;
+  return true;
+}
+
+void FrameInfoCache::Add(const std::string &module_name,
+                         mdMethodDef method_token, ULONG32 il_offset,
+                         const FrameInfo &info) {
+  if (capacity_ == 0) {
+    return;
+  }
+
+  Key key(module_name, method_token, il_offset);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto position = index_.find(key);
+  if (position != index_.end()) {
+    position->second->second = info;
+    entries_.splice(entries_.begin(), entries_, position->second);
+    return;
+  }
+
+  if (entries_.size() >= capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+
+  entries_.emplace_front(key, info);
+  index_[key] = entries_.begin();
+}
+
+void FrameInfoCache::RemoveModule(const std::string &module_name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto position = index_.lower_bound(Key(module_name, 0, 0));
+  while (position != index_.end() &&
+         std::get<0>(position->first) == module_name) {
+    entries_.erase(position->second);
+    position = index_.erase(position);
+  }
+}
+
+std::size_t FrameInfoCache::GetSize() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+}  //  namespace google_cloud_debugger
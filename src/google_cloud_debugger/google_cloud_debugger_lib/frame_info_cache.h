@@ -0,0 +1,117 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FRAME_INFO_CACHE_H_
+#define FRAME_INFO_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "cor.h"
+
+namespace google_cloud_debugger {
+
+// What is known about a stack frame at a given IL offset of a method.
+// Entries added with kNoILOffset only have the names of the method.
+// The others only have its source location.
+struct FrameInfo {
+  // Names of the method and of its class.
+  std::string method_name;
+  std::string class_name;
+  mdTypeDef class_token = 0;
+  ULONG32 func_virtual_addr = 0;
+
+  // True if the method is part of the machinery that starts and runs
+  // async methods, for example AsyncTaskMethodBuilder.Start, whose
+  // frames are hidden above the frame of an async method.
+  bool async_infrastructure = false;
+
+  // For the MoveNext method of a state machine, the class the state
+  // machine is nested in, which is the class of the async method.
+  // Otherwise 0.
+  mdTypeDef enclosing_class_token = 0;
+
+  // Source file and line of the IL offset.
+  std::string file;
+  std::uint32_t line = 0;
+
+  // Position of the method in the document index table of the PDB
+  // of the module.
+  std::size_t document_index = 0;
+  std::size_t method_index = 0;
+
+  // Index of the sequence point of the IL offset in the sequence points
+  // of the method, if has_sequence_point is true.
+  std::size_t sequence_point_index = 0;
+  bool has_sequence_point = false;
+};
+
+// A least recently used cache of the names and source locations of
+// stack frames, keyed by module name, method token and IL offset. The
+// same call stacks are captured over and over, so the cache is shared
+// by the breakpoint hits and saves the metadata and sequence point
+// lookups of the frames it has seen. Can be used from multiple threads.
+class FrameInfoCache {
+ public:
+  // IL offset of the entries that only hold the names of a method.
+  static const ULONG32 kNoILOffset = 0xFFFFFFFF;
+
+  // Creates a cache that holds at most capacity entries.
+  explicit FrameInfoCache(std::size_t capacity) : capacity_(capacity) {}
+  FrameInfoCache(const FrameInfoCache &) = delete;
+  FrameInfoCache &operator=(const FrameInfoCache &) = delete;
+
+  // Looks up the entry of method_token at il_offset in module_name and
+  // copies it to info. Returns false if there is none.
+  bool Find(const std::string &module_name, mdMethodDef method_token,
+            ULONG32 il_offset, FrameInfo *info);
+
+  // Adds or replaces the entry of method_token at il_offset in
+  // module_name. Evicts the least recently used entry if the cache is
+  // full.
+  void Add(const std::string &module_name, mdMethodDef method_token,
+           ULONG32 il_offset, const FrameInfo &info);
+
+  // Removes the entries of module_name, for example because the module
+  // was unloaded.
+  void RemoveModule(const std::string &module_name);
+
+  // Returns the number of entries in the cache.
+  std::size_t GetSize();
+
+ private:
+  typedef std::tuple<std::string, mdMethodDef, ULONG32> Key;
+  typedef std::list<std::pair<Key, FrameInfo>> EntryList;
+
+  // Maximum number of entries.
+  std::size_t capacity_;
+
+  // Entries from the most to the least recently used.
+  EntryList entries_;
+
+  // Positions of the entries in entries_.
+  std::map<Key, EntryList::iterator> index_;
+
+  // Protects entries_ and index_.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  FRAME_INFO_CACHE_H_
@@ -0,0 +1,116 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "front_coded_string_table.h"
+
+#include <algorithm>
+
+#include "memory_usage.h"
+
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_portable_pdb {
+
+const std::uint32_t FrontCodedStringTable::kBlockSize;
+
+// Appends value to data as a varint.
+static void AppendVarint(std::uint32_t value, string *data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<char>(value));
+}
+
+// Reads a varint from data at *offset and advances *offset past it.
+static std::uint32_t ReadVarint(const string &data, std::size_t *offset) {
+  std::uint32_t value = 0;
+  for (int shift = 0; *offset < data.size(); shift += 7) {
+    std::uint8_t byte = static_cast<std::uint8_t>(data[(*offset)++]);
+    value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  return value;
+}
+
+void FrontCodedStringTable::Initialize(const vector<string> &strings,
+                                       vector<std::uint32_t> *positions) {
+  vector<std::uint32_t> order(strings.size());
+  for (std::uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [&strings](std::uint32_t first, std::uint32_t second) {
+              return strings[first] < strings[second];
+            });
+
+  data_.clear();
+  block_offsets_.clear();
+  size_ = 0;
+  positions->assign(strings.size(), 0);
+  const string *previous = nullptr;
+  for (std::uint32_t index : order) {
+    const string &value = strings[index];
+    if (previous && *previous == value) {
+      (*positions)[index] = size_ - 1;
+      continue;
+    }
+
+    std::size_t shared = 0;
+    if (size_ % kBlockSize == 0) {
+      block_offsets_.push_back(static_cast<std::uint32_t>(data_.size()));
+    } else {
+      std::size_t limit = std::min(previous->size(), value.size());
+      while (shared < limit && (*previous)[shared] == value[shared]) {
+        ++shared;
+      }
+    }
+
+    AppendVarint(static_cast<std::uint32_t>(shared), &data_);
+    AppendVarint(static_cast<std::uint32_t>(value.size() - shared), &data_);
+    data_.append(value, shared, string::npos);
+    (*positions)[index] = size_++;
+    previous = &value;
+  }
+
+  data_.shrink_to_fit();
+  block_offsets_.shrink_to_fit();
+}
+
+string FrontCodedStringTable::Get(std::uint32_t position) const {
+  string value;
+  if (position >= size_) {
+    return value;
+  }
+
+  std::size_t offset = block_offsets_[position / kBlockSize];
+  for (std::uint32_t i = 0; i <= position % kBlockSize; ++i) {
+    std::uint32_t shared = ReadVarint(data_, &offset);
+    std::uint32_t length = ReadVarint(data_, &offset);
+    value.resize(shared);
+    value.append(data_, offset, length);
+    offset += length;
+  }
+  return value;
+}
+
+std::size_t FrontCodedStringTable::GetMemoryUsage() const {
+  return google_cloud_debugger::GetMemoryUsage(data_) +
+         google_cloud_debugger::GetMemoryUsage(block_offsets_);
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
@@ -0,0 +1,71 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FRONT_CODED_STRING_TABLE_H_
+#define FRONT_CODED_STRING_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace google_cloud_debugger_portable_pdb {
+
+// A sorted table of strings stored with front coding.
+//
+// The strings are sorted and split into blocks of kBlockSize. The first
+// string of a block is stored in full, and every other one as the length
+// of the prefix it shares with the string before it followed by the rest
+// of it. Document paths such as "/src/app/Controllers/HomeController.cs"
+// share long prefixes with their neighbours once sorted, so they take a
+// fraction of the memory of separate strings. A string is decoded from
+// the start of its block when it is accessed.
+//
+// The table does not change once it is built, so it can be read from
+// several threads at once.
+class FrontCodedStringTable {
+ public:
+  // The number of strings in a block.
+  static const std::uint32_t kBlockSize = 16;
+
+  // Builds the table from strings, replacing its content. Sets positions
+  // to the position of each of strings in the table. Equal strings are
+  // stored once and share a position.
+  void Initialize(const std::vector<std::string> &strings,
+                  std::vector<std::uint32_t> *positions);
+
+  // Returns the string at position, or an empty string if there is none.
+  std::string Get(std::uint32_t position) const;
+
+  // Returns the number of strings in the table.
+  std::uint32_t size() const { return size_; }
+
+  // Returns the bytes used by the table.
+  std::size_t GetMemoryUsage() const;
+
+ private:
+  // The encoded strings: the length of the shared prefix and the length
+  // of the rest as varints, followed by the rest.
+  std::string data_;
+
+  // The offset in data_ of the first string of each block.
+  std::vector<std::uint32_t> block_offsets_;
+
+  // The number of strings in the table.
+  std::uint32_t size_ = 0;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // FRONT_CODED_STRING_TABLE_H_
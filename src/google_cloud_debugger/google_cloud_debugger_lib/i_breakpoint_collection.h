@@ -32,6 +32,7 @@ namespace google_cloud_debugger {
 class DbgBreakpoint;
 class DebuggerCallback;
 class IEvalCoordinator;
+struct ModuleSnapshot;
 
 // Interface for managing a collection of breakpoints.
 class IBreakpointCollection {
@@ -53,6 +54,23 @@ class IBreakpointCollection {
   // This means duplicate breakpoints will be silently rejected.
   virtual HRESULT UpdateBreakpoint(const DbgBreakpoint &breakpoint) = 0;
 
+  // Updates a batch of breakpoints like UpdateBreakpoint, resolving the
+  // breakpoints at new locations together.
+  virtual HRESULT UpdateBreakpoints(
+      const std::vector<std::shared_ptr<DbgBreakpoint>> &breakpoints) = 0;
+
+  // Sets the breakpoints that could not be set so far in the documents
+  // of pdb_file, which belongs to a module that was just loaded.
+  virtual HRESULT UpdatePendingBreakpoints(
+      const std::shared_ptr<
+          google_cloud_debugger_portable_pdb::IPortablePdbFile> &pdb_file) = 0;
+
+  // Removes the breakpoints set in the module loaded at
+  // module_base_address, which is being unloaded. The active ones become
+  // pending again, so they are set if the module is loaded again.
+  virtual HRESULT RemoveModuleBreakpoints(
+      CORDB_ADDRESS module_base_address) = 0;
+
   // Using the breakpoint_client_read_ name pipe, try to read and parse
   // any incoming breakpoints that are written to the named pipe.
   // This method will then try to activate or deactivate these breakpoints.
@@ -64,23 +82,42 @@ class IBreakpointCollection {
   // Cancel SyncBreakpoints operation (should be called from another thread).
   virtual HRESULT CancelSyncBreakpoints() = 0;
 
+  // Called once the debugger is attached to the application and has
+  // processed the modules it had loaded. The agent is told the debugger
+  // is ready once SyncBreakpoints is also connected to it.
+  virtual void SetAttached() = 0;
+
   // Writes a breakpoint to the named pipe server.
   virtual HRESULT WriteBreakpoint(
       const google::cloud::diagnostics::debug::Breakpoint &breakpoint) = 0;
 
+  // Writes a breakpoint like WriteBreakpoint, but takes its contents
+  // instead of copying them. breakpoint is left empty.
+  virtual HRESULT WriteAndClearBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) = 0;
+
   // Reads a breakpoint from the named pipe server.
   virtual HRESULT ReadBreakpoint(
       google::cloud::diagnostics::debug::Breakpoint *breakpoint) = 0;
 
   // Evaluates and prints out the breakpoint that corresponds to
   // the IL offset il_offset inside the function with token
-  // function_token.
+  // function_token of the module loaded at module_base_address.
   virtual HRESULT EvaluateAndPrintBreakpoint(
-      mdMethodDef function_token, ULONG32 il_offset,
+      CORDB_ADDRESS module_base_address, mdMethodDef function_token,
+      ULONG32 il_offset, IEvalCoordinator *eval_coordinator,
+      ICorDebugThread *debug_thread,
+      std::shared_ptr<const ModuleSnapshot> modules) = 0;
+
+  // Returns true if exception points are active. Exceptions are only
+  // looked at if they are.
+  virtual bool HasExceptionPoints() = 0;
+
+  // Evaluates and prints out the exception points hit by the exception
+  // being thrown on debug_thread.
+  virtual HRESULT EvaluateExceptionPoints(
       IEvalCoordinator *eval_coordinator, ICorDebugThread *debug_thread,
-      const std::vector<
-          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-          &pdb_files) = 0;
+      std::shared_ptr<const ModuleSnapshot> modules) = 0;
 };
 
 }  // namespace google_cloud_debugger
@@ -91,7 +91,9 @@ class ICorDebugHelper {
 
   // Given an ICorDebugValue, creates a strong handle to the underlying
   // object. ICorDebugValue must represents an object type that can
-  // be stored on the heap.
+  // be stored on the heap. While the calling thread has a current
+  // StrongHandlePool, the handle of an object is created once and
+  // shared until the pool disposes it.
   virtual HRESULT CreateStrongHandle(ICorDebugValue *debug_value,
                                      ICorDebugHandleValue **handle,
                                      std::ostream *err_stream) = 0;
@@ -101,6 +103,14 @@ class ICorDebugHelper {
       ICorDebugStringValue *debug_string, std::string *returned_string,
       std::ostream *err_stream) = 0;
 
+  // Extracts out at most the first max_length characters of a string
+  // from ICorDebugStringValue. Zero max_length means no limit. length
+  // is set to the length of the whole string.
+  virtual HRESULT ExtractStringPrefixFromICorDebugStringValue(
+      ICorDebugStringValue *debug_string, ULONG32 max_length,
+      std::string *returned_string, ULONG32 *length,
+      std::ostream *err_stream) = 0;
+
   // Given a metadata token for the parameter param_token,
   // extracts out the parameter name.
   // metadata_import is the MetaDataImport of the module
@@ -231,13 +241,14 @@ class ICorDebugHelper {
       IMetaDataImport *metadata_import, std::string *type_name,
       mdTypeDef *type_def, IMetaDataImport **resolved_metadata_import) = 0;
 
-  // Given a signature blob for a constant, parses the blob
-  // and returns the constant type and value.
+  // Given the signature_size bytes of the signature blob for a constant,
+  // parses the blob and returns the constant type and value.
+  // constant_value points into signature_blob.
   // If the constant is a string, value_len returns the length of the string.
   // If the constant is an enum, remaining_bytes will contain the enum
   // class metadata token.
   virtual HRESULT ProcessConstantSigBlob(
-      const std::vector<uint8_t> &signature_blob,
+      const uint8_t *signature_blob, uint32_t signature_size,
       CorElementType *cor_type,
       UVCP_CONSTANT *constant_value,
       ULONG *value_len,
@@ -29,6 +29,17 @@ class IEvalCoordinator;
 class DbgObject;
 class IDbgObjectFactory;
 
+// How a member is displayed, from the DebuggerBrowsableState of its
+// DebuggerBrowsable attribute.
+enum class BrowsableState {
+  // The member is displayed, which is the default.
+  kCollapsed,
+  // The member is not displayed.
+  kNever,
+  // The members of the member are displayed in its place.
+  kRootHidden
+};
+
 // This class represents a member (property or field) in a .NET class.
 class IDbgClassMember : public StringStreamWrapper {
  public:
@@ -67,6 +78,14 @@ class IDbgClassMember : public StringStreamWrapper {
   // Returns the default value of the member.
   UVCP_CONSTANT GetDefaultValue() const { return default_value_; }
 
+  // Returns how the member is displayed.
+  BrowsableState GetBrowsableState() const { return browsable_state_; }
+
+  // Sets how the member is displayed.
+  void SetBrowsableState(BrowsableState browsable_state) {
+    browsable_state_ = browsable_state;
+  }
+
   // Returns the HRESULT when Initialize function is called.
   HRESULT GetInitializeHr() const { return initialized_hr_; }
 
@@ -119,6 +138,9 @@ class IDbgClassMember : public StringStreamWrapper {
 
   // Depth used when creating a DbgObject representing this member.
   int creation_depth_ = kDefaultObjectEvalDepth;
+
+  // How the member is displayed.
+  BrowsableState browsable_state_ = BrowsableState::kCollapsed;
 };
 
 }  //  namespace google_cloud_debugger
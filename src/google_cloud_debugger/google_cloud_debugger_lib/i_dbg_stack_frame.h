@@ -25,6 +25,7 @@
 #include "constants.h"
 #include "dbg_object.h"
 #include "document_index.h"
+#include "variable_slot.h"
 
 namespace google_cloud_debugger {
 
@@ -48,6 +49,22 @@ class IDbgStackFrame {
                                    std::shared_ptr<DbgObject> *dbg_object,
                                    std::ostream *err_stream) = 0;
 
+  // Finds the slot of the local variable or method argument that
+  // GetLocalVariable returns for variable_name. Returns S_FALSE if it
+  // has no slot (for example, it is a constant).
+  virtual HRESULT GetLocalVariableSlot(const std::string &variable_name,
+                                       VariableSlot *slot) {
+    return S_FALSE;
+  }
+
+  // Gets the local variable or method argument in slot, which was
+  // returned by GetLocalVariableSlot for a frame of the same method.
+  // Returns S_FALSE if this frame does not have it.
+  virtual HRESULT GetLocalVariableBySlot(
+      const VariableSlot &slot, std::shared_ptr<DbgObject> *dbg_object) {
+    return S_FALSE;
+  }
+
   // Gets out any field or auto-implemented property with the name
   // member_name of the class this frame is in.
   virtual HRESULT GetFieldAndAutoPropFromFrame(
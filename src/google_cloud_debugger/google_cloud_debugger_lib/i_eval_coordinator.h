@@ -18,6 +18,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -29,7 +30,9 @@ namespace google_cloud_debugger {
 
 class IBreakpointCollection;
 class DbgBreakpoint;
+class DbgObject;
 class IDbgObjectFactory;
+struct ModuleSnapshot;
 
 // An EvalCoordinator object is used by DebuggerCallback object to evaluate
 // and print out variables. It does so by creating a StackFrame on a new
@@ -75,8 +78,8 @@ class IEvalCoordinator {
   virtual void SignalFinishedEval(ICorDebugThread *debug_thread) = 0;
 
   // DebuggerCallback calls this function to signal that an exception has
-  // occurred.
-  virtual void HandleException() = 0;
+  // occurred on debug_thread.
+  virtual void HandleException(ICorDebugThread *debug_thread) = 0;
 
   // Processes a vector of breakpoints set at the SAME location (they
   // can have different conditions and expressions).
@@ -85,9 +88,7 @@ class IEvalCoordinator {
   virtual HRESULT ProcessBreakpoints(
       ICorDebugThread *debug_thread, IBreakpointCollection *breakpoint_collection,
       std::vector<std::shared_ptr<DbgBreakpoint>> breakpoints,
-      const std::vector<
-          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-          &pdb_files) = 0;
+      std::shared_ptr<const ModuleSnapshot> modules) = 0;
 
   // StackFrame calls this to signal that it already processed all the
   // variables and it is just waiting to perform evaluation (if necessary) and
@@ -104,8 +105,9 @@ class IEvalCoordinator {
   // Returns the active debug frame.
   virtual HRESULT GetActiveDebugFrame(ICorDebugILFrame **debug_frame) = 0;
 
-  // Returns true if we are waiting for an evaluation result.
-  virtual BOOL WaitingForEval() = 0;
+  // Returns true if we are waiting for an evaluation result on
+  // debug_thread.
+  virtual BOOL WaitingForEval(ICorDebugThread *debug_thread) = 0;
 
   // Sets whether property evaluation should be performed.
   virtual void SetPropertyEvaluation(BOOL eval) = 0;
@@ -118,6 +120,39 @@ class IEvalCoordinator {
 
   // Returns whether method call should be performed when evaluating condition.
   virtual BOOL MethodEvaluation() = 0;
+
+  // Sets value to the result of the getter of property property_def in
+  // debug_module that was evaluated on the object at object_address
+  // earlier during the breakpoint hit that is being processed. Returns
+  // false if the getter has not been evaluated on the object yet.
+  virtual bool GetCachedPropertyValue(CORDB_ADDRESS object_address,
+                                      ICorDebugModule *debug_module,
+                                      mdProperty property_def,
+                                      std::shared_ptr<DbgObject> *value) = 0;
+
+  // Keeps value, the result of the getter of property property_def in
+  // debug_module evaluated on the object at object_address, until the
+  // breakpoint hit that is being processed ends.
+  virtual void CachePropertyValue(CORDB_ADDRESS object_address,
+                                  ICorDebugModule *debug_module,
+                                  mdProperty property_def,
+                                  std::shared_ptr<DbgObject> value) = 0;
+
+  // Sets value to the result of the subexpression that prints as key
+  // (see SharedExpressionEvaluator) if it was evaluated earlier during
+  // the breakpoint hit that is being processed, by any of the breakpoints
+  // at the location. Returns false otherwise.
+  virtual bool GetCachedExpressionValue(const std::string &key,
+                                        std::shared_ptr<DbgObject> *value) = 0;
+
+  // Keeps value, the result of the subexpression that prints as key,
+  // until the breakpoint hit that is being processed ends.
+  virtual void CacheExpressionValue(const std::string &key,
+                                    std::shared_ptr<DbgObject> value) = 0;
+
+  // Drops what is cached about the stack frames in module module_name,
+  // which is being unloaded.
+  virtual void RemoveModuleFrames(const std::string &module_name) = 0;
 };
 
 }  //  namespace google_cloud_debugger
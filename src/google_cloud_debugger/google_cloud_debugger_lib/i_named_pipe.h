@@ -15,12 +15,22 @@
 #ifndef I_NAMED_PIPE_H_
 #define I_NAMED_PIPE_H_
 
+#include <cstddef>
 #include <string>
 
 #include "cor.h"
 
 namespace google_cloud_debugger {
 
+// A buffer that is not owned, used to write several buffers at once.
+struct PipeBuffer {
+  // The start of the buffer.
+  const char *data;
+
+  // The size of the buffer.
+  std::size_t size;
+};
+
 // Functionality of a named pipe.
 class INamedPipe {
  public:
@@ -40,11 +50,22 @@ class INamedPipe {
   // Note: strings are used only as containers.
   virtual HRESULT Read(std::string *message) = 0;
 
+  // Reads exactly size bytes from the pipe into message and returns an
+  // HRESULT. This function will block until all the bytes are read.
+  // message is resized to size, so passing the same string every time
+  // reuses its memory.
+  virtual HRESULT ReadExactly(std::size_t size, std::string *message) = 0;
+
   // Write a message up to the buffer in chunks of the maximum
   // buffer size from the pipe and returns an HRESULT.
   // Note: strings are used only as containers.
   virtual HRESULT Write(const std::string &message) = 0;
 
+  // Writes count buffers to the pipe, in order, as a single message
+  // without first copying them into one buffer, and returns an HRESULT.
+  virtual HRESULT WriteBuffers(const PipeBuffer *buffers,
+                               std::size_t count) = 0;
+
   // Cancels any pending operations and shuts down the pipe.
   virtual HRESULT ShutDown() = 0;
 };
@@ -0,0 +1,43 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef I_PDB_PROVIDER_H_
+#define I_PDB_PROVIDER_H_
+
+#include <string>
+
+#include "pe_debug_directory.h"
+
+namespace google_cloud_debugger_portable_pdb {
+
+// Provides the Portable PDBs of the modules that neither embed their PDB
+// nor have it next to them, for example when the PDBs are stripped from
+// the image of an application and kept in a symbol store.
+class IPdbProvider {
+ public:
+  virtual ~IPdbProvider() = default;
+
+  // Sets pdb_path to a local file with the PDB described by pdb_info.
+  // Does not download anything. Returns false if there is no such file.
+  virtual bool FindPdb(const CodeViewPdbInfo &pdb_info,
+                       std::string *pdb_path) const = 0;
+
+  // Fetches the PDB described by pdb_info so that FindPdb finds it.
+  // Blocks until it is fetched. Returns false if it cannot be fetched.
+  virtual bool FetchPdb(const CodeViewPdbInfo &pdb_info) = 0;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // I_PDB_PROVIDER_H_
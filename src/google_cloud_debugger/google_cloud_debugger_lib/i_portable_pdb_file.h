@@ -15,6 +15,8 @@
 #ifndef I_PORTABLE_PDB_H_
 #define I_PORTABLE_PDB_H_
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -24,10 +26,12 @@
 #include "cor.h"
 #include "cordebug.h"
 #include "document_index.h"
+#include "document_path_index.h"
 #include "metadata_tables.h"
 
 namespace google_cloud_debugger {
   class ICorDebugHelper;
+  class ModuleTypeDictionary;
 }
 
 namespace google_cloud_debugger_portable_pdb {
@@ -45,7 +49,11 @@ struct StreamHeader;
 //
 // To use this class, creates a PortablePdbFile object and calls Initialize
 // with an ICorDebugModule object. Then, calls the ParsePdb method to parse
-// the PDB file for the module.
+// the PDB file for the module. ParsePdb only reads the metadata tables and
+// the document names, which is enough to find the document of a breakpoint.
+// The methods of the documents are parsed the first time ParseMethods is
+// called, so their sequence points and local scopes are only expanded for
+// modules that breakpoints and stack frames actually use.
 class IPortablePdbFile {
  public:
   // Destructor.
@@ -59,6 +67,29 @@ class IPortablePdbFile {
   // ICorDebugModule object that is used to initialize this object.
   virtual bool ParsePdbFile() = 0;
 
+  // Parses the methods of every document in the pdb file. ParsePdbFile
+  // must have succeeded. Does nothing if the methods are already parsed.
+  virtual bool ParseMethods() = 0;
+
+  // Parses the methods of the document at index document of the document
+  // index table only. ParsePdbFile must have succeeded. Does nothing if
+  // the methods of the document are already parsed.
+  virtual bool ParseDocumentMethods(std::size_t document) = 0;
+
+  // Keeps the parsed methods and local scopes of this PDB from being
+  // evicted (see PdbMemoryLimiter) until UnpinMethods is called as many
+  // times. Whoever reads the methods of the document index table or the
+  // scopes of GetMethodScopes pins them first.
+  virtual void PinMethods() = 0;
+
+  // Undoes one PinMethods.
+  virtual void UnpinMethods() = 0;
+
+  // Frees the parsed methods and local scopes of this PDB, which are
+  // parsed again the next time they are needed, unless they are pinned
+  // or in use. Returns the bytes freed, or 0 if nothing is evicted.
+  virtual std::size_t EvictMethods() = 0;
+
   // Finds the stream header with a given name. Returns false if not found.
   // name is the name of the stream header.
   // stream_header is the stream header that has name name.
@@ -69,9 +100,10 @@ class IPortablePdbFile {
   virtual bool GetHeapString(std::uint32_t index,
                              std::string *result) const = 0;
 
-  // Get string from the blob at index index.
-  virtual bool GetBlobBytes(std::uint32_t index,
-                            std::vector<uint8_t> *result) const = 0;
+  // Sets data to the bytes of the blob at index index in the blob heap and
+  // length to their number. The bytes are valid for the lifetime of the PDB.
+  virtual bool GetBlobSpan(std::uint32_t index, const std::uint8_t **data,
+                           std::uint32_t *length) const = 0;
 
   // Retrieves the name of a document using the provided blob heap index.
   // The exact conversion from a blob to document name is in the Portable PDB
@@ -79,12 +111,10 @@ class IPortablePdbFile {
   virtual bool GetDocumentName(std::uint32_t index,
                                std::string *doc_name) const = 0;
 
-  // Gets GUID based on index.
-  virtual bool GetHeapGuid(std::uint32_t index, std::string *guid) const = 0;
-
-  // Gets the hash based on index.
-  virtual bool GetHash(std::uint32_t index,
-                       std::vector<std::uint8_t> *hash) const = 0;
+  // Sets guid to the 16 bytes of the GUID at index index in the GUID heap.
+  // The bytes are valid for the lifetime of the PDB.
+  virtual bool GetHeapGuidSpan(std::uint32_t index,
+                               const std::uint8_t **guid) const = 0;
 
   // Gets the method sequence information based on index.
   virtual bool GetMethodSeqInfo(
@@ -92,36 +122,79 @@ class IPortablePdbFile {
       MethodSequencePointInformation *sequence_point_info) const = 0;
 
   // Returns the document table.
-  virtual const std::vector<DocumentRow> &GetDocumentTable() const = 0;
+  virtual MetadataTableView<DocumentRow> GetDocumentTable() const = 0;
 
   // Returns the local scope table.
-  virtual const std::vector<LocalScopeRow> &GetLocalScopeTable() const = 0;
+  virtual MetadataTableView<LocalScopeRow> GetLocalScopeTable() const = 0;
 
   // Returns the local variable table.
-  virtual const std::vector<LocalVariableRow> &GetLocalVariableTable()
+  virtual MetadataTableView<LocalVariableRow> GetLocalVariableTable()
       const = 0;
 
   // Returns the method debug info table.
-  virtual const std::vector<MethodDebugInformationRow>
-      &GetMethodDebugInfoTable() const = 0;
+  virtual MetadataTableView<MethodDebugInformationRow>
+  GetMethodDebugInfoTable() const = 0;
 
   // Returns the local constant table.
-  virtual const std::vector<LocalConstantRow> &GetLocalConstantTable()
+  virtual MetadataTableView<LocalConstantRow> GetLocalConstantTable()
       const = 0;
 
   // Returns the document index table.
   virtual const std::vector<std::unique_ptr<IDocumentIndex>>
       &GetDocumentIndexTable() const = 0;
 
+  // Returns the index of the file paths of the documents in the
+  // document index table. Built once when the PDB is parsed.
+  virtual const DocumentPathIndex &GetDocumentPathIndex() const = 0;
+
+  // Gets the local scopes of method method_def. They are parsed the first
+  // time they are asked for and then kept until the methods of this PDB
+  // are evicted, so *scopes is
+  // valid as long as the methods of the PDB are pinned (see PinMethods).
+  // ParsePdbFile must have succeeded.
+  virtual bool GetMethodScopes(std::uint32_t method_def,
+                               const std::vector<Scope> **scopes) = 0;
+
   // Gets the name of the module of this PDB.
   virtual const std::string &GetModuleName() const = 0;
 
+  // Gets the id of this PDB, which identifies the build of its module.
+  // ParsePdbFile must have succeeded.
+  virtual const std::array<std::uint8_t, 20> &GetPdbId() const = 0;
+
   // Gets the ICorDebugModule of the module of this PDB.
   virtual HRESULT GetDebugModule(ICorDebugModule **debug_module) const = 0;
 
   // Gets the MetadataImport of the module of this PDB.
   virtual HRESULT GetMetaDataImport(
       IMetaDataImport **metadata_import) const = 0;
+
+  // Gets the dictionary of the types of the module of this PDB, which
+  // stack frames in the module share.
+  virtual std::shared_ptr<google_cloud_debugger::ModuleTypeDictionary>
+  GetTypeDictionary() const = 0;
+};
+
+// Pins the methods of a PDB (see IPortablePdbFile::PinMethods) for the
+// lifetime of the object.
+class ScopedMethodsPin {
+ public:
+  explicit ScopedMethodsPin(IPortablePdbFile *pdb) : pdb_(pdb) {
+    if (pdb_) {
+      pdb_->PinMethods();
+    }
+  }
+  ScopedMethodsPin(const ScopedMethodsPin &) = delete;
+  ScopedMethodsPin &operator=(const ScopedMethodsPin &) = delete;
+
+  ~ScopedMethodsPin() {
+    if (pdb_) {
+      pdb_->UnpinMethods();
+    }
+  }
+
+ private:
+  IPortablePdbFile *pdb_;
 };
 
 }  // namespace google_cloud_debugger_portable_pdb
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "breakpoint.pb.h"
+#include "capture_limits.h"
 #include "cor.h"
 #include "cordebug.h"
 #include "i_portable_pdb_file.h"
@@ -45,12 +46,22 @@ class IStackFrameCollection {
           &pdb_files,
       DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator) = 0;
 
-  // Populates the stack frames of a breakpoint using stack_frames.
+  // Evaluates the condition and the expressions of breakpoint the same
+  // way ProcessBreakpoint does but does not collect stack information.
+  // Returns S_FALSE if the condition evaluated to false.
+  virtual HRESULT EvaluateConditionAndExpressions(
+      const std::vector<
+          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+          &pdb_files,
+      DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator) = 0;
+
+  // Populates the stack frames of a breakpoint using stack_frames,
+  // capturing the variables within limits.
   // eval_coordinator will be used to perform eval coordination during function
   // evaluation if needed.
   virtual HRESULT PopulateStackFrames(
       google::cloud::diagnostics::debug::Breakpoint *breakpoint,
-      IEvalCoordinator *eval_coordinator) = 0;
+      const CaptureLimits &limits, IEvalCoordinator *eval_coordinator) = 0;
 };
 
 }  //  namespace google_cloud_debugger
@@ -0,0 +1,143 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "log_message_template.h"
+
+#include <cctype>
+#include <climits>
+
+#include "number_format.h"
+
+using google::cloud::diagnostics::debug::Variable;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsWhiteSpace(const string &value) {
+  for (char c : value) {
+    if (!std::isspace(static_cast<unsigned char>(c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+LogMessageTemplate::LogMessageTemplate(const string &message_format) {
+  string literal;
+  size_t i = 0;
+  while (i < message_format.size()) {
+    char current_char = message_format[i];
+    char next_char =
+        i + 1 < message_format.size() ? message_format[i + 1] : '\0';
+    if (current_char != '$' || (next_char != '$' && !IsDigit(next_char))) {
+      literal += current_char;
+      i += 1;
+      continue;
+    }
+
+    if (next_char == '$') {
+      // Escapes the current $.
+      literal += '$';
+      i += 2;
+      continue;
+    }
+
+    // A $ followed by the index of an expression.
+    AddLiteral(&literal);
+    i += 1;
+    long long expression_index = 0;
+    while (i < message_format.size() && IsDigit(message_format[i])) {
+      if (expression_index <= INT_MAX) {
+        expression_index = expression_index * 10 + (message_format[i] - '0');
+      }
+      i += 1;
+    }
+
+    if (expression_index > INT_MAX) {
+      expression_index = INT_MAX;
+    }
+    segments_.push_back({string(), static_cast<int>(expression_index)});
+  }
+
+  AddLiteral(&literal);
+}
+
+void LogMessageTemplate::Render(
+    const google::protobuf::RepeatedPtrField<Variable> &evaluated_expressions,
+    string *message) const {
+  for (const Segment &segment : segments_) {
+    if (segment.expression_index < 0) {
+      message->append(segment.literal);
+    } else if (segment.expression_index < evaluated_expressions.size()) {
+      AppendVariable(evaluated_expressions.Get(segment.expression_index),
+                     message);
+    } else {
+      message->append("{");
+      AppendNumber(segment.expression_index, message);
+      message->append(" cannot be evaluated}");
+    }
+  }
+}
+
+void LogMessageTemplate::AppendVariable(const Variable &variable,
+                                        string *message) {
+  if (variable.has_status() && variable.status().iserror()) {
+    message->append("\"Error evaluating ");
+    message->append(variable.name());
+    message->append(": ");
+    message->append(variable.status().message());
+    message->append("\"");
+    return;
+  }
+
+  if (!IsWhiteSpace(variable.value())) {
+    message->append(variable.value());
+    return;
+  }
+
+  size_t start = message->size();
+  message->append("[ ");
+  for (const Variable &member : variable.members()) {
+    message->append(member.name());
+    message->append(" (");
+    message->append(member.type());
+    message->append("): ");
+    AppendVariable(member, message);
+    message->append(", ");
+  }
+
+  // Trims the separator after the last member.
+  while (message->size() > start + 1 &&
+         (message->back() == ',' || message->back() == ' ')) {
+    message->pop_back();
+  }
+  message->append("]");
+}
+
+void LogMessageTemplate::AddLiteral(string *literal) {
+  if (literal->empty()) {
+    return;
+  }
+
+  segments_.push_back({*literal, -1});
+  literal->clear();
+}
+
+}  // namespace google_cloud_debugger
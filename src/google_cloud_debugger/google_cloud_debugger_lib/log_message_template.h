@@ -0,0 +1,64 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOG_MESSAGE_TEMPLATE_H_
+#define LOG_MESSAGE_TEMPLATE_H_
+
+#include <string>
+#include <vector>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// A log message format parsed into literal segments and the indices of
+// the expressions substituted between them. "$0", "$1", etc. refer to the
+// evaluated expressions of the log point and "$$" is a '$'. Messages are
+// rendered the way LogMessageTemplate of the agent renders them, so that
+// a log point reads the same whichever side formats it.
+class LogMessageTemplate {
+ public:
+  // Parses message_format into a template.
+  explicit LogMessageTemplate(const std::string &message_format);
+
+  // Appends the message with the expressions substituted by
+  // evaluated_expressions to message.
+  void Render(const google::protobuf::RepeatedPtrField<
+                  google::cloud::diagnostics::debug::Variable>
+                  &evaluated_expressions,
+              std::string *message) const;
+
+ private:
+  // A literal or, if expression_index is not negative, the expression
+  // with that index.
+  struct Segment {
+    std::string literal;
+    int expression_index;
+  };
+
+  // Appends variable to message in a more readable form, especially
+  // if the variable only has members and no value.
+  static void AppendVariable(
+      const google::cloud::diagnostics::debug::Variable &variable,
+      std::string *message);
+
+  // Adds literal as a segment and clears it.
+  void AddLiteral(std::string *literal);
+
+  std::vector<Segment> segments_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  LOG_MESSAGE_TEMPLATE_H_
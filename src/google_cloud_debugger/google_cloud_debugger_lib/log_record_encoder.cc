@@ -0,0 +1,88 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "log_record_encoder.h"
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include "constants.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::protobuf::io::CodedOutputStream;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Appends size as a varint32 and then size bytes of data to buffer.
+void AppendBytes(const char *data, size_t size, string *buffer) {
+  uint8_t prefix[5];
+  uint8_t *end = CodedOutputStream::WriteVarint32ToArray(
+      static_cast<uint32_t>(size), prefix);
+  buffer->append(reinterpret_cast<const char *>(prefix), end - prefix);
+  buffer->append(data, size);
+}
+
+}  // namespace
+
+bool LogRecordEncoder::CanEncode(const Breakpoint &breakpoint) {
+  return breakpoint.log_point() && !breakpoint.kill_server() &&
+         !breakpoint.has_status() && breakpoint.stack_frames_size() == 0;
+}
+
+void LogRecordEncoder::Append(const Breakpoint &breakpoint,
+                              std::uint64_t timestamp_us, string *buffer) {
+  AppendBytes(breakpoint.id().data(), breakpoint.id().size(), buffer);
+
+  char timestamp[sizeof(timestamp_us)];
+  for (size_t i = 0; i < sizeof(timestamp); ++i) {
+    timestamp[i] = static_cast<char>(timestamp_us >> (8 * i));
+  }
+  buffer->append(timestamp, sizeof(timestamp));
+
+  uint8_t level[5];
+  uint8_t *level_end = CodedOutputStream::WriteVarint32ToArray(
+      static_cast<uint32_t>(breakpoint.log_level()), level);
+  buffer->append(reinterpret_cast<const char *>(level), level_end - level);
+
+  message_.clear();
+  GetTemplate(breakpoint.log_message_format())
+      .Render(breakpoint.evaluated_expressions(), &message_);
+  AppendBytes(message_.data(), message_.size(), buffer);
+
+  // Does not keep the memory of an unusually long message around.
+  if (message_.capacity() > kMaximumPooledWriteBufferSize) {
+    string().swap(message_);
+  }
+}
+
+const LogMessageTemplate &LogRecordEncoder::GetTemplate(
+    const string &message_format) {
+  auto found = templates_.find(message_format);
+  if (found != templates_.end()) {
+    return found->second;
+  }
+
+  // Log points are few, so this only happens if formats keep changing.
+  if (templates_.size() >= kMaximumCachedLogMessageTemplates) {
+    templates_.clear();
+  }
+
+  return templates_
+      .emplace(message_format, LogMessageTemplate(message_format))
+      .first->second;
+}
+
+}  // namespace google_cloud_debugger
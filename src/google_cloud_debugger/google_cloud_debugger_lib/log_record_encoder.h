@@ -0,0 +1,65 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOG_RECORD_ENCODER_H_
+#define LOG_RECORD_ENCODER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "breakpoint.pb.h"
+#include "log_message_template.h"
+
+namespace google_cloud_debugger {
+
+// Encodes hits of log points as log records, which carry the formatted
+// message instead of the evaluated expressions, so that the agent only
+// has to write them to the log. A message of a frame with
+// kFrameLogRecordsFlag is a sequence of records, each of them:
+//   the size of the breakpoint ID as a varint32, then the ID,
+//   the time of the hit in microseconds since the epoch as a
+//   little-endian uint64,
+//   the log level as a varint32,
+//   the size of the message as a varint32, then the UTF-8 message.
+//
+// Not thread-safe; the breakpoint client encodes with its write lock held.
+class LogRecordEncoder {
+ public:
+  // Returns true if breakpoint is a hit of a log point that can be sent
+  // as a log record. Hits with an error status, which the agent logs
+  // and reports differently, are still sent as breakpoints.
+  static bool CanEncode(
+      const google::cloud::diagnostics::debug::Breakpoint &breakpoint);
+
+  // Appends the log record of breakpoint, which CanEncode accepted and
+  // which was hit at timestamp_us, to buffer.
+  void Append(const google::cloud::diagnostics::debug::Breakpoint &breakpoint,
+              std::uint64_t timestamp_us, std::string *buffer);
+
+ private:
+  // Returns the parsed template of message_format.
+  const LogMessageTemplate &GetTemplate(const std::string &message_format);
+
+  // Parsed log message formats, so that a format is not scanned again
+  // every time its log point is hit.
+  std::unordered_map<std::string, LogMessageTemplate> templates_;
+
+  // Buffer the messages are rendered in, reused across records.
+  std::string message_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  LOG_RECORD_ENCODER_H_
@@ -0,0 +1,61 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEMORY_MAPPED_FILE_H_
+#define MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace google_cloud_debugger_portable_pdb {
+
+// A read-only view of a whole file mapped into memory (mmap on Unix and
+// MapViewOfFile on Windows). The view stays valid until the object is
+// destroyed.
+class MemoryMappedFile {
+ public:
+  MemoryMappedFile() = default;
+  MemoryMappedFile(const MemoryMappedFile &) = delete;
+  MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+  // Unmaps the file.
+  ~MemoryMappedFile();
+
+  // Maps file into memory. Returns false if the file cannot be opened
+  // or mapped. An empty file is mapped to an empty view.
+  bool Open(const std::string &file);
+
+  // Returns the first byte of the file.
+  const std::uint8_t *GetData() const { return data_; }
+
+  // Returns the size of the file.
+  std::size_t GetSize() const { return size_; }
+
+ private:
+  // Start of the mapped view.
+  const std::uint8_t *data_ = nullptr;
+
+  // Size of the mapped view.
+  std::size_t size_ = 0;
+
+  // Handles of the file and of the file mapping object. Only used on
+  // Windows, where they must stay open while the view is mapped.
+  void *file_handle_ = nullptr;
+  void *mapping_handle_ = nullptr;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // MEMORY_MAPPED_FILE_H_
@@ -0,0 +1,76 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PLATFORM_UNIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+#include "memory_mapped_file.h"
+
+using std::cerr;
+using std::string;
+
+namespace google_cloud_debugger_portable_pdb {
+
+MemoryMappedFile::~MemoryMappedFile() {
+  if (data_ && munmap(const_cast<uint8_t *>(data_), size_) == -1) {
+    cerr << "munmap error: " << strerror(errno) << std::endl;
+  }
+}
+
+bool MemoryMappedFile::Open(const string &file) {
+  if (data_) {
+    return false;
+  }
+
+  int file_descriptor = open(file.c_str(), O_RDONLY);
+  if (file_descriptor == -1) {
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(file_descriptor, &file_stat) == -1) {
+    cerr << "fstat error: " << strerror(errno) << std::endl;
+    close(file_descriptor);
+    return false;
+  }
+
+  if (file_stat.st_size == 0) {
+    close(file_descriptor);
+    return true;
+  }
+
+  void *view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                    file_descriptor, 0);
+  // The mapping stays valid after the descriptor is closed.
+  close(file_descriptor);
+  if (view == MAP_FAILED) {
+    cerr << "mmap error: " << strerror(errno) << std::endl;
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t *>(view);
+  size_ = file_stat.st_size;
+  return true;
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  //  PLATFORM_UNIX
@@ -0,0 +1,88 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <iostream>
+
+#include "memory_mapped_file.h"
+
+using std::cerr;
+using std::string;
+
+namespace google_cloud_debugger_portable_pdb {
+
+MemoryMappedFile::~MemoryMappedFile() {
+  if (data_ && !UnmapViewOfFile(data_)) {
+    cerr << "UnmapViewOfFile error: " << HRESULT_FROM_WIN32(GetLastError())
+         << std::endl;
+  }
+
+  if (mapping_handle_) {
+    CloseHandle(mapping_handle_);
+  }
+
+  if (file_handle_) {
+    CloseHandle(file_handle_);
+  }
+}
+
+bool MemoryMappedFile::Open(const string &file) {
+  if (file_handle_) {
+    return false;
+  }
+
+  HANDLE file_handle =
+      CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  file_handle_ = file_handle;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_handle, &file_size)) {
+    cerr << "GetFileSizeEx error: " << HRESULT_FROM_WIN32(GetLastError())
+         << std::endl;
+    return false;
+  }
+
+  if (file_size.QuadPart == 0) {
+    return true;
+  }
+
+  mapping_handle_ =
+      CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_handle_) {
+    cerr << "CreateFileMapping error: " << HRESULT_FROM_WIN32(GetLastError())
+         << std::endl;
+    return false;
+  }
+
+  void *view = MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    cerr << "MapViewOfFile error: " << HRESULT_FROM_WIN32(GetLastError())
+         << std::endl;
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t *>(view);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  return true;
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  //  _WIN32
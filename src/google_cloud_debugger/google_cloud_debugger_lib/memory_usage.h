@@ -0,0 +1,75 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef MEMORY_USAGE_H_
+#define MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace google_cloud_debugger {
+
+// Estimates of the heap memory used by standard containers, for the
+// memory gauges of DebuggerMetrics. They count what the containers
+// allocate for their own elements, not what the elements point to, and
+// assume the node layouts common to the standard libraries the debugger
+// is built with, so they are approximate.
+
+// Returns the bytes allocated for the characters of value.
+inline std::size_t GetMemoryUsage(const std::string &value) {
+  return value.capacity() + 1;
+}
+
+// Returns the bytes allocated for the elements of values.
+template <typename T>
+std::size_t GetMemoryUsage(const std::vector<T> &values) {
+  return values.capacity() * sizeof(T);
+}
+
+// Returns the bytes allocated for the nodes of values. A node of a
+// red-black tree has three pointers and a color besides its element.
+template <typename Key, typename Value, typename Compare, typename Allocator>
+std::size_t GetMemoryUsage(
+    const std::map<Key, Value, Compare, Allocator> &values) {
+  return values.size() *
+         (sizeof(std::pair<const Key, Value>) + 4 * sizeof(void *));
+}
+
+// Returns the bytes allocated for a node of a hash table of type Map.
+// A node has a pointer to the next node and the hash of its key besides
+// its element.
+template <typename Map>
+std::size_t GetHashNodeMemoryUsage() {
+  return sizeof(typename Map::value_type) + 2 * sizeof(void *);
+}
+
+// Returns the bytes allocated for the buckets and the nodes of values.
+template <typename Key, typename Value, typename Hash, typename Equal,
+          typename Allocator>
+std::size_t GetMemoryUsage(
+    const std::unordered_map<Key, Value, Hash, Equal, Allocator> &values) {
+  return values.bucket_count() * sizeof(void *) +
+         values.size() *
+             GetHashNodeMemoryUsage<
+                 std::unordered_map<Key, Value, Hash, Equal, Allocator>>();
+}
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  MEMORY_USAGE_H_
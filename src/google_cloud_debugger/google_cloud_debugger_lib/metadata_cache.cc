@@ -0,0 +1,477 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "metadata_cache.h"
+
+#include "constants.h"
+#include "metrics.h"
+#include "string_stream_wrapper.h"
+
+namespace google_cloud_debugger {
+
+MetadataCache &MetadataCache::Global() {
+  static MetadataCache cache;
+  return cache;
+}
+
+void MetadataCache::SetEnabled(bool enabled) {
+  enabled_ = enabled;
+  if (!enabled) {
+    Clear();
+  }
+}
+
+bool MetadataCache::FindMetadataImport(ICorDebugModule *debug_module,
+                                       IMetaDataImport **metadata_import) {
+  if (!enabled_ || !debug_module || !metadata_import) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(imports_mutex_);
+  const auto &cached = imports_.find(debug_module);
+  if (cached == imports_.end()) {
+    return false;
+  }
+
+  // The caller owns the returned reference.
+  *metadata_import = cached->second.metadata_import;
+  (*metadata_import)->AddRef();
+  return true;
+}
+
+void MetadataCache::AddMetadataImport(ICorDebugModule *debug_module,
+                                      IMetaDataImport *metadata_import) {
+  if (!enabled_ || !debug_module || !metadata_import) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(imports_mutex_);
+  ModuleImport &cached = imports_[debug_module];
+  cached.debug_module = debug_module;
+  cached.metadata_import = metadata_import;
+}
+
+HRESULT MetadataCache::GetMethodProps(IMetaDataImport *metadata_import,
+                                      mdMethodDef method_def, bool need_name,
+                                      MethodProps *props) {
+  if (!metadata_import || !props) {
+    return E_INVALIDARG;
+  }
+
+  bool enabled = enabled_;
+  if (enabled &&
+      method_props_.Find(metadata_import, method_def, need_name, props)) {
+    return S_OK;
+  }
+
+  MethodProps result;
+  ULONG name_length = 0;
+  HRESULT hr = metadata_import->GetMethodProps(
+      method_def, &result.class_token, nullptr, 0, &name_length,
+      &result.attributes, &result.signature, &result.signature_length,
+      &result.virtual_address, &result.impl_flags);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (need_name) {
+    result.name.resize(name_length, 0);
+    hr = metadata_import->GetMethodProps(
+        method_def, &result.class_token, result.name.data(),
+        result.name.size(), &name_length, &result.attributes,
+        &result.signature, &result.signature_length, &result.virtual_address,
+        &result.impl_flags);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    result.has_name = true;
+  }
+
+  if (enabled && hr == S_OK) {
+    method_props_.Add(metadata_import, method_def, result);
+  }
+  *props = std::move(result);
+  return hr;
+}
+
+HRESULT MetadataCache::GetTypeProps(IMetaDataImport *metadata_import,
+                                    mdTypeDef type_def, bool need_name,
+                                    TypeProps *props) {
+  if (!metadata_import || !props) {
+    return E_INVALIDARG;
+  }
+
+  bool enabled = enabled_;
+  if (enabled &&
+      type_props_.Find(metadata_import, type_def, need_name, props)) {
+    return S_OK;
+  }
+
+  TypeProps result;
+  ULONG name_length = 0;
+  HRESULT hr = metadata_import->GetTypeDefProps(
+      type_def, nullptr, 0, &name_length, &result.flags, &result.extends);
+  if (FAILED(hr) || hr == S_FALSE) {
+    return hr;
+  }
+
+  if (need_name) {
+    result.name.resize(name_length, 0);
+    hr = metadata_import->GetTypeDefProps(type_def, result.name.data(),
+                                          result.name.size(), &name_length,
+                                          &result.flags, &result.extends);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    result.has_name = true;
+  }
+
+  if (enabled && hr == S_OK) {
+    type_props_.Add(metadata_import, type_def, result);
+  }
+  *props = std::move(result);
+  return hr;
+}
+
+HRESULT MetadataCache::GetTypeRefProps(IMetaDataImport *metadata_import,
+                                       mdTypeRef type_ref, bool need_name,
+                                       TypeRefProps *props) {
+  if (!metadata_import || !props) {
+    return E_INVALIDARG;
+  }
+
+  bool enabled = enabled_;
+  if (enabled &&
+      type_ref_props_.Find(metadata_import, type_ref, need_name, props)) {
+    return S_OK;
+  }
+
+  TypeRefProps result;
+  ULONG name_length = 0;
+  HRESULT hr = metadata_import->GetTypeRefProps(
+      type_ref, &result.resolution_scope, nullptr, 0, &name_length);
+  if (FAILED(hr) || hr == S_FALSE) {
+    return hr;
+  }
+
+  if (need_name) {
+    result.name.resize(name_length, 0);
+    hr = metadata_import->GetTypeRefProps(type_ref, &result.resolution_scope,
+                                          result.name.data(),
+                                          result.name.size(), &name_length);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    result.has_name = true;
+  }
+
+  if (enabled && hr == S_OK) {
+    type_ref_props_.Add(metadata_import, type_ref, result);
+  }
+  *props = std::move(result);
+  return hr;
+}
+
+HRESULT MetadataCache::GetFieldProps(IMetaDataImport *metadata_import,
+                                     mdFieldDef field_def, bool need_name,
+                                     FieldProps *props) {
+  if (!metadata_import || !props) {
+    return E_INVALIDARG;
+  }
+
+  bool enabled = enabled_;
+  if (enabled &&
+      field_props_.Find(metadata_import, field_def, need_name, props)) {
+    return S_OK;
+  }
+
+  FieldProps result;
+  ULONG name_length = 0;
+  HRESULT hr = metadata_import->GetFieldProps(
+      field_def, &result.class_token, nullptr, 0, &name_length,
+      &result.attributes, &result.signature, &result.signature_length,
+      &result.default_value_flags, &result.default_value,
+      &result.default_value_length);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (need_name) {
+    result.name.resize(name_length, 0);
+    hr = metadata_import->GetFieldProps(
+        field_def, &result.class_token, result.name.data(), name_length,
+        &name_length, &result.attributes, &result.signature,
+        &result.signature_length, &result.default_value_flags,
+        &result.default_value, &result.default_value_length);
+    if (FAILED(hr)) {
+      return hr;
+    }
+    result.has_name = true;
+  }
+
+  if (enabled && hr == S_OK) {
+    field_props_.Add(metadata_import, field_def, result);
+  }
+  *props = std::move(result);
+  return hr;
+}
+
+HRESULT MetadataCache::FindField(IMetaDataImport *metadata_import,
+                                 mdTypeDef class_token,
+                                 const std::string &name,
+                                 mdFieldDef *field_def) {
+  if (!metadata_import || !field_def) {
+    return E_INVALIDARG;
+  }
+
+  NamedMemberKey key(metadata_import, class_token, false, name);
+  NamedMember member;
+  if (FindNamedMember(key, &member)) {
+    *field_def = member.token;
+    return member.hr;
+  }
+
+  std::vector<WCHAR> wchar_name = ConvertStringToWCharPtr(name);
+  member.hr = metadata_import->FindField(class_token, wchar_name.data(),
+                                         nullptr, 0, &member.token);
+  if (member.hr == S_OK || member.hr == CLDB_E_RECORD_NOTFOUND) {
+    AddNamedMember(key, member);
+  }
+  *field_def = member.token;
+  return member.hr;
+}
+
+bool MetadataCache::FindProperty(IMetaDataImport *metadata_import,
+                                 mdTypeDef class_token,
+                                 const std::string &name,
+                                 mdProperty *property) {
+  NamedMember member;
+  if (!property ||
+      !FindNamedMember(NamedMemberKey(metadata_import, class_token, true, name),
+                       &member)) {
+    return false;
+  }
+  *property = member.token;
+  return true;
+}
+
+void MetadataCache::AddProperty(IMetaDataImport *metadata_import,
+                                mdTypeDef class_token,
+                                const std::string &name,
+                                mdProperty property) {
+  NamedMember member;
+  member.token = property;
+  AddNamedMember(NamedMemberKey(metadata_import, class_token, true, name),
+                 member);
+}
+
+bool MetadataCache::FindResolvedTypeRef(IMetaDataImport *metadata_import,
+                                        mdTypeRef type_ref,
+                                        mdTypeDef *type_def,
+                                        IMetaDataImport **type_def_metadata) {
+  if (!enabled_ || !type_def || !type_def_metadata) {
+    return false;
+  }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  std::lock_guard<std::mutex> lock(resolved_type_refs_mutex_);
+  const auto &cached =
+      resolved_type_refs_.find(std::make_pair(metadata_import, type_ref));
+  if (cached == resolved_type_refs_.end()) {
+    metrics.metadata_cache_misses.Increment();
+    return false;
+  }
+
+  metrics.metadata_cache_hits.Increment();
+  *type_def = cached->second.type_def;
+  *type_def_metadata = cached->second.metadata_import;
+  (*type_def_metadata)->AddRef();
+  return true;
+}
+
+void MetadataCache::AddResolvedTypeRef(IMetaDataImport *metadata_import,
+                                       mdTypeRef type_ref, mdTypeDef type_def,
+                                       IMetaDataImport *type_def_metadata) {
+  if (!enabled_ || !metadata_import || !type_def_metadata) {
+    return;
+  }
+
+  // The imports of a full cache are released outside of the lock.
+  std::map<std::pair<IMetaDataImport *, mdTypeRef>, ResolvedTypeRef> removed;
+  std::lock_guard<std::mutex> lock(resolved_type_refs_mutex_);
+  if (resolved_type_refs_.size() >= kMaximumCachedMetadataProps) {
+    removed.swap(resolved_type_refs_);
+  }
+
+  ResolvedTypeRef &resolved =
+      resolved_type_refs_[std::make_pair(metadata_import, type_ref)];
+  resolved.type_def = type_def;
+  resolved.metadata_import = type_def_metadata;
+}
+
+void MetadataCache::RemoveModule(ICorDebugModule *debug_module,
+                                 IMetaDataImport *metadata_import) {
+  method_props_.Remove(metadata_import);
+  type_props_.Remove(metadata_import);
+  type_ref_props_.Remove(metadata_import);
+  field_props_.Remove(metadata_import);
+  {
+    std::lock_guard<std::mutex> lock(named_members_mutex_);
+    auto member = named_members_.lower_bound(
+        NamedMemberKey(metadata_import, 0, false, std::string()));
+    while (member != named_members_.end() &&
+           std::get<0>(member->first) == metadata_import) {
+      member = named_members_.erase(member);
+    }
+  }
+
+  // The imports are released outside of the locks.
+  std::vector<ResolvedTypeRef> removed_type_refs;
+  {
+    std::lock_guard<std::mutex> lock(resolved_type_refs_mutex_);
+    auto resolved = resolved_type_refs_.begin();
+    while (resolved != resolved_type_refs_.end()) {
+      if (resolved->first.first == metadata_import ||
+          resolved->second.metadata_import == metadata_import) {
+        removed_type_refs.push_back(resolved->second);
+        resolved = resolved_type_refs_.erase(resolved);
+      } else {
+        ++resolved;
+      }
+    }
+  }
+
+  ModuleImport removed;
+  {
+    std::lock_guard<std::mutex> lock(imports_mutex_);
+    const auto &cached = imports_.find(debug_module);
+    if (cached == imports_.end()) {
+      return;
+    }
+    removed = std::move(cached->second);
+    imports_.erase(cached);
+  }
+}
+
+void MetadataCache::Clear() {
+  method_props_.Clear();
+  type_props_.Clear();
+  type_ref_props_.Clear();
+  field_props_.Clear();
+  {
+    std::lock_guard<std::mutex> lock(named_members_mutex_);
+    named_members_.clear();
+  }
+
+  std::map<std::pair<IMetaDataImport *, mdTypeRef>, ResolvedTypeRef>
+      removed_type_refs;
+  {
+    std::lock_guard<std::mutex> lock(resolved_type_refs_mutex_);
+    removed_type_refs.swap(resolved_type_refs_);
+  }
+
+  std::map<ICorDebugModule *, ModuleImport> removed;
+  {
+    std::lock_guard<std::mutex> lock(imports_mutex_);
+    removed.swap(imports_);
+  }
+}
+
+bool MetadataCache::FindNamedMember(const NamedMemberKey &key,
+                                    NamedMember *member) {
+  if (!enabled_) {
+    return false;
+  }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  std::lock_guard<std::mutex> lock(named_members_mutex_);
+  const auto &cached = named_members_.find(key);
+  if (cached == named_members_.end()) {
+    metrics.metadata_cache_misses.Increment();
+    return false;
+  }
+  metrics.metadata_cache_hits.Increment();
+  *member = cached->second;
+  return true;
+}
+
+void MetadataCache::AddNamedMember(const NamedMemberKey &key,
+                                   const NamedMember &member) {
+  if (!enabled_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(named_members_mutex_);
+  if (named_members_.size() >= kMaximumCachedMetadataProps) {
+    named_members_.clear();
+  }
+  named_members_[key] = member;
+}
+
+template <typename Props>
+bool MetadataCache::StripedProps<Props>::Find(IMetaDataImport *metadata_import,
+                                              mdToken token, bool need_name,
+                                              Props *props) {
+  Stripe &stripe = GetStripe(token);
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+  const auto &cached = stripe.entries.find(Key(metadata_import, token));
+  if (cached == stripe.entries.end() ||
+      (need_name && !cached->second.has_name)) {
+    DebuggerMetrics::Global().metadata_cache_misses.Increment();
+    return false;
+  }
+  DebuggerMetrics::Global().metadata_cache_hits.Increment();
+  *props = cached->second;
+  return true;
+}
+
+template <typename Props>
+void MetadataCache::StripedProps<Props>::Add(IMetaDataImport *metadata_import,
+                                             mdToken token,
+                                             const Props &props) {
+  Stripe &stripe = GetStripe(token);
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+  if (stripe.entries.size() >= kMaximumCachedMetadataProps / kStripes) {
+    stripe.entries.clear();
+  }
+
+  // Properties read without the name do not replace ones with the name.
+  Props &cached = stripe.entries[Key(metadata_import, token)];
+  if (props.has_name || !cached.has_name) {
+    cached = props;
+  }
+}
+
+template <typename Props>
+void MetadataCache::StripedProps<Props>::Remove(
+    IMetaDataImport *metadata_import) {
+  for (Stripe &stripe : stripes_) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto entry = stripe.entries.lower_bound(Key(metadata_import, 0));
+    while (entry != stripe.entries.end() &&
+           entry->first.first == metadata_import) {
+      entry = stripe.entries.erase(entry);
+    }
+  }
+}
+
+template <typename Props>
+void MetadataCache::StripedProps<Props>::Clear() {
+  for (Stripe &stripe : stripes_) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.entries.clear();
+  }
+}
+
+}  // namespace google_cloud_debugger
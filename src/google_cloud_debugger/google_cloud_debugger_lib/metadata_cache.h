@@ -0,0 +1,261 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef METADATA_CACHE_H_
+#define METADATA_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "ccomptr.h"
+#include "cor.h"
+#include "cordebug.h"
+
+namespace google_cloud_debugger {
+
+// The properties of a method returned by IMetaDataImport::GetMethodProps.
+// The name is only set if has_name is true and includes the terminating
+// null character.
+struct MethodProps {
+  mdTypeDef class_token = 0;
+  bool has_name = false;
+  std::vector<WCHAR> name;
+  DWORD attributes = 0;
+  PCCOR_SIGNATURE signature = nullptr;
+  ULONG signature_length = 0;
+  ULONG virtual_address = 0;
+  DWORD impl_flags = 0;
+};
+
+// The properties of a type returned by IMetaDataImport::GetTypeDefProps.
+struct TypeProps {
+  bool has_name = false;
+  std::vector<WCHAR> name;
+  DWORD flags = 0;
+  mdToken extends = 0;
+};
+
+// The properties of a type reference returned by
+// IMetaDataImport::GetTypeRefProps.
+struct TypeRefProps {
+  mdToken resolution_scope = 0;
+  bool has_name = false;
+  std::vector<WCHAR> name;
+};
+
+// The properties of a field returned by IMetaDataImport::GetFieldProps.
+struct FieldProps {
+  mdTypeDef class_token = 0;
+  bool has_name = false;
+  std::vector<WCHAR> name;
+  DWORD attributes = 0;
+  PCCOR_SIGNATURE signature = nullptr;
+  ULONG signature_length = 0;
+  DWORD default_value_flags = 0;
+  UVCP_CONSTANT default_value = nullptr;
+  ULONG default_value_length = 0;
+};
+
+// Caches the IMetaDataImport of each module, the properties of methods,
+// types, type references and fields read from them and the fields and
+// properties of classes found by name. It also caches the type definitions
+// in other modules that type references resolve to, which are otherwise
+// found by searching every loaded module. Frame resolution, field lookups and
+// breakpoint hits on different threads read the same metadata, and every
+// read from IMetaDataImport is a COM call that copies the name into a
+// buffer sized by a first call. The properties are held in stripes keyed
+// by token, each with its own lock, so threads reading different tokens
+// do not wait for each other.
+//
+// The cache is disabled by default, in which case every method reads
+// straight from IMetaDataImport. The signatures and default values point
+// into the metadata of the module, so the entries of a module have to be
+// removed with RemoveModule when it is unloaded.
+class MetadataCache {
+ public:
+  MetadataCache() = default;
+  MetadataCache(const MetadataCache &) = delete;
+  MetadataCache &operator=(const MetadataCache &) = delete;
+
+  // Returns the cache of this debugger.
+  static MetadataCache &Global();
+
+  // Enables or disables the cache. Disabling it clears it.
+  void SetEnabled(bool enabled);
+
+  // Sets metadata_import to the cached import of debug_module and adds a
+  // reference to it. Returns false if the cache is disabled or the import
+  // of the module is not cached.
+  bool FindMetadataImport(ICorDebugModule *debug_module,
+                          IMetaDataImport **metadata_import);
+
+  // Caches metadata_import as the import of debug_module if the cache is
+  // enabled.
+  void AddMetadataImport(ICorDebugModule *debug_module,
+                         IMetaDataImport *metadata_import);
+
+  // Gets the properties of method_def, including its name if need_name is
+  // true. Returns the HRESULT of GetMethodProps.
+  HRESULT GetMethodProps(IMetaDataImport *metadata_import,
+                         mdMethodDef method_def, bool need_name,
+                         MethodProps *props);
+
+  // Gets the properties of type_def, including its name if need_name is
+  // true. A result of S_FALSE from GetTypeDefProps is returned as is.
+  HRESULT GetTypeProps(IMetaDataImport *metadata_import, mdTypeDef type_def,
+                       bool need_name, TypeProps *props);
+
+  // Gets the properties of type_ref, including its name if need_name is
+  // true. A result of S_FALSE from GetTypeRefProps is returned as is.
+  HRESULT GetTypeRefProps(IMetaDataImport *metadata_import,
+                          mdTypeRef type_ref, bool need_name,
+                          TypeRefProps *props);
+
+  // Gets the properties of field_def, including its name if need_name is
+  // true.
+  HRESULT GetFieldProps(IMetaDataImport *metadata_import,
+                        mdFieldDef field_def, bool need_name,
+                        FieldProps *props);
+
+  // Finds the field of class_token named name with FindField. Fields
+  // that are not found are cached as well, since expressions look up
+  // the backing field of a property after its name fails.
+  HRESULT FindField(IMetaDataImport *metadata_import, mdTypeDef class_token,
+                    const std::string &name, mdFieldDef *field_def);
+
+  // Sets property to the cached property of class_token named name, or
+  // to mdPropertyNil if the class is known not to have one. Returns false
+  // if neither is cached.
+  bool FindProperty(IMetaDataImport *metadata_import, mdTypeDef class_token,
+                    const std::string &name, mdProperty *property);
+
+  // Caches property, which may be mdPropertyNil, as the property of
+  // class_token named name.
+  void AddProperty(IMetaDataImport *metadata_import, mdTypeDef class_token,
+                   const std::string &name, mdProperty property);
+
+  // Sets type_def and type_def_metadata to the type definition type_ref
+  // of metadata_import resolved to before and adds a reference to the
+  // import. Returns false if the cache is disabled or the resolution is
+  // not cached.
+  bool FindResolvedTypeRef(IMetaDataImport *metadata_import,
+                           mdTypeRef type_ref, mdTypeDef *type_def,
+                           IMetaDataImport **type_def_metadata);
+
+  // Caches that type_ref of metadata_import resolves to type_def of
+  // type_def_metadata. The resolution is removed when either module is
+  // unloaded.
+  void AddResolvedTypeRef(IMetaDataImport *metadata_import,
+                          mdTypeRef type_ref, mdTypeDef type_def,
+                          IMetaDataImport *type_def_metadata);
+
+  // Removes the import of debug_module, the properties read from
+  // metadata_import, which is the import of the module, and the type
+  // references resolved from or to the module.
+  void RemoveModule(ICorDebugModule *debug_module,
+                    IMetaDataImport *metadata_import);
+
+  // Removes everything and releases the cached imports.
+  void Clear();
+
+ private:
+  // Number of stripes of each kind of properties.
+  static const std::size_t kStripes = 16;
+
+  // Holds the properties of one kind, keyed by import and token.
+  template <typename Props>
+  class StripedProps {
+   public:
+    // Copies the cached properties of token into props. Returns false if
+    // they are not cached or lack the name while need_name is true.
+    bool Find(IMetaDataImport *metadata_import, mdToken token,
+              bool need_name, Props *props);
+
+    void Add(IMetaDataImport *metadata_import, mdToken token,
+             const Props &props);
+
+    void Remove(IMetaDataImport *metadata_import);
+
+    void Clear();
+
+   private:
+    typedef std::pair<IMetaDataImport *, mdToken> Key;
+
+    struct Stripe {
+      std::mutex mutex;
+      std::map<Key, Props> entries;
+    };
+
+    // The low bits of a token are the row of the token, which spreads
+    // consecutive methods and types over the stripes.
+    Stripe &GetStripe(mdToken token) { return stripes_[token % kStripes]; }
+
+    std::array<Stripe, kStripes> stripes_;
+  };
+
+  // Keeps the module alive while its import is cached, so the address of
+  // the module is not reused by another one.
+  struct ModuleImport {
+    CComPtr<ICorDebugModule> debug_module;
+    CComPtr<IMetaDataImport> metadata_import;
+  };
+
+  // A field or property of a class found by name. The flag is true for
+  // properties.
+  typedef std::tuple<IMetaDataImport *, mdTypeDef, bool, std::string>
+      NamedMemberKey;
+
+  struct NamedMember {
+    HRESULT hr = S_OK;
+    mdToken token = 0;
+  };
+
+  // Looks up and caches named members if the cache is enabled.
+  bool FindNamedMember(const NamedMemberKey &key, NamedMember *member);
+  void AddNamedMember(const NamedMemberKey &key, const NamedMember &member);
+
+  // The type definition a type reference resolves to.
+  struct ResolvedTypeRef {
+    mdTypeDef type_def = 0;
+    CComPtr<IMetaDataImport> metadata_import;
+  };
+
+  std::atomic<bool> enabled_{false};
+
+  std::mutex imports_mutex_;
+  std::map<ICorDebugModule *, ModuleImport> imports_;
+
+  StripedProps<MethodProps> method_props_;
+  StripedProps<TypeProps> type_props_;
+  StripedProps<TypeRefProps> type_ref_props_;
+  StripedProps<FieldProps> field_props_;
+
+  std::mutex named_members_mutex_;
+  std::map<NamedMemberKey, NamedMember> named_members_;
+
+  std::mutex resolved_type_refs_mutex_;
+  std::map<std::pair<IMetaDataImport *, mdTypeRef>, ResolvedTypeRef>
+      resolved_type_refs_;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // METADATA_CACHE_H_
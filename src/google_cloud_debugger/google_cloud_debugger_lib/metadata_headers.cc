@@ -15,14 +15,32 @@
 #include "metadata_headers.h"
 
 #include <assert.h>
+#include <cstring>
 
 #include "custom_binary_reader.h"
 
 namespace google_cloud_debugger_portable_pdb {
 
 using std::array;
-using std::string;
-using std::vector;
+
+namespace {
+
+// The names of the streams of MetadataStreamKind, in the same order.
+const char *const kStreamNames[kNumberOfStreamKinds] = {
+    "#Strings", "#Blob", "#GUID", "#Pdb", "#~"};
+
+}  // namespace
+
+MetadataStreamKind GetMetadataStreamKind(const char *name,
+                                         std::size_t length) {
+  for (int kind = 0; kind < kNumberOfStreamKinds; ++kind) {
+    if (length == std::strlen(kStreamNames[kind]) &&
+        std::memcmp(name, kStreamNames[kind], length) == 0) {
+      return static_cast<MetadataStreamKind>(kind);
+    }
+  }
+  return kUnknownStream;
+}
 
 bool ParseFrom(CustomBinaryStream *binary_reader,
                MetadataRootHeader *root_header) {
@@ -53,18 +71,13 @@ bool ParseFrom(CustomBinaryStream *binary_reader,
     return false;
   }
 
-  vector<uint8_t> version_string_bytes(root_header->version_string_length, 0);
-
-  uint32_t bytes_read = 0;
-  if (!binary_reader->ReadBytes(version_string_bytes.data(),
-                                root_header->version_string_length,
-                                &bytes_read)) {
+  const uint8_t *version_string = nullptr;
+  if (!binary_reader->ReadSpan(root_header->version_string_length,
+                               &version_string)) {
     return false;
   }
-
-  string temp_vers_string(version_string_bytes.begin(),
-                          version_string_bytes.end());
-  root_header->version_string = temp_vers_string;
+  root_header->version_string =
+      reinterpret_cast<const char *>(version_string);
 
   // We have to advance to the next 4 byte boundary.
   uint32_t bytes_to_skipped = 4 - (root_header->version_string_length % 4);
@@ -96,22 +109,30 @@ bool ParseFrom(CustomBinaryStream *binary_reader, StreamHeader *stream_header) {
     return false;
   }
 
-  vector<uint8_t> header_name;
+  // The name is read in place: the characters are contiguous in the
+  // stream, so the first one is where the name starts.
+  const uint8_t *name = nullptr;
+  const uint8_t *character = nullptr;
   uint8_t bytes_read = 0;
-  uint8_t character;
-  while (binary_reader->ReadByte(&character)) {
+  while (binary_reader->ReadSpan(1, &character)) {
+    if (bytes_read == 0) {
+      name = character;
+    }
     ++bytes_read;
-    if (character == 0) {
+    if (*character == 0) {
       break;
     }
 
-    header_name.push_back(character);
     // Name cannot be longer than 32 characters.
     if (bytes_read > 32) {
       return false;
     }
   }
 
+  if (bytes_read == 0 || *character != 0) {
+    return false;
+  }
+
   // Pad until 4 boundary.
   uint32_t bytes_to_skipped = 4 - (bytes_read % 4);
   if (bytes_to_skipped % 4 != 0 &&
@@ -119,8 +140,10 @@ bool ParseFrom(CustomBinaryStream *binary_reader, StreamHeader *stream_header) {
     return false;
   }
 
-  string name_string(header_name.begin(), header_name.end());
-  stream_header->name = name_string;
+  stream_header->name = reinterpret_cast<const char *>(name);
+  stream_header->name_length = bytes_read - 1;
+  stream_header->kind =
+      GetMetadataStreamKind(stream_header->name, stream_header->name_length);
 
   return true;
 }
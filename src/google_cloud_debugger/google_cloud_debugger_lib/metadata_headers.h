@@ -17,8 +17,8 @@
 
 #include <array>
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
-#include <string>
 #include <vector>
 
 namespace google_cloud_debugger_portable_pdb {
@@ -53,7 +53,9 @@ struct MetadataRootHeader {
   std::uint32_t version_string_length = 0;
 
   // UTF8-encoded null-terminated version string of length m (from above).
-  std::string version_string;
+  // Points into the stream the header is parsed from and is only valid as
+  // long as that stream is.
+  const char *version_string = nullptr;
 
   // Reserved, always 0.
   std::uint16_t flags = 0;
@@ -62,6 +64,30 @@ struct MetadataRootHeader {
   std::uint16_t number_streams = 0;
 };
 
+// The streams of a metadata file that the debugger reads. The kind of a
+// stream is identified from its name once, when its header is parsed, so
+// looking a stream up afterwards is an index into an array of
+// kNumberOfStreamKinds slots instead of a string comparison per stream.
+enum MetadataStreamKind {
+  // "#Strings", the strings heap.
+  kStringsStream = 0,
+  // "#Blob", the blob heap.
+  kBlobStream,
+  // "#GUID", the GUID heap.
+  kGuidStream,
+  // "#Pdb", the PortablePdbMetadataSectionHeader.
+  kPdbStream,
+  // "#~", the compressed metadata tables.
+  kCompressedTablesStream,
+  kNumberOfStreamKinds,
+  // Any other stream.
+  kUnknownStream = kNumberOfStreamKinds
+};
+
+// Returns the kind of the stream whose name is the length characters at
+// name, or kUnknownStream if the debugger does not read it.
+MetadataStreamKind GetMetadataStreamKind(const char *name, std::size_t length);
+
 // Header for an individual data stream of a Metadata file.
 // II.24.2.2 Stream header
 struct StreamHeader {
@@ -73,8 +99,15 @@ struct StreamHeader {
 
   // Name of the stream as null-terminated variable length array of ASCII
   // characters, padded to the next 4-byte boundary with \0 characters.
-  // The name is limited to 32 characters.
-  std::string name;
+  // The name is limited to 32 characters. Points into the stream the
+  // header is parsed from and is only valid as long as that stream is.
+  const char *name = nullptr;
+
+  // Number of characters in name, not counting the null terminator.
+  std::uint8_t name_length = 0;
+
+  // The kind of the stream, identified from its name.
+  MetadataStreamKind kind = kUnknownStream;
 };
 
 // Header for a PortablePDB metadata section. (The #Pdb stream.)
@@ -15,6 +15,7 @@
 #include "metadata_tables.h"
 
 #include <assert.h>
+#include <cstring>
 
 #include "custom_binary_reader.h"
 #include "metadata_headers.h"
@@ -24,64 +25,135 @@ using std::vector;
 
 namespace google_cloud_debugger_portable_pdb {
 
-const string kSha1Guid = "ff1816ec-aa5e-4d10-87f7-6f4963833460";
-const string kSha256Guid = "8829d00f-11b8-4213-878b-770e8597ac16";
-
-const string kCSharpGuid = "3f5162f8-07c6-11d3-9053-00c04fa302a1";
-const string kVisualBasicGuid = "3a12d0b8-c26c-11d0-b442-00a0244a1dd2";
-const string kFSharpGuid = "ab4f38c9-b6e6-43ba-be3b-58080b2ccce3";
+const std::uint32_t kGuidSize = 16;
+
+// The GUIDs as they are stored in the GUID heap, where the first three
+// groups are little-endian.
+
+// ff1816ec-aa5e-4d10-87f7-6f4963833460
+const uint8_t kSha1Guid[] = {0xec, 0x16, 0x18, 0xff, 0x5e, 0xaa, 0x10, 0x4d,
+                             0x87, 0xf7, 0x6f, 0x49, 0x63, 0x83, 0x34, 0x60};
+// 8829d00f-11b8-4213-878b-770e8597ac16
+const uint8_t kSha256Guid[] = {0x0f, 0xd0, 0x29, 0x88, 0xb8, 0x11, 0x13, 0x42,
+                               0x87, 0x8b, 0x77, 0x0e, 0x85, 0x97, 0xac, 0x16};
+
+// 3f5162f8-07c6-11d3-9053-00c04fa302a1
+const uint8_t kCSharpGuid[] = {0xf8, 0x62, 0x51, 0x3f, 0xc6, 0x07, 0xd3, 0x11,
+                               0x90, 0x53, 0x00, 0xc0, 0x4f, 0xa3, 0x02, 0xa1};
+// 3a12d0b8-c26c-11d0-b442-00a0244a1dd2
+const uint8_t kVisualBasicGuid[] = {0xb8, 0xd0, 0x12, 0x3a, 0x6c, 0xc2,
+                                    0xd0, 0x11, 0xb4, 0x42, 0x00, 0xa0,
+                                    0x24, 0x4a, 0x1d, 0xd2};
+// ab4f38c9-b6e6-43ba-be3b-58080b2ccce3
+const uint8_t kFSharpGuid[] = {0xc9, 0x38, 0x4f, 0xab, 0xe6, 0xb6, 0xba, 0x43,
+                               0xbe, 0x3b, 0x58, 0x08, 0x0b, 0x2c, 0xcc, 0xe3};
 
 const std::uint32_t kDocumentChangeSequencePointLine = 0xFDDFDD;
 const std::uint32_t kHiddenSequencePointLine = 0xFEEFEE;
 
 const uint16_t kDebuggerHidden = 0x0001;
 
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               DocumentRow *document_table) {
-  assert(binary_reader != nullptr);
-  assert(document_table != nullptr);
+namespace {
 
-  if (!binary_reader->ReadTableIndex(Heap::BlobsHeap, header.heap_sizes,
-                                     &document_table->name)) {
-    return false;
+// Returns the index of width bytes at *row and advances *row past it.
+uint32_t ReadIndex(const uint8_t **row, uint8_t width) {
+  uint32_t result = 0;
+  if (width == 4) {
+    memcpy(&result, *row, 4);
+  } else {
+    uint16_t index;
+    memcpy(&index, *row, 2);
+    result = index;
   }
+  *row += width;
+  return result;
+}
 
-  if (!binary_reader->ReadTableIndex(Heap::GuidsHeap, header.heap_sizes,
-                                     &document_table->hash_algorithm)) {
-    return false;
-  }
+}  // namespace
 
-  if (!binary_reader->ReadTableIndex(Heap::BlobsHeap, header.heap_sizes,
-                                     &document_table->hash)) {
-    return false;
+uint8_t GetIndexSize(Heap heap, uint8_t heap_sizes) {
+  // The Heap enum also encodes the bit mask into the heapSize value.
+  return (heap & heap_sizes) != 0x0 ? 4 : 2;
+}
+
+uint8_t GetIndexSize(MetadataTable table,
+                     const CompressedMetadataTableHeader &header) {
+  if (!header.valid_mask[static_cast<int>(table)]) {
+    // WARNING: If you are reading a table index into a metadata table that
+    // isn't present, something is wrong.
+    //
+    // In practice, this happens when you only load the PDB metadata tables and
+    // not the primary assembly's too. Since the PDB doesn't contain the rest of
+    // the metadata. If the table happens to contain more than 2^16 entries, we
+    // will read the wrong number of bytes and TERRIBLE THINGS will happen since
+    // all future reads will be corrupt.
+    //
+    // BUG: Read assembly metadata (headers at least) in addition to PDB
+    // metadata. For now we assume everything is less than 2^16.
+    return 2;
+  }
+
+  uint32_t present_table_index = 0;
+  for (size_t index = 0; index < static_cast<int>(table); ++index) {
+    if (header.valid_mask[index]) {
+      ++present_table_index;
+    }
   }
 
-  if (!binary_reader->ReadTableIndex(Heap::GuidsHeap, header.heap_sizes,
-                                     &document_table->language)) {
-    return false;
+  // If the table has less than 2^16 rows then it is stored using 2 bytes.
+  // Otherwise, 4 bytes.
+  if (present_table_index >= header.num_rows.size() ||
+      header.num_rows[present_table_index] < 0x10000) {  // 2^16
+    return 2;
   }
+  return 4;
+}
 
-  return true;
+MetadataIndexSizes GetIndexSizes(const CompressedMetadataTableHeader &header) {
+  MetadataIndexSizes sizes;
+  sizes.strings_heap = GetIndexSize(Heap::StringsHeap, header.heap_sizes);
+  sizes.guids_heap = GetIndexSize(Heap::GuidsHeap, header.heap_sizes);
+  sizes.blobs_heap = GetIndexSize(Heap::BlobsHeap, header.heap_sizes);
+  sizes.method_table = GetIndexSize(MetadataTable::Method, header);
+  sizes.import_scope_table = GetIndexSize(MetadataTable::ImportScope, header);
+  sizes.local_variable_table =
+      GetIndexSize(MetadataTable::LocalVariable, header);
+  sizes.local_constant_table =
+      GetIndexSize(MetadataTable::LocalConstant, header);
+  return sizes;
 }
 
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               MethodDebugInformationRow *method_debug) {
-  assert(binary_reader != nullptr);
-  assert(method_debug != nullptr);
+template <>
+uint32_t GetRowSize<DocumentRow>(const MetadataIndexSizes &sizes) {
+  return 2 * sizes.blobs_heap + 2 * sizes.guids_heap;
+}
 
-  if (!binary_reader->ReadTableIndex(Heap::BlobsHeap, header.heap_sizes,
-                                     &method_debug->document)) {
-    return false;
-  }
+void DecodeRow(const uint8_t *row, const MetadataIndexSizes &sizes,
+               DocumentRow *result) {
+  assert(row != nullptr);
+  assert(result != nullptr);
 
-  if (!binary_reader->ReadTableIndex(Heap::BlobsHeap, header.heap_sizes,
-                                     &method_debug->sequence_points)) {
-    return false;
-  }
+  result->name = ReadIndex(&row, sizes.blobs_heap);
+  result->hash_algorithm = ReadIndex(&row, sizes.guids_heap);
+  result->hash = ReadIndex(&row, sizes.blobs_heap);
+  result->language = ReadIndex(&row, sizes.guids_heap);
+}
 
-  return true;
+// NOTE: Document is an index into the Document table, but it is read with
+// the width of a Blob heap index. Both are 2 bytes unless the PDB is large.
+template <>
+uint32_t GetRowSize<MethodDebugInformationRow>(
+    const MetadataIndexSizes &sizes) {
+  return 2 * sizes.blobs_heap;
+}
+
+void DecodeRow(const uint8_t *row, const MetadataIndexSizes &sizes,
+               MethodDebugInformationRow *result) {
+  assert(row != nullptr);
+  assert(result != nullptr);
+
+  result->document = ReadIndex(&row, sizes.blobs_heap);
+  result->sequence_points = ReadIndex(&row, sizes.blobs_heap);
 }
 
 bool IsDocumentChange(SequencePointRecord record) {
@@ -116,83 +188,55 @@ SequencePointRecord NewDocumentChangeSequencePoint(uint32_t document) {
   return step;
 }
 
-bool ParseFrom(uint32_t starting_document, CustomBinaryStream *binary_reader,
-               MethodSequencePointInformation *sequence_point_info) {
-  assert(binary_reader != nullptr);
-  assert(sequence_point_info != nullptr);
+namespace {
 
-  // Parse the header.
-  if (!binary_reader->ReadCompressedUInt32(
-          &sequence_point_info->stand_alone_signature)) {
-    return false;
-  }
+// Reads the compressed integers of a sequence point blob in order.
+class CompressedIntReader {
+ public:
+  explicit CompressedIntReader(const CompressedInts &ints) : ints_(ints) {}
 
-  // If the Document field of the MethodDebugInformation table is set, then the
-  // method is housed entirely in the same document. Otherwise, it spans
-  // multiple documents and we read the initial doc now. (And again in while
-  // parsing subsequent document-record entries.)
-  // TODO(quoct): When does this happen in practice? Obviously some tests are
-  // needed.
-  if (starting_document == 0) {
-    uint32_t initial_doc;
-    if (!binary_reader->ReadCompressedUInt32(&initial_doc)) {
+  // Returns true if there is a next integer.
+  bool HasNext() const { return next_ < ints_.values.size(); }
+
+  // Reads the next integer as an unsigned integer.
+  bool ReadUInt32(uint32_t *result) {
+    if (!HasNext()) {
       return false;
     }
-    sequence_point_info->records.push_back(
-        NewDocumentChangeSequencePoint(initial_doc));
-  }
-
-  SequencePointRecord first_record;
-  if (!ParseFirstRecord(binary_reader, &first_record)) {
-    return false;
-  }
-
-  SequencePointRecord last_non_hidden_record;
-  bool no_non_hidden_record_yet = true;
-
-  if (!IsHidden(first_record)) {
-    last_non_hidden_record = first_record;
-    no_non_hidden_record_yet = false;
+    *result = ints_.values[next_++];
+    return true;
   }
 
-  sequence_point_info->records.push_back(std::move(first_record));
-
-  while (binary_reader->HasNext()) {
-    SequencePointRecord next_record;
-    if (no_non_hidden_record_yet) {
-      if (!ParseNextRecord(binary_reader, nullptr, &next_record)) {
-        return false;
-      }
-    } else {
-      if (!ParseNextRecord(binary_reader, &last_non_hidden_record,
-                           &next_record)) {
-        return false;
-      }
-    }
-
-    if (!IsHidden(next_record)) {
-      last_non_hidden_record = next_record;
-      no_non_hidden_record_yet = false;
+  // Reads the next integer as a signed integer.
+  bool ReadSignedInt32(int32_t *result) {
+    if (!HasNext()) {
+      return false;
     }
-
-    sequence_point_info->records.push_back(std::move(next_record));
+    *result = ToCompressedSignedInt32(ints_.values[next_], ints_.sizes[next_]);
+    ++next_;
+    return true;
   }
 
-  return true;
-}
+ private:
+  const CompressedInts &ints_;
+
+  // Index of the next integer in ints_.
+  size_t next_ = 0;
+};
 
-bool ParseFirstRecord(CustomBinaryStream *binary_reader,
+// Parses the very first entity of a SequencePointBlob. May be a
+// sequence-point-record or a hidden-sequence-point-record.
+bool ParseFirstRecord(CompressedIntReader *reader,
                       SequencePointRecord *record) {
-  assert(binary_reader != nullptr);
+  assert(reader != nullptr);
   assert(record != nullptr);
 
   uint32_t il_delta;
   uint32_t delta_lines;
   uint32_t delta_cols;
 
-  if (!binary_reader->ReadCompressedUInt32(&il_delta) ||
-      !binary_reader->ReadCompressedUInt32(&delta_lines) ||
-      !binary_reader->ReadCompressedUInt32(&delta_cols)) {
+  if (!reader->ReadUInt32(&il_delta) || !reader->ReadUInt32(&delta_lines) ||
+      !reader->ReadUInt32(&delta_cols)) {
     return false;
   }
 
@@ -205,8 +249,7 @@ bool ParseFirstRecord(CustomBinaryStream *binary_reader,
   uint32_t start_line;
   uint32_t start_col;
   // Regular sequence-point-record.
-  if (!binary_reader->ReadCompressedUInt32(&start_line) ||
-      !binary_reader->ReadCompressedUInt32(&start_col)) {
+  if (!reader->ReadUInt32(&start_line) || !reader->ReadUInt32(&start_col)) {
     return false;
   }
 
@@ -219,17 +262,19 @@ bool ParseFirstRecord(CustomBinaryStream *binary_reader,
   return true;
 }
 
-bool ParseNextRecord(CustomBinaryStream *binary_reader,
+// Parses the next entity in the SequencePointBlob. May be a
+// sequence-point-record, hidden-sequence-point-record, or document-record.
+bool ParseNextRecord(CompressedIntReader *reader,
                      SequencePointRecord *last_non_hidden_record,
                      SequencePointRecord *record) {
-  assert(binary_reader != nullptr);
+  assert(reader != nullptr);
   assert(record != nullptr);
 
   uint32_t first_compressed_uint;
   uint32_t second_compressed_uint;
 
-  if (!binary_reader->ReadCompressedUInt32(&first_compressed_uint) ||
-      !binary_reader->ReadCompressedUInt32(&second_compressed_uint)) {
+  if (!reader->ReadUInt32(&first_compressed_uint) ||
+      !reader->ReadUInt32(&second_compressed_uint)) {
     return false;
   }
 
@@ -251,11 +296,11 @@ bool ParseNextRecord(CustomBinaryStream *binary_reader,
   bool delta_cols_unsigned = delta_lines == 0;
 
   if (delta_cols_unsigned) {
-    if (!binary_reader->ReadCompressedUInt32(&unsigned_delta_cols)) {
+    if (!reader->ReadUInt32(&unsigned_delta_cols)) {
       return false;
     }
   } else {
-    if (!binary_reader->ReadCompressSignedInt32(&signed_delta_cols)) {
+    if (!reader->ReadSignedInt32(&signed_delta_cols)) {
       return false;
     }
   }
@@ -272,15 +317,14 @@ bool ParseNextRecord(CustomBinaryStream *binary_reader,
   // The first non-hidden step has absolute line/col values. The rest are
   // relative.
   if (last_non_hidden_record == nullptr) {
-    if (!binary_reader->ReadCompressedUInt32(&start_line) ||
-        !binary_reader->ReadCompressedUInt32(&start_col)) {
+    if (!reader->ReadUInt32(&start_line) || !reader->ReadUInt32(&start_col)) {
       return false;
     }
   } else {
     int32_t delta_start_line;
     int32_t delta_start_column;
-    if (!binary_reader->ReadCompressSignedInt32(&delta_start_line) ||
-        !binary_reader->ReadCompressSignedInt32(&delta_start_column)) {
+    if (!reader->ReadSignedInt32(&delta_start_line) ||
+        !reader->ReadSignedInt32(&delta_start_column)) {
       return false;
     }
 
@@ -300,104 +344,147 @@ bool ParseNextRecord(CustomBinaryStream *binary_reader,
   return true;
 }
 
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               LocalScopeRow *local_scope) {
-  assert(binary_reader != nullptr);
-  assert(local_scope != nullptr);
+}  // namespace
 
-  if (!binary_reader->ReadTableIndex(MetadataTable::Method, header,
-                                     &local_scope->method_def)) {
+bool ParseFrom(uint32_t starting_document, const uint8_t *blob,
+               uint32_t blob_size,
+               MethodSequencePointInformation *sequence_point_info) {
+  assert(blob != nullptr || blob_size == 0);
+  assert(sequence_point_info != nullptr);
+
+  // The integers of the blob are decoded in one pass, then read as the
+  // records need them.
+  CompressedInts ints;
+  if (!DecodeCompressedInts(blob, blob_size, &ints)) {
     return false;
   }
+  CompressedIntReader reader(ints);
 
-  if (!binary_reader->ReadTableIndex(MetadataTable::ImportScope, header,
-                                     &local_scope->import_scope)) {
+  // Parse the header.
+  if (!reader.ReadUInt32(&sequence_point_info->stand_alone_signature)) {
     return false;
   }
 
-  if (!binary_reader->ReadTableIndex(MetadataTable::LocalVariable, header,
-                                     &local_scope->variable_list)) {
-    return false;
+  // If the Document field of the MethodDebugInformation table is set, then the
+  // method is housed entirely in the same document. Otherwise, it spans
+  // multiple documents and we read the initial doc now. (And again in while
+  // parsing subsequent document-record entries.)
+  // TODO(quoct): When does this happen in practice? Obviously some tests are
+  // needed.
+  if (starting_document == 0) {
+    uint32_t initial_doc;
+    if (!reader.ReadUInt32(&initial_doc)) {
+      return false;
+    }
+    sequence_point_info->records.push_back(
+        NewDocumentChangeSequencePoint(initial_doc));
   }
 
-  if (!binary_reader->ReadTableIndex(MetadataTable::LocalConstant, header,
-                                     &local_scope->constant_list)) {
+  SequencePointRecord first_record;
+  if (!ParseFirstRecord(&reader, &first_record)) {
     return false;
   }
 
-  if (!binary_reader->ReadUInt32(&local_scope->start_offset)) {
-    return false;
+  SequencePointRecord last_non_hidden_record;
+  bool no_non_hidden_record_yet = true;
+
+  if (!IsHidden(first_record)) {
+    last_non_hidden_record = first_record;
+    no_non_hidden_record_yet = false;
   }
 
-  if (!binary_reader->ReadUInt32(&local_scope->length)) {
-    return false;
+  sequence_point_info->records.push_back(std::move(first_record));
+
+  while (reader.HasNext()) {
+    SequencePointRecord next_record;
+    if (no_non_hidden_record_yet) {
+      if (!ParseNextRecord(&reader, nullptr, &next_record)) {
+        return false;
+      }
+    } else {
+      if (!ParseNextRecord(&reader, &last_non_hidden_record, &next_record)) {
+        return false;
+      }
+    }
+
+    if (!IsHidden(next_record)) {
+      last_non_hidden_record = next_record;
+      no_non_hidden_record_yet = false;
+    }
+
+    sequence_point_info->records.push_back(std::move(next_record));
   }
 
   return true;
 }
 
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               LocalVariableRow *variable_table) {
-  assert(binary_reader != nullptr);
-  assert(variable_table != nullptr);
+template <>
+uint32_t GetRowSize<LocalScopeRow>(const MetadataIndexSizes &sizes) {
+  return sizes.method_table + sizes.import_scope_table +
+         sizes.local_variable_table + sizes.local_constant_table + 2 * 4;
+}
 
-  if (!binary_reader->ReadUInt16(&variable_table->attributes)) {
-    return false;
-  }
+void DecodeRow(const uint8_t *row, const MetadataIndexSizes &sizes,
+               LocalScopeRow *result) {
+  assert(row != nullptr);
+  assert(result != nullptr);
+
+  result->method_def = ReadIndex(&row, sizes.method_table);
+  result->import_scope = ReadIndex(&row, sizes.import_scope_table);
+  result->variable_list = ReadIndex(&row, sizes.local_variable_table);
+  result->constant_list = ReadIndex(&row, sizes.local_constant_table);
+  result->start_offset = ReadIndex(&row, 4);
+  result->length = ReadIndex(&row, 4);
+}
 
-  if (!binary_reader->ReadUInt16(&variable_table->index)) {
-    return false;
-  }
+template <>
+uint32_t GetRowSize<LocalVariableRow>(const MetadataIndexSizes &sizes) {
+  return 2 * 2 + sizes.strings_heap;
+}
 
-  if (!binary_reader->ReadTableIndex(Heap::StringsHeap, header.heap_sizes,
-                                     &variable_table->name)) {
-    return false;
-  }
+void DecodeRow(const uint8_t *row, const MetadataIndexSizes &sizes,
+               LocalVariableRow *result) {
+  assert(row != nullptr);
+  assert(result != nullptr);
 
-  return true;
+  result->attributes = ReadIndex(&row, 2);
+  result->index = ReadIndex(&row, 2);
+  result->name = ReadIndex(&row, sizes.strings_heap);
 }
 
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               LocalConstantRow *local_constant) {
-  if (!binary_reader || !local_constant) {
-    return false;
-  }
-
-  if (!binary_reader->ReadTableIndex(Heap::StringsHeap, header.heap_sizes,
-                                     &local_constant->name)) {
-    return false;
-  }
+template <>
+uint32_t GetRowSize<LocalConstantRow>(const MetadataIndexSizes &sizes) {
+  return sizes.strings_heap + sizes.blobs_heap;
+}
 
-  if (!binary_reader->ReadTableIndex(Heap::BlobsHeap, header.heap_sizes,
-                                     &local_constant->signature)) {
-    return false;
-  }
+void DecodeRow(const uint8_t *row, const MetadataIndexSizes &sizes,
+               LocalConstantRow *result) {
+  assert(row != nullptr);
+  assert(result != nullptr);
 
-  return true;
+  result->name = ReadIndex(&row, sizes.strings_heap);
+  result->signature = ReadIndex(&row, sizes.blobs_heap);
 }
 
-const string &GetLanguageName(const string &guid) {
+const string &GetLanguageName(const uint8_t *guid) {
   static const string kCSharp = "C#";
   static const string kVBNet = "VB .NET";
   static const string kFSharp = "F#";
   static const string kUnknown = "Unknown";
 
-  if (guid == kCSharpGuid) return kCSharp;
-  if (guid == kVisualBasicGuid) return kVBNet;
-  if (guid == kFSharpGuid) return kFSharp;
+  if (memcmp(guid, kCSharpGuid, kGuidSize) == 0) return kCSharp;
+  if (memcmp(guid, kVisualBasicGuid, kGuidSize) == 0) return kVBNet;
+  if (memcmp(guid, kFSharpGuid, kGuidSize) == 0) return kFSharp;
   return kUnknown;
 }
 
-const string &GetHashAlgorithmName(const string &guid) {
+const string &GetHashAlgorithmName(const uint8_t *guid) {
   static const string kSha1 = "SHA-1";
   static const string kSha256 = "SHA-256";
   static const string kUnknown = "Unknown";
 
-  if (guid == kSha1Guid) return kSha1;
-  if (guid == kSha256Guid) return kSha256;
+  if (memcmp(guid, kSha1Guid, kGuidSize) == 0) return kSha1;
+  if (memcmp(guid, kSha256Guid, kGuidSize) == 0) return kSha256;
   return kUnknown;
 }
 
@@ -16,6 +16,7 @@
 #define METADATA_TABLES_H_
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -25,6 +26,12 @@ namespace google_cloud_debugger_portable_pdb {
 class CustomBinaryStream;
 struct CompressedMetadataTableHeader;
 
+enum Heap : std::uint8_t {
+  StringsHeap = 0x01,
+  GuidsHeap = 0x02,
+  BlobsHeap = 0x04
+};
+
 /// Metadata tables.
 /// II.22 Metadata logical format: tables
 enum MetadataTable {
@@ -213,57 +220,127 @@ struct LocalConstantRow {
   std::uint32_t signature;
 };
 
-// Parses the binary stream to get MethodDebugInformationRow object.
-// Returns true if it is a success.
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               MethodDebugInformationRow *method_debug);
+// Widths in bytes of the heap and table indices in the columns of the
+// PDB metadata tables. They only depend on the
+// CompressedMetadataTableHeader, so they are computed once per PDB.
+struct MetadataIndexSizes {
+  std::uint8_t strings_heap = 2;
+  std::uint8_t guids_heap = 2;
+  std::uint8_t blobs_heap = 2;
+  std::uint8_t method_table = 2;
+  std::uint8_t import_scope_table = 2;
+  std::uint8_t local_variable_table = 2;
+  std::uint8_t local_constant_table = 2;
+};
 
-// Parses the binary stream to get DocumentRow object.
-// Returns true if it is a success.
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
+// Returns the width of an index into heap according to II.24.2.6
+// "#~ stream", where heap_sizes is the bit vector of the header.
+std::uint8_t GetIndexSize(Heap heap, std::uint8_t heap_sizes);
+
+// Returns the width of an index into table according to II.24.2.6
+// "#~ stream".
+std::uint8_t GetIndexSize(MetadataTable table,
+                          const CompressedMetadataTableHeader &header);
+
+// Returns the widths of the indices used by the tables of header.
+MetadataIndexSizes GetIndexSizes(const CompressedMetadataTableHeader &header);
+
+// Returns the size in bytes of a row of the table of Row.
+template <typename Row>
+std::uint32_t GetRowSize(const MetadataIndexSizes &sizes);
+
+template <>
+std::uint32_t GetRowSize<DocumentRow>(const MetadataIndexSizes &sizes);
+template <>
+std::uint32_t GetRowSize<MethodDebugInformationRow>(
+    const MetadataIndexSizes &sizes);
+template <>
+std::uint32_t GetRowSize<LocalScopeRow>(const MetadataIndexSizes &sizes);
+template <>
+std::uint32_t GetRowSize<LocalVariableRow>(const MetadataIndexSizes &sizes);
+template <>
+std::uint32_t GetRowSize<LocalConstantRow>(const MetadataIndexSizes &sizes);
+
+// Decodes the columns of the row that starts at row. The row must
+// have GetRowSize<Row>(sizes) bytes.
+void DecodeRow(const std::uint8_t *row, const MetadataIndexSizes &sizes,
                DocumentRow *result);
-
-// Parses the binary stream to get LocalScopeRow object.
-// Returns true if it is a success.
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
+void DecodeRow(const std::uint8_t *row, const MetadataIndexSizes &sizes,
+               MethodDebugInformationRow *result);
+void DecodeRow(const std::uint8_t *row, const MetadataIndexSizes &sizes,
                LocalScopeRow *result);
+void DecodeRow(const std::uint8_t *row, const MetadataIndexSizes &sizes,
+               LocalVariableRow *result);
+void DecodeRow(const std::uint8_t *row, const MetadataIndexSizes &sizes,
+               LocalConstantRow *result);
+
+// Read only view of a metadata table whose rows are still encoded in
+// the content of the PDB. The row size is computed once, and the
+// columns of a row are decoded when the row is accessed, so the table
+// is never copied.
+//
+// Like the tables, the view is 1-indexed: size() is the number of rows
+// plus one, and index 0 (or any index out of range) is a zeroed out row.
+template <typename Row>
+class MetadataTableView {
+ public:
+  MetadataTableView() = default;
+
+  // rows points at the first of row_count rows, which must outlive
+  // this view.
+  MetadataTableView(const std::uint8_t *rows, std::uint32_t row_count,
+                    const MetadataIndexSizes &sizes)
+      : rows_(rows),
+        row_count_(row_count),
+        sizes_(sizes),
+        row_size_(GetRowSize<Row>(sizes)) {}
+
+  // Returns the number of rows plus one for the empty row 0.
+  std::size_t size() const { return row_count_ + 1; }
+
+  // Returns the size in bytes of a row.
+  std::uint32_t row_size() const { return row_size_; }
+
+  // Decodes the row at index.
+  Row operator[](std::size_t index) const {
+    Row row = Row();
+    if (index != 0 && index <= row_count_) {
+      DecodeRow(rows_ + (index - 1) * row_size_, sizes_, &row);
+    }
+    return row;
+  }
+
+ private:
+  // The first row of the table.
+  const std::uint8_t *rows_ = nullptr;
+
+  // The number of rows of the table, not counting row 0.
+  std::uint32_t row_count_ = 0;
+
+  // The widths of the indices in the columns.
+  MetadataIndexSizes sizes_;
+
+  // The size in bytes of a row.
+  std::uint32_t row_size_ = 0;
+};
 
-// Parses the binary stream to get LocalVariableRow object.
-// Returns true if it is a success.
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               LocalVariableRow *variable_table);
-
-// Parses the binary stream to get LocalConstantRow object.
-// Returns true if it is a success.
-bool ParseFrom(CustomBinaryStream *binary_reader,
-               const CompressedMetadataTableHeader &header,
-               LocalConstantRow *local_constant);
+// Size in bytes of a GUID in the GUID heap.
+extern const std::uint32_t kGuidSize;
 
-// Given a GUID, returns the appropriate language name.
-const std::string &GetLanguageName(const std::string &guid);
+// Given the kGuidSize bytes of a GUID, returns the appropriate language
+// name.
+const std::string &GetLanguageName(const std::uint8_t *guid);
 
-// Given a GUID, returns the appropriate hash algorithm name.
-const std::string &GetHashAlgorithmName(const std::string &guid);
+// Given the kGuidSize bytes of a GUID, returns the appropriate hash
+// algorithm name.
+const std::string &GetHashAlgorithmName(const std::uint8_t *guid);
 
-bool ParseFrom(std::uint32_t starting_document,
-               CustomBinaryStream *binary_reader,
+// Parses the blob_size bytes of the sequence points blob blob of a method
+// whose MethodDebugInformation row has document starting_document.
+bool ParseFrom(std::uint32_t starting_document, const std::uint8_t *blob,
+               std::uint32_t blob_size,
                MethodSequencePointInformation *sequence_point_info);
 
-// Parses the very first entity of a SequencePointBlob. May be a
-// sequence-point-record or a hidden-sequence-point-record.
-bool ParseFirstRecord(CustomBinaryStream *binary_reader,
-                      SequencePointRecord *record);
-
-// Parses the next entity in the SequencePointBlob. May be a
-// sequence-point-record, hidden-sequence-point-record, or document-record.
-bool ParseNextRecord(CustomBinaryStream *binary_reader,
-                     SequencePointRecord *last_non_hidden_step,
-                     SequencePointRecord *record);
-
 // Returns a SequencePointRecord that represents a hidden sequence point.
 SequencePointRecord NewHiddenSequencePoint(std::uint32_t il_delta);
 
@@ -18,12 +18,18 @@
 #include <queue>
 #include <vector>
 
+#include "constants.h"
 #include "dbg_stack_frame.h"
 #include "i_cor_debug_helper.h"
 #include "type_signature.h"
 
 namespace google_cloud_debugger {
 
+std::map<MethodInfo::ResolvedMethodKey, MethodInfo::ResolvedMethod>
+    MethodInfo::resolved_methods_;
+
+std::mutex MethodInfo::resolved_methods_mutex_;
+
 HRESULT MethodInfo::PopulateMethodDefFromNameAndArguments(
     IMetaDataImport *metadata_import,
     const mdTypeDef &class_token,
@@ -34,6 +40,20 @@ HRESULT MethodInfo::PopulateMethodDefFromNameAndArguments(
     return E_INVALIDARG;
   }
 
+  ResolvedMethodKey key(metadata_import, class_token,
+                        GetResolvedMethodKey(class_generic_types));
+  {
+    std::lock_guard<std::mutex> lock(resolved_methods_mutex_);
+    auto resolved = resolved_methods_.find(key);
+    if (resolved != resolved_methods_.end()) {
+      method_token = resolved->second.method_token;
+      is_static = resolved->second.is_static;
+      has_generic_types = resolved->second.has_generic_types;
+      returned_type = resolved->second.returned_type;
+      return S_OK;
+    }
+  }
+
   std::vector<mdMethodDef> method_defs;
   HRESULT hr = GetMethodDefsFromName(metadata_import, class_token,
                                      &method_defs, &std::cerr);
@@ -52,12 +72,51 @@ HRESULT MethodInfo::PopulateMethodDefFromNameAndArguments(
     if (FAILED(hr)) {
       continue;
     }
+
+    ResolvedMethod resolved;
+    resolved.method_token = method_token;
+    resolved.is_static = is_static;
+    resolved.has_generic_types = has_generic_types;
+    resolved.returned_type = returned_type;
+
+    std::lock_guard<std::mutex> lock(resolved_methods_mutex_);
+    if (resolved_methods_.size() >= kMaximumCachedResolvedMethods) {
+      resolved_methods_.clear();
+    }
+    resolved_methods_[key] = std::move(resolved);
     return hr;
   }
 
   return S_FALSE;
 }
 
+void MethodInfo::RemoveResolvedMethods(IMetaDataImport *metadata_import) {
+  std::lock_guard<std::mutex> lock(resolved_methods_mutex_);
+  auto resolved = resolved_methods_.lower_bound(
+      ResolvedMethodKey(metadata_import, 0, std::string()));
+  while (resolved != resolved_methods_.end() &&
+         std::get<0>(resolved->first) == metadata_import) {
+    resolved = resolved_methods_.erase(resolved);
+  }
+}
+
+std::string MethodInfo::GetResolvedMethodKey(
+    const std::vector<TypeSignature> &class_generic_types) const {
+  std::string key = method_name + "(";
+  for (size_t i = 0; i < argument_types.size(); ++i) {
+    if (i != 0) {
+      key += ",";
+    }
+    key += argument_types[i].GetKey();
+  }
+  key += ")";
+
+  for (auto &&generic_type : class_generic_types) {
+    key += ";" + generic_type.GetKey();
+  }
+  return key;
+}
+
 HRESULT MethodInfo::GetMethodDefsFromName(
     IMetaDataImport *metadata_import, const mdTypeDef &class_token,
     std::vector<mdMethodDef> *methods_matched, std::ostream *err_stream) {
@@ -15,7 +15,10 @@
 #ifndef METHOD_INFO_H_
 #define METHOD_INFO_H_
 
+#include <map>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "cor.h"
@@ -60,6 +63,8 @@ struct MethodInfo {
   // class_generic_types is needed to parse generic types
   // in the class. For example, if the class is Dictionary<string, int>
   // then class_generic_types should contain { string, int }.
+  // The methods found are cached across breakpoint hits, keyed by the
+  // class, the method name and the argument types.
   HRESULT PopulateMethodDefFromNameAndArguments(
       IMetaDataImport *metadata_import,
       const mdTypeDef &class_token,
@@ -67,7 +72,35 @@ struct MethodInfo {
       const std::vector<TypeSignature> &class_generic_types,
       ICorDebugHelper *debug_helper);
 
+  // Removes the cached methods of the classes of the module of
+  // metadata_import, which is being unloaded.
+  static void RemoveResolvedMethods(IMetaDataImport *metadata_import);
+
+  // Clears the cache of the methods found.
+  static void ClearResolvedMethods() {
+    std::lock_guard<std::mutex> lock(resolved_methods_mutex_);
+    resolved_methods_.clear();
+  }
+
  private:
+  // A class, identified by the IMetaDataImport of its module and its
+  // token, and the GetResolvedMethodKey of a method call on it.
+  typedef std::tuple<IMetaDataImport *, mdTypeDef, std::string>
+      ResolvedMethodKey;
+
+  // What PopulateMethodDefFromNameAndArguments finds about a method.
+  struct ResolvedMethod {
+    mdMethodDef method_token;
+    bool is_static;
+    bool has_generic_types;
+    TypeSignature returned_type;
+  };
+
+  // Returns the key of a call of method_name with argument_types on a
+  // class whose generic types are class_generic_types.
+  std::string GetResolvedMethodKey(
+      const std::vector<TypeSignature> &class_generic_types) const;
+
   // Helper function to find all methods that matches the name
   // method_name.
   HRESULT GetMethodDefsFromName(IMetaDataImport *metadata_import,
@@ -86,6 +119,13 @@ struct MethodInfo {
     DbgStackFrame *stack_frame,
     const std::vector<TypeSignature> &class_generic_types,
     ICorDebugHelper *debug_helper);
+
+  // Cache of the methods found by PopulateMethodDefFromNameAndArguments.
+  // It is cleared once it has kMaximumCachedResolvedMethods methods.
+  static std::map<ResolvedMethodKey, ResolvedMethod> resolved_methods_;
+
+  // Protects resolved_methods_.
+  static std::mutex resolved_methods_mutex_;
 };
 
 }  //  namespace google_cloud_debugger
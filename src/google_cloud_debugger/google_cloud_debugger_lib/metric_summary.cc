@@ -0,0 +1,115 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "metric_summary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace google_cloud_debugger {
+
+void MetricSummary::AddValue(double value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (hits_ == non_numeric_hits_) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  ++hits_;
+  sum_ += value;
+  ++buckets_[GetBucket(value)];
+}
+
+void MetricSummary::AddHit() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++hits_;
+  ++non_numeric_hits_;
+}
+
+std::size_t MetricSummary::GetBucket(double value) {
+  if (!(value >= 1)) {
+    return 0;
+  }
+
+  // value is in [2^(exponent-1), 2^exponent).
+  int exponent;
+  std::frexp(value, &exponent);
+  return std::min<std::size_t>(exponent, kMetricPointHistogramBuckets - 1);
+}
+
+bool MetricSummary::Flush(Clock::time_point now, Clock::duration interval,
+                          std::string *message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (hits_ == 0) {
+    return false;
+  }
+
+  if (start_ == Clock::time_point()) {
+    start_ = now;
+  }
+  if (now - start_ < interval) {
+    return false;
+  }
+
+  Format(message);
+  Clear();
+  return true;
+}
+
+void MetricSummary::Format(std::string *message) const {
+  std::ostringstream summary;
+  summary.precision(15);
+  std::uint64_t count = hits_ - non_numeric_hits_;
+  summary << "count=" << count;
+  if (count != 0) {
+    summary << " sum=" << sum_ << " min=" << min_ << " max=" << max_;
+    summary << " histogram=[";
+    bool first = true;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+      if (buckets_[i] == 0) {
+        continue;
+      }
+      if (!first) {
+        summary << ' ';
+      }
+      first = false;
+      if (i + 1 < buckets_.size()) {
+        summary << '<' << std::ldexp(1.0, static_cast<int>(i));
+      } else {
+        summary << ">=" << std::ldexp(1.0, static_cast<int>(i) - 1);
+      }
+      summary << ':' << buckets_[i];
+    }
+    summary << ']';
+  }
+  if (non_numeric_hits_ != 0) {
+    summary << " non_numeric=" << non_numeric_hits_;
+  }
+  *message = summary.str();
+}
+
+void MetricSummary::Clear() {
+  hits_ = 0;
+  non_numeric_hits_ = 0;
+  sum_ = 0;
+  min_ = 0;
+  max_ = 0;
+  buckets_.fill(0);
+  start_ = Clock::time_point();
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,89 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef METRIC_SUMMARY_H_
+#define METRIC_SUMMARY_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "constants.h"
+
+namespace google_cloud_debugger {
+
+// Aggregates the values of the hits of a metric point: their count, sum,
+// minimum, maximum and a histogram, so that a metric point writes one
+// summary every interval instead of a message for every hit.
+//
+// The histogram has kMetricPointHistogramBuckets buckets. The first one
+// counts the values below 1 and bucket i the values in [2^(i-1), 2^i),
+// except the last one, which counts every value from 2^(buckets - 2) up.
+//
+// Hits on different threads can add their values at the same time.
+class MetricSummary {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  MetricSummary() = default;
+  MetricSummary(const MetricSummary &) = delete;
+  MetricSummary &operator=(const MetricSummary &) = delete;
+
+  // Adds a hit whose expression has value.
+  void AddValue(double value);
+
+  // Adds a hit whose expression has no numeric value.
+  void AddHit();
+
+  // Returns the index of the histogram bucket that counts value.
+  static std::size_t GetBucket(double value);
+
+  // If interval passed since the first hit after the last flush, sets
+  // message to the summary of the hits since then, as in
+  // "count=3 sum=7 min=1 max=4 histogram=[<2:1 <4:1 <8:1]", and starts
+  // a new summary. Returns false and leaves message alone otherwise.
+  bool Flush(Clock::time_point now, Clock::duration interval,
+             std::string *message);
+
+ private:
+  // Formats the summary into message. Has to be called with mutex_ held.
+  void Format(std::string *message) const;
+
+  // Clears the summary. Has to be called with mutex_ held.
+  void Clear();
+
+  // The number of hits, and of hits without a numeric value.
+  std::uint64_t hits_ = 0;
+  std::uint64_t non_numeric_hits_ = 0;
+
+  // The sum, minimum and maximum of the numeric values.
+  double sum_ = 0;
+  double min_ = 0;
+  double max_ = 0;
+
+  // The number of numeric values in each bucket.
+  std::array<std::uint64_t, kMetricPointHistogramBuckets> buckets_{};
+
+  // When the first hit since the last flush was added.
+  Clock::time_point start_;
+
+  // Protects the summary.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  METRIC_SUMMARY_H_
@@ -0,0 +1,221 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "constants.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Variable;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Adds a variable named name with value value to variables.
+Variable *AddMetric(const string &name, std::uint64_t value,
+                    google::protobuf::RepeatedPtrField<Variable> *variables) {
+  Variable *variable = variables->Add();
+  variable->set_name(name);
+  variable->set_value(std::to_string(value));
+  return variable;
+}
+
+// Adds the count, sum, maximum and percentiles of histogram as the
+// members of a variable named name.
+void AddHistogram(const string &name, const LatencyHistogram &histogram,
+                  google::protobuf::RepeatedPtrField<Variable> *variables) {
+  Variable *variable = AddMetric(name, histogram.GetCount(), variables);
+  AddMetric("count", histogram.GetCount(), variable->mutable_members());
+  AddMetric("sum", histogram.GetSum(), variable->mutable_members());
+  AddMetric("max", histogram.GetMaximum(), variable->mutable_members());
+  AddMetric("p50", histogram.GetPercentile(50), variable->mutable_members());
+  AddMetric("p90", histogram.GetPercentile(90), variable->mutable_members());
+  AddMetric("p99", histogram.GetPercentile(99), variable->mutable_members());
+}
+
+}  // namespace
+
+const std::uint32_t LatencyHistogram::kSubBucketBits;
+const std::uint32_t LatencyHistogram::kSubBucketCount;
+const std::uint32_t LatencyHistogram::kMaximumValueBits;
+const std::uint64_t LatencyHistogram::kMaximumValue;
+const std::size_t LatencyHistogram::kBucketCount;
+
+void LatencyHistogram::Record(std::uint64_t value) {
+  value = std::min(value, kMaximumValue);
+  buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+
+  std::uint64_t maximum = maximum_.load(std::memory_order_relaxed);
+  while (value > maximum &&
+         !maximum_.compare_exchange_weak(maximum, value,
+                                         std::memory_order_relaxed)) {
+  }
+}
+
+void MetricDuration::SetSince(std::chrono::steady_clock::time_point start) {
+  std::chrono::steady_clock::duration elapsed =
+      std::chrono::steady_clock::now() - start;
+  value_.store(static_cast<std::uint64_t>(std::max<std::int64_t>(
+                   std::chrono::duration_cast<std::chrono::microseconds>(
+                       elapsed)
+                       .count(),
+                   0)),
+               std::memory_order_relaxed);
+}
+
+void StartupTimings::PopulateBreakpoint(Breakpoint *breakpoint) const {
+  breakpoint->Clear();
+  breakpoint->set_id(kReadyBreakpointId);
+
+  google::protobuf::RepeatedPtrField<Variable> *variables =
+      breakpoint->mutable_evaluated_expressions();
+  AddMetric("runtime_registration_us", runtime_registration_us.GetValue(),
+            variables);
+  AddMetric("module_enumeration_us", module_enumeration_us.GetValue(),
+            variables);
+  AddMetric("pdb_parsing_us", pdb_parsing_us.GetValue(), variables);
+  AddMetric("modules_enumerated", modules_enumerated.GetValue(), variables);
+  AddMetric("breakpoint_client_connection_us",
+            breakpoint_client_connection_us.GetValue(), variables);
+  AddMetric("total_us", total_us.GetValue(), variables);
+}
+
+void LatencyHistogram::RecordSince(
+    std::chrono::steady_clock::time_point start) {
+  std::chrono::steady_clock::duration elapsed =
+      std::chrono::steady_clock::now() - start;
+  Record(static_cast<std::uint64_t>(std::max<std::int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+      0)));
+}
+
+std::uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+  std::uint64_t count = GetCount();
+  if (count == 0) {
+    return 0;
+  }
+
+  // The rank of the value the percentile falls on, from 1 to count.
+  double clamped = std::min(std::max(percentile, 0.0), 100.0);
+  std::uint64_t rank = static_cast<std::uint64_t>(
+      std::ceil(clamped / 100 * static_cast<double>(count)));
+  rank = std::max<std::uint64_t>(rank, 1);
+
+  // Values recorded while the buckets are read may not be in count, so
+  // the largest value is returned if the buckets add up to less than it.
+  std::uint64_t maximum = GetMaximum();
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(GetBucketMaximum(i), maximum);
+    }
+  }
+  return maximum;
+}
+
+std::size_t LatencyHistogram::GetBucketIndex(std::uint64_t value) {
+  value = std::min(value, kMaximumValue);
+  if (value < kSubBucketCount) {
+    return static_cast<std::size_t>(value);
+  }
+
+  // Values from 2 ^ power to 2 ^ (power + 1) - 1 are split into
+  // kSubBucketCount buckets by their kSubBucketBits bits below the top one.
+  std::uint32_t power = kSubBucketBits;
+  while (value >> (power + 1)) {
+    ++power;
+  }
+  std::uint32_t shift = power - kSubBucketBits;
+  std::size_t sub_bucket = (value >> shift) & (kSubBucketCount - 1);
+  return kSubBucketCount * (shift + 1) + sub_bucket;
+}
+
+std::uint64_t LatencyHistogram::GetBucketMaximum(std::size_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+
+  std::uint32_t shift = static_cast<std::uint32_t>(index / kSubBucketCount) - 1;
+  std::uint64_t sub_bucket = index % kSubBucketCount;
+  return ((kSubBucketCount + sub_bucket + 1) << shift) - 1;
+}
+
+DebuggerMetrics &DebuggerMetrics::Global() {
+  static DebuggerMetrics metrics;
+  return metrics;
+}
+
+void DebuggerMetrics::PopulateBreakpoint(Breakpoint *breakpoint) const {
+  breakpoint->Clear();
+  breakpoint->set_id(kMetricsBreakpointId);
+
+  google::protobuf::RepeatedPtrField<Variable> *variables =
+      breakpoint->mutable_evaluated_expressions();
+  AddMetric("breakpoint_hits", breakpoint_hits.GetValue(), variables);
+  AddHistogram("breakpoint_stop_time_us", breakpoint_stop_time_us, variables);
+  AddMetric("conditions_prefiltered", conditions_prefiltered.GetValue(),
+            variables);
+  AddMetric("exceptions", exceptions.GetValue(), variables);
+  AddMetric("exception_point_hits", exception_point_hits.GetValue(),
+            variables);
+  AddMetric("func_evals", func_evals.GetValue(), variables);
+  AddMetric("func_eval_timeouts", func_eval_timeouts.GetValue(), variables);
+  AddHistogram("func_eval_time_us", func_eval_time_us, variables);
+  AddMetric("modules_loaded", modules_loaded.GetValue(), variables);
+  AddHistogram("module_load_time_us", module_load_time_us, variables);
+  AddMetric("modules_filtered", modules_filtered.GetValue(), variables);
+  AddMetric("pdbs_parsed", pdbs_parsed.GetValue(), variables);
+  AddHistogram("pdb_parse_time_us", pdb_parse_time_us, variables);
+  AddMetric("pdb_evictions", pdb_evictions.GetValue(), variables);
+  AddMetric("pdb_evicted_bytes", pdb_evicted_bytes.GetValue(), variables);
+  AddMetric("pdbs_fetched", pdbs_fetched.GetValue(), variables);
+  AddHistogram("pdb_fetch_time_us", pdb_fetch_time_us, variables);
+  AddMetric("breakpoint_updates", breakpoint_updates.GetValue(), variables);
+  AddHistogram("breakpoint_update_time_us", breakpoint_update_time_us,
+               variables);
+  AddMetric("breakpoint_activations_cancelled",
+            breakpoint_activations_cancelled.GetValue(), variables);
+  AddMetric("pipe_messages_read", pipe_messages_read.GetValue(), variables);
+  AddMetric("pipe_bytes_read", pipe_bytes_read.GetValue(), variables);
+  AddMetric("pipe_messages_written", pipe_messages_written.GetValue(),
+            variables);
+  AddMetric("pipe_bytes_written", pipe_bytes_written.GetValue(), variables);
+  AddHistogram("pipe_write_time_us", pipe_write_time_us, variables);
+  AddMetric("metadata_cache_hits", metadata_cache_hits.GetValue(), variables);
+  AddMetric("metadata_cache_misses", metadata_cache_misses.GetValue(),
+            variables);
+  AddMetric("pdb_table_bytes", pdb_table_bytes.GetValue(), variables);
+  AddMetric("pdb_heap_bytes", pdb_heap_bytes.GetValue(), variables);
+  AddMetric("pdb_document_index_bytes", pdb_document_index_bytes.GetValue(),
+            variables);
+  AddMetric("breakpoint_collection_bytes",
+            breakpoint_collection_bytes.GetValue(), variables);
+  AddMetric("static_member_cache_bytes", static_member_cache_bytes.GetValue(),
+            variables);
+  AddMetric("class_layout_cache_bytes", class_layout_cache_bytes.GetValue(),
+            variables);
+  AddMetric("type_dictionary_bytes", type_dictionary_bytes.GetValue(),
+            variables);
+}
+
+}  //  namespace google_cloud_debugger
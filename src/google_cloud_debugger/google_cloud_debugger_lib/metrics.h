@@ -0,0 +1,329 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// A count of events. Can be incremented from any thread without a lock.
+class MetricCounter {
+ public:
+  MetricCounter() = default;
+  MetricCounter(const MetricCounter &) = delete;
+  MetricCounter &operator=(const MetricCounter &) = delete;
+
+  // Adds count to the counter.
+  void Increment(std::uint64_t count = 1) {
+    value_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  // Returns the number of events counted so far.
+  std::uint64_t GetValue() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+// An amount of memory in bytes held by the debugger. Can be changed from
+// any thread without a lock.
+class MemoryGauge {
+ public:
+  MemoryGauge() = default;
+  MemoryGauge(const MemoryGauge &) = delete;
+  MemoryGauge &operator=(const MemoryGauge &) = delete;
+
+  // Adds bytes, which is negative when memory is released, to the gauge.
+  void Add(std::int64_t bytes) {
+    value_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  // Returns the number of bytes held.
+  std::uint64_t GetValue() const {
+    std::int64_t value = value_.load(std::memory_order_relaxed);
+    return value > 0 ? static_cast<std::uint64_t>(value) : 0;
+  }
+
+ private:
+  std::atomic<std::int64_t> value_{0};
+};
+
+// The bytes a data structure charges to a gauge. The charge is released
+// when it is destroyed, so a data structure that owns one as a member is
+// accounted for exactly as long as it lives. Not thread-safe: the owner
+// has to serialize the calls.
+class ScopedMemoryCharge {
+ public:
+  explicit ScopedMemoryCharge(MemoryGauge *gauge) : gauge_(gauge) {}
+  ScopedMemoryCharge(const ScopedMemoryCharge &) = delete;
+  ScopedMemoryCharge &operator=(const ScopedMemoryCharge &) = delete;
+
+  ~ScopedMemoryCharge() { Set(0); }
+
+  // Charges bytes to the gauge in place of the bytes charged so far.
+  void Set(std::size_t bytes) {
+    gauge_->Add(static_cast<std::int64_t>(bytes) -
+                static_cast<std::int64_t>(bytes_));
+    bytes_ = bytes;
+  }
+
+  // Charges bytes to the gauge on top of the bytes charged so far.
+  void Add(std::size_t bytes) { Set(bytes_ + bytes); }
+
+  // Returns the bytes charged.
+  std::size_t Get() const { return bytes_; }
+
+ private:
+  MemoryGauge *gauge_;
+  std::size_t bytes_ = 0;
+};
+
+// A distribution of latencies in microseconds. Like an HDR histogram,
+// each power of two is split into kSubBucketCount buckets of the same
+// width, so the values reported are within 1 / kSubBucketCount of the
+// values recorded. Values can be recorded from any thread without a lock.
+class LatencyHistogram {
+ public:
+  // Every power of two is split into 2 ^ kSubBucketBits buckets.
+  static const std::uint32_t kSubBucketBits = 4;
+  static const std::uint32_t kSubBucketCount = 1 << kSubBucketBits;
+
+  // Values are recorded up to 2 ^ kMaximumValueBits - 1 microseconds
+  // (about 12 days). Larger values are recorded as that.
+  static const std::uint32_t kMaximumValueBits = 40;
+  static const std::uint64_t kMaximumValue =
+      (static_cast<std::uint64_t>(1) << kMaximumValueBits) - 1;
+
+  static const std::size_t kBucketCount =
+      kSubBucketCount * (kMaximumValueBits - kSubBucketBits + 1);
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  // Records a latency of value microseconds.
+  void Record(std::uint64_t value);
+
+  // Records the time elapsed since start.
+  void RecordSince(std::chrono::steady_clock::time_point start);
+
+  // Returns the number of values recorded.
+  std::uint64_t GetCount() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the sum of the values recorded.
+  std::uint64_t GetSum() const { return sum_.load(std::memory_order_relaxed); }
+
+  // Returns the largest value recorded, or 0 if none is.
+  std::uint64_t GetMaximum() const {
+    return maximum_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the value below which percentile percent of the recorded
+  // values are, rounded up to the end of its bucket. Returns 0 if no
+  // value is recorded.
+  std::uint64_t GetPercentile(double percentile) const;
+
+  // Returns the index of the bucket value is recorded in.
+  static std::size_t GetBucketIndex(std::uint64_t value);
+
+  // Returns the largest value recorded in the bucket at index.
+  static std::uint64_t GetBucketMaximum(std::size_t index);
+
+ private:
+  std::atomic<std::uint64_t> buckets_[kBucketCount] = {};
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> sum_{0};
+  std::atomic<std::uint64_t> maximum_{0};
+};
+
+// Records the time between its creation and its destruction
+// in a histogram.
+class ScopedLatencyTimer {
+ public:
+  explicit ScopedLatencyTimer(LatencyHistogram *histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ScopedLatencyTimer(const ScopedLatencyTimer &) = delete;
+  ScopedLatencyTimer &operator=(const ScopedLatencyTimer &) = delete;
+
+  ~ScopedLatencyTimer() { histogram_->RecordSince(start_); }
+
+ private:
+  LatencyHistogram *histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// How long a phase that runs once took, in microseconds. Can be set and
+// read from any thread without a lock.
+class MetricDuration {
+ public:
+  MetricDuration() = default;
+  MetricDuration(const MetricDuration &) = delete;
+  MetricDuration &operator=(const MetricDuration &) = delete;
+
+  // Sets the duration to the time elapsed since start.
+  void SetSince(std::chrono::steady_clock::time_point start);
+
+  // Returns the duration, or 0 if it is not set.
+  std::uint64_t GetValue() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+// How long the phases of the startup of the debugger take. The debugger
+// reports them once, in the message with ID kReadyBreakpointId that tells
+// the agent the debugger is attached and connected to it.
+struct StartupTimings {
+  // Sets breakpoint to a message with ID kReadyBreakpointId whose
+  // evaluated expressions are the timings.
+  void PopulateBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) const;
+
+  // From StartDebugging until the debugger is attached to the runtime.
+  MetricDuration runtime_registration_us;
+
+  // Enumerating and registering the modules the application had loaded
+  // when the debugger attached, and parsing their PDB files. Not set
+  // without --preload-modules.
+  MetricDuration module_enumeration_us;
+  MetricDuration pdb_parsing_us;
+  MetricCounter modules_enumerated;
+
+  // Connecting to the agent to read breakpoints.
+  MetricDuration breakpoint_client_connection_us;
+
+  // From StartDebugging until the debugger is ready.
+  MetricDuration total_us;
+
+  // When StartDebugging is called. Set before the other phases start.
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+};
+
+// What the debugger measures about itself. The debugger records into
+// the instance returned by Global and reports it to the agent every
+// --metrics-interval-ms milliseconds.
+struct DebuggerMetrics {
+  // Returns the metrics of this debugger.
+  static DebuggerMetrics &Global();
+
+  // Sets breakpoint to a message with ID kMetricsBreakpointId whose
+  // evaluated expressions are the metrics. A histogram is a variable
+  // whose members are its count, sum, maximum and percentiles.
+  void PopulateBreakpoint(
+      google::cloud::diagnostics::debug::Breakpoint *breakpoint) const;
+
+  // Breakpoint callbacks and how long they keep the debuggee thread
+  // stopped.
+  MetricCounter breakpoint_hits;
+  LatencyHistogram breakpoint_stop_time_us;
+
+  // Hits of breakpoints rejected by the pre-filter of their conditions
+  // before they are processed.
+  MetricCounter conditions_prefiltered;
+
+  // Exception callbacks, and the ones that hit an exception point.
+  MetricCounter exceptions;
+  MetricCounter exception_point_hits;
+
+  // Function evaluations made while breakpoints are evaluated, how long
+  // they take and how many of them are aborted after timing out.
+  MetricCounter func_evals;
+  MetricCounter func_eval_timeouts;
+  LatencyHistogram func_eval_time_us;
+
+  // Modules loaded and how long LoadModule takes.
+  MetricCounter modules_loaded;
+  LatencyHistogram module_load_time_us;
+
+  // Modules loaded whose PDB files are not parsed in the background
+  // because of the ModuleFilter.
+  MetricCounter modules_filtered;
+
+  // PDB files parsed and how long parsing each of them takes.
+  MetricCounter pdbs_parsed;
+  LatencyHistogram pdb_parse_time_us;
+
+  // PDB files whose parsed methods PdbMemoryLimiter evicted, and the
+  // bytes it freed.
+  MetricCounter pdb_evictions;
+  MetricCounter pdb_evicted_bytes;
+
+  // PDB files downloaded from the symbol server and how long each
+  // download takes, including the failed ones.
+  MetricCounter pdbs_fetched;
+  LatencyHistogram pdb_fetch_time_us;
+
+  // Breakpoints read from the agent and how long it takes to activate
+  // or deactivate them.
+  MetricCounter breakpoint_updates;
+  LatencyHistogram breakpoint_update_time_us;
+
+  // Queued activations that a deactivation or a newer version of the
+  // breakpoint read from the agent replaced before they were applied.
+  MetricCounter breakpoint_activations_cancelled;
+
+  // Messages and bytes read from and written to the agent, and how long
+  // each write to the pipe takes.
+  MetricCounter pipe_messages_read;
+  MetricCounter pipe_bytes_read;
+  MetricCounter pipe_messages_written;
+  MetricCounter pipe_bytes_written;
+  LatencyHistogram pipe_write_time_us;
+
+  // Lookups of the properties of methods, types and members in the
+  // MetadataCache that are found in it and that read the metadata.
+  MetricCounter metadata_cache_hits;
+  MetricCounter metadata_cache_misses;
+
+  // Bytes held by the parsed PDB files: their metadata tables, the file
+  // contents their heaps are read from and their document indices with
+  // the methods parsed from them.
+  MemoryGauge pdb_table_bytes;
+  MemoryGauge pdb_heap_bytes;
+  MemoryGauge pdb_document_index_bytes;
+
+  // Bytes held by the breakpoints set, pending and synced with the agent.
+  MemoryGauge breakpoint_collection_bytes;
+
+  // Bytes held by the caches of static class members of every thread and
+  // of the metadata of the members of classes.
+  MemoryGauge static_member_cache_bytes;
+  MemoryGauge class_layout_cache_bytes;
+
+  // Bytes held by the dictionaries of the types of the modules.
+  MemoryGauge type_dictionary_bytes;
+
+  // How long the startup of the debugger takes. Not reported with the
+  // other metrics.
+  StartupTimings startup;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  METRICS_H_
@@ -0,0 +1,158 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "module_filter.h"
+
+#include <cctype>
+#include <fstream>
+#include <utility>
+
+#include "constants.h"
+#include "embedded_pdb.h"
+#include "memory_mapped_file.h"
+
+using google_cloud_debugger_portable_pdb::EmbeddedPdb;
+using google_cloud_debugger_portable_pdb::MemoryMappedFile;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+// Returns the part of path after its last directory separator.
+static string GetFileName(const string &path) {
+  size_t separator = path.find_last_of("/\\");
+  if (separator == string::npos) {
+    return path;
+  }
+  return path.substr(separator + 1);
+}
+
+// Returns true if the module at module_path has a PDB embedded in it or a
+// PDB file next to it, where PortablePdbFile::ParsePdbFile looks for them.
+static bool HasPdbFile(const string &module_path) {
+  if (module_path.size() < kDllExtension.size() ||
+      module_path.compare(module_path.size() - kDllExtension.size(),
+                          kDllExtension.size(), kDllExtension) != 0) {
+    return false;
+  }
+
+  MemoryMappedFile module;
+  EmbeddedPdb embedded_pdb;
+  if (module.Open(module_path) &&
+      embedded_pdb.Find(module.GetData(), module.GetSize())) {
+    return true;
+  }
+
+  string pdb_path =
+      module_path.substr(0, module_path.size() - kDllExtension.size()) +
+      kPdbExtension;
+  std::ifstream pdb_file(pdb_path);
+  return pdb_file.good();
+}
+
+bool ModuleFilter::SetIncludePatterns(const string &patterns) {
+  return ParsePatterns(patterns, &include_patterns_);
+}
+
+bool ModuleFilter::SetExcludePatterns(const string &patterns) {
+  return ParsePatterns(patterns, &exclude_patterns_);
+}
+
+bool ModuleFilter::ShouldParse(const string &module_path) const {
+  string file_name = GetFileName(module_path);
+  bool included = include_patterns_.empty();
+  for (const string &pattern : include_patterns_) {
+    if (Matches(pattern, file_name)) {
+      included = true;
+      break;
+    }
+  }
+  if (!included) {
+    return false;
+  }
+
+  for (const string &pattern : exclude_patterns_) {
+    if (Matches(pattern, file_name)) {
+      return false;
+    }
+  }
+
+  return !require_pdb_file_ || HasPdbFile(module_path);
+}
+
+bool ModuleFilter::Matches(const string &pattern, const string &name) {
+  // Position after the last '*' seen in pattern and the position in name
+  // it is matched up to, to backtrack to when the rest does not match.
+  size_t star = string::npos;
+  size_t star_match = 0;
+  size_t p = 0;
+  size_t n = 0;
+  while (n < name.size()) {
+    if (p < pattern.size() && pattern[p] == '*') {
+      star = ++p;
+      star_match = n;
+    } else if (p < pattern.size() &&
+               (pattern[p] == '?' ||
+                tolower(static_cast<unsigned char>(pattern[p])) ==
+                    tolower(static_cast<unsigned char>(name[n])))) {
+      ++p;
+      ++n;
+    } else if (star != string::npos) {
+      p = star;
+      n = ++star_match;
+    } else {
+      return false;
+    }
+  }
+
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+bool ModuleFilter::ParsePatterns(const string &patterns,
+                                 vector<string> *result) {
+  vector<string> parsed;
+  size_t position = 0;
+  while (position <= patterns.size()) {
+    size_t end = patterns.find(',', position);
+    if (end == string::npos) {
+      end = patterns.size();
+    }
+
+    size_t first = position;
+    while (first < end &&
+           isspace(static_cast<unsigned char>(patterns[first]))) {
+      ++first;
+    }
+    size_t last = end;
+    while (last > first &&
+           isspace(static_cast<unsigned char>(patterns[last - 1]))) {
+      --last;
+    }
+    if (first == last) {
+      return false;
+    }
+
+    parsed.push_back(patterns.substr(first, last - first));
+    position = end + 1;
+  }
+
+  *result = std::move(parsed);
+  return true;
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,76 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef MODULE_FILTER_H_
+#define MODULE_FILTER_H_
+
+#include <string>
+#include <vector>
+
+namespace google_cloud_debugger {
+
+// Decides which loaded modules have their PDB files parsed as soon as
+// they are loaded. The other modules, for example System.* and NuGet
+// packages, are only tracked by name: their PDB files are parsed when a
+// breakpoint is not found in any other module, or when a stack frame of
+// the module is captured.
+//
+// A module is parsed when its file name matches an include pattern (or
+// there are none), does not match an exclude pattern and, if required,
+// has a PDB embedded in it or a PDB file next to it. Patterns are
+// matched case-insensitively and can have '*', which matches any
+// characters, and '?', which matches one.
+class ModuleFilter {
+ public:
+  // Sets the include patterns to patterns, which are separated by
+  // commas. Returns false if any of the patterns is empty.
+  bool SetIncludePatterns(const std::string &patterns);
+
+  // Sets the exclude patterns to patterns, which are separated by
+  // commas. Returns false if any of the patterns is empty.
+  bool SetExcludePatterns(const std::string &patterns);
+
+  // Sets whether only the modules with an embedded PDB or a PDB file
+  // next to them are parsed.
+  void SetRequirePdbFile(bool require_pdb_file) {
+    require_pdb_file_ = require_pdb_file;
+  }
+
+  // Returns true if the PDB file of the module at module_path is parsed
+  // as soon as the module is loaded.
+  bool ShouldParse(const std::string &module_path) const;
+
+  // Returns true if name matches pattern.
+  static bool Matches(const std::string &pattern, const std::string &name);
+
+ private:
+  // Splits patterns at commas into result. Returns false if any of them
+  // is empty.
+  static bool ParsePatterns(const std::string &patterns,
+                            std::vector<std::string> *result);
+
+  // Patterns of the file names of the modules that are parsed.
+  std::vector<std::string> include_patterns_;
+
+  // Patterns of the file names of the modules that are not parsed.
+  std::vector<std::string> exclude_patterns_;
+
+  // True if only the modules with a PDB file are parsed.
+  bool require_pdb_file_ = false;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // MODULE_FILTER_H_
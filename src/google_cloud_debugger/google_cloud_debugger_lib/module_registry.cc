@@ -0,0 +1,138 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "module_registry.h"
+
+#include <algorithm>
+
+using google_cloud_debugger_portable_pdb::IPortablePdbFile;
+using std::shared_ptr;
+
+namespace google_cloud_debugger {
+
+shared_ptr<IPortablePdbFile> ModuleSnapshot::FindByBaseAddress(
+    CORDB_ADDRESS module_base_address) const {
+  auto pdb_file = pdb_by_base_address.find(module_base_address);
+  if (pdb_file == pdb_by_base_address.end()) {
+    return nullptr;
+  }
+  return pdb_file->second;
+}
+
+shared_ptr<IPortablePdbFile> ModuleSnapshot::FindByMetaDataImport(
+    IMetaDataImport *metadata_import) const {
+  auto pdb_file = pdb_by_metadata_import.find(metadata_import);
+  if (pdb_file == pdb_by_metadata_import.end()) {
+    return nullptr;
+  }
+  return pdb_file->second;
+}
+
+std::vector<shared_ptr<IPortablePdbFile>>
+ModuleSnapshot::GetBreakpointSearchOrder() const {
+  std::vector<shared_ptr<IPortablePdbFile>> search_order(pdb_files);
+  if (!filtered_pdb_files.empty()) {
+    std::stable_partition(search_order.begin(), search_order.end(),
+                          [this](const shared_ptr<IPortablePdbFile> &pdb_file) {
+                            return filtered_pdb_files.count(pdb_file.get()) ==
+                                   0;
+                          });
+  }
+  return search_order;
+}
+
+shared_ptr<const ModuleSnapshot> ModuleRegistry::CreateEmptySnapshot() {
+  shared_ptr<ModuleSnapshot> snapshot = std::make_shared<ModuleSnapshot>();
+  snapshot->class_names = std::make_shared<ClassNameIndex>();
+  return snapshot;
+}
+
+HRESULT ModuleRegistry::AddModule(shared_ptr<IPortablePdbFile> pdb_file,
+                                  CORDB_ADDRESS module_base_address,
+                                  bool filtered) {
+  if (!pdb_file) {
+    return E_INVALIDARG;
+  }
+
+  CComPtr<IMetaDataImport> metadata_import;
+  HRESULT hr = pdb_file->GetMetaDataImport(&metadata_import);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  shared_ptr<const ModuleSnapshot> current = GetSnapshot();
+  if (current->FindByBaseAddress(module_base_address)) {
+    return S_FALSE;
+  }
+
+  shared_ptr<ModuleSnapshot> snapshot(new (std::nothrow)
+                                          ModuleSnapshot(*current));
+  if (!snapshot) {
+    return E_OUTOFMEMORY;
+  }
+
+  if (metadata_import) {
+    snapshot->pdb_by_metadata_import[metadata_import] = pdb_file;
+  }
+  if (filtered) {
+    snapshot->filtered_pdb_files.insert(pdb_file.get());
+  }
+  snapshot->class_names->AddModule(pdb_file);
+  snapshot->pdb_files.push_back(pdb_file);
+  snapshot->pdb_by_base_address[module_base_address] = std::move(pdb_file);
+  std::atomic_store(&snapshot_,
+                    shared_ptr<const ModuleSnapshot>(std::move(snapshot)));
+  return S_OK;
+}
+
+HRESULT ModuleRegistry::RemoveModule(CORDB_ADDRESS module_base_address,
+                                     shared_ptr<IPortablePdbFile> *pdb_file) {
+  if (!pdb_file) {
+    return E_INVALIDARG;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  shared_ptr<const ModuleSnapshot> current = GetSnapshot();
+  *pdb_file = current->FindByBaseAddress(module_base_address);
+  if (!*pdb_file) {
+    return S_FALSE;
+  }
+
+  shared_ptr<ModuleSnapshot> snapshot(new (std::nothrow)
+                                          ModuleSnapshot(*current));
+  if (!snapshot) {
+    return E_OUTOFMEMORY;
+  }
+
+  snapshot->class_names->RemoveModule(*pdb_file);
+  snapshot->pdb_by_base_address.erase(module_base_address);
+  snapshot->filtered_pdb_files.erase(pdb_file->get());
+  for (auto it = snapshot->pdb_by_metadata_import.begin();
+       it != snapshot->pdb_by_metadata_import.end();) {
+    if (it->second == *pdb_file) {
+      it = snapshot->pdb_by_metadata_import.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  snapshot->pdb_files.erase(std::remove(snapshot->pdb_files.begin(),
+                                        snapshot->pdb_files.end(), *pdb_file),
+                            snapshot->pdb_files.end());
+  std::atomic_store(&snapshot_,
+                    shared_ptr<const ModuleSnapshot>(std::move(snapshot)));
+  return S_OK;
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,122 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MODULE_REGISTRY_H_
+#define MODULE_REGISTRY_H_
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cor.h"
+#include "class_name_index.h"
+#include "cordebug.h"
+#include "i_portable_pdb_file.h"
+
+namespace google_cloud_debugger {
+
+// The PDB files of the modules loaded at some point. A snapshot is never
+// modified once it is published, so it can be used without a lock for as
+// long as it is held.
+struct ModuleSnapshot {
+  // The PDB files in the order their modules were loaded.
+  std::vector<
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+      pdb_files;
+
+  // The PDB files keyed by the base address of their module.
+  std::unordered_map<
+      CORDB_ADDRESS,
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+      pdb_by_base_address;
+
+  // The PDB files keyed by the IMetaDataImport of their module. The PDB
+  // files hold a reference to it, so a pointer is not reused while it
+  // is in the snapshot.
+  std::unordered_map<
+      IMetaDataImport *,
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+      pdb_by_metadata_import;
+
+  // The PDB files that are not parsed when their module is loaded (see
+  // ModuleFilter). Breakpoints are searched for in them last.
+  std::unordered_set<
+      const google_cloud_debugger_portable_pdb::IPortablePdbFile *>
+      filtered_pdb_files;
+
+  // Index of the types defined in the modules. It is shared by all the
+  // snapshots of a registry and synchronizes itself.
+  std::shared_ptr<ClassNameIndex> class_names;
+
+  // Returns the PDB file of the module loaded at module_base_address, or
+  // null if there is none.
+  std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+  FindByBaseAddress(CORDB_ADDRESS module_base_address) const;
+
+  // Returns the PDB file of the module whose metadata is metadata_import,
+  // or null if there is none.
+  std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+  FindByMetaDataImport(IMetaDataImport *metadata_import) const;
+
+  // Returns the PDB files in the order breakpoints are searched for in
+  // them: in load order, with the ones in filtered_pdb_files last.
+  std::vector<
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+  GetBreakpointSearchOrder() const;
+};
+
+// Keeps the PDB files of the loaded modules. Modules are added and
+// removed by the debugger callbacks while breakpoint hits read them, so
+// every change publishes a new ModuleSnapshot. Readers take a reference
+// to the current snapshot instead of copying the PDB files.
+class ModuleRegistry {
+ public:
+  // Returns the current snapshot. This does not take any locks.
+  std::shared_ptr<const ModuleSnapshot> GetSnapshot() const {
+    return std::atomic_load(&snapshot_);
+  }
+
+  // Adds pdb_file of the module loaded at module_base_address. If
+  // filtered is true, the PDB file is added to filtered_pdb_files.
+  // Returns S_FALSE and keeps the registered PDB file if a module is
+  // already registered at module_base_address.
+  HRESULT AddModule(
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+          pdb_file,
+      CORDB_ADDRESS module_base_address, bool filtered = false);
+
+  // Removes the PDB file of the module loaded at module_base_address and
+  // stores it in pdb_file. Returns S_FALSE if there is none.
+  HRESULT RemoveModule(
+      CORDB_ADDRESS module_base_address,
+      std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+          *pdb_file);
+
+ private:
+  // Returns a snapshot without modules and with an empty class name index.
+  static std::shared_ptr<const ModuleSnapshot> CreateEmptySnapshot();
+
+  // The current snapshot. Only accessed through GetSnapshot and by
+  // writers holding mutex_.
+  std::shared_ptr<const ModuleSnapshot> snapshot_ = CreateEmptySnapshot();
+
+  // Serializes the writers of snapshot_.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  MODULE_REGISTRY_H_
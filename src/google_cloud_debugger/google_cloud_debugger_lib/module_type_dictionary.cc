@@ -0,0 +1,142 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "module_type_dictionary.h"
+
+#include <iostream>
+#include <vector>
+
+#include "i_cor_debug_helper.h"
+#include "memory_usage.h"
+
+using std::cerr;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+HRESULT ModuleTypeDictionary::Populate(IMetaDataImport *metadata_import,
+                                       ICorDebugHelper *debug_helper) {
+  if (!metadata_import || !debug_helper) {
+    return E_INVALIDARG;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (populated_) {
+    return S_OK;
+  }
+
+  HCORENUM cor_enum = nullptr;
+  HRESULT hr = S_OK;
+  vector<mdTypeDef> type_defs(100, 0);
+  while (hr == S_OK) {
+    ULONG type_defs_returned = 0;
+    hr = metadata_import->EnumTypeDefs(&cor_enum, type_defs.data(),
+                                       type_defs.size(), &type_defs_returned);
+    if (FAILED(hr)) {
+      cerr << "Failed to get enumerate types with hr: " << std::hex << hr;
+      metadata_import->CloseEnum(cor_enum);
+      type_def_dict_.clear();
+      return hr;
+    }
+
+    // No type defs.
+    if (type_defs_returned == 0) {
+      break;
+    }
+    type_defs.resize(type_defs_returned);
+
+    for (auto const &type_def_token : type_defs) {
+      std::string type_name;
+      mdToken base_token;
+      HRESULT name_hr = debug_helper->GetTypeNameFromMdTypeDef(
+          type_def_token, metadata_import, &type_name, &base_token, &cerr);
+      if (FAILED(name_hr)) {
+        continue;
+      }
+      type_def_dict_[type_name] = type_def_token;
+    }
+  }
+
+  metadata_import->CloseEnum(cor_enum);
+  cor_enum = nullptr;
+
+  hr = S_OK;
+  vector<mdTypeRef> type_refs(100, 0);
+  while (hr == S_OK) {
+    ULONG type_refs_returned = 0;
+    hr = metadata_import->EnumTypeRefs(&cor_enum, type_refs.data(),
+                                       type_refs.size(), &type_refs_returned);
+    if (FAILED(hr)) {
+      cerr << "Failed to get enumerate types with hr: " << std::hex << hr;
+      metadata_import->CloseEnum(cor_enum);
+      type_def_dict_.clear();
+      type_ref_dict_.clear();
+      return hr;
+    }
+
+    // No type refs.
+    if (type_refs_returned == 0) {
+      break;
+    }
+    type_refs.resize(type_refs_returned);
+
+    for (auto const &type_ref_token : type_refs) {
+      std::string type_name;
+      HRESULT name_hr = debug_helper->GetTypeNameFromMdTypeRef(
+          type_ref_token, metadata_import, &type_name, &cerr);
+      if (FAILED(name_hr)) {
+        continue;
+      }
+      type_ref_dict_[type_name] = type_ref_token;
+    }
+  }
+
+  metadata_import->CloseEnum(cor_enum);
+  populated_ = true;
+
+  size_t bytes =
+      GetMemoryUsage(type_def_dict_) + GetMemoryUsage(type_ref_dict_);
+  for (const auto &type_def : type_def_dict_) {
+    bytes += GetMemoryUsage(type_def.first);
+  }
+  for (const auto &type_ref : type_ref_dict_) {
+    bytes += GetMemoryUsage(type_ref.first);
+  }
+  memory_.Set(bytes);
+  return S_OK;
+}
+
+bool ModuleTypeDictionary::FindTypeDef(const std::string &class_name,
+                                       mdTypeDef *type_def) const {
+  auto type_def_info = type_def_dict_.find(class_name);
+  if (type_def_info == type_def_dict_.end()) {
+    return false;
+  }
+
+  *type_def = type_def_info->second;
+  return true;
+}
+
+bool ModuleTypeDictionary::FindTypeRef(const std::string &class_name,
+                                       mdTypeRef *type_ref) const {
+  auto type_ref_info = type_ref_dict_.find(class_name);
+  if (type_ref_info == type_ref_dict_.end()) {
+    return false;
+  }
+
+  *type_ref = type_ref_info->second;
+  return true;
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,81 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MODULE_TYPE_DICTIONARY_H_
+#define MODULE_TYPE_DICTIONARY_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "cor.h"
+#include "metrics.h"
+
+namespace google_cloud_debugger {
+
+class ICorDebugHelper;
+
+// Dictionaries from the names of the types defined (mdTypeDef) and
+// referenced (mdTypeRef) in a module to their metadata tokens.
+// Enumerating the types of a large module takes thousands of metadata
+// calls, so the dictionaries are built once per module and shared by
+// the stack frames of every breakpoint hit in that module.
+class ModuleTypeDictionary {
+ public:
+  // Enumerates the types of metadata_import into the dictionaries if
+  // they are not populated yet. Can be called from multiple threads.
+  HRESULT Populate(IMetaDataImport *metadata_import,
+                   ICorDebugHelper *debug_helper);
+
+  // Looks up the mdTypeDef of the type class_name. Returns false if the
+  // type is not defined in the module. Populate must have succeeded.
+  bool FindTypeDef(const std::string &class_name, mdTypeDef *type_def) const;
+
+  // Looks up the mdTypeRef of the type class_name. Returns false if the
+  // type is not referenced by the module. Populate must have succeeded.
+  bool FindTypeRef(const std::string &class_name, mdTypeRef *type_ref) const;
+
+  // Returns the dictionary of the types defined in the module. Populate
+  // must have succeeded.
+  const std::map<std::string, mdTypeDef> &GetTypeDefs() const {
+    return type_def_dict_;
+  }
+
+ private:
+  // Dictionary whose key is class name and whose value
+  // is the metadata token mdTypeDef of that class.
+  std::map<std::string, mdTypeDef> type_def_dict_;
+
+  // Dictionary whose key is class name and whose value
+  // is the metadata token mdTypeRef of that class.
+  // The difference between mdTypeDef and mdTypeRef
+  // is that mdTypeDef type is found in the current module
+  // whereas mdTypeRef is found in other modules.
+  // Hence, mdTypeRef may needs to be resolved to mdTypeDef
+  // when needed.
+  std::map<std::string, mdTypeRef> type_ref_dict_;
+
+  // True if type_def_dict_ and type_ref_dict_ have been populated.
+  bool populated_ = false;
+
+  // Serializes Populate. The dictionaries are not modified afterwards.
+  std::mutex mutex_;
+
+  // Memory of the dictionaries, charged once they are populated.
+  ScopedMemoryCharge memory_{&DebuggerMetrics::Global().type_dictionary_bytes};
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // MODULE_TYPE_DICTIONARY_H_
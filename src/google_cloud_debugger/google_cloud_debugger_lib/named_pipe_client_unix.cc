@@ -15,10 +15,21 @@
 #ifdef PLATFORM_UNIX
 
 #include <errno.h>
-#include <sys/un.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#endif
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <vector>
 
 #include "named_pipe_client_unix.h"
 
@@ -33,6 +44,13 @@ NamedPipeClient::NamedPipeClient(std::string pipe_name)
 }
 
 NamedPipeClient::~NamedPipeClient() {
+  for (int fd : {read_wait_set_, write_wait_set_, cancel_read_fd_,
+                 cancel_write_fd_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+
   if (pipe_ == -1) {
     return;
   }
@@ -47,6 +65,15 @@ HRESULT NamedPipeClient::Initialize() {
     cerr << "socket error: " << strerror(errno) << std::endl;
     return E_FAIL;
   }
+
+  // ShutDown writes to this pipe to wake up the pending reads and writes.
+  int cancel_pipe[2];
+  if (pipe(cancel_pipe) == -1) {
+    cerr << "pipe error: " << strerror(errno) << std::endl;
+    return E_FAIL;
+  }
+  cancel_read_fd_ = cancel_pipe[0];
+  cancel_write_fd_ = cancel_pipe[1];
   return S_OK;
 }
 
@@ -55,31 +82,158 @@ HRESULT NamedPipeClient::WaitForConnection() {
   addr.sun_family = AF_UNIX;
   strncpy(addr.sun_path, pipe_name_.c_str(), sizeof(addr.sun_path) - 1);
 
-  int timeout = kConnectionWaitTimeoutMs;
-  bool file_found = false;
+  // Watches the directory of the pipe before the first connect so that
+  // the creation of the pipe by the agent cannot be missed.
+  int watch = WatchPipeDirectory();
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(kConnectionWaitTimeoutMs);
+  HRESULT hr = E_FAIL;
 
-  while (timeout > 0) {
-    int conn = connect(pipe_, (struct sockaddr *)&addr, sizeof(addr));
-    if (conn == 0) {
-      file_found = true;
+  while (true) {
+    if (connect(pipe_, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+      hr = PrepareWaitSets();
       break;
     }
 
-    // If the connection is refused or times out we should retry.
-    if (conn == -1 && !(errno == ENOENT || errno == ECONNREFUSED || errno == ETIMEDOUT)) {
-      cerr << "connect error: " << strerror(errno) << std::endl;
+    // If the pipe does not exist yet or the connection is refused or
+    // times out we should retry.
+    int connect_error = errno;
+    if (!(connect_error == ENOENT || connect_error == ECONNREFUSED ||
+          connect_error == ETIMEDOUT || connect_error == EINTR)) {
+      cerr << "connect error: " << strerror(connect_error) << std::endl;
+      break;
+    }
+
+    int remaining_ms = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now())
+            .count());
+    if (remaining_ms <= 0) {
+      cerr << "connect error: " << strerror(connect_error) << std::endl;
+      break;
+    }
+
+    if (connect_error == ENOENT && watch != -1) {
+      // Sleeps until something is created in the directory of the pipe.
+      struct pollfd poll_fd = {watch, POLLIN, 0};
+      if (poll(&poll_fd, 1, remaining_ms) > 0) {
+        char events[4096];
+        while (read(watch, events, sizeof(events)) > 0) {
+        }
+      }
+    } else {
+      // The pipe exists but the agent is not listening yet.
+      usleep(std::min(remaining_ms, kConnectionRetryIntervalMs) * 1000);
+    }
+  }
+
+  if (watch != -1) {
+    close(watch);
+  }
+  return hr;
+}
+
+int NamedPipeClient::WatchPipeDirectory() {
+#ifdef __linux__
+  std::size_t separator = pipe_name_.rfind('/');
+  if (separator == string::npos) {
+    return -1;
+  }
+
+  int watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watch == -1) {
+    return -1;
+  }
+
+  string directory = pipe_name_.substr(0, separator + 1);
+  if (inotify_add_watch(watch, directory.c_str(), IN_CREATE | IN_MOVED_TO) ==
+      -1) {
+    close(watch);
+    return -1;
+  }
+  return watch;
+#else
+  return -1;
+#endif
+}
+
+HRESULT NamedPipeClient::PrepareWaitSets() {
+  // Reads and writes wait for the pipe without blocking in recv or send,
+  // so that ShutDown and timeouts can interrupt them.
+  int flags = fcntl(pipe_, F_GETFL, 0);
+  if (flags == -1 || fcntl(pipe_, F_SETFL, flags | O_NONBLOCK) == -1 ||
+      fcntl(cancel_read_fd_, F_SETFL, O_NONBLOCK) == -1) {
+    cerr << "fcntl error: " << strerror(errno) << std::endl;
+    return E_FAIL;
+  }
+
+#ifdef __linux__
+  // Reads and writes can happen on different threads, so each waits on
+  // its own epoll set holding the pipe and the cancellation pipe.
+  for (int *wait_set : {&read_wait_set_, &write_wait_set_}) {
+    *wait_set = epoll_create1(EPOLL_CLOEXEC);
+    if (*wait_set == -1) {
+      cerr << "epoll_create1 error: " << strerror(errno) << std::endl;
+      return E_FAIL;
+    }
+
+    struct epoll_event event = {};
+    event.events = wait_set == &read_wait_set_ ? EPOLLIN : EPOLLOUT;
+    event.data.fd = pipe_;
+    if (epoll_ctl(*wait_set, EPOLL_CTL_ADD, pipe_, &event) == -1) {
+      cerr << "epoll_ctl error: " << strerror(errno) << std::endl;
       return E_FAIL;
     }
 
-    timeout -= kConnectionSleepTimeoutMs;
-    usleep(kConnectionSleepTimeoutMs * 1000);
+    event.events = EPOLLIN;
+    event.data.fd = cancel_read_fd_;
+    if (epoll_ctl(*wait_set, EPOLL_CTL_ADD, cancel_read_fd_, &event) == -1) {
+      cerr << "epoll_ctl error: " << strerror(errno) << std::endl;
+      return E_FAIL;
+    }
+  }
+#endif
+  return S_OK;
+}
+
+HRESULT NamedPipeClient::WaitForPipe(bool write, int timeout_ms) {
+  bool cancelled = false;
+  bool ready = false;
+#ifdef __linux__
+  struct epoll_event events[2];
+  int count = epoll_wait(write ? write_wait_set_ : read_wait_set_, events, 2,
+                         timeout_ms);
+  for (int i = 0; i < count; ++i) {
+    cancelled = cancelled || events[i].data.fd == cancel_read_fd_;
+    ready = ready || events[i].data.fd == pipe_;
+  }
+#else
+  short events = write ? POLLOUT : POLLIN;
+  struct pollfd fds[2] = {{pipe_, events, 0}, {cancel_read_fd_, POLLIN, 0}};
+  int count = poll(fds, 2, timeout_ms);
+  if (count > 0) {
+    cancelled = fds[1].revents != 0;
+    ready = fds[0].revents != 0;
   }
+#endif
 
-  if (!file_found) {
-    cerr << "connect error: " << strerror(errno) << std::endl;
+  if (count == -1) {
+    if (errno == EINTR) {
+      return S_OK;
+    }
+    cerr << "wait error: " << strerror(errno) << std::endl;
     return E_FAIL;
   }
 
+  if (cancelled) {
+    return E_ABORT;
+  }
+
+  if (!ready) {
+    cerr << (write ? "send" : "recv") << " error: timed out" << std::endl;
+    return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+  }
   return S_OK;
 }
 
@@ -89,32 +243,122 @@ HRESULT NamedPipeClient::Read(string *message) {
   }
 
   char buff[kBufferSize];
-  int read = recv(pipe_, buff, kBufferSize, 0);
+  while (true) {
+    ssize_t read = recv(pipe_, buff, kBufferSize, 0);
+    if (read >= 0) {
+      message->assign(buff, buff + read);
+      return S_OK;
+    }
 
-  if (read == -1) {
-    cerr << "recv error: " << strerror(errno) << std::endl;
-    return E_FAIL;
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      cerr << "recv error: " << strerror(errno) << std::endl;
+      return E_FAIL;
+    }
+
+    HRESULT hr = WaitForPipe(false, -1);
+    if (FAILED(hr)) {
+      return hr;
+    }
+  }
+}
+
+HRESULT NamedPipeClient::ReadExactly(std::size_t size, string *message) {
+  if (message == nullptr) {
+    return E_POINTER;
+  }
+
+  message->resize(size);
+  std::size_t total_read = 0;
+  while (total_read < size) {
+    ssize_t read = recv(pipe_, &(*message)[total_read], size - total_read, 0);
+    if (read == -1) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        cerr << "recv error: " << strerror(errno) << std::endl;
+        return E_FAIL;
+      }
+
+      HRESULT hr = WaitForPipe(false, -1);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      continue;
+    }
+
+    if (read == 0) {
+      cerr << "recv error: the pipe was closed" << std::endl;
+      return E_FAIL;
+    }
+
+    total_read += read;
   }
 
-  message->assign(buff, buff + read);
   return S_OK;
 }
 
 HRESULT NamedPipeClient::Write(const string &message) {
-  const char *buf = message.c_str();
-  DWORD bytes_left = message.length();
+  PipeBuffer buffer = {message.data(), message.size()};
+  return WriteBuffers(&buffer, 1);
+}
 
-  while (bytes_left > 0) {
-    int write = bytes_left > kBufferSize ? kBufferSize : bytes_left;
+HRESULT NamedPipeClient::WriteBuffers(const PipeBuffer *buffers,
+                                      std::size_t count) {
+  if (buffers == nullptr && count != 0) {
+    return E_POINTER;
+  }
 
-    int written = send(pipe_, buf, write, 0);
+  std::vector<struct iovec> iovecs;
+  iovecs.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (buffers[i].size == 0) {
+      continue;
+    }
+    struct iovec iov;
+    iov.iov_base = const_cast<char *>(buffers[i].data);
+    iov.iov_len = buffers[i].size;
+    iovecs.push_back(iov);
+  }
+
+  // sendmsg may write only part of the buffers, in which case the
+  // remaining iovecs are adjusted and sent again.
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(kPipeWriteTimeoutMs);
+  std::size_t current = 0;
+  while (current < iovecs.size()) {
+    struct msghdr header = {};
+    header.msg_iov = &iovecs[current];
+    header.msg_iovlen = std::min<std::size_t>(iovecs.size() - current, IOV_MAX);
+
+    ssize_t written = sendmsg(pipe_, &header, 0);
     if (written == -1) {
-      cerr << "send error: " << strerror(errno) << std::endl;
-      return E_FAIL;
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        cerr << "sendmsg error: " << strerror(errno) << std::endl;
+        return E_FAIL;
+      }
+
+      // Waits for the agent to read what was already written.
+      int remaining_ms = std::max(
+          0, static_cast<int>(
+                 std::chrono::duration_cast<std::chrono::milliseconds>(
+                     deadline - std::chrono::steady_clock::now())
+                     .count()));
+      HRESULT hr = WaitForPipe(true, remaining_ms);
+      if (FAILED(hr)) {
+        return hr;
+      }
+      continue;
     }
 
-    bytes_left -= written;
-    buf += written;
+    while (written > 0) {
+      struct iovec &iov = iovecs[current];
+      if (static_cast<std::size_t>(written) < iov.iov_len) {
+        iov.iov_base = static_cast<char *>(iov.iov_base) + written;
+        iov.iov_len -= written;
+        break;
+      }
+      written -= iov.iov_len;
+      ++current;
+    }
   }
   return S_OK;
 }
@@ -124,6 +368,15 @@ HRESULT NamedPipeClient::ShutDown() {
     return S_OK;
   }
 
+  // Wakes up the pending reads and writes. The byte is never read, so
+  // later reads and writes are cancelled too.
+  if (cancel_write_fd_ != -1) {
+    char cancel = 0;
+    if (write(cancel_write_fd_, &cancel, 1) == -1) {
+      cerr << "write error: " << strerror(errno) << std::endl;
+    }
+  }
+
   if (shutdown(pipe_, SHUT_RDWR) == -1) {
     cerr << "shutdown error: " << strerror(errno) << std::endl;
     return E_FAIL;
@@ -32,15 +32,38 @@ class NamedPipeClient : public INamedPipe {
   HRESULT Initialize() override;
   HRESULT WaitForConnection() override;
   HRESULT Read(std::string *message) override;
+  HRESULT ReadExactly(std::size_t size, std::string *message) override;
   HRESULT Write(const std::string &message) override;
+  HRESULT WriteBuffers(const PipeBuffer *buffers, std::size_t count) override;
   HRESULT ShutDown() override;
 
  private:
+  // Makes the pipe non-blocking and creates the epoll sets that
+  // reads and writes wait on. Called once the pipe is connected.
+  HRESULT PrepareWaitSets();
+
+  // Waits until the pipe can be read (or written if write is true), up to
+  // timeout_ms milliseconds (-1 waits forever). Returns E_ABORT if
+  // ShutDown is called while waiting or had been called before.
+  HRESULT WaitForPipe(bool write, int timeout_ms);
+
+  // Returns an inotify descriptor that becomes readable when a file is
+  // created in the directory of the pipe, or -1 if that is not supported.
+  int WatchPipeDirectory();
+
   // The name of the pipe.
   std::string pipe_name_;
 
   // The socket descriptor for the pipe.
   int pipe_ = -1;
+
+  // The epoll sets that reads and writes wait on (Linux only).
+  int read_wait_set_ = -1;
+  int write_wait_set_ = -1;
+
+  // A pipe that ShutDown writes to in order to cancel reads and writes.
+  int cancel_read_fd_ = -1;
+  int cancel_write_fd_ = -1;
 };
 
 }  // namespace google_cloud_debugger
@@ -30,6 +30,15 @@ NamedPipeClient::NamedPipeClient(std::string pipe_name)
 }
 
 NamedPipeClient::~NamedPipeClient() {
+  if (read_event_ != NULL) {
+    CloseHandle(read_event_);
+  }
+  if (write_event_ != NULL) {
+    CloseHandle(write_event_);
+  }
+  if (cancel_event_ != NULL) {
+    CloseHandle(cancel_event_);
+  }
   if (pipe_ == INVALID_HANDLE_VALUE) {
     return;
   }
@@ -39,28 +48,49 @@ NamedPipeClient::~NamedPipeClient() {
   }
 }
 
-HRESULT NamedPipeClient::Initialize() { return S_OK; }
+HRESULT NamedPipeClient::Initialize() {
+  // Reads and writes each wait on their own event so that a write
+  // can proceed while a read is pending on the same handle.
+  read_event_ = CreateEventW(NULL, TRUE, FALSE, NULL);
+  write_event_ = CreateEventW(NULL, TRUE, FALSE, NULL);
+  // Stays signaled once ShutDown sets it, cancelling later IO too.
+  cancel_event_ = CreateEventW(NULL, TRUE, FALSE, NULL);
+  if (read_event_ == NULL || write_event_ == NULL || cancel_event_ == NULL) {
+    std::cerr << "CreateEvent error: " << HRESULT_FROM_WIN32(GetLastError())
+              << std::endl;
+    return HRESULT_FROM_WIN32(GetLastError());
+  }
+  return S_OK;
+}
 
 HRESULT NamedPipeClient::WaitForConnection() {
-  int timeout = kConnectionWaitTimeoutMs;
+  ULONGLONG deadline = GetTickCount64() + kConnectionWaitTimeoutMs;
   bool file_found = false;
 
-  while (timeout > 0) {
-    BOOL available =
-        WaitNamedPipeW(pipe_name_.c_str(), kConnectionSleepTimeoutMs);
+  while (true) {
+    ULONGLONG now = GetTickCount64();
+    if (now >= deadline) {
+      break;
+    }
+
+    // WaitNamedPipe blocks until an instance of an existing pipe is
+    // available. It fails right away if the pipe does not exist yet, in
+    // which case we retry after a short interval.
+    BOOL available = WaitNamedPipeW(pipe_name_.c_str(),
+                                    static_cast<DWORD>(deadline - now));
     if (available) {
       file_found = true;
       break;
     }
 
-    if (!available && GetLastError() != ERROR_FILE_NOT_FOUND) {
+    if (GetLastError() != ERROR_FILE_NOT_FOUND &&
+        GetLastError() != ERROR_SEM_TIMEOUT) {
       std::cerr << "WaitNamedPipe error: " << HRESULT_FROM_WIN32(GetLastError())
                 << std::endl;
       return HRESULT_FROM_WIN32(GetLastError());
     }
 
-    timeout -= kConnectionSleepTimeoutMs;
-    Sleep(kConnectionSleepTimeoutMs);
+    Sleep(kConnectionRetryIntervalMs);
   }
 
   if (!file_found) {
@@ -71,7 +101,7 @@ HRESULT NamedPipeClient::WaitForConnection() {
 
   pipe_ = CreateFileW(pipe_name_.c_str(), GENERIC_READ | GENERIC_WRITE,
                       FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
-                      FILE_ATTRIBUTE_NORMAL, NULL);
+                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
 
   if (pipe_ == INVALID_HANDLE_VALUE) {
     std::cerr << "CreateFile error: " << HRESULT_FROM_WIN32(GetLastError())
@@ -81,41 +111,140 @@ HRESULT NamedPipeClient::WaitForConnection() {
   return S_OK;
 }
 
+HRESULT NamedPipeClient::WaitForOverlapped(OVERLAPPED *overlapped,
+                                           DWORD timeout_ms,
+                                           DWORD *transferred) {
+  HANDLE events[] = {overlapped->hEvent, cancel_event_};
+  DWORD wait = WaitForMultipleObjects(2, events, FALSE, timeout_ms);
+  if (wait != WAIT_OBJECT_0) {
+    // The IO has to be cancelled and completed before overlapped
+    // goes out of scope.
+    CancelIoEx(pipe_, overlapped);
+    GetOverlappedResult(pipe_, overlapped, transferred, TRUE);
+    if (wait == WAIT_OBJECT_0 + 1) {
+      return E_ABORT;
+    }
+    if (wait == WAIT_TIMEOUT) {
+      return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+    }
+    return HRESULT_FROM_WIN32(GetLastError());
+  }
+
+  if (!GetOverlappedResult(pipe_, overlapped, transferred, TRUE)) {
+    return HRESULT_FROM_WIN32(GetLastError());
+  }
+  return S_OK;
+}
+
+HRESULT NamedPipeClient::ReadSome(CHAR *buffer, DWORD size, DWORD *read) {
+  OVERLAPPED overlapped = {};
+  overlapped.hEvent = read_event_;
+  if (!ReadFile(pipe_, buffer, size, NULL, &overlapped) &&
+      GetLastError() != ERROR_IO_PENDING) {
+    std::cerr << "ReadFile error: " << HRESULT_FROM_WIN32(GetLastError())
+              << std::endl;
+    return HRESULT_FROM_WIN32(GetLastError());
+  }
+
+  HRESULT hr = WaitForOverlapped(&overlapped, INFINITE, read);
+  if (FAILED(hr)) {
+    std::cerr << "ReadFile error: " << hr << std::endl;
+    return hr;
+  }
+  return S_OK;
+}
+
+HRESULT NamedPipeClient::WriteSome(const CHAR *buffer, DWORD size,
+                                   DWORD timeout_ms, DWORD *written) {
+  OVERLAPPED overlapped = {};
+  overlapped.hEvent = write_event_;
+  if (!WriteFile(pipe_, buffer, size, NULL, &overlapped) &&
+      GetLastError() != ERROR_IO_PENDING) {
+    std::cerr << "WriteFile error: " << HRESULT_FROM_WIN32(GetLastError())
+              << std::endl;
+    return HRESULT_FROM_WIN32(GetLastError());
+  }
+
+  HRESULT hr = WaitForOverlapped(&overlapped, timeout_ms, written);
+  if (FAILED(hr)) {
+    std::cerr << "WriteFile error: " << hr << std::endl;
+    return hr;
+  }
+  return S_OK;
+}
+
 HRESULT NamedPipeClient::Read(string *message) {
   if (message == nullptr) {
     return E_POINTER;
   }
   CHAR buf[kBufferSize];
   DWORD read = 0;
-  BOOL success = ReadFile(pipe_, buf, kBufferSize - 1, &read, NULL);
-
-  if (!success) {
-    std::cerr << "ReadFile error: " << HRESULT_FROM_WIN32(GetLastError())
-              << std::endl;
-    return HRESULT_FROM_WIN32(GetLastError());
+  HRESULT hr = ReadSome(buf, kBufferSize - 1, &read);
+  if (FAILED(hr)) {
+    return hr;
   }
 
   message->assign(buf, buf + read);
   return S_OK;
 }
 
-HRESULT NamedPipeClient::Write(const string &message) {
-  const CHAR *buf = message.c_str();
-  DWORD bytes_left = message.size();
+HRESULT NamedPipeClient::ReadExactly(std::size_t size, string *message) {
+  if (message == nullptr) {
+    return E_POINTER;
+  }
 
-  while (bytes_left > 0) {
-    DWORD written = 0;
-    int write = bytes_left > kBufferSize ? kBufferSize : bytes_left;
+  message->resize(size);
+  std::size_t total_read = 0;
+  while (total_read < size) {
+    DWORD read = 0;
+    HRESULT hr = ReadSome(&(*message)[total_read], size - total_read, &read);
+    if (FAILED(hr)) {
+      return hr;
+    }
 
-    BOOL success = WriteFile(pipe_, buf, write, &written, NULL);
-    if (!success) {
-      std::cerr << "WriteFile error: " << HRESULT_FROM_WIN32(GetLastError())
-                << std::endl;
-      return HRESULT_FROM_WIN32(GetLastError());
+    if (read == 0) {
+      std::cerr << "ReadFile error: the pipe was closed" << std::endl;
+      return E_FAIL;
     }
 
-    bytes_left -= written;
-    buf += written;
+    total_read += read;
+  }
+
+  return S_OK;
+}
+
+HRESULT NamedPipeClient::Write(const string &message) {
+  PipeBuffer buffer = {message.data(), message.size()};
+  return WriteBuffers(&buffer, 1);
+}
+
+HRESULT NamedPipeClient::WriteBuffers(const PipeBuffer *buffers,
+                                      std::size_t count) {
+  if (buffers == nullptr && count != 0) {
+    return E_POINTER;
+  }
+
+  // Named pipes do not support gather writes (WSASend only works on
+  // sockets), so each buffer is written with its own WriteFile call.
+  // This still avoids copying the buffers into a single message.
+  ULONGLONG deadline = GetTickCount64() + kPipeWriteTimeoutMs;
+  for (std::size_t i = 0; i < count; ++i) {
+    const CHAR *buf = buffers[i].data;
+    DWORD bytes_left = buffers[i].size;
+
+    while (bytes_left > 0) {
+      ULONGLONG now = GetTickCount64();
+      DWORD timeout_ms =
+          now < deadline ? static_cast<DWORD>(deadline - now) : 0;
+      DWORD written = 0;
+      HRESULT hr = WriteSome(buf, bytes_left, timeout_ms, &written);
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      bytes_left -= written;
+      buf += written;
+    }
   }
   return S_OK;
 }
@@ -125,6 +254,11 @@ HRESULT NamedPipeClient::ShutDown() {
     return S_OK;
   }
 
+  // Wakes up the reads and writes waiting on the pipe.
+  if (cancel_event_ != NULL) {
+    SetEvent(cancel_event_);
+  }
+
   if (!CancelIoEx(pipe_, nullptr)) {
     std::cerr << "Canceling IO error: " << HRESULT_FROM_WIN32(GetLastError())
               << std::endl;
@@ -35,15 +35,40 @@ class NamedPipeClient : public INamedPipe {
   HRESULT Initialize() override;
   HRESULT WaitForConnection() override;
   HRESULT Read(std::string *message) override;
+  HRESULT ReadExactly(std::size_t size, std::string *message) override;
   HRESULT Write(const std::string &message) override;
+  HRESULT WriteBuffers(const PipeBuffer *buffers, std::size_t count) override;
   HRESULT ShutDown() override;
 
  private:
   // The name of the pipe.
   std::wstring pipe_name_;
 
-  // A handle to the open pipe.
+  // Waits up to timeout_ms milliseconds for the overlapped IO to
+  // complete. The IO is cancelled and E_ABORT returned if ShutDown
+  // is called while waiting.
+  HRESULT WaitForOverlapped(OVERLAPPED *overlapped, DWORD timeout_ms,
+                            DWORD *transferred);
+
+  // Reads up to size bytes into buffer with an overlapped ReadFile
+  // and waits for it to complete.
+  HRESULT ReadSome(CHAR *buffer, DWORD size, DWORD *read);
+
+  // Writes up to size bytes from buffer with an overlapped WriteFile
+  // and waits up to timeout_ms milliseconds for it to complete.
+  HRESULT WriteSome(const CHAR *buffer, DWORD size, DWORD timeout_ms,
+                    DWORD *written);
+
+  // A handle to the open pipe. It is opened for overlapped IO so that
+  // a read and a write can be pending at the same time.
   HANDLE pipe_ = INVALID_HANDLE_VALUE;
+
+  // Events signaled when the pending read or write completes.
+  HANDLE read_event_ = NULL;
+  HANDLE write_event_ = NULL;
+
+  // Event signaled by ShutDown to cancel the pending reads and writes.
+  HANDLE cancel_event_ = NULL;
 };
 
 }  // namespace google_cloud_debugger
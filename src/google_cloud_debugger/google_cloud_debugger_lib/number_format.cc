@@ -0,0 +1,226 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "number_format.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// The two digits of every number below 100, so that integers are
+// written two digits per division.
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the names .NET gives to the values that are not finite. Returns
+// nullptr if value is finite.
+char *FormatNonFinite(double value, char *buffer) {
+  const char *name = nullptr;
+  if (std::isnan(value)) {
+    name = "NaN";
+  } else if (std::isinf(value)) {
+    name = value < 0 ? "-Infinity" : "Infinity";
+  } else {
+    return nullptr;
+  }
+
+  std::size_t length = std::strlen(name);
+  std::memcpy(buffer, name, length);
+  return buffer + length;
+}
+
+// Writes value in fixed-point notation if it is an integer scaled below
+// max_scaled divided by some 10^k, and in the range %g prints without an
+// exponent. Returns the end of what it wrote, or nullptr if value has
+// more digits or is out of the range.
+//
+// scaled / 10^k is rounded to value by the division exactly like the
+// decimal is by strtod, so the decimal reads back as value. As every
+// decimal with as many digits as the precision of T reads back as a
+// different value, it is also the one printf writes.
+template <typename T>
+char *FormatShortDecimal(T value, T max_scaled, char *buffer) {
+  T magnitude = value < 0 ? -value : value;
+  if (!(magnitude >= static_cast<T>(1e-4) && magnitude < max_scaled)) {
+    return nullptr;
+  }
+
+  T scale = 1;
+  int point = 0;
+  T scaled = magnitude;
+  while (scaled != std::trunc(scaled) || scaled / scale != magnitude) {
+    scale *= 10;
+    ++point;
+    scaled = magnitude * scale;
+    if (!(scaled < max_scaled)) {
+      return nullptr;
+    }
+  }
+
+  char *end = buffer;
+  if (value < 0) {
+    *end++ = '-';
+  }
+
+  // The product may only be an integer for a larger k than the smallest,
+  // so the zeros it ends with are dropped.
+  char digits[kMaxFormattedNumberLength];
+  int length = static_cast<int>(
+      FormatUnsigned(static_cast<std::uint64_t>(scaled), digits) - digits);
+  while (point > 0 && digits[length - 1] == '0') {
+    --length;
+    --point;
+  }
+  if (length <= point) {
+    // Pads fractions below 1 with zeros, as in "0.005".
+    *end++ = '0';
+    *end++ = '.';
+    for (int i = length; i < point; ++i) {
+      *end++ = '0';
+    }
+    std::memcpy(end, digits, length);
+    return end + length;
+  }
+
+  std::memcpy(end, digits, length - point);
+  end += length - point;
+  if (point > 0) {
+    *end++ = '.';
+    std::memcpy(end, digits + length - point, point);
+    end += point;
+  }
+  return end;
+}
+
+// Writes value with printf's %g with the fewest significant digits from
+// min_precision up to max_precision that read back as value, with the
+// exponent marker in upper case like .NET. Returns the end of what it
+// wrote.
+template <typename T>
+char *FormatShortest(T value, int min_precision, int max_precision,
+                     T (*parse)(const char *, char **), char *buffer) {
+  char digits[kMaxFormattedNumberLength + 1];
+  int length = 0;
+  for (int precision = min_precision; precision <= max_precision;
+       ++precision) {
+    length = snprintf(digits, sizeof(digits), "%.*g", precision,
+                      static_cast<double>(value));
+    if (parse(digits, nullptr) == value) {
+      break;
+    }
+  }
+
+  if (length < 0) {
+    length = 0;
+  } else if (static_cast<std::size_t>(length) >= sizeof(digits)) {
+    length = sizeof(digits) - 1;
+  }
+  for (int i = 0; i < length; ++i) {
+    buffer[i] = digits[i] == 'e' ? 'E' : digits[i];
+  }
+  return buffer + length;
+}
+
+}  // namespace
+
+char *FormatUnsigned(std::uint64_t value, char *buffer) {
+  std::size_t length = 1;
+  for (std::uint64_t rest = value; rest >= 10; rest /= 10) {
+    ++length;
+  }
+
+  // Writes the digits from the last one.
+  char *end = buffer + length;
+  char *digit = end;
+  while (value >= 100) {
+    std::size_t pair = static_cast<std::size_t>(value % 100) * 2;
+    value /= 100;
+    *--digit = kDigitPairs[pair + 1];
+    *--digit = kDigitPairs[pair];
+  }
+  if (value >= 10) {
+    std::size_t pair = static_cast<std::size_t>(value) * 2;
+    *--digit = kDigitPairs[pair + 1];
+    *--digit = kDigitPairs[pair];
+  } else {
+    *--digit = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+char *FormatInteger(std::int64_t value, char *buffer) {
+  if (value >= 0) {
+    return FormatUnsigned(static_cast<std::uint64_t>(value), buffer);
+  }
+
+  // Negates in unsigned arithmetic so that the minimum value works too.
+  *buffer = '-';
+  return FormatUnsigned(0 - static_cast<std::uint64_t>(value), buffer + 1);
+}
+
+char *FormatDouble(double value, char *buffer) {
+  char *end = FormatNonFinite(value, buffer);
+  if (end) {
+    return end;
+  }
+
+  // Most doubles in programs have few decimal digits.
+  end = FormatShortDecimal(value, 1e15, buffer);
+  if (end) {
+    return end;
+  }
+
+  // Almost every double reads back from 15 digits, and every one does
+  // from 17.
+  return FormatShortest<double>(value, 15, 17, std::strtod, buffer);
+}
+
+char *FormatFloat(float value, char *buffer) {
+  char *end = FormatNonFinite(value, buffer);
+  if (end) {
+    return end;
+  }
+
+  end = FormatShortDecimal(value, 1e6f, buffer);
+  if (end) {
+    return end;
+  }
+
+  // Every float reads back from 9 digits.
+  return FormatShortest<float>(value, 6, 9, std::strtof, buffer);
+}
+
+void AssignIndexName(std::uint64_t index, std::string *output) {
+  char buffer[kMaxFormattedNumberLength + 2];
+  buffer[0] = '[';
+  char *end = FormatUnsigned(index, buffer + 1);
+  *end++ = ']';
+  output->assign(buffer, end);
+}
+
+}  //  namespace google_cloud_debugger
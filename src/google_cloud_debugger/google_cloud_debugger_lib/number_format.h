@@ -0,0 +1,91 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NUMBER_FORMAT_H_
+#define NUMBER_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace google_cloud_debugger {
+
+// The most characters the FormatNumber functions write: a 64-bit integer
+// with its sign, or a double with 17 digits, its sign, point and
+// exponent.
+const std::size_t kMaxFormattedNumberLength = 32;
+
+// Formats the numbers captured in snapshots and log points without
+// allocating. Each function writes value to buffer, which has room for
+// kMaxFormattedNumberLength characters, and returns the end of what it
+// wrote. The buffer is not null-terminated.
+
+// Writes value in decimal.
+char *FormatInteger(std::int64_t value, char *buffer);
+char *FormatUnsigned(std::uint64_t value, char *buffer);
+
+// Writes the shortest decimal that reads back as value, as in "0.1",
+// "1.5E+20" or "1E-05", and "NaN", "Infinity" and "-Infinity" like .NET.
+char *FormatDouble(double value, char *buffer);
+char *FormatFloat(float value, char *buffer);
+
+// Writes value, of any arithmetic type, with the function above that
+// fits its type. bool and char are written as integers.
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                            std::is_signed<T>::value,
+                        char *>::type
+FormatNumber(T value, char *buffer) {
+  return FormatInteger(value, buffer);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_signed<T>::value,
+                        char *>::type
+FormatNumber(T value, char *buffer) {
+  return FormatUnsigned(value, buffer);
+}
+
+inline char *FormatNumber(double value, char *buffer) {
+  return FormatDouble(value, buffer);
+}
+
+inline char *FormatNumber(float value, char *buffer) {
+  return FormatFloat(value, buffer);
+}
+
+// Sets output to value formatted by FormatNumber, reusing the memory of
+// output.
+template <typename T>
+void AssignNumber(T value, std::string *output) {
+  char buffer[kMaxFormattedNumberLength];
+  output->assign(buffer, FormatNumber(value, buffer));
+}
+
+// Appends value formatted by FormatNumber to output.
+template <typename T>
+void AppendNumber(T value, std::string *output) {
+  char buffer[kMaxFormattedNumberLength];
+  output->append(buffer, FormatNumber(value, buffer));
+}
+
+// Sets output to "[index]", the name of an item of an array or a
+// collection.
+void AssignIndexName(std::uint64_t index, std::string *output);
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  NUMBER_FORMAT_H_
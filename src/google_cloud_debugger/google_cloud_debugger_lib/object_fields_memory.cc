@@ -0,0 +1,268 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "object_fields_memory.h"
+
+#include <cstring>
+#include <set>
+
+#include "constants.h"
+#include "dbg_primitive.h"
+#include "debuggee_memory_cache.h"
+
+using std::shared_ptr;
+using std::unique_ptr;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+std::map<ObjectFieldsMemory::TypeLayoutKey,
+         shared_ptr<const ObjectFieldsMemory::TypeLayout>>
+    ObjectFieldsMemory::type_layouts_;
+
+std::mutex ObjectFieldsMemory::type_layouts_mutex_;
+
+// Returns the size of a field of primitive type cor_type that can be
+// read from memory, or 0 if it has to be read with GetFieldValue.
+// System.Char is not included since DbgPrimitive<char> holds 1 byte, and
+// native integers since DbgPrimitive without an ICorDebugType cannot tell
+// them from Int32 and Int64.
+static ULONG32 GetPrimitiveFieldSize(CorElementType cor_type) {
+  switch (cor_type) {
+    case ELEMENT_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case ELEMENT_TYPE_I1:
+    case ELEMENT_TYPE_U1:
+      return 1;
+    case ELEMENT_TYPE_I2:
+    case ELEMENT_TYPE_U2:
+      return 2;
+    case ELEMENT_TYPE_I4:
+    case ELEMENT_TYPE_U4:
+    case ELEMENT_TYPE_R4:
+      return 4;
+    case ELEMENT_TYPE_I8:
+    case ELEMENT_TYPE_U8:
+    case ELEMENT_TYPE_R8:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+// Creates a DbgPrimitive<T> with the value at field_memory.
+template <typename T>
+static HRESULT CreatePrimitive(const BYTE *field_memory,
+                               unique_ptr<DbgObject> *field_value) {
+  T value;
+  memcpy(&value, field_memory, sizeof(T));
+  field_value->reset(new (std::nothrow) DbgPrimitive<T>(value));
+  if (!*field_value) {
+    return E_OUTOFMEMORY;
+  }
+
+  return S_OK;
+}
+
+ObjectFieldsMemory::ObjectFieldsMemory(ICorDebugObjectValue *object_value,
+                                       ICorDebugModule *debug_module)
+    : object_value_(object_value), debug_module_(debug_module) {}
+
+HRESULT ObjectFieldsMemory::CreatePrimitiveField(
+    mdFieldDef field_def, unique_ptr<DbgObject> *field_value) {
+  if (!field_value) {
+    return E_INVALIDARG;
+  }
+
+  if (!read_) {
+    read_ = true;
+    read_hr_ = ReadObjectMemory();
+    // Nothing else needs the object once its memory is read.
+    object_value_.Release();
+    debug_module_.Release();
+  }
+
+  if (read_hr_ != S_OK) {
+    return S_FALSE;
+  }
+
+  auto field = layout_->fields.find(field_def);
+  if (field == layout_->fields.end()) {
+    return S_FALSE;
+  }
+
+  ULONG32 field_size = GetPrimitiveFieldSize(field->second.type);
+  if (field_size == 0 || field->second.offset + field_size > memory_.size()) {
+    return S_FALSE;
+  }
+
+  const BYTE *field_memory = memory_.data() + field->second.offset;
+  switch (field->second.type) {
+    case ELEMENT_TYPE_BOOLEAN:
+      return CreatePrimitive<bool>(field_memory, field_value);
+    case ELEMENT_TYPE_I1:
+      return CreatePrimitive<int8_t>(field_memory, field_value);
+    case ELEMENT_TYPE_U1:
+      return CreatePrimitive<uint8_t>(field_memory, field_value);
+    case ELEMENT_TYPE_I2:
+      return CreatePrimitive<int16_t>(field_memory, field_value);
+    case ELEMENT_TYPE_U2:
+      return CreatePrimitive<uint16_t>(field_memory, field_value);
+    case ELEMENT_TYPE_I4:
+      return CreatePrimitive<int32_t>(field_memory, field_value);
+    case ELEMENT_TYPE_U4:
+      return CreatePrimitive<uint32_t>(field_memory, field_value);
+    case ELEMENT_TYPE_I8:
+      return CreatePrimitive<int64_t>(field_memory, field_value);
+    case ELEMENT_TYPE_U8:
+      return CreatePrimitive<uint64_t>(field_memory, field_value);
+    case ELEMENT_TYPE_R4:
+      return CreatePrimitive<float>(field_memory, field_value);
+    case ELEMENT_TYPE_R8:
+      return CreatePrimitive<double>(field_memory, field_value);
+    default:
+      return S_FALSE;
+  }
+}
+
+HRESULT ObjectFieldsMemory::ReadObjectMemory() {
+  if (!object_value_ || !debug_module_) {
+    return E_INVALIDARG;
+  }
+
+  CComPtr<ICorDebugProcess> debug_process;
+  HRESULT hr = debug_module_->GetProcess(&debug_process);
+  if (FAILED(hr) || !debug_process) {
+    return E_FAIL;
+  }
+
+  // Older runtimes do not implement ICorDebugProcess5, in which case
+  // every field is read with GetFieldValue.
+  CComPtr<ICorDebugProcess5> debug_process5;
+  hr = debug_process->QueryInterface(
+      __uuidof(ICorDebugProcess5), reinterpret_cast<void **>(&debug_process5));
+  if (FAILED(hr) || !debug_process5) {
+    return E_NOINTERFACE;
+  }
+
+  hr = object_value_->GetAddress(&address_);
+  if (FAILED(hr) || address_ == 0) {
+    return E_FAIL;
+  }
+
+  COR_TYPEID type_id;
+  hr = debug_process5->GetTypeID(address_, &type_id);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  hr = GetTypeLayout(debug_process5, type_id, &layout_);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  if (layout_->fields.empty() || layout_->object_size == 0) {
+    return S_FALSE;
+  }
+
+  memory_.resize(layout_->object_size);
+  hr = DebuggeeMemoryCache::ReadMemory(debug_process, address_,
+                                       memory_.size(), memory_.data());
+  if (FAILED(hr)) {
+    memory_.clear();
+    return E_FAIL;
+  }
+
+  return S_OK;
+}
+
+HRESULT ObjectFieldsMemory::GetTypeLayout(
+    ICorDebugProcess5 *debug_process, const COR_TYPEID &type_id,
+    shared_ptr<const TypeLayout> *layout) {
+  TypeLayoutKey key(type_id.token1, type_id.token2);
+  {
+    std::lock_guard<std::mutex> lock(type_layouts_mutex_);
+    auto cached_layout = type_layouts_.find(key);
+    if (cached_layout != type_layouts_.end()) {
+      *layout = cached_layout->second;
+      return S_OK;
+    }
+  }
+
+  shared_ptr<TypeLayout> new_layout(new (std::nothrow) TypeLayout());
+  if (!new_layout) {
+    return E_OUTOFMEMORY;
+  }
+
+  // The fields of a type do not include the fields of its base types, so
+  // the fields of every type up to System.Object are added. A field token
+  // is only unique within a module, so a token used by two types of the
+  // hierarchy is left out and read with GetFieldValue.
+  std::set<mdFieldDef> ambiguous_fields;
+  COR_TYPEID current_id = type_id;
+  bool most_derived = true;
+  while (current_id.token1 != 0 || current_id.token2 != 0) {
+    COR_TYPE_LAYOUT type_layout;
+    HRESULT hr = debug_process->GetTypeLayout(current_id, &type_layout);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    if (most_derived) {
+      new_layout->object_size = type_layout.objectSize;
+      most_derived = false;
+    }
+
+    if (type_layout.numFields > 0) {
+      vector<COR_FIELD> fields(type_layout.numFields);
+      ULONG32 fields_fetched = 0;
+      hr = debug_process->GetTypeFields(current_id, fields.size(),
+                                        fields.data(), &fields_fetched);
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      for (ULONG32 i = 0; i < fields_fetched && i < fields.size(); ++i) {
+        FieldLayout field_layout;
+        field_layout.offset = fields[i].offset;
+        field_layout.type = fields[i].fieldType;
+        if (!new_layout->fields.emplace(fields[i].token, field_layout)
+                 .second) {
+          ambiguous_fields.insert(fields[i].token);
+        }
+      }
+    }
+
+    current_id = type_layout.parentID;
+  }
+
+  for (mdFieldDef field_def : ambiguous_fields) {
+    new_layout->fields.erase(field_def);
+  }
+
+  std::lock_guard<std::mutex> lock(type_layouts_mutex_);
+  if (type_layouts_.size() >= kMaximumCachedTypeFieldLayouts) {
+    type_layouts_.clear();
+  }
+  type_layouts_[key] = new_layout;
+  *layout = std::move(new_layout);
+  return S_OK;
+}
+
+void ObjectFieldsMemory::ClearTypeLayouts() {
+  std::lock_guard<std::mutex> lock(type_layouts_mutex_);
+  type_layouts_.clear();
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,106 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OBJECT_FIELDS_MEMORY_H_
+#define OBJECT_FIELDS_MEMORY_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "ccomptr.h"
+#include "cor.h"
+#include "cordebug.h"
+#include "dbg_object.h"
+
+namespace google_cloud_debugger {
+
+// Reads the primitive fields of an object from a single copy of its
+// memory instead of calling ICorDebugObjectValue::GetFieldValue and
+// ICorDebugGenericValue::GetValue for every field. The offsets and types
+// of the fields come from ICorDebugProcess5::GetTypeFields and are cached
+// by type ID, so after the first object of a type only the type ID of the
+// object is looked up before its memory is read with one
+// ICorDebugProcess::ReadMemory call.
+//
+// The memory is read when the first field is requested. Fields that are
+// not primitives, such as strings and other references, are not decoded
+// and have to be read with GetFieldValue.
+class ObjectFieldsMemory {
+ public:
+  // object_value is the reference type object whose fields are read and
+  // debug_module is used to get the process.
+  ObjectFieldsMemory(ICorDebugObjectValue *object_value,
+                     ICorDebugModule *debug_module);
+
+  // Creates in field_value a DbgPrimitive holding the value of
+  // field_def. Returns S_FALSE if the field is not a primitive of the
+  // type of the object or the memory of the object cannot be read, in
+  // which case the field has to be read with GetFieldValue.
+  HRESULT CreatePrimitiveField(mdFieldDef field_def,
+                               std::unique_ptr<DbgObject> *field_value);
+
+  // Removes the cached field layouts. The type IDs of the types of a
+  // module are not valid after it is unloaded.
+  static void ClearTypeLayouts();
+
+ private:
+  // Offset from the address of the object and type of a field.
+  struct FieldLayout {
+    ULONG32 offset = 0;
+    CorElementType type = ELEMENT_TYPE_END;
+  };
+
+  // Size of an object of a type and the layouts of its instance fields.
+  struct TypeLayout {
+    ULONG32 object_size = 0;
+    std::map<mdFieldDef, FieldLayout> fields;
+  };
+
+  typedef std::pair<ULONG64, ULONG64> TypeLayoutKey;
+
+  // Looks up the layout of the type of the object and reads its memory.
+  HRESULT ReadObjectMemory();
+
+  // Gets the cached layout of type_id or reads it from debug_process.
+  static HRESULT GetTypeLayout(ICorDebugProcess5 *debug_process,
+                               const COR_TYPEID &type_id,
+                               std::shared_ptr<const TypeLayout> *layout);
+
+  CComPtr<ICorDebugObjectValue> object_value_;
+  CComPtr<ICorDebugModule> debug_module_;
+
+  // S_OK once the memory of the object is read and the result of the
+  // read if it failed.
+  HRESULT read_hr_ = S_FALSE;
+  bool read_ = false;
+
+  CORDB_ADDRESS address_ = 0;
+  std::shared_ptr<const TypeLayout> layout_;
+  std::vector<BYTE> memory_;
+
+  // Layouts of the types whose objects were read, keyed by type ID.
+  static std::map<TypeLayoutKey, std::shared_ptr<const TypeLayout>>
+      type_layouts_;
+
+  // Protects type_layouts_.
+  static std::mutex type_layouts_mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  OBJECT_FIELDS_MEMORY_H_
@@ -0,0 +1,146 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "overhead_governor.h"
+
+#include <algorithm>
+
+#include "constants.h"
+#include "cpu_sampler.h"
+#include "metrics.h"
+
+namespace google_cloud_debugger {
+
+const std::uint32_t OverheadGovernor::kReducedMaxStackFrames;
+const std::uint32_t OverheadGovernor::kReducedMaxStackFramesWithVariables;
+const std::uint32_t OverheadGovernor::kReducedMaxCollectionItems;
+const int OverheadGovernor::kReducedMaxDepth;
+
+OverheadGovernor &OverheadGovernor::Global() {
+  static OverheadGovernor governor;
+  return governor;
+}
+
+void OverheadGovernor::SetBudget(double budget) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  budget_ = std::max(budget, 0.0);
+  window_started_ = false;
+  level_.store(kNone, std::memory_order_relaxed);
+}
+
+void OverheadGovernor::Update(std::chrono::steady_clock::time_point now) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (budget_ <= 0 ||
+        (window_started_ &&
+         now - window_start_ < std::chrono::milliseconds(kOverheadWindowMs))) {
+      return;
+    }
+  }
+
+  std::uint64_t cpu_time_us = 0;
+  CpuSampler::ReadProcessCpuTime(&cpu_time_us);
+  UpdateWithUsage(now, cpu_time_us,
+                  DebuggerMetrics::Global().breakpoint_stop_time_us.GetSum());
+}
+
+void OverheadGovernor::UpdateWithUsage(
+    std::chrono::steady_clock::time_point now, std::uint64_t cpu_time_us,
+    std::uint64_t stop_time_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (budget_ <= 0) {
+    return;
+  }
+
+  if (window_started_) {
+    std::int64_t wall_time_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                              window_start_)
+            .count();
+    if (wall_time_us < kOverheadWindowMs * 1000) {
+      return;
+    }
+
+    std::uint64_t used_us =
+        std::max(cpu_time_us > window_cpu_time_us_
+                     ? cpu_time_us - window_cpu_time_us_
+                     : 0,
+                 stop_time_us > window_stop_time_us_
+                     ? stop_time_us - window_stop_time_us_
+                     : 0);
+    double overhead = static_cast<double>(used_us) / wall_time_us;
+    level_.store(GetNextLevel(GetLevel(), overhead, budget_),
+                 std::memory_order_relaxed);
+  }
+
+  window_started_ = true;
+  window_start_ = now;
+  window_cpu_time_us_ = cpu_time_us;
+  window_stop_time_us_ = stop_time_us;
+}
+
+bool OverheadGovernor::ShouldProcessLogPoint() {
+  if (GetLevel() < kSampledLogPoints) {
+    return true;
+  }
+  return log_point_hits_.fetch_add(1, std::memory_order_relaxed) %
+             kOverheadSampledLogPointHits ==
+         0;
+}
+
+OverheadGovernor::Level OverheadGovernor::GetNextLevel(Level level,
+                                                       double overhead,
+                                                       double budget) {
+  if (budget <= 0) {
+    return kNone;
+  }
+  if (overhead > budget && level < kPausedSnapshots) {
+    return static_cast<Level>(level + 1);
+  }
+  if (overhead < budget / 2 && level > kNone) {
+    return static_cast<Level>(level - 1);
+  }
+  return level;
+}
+
+CaptureLimits OverheadGovernor::ReduceLimits(const CaptureLimits &limits) {
+  CaptureLimits reduced = limits;
+  reduced.max_stack_frames =
+      std::min(reduced.max_stack_frames, kReducedMaxStackFrames);
+  reduced.max_stack_frames_with_variables =
+      std::min(reduced.max_stack_frames_with_variables,
+               kReducedMaxStackFramesWithVariables);
+  reduced.max_collection_items =
+      std::min(reduced.max_collection_items, kReducedMaxCollectionItems);
+  reduced.max_depth = std::min(reduced.max_depth, kReducedMaxDepth);
+  return reduced;
+}
+
+const std::string &OverheadGovernor::GetStatusMessage(Level level) {
+  static const std::string kNoMessage;
+  switch (level) {
+    case kNoPropertyEvaluation:
+      return kOverheadNoPropertyEvaluationMessage;
+    case kReducedLimits:
+      return kOverheadReducedLimitsMessage;
+    case kSampledLogPoints:
+      return kOverheadSampledLogPointsMessage;
+    case kPausedSnapshots:
+      return kOverheadPausedSnapshotsMessage;
+    default:
+      return kNoMessage;
+  }
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,121 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OVERHEAD_GOVERNOR_H_
+#define OVERHEAD_GOVERNOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "capture_limits.h"
+
+namespace google_cloud_debugger {
+
+// Keeps the overhead of the debugger within a budget by degrading the
+// work done at breakpoint hits. The overhead is the larger of the CPU
+// time used by the debugger process and the time threads of the
+// debuggee are stopped at breakpoints, as a fraction of the wall time.
+// It is measured over windows of kOverheadWindowMs. Every window with
+// an overhead above the budget degrades the work by one more level, and
+// every window with an overhead below half the budget restores one
+// level.
+class OverheadGovernor {
+ public:
+  // The levels of degradation. Each level also does what the levels
+  // before it do.
+  enum Level {
+    // Nothing is degraded.
+    kNone = 0,
+    // Properties are not evaluated.
+    kNoPropertyEvaluation,
+    // Snapshots and log points are captured with the limits of
+    // ReduceLimits.
+    kReducedLimits,
+    // Only one of every kOverheadSampledLogPointHits hits of log points
+    // is processed.
+    kSampledLogPoints,
+    // Hits of snapshots are skipped.
+    kPausedSnapshots,
+  };
+
+  // The limits of ReduceLimits.
+  static const std::uint32_t kReducedMaxStackFrames = 5;
+  static const std::uint32_t kReducedMaxStackFramesWithVariables = 1;
+  static const std::uint32_t kReducedMaxCollectionItems = 3;
+  static const int kReducedMaxDepth = 2;
+
+  OverheadGovernor() = default;
+  OverheadGovernor(const OverheadGovernor &) = delete;
+  OverheadGovernor &operator=(const OverheadGovernor &) = delete;
+
+  // Returns the governor of this debugger.
+  static OverheadGovernor &Global();
+
+  // Sets the budget as a fraction of the wall time and restores all the
+  // work. A budget of 0 disables the governor.
+  void SetBudget(double budget);
+
+  // Measures the overhead if a window has passed since the last
+  // measurement and updates the level. Cheap otherwise.
+  void Update(std::chrono::steady_clock::time_point now);
+
+  // Implements Update with the CPU time and the time stopped at
+  // breakpoints so far, in microseconds.
+  void UpdateWithUsage(std::chrono::steady_clock::time_point now,
+                       std::uint64_t cpu_time_us, std::uint64_t stop_time_us);
+
+  // Returns the current level.
+  Level GetLevel() const {
+    return static_cast<Level>(level_.load(std::memory_order_relaxed));
+  }
+
+  // Returns true if a hit of a log point should be processed.
+  bool ShouldProcessLogPoint();
+
+  // Returns the level after a window with an overhead of overhead at
+  // level when the budget is budget.
+  static Level GetNextLevel(Level level, double overhead, double budget);
+
+  // Returns limits that are no larger than limits or the kReduced
+  // limits above.
+  static CaptureLimits ReduceLimits(const CaptureLimits &limits);
+
+  // Returns the status message of the hits degraded at level, or an
+  // empty string for kNone.
+  static const std::string &GetStatusMessage(Level level);
+
+ private:
+  // The current Level.
+  std::atomic<int> level_{kNone};
+
+  // Counts the hits of log points while they are sampled.
+  std::atomic<std::uint64_t> log_point_hits_{0};
+
+  // The budget and the usage when the current window started.
+  double budget_ = 0;
+  bool window_started_ = false;
+  std::chrono::steady_clock::time_point window_start_;
+  std::uint64_t window_cpu_time_us_ = 0;
+  std::uint64_t window_stop_time_us_ = 0;
+
+  // Protects the members above except the atomic ones.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  OVERHEAD_GOVERNOR_H_
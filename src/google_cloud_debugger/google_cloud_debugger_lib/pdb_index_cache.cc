@@ -0,0 +1,249 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pdb_index_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "custom_binary_reader.h"
+
+using std::array;
+using std::cerr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace google_cloud_debugger_portable_pdb {
+
+namespace {
+
+// Identifies a cache file.
+const char kCacheMagic[] = {'G', 'C', 'D', 'B', 'G', 'I', 'D', 'X'};
+
+// Version of the format of the cache file. Has to be incremented whenever
+// the format or the content of MethodInfo changes.
+// Version 2 dropped the local scopes, which are parsed on demand.
+const uint32_t kCacheVersion = 2;
+
+// Extension of the cache files.
+const string kCacheExtension = ".index";
+
+void AppendUInt32(uint32_t value, string *buffer) {
+  buffer->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void AppendBool(bool value, string *buffer) {
+  buffer->push_back(value ? 1 : 0);
+}
+
+void AppendString(const string &value, string *buffer) {
+  AppendUInt32(value.size(), buffer);
+  buffer->append(value);
+}
+
+void AppendMethod(const MethodInfo &method, string *buffer) {
+  AppendUInt32(method.method_def, buffer);
+  AppendUInt32(method.first_line, buffer);
+  AppendUInt32(method.last_line, buffer);
+
+  AppendUInt32(method.sequence_points.size(), buffer);
+  for (auto &&sequence_point : method.sequence_points) {
+    AppendUInt32(sequence_point.il_offset, buffer);
+    AppendUInt32(sequence_point.start_line, buffer);
+    AppendUInt32(sequence_point.start_col, buffer);
+    AppendUInt32(sequence_point.end_line, buffer);
+    AppendUInt32(sequence_point.end_col, buffer);
+    AppendBool(sequence_point.is_hidden, buffer);
+  }
+}
+
+bool ReadBool(CustomBinaryStream *stream, bool *value) {
+  uint8_t byte;
+  if (!stream->ReadByte(&byte)) {
+    return false;
+  }
+
+  *value = byte != 0;
+  return true;
+}
+
+bool ReadString(CustomBinaryStream *stream, string *value) {
+  uint32_t size;
+  if (!stream->ReadUInt32(&size)) {
+    return false;
+  }
+
+  value->resize(size);
+  uint32_t bytes_read;
+  return size == 0 ||
+         stream->ReadBytes(reinterpret_cast<uint8_t *>(&(*value)[0]), size,
+                           &bytes_read);
+}
+
+// Reads a count of items that take at least min_item_size bytes each.
+// Fails if the stream cannot possibly contain that many items, so that
+// a corrupted count does not lead to a huge allocation.
+bool ReadCount(CustomBinaryStream *stream, uint32_t min_item_size,
+               uint32_t stream_size, uint32_t *count) {
+  if (!stream->ReadUInt32(count)) {
+    return false;
+  }
+
+  return static_cast<uint64_t>(*count) * min_item_size <= stream_size;
+}
+
+bool ReadMethod(CustomBinaryStream *stream, uint32_t stream_size,
+                MethodInfo *method) {
+  uint32_t count;
+  if (!stream->ReadUInt32(&method->method_def) ||
+      !stream->ReadUInt32(&method->first_line) ||
+      !stream->ReadUInt32(&method->last_line) ||
+      !ReadCount(stream, 21, stream_size, &count)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    SequencePoint sequence_point;
+    if (!stream->ReadUInt32(&sequence_point.il_offset) ||
+        !stream->ReadUInt32(&sequence_point.start_line) ||
+        !stream->ReadUInt32(&sequence_point.start_col) ||
+        !stream->ReadUInt32(&sequence_point.end_line) ||
+        !stream->ReadUInt32(&sequence_point.end_col) ||
+        !ReadBool(stream, &sequence_point.is_hidden)) {
+      return false;
+    }
+    method->sequence_points.push_back(sequence_point);
+  }
+  method->sequence_points.ShrinkToFit();
+
+  return true;
+}
+
+}  // namespace
+
+string PdbIndexCache::GetCacheFilePath(const string &directory,
+                                       const array<uint8_t, 20> &pdb_id) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  string file_name;
+  file_name.reserve(pdb_id.size() * 2 + kCacheExtension.size());
+  for (uint8_t byte : pdb_id) {
+    file_name.push_back(kHexDigits[byte >> 4]);
+    file_name.push_back(kHexDigits[byte & 0xF]);
+  }
+  file_name.append(kCacheExtension);
+
+  if (directory.empty() || directory.back() == '/' ||
+      directory.back() == '\\') {
+    return directory + file_name;
+  }
+  return directory + "/" + file_name;
+}
+
+bool PdbIndexCache::Write(const string &file,
+                          const vector<unique_ptr<IDocumentIndex>> &documents) {
+  string buffer(kCacheMagic, sizeof(kCacheMagic));
+  AppendUInt32(kCacheVersion, &buffer);
+  AppendUInt32(documents.size(), &buffer);
+  for (auto &&document : documents) {
+    AppendString(document->GetFilePath(), &buffer);
+    const vector<MethodInfo> &methods = document->GetMethods();
+    AppendUInt32(methods.size(), &buffer);
+    for (auto &&method : methods) {
+      AppendMethod(method, &buffer);
+    }
+  }
+
+  string temporary_file = file + ".tmp";
+  {
+    std::ofstream output(temporary_file,
+                         std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+      cerr << "Failed to open PDB index cache file " << temporary_file;
+      return false;
+    }
+
+    output.write(buffer.data(), buffer.size());
+    if (!output.good()) {
+      cerr << "Failed to write PDB index cache file " << temporary_file;
+      output.close();
+      std::remove(temporary_file.c_str());
+      return false;
+    }
+  }
+
+  // rename does not replace an existing file on Windows. In that case
+  // another debugger already wrote the same content.
+  if (std::rename(temporary_file.c_str(), file.c_str()) != 0) {
+    std::remove(temporary_file.c_str());
+  }
+  return true;
+}
+
+bool PdbIndexCache::Read(const string &file,
+                         const vector<unique_ptr<IDocumentIndex>> &documents,
+                         vector<vector<MethodInfo>> *methods) {
+  if (!methods) {
+    return false;
+  }
+
+  CustomBinaryStream stream;
+  if (!stream.ConsumeFile(file)) {
+    return false;
+  }
+
+  // Bound for the counts in the file.
+  uint32_t stream_size = stream.GetLength();
+
+  char magic[sizeof(kCacheMagic)];
+  uint32_t bytes_read;
+  uint32_t version;
+  uint32_t document_count;
+  if (!stream.ReadBytes(reinterpret_cast<uint8_t *>(magic), sizeof(magic),
+                        &bytes_read) ||
+      !std::equal(magic, magic + sizeof(magic), kCacheMagic) ||
+      !stream.ReadUInt32(&version) || version != kCacheVersion ||
+      !stream.ReadUInt32(&document_count) ||
+      document_count != documents.size()) {
+    cerr << "Ignoring invalid PDB index cache file " << file;
+    return false;
+  }
+
+  vector<vector<MethodInfo>> result(document_count);
+  for (size_t i = 0; i < document_count; ++i) {
+    string file_path;
+    uint32_t method_count;
+    if (!ReadString(&stream, &file_path) ||
+        file_path != documents[i]->GetFilePath() ||
+        !ReadCount(&stream, 20, stream_size, &method_count)) {
+      cerr << "Ignoring invalid PDB index cache file " << file;
+      return false;
+    }
+
+    result[i].resize(method_count);
+    for (auto &&method : result[i]) {
+      if (!ReadMethod(&stream, stream_size, &method)) {
+        cerr << "Ignoring invalid PDB index cache file " << file;
+        return false;
+      }
+    }
+  }
+
+  *methods = std::move(result);
+  return true;
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
@@ -0,0 +1,61 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PDB_INDEX_CACHE_H_
+#define PDB_INDEX_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "document_index.h"
+
+namespace google_cloud_debugger_portable_pdb {
+
+// On-disk cache of the methods of the documents of Portable PDBs.
+//
+// The PDB id identifies the content of a PDB, so the methods, sequence
+// points and local scopes parsed from a PDB can be saved in a file named
+// after the id and loaded instead of parsing the PDB again after a restart.
+// The document paths are saved as well and checked when the cache is read,
+// and the file starts with a format version, so a stale or foreign cache
+// file is ignored.
+class PdbIndexCache {
+ public:
+  // Returns the path of the cache file for the PDB with id pdb_id
+  // in directory.
+  static std::string GetCacheFilePath(const std::string &directory,
+                                      const std::array<uint8_t, 20> &pdb_id);
+
+  // Writes the methods of documents to file. The content is written to a
+  // temporary file first and then renamed, so readers never see a partial
+  // file.
+  static bool Write(
+      const std::string &file,
+      const std::vector<std::unique_ptr<IDocumentIndex>> &documents);
+
+  // Reads the methods saved in file into methods, one vector per document.
+  // Returns false if the file does not exist, is invalid or was written for
+  // documents with different paths.
+  static bool Read(
+      const std::string &file,
+      const std::vector<std::unique_ptr<IDocumentIndex>> &documents,
+      std::vector<std::vector<MethodInfo>> *methods);
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // PDB_INDEX_CACHE_H_
@@ -0,0 +1,74 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pdb_index_store.h"
+
+using std::array;
+using std::shared_ptr;
+using std::string;
+
+namespace google_cloud_debugger_portable_pdb {
+
+PdbIndexStore &PdbIndexStore::Global() {
+  static PdbIndexStore store;
+  return store;
+}
+
+shared_ptr<const DocumentMethods> PdbIndexStore::Find(
+    const array<uint8_t, 20> &pdb_id, uint32_t document,
+    const string &file_path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto &stored = documents_.find(Key(pdb_id, document));
+  if (stored == documents_.end() ||
+      stored->second.file_path != file_path) {
+    return nullptr;
+  }
+  return stored->second.methods.lock();
+}
+
+shared_ptr<const DocumentMethods> PdbIndexStore::Add(
+    const array<uint8_t, 20> &pdb_id, uint32_t document,
+    const string &file_path, shared_ptr<const DocumentMethods> methods) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StoredDocument &stored = documents_[Key(pdb_id, document)];
+  shared_ptr<const DocumentMethods> existing = stored.methods.lock();
+  if (existing && stored.file_path == file_path) {
+    return existing;
+  }
+
+  stored.file_path = file_path;
+  stored.methods = methods;
+  if (documents_.size() >= next_cleanup_size_) {
+    RemoveExpired();
+    next_cleanup_size_ = 2 * documents_.size() + 64;
+  }
+  return methods;
+}
+
+std::size_t PdbIndexStore::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return documents_.size();
+}
+
+void PdbIndexStore::RemoveExpired() {
+  for (auto it = documents_.begin(); it != documents_.end();) {
+    if (it->second.methods.expired()) {
+      it = documents_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
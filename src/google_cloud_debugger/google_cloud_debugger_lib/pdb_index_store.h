@@ -0,0 +1,92 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PDB_INDEX_STORE_H_
+#define PDB_INDEX_STORE_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "document_index.h"
+
+namespace google_cloud_debugger_portable_pdb {
+
+// In-memory store of the parsed methods of the documents of Portable PDBs,
+// keyed by PDB id and document.
+//
+// The PDB id identifies the content of a PDB, so when the debugger is
+// attached to several processes that run the same build (or a module is
+// loaded again), the PortablePdbFile of every process shares the methods
+// that the first one parsed instead of parsing and holding its own copy.
+// The path of every document is checked as well, like PdbIndexCache does.
+// The store only holds weak references: the methods of a document are
+// freed once no PortablePdbFile uses them.
+class PdbIndexStore {
+ public:
+  PdbIndexStore() = default;
+  PdbIndexStore(const PdbIndexStore &) = delete;
+  PdbIndexStore &operator=(const PdbIndexStore &) = delete;
+
+  // Returns the store shared by every PortablePdbFile of this debugger.
+  static PdbIndexStore &Global();
+
+  // Returns the methods of document of the PDB with id pdb_id, or null
+  // if no PortablePdbFile uses them or the document has another path.
+  std::shared_ptr<const DocumentMethods> Find(
+      const std::array<std::uint8_t, 20> &pdb_id, std::uint32_t document,
+      const std::string &file_path);
+
+  // Adds methods as the methods of document, at file_path, of the PDB
+  // with id pdb_id. Returns the methods already in the store if another
+  // PortablePdbFile added them first, and methods otherwise.
+  std::shared_ptr<const DocumentMethods> Add(
+      const std::array<std::uint8_t, 20> &pdb_id, std::uint32_t document,
+      const std::string &file_path,
+      std::shared_ptr<const DocumentMethods> methods);
+
+  // Returns the number of documents in the store, including the ones
+  // whose methods are freed but not removed yet.
+  std::size_t Size();
+
+ private:
+  typedef std::pair<std::array<std::uint8_t, 20>, std::uint32_t> Key;
+
+  // A document in the store.
+  struct StoredDocument {
+    std::string file_path;
+    std::weak_ptr<const DocumentMethods> methods;
+  };
+
+  // Removes the documents whose methods are freed. Must be called with
+  // mutex_ held.
+  void RemoveExpired();
+
+  // Protects the fields below.
+  std::mutex mutex_;
+
+  // The methods of the documents by PDB id and document.
+  std::map<Key, StoredDocument> documents_;
+
+  // The size of documents_ that triggers the next RemoveExpired.
+  std::size_t next_cleanup_size_ = 64;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // PDB_INDEX_STORE_H_
@@ -0,0 +1,89 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pdb_memory_limiter.h"
+
+#include <iterator>
+
+#include "i_portable_pdb_file.h"
+#include "metrics.h"
+
+namespace google_cloud_debugger_portable_pdb {
+
+PdbMemoryLimiter &PdbMemoryLimiter::Global() {
+  static PdbMemoryLimiter limiter;
+  return limiter;
+}
+
+void PdbMemoryLimiter::Touch(IPortablePdbFile *pdb, std::size_t bytes) {
+  if (limit_ == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = entries_by_pdb_.find(pdb);
+  if (found == entries_by_pdb_.end()) {
+    entries_.push_front(Entry{pdb, bytes});
+    entries_by_pdb_[pdb] = entries_.begin();
+  } else {
+    bytes_ -= found->second->bytes;
+    found->second->bytes = bytes;
+    entries_.splice(entries_.begin(), entries_, found->second);
+  }
+  bytes_ += bytes;
+
+  if (bytes_ > limit_) {
+    Evict();
+  }
+}
+
+void PdbMemoryLimiter::Remove(IPortablePdbFile *pdb) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = entries_by_pdb_.find(pdb);
+  if (found == entries_by_pdb_.end()) {
+    return;
+  }
+
+  bytes_ -= found->second->bytes;
+  entries_.erase(found->second);
+  entries_by_pdb_.erase(found);
+}
+
+std::size_t PdbMemoryLimiter::GetBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+void PdbMemoryLimiter::Evict() {
+  google_cloud_debugger::DebuggerMetrics &metrics =
+      google_cloud_debugger::DebuggerMetrics::Global();
+  // The most recently used PDB is the one being used.
+  auto entry = entries_.end();
+  while (bytes_ > limit_ && entry != entries_.begin() &&
+         std::prev(entry) != entries_.begin()) {
+    --entry;
+    std::size_t evicted = entry->pdb->EvictMethods();
+    if (evicted == 0) {
+      continue;
+    }
+
+    metrics.pdb_evictions.Increment();
+    metrics.pdb_evicted_bytes.Increment(evicted);
+    bytes_ -= entry->bytes;
+    entries_by_pdb_.erase(entry->pdb);
+    entry = entries_.erase(entry);
+  }
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
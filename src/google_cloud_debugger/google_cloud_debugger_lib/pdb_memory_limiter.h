@@ -0,0 +1,99 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PDB_MEMORY_LIMITER_H_
+#define PDB_MEMORY_LIMITER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace google_cloud_debugger_portable_pdb {
+
+class IPortablePdbFile;
+
+// Keeps the memory used by the parsed methods and local scopes of every
+// PDB under a limit.
+//
+// A PDB reports the bytes of its parsed methods every time it uses them,
+// which also makes it the most recently used. Once the total goes over
+// the limit, the methods of the least recently used PDBs are evicted
+// (see IPortablePdbFile::EvictMethods) until it is back under it. Their
+// metadata tables, heaps and document path index are kept, so
+// breakpoints still resolve to their documents and the methods are
+// parsed again the next time they are needed. PDBs whose methods are
+// pinned, such as the ones with breakpoints set, are skipped.
+//
+// There is no limit by default, in which case nothing is tracked.
+class PdbMemoryLimiter {
+ public:
+  PdbMemoryLimiter() = default;
+  PdbMemoryLimiter(const PdbMemoryLimiter &) = delete;
+  PdbMemoryLimiter &operator=(const PdbMemoryLimiter &) = delete;
+
+  // Returns the limiter shared by every PortablePdbFile of this debugger.
+  static PdbMemoryLimiter &Global();
+
+  // Sets the limit in bytes, or 0 for no limit. Has to be called before
+  // any PDB is parsed.
+  void SetLimit(std::size_t bytes) { limit_ = bytes; }
+
+  // Returns the limit set by SetLimit.
+  std::size_t GetLimit() const { return limit_; }
+
+  // Records that the parsed methods of pdb take bytes and that pdb is the
+  // most recently used, then evicts the methods of other PDBs if the
+  // total is over the limit. Must not be called with a lock of pdb held.
+  void Touch(IPortablePdbFile *pdb, std::size_t bytes);
+
+  // Forgets pdb, which is being destroyed.
+  void Remove(IPortablePdbFile *pdb);
+
+  // Returns the bytes of the parsed methods of the PDBs tracked.
+  std::size_t GetBytes();
+
+ private:
+  // A PDB tracked and the bytes of its parsed methods.
+  struct Entry {
+    IPortablePdbFile *pdb;
+    std::size_t bytes;
+  };
+
+  // Evicts the methods of the least recently used PDBs other than the
+  // most recently used one until bytes_ is at most limit_. Must be
+  // called with mutex_ held.
+  void Evict();
+
+  // The limit in bytes, or 0.
+  std::atomic<std::size_t> limit_{0};
+
+  // Protects the fields below.
+  std::mutex mutex_;
+
+  // The PDBs tracked, the most recently used first.
+  std::list<Entry> entries_;
+
+  // The entries of entries_ by PDB.
+  std::unordered_map<IPortablePdbFile *, std::list<Entry>::iterator>
+      entries_by_pdb_;
+
+  // The sum of the bytes of entries_.
+  std::size_t bytes_ = 0;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // PDB_MEMORY_LIMITER_H_
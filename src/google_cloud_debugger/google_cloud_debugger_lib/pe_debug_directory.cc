@@ -0,0 +1,226 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pe_debug_directory.h"
+
+#include <cstring>
+
+namespace google_cloud_debugger_portable_pdb {
+
+const std::uint32_t kCodeViewDebugType = 2;
+const std::uint32_t kEmbeddedPortablePdbDebugType = 17;
+
+namespace {
+
+// Offset of the offset of the PE signature in the DOS header.
+const std::size_t kPeSignatureOffsetOffset = 0x3C;
+
+// Size of the PE signature "PE\0\0" and of the COFF file header.
+const std::size_t kPeSignatureSize = 4;
+const std::size_t kCoffHeaderSize = 20;
+
+// Magic numbers of the optional header of PE32 and PE32+ files.
+const std::uint16_t kPe32Magic = 0x10B;
+const std::uint16_t kPe32PlusMagic = 0x20B;
+
+// Offsets of the number of data directories in the optional headers of
+// PE32 and PE32+ files. The data directories follow it.
+const std::size_t kPe32NumberOfRvaAndSizesOffset = 92;
+const std::size_t kPe32PlusNumberOfRvaAndSizesOffset = 108;
+
+// Index of the debug directory in the data directories.
+const std::uint32_t kDebugDirectoryIndex = 6;
+
+// Size of a section header and of a debug directory entry.
+const std::size_t kSectionHeaderSize = 40;
+const std::size_t kDebugDirectoryEntrySize = 28;
+
+// Signature "RSDS" of the data of a CodeView entry, and the size of the
+// signature, GUID and age in front of the PDB path.
+const std::uint32_t kCodeViewSignature = 0x53445352;
+const std::size_t kCodeViewHeaderSize = 24;
+
+// Reads the little-endian integer at offset in the size bytes at data.
+// Returns false if it does not fit.
+bool ReadUInt16(const std::uint8_t *data, std::size_t size,
+                std::size_t offset, std::uint16_t *result) {
+  if (offset > size || size - offset < 2) {
+    return false;
+  }
+  *result = data[offset] | (data[offset + 1] << 8);
+  return true;
+}
+
+bool ReadUInt32(const std::uint8_t *data, std::size_t size,
+                std::size_t offset, std::uint32_t *result) {
+  if (offset > size || size - offset < 4) {
+    return false;
+  }
+  *result = data[offset] | (data[offset + 1] << 8) |
+            (data[offset + 2] << 16) |
+            (static_cast<std::uint32_t>(data[offset + 3]) << 24);
+  return true;
+}
+
+}  // namespace
+
+bool ReadDebugDirectory(const std::uint8_t *image, std::size_t size,
+                        std::vector<DebugDirectoryEntry> *entries) {
+  entries->clear();
+  if (!image || size < 2 || image[0] != 'M' || image[1] != 'Z') {
+    return false;
+  }
+
+  std::uint32_t pe_offset;
+  if (!ReadUInt32(image, size, kPeSignatureOffsetOffset, &pe_offset) ||
+      pe_offset > size || size - pe_offset < kPeSignatureSize ||
+      memcmp(image + pe_offset, "PE\0\0", kPeSignatureSize) != 0) {
+    return false;
+  }
+
+  std::size_t coff_offset = pe_offset + kPeSignatureSize;
+  std::uint16_t number_of_sections;
+  std::uint16_t optional_header_size;
+  if (!ReadUInt16(image, size, coff_offset + 2, &number_of_sections) ||
+      !ReadUInt16(image, size, coff_offset + 16, &optional_header_size)) {
+    return false;
+  }
+
+  std::size_t optional_header_offset = coff_offset + kCoffHeaderSize;
+  std::uint16_t magic;
+  if (!ReadUInt16(image, size, optional_header_offset, &magic)) {
+    return false;
+  }
+
+  std::size_t number_of_rva_and_sizes_offset;
+  if (magic == kPe32Magic) {
+    number_of_rva_and_sizes_offset = kPe32NumberOfRvaAndSizesOffset;
+  } else if (magic == kPe32PlusMagic) {
+    number_of_rva_and_sizes_offset = kPe32PlusNumberOfRvaAndSizesOffset;
+  } else {
+    return false;
+  }
+
+  // A PE file without a debug directory has no entries.
+  std::uint32_t number_of_rva_and_sizes;
+  if (!ReadUInt32(image, size,
+                  optional_header_offset + number_of_rva_and_sizes_offset,
+                  &number_of_rva_and_sizes)) {
+    return false;
+  }
+  if (number_of_rva_and_sizes <= kDebugDirectoryIndex) {
+    return true;
+  }
+
+  // Each data directory is the RVA and size of a table.
+  std::size_t debug_directory_offset = optional_header_offset +
+                                       number_of_rva_and_sizes_offset + 4 +
+                                       kDebugDirectoryIndex * 8;
+  std::uint32_t debug_directory_rva;
+  std::uint32_t debug_directory_size;
+  if (!ReadUInt32(image, size, debug_directory_offset, &debug_directory_rva) ||
+      !ReadUInt32(image, size, debug_directory_offset + 4,
+                  &debug_directory_size)) {
+    return false;
+  }
+  if (debug_directory_rva == 0) {
+    return true;
+  }
+
+  // The debug directory is found through its RVA, so its offset in the
+  // file is found from the section that contains it.
+  std::size_t debug_directory_file_offset = 0;
+  bool found_section = false;
+  std::size_t sections_offset = optional_header_offset + optional_header_size;
+  for (std::uint16_t i = 0; i < number_of_sections; ++i) {
+    std::size_t section_offset = sections_offset + i * kSectionHeaderSize;
+    std::uint32_t virtual_address;
+    std::uint32_t raw_data_size;
+    std::uint32_t raw_data_offset;
+    if (!ReadUInt32(image, size, section_offset + 12, &virtual_address) ||
+        !ReadUInt32(image, size, section_offset + 16, &raw_data_size) ||
+        !ReadUInt32(image, size, section_offset + 20, &raw_data_offset)) {
+      return false;
+    }
+
+    if (debug_directory_rva >= virtual_address &&
+        debug_directory_rva - virtual_address < raw_data_size) {
+      debug_directory_file_offset =
+          raw_data_offset + (debug_directory_rva - virtual_address);
+      found_section = true;
+      break;
+    }
+  }
+
+  if (!found_section) {
+    return false;
+  }
+
+  for (std::size_t entry = 0;
+       entry < debug_directory_size / kDebugDirectoryEntrySize; ++entry) {
+    std::size_t entry_offset =
+        debug_directory_file_offset + entry * kDebugDirectoryEntrySize;
+    DebugDirectoryEntry debug_entry;
+    std::uint32_t data_offset;
+    if (!ReadUInt32(image, size, entry_offset + 12, &debug_entry.type) ||
+        !ReadUInt32(image, size, entry_offset + 16, &debug_entry.data_size) ||
+        !ReadUInt32(image, size, entry_offset + 24, &data_offset)) {
+      return false;
+    }
+
+    if (data_offset > size || size - data_offset < debug_entry.data_size) {
+      continue;
+    }
+
+    debug_entry.data = image + data_offset;
+    entries->push_back(debug_entry);
+  }
+
+  return true;
+}
+
+bool ReadCodeViewPdbInfo(const std::uint8_t *image, std::size_t size,
+                         CodeViewPdbInfo *pdb_info) {
+  std::vector<DebugDirectoryEntry> entries;
+  if (!ReadDebugDirectory(image, size, &entries)) {
+    return false;
+  }
+
+  for (const DebugDirectoryEntry &entry : entries) {
+    std::uint32_t signature;
+    if (entry.type != kCodeViewDebugType ||
+        !ReadUInt32(entry.data, entry.data_size, 0, &signature) ||
+        signature != kCodeViewSignature ||
+        entry.data_size < kCodeViewHeaderSize) {
+      continue;
+    }
+
+    memcpy(pdb_info->guid.data(), entry.data + 4, pdb_info->guid.size());
+    ReadUInt32(entry.data, entry.data_size, 20, &pdb_info->age);
+
+    // The path is null terminated.
+    const char *path =
+        reinterpret_cast<const char *>(entry.data + kCodeViewHeaderSize);
+    std::size_t max_length = entry.data_size - kCodeViewHeaderSize;
+    const void *null_char = memchr(path, 0, max_length);
+    pdb_info->path.assign(
+        path, null_char ? static_cast<const char *>(null_char) - path
+                        : max_length);
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
@@ -0,0 +1,67 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PE_DEBUG_DIRECTORY_H_
+#define PE_DEBUG_DIRECTORY_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace google_cloud_debugger_portable_pdb {
+
+// Types of the entries of the debug directory of a PE file. See
+// https://github.com/dotnet/corefx/blob/master/src/System.Reflection.Metadata/specs/PE-COFF.md
+extern const std::uint32_t kCodeViewDebugType;
+extern const std::uint32_t kEmbeddedPortablePdbDebugType;
+
+// An entry of the debug directory of a PE file.
+struct DebugDirectoryEntry {
+  // Type of the entry, for example kCodeViewDebugType.
+  std::uint32_t type = 0;
+
+  // The data of the entry in the image, and its size.
+  const std::uint8_t *data = nullptr;
+  std::uint32_t data_size = 0;
+};
+
+// Reads the entries of the debug directory of the size bytes of the PE
+// file at image. The entries point into image. Entries whose data is
+// not in image are skipped. Returns false if image is not a PE file.
+bool ReadDebugDirectory(const std::uint8_t *image, std::size_t size,
+                        std::vector<DebugDirectoryEntry> *entries);
+
+// The PDB a module was built with, as recorded in the CodeView entry of
+// the debug directory of the module.
+struct CodeViewPdbInfo {
+  // The GUID of the PDB id of the PDB, as stored in the PDB.
+  std::array<std::uint8_t, 16> guid = {};
+
+  // The age of the PDB. Always 1 for Portable PDBs.
+  std::uint32_t age = 0;
+
+  // The path of the PDB when the module was built.
+  std::string path;
+};
+
+// Reads the CodeView entry of the size bytes of the PE file at image into
+// pdb_info. Returns false if there is none.
+bool ReadCodeViewPdbInfo(const std::uint8_t *image, std::size_t size,
+                         CodeViewPdbInfo *pdb_info);
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // PE_DEBUG_DIRECTORY_H_
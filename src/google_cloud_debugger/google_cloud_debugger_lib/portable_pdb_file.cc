@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <algorithm>
 #include <array>
+#include <fstream>
 #include <iostream>
 #include <memory>
 
@@ -24,12 +25,22 @@
 #include "custom_binary_reader.h"
 #include "dbg_object.h"
 #include "i_cor_debug_helper.h"
+#include "memory_mapped_file.h"
+#include "memory_usage.h"
 #include "metadata_headers.h"
 #include "metadata_tables.h"
+#include "metrics.h"
+#include "pdb_index_cache.h"
+#include "pdb_index_store.h"
+#include "pdb_memory_limiter.h"
+#include "pe_debug_directory.h"
 
 using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::DebuggerMetrics;
+using google_cloud_debugger::GetMemoryUsage;
 using google_cloud_debugger::kDllExtension;
 using google_cloud_debugger::kPdbExtension;
+using google_cloud_debugger::ScopedLatencyTimer;
 using std::array;
 using std::streampos;
 using std::string;
@@ -38,28 +49,180 @@ using std::vector;
 
 namespace google_cloud_debugger_portable_pdb {
 
+namespace {
+
+// Directory of the PDB index cache. Empty if the cache is disabled.
+string index_cache_directory;
+
+// Protects index_cache_directory.
+std::mutex index_cache_directory_mutex;
+
+// The provider of the PDBs that are not next to their modules, or null.
+std::shared_ptr<IPdbProvider> pdb_provider;
+
+// Protects pdb_provider.
+std::mutex pdb_provider_mutex;
+
+// Returns the name of the PDB file next to the module file module_name,
+// or an empty string if module_name is not a dll.
+string GetAdjacentPdbName(const string &module_name) {
+  size_t last_dll_extension_pos = module_name.rfind(kDllExtension);
+  if (last_dll_extension_pos == string::npos ||
+      last_dll_extension_pos != module_name.size() - kDllExtension.size()) {
+    return string();
+  }
+
+  string pdb_name = module_name;
+  pdb_name.replace(last_dll_extension_pos, kDllExtension.size(),
+                   kPdbExtension);
+  return pdb_name;
+}
+
+// Reads the CodeView entry of the module file module_name into pdb_info.
+// has_embedded_pdb is set to true if the module embeds its PDB.
+bool ReadModulePdbInfo(const string &module_name, CodeViewPdbInfo *pdb_info,
+                       bool *has_embedded_pdb) {
+  MemoryMappedFile module;
+  if (!module.Open(module_name)) {
+    return false;
+  }
+
+  vector<DebugDirectoryEntry> entries;
+  if (!ReadDebugDirectory(module.GetData(), module.GetSize(), &entries)) {
+    return false;
+  }
+
+  *has_embedded_pdb = std::any_of(
+      entries.begin(), entries.end(), [](const DebugDirectoryEntry &entry) {
+        return entry.type == kEmbeddedPortablePdbDebugType;
+      });
+  return ReadCodeViewPdbInfo(module.GetData(), module.GetSize(), pdb_info);
+}
+
+}  // namespace
+
+void PortablePdbFile::SetIndexCacheDirectory(const string &directory) {
+  std::lock_guard<std::mutex> lock(index_cache_directory_mutex);
+  index_cache_directory = directory;
+}
+
+string PortablePdbFile::GetIndexCacheDirectory() {
+  std::lock_guard<std::mutex> lock(index_cache_directory_mutex);
+  return index_cache_directory;
+}
+
+void PortablePdbFile::SetPdbProvider(std::shared_ptr<IPdbProvider> provider) {
+  std::lock_guard<std::mutex> lock(pdb_provider_mutex);
+  pdb_provider = std::move(provider);
+}
+
+std::shared_ptr<IPdbProvider> PortablePdbFile::GetPdbProvider() {
+  std::lock_guard<std::mutex> lock(pdb_provider_mutex);
+  return pdb_provider;
+}
+
+bool PortablePdbFile::FetchPdb(const string &module_name) {
+  std::shared_ptr<IPdbProvider> provider = GetPdbProvider();
+  string pdb_name = GetAdjacentPdbName(module_name);
+  if (!provider || pdb_name.empty()) {
+    return false;
+  }
+
+  CodeViewPdbInfo pdb_info;
+  bool has_embedded_pdb = false;
+  if (!ReadModulePdbInfo(module_name, &pdb_info, &has_embedded_pdb) ||
+      has_embedded_pdb ||
+      std::ifstream(pdb_name, std::ios::in | std::ios::binary).good()) {
+    return false;
+  }
+
+  return provider->FetchPdb(pdb_info);
+}
+
+bool PortablePdbFile::ConsumeProvidedPdb(const string &module_name) {
+  std::shared_ptr<IPdbProvider> provider = GetPdbProvider();
+  if (!provider) {
+    return false;
+  }
+
+  CodeViewPdbInfo pdb_info;
+  bool has_embedded_pdb = false;
+  string pdb_path;
+  return ReadModulePdbInfo(module_name, &pdb_info, &has_embedded_pdb) &&
+         provider->FindPdb(pdb_info, &pdb_path) &&
+         pdb_file_binary_stream_.ConsumeFile(pdb_path);
+}
+
+MethodsMemoryFootprint PortablePdbFile::GetMethodsMemoryFootprint() const {
+  MethodsMemoryFootprint footprint;
+  for (auto &&document_index : document_indices_) {
+    for (auto &&method : document_index->GetMethods()) {
+      footprint.Add(method);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(scopes_mutex_);
+  for (auto &&method_scopes : method_scopes_) {
+    footprint.Add(*method_scopes.second);
+  }
+  return footprint;
+}
+
+bool PortablePdbFile::GetMethodScopes(uint32_t method_def,
+                                      const vector<Scope> **scopes) {
+  if (!scopes) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> parse_lock(parse_mutex_);
+    if (!parsed) {
+      return false;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(scopes_mutex_);
+  auto found = method_scopes_.find(method_def);
+  if (found != method_scopes_.end()) {
+    *scopes = found->second.get();
+    return true;
+  }
+
+  unique_ptr<vector<Scope>> method_scopes(new (std::nothrow) vector<Scope>());
+  if (!method_scopes ||
+      !DocumentIndex::ParseScopes(*this, method_def, method_scopes.get())) {
+    return false;
+  }
+
+  MethodsMemoryFootprint footprint;
+  footprint.Add(*method_scopes);
+  scope_memory_.Add(footprint.scope_bytes);
+
+  *scopes = method_scopes.get();
+  method_scopes_[method_def] = std::move(method_scopes);
+  return true;
+}
+
 bool PortablePdbFile::GetStream(const string &name,
                                 StreamHeader *stream_header) const {
-  assert(stream_header != nullptr);
+  return GetStream(GetMetadataStreamKind(name.data(), name.size()),
+                   stream_header);
+}
 
-  const auto &result =
-      std::find_if(stream_headers_.begin(), stream_headers_.end(),
-                   [&name](const StreamHeader &stream) {
-                     return name.compare(stream.name) == 0;
-                   });
+bool PortablePdbFile::GetStream(MetadataStreamKind kind,
+                                StreamHeader *stream_header) const {
+  assert(stream_header != nullptr);
 
-  if (result == stream_headers_.end()) {
+  if (kind == kUnknownStream || stream_headers_[kind].kind != kind) {
     return false;
   }
 
-  *stream_header = *result;
-
+  *stream_header = stream_headers_[kind];
   return true;
 }
 
 bool PortablePdbFile::InitializeStringsHeap() {
-  static const string kStringsHeapName = "#Strings";
-  return GetStream(kStringsHeapName, &string_heap_header_);
+  return GetStream(kStringsStream, &string_heap_header_);
 }
 
 bool PortablePdbFile::GetHeapString(uint32_t index, string *heap_string) const {
@@ -67,27 +230,34 @@ bool PortablePdbFile::GetHeapString(uint32_t index, string *heap_string) const {
                                            string_heap_header_.offset + index);
 }
 
-bool PortablePdbFile::GetBlobBytes(
-    uint32_t index, std::vector<uint8_t> *result) const {
-  return pdb_file_binary_stream_.GetBlobBytes(
-    blob_heap_header_.offset + index, result);
+bool PortablePdbFile::GetBlobSpan(uint32_t index, const uint8_t **data,
+                                  uint32_t *length) const {
+  return pdb_file_binary_stream_.GetBlobSpan(blob_heap_header_.offset + index,
+                                             data, length);
 }
 
 bool PortablePdbFile::ParsePdbFile() {
+  std::lock_guard<std::mutex> lock(parse_mutex_);
   if (parsed) {
     return true;
   }
 
-  string module_name = GetModuleName();
-  size_t last_dll_extension_pos = module_name.rfind(kDllExtension);
-  if (last_dll_extension_pos != module_name.size() - kDllExtension.size()) {
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  metrics.pdbs_parsed.Increment();
+  ScopedLatencyTimer parse_timer(&metrics.pdb_parse_time_us);
+
+  const string &module_name = GetModuleName();
+  string pdb_name = GetAdjacentPdbName(module_name);
+  if (pdb_name.empty()) {
     return false;
   }
 
-  module_name.replace(last_dll_extension_pos, kDllExtension.size(),
-                      kPdbExtension);
-
-  if (!pdb_file_binary_stream_.ConsumeFile(module_name)) {
+  // Release builds embed their PDB in the module. The PDB file next to
+  // the module is only looked up if there is none, and the PDB provider
+  // if neither exists.
+  if (!pdb_file_binary_stream_.ConsumeEmbeddedPdb(module_name) &&
+      !pdb_file_binary_stream_.ConsumeFile(pdb_name) &&
+      !ConsumeProvidedPdb(module_name)) {
     return false;
   }
 
@@ -95,14 +265,18 @@ bool PortablePdbFile::ParsePdbFile() {
     return false;
   }
 
-  stream_headers_.reserve(root_header_.number_streams);
+  // Only the first stream of each kind is used, like a lookup by name
+  // would find it.
   for (size_t i = 0; i < root_header_.number_streams; ++i) {
     StreamHeader stream_header;
     if (!ParseFrom(&pdb_file_binary_stream_, &stream_header)) {
       return false;
     }
 
-    stream_headers_.push_back(std::move(stream_header));
+    if (stream_header.kind != kUnknownStream &&
+        stream_headers_[stream_header.kind].kind == kUnknownStream) {
+      stream_headers_[stream_header.kind] = stream_header;
+    }
   }
 
   if (!InitializeBlobHeap() || !InitializeStringsHeap() ||
@@ -114,6 +288,8 @@ bool PortablePdbFile::ParsePdbFile() {
     return false;
   }
 
+  vector<DocumentIndex *> documents;
+  vector<string> document_paths;
   if (document_table_.size() > 1) {
     document_indices_.reserve(document_table_.size() - 1);
     for (size_t i = 1; i < document_table_.size(); ++i) {
@@ -122,17 +298,258 @@ bool PortablePdbFile::ParsePdbFile() {
       if (!document_index || !document_index->Initialize(*this, i)) {
         return false;
       }
+      documents.push_back(document_index.get());
+      document_paths.push_back(document_index->GetFilePath());
       document_indices_.push_back(std::move(document_index));
     }
   }
 
+  document_path_index_.Initialize(document_indices_);
+
+  // The paths of the documents share long prefixes, so they are moved to
+  // one front-coded table once the path index is built.
+  vector<uint32_t> path_positions;
+  document_paths_.Initialize(document_paths, &path_positions);
+  for (size_t i = 0; i < documents.size(); ++i) {
+    documents[i]->SetPathTable(&document_paths_, path_positions[i]);
+  }
+  documents_parsed_.assign(document_indices_.size(), false);
+
   parsed = true;
+  AccountMemory();
+  return true;
+}
+
+PortablePdbFile::~PortablePdbFile() {
+  PdbMemoryLimiter::Global().Remove(this);
+}
+
+bool PortablePdbFile::ParseMethods() {
+  size_t bytes;
+  {
+    std::lock_guard<std::mutex> lock(parse_mutex_);
+    if (!parsed || !ParseAllMethods()) {
+      return false;
+    }
+    bytes = GetEvictableBytes();
+  }
+
+  PdbMemoryLimiter::Global().Touch(this, bytes);
   return true;
 }
 
+bool PortablePdbFile::ParseDocumentMethods(size_t document) {
+  size_t bytes;
+  {
+    std::lock_guard<std::mutex> lock(parse_mutex_);
+    if (!parsed || document >= document_indices_.size()) {
+      return false;
+    }
+
+    if (!methods_parsed_ && !documents_parsed_[document]) {
+      // The index cache holds the methods of every document, so it is
+      // read and written for the whole PDB.
+      if (!GetIndexCacheDirectory().empty()) {
+        if (!ParseAllMethods()) {
+          return false;
+        }
+      } else {
+        if (!ParseMethodsOfDocument(document)) {
+          return false;
+        }
+        AccountMemory();
+      }
+    }
+    bytes = GetEvictableBytes();
+  }
+
+  PdbMemoryLimiter::Global().Touch(this, bytes);
+  return true;
+}
+
+void PortablePdbFile::PinMethods() { ++method_pins_; }
+
+void PortablePdbFile::UnpinMethods() { --method_pins_; }
+
+size_t PortablePdbFile::EvictMethods() {
+  // A PDB being parsed is in use.
+  std::unique_lock<std::mutex> lock(parse_mutex_, std::try_to_lock);
+  if (!lock.owns_lock() || !parsed || method_pins_ > 0) {
+    return 0;
+  }
+
+  size_t bytes = GetEvictableBytes();
+  for (auto &&document_index : document_indices_) {
+    document_index->SetSharedMethods(nullptr);
+  }
+  documents_parsed_.assign(document_indices_.size(), false);
+  methods_parsed_ = false;
+  vector<vector<uint32_t>>().swap(methods_by_document_);
+  {
+    std::lock_guard<std::mutex> scopes_lock(scopes_mutex_);
+    method_scopes_.clear();
+    scope_memory_.Set(0);
+  }
+
+  AccountMemory();
+  return bytes;
+}
+
+bool PortablePdbFile::ParseAllMethods() {
+  if (methods_parsed_) {
+    return true;
+  }
+
+  // Another process of the same build may have parsed every document.
+  bool all_stored = true;
+  for (size_t i = 0; i < document_indices_.size(); ++i) {
+    all_stored = UseStoredDocumentMethods(i) && all_stored;
+  }
+  if (all_stored) {
+    methods_parsed_ = true;
+    AccountMemory();
+    return true;
+  }
+
+  string cache_file;
+  string cache_directory = GetIndexCacheDirectory();
+  if (!cache_directory.empty()) {
+    cache_file = PdbIndexCache::GetCacheFilePath(cache_directory,
+                                                 pdb_metadata_header_.pdb_id);
+    vector<vector<MethodInfo>> cached_methods;
+    if (PdbIndexCache::Read(cache_file, document_indices_, &cached_methods)) {
+      // The documents that are already parsed may be in use.
+      for (size_t i = 0; i < document_indices_.size(); ++i) {
+        if (!documents_parsed_[i]) {
+          document_indices_[i]->SetMethods(std::move(cached_methods[i]));
+          ShareDocumentMethods(i);
+          documents_parsed_[i] = true;
+        }
+      }
+
+      methods_parsed_ = true;
+      AccountMemory();
+      return true;
+    }
+  }
+
+  for (size_t i = 0; i < document_indices_.size(); ++i) {
+    if (!ParseMethodsOfDocument(i)) {
+      return false;
+    }
+  }
+
+  if (!cache_file.empty() &&
+      !PdbIndexCache::Write(cache_file, document_indices_)) {
+    std::cerr << "Failed to cache the methods of " << module_name_;
+  }
+
+  methods_parsed_ = true;
+  AccountMemory();
+  return true;
+}
+
+bool PortablePdbFile::ParseMethodsOfDocument(size_t document) {
+  if (documents_parsed_[document] || UseStoredDocumentMethods(document)) {
+    return true;
+  }
+
+  // Groups the methods by document in a single pass over the
+  // MethodDebugInformation table instead of one pass per document. Only
+  // the Document column is read, the sequence point blobs are decoded by
+  // the document that owns them.
+  if (methods_by_document_.empty()) {
+    methods_by_document_.resize(document_indices_.size());
+    for (size_t method_def = 1; method_def < method_debug_info_table_.size();
+         ++method_def) {
+      uint32_t owner = method_debug_info_table_[method_def].document;
+      if (owner == 0 || owner > document_indices_.size()) {
+        continue;
+      }
+      methods_by_document_[owner - 1].push_back(method_def);
+    }
+  }
+
+  if (!document_indices_[document]->ParseMethods(
+          *this, methods_by_document_[document])) {
+    return false;
+  }
+
+  ShareDocumentMethods(document);
+  documents_parsed_[document] = true;
+  // The method defs are not needed once the document is parsed.
+  vector<uint32_t>().swap(methods_by_document_[document]);
+  return true;
+}
+
+bool PortablePdbFile::UseStoredDocumentMethods(size_t document) {
+  if (documents_parsed_[document]) {
+    return true;
+  }
+
+  IDocumentIndex &document_index = *document_indices_[document];
+  std::shared_ptr<const DocumentMethods> stored =
+      PdbIndexStore::Global().Find(pdb_metadata_header_.pdb_id, document,
+                                   document_index.GetFilePath());
+  if (!stored) {
+    return false;
+  }
+
+  document_index.SetSharedMethods(std::move(stored));
+  documents_parsed_[document] = true;
+  if (!methods_by_document_.empty()) {
+    vector<uint32_t>().swap(methods_by_document_[document]);
+  }
+  return true;
+}
+
+void PortablePdbFile::ShareDocumentMethods(size_t document) {
+  IDocumentIndex &document_index = *document_indices_[document];
+  std::shared_ptr<const DocumentMethods> parsed =
+      document_index.GetSharedMethods();
+  if (!parsed) {
+    return;
+  }
+
+  // Another PortablePdbFile may have added the document in the meantime,
+  // in which case its methods are used so that only one copy is kept.
+  std::shared_ptr<const DocumentMethods> stored = PdbIndexStore::Global().Add(
+      pdb_metadata_header_.pdb_id, document, document_index.GetFilePath(),
+      parsed);
+  if (stored != parsed) {
+    document_index.SetSharedMethods(std::move(stored));
+  }
+}
+
+void PortablePdbFile::AccountMemory() {
+  // The metadata tables are views over the content of the stream, which
+  // is charged as heap memory if it is not memory-mapped.
+  table_memory_.Set(
+      GetMemoryUsage(metadata_table_header_.num_rows) +
+      GetMemoryUsage(pdb_metadata_header_.type_system_table_rows));
+  heap_memory_.Set(pdb_file_binary_stream_.GetMemoryUsage());
+
+  size_t document_index_bytes = GetMemoryUsage(document_indices_) +
+                                document_paths_.GetMemoryUsage();
+  method_bytes_ = 0;
+  for (auto &&document_index : document_indices_) {
+    document_index_bytes += sizeof(DocumentIndex) +
+                            GetMemoryUsage(document_index->GetContentHash());
+    method_bytes_ += GetMemoryUsage(document_index->GetMethods());
+  }
+  // The local scopes are charged to scope_memory_ when they are parsed.
+  MethodsMemoryFootprint footprint = GetMethodsMemoryFootprint();
+  method_bytes_ += footprint.sequence_point_bytes;
+  document_index_memory_.Set(document_index_bytes + method_bytes_);
+}
+
+size_t PortablePdbFile::GetEvictableBytes() const {
+  std::lock_guard<std::mutex> lock(scopes_mutex_);
+  return method_bytes_ + scope_memory_.Get();
+}
+
 bool PortablePdbFile::InitializeBlobHeap() {
-  static const string kBlobHeapName = "#Blob";
-  return GetStream(kBlobHeapName, &blob_heap_header_);
+  return GetStream(kBlobStream, &blob_heap_header_);
 }
 
 bool PortablePdbFile::GetDocumentName(uint32_t index, string *doc_name) const {
@@ -213,82 +630,37 @@ bool PortablePdbFile::GetDocumentName(uint32_t index, string *doc_name) const {
   return true;
 }
 
-bool PortablePdbFile::GetHeapGuid(uint32_t index, string *guid) const {
+bool PortablePdbFile::GetHeapGuidSpan(uint32_t index,
+                                      const uint8_t **guid) const {
   // GUID are 16 bytes. Index is 1-based so we have to minus 1.
-  uint32_t offset = (index - 1) * 16;
-
-  if (!pdb_file_binary_stream_.SeekFromOrigin(guid_heap_header_.offset +
-                                              offset)) {
-    return false;
-  }
-
-  guid->clear();
-  vector<uint8_t> bytes_read(16, 0);
-  uint32_t num_bytes_read;
-
-  if (!pdb_file_binary_stream_.ReadBytes(bytes_read.data(), bytes_read.size(),
-                                         &num_bytes_read)) {
-    std::cerr << "Failed to read from GUID heap.";
+  if (index == 0 || (index - 1) >= guid_heap_header_.size / kGuidSize) {
+    std::cerr << "GUID index " << index << " is out of the GUID heap.";
     return false;
   }
 
-  guid->append(bytes_read.begin(), bytes_read.end());
-  return true;
-}
-
-bool PortablePdbFile::GetHash(uint32_t index, vector<uint8_t> *hash) const {
-  if (!pdb_file_binary_stream_.SeekFromOrigin(blob_heap_header_.offset +
-                                              index)) {
-    return false;
-  }
-
-  uint32_t data_length;
-  if (!pdb_file_binary_stream_.ReadCompressedUInt32(&data_length)) {
-    return false;
-  }
-
-  hash->resize(data_length);
-  uint32_t bytes_read = 0;
-  if (!pdb_file_binary_stream_.ReadBytes(hash->data(), hash->size(),
-                                         &bytes_read)) {
-    std::cerr << "Failed to read the hash from the heap blob stream.";
-    return false;
-  }
-
-  return true;
+  return pdb_file_binary_stream_.GetSpan(
+      guid_heap_header_.offset + (index - 1) * kGuidSize, kGuidSize, guid);
 }
 
 bool PortablePdbFile::GetMethodSeqInfo(
     uint32_t doc_index, uint32_t sequence_index,
     MethodSequencePointInformation *sequence_point_info) const {
-  if (!pdb_file_binary_stream_.SeekFromOrigin(blob_heap_header_.offset +
-                                              sequence_index)) {
-    return false;
-  }
-
-  uint32_t data_length;
-  if (!pdb_file_binary_stream_.ReadCompressedUInt32(&data_length)) {
+  const uint8_t *blob;
+  uint32_t blob_size;
+  if (!GetBlobSpan(sequence_index, &blob, &blob_size)) {
     return false;
   }
 
-  if (!pdb_file_binary_stream_.SetStreamLength(data_length)) {
-    return false;
-  }
-
-  bool result =
-      ParseFrom(doc_index, &pdb_file_binary_stream_, sequence_point_info);
-  pdb_file_binary_stream_.ResetStreamLength();
-  return result;
+  return ParseFrom(doc_index, blob, blob_size, sequence_point_info);
 }
 
 bool PortablePdbFile::InitializeGuidHeap() {
-  static const string kGuidHeapName = "#GUID";
-  return GetStream(kGuidHeapName, &guid_heap_header_);
+  return GetStream(kGuidStream, &guid_heap_header_);
 }
 
 bool PortablePdbFile::ParsePortablePdbStream() {
   StreamHeader pdb_stream_header;
-  if (!GetStream("#Pdb", &pdb_stream_header)) {
+  if (!GetStream(kPdbStream, &pdb_stream_header)) {
     return false;
   }
 
@@ -308,13 +680,12 @@ bool PortablePdbFile::ParsePortablePdbStream() {
 }
 
 bool PortablePdbFile::ParseCompressedMetadataTableStream() {
-  static const string kCompressedStreamName = "#~";
   // NOTE: The sizes of references to type system tables are determined using
   // the algorithm described in ECMA -335-II Chapter 24.2.6, except their
   // respective row counts are found in TypeSystemTableRows field of the #Pdb
   // stream.
   StreamHeader compressed_stream_header;
-  if (!GetStream(kCompressedStreamName, &compressed_stream_header)) {
+  if (!GetStream(kCompressedTablesStream, &compressed_stream_header)) {
     return false;
   }
 
@@ -344,6 +715,10 @@ bool PortablePdbFile::ParseCompressedMetadataTableStream() {
     }
   }
 
+  // The index widths only depend on the header, so they are computed once
+  // for all the tables.
+  MetadataIndexSizes index_sizes = GetIndexSizes(metadata_table_header_);
+
   // Confirm the PDB only contains PDB-related metadata tables.
   for (size_t i = 0; i < rows_per_table[MetadataTable::Document]; i++) {
     if (rows_per_table[i] != 0) {
@@ -353,35 +728,35 @@ bool PortablePdbFile::ParseCompressedMetadataTableStream() {
   }
 
   if (!ParseMetadataTableRow<DocumentRow>(
-          rows_per_table[MetadataTable::Document], &pdb_file_binary_stream_,
-          &document_table_)) {
+          rows_per_table[MetadataTable::Document], index_sizes,
+          &pdb_file_binary_stream_, &document_table_)) {
     pdb_file_binary_stream_.ResetStreamLength();
     return false;
   }
 
   if (!ParseMetadataTableRow<MethodDebugInformationRow>(
-          rows_per_table[MetadataTable::MethodDebugInformation],
+          rows_per_table[MetadataTable::MethodDebugInformation], index_sizes,
           &pdb_file_binary_stream_, &method_debug_info_table_)) {
     pdb_file_binary_stream_.ResetStreamLength();
     return false;
   }
 
   if (!ParseMetadataTableRow<LocalScopeRow>(
-          rows_per_table[MetadataTable::LocalScope], &pdb_file_binary_stream_,
-          &local_scope_table_)) {
+          rows_per_table[MetadataTable::LocalScope], index_sizes,
+          &pdb_file_binary_stream_, &local_scope_table_)) {
     pdb_file_binary_stream_.ResetStreamLength();
     return false;
   }
 
   if (!ParseMetadataTableRow<LocalVariableRow>(
-          rows_per_table[MetadataTable::LocalVariable],
+          rows_per_table[MetadataTable::LocalVariable], index_sizes,
           &pdb_file_binary_stream_, &local_variable_table_)) {
     pdb_file_binary_stream_.ResetStreamLength();
     return false;
   }
 
   if (!ParseMetadataTableRow<LocalConstantRow>(
-          rows_per_table[MetadataTable::LocalConstant],
+          rows_per_table[MetadataTable::LocalConstant], index_sizes,
           &pdb_file_binary_stream_, &local_constant_table_)) {
     pdb_file_binary_stream_.ResetStreamLength();
     return false;
@@ -411,12 +786,26 @@ HRESULT PortablePdbFile::Initialize(ICorDebugModule *debug_module,
     return hr;
   }
 
-  module_name_ = google_cloud_debugger::ConvertWCharPtrToString(module_name);
+  // A background parse started by InitializeFromModuleFile may be reading
+  // the name, which is the same.
+  string name = google_cloud_debugger::ConvertWCharPtrToString(module_name);
+  if (module_name_ != name) {
+    module_name_ = std::move(name);
+  }
   debug_module_ = debug_module;
 
   return S_OK;
 }
 
+HRESULT PortablePdbFile::InitializeFromModuleFile(const string &module_name) {
+  if (GetAdjacentPdbName(module_name).empty()) {
+    return E_INVALIDARG;
+  }
+
+  module_name_ = module_name;
+  return S_OK;
+}
+
 HRESULT PortablePdbFile::GetDebugModule(ICorDebugModule **debug_module) const {
   if (!debug_module) {
     return E_INVALIDARG;
@@ -15,61 +15,132 @@
 #ifndef PORTABLE_PDB_H_
 #define PORTABLE_PDB_H_
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "custom_binary_reader.h"
+#include "front_coded_string_table.h"
+#include "i_pdb_provider.h"
 #include "i_portable_pdb_file.h"
 #include "metadata_headers.h"
+#include "metrics.h"
+#include "module_type_dictionary.h"
 
 namespace google_cloud_debugger_portable_pdb {
 
 // PortablePDB file. Wraps all the gory details of PE headers and metadata
 // compression.
 //
-// The file format is very information dense, and we expand all of the
-// compressed metadata into arrays which are exposed as read only vectors.
-// If load time and/or memory pressure become concerns, an alternative
-// implemenation could lock the file and generate the necessary structures
-// on-demand.
+// The file format is very information dense. The metadata tables are not
+// expanded: they are exposed as read only MetadataTableViews over the
+// content of the file, whose rows are decoded on access.
 //
 // To use this class, creates a PortablePdbFile object and calls Initialize
 // with an ICorDebugModule object. Then, calls the ParsePdb method to parse
-// the PDB file for the module.
+// the PDB file for the module. ParsePdb only reads the metadata tables and
+// the document names, which is enough to find the document of a breakpoint.
+// The methods of a document are parsed the first time ParseDocumentMethods
+// is called for it (or ParseMethods for all documents), so their sequence
+// points and local scopes are only expanded for the documents that
+// breakpoints and stack frames actually use. Under a PdbMemoryLimiter
+// limit, the parsed methods of the PDBs used least recently are freed
+// and parsed again the next time they are needed.
 class PortablePdbFile : public IPortablePdbFile {
  public:
+  PortablePdbFile() = default;
+  PortablePdbFile(const PortablePdbFile &) = delete;
+  PortablePdbFile &operator=(const PortablePdbFile &) = delete;
+
+  // Stops tracking the methods of this PDB in PdbMemoryLimiter.
+  ~PortablePdbFile();
+
   // Populates the name, metadata import and debug module.
   // This function will returns error if the name of the module
   // does not end with ".dll".
+  // The PDB can already be parsed (or be being parsed) for the same
+  // module through InitializeFromModuleFile.
   HRESULT Initialize(ICorDebugModule *debug_module,
                      google_cloud_debugger::ICorDebugHelper *debug_helper);
 
+  // Populates the name only, so that the PDB of the module file
+  // module_name can be parsed before the module is loaded. Initialize has
+  // to be called once it is loaded to populate the rest.
+  HRESULT InitializeFromModuleFile(const std::string &module_name);
+
   // Parses the pdb file. The name of the file will come from the
   // ICorDebugModule object that is used to initialize this object.
   bool ParsePdbFile();
 
+  // Parses the methods of every document in the pdb file. ParsePdbFile
+  // must have succeeded. Does nothing if the methods are already parsed.
+  bool ParseMethods();
+
+  // Parses the methods of the document at index document of the document
+  // index table only. ParsePdbFile must have succeeded. Does nothing if
+  // the methods of the document are already parsed.
+  bool ParseDocumentMethods(std::size_t document);
+
+  // Pins the parsed methods and local scopes of this PDB.
+  void PinMethods();
+
+  // Undoes one PinMethods.
+  void UnpinMethods();
+
+  // Frees the parsed methods and local scopes of this PDB unless they are
+  // pinned or another thread is parsing them. Returns the bytes freed.
+  std::size_t EvictMethods();
+
+  // Sets the directory of the on-disk cache of parsed methods (see
+  // PdbIndexCache) used by every PortablePdbFile. The cache is disabled
+  // if directory is empty, which is the default.
+  static void SetIndexCacheDirectory(const std::string &directory);
+
+  // Returns the directory set by SetIndexCacheDirectory.
+  static std::string GetIndexCacheDirectory();
+
+  // Sets the provider of the PDBs of the modules that have neither an
+  // embedded PDB nor a PDB file next to them, used by every
+  // PortablePdbFile. There is none by default.
+  static void SetPdbProvider(std::shared_ptr<IPdbProvider> provider);
+
+  // Returns the provider set by SetPdbProvider, or null.
+  static std::shared_ptr<IPdbProvider> GetPdbProvider();
+
+  // Fetches the PDB of the module file module_name through the PDB
+  // provider, so that parsing the PDB of the module does not wait for
+  // it. Returns true if the provider has the PDB now, and false if there
+  // is no provider, the module has its own PDB or no CodeView entry, or
+  // the fetch fails. This may block on the network.
+  static bool FetchPdb(const std::string &module_name);
+
   // Finds the stream header with a given name. Returns false if not found.
   // name is the name of the stream header.
   // stream_header is the stream header that has name name.
   bool GetStream(const std::string &name, StreamHeader *stream_header) const;
 
+  // Same as GetStream but finds the stream by its kind.
+  bool GetStream(MetadataStreamKind kind, StreamHeader *stream_header) const;
+
   // Get string from the heap at index index.
   bool GetHeapString(std::uint32_t index, std::string *result) const;
 
-  // Get bytes from blob at index index.
-  bool GetBlobBytes(std::uint32_t index, std::vector<uint8_t> *result) const;
+  // Gets the bytes of the blob at index index.
+  bool GetBlobSpan(std::uint32_t index, const std::uint8_t **data,
+                   std::uint32_t *length) const;
 
   // Retrieves the name of a document using the provided blob heap index.
   // The exact conversion from a blob to document name is in the Portable PDB
   // spec. Returns true if succeeds.
   bool GetDocumentName(std::uint32_t index, std::string *doc_name) const;
 
-  // Gets GUID based on index;
-  bool GetHeapGuid(std::uint32_t index, std::string *guid) const;
-
-  // Gets the hash based on index.
-  bool GetHash(std::uint32_t index, std::vector<std::uint8_t> *hash) const;
+  // Gets the bytes of the GUID at index index.
+  bool GetHeapGuidSpan(std::uint32_t index, const std::uint8_t **guid) const;
 
   // Gets the method sequence information based on index.
   bool GetMethodSeqInfo(
@@ -77,28 +148,28 @@ class PortablePdbFile : public IPortablePdbFile {
       MethodSequencePointInformation *sequence_point_info) const;
 
   // Returns the document table.
-  const std::vector<DocumentRow> &GetDocumentTable() const {
+  MetadataTableView<DocumentRow> GetDocumentTable() const {
     return document_table_;
   }
 
   // Returns the local scope table.
-  const std::vector<LocalScopeRow> &GetLocalScopeTable() const {
+  MetadataTableView<LocalScopeRow> GetLocalScopeTable() const {
     return local_scope_table_;
   }
 
   // Returns the local variable table.
-  const std::vector<LocalVariableRow> &GetLocalVariableTable() const {
+  MetadataTableView<LocalVariableRow> GetLocalVariableTable() const {
     return local_variable_table_;
   }
 
   // Returns the method debug info table.
-  const std::vector<MethodDebugInformationRow> &GetMethodDebugInfoTable()
+  MetadataTableView<MethodDebugInformationRow> GetMethodDebugInfoTable()
       const {
     return method_debug_info_table_;
   }
 
   // Returns the local constant table.
-  const std::vector<LocalConstantRow> &GetLocalConstantTable() const {
+  MetadataTableView<LocalConstantRow> GetLocalConstantTable() const {
     return local_constant_table_;
   }
 
@@ -108,15 +179,45 @@ class PortablePdbFile : public IPortablePdbFile {
     return document_indices_;
   }
 
+  // Returns the index of the file paths of the documents in the
+  // document index table.
+  const DocumentPathIndex &GetDocumentPathIndex() const {
+    return document_path_index_;
+  }
+
+  // Gets the local scopes of method method_def. They are parsed the first
+  // time they are asked for and then kept until the methods of this PDB
+  // are evicted, so *scopes is
+  // valid as long as the methods of the PDB are pinned (see PinMethods).
+  // ParsePdbFile must have succeeded.
+  bool GetMethodScopes(std::uint32_t method_def,
+                       const std::vector<Scope> **scopes);
+
+  // Returns the memory used by the parsed methods of this PDB.
+  // The footprint only has the documents and methods that have been
+  // parsed.
+  MethodsMemoryFootprint GetMethodsMemoryFootprint() const;
+
   // Gets the name of the module of this PDB.
   const std::string &GetModuleName() const { return module_name_; }
 
+  // Gets the id of this PDB.
+  const std::array<std::uint8_t, 20> &GetPdbId() const {
+    return pdb_metadata_header_.pdb_id;
+  }
+
   // Gets the ICorDebugModule of the module of this PDB.
   HRESULT GetDebugModule(ICorDebugModule **debug_module) const;
 
   // Gets the MetadataImport of the module of this PDB.
   HRESULT GetMetaDataImport(IMetaDataImport **metadata_import) const;
 
+  // Gets the dictionary of the types of the module of this PDB.
+  std::shared_ptr<google_cloud_debugger::ModuleTypeDictionary>
+  GetTypeDictionary() const {
+    return type_dictionary_;
+  }
+
  private:
   // Name of the module that corresponds to this PDB.
   std::string module_name_;
@@ -126,7 +227,10 @@ class PortablePdbFile : public IPortablePdbFile {
 
   // Not all PDB-specific metadata tables implemented/exposed.
   MetadataRootHeader root_header_;
-  std::vector<StreamHeader> stream_headers_;
+
+  // The headers of the streams the debugger reads, by MetadataStreamKind.
+  // The kind of a slot is kUnknownStream if the PDB has no such stream.
+  std::array<StreamHeader, kNumberOfStreamKinds> stream_headers_;
 
   // Stream header for the Strings heap.
   StreamHeader string_heap_header_;
@@ -145,48 +249,61 @@ class PortablePdbFile : public IPortablePdbFile {
 
   // PDB-specific metadata tables. All are 1-indexed, and contain a zeroed out
   // entry at index 0.
-  std::vector<DocumentRow> document_table_;
-  std::vector<MethodDebugInformationRow> method_debug_info_table_;
-  std::vector<LocalScopeRow> local_scope_table_;
-  std::vector<LocalVariableRow> local_variable_table_;
-  std::vector<LocalConstantRow> local_constant_table_;
+  MetadataTableView<DocumentRow> document_table_;
+  MetadataTableView<MethodDebugInformationRow> method_debug_info_table_;
+  MetadataTableView<LocalScopeRow> local_scope_table_;
+  MetadataTableView<LocalVariableRow> local_variable_table_;
+  MetadataTableView<LocalConstantRow> local_constant_table_;
 
-  // Vectors that contains all the strings in the Strings Heap.
-  // This vector is used to cache the strings.
-  mutable std::vector<std::string> heap_strings_;
+  // The file paths of the documents in document_indices_.
+  FrontCodedStringTable document_paths_;
 
   // Vector of all document indices inside this pdb.
   std::vector<std::unique_ptr<IDocumentIndex>> document_indices_;
 
+  // Index of the file paths of the documents in document_indices_.
+  DocumentPathIndex document_path_index_;
+
   // The ICorDebugModule of the module of this PDB.
   google_cloud_debugger::CComPtr<ICorDebugModule> debug_module_;
 
   // The IMetaDataImport of the module of this PDB.
   google_cloud_debugger::CComPtr<IMetaDataImport> metadata_import_;
 
-  // Template function to parse row for a specific metadata table.
+  // Types of the module, populated by the first stack frame that looks
+  // up a class.
+  std::shared_ptr<google_cloud_debugger::ModuleTypeDictionary>
+      type_dictionary_ =
+          std::make_shared<google_cloud_debugger::ModuleTypeDictionary>();
+
+  // Template function to set up the view of a specific metadata table,
+  // whose rows_in_table rows start at the current position of
+  // binary_stream. Advances binary_stream past the table.
   template <typename TableRow>
   bool ParseMetadataTableRow(uint32_t rows_in_table,
+                             const MetadataIndexSizes &sizes,
                              CustomBinaryStream *binary_stream,
-                             std::vector<TableRow> *table) {
+                             MetadataTableView<TableRow> *table) {
     if (!binary_stream || !table) {
       return false;
     }
 
-    // Metadata row indicies are all 1-indexed. So always leave a 0th row that
-    // is empty.
-    table->resize(rows_in_table + 1);
-    for (size_t i = 0; i < rows_in_table; i++) {
-      TableRow row;
-      if (!ParseFrom(binary_stream, metadata_table_header_, &row)) {
-        return false;
-      }
-      (*table)[i + 1] = std::move(row);
+    const std::uint8_t *rows;
+    uint64_t table_size =
+        static_cast<uint64_t>(GetRowSize<TableRow>(sizes)) * rows_in_table;
+    if (table_size > UINT32_MAX ||
+        !binary_stream->ReadSpan(static_cast<uint32_t>(table_size), &rows)) {
+      return false;
     }
 
+    *table = MetadataTableView<TableRow>(rows, rows_in_table, sizes);
     return true;
   }
 
+  // Consumes the PDB of the module file module_name that the PDB
+  // provider has, identified by the CodeView entry of the module.
+  bool ConsumeProvidedPdb(const std::string &module_name);
+
   // Parses the Blobs heap.
   bool InitializeBlobHeap();
 
@@ -202,8 +319,81 @@ class PortablePdbFile : public IPortablePdbFile {
   // Parses the compressed metadata tables stream.
   bool ParseCompressedMetadataTableStream();
 
+  // Parses the methods of every document that is not parsed yet, from
+  // the index cache if there is one. Must be called with parse_mutex_
+  // held.
+  bool ParseAllMethods();
+
+  // Parses the methods of the document at index document if they are not
+  // parsed yet. Must be called with parse_mutex_ held.
+  bool ParseMethodsOfDocument(std::size_t document);
+
+  // Sets the methods of the document at index document to the ones that
+  // another PortablePdbFile with the same PDB id added to PdbIndexStore.
+  // Returns false if there are none and the document is not parsed yet.
+  // Must be called with parse_mutex_ held.
+  bool UseStoredDocumentMethods(std::size_t document);
+
+  // Adds the parsed methods of the document at index document to
+  // PdbIndexStore so that other PortablePdbFiles with the same PDB id
+  // share them. Must be called with parse_mutex_ held.
+  void ShareDocumentMethods(std::size_t document);
+
+  // Charges the memory used by the tables, the heaps and the document
+  // indices of this PDB to the gauges of DebuggerMetrics. Must be called
+  // with parse_mutex_ held.
+  void AccountMemory();
+
+  // Returns the bytes of the parsed methods and local scopes, which
+  // EvictMethods frees. Must be called with parse_mutex_ held.
+  std::size_t GetEvictableBytes() const;
+
   // True if ParsePdbFile method is already called.
   bool parsed = false;
+
+  // True if the methods of all the documents have been parsed.
+  bool methods_parsed_ = false;
+
+  // documents_parsed_[i] is true if the methods of document_indices_[i]
+  // have been parsed.
+  std::vector<bool> documents_parsed_;
+
+  // The method defs of each document in document_indices_, grouped the
+  // first time the methods of a document are parsed.
+  std::vector<std::vector<std::uint32_t>> methods_by_document_;
+
+  // Serializes ParsePdbFile and ParseMethods, which can be called from
+  // the thread that sets breakpoints and from evaluation threads.
+  std::mutex parse_mutex_;
+
+  // The local scopes parsed by GetMethodScopes, by method def. The
+  // entries are only removed by EvictMethods, so the vectors stay where
+  // they are while the methods are pinned.
+  std::unordered_map<std::uint32_t, std::unique_ptr<std::vector<Scope>>>
+      method_scopes_;
+
+  // Guards method_scopes_ and scope_memory_. Taken after parse_mutex_
+  // when both are needed.
+  mutable std::mutex scopes_mutex_;
+
+  // The number of PinMethods calls not undone by UnpinMethods.
+  std::atomic<int> method_pins_{0};
+
+  // The bytes of the parsed methods charged by AccountMemory, which
+  // EvictMethods frees.
+  std::size_t method_bytes_ = 0;
+
+  // Memory charged by AccountMemory, released when this PDB is destroyed.
+  google_cloud_debugger::ScopedMemoryCharge table_memory_{
+      &google_cloud_debugger::DebuggerMetrics::Global().pdb_table_bytes};
+  google_cloud_debugger::ScopedMemoryCharge heap_memory_{
+      &google_cloud_debugger::DebuggerMetrics::Global().pdb_heap_bytes};
+  google_cloud_debugger::ScopedMemoryCharge document_index_memory_{
+      &google_cloud_debugger::DebuggerMetrics::Global()
+           .pdb_document_index_bytes};
+  google_cloud_debugger::ScopedMemoryCharge scope_memory_{
+      &google_cloud_debugger::DebuggerMetrics::Global()
+           .pdb_document_index_bytes};
 };
 
 }  // namespace google_cloud_debugger_portable_pdb
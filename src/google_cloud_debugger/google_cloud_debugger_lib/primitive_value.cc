@@ -0,0 +1,117 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "primitive_value.h"
+
+#include "dbg_primitive.h"
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Holds the value of dbg_object, a DbgPrimitive<T>, in value as a Stored.
+template <typename T, typename Stored = T>
+HRESULT SetFromPrimitive(DbgObject *dbg_object, PrimitiveValue *value) {
+  T primitive;
+  HRESULT hr = DbgPrimitive<T>::GetValue(dbg_object, &primitive);
+  if (SUCCEEDED(hr)) {
+    value->Set(static_cast<Stored>(primitive));
+  }
+  return hr;
+}
+
+// Creates a DbgPrimitive<T> that holds value.
+template <typename T>
+HRESULT CreatePrimitive(T value, std::shared_ptr<DbgObject> *dbg_object) {
+  dbg_object->reset(new (std::nothrow) DbgPrimitive<T>(value));
+  if (!*dbg_object) {
+    return E_OUTOFMEMORY;
+  }
+  return S_OK;
+}
+
+}  // namespace
+
+HRESULT PrimitiveValue::SetFromDbgObject(DbgObject *dbg_object) {
+  if (!dbg_object) {
+    return E_INVALIDARG;
+  }
+
+  switch (dbg_object->GetCorElementType()) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      return SetFromPrimitive<bool>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_CHAR:
+      return SetFromPrimitive<char>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_I:
+      return SetFromPrimitive<intptr_t, int64_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_U:
+      return SetFromPrimitive<uintptr_t, uint64_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_I1:
+      return SetFromPrimitive<int8_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_U1:
+      return SetFromPrimitive<uint8_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_I2:
+      return SetFromPrimitive<int16_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_U2:
+      return SetFromPrimitive<uint16_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_I4:
+      return SetFromPrimitive<int32_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_U4:
+      return SetFromPrimitive<uint32_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_I8:
+      return SetFromPrimitive<int64_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_U8:
+      return SetFromPrimitive<uint64_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_R4:
+      return SetFromPrimitive<float_t>(dbg_object, this);
+    case CorElementType::ELEMENT_TYPE_R8:
+      return SetFromPrimitive<double_t>(dbg_object, this);
+    default:
+      return E_FAIL;
+  }
+}
+
+HRESULT PrimitiveValue::CreateDbgObject(
+    std::shared_ptr<DbgObject> *dbg_object) const {
+  switch (type_) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      return CreatePrimitive(boolean_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_CHAR:
+      return CreatePrimitive(char_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_I1:
+      return CreatePrimitive(int8_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_U1:
+      return CreatePrimitive(uint8_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_I2:
+      return CreatePrimitive(int16_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_U2:
+      return CreatePrimitive(uint16_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_I4:
+      return CreatePrimitive(int32_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_U4:
+      return CreatePrimitive(uint32_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_I8:
+      return CreatePrimitive(int64_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_U8:
+      return CreatePrimitive(uint64_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_R4:
+      return CreatePrimitive(float_, dbg_object);
+    case CorElementType::ELEMENT_TYPE_R8:
+      return CreatePrimitive(double_, dbg_object);
+    default:
+      return E_FAIL;
+  }
+}
+
+}  //  namespace google_cloud_debugger
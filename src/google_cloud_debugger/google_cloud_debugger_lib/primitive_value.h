@@ -0,0 +1,163 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PRIMITIVE_VALUE_H_
+#define PRIMITIVE_VALUE_H_
+
+#include <math.h>
+#include <memory>
+
+#include "common_headers.h"
+
+namespace google_cloud_debugger {
+
+class DbgObject;
+
+// A primitive value tagged with its type, for evaluators to compute on
+// without creating a DbgPrimitive for every subexpression (see
+// ExpressionEvaluator::EvaluatePrimitive). It holds booleans, chars and
+// the integral and floating point types. Pointer sized integers are held
+// as 64 bit integers.
+class PrimitiveValue {
+ public:
+  // Returns the type of the value held, or ELEMENT_TYPE_END if it is not
+  // set.
+  CorElementType GetType() const { return type_; }
+
+  // Holds value.
+  void Set(bool value) {
+    type_ = CorElementType::ELEMENT_TYPE_BOOLEAN;
+    boolean_ = value;
+  }
+  void Set(char value) {
+    type_ = CorElementType::ELEMENT_TYPE_CHAR;
+    char_ = value;
+  }
+  void Set(int8_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_I1;
+    int8_ = value;
+  }
+  void Set(uint8_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_U1;
+    uint8_ = value;
+  }
+  void Set(int16_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_I2;
+    int16_ = value;
+  }
+  void Set(uint16_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_U2;
+    uint16_ = value;
+  }
+  void Set(int32_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_I4;
+    int32_ = value;
+  }
+  void Set(uint32_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_U4;
+    uint32_ = value;
+  }
+  void Set(int64_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_I8;
+    int64_ = value;
+  }
+  void Set(uint64_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_U8;
+    uint64_ = value;
+  }
+  void Set(float_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_R4;
+    float_ = value;
+  }
+  void Set(double_t value) {
+    type_ = CorElementType::ELEMENT_TYPE_R8;
+    double_ = value;
+  }
+
+  // Converts the value held to T, the same way
+  // NumericCompilerHelper::ExtractPrimitiveValue converts a DbgPrimitive.
+  // Returns E_FAIL if no value is held.
+  template <typename T>
+  HRESULT Get(T *value) const {
+    switch (type_) {
+      case CorElementType::ELEMENT_TYPE_BOOLEAN:
+        *value = static_cast<T>(boolean_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_CHAR:
+        *value = static_cast<T>(char_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_I1:
+        *value = static_cast<T>(int8_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_U1:
+        *value = static_cast<T>(uint8_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_I2:
+        *value = static_cast<T>(int16_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_U2:
+        *value = static_cast<T>(uint16_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_I4:
+        *value = static_cast<T>(int32_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_U4:
+        *value = static_cast<T>(uint32_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_I8:
+        *value = static_cast<T>(int64_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_U8:
+        *value = static_cast<T>(uint64_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_R4:
+        *value = static_cast<T>(float_);
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_R8:
+        *value = static_cast<T>(double_);
+        return S_OK;
+      default:
+        return E_FAIL;
+    }
+  }
+
+  // Holds the value of dbg_object, which has to be a DbgPrimitive.
+  HRESULT SetFromDbgObject(DbgObject *dbg_object);
+
+  // Creates a DbgPrimitive of the type of the value held.
+  HRESULT CreateDbgObject(std::shared_ptr<DbgObject> *dbg_object) const;
+
+ private:
+  // The type of the member of the union below that is set.
+  CorElementType type_ = CorElementType::ELEMENT_TYPE_END;
+
+  union {
+    bool boolean_;
+    char char_;
+    int8_t int8_;
+    uint8_t uint8_;
+    int16_t int16_;
+    uint16_t uint16_;
+    int32_t int32_;
+    uint32_t uint32_;
+    int64_t int64_;
+    uint64_t uint64_;
+    float_t float_;
+    double_t double_;
+  };
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  PRIMITIVE_VALUE_H_
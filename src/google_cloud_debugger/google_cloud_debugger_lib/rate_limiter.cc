@@ -0,0 +1,60 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rate_limiter.h"
+
+#include <algorithm>
+
+namespace google_cloud_debugger {
+
+RateLimiter::RateLimiter(double fill_rate, double capacity)
+    : fill_rate_(fill_rate),
+      capacity_(capacity),
+      tokens_(capacity),
+      last_refill_(Clock::now()) {}
+
+bool RateLimiter::RequestTokens(double tokens, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Refill(now);
+  if (tokens_ < tokens) {
+    return false;
+  }
+
+  tokens_ -= tokens;
+  return true;
+}
+
+void RateLimiter::ConsumeTokens(double tokens, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Refill(now);
+  tokens_ -= tokens;
+}
+
+bool RateLimiter::HasTokens(Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Refill(now);
+  return tokens_ > 0;
+}
+
+void RateLimiter::Refill(Clock::time_point now) {
+  if (now <= last_refill_) {
+    return;
+  }
+
+  std::chrono::duration<double> elapsed = now - last_refill_;
+  tokens_ = std::min(capacity_, tokens_ + elapsed.count() * fill_rate_);
+  last_refill_ = now;
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,69 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RATE_LIMITER_H_
+#define RATE_LIMITER_H_
+
+#include <chrono>
+#include <mutex>
+
+namespace google_cloud_debugger {
+
+// A token bucket. It holds up to capacity tokens and gains fill_rate
+// tokens every second. Callers take tokens for what they do and are
+// throttled once the bucket is empty.
+class RateLimiter {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Creates a full bucket.
+  RateLimiter(double fill_rate, double capacity);
+  RateLimiter(const RateLimiter &) = delete;
+  RateLimiter &operator=(const RateLimiter &) = delete;
+
+  // Takes tokens from the bucket if it has that many. Returns false
+  // and leaves the bucket alone otherwise.
+  bool RequestTokens(double tokens, Clock::time_point now = Clock::now());
+
+  // Takes tokens from the bucket even if it does not have that many,
+  // so that the bucket stays empty until the debt is refilled.
+  void ConsumeTokens(double tokens, Clock::time_point now = Clock::now());
+
+  // Returns true if the bucket is not empty.
+  bool HasTokens(Clock::time_point now = Clock::now());
+
+ private:
+  // Adds the tokens gained since the last refill. Has to be called with
+  // mutex_ held.
+  void Refill(Clock::time_point now);
+
+  // Tokens gained every second.
+  double fill_rate_;
+
+  // Maximum number of tokens in the bucket.
+  double capacity_;
+
+  // Tokens in the bucket. Negative if more were consumed than it had.
+  double tokens_;
+
+  // When tokens were last added to the bucket.
+  Clock::time_point last_refill_;
+
+  // Protects tokens_ and last_refill_.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  RATE_LIMITER_H_
@@ -0,0 +1,163 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sequence_point_index.h"
+
+#include <algorithm>
+
+#include "document_index.h"
+
+using std::vector;
+
+namespace google_cloud_debugger_portable_pdb {
+
+void SequencePointIndex::Initialize(const vector<MethodInfo> &methods) {
+  methods_.clear();
+
+  // Sorts the methods by first line. Among methods with the same first
+  // line, the one that comes first in the document is sorted last because
+  // FindSequencePoint walks the methods backward.
+  vector<uint32_t> order;
+  order.reserve(methods.size());
+  for (uint32_t i = 0; i < methods.size(); ++i) {
+    order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&](uint32_t first, uint32_t second) {
+    if (methods[first].first_line != methods[second].first_line) {
+      return methods[first].first_line < methods[second].first_line;
+    }
+    return first > second;
+  });
+
+  methods_.reserve(methods.size());
+  uint32_t max_last_line = 0;
+  for (uint32_t method_position : order) {
+    const MethodInfo &method = methods[method_position];
+
+    MethodEntry entry;
+    entry.method_def = method.method_def;
+    entry.first_line = method.first_line;
+    entry.last_line = method.last_line;
+
+    uint32_t position = 0;
+    for (const SequencePoint &sequence_point : method.sequence_points) {
+      if (!sequence_point.is_hidden) {
+        entry.lines.push_back({sequence_point.start_line,
+                               sequence_point.end_line,
+                               sequence_point.il_offset, position});
+      }
+      ++position;
+    }
+
+    // A method without visible sequence points can never be used.
+    if (entry.lines.empty()) {
+      continue;
+    }
+
+    std::sort(entry.lines.begin(), entry.lines.end(),
+              [](const LineEntry &first, const LineEntry &second) {
+                if (first.start_line != second.start_line) {
+                  return first.start_line < second.start_line;
+                }
+                return first.position < second.position;
+              });
+
+    entry.first_in_il_order.resize(entry.lines.size());
+    uint32_t first = entry.lines.size() - 1;
+    for (size_t i = entry.lines.size(); i-- > 0;) {
+      if (entry.lines[i].position < entry.lines[first].position) {
+        first = i;
+      }
+      entry.first_in_il_order[i] = first;
+    }
+
+    max_last_line = std::max(max_last_line, entry.last_line);
+    entry.max_last_line = max_last_line;
+    methods_.push_back(std::move(entry));
+  }
+}
+
+bool SequencePointIndex::FindSequencePoint(
+    uint32_t line, SequencePointLocation *location) const {
+  if (!location) {
+    return false;
+  }
+
+  // Methods after this one start after the line.
+  auto method = std::upper_bound(
+      methods_.begin(), methods_.end(), line,
+      [](uint32_t value, const MethodEntry &entry) {
+        return value < entry.first_line;
+      });
+
+  // Walks backward so that inner methods, which start on later lines than
+  // the methods they are defined in, are tried first.
+  while (method != methods_.begin()) {
+    --method;
+    if (method->max_last_line < line) {
+      break;
+    }
+
+    if (method->last_line >= line && FindInMethod(*method, line, location)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool SequencePointIndex::FindInMethod(const MethodEntry &method, uint32_t line,
+                                      SequencePointLocation *location) {
+  const vector<LineEntry> &lines = method.lines;
+  auto starts_after = std::upper_bound(
+      lines.begin(), lines.end(), line,
+      [](uint32_t value, const LineEntry &entry) {
+        return value < entry.start_line;
+      });
+
+  const LineEntry *result = nullptr;
+
+  // Checks whether the last statement starting at or before the line
+  // spans it.
+  if (starts_after != lines.begin()) {
+    uint32_t start_line = (starts_after - 1)->start_line;
+    auto same_start = std::lower_bound(
+        lines.begin(), starts_after, start_line,
+        [](const LineEntry &entry, uint32_t value) {
+          return entry.start_line < value;
+        });
+    for (; same_start != starts_after; ++same_start) {
+      if (same_start->end_line >= line) {
+        result = &(*same_start);
+        break;
+      }
+    }
+  }
+
+  // Otherwise, uses the first statement in IL order after the line.
+  if (!result && starts_after != lines.end()) {
+    result = &lines[method.first_in_il_order[starts_after - lines.begin()]];
+  }
+
+  if (!result) {
+    return false;
+  }
+
+  location->method_def = method.method_def;
+  location->il_offset = result->il_offset;
+  location->start_line = result->start_line;
+  return true;
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
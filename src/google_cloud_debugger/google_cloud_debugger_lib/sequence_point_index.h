@@ -0,0 +1,98 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SEQUENCE_POINT_INDEX_H_
+#define SEQUENCE_POINT_INDEX_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace google_cloud_debugger_portable_pdb {
+
+struct MethodInfo;
+
+// Location in a method that a source line resolves to.
+struct SequencePointLocation {
+  // MethodDef of the method that contains the line.
+  std::uint32_t method_def = 0;
+
+  // IL Offset of the sequence point for the line.
+  std::uint32_t il_offset = 0;
+
+  // Start line of the sequence point for the line.
+  std::uint32_t start_line = 0;
+};
+
+// Index from source lines to sequence points for the methods of a document.
+//
+// Methods are sorted by their first line and the non-hidden sequence points
+// of each method are sorted by their start line, so resolving a line is a
+// couple of binary searches instead of a scan of every sequence point of
+// every method in the document.
+class SequencePointIndex {
+ public:
+  // Builds the index from methods. Hidden sequence points are left out.
+  void Initialize(const std::vector<MethodInfo> &methods);
+
+  // Resolves line to a sequence point. The innermost method that spans
+  // line is used (for example, a lambda rather than the method it is
+  // defined in). Within that method, the statement that spans line is used
+  // if there is one (so a line inside a multi-line statement resolves to
+  // that statement). Otherwise, the first statement in IL order that starts
+  // after line is used. Returns false if no method has such a statement.
+  bool FindSequencePoint(std::uint32_t line,
+                         SequencePointLocation *location) const;
+
+ private:
+  // A non-hidden sequence point of a method.
+  struct LineEntry {
+    std::uint32_t start_line;
+    std::uint32_t end_line;
+    std::uint32_t il_offset;
+
+    // Position of the sequence point in the method. Sequence points
+    // are stored in IL order so this is used to compare IL order.
+    std::uint32_t position;
+  };
+
+  // A method and its sorted sequence points.
+  struct MethodEntry {
+    std::uint32_t method_def;
+    std::uint32_t first_line;
+    std::uint32_t last_line;
+
+    // Largest last_line of this method and every method sorted before it.
+    // Used to stop the search once no earlier method can span the line.
+    std::uint32_t max_last_line;
+
+    // Non-hidden sequence points sorted by start line, then by position.
+    std::vector<LineEntry> lines;
+
+    // first_in_il_order[i] is the index in lines of the entry with the
+    // smallest position among lines[i..].
+    std::vector<std::uint32_t> first_in_il_order;
+  };
+
+  // Tries to resolve line within method.
+  static bool FindInMethod(const MethodEntry &method, std::uint32_t line,
+                           SequencePointLocation *location);
+
+  // Methods sorted by first line. Methods with the same first line are
+  // sorted so that the one that comes first in the document is last.
+  std::vector<MethodEntry> methods_;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // SEQUENCE_POINT_INDEX_H_
@@ -0,0 +1,123 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sequence_point_list.h"
+
+using std::uint32_t;
+using std::uint64_t;
+using std::uint8_t;
+using std::vector;
+
+namespace google_cloud_debugger_portable_pdb {
+
+namespace {
+
+// Appends value to data as a little-endian base 128 integer.
+void AppendVarUInt(uint64_t value, vector<uint8_t> *data) {
+  while (value >= 0x80) {
+    data->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<uint8_t>(value));
+}
+
+// Reads a little-endian base 128 integer at *data and advances *data.
+uint64_t ReadVarUInt(const uint8_t **data) {
+  uint64_t value = 0;
+  uint32_t shift = 0;
+  uint8_t byte;
+  do {
+    byte = **data;
+    ++(*data);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+// Returns the difference between value and base, zigzag encoded so that
+// small negative differences stay small.
+uint32_t EncodeDelta(uint32_t value, uint32_t base) {
+  uint32_t delta = value - base;
+  return (delta << 1) ^ (0 - (delta >> 31));
+}
+
+// Returns the value whose difference from base was encoded by EncodeDelta.
+uint32_t DecodeDelta(uint32_t base, uint32_t zigzag) {
+  return base + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+}
+
+}  // namespace
+
+SequencePointList::const_iterator::const_iterator(const uint8_t *next,
+                                                  size_t remaining)
+    : next_(next), remaining_(remaining) {
+  if (remaining_ > 0) {
+    Decode();
+  }
+}
+
+SequencePointList::const_iterator &SequencePointList::const_iterator::
+operator++() {
+  --remaining_;
+  if (remaining_ > 0) {
+    Decode();
+  }
+  return *this;
+}
+
+void SequencePointList::const_iterator::Decode() {
+  // The hidden flag is stored in the lowest bit of the IL offset delta.
+  uint64_t il_offset_and_hidden = ReadVarUInt(&next_);
+  current_.is_hidden = il_offset_and_hidden & 1;
+  current_.il_offset = DecodeDelta(
+      current_.il_offset, static_cast<uint32_t>(il_offset_and_hidden >> 1));
+
+  current_.start_line = DecodeDelta(
+      current_.start_line, static_cast<uint32_t>(ReadVarUInt(&next_)));
+  current_.start_col = static_cast<uint32_t>(ReadVarUInt(&next_));
+  current_.end_line = DecodeDelta(current_.start_line,
+                                  static_cast<uint32_t>(ReadVarUInt(&next_)));
+  current_.end_col = static_cast<uint32_t>(ReadVarUInt(&next_));
+}
+
+void SequencePointList::push_back(const SequencePoint &sequence_point) {
+  uint64_t il_offset_delta =
+      EncodeDelta(sequence_point.il_offset, last_.il_offset);
+  AppendVarUInt((il_offset_delta << 1) | (sequence_point.is_hidden ? 1 : 0),
+                &data_);
+  AppendVarUInt(EncodeDelta(sequence_point.start_line, last_.start_line),
+                &data_);
+  AppendVarUInt(sequence_point.start_col, &data_);
+  AppendVarUInt(EncodeDelta(sequence_point.end_line, sequence_point.start_line),
+                &data_);
+  AppendVarUInt(sequence_point.end_col, &data_);
+
+  last_ = sequence_point;
+  ++size_;
+}
+
+void SequencePointList::clear() {
+  data_.clear();
+  size_ = 0;
+  last_ = SequencePoint();
+}
+
+SequencePointList::const_iterator SequencePointList::begin() const {
+  return const_iterator(data_.data(), size_);
+}
+
+void SequencePointList::ShrinkToFit() { data_.shrink_to_fit(); }
+
+}  // namespace google_cloud_debugger_portable_pdb
@@ -0,0 +1,139 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SEQUENCE_POINT_LIST_H_
+#define SEQUENCE_POINT_LIST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace google_cloud_debugger_portable_pdb {
+
+// Struct that represents a sequence point in a method.
+// Unlike SequencePointRecord struct, this struct has
+// the absoluate IL Offset.
+struct SequencePoint {
+  // IL Offset of this sequence point.
+  std::uint32_t il_offset = 0;
+
+  // Start line of this sequence point.
+  std::uint32_t start_line = 0;
+
+  // Start column of this sequence point.
+  std::uint32_t start_col = 0;
+
+  // End line of this sequence point.
+  std::uint32_t end_line = 0;
+
+  // End column of this sequence point.
+  std::uint32_t end_col = 0;
+
+  // True if this is a hidden or document change sequence point.
+  bool is_hidden = false;
+};
+
+// Compact list of the sequence points of a method.
+//
+// A SequencePoint takes 24 bytes, but consecutive sequence points of a
+// method usually differ by a few IL bytes and a line or two. The list
+// stores every sequence point as variable-length deltas from the previous
+// one in a single byte buffer, which typically takes 5 or 6 bytes per
+// sequence point. Sequence points are decoded on the fly while iterating,
+// so the list only supports sequential access.
+class SequencePointList {
+ public:
+  // Forward iterator that decodes the sequence points of the list.
+  class const_iterator
+      : public std::iterator<std::forward_iterator_tag, SequencePoint,
+                             std::ptrdiff_t, const SequencePoint *,
+                             const SequencePoint &> {
+   public:
+    const SequencePoint &operator*() const { return current_; }
+
+    const SequencePoint *operator->() const { return &current_; }
+
+    const_iterator &operator++();
+
+    const_iterator operator++(int) {
+      const_iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return remaining_ == other.remaining_;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return remaining_ != other.remaining_;
+    }
+
+   private:
+    friend class SequencePointList;
+
+    const_iterator(const std::uint8_t *next, std::size_t remaining);
+
+    // Decodes the sequence point at next_ into current_ using current_
+    // as the previous sequence point.
+    void Decode();
+
+    // Encoded bytes of the sequence point after current_.
+    const std::uint8_t *next_;
+
+    // Number of sequence points left, including current_.
+    std::size_t remaining_;
+
+    // The decoded sequence point.
+    SequencePoint current_;
+  };
+
+  // Appends sequence_point to the list.
+  void push_back(const SequencePoint &sequence_point);
+
+  // Removes all the sequence points.
+  void clear();
+
+  // Returns the number of sequence points in the list.
+  std::size_t size() const { return size_; }
+
+  // Returns true if the list has no sequence points.
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const;
+
+  const_iterator end() const { return const_iterator(nullptr, 0); }
+
+  // Releases the memory reserved by push_back that is not in use.
+  void ShrinkToFit();
+
+  // Returns the number of heap bytes held by the list.
+  std::size_t GetMemoryUsage() const { return data_.capacity(); }
+
+ private:
+  // Encoded sequence points.
+  std::vector<std::uint8_t> data_;
+
+  // Number of sequence points in data_.
+  std::size_t size_ = 0;
+
+  // The last sequence point appended, which the next one is encoded
+  // relative to.
+  SequencePoint last_;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // SEQUENCE_POINT_LIST_H_
@@ -0,0 +1,320 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PLATFORM_UNIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "constants.h"
+#include "shared_memory_pipe_unix.h"
+
+using std::cerr;
+using std::string;
+
+namespace google_cloud_debugger {
+
+static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t),
+              "The positions of a ring have to be plain uint64.");
+
+SharedMemoryPipe::SharedMemoryPipe(std::unique_ptr<INamedPipe> doorbell,
+                                   string shared_memory_path)
+    : doorbell_(std::move(doorbell)),
+      shared_memory_path_(std::move(shared_memory_path)) {}
+
+SharedMemoryPipe::~SharedMemoryPipe() {
+  if (memory_ && munmap(memory_, memory_size_) == -1) {
+    cerr << "munmap error: " << strerror(errno) << std::endl;
+  }
+}
+
+HRESULT SharedMemoryPipe::Initialize() {
+  if (!doorbell_) {
+    return E_POINTER;
+  }
+  return doorbell_->Initialize();
+}
+
+HRESULT SharedMemoryPipe::WaitForConnection() {
+  HRESULT hr = doorbell_->WaitForConnection();
+  if (FAILED(hr)) {
+    return hr;
+  }
+  return MapSharedMemory();
+}
+
+HRESULT SharedMemoryPipe::MapSharedMemory() {
+  int fd = open(shared_memory_path_.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd == -1) {
+    cerr << "open error: " << strerror(errno) << std::endl;
+    return E_FAIL;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    cerr << "fstat error: " << strerror(errno) << std::endl;
+    close(fd);
+    return E_FAIL;
+  }
+
+  std::size_t size = static_cast<std::size_t>(file_stat.st_size);
+  if (size < kSharedMemoryHeaderSize) {
+    cerr << "The shared memory of the pipe is too small." << std::endl;
+    close(fd);
+    return E_FAIL;
+  }
+
+  void *memory =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    cerr << "mmap error: " << strerror(errno) << std::endl;
+    return E_FAIL;
+  }
+
+  const std::uint32_t *header = static_cast<const std::uint32_t *>(memory);
+  std::uint64_t capacity = header[1];
+  if (header[0] != kSharedMemoryMagic || capacity == 0 ||
+      (capacity & (capacity - 1)) != 0 ||
+      size != kSharedMemoryHeaderSize +
+                  2 * (kSharedMemoryRingControlSize + capacity)) {
+    cerr << "The shared memory of the pipe has an invalid header."
+         << std::endl;
+    munmap(memory, size);
+    return E_FAIL;
+  }
+
+  memory_ = memory;
+  memory_size_ = size;
+  capacity_ = capacity;
+  SetRing(kSharedMemoryHeaderSize, &incoming_);
+  SetRing(kSharedMemoryHeaderSize + kSharedMemoryRingControlSize + capacity,
+          &outgoing_);
+  return S_OK;
+}
+
+void SharedMemoryPipe::SetRing(std::size_t offset, Ring *ring) {
+  // Each field of the control block has its own cache line, so that the
+  // writer and the reader do not invalidate each other's.
+  char *start = static_cast<char *>(memory_) + offset;
+  ring->write_position =
+      reinterpret_cast<std::atomic<std::uint64_t> *>(start);
+  ring->read_position =
+      reinterpret_cast<std::atomic<std::uint64_t> *>(start + 64);
+  ring->reader_waiting =
+      reinterpret_cast<std::atomic<std::uint32_t> *>(start + 128);
+  ring->data = start + kSharedMemoryRingControlSize;
+}
+
+std::size_t SharedMemoryPipe::ReadAvailable(char *buffer, std::size_t size) {
+  std::uint64_t read = incoming_.read_position->load(std::memory_order_relaxed);
+  std::uint64_t write =
+      incoming_.write_position->load(std::memory_order_acquire);
+  std::size_t count =
+      static_cast<std::size_t>(std::min<std::uint64_t>(size, write - read));
+  if (count == 0) {
+    return 0;
+  }
+
+  std::size_t index = static_cast<std::size_t>(read & (capacity_ - 1));
+  std::size_t first = std::min<std::size_t>(count, capacity_ - index);
+  memcpy(buffer, incoming_.data + index, first);
+  memcpy(buffer + first, incoming_.data, count - first);
+  incoming_.read_position->store(read + count, std::memory_order_release);
+  return count;
+}
+
+HRESULT SharedMemoryPipe::WaitForData() {
+  // The flag is set before the ring is checked again and the agent
+  // checks the flag after it moves the write position, so either this
+  // sees the new data or the agent sees the flag and rings the doorbell.
+  incoming_.reader_waiting->store(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (incoming_.write_position->load(std::memory_order_seq_cst) !=
+      incoming_.read_position->load(std::memory_order_relaxed)) {
+    incoming_.reader_waiting->store(0, std::memory_order_relaxed);
+    return S_OK;
+  }
+
+  string doorbell;
+  HRESULT hr = doorbell_->Read(&doorbell);
+  incoming_.reader_waiting->store(0, std::memory_order_relaxed);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // An empty read means the agent closed the pipe.
+  if (doorbell.empty() &&
+      incoming_.write_position->load(std::memory_order_acquire) ==
+          incoming_.read_position->load(std::memory_order_relaxed)) {
+    return S_FALSE;
+  }
+  return S_OK;
+}
+
+HRESULT SharedMemoryPipe::Read(string *message) {
+  if (message == nullptr) {
+    return E_POINTER;
+  }
+
+  if (!memory_) {
+    return E_FAIL;
+  }
+
+  char buffer[kBufferSize];
+  while (true) {
+    std::size_t read = ReadAvailable(buffer, kBufferSize);
+    if (read > 0) {
+      message->assign(buffer, read);
+      return S_OK;
+    }
+
+    HRESULT hr = WaitForData();
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    if (hr == S_FALSE) {
+      message->clear();
+      return S_OK;
+    }
+  }
+}
+
+HRESULT SharedMemoryPipe::ReadExactly(std::size_t size, string *message) {
+  if (message == nullptr) {
+    return E_POINTER;
+  }
+
+  if (!memory_) {
+    return E_FAIL;
+  }
+
+  message->resize(size);
+  std::size_t total_read = 0;
+  while (total_read < size) {
+    std::size_t read =
+        ReadAvailable(&(*message)[total_read], size - total_read);
+    if (read > 0) {
+      total_read += read;
+      continue;
+    }
+
+    HRESULT hr = WaitForData();
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    if (hr == S_FALSE) {
+      cerr << "read error: the pipe was closed" << std::endl;
+      return E_FAIL;
+    }
+  }
+  return S_OK;
+}
+
+HRESULT SharedMemoryPipe::Write(const string &message) {
+  PipeBuffer buffer = {message.data(), message.size()};
+  return WriteBuffers(&buffer, 1);
+}
+
+HRESULT SharedMemoryPipe::WriteBuffers(const PipeBuffer *buffers,
+                                       std::size_t count) {
+  if (buffers == nullptr && count != 0) {
+    return E_POINTER;
+  }
+
+  if (!memory_) {
+    return E_FAIL;
+  }
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(kPipeWriteTimeoutMs);
+  for (std::size_t i = 0; i < count; ++i) {
+    HRESULT hr = WriteToRing(buffers[i].data, buffers[i].size, deadline);
+    if (FAILED(hr)) {
+      return hr;
+    }
+  }
+  return RingDoorbell();
+}
+
+HRESULT SharedMemoryPipe::WriteToRing(
+    const char *data, std::size_t size,
+    std::chrono::steady_clock::time_point deadline) {
+  while (size > 0) {
+    std::uint64_t write =
+        outgoing_.write_position->load(std::memory_order_relaxed);
+    std::uint64_t read =
+        outgoing_.read_position->load(std::memory_order_acquire);
+    std::uint64_t space = capacity_ - (write - read);
+    if (space == 0) {
+      // The agent may be waiting with the part that was already written.
+      HRESULT hr = RingDoorbell();
+      if (FAILED(hr)) {
+        return hr;
+      }
+
+      if (shut_down_) {
+        return E_ABORT;
+      }
+
+      if (std::chrono::steady_clock::now() >= deadline) {
+        cerr << "write error: timed out" << std::endl;
+        return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+      }
+      usleep(kSharedMemoryFullRetryIntervalUs);
+      continue;
+    }
+
+    std::size_t count =
+        static_cast<std::size_t>(std::min<std::uint64_t>(size, space));
+    std::size_t index = static_cast<std::size_t>(write & (capacity_ - 1));
+    std::size_t first = std::min<std::size_t>(count, capacity_ - index);
+    memcpy(outgoing_.data + index, data, first);
+    memcpy(outgoing_.data, data + first, count - first);
+    outgoing_.write_position->store(write + count, std::memory_order_release);
+    data += count;
+    size -= count;
+  }
+  return S_OK;
+}
+
+HRESULT SharedMemoryPipe::RingDoorbell() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (outgoing_.reader_waiting->exchange(0, std::memory_order_seq_cst) == 0) {
+    return S_OK;
+  }
+  return doorbell_->Write(string(1, '\0'));
+}
+
+HRESULT SharedMemoryPipe::ShutDown() {
+  shut_down_ = true;
+  if (!doorbell_) {
+    return S_OK;
+  }
+  return doorbell_->ShutDown();
+}
+
+}  // namespace google_cloud_debugger
+
+#endif  //  PLATFORM_UNIX
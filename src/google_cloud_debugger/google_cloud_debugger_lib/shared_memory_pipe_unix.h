@@ -0,0 +1,117 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PLATFORM_UNIX
+
+#ifndef SHARED_MEMORY_PIPE_UNIX_H_
+#define SHARED_MEMORY_PIPE_UNIX_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "i_named_pipe.h"
+
+namespace google_cloud_debugger {
+
+// A pipe to the agent whose bytes go through two rings in memory shared
+// with the agent, one for each direction, instead of through the kernel.
+// Each ring has a single writer and a single reader.
+//
+// The connection to the agent is still made through doorbell, a named
+// pipe that then only carries wake ups: a reader that finds its ring
+// empty flags that it waits and blocks reading the doorbell, and a
+// writer writes a byte to the doorbell only if it sees that flag. A
+// reader that keeps up with the writer never waits, so writes then make
+// no system calls.
+//
+// The agent creates the shared memory (see kSharedMemoryMagic) before it
+// accepts the connection, so it exists once WaitForConnection connects.
+class SharedMemoryPipe : public INamedPipe {
+ public:
+  // Creates a pipe that maps the shared memory at shared_memory_path
+  // once doorbell is connected.
+  SharedMemoryPipe(std::unique_ptr<INamedPipe> doorbell,
+                   std::string shared_memory_path);
+  ~SharedMemoryPipe();
+  HRESULT Initialize() override;
+  HRESULT WaitForConnection() override;
+  HRESULT Read(std::string *message) override;
+  HRESULT ReadExactly(std::size_t size, std::string *message) override;
+  HRESULT Write(const std::string &message) override;
+  HRESULT WriteBuffers(const PipeBuffer *buffers, std::size_t count) override;
+  HRESULT ShutDown() override;
+
+ private:
+  // The control block and data of a ring in the shared memory.
+  struct Ring {
+    std::atomic<std::uint64_t> *write_position = nullptr;
+    std::atomic<std::uint64_t> *read_position = nullptr;
+    std::atomic<std::uint32_t> *reader_waiting = nullptr;
+    char *data = nullptr;
+  };
+
+  // Maps the shared memory and checks the header the agent wrote.
+  HRESULT MapSharedMemory();
+
+  // Points ring at the ring that starts at offset in the shared memory.
+  void SetRing(std::size_t offset, Ring *ring);
+
+  // Copies up to size bytes that the agent wrote into buffer and returns
+  // how many were copied, without blocking.
+  std::size_t ReadAvailable(char *buffer, std::size_t size);
+
+  // Blocks until the agent writes to the incoming ring. Returns S_FALSE
+  // if the agent closed the pipe and left nothing more to read.
+  HRESULT WaitForData();
+
+  // Copies data into the outgoing ring, waiting for the agent to read
+  // when the ring is full, up to deadline.
+  HRESULT WriteToRing(const char *data, std::size_t size,
+                      std::chrono::steady_clock::time_point deadline);
+
+  // Writes to the doorbell if the agent waits for the outgoing ring.
+  HRESULT RingDoorbell();
+
+  // The named pipe that connects to the agent and carries the wake ups.
+  std::unique_ptr<INamedPipe> doorbell_;
+
+  // The file of the shared memory.
+  std::string shared_memory_path_;
+
+  // The mapped shared memory.
+  void *memory_ = nullptr;
+  std::size_t memory_size_ = 0;
+
+  // The number of data bytes of each ring, a power of two.
+  std::uint64_t capacity_ = 0;
+
+  // The ring the agent writes to and the one the debugger writes to.
+  Ring incoming_;
+  Ring outgoing_;
+
+  // Serializes writers, since each ring has a single writer.
+  std::mutex write_mutex_;
+
+  // True once ShutDown is called.
+  std::atomic<bool> shut_down_{false};
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  //  SHARED_MEMORY_PIPE_UNIX_H_
+#endif  //  PLATFORM_UNIX
@@ -0,0 +1,138 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot_delta.h"
+
+#include "constants.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::StackFrame;
+using google::cloud::diagnostics::debug::Variable;
+using google::protobuf::RepeatedPtrField;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+const std::uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const std::uint64_t kFnvPrime = 1099511628211ULL;
+
+// Adds size bytes at data to the FNV-1a hash.
+void HashBytes(const void *data, std::size_t size, std::uint64_t *hash) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    *hash = (*hash ^ bytes[i]) * kFnvPrime;
+  }
+}
+
+// Adds value to the hash.
+void HashInteger(std::uint64_t value, std::uint64_t *hash) {
+  HashBytes(&value, sizeof(value), hash);
+}
+
+// Adds value, with its size so that consecutive strings do not run into
+// each other, to the hash.
+void HashString(const string &value, std::uint64_t *hash) {
+  HashInteger(value.size(), hash);
+  HashBytes(value.data(), value.size(), hash);
+}
+
+}  // namespace
+
+void SnapshotDelta::Encode(Breakpoint *breakpoint) {
+  if (breakpoint->stack_frames_size() == 0) {
+    return;
+  }
+
+  SnapshotHashes hashes;
+  hashes.arguments.resize(breakpoint->stack_frames_size());
+  hashes.locals.resize(breakpoint->stack_frames_size());
+  for (int i = 0; i < breakpoint->stack_frames_size(); ++i) {
+    const StackFrame &frame = breakpoint->stack_frames(i);
+    HashVariables(frame.arguments(), &hashes.arguments[i]);
+    HashVariables(frame.locals(), &hashes.locals[i]);
+  }
+  HashVariables(breakpoint->evaluated_expressions(), &hashes.expressions);
+
+  auto previous = snapshots_.find(breakpoint->id());
+  if (previous != snapshots_.end()) {
+    const SnapshotHashes &previous_hashes = previous->second;
+    for (int i = 0; i < breakpoint->stack_frames_size() &&
+                    i < static_cast<int>(previous_hashes.arguments.size());
+         ++i) {
+      StackFrame *frame = breakpoint->mutable_stack_frames(i);
+      ReplaceUnchanged(hashes.arguments[i], previous_hashes.arguments[i],
+                       frame->mutable_arguments());
+      ReplaceUnchanged(hashes.locals[i], previous_hashes.locals[i],
+                       frame->mutable_locals());
+    }
+    ReplaceUnchanged(hashes.expressions, previous_hashes.expressions,
+                     breakpoint->mutable_evaluated_expressions());
+    previous->second = std::move(hashes);
+    return;
+  }
+
+  if (snapshots_.size() >= kMaximumDeltaSnapshotBreakpoints) {
+    snapshots_.clear();
+  }
+  snapshots_[breakpoint->id()] = std::move(hashes);
+}
+
+void SnapshotDelta::HashVariable(const Variable &variable,
+                                 VariableHash *hash) {
+  hash->hash = kFnvOffsetBasis;
+  HashString(variable.name(), &hash->hash);
+  HashString(variable.type(), &hash->hash);
+  HashString(variable.value(), &hash->hash);
+  HashInteger(variable.has_status(), &hash->hash);
+  if (variable.has_status()) {
+    HashInteger(variable.status().iserror(), &hash->hash);
+    HashString(variable.status().message(), &hash->hash);
+  }
+
+  HashVariables(variable.members(), &hash->members);
+  HashInteger(hash->members.size(), &hash->hash);
+  for (const VariableHash &member : hash->members) {
+    HashInteger(member.hash, &hash->hash);
+  }
+}
+
+void SnapshotDelta::HashVariables(const RepeatedPtrField<Variable> &variables,
+                                  vector<VariableHash> *hashes) {
+  hashes->resize(variables.size());
+  for (int i = 0; i < variables.size(); ++i) {
+    HashVariable(variables.Get(i), &(*hashes)[i]);
+  }
+}
+
+void SnapshotDelta::ReplaceUnchanged(const vector<VariableHash> &hashes,
+                                     const vector<VariableHash> &previous,
+                                     RepeatedPtrField<Variable> *variables) {
+  for (int i = 0; i < variables->size() &&
+                  i < static_cast<int>(previous.size());
+       ++i) {
+    Variable *variable = variables->Mutable(i);
+    if (hashes[i].hash == previous[i].hash) {
+      variable->Clear();
+      variable->set_name(kUnchangedVariableName);
+    } else {
+      ReplaceUnchanged(hashes[i].members, previous[i].members,
+                       variable->mutable_members());
+    }
+  }
+}
+
+}  //  namespace google_cloud_debugger
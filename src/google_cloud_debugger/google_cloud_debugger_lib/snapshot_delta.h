@@ -0,0 +1,98 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SNAPSHOT_DELTA_H_
+#define SNAPSHOT_DELTA_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// Replaces the variables of a snapshot that did not change since the
+// previous snapshot of the same breakpoint, such as outer frames and
+// configuration objects captured at every hit, with a reference to the
+// variable at the same position of the previous snapshot.
+//
+// A referencing variable has kUnchangedVariableName as its name and no
+// other field. The variables of a snapshot are at the same position as
+// the ones of the previous snapshot if they are at the same indices of
+// the same lists: the arguments or locals of the frame at the same index,
+// the evaluated expressions, or the members of variables at the same
+// position. A variable that changed is sent with its name, type and value,
+// and only its members that changed are sent in full.
+//
+// The agent keeps the previous snapshot of each breakpoint to read the
+// references back. Both keep the snapshots of at most
+// kMaximumDeltaSnapshotBreakpoints breakpoints and forget all of them
+// when a snapshot of another breakpoint comes, so they agree on which
+// snapshots are known as long as every encoded snapshot is read.
+//
+// Not thread-safe; it is used by the writer thread of breakpoints.
+class SnapshotDelta {
+ public:
+  // Encodes breakpoint against the previous snapshot of the same
+  // breakpoint, and keeps breakpoint as the previous snapshot.
+  // Breakpoints without stack frames, such as hits of log points, are
+  // left as they are.
+  void Encode(google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+ private:
+  // The hash of a variable with its members, and the hashes of its
+  // members.
+  struct VariableHash {
+    std::uint64_t hash = 0;
+    std::vector<VariableHash> members;
+  };
+
+  // The hashes of the variables of a snapshot.
+  struct SnapshotHashes {
+    // The hashes of the arguments and of the locals of each frame.
+    std::vector<std::vector<VariableHash>> arguments;
+    std::vector<std::vector<VariableHash>> locals;
+
+    std::vector<VariableHash> expressions;
+  };
+
+  // Computes the hash of variable and of its members into hash.
+  static void HashVariable(
+      const google::cloud::diagnostics::debug::Variable &variable,
+      VariableHash *hash);
+
+  // Computes the hashes of variables into hashes.
+  static void HashVariables(
+      const google::protobuf::RepeatedPtrField<
+          google::cloud::diagnostics::debug::Variable> &variables,
+      std::vector<VariableHash> *hashes);
+
+  // Replaces the variables whose hash is the hash of the variable at the
+  // same position in previous by references. hashes are the hashes of
+  // variables.
+  static void ReplaceUnchanged(
+      const std::vector<VariableHash> &hashes,
+      const std::vector<VariableHash> &previous,
+      google::protobuf::RepeatedPtrField<
+          google::cloud::diagnostics::debug::Variable> *variables);
+
+  // The hashes of the previous snapshot of each breakpoint, by ID.
+  std::unordered_map<std::string, SnapshotHashes> snapshots_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  SNAPSHOT_DELTA_H_
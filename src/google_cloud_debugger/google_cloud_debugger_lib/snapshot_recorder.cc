@@ -0,0 +1,81 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot_recorder.h"
+
+#include <cstdint>
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger {
+
+bool SnapshotRecorder::Open(const string &path) {
+  output_.open(path, std::ios::out | std::ios::binary | std::ios::app);
+  return output_.is_open();
+}
+
+bool SnapshotRecorder::Record(const Breakpoint &breakpoint) {
+  if (breakpoint.stack_frames_size() == 0) {
+    return true;
+  }
+
+  if (!output_.is_open() || !breakpoint.SerializeToString(&message_)) {
+    return false;
+  }
+
+  std::uint32_t size = static_cast<std::uint32_t>(message_.size());
+  char length[4];
+  for (int i = 0; i < 4; ++i) {
+    length[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+  }
+  output_.write(length, sizeof(length));
+  output_.write(message_.data(), message_.size());
+  output_.flush();
+  return output_.good();
+}
+
+bool SnapshotRecorder::ReadSnapshots(std::istream *input,
+                                     vector<Breakpoint> *snapshots) {
+  string message;
+  while (true) {
+    unsigned char length[4];
+    input->read(reinterpret_cast<char *>(length), sizeof(length));
+    if (input->gcount() == 0 && input->eof()) {
+      return true;
+    }
+    if (input->gcount() != sizeof(length)) {
+      return false;
+    }
+
+    std::uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+      size |= static_cast<std::uint32_t>(length[i]) << (8 * i);
+    }
+    message.resize(size);
+    input->read(&message[0], size);
+    if (static_cast<std::uint32_t>(input->gcount()) != size) {
+      return false;
+    }
+
+    Breakpoint snapshot;
+    if (!snapshot.ParseFromString(message)) {
+      return false;
+    }
+    snapshots->push_back(std::move(snapshot));
+  }
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,64 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SNAPSHOT_RECORDER_H_
+#define SNAPSHOT_RECORDER_H_
+
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// Records the snapshots captured at real breakpoint hits to a file, so
+// that snapshot_benchmark can replay the object graphs they show without
+// a live CLR, as many times as needed for stable numbers.
+//
+// Each snapshot is written as its 4-byte little-endian length followed by
+// the serialized Breakpoint, as captured before the string table and
+// delta encodings. Breakpoints without stack frames, such as hits of log
+// points and status updates, are not recorded.
+//
+// Not thread-safe; it is used by the writer thread of breakpoints.
+class SnapshotRecorder {
+ public:
+  // Opens the file at path, appending to what it has. Returns false if
+  // it cannot be opened.
+  bool Open(const std::string &path);
+
+  // Appends breakpoint to the file if it is a snapshot. Returns false if
+  // it cannot be written.
+  bool Record(const google::cloud::diagnostics::debug::Breakpoint &breakpoint);
+
+  // Reads the snapshots of a file written by Record from input into
+  // snapshots. Returns false if the file is truncated or corrupt, in
+  // which case snapshots has the ones read before.
+  static bool ReadSnapshots(
+      std::istream *input,
+      std::vector<google::cloud::diagnostics::debug::Breakpoint> *snapshots);
+
+ private:
+  // The file snapshots are appended to.
+  std::ofstream output_;
+
+  // Buffer of the serialized snapshot, reused across snapshots.
+  std::string message_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  SNAPSHOT_RECORDER_H_
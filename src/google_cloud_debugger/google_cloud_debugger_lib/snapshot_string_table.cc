@@ -0,0 +1,125 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "snapshot_string_table.h"
+
+#include "constants.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::StackFrame;
+using google::cloud::diagnostics::debug::Variable;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// The bytes a string takes in the table besides the string itself: the
+// tag and size of the member Variable and of its value.
+const std::size_t kTableEntryOverhead = 4;
+
+template <typename Visit>
+void VisitStrings(Variable *variable, const Visit &visit) {
+  visit(variable->mutable_name());
+  visit(variable->mutable_type());
+  for (Variable &member : *variable->mutable_members()) {
+    VisitStrings(&member, visit);
+  }
+}
+
+// Calls visit on every string of breakpoint that can be replaced.
+template <typename Visit>
+void VisitStrings(Breakpoint *breakpoint, const Visit &visit) {
+  for (StackFrame &frame : *breakpoint->mutable_stack_frames()) {
+    visit(frame.mutable_method_name());
+    if (frame.has_location()) {
+      visit(frame.mutable_location()->mutable_path());
+    }
+    for (Variable &argument : *frame.mutable_arguments()) {
+      VisitStrings(&argument, visit);
+    }
+    for (Variable &local : *frame.mutable_locals()) {
+      VisitStrings(&local, visit);
+    }
+  }
+  for (Variable &expression : *breakpoint->mutable_evaluated_expressions()) {
+    VisitStrings(&expression, visit);
+  }
+}
+
+std::size_t CountDigits(std::size_t value) {
+  std::size_t digits = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++digits;
+  }
+  return digits;
+}
+
+}  // namespace
+
+void SnapshotStringTable::Encode(Breakpoint *breakpoint) {
+  if (breakpoint->stack_frames_size() == 0) {
+    return;
+  }
+
+  VisitStrings(breakpoint, [this](string *value) {
+    if (!value->empty()) {
+      ++entries_[*value].count;
+    }
+  });
+  VisitStrings(breakpoint, [this](string *value) { Replace(value); });
+
+  if (!table_.empty()) {
+    Variable *table = breakpoint->add_evaluated_expressions();
+    table->set_name(kStringTableExpressionName);
+    for (const string *value : table_) {
+      table->add_members()->set_value(*value);
+    }
+  }
+
+  table_.clear();
+  entries_.clear();
+}
+
+void SnapshotStringTable::Replace(string *value) {
+  if (value->empty()) {
+    return;
+  }
+
+  auto found = entries_.find(*value);
+  Entry &entry = found->second;
+  if (entry.index == kUndecided) {
+    std::size_t reference_size = 1 + CountDigits(table_.size());
+    std::size_t inline_size = entry.count * value->size();
+    std::size_t table_size = value->size() + kTableEntryOverhead +
+                             entry.count * reference_size;
+    // A string that looks like a reference has to be in the table to be
+    // read back as it is.
+    if (table_size < inline_size ||
+        (*value)[0] == kStringTableReferencePrefix) {
+      entry.index = table_.size();
+      table_.push_back(&found->first);
+    } else {
+      entry.index = kInline;
+    }
+  }
+
+  if (entry.index != kInline) {
+    value->assign(1, kStringTableReferencePrefix);
+    value->append(std::to_string(entry.index));
+  }
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,75 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SNAPSHOT_STRING_TABLE_H_
+#define SNAPSHOT_STRING_TABLE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// Replaces the strings that a snapshot repeats, such as the types of the
+// items of a collection or the names of their fields, with references
+// into a table of strings sent once with the snapshot, like the variable
+// table of the Cloud Debugger API.
+//
+// The table is an evaluated expression named kStringTableExpressionName
+// appended after the other evaluated expressions, whose members hold the
+// strings as their values. A name or type of a variable, or a method name
+// or path of a stack frame, that starts with kStringTableReferencePrefix
+// is replaced by the string of the table at the decimal index after the
+// prefix. A string is only put in the table if that makes the snapshot
+// smaller, so snapshots without repeated strings are left as they are.
+//
+// Not thread-safe; it is used by the writer thread of breakpoints.
+class SnapshotStringTable {
+ public:
+  // Encodes the strings of breakpoint. Breakpoints without stack frames,
+  // such as hits of log points, are left as they are.
+  void Encode(google::cloud::diagnostics::debug::Breakpoint *breakpoint);
+
+ private:
+  // Replaces value with a reference if its string is in the table,
+  // deciding whether it is at its first replacement.
+  void Replace(std::string *value);
+
+  static const std::int64_t kUndecided = -1;
+  static const std::int64_t kInline = -2;
+
+  struct Entry {
+    // Number of times the string occurs in the snapshot.
+    std::uint32_t count = 0;
+
+    // The index of the string in the table, kUndecided if no occurrence
+    // was replaced yet or kInline if the string is not in the table.
+    std::int64_t index = kUndecided;
+  };
+
+  // The strings of the snapshot being encoded. Cleared after every
+  // snapshot but kept to reuse its buckets.
+  std::unordered_map<std::string, Entry> entries_;
+
+  // The strings of the table in order. They point to the keys of
+  // entries_, which do not move while the snapshot is encoded.
+  std::vector<const std::string *> table_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  SNAPSHOT_STRING_TABLE_H_
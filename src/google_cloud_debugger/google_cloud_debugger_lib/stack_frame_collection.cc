@@ -15,14 +15,24 @@
 #include "stack_frame_collection.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <string>
 
+#include "async_continuation_chain.h"
 #include "dbg_breakpoint.h"
 #include "expression_util.h"
+#include "frame_info_cache.h"
 #include "i_cor_debug_helper.h"
 #include "i_dbg_object_factory.h"
 #include "i_eval_coordinator.h"
+#include "i_portable_pdb_file.h"
+#include "metadata_cache.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "variable_wrapper.h"
 
 using google::cloud::diagnostics::debug::Breakpoint;
 using google::cloud::diagnostics::debug::SourceLocation;
@@ -30,14 +40,72 @@ using google::cloud::diagnostics::debug::StackFrame;
 using google::cloud::diagnostics::debug::Variable;
 using google_cloud_debugger_portable_pdb::LocalConstantInfo;
 using google_cloud_debugger_portable_pdb::LocalVariableInfo;
+using google_cloud_debugger_portable_pdb::Scope;
+using google_cloud_debugger_portable_pdb::ScopedMethodsPin;
 using google_cloud_debugger_portable_pdb::SequencePoint;
 using std::cerr;
 using std::cout;
-using std::max;
 using std::string;
 using std::vector;
 
 namespace google_cloud_debugger {
+
+namespace {
+
+// Gives async_frame, the MoveNext frame of the state machine of an async
+// method, the names of kickoff_frame, the frame of the async method.
+void TakeKickoffNames(const DbgStackFrame &kickoff_frame,
+                      DbgStackFrame *async_frame) {
+  async_frame->SetClass(kickoff_frame.GetClass());
+  async_frame->SetModuleName(kickoff_frame.GetModule());
+  async_frame->SetMethod(kickoff_frame.GetMethod());
+  async_frame->SetClassToken(kickoff_frame.GetClassToken());
+}
+
+// Returns true if method_name of class_name is part of the machinery that
+// starts and runs the state machines of async methods.
+bool IsAsyncInfrastructureMethod(const string &class_name,
+                                 const string &method_name) {
+  static const char *kBuilderClasses[] = {
+      "System.Runtime.CompilerServices.AsyncMethodBuilderCore",
+      "System.Runtime.CompilerServices.AsyncTaskMethodBuilder",
+      "System.Runtime.CompilerServices.AsyncTaskMethodBuilder`1",
+      "System.Runtime.CompilerServices.AsyncValueTaskMethodBuilder",
+      "System.Runtime.CompilerServices.AsyncValueTaskMethodBuilder`1",
+      "System.Runtime.CompilerServices.AsyncVoidMethodBuilder"};
+  static const string kExecutionContextClass =
+      "System.Threading.ExecutionContext";
+
+  if (method_name == "Start") {
+    return std::find(std::begin(kBuilderClasses), std::end(kBuilderClasses),
+                     class_name) != std::end(kBuilderClasses);
+  }
+
+  return class_name == kExecutionContextClass &&
+         (method_name == "Run" || method_name == "RunInternal");
+}
+
+// Returns true if the variables captured with limits and other_limits
+// are the same.
+bool SameCaptureLimits(const CaptureLimits &limits,
+                       const CaptureLimits &other_limits) {
+  return limits.max_collection_items == other_limits.max_collection_items &&
+         limits.array_capture_mode == other_limits.array_capture_mode &&
+         limits.array_range_start == other_limits.array_range_start &&
+         limits.max_depth == other_limits.max_depth &&
+         limits.max_string_length == other_limits.max_string_length &&
+         limits.max_object_bytes == other_limits.max_object_bytes &&
+         limits.max_bytes == other_limits.max_bytes &&
+         limits.max_stack_frames == other_limits.max_stack_frames &&
+         limits.max_stack_frames_with_variables ==
+             other_limits.max_stack_frames_with_variables &&
+         limits.max_capture_time_ms == other_limits.max_capture_time_ms &&
+         limits.capture_mask == other_limits.capture_mask &&
+         limits.debugger_display == other_limits.debugger_display;
+}
+
+}  // namespace
+
 StackFrameCollection::StackFrameCollection(
     std::shared_ptr<ICorDebugHelper> debug_helper,
     std::shared_ptr<IDbgObjectFactory> obj_factory)
@@ -48,6 +116,20 @@ HRESULT StackFrameCollection::ProcessBreakpoint(
         std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
         &pdb_files,
     DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator) {
+  HRESULT hr =
+      EvaluateConditionAndExpressions(pdb_files, breakpoint, eval_coordinator);
+  if (hr != S_OK) {
+    return hr;
+  }
+
+  return WalkStackAndProcessStackFrame(eval_coordinator, pdb_files);
+}
+
+HRESULT StackFrameCollection::EvaluateConditionAndExpressions(
+    const vector<
+        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+        &pdb_files,
+    DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator) {
   if (!breakpoint) {
     std::cerr << "DbgBreakpoint is null.";
     return E_INVALIDARG;
@@ -84,11 +166,12 @@ HRESULT StackFrameCollection::ProcessBreakpoint(
     }
   }
 
-  return WalkStackAndProcessStackFrame(eval_coordinator, pdb_files);
+  return S_OK;
 }
 
 HRESULT StackFrameCollection::PopulateStackFrames(
-    Breakpoint *breakpoint, IEvalCoordinator *eval_coordinator) {
+    Breakpoint *breakpoint, const CaptureLimits &limits,
+    IEvalCoordinator *eval_coordinator) {
   if (!breakpoint) {
     std::cerr << "Null breakpoint.";
     return E_INVALIDARG;
@@ -100,24 +183,56 @@ HRESULT StackFrameCollection::PopulateStackFrames(
   }
 
   HRESULT hr = S_OK;
+  size_t breakpoint_size = breakpoint->ByteSizeLong();
+
+  // Breakpoints at the same location capture the same variables, so the
+  // frames populated for one of them are copied to the others that are
+  // captured with the same limits, as long as they fit.
+  for (const auto &populated : populated_stack_frames_) {
+    if (SameCaptureLimits(populated.limits, limits) &&
+        breakpoint_size + populated.byte_size <= limits.max_bytes) {
+      breakpoint->mutable_stack_frames()->MergeFrom(populated.frames);
+      return S_OK;
+    }
+  }
+
+  // Only the stack frames are added to the breakpoint below, so its size
+  // is tracked from their sizes instead of measuring the whole breakpoint
+  // after every frame.
+  SnapshotSizeTracker size_tracker(breakpoint_size, limits.max_bytes);
+  int first_frame = breakpoint->stack_frames_size();
+
+  // Variables already in the queue of the thread, like the evaluated
+  // expressions of the breakpoint, are captured with the first frame
+  // captured with variables. The breakpoint is measured again after it,
+  // as they are not in the frame.
+  bool queued_variables = !VariableQueue::GetThreadQueue()->empty();
 
   // Gives the first frame half available kb in the breakpoint.
+  int max_bytes = limits.max_bytes;
   int frame_max_size =
-      (DbgBreakpoint::kMaximumBreakpointSize - breakpoint->ByteSize()) / 2;
+      (max_bytes - static_cast<int>(size_tracker.GetSize())) / 2;
   int processed_il_frames_so_far = 0;
+  std::uint32_t frames_so_far = 0;
 
   for (auto &&dbg_stack_frame : stack_frames_) {
+    // The stack may have been walked for a breakpoint with higher limits.
+    if (frames_so_far++ >= limits.max_stack_frames) {
+      break;
+    }
+
     // If this is the last processed IL frame, just gives it the rest
     // of the size available.
     if (processed_il_frames_so_far == number_of_processed_il_frames_ - 1) {
-      frame_max_size =
-          DbgBreakpoint::kMaximumBreakpointSize - breakpoint->ByteSize();
+      frame_max_size = max_bytes - static_cast<int>(size_tracker.GetSize());
     }
 
     StackFrame *frame = breakpoint->add_stack_frames();
     // If dbg_stack_frame is an empty stack frame, just says it's undebuggable.
     if (dbg_stack_frame->IsEmpty()) {
       frame->set_method_name("Undebuggable code.");
+      size_tracker.Add(
+          SnapshotSizeTracker::EmbeddedSize(frame->ByteSizeLong()));
       continue;
     }
 
@@ -133,7 +248,21 @@ HRESULT StackFrameCollection::PopulateStackFrames(
     frame_location->set_line(dbg_stack_frame->GetLineNumber());
     frame_location->set_path(dbg_stack_frame->GetFile());
 
-    hr = dbg_stack_frame->PopulateStackFrame(frame, frame_max_size,
+    // Frames past the ones this breakpoint captures variables of, or
+    // past the deadline of the capture, only report their location.
+    if (dbg_stack_frame->IsProcessedIlFrame() &&
+        (processed_il_frames_so_far >=
+             static_cast<int>(limits.max_stack_frames_with_variables) ||
+         limits.DeadlineExceeded())) {
+      size_tracker.Add(
+          SnapshotSizeTracker::EmbeddedSize(frame->ByteSizeLong()));
+      if (size_tracker.Exceeded()) {
+        break;
+      }
+      continue;
+    }
+
+    hr = dbg_stack_frame->PopulateStackFrame(frame, frame_max_size, limits,
                                              eval_coordinator);
     if (FAILED(hr)) {
       return hr;
@@ -143,54 +272,150 @@ HRESULT StackFrameCollection::PopulateStackFrames(
       ++processed_il_frames_so_far;
     }
 
-    if (breakpoint->ByteSize() > DbgBreakpoint::kMaximumBreakpointSize) {
+    if (queued_variables) {
+      size_tracker =
+          SnapshotSizeTracker(breakpoint->ByteSizeLong(), limits.max_bytes);
+      queued_variables = false;
+    } else {
+      size_tracker.Add(
+          SnapshotSizeTracker::EmbeddedSize(frame->ByteSizeLong()));
+    }
+    if (size_tracker.Exceeded()) {
       break;
     }
 
     // Updates frame_max_size to half of whatever is left.
     frame_max_size =
-        (DbgBreakpoint::kMaximumBreakpointSize - breakpoint->ByteSize()) / 2;
+        (max_bytes - static_cast<int>(size_tracker.GetSize())) / 2;
+  }
+
+  PopulatedStackFrames populated;
+  populated.limits = limits;
+  for (int i = first_frame; i < breakpoint->stack_frames_size(); ++i) {
+    *populated.frames.Add() = breakpoint->stack_frames(i);
+  }
+  populated.byte_size = size_tracker.GetSize() - breakpoint_size;
+  populated_stack_frames_.push_back(std::move(populated));
+
+  return S_OK;
+}
+
+HRESULT StackFrameCollection::ClassifyAsyncCaller(
+    ICorDebugFrame *caller_frame, const string &async_module,
+    mdTypeDef kickoff_class_token,
+    const std::vector<
+        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+        &parsed_pdb_files,
+    DbgStackFrame *caller, AsyncCallerKind *kind) {
+  FrameInfo names;
+  HRESULT hr = PopulateDbgStackFrameHelper(parsed_pdb_files, caller_frame,
+                                           caller, false, &names);
+  if (FAILED(hr)) {
+    return hr;
   }
 
+  if (caller->IsEmpty()) {
+    *kind = AsyncCallerKind::kOther;
+  } else if (names.async_infrastructure) {
+    *kind = AsyncCallerKind::kInfrastructure;
+  } else if (kickoff_class_token != 0 &&
+             names.class_token == kickoff_class_token &&
+             caller->GetModule() == async_module) {
+    *kind = AsyncCallerKind::kKickoff;
+  } else {
+    *kind = AsyncCallerKind::kOther;
+  }
   return S_OK;
 }
 
 HRESULT StackFrameCollection::PopulateAsyncStackFrameInfo(
     DbgStackFrame *async_frame, ICorDebugStackWalk *stack_walk,
+    mdTypeDef kickoff_class_token,
     const std::vector<
         std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
         &parsed_pdb_files) {
-  HRESULT hr;
-  // To get to the stack frame with the actual method information,
-  // we have to step through the stack twice.
-  for (int i = 0; i < 2; ++i) {
-    hr = stack_walk->Next();
+  while (true) {
+    HRESULT hr = stack_walk->Next();
+    if (FAILED(hr)) {
+      cerr << "Failed to get stack frame's information.";
+      return hr;
+    }
+
+    CComPtr<ICorDebugFrame> caller_frame;
+    hr = stack_walk->GetFrame(&caller_frame);
+    if (hr == S_FALSE) {
+      return S_OK;
+    }
+
+    if (FAILED(hr)) {
+      cerr << "Failed to get the stack after async method.";
+      return hr;
+    }
+
+    DbgStackFrame caller(debug_helper_, obj_factory_);
+    AsyncCallerKind kind;
+    hr = ClassifyAsyncCaller(caller_frame, async_frame->GetModule(),
+                             kickoff_class_token, parsed_pdb_files, &caller,
+                             &kind);
     if (FAILED(hr)) {
       cerr << "Failed to get stack frame's information.";
       return hr;
     }
+
+    if (kind == AsyncCallerKind::kInfrastructure) {
+      continue;
+    }
+
+    if (kind == AsyncCallerKind::kKickoff) {
+      TakeKickoffNames(caller, async_frame);
+    }
+    return S_OK;
   }
+}
 
-  CComPtr<ICorDebugFrame> real_method_frame;
-  hr = stack_walk->GetFrame(&real_method_frame);
-  if (hr == S_FALSE) {
-    cerr << "Failed to get the stack after async method.";
-    return E_FAIL;
+HRESULT StackFrameCollection::AppendAwaitingFrames(DbgStackFrame *async_frame,
+                                                   std::size_t max_frames,
+                                                   bool *appended) {
+  *appended = false;
+  AsyncContinuationChain chain(debug_helper_);
+  vector<CComPtr<ICorDebugValue>> awaiters;
+  HRESULT hr = chain.GetAwaitingStateMachines(
+      async_frame->GetAsyncStateMachine(), max_frames, &awaiters);
+  if (FAILED(hr)) {
+    return hr;
   }
 
-  std::shared_ptr<DbgStackFrame> real_method_stack_frame(
-      new DbgStackFrame(debug_helper_, obj_factory_));
-  hr = PopulateDbgStackFrameHelper(parsed_pdb_files, real_method_frame,
-                                   real_method_stack_frame.get(), false);
+  if (awaiters.empty()) {
+    return S_OK;
+  }
+
+  vector<std::shared_ptr<DbgStackFrame>> awaiting_frames;
+  awaiting_frames.reserve(awaiters.size());
+  for (const auto &awaiter : awaiters) {
+    std::shared_ptr<DbgStackFrame> awaiting_frame(
+        new (std::nothrow) DbgStackFrame(debug_helper_, obj_factory_));
+    if (!awaiting_frame) {
+      return E_OUTOFMEMORY;
+    }
+
+    hr = chain.PopulateAsyncMethodNames(awaiter, awaiting_frame.get());
+    if (FAILED(hr)) {
+      return hr;
+    }
+    awaiting_frames.push_back(std::move(awaiting_frame));
+  }
+
+  // There is no frame of the async method to take the names of once it
+  // was resumed, so they come from its state machine as well.
+  hr = chain.PopulateAsyncMethodNames(async_frame->GetAsyncStateMachine(),
+                                      async_frame);
   if (FAILED(hr)) {
-    cerr << "Failed to get stack frame's information.";
     return hr;
   }
 
-  async_frame->SetClass(real_method_stack_frame->GetClass());
-  async_frame->SetModuleName(real_method_stack_frame->GetModule());
-  async_frame->SetMethod(real_method_stack_frame->GetMethod());
-  async_frame->SetClassToken(real_method_stack_frame->GetClassToken());
+  stack_frames_.insert(stack_frames_.end(), awaiting_frames.begin(),
+                       awaiting_frames.end());
+  *appended = true;
   return S_OK;
 }
 
@@ -202,6 +427,14 @@ HRESULT StackFrameCollection::PopulateLocalVarsAndMethodArgs(
     return E_INVALIDARG;
   }
 
+  // The methods and scopes below are only read while they are pinned.
+  ScopedMethodsPin methods_pin(pdb_file);
+  if (!pdb_file->ParseMethods()) {
+    cerr << "Failed to parse methods of PDB file "
+         << pdb_file->GetModuleName();
+    return S_FALSE;
+  }
+
   HRESULT hr;
   // Retrieves the IP offset in the function that corresponds to this stack
   // frame.
@@ -219,22 +452,102 @@ HRESULT StackFrameCollection::PopulateLocalVarsAndMethodArgs(
     return S_FALSE;
   }
 
+  const std::vector<
+      std::unique_ptr<google_cloud_debugger_portable_pdb::IDocumentIndex>>
+      &documents = pdb_file->GetDocumentIndexTable();
+  const google_cloud_debugger_portable_pdb::MethodInfo *method_info = nullptr;
+  FrameInfo location;
+
+  // Repeat captures of the same frame skip the search below.
+  if (frame_info_cache_ &&
+      frame_info_cache_->Find(pdb_file->GetModuleName(), target_function_token,
+                              ip_offset, &location) &&
+      location.document_index < documents.size() &&
+      location.method_index <
+          documents[location.document_index]->GetMethods().size()) {
+    method_info = &documents[location.document_index]
+                       ->GetMethods()[location.method_index];
+  } else {
+    hr = FindFrameLocation(documents, dbg_stack_frame->GetFuncVirtualAddr(),
+                           ip_offset, metadata_import, &location);
+    if (hr != S_OK) {
+      return SUCCEEDED(hr) ? S_OK : hr;
+    }
+
+    method_info = &documents[location.document_index]
+                       ->GetMethods()[location.method_index];
+    if (frame_info_cache_) {
+      frame_info_cache_->Add(pdb_file->GetModuleName(), target_function_token,
+                             ip_offset, location);
+    }
+  }
+
+  // Sets the file path since we know we are in the correct function.
+  dbg_stack_frame->SetFile(location.file);
+  if (!location.has_sequence_point) {
+    return S_OK;
+  }
+
+  // Populates the list of local variables in dbg_stack_frame from the local
+  // variable's vector of the matching sequence point.
+  const SequencePoint &sequence_point =
+      method_info->sequence_points[location.sequence_point_index];
+  dbg_stack_frame->SetLineNumber(sequence_point.start_line);
+  // The local scopes of a method are only parsed once a frame in it is
+  // captured.
+  const vector<Scope> *local_scopes = nullptr;
+  if (!pdb_file->GetMethodScopes(method_info->method_def, &local_scopes)) {
+    cerr << "Failed to parse the local scopes of method "
+         << method_info->method_def;
+    return S_FALSE;
+  }
+
+  vector<LocalVariableInfo> local_variables;
+  vector<LocalConstantInfo> local_constants;
+  vector<std::uint32_t> scope_indices;
+  for (auto &&local_scope : *local_scopes) {
+    if (local_scope.start_offset > sequence_point.il_offset ||
+        local_scope.start_offset + local_scope.length <
+            sequence_point.il_offset) {
+      continue;
+    }
+
+    local_variables.insert(local_variables.end(),
+                           local_scope.local_variables.begin(),
+                           local_scope.local_variables.end());
+    local_constants.insert(local_constants.end(),
+                           local_scope.local_constants.begin(),
+                           local_scope.local_constants.end());
+    scope_indices.push_back(local_scope.index);
+  }
+
+  dbg_stack_frame->SetTypeDictionary(pdb_file->GetTypeDictionary());
+  dbg_stack_frame->SetLocalScopeIndices(std::move(scope_indices));
+  hr = dbg_stack_frame->Initialize(il_frame, local_variables,
+                                   local_constants, target_function_token,
+                                   metadata_import);
+  return S_OK;
+}
+
+HRESULT StackFrameCollection::FindFrameLocation(
+    const std::vector<
+        std::unique_ptr<google_cloud_debugger_portable_pdb::IDocumentIndex>>
+        &documents,
+    ULONG32 func_virtual_addr, ULONG32 ip_offset,
+    IMetaDataImport *metadata_import, FrameInfo *location) {
   // Loops through all methods in all the documents of the pdb file to find
   // a MethodInfo object that corresponds with the method at this breakpoint.
-  for (auto &&document_index : pdb_file->GetDocumentIndexTable()) {
-    for (auto &&method : document_index->GetMethods()) {
-      PCCOR_SIGNATURE current_method_signature = 0;
-      ULONG current_method_virtual_addr = 0;
-      mdTypeDef type_def = 0;
-      ULONG method_name_length = 0;
-      DWORD flags1 = 0;
-      ULONG signature_blob;
-      DWORD flags2 = 0;
-
-      hr = metadata_import->GetMethodProps(
-          method.method_def, &type_def, nullptr, 0, &method_name_length,
-          &flags1, &current_method_signature, &signature_blob,
-          &current_method_virtual_addr, &flags2);
+  for (size_t document_index = 0; document_index < documents.size();
+       ++document_index) {
+    const vector<google_cloud_debugger_portable_pdb::MethodInfo> &methods =
+        documents[document_index]->GetMethods();
+    for (size_t method_index = 0; method_index < methods.size();
+         ++method_index) {
+      const google_cloud_debugger_portable_pdb::MethodInfo &method =
+          methods[method_index];
+      MethodProps method_props;
+      HRESULT hr = MetadataCache::Global().GetMethodProps(
+          metadata_import, method.method_def, false, &method_props);
       if (FAILED(hr)) {
         cerr << "Failed to extract method info from method "
              << method.method_def;
@@ -243,61 +556,30 @@ HRESULT StackFrameCollection::PopulateLocalVarsAndMethodArgs(
 
       // Checks that the virtual address of this method matches the one of the
       // stack frame.
-      if (current_method_virtual_addr !=
-          dbg_stack_frame->GetFuncVirtualAddr()) {
+      if (method_props.virtual_address != func_virtual_addr) {
         continue;
       }
 
-      // Sets the file path since we know we are in the correct function.
-      dbg_stack_frame->SetFile(document_index->GetFilePath());
-
-      long matching_sequence_point_position = -1;
-
-      // We find the first non-hidden sequence point that is just larger than
-      // the ip offset.
-      for (long index = 0; index < method.sequence_points.size(); index++) {
-        if (!method.sequence_points[index].is_hidden &&
-            method.sequence_points[index].il_offset <= ip_offset) {
-          matching_sequence_point_position =
-              max(matching_sequence_point_position, index);
+      location->file = documents[document_index]->GetFilePath();
+      location->document_index = document_index;
+      location->method_index = method_index;
+
+      // We find the last non-hidden sequence point whose IL offset is not
+      // larger than the ip offset.
+      for (size_t i = 0; i < method.sequence_points.size(); ++i) {
+        const SequencePoint &candidate = method.sequence_points[i];
+        if (!candidate.is_hidden && candidate.il_offset <= ip_offset) {
+          location->line = candidate.start_line;
+          location->sequence_point_index = i;
+          location->has_sequence_point = true;
         }
       }
 
-      // If we find the matching sequence point, populates the list of local
-      // variables in dbg_stack_frame from the local variable's vector of the
-      // matching sequence point.
-      if (matching_sequence_point_position != -1) {
-        SequencePoint sequence_point =
-            method.sequence_points[matching_sequence_point_position];
-
-        dbg_stack_frame->SetLineNumber(sequence_point.start_line);
-        vector<LocalVariableInfo> local_variables;
-        vector<LocalConstantInfo> local_constants;
-        for (auto &&local_scope : method.local_scope) {
-          if (local_scope.start_offset > sequence_point.il_offset ||
-              local_scope.start_offset + local_scope.length <
-                  sequence_point.il_offset) {
-            continue;
-          }
-
-          local_variables.insert(local_variables.end(),
-                                 local_scope.local_variables.begin(),
-                                 local_scope.local_variables.end());
-          local_constants.insert(local_constants.end(),
-                                 local_scope.local_constants.begin(),
-                                 local_scope.local_constants.end());
-        }
-
-        hr = dbg_stack_frame->Initialize(il_frame, local_variables,
-                                         local_constants, target_function_token,
-                                         metadata_import);
-      }
-
       return S_OK;
     }
   }
 
-  return S_OK;
+  return S_FALSE;
 }
 
 HRESULT StackFrameCollection::PopulateModuleClassAndFunctionName(
@@ -307,55 +589,20 @@ HRESULT StackFrameCollection::PopulateModuleClassAndFunctionName(
     return E_INVALIDARG;
   }
 
-  HRESULT hr;
-  mdTypeDef type_def = 0;
-  ULONG method_name_length = 0;
-  DWORD flags1 = 0;
-  ULONG signature_blob = 0;
-  ULONG target_method_virtual_addr = 0;
-  DWORD flags2 = 0;
-  PCCOR_SIGNATURE target_method_signature = 0;
-
-  // Retrieves the length of the name of the method that this stack frame
-  // is at.
-  hr = metadata_import->GetMethodProps(
-      function_token, &type_def, nullptr, 0, &method_name_length, &flags1,
-      &target_method_signature, &signature_blob, &target_method_virtual_addr,
-      &flags2);
-
-  if (FAILED(hr)) {
-    cerr << "Failed to get length of name of method for stack frame.";
-    return hr;
-  }
-
-  std::vector<WCHAR> method_name(method_name_length, 0);
-
   // Retrieves the name of the method that this stack frame is at.
-  hr = metadata_import->GetMethodProps(
-      function_token, &type_def, method_name.data(), method_name.size(),
-      &method_name_length, &flags1, &target_method_signature, &signature_blob,
-      &target_method_virtual_addr, &flags2);
+  MetadataCache &metadata_cache = MetadataCache::Global();
+  MethodProps method_props;
+  HRESULT hr = metadata_cache.GetMethodProps(metadata_import, function_token,
+                                             true, &method_props);
   if (FAILED(hr)) {
     cerr << "Failed to get name of method for stack frame.";
     return hr;
   }
 
   // Retrieves the class name.
-  // TODO(quoct): Cache the class name in MethodInfo method.
-  mdToken extends_token;
-  DWORD class_flags;
-  ULONG class_name_length;
-  hr = metadata_import->GetTypeDefProps(
-      type_def, nullptr, 0, &class_name_length, &class_flags, &extends_token);
-  if (FAILED(hr)) {
-    cerr << "Failed to get length of name of class type for stack frame.";
-    return hr;
-  }
-
-  std::vector<WCHAR> class_name(class_name_length, 0);
-  hr = metadata_import->GetTypeDefProps(type_def, class_name.data(),
-                                        class_name.size(), &class_name_length,
-                                        &class_flags, &extends_token);
+  TypeProps class_props;
+  hr = metadata_cache.GetTypeProps(metadata_import, method_props.class_token,
+                                   true, &class_props);
   if (FAILED(hr)) {
     cerr << "Failed to get name of class type for stack frame.";
     return hr;
@@ -363,10 +610,10 @@ HRESULT StackFrameCollection::PopulateModuleClassAndFunctionName(
 
   // Even if we cannot get variables, we should still report
   // method and class name of this frame.
-  dbg_stack_frame->SetMethod(method_name);
-  dbg_stack_frame->SetClass(class_name);
-  dbg_stack_frame->SetClassToken(type_def);
-  dbg_stack_frame->SetFuncVirtualAddr(target_method_virtual_addr);
+  dbg_stack_frame->SetMethod(method_props.name);
+  dbg_stack_frame->SetClass(class_props.name);
+  dbg_stack_frame->SetClassToken(method_props.class_token);
+  dbg_stack_frame->SetFuncVirtualAddr(method_props.virtual_address);
 
   return S_OK;
 }
@@ -376,10 +623,33 @@ HRESULT StackFrameCollection::WalkStackAndProcessStackFrame(
     const std::vector<
         std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
         &parsed_pdb_files) {
+  DEBUGGER_TRACE_SPAN("StackFrameCollection::WalkStackAndProcessStackFrame");
   if (stack_walked_) {
     return S_OK;
   }
 
+  // Nothing to walk if no breakpoint captures stack frames.
+  if (max_stack_frames_ == 0) {
+    stack_walked_ = true;
+    return S_OK;
+  }
+
+  // If only the top frame is captured, it is the active frame of the
+  // thread and the stack is not unwound. Only an async top frame walks
+  // the stack, to find the name of its async method.
+  if (max_stack_frames_ == 1) {
+    HRESULT hr = ProcessFirstStack(eval_coordinator, parsed_pdb_files);
+    if (FAILED(hr)) {
+      cerr << "Failed to process the first stack.";
+      return hr;
+    }
+
+    first_stack_->CreateDeferredVariables();
+    stack_frames_.push_back(first_stack_);
+    stack_walked_ = true;
+    return S_OK;
+  }
+
   CComPtr<ICorDebugStackWalk> debug_stack_walk;
   CComPtr<ICorDebugFrame> frame;
   int il_frame_parsed_so_far = 0;
@@ -390,33 +660,51 @@ HRESULT StackFrameCollection::WalkStackAndProcessStackFrame(
     return hr;
   }
 
+  // The frame of the async method whose callers are being classified,
+  // if any, and the class of the async method (see ClassifyAsyncCaller).
+  DbgStackFrame *async_frame = nullptr;
+  mdTypeDef kickoff_class_token = 0;
+
   // Skips the first stack if it is already processed.
   if (first_stack_) {
+    first_stack_->CreateDeferredVariables();
     stack_frames_.push_back(first_stack_);
     ++frame_parsed_so_far;
     if (first_stack_->IsProcessedIlFrame()) {
       ++il_frame_parsed_so_far;
     }
 
-    int stack_to_skip = first_stack_->IsAsyncMethod() ? 3 : 1;
-    for (int i = 0; i < stack_to_skip; ++i) {
-      hr = debug_stack_walk->Next();
+    hr = debug_stack_walk->Next();
+
+    // ProcessFirstStack gave an async first frame the class of its async
+    // method, whose frame is hidden below along with the machinery.
+    if (first_stack_->IsAsyncMethod()) {
+      async_frame = first_stack_.get();
+      kickoff_class_token = first_stack_->GetClassToken();
     }
   }
 
+  // Frames whose names are resolved on frame_resolution_pool_.
+  std::vector<DeferredStackFrame> deferred_frames;
+  if (frame_resolution_pool_) {
+    deferred_frames.reserve(max_stack_frames_);
+  }
+
   // Walks through the stack and populates stack_frames_ vector.
   while (SUCCEEDED(hr)) {
-    // Don't parse too many stack frames.
-    if (frame_parsed_so_far >= kMaximumStackFrames) {
-      stack_walked_ = true;
-      return S_OK;
+    // Don't parse too many stack frames. The frames hidden above an
+    // async frame do not count.
+    if (!async_frame &&
+        frame_parsed_so_far >= static_cast<int>(max_stack_frames_)) {
+      hr = S_OK;
+      break;
     }
 
     hr = debug_stack_walk->GetFrame(&frame);
     // No more stacks.
     if (hr == S_FALSE) {
-      stack_walked_ = true;
-      return S_OK;
+      hr = S_OK;
+      break;
     }
 
     if (FAILED(hr)) {
@@ -424,14 +712,75 @@ HRESULT StackFrameCollection::WalkStackAndProcessStackFrame(
       return hr;
     }
 
+    // Hides the machinery that runs the state machine of an async frame
+    // and the frame of its async method, whose names it takes.
+    if (async_frame) {
+      DbgStackFrame caller(debug_helper_, obj_factory_);
+      AsyncCallerKind kind;
+      hr = ClassifyAsyncCaller(frame, async_frame->GetModule(),
+                               kickoff_class_token, parsed_pdb_files, &caller,
+                               &kind);
+      if (FAILED(hr)) {
+        cerr << "Failed to get async stack frame's information.";
+        return hr;
+      }
+
+      if (kind != AsyncCallerKind::kOther) {
+        if (kind == AsyncCallerKind::kKickoff) {
+          TakeKickoffNames(caller, async_frame);
+          async_frame = nullptr;
+        }
+        hr = debug_stack_walk->Next();
+        continue;
+      }
+
+      // The async method was resumed after an await, so the frames above
+      // are the thread pool that resumed it rather than its callers.
+      if (logical_async_stacks_ && async_frame->GetAsyncStateMachine() &&
+          frame_parsed_so_far < static_cast<int>(max_stack_frames_)) {
+        bool appended = false;
+        hr = AppendAwaitingFrames(async_frame,
+                                  max_stack_frames_ - frame_parsed_so_far,
+                                  &appended);
+        if (FAILED(hr)) {
+          // Falls back to the frames of the thread pool.
+          cerr << "Failed to follow the continuations of an async method.";
+        } else if (appended) {
+          break;
+        }
+      }
+
+      async_frame = nullptr;
+      if (frame_parsed_so_far >= static_cast<int>(max_stack_frames_)) {
+        break;
+      }
+    }
+
     // Do not process too many IL frames to minimize breakpoint size.
     bool process_il_frame =
-        il_frame_parsed_so_far < kMaximumStackFramesWithVariables;
+        il_frame_parsed_so_far <
+        static_cast<int>(max_stack_frames_with_variables_);
 
     std::shared_ptr<DbgStackFrame> stack_frame(
         new DbgStackFrame(debug_helper_, obj_factory_));
+
+    // Only frames with variables can be async methods, which move the
+    // stack walk, so the others are resolved after the walk.
+    if (frame_resolution_pool_ && !process_il_frame) {
+      DeferredStackFrame deferred;
+      deferred.debug_frame = frame;
+      deferred.stack_frame = stack_frame;
+      deferred_frames.push_back(deferred);
+
+      ++frame_parsed_so_far;
+      stack_frames_.push_back(std::move(stack_frame));
+      hr = debug_stack_walk->Next();
+      continue;
+    }
+
+    FrameInfo names;
     hr = PopulateDbgStackFrameHelper(parsed_pdb_files, frame, stack_frame.get(),
-                                     process_il_frame);
+                                     process_il_frame, &names);
     if (FAILED(hr)) {
       cerr << "Failed to process stack frame.";
       return hr;
@@ -443,15 +792,11 @@ HRESULT StackFrameCollection::WalkStackAndProcessStackFrame(
     }
 
     // If this is an async frame, the method name would be something like
-    // <RealMethodName>d__18.MoveNext. PopulateAsyncStackFrameInfo
-    // will populate stack_frame with the correct method name and class token.
+    // <RealMethodName>d__18.MoveNext. The frames walked next populate
+    // stack_frame with the correct method name and class token.
     if (stack_frame->IsAsyncMethod()) {
-      hr = PopulateAsyncStackFrameInfo(stack_frame.get(), debug_stack_walk,
-                                       parsed_pdb_files);
-      if (FAILED(hr)) {
-        cerr << "Failed to get async stack frame's information.";
-        return hr;
-      }
+      async_frame = stack_frame.get();
+      kickoff_class_token = names.enclosing_class_token;
     }
 
     stack_frames_.push_back(std::move(stack_frame));
@@ -462,10 +807,59 @@ HRESULT StackFrameCollection::WalkStackAndProcessStackFrame(
     cerr << "Failed to get stack frame's information.";
   }
 
+  HRESULT deferred_hr =
+      PopulateDeferredStackFrames(parsed_pdb_files, deferred_frames);
+  if (FAILED(deferred_hr)) {
+    cerr << "Failed to process stack frame.";
+    return deferred_hr;
+  }
+
   stack_walked_ = true;
   return hr;
 }
 
+HRESULT StackFrameCollection::PopulateDeferredStackFrames(
+    const std::vector<
+        std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+        &parsed_pdb_files,
+    const std::vector<DeferredStackFrame> &deferred_frames) {
+  if (deferred_frames.empty()) {
+    return S_OK;
+  }
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  size_t frames_left = deferred_frames.size();
+  HRESULT result = S_OK;
+
+  for (const DeferredStackFrame &deferred : deferred_frames) {
+    const DeferredStackFrame *deferred_frame = &deferred;
+    auto task = [this, &parsed_pdb_files, deferred_frame, &mutex, &done_cv,
+                 &frames_left, &result]() {
+      HRESULT hr = PopulateDbgStackFrameHelper(
+          parsed_pdb_files, deferred_frame->debug_frame,
+          deferred_frame->stack_frame.get(), false);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (FAILED(hr) && SUCCEEDED(result)) {
+        result = hr;
+      }
+      if (--frames_left == 0) {
+        done_cv.notify_one();
+      }
+    };
+
+    // Resolves the frame here if the pool is being destroyed.
+    if (!frame_resolution_pool_->Schedule(task)) {
+      task();
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [&frames_left]() { return frames_left == 0; });
+  return result;
+}
+
 HRESULT StackFrameCollection::EvaluateBreakpointCondition(
     DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator,
     const std::vector<
@@ -531,10 +925,14 @@ HRESULT StackFrameCollection::ProcessFirstStack(
     return hr;
   }
 
+  // The condition and the expressions only create the variables they
+  // read. The others are created if the stack is walked.
   first_stack_ = std::shared_ptr<DbgStackFrame>(
       new DbgStackFrame(debug_helper_, obj_factory_));
+  first_stack_->SetDeferVariableCreation(true);
+  FrameInfo names;
   hr = PopulateDbgStackFrameHelper(parsed_pdb_files, debug_frame,
-                                   first_stack_.get(), true);
+                                   first_stack_.get(), true, &names);
   if (FAILED(hr)) {
     std::cerr << "Failed to process stack frame.";
     first_stack_.reset();
@@ -554,6 +952,7 @@ HRESULT StackFrameCollection::ProcessFirstStack(
     }
 
     hr = PopulateAsyncStackFrameInfo(first_stack_.get(), debug_stack_walk,
+                                     names.enclosing_class_token,
                                      parsed_pdb_files);
     if (FAILED(hr)) {
       cerr << "Failed to get async stack frame's information.";
@@ -570,7 +969,7 @@ HRESULT StackFrameCollection::PopulateDbgStackFrameHelper(
         std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
         &parsed_pdb_files,
     ICorDebugFrame *debug_frame, DbgStackFrame *stack_frame,
-    bool process_il_frame) {
+    bool process_il_frame, FrameInfo *names) {
   // Gets ICorDebugFunction that corresponds to the function at this frame.
   // We delay the logic to query the IL frame until we have to get the
   // variables and method arguments.
@@ -616,25 +1015,66 @@ HRESULT StackFrameCollection::PopulateDbgStackFrameHelper(
   string target_module_name = stack_frame->GetModule();
 
   CComPtr<IMetaDataImport> metadata_import;
-  hr = debug_helper_->GetMetadataImportFromICorDebugModule(
-      frame_module, &metadata_import, &cerr);
-  if (FAILED(hr)) {
-    return hr;
+  FrameInfo frame_names;
+  if (!names) {
+    names = &frame_names;
   }
+  if (frame_info_cache_ &&
+      frame_info_cache_->Find(target_module_name, target_function_token,
+                              FrameInfoCache::kNoILOffset, names)) {
+    stack_frame->SetMethod(names->method_name);
+    stack_frame->SetClass(names->class_name);
+    stack_frame->SetClassToken(names->class_token);
+    stack_frame->SetFuncVirtualAddr(names->func_virtual_addr);
+  } else {
+    hr = debug_helper_->GetMetadataImportFromICorDebugModule(
+        frame_module, &metadata_import, &cerr);
+    if (FAILED(hr)) {
+      return hr;
+    }
 
-  // Populates the module, class and function name of this stack frame
-  // so we can report this even if we don't have local variables or
-  // method arguments.
-  hr = PopulateModuleClassAndFunctionName(stack_frame, target_function_token,
-                                          metadata_import);
-  if (FAILED(hr)) {
-    return hr;
+    // Populates the module, class and function name of this stack frame
+    // so we can report this even if we don't have local variables or
+    // method arguments.
+    hr = PopulateModuleClassAndFunctionName(stack_frame, target_function_token,
+                                            metadata_import);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    names->method_name = stack_frame->GetMethod();
+    names->class_name = stack_frame->GetClass();
+    names->class_token = stack_frame->GetClassToken();
+    names->func_virtual_addr = stack_frame->GetFuncVirtualAddr();
+    names->async_infrastructure =
+        IsAsyncInfrastructureMethod(names->class_name, names->method_name);
+
+    // The state machine of an async method is nested in its class.
+    mdTypeDef enclosing_class_token = 0;
+    if (names->method_name == "MoveNext" &&
+        SUCCEEDED(metadata_import->GetNestedClassProps(
+            names->class_token, &enclosing_class_token))) {
+      names->enclosing_class_token = enclosing_class_token;
+    }
+
+    if (frame_info_cache_) {
+      frame_info_cache_->Add(target_module_name, target_function_token,
+                             FrameInfoCache::kNoILOffset, *names);
+    }
   }
 
   if (!process_il_frame) {
     return S_OK;
   }
 
+  if (!metadata_import) {
+    hr = debug_helper_->GetMetadataImportFromICorDebugModule(
+        frame_module, &metadata_import, &cerr);
+    if (FAILED(hr)) {
+      return hr;
+    }
+  }
+
   CComPtr<ICorDebugILFrame> il_frame;
   hr = debug_frame->QueryInterface(__uuidof(ICorDebugILFrame),
                                    reinterpret_cast<void **>(&il_frame));
@@ -649,14 +1089,42 @@ HRESULT StackFrameCollection::PopulateDbgStackFrameHelper(
     return hr;
   }
 
+  if (modules_) {
+    CORDB_ADDRESS module_base_address;
+    hr = frame_module->GetBaseAddress(&module_base_address);
+    if (FAILED(hr)) {
+      cerr << "Failed to get the base address of the module.";
+      return hr;
+    }
+
+    std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>
+        pdb_file = modules_->FindByBaseAddress(module_base_address);
+    if (!pdb_file || !pdb_file->ParsePdbFile()) {
+      return S_FALSE;
+    }
+
+    stack_frame->SetModules(modules_);
+    hr = PopulateLocalVarsAndMethodArgs(target_function_token, stack_frame,
+                                        il_frame, metadata_import,
+                                        pdb_file.get());
+    if (FAILED(hr)) {
+      cerr << "Failed to populate stack frame information.";
+      return hr;
+    }
+
+    return S_OK;
+  }
+
   for (auto &&pdb_file : parsed_pdb_files) {
-    // TODO(quoct): Possible performance improvement by caching the pdb_file
-    // based on token.
     string pdb_module_name = pdb_file->GetModuleName();
     if (pdb_module_name.compare(target_module_name) != 0) {
       continue;
     }
 
+    if (!pdb_file->ParsePdbFile()) {
+      continue;
+    }
+
     // Tries to populate local variables and method arguments of this frame.
     hr = PopulateLocalVarsAndMethodArgs(target_function_token, stack_frame,
                                         il_frame, metadata_import,
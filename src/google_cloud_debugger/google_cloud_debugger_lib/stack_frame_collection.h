@@ -15,18 +15,66 @@
 #ifndef STACK_FRAME_COLLECTION_H_
 #define STACK_FRAME_COLLECTION_H_
 
+#include <cstddef>
 #include <vector>
 
 #include "dbg_stack_frame.h"
 #include "i_stack_frame_collection.h"
+#include "module_registry.h"
 
 namespace google_cloud_debugger {
 
+class FrameInfoCache;
+struct FrameInfo;
+class ThreadPool;
+
 class StackFrameCollection : public IStackFrameCollection {
  public:
   StackFrameCollection(std::shared_ptr<ICorDebugHelper> debug_helper,
                        std::shared_ptr<IDbgObjectFactory> obj_factory);
 
+  // Sets the pool that resolves the method and class names of the frames
+  // whose variables are not populated. If set, the stack walk only
+  // collects these frames and their names are resolved in parallel once
+  // the walk is done. Otherwise, every frame is processed as it is
+  // walked. The pool has to outlive this collection.
+  void SetFrameResolutionPool(ThreadPool *pool) {
+    frame_resolution_pool_ = pool;
+  }
+
+  // Sets the cache of the names and source locations of frames that is
+  // shared with other collections. Without it, every frame is looked up
+  // in the metadata and the PDB. The cache has to outlive this collection.
+  void SetFrameInfoCache(FrameInfoCache *cache) { frame_info_cache_ = cache; }
+
+  // Sets the snapshot of the loaded modules that the PDB files passed to
+  // this collection come from. With it, the PDB file of a frame is looked
+  // up by the base address of its module instead of searching the PDB
+  // files by module name.
+  void SetModules(std::shared_ptr<const ModuleSnapshot> modules) {
+    modules_ = std::move(modules);
+  }
+
+  // Sets how much of the stack is walked: at most max_stack_frames
+  // frames, the first max_stack_frames_with_variables IL frames of which
+  // get their variables. Has to cover the limits of every breakpoint
+  // whose stack frames are populated from this collection. If at most
+  // one frame is captured, only the active frame of the thread is read,
+  // without walking the stack.
+  void SetWalkLimits(const CaptureLimits &limits) {
+    max_stack_frames_ = limits.max_stack_frames;
+    max_stack_frames_with_variables_ = limits.max_stack_frames_with_variables;
+  }
+
+  // Sets whether the callers of an async method that was resumed after
+  // an await are the async methods awaiting it, found by following the
+  // continuations of its task, instead of the frames of the thread pool
+  // that resumed it. The awaiting methods are reported with their names
+  // only.
+  void SetLogicalAsyncStacks(bool logical_async_stacks) {
+    logical_async_stacks_ = logical_async_stacks;
+  }
+
   // This function first checks whether breakpoint has a condition.
   // If the condition evaluated to false, do nothing.
   // If there is no condition or the condition evaluated to true,
@@ -39,31 +87,97 @@ class StackFrameCollection : public IStackFrameCollection {
           &pdb_files,
       DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator) override;
 
-  // Populates the stack frames of a breakpoint using stack_frames.
+  // Evaluates the condition and the expressions of breakpoint without
+  // walking the stack. Returns S_FALSE if the condition evaluated to
+  // false.
+  HRESULT EvaluateConditionAndExpressions(
+      const std::vector<
+          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+          &pdb_files,
+      DbgBreakpoint *breakpoint, IEvalCoordinator *eval_coordinator) override;
+
+  // Populates the stack frames of a breakpoint using stack_frames,
+  // capturing the variables within limits. The frames are only captured
+  // once for the breakpoints populated with the same limits, the others
+  // get a copy of them if it fits in their max_bytes.
   // eval_coordinator will be used to perform eval coordination during function
   // evaluation if needed.
   HRESULT PopulateStackFrames(
       google::cloud::diagnostics::debug::Breakpoint *breakpoint,
+      const CaptureLimits &limits,
       IEvalCoordinator *eval_coordinator) override;
 
  private:
+  // A frame collected by the stack walk whose names are resolved later.
+  struct DeferredStackFrame {
+    CComPtr<ICorDebugFrame> debug_frame;
+    std::shared_ptr<DbgStackFrame> stack_frame;
+  };
+
+  // The stack frames populated for a breakpoint with limits.
+  struct PopulatedStackFrames {
+    CaptureLimits limits;
+    google::protobuf::RepeatedPtrField<
+        google::cloud::diagnostics::debug::StackFrame>
+        frames;
+    // Number of bytes the frames add to a breakpoint.
+    size_t byte_size = 0;
+  };
+
   // Class that contains helper method for ICorDebug objects.
   std::shared_ptr<ICorDebugHelper> debug_helper_;
 
   // Factory for creating DbgObject.
   std::shared_ptr<IDbgObjectFactory> obj_factory_;
 
+  // What a frame above the frame of an async method is.
+  enum class AsyncCallerKind {
+    // A frame of the machinery that runs the state machine, for example
+    // AsyncTaskMethodBuilder.Start or ExecutionContext.Run.
+    kInfrastructure,
+    // The frame of the async method that started the state machine.
+    kKickoff,
+    // Any other frame, for example when the state machine was resumed
+    // after an await.
+    kOther
+  };
+
+  // Classifies caller_frame, which is above the frame of an async method
+  // in the module async_module whose state machine is nested in the class
+  // kickoff_class_token. The names of caller_frame are populated in
+  // caller, through frame_info_cache_ if it has them, so that the frames
+  // that are hidden are identified by token without reading metadata
+  // again.
+  HRESULT ClassifyAsyncCaller(
+      ICorDebugFrame *caller_frame, const std::string &async_module,
+      mdTypeDef kickoff_class_token,
+      const std::vector<
+          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+          &parsed_pdb_files,
+      DbgStackFrame *caller, AsyncCallerKind *kind);
+
   // Populates the stack frame information for an async frame.
   // We need to do this because the async frame does not have information
   // like method name, class name and class token as it is a
-  // compile generated method. So we have to walk the frame twice
-  // and get to a frame that has this information.
+  // compile generated method. So we walk past the frames of the
+  // machinery that runs the state machine to the frame of the async
+  // method, whose class is kickoff_class_token, and take its names. The
+  // names are left alone if there is no such frame.
   HRESULT PopulateAsyncStackFrameInfo(
       DbgStackFrame *async_frame, ICorDebugStackWalk *stack_walk,
+      mdTypeDef kickoff_class_token,
       const std::vector<
           std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
           &parsed_pdb_files);
 
+  // Appends to stack_frames_ at most max_frames frames for the async
+  // methods awaiting the one of async_frame, which was resumed after an
+  // await, and gives async_frame the names of its async method. Sets
+  // appended to whether any frame was appended, otherwise nothing is
+  // changed.
+  HRESULT AppendAwaitingFrames(DbgStackFrame *async_frame,
+                               std::size_t max_frames, bool *appended);
+
   // Given a PDB file, this function tries to find the metadata of the function
   // with token target_function_token in the PDB file. If found, this function
   // will populate dbg_stack_frame using the metadata found and the
@@ -73,6 +187,17 @@ class StackFrameCollection : public IStackFrameCollection {
       ICorDebugILFrame *il_frame, IMetaDataImport *metadata_import,
       google_cloud_debugger_portable_pdb::IPortablePdbFile *pdb_files);
 
+  // Searches documents for the method whose virtual address is
+  // func_virtual_addr and the sequence point of ip_offset in it, and
+  // stores what is found in location. Returns S_FALSE if there is no
+  // such method.
+  HRESULT FindFrameLocation(
+      const std::vector<
+          std::unique_ptr<google_cloud_debugger_portable_pdb::IDocumentIndex>>
+          &documents,
+      ULONG32 func_virtual_addr, ULONG32 ip_offset,
+      IMetaDataImport *metadata_import, FrameInfo *location);
+
   // Populates the module, class and function name of a stack frame
   // using function_token (represents function the frame is in)
   // and IMetaDataImport (from the module the frame is in).
@@ -122,12 +247,23 @@ class StackFrameCollection : public IStackFrameCollection {
   // If process_il_frame is set to true, this function will try to convert
   // debug_frame to an ICorDebugILFrame and retrieve local variables and
   // method arguments from the frame.
+  // If names is not null, the names of the method of the frame and how
+  // it relates to async methods are stored in it.
   HRESULT PopulateDbgStackFrameHelper(
       const std::vector<
           std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
           &parsed_pdb_files,
       ICorDebugFrame *debug_frame, DbgStackFrame *stack_frame,
-      bool process_il_frame);
+      bool process_il_frame, FrameInfo *names = nullptr);
+
+  // Populates the module, class and function names of deferred_frames
+  // on frame_resolution_pool_ and waits until all of them are done.
+  // Returns the first failure, if any.
+  HRESULT PopulateDeferredStackFrames(
+      const std::vector<
+          std::shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
+          &parsed_pdb_files,
+      const std::vector<DeferredStackFrame> &deferred_frames);
 
   // Vectors of stack frames that this collection owns.
   std::vector<std::shared_ptr<DbgStackFrame>> stack_frames_;
@@ -135,6 +271,10 @@ class StackFrameCollection : public IStackFrameCollection {
   // The very top stack frame of this collection.
   std::shared_ptr<DbgStackFrame> first_stack_;
 
+  // The stack frames populated by PopulateStackFrames, which are copied
+  // to the breakpoints populated later with the same limits.
+  std::vector<PopulatedStackFrames> populated_stack_frames_;
+
   // Number of processed IL frames in stack_frames_.
   int number_of_processed_il_frames_ = 0;
 
@@ -142,11 +282,26 @@ class StackFrameCollection : public IStackFrameCollection {
   // This means stack_frames_ vector should have been populated.
   bool stack_walked_ = false;
 
+  // Pool that resolves the names of frames without variables, or null
+  // if the frames are processed as the stack is walked.
+  ThreadPool *frame_resolution_pool_ = nullptr;
+
+  // If true, the callers of resumed async methods are the async methods
+  // awaiting them (see SetLogicalAsyncStacks).
+  bool logical_async_stacks_ = false;
+
+  // Cache of the names and source locations of frames, or null.
+  FrameInfoCache *frame_info_cache_ = nullptr;
+
+  // Snapshot of the loaded modules, or null.
+  std::shared_ptr<const ModuleSnapshot> modules_;
+
   // Maximum number of stack frames to be parsed.
-  static const std::uint32_t kMaximumStackFrames = 20;
+  std::uint32_t max_stack_frames_ = CaptureLimits::kDefaultMaxStackFrames;
 
   // Maximum number of stack frames with populated variables to be parsed.
-  static const std::uint32_t kMaximumStackFramesWithVariables = 4;
+  std::uint32_t max_stack_frames_with_variables_ =
+      CaptureLimits::kDefaultMaxStackFramesWithVariables;
 };
 
 }  //  namespace google_cloud_debugger
@@ -0,0 +1,59 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "string_pool.h"
+
+#include <mutex>
+#include <unordered_set>
+
+using std::string;
+
+namespace google_cloud_debugger_portable_pdb {
+
+namespace {
+
+// Strings of the pool. Elements of an unordered_set are never moved,
+// so handles stay valid when the set grows.
+struct Pool {
+  std::mutex mutex;
+  std::unordered_set<string> strings;
+};
+
+// The pool is created on first use and never destroyed, so handles
+// stay valid during static destruction.
+Pool &GetPool() {
+  static Pool *pool = new Pool();
+  return *pool;
+}
+
+}  // namespace
+
+InternedString::InternedString() {
+  static const InternedString empty = StringPool::Intern("");
+  value_ = empty.value_;
+}
+
+InternedString StringPool::Intern(const string &value) {
+  Pool &pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  return InternedString(&(*pool.strings.insert(value).first));
+}
+
+size_t StringPool::Size() {
+  Pool &pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  return pool.strings.size();
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
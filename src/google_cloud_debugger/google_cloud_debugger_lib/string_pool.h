@@ -0,0 +1,76 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STRING_POOL_H_
+#define STRING_POOL_H_
+
+#include <cstddef>
+#include <string>
+
+namespace google_cloud_debugger_portable_pdb {
+
+class StringPool;
+
+// Handle to a string stored in the StringPool. Copying a handle copies a
+// pointer, and two handles are equal if and only if they refer to the
+// same string, so comparing them does not compare characters.
+class InternedString {
+ public:
+  // Creates a handle to the empty string.
+  InternedString();
+
+  // Returns the string this handle refers to. The reference is valid
+  // for the lifetime of the process.
+  const std::string &str() const { return *value_; }
+
+  bool operator==(const InternedString &other) const {
+    return value_ == other.value_;
+  }
+
+  bool operator!=(const InternedString &other) const {
+    return value_ != other.value_;
+  }
+
+ private:
+  friend class StringPool;
+
+  explicit InternedString(const std::string *value) : value_(value) {}
+
+  // The string in the pool.
+  const std::string *value_;
+};
+
+// Process-wide pool of the strings read from Portable PDBs.
+//
+// Names of local variables and constants such as "this", "i" or
+// "CS$<>8__locals0" appear in almost every method of every module, so
+// storing a copy of them per LocalVariableInfo wastes a lot of memory.
+// Every PDB interns its strings here instead and keeps a handle. Strings
+// are never removed from the pool, which is fine since the set of distinct
+// names of an application is small.
+//
+// This class is thread-safe.
+class StringPool {
+ public:
+  // Returns the handle to the string in the pool that equals value,
+  // adding value to the pool if it is not there yet.
+  static InternedString Intern(const std::string &value);
+
+  // Returns the number of distinct strings in the pool.
+  static std::size_t Size();
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // STRING_POOL_H_
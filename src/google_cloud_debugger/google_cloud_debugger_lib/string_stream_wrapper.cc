@@ -14,8 +14,16 @@
 
 #include "string_stream_wrapper.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "breakpoint.pb.h"
 
 using google::cloud::diagnostics::debug::Status;
@@ -25,6 +33,37 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
+std::ostream *StringStreamWrapper::GetErrorStream() {
+  if (!error_stream_) {
+    error_stream_.reset(new (std::nothrow) ErrorStream(&error_));
+    if (!error_stream_) {
+      return nullptr;
+    }
+  }
+  return &error_stream_->stream;
+}
+
+void StringStreamWrapper::ResetErrorStream() {
+  error_.clear();
+  if (error_stream_) {
+    error_stream_->stream.clear();
+  }
+}
+
+StringStreamWrapper::ErrorBuffer::int_type
+StringStreamWrapper::ErrorBuffer::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    error_->push_back(traits_type::to_char_type(c));
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize StringStreamWrapper::ErrorBuffer::xsputn(
+    const char *s, std::streamsize count) {
+  error_->append(s, count);
+  return count;
+}
+
 void SetErrorStatusMessage(Variable *variable, const std::string &err_string) {
   assert(variable != nullptr);
 
@@ -34,6 +73,15 @@ void SetErrorStatusMessage(Variable *variable, const std::string &err_string) {
   variable->set_allocated_status(status.release());
 }
 
+void SetInfoStatusMessage(Variable *variable, const std::string &message) {
+  assert(variable != nullptr);
+
+  std::unique_ptr<Status> status(new (std::nothrow) Status());
+  status->set_message(message);
+  status->set_iserror(false);
+  variable->set_allocated_status(status.release());
+}
+
 void SetErrorStatusMessage(Variable *variable,
     StringStreamWrapper *string_stream) {
   assert(string_stream != nullptr);
@@ -92,48 +140,125 @@ vector<WCHAR> ConvertStringToWCharPtr(const std::string &target_string) {
 #endif
 }
 
-string ConvertWCharPtrToString(const WCHAR *wchar_string) {
-  if (!wchar_string || !(*wchar_string)) {
+// Converts the ASCII characters at the beginning of utf16 to utf8 16 at
+// a time and returns how many were converted. Stops at the first block
+// of 16 that has a character that is not ASCII.
+static size_t ConvertAsciiPrefix(const WCHAR *utf16, size_t length,
+                                 char *utf8) {
+  size_t converted = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128i non_ascii_mask = _mm_set1_epi16(static_cast<int16_t>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  while (length - converted >= 16) {
+    __m128i low = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(utf16 + converted));
+    __m128i high = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(utf16 + converted + 8));
+    __m128i non_ascii =
+        _mm_and_si128(_mm_or_si128(low, high), non_ascii_mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(utf8 + converted),
+                     _mm_packus_epi16(low, high));
+    converted += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  while (length - converted >= 16) {
+    uint16x8_t low = vld1q_u16(reinterpret_cast<const uint16_t *>(utf16) +
+                               converted);
+    uint16x8_t high = vld1q_u16(reinterpret_cast<const uint16_t *>(utf16) +
+                                converted + 8);
+    if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+      break;
+    }
+    vst1q_u8(reinterpret_cast<uint8_t *>(utf8 + converted),
+             vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    converted += 16;
+  }
+#endif
+  return converted;
+}
+
+string ConvertWCharPtrToString(const WCHAR *wchar_string, size_t length) {
+  if (!wchar_string || length == 0) {
     return string();
   }
 
-#ifdef PAL_STDCPP_COMPAT
-  // TODO(quoct): I cannot link the WideCharToMultiByte library on Linux.
-  // If I add -lcoreclr or -lmscordaccore, then the linking works but
-  // when running, the debugger will run into errors. Needs someone smarter
-  // for this linking.
-  std::wstring temp_wstring;
-  while (wchar_string && *wchar_string) {
-    WCHAR current_char = *wchar_string;
-    temp_wstring += static_cast<wchar_t>(current_char);
-    ++wchar_string;
+  // A UTF-16 code unit takes at most 3 bytes in UTF-8. A surrogate pair
+  // takes 4 bytes for 2 code units.
+  string result(length * 3, 0);
+  char *utf8 = &result[0];
+  size_t utf8_length = 0;
+  size_t i = 0;
+  while (i < length) {
+    size_t ascii = ConvertAsciiPrefix(wchar_string + i, length - i,
+                                      utf8 + utf8_length);
+    i += ascii;
+    utf8_length += ascii;
+
+    // Converts characters one by one until the next ASCII block can
+    // start, so that mostly ASCII strings stay on the fast path.
+    size_t block_end = std::min(length, i + 16);
+    while (i < block_end) {
+      uint32_t code_point = wchar_string[i++];
+      if (code_point < 0x80) {
+        utf8[utf8_length++] = static_cast<char>(code_point);
+        continue;
+      }
+
+      if (code_point < 0x800) {
+        utf8[utf8_length++] = static_cast<char>(0xC0 | (code_point >> 6));
+        utf8[utf8_length++] = static_cast<char>(0x80 | (code_point & 0x3F));
+        continue;
+      }
+
+      if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+        // Combines a surrogate pair. A lone surrogate cannot be encoded,
+        // so it becomes the replacement character U+FFFD.
+        if (code_point <= 0xDBFF && i < length &&
+            wchar_string[i] >= 0xDC00 && wchar_string[i] <= 0xDFFF) {
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                       (wchar_string[i++] - 0xDC00);
+          utf8[utf8_length++] = static_cast<char>(0xF0 | (code_point >> 18));
+          utf8[utf8_length++] =
+              static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+          utf8[utf8_length++] =
+              static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+          utf8[utf8_length++] = static_cast<char>(0x80 | (code_point & 0x3F));
+          continue;
+        }
+        code_point = 0xFFFD;
+      }
+
+      utf8[utf8_length++] = static_cast<char>(0xE0 | (code_point >> 12));
+      utf8[utf8_length++] =
+          static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      utf8[utf8_length++] = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
   }
 
-  return string(temp_wstring.begin(), temp_wstring.end());
-#else
-  // We feeds WideCharToMultiByte a null terminated WCHAR string and it will
-  // tells us the size of the string so we can create a CHAR string with the
-  // same length.
-  int string_size = WideCharToMultiByte(CP_UTF8, 0, wchar_string, -1, nullptr,
-                                        0, nullptr, nullptr);
-
-  string result(string_size, 0);
-  // This time, WideCharToMultiByte will fill up the result buffer with
-  // converted char.
-  string_size = WideCharToMultiByte(CP_UTF8, 0, wchar_string, -1, &result[0],
-                                    result.size(), nullptr, nullptr);
-  if (string_size == 0) {
+  result.resize(utf8_length);
+  return result;
+}
+
+string ConvertWCharPtrToString(const WCHAR *wchar_string) {
+  if (!wchar_string) {
     return string();
   }
 
-  // Minus one for the null-terminating character.
-  result.pop_back();
-  return result;
-#endif
+  size_t length = 0;
+  while (wchar_string[length]) {
+    ++length;
+  }
+  return ConvertWCharPtrToString(wchar_string, length);
 }
 
 std::string ConvertWCharPtrToString(const vector<WCHAR> &wchar_vector) {
-  return ConvertWCharPtrToString(wchar_vector.data());
+  // The vector may be bigger than the null-terminated string in it.
+  auto end = std::find(wchar_vector.begin(), wchar_vector.end(), 0);
+  return ConvertWCharPtrToString(wchar_vector.data(),
+                                 end - wchar_vector.begin());
 }
 
 }  // namespace google_cloud_debugger
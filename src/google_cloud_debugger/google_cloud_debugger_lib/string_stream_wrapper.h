@@ -16,7 +16,8 @@
 #define STRING_STREAM_WRAPPER_H_
 
 #include <memory>
-#include <sstream>
+#include <ostream>
+#include <streambuf>
 #include <string>
 #include <vector>
 
@@ -25,41 +26,70 @@
 
 namespace google_cloud_debugger {
 
-// This class is meant to be inherited and used for outputting error and
-// output stream to the underlying ostringstream. It has methods to set the
-// underlying streams as well as collecting the output and error stream.
+// This class is meant to be inherited and used for collecting the error
+// messages of an object. Most objects never fail, so nothing is allocated
+// until an error is written: the messages are kept in a string that starts
+// empty, and the stream that GetErrorStream returns for helpers that take
+// an std::ostream is only created the first time it is asked for. Whatever
+// is written to that stream is appended to the same string.
 // This class is NOT thread-safe.
 class StringStreamWrapper {
  public:
-  // Sets error_stream_ to error_stream and returns the old error stream.
-  std::ostringstream *SetErrorStream(std::ostringstream *error_stream) {
-    std::ostringstream *old_stream = error_stream_.release();
-    error_stream_.reset(error_stream);
-    return old_stream;
+  StringStreamWrapper() = default;
+
+  // The error stream writes to the messages of the object that created it,
+  // so it is not moved with them.
+  StringStreamWrapper(StringStreamWrapper &&other)
+      : error_(std::move(other.error_)) {}
+  StringStreamWrapper &operator=(StringStreamWrapper &&other) {
+    error_ = std::move(other.error_);
+    return *this;
   }
 
-  // Writes the string error to the error_stream_.
+  // Writes the string error to the error messages.
   void WriteError(const std::string &error) {
-    *error_stream_ << error << std::endl;
+    error_.append(error);
+    error_.push_back('\n');
   }
 
-  // Gets the underlying error stream.
-  std::ostringstream *GetErrorStream() { return error_stream_.get(); }
+  // Gets the error stream, creating it if this is the first call.
+  // Returns null if it cannot be created.
+  std::ostream *GetErrorStream();
 
-  // Gets string collected in the error stream.
-  std::string GetErrorString() { return error_stream_->str(); }
+  // Gets the error messages collected so far.
+  const std::string &GetErrorString() const { return error_; }
 
-  // Resets the error stream.
-  void ResetErrorStream() {
-    error_stream_->str("");
-    error_stream_->clear();
-  }
+  // Clears the error messages.
+  void ResetErrorStream();
 
  private:
-  // The underlying error stream.
-  std::unique_ptr<std::ostringstream> error_stream_ =
-      std::unique_ptr<std::ostringstream>(new (std::nothrow)
-                                              std::ostringstream());
+  // Stream buffer that appends what is written to a string.
+  class ErrorBuffer : public std::streambuf {
+   public:
+    explicit ErrorBuffer(std::string *error) : error_(error) {}
+
+   protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char *s, std::streamsize count) override;
+
+   private:
+    std::string *error_;
+  };
+
+  // The error stream and its buffer, created together by GetErrorStream.
+  struct ErrorStream {
+    explicit ErrorStream(std::string *error)
+        : buffer(error), stream(&buffer) {}
+
+    ErrorBuffer buffer;
+    std::ostream stream;
+  };
+
+  // The error messages.
+  std::string error_;
+
+  // The error stream, or null until GetErrorStream is called.
+  std::unique_ptr<ErrorStream> error_stream_;
 };
 
 // Sets the Status field of variable using error string err_string.
@@ -71,6 +101,10 @@ void SetErrorStatusMessage(google::cloud::diagnostics::debug::Variable *var,
 void SetErrorStatusMessage(google::cloud::diagnostics::debug::Variable *var,
                            StringStreamWrapper *string_stream);
 
+// Sets the Status field of variable to message, which is not an error.
+void SetInfoStatusMessage(google::cloud::diagnostics::debug::Variable *var,
+                          const std::string &message);
+
 // Sets the Status field of breakpoint using error string err_string.
 void SetErrorStatusMessage(
     google::cloud::diagnostics::debug::Breakpoint *breakpoint,
@@ -87,9 +121,14 @@ std::vector<WCHAR> ConvertStringToWCharPtr(const std::string &target_string);
 std::string ConvertWCharPtrToString(const WCHAR *wchar_string);
 
 // ConvertWCharPtrToString functions that takes in a vector
-// instead of WCHAR array.
+// instead of WCHAR array. Stops at the first null character.
 std::string ConvertWCharPtrToString(const std::vector<WCHAR> &wchar_vector);
 
+// Converts the UTF-16 string of length code units at wchar_string to
+// UTF-8. Runs of ASCII characters are converted with SIMD instructions
+// where they are available. Unpaired surrogates become U+FFFD.
+std::string ConvertWCharPtrToString(const WCHAR *wchar_string, size_t length);
+
 }  // namespace google_cloud_debugger
 
 #endif
@@ -0,0 +1,61 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "strong_handle_pool.h"
+
+namespace google_cloud_debugger {
+
+thread_local StrongHandlePool *StrongHandlePool::current_ = nullptr;
+
+bool StrongHandlePool::Find(CORDB_ADDRESS address,
+                            ICorDebugHandleValue **handle) const {
+  if (address == 0) {
+    return false;
+  }
+
+  auto found = handles_by_address_.find(address);
+  if (found == handles_by_address_.end()) {
+    return false;
+  }
+
+  *handle = found->second;
+  (*handle)->AddRef();
+  return true;
+}
+
+void StrongHandlePool::Add(CORDB_ADDRESS address,
+                           ICorDebugHandleValue *handle) {
+  if (!handle) {
+    return;
+  }
+
+  CComPtr<ICorDebugHandleValue> pooled_handle;
+  pooled_handle = handle;
+  if (address != 0) {
+    handles_by_address_[address] = pooled_handle;
+  }
+  handles_.push_back(pooled_handle);
+}
+
+void StrongHandlePool::DisposeAll() {
+  // The DbgObjects that still hold a handle see it as disposed if they
+  // use it, like a handle of an object that was collected.
+  for (auto &handle : handles_) {
+    handle->Dispose();
+  }
+  handles_by_address_.clear();
+  handles_.clear();
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,82 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STRONG_HANDLE_POOL_H_
+#define STRONG_HANDLE_POOL_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "ccomptr.h"
+#include "cor.h"
+#include "cordebug.h"
+
+namespace google_cloud_debugger {
+
+// The strong handles created while a debuggee thread is stopped at
+// breakpoints. The DbgObjects of the hit that hold the same object share
+// its handle instead of each creating one, and all the handles are
+// disposed together once the hit is done instead of whenever the last
+// DbgObject holding them is freed.
+//
+// Objects are matched by address, which the garbage collector may change
+// once the debuggee runs, so the addresses are forgotten before every
+// function evaluation while the handles are kept until the end of the
+// hit.
+class StrongHandlePool {
+ public:
+  StrongHandlePool() = default;
+  StrongHandlePool(const StrongHandlePool &) = delete;
+  StrongHandlePool &operator=(const StrongHandlePool &) = delete;
+
+  // Returns the pool of the hit the calling thread is processing, or
+  // null if there is none.
+  static StrongHandlePool *GetCurrent() { return current_; }
+
+  // Sets the pool of the hit the calling thread is processing.
+  static void SetCurrent(StrongHandlePool *pool) { current_ = pool; }
+
+  // Gets the handle created for the object at address since the
+  // addresses were last forgotten. Returns false if there is none.
+  bool Find(CORDB_ADDRESS address, ICorDebugHandleValue **handle) const;
+
+  // Adds handle, the handle of the object at address. If address is 0,
+  // the handle is only disposed with the others.
+  void Add(CORDB_ADDRESS address, ICorDebugHandleValue *handle);
+
+  // Forgets the addresses of the objects of the handles, which are not
+  // valid once the debuggee runs.
+  void ForgetAddresses() { handles_by_address_.clear(); }
+
+  // Disposes all the handles added and forgets them.
+  void DisposeAll();
+
+  // Returns the number of handles added since they were last disposed.
+  std::size_t GetHandleCount() const { return handles_.size(); }
+
+ private:
+  // The handles by the address of their object.
+  std::map<CORDB_ADDRESS, CComPtr<ICorDebugHandleValue>> handles_by_address_;
+
+  // All the handles added.
+  std::vector<CComPtr<ICorDebugHandleValue>> handles_;
+
+  // The pool of the hit each thread is processing.
+  static thread_local StrongHandlePool *current_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  STRONG_HANDLE_POOL_H_
@@ -0,0 +1,487 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "symbol_store_pdb_provider.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef PLATFORM_UNIX
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "metrics.h"
+
+using google_cloud_debugger::DebuggerMetrics;
+using google_cloud_debugger::ScopedLatencyTimer;
+using std::cerr;
+using std::string;
+
+namespace google_cloud_debugger_portable_pdb {
+
+namespace {
+
+// Prefix of the URLs of symbol servers.
+const string kHttpScheme = "http://";
+
+// Printed instead of the age in the keys of Portable PDBs.
+const string kPortablePdbAgeSuffix = "ffffffff";
+
+#ifdef PLATFORM_UNIX
+// How many redirects a download follows.
+const int kMaxRedirects = 5;
+
+// How long a download waits for the server before it fails.
+const int kSocketTimeoutSeconds = 30;
+
+// Maximum size of the status line and headers of a response.
+const size_t kMaxResponseHeaderSize = 64 * 1024;
+
+// Closes a socket when it goes out of scope.
+class ScopedSocket {
+ public:
+  explicit ScopedSocket(int socket) : socket_(socket) {}
+  ScopedSocket(const ScopedSocket &) = delete;
+  ScopedSocket &operator=(const ScopedSocket &) = delete;
+  ~ScopedSocket() {
+    if (socket_ >= 0) {
+      close(socket_);
+    }
+  }
+
+  int Get() const { return socket_; }
+
+ private:
+  int socket_;
+};
+
+// Returns a socket connected to port of host, or -1 if it cannot connect.
+int Connect(const string &host, const string &port) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *addresses = nullptr;
+  int result = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+  if (result != 0) {
+    cerr << "Cannot resolve symbol server " << host << ": "
+         << gai_strerror(result) << std::endl;
+    return -1;
+  }
+
+  int connected = -1;
+  for (struct addrinfo *address = addresses; address;
+       address = address->ai_next) {
+    int candidate = socket(address->ai_family, address->ai_socktype,
+                           address->ai_protocol);
+    if (candidate < 0) {
+      continue;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = kSocketTimeoutSeconds;
+    timeout.tv_usec = 0;
+    setsockopt(candidate, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(candidate, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(candidate, address->ai_addr, address->ai_addrlen) == 0) {
+      connected = candidate;
+      break;
+    }
+    close(candidate);
+  }
+
+  freeaddrinfo(addresses);
+  if (connected < 0) {
+    cerr << "Cannot connect to symbol server " << host << ":" << port
+         << std::endl;
+  }
+  return connected;
+}
+
+// Sends all of data to socket.
+bool SendAll(int socket, const string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t result = send(socket, data.data() + sent, data.size() - sent, 0);
+    if (result <= 0) {
+      return false;
+    }
+    sent += result;
+  }
+  return true;
+}
+
+// Returns the value of the header name in headers, which are the
+// headers of a response with one header per line, or an empty string.
+string GetHeader(const string &headers, const string &name) {
+  size_t line_start = headers.find("\r\n");
+  while (line_start != string::npos) {
+    line_start += 2;
+    size_t line_end = headers.find("\r\n", line_start);
+    string line = headers.substr(line_start, line_end == string::npos
+                                                 ? string::npos
+                                                 : line_end - line_start);
+    size_t colon = line.find(':');
+    if (colon == name.size()) {
+      bool matches = true;
+      for (size_t i = 0; i < colon; ++i) {
+        if (std::tolower(static_cast<unsigned char>(line[i])) !=
+            std::tolower(static_cast<unsigned char>(name[i]))) {
+          matches = false;
+          break;
+        }
+      }
+
+      if (matches) {
+        size_t value_start = line.find_first_not_of(" \t", colon + 1);
+        size_t value_end = line.find_last_not_of(" \t");
+        if (value_start == string::npos) {
+          return string();
+        }
+        return line.substr(value_start, value_end - value_start + 1);
+      }
+    }
+    line_start = line_end;
+  }
+  return string();
+}
+#endif  // PLATFORM_UNIX
+
+// Returns file in directory.
+string JoinPath(const string &directory, const string &file) {
+  if (directory.empty() || directory.back() == '/' ||
+      directory.back() == '\\') {
+    return directory + file;
+  }
+  return directory + "/" + file;
+}
+
+// Returns true if file exists and can be read.
+bool FileExists(const string &file) {
+  std::ifstream stream(file, std::ios::in | std::ios::binary);
+  return stream.good();
+}
+
+// Returns the file name of pdb_info's path, or an empty string if it
+// has none. The path may have either directory separator, depending on
+// where the module was built.
+string GetPdbFileName(const CodeViewPdbInfo &pdb_info) {
+  size_t separator = pdb_info.path.find_last_of("/\\");
+  if (separator == string::npos) {
+    return pdb_info.path;
+  }
+  return pdb_info.path.substr(separator + 1);
+}
+
+// Returns the GUID of pdb_info in hexadecimal without dashes, with the
+// digits in upper case if upper_case is true. The first three groups of
+// a GUID are stored little-endian.
+string FormatGuid(const CodeViewPdbInfo &pdb_info, bool upper_case) {
+  static const int kByteOrder[] = {3, 2, 1, 0, 5, 4, 7, 6,
+                                   8, 9, 10, 11, 12, 13, 14, 15};
+  const char *digits = upper_case ? "0123456789ABCDEF" : "0123456789abcdef";
+  string result;
+  result.reserve(32);
+  for (int index : kByteOrder) {
+    uint8_t byte = pdb_info.guid[index];
+    result.push_back(digits[byte >> 4]);
+    result.push_back(digits[byte & 0xF]);
+  }
+  return result;
+}
+
+}  // namespace
+
+SymbolStorePdbProvider::SymbolStorePdbProvider(const string &directory,
+                                               const string &server_url)
+    : directory_(directory), server_url_(server_url) {
+  while (!server_url_.empty() && server_url_.back() == '/') {
+    server_url_.pop_back();
+  }
+}
+
+bool SymbolStorePdbProvider::FindPdb(const CodeViewPdbInfo &pdb_info,
+                                     string *pdb_path) const {
+  string key = GetKey(pdb_info);
+  if (key.empty()) {
+    return false;
+  }
+
+  string file = JoinPath(directory_, key);
+  if (FileExists(file)) {
+    *pdb_path = file;
+    return true;
+  }
+
+  // Symbol stores populated by symstore keep the case of the file name
+  // and print the GUID in upper case.
+  string file_name = GetPdbFileName(pdb_info);
+  string age_suffix = kPortablePdbAgeSuffix;
+  for (char &c : age_suffix) {
+    c = std::toupper(static_cast<unsigned char>(c));
+  }
+  file = JoinPath(directory_, file_name + "/" + FormatGuid(pdb_info, true) +
+                                  age_suffix + "/" + file_name);
+  if (FileExists(file)) {
+    *pdb_path = file;
+    return true;
+  }
+  return false;
+}
+
+bool SymbolStorePdbProvider::FetchPdb(const CodeViewPdbInfo &pdb_info) {
+  string key = GetKey(pdb_info);
+  string pdb_path;
+  if (key.empty() || FindPdb(pdb_info, &pdb_path)) {
+    return !key.empty();
+  }
+
+  if (server_url_.empty()) {
+    return false;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    download_cv_.wait(lock, [this, &key]() {
+      return downloading_keys_.find(key) == downloading_keys_.end();
+    });
+    if (failed_keys_.find(key) != failed_keys_.end()) {
+      return false;
+    }
+
+    // Another fetch downloaded it meanwhile.
+    if (FindPdb(pdb_info, &pdb_path)) {
+      return true;
+    }
+    downloading_keys_.insert(key);
+  }
+
+  DebuggerMetrics &metrics = DebuggerMetrics::Global();
+  bool downloaded;
+  {
+    ScopedLatencyTimer fetch_timer(&metrics.pdb_fetch_time_us);
+    string file = JoinPath(directory_, key);
+    downloaded = CreateParentDirectories(file) &&
+                 Download(server_url_ + "/" + key, file);
+  }
+  if (downloaded) {
+    metrics.pdbs_fetched.Increment();
+  } else {
+    cerr << "Failed to download PDB " << key << " from " << server_url_
+         << std::endl;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    downloading_keys_.erase(key);
+    if (!downloaded) {
+      failed_keys_.insert(key);
+    }
+  }
+  download_cv_.notify_all();
+  return downloaded;
+}
+
+string SymbolStorePdbProvider::GetKey(const CodeViewPdbInfo &pdb_info) {
+  string file_name = GetPdbFileName(pdb_info);
+  if (file_name.empty()) {
+    return string();
+  }
+
+  for (char &c : file_name) {
+    c = std::tolower(static_cast<unsigned char>(c));
+  }
+  return file_name + "/" + FormatGuid(pdb_info, false) +
+         kPortablePdbAgeSuffix + "/" + file_name;
+}
+
+bool SymbolStorePdbProvider::ParseHttpUrl(const string &url, string *host,
+                                          string *port, string *path) {
+  if (url.compare(0, kHttpScheme.size(), kHttpScheme) != 0) {
+    return false;
+  }
+
+  size_t authority_start = kHttpScheme.size();
+  size_t path_start = url.find('/', authority_start);
+  string authority =
+      path_start == string::npos
+          ? url.substr(authority_start)
+          : url.substr(authority_start, path_start - authority_start);
+  *path = path_start == string::npos ? "/" : url.substr(path_start);
+
+  size_t colon = authority.rfind(':');
+  if (colon != string::npos && authority.find(']', colon) == string::npos) {
+    *host = authority.substr(0, colon);
+    *port = authority.substr(colon + 1);
+  } else {
+    *host = authority;
+    *port = "80";
+  }
+
+  // IPv6 addresses are in brackets.
+  if (host->size() >= 2 && host->front() == '[' && host->back() == ']') {
+    *host = host->substr(1, host->size() - 2);
+  }
+  return !host->empty() && !port->empty();
+}
+
+bool SymbolStorePdbProvider::Download(const string &url, const string &file) {
+#ifdef PLATFORM_UNIX
+  string current_url = url;
+  for (int redirect = 0; redirect <= kMaxRedirects; ++redirect) {
+    string host;
+    string port;
+    string path;
+    if (!ParseHttpUrl(current_url, &host, &port, &path)) {
+      cerr << "Only http:// symbol server URLs are supported: "
+           << current_url << std::endl;
+      return false;
+    }
+
+    ScopedSocket connection(Connect(host, port));
+    if (connection.Get() < 0) {
+      return false;
+    }
+
+    // HTTP/1.0 responses are never chunked and end when the server
+    // closes the connection.
+    string request = "GET " + path + " HTTP/1.0\r\nHost: " + host +
+                     "\r\nAccept: */*\r\nConnection: close\r\n\r\n";
+    if (!SendAll(connection.Get(), request)) {
+      cerr << "Failed to send request to symbol server " << host
+           << std::endl;
+      return false;
+    }
+
+    // Reads the status line and the headers. The bytes after them are
+    // the beginning of the body.
+    string response;
+    size_t headers_end = string::npos;
+    char buffer[16 * 1024];
+    while (headers_end == string::npos) {
+      ssize_t received = recv(connection.Get(), buffer, sizeof(buffer), 0);
+      if (received <= 0 || response.size() > kMaxResponseHeaderSize) {
+        cerr << "Invalid response from symbol server " << host << std::endl;
+        return false;
+      }
+      response.append(buffer, received);
+      headers_end = response.find("\r\n\r\n");
+    }
+
+    string headers = response.substr(0, headers_end);
+    int status = 0;
+    size_t status_start = headers.find(' ');
+    if (status_start != string::npos) {
+      status = atoi(headers.c_str() + status_start + 1);
+    }
+
+    if (status == 301 || status == 302 || status == 303 || status == 307 ||
+        status == 308) {
+      string location = GetHeader(headers, "Location");
+      if (location.empty()) {
+        return false;
+      }
+      if (location[0] == '/') {
+        location = kHttpScheme + host + ":" + port + location;
+      }
+      current_url = location;
+      continue;
+    }
+
+    if (status != 200) {
+      cerr << "Symbol server " << host << " returned " << status << " for "
+           << path << std::endl;
+      return false;
+    }
+
+    // The body is written to a temporary file that is renamed once it is
+    // complete, so FindPdb never returns a partial PDB.
+    string temporary_file = file + ".download";
+    size_t body_size = 0;
+    {
+      std::ofstream output(temporary_file,
+                           std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!output) {
+        cerr << "Cannot create " << temporary_file << std::endl;
+        return false;
+      }
+
+      output.write(response.data() + headers_end + 4,
+                   response.size() - headers_end - 4);
+      body_size = response.size() - headers_end - 4;
+      ssize_t received;
+      while ((received = recv(connection.Get(), buffer, sizeof(buffer), 0)) >
+             0) {
+        output.write(buffer, received);
+        body_size += received;
+      }
+
+      if (received < 0 || !output.good()) {
+        cerr << "Failed to download " << path << std::endl;
+        output.close();
+        std::remove(temporary_file.c_str());
+        return false;
+      }
+    }
+
+    string content_length = GetHeader(headers, "Content-Length");
+    if (!content_length.empty() &&
+        strtoull(content_length.c_str(), nullptr, 10) != body_size) {
+      cerr << "Incomplete download of " << path << std::endl;
+      std::remove(temporary_file.c_str());
+      return false;
+    }
+
+    if (std::rename(temporary_file.c_str(), file.c_str()) != 0) {
+      std::remove(temporary_file.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  cerr << "Too many redirects for " << url << std::endl;
+  return false;
+#else
+  return false;
+#endif
+}
+
+bool SymbolStorePdbProvider::CreateParentDirectories(const string &file) {
+#ifdef PLATFORM_UNIX
+  size_t separator = file.find('/', 1);
+  while (separator != string::npos) {
+    string directory = file.substr(0, separator);
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+      cerr << "Cannot create directory " << directory << std::endl;
+      return false;
+    }
+    separator = file.find('/', separator + 1);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace google_cloud_debugger_portable_pdb
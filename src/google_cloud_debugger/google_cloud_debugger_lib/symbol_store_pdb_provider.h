@@ -0,0 +1,90 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SYMBOL_STORE_PDB_PROVIDER_H_
+#define SYMBOL_STORE_PDB_PROVIDER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "i_pdb_provider.h"
+
+namespace google_cloud_debugger_portable_pdb {
+
+// Provides PDBs from a symbol store directory, which has the layout of the
+// Simple Symbol Query Protocol (SSQP): the PDB with key
+// <name>/<guid>ffffffff/<name> (see GetKey) is the file with that path in
+// the directory. If a symbol server is set, the PDBs that are not in the
+// directory are downloaded from <server url>/<key> into it.
+//
+// Downloads use plain HTTP over sockets, which is only implemented on
+// unix. On other platforms FetchPdb only finds the PDBs that already are
+// in the directory.
+class SymbolStorePdbProvider : public IPdbProvider {
+ public:
+  // Creates a provider for the symbol store directory. server_url is an
+  // http:// URL, or empty if PDBs are not downloaded.
+  SymbolStorePdbProvider(const std::string &directory,
+                         const std::string &server_url);
+
+  // IPdbProvider interface.
+  bool FindPdb(const CodeViewPdbInfo &pdb_info,
+               std::string *pdb_path) const override;
+
+  // Downloads the PDB if it is not in the directory. Concurrent fetches
+  // of the same PDB download it once, and a PDB that failed to download
+  // is not downloaded again.
+  bool FetchPdb(const CodeViewPdbInfo &pdb_info) override;
+
+  // Returns the SSQP key of the Portable PDB described by pdb_info, or an
+  // empty string if its path has no file name. The GUID is printed in
+  // lower-case hexadecimal without dashes, followed by ffffffff instead
+  // of the age.
+  static std::string GetKey(const CodeViewPdbInfo &pdb_info);
+
+  // Splits url, which has to be an http:// URL, into its host, port
+  // ("80" if there is none) and path ("/" if there is none).
+  static bool ParseHttpUrl(const std::string &url, std::string *host,
+                           std::string *port, std::string *path);
+
+ private:
+  // Downloads url into file. Follows redirects to http:// URLs.
+  static bool Download(const std::string &url, const std::string &file);
+
+  // Creates the directories of file that do not exist.
+  static bool CreateParentDirectories(const std::string &file);
+
+  // The symbol store directory.
+  std::string directory_;
+
+  // URL of the symbol server, without a trailing '/'. Empty if PDBs are
+  // not downloaded.
+  std::string server_url_;
+
+  // Keys of the PDBs being downloaded and of the ones that failed to.
+  std::unordered_set<std::string> downloading_keys_;
+  std::unordered_set<std::string> failed_keys_;
+
+  // Protects downloading_keys_ and failed_keys_.
+  std::mutex mutex_;
+
+  // Signaled when a download finishes.
+  std::condition_variable download_cv_;
+};
+
+}  // namespace google_cloud_debugger_portable_pdb
+
+#endif  // SYMBOL_STORE_PDB_PROVIDER_H_
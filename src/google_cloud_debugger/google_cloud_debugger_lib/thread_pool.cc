@@ -0,0 +1,157 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#include "cpu_sampler.h"
+#include "thread_scheduling.h"
+
+namespace google_cloud_debugger {
+
+ThreadPool::ThreadPool(std::size_t num_threads, const char *thread_role,
+                       std::chrono::milliseconds idle_timeout)
+    : num_threads_(num_threads == 0 ? 1 : num_threads),
+      thread_role_(thread_role),
+      idle_timeout_(idle_timeout) {}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    std::queue<std::function<void()>>().swap(tasks_);
+  }
+  tasks_cv_.notify_all();
+
+  for (auto &&thread : threads_) {
+    thread.join();
+  }
+}
+
+bool ThreadPool::Schedule(std::function<void()> task) {
+  return ScheduleTask(std::move(task), true);
+}
+
+bool ThreadPool::ScheduleWithoutWaiting(std::function<void()> task) {
+  return ScheduleTask(std::move(task), false);
+}
+
+std::size_t ThreadPool::GetThreadsCreated() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_created_;
+}
+
+std::size_t ThreadPool::GetThreadCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_.size() - exited_threads_.size();
+}
+
+bool ThreadPool::ScheduleTask(std::function<void()> task, bool wait) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return false;
+    }
+
+    JoinExitedThreads();
+    if (threads_.empty()) {
+      threads_.reserve(num_threads_);
+      for (std::size_t i = 0; i < num_threads_; ++i) {
+        StartThread();
+      }
+    }
+
+    // Every queued task takes one of the idle threads.
+    if (!wait && idle_threads_ <= tasks_.size()) {
+      StartThread();
+    }
+
+    tasks_.push(std::move(task));
+  }
+
+  tasks_cv_.notify_one();
+  return true;
+}
+
+void ThreadPool::StartThread() {
+  // The thread counts as idle from the start so that tasks scheduled
+  // before it runs do not start more threads.
+  ++idle_threads_;
+  ++threads_created_;
+  threads_.emplace_back(&ThreadPool::RunTasks, this);
+}
+
+bool ThreadPool::HasExtraThreads() {
+  return idle_timeout_.count() > 0 &&
+         threads_.size() - exited_threads_.size() > num_threads_;
+}
+
+void ThreadPool::JoinExitedThreads() {
+  if (exited_threads_.empty()) {
+    return;
+  }
+
+  // The exited threads do not need mutex_ anymore, so they can be joined
+  // while it is held.
+  for (auto thread = threads_.begin(); thread != threads_.end();) {
+    auto exited = std::find(exited_threads_.begin(), exited_threads_.end(),
+                            thread->get_id());
+    if (exited == exited_threads_.end()) {
+      ++thread;
+      continue;
+    }
+    thread->join();
+    thread = threads_.erase(thread);
+    exited_threads_.erase(exited);
+  }
+}
+
+void ThreadPool::RunTasks() {
+  CpuSampler::RegisterThread(thread_role_);
+  ThreadScheduling::Global().ApplyToBackgroundThread();
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stopping_ && tasks_.empty()) {
+        if (!HasExtraThreads()) {
+          tasks_cv_.wait(lock);
+        } else if (tasks_cv_.wait_for(lock, idle_timeout_) ==
+                       std::cv_status::timeout &&
+                   tasks_.empty() && HasExtraThreads()) {
+          // The thread is joined by the next call to Schedule, or by the
+          // destructor.
+          --idle_threads_;
+          exited_threads_.push_back(std::this_thread::get_id());
+          return;
+        }
+      }
+      if (stopping_) {
+        return;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop();
+      --idle_threads_;
+    }
+
+    task();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++idle_threads_;
+  }
+}
+
+}  //  namespace google_cloud_debugger
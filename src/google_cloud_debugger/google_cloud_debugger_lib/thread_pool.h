@@ -0,0 +1,126 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace google_cloud_debugger {
+
+// A fixed number of worker threads that run scheduled tasks in the order
+// they are scheduled, plus the threads ScheduleWithoutWaiting adds. The
+// threads are started by the first call to Schedule. If the pool has an
+// idle timeout, the threads beyond the fixed number exit once they have
+// been idle for that long. Tasks that have not started when the pool is
+// destroyed are dropped; the destructor waits for the running ones to
+// finish.
+class ThreadPool {
+ public:
+  // Creates a pool of num_threads threads (at least 1). The threads
+  // register with CpuSampler under thread_role, which has to be a string
+  // literal. The threads ScheduleWithoutWaiting adds exit after
+  // idle_timeout without tasks, or stay if it is zero.
+  explicit ThreadPool(
+      std::size_t num_threads, const char *thread_role = "thread_pool",
+      std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0));
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Drops the pending tasks and joins the worker threads.
+  ~ThreadPool();
+
+  // Schedules task to run on one of the worker threads.
+  // Returns false if the task cannot be scheduled.
+  bool Schedule(std::function<void()> task);
+
+  // Schedules task like Schedule, but starts another worker thread if no
+  // thread is idle, so that task never waits for other tasks. The thread
+  // stays in the pool afterwards, until the idle timeout. Used for tasks
+  // that block until work outside of the pool is done, which could
+  // otherwise deadlock.
+  bool ScheduleWithoutWaiting(std::function<void()> task);
+
+  // Returns the number of worker threads started so far.
+  std::size_t GetThreadsCreated();
+
+  // Returns the number of worker threads that have not exited.
+  std::size_t GetThreadCount();
+
+ private:
+  // Loop of a worker thread: runs tasks until the pool is destroyed.
+  void RunTasks();
+
+  // Queues task and starts the threads it needs. If wait is false, a
+  // thread is started unless an idle thread is left for task.
+  bool ScheduleTask(std::function<void()> task, bool wait);
+
+  // Starts a worker thread. Must be called with mutex_ held.
+  void StartThread();
+
+  // Returns true if an idle thread would exit at the idle timeout because
+  // the pool has more than num_threads_ threads. Must be called with
+  // mutex_ held.
+  bool HasExtraThreads();
+
+  // Joins the threads that exited at the idle timeout and removes them
+  // from threads_. Must be called with mutex_ held.
+  void JoinExitedThreads();
+
+  // Number of threads the pool starts.
+  std::size_t num_threads_;
+
+  // Role of the threads of the pool in CpuSampler.
+  const char *thread_role_;
+
+  // Time after which an idle thread beyond num_threads_ exits, or zero if
+  // the threads never exit.
+  std::chrono::milliseconds idle_timeout_;
+
+  // The worker threads, including the exited ones not joined yet.
+  std::vector<std::thread> threads_;
+
+  // IDs of the threads in threads_ that exited at the idle timeout.
+  std::vector<std::thread::id> exited_threads_;
+
+  // Number of worker threads started so far.
+  std::size_t threads_created_ = 0;
+
+  // Tasks waiting for a worker thread.
+  std::queue<std::function<void()>> tasks_;
+
+  // Number of threads that are not running a task.
+  std::size_t idle_threads_ = 0;
+
+  // True when the pool is being destroyed.
+  bool stopping_ = false;
+
+  // Protects threads_, exited_threads_, threads_created_, tasks_,
+  // idle_threads_ and stopping_.
+  std::mutex mutex_;
+
+  // Signaled when a task is scheduled or the pool is being destroyed.
+  std::condition_variable tasks_cv_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  THREAD_POOL_H_
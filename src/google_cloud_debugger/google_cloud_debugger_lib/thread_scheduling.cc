@@ -0,0 +1,105 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread_scheduling.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "constants.h"
+
+namespace google_cloud_debugger {
+
+ThreadScheduling &ThreadScheduling::Global() {
+  static ThreadScheduling scheduling;
+  return scheduling;
+}
+
+void ThreadScheduling::SetBackgroundCores(
+    const std::vector<std::uint32_t> &cores) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cores_ = cores;
+}
+
+void ThreadScheduling::SetBackgroundPriority(std::uint32_t priority) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  priority_ = std::min(priority, kMaxBackgroundThreadPriority);
+}
+
+void ThreadScheduling::ApplyToBackgroundThread() {
+  std::vector<std::uint32_t> cores;
+  std::uint32_t priority;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cores = cores_;
+    priority = priority_;
+  }
+
+#ifdef _WIN32
+  if (!cores.empty()) {
+    DWORD_PTR mask = 0;
+    for (std::uint32_t core : cores) {
+      if (core < sizeof(mask) * 8) {
+        mask |= static_cast<DWORD_PTR>(1) << core;
+      }
+    }
+    if (mask != 0) {
+      SetThreadAffinityMask(GetCurrentThread(), mask);
+    }
+  }
+
+  if (priority >= 10) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+  } else if (priority > 0) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+  }
+#elif defined(__linux__)
+  if (!cores.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (std::uint32_t core : cores) {
+      if (core < CPU_SETSIZE) {
+        CPU_SET(core, &cpu_set);
+      }
+    }
+    if (CPU_COUNT(&cpu_set) != 0) {
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+  }
+
+  // On Linux the nice value belongs to the thread, not the process.
+  if (priority > 0) {
+    pid_t thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+    errno = 0;
+    int nice_value = getpriority(PRIO_PROCESS, thread_id);
+    if (errno == 0) {
+      setpriority(PRIO_PROCESS, thread_id,
+                  std::min<int>(nice_value + static_cast<int>(priority),
+                                kMaxBackgroundThreadPriority));
+    }
+  }
+#endif
+}
+
+}  //  namespace google_cloud_debugger
@@ -0,0 +1,73 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THREAD_SCHEDULING_H_
+#define THREAD_SCHEDULING_H_
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace google_cloud_debugger {
+
+// Where and at which priority the background threads of the debugger
+// run: the threads of the PDB parsing and symbol fetch pools, the
+// breakpoint writer, activation queue, metrics and CPU sampler threads.
+// They can be pinned to a set of cores and given a lower priority so
+// that they do not compete with the threads of the application.
+//
+// The debugger callback thread, which processes the threads stopped at
+// breakpoints, is never changed so that the application threads it
+// stopped are resumed as soon as possible.
+//
+// By default background threads run at normal priority on any core.
+class ThreadScheduling {
+ public:
+  ThreadScheduling() = default;
+  ThreadScheduling(const ThreadScheduling &) = delete;
+  ThreadScheduling &operator=(const ThreadScheduling &) = delete;
+
+  // Returns the scheduling shared by every background thread.
+  static ThreadScheduling &Global();
+
+  // Sets the cores background threads are pinned to, or none to let them
+  // run on any core. Has to be called before the threads are started.
+  void SetBackgroundCores(const std::vector<std::uint32_t> &cores);
+
+  // Sets how much lower than normal the priority of background threads
+  // is, from 0 (normal) to kMaxBackgroundThreadPriority. On Linux this is
+  // added to the nice value of the threads. On Windows, 1 to 9 is below
+  // normal and 10 and up is the lowest priority. Has to be called before
+  // the threads are started.
+  void SetBackgroundPriority(std::uint32_t priority);
+
+  // Pins the calling thread to the background cores and lowers its
+  // priority. Called by background threads when they start. Failures are
+  // ignored since the thread still works, only scheduled differently.
+  void ApplyToBackgroundThread();
+
+ private:
+  // The cores background threads are pinned to.
+  std::vector<std::uint32_t> cores_;
+
+  // How much lower than normal the priority of background threads is.
+  std::uint32_t priority_ = 0;
+
+  // Protects cores_ and priority_.
+  std::mutex mutex_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  THREAD_SCHEDULING_H_
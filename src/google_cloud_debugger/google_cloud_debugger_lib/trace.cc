@@ -0,0 +1,180 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "trace.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "constants.h"
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// A span recorded by TraceLog::Record.
+struct TraceEvent {
+  const char *name;
+
+  // Start of the span since GetTraceEpoch and its length, in microseconds.
+  std::int64_t start_us;
+  std::int64_t duration_us;
+};
+
+// The spans of one thread.
+struct ThreadTraceBuffer {
+  // Identifies the thread in the trace.
+  std::uint32_t thread_index = 0;
+
+  // The last kTraceEventsPerThread spans of the thread. Once it is full,
+  // next is the oldest span, which the next span overwrites.
+  std::vector<TraceEvent> events;
+  std::size_t next = 0;
+
+  // Only contended while the trace is written.
+  std::mutex mutex;
+};
+
+// The buffers of all the threads that recorded spans. Buffers are kept
+// after their thread exits so that its spans are still written, and are
+// never freed so that threads can record spans while the process exits.
+struct TraceRegistry {
+  std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+  std::mutex mutex;
+};
+
+TraceRegistry *GetTraceRegistry() {
+  static TraceRegistry *registry = new TraceRegistry();
+  return registry;
+}
+
+// Spans are written relative to the first time this is called.
+TraceLog::Clock::time_point GetTraceEpoch() {
+  static TraceLog::Clock::time_point epoch = TraceLog::Clock::now();
+  return epoch;
+}
+
+// The buffer of the calling thread, created the first time it records
+// a span.
+thread_local ThreadTraceBuffer *thread_buffer = nullptr;
+
+ThreadTraceBuffer *GetThreadBuffer() {
+  if (thread_buffer) {
+    return thread_buffer;
+  }
+
+  std::shared_ptr<ThreadTraceBuffer> buffer(new (std::nothrow)
+                                                ThreadTraceBuffer());
+  if (!buffer) {
+    return nullptr;
+  }
+
+  TraceRegistry *registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  buffer->thread_index = static_cast<std::uint32_t>(registry->buffers.size());
+  registry->buffers.push_back(buffer);
+  thread_buffer = buffer.get();
+  return thread_buffer;
+}
+
+// Writes a span as a complete event of the Chrome trace event format.
+void WriteTraceEvent(const TraceEvent &event, std::uint32_t thread_index,
+                     bool first, std::ostream *out) {
+  if (!first) {
+    *out << ",";
+  }
+  *out << "\n{\"name\":\"" << event.name
+       << "\",\"cat\":\"debugger\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+       << thread_index << ",\"ts\":" << event.start_us
+       << ",\"dur\":" << event.duration_us << "}";
+}
+
+}  // namespace
+
+void TraceLog::Record(const char *name, Clock::time_point start,
+                      Clock::time_point end) {
+  Clock::time_point epoch = GetTraceEpoch();
+  ThreadTraceBuffer *buffer = GetThreadBuffer();
+  if (!buffer) {
+    return;
+  }
+
+  TraceEvent event;
+  event.name = name;
+  event.start_us = duration_cast<microseconds>(start - epoch).count();
+  event.duration_us = duration_cast<microseconds>(end - start).count();
+
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  if (buffer->events.size() < kTraceEventsPerThread) {
+    buffer->events.push_back(event);
+    return;
+  }
+
+  buffer->events[buffer->next] = event;
+  buffer->next = (buffer->next + 1) % kTraceEventsPerThread;
+}
+
+void TraceLog::WriteChromeTrace(std::ostream *out) {
+  *out << "{\"traceEvents\":[";
+  bool first = true;
+  TraceRegistry *registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> registry_lock(registry->mutex);
+  for (const auto &buffer : registry->buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    const std::vector<TraceEvent> &events = buffer->events;
+
+    // Writes the spans of the thread from the oldest one.
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      const TraceEvent &event = events[(buffer->next + i) % events.size()];
+      WriteTraceEvent(event, buffer->thread_index, first, out);
+      first = false;
+    }
+  }
+  *out << "\n]}\n";
+}
+
+HRESULT TraceLog::WriteChromeTrace(const std::string &path) {
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (!out) {
+    std::cerr << "Failed to open trace file " << path << std::endl;
+    return E_FAIL;
+  }
+
+  WriteChromeTrace(&out);
+  out.close();
+  if (!out) {
+    std::cerr << "Failed to write trace file " << path << std::endl;
+    return E_FAIL;
+  }
+  return S_OK;
+}
+
+void TraceLog::Clear() {
+  TraceRegistry *registry = GetTraceRegistry();
+  std::lock_guard<std::mutex> registry_lock(registry->mutex);
+  for (const auto &buffer : registry->buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->next = 0;
+  }
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,93 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "cor.h"
+#include "cpu_sampler.h"
+
+namespace google_cloud_debugger {
+
+// Spans of time spent in a scope, recorded into a ring buffer of the
+// thread they are on. Each thread keeps its last kTraceEventsPerThread
+// spans, which WriteChromeTrace writes as a trace that chrome://tracing
+// and similar tools can load.
+class TraceLog {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Records a span named name on the calling thread. name has to be
+  // a string literal that needs no escaping in JSON.
+  static void Record(const char *name, Clock::time_point start,
+                     Clock::time_point end);
+
+  // Writes the spans of all the threads to out in the Chrome trace
+  // event format.
+  static void WriteChromeTrace(std::ostream *out);
+
+  // Writes the spans of all the threads to the file at path in the
+  // Chrome trace event format.
+  static HRESULT WriteChromeTrace(const std::string &path);
+
+  // Removes the spans of all the threads.
+  static void Clear();
+};
+
+// Records the time between its creation and its destruction as a span
+// of the TraceLog. Use it through DEBUGGER_TRACE_SPAN.
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char *name)
+      : name_(name), start_(TraceLog::Clock::now()) {}
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+  ~TraceSpan() { TraceLog::Record(name_, start_, TraceLog::Clock::now()); }
+
+ private:
+  const char *name_;
+  TraceLog::Clock::time_point start_;
+};
+
+}  // namespace google_cloud_debugger
+
+// Traces the rest of the enclosing scope as a span named name, which is
+// also the phase CpuSampler attributes the CPU time of the thread to.
+// The span is compiled out unless GOOGLE_CLOUD_DEBUGGER_TRACING is
+// defined, which the makefiles do when built with TRACING=true, but the
+// phase is always set.
+#define DEBUGGER_TRACE_SPAN_CONCAT(prefix, line) prefix##line
+#define DEBUGGER_TRACE_SPAN_VARIABLE(prefix, line) \
+  DEBUGGER_TRACE_SPAN_CONCAT(prefix, line)
+#ifdef GOOGLE_CLOUD_DEBUGGER_TRACING
+#define DEBUGGER_TRACE_SPAN(name)                                  \
+  ::google_cloud_debugger::CpuPhase DEBUGGER_TRACE_SPAN_VARIABLE( \
+      cpu_phase_, __LINE__)(name);                                \
+  ::google_cloud_debugger::TraceSpan DEBUGGER_TRACE_SPAN_VARIABLE( \
+      trace_span_, __LINE__)(name)
+#else
+#define DEBUGGER_TRACE_SPAN(name)                                  \
+  ::google_cloud_debugger::CpuPhase DEBUGGER_TRACE_SPAN_VARIABLE( \
+      cpu_phase_, __LINE__)(name)
+#endif
+
+#endif  //  TRACE_H_
@@ -44,4 +44,24 @@ int TypeSignature::compare(const TypeSignature &other) const {
   return 0;
 }
 
+std::string TypeSignature::GetKey() const {
+  std::string key =
+      std::to_string(static_cast<int>(cor_type)) + ":" + type_name;
+  if (is_array) {
+    key += "[" + std::to_string(array_rank) + "]";
+  }
+
+  if (!generic_types.empty()) {
+    key += "<";
+    for (size_t i = 0; i < generic_types.size(); ++i) {
+      if (i != 0) {
+        key += ",";
+      }
+      key += generic_types[i].GetKey();
+    }
+    key += ">";
+  }
+  return key;
+}
+
 }  // namespace google_cloud_debugger
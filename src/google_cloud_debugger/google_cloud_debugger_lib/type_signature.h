@@ -61,6 +61,10 @@ struct TypeSignature {
   // and all TypeSignatures in the generic_types vector
   // are equal.
   int compare(const TypeSignature &other) const;
+
+  // Returns a string that identifies this TypeSignature, which can be
+  // used as the key of a cache. Equal TypeSignatures have the same key.
+  std::string GetKey() const;
 };
   
 }  // namespace google_cloud_debugger
@@ -0,0 +1,119 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "variable_encoder.h"
+
+#include <google/protobuf/io/coded_stream.h>
+
+using google::cloud::diagnostics::debug::Status;
+using google::cloud::diagnostics::debug::Variable;
+using google::protobuf::io::CodedOutputStream;
+using std::string;
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Wire types of the fields of variables.
+const std::uint32_t kVarintWireType = 0;
+const std::uint32_t kLengthDelimitedWireType = 2;
+
+}  // namespace
+
+void VariableEncoder::AppendVariable(int field_number,
+                                     const Variable &variable) {
+  size_t position = BeginMessage(field_number);
+  AppendString(Variable::kNameFieldNumber, variable.name());
+  AppendString(Variable::kTypeFieldNumber, variable.type());
+  AppendString(Variable::kValueFieldNumber, variable.value());
+  for (const Variable &member : variable.members()) {
+    AppendVariable(Variable::kMembersFieldNumber, member);
+  }
+
+  if (variable.has_status()) {
+    // The status is small and its length is known up front, so its
+    // length is not padded.
+    const Status &status = variable.status();
+    size_t status_size = status.iserror() ? 2 : 0;
+    if (!status.message().empty()) {
+      status_size += 1 +
+                     CodedOutputStream::VarintSize32(
+                         static_cast<uint32_t>(status.message().size())) +
+                     status.message().size();
+    }
+    AppendTag(Variable::kStatusFieldNumber, kLengthDelimitedWireType);
+    AppendVarint(status_size);
+    if (status.iserror()) {
+      AppendTag(Status::kIserrorFieldNumber, kVarintWireType);
+      AppendVarint(1);
+    }
+    AppendString(Status::kMessageFieldNumber, status.message());
+  }
+  EndMessage(position);
+}
+
+void VariableEncoder::AppendString(int field_number, const string &value) {
+  if (value.empty()) {
+    return;
+  }
+
+  AppendTag(field_number, kLengthDelimitedWireType);
+  AppendVarint(value.size());
+  buffer_->append(value);
+}
+
+size_t VariableEncoder::BeginMessage(int field_number) {
+  AppendTag(field_number, kLengthDelimitedWireType);
+  size_t position = buffer_->size();
+  buffer_->append(kLengthSize, '\0');
+  return position;
+}
+
+void VariableEncoder::EndMessage(size_t position) {
+  size_t length = buffer_->size() - position - kLengthSize;
+  size_t length_size = CodedOutputStream::VarintSize32(length);
+  if (length_size > kLengthSize) {
+    buffer_->insert(position, length_size - kLengthSize, '\0');
+  } else {
+    length_size = kLengthSize;
+  }
+
+  // Every byte but the last one of the padded varint has its
+  // continuation bit set, so the length takes exactly length_size bytes.
+  char *target = &(*buffer_)[position];
+  for (size_t i = 0; i < length_size; ++i) {
+    uint8_t byte = static_cast<uint8_t>(length & 0x7F);
+    length >>= 7;
+    if (i + 1 < length_size) {
+      byte |= 0x80;
+    }
+    target[i] = static_cast<char>(byte);
+  }
+}
+
+void VariableEncoder::AppendTag(int field_number, std::uint32_t wire_type) {
+  uint8_t tag[5];
+  uint8_t *end = CodedOutputStream::WriteTagToArray(
+      static_cast<uint32_t>(field_number) << 3 | wire_type, tag);
+  buffer_->append(reinterpret_cast<const char *>(tag), end - tag);
+}
+
+void VariableEncoder::AppendVarint(size_t value) {
+  uint8_t varint[5];
+  uint8_t *end = CodedOutputStream::WriteVarint32ToArray(
+      static_cast<uint32_t>(value), varint);
+  buffer_->append(reinterpret_cast<const char *>(varint), end - varint);
+}
+
+}  // namespace google_cloud_debugger
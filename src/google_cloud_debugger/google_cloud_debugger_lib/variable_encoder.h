@@ -0,0 +1,80 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VARIABLE_ENCODER_H_
+#define VARIABLE_ENCODER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "breakpoint.pb.h"
+
+namespace google_cloud_debugger {
+
+// Encodes variables straight into a buffer in the protobuf wire format,
+// in one pass, without computing the sizes of the messages first.
+//
+// The length of a nested message is only known once its fields are
+// written, so BeginMessage reserves kLengthSize bytes for it and
+// EndMessage fills them in with the length as a padded varint, which
+// parsers read like any other varint. Statuses, whose sizes are known up
+// front, are not padded. A variable then takes exactly the bytes
+// SnapshotSizeTracker counts for it, so GetSize is the exact size
+// of what was encoded and can be checked against the same limits.
+// Messages too long for kLengthSize bytes are moved to make room for a
+// longer length.
+//
+// Not thread-safe.
+class VariableEncoder {
+ public:
+  // Appends to buffer, which has to outlive the encoder.
+  explicit VariableEncoder(std::string *buffer) : buffer_(buffer) {}
+
+  // Appends variable, with its members and status, as the field
+  // field_number of the message being encoded.
+  void AppendVariable(
+      int field_number,
+      const google::cloud::diagnostics::debug::Variable &variable);
+
+  // Appends value as the string field field_number, unless it is empty.
+  void AppendString(int field_number, const std::string &value);
+
+  // Appends the tag of the message field field_number and reserves its
+  // length. Returns the position EndMessage takes once the fields of the
+  // message are appended.
+  size_t BeginMessage(int field_number);
+
+  // Fills in the length of the message BeginMessage started at position.
+  void EndMessage(size_t position);
+
+  // Returns the number of bytes in the buffer.
+  size_t GetSize() const { return buffer_->size(); }
+
+  // Number of bytes reserved for the length of a message, which holds
+  // lengths of up to 2 MB.
+  static const size_t kLengthSize = 3;
+
+ private:
+  // Appends the tag of field field_number with wire_type.
+  void AppendTag(int field_number, std::uint32_t wire_type);
+
+  // Appends value as a varint.
+  void AppendVarint(size_t value);
+
+  std::string *buffer_;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  VARIABLE_ENCODER_H_
@@ -0,0 +1,34 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VARIABLE_SLOT_H_
+#define VARIABLE_SLOT_H_
+
+#include <cstddef>
+
+namespace google_cloud_debugger {
+
+// Identifies a local variable by its IL slot or a method argument by its
+// index. The frames of a method at the same location have the same slots,
+// so a variable can be read from each of them without its name.
+struct VariableSlot {
+  enum class Kind { kNone, kLocalVariable, kMethodArgument };
+
+  Kind kind = Kind::kNone;
+  size_t index = 0;
+};
+
+}  //  namespace google_cloud_debugger
+
+#endif  //  VARIABLE_SLOT_H_
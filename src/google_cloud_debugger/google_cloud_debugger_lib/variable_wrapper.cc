@@ -14,15 +14,16 @@
 
 #include "variable_wrapper.h"
 
+#include <google/protobuf/io/coded_stream.h>
 #include <iostream>
-#include <queue>
 #include <vector>
 
+#include "error_messages.h"
 #include "string_stream_wrapper.h"
+#include "trace.h"
 
 using google::cloud::diagnostics::debug::Variable;
-using std::function;
-using std::queue;
+using google::protobuf::io::CodedOutputStream;
 using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
@@ -30,85 +31,262 @@ using std::vector;
 
 namespace google_cloud_debugger {
 
-HRESULT VariableWrapper::PerformBFS(queue<VariableWrapper>* bfs_queue,
-                                    const function<bool()> &terminate_condition,
+// Truncates the value of variable to max_length bytes, without splitting
+// a UTF-8 character, and marks it as truncated.
+static void TruncateValue(Variable *variable, std::uint32_t max_length) {
+  const string &value = variable->value();
+  if (max_length == 0 || value.size() <= max_length) {
+    return;
+  }
+
+  size_t length = max_length;
+  while (length > 0 && (value[length] & 0xC0) == 0x80) {
+    --length;
+  }
+  variable->set_value(value.substr(0, length) + "...");
+}
+
+size_t SnapshotSizeTracker::EmbeddedSize(size_t size) {
+  return 1 + CodedOutputStream::VarintSize32(size) + size;
+}
+
+size_t SnapshotSizeTracker::VariableFieldsSize(const Variable &variable) {
+  size_t size = 0;
+  for (const string *field :
+       {&variable.name(), &variable.type(), &variable.value()}) {
+    if (!field->empty()) {
+      size += EmbeddedSize(field->size());
+    }
+  }
+
+  if (variable.has_status()) {
+    size_t status_size = variable.status().iserror() ? 2 : 0;
+    if (!variable.status().message().empty()) {
+      status_size += EmbeddedSize(variable.status().message().size());
+    }
+    size += EmbeddedSize(status_size);
+  }
+
+  // Tag and length of the variable itself.
+  return 1 + kMaxLengthSize + size;
+}
+
+HRESULT VariableWrapper::PerformBFS(VariableQueue *bfs_queue,
+                                    const CaptureLimits &limits,
+                                    SnapshotSizeTracker *size_tracker,
                                     IEvalCoordinator *eval_coordinator) {
-  if (!bfs_queue) {
+  DEBUGGER_TRACE_SPAN("VariableWrapper::PerformBFS");
+  if (!bfs_queue || !size_tracker) {
     return E_INVALIDARG;
   }
 
-  HRESULT hr;
+  // The caller measured the variables in the queue while their lengths
+  // took 1 byte. Their members can make them up to kMaxLengthSize.
+  size_tracker->Add(bfs_queue->size() *
+                    (SnapshotSizeTracker::kMaxLengthSize - 1));
+
   // Until the queue is empty, we:
   //  1. Pop out an item X.
   //  2. If X is null, continue with the loop.
-  //  3. If the BFS level of X is kDefaultObjectEvalDepth,
+  //  3. If the BFS level of X is the max_depth of limits,
   // sets an error status on X saying that we cannot evaluate
   // its children and continue with the loop.
   //  4. Otherwise, try to get members (children) of X.
   //  5. If there are members, push them into the queue. We
   // also set the BFS level of the members to be the BFS
   // level of the node X + 1. If not, call PopulateValue on X.
+  vector<VariableWrapper> members;
+  Expansion expansion;
   while (!bfs_queue->empty()) {
-    if (terminate_condition()) {
+    if (size_tracker->Exceeded()) {
+      // Releases the objects of the variables that are not populated.
+      bfs_queue->clear();
       return S_OK;
     }
 
-    VariableWrapper current_variable = bfs_queue->front();
-    // Populates the type of the variable into the variable proto.
-    hr = current_variable.PopulateType();
-
-    if (FAILED(hr)) {
-      SetErrorStatusMessage(current_variable.variable_proto_,
-                            current_variable.variable_value_->GetErrorString());
-      bfs_queue->pop();
-      continue;
+    if (limits.DeadlineExceeded()) {
+      // The snapshot is written with what is captured so far, and the
+      // variables that are not populated say why.
+      while (!bfs_queue->empty()) {
+        Variable *variable_proto = bfs_queue->front().variable_proto_;
+        size_t size_before =
+            SnapshotSizeTracker::VariableFieldsSize(*variable_proto);
+        SetInfoStatusMessage(variable_proto, kCaptureDeadlineExceeded);
+        size_tracker->Add(
+            SnapshotSizeTracker::VariableFieldsSize(*variable_proto) -
+            size_before);
+        bfs_queue->pop();
+      }
+      return S_OK;
     }
 
-    if (current_variable.bfs_level_ >= kDefaultObjectEvalDepth) {
-      // We have reached a level that is more than the evaluation depth.
-      SetErrorStatusMessage(current_variable.variable_proto_,
-                            "Object evaluation limit reached");
-      bfs_queue->pop();
-      continue;
-    }
+    VariableWrapper current_variable = std::move(bfs_queue->front());
+    bfs_queue->pop();
 
-    // If variable is null, moves on.
-    if (current_variable.variable_value_->GetIsNull()) {
-      bfs_queue->pop();
-      continue;
+    // Only the fields populated now are new. The rest of the variable
+    // was counted when it was added to its parent.
+    const Variable &variable_proto = *current_variable.variable_proto_;
+    size_t size_before =
+        SnapshotSizeTracker::VariableFieldsSize(variable_proto);
+    current_variable.PopulateVariable(bfs_queue, &members, limits,
+                                      size_tracker, &expansion,
+                                      eval_coordinator);
+    members.clear();
+    size_t size_after = SnapshotSizeTracker::VariableFieldsSize(variable_proto);
+    if (size_after > size_before) {
+      size_tracker->Add(size_after - size_before);
     }
+  }
+
+  return S_OK;
+}
+
+void VariableWrapper::PopulateVariable(VariableQueue *bfs_queue,
+                                       vector<VariableWrapper> *members,
+                                       const CaptureLimits &bfs_limits,
+                                       SnapshotSizeTracker *size_tracker,
+                                       Expansion *expansion,
+                                       IEvalCoordinator *eval_coordinator) {
+  const CaptureLimits &limits = limits_ ? *limits_ : bfs_limits;
+  // The resolver sets the error status if it fails.
+  HRESULT hr = ResolveValue();
+  if (FAILED(hr)) {
+    return;
+  }
+
+  // Populates the type of the variable into the variable proto.
+  hr = PopulateType();
+  if (FAILED(hr)) {
+    SetErrorStatusMessage(variable_proto_, variable_value_->GetErrorString());
+    return;
+  }
+
+  if (type_only_) {
+    return;
+  }
+
+  if (capture_mask_ && capture_mask_->IsTarget()) {
+    // The target of a path is captured like a local variable whose
+    // evaluation depth is the depth of the path.
+    int depth = capture_mask_->GetDepth();
+    bfs_level_ = depth == 0 ? 1 : limits.max_depth - depth + 1;
+    capture_mask_ = nullptr;
+  }
+
+  if (!capture_mask_ && bfs_level_ >= limits.max_depth) {
+    // We have reached a level that is more than the evaluation depth.
+    SetErrorStatusMessage(variable_proto_, "Object evaluation limit reached");
+    return;
+  }
 
-    // Tries to see whether we can get any members (children) from
-    // this variable.
-    vector<VariableWrapper> variable_members;
-    hr = current_variable.PopulateMembers(&variable_members, eval_coordinator);
+  // If variable is null, moves on.
+  if (variable_value_->GetIsNull()) {
+    return;
+  }
+
+  // The members of an object or array that is too large are not
+  // captured, so that its size bounds the cost of the capture instead of
+  // its shape. The variables on the paths of a capture mask are always
+  // expanded.
+  ULONG32 object_size = variable_value_->GetObjectSize();
+  if (!capture_mask_ && limits.max_object_bytes != 0 &&
+      object_size > limits.max_object_bytes) {
+    SetInfoStatusMessage(variable_proto_,
+                         "Object of " + std::to_string(object_size) +
+                             " bytes is larger than the capture limit of " +
+                             std::to_string(limits.max_object_bytes) +
+                             " bytes");
+    return;
+  }
 
-    // If hr is S_FALSE then there are no members so we simply
-    // call PopulateValue.
-    if (hr == S_FALSE) {
-      hr = current_variable.PopulateValue();
+  // An object that was already expanded, like the parent its children
+  // point back to, refers to the variable it was expanded in. The
+  // variables on the paths of a capture mask are always expanded.
+  ICorDebugHandleValue *object_handle = variable_value_->GetObjectHandle();
+  if (object_handle && !capture_mask_) {
+    auto expanded_object = expansion->objects.find(object_handle);
+    if (expanded_object != expansion->objects.end()) {
+      variable_proto_->set_value("see " + *expanded_object->second.path);
+      return;
     }
-    // Otherwise, process and put the members in the queue.
-    else if (SUCCEEDED(hr)) {
-      for (auto &member_value : variable_members) {
-        member_value.bfs_level_ = current_variable.bfs_level_ + 1;
-        bfs_queue->push(member_value);
-      }
+  }
+
+  // Tries to see whether we can get any members (children) from
+  // this variable. The objects on the paths of a capture mask are not
+  // captured as their DebuggerDisplay string, which would hide the
+  // members on the paths.
+  if (capture_mask_ && limits.debugger_display) {
+    CaptureLimits path_limits = limits;
+    path_limits.debugger_display = false;
+    hr = PopulateMembers(members, path_limits, eval_coordinator);
+  } else {
+    hr = PopulateMembers(members, limits, eval_coordinator);
+  }
+
+  // The members need the path of the variable for their own paths.
+  // Objects without members, like strings, are captured every time.
+  const string *path = nullptr;
+  if (SUCCEEDED(hr) && hr != S_FALSE) {
+    expansion->paths.push_back(GetPath());
+    path = &expansion->paths.back();
+    if (object_handle && !capture_mask_) {
+      ExpandedObject &expanded_object = expansion->objects[object_handle];
+      expanded_object.object_handle = object_handle;
+      expanded_object.path = path;
     }
+  }
 
-    if (FAILED(hr)) {
-      SetErrorStatusMessage(current_variable.variable_proto_,
-                            current_variable.variable_value_->GetErrorString());
+  // If hr is S_FALSE then there are no members so we simply
+  // call PopulateValue.
+  if (hr == S_FALSE) {
+    hr = variable_value_->PopulateValueWithinLimits(variable_proto_, limits);
+    if (SUCCEEDED(hr)) {
+      TruncateValue(variable_proto_, limits.max_string_length);
+    }
+  }
+  // Otherwise, process and put the members in the queue.
+  else if (SUCCEEDED(hr)) {
+    for (auto &member_value : *members) {
+      member_value.bfs_level_ = bfs_level_ + 1;
+      member_value.parent_path_ = path;
+      member_value.limits_ = limits_;
+      if (capture_mask_) {
+        member_value.capture_mask_ =
+            capture_mask_->GetMember(member_value.variable_proto_->name());
+        member_value.type_only_ = !member_value.capture_mask_;
+      }
+      size_tracker->Add(SnapshotSizeTracker::VariableFieldsSize(
+          *member_value.variable_proto_));
+      bfs_queue->push(std::move(member_value));
     }
-    bfs_queue->pop();
   }
 
-  return S_OK;
+  if (FAILED(hr)) {
+    SetErrorStatusMessage(variable_proto_, variable_value_->GetErrorString());
+  }
 }
 
 // Populates variable proto variable_proto_ with
 // variable_value_ object.
+string VariableWrapper::GetPath() const {
+  const string &name = variable_proto_->name();
+  if (!parent_path_) {
+    return name;
+  }
+
+  // Elements are named after their index, like "[2]".
+  if (!name.empty() && name[0] == '[') {
+    return *parent_path_ + name;
+  }
+  return *parent_path_ + "." + name;
+}
+
 HRESULT VariableWrapper::PopulateValue() {
+  HRESULT hr = ResolveValue();
+  if (FAILED(hr)) {
+    return hr;
+  }
+
   if (!variable_proto_ || !variable_value_) {
     return E_INVALIDARG;
   }
@@ -118,6 +296,11 @@ HRESULT VariableWrapper::PopulateValue() {
 // Populates variable proto variable_proto_ with
 // type of variable_value_ object.
 HRESULT VariableWrapper::PopulateType() {
+  HRESULT hr = ResolveValue();
+  if (FAILED(hr)) {
+    return hr;
+  }
+
   if (!variable_proto_ || !variable_value_) {
     return E_INVALIDARG;
   }
@@ -127,13 +310,72 @@ HRESULT VariableWrapper::PopulateType() {
 // Calls PopulateMembers of variable_value_ object.
 // Pass in variable_proto_ as the parent proto.
 HRESULT VariableWrapper::PopulateMembers(std::vector<VariableWrapper> *members,
-  IEvalCoordinator *eval_coordinator) {
+  const CaptureLimits &limits, IEvalCoordinator *eval_coordinator) {
+  HRESULT hr = ResolveValue();
+  if (FAILED(hr)) {
+    return hr;
+  }
+
   if (!variable_proto_ || !variable_value_
     || !members || !eval_coordinator) {
     return E_INVALIDARG;
   }
   return variable_value_->PopulateMembers(variable_proto_,
-    members, eval_coordinator);
+    members, limits, eval_coordinator);
+}
+
+HRESULT VariableWrapper::ResolveValue() {
+  if (!value_resolver_) {
+    return S_OK;
+  }
+
+  // The value is resolved only once, even if resolving it fails.
+  ValueResolver value_resolver = std::move(value_resolver_);
+  value_resolver_ = nullptr;
+  return value_resolver(&variable_value_);
+}
+
+const std::size_t VariableQueue::kInitialCapacity;
+
+VariableQueue *VariableQueue::GetThreadQueue() {
+  static thread_local VariableQueue queue;
+  return &queue;
+}
+
+void VariableQueue::push(VariableWrapper variable) {
+  if (size_ == items_.size()) {
+    Grow();
+  }
+  items_[(head_ + size_) % items_.size()] = std::move(variable);
+  ++size_;
+}
+
+void VariableQueue::pop() {
+  // Releases the object of the variable.
+  items_[head_] = VariableWrapper(nullptr, nullptr);
+  head_ = (head_ + 1) % items_.size();
+  --size_;
+}
+
+void VariableQueue::clear() {
+  while (!empty()) {
+    pop();
+  }
+  head_ = 0;
+}
+
+void VariableQueue::Grow() {
+  vector<VariableWrapper> items;
+  std::size_t capacity = items_.empty() ? kInitialCapacity : 2 * items_.size();
+  items.reserve(capacity);
+  for (std::size_t i = 0; i < size_; ++i) {
+    items.push_back(std::move(items_[(head_ + i) % items_.size()]));
+  }
+  while (items.size() < capacity) {
+    items.push_back(VariableWrapper(nullptr, nullptr));
+  }
+  items_ = std::move(items);
+  head_ = 0;
 }
 
 }  //  namespace google_cloud_debugger
@@ -15,13 +15,17 @@
 #ifndef VARIABLE_WRAPPER_H_
 #define VARIABLE_WRAPPER_H_
 
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
-#include <queue>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "breakpoint.pb.h"
+#include "capture_limits.h"
+#include "ccomptr.h"
 #include "constants.h"
 #include "cor.h"
 #include "cordebug.h"
@@ -30,13 +34,57 @@
 namespace google_cloud_debugger {
 
 class IEvalCoordinator;
+class VariableQueue;
+
+// Tracks the encoded size of a message while PerformBFS populates the
+// variables in it, so that checking the size against a limit is O(1)
+// for every variable instead of a ByteSizeLong walk of the whole message.
+// The size tracked is an upper bound of the real size.
+class SnapshotSizeTracker {
+ public:
+  // Tracks a message that is size bytes now and can grow to max_size.
+  SnapshotSizeTracker(size_t size, size_t max_size)
+      : size_(size), max_size_(max_size) {}
+
+  // Returns true if the message is larger than max_size.
+  bool Exceeded() const { return size_ > max_size_; }
+
+  // Returns the size of the message.
+  size_t GetSize() const { return size_; }
+
+  // Adds bytes to the size of the message.
+  void Add(size_t bytes) { size_ += bytes; }
+
+  // Returns the size of a message field of size bytes: the message
+  // and the tag and length that precede it.
+  static size_t EmbeddedSize(size_t size);
+
+  // Returns the size of the fields of variable other than its members,
+  // including the tag and the length that embed it in its parent. The
+  // length is counted as if members made it as long as kMaxLengthSize.
+  static size_t VariableFieldsSize(
+      const google::cloud::diagnostics::debug::Variable &variable);
+
+  // Number of bytes the length of a variable takes at most. Messages
+  // built by the debugger are smaller than 2 MB, which takes 3 bytes.
+  static const size_t kMaxLengthSize = 3;
+
+ private:
+  size_t size_;
+  size_t max_size_;
+};
 
 // This wrapper class contains pointers to a variable proto and
 // its underlying object. It also contains the BFS level,
-// which is used by PopulateStackFrame to stop the BFS when
-// it reaches kDefaultObjectEvalDepth.
+// which is used by PerformBFS to stop the BFS when it reaches
+// the max_depth limit.
 class VariableWrapper {
 public:
+  // Function that produces the underlying object of a variable. It sets
+  // the error status of the variable proto if it fails.
+  typedef std::function<HRESULT(std::shared_ptr<DbgObject> *)>
+      ValueResolver;
+
   // Constructor that takes in variable proto, the underlying object
   // and the BFS level (default to 1).
   VariableWrapper(google::cloud::diagnostics::debug::Variable *variable_proto,
@@ -47,20 +95,35 @@ public:
 
   // This method is used to process all VariableWrapper in the
   // queue by populating their variable_proto_ with the underlying
-  // object variable_value_.
+  // object variable_value_ within limits. size_tracker starts with the
+  // size of the message the variables are in, including the variables in
+  // the queue, and is updated as the variables are populated.
   // Until the queue is empty, this method:
-  //  1. Checks if terminate_condition is true. If so, returns.
+  //  1. Checks if size_tracker is exceeded. If so, returns. If the
+  // deadline of limits passed, marks the variables left in the queue
+  // with kCaptureDeadlineExceeded and returns.
   //  2. Pops out an item X.
   //  3. If X is null, continues with the loop.
-  //  4. If the BFS level of X is kDefaultObjectEvalDepth,
+  //  4. If the BFS level of X is the max_depth of limits,
   // sets an error status on X saying that we cannot evaluate
   // its children and continues with the loop.
   //  5. Otherwise, tries to get members (children) of X.
   //  6. If there are members, pushes them into the queue. We
   // also set the BFS level of the members to be the BFS
-  // level of the node X + 1. If not, call PopulateValue on X.
-  static HRESULT PerformBFS(std::queue<VariableWrapper> *bfs_queue,
-                            const std::function<bool()> &terminate_condition,
+  // level of the node X + 1. If not, call PopulateValue on X
+  // and truncates the value to the max_string_length of limits.
+  // When the variables are on a capture mask, variables that are not on
+  // a path of the mask only get their types, and variables on the way to
+  // the target of a path are expanded regardless of their BFS level.
+  // An object that was already expanded is not expanded again; its
+  // value refers to the first variable that holds it instead.
+  // As the queue is first in, first out, the variables queued first and
+  // the shallow ones are captured ahead of the rest when size_tracker or
+  // the deadline of limits runs out.
+  // The queue is empty when this method returns.
+  static HRESULT PerformBFS(VariableQueue *bfs_queue,
+                            const CaptureLimits &limits,
+                            SnapshotSizeTracker *size_tracker,
                             IEvalCoordinator *eval_coordinator);
 
   // Populates variable proto variable_proto_ with
@@ -74,6 +137,7 @@ public:
   // Calls PopulateMembers of variable_value_ object.
   // Pass in variable_proto_ as the parent proto.
   HRESULT PopulateMembers(std::vector<VariableWrapper> *members,
+                          const CaptureLimits &limits,
                           IEvalCoordinator *eval_coordinator);
 
   // Returns the variable proto of this wrapper.
@@ -91,15 +155,151 @@ public:
     bfs_level_ = level;
   }
 
+  // Sets the node of the capture mask of the snapshot this variable is
+  // on, so that only the members on the paths of the mask are captured
+  // in full. See CaptureMask.
+  void SetCaptureMask(const CaptureMask *capture_mask) {
+    capture_mask_ = capture_mask;
+  }
+
+  // Makes PerformBFS capture only the type of this variable, because it
+  // is not on any path of the capture mask.
+  void SetTypeOnly() { type_only_ = true; }
+
+  // Makes PerformBFS capture this variable and its members within limits
+  // instead of the limits it is given, so that variables captured with
+  // different limits can share one BFS. limits has to outlive the BFS.
+  void SetLimits(const CaptureLimits *limits) { limits_ = limits; }
+
+  // Sets a function that produces the underlying object the first time
+  // the variable is populated, so that variables that are never
+  // populated cost nothing.
+  void SetValueResolver(ValueResolver value_resolver) {
+    value_resolver_ = std::move(value_resolver);
+  }
+
 private:
+  // An object PerformBFS expanded.
+  struct ExpandedObject {
+    // Keeps the handle that identifies the object alive, so that it is
+    // not mistaken for the handle of another object.
+    CComPtr<ICorDebugHandleValue> object_handle;
+
+    // Path of the first variable that holds the object.
+    const std::string *path = nullptr;
+  };
+
+  // What PerformBFS expanded so far.
+  struct Expansion {
+    // The objects expanded, by the handle that identifies them.
+    std::map<ICorDebugHandleValue *, ExpandedObject> objects;
+
+    // Paths of the variables expanded, like "this.items[2]". A deque,
+    // so that adding paths does not move the ones the members point to.
+    std::deque<std::string> paths;
+  };
+
+  // Populates the proto of this variable, which PerformBFS popped out
+  // of bfs_queue, and pushes its members into bfs_queue. Adds the size
+  // of the members to size_tracker. members is an empty vector that is
+  // reused for every variable, so that its memory is allocated once.
+  // If the object of the variable is in expansion, the variable only
+  // refers to it. Otherwise, the variable is added if it has members.
+  // The variable is captured within bfs_limits unless it has its own.
+  void PopulateVariable(VariableQueue *bfs_queue,
+                        std::vector<VariableWrapper> *members,
+                        const CaptureLimits &bfs_limits,
+                        SnapshotSizeTracker *size_tracker,
+                        Expansion *expansion,
+                        IEvalCoordinator *eval_coordinator);
+
+  // Returns the path of this variable from the variable PerformBFS
+  // started from, like "this.items[2]".
+  std::string GetPath() const;
+
   // The proto for this variable.
   google::cloud::diagnostics::debug::Variable *variable_proto_;
 
   // The underlying object that will be used to populate variable proto.
   std::shared_ptr<DbgObject> variable_value_;
 
+  // Resolves variable_value_ with value_resolver_ if it is set.
+  HRESULT ResolveValue();
+
   // The BFS level that this variable is at.
   std::int32_t bfs_level_;
+
+  // Produces variable_value_ when the variable is populated, if set.
+  ValueResolver value_resolver_;
+
+  // Node of the capture mask this variable is at, or nullptr if the
+  // variable is captured without a mask.
+  const CaptureMask *capture_mask_ = nullptr;
+
+  // True if only the type of the variable is captured.
+  bool type_only_ = false;
+
+  // Limits this variable and its members are captured within, or nullptr
+  // if they are captured within the limits of PerformBFS.
+  const CaptureLimits *limits_ = nullptr;
+
+  // Path of the parent of this variable, or null if PerformBFS started
+  // from it. Owned by the Expansion of PerformBFS.
+  const std::string *parent_path_ = nullptr;
+};
+
+// FIFO queue of the variables PerformBFS has yet to populate. The
+// variables are kept in a ring buffer that only grows, so a queue that
+// is reused, like the one of GetThreadQueue, stops allocating once it
+// has held the largest frontier of a capture.
+class VariableQueue {
+ public:
+  VariableQueue() = default;
+  VariableQueue(const VariableQueue &) = delete;
+  VariableQueue &operator=(const VariableQueue &) = delete;
+
+  // Returns the queue of the calling thread, which the captures on the
+  // thread reuse. PerformBFS empties the queue before it returns, so
+  // the queue can only be used by one BFS at a time.
+  static VariableQueue *GetThreadQueue();
+
+  // Adds variable to the back of the queue.
+  void push(VariableWrapper variable);
+
+  // Returns the variable at the front of the queue, which cannot be
+  // empty. The variable can be moved from before it is popped.
+  VariableWrapper &front() { return items_[head_]; }
+
+  // Removes the variable at the front of the queue.
+  void pop();
+
+  // Removes all variables, keeping the memory of the queue.
+  void clear();
+
+  bool empty() const { return size_ == 0; }
+
+  std::size_t size() const { return size_; }
+
+  // Returns the number of variables the queue can hold without
+  // allocating.
+  std::size_t capacity() const { return items_.size(); }
+
+ private:
+  // Number of variables a queue can hold when it first allocates.
+  static const std::size_t kInitialCapacity = 64;
+
+  // Doubles the size of items_, moving the variables to its beginning.
+  void Grow();
+
+  // Variables of the queue, starting at head_ and wrapping around.
+  // Slots that are not in the queue hold empty variables.
+  std::vector<VariableWrapper> items_;
+
+  // Index of the front of the queue in items_.
+  std::size_t head_ = 0;
+
+  // Number of variables in the queue.
+  std::size_t size_ = 0;
 };
 
 }  //  namespace google_cloud_debugger
@@ -0,0 +1,58 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async_continuation_chain.h"
+#include "i_cor_debug_helper.h"
+
+using google_cloud_debugger::AsyncContinuationChain;
+using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::ICorDebugHelper;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Tests that the names of async methods are read from the names the
+// compiler gives their state machines.
+TEST(AsyncContinuationChainTest, GetAsyncMethodName) {
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName("<Run>d__3"), "Run");
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName("<GetAsync>d__12`1"),
+            "GetAsync");
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName("<<Main>b__0_0>d"),
+            "<Main>b__0_0");
+}
+
+// Tests that classes that are not state machines have no async method.
+TEST(AsyncContinuationChainTest, GetAsyncMethodNameOfOtherClasses) {
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName(""), "");
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName("Program"), "");
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName("<>c"), "");
+  EXPECT_EQ(AsyncContinuationChain::GetAsyncMethodName("<Run"), "");
+}
+
+// Tests that the chain is not followed without a state machine.
+TEST(AsyncContinuationChainTest, NullStateMachine) {
+  AsyncContinuationChain chain((std::shared_ptr<ICorDebugHelper>()));
+  std::vector<CComPtr<ICorDebugValue>> awaiters;
+  EXPECT_EQ(chain.GetAwaitingStateMachines(nullptr, 10, &awaiters),
+            E_INVALIDARG);
+  EXPECT_TRUE(awaiters.empty());
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,53 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the results of a run of a benchmark with its baseline and
+// prints a report of the differences, for run_benchmarks.sh.
+//
+// Usage: benchmark_regression <baseline.json> <results.json>
+//
+// Both files are written by BenchmarkResults. Exits with 1 if a result
+// regressed beyond its tolerance or is missing, and with 0 otherwise,
+// including when the benchmark has no baseline yet.
+
+#include <iostream>
+
+#include "benchmark_results.h"
+
+using google_cloud_debugger_test::BenchmarkResults;
+using std::cerr;
+using std::cout;
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    cerr << "Usage: benchmark_regression <baseline.json> <results.json>\n";
+    return 2;
+  }
+
+  BenchmarkResults current("", 0);
+  if (!BenchmarkResults::Read(argv[2], &current)) {
+    cerr << "Failed to read the benchmark results " << argv[2] << ".\n";
+    return 2;
+  }
+
+  BenchmarkResults baseline("", 0);
+  if (!BenchmarkResults::Read(argv[1], &baseline)) {
+    cout << current.GetName() << " has no baseline at " << argv[1]
+         << ", every result is new.\n";
+  }
+
+  int failures = BenchmarkResults::Compare(baseline, current, &cout);
+  cout << "\n";
+  return failures == 0 ? 0 : 1;
+}
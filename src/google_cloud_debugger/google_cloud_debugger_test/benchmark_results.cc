@@ -0,0 +1,236 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark_results.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+namespace {
+
+// The name of the result Write adds for the peak resident memory.
+const char kPeakMemoryResult[] = "peak resident memory kB";
+
+// The tolerance of the peak resident memory.
+const double kPeakMemoryTolerance = 0.1;
+
+// Returns value as a JSON string.
+string QuoteJson(const string &value) {
+  string quoted = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  quoted += '"';
+  return quoted;
+}
+
+// Finds "key": in line and sets position to the start of its value.
+// Returns false if line does not have key.
+bool FindKey(const string &line, const string &key, size_t *position) {
+  string quoted_key = "\"" + key + "\":";
+  size_t found = line.find(quoted_key);
+  if (found == string::npos) {
+    return false;
+  }
+  *position = line.find_first_not_of(' ', found + quoted_key.size());
+  return *position != string::npos;
+}
+
+// Reads the string value of key in line, as QuoteJson wrote it.
+bool ReadString(const string &line, const string &key, string *value) {
+  size_t position;
+  if (!FindKey(line, key, &position) || line[position] != '"') {
+    return false;
+  }
+  value->clear();
+  for (++position; position < line.size(); ++position) {
+    if (line[position] == '"') {
+      return true;
+    }
+    if (line[position] == '\\' && position + 1 < line.size()) {
+      ++position;
+    }
+    *value += line[position];
+  }
+  return false;
+}
+
+// Reads the number value of key in line.
+bool ReadNumber(const string &line, const string &key, double *value) {
+  size_t position;
+  if (!FindKey(line, key, &position)) {
+    return false;
+  }
+  char *end;
+  *value = std::strtod(line.c_str() + position, &end);
+  return end != line.c_str() + position;
+}
+
+}  // namespace
+
+BenchmarkResults::BenchmarkResults(const string &name, double tolerance)
+    : name_(name), tolerance_(tolerance) {}
+
+void BenchmarkResults::Add(const string &name, double value,
+                           bool lower_is_better, double tolerance) {
+  Result result;
+  result.name = name;
+  result.value = value;
+  result.lower_is_better = lower_is_better;
+  result.tolerance = tolerance;
+  results_.push_back(result);
+}
+
+bool BenchmarkResults::Write() {
+  const char *directory = std::getenv("BENCHMARK_RESULTS_DIR");
+  if (!directory || !directory[0]) {
+    return true;
+  }
+
+  long peak_kb = ReadPeakMemoryKb();
+  if (peak_kb > 0) {
+    Add(kPeakMemoryResult, peak_kb, true, kPeakMemoryTolerance);
+  }
+
+  string path = string(directory) + "/" + name_ + ".json";
+  std::ofstream file(path);
+  file << std::setprecision(6);
+  file << "{\n";
+  file << "  \"benchmark\": " << QuoteJson(name_) << ",\n";
+  file << "  \"tolerance\": " << tolerance_ << ",\n";
+  file << "  \"results\": [\n";
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const Result &result = results_[i];
+    file << "    {\"name\": " << QuoteJson(result.name)
+         << ", \"value\": " << result.value << ", \"lower_is_better\": "
+         << (result.lower_is_better ? "true" : "false")
+         << ", \"tolerance\": " << result.tolerance << "}"
+         << (i + 1 < results_.size() ? ",\n" : "\n");
+  }
+  file << "  ]\n";
+  file << "}\n";
+  file.close();
+  if (!file) {
+    std::cerr << "Failed to write the benchmark results to " << path << ".\n";
+    return false;
+  }
+  return true;
+}
+
+bool BenchmarkResults::Read(const string &path, BenchmarkResults *results) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+
+  results->name_.clear();
+  results->tolerance_ = 0;
+  results->results_.clear();
+  string line;
+  while (std::getline(file, line)) {
+    Result result;
+    if (ReadString(line, "name", &result.name)) {
+      if (!ReadNumber(line, "value", &result.value) ||
+          !ReadNumber(line, "tolerance", &result.tolerance)) {
+        return false;
+      }
+      result.lower_is_better =
+          line.find("\"lower_is_better\": false") == string::npos;
+      results->results_.push_back(result);
+    } else if (!ReadString(line, "benchmark", &results->name_)) {
+      ReadNumber(line, "tolerance", &results->tolerance_);
+    }
+  }
+  return !results->name_.empty();
+}
+
+int BenchmarkResults::Compare(const BenchmarkResults &baseline,
+                              const BenchmarkResults &current,
+                              std::ostream *report) {
+  std::unordered_map<string, const Result *> baseline_results;
+  for (const Result &result : baseline.results_) {
+    baseline_results[result.name] = &result;
+  }
+
+  int failures = 0;
+  *report << current.name_ << "\n";
+  *report << std::left << std::setw(52) << "  result" << std::right
+          << std::setw(12) << "baseline" << std::setw(12) << "current"
+          << std::setw(10) << "change"
+          << "\n";
+  for (const Result &result : current.results_) {
+    *report << "  " << std::left << std::setw(50) << result.name
+            << std::right;
+    auto found = baseline_results.find(result.name);
+    if (found == baseline_results.end()) {
+      *report << std::setw(12) << "-" << std::setw(12) << result.value
+              << std::setw(10) << "-"
+              << "  new\n";
+      continue;
+    }
+
+    const Result &expected = *found->second;
+    baseline_results.erase(found);
+    double change = expected.value == 0
+                        ? 0
+                        : (result.value - expected.value) / expected.value;
+    double worse = result.lower_is_better ? change : -change;
+    *report << std::setw(12) << expected.value << std::setw(12)
+            << result.value << std::setw(9) << std::showpos
+            << std::setprecision(3) << change * 100 << std::noshowpos
+            << std::setprecision(6) << "%";
+    if (worse > expected.tolerance) {
+      *report << "  REGRESSED (tolerance " << expected.tolerance * 100
+              << "%)";
+      ++failures;
+    } else if (-worse > expected.tolerance) {
+      *report << "  improved";
+    }
+    *report << "\n";
+  }
+
+  for (const Result &result : baseline.results_) {
+    if (baseline_results.count(result.name) != 0) {
+      *report << "  " << std::left << std::setw(50) << result.name
+              << std::right << std::setw(12) << result.value << std::setw(12)
+              << "-" << std::setw(10) << "-"
+              << "  MISSING\n";
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+long BenchmarkResults::ReadPeakMemoryKb() {
+  std::ifstream status("/proc/self/status");
+  string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::atol(line.c_str() + 6);
+    }
+  }
+  return 0;
+}
+
+}  // namespace google_cloud_debugger_test
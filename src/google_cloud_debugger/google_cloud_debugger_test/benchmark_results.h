@@ -0,0 +1,105 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_RESULTS_H_
+#define BENCHMARK_RESULTS_H_
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace google_cloud_debugger_test {
+
+// The results of a run of a benchmark, which the benchmark regression
+// suite compares with the baseline checked in for the benchmark.
+//
+// A benchmark adds its measurements with Add and calls Write before it
+// exits. If the environment variable BENCHMARK_RESULTS_DIR is set, Write
+// saves the results to <name>.json in that directory, with the peak
+// resident memory of the process, one result per line:
+//
+//   {
+//     "benchmark": "snapshot_benchmark",
+//     "tolerance": 0.25,
+//     "results": [
+//       {"name": "wide class/PerformBFS ns/var", "value": 102.5,
+//        "lower_is_better": true, "tolerance": 0.25},
+//       ...
+//     ]
+//   }
+//
+// A result regresses when it is worse than the baseline by more than its
+// tolerance, a fraction of the baseline. The baselines are files written
+// by Write, so their tolerances can be edited by hand.
+class BenchmarkResults {
+ public:
+  // A measurement of a benchmark.
+  struct Result {
+    std::string name;
+    double value = 0;
+    bool lower_is_better = true;
+    double tolerance = 0;
+  };
+
+  // Creates the results of the benchmark name, whose results regress
+  // beyond tolerance by default.
+  BenchmarkResults(const std::string &name, double tolerance);
+
+  // Adds the measurement name of value, which regresses beyond the
+  // default tolerance.
+  void Add(const std::string &name, double value, bool lower_is_better) {
+    Add(name, value, lower_is_better, tolerance_);
+  }
+
+  // Adds the measurement name of value, which regresses beyond tolerance.
+  void Add(const std::string &name, double value, bool lower_is_better,
+           double tolerance);
+
+  // Adds the peak resident memory of the process and writes the results
+  // to BENCHMARK_RESULTS_DIR. Returns true if they were written or the
+  // variable is not set.
+  bool Write();
+
+  // Reads results written by Write from path. Returns false if the file
+  // cannot be read or is not in that format.
+  static bool Read(const std::string &path, BenchmarkResults *results);
+
+  // Compares current with baseline and prints a line for every result to
+  // report, marking the regressions, the improvements and the results
+  // missing from either. Returns the number of regressions and missing
+  // results.
+  static int Compare(const BenchmarkResults &baseline,
+                     const BenchmarkResults &current, std::ostream *report);
+
+  // Returns the name of the benchmark.
+  const std::string &GetName() const { return name_; }
+
+  // Returns the results, in the order they were added.
+  const std::vector<Result> &GetResults() const { return results_; }
+
+  // Returns the peak resident memory of the process in kB, or 0 if it
+  // cannot be read.
+  static long ReadPeakMemoryKb();
+
+ private:
+  // The name of the benchmark and its default tolerance.
+  std::string name_;
+  double tolerance_;
+
+  std::vector<Result> results_;
+};
+
+}  // namespace google_cloud_debugger_test
+
+#endif  // BENCHMARK_RESULTS_H_
@@ -0,0 +1,96 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The benchmarks run on Linux only.
+#ifdef PLATFORM_UNIX
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include "benchmark_results.h"
+
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for BenchmarkResults.
+class BenchmarkResultsTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { setenv("BENCHMARK_RESULTS_DIR", ".", 1); }
+
+  virtual void TearDown() {
+    unsetenv("BENCHMARK_RESULTS_DIR");
+    std::remove(results_file_.c_str());
+  }
+
+  string results_file_ = "./benchmark_results_test.json";
+};
+
+// Tests that written results are read back with the peak memory.
+TEST_F(BenchmarkResultsTest, WriteAndRead) {
+  BenchmarkResults results("benchmark_results_test", 0.25);
+  results.Add("condition \"a\" ns", 12.5, true);
+  results.Add("messages/s", 1000, false, 0.5);
+  ASSERT_TRUE(results.Write());
+
+  BenchmarkResults read("", 0);
+  ASSERT_TRUE(BenchmarkResults::Read(results_file_, &read));
+  EXPECT_EQ(read.GetName(), "benchmark_results_test");
+  ASSERT_GE(read.GetResults().size(), 2);
+  EXPECT_EQ(read.GetResults()[0].name, "condition \"a\" ns");
+  EXPECT_EQ(read.GetResults()[0].value, 12.5);
+  EXPECT_TRUE(read.GetResults()[0].lower_is_better);
+  EXPECT_EQ(read.GetResults()[0].tolerance, 0.25);
+  EXPECT_EQ(read.GetResults()[1].name, "messages/s");
+  EXPECT_FALSE(read.GetResults()[1].lower_is_better);
+  EXPECT_EQ(read.GetResults()[1].tolerance, 0.5);
+
+  // The peak memory is added on Linux.
+  EXPECT_EQ(read.GetResults().size(),
+            BenchmarkResults::ReadPeakMemoryKb() > 0 ? 3 : 2);
+  EXPECT_FALSE(BenchmarkResults::Read("missing.json", &read));
+}
+
+// Tests that only the results worse than the baseline by more than their
+// tolerance, and the results missing from the run, fail the comparison.
+TEST_F(BenchmarkResultsTest, Compare) {
+  BenchmarkResults baseline("benchmark", 0.1);
+  baseline.Add("time", 100, true);
+  baseline.Add("throughput", 100, false);
+  baseline.Add("allocations", 10, true, 0);
+  baseline.Add("removed", 1, true);
+
+  BenchmarkResults current("benchmark", 0.1);
+  current.Add("time", 105, true);
+  current.Add("throughput", 50, false);
+  current.Add("allocations", 9, true, 0);
+  current.Add("added", 1, true);
+
+  std::ostringstream report;
+  EXPECT_EQ(BenchmarkResults::Compare(baseline, current, &report), 2);
+  string text = report.str();
+  EXPECT_NE(text.find("throughput"), string::npos);
+  EXPECT_NE(text.find("REGRESSED"), string::npos);
+  EXPECT_NE(text.find("improved"), string::npos);
+  EXPECT_NE(text.find("new"), string::npos);
+  EXPECT_NE(text.find("MISSING"), string::npos);
+  EXPECT_EQ(text.find("REGRESSED"), text.rfind("REGRESSED"));
+}
+
+}  // namespace google_cloud_debugger_test
+
+#endif  //  PLATFORM_UNIX
@@ -18,6 +18,7 @@
 
 #include "binary_expression_evaluator.h"
 #include "common_fixtures.h"
+#include "string_evaluator.h"
 
 using google_cloud_debugger::BinaryCSharpExpression;
 using google_cloud_debugger::BinaryExpressionEvaluator;
@@ -27,6 +28,8 @@ using google_cloud_debugger::DbgPrimitive;
 using google_cloud_debugger::DbgString;
 using google_cloud_debugger::ExpressionEvaluator;
 using google_cloud_debugger::LiteralEvaluator;
+using google_cloud_debugger::PrimitiveValue;
+using google_cloud_debugger::StringEvaluator;
 using google_cloud_debugger::TypeSignature;
 using std::shared_ptr;
 using std::string;
@@ -421,4 +424,110 @@ TEST_F(BinaryExpressionEvaluatorTest, TestStringComparison) {
                        third_string_obj, test_string.compare(test_string) == 0);
 }
 
+// Tests that a string is compared with a string literal without creating
+// the literal in the debuggee.
+TEST_F(BinaryExpressionEvaluatorTest, TestStringLiteralComparison) {
+  std::shared_ptr<DbgString> string_obj(new DbgString("Test string"));
+  unique_ptr<ExpressionEvaluatorMock> first_arg(new ExpressionEvaluatorMock());
+  EXPECT_CALL(*first_arg, GetStaticType())
+      .WillRepeatedly(ReturnRef(string_sig_));
+  EXPECT_CALL(*first_arg, Compile(_, _, _)).WillOnce(Return(S_OK));
+  EXPECT_CALL(*first_arg, Evaluate(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(DoAll(SetArgPointee<0>(string_obj), Return(S_OK)));
+  EXPECT_CALL(eval_coordinator_mock_, CreateEval(_)).Times(0);
+
+  BinaryExpressionEvaluator evaluator(
+      BinaryCSharpExpression::Type::eq, std::move(first_arg),
+      unique_ptr<ExpressionEvaluator>(new StringEvaluator("Test string")));
+  EXPECT_EQ(evaluator.Compile(nullptr, nullptr, &err_stream_), S_OK);
+
+  std::shared_ptr<DbgObject> result;
+  EXPECT_EQ(evaluator.Evaluate(&result, &eval_coordinator_mock_,
+                               &object_factory_mock_, &err_stream_),
+            S_OK);
+  DbgPrimitive<bool> *cast_result =
+      dynamic_cast<DbgPrimitive<bool> *>(result.get());
+  ASSERT_TRUE(cast_result != nullptr);
+  EXPECT_TRUE(cast_result->GetValue());
+
+  PrimitiveValue value;
+  bool is_equal = false;
+  EXPECT_EQ(evaluator.EvaluatePrimitive(&value, &eval_coordinator_mock_,
+                                        &object_factory_mock_, &err_stream_),
+            S_OK);
+  EXPECT_EQ(value.Get(&is_equal), S_OK);
+  EXPECT_TRUE(is_equal);
+}
+
+// Tests that nested operators on numbers are evaluated from the primitive
+// values of their subexpressions.
+TEST_F(BinaryExpressionEvaluatorTest, TestNestedPrimitives) {
+  unique_ptr<ExpressionEvaluator> sum(new BinaryExpressionEvaluator(
+      BinaryCSharpExpression::Type::add,
+      unique_ptr<ExpressionEvaluator>(new LiteralEvaluator(first_int_obj_)),
+      unique_ptr<ExpressionEvaluator>(new LiteralEvaluator(second_int_obj_))));
+  BinaryExpressionEvaluator evaluator(
+      BinaryCSharpExpression::Type::mul, std::move(sum),
+      unique_ptr<ExpressionEvaluator>(new LiteralEvaluator(first_long_obj_)));
+  EXPECT_EQ(evaluator.Compile(nullptr, nullptr, &err_stream_), S_OK);
+  EXPECT_EQ(evaluator.GetStaticType().cor_type,
+            CorElementType::ELEMENT_TYPE_I8);
+
+  const int64_t expected =
+      (first_int_obj_value_ + second_int_obj_value_) * first_long_obj_value_;
+  PrimitiveValue value;
+  EXPECT_EQ(evaluator.EvaluatePrimitive(&value, &eval_coordinator_mock_,
+                                        &object_factory_mock_, &err_stream_),
+            S_OK);
+  EXPECT_EQ(value.GetType(), CorElementType::ELEMENT_TYPE_I8);
+  int64_t result = 0;
+  EXPECT_EQ(value.Get(&result), S_OK);
+  EXPECT_EQ(result, expected);
+
+  shared_ptr<DbgObject> result_obj;
+  EXPECT_EQ(evaluator.Evaluate(&result_obj, &eval_coordinator_mock_,
+                               &object_factory_mock_, &err_stream_),
+            S_OK);
+  DbgPrimitive<int64_t> *cast_result =
+      dynamic_cast<DbgPrimitive<int64_t> *>(result_obj.get());
+  EXPECT_TRUE(cast_result != nullptr);
+  EXPECT_EQ(cast_result->GetValue(), expected);
+}
+
+// Tests that && and || do not evaluate the second operand when the first
+// one decides the value.
+TEST_F(BinaryExpressionEvaluatorTest, TestShortCircuit) {
+  TypeSignature boolean_sig{CorElementType::ELEMENT_TYPE_BOOLEAN,
+                            google_cloud_debugger::kBooleanClassName};
+  const BinaryCSharpExpression::Type types[] = {
+      BinaryCSharpExpression::Type::conditional_and,
+      BinaryCSharpExpression::Type::conditional_or};
+  for (BinaryCSharpExpression::Type type : types) {
+    const bool is_and = type == BinaryCSharpExpression::Type::conditional_and;
+    unique_ptr<ExpressionEvaluatorMock> second_arg(
+        new ExpressionEvaluatorMock());
+    EXPECT_CALL(*second_arg, GetStaticType())
+        .WillRepeatedly(ReturnRef(boolean_sig));
+    EXPECT_CALL(*second_arg, Compile(_, _, _)).WillOnce(Return(S_OK));
+    EXPECT_CALL(*second_arg, Evaluate(_, _, _, _)).Times(0);
+
+    BinaryExpressionEvaluator evaluator(
+        type,
+        unique_ptr<ExpressionEvaluator>(
+            new LiteralEvaluator(is_and ? false_ : true_)),
+        std::move(second_arg));
+    EXPECT_EQ(evaluator.Compile(nullptr, nullptr, &err_stream_), S_OK);
+
+    shared_ptr<DbgObject> result;
+    EXPECT_EQ(evaluator.Evaluate(&result, &eval_coordinator_mock_,
+                                 &object_factory_mock_, &err_stream_),
+              S_OK);
+    DbgPrimitive<bool> *cast_result =
+        dynamic_cast<DbgPrimitive<bool> *>(result.get());
+    EXPECT_TRUE(cast_result != nullptr);
+    EXPECT_EQ(cast_result->GetValue(), !is_and);
+  }
+}
+
 }  // namespace google_cloud_debugger_test
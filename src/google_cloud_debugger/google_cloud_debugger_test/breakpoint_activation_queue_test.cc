@@ -0,0 +1,195 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpoint_activation_queue.h"
+
+using google::cloud::diagnostics::debug::Breakpoint_LogLevel_INFO;
+using google_cloud_debugger::BreakpointActivationQueue;
+using google_cloud_debugger::DbgBreakpoint;
+using google_cloud_debugger::MetricCounter;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Returns an activated breakpoint with the given id.
+shared_ptr<DbgBreakpoint> CreateActivation(const string &id) {
+  shared_ptr<DbgBreakpoint> breakpoint(new DbgBreakpoint);
+  breakpoint->Initialize("Program.cs", id, 10, 0, false, "",
+                         Breakpoint_LogLevel_INFO, "", {});
+  breakpoint->SetActivated(true);
+  return breakpoint;
+}
+
+// Records the batches activated by a BreakpointActivationQueue. If
+// blocked, the first activation waits until Release is called.
+class ActivationRecorder {
+ public:
+  explicit ActivationRecorder(bool blocked = false) {
+    if (!blocked) {
+      release_.set_value();
+    }
+  }
+
+  BreakpointActivationQueue::ActivateFunction GetActivateFunction() {
+    return [this](const vector<shared_ptr<DbgBreakpoint>> &breakpoints) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!first_activation_started_) {
+          first_activation_started_ = true;
+          started_.set_value();
+        }
+      }
+      release_future_.wait();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      vector<string> ids;
+      for (const shared_ptr<DbgBreakpoint> &breakpoint : breakpoints) {
+        ids.push_back(breakpoint->GetId());
+      }
+      batches_.push_back(ids);
+      activated_count_ += ids.size();
+      activated_cv_.notify_all();
+      return S_OK;
+    };
+  }
+
+  // Waits until the first activation starts.
+  void WaitForFirstActivation() { started_.get_future().wait(); }
+
+  // Lets the activations continue.
+  void Release() { release_.set_value(); }
+
+  // Waits until count breakpoints are activated and returns the ids of
+  // the breakpoints of every batch activated.
+  vector<vector<string>> WaitForBatches(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    activated_cv_.wait(lock,
+                       [this, count] { return activated_count_ >= count; });
+    return batches_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable activated_cv_;
+  bool first_activation_started_ = false;
+  size_t activated_count_ = 0;
+  std::promise<void> started_;
+  std::promise<void> release_;
+  std::shared_future<void> release_future_ = release_.get_future().share();
+  vector<vector<string>> batches_;
+};
+
+// Tests that the breakpoints are activated in order in batches of at
+// most the batch size.
+TEST(BreakpointActivationQueueTest, ActivatesInBatches) {
+  ActivationRecorder recorder(true);
+  MetricCounter cancelled;
+  BreakpointActivationQueue queue(recorder.GetActivateFunction(), 2,
+                                  &cancelled);
+
+  EXPECT_EQ(queue.Enqueue({CreateActivation("first")}), S_OK);
+  recorder.WaitForFirstActivation();
+  EXPECT_EQ(queue.Enqueue({CreateActivation("1"), CreateActivation("2"),
+                           CreateActivation("3")}),
+            S_OK);
+  EXPECT_EQ(queue.GetQueuedCount(), 3);
+  recorder.Release();
+
+  vector<vector<string>> batches = recorder.WaitForBatches(4);
+  ASSERT_EQ(batches.size(), 3);
+  EXPECT_EQ(batches[0], vector<string>({"first"}));
+  EXPECT_EQ(batches[1], vector<string>({"1", "2"}));
+  EXPECT_EQ(batches[2], vector<string>({"3"}));
+  EXPECT_EQ(cancelled.GetValue(), 0);
+}
+
+// Tests that cancelled and replaced activations are not applied.
+TEST(BreakpointActivationQueueTest, CancelsQueuedActivations) {
+  ActivationRecorder recorder(true);
+  MetricCounter cancelled;
+  BreakpointActivationQueue queue(recorder.GetActivateFunction(), 10,
+                                  &cancelled);
+
+  EXPECT_EQ(queue.Enqueue({CreateActivation("first")}), S_OK);
+  recorder.WaitForFirstActivation();
+  EXPECT_EQ(queue.Enqueue({CreateActivation("1"), CreateActivation("2"),
+                           CreateActivation("3")}),
+            S_OK);
+  EXPECT_TRUE(queue.Cancel("2"));
+  EXPECT_FALSE(queue.Cancel("2"));
+  EXPECT_EQ(queue.Enqueue({CreateActivation("1")}), S_OK);
+  EXPECT_EQ(queue.GetQueuedCount(), 2);
+  recorder.Release();
+
+  vector<vector<string>> batches = recorder.WaitForBatches(3);
+  ASSERT_EQ(batches.size(), 2);
+  EXPECT_EQ(batches[1], vector<string>({"3", "1"}));
+  EXPECT_EQ(cancelled.GetValue(), 2);
+}
+
+// Tests that cancelling a breakpoint that is being activated waits for
+// the activation to finish.
+TEST(BreakpointActivationQueueTest, CancelWaitsForActivation) {
+  ActivationRecorder recorder(true);
+  BreakpointActivationQueue queue(recorder.GetActivateFunction(), 10,
+                                  nullptr);
+
+  EXPECT_EQ(queue.Enqueue({CreateActivation("first")}), S_OK);
+  recorder.WaitForFirstActivation();
+
+  std::future<bool> cancel = std::async(
+      std::launch::async, [&queue]() { return queue.Cancel("first"); });
+  EXPECT_EQ(cancel.wait_for(std::chrono::milliseconds(50)),
+            std::future_status::timeout);
+  recorder.Release();
+  EXPECT_FALSE(cancel.get());
+  EXPECT_EQ(recorder.WaitForBatches(1).size(), 1);
+}
+
+// Tests that Stop drops the queued activations.
+TEST(BreakpointActivationQueueTest, StopDropsQueuedActivations) {
+  ActivationRecorder recorder(true);
+  BreakpointActivationQueue queue(recorder.GetActivateFunction(), 10,
+                                  nullptr);
+
+  EXPECT_EQ(queue.Enqueue({CreateActivation("first")}), S_OK);
+  recorder.WaitForFirstActivation();
+  EXPECT_EQ(queue.Enqueue({CreateActivation("queued")}), S_OK);
+
+  std::future<void> stop =
+      std::async(std::launch::async, [&queue]() { queue.Stop(); });
+  while (queue.GetQueuedCount() != 0) {
+    std::this_thread::yield();
+  }
+  recorder.Release();
+  stop.get();
+
+  EXPECT_EQ(recorder.WaitForBatches(1).size(), 1);
+  EXPECT_EQ(queue.GetQueuedCount(), 0);
+  EXPECT_EQ(queue.Enqueue({CreateActivation("late")}), E_ABORT);
+}
+
+}  // namespace google_cloud_debugger_test
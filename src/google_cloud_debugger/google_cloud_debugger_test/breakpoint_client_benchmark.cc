@@ -0,0 +1,395 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the latency and throughput of BreakpointClient over a real unix
+// socket, without the agent or a debugged application.
+//
+// The benchmark listens on the socket NamedPipeClient connects to and
+// echoes back everything it reads, so every breakpoint written by the
+// client comes back as a breakpoint it can read. For each breakpoint size
+// it reports the percentiles of the round-trip time of one breakpoint and
+// how many breakpoints per second can be written and read back when the
+// client writes them as fast as it can.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark_results.h"
+#include "breakpoint.pb.h"
+#include "breakpoint_client.h"
+#include "named_pipe_client_unix.h"
+#include "optionparser.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::StackFrame;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::BreakpointClient;
+using google_cloud_debugger::MessageFraming;
+using google_cloud_debugger::NamedPipeClient;
+using google_cloud_debugger_test::BenchmarkResults;
+using std::cerr;
+using std::chrono::steady_clock;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+// Sizes of the serialized breakpoints that are measured, in bytes.
+const vector<size_t> kBreakpointSizes = {64, 1024, 16 * 1024, 256 * 1024};
+
+// Number of round trips measured for every breakpoint size by default.
+const int kDefaultIterations = 2000;
+
+// Number of breakpoints written for every breakpoint size by default when
+// measuring throughput.
+const int kDefaultMessages = 20000;
+
+enum optionIndex {
+  UNKNOWN,
+  ITERATIONS,
+  MESSAGES,
+  BATCH,
+  LENGTHPREFIXEDFRAMING,
+  COMPRESSBREAKPOINTS
+};
+
+// Accepts an option that has a positive integer argument.
+option::ArgStatus PositiveNumber(const option::Option &option, bool msg) {
+  if (option.arg != nullptr && atoi(option.arg) > 0) {
+    return option::ARG_OK;
+  }
+  if (msg) {
+    cerr << "Option " << option.name << " requires a positive number.\n";
+  }
+  return option::ARG_ILLEGAL;
+}
+
+const option::Descriptor usage[] = {
+    {UNKNOWN, 0, "", "", option::Arg::None,
+     "USAGE: breakpoint_client_benchmark [options]\n\n"
+     "Options:"},
+    {ITERATIONS, 0, "", "iterations", PositiveNumber,
+     "  --iterations=<n>  \tNumber of round trips measured for every "
+     "breakpoint size."},
+    {MESSAGES, 0, "", "messages", PositiveNumber,
+     "  --messages=<n>  \tNumber of breakpoints written for every breakpoint "
+     "size when measuring throughput."},
+    {BATCH, 0, "", "batch", PositiveNumber,
+     "  --batch=<n>  \tNumber of breakpoints written in a single "
+     "WriteBreakpoints call when measuring throughput."},
+    {LENGTHPREFIXEDFRAMING, 0, "", "length-prefixed-framing",
+     option::Arg::None,
+     "  --length-prefixed-framing  \tIf used, breakpoints are preceded by "
+     "their size instead of being surrounded by start and end markers."},
+    {COMPRESSBREAKPOINTS, 0, "", "compress-breakpoints", option::Arg::None,
+     "  --compress-breakpoints  \tIf used, large breakpoints are written "
+     "compressed. Only measures writes, since the client does not read "
+     "compressed breakpoints, so it requires --length-prefixed-framing."},
+    {0, 0, 0, 0, 0, 0}};
+
+// Listens on the unix socket of a pipe and echoes back everything
+// written by the client that connects to it.
+class EchoServer {
+ public:
+  // The client has to be destroyed first so that the echo thread sees
+  // the end of the connection.
+  ~EchoServer() {
+    if (thread_.joinable()) {
+      // Wakes up accept if the client never connected.
+      shutdown(listener_, SHUT_RDWR);
+      thread_.join();
+    }
+    if (connection_ != -1) {
+      close(connection_);
+    }
+    if (listener_ != -1) {
+      close(listener_);
+      unlink(path_.c_str());
+    }
+  }
+
+  // Listens on the socket of the pipe pipe_name. If discard is true,
+  // what the client writes is read but not echoed back.
+  bool Start(const string &pipe_name, bool discard) {
+    path_ = "/tmp/CoreFxPipe_" + pipe_name;
+    listener_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener_ == -1) {
+      cerr << "socket error: " << strerror(errno) << std::endl;
+      return false;
+    }
+
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path_.c_str());
+    if (bind(listener_, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        listen(listener_, 1) == -1) {
+      cerr << "bind error: " << strerror(errno) << std::endl;
+      return false;
+    }
+
+    thread_ = std::thread(&EchoServer::Echo, this, discard);
+    return true;
+  }
+
+ private:
+  void Echo(bool discard) {
+    connection_ = accept(listener_, nullptr, nullptr);
+    if (connection_ == -1) {
+      cerr << "accept error: " << strerror(errno) << std::endl;
+      return;
+    }
+
+    vector<char> buffer(64 * 1024);
+    while (true) {
+      ssize_t read_bytes = read(connection_, buffer.data(), buffer.size());
+      if (read_bytes <= 0) {
+        return;
+      }
+      if (discard) {
+        continue;
+      }
+
+      ssize_t written = 0;
+      while (written < read_bytes) {
+        ssize_t result =
+            write(connection_, buffer.data() + written, read_bytes - written);
+        if (result <= 0) {
+          return;
+        }
+        written += result;
+      }
+    }
+  }
+
+  string path_;
+  int listener_ = -1;
+  int connection_ = -1;
+  std::thread thread_;
+};
+
+// Creates a snapshot breakpoint whose serialized size is about size bytes.
+Breakpoint CreateBreakpoint(size_t size) {
+  Breakpoint breakpoint;
+  breakpoint.set_id("benchmark-breakpoint");
+  breakpoint.mutable_location()->set_path("/app/Program.cs");
+  breakpoint.mutable_location()->set_line(42);
+
+  StackFrame *frame = breakpoint.add_stack_frames();
+  frame->set_method_name("Program.Main");
+  int index = 0;
+  while (breakpoint.ByteSizeLong() < size) {
+    Variable *variable = frame->add_locals();
+    variable->set_name("local" + std::to_string(index++));
+    variable->set_type("System.String");
+    variable->set_value(string(16, 'a' + index % 26));
+  }
+  return breakpoint;
+}
+
+// Prints the percentiles of the round trip times in latencies and adds the
+// median and the 99th percentile to results.
+void PrintLatencies(size_t size, vector<double> *latencies,
+                    BenchmarkResults *results) {
+  std::sort(latencies->begin(), latencies->end());
+  auto percentile = [latencies](double fraction) {
+    size_t index = static_cast<size_t>(fraction * (latencies->size() - 1));
+    return (*latencies)[index];
+  };
+  printf("%10zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", size,
+         percentile(0.5), percentile(0.9), percentile(0.99),
+         percentile(0.999), latencies->back());
+  string name = std::to_string(size) + " bytes ";
+  results->Add(name + "p50 latency us", percentile(0.5), true);
+  results->Add(name + "p99 latency us", percentile(0.99), true);
+}
+
+// Connects a client to a new echo server and returns it.
+unique_ptr<BreakpointClient> Connect(EchoServer *server,
+                                     MessageFraming framing, bool compress,
+                                     bool discard) {
+  string pipe_name = "benchmark-" + std::to_string(getpid());
+  if (!server->Start(pipe_name, discard)) {
+    return nullptr;
+  }
+
+  unique_ptr<NamedPipeClient> pipe(new (std::nothrow)
+                                       NamedPipeClient(pipe_name));
+  unique_ptr<BreakpointClient> client(
+      new (std::nothrow) BreakpointClient(std::move(pipe), framing));
+  if (FAILED(client->Initialize()) || FAILED(client->WaitForConnection())) {
+    cerr << "Failed to connect to the echo server." << std::endl;
+    return nullptr;
+  }
+  client->SetCompressBreakpoints(compress);
+  return client;
+}
+
+// Measures the round trip time of iterations breakpoints of every size.
+bool MeasureLatency(MessageFraming framing, int iterations,
+                    BenchmarkResults *results) {
+  EchoServer server;
+  unique_ptr<BreakpointClient> client =
+      Connect(&server, framing, false, false);
+  if (!client) {
+    return false;
+  }
+
+  printf("Round trip latency (us)\n");
+  printf("%10s %10s %10s %10s %10s %10s\n", "bytes", "p50", "p90", "p99",
+         "p99.9", "max");
+  Breakpoint read_breakpoint;
+  for (size_t size : kBreakpointSizes) {
+    Breakpoint breakpoint = CreateBreakpoint(size);
+    vector<double> latencies;
+    latencies.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+      steady_clock::time_point start = steady_clock::now();
+      if (FAILED(client->WriteBreakpoint(breakpoint)) ||
+          FAILED(client->ReadBreakpoint(&read_breakpoint))) {
+        cerr << "Round trip failed." << std::endl;
+        return false;
+      }
+      latencies.push_back(std::chrono::duration<double, std::micro>(
+                              steady_clock::now() - start)
+                              .count());
+    }
+    PrintLatencies(breakpoint.ByteSizeLong(), &latencies, results);
+  }
+  return true;
+}
+
+// Measures how many breakpoints of every size are written (and read back
+// unless compress is true) per second when written in batches of batch.
+bool MeasureThroughput(MessageFraming framing, bool compress, int messages,
+                       int batch, BenchmarkResults *results) {
+  EchoServer server;
+  unique_ptr<BreakpointClient> client =
+      Connect(&server, framing, compress, compress);
+  if (!client) {
+    return false;
+  }
+
+  printf("\nThroughput with batches of %d\n", batch);
+  printf("%10s %14s %10s\n", "bytes", "messages/s", "MB/s");
+  for (size_t size : kBreakpointSizes) {
+    vector<Breakpoint> breakpoints(batch, CreateBreakpoint(size));
+    size_t breakpoint_size = breakpoints[0].ByteSizeLong();
+
+    steady_clock::time_point start = steady_clock::now();
+    bool write_failed = false;
+    std::thread writer([&]() {
+      for (int written = 0; written < messages; written += batch) {
+        size_t count = std::min(batch, messages - written);
+        if (FAILED(client->WriteBreakpoints(breakpoints.data(), count))) {
+          write_failed = true;
+          return;
+        }
+      }
+    });
+
+    // Reads concurrently so that the echo server never blocks on a full
+    // socket buffer.
+    Breakpoint read_breakpoint;
+    bool read_failed = false;
+    for (int i = 0; i < messages && !compress; ++i) {
+      if (FAILED(client->ReadBreakpoint(&read_breakpoint))) {
+        read_failed = true;
+        client->ShutDown();
+        break;
+      }
+    }
+    writer.join();
+    if (write_failed || read_failed) {
+      cerr << "Throughput measurement failed." << std::endl;
+      return false;
+    }
+
+    double seconds =
+        std::chrono::duration<double>(steady_clock::now() - start).count();
+    printf("%10zu %14.0f %10.1f\n", breakpoint_size, messages / seconds,
+           messages * breakpoint_size / seconds / (1024 * 1024));
+    results->Add(std::to_string(breakpoint_size) + " bytes messages/s",
+                 messages / seconds, false);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 0) {
+    // Skips first argument.
+    argc -= 1;
+    argv += 1;
+  }
+
+  option::Stats stats(usage, argc, argv);
+  vector<option::Option> options(stats.options_max);
+  vector<option::Option> buffer(stats.buffer_max);
+  option::Parser parse(usage, argc, argv, options.data(), buffer.data());
+  if (parse.error() || options[UNKNOWN].count()) {
+    option::printUsage(std::cout, usage);
+    return -1;
+  }
+
+  int iterations = options[ITERATIONS] ? atoi(options[ITERATIONS].arg)
+                                       : kDefaultIterations;
+  int messages =
+      options[MESSAGES] ? atoi(options[MESSAGES].arg) : kDefaultMessages;
+  int batch = options[BATCH] ? atoi(options[BATCH].arg) : 1;
+  MessageFraming framing = options[LENGTHPREFIXEDFRAMING]
+                               ? MessageFraming::kLengthPrefixed
+                               : MessageFraming::kMarkers;
+  bool compress = options[COMPRESSBREAKPOINTS].count() > 0;
+  if (compress && framing != MessageFraming::kLengthPrefixed) {
+    cerr << "--compress-breakpoints requires --length-prefixed-framing.\n";
+    return -1;
+  }
+
+  // Every combination of the options is compared with its own baseline.
+  string name = "breakpoint_client_benchmark";
+  if (framing == MessageFraming::kLengthPrefixed) {
+    name += "_framed";
+  }
+  if (compress) {
+    name += "_compressed";
+  }
+  if (batch != 1) {
+    name += "_batch" + std::to_string(batch);
+  }
+  BenchmarkResults results(name, 0.25);
+
+  // Compressed breakpoints cannot be read back, so only throughput
+  // is measured.
+  if (!compress && !MeasureLatency(framing, iterations, &results)) {
+    return -1;
+  }
+  if (!MeasureThroughput(framing, compress, messages, batch, &results)) {
+    return -1;
+  }
+  return results.Write() ? 0 : 1;
+}
@@ -14,21 +14,30 @@
 
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <string>
 
+#ifdef PLATFORM_UNIX
+#include <zlib.h>
+#endif
+
 #include "breakpoint_client.h"
 #include "custom_binary_reader.h"
 #include "common_action_mocks.h"
 #include "i_named_pipe_mock.h"
 
 using ::testing::DoAll;
+using ::testing::Invoke;
 using ::testing::Return;
-using ::testing::SaveArg;
+using ::testing::SetArgPointee;
 using ::testing::_;
 using google::cloud::diagnostics::debug::Breakpoint;
 using google::cloud::diagnostics::debug::SourceLocation;
+using google::cloud::diagnostics::debug::StackFrame;
 using google_cloud_debugger::BreakpointClient;
+using google_cloud_debugger::MessageFraming;
+using google_cloud_debugger::PipeBuffer;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -49,6 +58,18 @@ namespace google_cloud_debugger_test {
   BreakpointClient client(std::move(named_pipe));                             \
   EXPECT_EQ(client.TestFunction(), TestFunctionReturnValue);
 
+// Returns an action for INamedPipeMock::WriteBuffers that appends
+// the written buffers to message.
+std::function<HRESULT(const PipeBuffer *, size_t)> SaveBuffers(
+    string *message) {
+  return [message](const PipeBuffer *buffers, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      message->append(buffers[i].data, buffers[i].size);
+    }
+    return S_OK;
+  };
+}
+
 // Tests Initialize function of BreakpointClient.
 TEST(BreakpointClientTest, Initialize) {
   BREAKPOINT_CLIENT_SIMPLE_TEST(Initialize, S_OK);
@@ -154,14 +175,46 @@ TEST(BreakpointClientTest, WriteBreakpoint) {
   unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
 
   string breakpoint_to_write;
-  EXPECT_CALL(*named_pipe, Write(_))
-      .WillRepeatedly(DoAll(SaveArg<0>(&breakpoint_to_write), Return(S_OK)));
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .WillRepeatedly(Invoke(SaveBuffers(&breakpoint_to_write)));
+  EXPECT_CALL(*named_pipe, Write(_)).Times(0);
   BreakpointClient client(std::move(named_pipe));
 
   EXPECT_EQ(client.WriteBreakpoint(breakpoint), S_OK);
   EXPECT_EQ(breakpoint_to_write, breakpoint_string);
 }
 
+// Tests that WriteBreakpoint sends the markers and the serialized
+// breakpoint as separate buffers instead of copying them together.
+TEST(BreakpointClientTest, WriteBreakpointBuffers) {
+  Breakpoint breakpoint;
+  SetBreakpointAndSerialize(&breakpoint, true, 35, "My Path");
+  string serialized_breakpoint;
+  breakpoint.SerializeToString(&serialized_breakpoint);
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+
+  vector<string> buffers;
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, 3))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](const PipeBuffer *written, size_t count) {
+        buffers.clear();
+        for (size_t i = 0; i < count; ++i) {
+          buffers.push_back(string(written[i].data, written[i].size));
+        }
+        return S_OK;
+      }));
+  BreakpointClient client(std::move(named_pipe));
+
+  // The second write reuses the buffer of the first one.
+  EXPECT_EQ(client.WriteBreakpoint(breakpoint), S_OK);
+  EXPECT_EQ(client.WriteBreakpoint(breakpoint), S_OK);
+  ASSERT_EQ(buffers.size(), 3);
+  EXPECT_EQ(buffers[0], google_cloud_debugger::kStartBreakpointMessage);
+  EXPECT_EQ(buffers[1], serialized_breakpoint);
+  EXPECT_EQ(buffers[2], google_cloud_debugger::kEndBreakpointMessage);
+}
+
 // Tests error case for WriteBreakpoint function of BreakpointClient.
 TEST(BreakpointClientTest, WriteBreakpointError) {
   Breakpoint breakpoint;
@@ -170,10 +223,303 @@ TEST(BreakpointClientTest, WriteBreakpointError) {
 
   unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
 
-  EXPECT_CALL(*named_pipe, Write(_)).WillRepeatedly(Return(E_ABORT));
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .WillRepeatedly(Return(E_ABORT));
   BreakpointClient client(std::move(named_pipe));
 
   EXPECT_EQ(client.WriteBreakpoint(breakpoint), E_ABORT);
 }
 
+// Tests that WriteBreakpoint with length-prefixed framing writes
+// the frame header followed by the serialized breakpoint.
+TEST(BreakpointClientTest, WriteLengthPrefixedBreakpoint) {
+  Breakpoint breakpoint;
+  SetBreakpointAndSerialize(&breakpoint, true, 35, "My Path");
+  string serialized_breakpoint;
+  breakpoint.SerializeToString(&serialized_breakpoint);
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+
+  string frame;
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .WillOnce(Invoke(SaveBuffers(&frame)));
+  BreakpointClient client(std::move(named_pipe),
+                          MessageFraming::kLengthPrefixed);
+
+  EXPECT_EQ(client.WriteBreakpoint(breakpoint), S_OK);
+  ASSERT_EQ(frame.size(), 5 + serialized_breakpoint.size());
+  EXPECT_EQ(frame[0], google_cloud_debugger::kFrameVersion);
+  EXPECT_EQ(static_cast<uint8_t>(frame[1]), serialized_breakpoint.size());
+  EXPECT_EQ(frame[2], 0);
+  EXPECT_EQ(frame[3], 0);
+  EXPECT_EQ(frame[4], 0);
+  EXPECT_EQ(frame.substr(5), serialized_breakpoint);
+}
+
+// Tests that WriteBreakpoints writes all the frames in one write.
+TEST(BreakpointClientTest, WriteLengthPrefixedBreakpoints) {
+  Breakpoint breakpoints[2];
+  SetBreakpointAndSerialize(&breakpoints[0], true, 35, "My Path");
+  SetBreakpointAndSerialize(&breakpoints[1], false, 7, "Other Path");
+
+  string expected_frames;
+  for (const Breakpoint &breakpoint : breakpoints) {
+    unique_ptr<INamedPipeMock> frame_pipe(new (std::nothrow) INamedPipeMock());
+    EXPECT_CALL(*frame_pipe, WriteBuffers(_, _))
+        .WillOnce(Invoke(SaveBuffers(&expected_frames)));
+    BreakpointClient frame_client(std::move(frame_pipe),
+                                  MessageFraming::kLengthPrefixed);
+    EXPECT_EQ(frame_client.WriteBreakpoint(breakpoint), S_OK);
+  }
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+  string frames;
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .WillOnce(Invoke(SaveBuffers(&frames)));
+  BreakpointClient client(std::move(named_pipe),
+                          MessageFraming::kLengthPrefixed);
+
+  EXPECT_EQ(client.WriteBreakpoints(breakpoints, 2), S_OK);
+  EXPECT_EQ(frames, expected_frames);
+}
+
+#ifdef PLATFORM_UNIX
+// Tests that large breakpoints are compressed when compression is enabled
+// and small ones are still sent as they are.
+TEST(BreakpointClientTest, WriteCompressedBreakpoints) {
+  Breakpoint breakpoints[2];
+  SetBreakpointAndSerialize(&breakpoints[0], true, 35, "My Path");
+  SetBreakpointAndSerialize(&breakpoints[1], true, 7, "Other Path");
+  for (int i = 0; i < 200; ++i) {
+    StackFrame *frame = breakpoints[1].add_stack_frames();
+    frame->set_method_name("Method");
+    frame->add_locals()->set_name("Variable");
+  }
+  string small_breakpoint;
+  string large_breakpoint;
+  breakpoints[0].SerializeToString(&small_breakpoint);
+  breakpoints[1].SerializeToString(&large_breakpoint);
+  ASSERT_LT(small_breakpoint.size(),
+            google_cloud_debugger::kMinimumCompressedBreakpointSize);
+  ASSERT_GE(large_breakpoint.size(),
+            google_cloud_debugger::kMinimumCompressedBreakpointSize);
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+  string frames;
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .WillOnce(Invoke(SaveBuffers(&frames)));
+  BreakpointClient client(std::move(named_pipe),
+                          MessageFraming::kLengthPrefixed);
+  client.SetCompressBreakpoints(true);
+  EXPECT_EQ(client.WriteBreakpoints(breakpoints, 2), S_OK);
+
+  ASSERT_GT(frames.size(), 5 + small_breakpoint.size());
+  EXPECT_EQ(frames[0], google_cloud_debugger::kFrameVersion);
+  EXPECT_EQ(frames.substr(5, small_breakpoint.size()), small_breakpoint);
+
+  string frame = frames.substr(5 + small_breakpoint.size());
+  ASSERT_GT(frame.size(), 9);
+  EXPECT_EQ(static_cast<uint8_t>(frame[0]),
+            google_cloud_debugger::kFrameVersion |
+                google_cloud_debugger::kFrameCompressedFlag);
+  uint32_t compressed_size = static_cast<uint8_t>(frame[1]) |
+                             static_cast<uint8_t>(frame[2]) << 8 |
+                             static_cast<uint8_t>(frame[3]) << 16 |
+                             static_cast<uint8_t>(frame[4]) << 24;
+  ASSERT_EQ(compressed_size, frame.size() - 5);
+  EXPECT_LT(compressed_size, large_breakpoint.size());
+  uint32_t uncompressed_size = static_cast<uint8_t>(frame[5]) |
+                               static_cast<uint8_t>(frame[6]) << 8 |
+                               static_cast<uint8_t>(frame[7]) << 16 |
+                               static_cast<uint8_t>(frame[8]) << 24;
+  ASSERT_EQ(uncompressed_size, large_breakpoint.size());
+
+  z_stream stream = {};
+  ASSERT_EQ(inflateInit2(&stream, -MAX_WBITS), Z_OK);
+  string inflated(uncompressed_size, '\0');
+  stream.next_in = reinterpret_cast<Bytef *>(&frame[9]);
+  stream.avail_in = frame.size() - 9;
+  stream.next_out = reinterpret_cast<Bytef *>(&inflated[0]);
+  stream.avail_out = inflated.size();
+  EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+  inflateEnd(&stream);
+  EXPECT_EQ(inflated, large_breakpoint);
+}
+#endif
+
+// Tests that a breakpoint larger than a chunk is written as frames that
+// merge back into it, all of them but the last flagged as chunks.
+TEST(BreakpointClientTest, WriteChunkedBreakpoint) {
+  Breakpoint breakpoint;
+  SetBreakpointAndSerialize(&breakpoint, true, 35, "My Path");
+  string value(4096, 'x');
+  for (int i = 0; i < 200; ++i) {
+    StackFrame *frame = breakpoint.add_stack_frames();
+    frame->set_method_name("Method" + std::to_string(i));
+    frame->add_locals()->set_value(value);
+  }
+  breakpoint.add_evaluated_expressions()->set_name("Expression");
+  string serialized;
+  breakpoint.SerializeToString(&serialized);
+  ASSERT_GT(serialized.size(), 2 * google_cloud_debugger::kBreakpointChunkSize);
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+  string frames;
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .WillRepeatedly(Invoke(SaveBuffers(&frames)));
+  BreakpointClient client(std::move(named_pipe),
+                          MessageFraming::kLengthPrefixed);
+  EXPECT_EQ(client.WriteBreakpoint(breakpoint), S_OK);
+
+  Breakpoint merged;
+  size_t offset = 0;
+  int frame_count = 0;
+  bool last = false;
+  while (offset < frames.size()) {
+    ASSERT_FALSE(last);
+    ASSERT_GE(frames.size() - offset, 5);
+    uint8_t version = static_cast<uint8_t>(frames[offset]);
+    uint32_t size = static_cast<uint8_t>(frames[offset + 1]) |
+                    static_cast<uint8_t>(frames[offset + 2]) << 8 |
+                    static_cast<uint8_t>(frames[offset + 3]) << 16 |
+                    static_cast<uint8_t>(frames[offset + 4]) << 24;
+    ASSERT_LE(size, frames.size() - offset - 5);
+    EXPECT_LT(size, google_cloud_debugger::kBreakpointChunkSize + 2 * 4096);
+    last = version == google_cloud_debugger::kFrameVersion;
+    if (!last) {
+      EXPECT_EQ(version, google_cloud_debugger::kFrameVersion |
+                             google_cloud_debugger::kFrameChunkFlag);
+    }
+    ASSERT_TRUE(merged.MergeFromString(frames.substr(offset + 5, size)));
+    offset += 5 + size;
+    ++frame_count;
+  }
+
+  EXPECT_TRUE(last);
+  EXPECT_GT(frame_count, 3);
+  string merged_serialized;
+  merged.SerializeToString(&merged_serialized);
+  EXPECT_EQ(merged_serialized, serialized);
+}
+
+// Tests that consecutive hits of log points are written as one frame of
+// log records between the breakpoints around them when log records are
+// enabled.
+TEST(BreakpointClientTest, WriteLogRecords) {
+  vector<Breakpoint> breakpoints(4);
+  SetBreakpointAndSerialize(&breakpoints[0], true, 35, "My Path");
+  for (int i = 1; i < 3; ++i) {
+    breakpoints[i].set_id("log" + std::to_string(i));
+    breakpoints[i].set_log_point(true);
+    breakpoints[i].set_log_message_format("Hit $0");
+    breakpoints[i].set_log_level(Breakpoint::WARNING);
+    breakpoints[i].add_evaluated_expressions()->set_value(std::to_string(i));
+  }
+
+  // A hit with an error status is still written as a breakpoint.
+  breakpoints[3] = breakpoints[1];
+  breakpoints[3].mutable_status()->set_iserror(true);
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+  string frames;
+  EXPECT_CALL(*named_pipe, WriteBuffers(_, _))
+      .Times(3)
+      .WillRepeatedly(Invoke(SaveBuffers(&frames)));
+  BreakpointClient client(std::move(named_pipe),
+                          MessageFraming::kLengthPrefixed);
+  client.SetLogRecords(true);
+  EXPECT_EQ(client.WriteBreakpoints(breakpoints.data(), breakpoints.size()),
+            S_OK);
+
+  vector<uint8_t> versions;
+  vector<string> messages;
+  size_t offset = 0;
+  while (offset < frames.size()) {
+    ASSERT_GE(frames.size() - offset, 5);
+    versions.push_back(static_cast<uint8_t>(frames[offset]));
+    uint32_t size = static_cast<uint8_t>(frames[offset + 1]) |
+                    static_cast<uint8_t>(frames[offset + 2]) << 8 |
+                    static_cast<uint8_t>(frames[offset + 3]) << 16 |
+                    static_cast<uint8_t>(frames[offset + 4]) << 24;
+    ASSERT_LE(size, frames.size() - offset - 5);
+    messages.push_back(frames.substr(offset + 5, size));
+    offset += 5 + size;
+  }
+
+  ASSERT_EQ(versions.size(), 3);
+  EXPECT_EQ(versions[0], google_cloud_debugger::kFrameVersion);
+  EXPECT_EQ(versions[1], google_cloud_debugger::kFrameVersion |
+                             google_cloud_debugger::kFrameLogRecordsFlag);
+  EXPECT_EQ(versions[2], google_cloud_debugger::kFrameVersion);
+
+  Breakpoint parsed;
+  ASSERT_TRUE(parsed.ParseFromString(messages[0]));
+  EXPECT_EQ(parsed.id(), breakpoints[0].id());
+  ASSERT_TRUE(parsed.ParseFromString(messages[2]));
+  EXPECT_TRUE(parsed.status().iserror());
+
+  // Two records of the ID "logN", an eight-byte timestamp, the level and
+  // the message "Hit N", with the sizes of the strings in front of them.
+  const string &records = messages[1];
+  ASSERT_EQ(records.size(), 2 * (5 + 8 + 1 + 6));
+  EXPECT_EQ(records.substr(0, 5), "\x04log1");
+  EXPECT_EQ(records[13], static_cast<char>(Breakpoint::WARNING));
+  EXPECT_EQ(records.substr(14, 6), "\x05Hit 1");
+  EXPECT_EQ(records.substr(20, 5), "\x04log2");
+  EXPECT_EQ(records.substr(34, 6), "\x05Hit 2");
+}
+
+// Tests that ReadBreakpoint with length-prefixed framing reads the frame
+// header and then exactly the size in it.
+TEST(BreakpointClientTest, ReadLengthPrefixedBreakpoint) {
+  Breakpoint breakpoint;
+  SetBreakpointAndSerialize(&breakpoint, true, 35, "My Path");
+
+  // Uses a client to create the frame.
+  string frame;
+  unique_ptr<INamedPipeMock> write_pipe(new (std::nothrow) INamedPipeMock());
+  EXPECT_CALL(*write_pipe, WriteBuffers(_, _))
+      .WillOnce(Invoke(SaveBuffers(&frame)));
+  BreakpointClient write_client(std::move(write_pipe),
+                                MessageFraming::kLengthPrefixed);
+  EXPECT_EQ(write_client.WriteBreakpoint(breakpoint), S_OK);
+
+  unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+  size_t position = 0;
+  EXPECT_CALL(*named_pipe, ReadExactly(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](size_t size, string *message) {
+        *message = frame.substr(position, size);
+        position += size;
+        return message->size() == size ? S_OK : E_FAIL;
+      }));
+  EXPECT_CALL(*named_pipe, Read(_)).Times(0);
+  BreakpointClient client(std::move(named_pipe),
+                          MessageFraming::kLengthPrefixed);
+
+  Breakpoint read_breakpoint;
+  EXPECT_EQ(client.ReadBreakpoint(&read_breakpoint), S_OK);
+  EXPECT_EQ(position, frame.size());
+  EXPECT_EQ(read_breakpoint.activated(), breakpoint.activated());
+  EXPECT_EQ(read_breakpoint.location().line(), breakpoint.location().line());
+  EXPECT_EQ(read_breakpoint.location().path(), breakpoint.location().path());
+}
+
+// Tests that frames with an unknown version or a size that is too large
+// are rejected without reading the rest of the frame.
+TEST(BreakpointClientTest, ReadLengthPrefixedBreakpointInvalidHeader) {
+  vector<string> headers = {string("\x02\x01\x00\x00\x00", 5),
+                            string("\x01\xFF\xFF\xFF\xFF", 5)};
+  for (const string &header : headers) {
+    unique_ptr<INamedPipeMock> named_pipe(new (std::nothrow) INamedPipeMock());
+    EXPECT_CALL(*named_pipe, ReadExactly(5, _))
+        .WillOnce(DoAll(SetArgPointee<1>(header), Return(S_OK)));
+    BreakpointClient client(std::move(named_pipe),
+                            MessageFraming::kLengthPrefixed);
+
+    Breakpoint read_breakpoint;
+    EXPECT_EQ(client.ReadBreakpoint(&read_breakpoint), E_FAIL);
+  }
+}
+
 }  // namespace google_cloud_debugger_test
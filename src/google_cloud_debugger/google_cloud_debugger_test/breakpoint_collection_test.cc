@@ -0,0 +1,104 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "breakpoint.pb.h"
+#include "breakpoint_collection.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google_cloud_debugger::BreakpointCollection;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a line with a path and a line is parsed as a snapshot.
+TEST(BreakpointCollectionTest, ParseLocalSnapshot) {
+  std::istringstream input("Program.cs:42\n");
+  vector<Breakpoint> breakpoints;
+  EXPECT_EQ(BreakpointCollection::ParseLocalBreakpoints(&input, &breakpoints),
+            S_OK);
+  ASSERT_EQ(breakpoints.size(), 1);
+  EXPECT_EQ(breakpoints[0].id(), "local-1");
+  EXPECT_EQ(breakpoints[0].location().path(), "Program.cs");
+  EXPECT_EQ(breakpoints[0].location().line(), 42);
+  EXPECT_TRUE(breakpoints[0].activated());
+  EXPECT_FALSE(breakpoints[0].log_point());
+}
+
+// Tests that the text after the location is the message of a log point.
+TEST(BreakpointCollectionTest, ParseLocalLogPoint) {
+  std::istringstream input("src/Orders.cs:7 Order {order.Id} placed\n");
+  vector<Breakpoint> breakpoints;
+  EXPECT_EQ(BreakpointCollection::ParseLocalBreakpoints(&input, &breakpoints),
+            S_OK);
+  ASSERT_EQ(breakpoints.size(), 1);
+  EXPECT_EQ(breakpoints[0].location().path(), "src/Orders.cs");
+  EXPECT_EQ(breakpoints[0].location().line(), 7);
+  EXPECT_TRUE(breakpoints[0].log_point());
+  EXPECT_EQ(breakpoints[0].log_message_format(), "Order {order.Id} placed");
+}
+
+// Tests that the line number is taken after the last colon of a path.
+TEST(BreakpointCollectionTest, ParseLocalWindowsPath) {
+  std::istringstream input("C:\\app\\Program.cs:12\r\n");
+  vector<Breakpoint> breakpoints;
+  EXPECT_EQ(BreakpointCollection::ParseLocalBreakpoints(&input, &breakpoints),
+            S_OK);
+  ASSERT_EQ(breakpoints.size(), 1);
+  EXPECT_EQ(breakpoints[0].location().path(), "C:\\app\\Program.cs");
+  EXPECT_EQ(breakpoints[0].location().line(), 12);
+}
+
+// Tests that empty lines and comments are skipped.
+TEST(BreakpointCollectionTest, ParseLocalSkipsComments) {
+  std::istringstream input("# Hot loop.\n\nLoop.cs:3\n# Done.\nLoop.cs:9\n");
+  vector<Breakpoint> breakpoints;
+  EXPECT_EQ(BreakpointCollection::ParseLocalBreakpoints(&input, &breakpoints),
+            S_OK);
+  ASSERT_EQ(breakpoints.size(), 2);
+  EXPECT_EQ(breakpoints[0].location().line(), 3);
+  EXPECT_EQ(breakpoints[1].id(), "local-2");
+  EXPECT_EQ(breakpoints[1].location().line(), 9);
+}
+
+// Tests that lines without a valid line number are rejected.
+TEST(BreakpointCollectionTest, ParseLocalInvalidLines) {
+  vector<string> invalid_lines = {"Program.cs", "Program.cs:", ":42",
+                                  "Program.cs:4x2", "Program.cs:0"};
+  for (const string &invalid_line : invalid_lines) {
+    std::istringstream input(invalid_line);
+    vector<Breakpoint> breakpoints;
+    EXPECT_EQ(
+        BreakpointCollection::ParseLocalBreakpoints(&input, &breakpoints),
+        E_INVALIDARG)
+        << invalid_line;
+  }
+}
+
+// Tests that null arguments are rejected.
+TEST(BreakpointCollectionTest, ParseLocalNullArguments) {
+  std::istringstream input("Program.cs:42");
+  vector<Breakpoint> breakpoints;
+  EXPECT_EQ(BreakpointCollection::ParseLocalBreakpoints(nullptr, &breakpoints),
+            E_INVALIDARG);
+  EXPECT_EQ(BreakpointCollection::ParseLocalBreakpoints(&input, nullptr),
+            E_INVALIDARG);
+}
+
+}  // namespace google_cloud_debugger_test
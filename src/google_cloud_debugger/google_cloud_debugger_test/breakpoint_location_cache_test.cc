@@ -0,0 +1,95 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "breakpoint_location_cache.h"
+
+using google_cloud_debugger::BreakpointLocationCache;
+using google_cloud_debugger::CachedBreakpointLocation;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for BreakpointLocationCache.
+class BreakpointLocationCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    location_.pdb_id.fill(0xAB);
+    location_.file_path = "/app/program.cs";
+    location_.line = 11;
+    location_.method_def = 0x06000001;
+    location_.il_offset = 4;
+    location_.resolved_line = 12;
+  }
+
+  virtual void TearDown() { std::remove(cache_file_.c_str()); }
+
+  string cache_file_ = "breakpoint_location_cache_test.cache";
+  CachedBreakpointLocation location_;
+};
+
+// Tests the path of the cache file.
+TEST_F(BreakpointLocationCacheTest, GetCacheFilePath) {
+  EXPECT_EQ(BreakpointLocationCache::GetCacheFilePath("/tmp"),
+            "/tmp/breakpoint_locations.cache");
+  EXPECT_EQ(BreakpointLocationCache::GetCacheFilePath("/tmp/"),
+            "/tmp/breakpoint_locations.cache");
+}
+
+// Tests that the locations written to a file are read back.
+TEST_F(BreakpointLocationCacheTest, RoundTrip) {
+  BreakpointLocationCache cache;
+  EXPECT_TRUE(cache.Set("bp1", location_));
+  EXPECT_FALSE(cache.Set("bp1", location_));
+  ASSERT_TRUE(cache.Write(cache_file_));
+
+  BreakpointLocationCache result;
+  ASSERT_TRUE(result.Read(cache_file_));
+  const CachedBreakpointLocation *location = result.Find("bp1");
+  ASSERT_NE(location, nullptr);
+  EXPECT_EQ(location->pdb_id, location_.pdb_id);
+  EXPECT_EQ(location->file_path, location_.file_path);
+  EXPECT_EQ(location->line, location_.line);
+  EXPECT_EQ(location->method_def, location_.method_def);
+  EXPECT_EQ(location->il_offset, location_.il_offset);
+  EXPECT_EQ(location->resolved_line, location_.resolved_line);
+  EXPECT_EQ(result.Find("bp2"), nullptr);
+
+  // The file is replaced when the cache changes.
+  EXPECT_TRUE(result.Remove("bp1"));
+  EXPECT_FALSE(result.Remove("bp1"));
+  ASSERT_TRUE(result.Write(cache_file_));
+  ASSERT_TRUE(cache.Read(cache_file_));
+  EXPECT_EQ(cache.Find("bp1"), nullptr);
+}
+
+// Tests that a file that is not a cache file is ignored.
+TEST_F(BreakpointLocationCacheTest, InvalidFile) {
+  {
+    std::ofstream output(cache_file_, std::ios::out | std::ios::binary);
+    output << "not a cache file";
+  }
+
+  BreakpointLocationCache cache;
+  cache.Set("bp1", location_);
+  EXPECT_FALSE(cache.Read(cache_file_));
+  EXPECT_EQ(cache.Find("bp1"), nullptr);
+  EXPECT_FALSE(cache.Read("missing_breakpoint_location_cache_test.cache"));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,116 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "breakpoint_location_collection.h"
+#include "dbg_breakpoint.h"
+#include "i_cor_debug_mocks.h"
+
+using google::cloud::diagnostics::debug::Breakpoint_LogLevel;
+using google_cloud_debugger::BreakpointLocationCollection;
+using google_cloud_debugger::DbgBreakpoint;
+using std::string;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for BreakpointLocationCollection. Sets up a collection
+// with a first breakpoint whose ICorDebugBreakpoint is mocked.
+class BreakpointLocationCollectionTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    std::shared_ptr<DbgBreakpoint> first_breakpoint(new DbgBreakpoint());
+    InitializeBreakpoint("bp1", true, first_breakpoint.get());
+    first_breakpoint->SetCorDebugBreakpoint(&cordebug_breakpoint_);
+    ASSERT_EQ(collection_.AddFirstBreakpoint(std::move(first_breakpoint)),
+              S_OK);
+  }
+
+  void InitializeBreakpoint(const string &id, bool activated,
+                            DbgBreakpoint *breakpoint) {
+    breakpoint->Initialize("Program.cs", id, 10, 0, false, "",
+                           Breakpoint_LogLevel::Breakpoint_LogLevel_INFO, "",
+                           {});
+    breakpoint->SetActivated(activated);
+  }
+
+  // Expects the ICorDebugBreakpoint to be in state active and to be
+  // switched to the other state.
+  void ExpectActivate(BOOL active) {
+    EXPECT_CALL(cordebug_breakpoint_, IsActive(_))
+        .WillOnce(DoAll(SetArgPointee<0>(active), Return(S_OK)));
+    EXPECT_CALL(cordebug_breakpoint_, Activate(!active))
+        .WillOnce(Return(S_OK));
+  }
+
+  HRESULT Update(const string &id, bool activated) {
+    DbgBreakpoint breakpoint;
+    InitializeBreakpoint(id, activated, &breakpoint);
+    return collection_.UpdateBreakpoints(breakpoint);
+  }
+
+  ICorDebugBreakpointMock cordebug_breakpoint_;
+  BreakpointLocationCollection collection_;
+};
+
+// Tests that the ICorDebugBreakpoint is deactivated with the last
+// breakpoint at the location.
+TEST_F(BreakpointLocationCollectionTest, DeactivatesLastBreakpoint) {
+  std::chrono::steady_clock::time_point before =
+      std::chrono::steady_clock::now();
+  EXPECT_EQ(Update("bp2", true), S_OK);
+  EXPECT_EQ(collection_.GetBreakpoints().size(), 2);
+
+  // Another breakpoint is still active.
+  EXPECT_CALL(cordebug_breakpoint_, IsActive(_))
+      .WillOnce(DoAll(SetArgPointee<0>(TRUE), Return(S_OK)));
+  EXPECT_CALL(cordebug_breakpoint_, Activate(_)).Times(0);
+  EXPECT_EQ(Update("bp1", false), S_OK);
+  EXPECT_EQ(collection_.GetBreakpoints().size(), 1);
+  EXPECT_FALSE(collection_.DeactivatedBefore(
+      std::chrono::steady_clock::now() + std::chrono::hours(1)));
+
+  ::testing::Mock::VerifyAndClearExpectations(&cordebug_breakpoint_);
+  ExpectActivate(TRUE);
+  EXPECT_EQ(Update("bp2", false), S_OK);
+  EXPECT_TRUE(collection_.GetBreakpoints().empty());
+  EXPECT_TRUE(collection_.DeactivatedBefore(
+      std::chrono::steady_clock::now() + std::chrono::hours(1)));
+  EXPECT_FALSE(collection_.DeactivatedBefore(before));
+}
+
+// Tests that a breakpoint set again at the location reactivates the
+// ICorDebugBreakpoint the location kept.
+TEST_F(BreakpointLocationCollectionTest, ReactivatesBreakpoint) {
+  ExpectActivate(TRUE);
+  EXPECT_EQ(Update("bp1", false), S_OK);
+
+  ::testing::Mock::VerifyAndClearExpectations(&cordebug_breakpoint_);
+  ExpectActivate(FALSE);
+  EXPECT_EQ(Update("bp1", true), S_OK);
+  ASSERT_EQ(collection_.GetBreakpoints().size(), 1);
+  EXPECT_TRUE(collection_.GetBreakpoints()[0]->Activated());
+  EXPECT_FALSE(collection_.DeactivatedBefore(
+      std::chrono::steady_clock::now() + std::chrono::hours(1)));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,81 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+#include "breakpoint_pool.h"
+#include "constants.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::StackFrame;
+using google_cloud_debugger::BreakpointPool;
+using google_cloud_debugger::kMaximumPooledBreakpointSize;
+using std::string;
+using std::unique_ptr;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a released breakpoint is cleared and acquired again
+// with the memory of its stack frames.
+TEST(BreakpointPoolTest, ReusesReleasedBreakpoint) {
+  BreakpointPool pool(2);
+  unique_ptr<Breakpoint> breakpoint = pool.Acquire();
+  ASSERT_TRUE(breakpoint != nullptr);
+  breakpoint->set_id("id");
+  StackFrame *stack_frame = breakpoint->add_stack_frames();
+  stack_frame->set_method_name("Main");
+  Breakpoint *released = breakpoint.get();
+
+  pool.Release(std::move(breakpoint));
+  EXPECT_EQ(pool.GetSize(), 1);
+
+  breakpoint = pool.Acquire();
+  EXPECT_EQ(breakpoint.get(), released);
+  EXPECT_EQ(pool.GetSize(), 0);
+  EXPECT_TRUE(breakpoint->id().empty());
+  EXPECT_EQ(breakpoint->stack_frames_size(), 0);
+  EXPECT_EQ(breakpoint->add_stack_frames(), stack_frame);
+  EXPECT_TRUE(stack_frame->method_name().empty());
+}
+
+// Tests that the pool keeps at most its capacity of breakpoints.
+TEST(BreakpointPoolTest, Capacity) {
+  BreakpointPool pool(1);
+  unique_ptr<Breakpoint> first = pool.Acquire();
+  unique_ptr<Breakpoint> second = pool.Acquire();
+  ASSERT_TRUE(first != nullptr);
+  ASSERT_TRUE(second != nullptr);
+  EXPECT_NE(first.get(), second.get());
+
+  pool.Release(std::move(first));
+  pool.Release(std::move(second));
+  pool.Release(nullptr);
+  EXPECT_EQ(pool.GetSize(), 1);
+}
+
+// Tests that a large breakpoint is not kept.
+TEST(BreakpointPoolTest, LargeBreakpoint) {
+  BreakpointPool pool(1);
+  unique_ptr<Breakpoint> breakpoint = pool.Acquire();
+  ASSERT_TRUE(breakpoint != nullptr);
+  breakpoint->set_log_message_format(
+      string(kMaximumPooledBreakpointSize, 'a'));
+
+  pool.Release(std::move(breakpoint));
+  EXPECT_EQ(pool.GetSize(), 0);
+}
+
+}  // namespace google_cloud_debugger_test
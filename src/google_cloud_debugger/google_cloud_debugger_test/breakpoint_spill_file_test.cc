@@ -0,0 +1,102 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+#include "breakpoint_spill_file.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google_cloud_debugger::BreakpointSpillFile;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for BreakpointSpillFile.
+class BreakpointSpillFileTest : public ::testing::Test {
+ protected:
+  virtual void TearDown() { std::remove(spill_file_.c_str()); }
+
+  // Returns a breakpoint with the given id.
+  static Breakpoint CreateBreakpoint(const string &id) {
+    Breakpoint breakpoint;
+    breakpoint.set_id(id);
+    return breakpoint;
+  }
+
+  // Reads the next breakpoint of spill and returns its id, or "none" if
+  // it cannot be read.
+  static string ReadNextId(BreakpointSpillFile *spill) {
+    Breakpoint breakpoint;
+    if (!spill->ReadNext(&breakpoint)) {
+      return "none";
+    }
+    return breakpoint.id();
+  }
+
+  string spill_file_ = "breakpoint_spill_file_test.spill";
+};
+
+// Tests that breakpoints are read back in the order they were appended,
+// also when appends and reads alternate.
+TEST_F(BreakpointSpillFileTest, FirstInFirstOut) {
+  BreakpointSpillFile spill;
+  ASSERT_TRUE(spill.Open(spill_file_, 1024));
+  EXPECT_TRUE(spill.Empty());
+  EXPECT_EQ(ReadNextId(&spill), "none");
+
+  EXPECT_TRUE(spill.Append(CreateBreakpoint("first")));
+  EXPECT_TRUE(spill.Append(CreateBreakpoint("second")));
+  EXPECT_FALSE(spill.Empty());
+  EXPECT_EQ(ReadNextId(&spill), "first");
+  EXPECT_TRUE(spill.Append(CreateBreakpoint("third")));
+  EXPECT_EQ(ReadNextId(&spill), "second");
+  EXPECT_EQ(ReadNextId(&spill), "third");
+  EXPECT_TRUE(spill.Empty());
+  EXPECT_EQ(spill.GetSize(), 0);
+}
+
+// Tests that appends fail once the file holds capacity bytes and that
+// the file is reused once drained.
+TEST_F(BreakpointSpillFileTest, BoundedBySize) {
+  Breakpoint breakpoint = CreateBreakpoint("spilled");
+  std::uint64_t size = 4 + breakpoint.ByteSizeLong();
+  BreakpointSpillFile spill;
+  ASSERT_TRUE(spill.Open(spill_file_, 2 * size + 1));
+
+  EXPECT_TRUE(spill.Append(breakpoint));
+  EXPECT_TRUE(spill.Append(breakpoint));
+  EXPECT_EQ(spill.GetSize(), 2 * size);
+  EXPECT_FALSE(spill.Append(breakpoint));
+
+  // Space is only reclaimed once every breakpoint is read.
+  EXPECT_EQ(ReadNextId(&spill), "spilled");
+  EXPECT_FALSE(spill.Append(breakpoint));
+  EXPECT_EQ(ReadNextId(&spill), "spilled");
+  EXPECT_TRUE(spill.Append(breakpoint));
+  EXPECT_TRUE(spill.Append(breakpoint));
+  EXPECT_EQ(ReadNextId(&spill), "spilled");
+  EXPECT_EQ(ReadNextId(&spill), "spilled");
+  EXPECT_TRUE(spill.Empty());
+}
+
+// Tests that a spill file that cannot be created is reported.
+TEST_F(BreakpointSpillFileTest, OpenFails) {
+  BreakpointSpillFile spill;
+  EXPECT_FALSE(spill.Open("no_such_directory/spill", 1024));
+  EXPECT_FALSE(spill.Append(CreateBreakpoint("spilled")));
+}
+
+}  // namespace google_cloud_debugger_test
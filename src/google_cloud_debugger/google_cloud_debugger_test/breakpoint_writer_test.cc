@@ -0,0 +1,288 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpoint_writer.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google_cloud_debugger::BreakpointWriteOverflow;
+using google_cloud_debugger::BreakpointWriter;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Returns a breakpoint with the given id.
+Breakpoint CreateBreakpoint(const string &id, bool log_point = false) {
+  Breakpoint breakpoint;
+  breakpoint.set_id(id);
+  breakpoint.set_log_point(log_point);
+  return breakpoint;
+}
+
+// Records the batches written by a BreakpointWriter. If blocked, the first
+// write waits until Release is called.
+class BatchRecorder {
+ public:
+  explicit BatchRecorder(bool blocked = false) {
+    if (!blocked) {
+      release_.set_value();
+    }
+  }
+
+  BreakpointWriter::WriteFunction GetWriteFunction() {
+    return [this](const vector<Breakpoint> &breakpoints) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!first_write_started_) {
+          first_write_started_ = true;
+          started_.set_value();
+        }
+      }
+      release_future_.wait();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      vector<string> ids;
+      for (const Breakpoint &breakpoint : breakpoints) {
+        ids.push_back(breakpoint.id());
+      }
+      batches_.push_back(ids);
+      return result_;
+    };
+  }
+
+  // Waits until the first write starts.
+  void WaitForFirstWrite() { started_.get_future().wait(); }
+
+  // Lets the writes continue.
+  void Release() { release_.set_value(); }
+
+  // Returns the ids of the breakpoints of every batch written.
+  vector<vector<string>> GetBatches() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+  }
+
+  // Returns the ids of all the breakpoints written.
+  vector<string> GetIds() {
+    vector<string> ids;
+    for (const vector<string> &batch : GetBatches()) {
+      ids.insert(ids.end(), batch.begin(), batch.end());
+    }
+    return ids;
+  }
+
+  // What the write function returns.
+  HRESULT result_ = S_OK;
+
+ private:
+  std::mutex mutex_;
+  bool first_write_started_ = false;
+  std::promise<void> started_;
+  std::promise<void> release_;
+  std::shared_future<void> release_future_ = release_.get_future().share();
+  vector<vector<string>> batches_;
+};
+
+// Tests that every queued breakpoint is written, in order, before
+// Stop returns.
+TEST(BreakpointWriterTest, WritesInOrder) {
+  BatchRecorder recorder;
+  BreakpointWriter writer(recorder.GetWriteFunction(), 100,
+                          BreakpointWriteOverflow::kBlock);
+
+  vector<string> expected_ids;
+  for (int i = 0; i < 50; ++i) {
+    expected_ids.push_back(std::to_string(i));
+    EXPECT_EQ(writer.Enqueue(CreateBreakpoint(expected_ids.back())), S_OK);
+  }
+  writer.Stop();
+
+  EXPECT_EQ(recorder.GetIds(), expected_ids);
+  EXPECT_EQ(writer.GetWrittenCount(), 50);
+  EXPECT_EQ(writer.GetDroppedCount(), 0);
+  EXPECT_EQ(writer.GetFailedCount(), 0);
+}
+
+// Tests that a swapped breakpoint is written and that the breakpoint it
+// was swapped from is left empty.
+TEST(BreakpointWriterTest, EnqueueSwapped) {
+  BatchRecorder recorder;
+  BreakpointWriter writer(recorder.GetWriteFunction(), 10,
+                          BreakpointWriteOverflow::kBlock);
+
+  Breakpoint breakpoint = CreateBreakpoint("swapped");
+  EXPECT_EQ(writer.EnqueueSwapped(&breakpoint), S_OK);
+  EXPECT_TRUE(breakpoint.id().empty());
+  EXPECT_EQ(writer.EnqueueSwapped(nullptr), E_INVALIDARG);
+  writer.Stop();
+
+  EXPECT_EQ(recorder.GetIds(), vector<string>{"swapped"});
+  EXPECT_EQ(writer.GetWrittenCount(), 1);
+}
+
+// Tests that the breakpoints queued during a write are written together.
+TEST(BreakpointWriterTest, CoalescesWrites) {
+  BatchRecorder recorder(true);
+  BreakpointWriter writer(recorder.GetWriteFunction(), 100,
+                          BreakpointWriteOverflow::kBlock);
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("first")), S_OK);
+  recorder.WaitForFirstWrite();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(writer.Enqueue(CreateBreakpoint(std::to_string(i))), S_OK);
+  }
+  recorder.Release();
+  writer.Stop();
+
+  vector<vector<string>> batches = recorder.GetBatches();
+  ASSERT_EQ(batches.size(), 2);
+  EXPECT_EQ(batches[0], vector<string>({"first"}));
+  EXPECT_EQ(batches[1].size(), 10);
+  EXPECT_EQ(writer.GetBatchCount(), 2);
+  EXPECT_EQ(writer.GetWrittenCount(), 11);
+}
+
+// Tests that log points are dropped when the queue is full and the
+// overflow policy allows it, while other breakpoints wait for room.
+TEST(BreakpointWriterTest, DropsLogPointsWhenFull) {
+  BatchRecorder recorder(true);
+  BreakpointWriter writer(recorder.GetWriteFunction(), 1,
+                          BreakpointWriteOverflow::kDropLogPoints);
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("first")), S_OK);
+  recorder.WaitForFirstWrite();
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("queued")), S_OK);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("log", true)), S_FALSE);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("log", true)), S_FALSE);
+  EXPECT_EQ(writer.GetDroppedCount(), 2);
+
+  std::future<HRESULT> snapshot = std::async(std::launch::async, [&writer]() {
+    return writer.Enqueue(CreateBreakpoint("snapshot"));
+  });
+  recorder.Release();
+  EXPECT_EQ(snapshot.get(), S_OK);
+  writer.Stop();
+
+  EXPECT_EQ(recorder.GetIds(),
+            vector<string>({"first", "queued", "snapshot"}));
+  EXPECT_EQ(writer.GetWrittenCount(), 3);
+}
+
+// Tests that log points are not dropped with the blocking policy.
+TEST(BreakpointWriterTest, BlocksWhenFull) {
+  BatchRecorder recorder(true);
+  BreakpointWriter writer(recorder.GetWriteFunction(), 1,
+                          BreakpointWriteOverflow::kBlock);
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("first")), S_OK);
+  recorder.WaitForFirstWrite();
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("queued")), S_OK);
+
+  std::future<HRESULT> log_point = std::async(std::launch::async, [&writer]() {
+    return writer.Enqueue(CreateBreakpoint("log", true));
+  });
+  recorder.Release();
+  EXPECT_EQ(log_point.get(), S_OK);
+  writer.Stop();
+
+  EXPECT_EQ(recorder.GetIds(), vector<string>({"first", "queued", "log"}));
+  EXPECT_EQ(writer.GetDroppedCount(), 0);
+}
+
+// Tests that breakpoints are spilled to the file while the queue is full,
+// that the next ones are spilled too until it is drained and that all of
+// them are written in order.
+TEST(BreakpointWriterTest, SpillsWhenFull) {
+  string spill_file = "breakpoint_writer_test.spill";
+  BatchRecorder recorder(true);
+  BreakpointWriter writer(recorder.GetWriteFunction(), 1,
+                          BreakpointWriteOverflow::kBlock);
+  ASSERT_TRUE(writer.SetSpillFile(spill_file, 1024));
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("first")), S_OK);
+  recorder.WaitForFirstWrite();
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("queued")), S_OK);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("log", true)), S_OK);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("snapshot")), S_OK);
+  EXPECT_EQ(writer.GetSpilledCount(), 2);
+  recorder.Release();
+  writer.Stop();
+  std::remove(spill_file.c_str());
+
+  EXPECT_EQ(recorder.GetIds(),
+            vector<string>({"first", "queued", "log", "snapshot"}));
+  EXPECT_EQ(writer.GetWrittenCount(), 4);
+  EXPECT_EQ(writer.GetDroppedCount(), 0);
+}
+
+// Tests that the overflow policy applies once the spill file is full.
+TEST(BreakpointWriterTest, DropsLogPointsWhenSpillFileFull) {
+  string spill_file = "breakpoint_writer_test.spill";
+  BatchRecorder recorder(true);
+  BreakpointWriter writer(recorder.GetWriteFunction(), 1,
+                          BreakpointWriteOverflow::kDropLogPoints);
+  ASSERT_TRUE(writer.SetSpillFile(
+      spill_file, 4 + CreateBreakpoint("spilled").ByteSizeLong()));
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("first")), S_OK);
+  recorder.WaitForFirstWrite();
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("queued")), S_OK);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("spilled")), S_OK);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("log", true)), S_FALSE);
+  recorder.Release();
+  writer.Stop();
+  std::remove(spill_file.c_str());
+
+  EXPECT_EQ(recorder.GetIds(),
+            vector<string>({"first", "queued", "spilled"}));
+  EXPECT_EQ(writer.GetSpilledCount(), 1);
+  EXPECT_EQ(writer.GetDroppedCount(), 1);
+}
+
+// Tests that failed writes are counted and do not stop the writer.
+TEST(BreakpointWriterTest, CountsFailedWrites) {
+  BatchRecorder recorder;
+  recorder.result_ = E_FAIL;
+  BreakpointWriter writer(recorder.GetWriteFunction(), 10,
+                          BreakpointWriteOverflow::kBlock);
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("first")), S_OK);
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("second")), S_OK);
+  writer.Stop();
+
+  EXPECT_EQ(recorder.GetIds(), vector<string>({"first", "second"}));
+  EXPECT_EQ(writer.GetFailedCount(), 2);
+  EXPECT_EQ(writer.GetWrittenCount(), 0);
+}
+
+// Tests that a stopped writer rejects breakpoints.
+TEST(BreakpointWriterTest, RejectsAfterStop) {
+  BatchRecorder recorder;
+  BreakpointWriter writer(recorder.GetWriteFunction(), 10,
+                          BreakpointWriteOverflow::kBlock);
+  writer.Stop();
+
+  EXPECT_EQ(writer.Enqueue(CreateBreakpoint("late")), E_ABORT);
+  EXPECT_TRUE(recorder.GetIds().empty());
+}
+
+}  // namespace google_cloud_debugger_test
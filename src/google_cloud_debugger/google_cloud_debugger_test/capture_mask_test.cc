@@ -0,0 +1,79 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "capture_mask.h"
+
+using google_cloud_debugger::CaptureMask;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Tests that paths are split into the names of the members on them.
+TEST(CaptureMaskTest, ParsePaths) {
+  CaptureMask mask;
+  ASSERT_TRUE(CaptureMask::Parse("request.Headers:2, order.Items[0].Price",
+                                 &mask));
+  EXPECT_FALSE(mask.IsEmpty());
+  EXPECT_EQ(mask.GetMember("Headers"), nullptr);
+
+  const CaptureMask *request = mask.GetMember("request");
+  ASSERT_NE(request, nullptr);
+  EXPECT_FALSE(request->IsTarget());
+  const CaptureMask *headers = request->GetMember("Headers");
+  ASSERT_NE(headers, nullptr);
+  EXPECT_TRUE(headers->IsTarget());
+  EXPECT_EQ(headers->GetDepth(), 2);
+
+  const CaptureMask *order = mask.GetMember("order");
+  ASSERT_NE(order, nullptr);
+  const CaptureMask *items = order->GetMember("Items");
+  ASSERT_NE(items, nullptr);
+  const CaptureMask *item = items->GetMember("[0]");
+  ASSERT_NE(item, nullptr);
+  EXPECT_FALSE(item->IsTarget());
+  const CaptureMask *price = item->GetMember("Price");
+  ASSERT_NE(price, nullptr);
+  EXPECT_TRUE(price->IsTarget());
+  EXPECT_EQ(price->GetDepth(), 0);
+}
+
+// Tests that the deeper of two paths to the same member wins.
+TEST(CaptureMaskTest, SamePath) {
+  CaptureMask mask;
+  ASSERT_TRUE(CaptureMask::Parse("a.b:2,a.b:3,a.b:1,a", &mask));
+  const CaptureMask *a = mask.GetMember("a");
+  ASSERT_NE(a, nullptr);
+  EXPECT_TRUE(a->IsTarget());
+  const CaptureMask *b = a->GetMember("b");
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(b->GetDepth(), 3);
+
+  ASSERT_TRUE(CaptureMask::Parse("a.b", &mask));
+  EXPECT_EQ(b->GetDepth(), 0);
+}
+
+// Tests that invalid paths are rejected.
+TEST(CaptureMaskTest, InvalidPaths) {
+  for (const char *paths :
+       {"", "a,", "a..b", "a.", ".a", "a[", "a[]", "a:", "a:0", "a:x",
+        "a:-1", "a.b:12345"}) {
+    CaptureMask mask;
+    EXPECT_FALSE(CaptureMask::Parse(paths, &mask)) << paths;
+  }
+}
+
+}  // namespace google_cloud_debugger_test
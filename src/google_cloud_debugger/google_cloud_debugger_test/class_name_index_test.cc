@@ -0,0 +1,136 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+#include "class_name_index.h"
+#include "i_cor_debug_helper_mock.h"
+#include "i_metadata_import_mock.h"
+#include "i_portable_pdb_mocks.h"
+#include "module_type_dictionary.h"
+
+using google_cloud_debugger::ClassNameIndex;
+using google_cloud_debugger::ModuleTypeDictionary;
+using google_cloud_debugger_portable_pdb::IPortablePdbFile;
+using std::shared_ptr;
+using std::string;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::ReturnRef;
+using ::testing::SetArgPointee;
+using ::testing::SetArrayArgument;
+
+namespace google_cloud_debugger_test {
+
+// A module whose metadata defines a single type.
+class ClassNameIndexModule {
+ public:
+  ClassNameIndexModule(ICorDebugHelperMock *debug_helper,
+                       const string &module_name, const string &type_name,
+                       mdTypeDef type_def)
+      : module_name_(module_name),
+        type_def_(type_def),
+        dictionary_(std::make_shared<ModuleTypeDictionary>()),
+        pdb_mock_(new IPortablePdbFileMock()),
+        pdb_file_(pdb_mock_) {
+    ON_CALL(metadata_import_, AddRef()).WillByDefault(Return(S_OK));
+    ON_CALL(metadata_import_, Release()).WillByDefault(Return(S_OK));
+    EXPECT_CALL(metadata_import_, EnumTypeDefs(_, _, _, _))
+        .WillOnce(DoAll(SetArrayArgument<1>(&type_def_, &type_def_ + 1),
+                        SetArgPointee<3>(1), Return(S_OK)))
+        .WillOnce(DoAll(SetArgPointee<3>(0), Return(S_FALSE)));
+    EXPECT_CALL(metadata_import_, EnumTypeRefs(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<3>(0), Return(S_FALSE)));
+    EXPECT_CALL(*debug_helper, GetTypeNameFromMdTypeDef(type_def_, _, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(type_name), Return(S_OK)));
+
+    ON_CALL(*pdb_mock_, GetTypeDictionary())
+        .WillByDefault(Return(dictionary_));
+    ON_CALL(*pdb_mock_, GetMetaDataImport(_))
+        .WillByDefault(
+            DoAll(SetArgPointee<0>(&metadata_import_), Return(S_OK)));
+    ON_CALL(*pdb_mock_, GetModuleName()).WillByDefault(ReturnRef(module_name_));
+  }
+
+  string module_name_;
+  mdTypeDef type_def_;
+  IMetaDataImportMock metadata_import_;
+  shared_ptr<ModuleTypeDictionary> dictionary_;
+  IPortablePdbFileMock *pdb_mock_;
+  shared_ptr<IPortablePdbFile> pdb_file_;
+};
+
+// Tests that the types of the added modules are found and that the
+// module loaded first wins.
+TEST(ClassNameIndexTest, FindTypeDef) {
+  ICorDebugHelperMock debug_helper;
+  ClassNameIndexModule first(&debug_helper, "First.dll", "App.Shared", 10);
+  ClassNameIndexModule second(&debug_helper, "Second.dll", "App.Shared", 20);
+  ClassNameIndexModule third(&debug_helper, "Third.dll", "App.Other", 30);
+
+  ClassNameIndex index;
+  index.AddModule(first.pdb_file_);
+  index.AddModule(second.pdb_file_);
+  index.AddModule(third.pdb_file_);
+
+  shared_ptr<IPortablePdbFile> pdb_file;
+  mdTypeDef type_def = 0;
+  EXPECT_EQ(index.FindTypeDef("App.Shared", &debug_helper, &pdb_file,
+                              &type_def),
+            S_OK);
+  EXPECT_EQ(pdb_file, first.pdb_file_);
+  EXPECT_EQ(type_def, 10);
+
+  EXPECT_EQ(index.FindTypeDef("App.Other", &debug_helper, &pdb_file,
+                              &type_def),
+            S_OK);
+  EXPECT_EQ(pdb_file, third.pdb_file_);
+  EXPECT_EQ(type_def, 30);
+
+  EXPECT_EQ(index.FindTypeDef("App.Missing", &debug_helper, &pdb_file,
+                              &type_def),
+            S_FALSE);
+}
+
+// Tests that removing a module makes the types it shadowed visible and
+// does not enumerate the remaining modules again.
+TEST(ClassNameIndexTest, RemoveModule) {
+  ICorDebugHelperMock debug_helper;
+  ClassNameIndexModule first(&debug_helper, "First.dll", "App.Shared", 10);
+  ClassNameIndexModule second(&debug_helper, "Second.dll", "App.Shared", 20);
+
+  ClassNameIndex index;
+  index.AddModule(first.pdb_file_);
+  index.AddModule(second.pdb_file_);
+
+  shared_ptr<IPortablePdbFile> pdb_file;
+  mdTypeDef type_def = 0;
+  EXPECT_EQ(index.FindTypeDef("App.Shared", &debug_helper, &pdb_file,
+                              &type_def),
+            S_OK);
+  EXPECT_EQ(pdb_file, first.pdb_file_);
+
+  index.RemoveModule(first.pdb_file_);
+  EXPECT_EQ(index.FindTypeDef("App.Shared", &debug_helper, &pdb_file,
+                              &type_def),
+            S_OK);
+  EXPECT_EQ(pdb_file, second.pdb_file_);
+  EXPECT_EQ(type_def, 20);
+}
+
+}  // namespace google_cloud_debugger_test
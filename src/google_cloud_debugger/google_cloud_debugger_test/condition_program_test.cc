@@ -0,0 +1,262 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "binary_expression_evaluator.h"
+#include "common_fixtures.h"
+#include "condition_program.h"
+#include "dbg_string.h"
+#include "i_dbg_stack_frame_mock.h"
+#include "identifier_evaluator.h"
+#include "unary_expression_evaluator.h"
+
+using google_cloud_debugger::BinaryCSharpExpression;
+using google_cloud_debugger::BinaryExpressionEvaluator;
+using google_cloud_debugger::ConditionProgram;
+using google_cloud_debugger::DbgObject;
+using google_cloud_debugger::DbgPrimitive;
+using google_cloud_debugger::DbgString;
+using google_cloud_debugger::ExpressionEvaluator;
+using google_cloud_debugger::IdentifierEvaluator;
+using google_cloud_debugger::LiteralEvaluator;
+using google_cloud_debugger::UnaryCSharpExpression;
+using google_cloud_debugger::UnaryExpressionEvaluator;
+using google_cloud_debugger::VariableSlot;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for ConditionProgram.
+class ConditionProgramTest : public NumericalEvaluatorTestFixture {
+ protected:
+  // Sets up the stack frame mock to return value for local variable name.
+  void SetUpLocalVariable(const string &name, shared_ptr<DbgObject> value) {
+    EXPECT_CALL(stack_mock_, GetLocalVariable(name, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<1>(value), Return(S_OK)));
+  }
+
+  // Compiles evaluator and lowers it into program_. Returns false if
+  // the evaluator cannot be lowered.
+  bool CompileAndLower(ExpressionEvaluator *evaluator) {
+    EXPECT_EQ(evaluator->Compile(&stack_mock_, nullptr, &err_stream_), S_OK);
+    return evaluator->Lower(&program_,
+                            CorElementType::ELEMENT_TYPE_BOOLEAN,
+                            program_.AllocateRegister());
+  }
+
+  // Returns an evaluator for identifier name.
+  unique_ptr<ExpressionEvaluator> Identifier(const string &name) {
+    return unique_ptr<ExpressionEvaluator>(new IdentifierEvaluator(name));
+  }
+
+  // Returns an evaluator for literal value.
+  unique_ptr<ExpressionEvaluator> Literal(shared_ptr<DbgObject> value) {
+    return unique_ptr<ExpressionEvaluator>(new LiteralEvaluator(value));
+  }
+
+  // Returns an evaluator for binary expression first op second.
+  unique_ptr<ExpressionEvaluator> Binary(
+      BinaryCSharpExpression::Type op, unique_ptr<ExpressionEvaluator> first,
+      unique_ptr<ExpressionEvaluator> second) {
+    return unique_ptr<ExpressionEvaluator>(new BinaryExpressionEvaluator(
+        op, std::move(first), std::move(second)));
+  }
+
+  // Mock of an IDbgStackFrame.
+  IDbgStackFrameMock stack_mock_;
+
+  // Program under test.
+  ConditionProgram program_;
+};
+
+// Tests a program emitted directly that compares a local variable
+// with a constant.
+TEST_F(ConditionProgramTest, EmitCompareVariable) {
+  SetUpLocalVariable("count", first_int_obj_);
+
+  int result_register = program_.AllocateRegister();
+  int operand_register = program_.AllocateRegister();
+  EXPECT_TRUE(program_.EmitVariable("count", CorElementType::ELEMENT_TYPE_I4,
+                                    CorElementType::ELEMENT_TYPE_I4,
+                                    result_register));
+  EXPECT_TRUE(program_.EmitConstant(second_int_obj_.get(),
+                                    CorElementType::ELEMENT_TYPE_I4,
+                                    operand_register));
+  EXPECT_TRUE(program_.EmitOperation(ConditionProgram::OpCode::kGt,
+                                     CorElementType::ELEMENT_TYPE_I4,
+                                     result_register, operand_register));
+
+  bool result = false;
+  EXPECT_EQ(program_.Run(&stack_mock_, &result), S_OK);
+  EXPECT_TRUE(result);
+}
+
+// Tests that a program whose variables have slots runs on the values read
+// straight from the frame.
+TEST_F(ConditionProgramTest, RunOnFrame) {
+  VariableSlot slot;
+  slot.kind = VariableSlot::Kind::kLocalVariable;
+  slot.index = 2;
+
+  int result_register = program_.AllocateRegister();
+  int operand_register = program_.AllocateRegister();
+  EXPECT_TRUE(program_.EmitVariable("count", CorElementType::ELEMENT_TYPE_I4,
+                                    CorElementType::ELEMENT_TYPE_I8,
+                                    result_register, slot));
+  EXPECT_TRUE(program_.EmitConstant(first_int_obj_.get(),
+                                    CorElementType::ELEMENT_TYPE_I8,
+                                    operand_register));
+  EXPECT_TRUE(program_.EmitOperation(ConditionProgram::OpCode::kEq,
+                                     CorElementType::ELEMENT_TYPE_I8,
+                                     result_register, operand_register));
+  EXPECT_TRUE(program_.CanRunOnFrame());
+
+  ICorDebugGenericValueMock generic_value;
+  SetUpMockGenericValue(&generic_value, first_int_obj_value_);
+  ULONG32 size = sizeof(int32_t);
+  EXPECT_CALL(generic_value, GetSize(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(size), Return(S_OK)));
+  ICorDebugILFrameMock il_frame;
+  EXPECT_CALL(il_frame, GetLocalVariable(2, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(&generic_value), Return(S_OK)));
+
+  bool result = false;
+  EXPECT_EQ(program_.RunOnFrame(&il_frame, &result), S_OK);
+  EXPECT_TRUE(result);
+
+  // A value of another type fails the program.
+  EXPECT_CALL(generic_value, GetType(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(CorElementType::ELEMENT_TYPE_I8),
+                            Return(S_OK)));
+  EXPECT_TRUE(FAILED(program_.RunOnFrame(&il_frame, &result)));
+}
+
+// Tests that a program reading a variable without a slot cannot run on
+// a frame.
+TEST_F(ConditionProgramTest, CannotRunOnFrameWithoutSlots) {
+  int result_register = program_.AllocateRegister();
+  EXPECT_TRUE(program_.EmitVariable("enabled",
+                                    CorElementType::ELEMENT_TYPE_BOOLEAN,
+                                    CorElementType::ELEMENT_TYPE_BOOLEAN,
+                                    result_register));
+  EXPECT_FALSE(program_.CanRunOnFrame());
+}
+
+// Tests registers cannot be allocated past kMaxRegisters.
+TEST_F(ConditionProgramTest, TooManyRegisters) {
+  for (int i = 0; i < ConditionProgram::kMaxRegisters; ++i) {
+    EXPECT_EQ(program_.AllocateRegister(), i);
+  }
+  EXPECT_EQ(program_.AllocateRegister(), -1);
+}
+
+// Tests "count * 2 == 20 && enabled" lowered from evaluators.
+TEST_F(ConditionProgramTest, LowerArithmeticAndConditional) {
+  SetUpLocalVariable("count", first_int_obj_);
+  SetUpLocalVariable("enabled", true_);
+
+  shared_ptr<DbgObject> two(new DbgPrimitive<int32_t>(2));
+  shared_ptr<DbgObject> twenty(new DbgPrimitive<int64_t>(20));
+  unique_ptr<ExpressionEvaluator> evaluator = Binary(
+      BinaryCSharpExpression::Type::conditional_and,
+      Binary(BinaryCSharpExpression::Type::eq,
+             Binary(BinaryCSharpExpression::Type::mul, Identifier("count"),
+                    Literal(two)),
+             Literal(twenty)),
+      Identifier("enabled"));
+  EXPECT_TRUE(CompileAndLower(evaluator.get()));
+
+  bool result = false;
+  EXPECT_EQ(program_.Run(&stack_mock_, &result), S_OK);
+  EXPECT_TRUE(result);
+
+  // The program reads the variables again on every run.
+  SetUpLocalVariable("enabled", false_);
+  EXPECT_EQ(program_.Run(&stack_mock_, &result), S_OK);
+  EXPECT_FALSE(result);
+}
+
+// Tests "count > 100 || !(count < 0)" lowered from evaluators.
+TEST_F(ConditionProgramTest, LowerConditionalOrAndNot) {
+  SetUpLocalVariable("count", first_negative_int_obj_);
+
+  shared_ptr<DbgObject> hundred(new DbgPrimitive<int32_t>(100));
+  unique_ptr<ExpressionEvaluator> negation(new UnaryExpressionEvaluator(
+      UnaryCSharpExpression::Type::logical_complement,
+      Binary(BinaryCSharpExpression::Type::lt, Identifier("count"),
+             Literal(zero_obj_))));
+  unique_ptr<ExpressionEvaluator> evaluator =
+      Binary(BinaryCSharpExpression::Type::conditional_or,
+             Binary(BinaryCSharpExpression::Type::gt, Identifier("count"),
+                    Literal(hundred)),
+             std::move(negation));
+  EXPECT_TRUE(CompileAndLower(evaluator.get()));
+
+  bool result = true;
+  EXPECT_EQ(program_.Run(&stack_mock_, &result), S_OK);
+  EXPECT_FALSE(result);
+}
+
+// Tests that the program fails, so that the evaluators can report the
+// error, when a division by zero happens.
+TEST_F(ConditionProgramTest, DivisionByZero) {
+  SetUpLocalVariable("count", zero_obj_);
+
+  unique_ptr<ExpressionEvaluator> evaluator =
+      Binary(BinaryCSharpExpression::Type::eq,
+             Binary(BinaryCSharpExpression::Type::div, Literal(first_int_obj_),
+                    Identifier("count")),
+             Literal(second_int_obj_));
+  EXPECT_TRUE(CompileAndLower(evaluator.get()));
+
+  bool result = false;
+  EXPECT_TRUE(FAILED(program_.Run(&stack_mock_, &result)));
+}
+
+// Tests that the program fails when a variable no longer has the type
+// the program was built for.
+TEST_F(ConditionProgramTest, VariableTypeChanged) {
+  SetUpLocalVariable("count", first_int_obj_);
+
+  unique_ptr<ExpressionEvaluator> evaluator =
+      Binary(BinaryCSharpExpression::Type::ne, Identifier("count"),
+             Literal(second_int_obj_));
+  EXPECT_TRUE(CompileAndLower(evaluator.get()));
+
+  SetUpLocalVariable("count", first_long_obj_);
+  bool result = false;
+  EXPECT_TRUE(FAILED(program_.Run(&stack_mock_, &result)));
+}
+
+// Tests that comparisons which are not numeric or boolean are not lowered.
+TEST_F(ConditionProgramTest, StringComparisonNotLowered) {
+  shared_ptr<DbgObject> first_string(new DbgString("first"));
+  shared_ptr<DbgObject> second_string(new DbgString("second"));
+
+  unique_ptr<ExpressionEvaluator> evaluator =
+      Binary(BinaryCSharpExpression::Type::eq, Literal(first_string),
+             Literal(second_string));
+  EXPECT_FALSE(CompileAndLower(evaluator.get()));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -26,6 +26,7 @@
 
 using google_cloud_debugger::CComPtr;
 using google_cloud_debugger::CorDebugHelper;
+using google_cloud_debugger::TypeSignature;
 using std::string;
 using std::vector;
 using ::testing::_;
@@ -190,4 +191,42 @@ TEST_F(CorDebugHelperTest, GetModuleNameFromICorDebugModuleError) {
   EXPECT_EQ(hr, E_FAIL);
 }
 
+// Tests that a type is only parsed from its signature once and that
+// the cached type still advances the signature.
+TEST_F(CorDebugHelperTest, ParseTypeFromSigCached) {
+  CorDebugHelper::ClearParsedTypeSignatures();
+
+  // A class whose encoded mdTypeDef has the row id 2.
+  COR_SIGNATURE signature[] = {ELEMENT_TYPE_CLASS, 0x08};
+  mdTypeDef class_token = TokenFromRid(2, mdtTypeDef);
+  vector<WCHAR> wchar_class_name =
+      google_cloud_debugger::ConvertStringToWCharPtr("App.Type");
+  uint32_t class_name_len = wchar_class_name.size();
+
+  EXPECT_CALL(metadata_import_,
+              GetTypeDefProps(class_token, nullptr, 0, _, _, _))
+      .Times(1)
+      .WillOnce(DoAll(SetArgPointee<3>(class_name_len), Return(S_OK)));
+  EXPECT_CALL(metadata_import_,
+              GetTypeDefProps(class_token, _, class_name_len, _, _, _))
+      .Times(1)
+      .WillOnce(
+          DoAll(SetArg1ToWcharArray(wchar_class_name.data(), class_name_len),
+                SetArgPointee<3>(class_name_len), Return(S_OK)));
+
+  for (int i = 0; i < 2; ++i) {
+    PCCOR_SIGNATURE sig = signature;
+    ULONG sig_len = sizeof(signature);
+    TypeSignature type_signature;
+    HRESULT hr = debug_helper_.ParseTypeFromSig(
+        &sig, &sig_len, &metadata_import_, {}, &type_signature);
+    EXPECT_EQ(hr, S_OK);
+    EXPECT_EQ(type_signature.type_name, "App.Type");
+    EXPECT_EQ(sig, signature + sizeof(signature));
+    EXPECT_EQ(sig_len, 0);
+  }
+
+  CorDebugHelper::RemoveParsedTypeSignatures(&metadata_import_);
+}
+
 }  // namespace google_cloud_debugger_test
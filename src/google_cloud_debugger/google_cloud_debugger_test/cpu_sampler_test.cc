@@ -0,0 +1,123 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "breakpoint.pb.h"
+#include "cpu_sampler.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::CpuPhase;
+using google_cloud_debugger::CpuSampler;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+namespace {
+
+// Returns the evaluated expression of breakpoint named name, or null.
+const Variable *FindVariable(const Breakpoint &breakpoint,
+                             const string &name) {
+  for (const Variable &variable : breakpoint.evaluated_expressions()) {
+    if (variable.name() == name) {
+      return &variable;
+    }
+  }
+  return nullptr;
+}
+
+// Returns the value of the member of variable named name, or -1.
+long long GetMemberValue(const Variable &variable, const string &name) {
+  for (const Variable &member : variable.members()) {
+    if (member.name() == name) {
+      return std::stoll(member.value());
+    }
+  }
+  return -1;
+}
+
+// Keeps the calling thread busy for duration.
+void Spin(std::chrono::milliseconds duration) {
+  std::chrono::steady_clock::time_point end =
+      std::chrono::steady_clock::now() + duration;
+  volatile std::uint64_t count = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    count = count + 1;
+  }
+}
+
+}  // namespace
+
+// Tests that phases are only tracked on registered threads and that a
+// phase restores the previous one when it ends.
+TEST(CpuSamplerTest, Phases) {
+  std::thread([]() {
+    EXPECT_EQ(nullptr, CpuSampler::SetPhase("Unregistered"));
+    EXPECT_EQ(nullptr, CpuSampler::SetPhase(nullptr));
+
+    CpuSampler::RegisterThread("phases_test");
+    {
+      CpuPhase outer("Outer");
+      {
+        CpuPhase inner("Inner");
+        EXPECT_STREQ("Inner", CpuSampler::SetPhase("Inner"));
+      }
+      EXPECT_STREQ("Outer", CpuSampler::SetPhase("Outer"));
+    }
+    EXPECT_EQ(nullptr, CpuSampler::SetPhase(nullptr));
+  }).join();
+}
+
+// Tests that nothing is reported before the sampler is started.
+TEST(CpuSamplerTest, NotStarted) {
+  CpuSampler sampler;
+  Breakpoint breakpoint;
+  sampler.AddToBreakpoint(&breakpoint);
+  EXPECT_EQ(0, breakpoint.evaluated_expressions_size());
+}
+
+// Tests that the CPU time of a thread is attributed to its role and to
+// the phase it is in, including after the thread exits.
+TEST(CpuSamplerTest, AttributesTime) {
+  CpuSampler sampler;
+  sampler.Start(std::chrono::milliseconds(5));
+  std::thread([]() {
+    CpuSampler::RegisterThread("sampler_test");
+    CpuPhase phase("SpinPhase");
+    Spin(std::chrono::milliseconds(100));
+  }).join();
+  sampler.Stop();
+
+  Breakpoint breakpoint;
+  sampler.AddToBreakpoint(&breakpoint);
+  const Variable *cpu_time = FindVariable(breakpoint, "cpu_time_us");
+  const Variable *phase_time = FindVariable(breakpoint, "cpu_phase_time_us");
+  const Variable *wall_time = FindVariable(breakpoint, "cpu_wall_time_us");
+  ASSERT_NE(nullptr, cpu_time);
+  ASSERT_NE(nullptr, phase_time);
+  ASSERT_NE(nullptr, wall_time);
+
+  // Half of the time spinning is enough to tolerate coarse clocks.
+  EXPECT_GE(GetMemberValue(*cpu_time, "sampler_test"), 50000);
+  EXPECT_GE(GetMemberValue(*phase_time, "SpinPhase"), 50000);
+  EXPECT_GE(std::stoll(cpu_time->value()),
+            GetMemberValue(*cpu_time, "sampler_test"));
+  EXPECT_GE(std::stoll(wall_time->value()), 100000);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,144 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "csharp_expression.h"
+#include "dbg_primitive.h"
+#include "expression_util.h"
+#include "identifier_evaluator.h"
+#include "literal_evaluator.h"
+#include "string_evaluator.h"
+
+using google_cloud_debugger::BinaryCSharpExpression;
+using google_cloud_debugger::CompiledExpression;
+using google_cloud_debugger::ConditionalCSharpExpression;
+using google_cloud_debugger::CSharpBooleanLiteral;
+using google_cloud_debugger::CSharpExpression;
+using google_cloud_debugger::CSharpIdentifier;
+using google_cloud_debugger::CSharpIntLiteral;
+using google_cloud_debugger::CSharpStringLiteral;
+using google_cloud_debugger::DbgPrimitive;
+using google_cloud_debugger::IdentifierEvaluator;
+using google_cloud_debugger::LiteralEvaluator;
+using google_cloud_debugger::StringEvaluator;
+using google_cloud_debugger::TypeCastCSharpExpression;
+using google_cloud_debugger::UnaryCSharpExpression;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Returns an int literal expression of value.
+static CSharpExpression *IntLiteral(const string &value) {
+  CSharpIntLiteral *literal = new CSharpIntLiteral();
+  EXPECT_TRUE(literal->ParseString(value, 10));
+  return literal;
+}
+
+// Returns a string literal expression of value.
+static CSharpExpression *StringLiteral(const string &value) {
+  CSharpStringLiteral *literal = new CSharpStringLiteral();
+  EXPECT_TRUE(literal->ParseString(value));
+  return literal;
+}
+
+// Checks that compiled is a literal of type T with value.
+template <typename T>
+static void ExpectLiteral(const CompiledExpression &compiled, T value) {
+  LiteralEvaluator *literal =
+      dynamic_cast<LiteralEvaluator *>(compiled.evaluator.get());
+  ASSERT_TRUE(literal != nullptr);
+
+  DbgPrimitive<T> *primitive =
+      dynamic_cast<DbgPrimitive<T> *>(literal->GetLiteral().get());
+  ASSERT_TRUE(primitive != nullptr);
+  EXPECT_EQ(primitive->GetValue(), value);
+}
+
+// Tests that arithmetic on literals is folded into one literal.
+TEST(CSharpExpressionTest, FoldArithmetic) {
+  // (2 + 3) * -4L
+  BinaryCSharpExpression expression(
+      BinaryCSharpExpression::Type::mul,
+      new BinaryCSharpExpression(BinaryCSharpExpression::Type::add,
+                                 IntLiteral("2"), IntLiteral("3")),
+      new UnaryCSharpExpression(UnaryCSharpExpression::Type::minus,
+                                IntLiteral("4L")));
+  ExpectLiteral<int64_t>(expression.CreateEvaluator(), -20);
+}
+
+// Tests that numeric casts of literals are folded.
+TEST(CSharpExpressionTest, FoldTypeCast) {
+  TypeCastCSharpExpression expression("System.Int16", IntLiteral("70000"));
+  ExpectLiteral<int16_t>(expression.CreateEvaluator(),
+                         static_cast<int16_t>(70000));
+}
+
+// Tests that string literals are concatenated and compared.
+TEST(CSharpExpressionTest, FoldStrings) {
+  BinaryCSharpExpression concatenation(BinaryCSharpExpression::Type::add,
+                                       StringLiteral("Hello, "),
+                                       StringLiteral("World"));
+  CompiledExpression compiled = concatenation.CreateEvaluator();
+  StringEvaluator *string_evaluator =
+      dynamic_cast<StringEvaluator *>(compiled.evaluator.get());
+  ASSERT_TRUE(string_evaluator != nullptr);
+  EXPECT_EQ(string_evaluator->GetStringContent(), "Hello, World");
+
+  BinaryCSharpExpression comparison(BinaryCSharpExpression::Type::ne,
+                                    StringLiteral("a"), StringLiteral("b"));
+  ExpectLiteral<bool>(comparison.CreateEvaluator(), true);
+}
+
+// Tests that branches which can never be evaluated are dropped.
+TEST(CSharpExpressionTest, PruneBranches) {
+  BinaryCSharpExpression conditional_and(
+      BinaryCSharpExpression::Type::conditional_and,
+      new CSharpBooleanLiteral(false), new CSharpIdentifier("x"));
+  ExpectLiteral<bool>(conditional_and.CreateEvaluator(), false);
+
+  BinaryCSharpExpression conditional_or(
+      BinaryCSharpExpression::Type::conditional_or,
+      new CSharpBooleanLiteral(true), new CSharpIdentifier("x"));
+  ExpectLiteral<bool>(conditional_or.CreateEvaluator(), true);
+
+  ConditionalCSharpExpression conditional(new CSharpBooleanLiteral(false),
+                                          IntLiteral("1"),
+                                          new CSharpIdentifier("x"));
+  CompiledExpression compiled = conditional.CreateEvaluator();
+  EXPECT_TRUE(dynamic_cast<IdentifierEvaluator *>(
+                  compiled.evaluator.get()) != nullptr);
+}
+
+// Tests that expressions which need the debuggee are not folded, and
+// neither are constant expressions whose evaluation fails.
+TEST(CSharpExpressionTest, NoFolding) {
+  BinaryCSharpExpression variable(BinaryCSharpExpression::Type::add,
+                                  IntLiteral("2"), new CSharpIdentifier("x"));
+  CompiledExpression compiled = variable.CreateEvaluator();
+  ASSERT_TRUE(compiled.evaluator != nullptr);
+  EXPECT_TRUE(dynamic_cast<LiteralEvaluator *>(compiled.evaluator.get()) ==
+              nullptr);
+
+  BinaryCSharpExpression division(BinaryCSharpExpression::Type::div,
+                                  IntLiteral("1"), IntLiteral("0"));
+  compiled = division.CreateEvaluator();
+  ASSERT_TRUE(compiled.evaluator != nullptr);
+  EXPECT_TRUE(dynamic_cast<LiteralEvaluator *>(compiled.evaluator.get()) ==
+              nullptr);
+}
+
+}  // namespace google_cloud_debugger_test
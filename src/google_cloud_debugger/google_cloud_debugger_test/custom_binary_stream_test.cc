@@ -15,6 +15,8 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <cstdio>
+#include <fstream>
 #include <string>
 
 #include "custom_binary_reader.h"
@@ -170,4 +172,157 @@ TEST(BinaryReader, GetStringTest) {
   EXPECT_EQ(second_string, "def");
 }
 
+// Tests that GetStringSpan returns the characters without the null
+// character and stops at the end of the stream.
+TEST(BinaryReader, GetStringSpanTest) {
+  char test_data[] = {'a', 'b', 'c', 0, 'd', 'e', 'f'};
+  unique_ptr<stringstream> test_stream =
+      SetUpStream(test_data, sizeof(test_data));
+  google_cloud_debugger_portable_pdb::CustomBinaryStream binary_stream;
+
+  EXPECT_TRUE(binary_stream.ConsumeStream(test_stream.release()));
+
+  const char *data;
+  uint32_t length;
+  EXPECT_TRUE(binary_stream.GetStringSpan(0, &data, &length));
+  EXPECT_EQ(string(data, length), "abc");
+
+  EXPECT_TRUE(binary_stream.GetStringSpan(4, &data, &length));
+  EXPECT_EQ(string(data, length), "def");
+
+  EXPECT_FALSE(binary_stream.GetStringSpan(10, &data, &length));
+}
+
+// Tests that ReadSpan returns the bytes in the stream and advances it.
+TEST(BinaryReader, ReadSpanTest) {
+  char test_data[] = {0x01, 0x02, 0x03, 0x04};
+  unique_ptr<stringstream> test_stream =
+      SetUpStream(test_data, sizeof(test_data));
+  google_cloud_debugger_portable_pdb::CustomBinaryStream binary_stream;
+
+  EXPECT_TRUE(binary_stream.ConsumeStream(test_stream.release()));
+
+  const uint8_t *data;
+  EXPECT_TRUE(binary_stream.ReadSpan(3, &data));
+  EXPECT_EQ(data[0], 0x01);
+  EXPECT_EQ(data[2], 0x03);
+
+  uint8_t next_byte;
+  EXPECT_TRUE(binary_stream.Peek(&next_byte));
+  EXPECT_EQ(next_byte, 0x04);
+
+  EXPECT_FALSE(binary_stream.ReadSpan(2, &data));
+}
+
+// Tests that GetBlobSpan reads the length prefix and GetSpan does not, and
+// that neither moves the stream.
+TEST(BinaryReader, GetBlobTest) {
+  char test_data[] = {0x00, 0x03, 0x0A, 0x0B, 0x0C, 0x05, 0x01};
+  unique_ptr<stringstream> test_stream =
+      SetUpStream(test_data, sizeof(test_data));
+  google_cloud_debugger_portable_pdb::CustomBinaryStream binary_stream;
+
+  EXPECT_TRUE(binary_stream.ConsumeStream(test_stream.release()));
+
+  const uint8_t *data;
+  uint32_t length;
+  EXPECT_TRUE(binary_stream.GetBlobSpan(1, &data, &length));
+  EXPECT_EQ(length, 3);
+  EXPECT_EQ(data[0], 0x0A);
+  EXPECT_EQ(data[2], 0x0C);
+
+  EXPECT_TRUE(binary_stream.GetSpan(1, 2, &data));
+  EXPECT_EQ(data[0], 0x03);
+  EXPECT_EQ(data[1], 0x0A);
+  EXPECT_TRUE(binary_stream.GetSpan(7, 0, &data));
+  EXPECT_FALSE(binary_stream.GetSpan(6, 2, &data));
+
+  // The blob at offset 5 claims 5 bytes but only 1 is left.
+  EXPECT_FALSE(binary_stream.GetBlobSpan(5, &data, &length));
+
+  uint8_t peek_byte;
+  EXPECT_TRUE(binary_stream.Peek(&peek_byte));
+  EXPECT_EQ(peek_byte, 0x00);
+}
+
+// Tests that DecodeCompressedInts decodes the same integers as
+// ReadCompressedUInt32, both in runs of one byte integers and outside.
+TEST(BinaryReader, DecodeCompressedIntsTest) {
+  char test_data[] = {0x03, 0x7F, 0x80, 0x80, 0xAE, 0x57, 0xBF, 0xFF, 0xC0,
+                      0x00, 0x40, 0x00, 0xDF, 0xFF, 0xFF, 0xFF, 0x01, 0x02,
+                      0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x7B, 0x80,
+                      0x01, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11};
+  unique_ptr<stringstream> test_stream =
+      SetUpStream(test_data, sizeof(test_data));
+  google_cloud_debugger_portable_pdb::CustomBinaryStream binary_stream;
+
+  EXPECT_TRUE(binary_stream.ConsumeStream(test_stream.release()));
+
+  google_cloud_debugger_portable_pdb::CompressedInts ints;
+  EXPECT_TRUE(google_cloud_debugger_portable_pdb::DecodeCompressedInts(
+      reinterpret_cast<const uint8_t *>(test_data), sizeof(test_data),
+      &ints));
+  EXPECT_EQ(ints.values.size(), ints.sizes.size());
+
+  size_t index = 0;
+  while (binary_stream.HasNext()) {
+    uint32_t value;
+    EXPECT_TRUE(binary_stream.ReadCompressedUInt32(&value));
+    ASSERT_LT(index, ints.values.size());
+    EXPECT_EQ(ints.values[index], value);
+    ++index;
+  }
+  EXPECT_EQ(index, ints.values.size());
+
+  EXPECT_EQ(ints.sizes[0], 1);
+  EXPECT_EQ(ints.sizes[2], 2);
+  EXPECT_EQ(ints.sizes[5], 4);
+
+  // A four byte integer cut short and an invalid first byte.
+  EXPECT_FALSE(google_cloud_debugger_portable_pdb::DecodeCompressedInts(
+      reinterpret_cast<const uint8_t *>(test_data) + 8, 2, &ints));
+  const uint8_t invalid[] = {0x01, 0xE0};
+  EXPECT_FALSE(google_cloud_debugger_portable_pdb::DecodeCompressedInts(
+      invalid, sizeof(invalid), &ints));
+}
+
+// Tests that ToCompressedSignedInt32 decodes the same integers as
+// ReadCompressSignedInt32.
+TEST(BinaryReader, ToCompressedSignedInt32Test) {
+  using google_cloud_debugger_portable_pdb::ToCompressedSignedInt32;
+
+  EXPECT_EQ(ToCompressedSignedInt32(0x06, 1), 3);
+  EXPECT_EQ(ToCompressedSignedInt32(0x7B, 1), -3);
+  EXPECT_EQ(ToCompressedSignedInt32(0x80, 2), 64);
+  EXPECT_EQ(ToCompressedSignedInt32(0x01, 1), -64);
+  EXPECT_EQ(ToCompressedSignedInt32(0x4000, 4), 8192);
+  EXPECT_EQ(ToCompressedSignedInt32(0x0001, 2), -8192);
+  EXPECT_EQ(ToCompressedSignedInt32(0x1FFFFFFE, 4), 268435455);
+  EXPECT_EQ(ToCompressedSignedInt32(0x1, 4), -268435456);
+}
+
+// Tests that ConsumeFile maps the content of a file.
+TEST(BinaryReader, ConsumeFileTest) {
+  const string file_name = "custom_binary_stream_test.bin";
+  {
+    std::ofstream file(file_name, std::ios::out | std::ios::binary);
+    char test_data[] = {0x01, 0x02, 0x03, 0x04, 'h', 'i', 0};
+    file.write(test_data, sizeof(test_data));
+  }
+
+  google_cloud_debugger_portable_pdb::CustomBinaryStream binary_stream;
+  EXPECT_TRUE(binary_stream.ConsumeFile(file_name));
+
+  uint32_t value;
+  EXPECT_TRUE(binary_stream.ReadUInt32(&value));
+  EXPECT_EQ(value, 0x04030201);
+
+  string result;
+  EXPECT_TRUE(binary_stream.GetString(&result, 4));
+  EXPECT_EQ(result, "hi");
+
+  std::remove(file_name.c_str());
+  EXPECT_FALSE(binary_stream.ConsumeFile(file_name));
+}
+
 }  // namespace google_cloud_debugger_test
@@ -26,6 +26,8 @@
 #include "variable_wrapper.h"
 
 using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::ArrayCaptureMode;
+using google_cloud_debugger::CaptureLimits;
 using google_cloud_debugger::CComPtr;
 using google_cloud_debugger::CorDebugHelper;
 using google_cloud_debugger::DbgArray;
@@ -86,15 +88,18 @@ class DbgArrayTest : public ::testing::Test {
     // Initialize function should issue call to get dimensions
     // and ranks of the array.
     EXPECT_CALL(array_value_, GetDimensions(_, _))
-        .WillRepeatedly(DoAll(SetArrayArgument<1>(dimensions_, dimensions_ + 1),
-                              Return(S_OK)));
+        .WillRepeatedly(DoAll(
+            SetArrayArgument<1>(dimensions_.begin(), dimensions_.end()),
+            Return(S_OK)));
 
     EXPECT_CALL(array_type_, GetRank(_))
-        .WillRepeatedly(DoAll(SetArgPointee<0>(1), Return(S_OK)));
+        .WillRepeatedly(DoAll(SetArgPointee<0>(dimensions_.size()),
+                              Return(S_OK)));
   }
 
-  // An array with 2 elements.
-  ULONG32 dimensions_[1] = {2};
+  // An array with 2 elements, unless a test changes it before calling
+  // SetUpArray.
+  vector<ULONG32> dimensions_ = {2};
 
   // ICorDebugHelper used for array constructor.
   std::shared_ptr<ICorDebugHelper> debug_helper_;
@@ -310,7 +315,7 @@ TEST_F(DbgArrayTest, TestPopulateMembers) {
     // Initialize to a null array.
     dbgarray.Initialize(&array_value_, TRUE);
     HRESULT hr = dbgarray.PopulateMembers(&variable, &variable_wrappers,
-                                          &eval_coordinator_);
+                                          CaptureLimits(), &eval_coordinator_);
     EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
     EXPECT_EQ(variable.members_size(), 0);
@@ -342,7 +347,7 @@ TEST_F(DbgArrayTest, TestPopulateMembers) {
       .WillRepeatedly(DoAll(SetArgPointee<1>(&item1), Return(S_OK)));
 
   HRESULT hr = dbgarray.PopulateMembers(&variable, &variable_wrappers,
-                                        &eval_coordinator_);
+                                        CaptureLimits(), &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // Checks that the variable proto in the wrapper is children
@@ -361,6 +366,240 @@ TEST_F(DbgArrayTest, TestPopulateMembers) {
   EXPECT_EQ(variable.members(1).value(), std::to_string(value1));
 }
 
+// Tests that PopulateMembers reads the items of an array of primitives
+// with a single read of the memory of the debuggee.
+TEST_F(DbgArrayTest, TestPopulateMembersReadsPrimitiveMemory) {
+  SetUpArray();
+
+  DbgArray dbgarray(&array_type_, 1, debug_helper_, dbg_object_factory_);
+  dbgarray.Initialize(&array_value_, FALSE);
+
+  ICorDebugThreadMock debug_thread;
+  ICorDebugProcessMock debug_process;
+  EXPECT_CALL(eval_coordinator_, GetActiveDebugThread(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_thread), Return(S_OK)));
+  EXPECT_CALL(debug_thread, GetProcess(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_process), Return(S_OK)));
+
+  // Only the first item is retrieved, to find where the items are.
+  ICorDebugGenericValueMock item0;
+  CORDB_ADDRESS address = 0x1000;
+  EXPECT_CALL(array_value_, GetElementAtPosition(0, _))
+      .Times(1)
+      .WillRepeatedly(DoAll(SetArgPointee<1>(&item0), Return(S_OK)));
+  EXPECT_CALL(array_value_, GetElementAtPosition(1, _)).Times(0);
+  EXPECT_CALL(item0, GetAddress(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(address), Return(S_OK)));
+  EXPECT_CALL(item0, GetSize(_))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(sizeof(int32_t)), Return(S_OK)));
+
+  int32_t values[] = {20, 40};
+  const BYTE *memory = reinterpret_cast<const BYTE *>(values);
+  EXPECT_CALL(debug_process, ReadMemory(address, sizeof(values), _, _))
+      .Times(1)
+      .WillRepeatedly(
+          DoAll(SetArrayArgument<2>(memory, memory + sizeof(values)),
+                SetArgPointee<3>(sizeof(values)), Return(S_OK)));
+
+  Variable variable;
+  vector<VariableWrapper> variable_wrappers;
+  HRESULT hr = dbgarray.PopulateMembers(&variable, &variable_wrappers,
+                                        CaptureLimits(), &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(variable_wrappers.size(), 2);
+
+  PopulateTypeAndValue(variable_wrappers);
+
+  EXPECT_EQ(variable.members(0).name(), "[0]");
+  EXPECT_EQ(variable.members(1).name(), "[1]");
+  EXPECT_EQ(variable.members(0).type(), "System.Int32");
+  EXPECT_EQ(variable.members(1).type(), "System.Int32");
+  EXPECT_EQ(variable.members(0).value(), "20");
+  EXPECT_EQ(variable.members(1).value(), "40");
+}
+
+// Tests that PopulateMembers captures a multi-dimensional array of
+// primitives as nested members, reading each row of the captured items
+// with a single read of the memory of the debuggee.
+TEST_F(DbgArrayTest, TestPopulateMembersMultiDimensional) {
+  dimensions_ = {2, 3};
+  SetUpArray();
+
+  DbgArray dbgarray(&array_type_, 1, debug_helper_, dbg_object_factory_);
+  dbgarray.Initialize(&array_value_, FALSE);
+
+  ICorDebugThreadMock debug_thread;
+  ICorDebugProcessMock debug_process;
+  EXPECT_CALL(eval_coordinator_, GetActiveDebugThread(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_thread), Return(S_OK)));
+  EXPECT_CALL(debug_thread, GetProcess(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_process), Return(S_OK)));
+
+  // Only the first item of each row is retrieved.
+  ICorDebugGenericValueMock row0;
+  ICorDebugGenericValueMock row1;
+  CORDB_ADDRESS address = 0x1000;
+  CORDB_ADDRESS row_address = address + 3 * sizeof(int32_t);
+  EXPECT_CALL(array_value_, GetElementAtPosition(0, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(&row0), Return(S_OK)));
+  EXPECT_CALL(array_value_, GetElementAtPosition(3, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(&row1), Return(S_OK)));
+  EXPECT_CALL(row0, GetAddress(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(address), Return(S_OK)));
+  EXPECT_CALL(row1, GetAddress(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(row_address), Return(S_OK)));
+  EXPECT_CALL(row0, GetSize(_))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(sizeof(int32_t)), Return(S_OK)));
+  EXPECT_CALL(row1, GetSize(_))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(sizeof(int32_t)), Return(S_OK)));
+
+  int32_t values[] = {1, 2, 4, 5};
+  const BYTE *memory = reinterpret_cast<const BYTE *>(values);
+  EXPECT_CALL(debug_process, ReadMemory(address, 2 * sizeof(int32_t), _, _))
+      .Times(1)
+      .WillRepeatedly(
+          DoAll(SetArrayArgument<2>(memory, memory + 2 * sizeof(int32_t)),
+                SetArgPointee<3>(2 * sizeof(int32_t)), Return(S_OK)));
+  EXPECT_CALL(debug_process,
+              ReadMemory(row_address, 2 * sizeof(int32_t), _, _))
+      .Times(1)
+      .WillRepeatedly(DoAll(
+          SetArrayArgument<2>(memory + 2 * sizeof(int32_t),
+                              memory + 4 * sizeof(int32_t)),
+          SetArgPointee<3>(2 * sizeof(int32_t)), Return(S_OK)));
+
+  // 4 items are captured out of the 2x3 array, 2 of each row.
+  CaptureLimits limits;
+  limits.max_collection_items = 4;
+  Variable variable;
+  vector<VariableWrapper> variable_wrappers;
+  HRESULT hr = dbgarray.PopulateMembers(&variable, &variable_wrappers, limits,
+                                        &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(variable_wrappers.size(), 4);
+
+  PopulateTypeAndValue(variable_wrappers);
+
+  ASSERT_EQ(variable.members_size(), 2);
+  for (int row = 0; row < 2; ++row) {
+    const Variable &row_variable = variable.members(row);
+    EXPECT_EQ(row_variable.name(), "[" + std::to_string(row) + "]");
+    ASSERT_EQ(row_variable.members_size(), 2);
+    EXPECT_EQ(row_variable.members(0).name(), "[0]");
+    EXPECT_EQ(row_variable.members(1).name(), "[1]");
+    EXPECT_EQ(row_variable.members(0).value(), std::to_string(values[2 * row]));
+    EXPECT_EQ(row_variable.members(1).value(),
+              std::to_string(values[2 * row + 1]));
+  }
+}
+
+// Tests how many items of each dimension of a multi-dimensional array
+// are captured.
+TEST(DbgArraySelectDimensionCountsTest, SharesItemsBetweenDimensions) {
+  vector<ULONG32> counts;
+
+  DbgArray::SelectDimensionCounts({10, 10}, 10, &counts);
+  EXPECT_EQ(counts, vector<ULONG32>({3, 3}));
+
+  // The items a short dimension does not use go to the others.
+  DbgArray::SelectDimensionCounts({100, 2}, 100, &counts);
+  EXPECT_EQ(counts, vector<ULONG32>({50, 2}));
+
+  DbgArray::SelectDimensionCounts({2, 3, 4}, 100, &counts);
+  EXPECT_EQ(counts, vector<ULONG32>({2, 3, 4}));
+
+  // Every dimension has at least one item if any item is captured.
+  DbgArray::SelectDimensionCounts({5, 5, 5}, 2, &counts);
+  EXPECT_EQ(counts, vector<ULONG32>({1, 1, 2}));
+
+  DbgArray::SelectDimensionCounts({5, 0}, 10, &counts);
+  EXPECT_EQ(counts, vector<ULONG32>({0, 0}));
+}
+
+// Tests the items that each array capture mode selects.
+TEST(DbgArraySelectItemPositionsTest, SelectsItemsByMode) {
+  CaptureLimits limits;
+  vector<int> positions;
+
+  // Short arrays are captured in full in every mode.
+  limits.array_capture_mode = ArrayCaptureMode::kStrided;
+  DbgArray::SelectItemPositions(3, 5, limits, &positions);
+  EXPECT_EQ(positions, vector<int>({0, 1, 2}));
+
+  limits.array_capture_mode = ArrayCaptureMode::kHead;
+  DbgArray::SelectItemPositions(100, 4, limits, &positions);
+  EXPECT_EQ(positions, vector<int>({0, 1, 2, 3}));
+
+  limits.array_capture_mode = ArrayCaptureMode::kHeadAndTail;
+  DbgArray::SelectItemPositions(100, 5, limits, &positions);
+  EXPECT_EQ(positions, vector<int>({0, 1, 2, 98, 99}));
+
+  limits.array_capture_mode = ArrayCaptureMode::kStrided;
+  DbgArray::SelectItemPositions(100, 4, limits, &positions);
+  EXPECT_EQ(positions, vector<int>({0, 25, 50, 75}));
+
+  limits.array_capture_mode = ArrayCaptureMode::kRange;
+  limits.array_range_start = 97;
+  DbgArray::SelectItemPositions(100, 5, limits, &positions);
+  EXPECT_EQ(positions, vector<int>({97, 98, 99}));
+
+  // A range past the end of the array captures nothing.
+  limits.array_range_start = 100;
+  DbgArray::SelectItemPositions(100, 5, limits, &positions);
+  EXPECT_TRUE(positions.empty());
+}
+
+// Tests that ReadItemsMemory reads from the address of the first item
+// requested and only reads items that are in the array.
+TEST_F(DbgArrayTest, TestReadItemsMemory) {
+  SetUpArray();
+
+  DbgArray dbgarray(&array_type_, 1, debug_helper_, dbg_object_factory_);
+  dbgarray.Initialize(&array_value_, FALSE);
+
+  ICorDebugThreadMock debug_thread;
+  ICorDebugProcessMock debug_process;
+  EXPECT_CALL(eval_coordinator_, GetActiveDebugThread(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_thread), Return(S_OK)));
+  EXPECT_CALL(debug_thread, GetProcess(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_process), Return(S_OK)));
+
+  vector<BYTE> items_memory;
+  ULONG32 item_size;
+
+  // The array only has 2 items.
+  EXPECT_EQ(dbgarray.ReadItemsMemory(1, 2, &eval_coordinator_, &items_memory,
+                                     &item_size),
+            E_INVALIDARG);
+
+  ICorDebugGenericValueMock item1;
+  CORDB_ADDRESS address = 0x1004;
+  EXPECT_CALL(array_value_, GetElementAtPosition(1, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(&item1), Return(S_OK)));
+  EXPECT_CALL(item1, GetAddress(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(address), Return(S_OK)));
+  EXPECT_CALL(item1, GetSize(_))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(sizeof(int32_t)), Return(S_OK)));
+
+  int32_t value = 40;
+  const BYTE *memory = reinterpret_cast<const BYTE *>(&value);
+  EXPECT_CALL(debug_process, ReadMemory(address, sizeof(value), _, _))
+      .Times(1)
+      .WillRepeatedly(
+          DoAll(SetArrayArgument<2>(memory, memory + sizeof(value)),
+                SetArgPointee<3>(sizeof(value)), Return(S_OK)));
+
+  EXPECT_EQ(dbgarray.ReadItemsMemory(1, 1, &eval_coordinator_, &items_memory,
+                                     &item_size),
+            S_OK);
+  EXPECT_EQ(item_size, sizeof(int32_t));
+  EXPECT_EQ(items_memory, vector<BYTE>(memory, memory + sizeof(value)));
+}
+
 // Tests error case for PopulateMembers function of DbgArray.
 TEST_F(DbgArrayTest, TestPopulateMembersError) {
   SetUpArray();
@@ -379,7 +618,7 @@ TEST_F(DbgArrayTest, TestPopulateMembersError) {
     vector<VariableWrapper> variable_wrappers;
     EXPECT_EQ(dbgarray.GetInitializeHr(),
               dbgarray.PopulateMembers(&variable, &variable_wrappers,
-                                       &eval_coordinator_));
+                                       CaptureLimits(), &eval_coordinator_));
   }
 
   DbgArray dbgarray(&array_type_, 1, debug_helper_, dbg_object_factory_);
@@ -388,16 +627,19 @@ TEST_F(DbgArrayTest, TestPopulateMembersError) {
   // Should throws error for null variable.
   vector<VariableWrapper> variable_wrappers;
   EXPECT_EQ(
-      dbgarray.PopulateMembers(nullptr, &variable_wrappers, &eval_coordinator_),
+      dbgarray.PopulateMembers(nullptr, &variable_wrappers, CaptureLimits(),
+                               &eval_coordinator_),
       E_INVALIDARG);
 
   Variable variable;
   // Should throws error for null variable wrappers vector.
-  EXPECT_EQ(dbgarray.PopulateMembers(&variable, nullptr, &eval_coordinator_),
+  EXPECT_EQ(dbgarray.PopulateMembers(&variable, nullptr, CaptureLimits(),
+                                     &eval_coordinator_),
             E_INVALIDARG);
 
   // Should throws error for null eval coordinator.
-  EXPECT_EQ(dbgarray.PopulateMembers(&variable, &variable_wrappers, nullptr),
+  EXPECT_EQ(dbgarray.PopulateMembers(&variable, &variable_wrappers,
+                                     CaptureLimits(), nullptr),
             E_INVALIDARG);
 }
 
@@ -14,6 +14,7 @@
 
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <string>
 
@@ -28,20 +29,27 @@
 #include "i_eval_coordinator_mock.h"
 #include "i_portable_pdb_mocks.h"
 #include "i_stack_frame_collection_mock.h"
+#include "variable_wrapper.h"
 
 using google::cloud::diagnostics::debug::Breakpoint;
+using google_cloud_debugger::BreakpointCost;
 using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::CaptureLimits;
 using google_cloud_debugger::DbgBreakpoint;
+using google_cloud_debugger::VariableQueue;
 using google_cloud_debugger_portable_pdb::IDocumentIndex;
 using google_cloud_debugger_portable_pdb::MethodInfo;
 using google_cloud_debugger_portable_pdb::SequencePoint;
+using google_cloud_debugger_portable_pdb::SequencePointLocation;
 using google::cloud::diagnostics::debug::Breakpoint_LogLevel;
+using google::cloud::diagnostics::debug::Variable;
 using std::max;
 using std::string;
 using std::unique_ptr;
 using std::vector;
 using ::testing::_;
 using ::testing::Const;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::ReturnRef;
 using ::testing::SetArgPointee;
@@ -147,6 +155,12 @@ class DbgBreakpointTest : public ::testing::Test {
 
     SetUpBreakpoint();
 
+    // Only the methods of the chosen document, which comes after the
+    // similar ones, are parsed.
+    EXPECT_CALL(file_mock_, ParseDocumentMethods(similar_file_names.size()))
+        .Times(1);
+    EXPECT_CALL(file_mock_, ParseMethods()).Times(0);
+
     EXPECT_TRUE(breakpoint_.TrySetBreakpoint(&file_mock_));
     EXPECT_EQ(breakpoint_.GetILOffset(), il_offset);
     EXPECT_EQ(breakpoint_.GetMethodDef(), method_def);
@@ -228,6 +242,30 @@ TEST_F(DbgBreakpointTest, Initialize) {
   EXPECT_EQ(breakpoint2.LogLevel(), log_level_);
 }
 
+// Tests that the exception type and module of exception points are
+// parsed from their path.
+TEST_F(DbgBreakpointTest, InitializeExceptionPoint) {
+  EXPECT_FALSE(breakpoint_.IsExceptionPoint());
+
+  breakpoint_.Initialize("exception:System.InvalidOperationException@App",
+                         id_, 0, 0, false, "", log_level_, "", {});
+  EXPECT_TRUE(breakpoint_.IsExceptionPoint());
+  EXPECT_EQ(breakpoint_.GetExceptionType(),
+            "system.invalidoperationexception");
+  EXPECT_EQ(breakpoint_.GetExceptionModule(), "app");
+
+  breakpoint_.Initialize("exception:System.Exception", id_, 0, 0, false, "",
+                         log_level_, "", {});
+  EXPECT_TRUE(breakpoint_.IsExceptionPoint());
+  EXPECT_EQ(breakpoint_.GetExceptionType(), "system.exception");
+  EXPECT_EQ(breakpoint_.GetExceptionModule(), "");
+
+  // Other breakpoints are not.
+  SetUpBreakpoint();
+  EXPECT_FALSE(breakpoint_.IsExceptionPoint());
+  EXPECT_EQ(breakpoint_.GetExceptionType(), "");
+}
+
 // Tests that the Set/GetMethodToken function sets up the correct fields.
 TEST_F(DbgBreakpointTest, SetGetMethodToken) {
   mdMethodDef method_token = 10;
@@ -282,6 +320,32 @@ TEST_F(DbgBreakpointTest, TrySetBreakpoint) {
   EXPECT_EQ(breakpoint_.GetMethodDef(), method_def);
 }
 
+// Tests that FindLocation returns the location TrySetBreakpoint sets
+// without changing the breakpoint.
+TEST_F(DbgBreakpointTest, FindLocation) {
+  uint32_t method_first_line = (line_ - 4) % line_;
+  uint32_t method_def = 100;
+  uint32_t il_offset = 99;
+  first_doc_.methods_.push_back(
+      MakeMatchingMethod(line_, method_first_line, method_def, il_offset));
+
+  SetUpBreakpoint();
+  breakpoint_.SetMethodDef(0);
+  breakpoint_.SetILOffset(0);
+
+  SequencePointLocation location;
+  EXPECT_TRUE(breakpoint_.FindLocation(&file_mock_, &location));
+  EXPECT_EQ(location.il_offset, il_offset);
+  EXPECT_EQ(location.method_def, method_def);
+  EXPECT_EQ(breakpoint_.GetILOffset(), 0u);
+  EXPECT_EQ(breakpoint_.GetMethodDef(), 0u);
+
+  breakpoint_.SetLocation(location);
+  EXPECT_EQ(breakpoint_.GetILOffset(), il_offset);
+  EXPECT_EQ(breakpoint_.GetMethodDef(), method_def);
+  EXPECT_FALSE(breakpoint_.FindLocation(nullptr, &location));
+}
+
 // Test the TrySetBreakpoint function of DbgBreakpoint when there are
 // multiple documents.
 TEST_F(DbgBreakpointTest, TrySetBreakpointMultipleFilesOne) {
@@ -399,8 +463,9 @@ TEST_F(DbgBreakpointTest, PopulateBreakpoint) {
   Breakpoint proto_breakpoint;
   IStackFrameCollectionMock stackframe_collection_mock;
 
-  EXPECT_CALL(stackframe_collection_mock,
-              PopulateStackFrames(&proto_breakpoint, &eval_coordinator_mock_))
+  EXPECT_CALL(
+      stackframe_collection_mock,
+      PopulateStackFrames(&proto_breakpoint, _, &eval_coordinator_mock_))
       .Times(1)
       .WillRepeatedly(Return(S_OK));
 
@@ -414,6 +479,25 @@ TEST_F(DbgBreakpointTest, PopulateBreakpoint) {
   EXPECT_EQ(proto_breakpoint.id(), id_);
 }
 
+// Tests that PopulateLogPoint populates the breakpoint without stack frames.
+TEST_F(DbgBreakpointTest, PopulateLogPoint) {
+  SetUpBreakpoint();
+
+  Breakpoint proto_breakpoint;
+  EXPECT_CALL(eval_coordinator_mock_, WaitForReadySignal()).Times(1);
+  HRESULT hr =
+      breakpoint_.PopulateLogPoint(&proto_breakpoint, &eval_coordinator_mock_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  EXPECT_EQ(proto_breakpoint.location().line(), line_);
+  EXPECT_EQ(proto_breakpoint.location().path(), lower_case_file_path_);
+  EXPECT_EQ(proto_breakpoint.id(), id_);
+  EXPECT_EQ(proto_breakpoint.stack_frames_size(), 0);
+
+  EXPECT_EQ(breakpoint_.PopulateLogPoint(&proto_breakpoint, nullptr),
+            E_INVALIDARG);
+}
+
 // Tests the error cases of PopulateBreakpoint function of DbgBreakpoint.
 TEST_F(DbgBreakpointTest, PopulateBreakpointError) {
   SetUpBreakpoint();
@@ -433,8 +517,9 @@ TEST_F(DbgBreakpointTest, PopulateBreakpointError) {
             E_INVALIDARG);
 
   // Makes PopulateStackFrames returns error.
-  EXPECT_CALL(stackframe_collection_mock,
-              PopulateStackFrames(&proto_breakpoint, &eval_coordinator_mock_))
+  EXPECT_CALL(
+      stackframe_collection_mock,
+      PopulateStackFrames(&proto_breakpoint, _, &eval_coordinator_mock_))
       .Times(1)
       .WillRepeatedly(Return(CORDBG_E_BAD_REFERENCE_VALUE));
 
@@ -444,6 +529,160 @@ TEST_F(DbgBreakpointTest, PopulateBreakpointError) {
             CORDBG_E_BAD_REFERENCE_VALUE);
 }
 
+// Tests that the costs of the hits of a breakpoint add up and are
+// reported in a status that is not an error.
+TEST_F(DbgBreakpointTest, RecordHitCost) {
+  SetUpBreakpoint();
+
+  breakpoint_.RecordHitCost(std::chrono::microseconds(300), 2);
+  breakpoint_.RecordHitCost(std::chrono::microseconds(100), 0);
+  breakpoint_.RecordPayloadBytes(1000);
+
+  BreakpointCost cost = breakpoint_.GetCost();
+  EXPECT_EQ(cost.hits, 2);
+  EXPECT_EQ(cost.total_stop_time_us, 400);
+  EXPECT_EQ(cost.max_stop_time_us, 300);
+  EXPECT_EQ(cost.func_evals, 2);
+  EXPECT_EQ(cost.payload_bytes, 1000);
+
+  Breakpoint proto_breakpoint;
+  breakpoint_.PopulateCostStatus(&proto_breakpoint);
+  ASSERT_TRUE(proto_breakpoint.has_status());
+  EXPECT_FALSE(proto_breakpoint.status().iserror());
+  EXPECT_NE(proto_breakpoint.status().message().find("2 hits"),
+            string::npos);
+  EXPECT_NE(proto_breakpoint.status().message().find("400 us"),
+            string::npos);
+
+  // An error status is not replaced.
+  Breakpoint error_breakpoint;
+  breakpoint_.PopulateErrorStatus(&error_breakpoint, "error");
+  breakpoint_.PopulateCostStatus(&error_breakpoint);
+  EXPECT_TRUE(error_breakpoint.status().iserror());
+  EXPECT_EQ(error_breakpoint.status().message(), "error");
+}
+
+// Tests that a breakpoint is finished once its hits reach its hit limit,
+// and that hits past the limit are not counted as processed.
+TEST_F(DbgBreakpointTest, CountHit) {
+  SetUpBreakpoint();
+  std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+
+  // Without a hit limit, a breakpoint is never finished by its hits.
+  EXPECT_FALSE(breakpoint_.HasHitLimitOrExpiry());
+  EXPECT_TRUE(breakpoint_.CountHit());
+  EXPECT_FALSE(breakpoint_.IsFinished(now));
+
+  breakpoint_.SetHitLimit(2);
+  EXPECT_TRUE(breakpoint_.HasHitLimitOrExpiry());
+  EXPECT_TRUE(breakpoint_.CountHit());
+  EXPECT_FALSE(breakpoint_.IsFinished(now));
+  EXPECT_TRUE(breakpoint_.CountHit());
+  EXPECT_TRUE(breakpoint_.IsFinished(now));
+  EXPECT_FALSE(breakpoint_.CountHit());
+
+  // A copy starts counting its hits again.
+  DbgBreakpoint copy;
+  copy.Initialize(breakpoint_);
+  EXPECT_EQ(copy.GetHitLimit(), 2);
+  EXPECT_FALSE(copy.IsFinished(now));
+}
+
+// Tests that only one hit at a time holds the capture slot of a snapshot
+// with a hit limit, and that other breakpoints only use it if they
+// coalesce their hits.
+TEST_F(DbgBreakpointTest, CaptureSlot) {
+  log_point_ = false;
+  SetUpBreakpoint();
+  EXPECT_FALSE(breakpoint_.HasSingleCapture());
+
+  breakpoint_.SetHitLimit(1);
+  EXPECT_TRUE(breakpoint_.HasSingleCapture());
+  EXPECT_TRUE(breakpoint_.BeginCapture());
+  EXPECT_FALSE(breakpoint_.BeginCapture());
+  breakpoint_.EndCapture();
+  EXPECT_TRUE(breakpoint_.BeginCapture());
+  breakpoint_.EndCapture();
+
+  DbgBreakpoint log_point;
+  log_point.Initialize(file_path_, id_, line_, column_, true,
+                       log_message_format_, log_level_, condition_,
+                       expressions_);
+  log_point.SetHitLimit(1);
+  EXPECT_FALSE(log_point.HasSingleCapture());
+  log_point.SetCoalesceHits(true);
+  EXPECT_TRUE(log_point.HasSingleCapture());
+
+  DbgBreakpoint copy;
+  copy.Initialize(log_point);
+  EXPECT_TRUE(copy.HasSingleCapture());
+}
+
+// Tests that every sample_every-th hit is sampled, and that a sample rate
+// of 0 or 1 samples every hit.
+TEST_F(DbgBreakpointTest, Sampling) {
+  log_point_ = false;
+  SetUpBreakpoint();
+  EXPECT_FALSE(breakpoint_.IsSampled());
+  EXPECT_TRUE(breakpoint_.SampleHit());
+
+  breakpoint_.SetSampling(3, 0);
+  EXPECT_TRUE(breakpoint_.IsSampled());
+  int sampled = 0;
+  for (int i = 0; i < 9; ++i) {
+    if (breakpoint_.SampleHit()) {
+      EXPECT_EQ(i % 3, 2);
+      ++sampled;
+    }
+  }
+  EXPECT_EQ(sampled, 3);
+
+  breakpoint_.SetSampling(0, 1);
+  EXPECT_FALSE(breakpoint_.IsSampled());
+  breakpoint_.SetSampling(0, 0.5);
+  EXPECT_TRUE(breakpoint_.IsSampled());
+
+  DbgBreakpoint copy;
+  copy.Initialize(breakpoint_);
+  EXPECT_TRUE(copy.IsSampled());
+}
+
+// Tests that only log points whose message format starts with
+// kMetricPointFormatPrefix are metric points.
+TEST_F(DbgBreakpointTest, IsMetricPoint) {
+  DbgBreakpoint breakpoint;
+  breakpoint.Initialize(file_path_, id_, line_, column_, true,
+                        "metric: latency $0", log_level_, condition_,
+                        {"elapsed"});
+  EXPECT_TRUE(breakpoint.IsMetricPoint());
+
+  DbgBreakpoint copy;
+  copy.Initialize(breakpoint);
+  EXPECT_TRUE(copy.IsMetricPoint());
+
+  breakpoint.Initialize(file_path_, id_, line_, column_, false,
+                        "metric: latency $0", log_level_, condition_,
+                        {"elapsed"});
+  EXPECT_FALSE(breakpoint.IsMetricPoint());
+
+  breakpoint.Initialize(file_path_, id_, line_, column_, true,
+                        "latency metric: $0", log_level_, condition_,
+                        {"elapsed"});
+  EXPECT_FALSE(breakpoint.IsMetricPoint());
+}
+
+// Tests that a breakpoint is finished once it expires.
+TEST_F(DbgBreakpointTest, ExpireTime) {
+  SetUpBreakpoint();
+  std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+
+  breakpoint_.SetExpireTime(now + std::chrono::hours(1));
+  EXPECT_TRUE(breakpoint_.HasHitLimitOrExpiry());
+  EXPECT_FALSE(breakpoint_.IsFinished(now));
+  EXPECT_TRUE(breakpoint_.IsFinished(now + std::chrono::hours(1)));
+  EXPECT_TRUE(breakpoint_.CountHit());
+}
+
 // Tests the EvaluateExpressions function of DbgBreakpoint.
 TEST_F(DbgBreakpointTest, EvaluateExpressions) {
   expressions_ = {"1", "2"};
@@ -458,6 +697,63 @@ TEST_F(DbgBreakpointTest, EvaluateExpressions) {
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 }
 
+// Tests that the expressions parsed on the first hit are evaluated again
+// on later hits.
+TEST_F(DbgBreakpointTest, EvaluateExpressionsAgain) {
+  expressions_ = {"1", "2 + 3"};
+  SetUpBreakpoint();
+
+  EXPECT_CALL(eval_coordinator_mock_, GetActiveDebugFrame(_))
+      .Times(2 * expressions_.size())
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(&active_frame_mock_), Return(S_OK)));
+
+  for (int i = 0; i < 2; ++i) {
+    HRESULT hr = breakpoint_.EvaluateExpressions(
+        &dbg_stack_frame_, &eval_coordinator_mock_, &object_factory_);
+    EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  }
+}
+
+// Tests that the values of expressions that only read constants are
+// reused by later hits while the TTL lasts, and that their status tells
+// their age.
+TEST_F(DbgBreakpointTest, ReusesStaticExpressions) {
+  expressions_ = {"1", "2 + 3"};
+  SetUpBreakpoint();
+  breakpoint_.SetStaticExpressionTtl(std::chrono::hours(1));
+
+  EXPECT_CALL(eval_coordinator_mock_, GetActiveDebugFrame(_))
+      .Times(expressions_.size())
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(&active_frame_mock_), Return(S_OK)));
+
+  for (int i = 0; i < 2; ++i) {
+    HRESULT hr = breakpoint_.EvaluateExpressions(
+        &dbg_stack_frame_, &eval_coordinator_mock_, &object_factory_);
+    EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  }
+
+  Breakpoint proto_breakpoint;
+  IStackFrameCollectionMock stackframe_collection_mock;
+  EXPECT_CALL(
+      stackframe_collection_mock,
+      PopulateStackFrames(&proto_breakpoint, _, &eval_coordinator_mock_))
+      .Times(1)
+      .WillRepeatedly(Return(S_OK));
+
+  HRESULT hr = breakpoint_.PopulateBreakpoint(
+      &proto_breakpoint, &stackframe_collection_mock, &eval_coordinator_mock_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(proto_breakpoint.evaluated_expressions_size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    const Variable &expression = proto_breakpoint.evaluated_expressions(i);
+    EXPECT_EQ(expression.value(), expression.name() == "1" ? "1" : "5");
+    EXPECT_FALSE(expression.status().iserror());
+    EXPECT_EQ(expression.status().message().find("Value evaluated "), 0);
+  }
+}
+
 // Tests that after EvaluateExpressions is called, PopulateBreakpoint
 // populates breakpoint proto with expressions.
 TEST_F(DbgBreakpointTest, PopulateBreakpointExpression) {
@@ -476,8 +772,9 @@ TEST_F(DbgBreakpointTest, PopulateBreakpointExpression) {
   Breakpoint proto_breakpoint;
   IStackFrameCollectionMock stackframe_collection_mock;
 
-  EXPECT_CALL(stackframe_collection_mock,
-              PopulateStackFrames(&proto_breakpoint, &eval_coordinator_mock_))
+  EXPECT_CALL(
+      stackframe_collection_mock,
+      PopulateStackFrames(&proto_breakpoint, _, &eval_coordinator_mock_))
       .Times(1)
       .WillRepeatedly(Return(S_OK));
 
@@ -499,4 +796,94 @@ TEST_F(DbgBreakpointTest, PopulateBreakpointExpression) {
   }
 }
 
+// Tests that the expressions wait in the queue of the thread while the
+// stack frames are populated, so that they are captured in the same BFS
+// as the variables of the top frame.
+TEST_F(DbgBreakpointTest, PopulateBreakpointQueuesExpressions) {
+  expressions_ = {"1", "2"};
+  SetUpBreakpoint();
+
+  EXPECT_CALL(eval_coordinator_mock_, GetActiveDebugFrame(_))
+      .Times(expressions_.size())
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(&active_frame_mock_), Return(S_OK)));
+
+  HRESULT hr = breakpoint_.EvaluateExpressions(
+      &dbg_stack_frame_, &eval_coordinator_mock_, &object_factory_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint proto_breakpoint;
+  IStackFrameCollectionMock stackframe_collection_mock;
+  EXPECT_CALL(
+      stackframe_collection_mock,
+      PopulateStackFrames(&proto_breakpoint, _, &eval_coordinator_mock_))
+      .Times(1)
+      .WillRepeatedly(Invoke(
+          [&proto_breakpoint](Breakpoint *, const CaptureLimits &,
+                              google_cloud_debugger::IEvalCoordinator *) {
+            EXPECT_EQ(VariableQueue::GetThreadQueue()->size(), 2);
+            EXPECT_EQ(proto_breakpoint.evaluated_expressions_size(), 2);
+            EXPECT_EQ(proto_breakpoint.evaluated_expressions(0).value(), "");
+            return S_OK;
+          }));
+
+  hr = breakpoint_.PopulateBreakpoint(
+      &proto_breakpoint, &stackframe_collection_mock, &eval_coordinator_mock_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  // No frame captured them, so they are captured on their own.
+  EXPECT_TRUE(VariableQueue::GetThreadQueue()->empty());
+  ASSERT_EQ(proto_breakpoint.evaluated_expressions_size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    const Variable &expression = proto_breakpoint.evaluated_expressions(i);
+    EXPECT_EQ(expression.name(), expression.value());
+  }
+}
+
+// Tests that expression values are captured and populated without
+// the stack frames.
+TEST_F(DbgBreakpointTest, CaptureExpressionValues) {
+  expressions_ = {"1", "2"};
+  SetUpBreakpoint();
+
+  EXPECT_CALL(eval_coordinator_mock_, GetActiveDebugFrame(_))
+      .Times(expressions_.size())
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(&active_frame_mock_), Return(S_OK)));
+
+  HRESULT hr = breakpoint_.EvaluateExpressions(
+      &dbg_stack_frame_, &eval_coordinator_mock_, &object_factory_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  EXPECT_EQ(breakpoint_.CaptureExpressionValues(nullptr), E_INVALIDARG);
+
+  DbgBreakpoint::ExpressionValues values;
+  hr = breakpoint_.CaptureExpressionValues(&values);
+  EXPECT_EQ(hr, S_OK);
+  EXPECT_EQ(values.size(), 2);
+
+  // The captured values are no longer populated with the breakpoint.
+  Breakpoint proto_breakpoint;
+  IStackFrameCollectionMock stackframe_collection_mock;
+  EXPECT_CALL(
+      stackframe_collection_mock,
+      PopulateStackFrames(&proto_breakpoint, _, &eval_coordinator_mock_))
+      .Times(1)
+      .WillRepeatedly(Return(S_OK));
+
+  hr = breakpoint_.PopulateBreakpoint(
+      &proto_breakpoint, &stackframe_collection_mock, &eval_coordinator_mock_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(proto_breakpoint.evaluated_expressions_size(), 0);
+
+  hr = DbgBreakpoint::PopulateCapturedExpressions(
+      &proto_breakpoint, values, CaptureLimits(), &eval_coordinator_mock_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(proto_breakpoint.evaluated_expressions_size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    const Variable &expression = proto_breakpoint.evaluated_expressions(i);
+    EXPECT_EQ(expression.name(), expression.value());
+  }
+}
+
 }  // namespace google_cloud_debugger_test
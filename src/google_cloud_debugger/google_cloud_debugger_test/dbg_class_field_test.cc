@@ -39,6 +39,7 @@ using std::string;
 using std::vector;
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::Mock;
 using ::testing::Return;
 using ::testing::SetArgPointee;
 using ::testing::SetArrayArgument;
@@ -221,17 +222,43 @@ TEST_F(DbgClassFieldTest, TestInitializeError) {
               GetFieldPropsSecond(field_def_, _, _, _, _, _))
       .WillRepeatedly(Return(S_OK));
 
-  // GetFieldValue returns error.
+  // GetFieldValue returns error. The value is only read when the field
+  // is evaluated.
   EXPECT_CALL(object_value_, GetFieldValue(&debug_class_, field_def_, _))
       .Times(1)
       .WillRepeatedly(Return(CORDBG_E_FIELD_NOT_AVAILABLE));
 
   class_field_->Initialize(nullptr, &metadataimport_mock_,
                            &object_value_, &debug_class_);
+  EXPECT_EQ(class_field_->GetInitializeHr(), S_OK);
 
+  EXPECT_EQ(class_field_->Evaluate(nullptr, &eval_coordinator_, nullptr),
+            CORDBG_E_FIELD_NOT_AVAILABLE);
   EXPECT_EQ(class_field_->GetInitializeHr(), CORDBG_E_FIELD_NOT_AVAILABLE);
 }
 
+// Tests that the value of a non-static field is read from the object
+// only once, when the field is first evaluated.
+TEST_F(DbgClassFieldTest, TestNonStaticValueReadWhenEvaluated) {
+  EXPECT_CALL(object_value_, GetFieldValue(&debug_class_, field_def_, _))
+      .Times(0);
+  SetUpField(TRUE, 20);
+  EXPECT_TRUE(class_field_->GetMemberValue() == nullptr);
+  Mock::VerifyAndClearExpectations(&object_value_);
+
+  EXPECT_CALL(object_value_, GetFieldValue(&debug_class_, field_def_, _))
+      .Times(1)
+      .WillOnce(DoAll(SetArgPointee<2>(&generic_value_), Return(S_OK)));
+  EXPECT_EQ(class_field_->Evaluate(nullptr, &eval_coordinator_, nullptr), S_OK);
+  EXPECT_EQ(class_field_->Evaluate(nullptr, &eval_coordinator_, nullptr), S_OK);
+  EXPECT_EQ(class_field_->ExtractFieldValue(), S_OK);
+
+  Variable variable;
+  EXPECT_TRUE(class_field_->GetMemberValue() != nullptr);
+  EXPECT_EQ(class_field_->GetMemberValue()->PopulateValue(&variable), S_OK);
+  EXPECT_EQ(variable.value(), "20");
+}
+
 // Tests the PopulateVariableValue function of DbgClassProperty for nonstatic
 // field.
 TEST_F(DbgClassFieldTest, TestPopulateVariableValueNonStatic) {
@@ -23,6 +23,7 @@
 #include "cor_debug_helper.h"
 #include "dbg_class_property.h"
 #include "dbg_object_factory.h"
+#include "dbg_primitive.h"
 #include "i_cor_debug_mocks.h"
 #include "i_eval_coordinator_mock.h"
 #include "i_metadata_import_mock.h"
@@ -32,7 +33,9 @@ using google_cloud_debugger::CComPtr;
 using google_cloud_debugger::ConvertStringToWCharPtr;
 using google_cloud_debugger::CorDebugHelper;
 using google_cloud_debugger::DbgClassProperty;
+using google_cloud_debugger::DbgObject;
 using google_cloud_debugger::DbgObjectFactory;
+using google_cloud_debugger::DbgPrimitive;
 using google_cloud_debugger::ICorDebugHelper;
 using google_cloud_debugger::IDbgObjectFactory;
 using std::string;
@@ -387,4 +390,160 @@ TEST_F(DbgClassPropertyTest, TestPopulateVariableValueError) {
             CORDBG_E_FUNC_EVAL_NOT_COMPLETE);
 }
 
+// Tests that a property is not evaluated once the evaluation budget
+// of the breakpoint is used up.
+TEST_F(DbgClassPropertyTest, TestPopulateVariableValueBudgetUsedUp) {
+  SetUpProperty();
+
+  vector<CComPtr<ICorDebugType>> generic_types;
+  EXPECT_CALL(debug_module_, GetFunctionFromToken(_, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(&debug_function_), Return(S_OK)));
+  EXPECT_CALL(eval_coordinator_mock_, CreateEval(_))
+      .Times(1)
+      .WillRepeatedly(Return(E_ABORT));
+  EXPECT_CALL(eval_coordinator_mock_, WaitForEval(_, _, _)).Times(0);
+
+  EXPECT_EQ(class_property_->Evaluate(&reference_value_,
+                                      &eval_coordinator_mock_, &generic_types),
+            E_ABORT);
+  EXPECT_NE(class_property_->GetErrorString().find("budget"), string::npos);
+}
+
+// Tests that a property already evaluated on the same object during the
+// breakpoint hit is not evaluated again.
+TEST_F(DbgClassPropertyTest, TestPopulateVariableValueCached) {
+  SetUpProperty();
+
+  CORDB_ADDRESS object_address = 0x1000;
+  class_property_->SetObjectAddress(object_address);
+
+  std::shared_ptr<DbgObject> cached_value(
+      new DbgPrimitive<int32_t>(property_value_));
+  vector<CComPtr<ICorDebugType>> generic_types;
+  EXPECT_CALL(eval_coordinator_mock_,
+              GetCachedPropertyValue(object_address, _, property_def_, _))
+      .Times(1)
+      .WillRepeatedly(DoAll(SetArgPointee<3>(cached_value), Return(true)));
+  EXPECT_CALL(debug_module_, GetFunctionFromToken(_, _)).Times(0);
+  EXPECT_CALL(eval_coordinator_mock_, CreateEval(_)).Times(0);
+
+  EXPECT_EQ(class_property_->Evaluate(&reference_value_,
+                                      &eval_coordinator_mock_, &generic_types),
+            S_OK);
+  EXPECT_EQ(class_property_->GetMemberValue(), cached_value);
+}
+
+// Tests that GetReturnedField finds the field of the getters that only
+// return one, in release and debug builds.
+TEST(DbgClassPropertyGetterTest, TestGetReturnedField) {
+  // ldarg.0, ldfld 0x04000003, ret.
+  EXPECT_EQ(DbgClassProperty::GetReturnedField(
+                {0x02, 0x7B, 0x03, 0x00, 0x00, 0x04, 0x2A}),
+            0x04000003u);
+
+  // nop, ldarg.0, ldfld 0x04000103, stloc.0, br.s 0, ldloc.0, ret.
+  EXPECT_EQ(DbgClassProperty::GetReturnedField({0x00, 0x02, 0x7B, 0x03, 0x01,
+                                                0x00, 0x04, 0x0A, 0x2B, 0x00,
+                                                0x06, 0x2A}),
+            0x04000103u);
+}
+
+// Tests that GetReturnedField returns 0 for the getters that do more
+// than return a field.
+TEST(DbgClassPropertyGetterTest, TestGetReturnedFieldOther) {
+  EXPECT_EQ(DbgClassProperty::GetReturnedField({}), 0u);
+
+  // The field of a generic class is a MemberRef.
+  EXPECT_EQ(DbgClassProperty::GetReturnedField(
+                {0x02, 0x7B, 0x03, 0x00, 0x00, 0x0A, 0x2A}),
+            0u);
+
+  // ldarg.0, ldfld 0x04000003, ldc.i4.1, add, ret.
+  EXPECT_EQ(DbgClassProperty::GetReturnedField(
+                {0x02, 0x7B, 0x03, 0x00, 0x00, 0x04, 0x17, 0x58, 0x2A}),
+            0u);
+
+  // ldsfld 0x04000003, ret.
+  EXPECT_EQ(DbgClassProperty::GetReturnedField(
+                {0x7E, 0x03, 0x00, 0x00, 0x04, 0x2A}),
+            0u);
+
+  // ldarg.0, ldfld 0x04000003 without a ret.
+  EXPECT_EQ(DbgClassProperty::GetReturnedField(
+                {0x02, 0x7B, 0x03, 0x00, 0x00, 0x04}),
+            0u);
+}
+
+// Tests that GetReturnedConstant finds the constants of the getters that
+// only return one, in release and debug builds.
+TEST(DbgClassPropertyGetterTest, TestGetReturnedConstant) {
+  DbgClassProperty::ILConstant constant;
+
+  // ldc.i4.m1, ret.
+  EXPECT_TRUE(DbgClassProperty::GetReturnedConstant({0x15, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_I4);
+  EXPECT_EQ(constant.integer, -1);
+
+  // nop, ldc.i4.s -2, stloc.0, br.s 0, ldloc.0, ret.
+  EXPECT_TRUE(DbgClassProperty::GetReturnedConstant(
+      {0x00, 0x1F, 0xFE, 0x0A, 0x2B, 0x00, 0x06, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_I4);
+  EXPECT_EQ(constant.integer, -2);
+
+  // ldc.i4 100000, ret.
+  EXPECT_TRUE(DbgClassProperty::GetReturnedConstant(
+      {0x20, 0xA0, 0x86, 0x01, 0x00, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_I4);
+  EXPECT_EQ(constant.integer, 100000);
+
+  // ldc.i4.m1, conv.u8, ret.
+  EXPECT_TRUE(
+      DbgClassProperty::GetReturnedConstant({0x15, 0x6E, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_I8);
+  EXPECT_EQ(constant.integer, 0xFFFFFFFFll);
+
+  // ldc.r8 1.5, ret.
+  EXPECT_TRUE(DbgClassProperty::GetReturnedConstant(
+      {0x23, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x3F, 0x2A},
+      &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_R8);
+  EXPECT_EQ(constant.real, 1.5);
+
+  // ldc.r4 0.5, ret.
+  EXPECT_TRUE(DbgClassProperty::GetReturnedConstant(
+      {0x22, 0x00, 0x00, 0x00, 0x3F, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_R4);
+  EXPECT_EQ(constant.real, 0.5);
+
+  // ldstr 0x70000001, ret.
+  EXPECT_TRUE(DbgClassProperty::GetReturnedConstant(
+      {0x72, 0x01, 0x00, 0x00, 0x70, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_STRING);
+  EXPECT_EQ(constant.string_token, 0x70000001u);
+}
+
+// Tests that GetReturnedConstant returns false for the getters that do
+// more than return a constant.
+TEST(DbgClassPropertyGetterTest, TestGetReturnedConstantOther) {
+  DbgClassProperty::ILConstant constant;
+  EXPECT_FALSE(DbgClassProperty::GetReturnedConstant({}, &constant));
+
+  // ldarg.0, ldfld 0x04000003, ret.
+  EXPECT_FALSE(DbgClassProperty::GetReturnedConstant(
+      {0x02, 0x7B, 0x03, 0x00, 0x00, 0x04, 0x2A}, &constant));
+
+  // ldc.i4.1, ldc.i4.2, add, ret.
+  EXPECT_FALSE(DbgClassProperty::GetReturnedConstant({0x17, 0x18, 0x58, 0x2A},
+                                                     &constant));
+
+  // ldc.i4 without its operand.
+  EXPECT_FALSE(
+      DbgClassProperty::GetReturnedConstant({0x20, 0x01, 0x2A}, &constant));
+
+  // ldstr of a token that is not a user string.
+  EXPECT_FALSE(DbgClassProperty::GetReturnedConstant(
+      {0x72, 0x01, 0x00, 0x00, 0x04, 0x2A}, &constant));
+  EXPECT_EQ(constant.type, ELEMENT_TYPE_END);
+}
+
 }  // namespace google_cloud_debugger_test
@@ -17,10 +17,13 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include "ccomptr.h"
 #include "common_action_mocks.h"
+#include "cor_debug_helper.h"
 #include "dbg_class.h"
+#include "dbg_enum.h"
 #include "dbg_object.h"
 #include "dbg_object_factory.h"
 #include "i_cor_debug_mocks.h"
@@ -29,11 +32,15 @@
 #include "variable_wrapper.h"
 
 using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::CaptureLimits;
 using google_cloud_debugger::CComPtr;
 using google_cloud_debugger::ConvertStringToWCharPtr;
+using google_cloud_debugger::CorDebugHelper;
 using google_cloud_debugger::DbgClass;
+using google_cloud_debugger::DbgEnum;
 using google_cloud_debugger::DbgObject;
 using google_cloud_debugger::DbgObjectFactory;
+using google_cloud_debugger::IDbgClassMember;
 using google_cloud_debugger::VariableWrapper;
 using std::string;
 using std::unique_ptr;
@@ -53,7 +60,12 @@ class DbgClassTest : public ::testing::Test {
  protected:
   virtual void SetUp() {}
 
-  virtual void TearDown() { DbgClass::ClearStaticCache(); }
+  virtual void TearDown() {
+    DbgClass::ClearStaticCache();
+    DbgClass::ClearClassLayouts();
+    DbgEnum::ClearEnumLayouts();
+    CorDebugHelper::ClearParsedTypeSignatures();
+  }
 
   // Sets up class with element type as ELEMENT_TYPE_CLASS by default.
   void SetUpDbgClass(
@@ -622,7 +634,7 @@ TEST_F(DbgClassTest, TestPopulateMembers) {
       .WillRepeatedly(DoAll(SetArgPointee<2>(&property_), Return(S_OK)));
 
   hr = dbgclass->PopulateMembers(&variable, &variable_wrappers,
-                                 &eval_coordinator_);
+                                 CaptureLimits(), &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   EXPECT_EQ(variable_wrappers.size(), 3);
@@ -668,7 +680,7 @@ TEST_F(DbgClassTest, TestPopulateMembersBackingField) {
   // Nothing should be evaluated since we have the backing field.
   EXPECT_CALL(eval_coordinator_, CreateEval(_)).Times(0);
   hr = dbgclass->PopulateMembers(&variable, &variable_wrappers,
-                                 &eval_coordinator_);
+                                 CaptureLimits(), &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   EXPECT_EQ(variable_wrappers.size(), 2);
@@ -685,6 +697,182 @@ TEST_F(DbgClassTest, TestPopulateMembersBackingField) {
   EXPECT_EQ(variable.members(1).value(), std::to_string(second_field_value_));
 }
 
+// Tests that PopulateMembers skips the members that are never browsable,
+// including the backing field of a property that is never browsable.
+TEST_F(DbgClassTest, TestPopulateMembersNeverBrowsable) {
+  class_second_field_ = "<" + class_property_ + ">k__BackingField";
+  SetUpDbgClass();
+  SetUpBaseClass();
+  SetUpMetaDataImport();
+  SetUpClassField();
+  SetUpClassProperty();
+
+  // [DebuggerBrowsable(DebuggerBrowsableState.Never)] on the property.
+  static const uint8_t never_blob[] = {0x01, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x00};
+  ON_CALL(metadata_import_, GetCustomAttributeByName(property_def_[0], _, _, _))
+      .WillByDefault(
+          DoAll(SetArgPointee<2>(static_cast<const void *>(never_blob)),
+                SetArgPointee<3>(sizeof(never_blob)), Return(S_OK)));
+  ON_CALL(metadata_import_, GetCustomAttributeByName(field_defs_[0], _, _, _))
+      .WillByDefault(Return(S_FALSE));
+  ON_CALL(metadata_import_, GetCustomAttributeByName(field_defs_[1], _, _, _))
+      .WillByDefault(Return(S_FALSE));
+
+  Variable variable;
+  vector<VariableWrapper> variable_wrappers;
+  unique_ptr<DbgObject> dbgclass;
+  std::ostringstream err_stream;
+  HRESULT hr = object_factory_.CreateDbgClassObject(
+      &debug_type_, 1, &object_value_, FALSE, &dbgclass, &err_stream);
+
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  dbgclass->Initialize(&object_value_, FALSE);
+  hr = dbgclass->GetInitializeHr();
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  EXPECT_CALL(eval_coordinator_, CreateEval(_)).Times(0);
+  hr = dbgclass->PopulateMembers(&variable, &variable_wrappers,
+                                 CaptureLimits(), &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  EXPECT_EQ(variable_wrappers.size(), 1);
+  PopulateTypeAndValue(variable_wrappers);
+  EXPECT_EQ(variable.members_size(), 1);
+  EXPECT_EQ(variable.members(0).name(), class_first_field_);
+  EXPECT_EQ(variable.members(0).value(), std::to_string(first_field_value_));
+}
+
+// Tests that PopulateMembers captures an object of a class with a
+// DebuggerDisplay attribute as the string of its format.
+TEST_F(DbgClassTest, TestPopulateMembersDebuggerDisplay) {
+  SetUpDbgClass();
+  SetUpBaseClass();
+  SetUpMetaDataImport();
+  SetUpClassField();
+
+  // [DebuggerDisplay("{Field1} and {Field2}")] on the class.
+  string format = "{" + class_first_field_ + "} and {" +
+                  class_second_field_ + "}";
+  vector<uint8_t> display_blob = {0x01, 0x00,
+                                  static_cast<uint8_t>(format.size())};
+  display_blob.insert(display_blob.end(), format.begin(), format.end());
+  display_blob.insert(display_blob.end(), {0x00, 0x00});
+  ON_CALL(metadata_import_, GetCustomAttributeByName(class_token_, _, _, _))
+      .WillByDefault(DoAll(
+          SetArgPointee<2>(static_cast<const void *>(display_blob.data())),
+          SetArgPointee<3>(display_blob.size()), Return(S_OK)));
+
+  Variable variable;
+  vector<VariableWrapper> variable_wrappers;
+  unique_ptr<DbgObject> dbgclass;
+  std::ostringstream err_stream;
+  HRESULT hr = object_factory_.CreateDbgClassObject(
+      &debug_type_, 1, &object_value_, FALSE, &dbgclass, &err_stream);
+
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  dbgclass->Initialize(&object_value_, FALSE);
+  hr = dbgclass->GetInitializeHr();
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  CaptureLimits limits;
+  limits.debugger_display = true;
+  hr = dbgclass->PopulateMembers(&variable, &variable_wrappers, limits,
+                                 &eval_coordinator_);
+  EXPECT_EQ(hr, S_FALSE);
+  EXPECT_TRUE(variable_wrappers.empty());
+  EXPECT_EQ(variable.members_size(), 0);
+
+  hr = dbgclass->PopulateValue(&variable);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(variable.value(), std::to_string(first_field_value_) + " and " +
+                                  std::to_string(second_field_value_));
+}
+
+// Tests that the metadata of the members of a class is read only once
+// for all the objects of the class.
+TEST_F(DbgClassTest, TestPopulateMembersCachedLayout) {
+  class_second_field_ = "<" + class_property_ + ">k__BackingField";
+  SetUpDbgClass();
+  SetUpBaseClass();
+  SetUpMetaDataImport();
+  // The fields and the property are only enumerated and read once.
+  SetUpClassField();
+  SetUpClassProperty();
+
+  EXPECT_CALL(eval_coordinator_, CreateEval(_)).Times(0);
+  for (int i = 0; i < 2; ++i) {
+    Variable variable;
+    vector<VariableWrapper> variable_wrappers;
+    unique_ptr<DbgObject> dbgclass;
+    std::ostringstream err_stream;
+    HRESULT hr = object_factory_.CreateDbgClassObject(
+        &debug_type_, 1, &object_value_, FALSE, &dbgclass, &err_stream);
+
+    EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+    dbgclass->Initialize(&object_value_, FALSE);
+    hr = dbgclass->GetInitializeHr();
+    EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+    hr = dbgclass->PopulateMembers(&variable, &variable_wrappers,
+                                   CaptureLimits(), &eval_coordinator_);
+    EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+    EXPECT_EQ(variable_wrappers.size(), 2);
+
+    PopulateTypeAndValue(variable_wrappers);
+    EXPECT_EQ(variable.members_size(), 2);
+    EXPECT_EQ(variable.members(0).name(), class_first_field_);
+    EXPECT_EQ(variable.members(0).value(), std::to_string(first_field_value_));
+    EXPECT_EQ(variable.members(1).value(),
+              std::to_string(second_field_value_));
+  }
+}
+
+// Tests that the objects of a class processed on one thread share its
+// static members and that other threads get their own.
+TEST_F(DbgClassTest, TestStaticMembersCachedPerThread) {
+  second_field_attr_ = fdStatic;
+  SetUpDbgClass();
+  SetUpBaseClass();
+  SetUpMetaDataImport();
+  SetUpClassField();
+
+  // Returns the static field of a new object of the class.
+  auto get_static_field = [this](std::shared_ptr<IDbgClassMember> *field) {
+    unique_ptr<DbgObject> dbgclass;
+    std::ostringstream err_stream;
+    HRESULT hr = object_factory_.CreateDbgClassObject(
+        &debug_type_, 1, &object_value_, FALSE, &dbgclass, &err_stream);
+    EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+    dbgclass->Initialize(&object_value_, FALSE);
+
+    DbgClass *class_obj = dynamic_cast<DbgClass *>(dbgclass.get());
+    ASSERT_TRUE(class_obj != nullptr);
+    EXPECT_EQ(class_obj->ProcessClassMembers(), S_OK);
+    ASSERT_EQ(class_obj->GetFields().size(), 2);
+    *field = class_obj->GetFields()[1];
+    EXPECT_TRUE((*field)->IsStatic());
+  };
+
+  std::shared_ptr<IDbgClassMember> first_field;
+  std::shared_ptr<IDbgClassMember> second_field;
+  std::shared_ptr<IDbgClassMember> other_thread_field;
+  get_static_field(&first_field);
+  get_static_field(&second_field);
+  std::thread other_thread(get_static_field, &other_thread_field);
+  other_thread.join();
+
+  EXPECT_EQ(first_field, second_field);
+  ASSERT_TRUE(other_thread_field != nullptr);
+  EXPECT_NE(first_field, other_thread_field);
+
+  // Clearing the cache of this thread makes the next object read the
+  // static field again.
+  DbgClass::ClearStaticCache();
+  get_static_field(&second_field);
+  EXPECT_NE(first_field, second_field);
+}
+
 // Test error cases for PopulateMembers function.
 TEST_F(DbgClassTest, TestPopulateMembersError) {
   SetUpDbgClass();
@@ -706,12 +894,14 @@ TEST_F(DbgClassTest, TestPopulateMembersError) {
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // Null check.
-  EXPECT_EQ(dbgclass->PopulateMembers(&variable, &variable_wrappers, nullptr),
+  EXPECT_EQ(dbgclass->PopulateMembers(&variable, &variable_wrappers,
+                                      CaptureLimits(), nullptr),
             E_INVALIDARG);
-  EXPECT_EQ(dbgclass->PopulateMembers(&variable, nullptr, nullptr),
+  EXPECT_EQ(dbgclass->PopulateMembers(&variable, nullptr, CaptureLimits(),
+                                      nullptr),
             E_INVALIDARG);
   EXPECT_EQ(dbgclass->PopulateMembers(nullptr, &variable_wrappers,
-                                      &eval_coordinator_),
+                                      CaptureLimits(), &eval_coordinator_),
             E_INVALIDARG);
 
   // Debug module should return the correct property getter function.
@@ -726,7 +916,7 @@ TEST_F(DbgClassTest, TestPopulateMembersError) {
 
   // This should still return S_OK (but the property value not populated).
   EXPECT_EQ(dbgclass->PopulateMembers(&variable, &variable_wrappers,
-                                      &eval_coordinator_),
+                                      CaptureLimits(), &eval_coordinator_),
             S_OK);
 
   // Only 2 VariableWrapper should be returned as the third one is an error.
@@ -792,6 +982,41 @@ TEST_F(DbgClassTest, TestEnum) {
   EXPECT_EQ(variable.value(), class_second_field_);
 }
 
+// Tests the case where the value of an enum combines flags.
+TEST_F(DbgClassTest, TestEnumFlags) {
+  base_class_name_ = "System.Enum";
+  class_first_field_ = "value__";
+  COR_SIGNATURE enum_type = CorElementType::ELEMENT_TYPE_I1;
+  first_field_sig_ = &enum_type;
+
+  // The enum value has the bits of the second field and one more, so it
+  // is named after the second field.
+  uint8_t flag_value = 4;
+  enum_value_ = 5;
+  second_field_default_value_ = &flag_value;
+  second_field_attr_ = fdStatic;
+
+  SetUpDbgClass(CorElementType::ELEMENT_TYPE_VALUETYPE);
+  SetUpBaseClass();
+  SetUpMetaDataImport();
+  SetUpClassField();
+  SetUpEnum();
+
+  unique_ptr<DbgObject> dbgclass;
+  std::ostringstream err_stream;
+  HRESULT hr = object_factory_.CreateDbgClassObject(
+      &debug_type_, 1, &object_value_, FALSE, &dbgclass, &err_stream);
+
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  dbgclass->Initialize(&object_value_, FALSE);
+  hr = dbgclass->GetInitializeHr();
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Variable variable;
+  EXPECT_EQ(dbgclass->PopulateValue(&variable), S_OK);
+  EXPECT_EQ(variable.value(), class_second_field_);
+}
+
 // Tests the error case where the object is an enum.
 TEST_F(DbgClassTest, TestEnumError) {
   // Makes the base class System.Enum.
@@ -0,0 +1,97 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+#include "dbg_object_pool.h"
+
+using google_cloud_debugger::DbgObjectPool;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Tests that objects are aligned and do not overlap.
+TEST(DbgObjectPoolTest, AllocateDistinctObjects) {
+  DbgObjectPool pool;
+  vector<char *> objects;
+  for (int i = 0; i < 100; ++i) {
+    char *object = static_cast<char *>(pool.Allocate(40));
+    ASSERT_NE(object, nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(object) %
+                  DbgObjectPool::kAlignment,
+              0u);
+    for (char *other : objects) {
+      EXPECT_TRUE(object + 40 <= other || other + 40 <= object);
+    }
+    objects.push_back(object);
+  }
+  EXPECT_EQ(pool.GetLiveObjects(), 100u);
+  EXPECT_EQ(pool.GetSlabCount(), 1u);
+
+  for (char *object : objects) {
+    pool.Free(object, 40);
+  }
+  EXPECT_EQ(pool.GetLiveObjects(), 0u);
+}
+
+// Tests that a freed object is reused by an object of the same size.
+TEST(DbgObjectPoolTest, ReuseFreedObject) {
+  DbgObjectPool pool;
+  void *first = pool.Allocate(24);
+  void *second = pool.Allocate(24);
+  pool.Free(first, 24);
+
+  EXPECT_EQ(pool.Allocate(20), first);
+  EXPECT_NE(pool.Allocate(24), second);
+  EXPECT_EQ(pool.GetLiveObjects(), 3u);
+}
+
+// Tests that the slabs are only freed once all objects are freed.
+TEST(DbgObjectPoolTest, ReleaseIfUnused) {
+  DbgObjectPool pool;
+  size_t objects_per_slab = DbgObjectPool::kSlabSize / 64;
+  vector<void *> objects;
+  for (size_t i = 0; i <= objects_per_slab; ++i) {
+    objects.push_back(pool.Allocate(64));
+  }
+  EXPECT_EQ(pool.GetSlabCount(), 2u);
+
+  pool.Free(objects.back(), 64);
+  objects.pop_back();
+  EXPECT_FALSE(pool.ReleaseIfUnused());
+  EXPECT_EQ(pool.GetSlabCount(), 2u);
+
+  for (void *object : objects) {
+    pool.Free(object, 64);
+  }
+  EXPECT_TRUE(pool.ReleaseIfUnused());
+  EXPECT_EQ(pool.GetSlabCount(), 0u);
+
+  EXPECT_NE(pool.Allocate(64), nullptr);
+  EXPECT_EQ(pool.GetSlabCount(), 1u);
+}
+
+// Tests that large objects are not counted as objects of the slabs.
+TEST(DbgObjectPoolTest, LargeObjects) {
+  DbgObjectPool pool;
+  void *object = pool.Allocate(DbgObjectPool::kMaxObjectSize + 1);
+  ASSERT_NE(object, nullptr);
+  EXPECT_EQ(pool.GetLiveObjects(), 0u);
+  EXPECT_EQ(pool.GetSlabCount(), 0u);
+  pool.Free(object, DbgObjectPool::kMaxObjectSize + 1);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -39,10 +39,11 @@ class DbgReferenceObjectMock
                HRESULT(google::cloud::diagnostics::debug::Variable *variable));
   MOCK_METHOD1(GetTypeSignature,
                HRESULT(google_cloud_debugger::TypeSignature *type_signature));
-  MOCK_METHOD3(
+  MOCK_METHOD4(
       PopulateMembers,
       HRESULT(google::cloud::diagnostics::debug::Variable *variable_proto,
               std::vector<google_cloud_debugger::VariableWrapper> *members,
+              const google_cloud_debugger::CaptureLimits &limits,
               google_cloud_debugger::IEvalCoordinator *eval_coordinator));
   MOCK_METHOD2(GetICorDebugValue, HRESULT(ICorDebugValue **debug_value,
                                           ICorDebugEval *debug_eval));
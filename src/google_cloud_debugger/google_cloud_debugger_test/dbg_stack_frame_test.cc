@@ -15,6 +15,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <cstdint>
+#include <iostream>
 #include <string>
 
 #include "ccomptr.h"
@@ -29,14 +30,18 @@
 
 using google::cloud::diagnostics::debug::StackFrame;
 using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::CaptureLimits;
 using google_cloud_debugger::ConvertStringToWCharPtr;
 using google_cloud_debugger::CorDebugHelper;
+using google_cloud_debugger::DbgObject;
 using google_cloud_debugger::DbgObjectFactory;
 using google_cloud_debugger::DbgStackFrame;
 using google_cloud_debugger::ICorDebugHelper;
 using google_cloud_debugger::IDbgObjectFactory;
+using google_cloud_debugger::VariableSlot;
 using google_cloud_debugger_portable_pdb::LocalConstantInfo;
 using google_cloud_debugger_portable_pdb::LocalVariableInfo;
+using google_cloud_debugger_portable_pdb::StringPool;
 using std::string;
 using std::vector;
 using ::testing::_;
@@ -107,9 +112,10 @@ class DbgStackFrameTest : public ::testing::Test {
     // Sets up LocalVariableInfo vector, which is used to retrieve
     // name of a variable based on its position.
     local_variables_info_.resize(2);
-    local_variables_info_[0].name = first_local_var_.name_;
+    local_variables_info_[0].name = StringPool::Intern(first_local_var_.name_);
     local_variables_info_[0].slot = first_local_var_.slot_;
-    local_variables_info_[1].name = second_local_var_.name_;
+    local_variables_info_[1].name =
+        StringPool::Intern(second_local_var_.name_);
     local_variables_info_[1].slot = second_local_var_.slot_;
 
     // Sets up the ICorDebugValue that represents the variables.
@@ -356,7 +362,7 @@ TEST_F(DbgStackFrameTest, TestPopulateStackFrame) {
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   hr = stack_frame.PopulateStackFrame(&proto_stack_frame, 2000,
-                                      &eval_coordinator_);
+                                      CaptureLimits(), &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // Checks that the frame has the correct local variables.
@@ -378,6 +384,122 @@ TEST_F(DbgStackFrameTest, TestPopulateStackFrame) {
             std::to_string(second_method_arg_.value_));
 }
 
+// Tests that deferred variables are only created when they are looked up
+// or when CreateDeferredVariables is called.
+TEST_F(DbgStackFrameTest, TestDeferVariableCreation) {
+  DbgStackFrame stack_frame(debug_helper_, dbg_object_factory_);
+  stack_frame.SetDeferVariableCreation(true);
+
+  SetUpLocalVariables();
+  SetUpMethodArguments();
+  SetUpMetaDataImport();
+
+  HRESULT hr = stack_frame.Initialize(
+      &frame_mock_, local_variables_info_, local_constants_info_,
+      method_token_, &metadata_import_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  std::shared_ptr<DbgObject> variable;
+  hr = stack_frame.GetLocalVariable(second_local_var_.name_, &variable,
+                                    &std::cerr);
+  EXPECT_EQ(hr, S_OK);
+  EXPECT_TRUE(variable != nullptr);
+
+  hr = stack_frame.GetLocalVariable(first_method_arg_.name_, &variable,
+                                    &std::cerr);
+  EXPECT_EQ(hr, S_OK);
+  EXPECT_TRUE(variable != nullptr);
+
+  // Only the variables looked up have values.
+  StackFrame proto_stack_frame;
+  hr = stack_frame.PopulateStackFrame(&proto_stack_frame, 2000,
+                                      CaptureLimits(), &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(proto_stack_frame.locals().size(), 2);
+  EXPECT_EQ(proto_stack_frame.locals(0).value(), "");
+  EXPECT_EQ(proto_stack_frame.locals(1).value(),
+            std::to_string(second_local_var_.value_));
+  ASSERT_EQ(proto_stack_frame.arguments().size(), 2);
+  EXPECT_EQ(proto_stack_frame.arguments(0).value(),
+            std::to_string(first_method_arg_.value_));
+  EXPECT_EQ(proto_stack_frame.arguments(1).value(), "");
+
+  stack_frame.CreateDeferredVariables();
+  proto_stack_frame.Clear();
+  hr = stack_frame.PopulateStackFrame(&proto_stack_frame, 2000,
+                                      CaptureLimits(), &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(proto_stack_frame.locals().size(), 2);
+  EXPECT_EQ(proto_stack_frame.locals(0).value(),
+            std::to_string(first_local_var_.value_));
+  ASSERT_EQ(proto_stack_frame.arguments().size(), 2);
+  EXPECT_EQ(proto_stack_frame.arguments(1).value(),
+            std::to_string(second_method_arg_.value_));
+}
+
+// Tests that local variables and method arguments are found by their
+// slots.
+TEST_F(DbgStackFrameTest, TestLocalVariableSlots) {
+  DbgStackFrame stack_frame(debug_helper_, dbg_object_factory_);
+  stack_frame.SetDeferVariableCreation(true);
+
+  SetUpLocalVariables();
+  SetUpMethodArguments();
+  SetUpMetaDataImport();
+
+  HRESULT hr = stack_frame.Initialize(
+      &frame_mock_, local_variables_info_, local_constants_info_,
+      method_token_, &metadata_import_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  VariableSlot local_slot;
+  EXPECT_EQ(stack_frame.GetLocalVariableSlot(second_local_var_.name_,
+                                             &local_slot),
+            S_OK);
+  EXPECT_EQ(local_slot.kind, VariableSlot::Kind::kLocalVariable);
+  EXPECT_EQ(local_slot.index, second_local_var_.slot_);
+
+  VariableSlot argument_slot;
+  EXPECT_EQ(stack_frame.GetLocalVariableSlot(second_method_arg_.name_,
+                                             &argument_slot),
+            S_OK);
+  EXPECT_EQ(argument_slot.kind, VariableSlot::Kind::kMethodArgument);
+  EXPECT_EQ(argument_slot.index, 1u);
+
+  VariableSlot missing_slot;
+  EXPECT_EQ(stack_frame.GetLocalVariableSlot("Missing", &missing_slot),
+            S_FALSE);
+
+  std::shared_ptr<DbgObject> variable;
+  EXPECT_EQ(stack_frame.GetLocalVariableBySlot(local_slot, &variable), S_OK);
+  EXPECT_TRUE(variable != nullptr);
+
+  variable.reset();
+  EXPECT_EQ(stack_frame.GetLocalVariableBySlot(argument_slot, &variable),
+            S_OK);
+  EXPECT_TRUE(variable != nullptr);
+
+  argument_slot.index = 2;
+  EXPECT_EQ(stack_frame.GetLocalVariableBySlot(argument_slot, &variable),
+            S_FALSE);
+  EXPECT_EQ(stack_frame.GetLocalVariableBySlot(missing_slot, &variable),
+            S_FALSE);
+
+  // Only the variables read by their slots have values.
+  StackFrame proto_stack_frame;
+  hr = stack_frame.PopulateStackFrame(&proto_stack_frame, 2000,
+                                      CaptureLimits(), &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(proto_stack_frame.locals().size(), 2);
+  EXPECT_EQ(proto_stack_frame.locals(0).value(), "");
+  EXPECT_EQ(proto_stack_frame.locals(1).value(),
+            std::to_string(second_local_var_.value_));
+  ASSERT_EQ(proto_stack_frame.arguments().size(), 2);
+  EXPECT_EQ(proto_stack_frame.arguments(0).value(), "");
+  EXPECT_EQ(proto_stack_frame.arguments(1).value(),
+            std::to_string(second_method_arg_.value_));
+}
+
 // Tests the PopulateStackFrame function of DbgStackFrame when we restrict
 // the amount of information that can be populated into the proto.
 TEST_F(DbgStackFrameTest, TestPopulateStackFrameRestricted) {
@@ -394,7 +516,7 @@ TEST_F(DbgStackFrameTest, TestPopulateStackFrameRestricted) {
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   hr = stack_frame.PopulateStackFrame(&proto_stack_frame, 100,
-                                      &eval_coordinator_);
+                                      CaptureLimits(), &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // Checks that the frame has the correct local variables.
@@ -435,7 +557,7 @@ TEST_F(DbgStackFrameTest, TestPopulateStackFrameSparse) {
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   hr = stack_frame.PopulateStackFrame(&proto_stack_frame, 2000,
-                                      &eval_coordinator_);
+                                      CaptureLimits(), &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // Checks that the frame has the correct local variables.
@@ -473,10 +595,52 @@ TEST_F(DbgStackFrameTest, TestPopulateStackFrameError) {
       method_token_, &metadata_import_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
-  EXPECT_EQ(stack_frame.PopulateStackFrame(nullptr, 2000, &eval_coordinator_),
+  EXPECT_EQ(stack_frame.PopulateStackFrame(nullptr, 2000, CaptureLimits(),
+                                           &eval_coordinator_),
             E_INVALIDARG);
-  EXPECT_EQ(stack_frame.PopulateStackFrame(&proto_stack_frame, 2000, nullptr),
+  EXPECT_EQ(stack_frame.PopulateStackFrame(&proto_stack_frame, 2000,
+                                           CaptureLimits(), nullptr),
             E_INVALIDARG);
 }
 
+// Tests that a frame at the same local scopes of a method reuses the
+// names read by the first frame instead of reading them again.
+TEST_F(DbgStackFrameTest, TestInitializeWithCachedLayout) {
+  DbgStackFrame::RemoveMethodFrameLayouts(&metadata_import_);
+  SetUpLocalVariables();
+  SetUpMethodArguments();
+  SetUpMetaDataImport();
+
+  DbgStackFrame first_frame(debug_helper_, dbg_object_factory_);
+  first_frame.SetLocalScopeIndices({1, 3});
+  HRESULT hr = first_frame.Initialize(&frame_mock_, local_variables_info_,
+                                      local_constants_info_, method_token_,
+                                      &metadata_import_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  // The values are read again, while GetMethodProps and EnumParams are
+  // not called again and the variable infos are not needed.
+  SetUpLocalVariables();
+  SetUpMethodArguments();
+  DbgStackFrame second_frame(debug_helper_, dbg_object_factory_);
+  second_frame.SetLocalScopeIndices({1, 3});
+  hr = second_frame.Initialize(&frame_mock_, vector<LocalVariableInfo>(),
+                               local_constants_info_, method_token_,
+                               &metadata_import_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  StackFrame proto_stack_frame;
+  hr = second_frame.PopulateStackFrame(&proto_stack_frame, 2000,
+                                       CaptureLimits(), &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(proto_stack_frame.locals().size(), 2);
+  EXPECT_EQ(proto_stack_frame.locals(1).name(), second_local_var_.name_);
+  EXPECT_EQ(proto_stack_frame.locals(1).value(),
+            std::to_string(second_local_var_.value_));
+  ASSERT_EQ(proto_stack_frame.arguments().size(), 2);
+  EXPECT_EQ(proto_stack_frame.arguments(0).name(), first_method_arg_.name_);
+
+  DbgStackFrame::RemoveMethodFrameLayouts(&metadata_import_);
+}
+
 }  // namespace google_cloud_debugger_test
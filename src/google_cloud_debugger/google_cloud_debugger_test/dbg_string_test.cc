@@ -16,12 +16,14 @@
 #include <gtest/gtest.h>
 #include <string>
 
+#include "capture_limits.h"
 #include "class_names.h"
 #include "common_action_mocks.h"
 #include "cor_debug_helper.h"
 #include "i_cor_debug_mocks.h"
 
 using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::CaptureLimits;
 using google_cloud_debugger::ConvertStringToWCharPtr;
 using google_cloud_debugger::CorDebugHelper;
 using google_cloud_debugger::DbgString;
@@ -185,4 +187,74 @@ TEST_F(DbgStringTest, GetStringError) {
   }
 }
 
+// Tests that PopulateValueWithinLimits only reads the beginning of a
+// string that is longer than the limit.
+TEST_F(DbgStringTest, PopulateValueWithinLimits) {
+  static const string test_string_value = "This is a test string";
+  static const uint32_t max_length = 6;
+
+  vector<WCHAR> wchar_string = ConvertStringToWCharPtr(test_string_value);
+
+  // Only the limit plus 1 character and the NULL are requested.
+  EXPECT_CALL(string_value_, GetLength(_))
+      .Times(1)
+      .WillRepeatedly(DoAll(SetArgPointee<0>(test_string_value.size()),
+                            Return(S_OK)));
+  EXPECT_CALL(string_value_, GetString(max_length + 2, _, _))
+      .Times(1)
+      .WillRepeatedly(
+          DoAll(SetArrayArgument<2>(wchar_string.data(),
+                                    wchar_string.data() + max_length + 1),
+                Return(S_OK)));
+
+  DbgString dbg_string(nullptr, debug_helper_);
+  SetUpString();
+  dbg_string.Initialize(&string_value_, FALSE);
+
+  CaptureLimits limits;
+  limits.max_string_length = max_length;
+  Variable variable;
+  EXPECT_EQ(dbg_string.PopulateValueWithinLimits(&variable, limits), S_OK);
+
+  EXPECT_EQ(variable.value(), test_string_value.substr(0, max_length + 1));
+  EXPECT_FALSE(variable.status().iserror());
+  EXPECT_NE(variable.status().message().find(
+                std::to_string(test_string_value.size())),
+            string::npos);
+}
+
+// Tests that PopulateValueWithinLimits keeps a string that fits in the
+// limit so that it is not read again.
+TEST_F(DbgStringTest, PopulateValueWithinLimitsShortString) {
+  static const string test_string_value = "Short";
+
+  vector<WCHAR> wchar_string = ConvertStringToWCharPtr(test_string_value);
+  uint32_t string_size = wchar_string.size();
+
+  EXPECT_CALL(string_value_, GetLength(_))
+      .Times(1)
+      .WillRepeatedly(DoAll(SetArgPointee<0>(string_size - 1), Return(S_OK)));
+  EXPECT_CALL(string_value_, GetString(string_size, _, _))
+      .Times(1)
+      .WillRepeatedly(
+          DoAll(SetArrayArgument<2>(wchar_string.data(),
+                                    wchar_string.data() + string_size),
+                Return(S_OK)));
+
+  DbgString dbg_string(nullptr, debug_helper_);
+  SetUpString();
+  dbg_string.Initialize(&string_value_, FALSE);
+
+  CaptureLimits limits;
+  limits.max_string_length = 10;
+  Variable variable;
+  EXPECT_EQ(dbg_string.PopulateValueWithinLimits(&variable, limits), S_OK);
+  EXPECT_EQ(variable.value(), test_string_value);
+  EXPECT_FALSE(variable.has_status());
+
+  std::string returned_string;
+  EXPECT_EQ(DbgString::GetString(&dbg_string, &returned_string), S_OK);
+  EXPECT_EQ(returned_string, test_string_value);
+}
+
 }  // namespace google_cloud_debugger_test
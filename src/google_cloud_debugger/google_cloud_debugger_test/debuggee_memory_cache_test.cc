@@ -0,0 +1,153 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+#include "constants.h"
+#include "debuggee_memory_cache.h"
+#include "i_cor_debug_mocks.h"
+
+using google_cloud_debugger::DebuggeeMemoryCache;
+using google_cloud_debugger::kDebuggeeMemoryPageSize;
+using google_cloud_debugger::kMaximumCachedDebuggeeMemoryReadPages;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+namespace google_cloud_debugger_test {
+
+// The address of the first page the tests read.
+static const CORDB_ADDRESS kFirstPage = 0x10000;
+
+// Fills buffer with the low byte of the address of each byte.
+static HRESULT ReadAddressBytes(CORDB_ADDRESS address, DWORD size,
+                                BYTE buffer[], SIZE_T *read) {
+  for (DWORD i = 0; i < size; ++i) {
+    buffer[i] = static_cast<BYTE>(address + i);
+  }
+  *read = size;
+  return S_OK;
+}
+
+// Test fixture for DebuggeeMemoryCache.
+class DebuggeeMemoryCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    ON_CALL(process_, ReadMemory(_, _, _, _))
+        .WillByDefault(Invoke(ReadAddressBytes));
+  }
+
+  virtual void TearDown() { DebuggeeMemoryCache::SetCurrent(nullptr); }
+
+  // Reads size bytes at address through DebuggeeMemoryCache::ReadMemory
+  // and checks that they are the bytes of the address.
+  void CheckRead(CORDB_ADDRESS address, std::size_t size) {
+    std::vector<BYTE> buffer(size);
+    EXPECT_EQ(DebuggeeMemoryCache::ReadMemory(&process_, address, size,
+                                              buffer.data()),
+              S_OK);
+    for (std::size_t i = 0; i < size; ++i) {
+      EXPECT_EQ(buffer[i], static_cast<BYTE>(address + i));
+    }
+  }
+
+  ICorDebugProcessMock process_;
+};
+
+// Tests that reads within the cached pages do not read the debuggee again
+// until the cache is cleared.
+TEST_F(DebuggeeMemoryCacheTest, ReadsPageOnce) {
+  DebuggeeMemoryCache cache;
+  DebuggeeMemoryCache::SetCurrent(&cache);
+  EXPECT_CALL(process_,
+              ReadMemory(kFirstPage, kDebuggeeMemoryPageSize, _, _))
+      .Times(1);
+  CheckRead(kFirstPage + 16, 24);
+  CheckRead(kFirstPage + 100, 8);
+  CheckRead(kFirstPage, kDebuggeeMemoryPageSize);
+  EXPECT_EQ(cache.GetPageCount(), 1u);
+
+  // The debuggee ran, so the page is read again.
+  cache.Clear();
+  EXPECT_CALL(process_,
+              ReadMemory(kFirstPage, kDebuggeeMemoryPageSize, _, _))
+      .Times(1);
+  CheckRead(kFirstPage + 16, 24);
+}
+
+// Tests that a read across pages only reads the pages that are not
+// cached, with one call.
+TEST_F(DebuggeeMemoryCacheTest, ReadsMissingPagesTogether) {
+  DebuggeeMemoryCache cache;
+  DebuggeeMemoryCache::SetCurrent(&cache);
+  EXPECT_CALL(process_,
+              ReadMemory(kFirstPage, kDebuggeeMemoryPageSize, _, _))
+      .Times(1);
+  CheckRead(kFirstPage + 8, 8);
+
+  EXPECT_CALL(process_, ReadMemory(kFirstPage + kDebuggeeMemoryPageSize,
+                                   2 * kDebuggeeMemoryPageSize, _, _))
+      .Times(1);
+  CheckRead(kFirstPage + kDebuggeeMemoryPageSize - 4,
+            2 * kDebuggeeMemoryPageSize);
+  EXPECT_EQ(cache.GetPageCount(), 3u);
+}
+
+// Tests that reads spanning many pages are not cached.
+TEST_F(DebuggeeMemoryCacheTest, DoesNotCacheLargeReads) {
+  DebuggeeMemoryCache cache;
+  DebuggeeMemoryCache::SetCurrent(&cache);
+  std::size_t size =
+      (kMaximumCachedDebuggeeMemoryReadPages + 1) * kDebuggeeMemoryPageSize;
+  EXPECT_CALL(process_, ReadMemory(kFirstPage, size, _, _)).Times(2);
+  CheckRead(kFirstPage, size);
+  CheckRead(kFirstPage, size);
+  EXPECT_EQ(cache.GetPageCount(), 0u);
+}
+
+// Tests that the requested bytes are read by themselves if their pages
+// cannot be read.
+TEST_F(DebuggeeMemoryCacheTest, ReadsBytesIfPageFails) {
+  DebuggeeMemoryCache cache;
+  DebuggeeMemoryCache::SetCurrent(&cache);
+  EXPECT_CALL(process_,
+              ReadMemory(kFirstPage, kDebuggeeMemoryPageSize, _, _))
+      .WillOnce(Return(E_FAIL));
+  EXPECT_CALL(process_, ReadMemory(kFirstPage + 16, 24, _, _)).Times(1);
+  CheckRead(kFirstPage + 16, 24);
+  EXPECT_EQ(cache.GetPageCount(), 0u);
+}
+
+// Tests that every read goes to the debuggee without a cache.
+TEST_F(DebuggeeMemoryCacheTest, ReadsEveryTimeWithoutCache) {
+  EXPECT_CALL(process_, ReadMemory(kFirstPage + 16, 24, _, _)).Times(2);
+  CheckRead(kFirstPage + 16, 24);
+  CheckRead(kFirstPage + 16, 24);
+}
+
+// Tests that a failed read is reported.
+TEST_F(DebuggeeMemoryCacheTest, FailsIfBytesCannotBeRead) {
+  DebuggeeMemoryCache cache;
+  DebuggeeMemoryCache::SetCurrent(&cache);
+  EXPECT_CALL(process_, ReadMemory(_, _, _, _))
+      .WillRepeatedly(Return(E_FAIL));
+  BYTE buffer[8];
+  EXPECT_EQ(DebuggeeMemoryCache::ReadMemory(&process_, kFirstPage, 8, buffer),
+            E_FAIL);
+}
+
+}  // namespace google_cloud_debugger_test
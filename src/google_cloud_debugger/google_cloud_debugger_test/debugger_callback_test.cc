@@ -82,6 +82,10 @@ class DebuggerCallbackTest : public ::testing::Test {
         .Times(1)
         .WillRepeatedly(DoAll(SetArgPointee<0>(&debug_module_), Return(S_OK)));
 
+    EXPECT_CALL(debug_module_, GetBaseAddress(_))
+        .Times(1)
+        .WillRepeatedly(Return(S_OK));
+
     EXPECT_CALL(debug_module_, GetMetaDataInterface(_, _))
         .Times(1)
         .WillRepeatedly(
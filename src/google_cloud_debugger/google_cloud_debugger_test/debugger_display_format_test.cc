@@ -0,0 +1,74 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "debugger_display_format.h"
+
+using google_cloud_debugger::DebuggerDisplayFormat;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a format is split into its text and the member paths of
+// its expressions.
+TEST(DebuggerDisplayFormatTest, Parse) {
+  DebuggerDisplayFormat format;
+  ASSERT_TRUE(format.Parse("Order {Id}: {Customer.Name,nq} \\{x\\}"));
+
+  const vector<DebuggerDisplayFormat::Segment> &segments =
+      format.GetSegments();
+  ASSERT_EQ(segments.size(), 3);
+  EXPECT_EQ(segments[0].text, "Order ");
+  EXPECT_EQ(segments[0].member_path, vector<string>({"Id"}));
+  EXPECT_TRUE(segments[0].quote_strings);
+  EXPECT_EQ(segments[1].text, ": ");
+  EXPECT_EQ(segments[1].member_path, vector<string>({"Customer", "Name"}));
+  EXPECT_FALSE(segments[1].quote_strings);
+  EXPECT_EQ(segments[2].text, " {x}");
+  EXPECT_TRUE(segments[2].member_path.empty());
+}
+
+// Tests that expressions that are not members are not supported.
+TEST(DebuggerDisplayFormatTest, ParseUnsupported) {
+  DebuggerDisplayFormat format;
+  EXPECT_FALSE(format.Parse("{Count()}"));
+  EXPECT_FALSE(format.Parse("{Id + 1}"));
+  EXPECT_FALSE(format.Parse("{Id,h}"));
+  EXPECT_FALSE(format.Parse("{Id"));
+  EXPECT_TRUE(format.GetSegments().empty());
+}
+
+// Tests that the format is read from the blob of the attribute.
+TEST(DebuggerDisplayFormatTest, ReadAttributeArgument) {
+  const uint8_t blob[] = {0x01, 0x00, 0x04, '{', 'I', 'd', '}', 0x00, 0x00};
+  string format;
+  ASSERT_TRUE(DebuggerDisplayFormat::ReadAttributeArgument(blob, sizeof(blob),
+                                                           &format));
+  EXPECT_EQ(format, "{Id}");
+
+  const uint8_t null_string[] = {0x01, 0x00, 0xFF, 0x00, 0x00};
+  EXPECT_FALSE(DebuggerDisplayFormat::ReadAttributeArgument(
+      null_string, sizeof(null_string), &format));
+
+  const uint8_t truncated[] = {0x01, 0x00, 0x08, '{', 'I', 'd', '}'};
+  EXPECT_FALSE(DebuggerDisplayFormat::ReadAttributeArgument(
+      truncated, sizeof(truncated), &format));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,131 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "ccomptr.h"
+#include "cor_debug_helper.h"
+#include "dereference_cache.h"
+#include "i_cor_debug_mocks.h"
+
+using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::CorDebugHelper;
+using google_cloud_debugger::DereferenceCache;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a value is found by the address of its object until the
+// cache is cleared, and that null references are not cached.
+TEST(DereferenceCacheTest, FindsValueByAddress) {
+  DereferenceCache cache;
+  ICorDebugObjectValueMock object_value;
+  CComPtr<ICorDebugValue> found;
+  EXPECT_FALSE(cache.Find(100, &found));
+
+  cache.Add(100, &object_value);
+  cache.Add(0, &object_value);
+  EXPECT_EQ(cache.GetSize(), 1u);
+  ASSERT_TRUE(cache.Find(100, &found));
+  EXPECT_EQ(static_cast<ICorDebugValue *>(found), &object_value);
+  EXPECT_FALSE(cache.Find(0, &found));
+
+  cache.Clear();
+  EXPECT_FALSE(cache.Find(100, &found));
+  EXPECT_EQ(cache.GetSize(), 0u);
+}
+
+// Test fixture for the dereferences of CorDebugHelper.
+class DereferenceCacheHelperTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    ON_CALL(reference_value_,
+            QueryInterface(__uuidof(ICorDebugReferenceValue), _))
+        .WillByDefault(
+            DoAll(SetArgPointee<1>(&reference_value_), Return(S_OK)));
+    ON_CALL(reference_value_, GetValue(_))
+        .WillByDefault(DoAll(SetArgPointee<0>(100), Return(S_OK)));
+    ON_CALL(reference_value_, IsNull(_))
+        .WillByDefault(DoAll(SetArgPointee<0>(FALSE), Return(S_OK)));
+    ON_CALL(reference_value_, Dereference(_))
+        .WillByDefault(DoAll(SetArgPointee<0>(&object_value_), Return(S_OK)));
+    ON_CALL(object_value_, QueryInterface(_, _))
+        .WillByDefault(Return(E_NOINTERFACE));
+  }
+
+  virtual void TearDown() { DereferenceCache::SetCurrent(nullptr); }
+
+  // Dereferences reference_value_ and checks that it gives object_value_.
+  void CheckDereference() {
+    CComPtr<ICorDebugValue> dereferenced_value;
+    BOOL is_null = TRUE;
+    EXPECT_EQ(helper_.Dereference(&reference_value_, &dereferenced_value,
+                                  &is_null, &std::cerr),
+              S_OK);
+    EXPECT_FALSE(is_null);
+    EXPECT_EQ(static_cast<ICorDebugValue *>(dereferenced_value),
+              &object_value_);
+  }
+
+  ICorDebugReferenceValueMock reference_value_;
+  ICorDebugObjectValueMock object_value_;
+  CorDebugHelper helper_;
+};
+
+// Tests that a reference is dereferenced once while a cache is current.
+TEST_F(DereferenceCacheHelperTest, DereferencesOnceWithCache) {
+  DereferenceCache cache;
+  DereferenceCache::SetCurrent(&cache);
+  EXPECT_CALL(reference_value_, Dereference(_)).Times(1);
+  for (int i = 0; i < 3; ++i) {
+    CheckDereference();
+  }
+
+  // The debuggee ran, so the reference is dereferenced again.
+  cache.Clear();
+  EXPECT_CALL(reference_value_, Dereference(_)).Times(1);
+  CheckDereference();
+}
+
+// Tests that a reference is dereferenced every time without a cache.
+TEST_F(DereferenceCacheHelperTest, DereferencesEveryTimeWithoutCache) {
+  EXPECT_CALL(reference_value_, Dereference(_)).Times(2);
+  CheckDereference();
+  CheckDereference();
+}
+
+// Tests that a null reference is not cached.
+TEST_F(DereferenceCacheHelperTest, DoesNotCacheNullReference) {
+  ON_CALL(reference_value_, GetValue(_))
+      .WillByDefault(DoAll(SetArgPointee<0>(0), Return(S_OK)));
+  ON_CALL(reference_value_, IsNull(_))
+      .WillByDefault(DoAll(SetArgPointee<0>(TRUE), Return(S_OK)));
+
+  DereferenceCache cache;
+  DereferenceCache::SetCurrent(&cache);
+  CComPtr<ICorDebugValue> dereferenced_value;
+  BOOL is_null = FALSE;
+  EXPECT_EQ(helper_.Dereference(&reference_value_, &dereferenced_value,
+                                &is_null, &std::cerr),
+            S_OK);
+  EXPECT_TRUE(is_null);
+  EXPECT_EQ(cache.GetSize(), 0u);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,53 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "directory_listing.h"
+
+using google_cloud_debugger::GetApplicationDirectory;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Tests that the directory of the first module in the command line is
+// used.
+TEST(DirectoryListingTest, ApplicationModule) {
+  EXPECT_EQ(GetApplicationDirectory("dotnet /app/bin/App.dll"), "/app/bin");
+  EXPECT_EQ(GetApplicationDirectory("dotnet bin/App.dll --port 80"), "bin");
+  EXPECT_EQ(GetApplicationDirectory("dotnet exec bin/App.dll other/B.dll"),
+            "bin");
+  EXPECT_EQ(GetApplicationDirectory("dotnet App.dll"), ".");
+  EXPECT_EQ(GetApplicationDirectory("dotnet C:\\app\\App.dll"), "C:\\app");
+}
+
+// Tests that the directory of the program is used if the command line
+// has no module.
+TEST(DirectoryListingTest, ApplicationProgram) {
+  EXPECT_EQ(GetApplicationDirectory("/app/App --port 80"), "/app");
+  EXPECT_EQ(GetApplicationDirectory("/App"), "/");
+  EXPECT_EQ(GetApplicationDirectory("App"), ".");
+  EXPECT_EQ(GetApplicationDirectory(""), ".");
+}
+
+// Tests that quoted arguments can have spaces.
+TEST(DirectoryListingTest, QuotedArguments) {
+  EXPECT_EQ(GetApplicationDirectory("\"/my app/App\""), "/my app");
+  EXPECT_EQ(GetApplicationDirectory("dotnet \"/my app/bin/App.dll\" x"),
+            "/my app/bin");
+  EXPECT_EQ(GetApplicationDirectory("dotnet /my\" app\"/App.dll"), "/my app");
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,163 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "document_path_index.h"
+#include "i_portable_pdb_mocks.h"
+
+using google_cloud_debugger_portable_pdb::DocumentPathIndex;
+using google_cloud_debugger_portable_pdb::DocumentPathKey;
+using google_cloud_debugger_portable_pdb::IDocumentIndex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for DocumentPathIndex.
+class DocumentPathIndexTest : public ::testing::Test {
+ protected:
+  // Creates a document index mock for every path in file_names_, with
+  // the content hash at the same position in content_hashes_ if any,
+  // and builds the path index from them.
+  void BuildIndex() {
+    content_hashes_.resize(file_names_.size());
+    for (size_t i = 0; i < file_names_.size(); ++i) {
+      unique_ptr<IDocumentIndexMock> doc_index(new (std::nothrow)
+                                                   IDocumentIndexMock());
+      ON_CALL(*doc_index, GetFilePath())
+          .WillByDefault(Return(file_names_[i]));
+      ON_CALL(*doc_index, GetContentHash())
+          .WillByDefault(ReturnRef(content_hashes_[i]));
+      document_indices_.push_back(std::move(doc_index));
+    }
+    path_index_.Initialize(document_indices_);
+  }
+
+  // Returns the position of the best match for path.
+  int32_t FindBestMatch(const string &path) {
+    return path_index_.FindBestMatch(DocumentPathIndex::CreatePathKey(path));
+  }
+
+  // Returns the position of the document for path and content_hash.
+  int32_t FindDocument(const string &path, const string &content_hash) {
+    return path_index_.FindDocument(DocumentPathIndex::CreatePathKey(path),
+                                    content_hash);
+  }
+
+  vector<string> file_names_;
+  vector<string> content_hashes_;
+  vector<unique_ptr<IDocumentIndex>> document_indices_;
+  DocumentPathIndex path_index_;
+};
+
+// Tests that SplitFilePath returns the segments with the file name first.
+TEST_F(DocumentPathIndexTest, SplitFilePath) {
+  vector<string> segments =
+      DocumentPathIndex::SplitFilePath("/src/test/program.cs");
+  ASSERT_EQ(segments.size(), 4);
+  EXPECT_EQ(segments[0], "program.cs");
+  EXPECT_EQ(segments[1], "test");
+  EXPECT_EQ(segments[2], "src");
+  EXPECT_EQ(segments[3], "");
+}
+
+// Tests that NormalizeFilePath lower cases and converts separators.
+TEST_F(DocumentPathIndexTest, NormalizeFilePath) {
+  EXPECT_EQ(DocumentPathIndex::NormalizeFilePath("C:\\Src\\Program.cs"),
+            "c:/src/program.cs");
+}
+
+// Tests that the key of a path holds its normalized segments in reverse
+// order and their hashes.
+TEST_F(DocumentPathIndexTest, CreatePathKey) {
+  DocumentPathKey key = DocumentPathIndex::CreatePathKey("Src\\Program.cs");
+  EXPECT_EQ(key.reversed_segments, vector<string>({"program.cs", "src"}));
+  ASSERT_EQ(key.segment_hashes.size(), 2);
+  EXPECT_EQ(key.segment_hashes[0], std::hash<string>()("program.cs"));
+  EXPECT_EQ(key.segment_hashes[1], std::hash<string>()("src"));
+}
+
+// Tests that the document with the longest matching suffix is returned.
+TEST_F(DocumentPathIndexTest, LongestSuffix) {
+  file_names_ = {"C:\\app\\program.cs", "c:\\app\\src\\test\\program.cs",
+                 "/app/other/test/program.cs", "/app/src/util.cs"};
+  BuildIndex();
+
+  EXPECT_EQ(FindBestMatch("src/test/program.cs"), 1);
+  EXPECT_EQ(FindBestMatch("other/test/program.cs"), 2);
+  EXPECT_EQ(FindBestMatch("Src/Util.cs"), 3);
+  EXPECT_EQ(FindBestMatch("SRC\\Test\\Program.cs"), 1);
+}
+
+// Tests that the first document wins when several match equally well.
+TEST_F(DocumentPathIndexTest, TieGoesToFirstDocument) {
+  file_names_ = {"a/test/program.cs", "b/test/program.cs"};
+  BuildIndex();
+
+  EXPECT_EQ(FindBestMatch("test/program.cs"), 0);
+  EXPECT_EQ(FindBestMatch("program.cs"), 0);
+  EXPECT_EQ(FindBestMatch("b/test/program.cs"), 1);
+}
+
+// Tests that -1 is returned when no document has the same file name.
+TEST_F(DocumentPathIndexTest, NoMatch) {
+  file_names_ = {"src/program.cs"};
+  BuildIndex();
+
+  EXPECT_EQ(FindBestMatch("src/aprogram.cs"), -1);
+  EXPECT_EQ(FindBestMatch(""), -1);
+
+  DocumentPathIndex empty_index;
+  EXPECT_EQ(
+      empty_index.FindBestMatch(DocumentPathIndex::CreatePathKey("program.cs")),
+      -1);
+}
+
+// Tests that the content hash picks the document among the ones that
+// share the path suffix.
+TEST_F(DocumentPathIndexTest, FindDocumentByHash) {
+  file_names_ = {"/repo/a/program.cs", "/repo/b/program.cs",
+                 "/repo/c/src/program.cs", "/repo/d/src/program.cs"};
+  content_hashes_ = {"aa", "bb", "cc", "cc"};
+  BuildIndex();
+
+  EXPECT_EQ(FindDocument("program.cs", "bb"), 1);
+  EXPECT_EQ(FindDocument("Program.cs", "cc"), 2);
+  EXPECT_EQ(FindDocument("d/src/program.cs", "cc"), 3);
+  // Without the hash, the path alone decides.
+  EXPECT_EQ(FindDocument("program.cs", ""), 0);
+}
+
+// Tests that the path is matched when no document with the same file
+// name has the hash.
+TEST_F(DocumentPathIndexTest, FindDocumentFallsBackToPath) {
+  file_names_ = {"/repo/a/program.cs", "/repo/b/program.cs",
+                 "/repo/b/empty.cs"};
+  content_hashes_ = {"aa", "bb", "ee"};
+  BuildIndex();
+
+  EXPECT_EQ(FindDocument("b/program.cs", "ff"), 1);
+  EXPECT_EQ(FindDocument("a/program.cs", "ee"), 0);
+  EXPECT_EQ(FindDocument("other.cs", "aa"), -1);
+}
+
+}  // namespace google_cloud_debugger_test
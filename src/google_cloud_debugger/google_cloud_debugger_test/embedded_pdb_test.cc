@@ -0,0 +1,213 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef PLATFORM_UNIX
+#include <zlib.h>
+#endif
+
+#include "custom_binary_reader.h"
+#include "embedded_pdb.h"
+#include "pe_debug_directory.h"
+
+using google_cloud_debugger_portable_pdb::CodeViewPdbInfo;
+using google_cloud_debugger_portable_pdb::CustomBinaryStream;
+using google_cloud_debugger_portable_pdb::EmbeddedPdb;
+using google_cloud_debugger_portable_pdb::ReadCodeViewPdbInfo;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Offsets in the image built by BuildImage.
+static const size_t kDebugDirectoryOffset = 0x200;
+static const size_t kEmbeddedPdbOffset = 0x300;
+
+// Writes value at offset in image as a little-endian integer of size bytes.
+static void Write(vector<uint8_t> *image, size_t offset, uint32_t value,
+                  size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    (*image)[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+// Builds a PE32 image with one section that holds the debug directory,
+// which has one entry of type type for data.
+static vector<uint8_t> BuildImage(uint32_t type, const vector<uint8_t> &data) {
+  vector<uint8_t> image(kEmbeddedPdbOffset + data.size());
+  image[0] = 'M';
+  image[1] = 'Z';
+  Write(&image, 0x3C, 0x40, 4);
+  memcpy(&image[0x40], "PE\0\0", 4);
+
+  // COFF header: one section and a PE32 optional header with 16 data
+  // directories.
+  Write(&image, 0x44 + 2, 1, 2);
+  Write(&image, 0x44 + 16, 224, 2);
+
+  // Optional header, with the debug directory at RVA 0x2000.
+  size_t optional_header = 0x58;
+  Write(&image, optional_header, 0x10B, 2);
+  Write(&image, optional_header + 92, 16, 4);
+  Write(&image, optional_header + 96 + 6 * 8, 0x2000, 4);
+  Write(&image, optional_header + 96 + 6 * 8 + 4, 28, 4);
+
+  // Section mapping RVA 0x2000 to the debug directory in the file.
+  size_t section = optional_header + 224;
+  Write(&image, section + 8, 0x1000, 4);
+  Write(&image, section + 12, 0x2000, 4);
+  Write(&image, section + 16, 0x200, 4);
+  Write(&image, section + 20, kDebugDirectoryOffset, 4);
+
+  Write(&image, kDebugDirectoryOffset + 12, type, 4);
+  Write(&image, kDebugDirectoryOffset + 16, data.size(), 4);
+  Write(&image, kDebugDirectoryOffset + 24, kEmbeddedPdbOffset, 4);
+  std::copy(data.begin(), data.end(), image.begin() + kEmbeddedPdbOffset);
+  return image;
+}
+
+// Returns the data of the debug directory entry of a PDB with content
+// pdb, which is deflated if possible.
+static vector<uint8_t> EmbedPdb(const string &pdb) {
+  vector<uint8_t> data = {'M', 'P', 'D', 'B', 0, 0, 0, 0};
+  Write(&data, 4, pdb.size(), 4);
+#ifdef PLATFORM_UNIX
+  z_stream stream = {};
+  EXPECT_EQ(deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8,
+                         Z_DEFAULT_STRATEGY),
+            Z_OK);
+  vector<uint8_t> deflated(deflateBound(&stream, pdb.size()));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(pdb.data()));
+  stream.avail_in = pdb.size();
+  stream.next_out = deflated.data();
+  stream.avail_out = deflated.size();
+  EXPECT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+  deflated.resize(stream.total_out);
+  deflateEnd(&stream);
+  data.insert(data.end(), deflated.begin(), deflated.end());
+#endif
+  return data;
+}
+
+// Tests that Find rejects images that are not PE files or have no
+// embedded PDB.
+TEST(EmbeddedPdbTest, NoEmbeddedPdb) {
+  EmbeddedPdb embedded_pdb;
+  EXPECT_FALSE(embedded_pdb.Find(nullptr, 0));
+
+  vector<uint8_t> not_pe(0x400, 0);
+  EXPECT_FALSE(embedded_pdb.Find(not_pe.data(), not_pe.size()));
+
+  // A CodeView entry, which points at a PDB file.
+  vector<uint8_t> code_view = BuildImage(2, vector<uint8_t>(24, 0));
+  EXPECT_FALSE(embedded_pdb.Find(code_view.data(), code_view.size()));
+
+  // An embedded PDB entry without the MPDB signature.
+  vector<uint8_t> bad_signature = BuildImage(17, vector<uint8_t>(16, 0));
+  EXPECT_FALSE(embedded_pdb.Find(bad_signature.data(),
+                                 bad_signature.size()));
+
+  // An image cut before the end of the embedded PDB.
+  vector<uint8_t> truncated = BuildImage(17, EmbedPdb("abc"));
+  truncated.resize(kEmbeddedPdbOffset + 4);
+  EXPECT_FALSE(embedded_pdb.Find(truncated.data(), truncated.size()));
+}
+
+// Tests that ReadCodeViewPdbInfo reads the GUID, age and path of the
+// PDB from a CodeView entry.
+TEST(EmbeddedPdbTest, ReadCodeViewPdbInfo) {
+  vector<uint8_t> data = {'R', 'S', 'D', 'S'};
+  for (uint8_t i = 0; i < 16; ++i) {
+    data.push_back(i);
+  }
+  data.insert(data.end(), {1, 0, 0, 0});
+  const string path = "C:\\build\\App.pdb";
+  data.insert(data.end(), path.begin(), path.end());
+  data.push_back(0);
+
+  CodeViewPdbInfo pdb_info;
+  vector<uint8_t> image = BuildImage(2, data);
+  ASSERT_TRUE(ReadCodeViewPdbInfo(image.data(), image.size(), &pdb_info));
+  for (uint8_t i = 0; i < 16; ++i) {
+    EXPECT_EQ(pdb_info.guid[i], i);
+  }
+  EXPECT_EQ(pdb_info.age, 1);
+  EXPECT_EQ(pdb_info.path, path);
+
+  // The path ends with the entry if it is not terminated.
+  data.pop_back();
+  data.pop_back();
+  image = BuildImage(2, data);
+  EXPECT_TRUE(ReadCodeViewPdbInfo(image.data(), image.size(), &pdb_info));
+  EXPECT_EQ(pdb_info.path, path.substr(0, path.size() - 1));
+
+  image = BuildImage(17, EmbedPdb("abc"));
+  EXPECT_FALSE(ReadCodeViewPdbInfo(image.data(), image.size(), &pdb_info));
+}
+
+#ifdef PLATFORM_UNIX
+// Tests that the embedded PDB is found and inflated.
+TEST(EmbeddedPdbTest, Inflate) {
+  string pdb(10000, 'x');
+  for (size_t i = 0; i < pdb.size(); i += 7) {
+    pdb[i] = static_cast<char>(i);
+  }
+  vector<uint8_t> image = BuildImage(17, EmbedPdb(pdb));
+
+  EmbeddedPdb embedded_pdb;
+  ASSERT_TRUE(embedded_pdb.Find(image.data(), image.size()));
+  EXPECT_EQ(embedded_pdb.GetPdbSize(), pdb.size());
+
+  vector<uint8_t> inflated(embedded_pdb.GetPdbSize());
+  EXPECT_TRUE(embedded_pdb.Inflate(inflated.data()));
+  EXPECT_EQ(string(inflated.begin(), inflated.end()), pdb);
+
+  // The deflated bytes are cut short.
+  Write(&image, kDebugDirectoryOffset + 16, 12, 4);
+  ASSERT_TRUE(embedded_pdb.Find(image.data(), image.size()));
+  EXPECT_FALSE(embedded_pdb.Inflate(inflated.data()));
+}
+
+// Tests that CustomBinaryStream::ConsumeEmbeddedPdb exposes the
+// embedded PDB of a module file.
+TEST(EmbeddedPdbTest, ConsumeEmbeddedPdb) {
+  const string module_file = "embedded_pdb_test.dll";
+  {
+    vector<uint8_t> image = BuildImage(17, EmbedPdb("BSJB pdb"));
+    std::ofstream file(module_file, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+  }
+
+  CustomBinaryStream binary_stream;
+  EXPECT_TRUE(binary_stream.ConsumeEmbeddedPdb(module_file));
+  string content;
+  EXPECT_TRUE(binary_stream.GetString(&content, 0));
+  EXPECT_EQ(content, "BSJB pdb");
+
+  std::remove(module_file.c_str());
+  EXPECT_FALSE(binary_stream.ConsumeEmbeddedPdb(module_file));
+  EXPECT_TRUE(binary_stream.GetString(&content, 5));
+  EXPECT_EQ(content, "pdb");
+}
+#endif
+
+}  // namespace google_cloud_debugger_test
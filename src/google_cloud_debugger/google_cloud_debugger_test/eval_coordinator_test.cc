@@ -28,6 +28,7 @@
 using ::testing::_;
 using ::testing::DoAll;
 using ::testing::Return;
+using ::testing::SetArgPointee;
 using google_cloud_debugger::CComPtr;
 using google_cloud_debugger::EvalCoordinator;
 using std::chrono::high_resolution_clock;
@@ -57,9 +58,9 @@ class EvalCoordinatorTest : public ::testing::Test {
   // DbgBreakpoints passed to PrintBreakpoint function.
   std::vector<shared_ptr<google_cloud_debugger::DbgBreakpoint>> breakpoints_;
 
-  // Empty list of PDB files passed to PrintBreakpoint function.
-  vector<shared_ptr<google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-      pdb_files_;
+  // Empty snapshot of PDB files passed to PrintBreakpoint function.
+  shared_ptr<const google_cloud_debugger::ModuleSnapshot> modules_ =
+      std::make_shared<google_cloud_debugger::ModuleSnapshot>();
 
   // The ICorDebugEval being evaluated.
   ICorDebugEvalMock eval_;
@@ -112,6 +113,35 @@ TEST_F(EvalCoordinatorTest, TestWaitForEvalTimeOut) {
   EXPECT_EQ(hr, CORDBG_E_FUNC_EVAL_NOT_COMPLETE);
 }
 
+// Tests that threads without breakpoints being processed are not
+// waiting for an evaluation.
+TEST_F(EvalCoordinatorTest, TestWaitingForEvalPerThread) {
+  EXPECT_CALL(debug_thread_, GetID(_))
+      .WillRepeatedly(DoAll(SetArgPointee<0>(10), Return(S_OK)));
+
+  // An exception on a thread that is not processed is ignored.
+  eval_coordinator_.HandleException(&debug_thread_);
+  EXPECT_FALSE(eval_coordinator_.WaitingForEval(&debug_thread_));
+  EXPECT_FALSE(eval_coordinator_.WaitingForEval(nullptr));
+}
+
+// Tests that WaitForEval aborts an evaluation that takes longer than
+// the evaluation timeout.
+TEST_F(EvalCoordinatorTest, TestWaitForEvalAbort) {
+  eval_coordinator_.SetEvaluationTimeout(std::chrono::milliseconds(100));
+  EXPECT_CALL(eval_, GetResult(_))
+      .WillRepeatedly(Return(CORDBG_E_FUNC_EVAL_NOT_COMPLETE));
+  EXPECT_CALL(eval_, Abort()).Times(1).WillOnce(Return(S_OK));
+
+  auto start = high_resolution_clock::now();
+  HRESULT hr =
+      eval_coordinator_.WaitForEval(&exception_thrown, &eval_, &eval_result_);
+  auto end = high_resolution_clock::now();
+
+  EXPECT_EQ(hr, CORDBG_E_FUNC_EVAL_NOT_COMPLETE);
+  EXPECT_TRUE(end - start < minutes(1));
+}
+
 // Tests that ProcessBreakpoint will return.
 TEST_F(EvalCoordinatorTest, TestProcessBreakpoint) {
   EXPECT_CALL(debug_stack_walk_, GetFrame(_)).WillRepeatedly(Return(S_FALSE));
@@ -120,8 +150,7 @@ TEST_F(EvalCoordinatorTest, TestProcessBreakpoint) {
   EXPECT_CALL(breakpoint_collection_, WriteBreakpoint(_))
       .Times(0);
   HRESULT hr = eval_coordinator_.ProcessBreakpoints(
-      &debug_thread_, &breakpoint_collection_, breakpoints_,
-      pdb_files_);
+      &debug_thread_, &breakpoint_collection_, breakpoints_, modules_);
 
   // PrintBreakpoint going to call a task that will call WriteBreakpoint
   // function of breakpoint_collection_ so we should give it some time to
@@ -0,0 +1,130 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dbg_breakpoint.h"
+#include "exception_point_filter.h"
+
+using google_cloud_debugger::DbgBreakpoint;
+using google_cloud_debugger::ExceptionPointFilter;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+const CORDB_ADDRESS kModule = 0x10000;
+const mdTypeDef kInvalidOperationToken = 0x02000010;
+const mdTypeDef kFormatToken = 0x02000020;
+
+// Test Fixture for ExceptionPointFilter. Counts how often the names of
+// classes and modules are looked up.
+class ExceptionPointFilterTest : public ::testing::Test {
+ protected:
+  // Matches an exception of the class class_token, named class_name,
+  // thrown in App.dll.
+  vector<shared_ptr<DbgBreakpoint>> Match(mdTypeDef class_token,
+                                          const string &class_name) {
+    vector<shared_ptr<DbgBreakpoint>> matched;
+    EXPECT_EQ(filter_.Match(kModule, class_token,
+                            [&](string *name) {
+                              ++class_name_lookups_;
+                              *name = class_name;
+                              return S_OK;
+                            },
+                            [&](string *name) {
+                              ++module_lookups_;
+                              *name = "/app/App.dll";
+                              return S_OK;
+                            },
+                            &matched),
+              S_OK);
+    return matched;
+  }
+
+  ExceptionPointFilter filter_;
+  shared_ptr<DbgBreakpoint> invalid_operation_ =
+      std::make_shared<DbgBreakpoint>();
+  shared_ptr<DbgBreakpoint> in_app_ = std::make_shared<DbgBreakpoint>();
+  shared_ptr<DbgBreakpoint> in_library_ = std::make_shared<DbgBreakpoint>();
+  int class_name_lookups_ = 0;
+  int module_lookups_ = 0;
+};
+
+// Tests that exceptions match the exception points of their type and
+// that the name of a class is only looked up once.
+TEST_F(ExceptionPointFilterTest, Match) {
+  EXPECT_TRUE(filter_.Empty());
+  filter_.Add("system.invalidoperationexception", "", invalid_operation_);
+  EXPECT_FALSE(filter_.Empty());
+
+  vector<shared_ptr<DbgBreakpoint>> matched =
+      Match(kInvalidOperationToken, "System.InvalidOperationException");
+  ASSERT_EQ(matched.size(), 1);
+  EXPECT_EQ(matched[0], invalid_operation_);
+
+  EXPECT_TRUE(Match(kFormatToken, "System.FormatException").empty());
+  EXPECT_TRUE(Match(kFormatToken, "System.FormatException").empty());
+  EXPECT_EQ(Match(kInvalidOperationToken, "").size(), 1);
+  EXPECT_EQ(class_name_lookups_, 2);
+  EXPECT_EQ(module_lookups_, 0);
+
+  // The classes of an unloaded module are looked up again.
+  filter_.RemoveModule(kModule);
+  EXPECT_TRUE(Match(kFormatToken, "System.FormatException").empty());
+  EXPECT_EQ(class_name_lookups_, 3);
+}
+
+// Tests that exception points restricted to a module only match the
+// exceptions thrown by its code.
+TEST_F(ExceptionPointFilterTest, MatchModule) {
+  filter_.Add("system.formatexception", "app", in_app_);
+  filter_.Add("system.formatexception", "library.dll", in_library_);
+
+  vector<shared_ptr<DbgBreakpoint>> matched =
+      Match(kFormatToken, "System.FormatException");
+  ASSERT_EQ(matched.size(), 1);
+  EXPECT_EQ(matched[0], in_app_);
+  EXPECT_EQ(module_lookups_, 1);
+}
+
+// Tests that the errors of the lookups are returned.
+TEST_F(ExceptionPointFilterTest, MatchError) {
+  filter_.Add("system.formatexception", "", in_app_);
+  vector<shared_ptr<DbgBreakpoint>> matched;
+  EXPECT_EQ(filter_.Match(kModule, kFormatToken,
+                          [](string *name) { return E_FAIL; },
+                          [](string *name) { return S_OK; }, &matched),
+            E_FAIL);
+  EXPECT_EQ(filter_.Match(kModule, kFormatToken,
+                          [](string *name) { return S_OK; },
+                          [](string *name) { return S_OK; }, nullptr),
+            E_INVALIDARG);
+}
+
+// Tests that modules are matched by their file name.
+TEST(ExceptionPointFilterModuleTest, ModuleMatches) {
+  EXPECT_TRUE(ExceptionPointFilter::ModuleMatches("/app/app.dll", "app"));
+  EXPECT_TRUE(ExceptionPointFilter::ModuleMatches("/app/app.dll", "app.dll"));
+  EXPECT_TRUE(ExceptionPointFilter::ModuleMatches("c:\\app\\app.dll", "app"));
+  EXPECT_FALSE(ExceptionPointFilter::ModuleMatches("/app/app.dll", "ap"));
+  EXPECT_FALSE(ExceptionPointFilter::ModuleMatches("/app/myapp.dll", "app"));
+  EXPECT_FALSE(ExceptionPointFilter::ModuleMatches("", "app"));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,263 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Measures how fast breakpoint conditions are compiled and evaluated,
+// without a live CLR.
+//
+// The local variables of the conditions are synthetic DbgPrimitives
+// returned by a mocked stack frame. For every condition, the benchmark
+// reports the time to parse it with the ANTLR lexer and parser, to build
+// and compile its ExpressionEvaluator tree against the stack frame, to
+// evaluate the tree and, for the conditions that can be lowered, to run
+// its ConditionProgram.
+
+#include <gmock/gmock.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark_results.h"
+#include "condition_program.h"
+#include "csharp_expression.h"
+#include "dbg_primitive.h"
+#include "expression_evaluator.h"
+#include "expression_util.h"
+#include "i_dbg_object_factory_mock.h"
+#include "i_dbg_stack_frame_mock.h"
+#include "i_eval_coordinator_mock.h"
+#include "optionparser.h"
+
+using google_cloud_debugger::CompiledExpression;
+using google_cloud_debugger::ConditionProgram;
+using google_cloud_debugger::CSharpExpression;
+using google_cloud_debugger::DbgObject;
+using google_cloud_debugger::DbgPrimitive;
+using google_cloud_debugger::ExpressionEvaluator;
+using google_cloud_debugger::ParseExpression;
+using google_cloud_debugger_test::BenchmarkResults;
+using google_cloud_debugger_test::IDbgObjectFactoryMock;
+using google_cloud_debugger_test::IDbgStackFrameMock;
+using google_cloud_debugger_test::IEvalCoordinatorMock;
+using std::cerr;
+using std::chrono::steady_clock;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace {
+
+// Representative conditions over the variables of SetUpLocalVariables.
+const vector<string> kConditions = {
+    "count > 10",
+    "count * 2 == 20 && enabled",
+    "ratio > 0.5 || retries >= 3",
+    "!(count < 0) && (total - count) % 7 != 0",
+    "total >= 1000L && total <= 2000L && retries != 0",
+    "enabled ? count + 1 > total : ratio * 2.0 < 1.5"};
+
+// Number of times every condition is compiled by default.
+const int kDefaultCompilations = 2000;
+
+// Number of times every condition is evaluated by default.
+const int kDefaultEvaluations = 200000;
+
+enum optionIndex { UNKNOWN, COMPILATIONS, EVALUATIONS };
+
+// Accepts an option that has a positive integer argument.
+option::ArgStatus PositiveNumber(const option::Option &option, bool msg) {
+  if (option.arg != nullptr && atoi(option.arg) > 0) {
+    return option::ARG_OK;
+  }
+  if (msg) {
+    cerr << "Option " << option.name << " requires a positive number.\n";
+  }
+  return option::ARG_ILLEGAL;
+}
+
+const option::Descriptor usage[] = {
+    {UNKNOWN, 0, "", "", option::Arg::None,
+     "USAGE: expression_benchmark [options]\n\n"
+     "Options:"},
+    {COMPILATIONS, 0, "", "compilations", PositiveNumber,
+     "  --compilations=<n>  \tNumber of times every condition is parsed "
+     "and compiled."},
+    {EVALUATIONS, 0, "", "evaluations", PositiveNumber,
+     "  --evaluations=<n>  \tNumber of times every condition is "
+     "evaluated."},
+    {0, 0, 0, 0, 0, 0}};
+
+// Nanoseconds per iteration since start.
+double NanosecondsPerIteration(steady_clock::time_point start,
+                               int iterations) {
+  std::chrono::duration<double, std::nano> elapsed =
+      steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+// Makes stack_frame return the local variables of the conditions.
+void SetUpLocalVariables(IDbgStackFrameMock *stack_frame) {
+  ON_CALL(*stack_frame, GetLocalVariable(_, _, _))
+      .WillByDefault(Return(S_FALSE));
+
+  vector<std::pair<string, shared_ptr<DbgObject>>> variables = {
+      {"count", shared_ptr<DbgObject>(new DbgPrimitive<int32_t>(10))},
+      {"total", shared_ptr<DbgObject>(new DbgPrimitive<int64_t>(1500))},
+      {"retries", shared_ptr<DbgObject>(new DbgPrimitive<int16_t>(3))},
+      {"ratio", shared_ptr<DbgObject>(new DbgPrimitive<double>(0.25))},
+      {"enabled", shared_ptr<DbgObject>(new DbgPrimitive<bool>(true))}};
+  for (const auto &variable : variables) {
+    ON_CALL(*stack_frame, GetLocalVariable(variable.first, _, _))
+        .WillByDefault(DoAll(SetArgPointee<1>(variable.second),
+                             Return(S_OK)));
+  }
+}
+
+// Creates the evaluator of parsed and compiles it against stack_frame.
+unique_ptr<ExpressionEvaluator> Compile(CSharpExpression *parsed,
+                                        IDbgStackFrameMock *stack_frame) {
+  std::ostringstream err_stream;
+  CompiledExpression compiled = parsed->CreateEvaluator();
+  if (!compiled.evaluator ||
+      FAILED(compiled.evaluator->Compile(stack_frame, nullptr,
+                                         &err_stream))) {
+    return nullptr;
+  }
+  return std::move(compiled.evaluator);
+}
+
+// Prints the times of compiling and evaluating condition and adds them to
+// results.
+bool MeasureCondition(const string &condition, int compilations,
+                      int evaluations, IDbgStackFrameMock *stack_frame,
+                      BenchmarkResults *results) {
+  steady_clock::time_point start = steady_clock::now();
+  for (int i = 0; i < compilations; ++i) {
+    if (!ParseExpression(condition)) {
+      cerr << "Failed to parse " << condition << std::endl;
+      return false;
+    }
+  }
+  double parse_ns = NanosecondsPerIteration(start, compilations);
+
+  // Compiling reuses the parsed tree, like the breakpoints do.
+  unique_ptr<CSharpExpression> parsed = ParseExpression(condition);
+  start = steady_clock::now();
+  for (int i = 0; i < compilations; ++i) {
+    if (!Compile(parsed.get(), stack_frame)) {
+      cerr << "Failed to compile " << condition << std::endl;
+      return false;
+    }
+  }
+  double compile_ns = NanosecondsPerIteration(start, compilations);
+
+  NiceMock<IEvalCoordinatorMock> eval_coordinator;
+  NiceMock<IDbgObjectFactoryMock> object_factory;
+  std::ostringstream err_stream;
+  unique_ptr<ExpressionEvaluator> evaluator =
+      Compile(parsed.get(), stack_frame);
+  start = steady_clock::now();
+  for (int i = 0; i < evaluations; ++i) {
+    shared_ptr<DbgObject> result;
+    if (FAILED(evaluator->Evaluate(&result, &eval_coordinator,
+                                   &object_factory, &err_stream))) {
+      cerr << "Failed to evaluate " << condition << std::endl;
+      return false;
+    }
+  }
+  double evaluate_ns = NanosecondsPerIteration(start, evaluations);
+
+  ConditionProgram program;
+  bool lowered =
+      evaluator->Lower(&program, evaluator->GetStaticType().cor_type,
+                       program.AllocateRegister());
+  double run_ns = 0;
+  if (lowered) {
+    start = steady_clock::now();
+    for (int i = 0; i < evaluations; ++i) {
+      bool result = false;
+      if (FAILED(program.Run(stack_frame, &result))) {
+        cerr << "Failed to run the program of " << condition << std::endl;
+        return false;
+      }
+    }
+    run_ns = NanosecondsPerIteration(start, evaluations);
+  }
+
+  printf("%-50s %10.0f %10.0f %10.1f", condition.c_str(), parse_ns,
+         compile_ns, evaluate_ns);
+  if (lowered) {
+    printf(" %10.1f\n", run_ns);
+  } else {
+    printf(" %10s\n", "-");
+  }
+
+  results->Add(condition + " parse ns", parse_ns, true);
+  results->Add(condition + " compile ns", compile_ns, true);
+  results->Add(condition + " evaluate ns", evaluate_ns, true);
+  if (lowered) {
+    results->Add(condition + " program ns", run_ns, true);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 0) {
+    // Skips first argument.
+    argc -= 1;
+    argv += 1;
+  }
+
+  option::Stats stats(usage, argc, argv);
+  vector<option::Option> options(stats.options_max);
+  vector<option::Option> buffer(stats.buffer_max);
+  option::Parser parse(usage, argc, argv, options.data(), buffer.data());
+  if (parse.error() || options[UNKNOWN].count()) {
+    option::printUsage(std::cout, usage);
+    return -1;
+  }
+
+  int compilations = options[COMPILATIONS] ? atoi(options[COMPILATIONS].arg)
+                                           : kDefaultCompilations;
+  int evaluations = options[EVALUATIONS] ? atoi(options[EVALUATIONS].arg)
+                                         : kDefaultEvaluations;
+
+  NiceMock<IDbgStackFrameMock> stack_frame;
+  SetUpLocalVariables(&stack_frame);
+
+  BenchmarkResults results("expression_benchmark", 0.25);
+  printf("Nanoseconds per condition\n");
+  printf("%-50s %10s %10s %10s %10s\n", "condition", "parse", "compile",
+         "evaluate", "program");
+  for (const string &condition : kConditions) {
+    if (!MeasureCondition(condition, compilations, evaluations,
+                          &stack_frame, &results)) {
+      return -1;
+    }
+  }
+  return results.Write() ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "frame_info_cache.h"
+
+using google_cloud_debugger::FrameInfo;
+using google_cloud_debugger::FrameInfoCache;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Tests that an added entry is found under its module, method token
+// and IL offset only.
+TEST(FrameInfoCacheTest, FindsAddedEntry) {
+  FrameInfoCache cache(4);
+  FrameInfo info;
+  info.method_name = "Main";
+  info.class_name = "Program";
+  info.line = 12;
+  cache.Add("App.dll", 100, 8, info);
+
+  FrameInfo found;
+  ASSERT_TRUE(cache.Find("App.dll", 100, 8, &found));
+  EXPECT_EQ(found.method_name, "Main");
+  EXPECT_EQ(found.class_name, "Program");
+  EXPECT_EQ(found.line, 12);
+
+  EXPECT_FALSE(cache.Find("App.dll", 100, 9, &found));
+  EXPECT_FALSE(cache.Find("App.dll", 101, 8, &found));
+  EXPECT_FALSE(cache.Find("Lib.dll", 100, 8, &found));
+  EXPECT_FALSE(
+      cache.Find("App.dll", 100, FrameInfoCache::kNoILOffset, &found));
+}
+
+// Tests that adding an existing entry replaces it.
+TEST(FrameInfoCacheTest, ReplacesEntry) {
+  FrameInfoCache cache(4);
+  FrameInfo info;
+  info.line = 1;
+  cache.Add("App.dll", 100, 8, info);
+  info.line = 2;
+  cache.Add("App.dll", 100, 8, info);
+
+  FrameInfo found;
+  ASSERT_TRUE(cache.Find("App.dll", 100, 8, &found));
+  EXPECT_EQ(found.line, 2);
+  EXPECT_EQ(cache.GetSize(), 1);
+}
+
+// Tests that the least recently used entry is evicted when the cache
+// is full.
+TEST(FrameInfoCacheTest, EvictsLeastRecentlyUsed) {
+  FrameInfoCache cache(2);
+  FrameInfo info;
+  cache.Add("App.dll", 1, 0, info);
+  cache.Add("App.dll", 2, 0, info);
+
+  // Uses the first entry so that the second one is evicted.
+  FrameInfo found;
+  EXPECT_TRUE(cache.Find("App.dll", 1, 0, &found));
+  cache.Add("App.dll", 3, 0, info);
+
+  EXPECT_EQ(cache.GetSize(), 2);
+  EXPECT_TRUE(cache.Find("App.dll", 1, 0, &found));
+  EXPECT_FALSE(cache.Find("App.dll", 2, 0, &found));
+  EXPECT_TRUE(cache.Find("App.dll", 3, 0, &found));
+}
+
+// Tests that removing a module removes its entries only.
+TEST(FrameInfoCacheTest, RemovesModule) {
+  FrameInfoCache cache(4);
+  FrameInfo info;
+  cache.Add("App.dll", 1, 0, info);
+  cache.Add("App.dll", 2, FrameInfoCache::kNoILOffset, info);
+  cache.Add("Lib.dll", 1, 0, info);
+
+  cache.RemoveModule("App.dll");
+
+  FrameInfo found;
+  EXPECT_EQ(cache.GetSize(), 1);
+  EXPECT_FALSE(cache.Find("App.dll", 1, 0, &found));
+  EXPECT_FALSE(
+      cache.Find("App.dll", 2, FrameInfoCache::kNoILOffset, &found));
+  EXPECT_TRUE(cache.Find("Lib.dll", 1, 0, &found));
+}
+
+// Tests that a cache without capacity keeps nothing.
+TEST(FrameInfoCacheTest, ZeroCapacity) {
+  FrameInfoCache cache(0);
+  cache.Add("App.dll", 1, 0, FrameInfo());
+
+  FrameInfo found;
+  EXPECT_FALSE(cache.Find("App.dll", 1, 0, &found));
+  EXPECT_EQ(cache.GetSize(), 0);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,84 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "front_coded_string_table.h"
+
+using google_cloud_debugger_portable_pdb::FrontCodedStringTable;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Tests that every string is decoded from its position.
+TEST(FrontCodedStringTableTest, GetsStrings) {
+  vector<string> paths = {
+      "/src/app/Program.cs", "/src/app/Controllers/HomeController.cs",
+      "/src/app/Controllers/AccountController.cs", "", "/src/lib/Util.cs",
+      "C:\\agent\\_work\\1\\s\\App\\Startup.cs"};
+  FrontCodedStringTable table;
+  vector<std::uint32_t> positions;
+  table.Initialize(paths, &positions);
+
+  ASSERT_EQ(positions.size(), paths.size());
+  EXPECT_EQ(table.size(), paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    EXPECT_EQ(table.Get(positions[i]), paths[i]);
+  }
+
+  // The strings are sorted.
+  EXPECT_EQ(table.Get(0), "");
+  EXPECT_EQ(table.Get(1), "/src/app/Controllers/AccountController.cs");
+  EXPECT_EQ(table.Get(table.size()), "");
+}
+
+// Tests that equal strings share a position.
+TEST(FrontCodedStringTableTest, Duplicates) {
+  vector<string> paths = {"/src/b.cs", "/src/a.cs", "/src/b.cs"};
+  FrontCodedStringTable table;
+  vector<std::uint32_t> positions;
+  table.Initialize(paths, &positions);
+
+  EXPECT_EQ(table.size(), 2u);
+  EXPECT_EQ(positions[0], positions[2]);
+  EXPECT_EQ(table.Get(positions[0]), "/src/b.cs");
+  EXPECT_EQ(table.Get(positions[1]), "/src/a.cs");
+}
+
+// Tests strings across several blocks, and that shared prefixes take
+// less memory than the strings themselves.
+TEST(FrontCodedStringTableTest, ManyBlocks) {
+  vector<string> paths;
+  size_t total_size = 0;
+  for (int i = 0; i < 200; ++i) {
+    paths.push_back("/home/build/agent/work/src/Company.Product/Feature" +
+                    std::to_string(i % 7) + "/File" + std::to_string(i) +
+                    ".cs");
+    total_size += paths.back().size();
+  }
+  FrontCodedStringTable table;
+  vector<std::uint32_t> positions;
+  table.Initialize(paths, &positions);
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    EXPECT_EQ(table.Get(positions[i]), paths[i]);
+  }
+  EXPECT_LT(table.GetMemoryUsage(), total_size / 2);
+}
+
+}  // namespace google_cloud_debugger_test
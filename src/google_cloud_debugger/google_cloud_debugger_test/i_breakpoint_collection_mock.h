@@ -20,6 +20,7 @@
 
 #include "breakpoint.pb.h"
 #include "i_breakpoint_collection.h"
+#include "module_registry.h"
 
 namespace google_cloud_debugger {
 class IPortablePdbFile;
@@ -39,22 +40,44 @@ class IBreakpointCollectionMock
       HRESULT(google_cloud_debugger::DebuggerCallback *debugger_callback));
   MOCK_METHOD1(UpdateBreakpoint,
                HRESULT(const google_cloud_debugger::DbgBreakpoint &breakpoint));
+  MOCK_METHOD1(
+      UpdateBreakpoints,
+      HRESULT(const std::vector<
+              std::shared_ptr<google_cloud_debugger::DbgBreakpoint>>
+                  &breakpoints));
+  MOCK_METHOD1(
+      UpdatePendingBreakpoints,
+      HRESULT(const std::shared_ptr<
+              google_cloud_debugger_portable_pdb::IPortablePdbFile> &pdb_file));
+  MOCK_METHOD1(RemoveModuleBreakpoints,
+               HRESULT(CORDB_ADDRESS module_base_address));
   MOCK_METHOD0(SyncBreakpoints, HRESULT());
   MOCK_METHOD0(CancelSyncBreakpoints, HRESULT());
+  MOCK_METHOD0(SetAttached, void());
   MOCK_METHOD1(
       WriteBreakpoint,
       HRESULT(const google::cloud::diagnostics::debug::Breakpoint &breakpoint));
+  MOCK_METHOD1(
+      WriteAndClearBreakpoint,
+      HRESULT(google::cloud::diagnostics::debug::Breakpoint *breakpoint));
   MOCK_METHOD1(
       ReadBreakpoint,
       HRESULT(google::cloud::diagnostics::debug::Breakpoint *breakpoint));
-  MOCK_METHOD5(
+  MOCK_METHOD6(
       EvaluateAndPrintBreakpoint,
-      HRESULT(mdMethodDef function_token, ULONG32 il_offset,
+      HRESULT(CORDB_ADDRESS module_base_address, mdMethodDef function_token,
+              ULONG32 il_offset,
               google_cloud_debugger::IEvalCoordinator *eval_coordinator,
               ICorDebugThread *debug_thread,
-              const std::vector<std::shared_ptr<
-                  google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-                  &pdb_files));
+              std::shared_ptr<const google_cloud_debugger::ModuleSnapshot>
+                  modules));
+  MOCK_METHOD0(HasExceptionPoints, bool());
+  MOCK_METHOD3(
+      EvaluateExceptionPoints,
+      HRESULT(google_cloud_debugger::IEvalCoordinator *eval_coordinator,
+              ICorDebugThread *debug_thread,
+              std::shared_ptr<const google_cloud_debugger::ModuleSnapshot>
+                  modules));
 };
 
 }  // namespace google_cloud_debugger_test
@@ -67,6 +67,10 @@ class ICorDebugHelperMock : public google_cloud_debugger::ICorDebugHelper {
   MOCK_METHOD3(ExtractStringFromICorDebugStringValue,
                HRESULT(ICorDebugStringValue *debug_string,
                        std::string *returned_string, std::ostream *err_stream));
+  MOCK_METHOD5(ExtractStringPrefixFromICorDebugStringValue,
+               HRESULT(ICorDebugStringValue *debug_string, ULONG32 max_length,
+                       std::string *returned_string, ULONG32 *length,
+                       std::ostream *err_stream));
   MOCK_METHOD4(ExtractParamName,
                HRESULT(IMetaDataImport *metadata_import, mdParamDef param_token,
                        std::string *param_name, std::ostream *err_stream));
@@ -157,9 +161,9 @@ class ICorDebugHelperMock : public google_cloud_debugger::ICorDebugHelper {
       HRESULT(ULONG encoded_token, ICorDebugModule *debug_module,
               IMetaDataImport *metadata_import, std::string *type_name,
               mdTypeDef *type_def, IMetaDataImport **resolved_metadata_import));
-  MOCK_METHOD5(
+  MOCK_METHOD6(
       ProcessConstantSigBlob,
-      HRESULT(const std::vector<uint8_t> &signature_blob,
+      HRESULT(const uint8_t *signature_blob, uint32_t signature_size,
               CorElementType *cor_type,
               UVCP_CONSTANT *constant_value,
               ULONG *value_len,
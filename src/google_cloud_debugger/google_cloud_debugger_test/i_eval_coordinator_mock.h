@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 
 #include "i_eval_coordinator.h"
+#include "module_registry.h"
 
 namespace google_cloud_debugger_test {
 
@@ -33,7 +34,7 @@ class IEvalCoordinatorMock : public google_cloud_debugger::IEvalCoordinator {
 
   MOCK_METHOD1(SignalFinishedEval, void(ICorDebugThread *debug_thread));
 
-  MOCK_METHOD0(HandleException, void());
+  MOCK_METHOD1(HandleException, void(ICorDebugThread *debug_thread));
 
   MOCK_METHOD4(
       ProcessBreakpoints,
@@ -41,9 +42,8 @@ class IEvalCoordinatorMock : public google_cloud_debugger::IEvalCoordinator {
           ICorDebugThread *debug_thread,
           google_cloud_debugger::IBreakpointCollection *breakpoint_collection,
           std::vector<std::shared_ptr<google_cloud_debugger::DbgBreakpoint>> breakpoint,
-          const std::vector<std::shared_ptr<
-              google_cloud_debugger_portable_pdb::IPortablePdbFile>>
-              &pdb_files));
+          std::shared_ptr<const google_cloud_debugger::ModuleSnapshot>
+              modules));
 
   MOCK_METHOD0(WaitForReadySignal, void());
 
@@ -53,7 +53,7 @@ class IEvalCoordinatorMock : public google_cloud_debugger::IEvalCoordinator {
 
   MOCK_METHOD1(GetActiveDebugFrame, HRESULT(ICorDebugILFrame **debug_frame));
 
-  MOCK_METHOD0(WaitingForEval, BOOL());
+  MOCK_METHOD1(WaitingForEval, BOOL(ICorDebugThread *debug_thread));
 
   MOCK_METHOD1(SetPropertyEvaluation, void(BOOL eval));
 
@@ -64,6 +64,26 @@ class IEvalCoordinatorMock : public google_cloud_debugger::IEvalCoordinator {
   MOCK_METHOD1(SetMethodEvaluation, void(BOOL eval));
 
   MOCK_METHOD1(CreateStackWalk, HRESULT(ICorDebugStackWalk **debug_stack_walk));
+
+  MOCK_METHOD4(GetCachedPropertyValue,
+               bool(CORDB_ADDRESS object_address,
+                    ICorDebugModule *debug_module, mdProperty property_def,
+                    std::shared_ptr<google_cloud_debugger::DbgObject> *value));
+
+  MOCK_METHOD4(CachePropertyValue,
+               void(CORDB_ADDRESS object_address,
+                    ICorDebugModule *debug_module, mdProperty property_def,
+                    std::shared_ptr<google_cloud_debugger::DbgObject> value));
+
+  MOCK_METHOD2(GetCachedExpressionValue,
+               bool(const std::string &key,
+                    std::shared_ptr<google_cloud_debugger::DbgObject> *value));
+
+  MOCK_METHOD2(CacheExpressionValue,
+               void(const std::string &key,
+                    std::shared_ptr<google_cloud_debugger::DbgObject> value));
+
+  MOCK_METHOD1(RemoveModuleFrames, void(const std::string &module_name));
 };
 
 }  // namespace google_cloud_debugger_test
@@ -31,8 +31,13 @@ class INamedPipeMock : public google_cloud_debugger::INamedPipe {
       HRESULT());
   MOCK_METHOD1(Read,
       HRESULT(std::string *message));
+  MOCK_METHOD2(ReadExactly,
+      HRESULT(std::size_t size, std::string *message));
   MOCK_METHOD1(Write,
       HRESULT(const std::string &message));
+  MOCK_METHOD2(WriteBuffers,
+      HRESULT(const google_cloud_debugger::PipeBuffer *buffers,
+              std::size_t count));
   MOCK_METHOD0(ShutDown,
       HRESULT());
 };
@@ -18,14 +18,19 @@
 #include <gtest/gtest.h>
 
 using std::unique_ptr;
+using ::testing::DoAll;
 using ::testing::Return;
 using ::testing::ReturnRef;
+using ::testing::SetArgPointee;
+using ::testing::_;
 
 namespace google_cloud_debugger_test {
 
 void PortablePDBFileFixture::SetUpIPortablePDBFile(
     IPortablePdbFileMock *file_mock) {
   ON_CALL(*file_mock, ParsePdbFile()).WillByDefault(Return(true));
+  ON_CALL(*file_mock, ParseMethods()).WillByDefault(Return(true));
+  ON_CALL(*file_mock, ParseDocumentMethods(_)).WillByDefault(Return(true));
 
   // Makes a vector with a Document Index mock
   for (auto &&document_fixture : documents_) {
@@ -34,7 +39,14 @@ void PortablePDBFileFixture::SetUpIPortablePDBFile(
     ON_CALL(*doc_index, GetMethods())
         .WillByDefault(ReturnRef(document_fixture.methods_));
     ON_CALL(*doc_index, GetFilePath())
-        .WillByDefault(ReturnRef(document_fixture.file_name_));
+        .WillByDefault(Return(document_fixture.file_name_));
+    ON_CALL(*doc_index, GetContentHash())
+        .WillByDefault(ReturnRef(document_fixture.content_hash_));
+
+    document_fixture.sequence_point_index_.Initialize(
+        document_fixture.methods_);
+    ON_CALL(*doc_index, GetSequencePointIndex())
+        .WillByDefault(ReturnRef(document_fixture.sequence_point_index_));
 
     document_indices_.push_back(std::move(doc_index));
   }
@@ -43,6 +55,13 @@ void PortablePDBFileFixture::SetUpIPortablePDBFile(
   ON_CALL(*file_mock, GetDocumentIndexTable())
       .WillByDefault(ReturnRef(document_indices_));
 
+  document_path_index_.Initialize(document_indices_);
+  ON_CALL(*file_mock, GetDocumentPathIndex())
+      .WillByDefault(ReturnRef(document_path_index_));
+
+  ON_CALL(*file_mock, GetMethodScopes(_, _))
+      .WillByDefault(DoAll(SetArgPointee<1>(&method_scopes_), Return(true)));
+
   // Module name should be the same as file name.
   ON_CALL(*file_mock, GetModuleName()).WillByDefault(ReturnRef(module_name_));
 }
@@ -17,11 +17,14 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <array>
 #include <cstdint>
 
 #include "document_index.h"
+#include "document_path_index.h"
 #include "i_portable_pdb_file.h"
 #include "i_cor_debug_helper.h"
+#include "module_type_dictionary.h"
 
 namespace google_cloud_debugger_test {
 
@@ -32,6 +35,11 @@ class IPortablePdbFileMock
   MOCK_METHOD2(Initialize, HRESULT(ICorDebugModule *debug_module,
       google_cloud_debugger::ICorDebugHelper *debug_helper));
   MOCK_METHOD0(ParsePdbFile, bool());
+  MOCK_METHOD0(ParseMethods, bool());
+  MOCK_METHOD1(ParseDocumentMethods, bool(std::size_t document));
+  MOCK_METHOD0(PinMethods, void());
+  MOCK_METHOD0(UnpinMethods, void());
+  MOCK_METHOD0(EvictMethods, std::size_t());
   MOCK_CONST_METHOD2(
       GetStream,
       bool(const std::string &name,
@@ -40,9 +48,8 @@ class IPortablePdbFileMock
                      bool(std::uint32_t index, std::string *result));
   MOCK_CONST_METHOD2(GetDocumentName,
                      bool(std::uint32_t index, std::string *doc_name));
-  MOCK_CONST_METHOD2(GetHeapGuid, bool(std::uint32_t index, std::string *guid));
-  MOCK_CONST_METHOD2(GetHash, bool(std::uint32_t index,
-                                   std::vector<std::uint8_t> *hash));
+  MOCK_CONST_METHOD2(GetHeapGuidSpan,
+                     bool(std::uint32_t index, const std::uint8_t **guid));
   MOCK_CONST_METHOD3(
       GetMethodSeqInfo,
       bool(std::uint32_t doc_index, std::uint32_t sequence_index,
@@ -50,33 +57,48 @@ class IPortablePdbFileMock
                *sequence_point_info));
   MOCK_CONST_METHOD0(
       GetDocumentTable,
-      const std::vector<google_cloud_debugger_portable_pdb::DocumentRow> &());
+      google_cloud_debugger_portable_pdb::MetadataTableView<
+          google_cloud_debugger_portable_pdb::DocumentRow>());
   MOCK_CONST_METHOD0(
       GetLocalScopeTable,
-      const std::vector<google_cloud_debugger_portable_pdb::LocalScopeRow> &());
+      google_cloud_debugger_portable_pdb::MetadataTableView<
+          google_cloud_debugger_portable_pdb::LocalScopeRow>());
   MOCK_CONST_METHOD0(
       GetLocalVariableTable,
-      const std::vector<google_cloud_debugger_portable_pdb::LocalVariableRow>
-          &());
+      google_cloud_debugger_portable_pdb::MetadataTableView<
+          google_cloud_debugger_portable_pdb::LocalVariableRow>());
   MOCK_CONST_METHOD0(
       GetMethodDebugInfoTable,
-      const std::vector<
-          google_cloud_debugger_portable_pdb::MethodDebugInformationRow> &());
+      google_cloud_debugger_portable_pdb::MetadataTableView<
+          google_cloud_debugger_portable_pdb::MethodDebugInformationRow>());
   MOCK_CONST_METHOD0(
       GetLocalConstantTable,
-      const std::vector<google_cloud_debugger_portable_pdb::LocalConstantRow>
-          &());
+      google_cloud_debugger_portable_pdb::MetadataTableView<
+          google_cloud_debugger_portable_pdb::LocalConstantRow>());
   MOCK_CONST_METHOD0(
       GetDocumentIndexTable,
       const std::vector<
           std::unique_ptr<google_cloud_debugger_portable_pdb::IDocumentIndex>>
           &());
+  MOCK_CONST_METHOD0(
+      GetDocumentPathIndex,
+      const google_cloud_debugger_portable_pdb::DocumentPathIndex &());
+  MOCK_METHOD2(
+      GetMethodScopes,
+      bool(std::uint32_t method_def,
+           const std::vector<google_cloud_debugger_portable_pdb::Scope>
+               **scopes));
   MOCK_CONST_METHOD0(GetModuleName, const std::string &());
+  MOCK_CONST_METHOD0(GetPdbId, const std::array<std::uint8_t, 20> &());
   MOCK_CONST_METHOD1(GetDebugModule, HRESULT(ICorDebugModule **debug_module));
   MOCK_CONST_METHOD1(GetMetaDataImport,
                      HRESULT(IMetaDataImport **metadata_import));
-  MOCK_CONST_METHOD2(GetBlobBytes,
-                     bool(std::uint32_t index, std::vector<uint8_t> *result));
+  MOCK_CONST_METHOD0(
+      GetTypeDictionary,
+      std::shared_ptr<google_cloud_debugger::ModuleTypeDictionary>());
+  MOCK_CONST_METHOD3(GetBlobSpan,
+                     bool(std::uint32_t index, const std::uint8_t **data,
+                          std::uint32_t *length));
 };
 
 // Mock for IDocumentIndex
@@ -87,10 +109,30 @@ class IDocumentIndexMock
       Initialize,
       bool(const google_cloud_debugger_portable_pdb::IPortablePdbFile &pdb,
            int doc_index));
-  MOCK_CONST_METHOD0(GetFilePath, std::string &());
+  MOCK_METHOD2(
+      ParseMethods,
+      bool(const google_cloud_debugger_portable_pdb::IPortablePdbFile &pdb,
+           const std::vector<std::uint32_t> &method_defs));
+  MOCK_CONST_METHOD0(GetFilePath, std::string());
+  MOCK_CONST_METHOD0(GetContentHash, std::string &());
   MOCK_CONST_METHOD0(
       GetMethods,
       const std::vector<google_cloud_debugger_portable_pdb::MethodInfo> &());
+  MOCK_CONST_METHOD0(
+      GetSequencePointIndex,
+      const google_cloud_debugger_portable_pdb::SequencePointIndex &());
+  MOCK_METHOD1(
+      SetMethods,
+      void(std::vector<google_cloud_debugger_portable_pdb::MethodInfo> methods));
+  MOCK_METHOD1(
+      SetSharedMethods,
+      void(std::shared_ptr<
+           const google_cloud_debugger_portable_pdb::DocumentMethods>
+               methods));
+  MOCK_CONST_METHOD0(
+      GetSharedMethods,
+      std::shared_ptr<
+          const google_cloud_debugger_portable_pdb::DocumentMethods>());
 };
 
 // Fixtures that contains information to mock an IDocumentIndex.
@@ -99,8 +141,14 @@ class IDocumentIndexFixture {
   // Name of the file of the document index.
   std::string file_name_;
 
+  // Hash of the content of the file, in lower case hex.
+  std::string content_hash_;
+
   // Method in the document index.
   std::vector<google_cloud_debugger_portable_pdb::MethodInfo> methods_;
+
+  // Sequence point index built from methods_.
+  google_cloud_debugger_portable_pdb::SequencePointIndex sequence_point_index_;
 };
 
 // Fixtures that contains information to mock a Portable PDB file.
@@ -120,6 +168,12 @@ class PortablePDBFileFixture {
   std::vector<
       std::unique_ptr<google_cloud_debugger_portable_pdb::IDocumentIndex>>
       document_indices_;
+
+  // Path index built from document_indices_.
+  google_cloud_debugger_portable_pdb::DocumentPathIndex document_path_index_;
+
+  // Local scopes returned for every method.
+  std::vector<google_cloud_debugger_portable_pdb::Scope> method_scopes_;
 };
 
 }  // namespace google_cloud_debugger_test
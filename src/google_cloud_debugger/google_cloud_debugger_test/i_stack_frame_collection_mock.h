@@ -34,10 +34,18 @@ class IStackFrameCollectionMock
               google_cloud_debugger_portable_pdb::IPortablePdbFile>> &pdb_files,
           google_cloud_debugger::DbgBreakpoint *breakpoint,
           google_cloud_debugger::IEvalCoordinator *eval_coordinator));
-  MOCK_METHOD2(
+  MOCK_METHOD3(
+      EvaluateConditionAndExpressions,
+      HRESULT(
+          const std::vector<std::shared_ptr<
+              google_cloud_debugger_portable_pdb::IPortablePdbFile>> &pdb_files,
+          google_cloud_debugger::DbgBreakpoint *breakpoint,
+          google_cloud_debugger::IEvalCoordinator *eval_coordinator));
+  MOCK_METHOD3(
       PopulateStackFrames,
       HRESULT(
           google::cloud::diagnostics::debug::Breakpoint *breakpoint,
+          const google_cloud_debugger::CaptureLimits &limits,
           google_cloud_debugger::IEvalCoordinator *eval_coordinator));
 };
 
@@ -0,0 +1,122 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "log_message_template.h"
+#include "log_record_encoder.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::LogMessageTemplate;
+using google_cloud_debugger::LogRecordEncoder;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Returns message_format rendered with breakpoint's evaluated expressions.
+string Render(const string &message_format, const Breakpoint &breakpoint) {
+  string message;
+  LogMessageTemplate(message_format)
+      .Render(breakpoint.evaluated_expressions(), &message);
+  return message;
+}
+
+// Tests that expressions are substituted, "$$" is a '$' and expressions
+// that do not exist are reported in the message.
+TEST(LogMessageTemplateTest, Render) {
+  Breakpoint breakpoint;
+  breakpoint.add_evaluated_expressions()->set_value("10");
+  breakpoint.add_evaluated_expressions()->set_value("\"text\"");
+
+  EXPECT_EQ(Render("a=$0 b=$1 $$0 $", breakpoint), "a=10 b=\"text\" $0 $");
+  EXPECT_EQ(Render("$1$0", breakpoint), "\"text\"10");
+  EXPECT_EQ(Render("c=$2", breakpoint), "c={2 cannot be evaluated}");
+  EXPECT_EQ(Render("$99999999999", breakpoint),
+            "{2147483647 cannot be evaluated}");
+  EXPECT_EQ(Render("", breakpoint), "");
+}
+
+// Tests that variables without a value are written as their members and
+// variables with an error as the error.
+TEST(LogMessageTemplateTest, RenderMembersAndErrors) {
+  Breakpoint breakpoint;
+  Variable *object = breakpoint.add_evaluated_expressions();
+  Variable *member = object->add_members();
+  member->set_name("x");
+  member->set_type("System.Int32");
+  member->set_value("1");
+  member = object->add_members();
+  member->set_name("y");
+  member->set_type("System.Object");
+  member = member->add_members();
+  member->set_name("a");
+  member->set_type("System.Int32");
+  member->set_value("2");
+
+  Variable *error = breakpoint.add_evaluated_expressions();
+  error->set_name("z");
+  error->mutable_status()->set_iserror(true);
+  error->mutable_status()->set_message("Not found.");
+
+  EXPECT_EQ(Render("$0 $1", breakpoint),
+            "[ x (System.Int32): 1, y (System.Object): [ a (System.Int32): 2]] "
+            "\"Error evaluating z: Not found.\"");
+}
+
+// Tests that only hits of log points without an error are encoded.
+TEST(LogRecordEncoderTest, CanEncode) {
+  Breakpoint breakpoint;
+  EXPECT_FALSE(LogRecordEncoder::CanEncode(breakpoint));
+
+  breakpoint.set_log_point(true);
+  EXPECT_TRUE(LogRecordEncoder::CanEncode(breakpoint));
+
+  Breakpoint with_status = breakpoint;
+  with_status.mutable_status()->set_message("Some hits are skipped.");
+  EXPECT_FALSE(LogRecordEncoder::CanEncode(with_status));
+
+  Breakpoint kill_server = breakpoint;
+  kill_server.set_kill_server(true);
+  EXPECT_FALSE(LogRecordEncoder::CanEncode(kill_server));
+}
+
+// Tests the encoding of a record.
+TEST(LogRecordEncoderTest, Append) {
+  Breakpoint breakpoint;
+  breakpoint.set_id("id");
+  breakpoint.set_log_point(true);
+  breakpoint.set_log_level(Breakpoint::ERR);
+  breakpoint.set_log_message_format("x is $0");
+  breakpoint.add_evaluated_expressions()->set_value(string(200, 'x'));
+
+  LogRecordEncoder encoder;
+  string buffer = "previous";
+  encoder.Append(breakpoint, 0x0102030405060708, &buffer);
+  encoder.Append(breakpoint, 0, &buffer);
+
+  string message = "x is " + string(200, 'x');
+  string record = string("\x02id", 3) +
+                  string("\x08\x07\x06\x05\x04\x03\x02\x01", 8) + "\x02" +
+                  "\xcd\x01" + message;
+  EXPECT_EQ(buffer.substr(0, 8), "previous");
+  EXPECT_EQ(buffer.substr(8, record.size()), record);
+
+  // The template of the format is reused for the second record.
+  record.replace(3, 8, string(8, '\0'));
+  EXPECT_EQ(buffer.substr(8 + record.size()), record);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,235 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "common_action_mocks.h"
+#include "i_cor_debug_mocks.h"
+#include "i_metadata_import_mock.h"
+#include "metadata_cache.h"
+#include "string_stream_wrapper.h"
+
+using google_cloud_debugger::ConvertStringToWCharPtr;
+using google_cloud_debugger::ConvertWCharPtrToString;
+using google_cloud_debugger::MetadataCache;
+using google_cloud_debugger::MethodProps;
+using google_cloud_debugger::TypeProps;
+using std::vector;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for MetadataCache. Sets up a method and its class in a
+// mocked IMetaDataImport.
+class MetadataCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    cache_.SetEnabled(true);
+    method_name_ = ConvertStringToWCharPtr("Method");
+    class_name_ = ConvertStringToWCharPtr("Program");
+  }
+
+  // Expects the props of the method to be read times times.
+  void ExpectMethodProps(int times) {
+    ULONG name_len = method_name_.size();
+    EXPECT_CALL(metadata_import_,
+                GetMethodProps(method_token_, _, nullptr, 0, _, _, _, _, _, _))
+        .Times(times)
+        .WillRepeatedly(DoAll(SetArgPointee<1>(class_token_),
+                              SetArgPointee<4>(name_len),
+                              SetArgPointee<8>(virtual_address_),
+                              Return(S_OK)));
+    EXPECT_CALL(metadata_import_, GetMethodProps(method_token_, _, _, name_len,
+                                                 _, _, _, _, _, _))
+        .Times(times)
+        .WillRepeatedly(
+            DoAll(SetArgPointee<1>(class_token_),
+                  SetArg2ToWcharArray(method_name_.data(), name_len),
+                  SetArgPointee<4>(name_len),
+                  SetArgPointee<8>(virtual_address_), Return(S_OK)));
+  }
+
+  // Expects the props of the class to be read times times.
+  void ExpectTypeProps(int times) {
+    ULONG name_len = class_name_.size();
+    EXPECT_CALL(metadata_import_,
+                GetTypeDefProps(class_token_, nullptr, 0, _, _, _))
+        .Times(times)
+        .WillRepeatedly(DoAll(SetArgPointee<3>(name_len), Return(S_OK)));
+    EXPECT_CALL(metadata_import_,
+                GetTypeDefProps(class_token_, _, name_len, _, _, _))
+        .Times(times)
+        .WillRepeatedly(
+            DoAll(SetArg1ToWcharArray(class_name_.data(), name_len),
+                  SetArgPointee<3>(name_len), Return(S_OK)));
+  }
+
+  MetadataCache cache_;
+  IMetaDataImportMock metadata_import_;
+  mdMethodDef method_token_ = 0x06000011;
+  mdTypeDef class_token_ = 0x02000003;
+  ULONG virtual_address_ = 0x2050;
+  vector<WCHAR> method_name_;
+  vector<WCHAR> class_name_;
+};
+
+// Tests that the props of a method are read once.
+TEST_F(MetadataCacheTest, CachesMethodProps) {
+  ExpectMethodProps(1);
+
+  for (int i = 0; i < 2; ++i) {
+    MethodProps props;
+    EXPECT_EQ(cache_.GetMethodProps(&metadata_import_, method_token_, true,
+                                    &props),
+              S_OK);
+    EXPECT_TRUE(props.has_name);
+    EXPECT_EQ(ConvertWCharPtrToString(props.name), "Method");
+    EXPECT_EQ(props.class_token, class_token_);
+    EXPECT_EQ(props.virtual_address, virtual_address_);
+  }
+
+  // The props with the name also serve reads without it.
+  MethodProps props;
+  EXPECT_EQ(
+      cache_.GetMethodProps(&metadata_import_, method_token_, false, &props),
+      S_OK);
+  EXPECT_EQ(props.virtual_address, virtual_address_);
+}
+
+// Tests that a failed read is not cached.
+TEST_F(MetadataCacheTest, DoesNotCacheFailures) {
+  EXPECT_CALL(metadata_import_,
+              GetTypeDefProps(class_token_, nullptr, 0, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(E_FAIL));
+
+  for (int i = 0; i < 2; ++i) {
+    TypeProps props;
+    EXPECT_EQ(
+        cache_.GetTypeProps(&metadata_import_, class_token_, true, &props),
+        E_FAIL);
+  }
+}
+
+// Tests that found fields and fields that are not found are cached.
+TEST_F(MetadataCacheTest, FindField) {
+  mdFieldDef field_token = 0x04000007;
+  EXPECT_CALL(metadata_import_, FindField(class_token_, _, nullptr, 0, _))
+      .Times(2)
+      .WillOnce(DoAll(SetArgPointee<4>(field_token), Return(S_OK)))
+      .WillOnce(Return(CLDB_E_RECORD_NOTFOUND));
+
+  for (int i = 0; i < 2; ++i) {
+    mdFieldDef field_def = 0;
+    EXPECT_EQ(cache_.FindField(&metadata_import_, class_token_, "count",
+                               &field_def),
+              S_OK);
+    EXPECT_EQ(field_def, field_token);
+    EXPECT_EQ(cache_.FindField(&metadata_import_, class_token_, "missing",
+                               &field_def),
+              CLDB_E_RECORD_NOTFOUND);
+  }
+}
+
+// Tests the properties cached by name.
+TEST_F(MetadataCacheTest, Properties) {
+  mdProperty property = 0;
+  EXPECT_FALSE(cache_.FindProperty(&metadata_import_, class_token_, "Count",
+                                   &property));
+
+  cache_.AddProperty(&metadata_import_, class_token_, "Count", 0x17000002);
+  cache_.AddProperty(&metadata_import_, class_token_, "Missing",
+                     mdPropertyNil);
+  EXPECT_TRUE(cache_.FindProperty(&metadata_import_, class_token_, "Count",
+                                  &property));
+  EXPECT_EQ(property, 0x17000002);
+  EXPECT_TRUE(cache_.FindProperty(&metadata_import_, class_token_, "Missing",
+                                  &property));
+  EXPECT_EQ(property, mdPropertyNil);
+}
+
+// Tests that type references resolved to another module are removed when
+// the other module is unloaded.
+TEST_F(MetadataCacheTest, ResolvedTypeRefs) {
+  IMetaDataImportMock type_def_metadata;
+  ICorDebugModuleMock type_def_module;
+  EXPECT_CALL(type_def_metadata, AddRef()).WillRepeatedly(Return(1));
+  EXPECT_CALL(type_def_metadata, Release()).WillRepeatedly(Return(1));
+  mdTypeRef type_ref = 0x01000005;
+
+  mdTypeDef type_def = 0;
+  IMetaDataImport *metadata_import = nullptr;
+  EXPECT_FALSE(cache_.FindResolvedTypeRef(&metadata_import_, type_ref,
+                                          &type_def, &metadata_import));
+
+  cache_.AddResolvedTypeRef(&metadata_import_, type_ref, class_token_,
+                            &type_def_metadata);
+  EXPECT_TRUE(cache_.FindResolvedTypeRef(&metadata_import_, type_ref,
+                                         &type_def, &metadata_import));
+  EXPECT_EQ(type_def, class_token_);
+  EXPECT_EQ(metadata_import, &type_def_metadata);
+
+  cache_.RemoveModule(&type_def_module, &type_def_metadata);
+  EXPECT_FALSE(cache_.FindResolvedTypeRef(&metadata_import_, type_ref,
+                                          &type_def, &metadata_import));
+}
+
+// Tests that a disabled cache reads the props every time.
+TEST_F(MetadataCacheTest, Disabled) {
+  cache_.SetEnabled(false);
+  ExpectTypeProps(2);
+
+  for (int i = 0; i < 2; ++i) {
+    TypeProps props;
+    EXPECT_EQ(
+        cache_.GetTypeProps(&metadata_import_, class_token_, true, &props),
+        S_OK);
+    EXPECT_EQ(ConvertWCharPtrToString(props.name), "Program");
+  }
+}
+
+// Tests that the props of an unloaded module are read again.
+TEST_F(MetadataCacheTest, RemoveModule) {
+  ICorDebugModuleMock debug_module;
+  EXPECT_CALL(debug_module, AddRef()).WillRepeatedly(Return(1));
+  EXPECT_CALL(debug_module, Release()).WillRepeatedly(Return(1));
+  EXPECT_CALL(metadata_import_, AddRef()).WillRepeatedly(Return(1));
+  EXPECT_CALL(metadata_import_, Release()).WillRepeatedly(Return(1));
+  ExpectTypeProps(2);
+
+  cache_.AddMetadataImport(&debug_module, &metadata_import_);
+  IMetaDataImport *metadata_import = nullptr;
+  EXPECT_TRUE(cache_.FindMetadataImport(&debug_module, &metadata_import));
+  EXPECT_EQ(metadata_import, &metadata_import_);
+
+  TypeProps props;
+  EXPECT_EQ(cache_.GetTypeProps(&metadata_import_, class_token_, true, &props),
+            S_OK);
+  EXPECT_EQ(cache_.GetTypeProps(&metadata_import_, class_token_, true, &props),
+            S_OK);
+
+  cache_.RemoveModule(&debug_module, &metadata_import_);
+  EXPECT_FALSE(cache_.FindMetadataImport(&debug_module, &metadata_import));
+  EXPECT_EQ(cache_.GetTypeProps(&metadata_import_, class_token_, true, &props),
+            S_OK);
+  EXPECT_EQ(ConvertWCharPtrToString(props.name), "Program");
+}
+
+}  // namespace google_cloud_debugger_test
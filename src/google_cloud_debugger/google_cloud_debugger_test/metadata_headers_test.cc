@@ -0,0 +1,69 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "custom_binary_reader.h"
+#include "metadata_headers.h"
+
+using google_cloud_debugger_portable_pdb::CustomBinaryStream;
+using google_cloud_debugger_portable_pdb::GetMetadataStreamKind;
+using google_cloud_debugger_portable_pdb::kBlobStream;
+using google_cloud_debugger_portable_pdb::kCompressedTablesStream;
+using google_cloud_debugger_portable_pdb::kUnknownStream;
+using google_cloud_debugger_portable_pdb::StreamHeader;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Tests that the streams the debugger reads are identified by name.
+TEST(MetadataHeadersTest, GetMetadataStreamKind) {
+  EXPECT_EQ(GetMetadataStreamKind("#Blob", 5), kBlobStream);
+  EXPECT_EQ(GetMetadataStreamKind("#~", 2), kCompressedTablesStream);
+  EXPECT_EQ(GetMetadataStreamKind("#Blobs", 6), kUnknownStream);
+  EXPECT_EQ(GetMetadataStreamKind("#Blob", 4), kUnknownStream);
+  EXPECT_EQ(GetMetadataStreamKind("#US", 3), kUnknownStream);
+}
+
+// Tests that stream headers are parsed with their names in place.
+TEST(MetadataHeadersTest, ParseStreamHeaders) {
+  // Offset 0x6C and size 0x10 of "#~", then offset 0x100 and size 0x20
+  // of "#Blob", each name padded to 4 bytes.
+  string data("\x6C\0\0\0\x10\0\0\0#~\0\0"
+              "\0\x01\0\0\x20\0\0\0#Blob\0\0\0",
+              28);
+  std::unique_ptr<std::istringstream> stream(new std::istringstream(data));
+  CustomBinaryStream binary_stream;
+  ASSERT_TRUE(binary_stream.ConsumeStream(stream.release()));
+
+  StreamHeader header;
+  ASSERT_TRUE(ParseFrom(&binary_stream, &header));
+  EXPECT_EQ(header.offset, 0x6C);
+  EXPECT_EQ(header.size, 0x10);
+  EXPECT_EQ(string(header.name, header.name_length), "#~");
+  EXPECT_EQ(header.kind, kCompressedTablesStream);
+
+  ASSERT_TRUE(ParseFrom(&binary_stream, &header));
+  EXPECT_EQ(header.offset, 0x100);
+  EXPECT_EQ(header.size, 0x20);
+  EXPECT_EQ(string(header.name, header.name_length), "#Blob");
+  EXPECT_EQ(header.kind, kBlobStream);
+
+  EXPECT_FALSE(ParseFrom(&binary_stream, &header));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,98 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "metadata_headers.h"
+#include "metadata_tables.h"
+
+using google_cloud_debugger_portable_pdb::CompressedMetadataTableHeader;
+using google_cloud_debugger_portable_pdb::GetHashAlgorithmName;
+using google_cloud_debugger_portable_pdb::GetIndexSizes;
+using google_cloud_debugger_portable_pdb::GetLanguageName;
+using google_cloud_debugger_portable_pdb::GetRowSize;
+using google_cloud_debugger_portable_pdb::Heap;
+using google_cloud_debugger_portable_pdb::LocalConstantRow;
+using google_cloud_debugger_portable_pdb::LocalScopeRow;
+using google_cloud_debugger_portable_pdb::LocalVariableRow;
+using google_cloud_debugger_portable_pdb::MetadataIndexSizes;
+using google_cloud_debugger_portable_pdb::MetadataTable;
+using google_cloud_debugger_portable_pdb::MetadataTableView;
+
+namespace google_cloud_debugger_test {
+
+// Tests the index widths of a header with a big Blob heap and a
+// LocalVariable table of 2^16 rows.
+TEST(MetadataTablesTest, GetIndexSizes) {
+  CompressedMetadataTableHeader header;
+  header.heap_sizes = Heap::BlobsHeap;
+  header.valid_mask[MetadataTable::LocalVariable] = true;
+  header.num_rows.push_back(0x10000);
+
+  MetadataIndexSizes sizes = GetIndexSizes(header);
+  EXPECT_EQ(sizes.strings_heap, 2);
+  EXPECT_EQ(sizes.guids_heap, 2);
+  EXPECT_EQ(sizes.blobs_heap, 4);
+  EXPECT_EQ(sizes.method_table, 2);
+  EXPECT_EQ(sizes.local_variable_table, 4);
+  EXPECT_EQ(sizes.local_constant_table, 2);
+
+  EXPECT_EQ(GetRowSize<LocalScopeRow>(sizes), 18);
+  EXPECT_EQ(GetRowSize<LocalVariableRow>(sizes), 6);
+  EXPECT_EQ(GetRowSize<LocalConstantRow>(sizes), 6);
+}
+
+// Tests that a view decodes its rows from the bytes of the table.
+TEST(MetadataTablesTest, TableView) {
+  MetadataIndexSizes sizes;
+  sizes.blobs_heap = 4;
+  const uint8_t rows[] = {0x01, 0x00, 0x02, 0x00, 0x00, 0x00,
+                          0x05, 0x00, 0x06, 0x07, 0x00, 0x00};
+
+  MetadataTableView<LocalConstantRow> view(rows, 2, sizes);
+  EXPECT_EQ(view.size(), 3);
+  EXPECT_EQ(view.row_size(), 6);
+
+  EXPECT_EQ(view[1].name, 1);
+  EXPECT_EQ(view[1].signature, 2);
+  EXPECT_EQ(view[2].name, 5);
+  EXPECT_EQ(view[2].signature, 0x706);
+
+  // Row 0 and the rows past the end are zeroed out.
+  EXPECT_EQ(view[0].name, 0);
+  EXPECT_EQ(view[0].signature, 0);
+  EXPECT_EQ(view[3].name, 0);
+
+  MetadataTableView<LocalConstantRow> empty;
+  EXPECT_EQ(empty.size(), 1);
+  EXPECT_EQ(empty[1].name, 0);
+}
+
+// Tests that the names are looked up from the bytes of the GUIDs as they
+// are stored in the GUID heap.
+TEST(MetadataTablesTest, GuidNames) {
+  const uint8_t csharp[] = {0xf8, 0x62, 0x51, 0x3f, 0xc6, 0x07, 0xd3, 0x11,
+                            0x90, 0x53, 0x00, 0xc0, 0x4f, 0xa3, 0x02, 0xa1};
+  const uint8_t sha256[] = {0x0f, 0xd0, 0x29, 0x88, 0xb8, 0x11, 0x13, 0x42,
+                            0x87, 0x8b, 0x77, 0x0e, 0x85, 0x97, 0xac, 0x16};
+
+  EXPECT_EQ(GetLanguageName(csharp), "C#");
+  EXPECT_EQ(GetLanguageName(sha256), "Unknown");
+  EXPECT_EQ(GetHashAlgorithmName(sha256), "SHA-256");
+  EXPECT_EQ(GetHashAlgorithmName(csharp), "Unknown");
+}
+
+}  // namespace google_cloud_debugger_test
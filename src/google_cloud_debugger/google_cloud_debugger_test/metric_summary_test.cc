@@ -0,0 +1,88 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "constants.h"
+#include "metric_summary.h"
+
+using google_cloud_debugger::kMetricPointHistogramBuckets;
+using google_cloud_debugger::MetricSummary;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// The interval the tests flush summaries at.
+static const MetricSummary::Clock::duration kInterval =
+    std::chrono::seconds(10);
+
+// Tests that values are sorted into power of two buckets.
+TEST(MetricSummaryTest, GetBucket) {
+  EXPECT_EQ(MetricSummary::GetBucket(-5), 0u);
+  EXPECT_EQ(MetricSummary::GetBucket(0.5), 0u);
+  EXPECT_EQ(MetricSummary::GetBucket(1), 1u);
+  EXPECT_EQ(MetricSummary::GetBucket(1.5), 1u);
+  EXPECT_EQ(MetricSummary::GetBucket(2), 2u);
+  EXPECT_EQ(MetricSummary::GetBucket(1023), 10u);
+  EXPECT_EQ(MetricSummary::GetBucket(1024), 11u);
+  EXPECT_EQ(MetricSummary::GetBucket(1e300), kMetricPointHistogramBuckets - 1);
+}
+
+// Tests that the summary is only flushed once the interval passed since
+// its first hit, and that a new summary starts afterwards.
+TEST(MetricSummaryTest, FlushesEveryInterval) {
+  MetricSummary summary;
+  MetricSummary::Clock::time_point start = MetricSummary::Clock::now();
+  string message;
+  EXPECT_FALSE(summary.Flush(start, kInterval, &message));
+
+  summary.AddValue(3);
+  EXPECT_FALSE(summary.Flush(start, kInterval, &message));
+  summary.AddValue(1);
+  summary.AddValue(0.5);
+  summary.AddValue(2.5);
+  EXPECT_FALSE(summary.Flush(start + kInterval / 2, kInterval, &message));
+  EXPECT_TRUE(message.empty());
+
+  EXPECT_TRUE(summary.Flush(start + kInterval, kInterval, &message));
+  EXPECT_EQ(message, "count=4 sum=7 min=0.5 max=3 histogram=[<1:1 <2:1 <4:2]");
+  EXPECT_FALSE(summary.Flush(start + 2 * kInterval, kInterval, &message));
+
+  summary.AddValue(-1);
+  EXPECT_FALSE(summary.Flush(start + 2 * kInterval, kInterval, &message));
+  EXPECT_TRUE(summary.Flush(start + 3 * kInterval, kInterval, &message));
+  EXPECT_EQ(message, "count=1 sum=-1 min=-1 max=-1 histogram=[<1:1]");
+}
+
+// Tests that hits without a numeric value are counted on their own.
+TEST(MetricSummaryTest, NonNumericHits) {
+  MetricSummary summary;
+  MetricSummary::Clock::time_point start = MetricSummary::Clock::now();
+  string message;
+  summary.AddHit();
+  EXPECT_FALSE(summary.Flush(start, kInterval, &message));
+  EXPECT_TRUE(summary.Flush(start + kInterval, kInterval, &message));
+  EXPECT_EQ(message, "count=0 non_numeric=1");
+
+  summary.AddHit();
+  summary.AddValue(5e9);
+  EXPECT_FALSE(summary.Flush(start + kInterval, kInterval, &message));
+  EXPECT_TRUE(summary.Flush(start + 2 * kInterval, kInterval, &message));
+  EXPECT_EQ(message,
+            "count=1 sum=5000000000 min=5000000000 max=5000000000 "
+            "histogram=[>=1073741824:1] non_numeric=1");
+}
+
+}  // namespace google_cloud_debugger_test
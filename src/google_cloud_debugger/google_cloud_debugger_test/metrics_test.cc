@@ -0,0 +1,215 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "breakpoint.pb.h"
+#include "constants.h"
+#include "memory_usage.h"
+#include "metrics.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::DebuggerMetrics;
+using google_cloud_debugger::GetMemoryUsage;
+using google_cloud_debugger::LatencyHistogram;
+using google_cloud_debugger::MemoryGauge;
+using google_cloud_debugger::MetricCounter;
+using google_cloud_debugger::MetricDuration;
+using google_cloud_debugger::ScopedMemoryCharge;
+using google_cloud_debugger::StartupTimings;
+using google_cloud_debugger::kMetricsBreakpointId;
+using google_cloud_debugger::kReadyBreakpointId;
+
+namespace google_cloud_debugger_test {
+
+// Tests that increments from several threads are all counted.
+TEST(MetricsTest, CounterIncrement) {
+  MetricCounter counter;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&counter]() {
+      for (int j = 0; j < 1000; ++j) {
+        counter.Increment();
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  counter.Increment(10);
+
+  EXPECT_EQ(4010, counter.GetValue());
+}
+
+// Tests that a charge adjusts its gauge when it changes and releases it
+// when it is destroyed.
+TEST(MetricsTest, MemoryCharge) {
+  MemoryGauge gauge;
+  {
+    ScopedMemoryCharge first(&gauge);
+    ScopedMemoryCharge second(&gauge);
+    first.Set(100);
+    second.Add(30);
+    second.Add(20);
+    EXPECT_EQ(150, gauge.GetValue());
+
+    first.Set(40);
+    EXPECT_EQ(40, first.Get());
+    EXPECT_EQ(90, gauge.GetValue());
+  }
+  EXPECT_EQ(0, gauge.GetValue());
+
+  // A gauge never reports less than nothing.
+  gauge.Add(-10);
+  EXPECT_EQ(0, gauge.GetValue());
+}
+
+// Tests that the memory of containers grows with their elements.
+TEST(MetricsTest, ContainerMemoryUsage) {
+  std::vector<std::uint64_t> values;
+  values.reserve(10);
+  EXPECT_EQ(10 * sizeof(std::uint64_t), GetMemoryUsage(values));
+
+  std::map<std::string, int> tree;
+  std::unordered_map<std::string, int> table;
+  EXPECT_EQ(0, GetMemoryUsage(tree));
+  size_t empty_table = GetMemoryUsage(table);
+  tree["key"] = 1;
+  table["key"] = 1;
+  EXPECT_GT(GetMemoryUsage(tree), sizeof(std::pair<const std::string, int>));
+  EXPECT_GT(GetMemoryUsage(table),
+            empty_table + sizeof(std::pair<const std::string, int>));
+}
+
+// Tests that every value falls in a bucket whose bounds contain it and
+// that large values are clamped to the last bucket.
+TEST(MetricsTest, HistogramBuckets) {
+  for (std::uint64_t value = 0; value < 100000; ++value) {
+    std::size_t index = LatencyHistogram::GetBucketIndex(value);
+    EXPECT_GE(LatencyHistogram::GetBucketMaximum(index), value);
+    if (index > 0) {
+      EXPECT_LT(LatencyHistogram::GetBucketMaximum(index - 1), value);
+    }
+  }
+
+  EXPECT_EQ(LatencyHistogram::kBucketCount - 1,
+            LatencyHistogram::GetBucketIndex(LatencyHistogram::kMaximumValue));
+  EXPECT_EQ(LatencyHistogram::kBucketCount - 1,
+            LatencyHistogram::GetBucketIndex(UINT64_MAX));
+  EXPECT_EQ(LatencyHistogram::kMaximumValue,
+            LatencyHistogram::GetBucketMaximum(LatencyHistogram::kBucketCount -
+                                               1));
+}
+
+// Tests the count, sum, maximum and percentiles of a histogram.
+TEST(MetricsTest, HistogramPercentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.GetPercentile(50));
+
+  for (std::uint64_t value = 1; value <= 1000; ++value) {
+    histogram.Record(value);
+  }
+
+  EXPECT_EQ(1000, histogram.GetCount());
+  EXPECT_EQ(500500, histogram.GetSum());
+  EXPECT_EQ(1000, histogram.GetMaximum());
+
+  // Percentiles are within the width of a bucket of the exact values.
+  std::uint64_t p50 = histogram.GetPercentile(50);
+  EXPECT_GE(p50, 500);
+  EXPECT_LE(p50, 500 + 500 / LatencyHistogram::kSubBucketCount);
+  std::uint64_t p99 = histogram.GetPercentile(99);
+  EXPECT_GE(p99, 990);
+  EXPECT_LE(p99, 1000);
+  EXPECT_EQ(1000, histogram.GetPercentile(100));
+  EXPECT_EQ(1, histogram.GetPercentile(0));
+}
+
+// Tests that the metrics are reported as the evaluated expressions of
+// a breakpoint with the metrics ID.
+TEST(MetricsTest, PopulateBreakpoint) {
+  DebuggerMetrics metrics;
+  metrics.breakpoint_hits.Increment(3);
+  metrics.breakpoint_stop_time_us.Record(100);
+  metrics.breakpoint_stop_time_us.Record(200);
+
+  Breakpoint breakpoint;
+  breakpoint.set_log_point(true);
+  metrics.PopulateBreakpoint(&breakpoint);
+
+  EXPECT_EQ(kMetricsBreakpointId, breakpoint.id());
+  EXPECT_FALSE(breakpoint.log_point());
+  ASSERT_GE(breakpoint.evaluated_expressions_size(), 2);
+
+  const Variable &hits = breakpoint.evaluated_expressions(0);
+  EXPECT_EQ("breakpoint_hits", hits.name());
+  EXPECT_EQ("3", hits.value());
+
+  const Variable &stop_time = breakpoint.evaluated_expressions(1);
+  EXPECT_EQ("breakpoint_stop_time_us", stop_time.name());
+  ASSERT_EQ(6, stop_time.members_size());
+  EXPECT_EQ("count", stop_time.members(0).name());
+  EXPECT_EQ("2", stop_time.members(0).value());
+  EXPECT_EQ("sum", stop_time.members(1).name());
+  EXPECT_EQ("300", stop_time.members(1).value());
+  EXPECT_EQ("max", stop_time.members(2).name());
+  EXPECT_EQ("200", stop_time.members(2).value());
+}
+
+// Tests that a duration is the time since its start.
+TEST(MetricsTest, MetricDuration) {
+  MetricDuration duration;
+  EXPECT_EQ(0, duration.GetValue());
+
+  duration.SetSince(std::chrono::steady_clock::now() -
+                    std::chrono::milliseconds(5));
+  EXPECT_GE(duration.GetValue(), 5000);
+
+  // A start in the future does not make the duration negative.
+  duration.SetSince(std::chrono::steady_clock::now() +
+                    std::chrono::seconds(1));
+  EXPECT_EQ(0, duration.GetValue());
+}
+
+// Tests that the startup timings are reported as the evaluated
+// expressions of a breakpoint with the ready ID.
+TEST(MetricsTest, PopulateStartupBreakpoint) {
+  StartupTimings startup;
+  startup.modules_enumerated.Increment(7);
+  startup.total_us.SetSince(startup.start - std::chrono::milliseconds(1));
+
+  Breakpoint breakpoint;
+  startup.PopulateBreakpoint(&breakpoint);
+
+  EXPECT_EQ(kReadyBreakpointId, breakpoint.id());
+  std::map<std::string, std::string> values;
+  for (const Variable &variable : breakpoint.evaluated_expressions()) {
+    values[variable.name()] = variable.value();
+  }
+  EXPECT_EQ(6, values.size());
+  EXPECT_EQ("7", values["modules_enumerated"]);
+  EXPECT_EQ("0", values["pdb_parsing_us"]);
+  EXPECT_EQ("0", values["runtime_registration_us"]);
+  EXPECT_NE("0", values["total_us"]);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,81 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "module_filter.h"
+
+using google_cloud_debugger::ModuleFilter;
+
+namespace google_cloud_debugger_test {
+
+// Tests the wildcards of module name patterns.
+TEST(ModuleFilterTest, Matches) {
+  EXPECT_TRUE(ModuleFilter::Matches("System.dll", "System.dll"));
+  EXPECT_TRUE(ModuleFilter::Matches("system.DLL", "System.dll"));
+  EXPECT_TRUE(ModuleFilter::Matches("System.*", "System.Private.CoreLib.dll"));
+  EXPECT_TRUE(ModuleFilter::Matches("*", ""));
+  EXPECT_TRUE(ModuleFilter::Matches("*.dll", "MyApp.dll"));
+  EXPECT_TRUE(ModuleFilter::Matches("My?pp.dll", "MyApp.dll"));
+  EXPECT_TRUE(ModuleFilter::Matches("*App*.dll", "MyApp.Web.dll"));
+  EXPECT_TRUE(ModuleFilter::Matches("a*b*c", "aXbYbZc"));
+
+  EXPECT_FALSE(ModuleFilter::Matches("System.*", "MyApp.dll"));
+  EXPECT_FALSE(ModuleFilter::Matches("My?pp.dll", "Mypp.dll"));
+  EXPECT_FALSE(ModuleFilter::Matches("*.dll", "MyApp.exe"));
+  EXPECT_FALSE(ModuleFilter::Matches("a*b*c", "aXbYbZ"));
+  EXPECT_FALSE(ModuleFilter::Matches("", "a"));
+}
+
+// Tests that modules are parsed if they match an include pattern and
+// no exclude pattern.
+TEST(ModuleFilterTest, ShouldParse) {
+  ModuleFilter filter;
+  EXPECT_TRUE(filter.ShouldParse("/app/System.Runtime.dll"));
+
+  ASSERT_TRUE(filter.SetExcludePatterns("System.*, Microsoft.*"));
+  EXPECT_FALSE(filter.ShouldParse("/app/System.Runtime.dll"));
+  EXPECT_FALSE(filter.ShouldParse("C:\\app\\Microsoft.CSharp.dll"));
+  EXPECT_TRUE(filter.ShouldParse("/app/MyApp.dll"));
+  EXPECT_TRUE(filter.ShouldParse("/app/Newtonsoft.Json.dll"));
+
+  ASSERT_TRUE(filter.SetIncludePatterns("MyApp*"));
+  EXPECT_TRUE(filter.ShouldParse("/app/MyApp.dll"));
+  EXPECT_TRUE(filter.ShouldParse("/app/MyApp.Data.dll"));
+  EXPECT_FALSE(filter.ShouldParse("/app/Newtonsoft.Json.dll"));
+
+  // The directories of the module are not matched.
+  EXPECT_FALSE(filter.ShouldParse("/MyApp/Newtonsoft.Json.dll"));
+}
+
+// Tests that only modules with a PDB file are parsed if it is required.
+TEST(ModuleFilterTest, RequirePdbFile) {
+  ModuleFilter filter;
+  filter.SetRequirePdbFile(true);
+  EXPECT_FALSE(filter.ShouldParse("/nonexistent/MyApp.dll"));
+  EXPECT_FALSE(filter.ShouldParse("/nonexistent/MyApp"));
+}
+
+// Tests that lists of patterns with empty patterns are rejected.
+TEST(ModuleFilterTest, InvalidPatterns) {
+  ModuleFilter filter;
+  EXPECT_FALSE(filter.SetIncludePatterns(""));
+  EXPECT_FALSE(filter.SetIncludePatterns("MyApp*,"));
+  EXPECT_FALSE(filter.SetExcludePatterns("System.*, ,Microsoft.*"));
+  EXPECT_TRUE(filter.ShouldParse("/app/System.Runtime.dll"));
+}
+
+}  // namespace google_cloud_debugger_test
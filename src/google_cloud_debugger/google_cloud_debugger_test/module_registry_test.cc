@@ -0,0 +1,143 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "i_metadata_import_mock.h"
+#include "i_portable_pdb_mocks.h"
+#include "module_registry.h"
+
+using google_cloud_debugger::ModuleRegistry;
+using google_cloud_debugger::ModuleSnapshot;
+using google_cloud_debugger_portable_pdb::IPortablePdbFile;
+using std::shared_ptr;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Tests that added modules are in the snapshots published afterwards
+// and that earlier snapshots do not change.
+TEST(ModuleRegistryTest, AddModule) {
+  ModuleRegistry registry;
+  shared_ptr<const ModuleSnapshot> empty = registry.GetSnapshot();
+
+  shared_ptr<IPortablePdbFile> first(new IPortablePdbFileMock());
+  shared_ptr<IPortablePdbFile> second(new IPortablePdbFileMock());
+  EXPECT_EQ(registry.AddModule(first, 0x1000), S_OK);
+  EXPECT_EQ(registry.AddModule(second, 0x2000), S_OK);
+  EXPECT_EQ(registry.AddModule(nullptr, 0x3000), E_INVALIDARG);
+
+  shared_ptr<const ModuleSnapshot> snapshot = registry.GetSnapshot();
+  ASSERT_EQ(snapshot->pdb_files.size(), 2);
+  EXPECT_EQ(snapshot->pdb_files[0], first);
+  EXPECT_EQ(snapshot->pdb_files[1], second);
+  EXPECT_EQ(snapshot->FindByBaseAddress(0x1000), first);
+  EXPECT_EQ(snapshot->FindByBaseAddress(0x2000), second);
+  EXPECT_EQ(snapshot->FindByBaseAddress(0x3000), nullptr);
+
+  ASSERT_NE(empty->class_names, nullptr);
+  EXPECT_EQ(snapshot->class_names, empty->class_names);
+  EXPECT_TRUE(empty->pdb_files.empty());
+  EXPECT_EQ(empty->FindByBaseAddress(0x1000), nullptr);
+}
+
+// Tests that a module registered twice keeps its first PDB file.
+TEST(ModuleRegistryTest, AddModuleTwice) {
+  ModuleRegistry registry;
+  shared_ptr<IPortablePdbFile> first(new IPortablePdbFileMock());
+  shared_ptr<IPortablePdbFile> second(new IPortablePdbFileMock());
+  EXPECT_EQ(registry.AddModule(first, 0x1000), S_OK);
+  shared_ptr<const ModuleSnapshot> before = registry.GetSnapshot();
+  EXPECT_EQ(registry.AddModule(second, 0x1000), S_FALSE);
+
+  shared_ptr<const ModuleSnapshot> after = registry.GetSnapshot();
+  EXPECT_EQ(after, before);
+  ASSERT_EQ(after->pdb_files.size(), 1);
+  EXPECT_EQ(after->FindByBaseAddress(0x1000), first);
+}
+
+// Tests that breakpoints are searched for in filtered modules last.
+TEST(ModuleRegistryTest, BreakpointSearchOrder) {
+  ModuleRegistry registry;
+  shared_ptr<IPortablePdbFile> first(new IPortablePdbFileMock());
+  shared_ptr<IPortablePdbFile> second(new IPortablePdbFileMock());
+  shared_ptr<IPortablePdbFile> third(new IPortablePdbFileMock());
+  registry.AddModule(first, 0x1000, true);
+  registry.AddModule(second, 0x2000);
+  registry.AddModule(third, 0x3000);
+
+  std::vector<shared_ptr<IPortablePdbFile>> search_order =
+      registry.GetSnapshot()->GetBreakpointSearchOrder();
+  ASSERT_EQ(search_order.size(), 3);
+  EXPECT_EQ(search_order[0], second);
+  EXPECT_EQ(search_order[1], third);
+  EXPECT_EQ(search_order[2], first);
+
+  shared_ptr<IPortablePdbFile> removed;
+  registry.RemoveModule(0x1000, &removed);
+  EXPECT_TRUE(registry.GetSnapshot()->filtered_pdb_files.empty());
+}
+
+// Tests that a removed module is only dropped from later snapshots.
+TEST(ModuleRegistryTest, RemoveModule) {
+  ModuleRegistry registry;
+  shared_ptr<IPortablePdbFile> first(new IPortablePdbFileMock());
+  shared_ptr<IPortablePdbFile> second(new IPortablePdbFileMock());
+  registry.AddModule(first, 0x1000);
+  registry.AddModule(second, 0x2000);
+  shared_ptr<const ModuleSnapshot> before = registry.GetSnapshot();
+
+  shared_ptr<IPortablePdbFile> removed;
+  EXPECT_EQ(registry.RemoveModule(0x1000, &removed), S_OK);
+  EXPECT_EQ(removed, first);
+  EXPECT_EQ(registry.RemoveModule(0x1000, &removed), S_FALSE);
+  EXPECT_EQ(removed, nullptr);
+
+  shared_ptr<const ModuleSnapshot> after = registry.GetSnapshot();
+  ASSERT_EQ(after->pdb_files.size(), 1);
+  EXPECT_EQ(after->pdb_files[0], second);
+  EXPECT_EQ(after->FindByBaseAddress(0x1000), nullptr);
+  EXPECT_EQ(before->pdb_files.size(), 2);
+  EXPECT_EQ(before->FindByBaseAddress(0x1000), first);
+}
+
+// Tests that the PDB files can be found from the metadata of their
+// module until the module is removed.
+TEST(ModuleRegistryTest, FindByMetaDataImport) {
+  IMetaDataImportMock metadata_import;
+  EXPECT_CALL(metadata_import, AddRef()).WillRepeatedly(Return(S_OK));
+  EXPECT_CALL(metadata_import, Release()).WillRepeatedly(Return(S_OK));
+
+  IPortablePdbFileMock *pdb_mock = new IPortablePdbFileMock();
+  shared_ptr<IPortablePdbFile> pdb_file(pdb_mock);
+  EXPECT_CALL(*pdb_mock, GetMetaDataImport(_))
+      .WillOnce(DoAll(SetArgPointee<0>(&metadata_import), Return(S_OK)));
+
+  ModuleRegistry registry;
+  registry.AddModule(pdb_file, 0x1000);
+  EXPECT_EQ(registry.GetSnapshot()->FindByMetaDataImport(&metadata_import),
+            pdb_file);
+
+  shared_ptr<IPortablePdbFile> removed;
+  registry.RemoveModule(0x1000, &removed);
+  EXPECT_EQ(registry.GetSnapshot()->FindByMetaDataImport(&metadata_import),
+            nullptr);
+}
+
+}  // namespace google_cloud_debugger_test
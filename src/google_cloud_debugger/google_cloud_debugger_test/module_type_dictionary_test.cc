@@ -0,0 +1,90 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "i_cor_debug_helper_mock.h"
+#include "i_metadata_import_mock.h"
+#include "module_type_dictionary.h"
+
+using google_cloud_debugger::ModuleTypeDictionary;
+using std::string;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+using ::testing::SetArrayArgument;
+
+namespace google_cloud_debugger_test {
+
+// Tests that the dictionaries are built from the type defs and type refs
+// of the module only once.
+TEST(ModuleTypeDictionaryTest, PopulateOnce) {
+  IMetaDataImportMock metadata_import;
+  ICorDebugHelperMock debug_helper;
+  mdTypeDef type_def = 10;
+  mdTypeRef type_ref = 20;
+
+  EXPECT_CALL(metadata_import, EnumTypeDefs(_, _, _, _))
+      .Times(2)
+      .WillOnce(DoAll(SetArrayArgument<1>(&type_def, &type_def + 1),
+                      SetArgPointee<3>(1), Return(S_OK)))
+      .WillOnce(DoAll(SetArgPointee<3>(0), Return(S_FALSE)));
+  EXPECT_CALL(metadata_import, EnumTypeRefs(_, _, _, _))
+      .Times(2)
+      .WillOnce(DoAll(SetArrayArgument<1>(&type_ref, &type_ref + 1),
+                      SetArgPointee<3>(1), Return(S_OK)))
+      .WillOnce(DoAll(SetArgPointee<3>(0), Return(S_FALSE)));
+  EXPECT_CALL(metadata_import, CloseEnum(_)).Times(2);
+  EXPECT_CALL(debug_helper, GetTypeNameFromMdTypeDef(type_def, _, _, _, _))
+      .Times(1)
+      .WillOnce(DoAll(SetArgPointee<2>(string("App.Defined")), Return(S_OK)));
+  EXPECT_CALL(debug_helper, GetTypeNameFromMdTypeRef(type_ref, _, _, _))
+      .Times(1)
+      .WillOnce(
+          DoAll(SetArgPointee<2>(string("System.Referenced")), Return(S_OK)));
+
+  ModuleTypeDictionary dictionary;
+  EXPECT_EQ(dictionary.Populate(&metadata_import, &debug_helper), S_OK);
+  EXPECT_EQ(dictionary.Populate(&metadata_import, &debug_helper), S_OK);
+
+  mdTypeDef found_type_def = 0;
+  EXPECT_TRUE(dictionary.FindTypeDef("App.Defined", &found_type_def));
+  EXPECT_EQ(found_type_def, type_def);
+  EXPECT_FALSE(dictionary.FindTypeDef("System.Referenced", &found_type_def));
+
+  mdTypeRef found_type_ref = 0;
+  EXPECT_TRUE(dictionary.FindTypeRef("System.Referenced", &found_type_ref));
+  EXPECT_EQ(found_type_ref, type_ref);
+  EXPECT_FALSE(dictionary.FindTypeRef("App.Missing", &found_type_ref));
+}
+
+// Tests that a failed enumeration is retried by the next Populate.
+TEST(ModuleTypeDictionaryTest, PopulateFailure) {
+  IMetaDataImportMock metadata_import;
+  ICorDebugHelperMock debug_helper;
+
+  EXPECT_CALL(metadata_import, EnumTypeDefs(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(E_FAIL));
+  EXPECT_CALL(metadata_import, CloseEnum(_)).Times(2);
+
+  ModuleTypeDictionary dictionary;
+  EXPECT_EQ(dictionary.Populate(&metadata_import, &debug_helper), E_FAIL);
+  EXPECT_EQ(dictionary.Populate(&metadata_import, &debug_helper), E_FAIL);
+}
+
+}  // namespace google_cloud_debugger_test
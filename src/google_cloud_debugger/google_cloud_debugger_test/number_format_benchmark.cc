@@ -0,0 +1,128 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how fast FormatNumber formats the integers and doubles that
+// snapshots capture, compared to std::to_string and std::ostringstream.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark_results.h"
+#include "number_format.h"
+
+using google_cloud_debugger::AssignNumber;
+using google_cloud_debugger_test::BenchmarkResults;
+using std::chrono::steady_clock;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Number of values formatted by every method.
+const size_t kValueCount = 1024;
+
+// Number of times every method formats the values.
+const size_t kIterations = 2000;
+
+// Returns kValueCount values of type T, built by create from random
+// numbers, with a fixed seed so that runs can be compared.
+template <typename T, typename Create>
+vector<T> CreateValues(Create create) {
+  std::srand(1);
+  vector<T> values;
+  for (size_t i = 0; i < kValueCount; ++i) {
+    values.push_back(create(std::rand()));
+  }
+  return values;
+}
+
+// Returns the millions of values formatted per second by format, which
+// sets its string argument to a value.
+template <typename T, typename Format>
+double Measure(const vector<T> &values, Format format) {
+  string formatted;
+  size_t total_length = 0;
+  steady_clock::time_point start = steady_clock::now();
+  for (size_t i = 0; i < kIterations; ++i) {
+    for (const T &value : values) {
+      format(value, &formatted);
+      total_length += formatted.size();
+    }
+  }
+  std::chrono::duration<double> elapsed = steady_clock::now() - start;
+
+  // Uses the result so that the formatting is not optimized away.
+  if (total_length == 0) {
+    abort();
+  }
+  return kIterations * values.size() / elapsed.count() / 1e6;
+}
+
+// Prints the throughput of every method for values and adds the one of
+// FormatNumber to results.
+template <typename T>
+void MeasureValues(const char *description, const vector<T> &values,
+                   BenchmarkResults *results) {
+  double stream = Measure(values, [](T value, string *formatted) {
+    std::ostringstream stream;
+    stream.precision(17);
+    stream << value;
+    *formatted = stream.str();
+  });
+  double to_string = Measure(values, [](T value, string *formatted) {
+    *formatted = std::to_string(value);
+  });
+  double format_number = Measure(values, [](T value, string *formatted) {
+    AssignNumber(value, formatted);
+  });
+  printf("%-12s %14.1f %14.1f %14.1f\n", description, stream, to_string,
+         format_number);
+  results->Add(string(description) + " FormatNumber Mvalues/s", format_number,
+               false);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  BenchmarkResults results("number_format_benchmark", 0.25);
+  printf("Millions of values formatted per second\n");
+  printf("%-12s %14s %14s %14s\n", "values", "ostringstream", "to_string",
+         "FormatNumber");
+  MeasureValues("small ints",
+                CreateValues<std::int32_t>(
+                    [](int random) { return random % 100; }),
+                &results);
+  MeasureValues("ints", CreateValues<std::int32_t>([](int random) {
+                  return random - RAND_MAX / 2;
+                }),
+                &results);
+  MeasureValues("int64s", CreateValues<std::int64_t>([](int random) {
+                  return static_cast<std::int64_t>(random) * random;
+                }),
+                &results);
+  MeasureValues("doubles", CreateValues<double>([](int random) {
+                  return static_cast<double>(random) / 1000;
+                }),
+                &results);
+  MeasureValues("floats", CreateValues<float>([](int random) {
+                  return static_cast<float>(random % 100000) / 7;
+                }),
+                &results);
+  return results.Write() ? 0 : 1;
+}
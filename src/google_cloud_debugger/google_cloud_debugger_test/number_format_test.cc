@@ -0,0 +1,105 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "number_format.h"
+
+using google_cloud_debugger::AssignIndexName;
+using google_cloud_debugger::AssignNumber;
+using google_cloud_debugger::AppendNumber;
+using std::numeric_limits;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Returns value formatted by AssignNumber.
+template <typename T>
+static string Format(T value) {
+  string formatted = "previous";
+  AssignNumber(value, &formatted);
+  return formatted;
+}
+
+// Tests that integers of every type are formatted like std::to_string.
+TEST(NumberFormatTest, Integers) {
+  EXPECT_EQ(Format(0), "0");
+  EXPECT_EQ(Format(7), "7");
+  EXPECT_EQ(Format(10), "10");
+  EXPECT_EQ(Format(99), "99");
+  EXPECT_EQ(Format(100), "100");
+  EXPECT_EQ(Format(-5), "-5");
+  EXPECT_EQ(Format(-1234567), "-1234567");
+  EXPECT_EQ(Format(true), "1");
+  EXPECT_EQ(Format(static_cast<char>(65)), "65");
+  EXPECT_EQ(Format(numeric_limits<std::int8_t>::min()), "-128");
+  EXPECT_EQ(Format(numeric_limits<std::uint16_t>::max()), "65535");
+  EXPECT_EQ(Format(numeric_limits<std::int64_t>::min()),
+            "-9223372036854775808");
+  EXPECT_EQ(Format(numeric_limits<std::int64_t>::max()),
+            "9223372036854775807");
+  EXPECT_EQ(Format(numeric_limits<std::uint64_t>::max()),
+            "18446744073709551615");
+
+  for (std::int64_t value = -100000; value <= 100000; value += 7) {
+    EXPECT_EQ(Format(value), std::to_string(value));
+  }
+}
+
+// Tests that doubles and floats are formatted with the fewest digits
+// that read back as the same value.
+TEST(NumberFormatTest, FloatingPoint) {
+  EXPECT_EQ(Format(0.0), "0");
+  EXPECT_EQ(Format(-0.0), "-0");
+  EXPECT_EQ(Format(3.5), "3.5");
+  EXPECT_EQ(Format(0.1), "0.1");
+  EXPECT_EQ(Format(-2.0), "-2");
+  EXPECT_EQ(Format(0.1 + 0.2), "0.30000000000000004");
+  EXPECT_EQ(Format(1e20), "1E+20");
+  EXPECT_EQ(Format(1e-5), "1E-05");
+  EXPECT_EQ(Format(numeric_limits<double>::max()), "1.7976931348623157E+308");
+  EXPECT_EQ(Format(0.1f), "0.1");
+  EXPECT_EQ(Format(3.14159274f), "3.1415927");
+  EXPECT_EQ(Format(numeric_limits<float>::max()), "3.4028235E+38");
+
+  EXPECT_EQ(Format(numeric_limits<double>::quiet_NaN()), "NaN");
+  EXPECT_EQ(Format(numeric_limits<double>::infinity()), "Infinity");
+  EXPECT_EQ(Format(-numeric_limits<float>::infinity()), "-Infinity");
+
+  double value = 1.0 / 3;
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(std::strtod(Format(value).c_str(), nullptr), value);
+    value *= -1.7;
+  }
+}
+
+// Tests that AppendNumber keeps what was there and that index names
+// are bracketed.
+TEST(NumberFormatTest, AppendAndIndexNames) {
+  string message = "count=";
+  AppendNumber(42u, &message);
+  EXPECT_EQ(message, "count=42");
+
+  string name;
+  AssignIndexName(0, &name);
+  EXPECT_EQ(name, "[0]");
+  AssignIndexName(1234, &name);
+  EXPECT_EQ(name, "[1234]");
+}
+
+}  // namespace google_cloud_debugger_test
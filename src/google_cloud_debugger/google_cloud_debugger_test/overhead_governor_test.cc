@@ -0,0 +1,145 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "constants.h"
+#include "overhead_governor.h"
+
+using google_cloud_debugger::CaptureLimits;
+using google_cloud_debugger::OverheadGovernor;
+using google_cloud_debugger::kOverheadSampledLogPointHits;
+using google_cloud_debugger::kOverheadWindowMs;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace google_cloud_debugger_test {
+
+// Tests that the level goes up above the budget, down below half of it
+// and stays in between.
+TEST(OverheadGovernorTest, GetNextLevel) {
+  EXPECT_EQ(OverheadGovernor::kNoPropertyEvaluation,
+            OverheadGovernor::GetNextLevel(OverheadGovernor::kNone, 0.2, 0.1));
+  EXPECT_EQ(OverheadGovernor::kPausedSnapshots,
+            OverheadGovernor::GetNextLevel(OverheadGovernor::kPausedSnapshots,
+                                           0.2, 0.1));
+  EXPECT_EQ(OverheadGovernor::kReducedLimits,
+            OverheadGovernor::GetNextLevel(OverheadGovernor::kReducedLimits,
+                                           0.07, 0.1));
+  EXPECT_EQ(OverheadGovernor::kNoPropertyEvaluation,
+            OverheadGovernor::GetNextLevel(OverheadGovernor::kReducedLimits,
+                                           0.01, 0.1));
+  EXPECT_EQ(OverheadGovernor::kNone,
+            OverheadGovernor::GetNextLevel(OverheadGovernor::kNone, 0, 0.1));
+  EXPECT_EQ(OverheadGovernor::kNone,
+            OverheadGovernor::GetNextLevel(OverheadGovernor::kReducedLimits,
+                                           0.2, 0));
+}
+
+// Tests that every window over the budget degrades one more level and
+// that the level is restored once the overhead drops.
+TEST(OverheadGovernorTest, UpdateWithUsage) {
+  OverheadGovernor governor;
+  steady_clock::time_point now = steady_clock::now();
+  governor.UpdateWithUsage(now, 0, 0);
+  EXPECT_EQ(OverheadGovernor::kNone, governor.GetLevel());
+
+  // Without a budget nothing is degraded.
+  governor.UpdateWithUsage(now + milliseconds(kOverheadWindowMs),
+                           kOverheadWindowMs * 1000, 0);
+  EXPECT_EQ(OverheadGovernor::kNone, governor.GetLevel());
+
+  governor.SetBudget(0.1);
+  std::uint64_t window_us = kOverheadWindowMs * 1000;
+  governor.UpdateWithUsage(now, 0, 0);
+
+  // 50% of the time stopped at breakpoints.
+  governor.UpdateWithUsage(now + milliseconds(kOverheadWindowMs), 0,
+                           window_us / 2);
+  EXPECT_EQ(OverheadGovernor::kNoPropertyEvaluation, governor.GetLevel());
+
+  // Windows that have not passed yet change nothing.
+  governor.UpdateWithUsage(now + milliseconds(kOverheadWindowMs + 1),
+                           window_us, window_us);
+  EXPECT_EQ(OverheadGovernor::kNoPropertyEvaluation, governor.GetLevel());
+
+  // 50% of the time on the CPU.
+  governor.UpdateWithUsage(now + milliseconds(2 * kOverheadWindowMs),
+                           window_us / 2, window_us / 2);
+  EXPECT_EQ(OverheadGovernor::kReducedLimits, governor.GetLevel());
+
+  // No overhead at all.
+  governor.UpdateWithUsage(now + milliseconds(3 * kOverheadWindowMs),
+                           window_us / 2, window_us / 2);
+  EXPECT_EQ(OverheadGovernor::kNoPropertyEvaluation, governor.GetLevel());
+
+  governor.SetBudget(0);
+  EXPECT_EQ(OverheadGovernor::kNone, governor.GetLevel());
+}
+
+// Tests that log points are sampled from kSampledLogPoints on.
+TEST(OverheadGovernorTest, ShouldProcessLogPoint) {
+  OverheadGovernor governor;
+  for (std::uint64_t i = 0; i < kOverheadSampledLogPointHits; ++i) {
+    EXPECT_TRUE(governor.ShouldProcessLogPoint());
+  }
+
+  governor.SetBudget(0.1);
+  steady_clock::time_point now = steady_clock::now();
+  std::uint64_t window_us = kOverheadWindowMs * 1000;
+  governor.UpdateWithUsage(now, 0, 0);
+  for (int i = 1; i <= OverheadGovernor::kSampledLogPoints; ++i) {
+    governor.UpdateWithUsage(now + milliseconds(i * kOverheadWindowMs), 0,
+                             i * window_us);
+  }
+  ASSERT_EQ(OverheadGovernor::kSampledLogPoints, governor.GetLevel());
+
+  int processed = 0;
+  for (std::uint64_t i = 0; i < 3 * kOverheadSampledLogPointHits; ++i) {
+    processed += governor.ShouldProcessLogPoint() ? 1 : 0;
+  }
+  EXPECT_EQ(3, processed);
+}
+
+// Tests that ReduceLimits only ever lowers limits.
+TEST(OverheadGovernorTest, ReduceLimits) {
+  CaptureLimits limits;
+  limits.max_stack_frames = 20;
+  limits.max_stack_frames_with_variables = 0;
+  limits.max_collection_items = 100;
+  limits.max_depth = 1;
+  CaptureLimits reduced = OverheadGovernor::ReduceLimits(limits);
+  EXPECT_EQ(OverheadGovernor::kReducedMaxStackFrames,
+            reduced.max_stack_frames);
+  EXPECT_EQ(0u, reduced.max_stack_frames_with_variables);
+  EXPECT_EQ(OverheadGovernor::kReducedMaxCollectionItems,
+            reduced.max_collection_items);
+  EXPECT_EQ(1, reduced.max_depth);
+  EXPECT_EQ(limits.max_bytes, reduced.max_bytes);
+}
+
+// Tests that every degraded level has a status message.
+TEST(OverheadGovernorTest, GetStatusMessage) {
+  EXPECT_TRUE(OverheadGovernor::GetStatusMessage(OverheadGovernor::kNone)
+                  .empty());
+  for (int level = OverheadGovernor::kNoPropertyEvaluation;
+       level <= OverheadGovernor::kPausedSnapshots; ++level) {
+    EXPECT_FALSE(OverheadGovernor::GetStatusMessage(
+                     static_cast<OverheadGovernor::Level>(level))
+                     .empty());
+  }
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,178 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "i_portable_pdb_mocks.h"
+#include "pdb_index_cache.h"
+
+using google_cloud_debugger_portable_pdb::IDocumentIndex;
+using google_cloud_debugger_portable_pdb::MethodInfo;
+using google_cloud_debugger_portable_pdb::PdbIndexCache;
+using google_cloud_debugger_portable_pdb::SequencePoint;
+using std::array;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for PdbIndexCache.
+class PdbIndexCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    file_paths_ = {"/app/program.cs", "/app/util.cs"};
+    methods_.resize(file_paths_.size());
+
+    MethodInfo method;
+    method.method_def = 0x06000001;
+    method.first_line = 10;
+    method.last_line = 20;
+
+    SequencePoint sequence_point;
+    sequence_point.il_offset = 4;
+    sequence_point.start_line = 12;
+    sequence_point.start_col = 5;
+    sequence_point.end_line = 13;
+    sequence_point.end_col = 9;
+    sequence_point.is_hidden = true;
+    method.sequence_points.push_back(sequence_point);
+
+    methods_[0].push_back(method);
+    documents_ = CreateDocuments(file_paths_);
+  }
+
+  virtual void TearDown() { std::remove(cache_file_.c_str()); }
+
+  // Creates document index mocks with the given paths that return the
+  // methods in methods_.
+  vector<unique_ptr<IDocumentIndex>> CreateDocuments(
+      const vector<string> &file_paths) {
+    mock_file_paths_.push_back(file_paths);
+    vector<string> &paths = mock_file_paths_.back();
+
+    vector<unique_ptr<IDocumentIndex>> documents;
+    for (size_t i = 0; i < paths.size(); ++i) {
+      unique_ptr<IDocumentIndexMock> document(new (std::nothrow)
+                                                  IDocumentIndexMock());
+      ON_CALL(*document, GetFilePath()).WillByDefault(Return(paths[i]));
+      ON_CALL(*document, GetMethods()).WillByDefault(ReturnRef(methods_[i]));
+      documents.push_back(std::move(document));
+    }
+    return documents;
+  }
+
+  string cache_file_ = "pdb_index_cache_test.index";
+  vector<string> file_paths_;
+  vector<vector<MethodInfo>> methods_;
+  vector<unique_ptr<IDocumentIndex>> documents_;
+
+  // Keeps the paths returned by the mocks alive.
+  std::list<vector<string>> mock_file_paths_;
+};
+
+// Tests that the cache file is named after the PDB id.
+TEST_F(PdbIndexCacheTest, GetCacheFilePath) {
+  array<uint8_t, 20> pdb_id = {};
+  pdb_id[0] = 0xAB;
+  pdb_id[19] = 0x01;
+
+  string expected_name = "ab" + string(36, '0') + "01.index";
+  EXPECT_EQ(PdbIndexCache::GetCacheFilePath("/tmp", pdb_id),
+            "/tmp/" + expected_name);
+  EXPECT_EQ(PdbIndexCache::GetCacheFilePath("/tmp/", pdb_id),
+            "/tmp/" + expected_name);
+}
+
+// Tests that the methods read back are the ones written.
+TEST_F(PdbIndexCacheTest, RoundTrip) {
+  ASSERT_TRUE(PdbIndexCache::Write(cache_file_, documents_));
+
+  vector<vector<MethodInfo>> result;
+  ASSERT_TRUE(PdbIndexCache::Read(cache_file_, documents_, &result));
+  ASSERT_EQ(result.size(), 2);
+  ASSERT_EQ(result[0].size(), 1);
+  EXPECT_TRUE(result[1].empty());
+
+  const MethodInfo &method = result[0][0];
+  EXPECT_EQ(method.method_def, 0x06000001);
+  EXPECT_EQ(method.first_line, 10);
+  EXPECT_EQ(method.last_line, 20);
+
+  ASSERT_EQ(method.sequence_points.size(), 1);
+  SequencePoint sequence_point = *method.sequence_points.begin();
+  EXPECT_EQ(sequence_point.il_offset, 4);
+  EXPECT_EQ(sequence_point.start_line, 12);
+  EXPECT_EQ(sequence_point.start_col, 5);
+  EXPECT_EQ(sequence_point.end_line, 13);
+  EXPECT_EQ(sequence_point.end_col, 9);
+  EXPECT_TRUE(sequence_point.is_hidden);
+}
+
+// Tests that a cache written for other documents is ignored.
+TEST_F(PdbIndexCacheTest, DocumentMismatch) {
+  ASSERT_TRUE(PdbIndexCache::Write(cache_file_, documents_));
+
+  vector<vector<MethodInfo>> result;
+  vector<unique_ptr<IDocumentIndex>> renamed =
+      CreateDocuments({"/app/program.cs", "/app/other.cs"});
+  EXPECT_FALSE(PdbIndexCache::Read(cache_file_, renamed, &result));
+
+  vector<unique_ptr<IDocumentIndex>> fewer =
+      CreateDocuments({"/app/program.cs"});
+  EXPECT_FALSE(PdbIndexCache::Read(cache_file_, fewer, &result));
+  EXPECT_TRUE(result.empty());
+}
+
+// Tests that missing and invalid cache files are ignored.
+TEST_F(PdbIndexCacheTest, InvalidFile) {
+  vector<vector<MethodInfo>> result;
+  EXPECT_FALSE(PdbIndexCache::Read(cache_file_, documents_, &result));
+
+  {
+    std::ofstream file(cache_file_, std::ios::out | std::ios::binary);
+    file << "not a cache file";
+  }
+  EXPECT_FALSE(PdbIndexCache::Read(cache_file_, documents_, &result));
+
+  // A truncated cache file is rejected.
+  ASSERT_TRUE(PdbIndexCache::Write(cache_file_, documents_));
+  string content;
+  {
+    std::ifstream file(cache_file_, std::ios::in | std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(cache_file_,
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size() - 3);
+  }
+  EXPECT_FALSE(PdbIndexCache::Read(cache_file_, documents_, &result));
+  EXPECT_TRUE(result.empty());
+
+  EXPECT_FALSE(PdbIndexCache::Read(cache_file_, documents_, nullptr));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,102 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <string>
+
+#include "document_index.h"
+#include "pdb_index_store.h"
+
+using google_cloud_debugger_portable_pdb::DocumentIndex;
+using google_cloud_debugger_portable_pdb::DocumentMethods;
+using google_cloud_debugger_portable_pdb::MethodInfo;
+using google_cloud_debugger_portable_pdb::PdbIndexStore;
+using std::array;
+using std::shared_ptr;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for PdbIndexStore.
+class PdbIndexStoreTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    pdb_id_.fill(0xAB);
+    MethodInfo method;
+    method.method_def = 0x06000001;
+    method.first_line = 10;
+    method.last_line = 20;
+    methods_->methods.push_back(method);
+  }
+
+  array<uint8_t, 20> pdb_id_;
+  string file_path_ = "/app/program.cs";
+  shared_ptr<DocumentMethods> methods_{new DocumentMethods()};
+  PdbIndexStore store_;
+};
+
+// Tests that the methods of a document are found by PDB id, document
+// and path.
+TEST_F(PdbIndexStoreTest, FindsAddedMethods) {
+  EXPECT_EQ(store_.Find(pdb_id_, 0, file_path_), nullptr);
+  EXPECT_EQ(store_.Add(pdb_id_, 0, file_path_, methods_), methods_);
+  EXPECT_EQ(store_.Find(pdb_id_, 0, file_path_), methods_);
+
+  array<uint8_t, 20> other_pdb_id = pdb_id_;
+  other_pdb_id[0] = 0;
+  EXPECT_EQ(store_.Find(other_pdb_id, 0, file_path_), nullptr);
+  EXPECT_EQ(store_.Find(pdb_id_, 1, file_path_), nullptr);
+  EXPECT_EQ(store_.Find(pdb_id_, 0, "/app/other.cs"), nullptr);
+}
+
+// Tests that the methods added first are kept.
+TEST_F(PdbIndexStoreTest, KeepsFirstMethods) {
+  shared_ptr<DocumentMethods> other_methods(new DocumentMethods());
+  store_.Add(pdb_id_, 0, file_path_, methods_);
+  EXPECT_EQ(store_.Add(pdb_id_, 0, file_path_, other_methods), methods_);
+  EXPECT_EQ(store_.Find(pdb_id_, 0, file_path_), methods_);
+}
+
+// Tests that the store does not keep methods alive.
+TEST_F(PdbIndexStoreTest, ReleasesUnusedMethods) {
+  store_.Add(pdb_id_, 0, file_path_, methods_);
+  methods_.reset();
+  EXPECT_EQ(store_.Find(pdb_id_, 0, file_path_), nullptr);
+
+  // Documents whose methods are freed are removed as the store grows.
+  for (uint32_t document = 1; document < 1000; ++document) {
+    shared_ptr<DocumentMethods> methods(new DocumentMethods());
+    store_.Add(pdb_id_, document, file_path_, methods);
+  }
+  EXPECT_LT(store_.Size(), 1000);
+}
+
+// Tests that documents with the same content share their methods.
+TEST_F(PdbIndexStoreTest, DocumentsShareMethods) {
+  DocumentIndex first;
+  first.SetMethods(methods_->methods);
+  ASSERT_NE(first.GetSharedMethods(), nullptr);
+
+  DocumentIndex second;
+  EXPECT_EQ(second.GetSharedMethods(), nullptr);
+  EXPECT_TRUE(second.GetMethods().empty());
+  second.SetSharedMethods(first.GetSharedMethods());
+  EXPECT_EQ(&second.GetMethods(), &first.GetMethods());
+  ASSERT_EQ(second.GetMethods().size(), 1);
+  EXPECT_EQ(second.GetMethods()[0].method_def, 0x06000001);
+}
+
+}  // namespace google_cloud_debugger_test
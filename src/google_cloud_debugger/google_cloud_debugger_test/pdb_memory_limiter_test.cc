@@ -0,0 +1,94 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "i_portable_pdb_mocks.h"
+#include "pdb_memory_limiter.h"
+
+using google_cloud_debugger_portable_pdb::PdbMemoryLimiter;
+using ::testing::Return;
+
+namespace google_cloud_debugger_test {
+
+// Tests that nothing is tracked or evicted without a limit.
+TEST(PdbMemoryLimiterTest, NoLimit) {
+  PdbMemoryLimiter limiter;
+  IPortablePdbFileMock pdb;
+  EXPECT_CALL(pdb, EvictMethods()).Times(0);
+
+  limiter.Touch(&pdb, 1000);
+  EXPECT_EQ(limiter.GetBytes(), 0u);
+}
+
+// Tests that the least recently used PDB is evicted once the limit is
+// exceeded, and not the one being used.
+TEST(PdbMemoryLimiterTest, EvictsLeastRecentlyUsed) {
+  PdbMemoryLimiter limiter;
+  limiter.SetLimit(100);
+  IPortablePdbFileMock first;
+  IPortablePdbFileMock second;
+  IPortablePdbFileMock third;
+  EXPECT_CALL(first, EvictMethods()).Times(0);
+  EXPECT_CALL(second, EvictMethods()).WillOnce(Return(40));
+  EXPECT_CALL(third, EvictMethods()).Times(0);
+
+  limiter.Touch(&first, 40);
+  limiter.Touch(&second, 40);
+  limiter.Touch(&first, 40);
+  EXPECT_EQ(limiter.GetBytes(), 80u);
+
+  limiter.Touch(&third, 40);
+  EXPECT_EQ(limiter.GetBytes(), 80u);
+}
+
+// Tests that PDBs that cannot be evicted are skipped.
+TEST(PdbMemoryLimiterTest, SkipsPinnedPdbs) {
+  PdbMemoryLimiter limiter;
+  limiter.SetLimit(100);
+  IPortablePdbFileMock pinned;
+  IPortablePdbFileMock unpinned;
+  IPortablePdbFileMock used;
+  EXPECT_CALL(pinned, EvictMethods()).WillRepeatedly(Return(0));
+  EXPECT_CALL(unpinned, EvictMethods()).WillOnce(Return(40));
+  EXPECT_CALL(used, EvictMethods()).Times(0);
+
+  limiter.Touch(&pinned, 40);
+  limiter.Touch(&unpinned, 40);
+  limiter.Touch(&used, 40);
+  EXPECT_EQ(limiter.GetBytes(), 80u);
+
+  // The limit stays exceeded if only pinned PDBs are left.
+  limiter.Touch(&used, 80);
+  EXPECT_EQ(limiter.GetBytes(), 120u);
+}
+
+// Tests that removed PDBs are no longer tracked.
+TEST(PdbMemoryLimiterTest, Remove) {
+  PdbMemoryLimiter limiter;
+  limiter.SetLimit(100);
+  IPortablePdbFileMock first;
+  IPortablePdbFileMock second;
+  EXPECT_CALL(first, EvictMethods()).Times(0);
+  EXPECT_CALL(second, EvictMethods()).Times(0);
+
+  limiter.Touch(&first, 60);
+  limiter.Remove(&first);
+  EXPECT_EQ(limiter.GetBytes(), 0u);
+  limiter.Touch(&second, 60);
+  EXPECT_EQ(limiter.GetBytes(), 60u);
+}
+
+}  // namespace google_cloud_debugger_test
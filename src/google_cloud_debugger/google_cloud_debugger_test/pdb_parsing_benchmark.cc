@@ -0,0 +1,275 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Measures how fast Portable PDBs are parsed and how much memory they
+// take, without a debugged application.
+//
+// The benchmark takes the paths of assemblies that have their Portable
+// PDB next to them, from small libraries up to large framework
+// assemblies. For every assembly, it reports the median time of
+// PortablePdbFile::ParsePdbFile, which reads the metadata tables and
+// builds the document and path indices, of ParseMethods, which builds
+// the methods and sequence point index of every document, and of
+// resolving a breakpoint at the first line of every method with
+// DbgBreakpoint::TrySetBreakpoint. It also reports the peak memory used
+// while parsing the PDB.
+
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark_results.h"
+#include "dbg_breakpoint.h"
+#include "i_cor_debug_helper_mock.h"
+#include "i_cor_debug_mocks.h"
+#include "optionparser.h"
+#include "portable_pdb_file.h"
+#include "string_stream_wrapper.h"
+
+using google::cloud::diagnostics::debug::Breakpoint_LogLevel_INFO;
+using google_cloud_debugger::ConvertStringToWCharPtr;
+using google_cloud_debugger::DbgBreakpoint;
+using google_cloud_debugger_portable_pdb::IDocumentIndex;
+using google_cloud_debugger_portable_pdb::MethodInfo;
+using google_cloud_debugger_portable_pdb::PortablePdbFile;
+using google_cloud_debugger_test::BenchmarkResults;
+using google_cloud_debugger_test::ICorDebugHelperMock;
+using google_cloud_debugger_test::ICorDebugModuleMock;
+using std::cerr;
+using std::chrono::steady_clock;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace {
+
+// Number of times every PDB is parsed by default.
+const int kDefaultIterations = 5;
+
+enum optionIndex { UNKNOWN, ITERATIONS };
+
+// Accepts an option that has a positive integer argument.
+option::ArgStatus PositiveNumber(const option::Option &option, bool msg) {
+  if (option.arg != nullptr && atoi(option.arg) > 0) {
+    return option::ARG_OK;
+  }
+  if (msg) {
+    cerr << "Option " << option.name << " requires a positive number.\n";
+  }
+  return option::ARG_ILLEGAL;
+}
+
+const option::Descriptor usage[] = {
+    {UNKNOWN, 0, "", "", option::Arg::None,
+     "USAGE: pdb_parsing_benchmark [options] <assembly.dll>...\n\n"
+     "Every assembly has to have its Portable PDB next to it.\n\n"
+     "Options:"},
+    {ITERATIONS, 0, "", "iterations", PositiveNumber,
+     "  --iterations=<n>  \tNumber of times every PDB is parsed."},
+    {0, 0, 0, 0, 0, 0}};
+
+// Milliseconds since start.
+double MillisecondsSince(steady_clock::time_point start) {
+  std::chrono::duration<double, std::milli> elapsed =
+      steady_clock::now() - start;
+  return elapsed.count();
+}
+
+double Median(vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// Returns the value in kB of the field of /proc/self/status, like
+// "VmHWM" for the peak resident memory of the process.
+long ReadMemoryStatus(const string &field) {
+  std::ifstream status("/proc/self/status");
+  string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, field.size() + 1, field + ":") == 0) {
+      return atol(line.c_str() + field.size() + 1);
+    }
+  }
+  return 0;
+}
+
+// Resets the peak resident memory of the process to its current
+// resident memory. Returns false if the kernel does not support it.
+bool ResetPeakMemory() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.close();
+  return static_cast<bool>(clear_refs);
+}
+
+// The measurements of one parse of a PDB.
+struct ParseTimes {
+  double parse_ms = 0;
+  double parse_methods_ms = 0;
+  double resolve_ms = 0;
+  size_t documents = 0;
+  size_t breakpoints = 0;
+  size_t resolved = 0;
+};
+
+// Parses the PDB of the assembly at path and resolves a breakpoint at
+// the first line of every method of it.
+bool ParseOnce(const string &path, ParseTimes *times) {
+  vector<WCHAR> module_name = ConvertStringToWCharPtr(path);
+  NiceMock<ICorDebugModuleMock> debug_module;
+  NiceMock<ICorDebugHelperMock> debug_helper;
+  ON_CALL(debug_helper, GetModuleNameFromICorDebugModule(_, _, _))
+      .WillByDefault(DoAll(SetArgPointee<1>(module_name), Return(S_OK)));
+
+  PortablePdbFile pdb_file;
+  if (FAILED(pdb_file.Initialize(&debug_module, &debug_helper))) {
+    cerr << "Failed to initialize the PDB of " << path << std::endl;
+    return false;
+  }
+
+  steady_clock::time_point start = steady_clock::now();
+  if (!pdb_file.ParsePdbFile()) {
+    cerr << "Failed to parse the PDB of " << path << std::endl;
+    return false;
+  }
+  times->parse_ms = MillisecondsSince(start);
+
+  start = steady_clock::now();
+  if (!pdb_file.ParseMethods()) {
+    cerr << "Failed to parse the methods of " << path << std::endl;
+    return false;
+  }
+  times->parse_methods_ms = MillisecondsSince(start);
+
+  // Creates the breakpoints first so that only resolving them is timed.
+  vector<unique_ptr<DbgBreakpoint>> breakpoints;
+  const vector<unique_ptr<IDocumentIndex>> &documents =
+      pdb_file.GetDocumentIndexTable();
+  for (const unique_ptr<IDocumentIndex> &document : documents) {
+    for (const MethodInfo &method : document->GetMethods()) {
+      unique_ptr<DbgBreakpoint> breakpoint(new DbgBreakpoint());
+      breakpoint->Initialize(document->GetFilePath(), "benchmark",
+                             method.first_line, 0, false, "",
+                             Breakpoint_LogLevel_INFO, "", {});
+      breakpoints.push_back(std::move(breakpoint));
+    }
+  }
+
+  start = steady_clock::now();
+  times->resolved = 0;
+  for (const unique_ptr<DbgBreakpoint> &breakpoint : breakpoints) {
+    if (breakpoint->TrySetBreakpoint(&pdb_file)) {
+      ++times->resolved;
+    }
+  }
+  times->resolve_ms = MillisecondsSince(start);
+  times->documents = documents.size();
+  times->breakpoints = breakpoints.size();
+  return true;
+}
+
+// Parses the PDB of the assembly at path iterations times, prints the
+// median times and the peak memory and adds them to results.
+bool MeasureModule(const string &path, int iterations, bool measure_memory,
+                   BenchmarkResults *results) {
+  long resident_kb = 0;
+  if (measure_memory) {
+    resident_kb = ReadMemoryStatus("VmRSS");
+  }
+
+  vector<double> parse_ms;
+  vector<double> parse_methods_ms;
+  vector<double> resolve_us;
+  ParseTimes times;
+  for (int i = 0; i < iterations; ++i) {
+    if (!ParseOnce(path, &times)) {
+      return false;
+    }
+    parse_ms.push_back(times.parse_ms);
+    parse_methods_ms.push_back(times.parse_methods_ms);
+    resolve_us.push_back(times.breakpoints == 0
+                             ? 0
+                             : times.resolve_ms * 1000 / times.breakpoints);
+  }
+
+  string name = path.substr(path.find_last_of('/') + 1);
+  printf("%-40s %6zu %8zu %8zu %10.2f %10.2f %10.2f", name.c_str(),
+         times.documents, times.breakpoints, times.resolved,
+         Median(parse_ms), Median(parse_methods_ms), Median(resolve_us));
+  results->Add(name + " parse ms", Median(parse_ms), true);
+  results->Add(name + " methods ms", Median(parse_methods_ms), true);
+  results->Add(name + " resolve us", Median(resolve_us), true);
+  if (measure_memory) {
+    long peak_kb = ReadMemoryStatus("VmHWM") - resident_kb;
+    printf(" %10.1f", std::max(0L, peak_kb) / 1024.0);
+    results->Add(name + " peak MB", std::max(0L, peak_kb) / 1024.0, true,
+                 0.1);
+  }
+  printf("\n");
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 0) {
+    // Skips first argument.
+    argc -= 1;
+    argv += 1;
+  }
+
+  option::Stats stats(usage, argc, argv);
+  vector<option::Option> options(stats.options_max);
+  vector<option::Option> buffer(stats.buffer_max);
+  option::Parser parse(usage, argc, argv, options.data(), buffer.data());
+  if (parse.error() || options[UNKNOWN].count() ||
+      parse.nonOptionsCount() == 0) {
+    option::printUsage(std::cout, usage);
+    return -1;
+  }
+
+  int iterations = options[ITERATIONS] ? atoi(options[ITERATIONS].arg)
+                                       : kDefaultIterations;
+
+  // The peak memory of every module is measured from a reset of the
+  // peak of the process, which needs Linux 4.0 or later.
+  bool measure_memory = ResetPeakMemory();
+  BenchmarkResults results("pdb_parsing_benchmark", 0.25);
+  printf("%-40s %6s %8s %8s %10s %10s %10s%s\n", "module", "docs",
+         "methods", "resolved", "parse ms", "methods ms", "resolve us",
+         measure_memory ? "    peak MB" : "");
+  for (int i = 0; i < parse.nonOptionsCount(); ++i) {
+    if (measure_memory) {
+      ResetPeakMemory();
+    }
+    if (!MeasureModule(parse.nonOption(i), iterations, measure_memory,
+                       &results)) {
+      return -1;
+    }
+  }
+  return results.Write() ? 0 : 1;
+}
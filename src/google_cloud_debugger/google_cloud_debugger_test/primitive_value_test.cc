@@ -0,0 +1,76 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "dbg_primitive.h"
+#include "dbg_string.h"
+#include "primitive_value.h"
+
+using google_cloud_debugger::DbgObject;
+using google_cloud_debugger::DbgPrimitive;
+using google_cloud_debugger::DbgString;
+using google_cloud_debugger::PrimitiveValue;
+using std::shared_ptr;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a value is held with its type and converted when read.
+TEST(PrimitiveValueTest, SetAndGet) {
+  PrimitiveValue value;
+  EXPECT_EQ(CorElementType::ELEMENT_TYPE_END, value.GetType());
+  int32_t int_value = 0;
+  EXPECT_EQ(E_FAIL, value.Get(&int_value));
+
+  value.Set(static_cast<int16_t>(-7));
+  EXPECT_EQ(CorElementType::ELEMENT_TYPE_I2, value.GetType());
+  EXPECT_EQ(S_OK, value.Get(&int_value));
+  EXPECT_EQ(-7, int_value);
+
+  value.Set(2.5);
+  EXPECT_EQ(CorElementType::ELEMENT_TYPE_R8, value.GetType());
+  EXPECT_EQ(S_OK, value.Get(&int_value));
+  EXPECT_EQ(2, int_value);
+
+  value.Set(true);
+  EXPECT_EQ(CorElementType::ELEMENT_TYPE_BOOLEAN, value.GetType());
+  bool bool_value = false;
+  EXPECT_EQ(S_OK, value.Get(&bool_value));
+  EXPECT_TRUE(bool_value);
+}
+
+// Tests reading the value of a DbgPrimitive and creating one back.
+TEST(PrimitiveValueTest, DbgObjects) {
+  DbgPrimitive<uint64_t> primitive(42);
+  PrimitiveValue value;
+  EXPECT_EQ(S_OK, value.SetFromDbgObject(&primitive));
+  EXPECT_EQ(CorElementType::ELEMENT_TYPE_U8, value.GetType());
+
+  shared_ptr<DbgObject> dbg_object;
+  EXPECT_EQ(S_OK, value.CreateDbgObject(&dbg_object));
+  DbgPrimitive<uint64_t> *created =
+      dynamic_cast<DbgPrimitive<uint64_t> *>(dbg_object.get());
+  ASSERT_TRUE(created != nullptr);
+  EXPECT_EQ(42u, created->GetValue());
+
+  // Objects that are not primitives can't be held.
+  DbgString string_object("42");
+  EXPECT_TRUE(FAILED(value.SetFromDbgObject(&string_object)));
+  EXPECT_TRUE(FAILED(value.SetFromDbgObject(nullptr)));
+  EXPECT_EQ(E_FAIL, PrimitiveValue().CreateDbgObject(&dbg_object));
+}
+
+}  // namespace google_cloud_debugger_test
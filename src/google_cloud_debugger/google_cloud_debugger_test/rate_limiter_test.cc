@@ -0,0 +1,74 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "rate_limiter.h"
+
+using google_cloud_debugger::RateLimiter;
+using std::chrono::milliseconds;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a full bucket gives out its capacity and then refills at
+// the fill rate.
+TEST(RateLimiterTest, RequestTokens) {
+  RateLimiter limiter(10, 3);
+  RateLimiter::Clock::time_point now = RateLimiter::Clock::now();
+
+  EXPECT_TRUE(limiter.RequestTokens(2, now));
+  EXPECT_TRUE(limiter.RequestTokens(1, now));
+  EXPECT_FALSE(limiter.RequestTokens(1, now));
+  EXPECT_FALSE(limiter.HasTokens(now));
+
+  // 10 tokens a second is 1 token every 100 ms.
+  now += milliseconds(100);
+  EXPECT_TRUE(limiter.RequestTokens(1, now));
+  EXPECT_FALSE(limiter.RequestTokens(1, now));
+
+  // The bucket does not fill above its capacity.
+  now += milliseconds(10000);
+  EXPECT_TRUE(limiter.RequestTokens(3, now));
+  EXPECT_FALSE(limiter.RequestTokens(1, now));
+}
+
+// Tests that consuming more tokens than the bucket has keeps it empty
+// until the debt is refilled.
+TEST(RateLimiterTest, ConsumeTokens) {
+  RateLimiter limiter(10, 5);
+  RateLimiter::Clock::time_point now = RateLimiter::Clock::now();
+
+  limiter.ConsumeTokens(7, now);
+  EXPECT_FALSE(limiter.HasTokens(now));
+
+  now += milliseconds(150);
+  EXPECT_FALSE(limiter.HasTokens(now));
+
+  now += milliseconds(100);
+  EXPECT_TRUE(limiter.HasTokens(now));
+  EXPECT_FALSE(limiter.RequestTokens(1, now));
+}
+
+// Tests that time going backwards does not take tokens away.
+TEST(RateLimiterTest, EarlierTime) {
+  RateLimiter limiter(10, 2);
+  RateLimiter::Clock::time_point now = RateLimiter::Clock::now();
+
+  EXPECT_TRUE(limiter.RequestTokens(1, now));
+  EXPECT_TRUE(limiter.RequestTokens(1, now - milliseconds(1000)));
+  EXPECT_FALSE(limiter.RequestTokens(1, now));
+}
+
+}  // namespace google_cloud_debugger_test
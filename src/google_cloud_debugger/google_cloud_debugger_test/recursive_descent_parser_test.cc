@@ -0,0 +1,231 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "csharp_expression.h"
+#include "expression_util.h"
+#include "recursive_descent_parser.h"
+
+using google_cloud_debugger::CSharpExpression;
+using google_cloud_debugger::ParseExpressionWithAntlr;
+using google_cloud_debugger::RecursiveDescentParser;
+using std::string;
+using std::unique_ptr;
+
+namespace google_cloud_debugger_test {
+
+// Returns the tree of expression printed, or "<null>" if it is null.
+static string PrintTree(const unique_ptr<CSharpExpression> &expression) {
+  if (!expression) {
+    return "<null>";
+  }
+  std::ostringstream os;
+  expression->Print(&os, false);
+  return os.str();
+}
+
+// Checks that both parsers build the same tree for expression.
+static void ExpectSameTree(const string &expression) {
+  unique_ptr<CSharpExpression> antlr = ParseExpressionWithAntlr(expression);
+  unique_ptr<CSharpExpression> parsed =
+      RecursiveDescentParser::Parse(expression);
+  EXPECT_TRUE(antlr != nullptr) << expression;
+  EXPECT_EQ(PrintTree(antlr), PrintTree(parsed)) << expression;
+}
+
+// Checks that both parsers reject expression.
+static void ExpectBothFail(const string &expression) {
+  EXPECT_TRUE(ParseExpressionWithAntlr(expression) == nullptr) << expression;
+  EXPECT_TRUE(RecursiveDescentParser::Parse(expression) == nullptr)
+      << expression;
+}
+
+// Returns expression nested in depth pairs of parentheses.
+static string Parenthesize(const string &expression, int depth) {
+  return string(depth, '(') + expression + string(depth, ')');
+}
+
+TEST(RecursiveDescentParserTest, Literals) {
+  const char *expressions[] = {
+      "0",         "7",          "123",       "2147483647", "10L",
+      "10l",       "0x1F",       "017",       "0777L",      "1.5",
+      "1.5f",      "1.5D",       ".5",        "'a'",        "'\\n'",
+      "'\\''",     "'\\\\'",     "'\\u0041'", "'\\0'",      "\"\"",
+      "\"abc\"",   "\"a\\tb\"",  "\"\\\"\"",  "\"\\u00e9\"", "true",
+      "false",     "null",
+  };
+  for (const char *expression : expressions) {
+    ExpectSameTree(expression);
+  }
+}
+
+TEST(RecursiveDescentParserTest, Operators) {
+  const char *expressions[] = {
+      "a + b",
+      "a - b - c",
+      "a + b * c",
+      "(a + b) * c",
+      "a * b / c % d",
+      "a << 2 >> 3 >>> 4",
+      "a < b",
+      "a <= b == c >= d",
+      "a != b > c",
+      "a & b | c ^ d",
+      "a && b || c && d",
+      "a || b && c | d ^ e & f == g < h << i + j * k",
+      "a ? b : c",
+      "a ? b ? c : d : e ? f : g",
+      "a || b ? c + 1 : d * 2",
+      "-a",
+      "+a",
+      "- -a",
+      "!a",
+      "~a",
+      "!!a",
+      "-a * -b",
+      "a - -1",
+  };
+  for (const char *expression : expressions) {
+    ExpectSameTree(expression);
+  }
+}
+
+TEST(RecursiveDescentParserTest, Primaries) {
+  const char *expressions[] = {
+      "a",
+      "a.b",
+      "a.b.c",
+      "a[1]",
+      "a[i + 1][j]",
+      "a.b[2].c",
+      "f()",
+      "f(1)",
+      "f(1, b, \"c\")",
+      "a.f()",
+      "a.b.f(x).g(y, z)",
+      "a[f(1)].b",
+      "f(g(h(1)))",
+      "(a).b",
+      "(a + b).c",
+      "(f(x))[0]",
+      "\"abc\".Length",
+      "this.a",
+  };
+  for (const char *expression : expressions) {
+    ExpectSameTree(expression);
+  }
+}
+
+TEST(RecursiveDescentParserTest, Casts) {
+  const char *expressions[] = {
+      "(int)a",
+      "(System.String)a",
+      "(A.B.C)a.b",
+      "(int)(a + b)",
+      "(int)!a",
+      "(int)~a",
+      "(int)f(1)",
+      "(int)1",
+      "(int)\"a\"",
+      "(int)(long)a",
+      "(a) + b",
+      "(a) - b",
+      "(a) * b",
+      "(a)[0]",
+      "(a.b)",
+      "(int)",
+      "(int)a * b",
+  };
+  for (const char *expression : expressions) {
+    ExpectSameTree(expression);
+  }
+}
+
+TEST(RecursiveDescentParserTest, Whitespace) {
+  const char *expressions[] = {
+      "  a  ",
+      "a\t+\nb",
+      "a /* comment */ + b",
+      "a + b // comment",
+      "/**/a",
+  };
+  for (const char *expression : expressions) {
+    ExpectSameTree(expression);
+  }
+}
+
+TEST(RecursiveDescentParserTest, Invalid) {
+  const char *expressions[] = {
+      "",       "a +",     "+",        "(a",       "a)",      "a b",
+      "a ? b",  "a ? : b", "f(",       "f(a,)",    "f(,a)",   "a[",
+      "a[]",    "a.",      "a.1",      "1a",       "a = b",   "a;",
+      "{a}",    "'",       "''",       "'ab'",     "\"abc",   "'\\q'",
+      "\"\\q\"", "/* a",   "a ## b",   "()",       "a..b",    "5.",
+      "1e10",   "2e+3f",   "0XabL",    "4294967296",
+  };
+  for (const char *expression : expressions) {
+    ExpectBothFail(expression);
+  }
+}
+
+// Tests that both parsers reject the expressions whose tree is deeper
+// than the limit, and accept the ones just below.
+TEST(RecursiveDescentParserTest, MaxTreeDepth) {
+  int depth = 0;
+  while (ParseExpressionWithAntlr(Parenthesize("a", depth + 1)) != nullptr) {
+    ++depth;
+    ASSERT_LT(depth, RecursiveDescentParser::kMaxTreeDepth);
+  }
+  ExpectSameTree(Parenthesize("a", depth));
+  ExpectBothFail(Parenthesize("a", depth + 1));
+  ExpectBothFail(Parenthesize("a", 1000));
+
+  string sum = "a";
+  while (ParseExpressionWithAntlr(sum + " + a") != nullptr) {
+    sum += " + a";
+  }
+  ExpectSameTree(sum);
+  ExpectBothFail(sum + " + a");
+
+  ExpectBothFail(string(1000, '-') + "a");
+  ExpectBothFail(string(1000, '!') + "a");
+}
+
+// The ANTLR lexer turns string literals with the text of a keyword into
+// the keyword. The recursive descent parser keeps them strings.
+TEST(RecursiveDescentParserTest, KeywordStrings) {
+  unique_ptr<CSharpExpression> antlr = ParseExpressionWithAntlr("\"null\"");
+  unique_ptr<CSharpExpression> parsed =
+      RecursiveDescentParser::Parse("\"null\"");
+  EXPECT_EQ(PrintTree(RecursiveDescentParser::Parse("null")),
+            PrintTree(antlr));
+  EXPECT_EQ(PrintTree(RecursiveDescentParser::Parse("\"nul\"")).size() + 1,
+            PrintTree(parsed).size());
+  EXPECT_NE(PrintTree(antlr), PrintTree(parsed));
+}
+
+// The ANTLR parser loses the lexer errors after a parenthesized name while
+// it guesses whether the name is a cast. The recursive descent parser
+// reports them.
+TEST(RecursiveDescentParserTest, UnterminatedCommentAfterCast) {
+  EXPECT_TRUE(ParseExpressionWithAntlr("(a) /* b") != nullptr);
+  EXPECT_TRUE(RecursiveDescentParser::Parse("(a) /* b") == nullptr);
+  ExpectBothFail("(a) #");
+}
+
+}  // namespace google_cloud_debugger_test
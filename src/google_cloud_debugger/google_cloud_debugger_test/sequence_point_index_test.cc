@@ -0,0 +1,163 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "document_index.h"
+#include "sequence_point_index.h"
+
+using google_cloud_debugger_portable_pdb::MethodInfo;
+using google_cloud_debugger_portable_pdb::SequencePoint;
+using google_cloud_debugger_portable_pdb::SequencePointIndex;
+using google_cloud_debugger_portable_pdb::SequencePointLocation;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for SequencePointIndex.
+class SequencePointIndexTest : public ::testing::Test {
+ protected:
+  // Adds a method that spans first_line to last_line to methods_.
+  MethodInfo *AddMethod(uint32_t method_def, uint32_t first_line,
+                        uint32_t last_line) {
+    MethodInfo method;
+    method.method_def = method_def;
+    method.first_line = first_line;
+    method.last_line = last_line;
+    methods_.push_back(method);
+    return &methods_.back();
+  }
+
+  // Adds a sequence point to method.
+  void AddSequencePoint(MethodInfo *method, uint32_t il_offset,
+                        uint32_t start_line, uint32_t end_line,
+                        bool is_hidden = false) {
+    SequencePoint sequence_point;
+    sequence_point.il_offset = il_offset;
+    sequence_point.start_line = start_line;
+    sequence_point.end_line = end_line;
+    sequence_point.is_hidden = is_hidden;
+    method->sequence_points.push_back(sequence_point);
+  }
+
+  vector<MethodInfo> methods_;
+  SequencePointIndex index_;
+  SequencePointLocation location_;
+};
+
+// Tests that a line resolves to the statement that starts on it.
+TEST_F(SequencePointIndexTest, StatementOnLine) {
+  MethodInfo *method = AddMethod(1, 10, 20);
+  AddSequencePoint(method, 0, 10, 10);
+  AddSequencePoint(method, 5, 12, 12);
+  AddSequencePoint(method, 9, 14, 14);
+  index_.Initialize(methods_);
+
+  EXPECT_TRUE(index_.FindSequencePoint(12, &location_));
+  EXPECT_EQ(location_.method_def, 1);
+  EXPECT_EQ(location_.il_offset, 5);
+  EXPECT_EQ(location_.start_line, 12);
+
+  // Line 13 has no statement so the next one is used.
+  EXPECT_TRUE(index_.FindSequencePoint(13, &location_));
+  EXPECT_EQ(location_.il_offset, 9);
+  EXPECT_EQ(location_.start_line, 14);
+}
+
+// Tests that a line inside a multi-line statement resolves to it.
+TEST_F(SequencePointIndexTest, MultiLineStatement) {
+  MethodInfo *method = AddMethod(1, 10, 20);
+  AddSequencePoint(method, 0, 10, 10);
+  AddSequencePoint(method, 5, 11, 14);
+  AddSequencePoint(method, 9, 15, 15);
+  index_.Initialize(methods_);
+
+  EXPECT_TRUE(index_.FindSequencePoint(13, &location_));
+  EXPECT_EQ(location_.il_offset, 5);
+  EXPECT_EQ(location_.start_line, 11);
+}
+
+// Tests that hidden sequence points are never used.
+TEST_F(SequencePointIndexTest, HiddenSequencePoint) {
+  MethodInfo *method = AddMethod(1, 10, 20);
+  AddSequencePoint(method, 0, 12, 12, true);
+  AddSequencePoint(method, 5, 12, 12);
+  AddSequencePoint(method, 7, 16, 16, true);
+  index_.Initialize(methods_);
+
+  EXPECT_TRUE(index_.FindSequencePoint(12, &location_));
+  EXPECT_EQ(location_.il_offset, 5);
+
+  // The only statement after line 13 is hidden.
+  EXPECT_FALSE(index_.FindSequencePoint(13, &location_));
+}
+
+// Tests that the statement after the line that comes first in IL order
+// is used when no statement spans the line.
+TEST_F(SequencePointIndexTest, FirstInILOrder) {
+  MethodInfo *method = AddMethod(1, 10, 30);
+  AddSequencePoint(method, 0, 10, 10);
+  AddSequencePoint(method, 4, 20, 20);
+  AddSequencePoint(method, 8, 15, 15);
+  index_.Initialize(methods_);
+
+  EXPECT_TRUE(index_.FindSequencePoint(12, &location_));
+  EXPECT_EQ(location_.il_offset, 4);
+  EXPECT_EQ(location_.start_line, 20);
+}
+
+// Tests that the innermost method that spans the line is used.
+TEST_F(SequencePointIndexTest, NestedMethods) {
+  MethodInfo *outer = AddMethod(1, 10, 40);
+  AddSequencePoint(outer, 0, 10, 10);
+  AddSequencePoint(outer, 10, 14, 22);
+  AddSequencePoint(outer, 20, 30, 30);
+
+  MethodInfo *lambda = AddMethod(2, 15, 20);
+  AddSequencePoint(lambda, 0, 16, 16);
+  AddSequencePoint(lambda, 3, 18, 18);
+
+  MethodInfo *other = AddMethod(3, 50, 60);
+  AddSequencePoint(other, 0, 50, 50);
+  index_.Initialize(methods_);
+
+  EXPECT_TRUE(index_.FindSequencePoint(18, &location_));
+  EXPECT_EQ(location_.method_def, 2);
+  EXPECT_EQ(location_.il_offset, 3);
+
+  // Past the statements of the lambda, the outer method is used.
+  EXPECT_TRUE(index_.FindSequencePoint(25, &location_));
+  EXPECT_EQ(location_.method_def, 1);
+  EXPECT_EQ(location_.il_offset, 20);
+
+  EXPECT_TRUE(index_.FindSequencePoint(50, &location_));
+  EXPECT_EQ(location_.method_def, 3);
+
+  // No method spans these lines.
+  EXPECT_FALSE(index_.FindSequencePoint(45, &location_));
+  EXPECT_FALSE(index_.FindSequencePoint(5, &location_));
+  EXPECT_FALSE(index_.FindSequencePoint(70, &location_));
+}
+
+// Tests that a null location is rejected.
+TEST_F(SequencePointIndexTest, NullLocation) {
+  MethodInfo *method = AddMethod(1, 10, 20);
+  AddSequencePoint(method, 0, 10, 10);
+  index_.Initialize(methods_);
+
+  EXPECT_FALSE(index_.FindSequencePoint(10, nullptr));
+}
+
+}  // namespace google_cloud_debugger_test
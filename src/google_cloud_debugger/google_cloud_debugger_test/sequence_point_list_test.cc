@@ -0,0 +1,101 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "document_index.h"
+#include "sequence_point_list.h"
+
+using google_cloud_debugger_portable_pdb::MethodInfo;
+using google_cloud_debugger_portable_pdb::MethodsMemoryFootprint;
+using google_cloud_debugger_portable_pdb::SequencePoint;
+using google_cloud_debugger_portable_pdb::SequencePointList;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Returns a sequence point with the given fields.
+SequencePoint CreateSequencePoint(uint32_t il_offset, uint32_t start_line,
+                                  uint32_t start_col, uint32_t end_line,
+                                  uint32_t end_col, bool is_hidden) {
+  SequencePoint sequence_point;
+  sequence_point.il_offset = il_offset;
+  sequence_point.start_line = start_line;
+  sequence_point.start_col = start_col;
+  sequence_point.end_line = end_line;
+  sequence_point.end_col = end_col;
+  sequence_point.is_hidden = is_hidden;
+  return sequence_point;
+}
+
+// Tests that the sequence points are read back in order, including
+// lines that go backward and the line number of hidden sequence points.
+TEST(SequencePointListTest, RoundTrip) {
+  vector<SequencePoint> expected = {
+      CreateSequencePoint(0, 10, 5, 10, 20, false),
+      CreateSequencePoint(4, 0xFEEFEE, 0, 0xFEEFEE, 0, true),
+      CreateSequencePoint(9, 12, 9, 14, 3, false),
+      CreateSequencePoint(15, 3, 1, 3, 30, false),
+      CreateSequencePoint(UINT32_MAX, UINT32_MAX, UINT32_MAX, 0, UINT32_MAX,
+                          true)};
+
+  SequencePointList list;
+  EXPECT_TRUE(list.empty());
+  EXPECT_TRUE(list.begin() == list.end());
+  for (auto &&sequence_point : expected) {
+    list.push_back(sequence_point);
+  }
+  list.ShrinkToFit();
+  ASSERT_EQ(list.size(), expected.size());
+
+  size_t i = 0;
+  for (const SequencePoint &sequence_point : list) {
+    EXPECT_EQ(sequence_point.il_offset, expected[i].il_offset);
+    EXPECT_EQ(sequence_point.start_line, expected[i].start_line);
+    EXPECT_EQ(sequence_point.start_col, expected[i].start_col);
+    EXPECT_EQ(sequence_point.end_line, expected[i].end_line);
+    EXPECT_EQ(sequence_point.end_col, expected[i].end_col);
+    EXPECT_EQ(sequence_point.is_hidden, expected[i].is_hidden);
+    ++i;
+  }
+  EXPECT_EQ(i, expected.size());
+
+  list.clear();
+  EXPECT_TRUE(list.empty());
+  list.push_back(expected[2]);
+  EXPECT_EQ(list.begin()->start_line, 12);
+}
+
+// Tests that typical sequence points take far less memory than
+// an array of SequencePoint.
+TEST(SequencePointListTest, MemoryFootprint) {
+  MethodInfo method;
+  for (uint32_t i = 0; i < 100; ++i) {
+    method.sequence_points.push_back(
+        CreateSequencePoint(i * 6, 100 + i, 9, 100 + i, 40, false));
+  }
+  method.sequence_points.ShrinkToFit();
+
+  MethodsMemoryFootprint footprint;
+  footprint.Add(method);
+  EXPECT_EQ(footprint.methods, 1);
+  EXPECT_EQ(footprint.sequence_points, 100);
+  EXPECT_EQ(footprint.uncompressed_sequence_point_bytes,
+            100 * sizeof(SequencePoint));
+  EXPECT_LT(footprint.sequence_point_bytes,
+            footprint.uncompressed_sequence_point_bytes / 4);
+}
+
+}  // namespace google_cloud_debugger_test
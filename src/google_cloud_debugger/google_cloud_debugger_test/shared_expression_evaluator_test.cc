@@ -0,0 +1,121 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "class_names.h"
+#include "dbg_primitive.h"
+#include "expression_evaluator_mock.h"
+#include "i_eval_coordinator_mock.h"
+#include "shared_expression_evaluator.h"
+
+using google_cloud_debugger::DbgObject;
+using google_cloud_debugger::DbgPrimitive;
+using google_cloud_debugger::SharedExpressionEvaluator;
+using google_cloud_debugger::TypeSignature;
+using std::string;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::ReturnRef;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for SharedExpressionEvaluator.
+class SharedExpressionEvaluatorTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    std::unique_ptr<ExpressionEvaluatorMock> expression_mock(
+        new ExpressionEvaluatorMock());
+    expression_mock_ = expression_mock.get();
+    evaluator_.reset(
+        new SharedExpressionEvaluator(key_, std::move(expression_mock)));
+    ON_CALL(*expression_mock_, GetStaticType())
+        .WillByDefault(ReturnRef(type_));
+  }
+
+  // Key of the subexpression.
+  string key_ = "<member_selector>";
+
+  // Static type of the subexpression.
+  TypeSignature type_{CorElementType::ELEMENT_TYPE_I4,
+                      google_cloud_debugger::kInt32ClassName};
+
+  // Value of the subexpression.
+  std::shared_ptr<DbgObject> value_ =
+      std::shared_ptr<DbgObject>(new DbgPrimitive<int32_t>(42));
+
+  // Evaluator wrapped by evaluator_.
+  ExpressionEvaluatorMock *expression_mock_;
+
+  std::unique_ptr<SharedExpressionEvaluator> evaluator_;
+
+  IEvalCoordinatorMock eval_coordinator_mock_;
+};
+
+// Tests that the subexpression is evaluated and cached if its value is
+// not cached yet.
+TEST_F(SharedExpressionEvaluatorTest, EvaluatesAndCaches) {
+  EXPECT_CALL(*expression_mock_, Compile(_, _, _)).WillOnce(Return(S_OK));
+  EXPECT_EQ(evaluator_->Compile(nullptr, nullptr, nullptr), S_OK);
+  EXPECT_EQ(evaluator_->GetStaticType().cor_type, type_.cor_type);
+
+  EXPECT_CALL(eval_coordinator_mock_, GetCachedExpressionValue(key_, _))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*expression_mock_, Evaluate(_, _, _, _))
+      .WillOnce(DoAll(SetArgPointee<0>(value_), Return(S_OK)));
+  EXPECT_CALL(eval_coordinator_mock_, CacheExpressionValue(key_, value_))
+      .Times(1);
+
+  std::shared_ptr<DbgObject> result;
+  EXPECT_EQ(evaluator_->Evaluate(&result, &eval_coordinator_mock_, nullptr,
+                                 nullptr),
+            S_OK);
+  EXPECT_EQ(result, value_);
+}
+
+// Tests that a cached value is reused without evaluating the
+// subexpression.
+TEST_F(SharedExpressionEvaluatorTest, ReusesCachedValue) {
+  EXPECT_CALL(eval_coordinator_mock_, GetCachedExpressionValue(key_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(value_), Return(true)));
+  EXPECT_CALL(*expression_mock_, Evaluate(_, _, _, _)).Times(0);
+  EXPECT_CALL(eval_coordinator_mock_, CacheExpressionValue(_, _)).Times(0);
+
+  std::shared_ptr<DbgObject> result;
+  EXPECT_EQ(evaluator_->Evaluate(&result, &eval_coordinator_mock_, nullptr,
+                                 nullptr),
+            S_OK);
+  EXPECT_EQ(result, value_);
+}
+
+// Tests that failures are not cached.
+TEST_F(SharedExpressionEvaluatorTest, DoesNotCacheFailures) {
+  EXPECT_CALL(eval_coordinator_mock_, GetCachedExpressionValue(key_, _))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*expression_mock_, Evaluate(_, _, _, _))
+      .WillOnce(Return(E_FAIL));
+  EXPECT_CALL(eval_coordinator_mock_, CacheExpressionValue(_, _)).Times(0);
+
+  std::shared_ptr<DbgObject> result;
+  EXPECT_EQ(evaluator_->Evaluate(&result, &eval_coordinator_mock_, nullptr,
+                                 nullptr),
+            E_FAIL);
+}
+
+}  // namespace google_cloud_debugger_test
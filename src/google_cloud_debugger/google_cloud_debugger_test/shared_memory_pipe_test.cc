@@ -0,0 +1,200 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PLATFORM_UNIX
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "constants.h"
+#include "i_named_pipe_mock.h"
+#include "shared_memory_pipe_unix.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+using google_cloud_debugger::kSharedMemoryHeaderSize;
+using google_cloud_debugger::kSharedMemoryMagic;
+using google_cloud_debugger::kSharedMemoryRingControlSize;
+using google_cloud_debugger::SharedMemoryPipe;
+using std::string;
+using std::unique_ptr;
+
+namespace google_cloud_debugger_test {
+
+// The capacity of the rings, small enough for writes to wrap around.
+const std::uint32_t kCapacity = 16;
+
+// Test Fixture for SharedMemoryPipe. Creates the shared memory the way
+// the agent does and maps it to act as the agent.
+class SharedMemoryPipeTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    char path[] = "/tmp/shared_memory_pipe_testXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    path_ = path;
+
+    size_ = kSharedMemoryHeaderSize +
+            2 * (kSharedMemoryRingControlSize + kCapacity);
+    ASSERT_EQ(ftruncate(fd, size_), 0);
+    memory_ = static_cast<char *>(
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    close(fd);
+    ASSERT_NE(memory_, MAP_FAILED);
+
+    std::uint32_t header[] = {kSharedMemoryMagic, kCapacity};
+    memcpy(memory_, header, sizeof(header));
+
+    doorbell_ = new INamedPipeMock();
+    pipe_.reset(
+        new SharedMemoryPipe(unique_ptr<INamedPipeMock>(doorbell_), path_));
+  }
+
+  virtual void TearDown() {
+    pipe_.reset();
+    munmap(memory_, size_);
+    unlink(path_.c_str());
+  }
+
+  // Returns the field at offset of the control block of the ring the
+  // agent writes to, or of the ring the debugger writes to if outgoing.
+  std::uint64_t *Position(bool outgoing, std::size_t offset) {
+    return reinterpret_cast<std::uint64_t *>(Ring(outgoing) + offset);
+  }
+
+  std::uint32_t *ReaderWaiting(bool outgoing) {
+    return reinterpret_cast<std::uint32_t *>(Ring(outgoing) + 128);
+  }
+
+  char *Data(bool outgoing) {
+    return Ring(outgoing) + kSharedMemoryRingControlSize;
+  }
+
+  char *Ring(bool outgoing) {
+    return memory_ + kSharedMemoryHeaderSize +
+           (outgoing ? kSharedMemoryRingControlSize + kCapacity : 0);
+  }
+
+  // Writes message into the ring of the agent, starting at position.
+  void AgentWrite(const string &message, std::uint64_t position) {
+    for (std::size_t i = 0; i < message.size(); ++i) {
+      Data(false)[(position + i) % kCapacity] = message[i];
+    }
+    *Position(false, 0) = position + message.size();
+  }
+
+  void Connect() {
+    EXPECT_CALL(*doorbell_, WaitForConnection()).WillOnce(Return(S_OK));
+    ASSERT_EQ(pipe_->WaitForConnection(), S_OK);
+  }
+
+  string path_;
+  char *memory_ = nullptr;
+  std::size_t size_ = 0;
+  INamedPipeMock *doorbell_;
+  unique_ptr<SharedMemoryPipe> pipe_;
+};
+
+// Tests that writes go to the ring of the debugger and only ring the
+// doorbell when the agent waits.
+TEST_F(SharedMemoryPipeTest, Write) {
+  Connect();
+  EXPECT_CALL(*doorbell_, Write(_)).Times(0);
+  EXPECT_EQ(pipe_->Write("hello"), S_OK);
+  EXPECT_EQ(*Position(true, 0), 5);
+  EXPECT_EQ(string(Data(true), 5), "hello");
+
+  // The agent read everything and waits for more.
+  *Position(true, 64) = 5;
+  *ReaderWaiting(true) = 1;
+  EXPECT_CALL(*doorbell_, Write(string(1, '\0'))).WillOnce(Return(S_OK));
+  EXPECT_EQ(pipe_->Write("world, again"), S_OK);
+  EXPECT_EQ(*Position(true, 0), 17);
+  EXPECT_EQ(*ReaderWaiting(true), 0);
+
+  // The write wrapped around the end of the ring.
+  EXPECT_EQ(string(Data(true) + 5, 11), "world, agai");
+  EXPECT_EQ(Data(true)[0], 'n');
+}
+
+// Tests that reads return what the agent wrote, across the end of the
+// ring, without waiting while there is something to read.
+TEST_F(SharedMemoryPipeTest, Read) {
+  Connect();
+  EXPECT_CALL(*doorbell_, Read(_)).Times(0);
+  *Position(false, 64) = 12;
+  AgentWrite("abcdefgh", 12);
+
+  string message;
+  EXPECT_EQ(pipe_->ReadExactly(6, &message), S_OK);
+  EXPECT_EQ(message, "abcdef");
+  EXPECT_EQ(pipe_->Read(&message), S_OK);
+  EXPECT_EQ(message, "gh");
+  EXPECT_EQ(*Position(false, 64), 20);
+}
+
+// Tests that a read of an empty ring waits for the doorbell with the
+// waiting flag set.
+TEST_F(SharedMemoryPipeTest, ReadWaitsForDoorbell) {
+  Connect();
+  EXPECT_CALL(*doorbell_, Read(_))
+      .WillOnce(Invoke([this](string *message) {
+        EXPECT_EQ(*ReaderWaiting(false), 1);
+        AgentWrite("abc", 0);
+        message->assign(1, '\0');
+        return S_OK;
+      }));
+
+  string message;
+  EXPECT_EQ(pipe_->Read(&message), S_OK);
+  EXPECT_EQ(message, "abc");
+  EXPECT_EQ(*ReaderWaiting(false), 0);
+}
+
+// Tests that reads fail once the agent closes the pipe.
+TEST_F(SharedMemoryPipeTest, ReadClosed) {
+  Connect();
+  EXPECT_CALL(*doorbell_, Read(_))
+      .WillRepeatedly(Invoke([](string *message) {
+        message->clear();
+        return S_OK;
+      }));
+
+  string message = "previous";
+  EXPECT_EQ(pipe_->Read(&message), S_OK);
+  EXPECT_TRUE(message.empty());
+  EXPECT_EQ(pipe_->ReadExactly(4, &message), E_FAIL);
+}
+
+// Tests that shared memory without the header of the agent is rejected.
+TEST_F(SharedMemoryPipeTest, InvalidHeader) {
+  std::uint32_t capacity = kCapacity * 2;
+  memcpy(memory_ + sizeof(std::uint32_t), &capacity, sizeof(capacity));
+  EXPECT_CALL(*doorbell_, WaitForConnection()).WillOnce(Return(S_OK));
+  EXPECT_EQ(pipe_->WaitForConnection(), E_FAIL);
+
+  string message;
+  EXPECT_EQ(pipe_->Read(&message), E_FAIL);
+}
+
+}  // namespace google_cloud_debugger_test
+
+#endif  //  PLATFORM_UNIX
@@ -0,0 +1,495 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Measures how fast snapshots of synthetic object graphs are populated
+// and how much they allocate, without a live CLR.
+//
+// The graphs are wide classes, deeply nested classes, large arrays and
+// dictionaries made of fake DbgObjects. Every graph is populated into a
+// variable with VariableWrapper::PerformBFS, and into the evaluated
+// expressions of a breakpoint with DbgBreakpoint::PopulateBreakpoint and
+// PopulateCapturedExpressions, which stop when the size of the
+// breakpoint reaches max_bytes. For both, the benchmark reports the time
+// and the heap allocations per variable populated and the final
+// ByteSizeLong of the message.
+//
+// With --replay, the graphs are instead the variables of the snapshots a
+// debugger recorded with --record-snapshots at real breakpoint hits: one
+// graph per snapshot, whose members are the arguments and locals of its
+// stack frames, with the types, values and members they were captured
+// with.
+
+#include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark_results.h"
+#include "breakpoint.pb.h"
+#include "capture_limits.h"
+#include "dbg_breakpoint.h"
+#include "dbg_object.h"
+#include "i_eval_coordinator_mock.h"
+#include "optionparser.h"
+#include "snapshot_recorder.h"
+#include "variable_wrapper.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Breakpoint_LogLevel_INFO;
+using google::cloud::diagnostics::debug::StackFrame;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::CaptureLimits;
+using google_cloud_debugger::DbgBreakpoint;
+using google_cloud_debugger::DbgObject;
+using google_cloud_debugger::ICorDebugHelper;
+using google_cloud_debugger::IEvalCoordinator;
+using google_cloud_debugger::SnapshotRecorder;
+using google_cloud_debugger::SnapshotSizeTracker;
+using google_cloud_debugger::VariableQueue;
+using google_cloud_debugger::VariableWrapper;
+using google_cloud_debugger_test::BenchmarkResults;
+using google_cloud_debugger_test::IEvalCoordinatorMock;
+using std::cerr;
+using std::chrono::steady_clock;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using ::testing::NiceMock;
+
+namespace {
+
+// Number of heap allocations made by the process.
+std::atomic<std::uint64_t> allocations(0);
+
+}  // namespace
+
+// Counts the heap allocations. DbgObjects come from DbgObjectPool, but
+// the graphs are built before the measurements, so this counts the
+// allocations of the protos, strings and vectors of the snapshots.
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void *memory = malloc(size == 0 ? 1 : size);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+  free(memory);
+}
+
+namespace {
+
+// Number of times every graph is populated by default.
+const int kDefaultIterations = 200;
+
+enum optionIndex { UNKNOWN, ITERATIONS, MAXCOLLECTIONITEMS, MAXDEPTH, REPLAY };
+
+// Accepts an option that has a positive integer argument.
+option::ArgStatus PositiveNumber(const option::Option &option, bool msg) {
+  if (option.arg != nullptr && atoi(option.arg) > 0) {
+    return option::ARG_OK;
+  }
+  if (msg) {
+    cerr << "Option " << option.name << " requires a positive number.\n";
+  }
+  return option::ARG_ILLEGAL;
+}
+
+// Accepts an option that has a non-empty argument.
+option::ArgStatus NonEmpty(const option::Option &option, bool msg) {
+  if (option.arg != nullptr && option.arg[0] != 0) {
+    return option::ARG_OK;
+  }
+  if (msg) {
+    cerr << "Option " << option.name << " requires an argument.\n";
+  }
+  return option::ARG_ILLEGAL;
+}
+
+const option::Descriptor usage[] = {
+    {UNKNOWN, 0, "", "", option::Arg::None,
+     "USAGE: snapshot_benchmark [options]\n\n"
+     "Options:"},
+    {ITERATIONS, 0, "", "iterations", PositiveNumber,
+     "  --iterations=<n>  \tNumber of times every graph is populated."},
+    {MAXCOLLECTIONITEMS, 0, "", "max-collection-items", PositiveNumber,
+     "  --max-collection-items=<n>  \tThe maximum number of items of a "
+     "collection that is captured. Defaults to no limit, like "
+     "expressions."},
+    {MAXDEPTH, 0, "", "max-depth", PositiveNumber,
+     "  --max-depth=<n>  \tThe maximum number of levels of members captured "
+     "below a variable."},
+    {REPLAY, 0, "", "replay", NonEmpty,
+     "  --replay=<file>  \tPopulates the variables of the snapshots recorded "
+     "to this file by the debugger with --record-snapshots instead of the "
+     "synthetic graphs."},
+    {0, 0, 0, 0, 0, 0}};
+
+// Object of a synthetic graph. It has a value if it has no members, and
+// its members are captured like the fields of a class, or like the items
+// of a collection if it is a collection.
+class FakeObject : public DbgObject {
+ public:
+  FakeObject(const string &type, const string &value, bool collection)
+      : DbgObject(nullptr, 0, shared_ptr<ICorDebugHelper>()),
+        type_(type),
+        value_(value),
+        collection_(collection) {}
+
+  void Initialize(ICorDebugValue *debug_value, BOOL is_null) override {}
+
+  HRESULT GetTypeString(string *type_string) override {
+    *type_string = type_;
+    return S_OK;
+  }
+
+  HRESULT GetICorDebugValue(ICorDebugValue **debug_value,
+                            ICorDebugEval *debug_eval) override {
+    return E_NOTIMPL;
+  }
+
+  HRESULT PopulateValue(Variable *variable) override {
+    if (members_.empty()) {
+      variable->set_value(value_);
+    }
+    return S_OK;
+  }
+
+  HRESULT PopulateMembers(Variable *variable_proto,
+                          vector<VariableWrapper> *members,
+                          const CaptureLimits &limits,
+                          IEvalCoordinator *eval_coordinator) override {
+    if (members_.empty()) {
+      return S_FALSE;
+    }
+
+    size_t count = members_.size();
+    if (collection_ && count > limits.max_collection_items) {
+      count = limits.max_collection_items;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      Variable *member = variable_proto->add_members();
+      member->set_name(members_[i].first);
+      members->push_back(VariableWrapper(member, members_[i].second));
+    }
+    return S_OK;
+  }
+
+  // Adds a member called name.
+  void AddMember(const string &name, shared_ptr<DbgObject> member) {
+    members_.emplace_back(name, std::move(member));
+  }
+
+ private:
+  string type_;
+  string value_;
+  bool collection_;
+  vector<std::pair<string, shared_ptr<DbgObject>>> members_;
+};
+
+shared_ptr<FakeObject> Value(int index) {
+  return shared_ptr<FakeObject>(new FakeObject(
+      "System.Int32", std::to_string(index * 7919 % 100000), false));
+}
+
+// A class with fields fields of primitive values.
+shared_ptr<DbgObject> CreateWideClass(int fields) {
+  shared_ptr<FakeObject> object(
+      new FakeObject("Benchmark.WideClass", "", false));
+  for (int i = 0; i < fields; ++i) {
+    object->AddMember("Field" + std::to_string(i), Value(i));
+  }
+  return object;
+}
+
+// A chain of depth classes that have a few fields besides the next one.
+shared_ptr<DbgObject> CreateDeepNesting(int depth) {
+  shared_ptr<FakeObject> object(new FakeObject("Benchmark.Node", "", false));
+  object->AddMember("Id", Value(depth));
+  object->AddMember("Name", Value(depth + 1));
+  object->AddMember("Count", Value(depth + 2));
+  if (depth > 1) {
+    object->AddMember("Next", CreateDeepNesting(depth - 1));
+  }
+  return object;
+}
+
+// An array of items primitive values.
+shared_ptr<DbgObject> CreateLargeArray(int items) {
+  shared_ptr<FakeObject> array(new FakeObject("System.Int32[]", "", true));
+  for (int i = 0; i < items; ++i) {
+    array->AddMember("[" + std::to_string(i) + "]", Value(i));
+  }
+  return array;
+}
+
+// A dictionary of entries of a string key and a class, with the keys
+// shown as the names of the entries.
+shared_ptr<DbgObject> CreateDictionary(int entries) {
+  shared_ptr<FakeObject> dictionary(new FakeObject(
+      "System.Collections.Generic.Dictionary<System.String, "
+      "Benchmark.Order>",
+      "", true));
+  for (int i = 0; i < entries; ++i) {
+    shared_ptr<FakeObject> order(
+        new FakeObject("Benchmark.Order", "", false));
+    order->AddMember("Quantity", Value(i));
+    order->AddMember("Price", Value(i + 1));
+    dictionary->AddMember("[\"order-" + std::to_string(i) + "\"]", order);
+  }
+  return dictionary;
+}
+
+// Recreates the object a snapshot captured as variable, with its members.
+// Variables whose members are indices, like [0] or ["key"], are the
+// items of a collection.
+shared_ptr<DbgObject> CreateFromVariable(const Variable &variable) {
+  bool collection = variable.members_size() > 0 &&
+                    !variable.members(0).name().empty() &&
+                    variable.members(0).name()[0] == '[';
+  shared_ptr<FakeObject> object(
+      new FakeObject(variable.type(), variable.value(), collection));
+  for (const Variable &member : variable.members()) {
+    object->AddMember(member.name(), CreateFromVariable(member));
+  }
+  return object;
+}
+
+// Reads the snapshots recorded to path into one graph per snapshot.
+bool ReadRecordedGraphs(
+    const string &path,
+    vector<std::pair<string, shared_ptr<DbgObject>>> *graphs) {
+  std::ifstream input(path, std::ios::in | std::ios::binary);
+  vector<Breakpoint> snapshots;
+  if (!input || !SnapshotRecorder::ReadSnapshots(&input, &snapshots)) {
+    cerr << "Cannot read the recorded snapshots of " << path << std::endl;
+    return false;
+  }
+
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    shared_ptr<FakeObject> frames(new FakeObject("", "", false));
+    for (const StackFrame &frame : snapshots[i].stack_frames()) {
+      for (const Variable &argument : frame.arguments()) {
+        frames->AddMember(argument.name(), CreateFromVariable(argument));
+      }
+      for (const Variable &local : frame.locals()) {
+        frames->AddMember(local.name(), CreateFromVariable(local));
+      }
+    }
+    graphs->emplace_back("recorded " + std::to_string(i), frames);
+  }
+  return true;
+}
+
+// Returns the number of variables in variable and its members.
+size_t CountVariables(const Variable &variable) {
+  size_t count = 1;
+  for (const Variable &member : variable.members()) {
+    count += CountVariables(member);
+  }
+  return count;
+}
+
+// The measurements of populating a graph.
+struct Measurement {
+  size_t variables = 0;
+  double ns_per_variable = 0;
+  double allocations_per_variable = 0;
+  size_t byte_size = 0;
+};
+
+// Populates graph into a variable with PerformBFS iterations times.
+bool MeasurePerformBFS(shared_ptr<DbgObject> graph, int iterations,
+                       const CaptureLimits &limits,
+                       IEvalCoordinator *eval_coordinator,
+                       Measurement *measurement) {
+  VariableQueue *bfs_queue = VariableQueue::GetThreadQueue();
+  double total_ns = 0;
+  std::uint64_t total_allocations = 0;
+  for (int i = 0; i < iterations; ++i) {
+    std::uint64_t allocations_start = allocations.load();
+    steady_clock::time_point start = steady_clock::now();
+    Variable variable;
+    variable.set_name("graph");
+    bfs_queue->push(VariableWrapper(&variable, graph));
+    SnapshotSizeTracker size_tracker(0, limits.max_bytes);
+    HRESULT hr = VariableWrapper::PerformBFS(bfs_queue, limits,
+                                             &size_tracker, eval_coordinator);
+    std::chrono::duration<double, std::nano> elapsed =
+        steady_clock::now() - start;
+    total_ns += elapsed.count();
+    total_allocations += allocations.load() - allocations_start;
+    if (FAILED(hr)) {
+      cerr << "PerformBFS failed with HRESULT " << std::hex << hr
+           << std::endl;
+      return false;
+    }
+
+    measurement->variables = CountVariables(variable);
+    measurement->byte_size = variable.ByteSizeLong();
+  }
+
+  double populated = static_cast<double>(measurement->variables) * iterations;
+  measurement->ns_per_variable = total_ns / populated;
+  measurement->allocations_per_variable = total_allocations / populated;
+  return true;
+}
+
+// Populates graph into the evaluated expressions of a breakpoint
+// iterations times.
+bool MeasurePopulateBreakpoint(shared_ptr<DbgObject> graph, int iterations,
+                               const CaptureLimits &limits,
+                               IEvalCoordinator *eval_coordinator,
+                               Measurement *measurement) {
+  DbgBreakpoint breakpoint;
+  breakpoint.Initialize("/app/Program.cs", "benchmark", 42, 0, false, "",
+                        Breakpoint_LogLevel_INFO, "", {});
+  DbgBreakpoint::ExpressionValues values = {{"graph", graph}};
+
+  double total_ns = 0;
+  std::uint64_t total_allocations = 0;
+  for (int i = 0; i < iterations; ++i) {
+    std::uint64_t allocations_start = allocations.load();
+    steady_clock::time_point start = steady_clock::now();
+    Breakpoint proto_breakpoint;
+    HRESULT hr = breakpoint.PopulateBreakpoint(&proto_breakpoint);
+    if (SUCCEEDED(hr)) {
+      hr = DbgBreakpoint::PopulateCapturedExpressions(
+          &proto_breakpoint, values, limits, eval_coordinator);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        steady_clock::now() - start;
+    total_ns += elapsed.count();
+    total_allocations += allocations.load() - allocations_start;
+    if (FAILED(hr)) {
+      cerr << "PopulateBreakpoint failed with HRESULT " << std::hex << hr
+           << std::endl;
+      return false;
+    }
+
+    measurement->variables = 0;
+    for (const Variable &expression :
+         proto_breakpoint.evaluated_expressions()) {
+      measurement->variables += CountVariables(expression);
+    }
+    measurement->byte_size = proto_breakpoint.ByteSizeLong();
+  }
+
+  double populated = static_cast<double>(measurement->variables) * iterations;
+  measurement->ns_per_variable = total_ns / populated;
+  measurement->allocations_per_variable = total_allocations / populated;
+  return true;
+}
+
+// Prints measurement and adds it to results. The allocations and the size
+// do not depend on the machine, so any increase of them is a regression.
+void PrintMeasurement(const string &graph, const string &method,
+                      const Measurement &measurement,
+                      BenchmarkResults *results) {
+  printf("%-20s %-20s %10zu %10.1f %10.2f %10zu\n", graph.c_str(),
+         method.c_str(), measurement.variables, measurement.ns_per_variable,
+         measurement.allocations_per_variable, measurement.byte_size);
+  string name = graph + "/" + method;
+  results->Add(name + " ns/var", measurement.ns_per_variable, true);
+  results->Add(name + " allocs/var", measurement.allocations_per_variable,
+               true, 0);
+  results->Add(name + " bytes", measurement.byte_size, true, 0);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 0) {
+    // Skips first argument.
+    argc -= 1;
+    argv += 1;
+  }
+
+  option::Stats stats(usage, argc, argv);
+  vector<option::Option> options(stats.options_max);
+  vector<option::Option> buffer(stats.buffer_max);
+  option::Parser parse(usage, argc, argv, options.data(), buffer.data());
+  if (parse.error() || options[UNKNOWN].count()) {
+    option::printUsage(std::cout, usage);
+    return -1;
+  }
+
+  // Collections are captured in full, like the collections of
+  // expressions, so that the graphs are only limited by max_bytes.
+  CaptureLimits limits;
+  limits.max_collection_items = INT32_MAX;
+  int iterations = options[ITERATIONS] ? atoi(options[ITERATIONS].arg)
+                                       : kDefaultIterations;
+  if (options[MAXCOLLECTIONITEMS]) {
+    limits.max_collection_items = atoi(options[MAXCOLLECTIONITEMS].arg);
+  }
+  if (options[MAXDEPTH]) {
+    limits.max_depth = atoi(options[MAXDEPTH].arg);
+  }
+
+  vector<std::pair<string, shared_ptr<DbgObject>>> graphs;
+  if (options[REPLAY]) {
+    if (!ReadRecordedGraphs(options[REPLAY].arg, &graphs)) {
+      return -1;
+    }
+  } else {
+    graphs = {{"wide class", CreateWideClass(500)},
+              {"deep nesting", CreateDeepNesting(100)},
+              {"large array", CreateLargeArray(20000)},
+              {"dictionary", CreateDictionary(5000)}};
+  }
+
+  // Recorded graphs are compared with their own baseline.
+  BenchmarkResults results(
+      options[REPLAY] ? "snapshot_benchmark_replay" : "snapshot_benchmark",
+      0.25);
+  NiceMock<IEvalCoordinatorMock> eval_coordinator;
+  printf("%-20s %-20s %10s %10s %10s %10s\n", "graph", "method", "variables",
+         "ns/var", "allocs/var", "bytes");
+  for (const auto &graph : graphs) {
+    Measurement measurement;
+    if (!MeasurePerformBFS(graph.second, iterations, limits,
+                           &eval_coordinator, &measurement)) {
+      return -1;
+    }
+    PrintMeasurement(graph.first, "PerformBFS", measurement, &results);
+
+    if (!MeasurePopulateBreakpoint(graph.second, iterations, limits,
+                                   &eval_coordinator, &measurement)) {
+      return -1;
+    }
+    PrintMeasurement(graph.first, "PopulateBreakpoint", measurement,
+                     &results);
+  }
+  return results.Write() ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "constants.h"
+#include "snapshot_delta.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::StackFrame;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::kMaximumDeltaSnapshotBreakpoints;
+using google_cloud_debugger::kUnchangedVariableName;
+using google_cloud_debugger::SnapshotDelta;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Returns a snapshot of breakpoint id whose local "counter" has the value
+// counter, next to a local "config" with two fields.
+static Breakpoint CreateSnapshot(const string &id, int counter) {
+  Breakpoint breakpoint;
+  breakpoint.set_id(id);
+  StackFrame *frame = breakpoint.add_stack_frames();
+  frame->set_method_name("Main");
+  Variable *argument = frame->add_arguments();
+  argument->set_name("args");
+  argument->set_type("System.String[]");
+
+  Variable *config = frame->add_locals();
+  config->set_name("config");
+  config->set_type("App.Config");
+  Variable *name = config->add_members();
+  name->set_name("Name");
+  name->set_value("app");
+  Variable *count = config->add_members();
+  count->set_name("Count");
+  count->set_value(std::to_string(counter));
+
+  Variable *local = frame->add_locals();
+  local->set_name("counter");
+  local->set_type("System.Int32");
+  local->set_value(std::to_string(counter));
+  return breakpoint;
+}
+
+// Returns true if variable references the previous snapshot.
+static bool IsUnchanged(const Variable &variable) {
+  Variable reference;
+  reference.set_name(kUnchangedVariableName);
+  return variable.SerializeAsString() == reference.SerializeAsString();
+}
+
+// Tests that the first snapshot of a breakpoint is sent in full and that
+// the variables of the next ones that did not change are references.
+TEST(SnapshotDeltaTest, ReplacesUnchangedVariables) {
+  SnapshotDelta delta;
+  Breakpoint breakpoint = CreateSnapshot("snapshot", 1);
+  Breakpoint original = breakpoint;
+  delta.Encode(&breakpoint);
+  EXPECT_EQ(breakpoint.SerializeAsString(), original.SerializeAsString());
+
+  breakpoint = CreateSnapshot("snapshot", 1);
+  original = breakpoint;
+  delta.Encode(&breakpoint);
+  EXPECT_LT(breakpoint.ByteSizeLong(), original.ByteSizeLong());
+  const StackFrame &frame = breakpoint.stack_frames(0);
+  EXPECT_EQ(frame.method_name(), "Main");
+  EXPECT_TRUE(IsUnchanged(frame.arguments(0)));
+  EXPECT_TRUE(IsUnchanged(frame.locals(0)));
+  EXPECT_TRUE(IsUnchanged(frame.locals(1)));
+
+  // Only the members that changed are sent in full.
+  breakpoint = CreateSnapshot("snapshot", 2);
+  delta.Encode(&breakpoint);
+  const StackFrame &changed_frame = breakpoint.stack_frames(0);
+  EXPECT_TRUE(IsUnchanged(changed_frame.arguments(0)));
+  const Variable &config = changed_frame.locals(0);
+  EXPECT_EQ(config.name(), "config");
+  EXPECT_EQ(config.type(), "App.Config");
+  ASSERT_EQ(config.members_size(), 2);
+  EXPECT_TRUE(IsUnchanged(config.members(0)));
+  EXPECT_EQ(config.members(1).value(), "2");
+  EXPECT_EQ(changed_frame.locals(1).value(), "2");
+}
+
+// Tests that variables are only compared with the snapshots of the same
+// breakpoint.
+TEST(SnapshotDeltaTest, SeparatesBreakpoints) {
+  SnapshotDelta delta;
+  Breakpoint breakpoint = CreateSnapshot("first", 1);
+  delta.Encode(&breakpoint);
+
+  breakpoint = CreateSnapshot("second", 1);
+  Breakpoint original = breakpoint;
+  delta.Encode(&breakpoint);
+  EXPECT_EQ(breakpoint.SerializeAsString(), original.SerializeAsString());
+}
+
+// Tests that the snapshots of every breakpoint are forgotten once the
+// snapshots of kMaximumDeltaSnapshotBreakpoints breakpoints are kept.
+TEST(SnapshotDeltaTest, ForgetsSnapshotsWhenFull) {
+  SnapshotDelta delta;
+  for (std::size_t i = 0; i < kMaximumDeltaSnapshotBreakpoints; ++i) {
+    Breakpoint breakpoint = CreateSnapshot(std::to_string(i), 1);
+    delta.Encode(&breakpoint);
+  }
+
+  Breakpoint breakpoint = CreateSnapshot("0", 1);
+  delta.Encode(&breakpoint);
+  EXPECT_TRUE(IsUnchanged(breakpoint.stack_frames(0).locals(1)));
+
+  breakpoint = CreateSnapshot("new", 1);
+  delta.Encode(&breakpoint);
+  breakpoint = CreateSnapshot("0", 1);
+  Breakpoint original = breakpoint;
+  delta.Encode(&breakpoint);
+  EXPECT_EQ(breakpoint.SerializeAsString(), original.SerializeAsString());
+}
+
+// Tests that breakpoints without stack frames are not encoded.
+TEST(SnapshotDeltaTest, LogPoint) {
+  SnapshotDelta delta;
+  Breakpoint breakpoint;
+  breakpoint.set_id("log point");
+  breakpoint.set_log_point(true);
+  breakpoint.add_evaluated_expressions()->set_value("1");
+  for (int i = 0; i < 2; ++i) {
+    Breakpoint hit = breakpoint;
+    delta.Encode(&hit);
+    EXPECT_EQ(hit.SerializeAsString(), breakpoint.SerializeAsString());
+  }
+}
+
+}  // namespace google_cloud_debugger_test
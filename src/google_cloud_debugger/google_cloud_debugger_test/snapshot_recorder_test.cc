@@ -0,0 +1,97 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "snapshot_recorder.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google_cloud_debugger::SnapshotRecorder;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Test Fixture for SnapshotRecorder.
+class SnapshotRecorderTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { std::remove(record_file_.c_str()); }
+
+  virtual void TearDown() { std::remove(record_file_.c_str()); }
+
+  // Returns a snapshot of breakpoint id with a local called local.
+  static Breakpoint CreateSnapshot(const string &id, const string &local) {
+    Breakpoint breakpoint;
+    breakpoint.set_id(id);
+    breakpoint.add_stack_frames()->add_locals()->set_name(local);
+    return breakpoint;
+  }
+
+  string record_file_ = "snapshot_recorder_test.record";
+};
+
+// Tests that snapshots are read back in the order they were recorded,
+// including the ones recorded by an earlier recorder, and that
+// breakpoints without stack frames are not recorded.
+TEST_F(SnapshotRecorderTest, RecordsSnapshots) {
+  {
+    SnapshotRecorder recorder;
+    ASSERT_TRUE(recorder.Open(record_file_));
+    EXPECT_TRUE(recorder.Record(CreateSnapshot("first", "a")));
+    Breakpoint log_point;
+    log_point.set_id("log point");
+    EXPECT_TRUE(recorder.Record(log_point));
+  }
+  {
+    SnapshotRecorder recorder;
+    ASSERT_TRUE(recorder.Open(record_file_));
+    EXPECT_TRUE(recorder.Record(CreateSnapshot("second", "b")));
+  }
+
+  std::ifstream input(record_file_, std::ios::in | std::ios::binary);
+  vector<Breakpoint> snapshots;
+  ASSERT_TRUE(SnapshotRecorder::ReadSnapshots(&input, &snapshots));
+  ASSERT_EQ(snapshots.size(), 2u);
+  EXPECT_EQ(snapshots[0].SerializeAsString(),
+            CreateSnapshot("first", "a").SerializeAsString());
+  EXPECT_EQ(snapshots[1].SerializeAsString(),
+            CreateSnapshot("second", "b").SerializeAsString());
+}
+
+// Tests that a truncated record is reported after the snapshots before it.
+TEST_F(SnapshotRecorderTest, TruncatedRecord) {
+  {
+    SnapshotRecorder recorder;
+    ASSERT_TRUE(recorder.Open(record_file_));
+    EXPECT_TRUE(recorder.Record(CreateSnapshot("first", "a")));
+    EXPECT_TRUE(recorder.Record(CreateSnapshot("second", "b")));
+  }
+
+  std::ifstream file(record_file_, std::ios::in | std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  string record = contents.str();
+  std::istringstream input(record.substr(0, record.size() - 1));
+  vector<Breakpoint> snapshots;
+  EXPECT_FALSE(SnapshotRecorder::ReadSnapshots(&input, &snapshots));
+  ASSERT_EQ(snapshots.size(), 1u);
+  EXPECT_EQ(snapshots[0].id(), "first");
+}
+
+}  // namespace google_cloud_debugger_test
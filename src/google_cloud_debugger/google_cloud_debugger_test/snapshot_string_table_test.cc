@@ -0,0 +1,114 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "constants.h"
+#include "snapshot_string_table.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::StackFrame;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::kStringTableExpressionName;
+using google_cloud_debugger::kStringTableReferencePrefix;
+using google_cloud_debugger::SnapshotStringTable;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+const string kItemType = "System.Collections.Generic.KeyValuePair`2";
+
+// Returns a reference to the string at index of the table.
+string Reference(int index) {
+  return string(1, kStringTableReferencePrefix) + std::to_string(index);
+}
+
+// Returns a snapshot with a local that has count items of kItemType.
+Breakpoint CreateSnapshot(int count) {
+  Breakpoint breakpoint;
+  breakpoint.set_id("snapshot");
+  StackFrame *frame = breakpoint.add_stack_frames();
+  frame->set_method_name("Main");
+  frame->mutable_location()->set_path("Program.cs");
+  Variable *local = frame->add_locals();
+  local->set_name("dictionary");
+  for (int i = 0; i < count; ++i) {
+    Variable *item = local->add_members();
+    item->set_name("[" + std::to_string(i) + "]");
+    item->set_type(kItemType);
+    item->set_value(kItemType);
+  }
+  return breakpoint;
+}
+
+// Tests that repeated types are replaced by references to a table
+// appended to the evaluated expressions and that values are kept.
+TEST(SnapshotStringTableTest, RepeatedStrings) {
+  Breakpoint breakpoint = CreateSnapshot(3);
+  Breakpoint original = breakpoint;
+  SnapshotStringTable string_table;
+  string_table.Encode(&breakpoint);
+
+  EXPECT_LT(breakpoint.ByteSizeLong(), original.ByteSizeLong());
+  ASSERT_EQ(breakpoint.evaluated_expressions_size(), 1);
+  const Variable &table = breakpoint.evaluated_expressions(0);
+  EXPECT_EQ(table.name(), kStringTableExpressionName);
+  ASSERT_EQ(table.members_size(), 1);
+  EXPECT_EQ(table.members(0).value(), kItemType);
+
+  const Variable &local = breakpoint.stack_frames(0).locals(0);
+  EXPECT_EQ(local.name(), "dictionary");
+  for (const Variable &item : local.members()) {
+    EXPECT_EQ(item.type(), Reference(0));
+    EXPECT_EQ(item.value(), kItemType);
+  }
+  EXPECT_EQ(local.members(2).name(), "[2]");
+  EXPECT_EQ(breakpoint.stack_frames(0).method_name(), "Main");
+
+  // The table is emptied between snapshots.
+  breakpoint = CreateSnapshot(1);
+  string_table.Encode(&breakpoint);
+  EXPECT_EQ(breakpoint.evaluated_expressions_size(), 0);
+  EXPECT_EQ(breakpoint.stack_frames(0).locals(0).members(0).type(), kItemType);
+}
+
+// Tests that a string that looks like a reference is put in the table so
+// that it is not read back as one.
+TEST(SnapshotStringTableTest, StringLikeReference) {
+  Breakpoint breakpoint = CreateSnapshot(0);
+  string name = Reference(5);
+  breakpoint.mutable_stack_frames(0)->mutable_locals(0)->set_name(name);
+  SnapshotStringTable string_table;
+  string_table.Encode(&breakpoint);
+
+  EXPECT_EQ(breakpoint.stack_frames(0).locals(0).name(), Reference(0));
+  ASSERT_EQ(breakpoint.evaluated_expressions_size(), 1);
+  EXPECT_EQ(breakpoint.evaluated_expressions(0).members(0).value(), name);
+}
+
+// Tests that breakpoints without stack frames are not encoded.
+TEST(SnapshotStringTableTest, LogPoint) {
+  Breakpoint breakpoint;
+  breakpoint.set_log_point(true);
+  for (int i = 0; i < 3; ++i) {
+    breakpoint.add_evaluated_expressions()->set_type(kItemType);
+  }
+  Breakpoint original = breakpoint;
+  SnapshotStringTable string_table;
+  string_table.Encode(&breakpoint);
+  EXPECT_EQ(breakpoint.SerializeAsString(), original.SerializeAsString());
+}
+
+}  // namespace google_cloud_debugger_test
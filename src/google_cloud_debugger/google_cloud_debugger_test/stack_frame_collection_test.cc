@@ -24,25 +24,32 @@
 #include "dbg_breakpoint.h"
 #include "dbg_object_factory.h"
 #include "dbg_primitive.h"
+#include "frame_info_cache.h"
 #include "i_cor_debug_mocks.h"
 #include "i_eval_coordinator_mock.h"
 #include "i_metadata_import_mock.h"
 #include "i_portable_pdb_mocks.h"
 #include "stack_frame_collection.h"
+#include "thread_pool.h"
 
 using google::cloud::diagnostics::debug::Breakpoint;
 using google::cloud::diagnostics::debug::StackFrame;
 using google::cloud::diagnostics::debug::Variable;
 using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::CaptureLimits;
 using google_cloud_debugger::ConvertStringToWCharPtr;
 using google_cloud_debugger::CorDebugHelper;
 using google_cloud_debugger::DbgBreakpoint;
 using google_cloud_debugger::DbgObject;
 using google_cloud_debugger::DbgObjectFactory;
 using google_cloud_debugger::DbgPrimitive;
+using google_cloud_debugger::FrameInfo;
+using google_cloud_debugger::FrameInfoCache;
 using google_cloud_debugger::ICorDebugHelper;
 using google_cloud_debugger::IDbgObjectFactory;
+using google_cloud_debugger::ModuleSnapshot;
 using google_cloud_debugger::StackFrameCollection;
+using google_cloud_debugger::ThreadPool;
 using google_cloud_debugger_portable_pdb::LocalVariableInfo;
 using google_cloud_debugger_portable_pdb::MethodInfo;
 using google_cloud_debugger_portable_pdb::Scope;
@@ -267,6 +274,57 @@ class StackFrameCollectionTest : public ::testing::Test {
     SetUpDebugModule();
   }
 
+  // Sets up the stack walk to return 5 frames. The first 4 are IL frames
+  // with variables and the fifth only has its names resolved.
+  void SetUpFiveFrames() {
+    EXPECT_CALL(debug_stack_walk_, GetFrame(_))
+        .WillOnce(DoAll(SetArgPointee<0>(&first_frame_.frame_), Return(S_OK)))
+        .WillOnce(
+            DoAll(SetArgPointee<0>(&second_frame_.frame_), Return(S_OK)))
+        .WillOnce(DoAll(SetArgPointee<0>(&third_frame_.frame_), Return(S_OK)))
+        .WillOnce(
+            DoAll(SetArgPointee<0>(&fourth_frame_.frame_), Return(S_OK)))
+        .WillOnce(DoAll(SetArgPointee<0>(&fifth_frame_.frame_), Return(S_OK)))
+        .WillOnce(Return(S_FALSE));
+
+    ULONG func_virtual_addr = 1000;
+    mdMethodDef func_token = 2000;
+    string func_name = "MyFunction";
+    mdTypeDef class_token = 3000;
+    string class_name = "MyClass";
+
+    first_frame_.SetUpFrame(&debug_module_, &metadata_import_,
+                            func_virtual_addr, func_token, func_name,
+                            class_token, class_name);
+    first_frame_.SetUpILFrame(true, 500);
+    second_frame_.SetUpFrame(&debug_module_, &metadata_import_,
+                             func_virtual_addr + 1, func_token + 1,
+                             func_name + "1", class_token + 1,
+                             class_name + "1");
+    second_frame_.SetUpILFrame(true, 500);
+    third_frame_.SetUpFrame(&debug_module_, &metadata_import_,
+                            func_virtual_addr + 2, func_token + 2,
+                            func_name + "2", class_token + 2, class_name + "2");
+    third_frame_.SetUpILFrame(true, 500);
+    fourth_frame_.SetUpFrame(&debug_module_, &metadata_import_,
+                             func_virtual_addr + 3, func_token + 3,
+                             func_name + "3", class_token + 3,
+                             class_name + "3");
+    fourth_frame_.SetUpILFrame(true, 500);
+    fifth_frame_.SetUpFrame(&debug_module_, &metadata_import_,
+                            func_virtual_addr + 4, func_token + 4,
+                            func_name + "4", class_token + 4, class_name + "4");
+
+    // For the fifth frame, only sets up such that it gets identified as
+    // an IL frame, don't set up other things as they shouldn't be called.
+    ON_CALL(fifth_frame_.frame_,
+            QueryInterface(__uuidof(ICorDebugILFrame), _))
+        .WillByDefault(
+            DoAll(SetArgPointee<1>(&(fifth_frame_.il_frame_)), Return(S_OK)));
+
+    SetUpDebugModule();
+  }
+
   // Sets up debug_module_ so it will return module_name_
   // when queried.
   virtual void SetUpDebugModule() {
@@ -411,6 +469,28 @@ TEST_F(StackFrameCollectionTest, TestInitializeWithPDBFile) {
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 }
 
+// Tests that the PDB file of a frame is found from the base address of
+// its module when the collection has the snapshot of the loaded modules.
+TEST_F(StackFrameCollectionTest, TestInitializeWithModules) {
+  SetUpStackWalk();
+  SetUpPDBFile();
+  CORDB_ADDRESS module_base_address = 0x1000;
+  EXPECT_CALL(debug_module_, GetBaseAddress(_))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<0>(module_base_address), Return(S_OK)));
+
+  shared_ptr<ModuleSnapshot> modules(new ModuleSnapshot());
+  modules->pdb_files = pdb_files_;
+  modules->pdb_by_base_address[module_base_address] = pdb_files_[0];
+
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  stack_frame_collection.SetModules(modules);
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+}
+
 // Tests the Initialize function of stack frame collection
 // when there is an error.
 TEST_F(StackFrameCollectionTest, TestInitializeError) {
@@ -464,53 +544,41 @@ TEST_F(StackFrameCollectionTest, TestInitializeWithMoreThan20Frames) {
 // Tests that if we have more than 4 IL frames, only the first 4
 // are processed.
 TEST_F(StackFrameCollectionTest, TestInitializeWithFourILFrames) {
-  // Sets up the stack walk to return 3 frames.
-  EXPECT_CALL(debug_stack_walk_, GetFrame(_))
-      .WillOnce(DoAll(SetArgPointee<0>(&first_frame_.frame_), Return(S_OK)))
-      .WillOnce(DoAll(SetArgPointee<0>(&second_frame_.frame_), Return(S_OK)))
-      .WillOnce(DoAll(SetArgPointee<0>(&third_frame_.frame_), Return(S_OK)))
-      .WillOnce(DoAll(SetArgPointee<0>(&fourth_frame_.frame_), Return(S_OK)))
-      .WillOnce(DoAll(SetArgPointee<0>(&fifth_frame_.frame_), Return(S_OK)))
-      .WillOnce(Return(S_FALSE));
-
-  ULONG func_virtual_addr = 1000;
-  mdMethodDef func_token = 2000;
-  string func_name = "MyFunction";
-  mdTypeDef class_token = 3000;
-  string class_name = "MyClass";
-
-  first_frame_.SetUpFrame(&debug_module_, &metadata_import_, func_virtual_addr,
-                          func_token, func_name, class_token, class_name);
-  first_frame_.SetUpILFrame(true, 500);
-  second_frame_.SetUpFrame(&debug_module_, &metadata_import_,
-                           func_virtual_addr + 1, func_token + 1,
-                           func_name + "1", class_token + 1, class_name + "1");
-  second_frame_.SetUpILFrame(true, 500);
-  third_frame_.SetUpFrame(&debug_module_, &metadata_import_,
-                          func_virtual_addr + 2, func_token + 2,
-                          func_name + "2", class_token + 2, class_name + "2");
-  third_frame_.SetUpILFrame(true, 500);
-  fourth_frame_.SetUpFrame(&debug_module_, &metadata_import_,
-                           func_virtual_addr + 3, func_token + 3,
-                           func_name + "3", class_token + 3, class_name + "3");
-  fourth_frame_.SetUpILFrame(true, 500);
-  fifth_frame_.SetUpFrame(&debug_module_, &metadata_import_,
-                          func_virtual_addr + 4, func_token + 4,
-                          func_name + "4", class_token + 4, class_name + "4");
-
-  // For the fifth frame, only sets up such that it gets identified as
-  // an IL frame, don't set up other things as they shouldn't be called.
-  ON_CALL(fifth_frame_.frame_, QueryInterface(__uuidof(ICorDebugILFrame), _))
-      .WillByDefault(
-          DoAll(SetArgPointee<1>(&(fifth_frame_.il_frame_)), Return(S_OK)));
+  SetUpFiveFrames();
 
-  SetUpDebugModule();
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+}
+
+// Tests that frames without variables are resolved on the frame
+// resolution pool.
+TEST_F(StackFrameCollectionTest, TestInitializeWithFrameResolutionPool) {
+  SetUpFiveFrames();
 
+  // The fifth frame is only resolved once, on the pool.
+  EXPECT_CALL(fifth_frame_.frame_, GetFunction(_))
+      .WillOnce(DoAll(SetArgPointee<0>(&fifth_frame_.frame_function_),
+                      Return(S_OK)));
+
+  ThreadPool pool(2);
   StackFrameCollection stack_frame_collection(debug_helper_,
                                               dbg_object_factory_);
+  stack_frame_collection.SetFrameResolutionPool(&pool);
   HRESULT hr = stack_frame_collection.ProcessBreakpoint(
       pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint breakpoint;
+  IEvalCoordinatorMock eval_coordinator;
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, CaptureLimits(),
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(breakpoint.stack_frames_size(), 5);
+  EXPECT_EQ(breakpoint.stack_frames(4).method_name(),
+            fifth_frame_.GetFullMethodName(module_name_));
 }
 
 // Tests the PopulateStackFrames function of stack frame collection.
@@ -525,7 +593,7 @@ TEST_F(StackFrameCollectionTest, TestPopulateStackFrames) {
 
   Breakpoint breakpoint;
   IEvalCoordinatorMock eval_coordinator;
-  hr = stack_frame_collection.PopulateStackFrames(&breakpoint,
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, CaptureLimits(),
                                                   &eval_coordinator);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
@@ -544,7 +612,7 @@ TEST_F(StackFrameCollectionTest, TestPopulateStackFrames) {
   // method of the first document index.
   EXPECT_EQ(
       first_proto_frame.location().line(),
-      first_doc_.methods_[0].sequence_points[0].start_line);
+      first_doc_.methods_[0].sequence_points.begin()->start_line);
 
   // No path or line number set for the second and third frames.
   StackFrame second_proto_frame = breakpoint.stack_frames(1);
@@ -560,6 +628,162 @@ TEST_F(StackFrameCollectionTest, TestPopulateStackFrames) {
   EXPECT_EQ(third_proto_frame.location().line(), 0);
 }
 
+// Tests that the names and source locations of the frames are added to
+// the frame info cache and do not change the captured frames.
+TEST_F(StackFrameCollectionTest, TestPopulateStackFramesWithFrameInfoCache) {
+  FrameInfoCache cache(16);
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  stack_frame_collection.SetFrameInfoCache(&cache);
+  SetUpStackWalk();
+  SetUpPDBFile();
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint breakpoint;
+  IEvalCoordinatorMock eval_coordinator;
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, CaptureLimits(),
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  ASSERT_EQ(breakpoint.stack_frames_size(), 3);
+  EXPECT_EQ(breakpoint.stack_frames(0).method_name(),
+            first_frame_.GetFullMethodName(module_name_));
+  EXPECT_EQ(breakpoint.stack_frames(0).location().path(),
+            first_doc_.file_name_);
+  EXPECT_EQ(breakpoint.stack_frames(0).location().line(),
+            first_doc_.methods_[0].sequence_points.begin()->start_line);
+
+  // The names of every frame are cached.
+  FrameInfo names;
+  EXPECT_TRUE(cache.Find(module_name_, first_frame_.frame_function_token_,
+                         FrameInfoCache::kNoILOffset, &names));
+  EXPECT_EQ(names.method_name, first_frame_.frame_function_name_);
+  EXPECT_TRUE(cache.Find(module_name_, third_frame_.frame_function_token_,
+                         FrameInfoCache::kNoILOffset, &names));
+}
+
+// Tests that PopulateStackFrames only captures as many frames as the
+// limits allow, even if more frames were walked.
+TEST_F(StackFrameCollectionTest, TestPopulateStackFramesWithMaxStackFrames) {
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  SetUpStackWalk();
+  SetUpPDBFile();
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  CaptureLimits limits;
+  limits.max_stack_frames = 2;
+  Breakpoint breakpoint;
+  IEvalCoordinatorMock eval_coordinator;
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, limits,
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(breakpoint.stack_frames_size(), 2);
+  EXPECT_EQ(breakpoint.stack_frames(1).method_name(),
+            second_frame_.GetFullMethodName(module_name_));
+}
+
+// Tests that the stack frames populated for a breakpoint are copied to
+// the breakpoints populated later with the same limits.
+TEST_F(StackFrameCollectionTest, TestPopulateStackFramesTwice) {
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  SetUpStackWalk();
+  SetUpPDBFile();
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint breakpoint;
+  IEvalCoordinatorMock eval_coordinator;
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, CaptureLimits(),
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint second_breakpoint;
+  second_breakpoint.set_id("second");
+  hr = stack_frame_collection.PopulateStackFrames(
+      &second_breakpoint, CaptureLimits(), &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(second_breakpoint.stack_frames_size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(second_breakpoint.stack_frames(i).SerializeAsString(),
+              breakpoint.stack_frames(i).SerializeAsString());
+  }
+
+  // Other limits populate the frames again.
+  CaptureLimits limits;
+  limits.max_stack_frames = 2;
+  Breakpoint third_breakpoint;
+  hr = stack_frame_collection.PopulateStackFrames(&third_breakpoint, limits,
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(third_breakpoint.stack_frames_size(), 2);
+}
+
+// Tests that the stack is not walked if no stack frame is captured.
+TEST_F(StackFrameCollectionTest, TestInitializeWithoutStackFrames) {
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  CaptureLimits limits;
+  limits.max_stack_frames = 0;
+  stack_frame_collection.SetWalkLimits(limits);
+
+  EXPECT_CALL(eval_coordinator_, CreateStackWalk(_)).Times(0);
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint breakpoint;
+  IEvalCoordinatorMock eval_coordinator;
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, limits,
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(breakpoint.stack_frames_size(), 0);
+}
+
+// Tests that only the active frame is read, without walking the stack,
+// if only the top frame is captured.
+TEST_F(StackFrameCollectionTest, TestInitializeWithTopFrameOnly) {
+  StackFrameCollection stack_frame_collection(debug_helper_,
+                                              dbg_object_factory_);
+  CaptureLimits limits;
+  limits.max_stack_frames = 1;
+  stack_frame_collection.SetWalkLimits(limits);
+
+  first_frame_.SetUpFrame(&debug_module_, &metadata_import_, 1000, 2000,
+                          "MyFunction", 3000, "MyClass");
+  first_frame_.SetUpILFrame(true, 500);
+  SetUpDebugModule();
+  SetUpPDBFile();
+
+  ICorDebugThreadMock debug_thread;
+  EXPECT_CALL(eval_coordinator_, GetActiveDebugThread(_))
+      .WillOnce(DoAll(SetArgPointee<0>(&debug_thread), Return(S_OK)));
+  EXPECT_CALL(debug_thread, GetActiveFrame(_))
+      .WillOnce(DoAll(SetArgPointee<0>(&first_frame_.frame_), Return(S_OK)));
+  EXPECT_CALL(eval_coordinator_, CreateStackWalk(_)).Times(0);
+
+  HRESULT hr = stack_frame_collection.ProcessBreakpoint(
+      pdb_files_, &dbg_breakpoint_, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  Breakpoint breakpoint;
+  IEvalCoordinatorMock eval_coordinator;
+  hr = stack_frame_collection.PopulateStackFrames(&breakpoint, limits,
+                                                  &eval_coordinator);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  ASSERT_EQ(breakpoint.stack_frames_size(), 1);
+  EXPECT_EQ(breakpoint.stack_frames(0).method_name(),
+            first_frame_.GetFullMethodName(module_name_));
+  EXPECT_EQ(breakpoint.stack_frames(0).location().path(),
+            first_doc_.file_name_);
+}
+
 // Tests the error case for PopulateStackFrames function of stack frame
 // collection.
 TEST_F(StackFrameCollectionTest, TestPopulateStackFramesError) {
@@ -573,11 +797,11 @@ TEST_F(StackFrameCollectionTest, TestPopulateStackFramesError) {
 
   Breakpoint breakpoint;
   IEvalCoordinatorMock eval_coordinator;
-  EXPECT_EQ(stack_frame_collection.PopulateStackFrames(nullptr,
-                                                       &eval_coordinator),
+  EXPECT_EQ(stack_frame_collection.PopulateStackFrames(
+                nullptr, CaptureLimits(), &eval_coordinator),
             E_INVALIDARG);
-  EXPECT_EQ(stack_frame_collection.PopulateStackFrames(&breakpoint,
-                                                       nullptr),
+  EXPECT_EQ(stack_frame_collection.PopulateStackFrames(
+                &breakpoint, CaptureLimits(), nullptr),
             E_INVALIDARG);
 }
 
@@ -0,0 +1,121 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how fast ConvertWCharPtrToString converts UTF-16 strings of
+// different lengths and contents to UTF-8, compared to the conversion
+// one character at a time that it replaced.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchmark_results.h"
+#include "string_stream_wrapper.h"
+
+using google_cloud_debugger::ConvertWCharPtrToString;
+using google_cloud_debugger_test::BenchmarkResults;
+using std::chrono::steady_clock;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Lengths of the strings that are measured, in UTF-16 code units.
+const vector<size_t> kStringLengths = {8, 32, 256, 4096, 65536};
+
+// Number of UTF-16 code units converted for every string length.
+const size_t kCodeUnitsPerLength = 64 * 1024 * 1024;
+
+// The conversion ConvertWCharPtrToString used before, which copies the
+// string one character at a time.
+string ConvertOneByOne(const WCHAR *wchar_string) {
+  if (!wchar_string || !(*wchar_string)) {
+    return string();
+  }
+
+  std::wstring temp_wstring;
+  while (wchar_string && *wchar_string) {
+    WCHAR current_char = *wchar_string;
+    temp_wstring += static_cast<wchar_t>(current_char);
+    ++wchar_string;
+  }
+
+  return string(temp_wstring.begin(), temp_wstring.end());
+}
+
+// Creates a null-terminated string of length code units. Every
+// non_ascii_every-th code unit is not ASCII, or none if it is 0.
+vector<WCHAR> CreateString(size_t length, size_t non_ascii_every) {
+  vector<WCHAR> wchar_string;
+  for (size_t i = 0; i < length; ++i) {
+    if (non_ascii_every != 0 && i % non_ascii_every == 0) {
+      wchar_string.push_back(static_cast<WCHAR>(0x00E9));
+    } else {
+      wchar_string.push_back(static_cast<WCHAR>('a' + i % 26));
+    }
+  }
+  wchar_string.push_back(0);
+  return wchar_string;
+}
+
+// Returns the millions of code units converted per second by convert.
+template <typename Convert>
+double Measure(const vector<WCHAR> &wchar_string, Convert convert) {
+  size_t iterations = kCodeUnitsPerLength / (wchar_string.size() - 1);
+  size_t total_length = 0;
+  steady_clock::time_point start = steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    total_length += convert(wchar_string.data()).size();
+  }
+  std::chrono::duration<double> elapsed = steady_clock::now() - start;
+
+  // Uses the result so that the conversions are not optimized away.
+  if (total_length == 0) {
+    abort();
+  }
+  return iterations * (wchar_string.size() - 1) / elapsed.count() / 1e6;
+}
+
+// Prints the throughput of both conversions for strings that have a
+// non-ASCII character every non_ascii_every code units and adds the one of
+// ConvertWCharPtrToString to results.
+void MeasureStrings(const char *description, size_t non_ascii_every,
+                    BenchmarkResults *results) {
+  printf("%s (millions of code units per second)\n", description);
+  printf("%10s %12s %12s\n", "length", "one by one", "current");
+  for (size_t length : kStringLengths) {
+    vector<WCHAR> wchar_string = CreateString(length, non_ascii_every);
+    double one_by_one = Measure(wchar_string, ConvertOneByOne);
+    double current = Measure(wchar_string, [](const WCHAR *wchar_string) {
+      return ConvertWCharPtrToString(wchar_string);
+    });
+    printf("%10zu %12.1f %12.1f\n", length, one_by_one, current);
+    results->Add(string(description) + " length " + std::to_string(length) +
+                     " Mcode units/s",
+                 current, false);
+  }
+  printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  BenchmarkResults results("string_conversion_benchmark", 0.25);
+  MeasureStrings("ASCII strings", 0, &results);
+  MeasureStrings("Strings with 1 non-ASCII character in 64", 64, &results);
+  MeasureStrings("Strings with 1 non-ASCII character in 4", 4, &results);
+  return results.Write() ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "string_pool.h"
+
+using google_cloud_debugger_portable_pdb::InternedString;
+using google_cloud_debugger_portable_pdb::StringPool;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Tests that equal strings share a single copy in the pool.
+TEST(StringPoolTest, InternReturnsSameString) {
+  InternedString first = StringPool::Intern("string_pool_test_local");
+  size_t size = StringPool::Size();
+
+  string copy = "string_pool_test_local";
+  InternedString second = StringPool::Intern(copy);
+  EXPECT_TRUE(first == second);
+  EXPECT_EQ(&first.str(), &second.str());
+  EXPECT_EQ(second.str(), "string_pool_test_local");
+  EXPECT_EQ(StringPool::Size(), size);
+
+  InternedString other = StringPool::Intern("string_pool_test_other");
+  EXPECT_TRUE(first != other);
+  EXPECT_EQ(StringPool::Size(), size + 1);
+}
+
+// Tests that a default handle refers to the empty string.
+TEST(StringPoolTest, DefaultIsEmpty) {
+  InternedString empty;
+  EXPECT_TRUE(empty.str().empty());
+  EXPECT_TRUE(empty == StringPool::Intern(""));
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,112 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "string_stream_wrapper.h"
+
+using google_cloud_debugger::ConvertWCharPtrToString;
+using google_cloud_debugger::StringStreamWrapper;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Tests that ASCII strings of every length around the size of the SIMD
+// blocks are converted.
+TEST(ConvertWCharPtrToStringTest, Ascii) {
+  for (size_t length = 0; length < 40; ++length) {
+    string expected;
+    vector<WCHAR> wchar_string;
+    for (size_t i = 0; i < length; ++i) {
+      expected += static_cast<char>('a' + i % 26);
+      wchar_string.push_back(static_cast<WCHAR>('a' + i % 26));
+    }
+    wchar_string.push_back(0);
+
+    EXPECT_EQ(ConvertWCharPtrToString(wchar_string.data()), expected);
+    EXPECT_EQ(ConvertWCharPtrToString(wchar_string), expected);
+  }
+}
+
+// Tests that characters that take 2, 3 and 4 bytes in UTF-8 are
+// converted, also when they come after a block of ASCII characters.
+TEST(ConvertWCharPtrToStringTest, NonAscii) {
+  vector<WCHAR> wchar_string(20, static_cast<WCHAR>('x'));
+  // U+00E9, U+4E2D and U+1F600 (a surrogate pair).
+  for (WCHAR code_unit : {0x00E9, 0x4E2D, 0xD83D, 0xDE00}) {
+    wchar_string.push_back(code_unit);
+  }
+  wchar_string.push_back(static_cast<WCHAR>('y'));
+  wchar_string.push_back(0);
+
+  string expected = string(20, 'x') + "\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80y";
+  EXPECT_EQ(ConvertWCharPtrToString(wchar_string), expected);
+}
+
+// Tests that unpaired surrogates become the replacement character.
+TEST(ConvertWCharPtrToStringTest, UnpairedSurrogates) {
+  vector<WCHAR> wchar_string = {static_cast<WCHAR>('a'), 0xD800,
+                                static_cast<WCHAR>('b'), 0xDC00, 0xD800, 0};
+  EXPECT_EQ(ConvertWCharPtrToString(wchar_string),
+            "a\xEF\xBF\xBD"
+            "b\xEF\xBF\xBD\xEF\xBF\xBD");
+}
+
+// Tests that only the characters before the first null in a vector and
+// the given number of characters are converted.
+TEST(ConvertWCharPtrToStringTest, Length) {
+  vector<WCHAR> wchar_string = {static_cast<WCHAR>('a'),
+                                static_cast<WCHAR>('b'), 0,
+                                static_cast<WCHAR>('c')};
+  EXPECT_EQ(ConvertWCharPtrToString(wchar_string), "ab");
+  EXPECT_EQ(ConvertWCharPtrToString(wchar_string.data(), 1), "a");
+  EXPECT_EQ(ConvertWCharPtrToString(nullptr), "");
+  EXPECT_EQ(ConvertWCharPtrToString(vector<WCHAR>()), "");
+}
+
+// Tests that errors written directly and through the error stream are
+// collected in order.
+TEST(StringStreamWrapperTest, CollectsErrors) {
+  StringStreamWrapper wrapper;
+  EXPECT_EQ(wrapper.GetErrorString(), "");
+
+  wrapper.WriteError("First error.");
+  std::ostream *err_stream = wrapper.GetErrorStream();
+  ASSERT_NE(err_stream, nullptr);
+  EXPECT_EQ(wrapper.GetErrorStream(), err_stream);
+  *err_stream << "Second error " << 2 << ".";
+  wrapper.WriteError("");
+  EXPECT_EQ(wrapper.GetErrorString(), "First error.\nSecond error 2.\n");
+
+  wrapper.ResetErrorStream();
+  EXPECT_EQ(wrapper.GetErrorString(), "");
+  *err_stream << "Third error.";
+  EXPECT_EQ(wrapper.GetErrorString(), "Third error.");
+}
+
+// Tests that moved errors are written to by the stream of their new owner.
+TEST(StringStreamWrapperTest, Move) {
+  StringStreamWrapper wrapper;
+  *wrapper.GetErrorStream() << "Error.";
+
+  StringStreamWrapper moved(std::move(wrapper));
+  EXPECT_EQ(moved.GetErrorString(), "Error.");
+  *moved.GetErrorStream() << " More.";
+  EXPECT_EQ(moved.GetErrorString(), "Error. More.");
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,126 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "ccomptr.h"
+#include "cor_debug_helper.h"
+#include "i_cor_debug_mocks.h"
+#include "strong_handle_pool.h"
+
+using google_cloud_debugger::CComPtr;
+using google_cloud_debugger::CorDebugHelper;
+using google_cloud_debugger::StrongHandlePool;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace google_cloud_debugger_test {
+
+// Tests that a handle is found by the address of its object until the
+// addresses are forgotten.
+TEST(StrongHandlePoolTest, FindsHandleByAddress) {
+  StrongHandlePool pool;
+  ICorDebugHandleValueMock handle_value;
+  CComPtr<ICorDebugHandleValue> found;
+  EXPECT_FALSE(pool.Find(100, &found));
+
+  pool.Add(100, &handle_value);
+  ASSERT_TRUE(pool.Find(100, &found));
+  EXPECT_EQ(static_cast<ICorDebugHandleValue *>(found), &handle_value);
+  EXPECT_FALSE(pool.Find(200, &found));
+
+  pool.ForgetAddresses();
+  EXPECT_FALSE(pool.Find(100, &found));
+  EXPECT_EQ(pool.GetHandleCount(), 1u);
+
+  EXPECT_CALL(handle_value, Dispose()).Times(1);
+  pool.DisposeAll();
+}
+
+// Tests that a handle added without an address is disposed but never
+// found.
+TEST(StrongHandlePoolTest, AddsHandleWithoutAddress) {
+  StrongHandlePool pool;
+  ICorDebugHandleValueMock handle_value;
+  pool.Add(0, &handle_value);
+
+  CComPtr<ICorDebugHandleValue> found;
+  EXPECT_FALSE(pool.Find(0, &found));
+  EXPECT_EQ(pool.GetHandleCount(), 1u);
+
+  EXPECT_CALL(handle_value, Dispose()).Times(1);
+  pool.DisposeAll();
+  EXPECT_EQ(pool.GetHandleCount(), 0u);
+}
+
+// Tests that DisposeAll disposes every handle once.
+TEST(StrongHandlePoolTest, DisposesAllHandles) {
+  StrongHandlePool pool;
+  ICorDebugHandleValueMock first_handle;
+  ICorDebugHandleValueMock second_handle;
+  pool.Add(100, &first_handle);
+  pool.Add(200, &second_handle);
+
+  EXPECT_CALL(first_handle, Dispose()).Times(1);
+  EXPECT_CALL(second_handle, Dispose()).Times(1);
+  pool.DisposeAll();
+
+  // Nothing is left to dispose.
+  pool.DisposeAll();
+  CComPtr<ICorDebugHandleValue> found;
+  EXPECT_FALSE(pool.Find(100, &found));
+}
+
+// Tests that CorDebugHelper creates the handle of an object once while
+// a pool is current, and every time otherwise.
+TEST(StrongHandlePoolTest, SharesHandlesOfCurrentPool) {
+  ICorDebugStringValueMock string_value;
+  ICorDebugHeapValue2Mock heap_value;
+  ICorDebugHandleValueMock handle_value;
+  CorDebugHelper helper;
+
+  ON_CALL(string_value, QueryInterface(__uuidof(ICorDebugHeapValue2), _))
+      .WillByDefault(DoAll(SetArgPointee<1>(&heap_value), Return(S_OK)));
+  ON_CALL(string_value, GetAddress(_))
+      .WillByDefault(DoAll(SetArgPointee<0>(100), Return(S_OK)));
+  ON_CALL(heap_value, CreateHandle(_, _))
+      .WillByDefault(DoAll(SetArgPointee<1>(&handle_value), Return(S_OK)));
+
+  StrongHandlePool pool;
+  StrongHandlePool::SetCurrent(&pool);
+  EXPECT_CALL(heap_value, CreateHandle(_, _)).Times(1);
+  for (int i = 0; i < 3; ++i) {
+    CComPtr<ICorDebugHandleValue> handle;
+    EXPECT_EQ(helper.CreateStrongHandle(&string_value, &handle, &std::cerr),
+              S_OK);
+    EXPECT_EQ(static_cast<ICorDebugHandleValue *>(handle), &handle_value);
+  }
+
+  EXPECT_CALL(handle_value, Dispose()).Times(1);
+  pool.DisposeAll();
+  StrongHandlePool::SetCurrent(nullptr);
+
+  EXPECT_CALL(heap_value, CreateHandle(_, _)).Times(2);
+  for (int i = 0; i < 2; ++i) {
+    CComPtr<ICorDebugHandleValue> handle;
+    EXPECT_EQ(helper.CreateStrongHandle(&string_value, &handle, &std::cerr),
+              S_OK);
+  }
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,260 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef PLATFORM_UNIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "pe_debug_directory.h"
+#include "symbol_store_pdb_provider.h"
+
+using google_cloud_debugger_portable_pdb::CodeViewPdbInfo;
+using google_cloud_debugger_portable_pdb::SymbolStorePdbProvider;
+using std::string;
+using std::vector;
+
+namespace google_cloud_debugger_test {
+
+// Returns the CodeView information of a PDB at path whose GUID bytes are
+// 0, 1, ..., 15.
+static CodeViewPdbInfo MakePdbInfo(const string &path) {
+  CodeViewPdbInfo pdb_info;
+  for (size_t i = 0; i < pdb_info.guid.size(); ++i) {
+    pdb_info.guid[i] = static_cast<uint8_t>(i);
+  }
+  pdb_info.age = 1;
+  pdb_info.path = path;
+  return pdb_info;
+}
+
+// Writes content to file.
+static void WriteFile(const string &file, const string &content) {
+  std::ofstream stream(file, std::ios::out | std::ios::binary);
+  stream << content;
+}
+
+// Returns the content of file.
+static string ReadFile(const string &file) {
+  std::ifstream stream(file, std::ios::in | std::ios::binary);
+  return string(std::istreambuf_iterator<char>(stream),
+                std::istreambuf_iterator<char>());
+}
+
+// Tests the SSQP keys of PDBs: the first three groups of the GUID are
+// little-endian, and the name is the lower-case file name of the path.
+TEST(SymbolStorePdbProviderTest, GetKey) {
+  EXPECT_EQ(SymbolStorePdbProvider::GetKey(MakePdbInfo("C:\\src\\App.pdb")),
+            "app.pdb/030201000504070608090a0b0c0d0e0fffffffff/app.pdb");
+  EXPECT_EQ(SymbolStorePdbProvider::GetKey(MakePdbInfo("/src/obj/Lib.PDB")),
+            "lib.pdb/030201000504070608090a0b0c0d0e0fffffffff/lib.pdb");
+  EXPECT_EQ(SymbolStorePdbProvider::GetKey(MakePdbInfo("a.pdb")),
+            "a.pdb/030201000504070608090a0b0c0d0e0fffffffff/a.pdb");
+  EXPECT_EQ(SymbolStorePdbProvider::GetKey(MakePdbInfo("")), "");
+  EXPECT_EQ(SymbolStorePdbProvider::GetKey(MakePdbInfo("/src/")), "");
+}
+
+TEST(SymbolStorePdbProviderTest, ParseHttpUrl) {
+  string host;
+  string port;
+  string path;
+  EXPECT_TRUE(SymbolStorePdbProvider::ParseHttpUrl(
+      "http://symbols.example.com/download/symbols", &host, &port, &path));
+  EXPECT_EQ(host, "symbols.example.com");
+  EXPECT_EQ(port, "80");
+  EXPECT_EQ(path, "/download/symbols");
+
+  EXPECT_TRUE(SymbolStorePdbProvider::ParseHttpUrl("http://localhost:8080",
+                                                   &host, &port, &path));
+  EXPECT_EQ(host, "localhost");
+  EXPECT_EQ(port, "8080");
+  EXPECT_EQ(path, "/");
+
+  EXPECT_TRUE(SymbolStorePdbProvider::ParseHttpUrl("http://[::1]:81/a", &host,
+                                                   &port, &path));
+  EXPECT_EQ(host, "::1");
+  EXPECT_EQ(port, "81");
+  EXPECT_EQ(path, "/a");
+
+  EXPECT_FALSE(SymbolStorePdbProvider::ParseHttpUrl(
+      "https://symbols.example.com/", &host, &port, &path));
+  EXPECT_FALSE(
+      SymbolStorePdbProvider::ParseHttpUrl("http:///a", &host, &port, &path));
+  EXPECT_FALSE(SymbolStorePdbProvider::ParseHttpUrl("symbols", &host, &port,
+                                                    &path));
+}
+
+#ifdef PLATFORM_UNIX
+// Tests that PDBs are found in the symbol store directory, keyed either
+// the SSQP way or the symstore way.
+TEST(SymbolStorePdbProviderTest, FindPdb) {
+  char directory_template[] = "/tmp/symbol_store_test_XXXXXX";
+  ASSERT_TRUE(mkdtemp(directory_template) != nullptr);
+  string directory = directory_template;
+  SymbolStorePdbProvider provider(directory, "");
+
+  CodeViewPdbInfo app_info = MakePdbInfo("C:\\src\\App.pdb");
+  string pdb_path;
+  EXPECT_FALSE(provider.FindPdb(app_info, &pdb_path));
+  EXPECT_FALSE(provider.FetchPdb(app_info));
+
+  string guid_directory = directory + "/app.pdb";
+  string file = guid_directory +
+                "/030201000504070608090a0b0c0d0e0fffffffff/app.pdb";
+  ASSERT_EQ(mkdir(guid_directory.c_str(), 0755), 0);
+  ASSERT_EQ(mkdir(file.substr(0, file.rfind('/')).c_str(), 0755), 0);
+  WriteFile(file, "pdb");
+  EXPECT_TRUE(provider.FindPdb(app_info, &pdb_path));
+  EXPECT_EQ(pdb_path, file);
+  EXPECT_TRUE(provider.FetchPdb(app_info));
+
+  CodeViewPdbInfo lib_info = MakePdbInfo("/src/Lib.pdb");
+  string symstore_file = directory + "/Lib.pdb";
+  ASSERT_EQ(mkdir(symstore_file.c_str(), 0755), 0);
+  symstore_file += "/030201000504070608090A0B0C0D0E0FFFFFFFFF";
+  ASSERT_EQ(mkdir(symstore_file.c_str(), 0755), 0);
+  symstore_file += "/Lib.pdb";
+  WriteFile(symstore_file, "pdb");
+  EXPECT_TRUE(provider.FindPdb(lib_info, &pdb_path));
+  EXPECT_EQ(pdb_path, symstore_file);
+
+  std::remove(symstore_file.c_str());
+  std::remove(file.c_str());
+  EXPECT_EQ(system(("rm -rf " + directory).c_str()), 0);
+}
+
+// Serves responses, one per connection, on a local port.
+class TestSymbolServer {
+ public:
+  explicit TestSymbolServer(const vector<string> &responses) {
+    listener_ = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    EXPECT_EQ(bind(listener_, reinterpret_cast<struct sockaddr *>(&address),
+                   sizeof(address)),
+              0);
+    EXPECT_EQ(listen(listener_, 4), 0);
+    socklen_t address_size = sizeof(address);
+    getsockname(listener_, reinterpret_cast<struct sockaddr *>(&address),
+                &address_size);
+    port_ = ntohs(address.sin_port);
+
+    thread_ = std::thread([this, responses]() {
+      for (const string &response : responses) {
+        int connection = accept(listener_, nullptr, nullptr);
+        if (connection < 0) {
+          return;
+        }
+
+        // Reads the request until the blank line that ends it.
+        string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == string::npos) {
+          ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+          if (received <= 0) {
+            break;
+          }
+          request.append(buffer, received);
+        }
+        requests_.push_back(request.substr(0, request.find("\r\n")));
+        send(connection, response.data(), response.size(), 0);
+        close(connection);
+      }
+    });
+  }
+
+  ~TestSymbolServer() {
+    Join();
+    close(listener_);
+  }
+
+  // Returns the URL of the server.
+  string GetUrl() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+  // Returns the request lines received. The server has to be done.
+  const vector<string> &GetRequests() const { return requests_; }
+
+  // Waits until every response is sent.
+  void Join() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+ private:
+  int listener_;
+  int port_ = 0;
+  std::thread thread_;
+  vector<string> requests_;
+};
+
+// Tests that FetchPdb downloads PDBs into the symbol store directory,
+// following redirects, and does not retry the ones that failed.
+TEST(SymbolStorePdbProviderTest, FetchPdb) {
+  char directory_template[] = "/tmp/symbol_store_test_XXXXXX";
+  ASSERT_TRUE(mkdtemp(directory_template) != nullptr);
+  string directory = directory_template;
+
+  CodeViewPdbInfo app_info = MakePdbInfo("C:\\src\\App.pdb");
+  CodeViewPdbInfo lib_info = MakePdbInfo("C:\\src\\Lib.pdb");
+  string app_key = SymbolStorePdbProvider::GetKey(app_info);
+  TestSymbolServer server(
+      {"HTTP/1.1 302 Found\r\nLocation: /mirror/" + app_key + "\r\n\r\n",
+       "HTTP/1.1 200 OK\r\nContent-Length: 8\r\n\r\nBSJB pdb",
+       "HTTP/1.1 404 Not Found\r\n\r\n"});
+  SymbolStorePdbProvider provider(directory, server.GetUrl() + "/symbols/");
+
+  EXPECT_TRUE(provider.FetchPdb(app_info));
+  string pdb_path;
+  EXPECT_TRUE(provider.FindPdb(app_info, &pdb_path));
+  EXPECT_EQ(pdb_path, directory + "/" + app_key);
+  EXPECT_EQ(ReadFile(pdb_path), "BSJB pdb");
+
+  // The PDB is in the directory now.
+  EXPECT_TRUE(provider.FetchPdb(app_info));
+
+  EXPECT_FALSE(provider.FetchPdb(lib_info));
+  EXPECT_FALSE(provider.FindPdb(lib_info, &pdb_path));
+  server.Join();
+  EXPECT_FALSE(provider.FetchPdb(lib_info));
+
+  ASSERT_EQ(server.GetRequests().size(), 3u);
+  EXPECT_EQ(server.GetRequests()[0],
+            "GET /symbols/" + app_key + " HTTP/1.0");
+  EXPECT_EQ(server.GetRequests()[1], "GET /mirror/" + app_key + " HTTP/1.0");
+  EXPECT_EQ(server.GetRequests()[2],
+            "GET /symbols/" + SymbolStorePdbProvider::GetKey(lib_info) +
+                " HTTP/1.0");
+  EXPECT_EQ(system(("rm -rf " + directory).c_str()), 0);
+}
+#endif
+
+}  // namespace google_cloud_debugger_test
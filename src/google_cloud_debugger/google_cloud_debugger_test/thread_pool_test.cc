@@ -0,0 +1,151 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "thread_pool.h"
+
+using google_cloud_debugger::ThreadPool;
+
+namespace google_cloud_debugger_test {
+
+// Tests that every scheduled task runs.
+TEST(ThreadPoolTest, RunsAllTasks) {
+  const int kTasks = 50;
+  std::atomic<int> count(0);
+  std::promise<void> all_done;
+
+  ThreadPool pool(4);
+  for (int i = 0; i < kTasks; ++i) {
+    EXPECT_TRUE(pool.Schedule([&count, &all_done, kTasks]() {
+      if (++count == kTasks) {
+        all_done.set_value();
+      }
+    }));
+  }
+
+  all_done.get_future().wait();
+  EXPECT_EQ(count, kTasks);
+}
+
+// Tests that a pool with 0 threads still runs tasks.
+TEST(ThreadPoolTest, ZeroThreads) {
+  std::promise<int> result;
+  ThreadPool pool(0);
+  EXPECT_TRUE(pool.Schedule([&result]() { result.set_value(42); }));
+  EXPECT_EQ(result.get_future().get(), 42);
+}
+
+// Tests that destroying the pool waits for the running task.
+TEST(ThreadPoolTest, DestructorWaitsForRunningTask) {
+  std::promise<void> started;
+  std::atomic<bool> finished(false);
+
+  std::unique_ptr<ThreadPool> pool(new ThreadPool(1));
+  EXPECT_TRUE(pool->Schedule([&]() {
+    started.set_value();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    finished = true;
+  }));
+
+  started.get_future().wait();
+  pool.reset();
+  EXPECT_TRUE(finished);
+}
+
+// Tests that ScheduleWithoutWaiting starts a thread when every thread is
+// busy and reuses the threads once they are idle.
+TEST(ThreadPoolTest, ScheduleWithoutWaiting) {
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> second_done;
+
+  ThreadPool pool(1);
+  EXPECT_TRUE(pool.ScheduleWithoutWaiting([released]() { released.wait(); }));
+  EXPECT_EQ(pool.GetThreadsCreated(), 1);
+
+  // The only thread is blocked, so the second task needs another one.
+  EXPECT_TRUE(pool.ScheduleWithoutWaiting(
+      [&second_done]() { second_done.set_value(); }));
+  second_done.get_future().wait();
+  EXPECT_EQ(pool.GetThreadsCreated(), 2);
+
+  release.set_value();
+  // Waits until both threads are idle again.
+  std::promise<void> third_done;
+  std::promise<void> fourth_done;
+  EXPECT_TRUE(pool.Schedule([&third_done]() { third_done.set_value(); }));
+  EXPECT_TRUE(pool.Schedule([&fourth_done]() { fourth_done.set_value(); }));
+  third_done.get_future().wait();
+  fourth_done.get_future().wait();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  std::promise<void> fifth_done;
+  EXPECT_TRUE(
+      pool.ScheduleWithoutWaiting([&fifth_done]() { fifth_done.set_value(); }));
+  fifth_done.get_future().wait();
+  EXPECT_EQ(pool.GetThreadsCreated(), 2);
+}
+
+// Tests that Schedule queues tasks instead of starting threads.
+TEST(ThreadPoolTest, ScheduleDoesNotStartThreads) {
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> second_done;
+
+  ThreadPool pool(1);
+  EXPECT_TRUE(pool.Schedule([released]() { released.wait(); }));
+  EXPECT_TRUE(pool.Schedule([&second_done]() { second_done.set_value(); }));
+  EXPECT_EQ(pool.GetThreadsCreated(), 1);
+
+  release.set_value();
+  second_done.get_future().wait();
+  EXPECT_EQ(pool.GetThreadsCreated(), 1);
+}
+
+// Tests that the threads ScheduleWithoutWaiting adds exit after the idle
+// timeout and that the pool keeps its fixed threads.
+TEST(ThreadPoolTest, IdleThreadsExit) {
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> second_done;
+
+  ThreadPool pool(1, "thread_pool", std::chrono::milliseconds(10));
+  EXPECT_TRUE(pool.ScheduleWithoutWaiting([released]() { released.wait(); }));
+  EXPECT_TRUE(pool.ScheduleWithoutWaiting(
+      [&second_done]() { second_done.set_value(); }));
+  second_done.get_future().wait();
+  EXPECT_EQ(pool.GetThreadCount(), 2);
+
+  release.set_value();
+  for (int i = 0; i < 500 && pool.GetThreadCount() > 1; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(pool.GetThreadCount(), 1);
+  EXPECT_EQ(pool.GetThreadsCreated(), 2);
+
+  // The remaining thread still runs tasks.
+  std::promise<void> third_done;
+  EXPECT_TRUE(
+      pool.ScheduleWithoutWaiting([&third_done]() { third_done.set_value(); }));
+  third_done.get_future().wait();
+  EXPECT_GE(pool.GetThreadCount(), 1);
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,85 @@
+// Copyright 2017 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "constants.h"
+#include "thread_scheduling.h"
+
+using google_cloud_debugger::kMaxBackgroundThreadPriority;
+using google_cloud_debugger::ThreadScheduling;
+
+namespace google_cloud_debugger_test {
+
+#ifdef __linux__
+// Returns the nice value of the calling thread.
+static int GetThreadNiceValue() {
+  return getpriority(PRIO_PROCESS, static_cast<pid_t>(syscall(SYS_gettid)));
+}
+
+// Tests that a background thread is pinned to the background cores and
+// has its nice value raised, while other threads are left alone.
+TEST(ThreadSchedulingTest, AppliesToBackgroundThread) {
+  ThreadScheduling scheduling;
+  scheduling.SetBackgroundCores({0});
+  scheduling.SetBackgroundPriority(3);
+
+  int normal_nice_value = GetThreadNiceValue();
+  int nice_value = 0;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  std::thread background([&]() {
+    scheduling.ApplyToBackgroundThread();
+    nice_value = GetThreadNiceValue();
+    pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  });
+  background.join();
+
+  EXPECT_EQ(nice_value,
+            std::min<int>(normal_nice_value + 3, kMaxBackgroundThreadPriority));
+  EXPECT_EQ(CPU_COUNT(&cpu_set), 1);
+  EXPECT_TRUE(CPU_ISSET(0, &cpu_set));
+  EXPECT_EQ(GetThreadNiceValue(), normal_nice_value);
+}
+#endif
+
+// Tests that background threads are left alone by default.
+TEST(ThreadSchedulingTest, DefaultsToNormalScheduling) {
+  ThreadScheduling scheduling;
+#ifdef __linux__
+  int normal_nice_value = GetThreadNiceValue();
+  int nice_value = 0;
+  std::thread background([&]() {
+    scheduling.ApplyToBackgroundThread();
+    nice_value = GetThreadNiceValue();
+  });
+  background.join();
+  EXPECT_EQ(nice_value, normal_nice_value);
+#else
+  std::thread background([&]() { scheduling.ApplyToBackgroundThread(); });
+  background.join();
+#endif
+}
+
+}  // namespace google_cloud_debugger_test
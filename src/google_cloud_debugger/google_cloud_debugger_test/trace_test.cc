@@ -0,0 +1,127 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "constants.h"
+#include "trace.h"
+
+using google_cloud_debugger::TraceLog;
+using google_cloud_debugger::TraceSpan;
+using google_cloud_debugger::kTraceEventsPerThread;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+namespace {
+
+// Returns how many times value appears in text.
+size_t CountOccurrences(const string &text, const string &value) {
+  size_t count = 0;
+  for (size_t position = text.find(value); position != string::npos;
+       position = text.find(value, position + value.size())) {
+    ++count;
+  }
+  return count;
+}
+
+string WriteTrace() {
+  std::ostringstream out;
+  TraceLog::WriteChromeTrace(&out);
+  return out.str();
+}
+
+}  // namespace
+
+// Tests that a span is written as a complete event with its duration.
+TEST(TraceTest, RecordSpan) {
+  TraceLog::Clear();
+  TraceLog::Clock::time_point start = TraceLog::Clock::now();
+  TraceLog::Record("RecordSpan", start,
+                   start + std::chrono::microseconds(42));
+
+  string trace = WriteTrace();
+  EXPECT_EQ(0, trace.find("{\"traceEvents\":["));
+  EXPECT_NE(string::npos, trace.find("{\"name\":\"RecordSpan\",\"cat\":"
+                                     "\"debugger\",\"ph\":\"X\""));
+  EXPECT_NE(string::npos, trace.find("\"dur\":42}"));
+}
+
+// Tests that TraceSpan records a span when it goes out of scope.
+TEST(TraceTest, ScopedSpan) {
+  TraceLog::Clear();
+  {
+    TraceSpan span("ScopedSpan");
+    EXPECT_EQ(string::npos, WriteTrace().find("ScopedSpan"));
+  }
+  EXPECT_EQ(1, CountOccurrences(WriteTrace(), "\"ScopedSpan\""));
+}
+
+// Tests that DEBUGGER_TRACE_SPAN is compiled out unless tracing is enabled.
+TEST(TraceTest, TraceSpanMacro) {
+  TraceLog::Clear();
+  { DEBUGGER_TRACE_SPAN("MacroSpan"); }
+#ifdef GOOGLE_CLOUD_DEBUGGER_TRACING
+  EXPECT_EQ(1, CountOccurrences(WriteTrace(), "\"MacroSpan\""));
+#else
+  EXPECT_EQ(0, CountOccurrences(WriteTrace(), "\"MacroSpan\""));
+#endif
+}
+
+// Tests that a thread only keeps its last kTraceEventsPerThread spans.
+TEST(TraceTest, RingBuffer) {
+  TraceLog::Clear();
+  TraceLog::Clock::time_point now = TraceLog::Clock::now();
+  TraceLog::Record("OldestSpan", now, now);
+  for (size_t i = 0; i < kTraceEventsPerThread; ++i) {
+    TraceLog::Record("NewerSpan", now, now);
+  }
+
+  string trace = WriteTrace();
+  EXPECT_EQ(0, CountOccurrences(trace, "\"OldestSpan\""));
+  EXPECT_EQ(kTraceEventsPerThread, CountOccurrences(trace, "\"NewerSpan\""));
+}
+
+// Tests that spans of other threads are written with their own thread
+// and kept after the threads exit.
+TEST(TraceTest, MultipleThreads) {
+  TraceLog::Clear();
+  std::thread first([]() { TraceSpan span("FirstThread"); });
+  first.join();
+  std::thread second([]() { TraceSpan span("SecondThread"); });
+  second.join();
+
+  string trace = WriteTrace();
+  size_t first_position = trace.find("\"FirstThread\"");
+  size_t second_position = trace.find("\"SecondThread\"");
+  ASSERT_NE(string::npos, first_position);
+  ASSERT_NE(string::npos, second_position);
+
+  size_t first_tid = trace.find("\"tid\":", first_position);
+  size_t second_tid = trace.find("\"tid\":", second_position);
+  EXPECT_NE(trace.substr(first_tid, trace.find(',', first_tid) - first_tid),
+            trace.substr(second_tid, trace.find(',', second_tid) - second_tid));
+}
+
+// Tests that the trace is valid without any span.
+TEST(TraceTest, EmptyTrace) {
+  TraceLog::Clear();
+  EXPECT_EQ("{\"traceEvents\":[\n]}\n", WriteTrace());
+}
+
+}  // namespace google_cloud_debugger_test
@@ -0,0 +1,84 @@
+// Copyright 2018 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "variable_encoder.h"
+
+using google::cloud::diagnostics::debug::Breakpoint;
+using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::VariableEncoder;
+using std::string;
+
+namespace google_cloud_debugger_test {
+
+// Encodes variable as the evaluated expression of a breakpoint and
+// parses it back into parsed. Returns the size of the encoded breakpoint.
+static size_t EncodeAndParse(const Variable &variable, Breakpoint *parsed) {
+  string buffer;
+  VariableEncoder encoder(&buffer);
+  encoder.AppendVariable(Breakpoint::kEvaluatedExpressionsFieldNumber,
+                         variable);
+  EXPECT_EQ(encoder.GetSize(), buffer.size());
+  EXPECT_TRUE(parsed->ParseFromString(buffer));
+  return buffer.size();
+}
+
+// Tests that variables with members and statuses are encoded as protobuf
+// would, except that the length of every variable takes
+// VariableEncoder::kLengthSize bytes.
+TEST(VariableEncoderTest, EncodesVariables) {
+  Variable variable;
+  variable.set_name("items");
+  variable.set_type("System.Collections.Generic.List");
+  Variable *count = variable.add_members();
+  count->set_name("Count");
+  count->set_value("2");
+  Variable *item = variable.add_members();
+  item->set_name("[0]");
+  item->mutable_status()->set_iserror(true);
+  item->mutable_status()->set_message("Object is null.");
+  Variable *empty = variable.add_members();
+  empty->mutable_status()->set_message("Empty.");
+  variable.add_members();
+
+  Breakpoint expected;
+  *expected.add_evaluated_expressions() = variable;
+  Breakpoint parsed;
+  size_t size = EncodeAndParse(variable, &parsed);
+  EXPECT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+
+  // Five variables whose lengths take 1 byte when they are not padded.
+  EXPECT_EQ(size,
+            expected.ByteSizeLong() + 5 * (VariableEncoder::kLengthSize - 1));
+}
+
+// Tests that a variable too long for kLengthSize bytes of length is
+// encoded with a longer length.
+TEST(VariableEncoderTest, EncodesLongVariables) {
+  Variable variable;
+  variable.set_name("text");
+  variable.set_value(string(3 * 1024 * 1024, 'a'));
+  Variable *member = variable.add_members();
+  member->set_name("Length");
+
+  Breakpoint expected;
+  *expected.add_evaluated_expressions() = variable;
+  Breakpoint parsed;
+  EncodeAndParse(variable, &parsed);
+  EXPECT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+}
+
+}  // namespace google_cloud_debugger_test
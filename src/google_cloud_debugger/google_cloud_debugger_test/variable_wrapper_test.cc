@@ -16,7 +16,6 @@
 #include <gtest/gtest.h>
 #include <cstdint>
 #include <cstdlib>
-#include <queue>
 #include <vector>
 
 #include "breakpoint.pb.h"
@@ -24,19 +23,25 @@
 #include "cor.h"
 #include "cordebug.h"
 #include "dbg_object.h"
+#include "error_messages.h"
 #include "i_cor_debug_helper.h"
+#include "i_cor_debug_mocks.h"
 #include "i_dbg_object_factory.h"
 #include "i_eval_coordinator_mock.h"
 #include "variable_wrapper.h"
 #include "winerror.h"
 
 using google::cloud::diagnostics::debug::Variable;
+using google_cloud_debugger::CaptureLimits;
+using google_cloud_debugger::CaptureMask;
 using google_cloud_debugger::DbgObject;
 using google_cloud_debugger::ICorDebugHelper;
 using google_cloud_debugger::IDbgObjectFactory;
 using google_cloud_debugger::IEvalCoordinator;
+using google_cloud_debugger::kCaptureDeadlineExceeded;
+using google_cloud_debugger::SnapshotSizeTracker;
+using google_cloud_debugger::VariableQueue;
 using google_cloud_debugger::VariableWrapper;
-using std::queue;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -88,6 +93,7 @@ class FakeDbgObjectValue : public FakeDbgObjectBase {
 
   virtual HRESULT PopulateMembers(Variable *variable_proto,
                                   std::vector<VariableWrapper> *members,
+                                  const CaptureLimits &limits,
                                   IEvalCoordinator *eval_coordinator) override {
     return S_FALSE;
   }
@@ -113,11 +119,16 @@ class FakeDbgObjectMembers : public FakeDbgObjectBase {
 
   virtual HRESULT PopulateMembers(Variable *variable_proto,
                                   std::vector<VariableWrapper> *members,
+                                  const CaptureLimits &limits,
                                   IEvalCoordinator *eval_coordinator) override {
     members->insert(members->begin(), members_.begin(), members_.end());
     return S_OK;
   }
 
+  ICorDebugHandleValue *GetObjectHandle() const override {
+    return object_handle_;
+  }
+
   // Creates a variable wrapper. The proto of the wrapper
   // will be variable_proto_ field of the object.
   static VariableWrapper GetVariableWrapper() {
@@ -128,6 +139,9 @@ class FakeDbgObjectMembers : public FakeDbgObjectBase {
 
   // Members of the object.
   vector<VariableWrapper> members_;
+
+  // Handle that identifies the object, if any.
+  ICorDebugHandleValue *object_handle_ = nullptr;
 };
 
 // Test Fixture for DbgClass.
@@ -164,6 +178,16 @@ void CheckType(VariableWrapper *wrapper) {
   EXPECT_EQ(wrapper->GetVariableProto()->type(), fake_dbg_object->type_);
 }
 
+// Helper function to give the FakeDbgObjectMembers in wrapper the
+// handle that identifies its object and names its variable.
+void SetObject(VariableWrapper *wrapper, ICorDebugHandleValue *handle,
+               const string &name) {
+  FakeDbgObjectMembers *fake_members_ =
+      (FakeDbgObjectMembers *)wrapper->GetVariableValue().get();
+  fake_members_->object_handle_ = handle;
+  wrapper->GetVariableProto()->set_name(name);
+}
+
 // Helper function to add variable wrapper item to the FakeDbgObjectMembers
 // in wrapper container.
 void AddMembers(VariableWrapper *container, const VariableWrapper &item) {
@@ -214,7 +238,8 @@ TEST_F(VariableWrapperTest, TestPopulateMembers) {
   AddMembers(&members_wrapper_, value_wrapper_2_);
 
   vector<VariableWrapper> members;
-  HRESULT hr = members_wrapper_.PopulateMembers(&members, &eval_coordinator_);
+  HRESULT hr = members_wrapper_.PopulateMembers(&members, CaptureLimits(),
+                                                &eval_coordinator_);
 
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
   EXPECT_EQ(members.size(), 2);
@@ -226,17 +251,21 @@ TEST_F(VariableWrapperTest, TestPopulateMembers) {
 TEST_F(VariableWrapperTest, TestPopulateMembersError) {
   vector<VariableWrapper> members;
 
-  EXPECT_EQ(members_wrapper_.PopulateMembers(nullptr, &eval_coordinator_),
+  EXPECT_EQ(members_wrapper_.PopulateMembers(nullptr, CaptureLimits(),
+                                             &eval_coordinator_),
             E_INVALIDARG);
-  EXPECT_EQ(members_wrapper_.PopulateMembers(&members, nullptr), E_INVALIDARG);
+  EXPECT_EQ(
+      members_wrapper_.PopulateMembers(&members, CaptureLimits(), nullptr),
+      E_INVALIDARG);
 }
 
 // Tests PerformBFS method when there is only 1 item.
 TEST_F(VariableWrapperTest, TestBFSOneItem) {
-  queue<VariableWrapper> bfs_queue;
+  VariableQueue bfs_queue;
   bfs_queue.push(value_wrapper_);
-  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, []() { return false; },
-                                           &eval_coordinator_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // BFS should fill up the proto with both value and type.
@@ -249,10 +278,11 @@ TEST_F(VariableWrapperTest, TestBFSTwoChildren) {
   AddMembers(&members_wrapper_, value_wrapper_);
   AddMembers(&members_wrapper_, value_wrapper_2_);
 
-  queue<VariableWrapper> bfs_queue;
+  VariableQueue bfs_queue;
   bfs_queue.push(members_wrapper_);
-  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, []() { return false; },
-                                           &eval_coordinator_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // BFS should fill up the proto with correct type.
@@ -273,25 +303,21 @@ TEST_F(VariableWrapperTest, TestBFSTwoChildrenWithTerminatingCondition) {
   AddMembers(&members_wrapper_, value_wrapper_);
   AddMembers(&members_wrapper_, value_wrapper_2_);
 
-  bool first_time = true;
-  queue<VariableWrapper> bfs_queue;
+  VariableQueue bfs_queue;
   bfs_queue.push(members_wrapper_);
-  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue,
-                                           [&first_time]() {
-                                             // Terminates the BFS after
-                                             // processing the first item.
-                                             if (first_time) {
-                                               first_time = false;
-                                               return false;
-                                             }
-                                             return true;
-                                           },
-                                           &eval_coordinator_);
+  // The queued item alone takes up the limit, so the BFS terminates
+  // after processing it.
+  SnapshotSizeTracker size_tracker(0, SnapshotSizeTracker::kMaxLengthSize - 1);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // BFS should fill up the proto with correct type.
   CheckType(&members_wrapper_);
 
+  // The children that are not populated are removed from the queue.
+  EXPECT_TRUE(bfs_queue.empty());
+
   // Checks that the children are not filled up at all.
   EXPECT_EQ(value_wrapper_.GetVariableProto()->type(), "");
   EXPECT_EQ(value_wrapper_.GetVariableProto()->value(), "");
@@ -299,6 +325,49 @@ TEST_F(VariableWrapperTest, TestBFSTwoChildrenWithTerminatingCondition) {
   EXPECT_EQ(value_wrapper_2_.GetVariableProto()->value(), "");
 }
 
+// Tests that PerformBFS stops once the deadline of the capture passed and
+// marks the variables it did not populate.
+TEST_F(VariableWrapperTest, TestBFSDeadlineExceeded) {
+  AddMembers(&members_wrapper_, value_wrapper_);
+
+  VariableQueue bfs_queue;
+  bfs_queue.push(members_wrapper_);
+  bfs_queue.push(value_wrapper_2_);
+  CaptureLimits limits;
+  limits.deadline = std::chrono::steady_clock::now();
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                           &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_TRUE(bfs_queue.empty());
+
+  for (VariableWrapper *wrapper : {&members_wrapper_, &value_wrapper_2_}) {
+    const Variable &variable = *wrapper->GetVariableProto();
+    EXPECT_EQ(variable.type(), "");
+    EXPECT_EQ(variable.members_size(), 0);
+    EXPECT_FALSE(variable.status().iserror());
+    EXPECT_EQ(variable.status().message(), kCaptureDeadlineExceeded);
+  }
+}
+
+// Tests that the size tracked by PerformBFS is at least the size
+// the variables are serialized to.
+TEST_F(VariableWrapperTest, TestBFSTrackedSize) {
+  AddMembers(&members_wrapper_, value_wrapper_);
+  AddMembers(&members_wrapper_, value_wrapper_2_);
+
+  size_t initial_size = members_wrapper_.GetVariableProto()->ByteSizeLong();
+  VariableQueue bfs_queue;
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(initial_size, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  EXPECT_GE(size_tracker.GetSize(),
+            members_wrapper_.GetVariableProto()->ByteSizeLong());
+}
+
 // Tests PerformBFS method when there is 1 item with 2 children
 // and 1 of the children has another 2 children. We will, however,
 // sets the BFS level so that the last 2 children won't be evaluated.
@@ -310,10 +379,11 @@ TEST_F(VariableWrapperTest, TestBFSTwoLevels) {
   members_wrapper_.SetBFSLevel(google_cloud_debugger::kDefaultObjectEvalDepth -
                                2);
 
-  queue<VariableWrapper> bfs_queue;
+  VariableQueue bfs_queue;
   bfs_queue.push(members_wrapper_);
-  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, []() { return false; },
-                                           &eval_coordinator_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // BFS should fill up the proto with correct type.
@@ -334,6 +404,44 @@ TEST_F(VariableWrapperTest, TestBFSTwoLevels) {
             "Object evaluation limit reached");
 }
 
+// Tests PerformBFS method with a maximum depth of 1, so that
+// the children are not evaluated.
+TEST_F(VariableWrapperTest, TestBFSMaxDepth) {
+  AddMembers(&members_wrapper_, value_wrapper_);
+
+  CaptureLimits limits;
+  limits.max_depth = 1;
+  VariableQueue bfs_queue;
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                           &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  CheckType(&members_wrapper_);
+  EXPECT_TRUE(members_wrapper_.GetVariableProto()->status().iserror());
+  EXPECT_EQ(members_wrapper_.GetVariableProto()->status().message(),
+            "Object evaluation limit reached");
+  EXPECT_EQ(value_wrapper_.GetVariableProto()->type(), "");
+}
+
+// Tests that PerformBFS truncates values longer than max_string_length.
+TEST_F(VariableWrapperTest, TestBFSMaxStringLength) {
+  CaptureLimits limits;
+  limits.max_string_length = 3;
+  VariableQueue bfs_queue;
+  bfs_queue.push(value_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                           &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  FakeDbgObjectValue *fake_dbg_object =
+      (FakeDbgObjectValue *)value_wrapper_.GetVariableValue().get();
+  EXPECT_EQ(value_wrapper_.GetVariableProto()->value(),
+            fake_dbg_object->value_.substr(0, 3) + "...");
+}
+
 // Tests PerformBFS method when there is 1 item with 2 children
 // and each chilren has 2 children.
 TEST_F(VariableWrapperTest, TestBFSThreeLevels) {
@@ -345,10 +453,11 @@ TEST_F(VariableWrapperTest, TestBFSThreeLevels) {
   AddMembers(&members_wrapper_3_, value_wrapper_3_);
   AddMembers(&members_wrapper_3_, value_wrapper_4_);
 
-  queue<VariableWrapper> bfs_queue;
+  VariableQueue bfs_queue;
   bfs_queue.push(members_wrapper_);
-  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, []() { return false; },
-                                           &eval_coordinator_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
   EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
 
   // Checks that BFS fill up everything correctly.
@@ -366,4 +475,218 @@ TEST_F(VariableWrapperTest, TestBFSThreeLevels) {
   CheckValue(&value_wrapper_4_);
 }
 
+// Tests that PerformBFS resolves the value of a variable only when it
+// populates the variable.
+TEST_F(VariableWrapperTest, TestBFSValueResolver) {
+  int resolved = 0;
+  shared_ptr<DbgObject> value = value_wrapper_.GetVariableValue();
+  VariableWrapper lazy_wrapper(value_wrapper_.GetVariableProto(), nullptr);
+  lazy_wrapper.SetValueResolver(
+      [&resolved, value](shared_ptr<DbgObject> *variable_value) -> HRESULT {
+        ++resolved;
+        *variable_value = value;
+        return S_OK;
+      });
+  AddMembers(&members_wrapper_, lazy_wrapper);
+
+  // The BFS stops before the member is populated.
+  {
+    VariableQueue bfs_queue;
+    bfs_queue.push(members_wrapper_);
+    SnapshotSizeTracker size_tracker(0,
+                                     SnapshotSizeTracker::kMaxLengthSize - 1);
+    EXPECT_EQ(VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                          &size_tracker, &eval_coordinator_),
+              S_OK);
+    EXPECT_EQ(resolved, 0);
+  }
+
+  VariableQueue bfs_queue;
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_EQ(resolved, 1);
+  CheckType(&value_wrapper_);
+  CheckValue(&value_wrapper_);
+}
+
+// Tests that a variable whose value cannot be resolved is not populated.
+TEST_F(VariableWrapperTest, TestValueResolverError) {
+  VariableWrapper lazy_wrapper(value_wrapper_.GetVariableProto(), nullptr);
+  lazy_wrapper.SetValueResolver(
+      [](shared_ptr<DbgObject> *variable_value) -> HRESULT { return E_FAIL; });
+
+  EXPECT_EQ(lazy_wrapper.PopulateType(), E_FAIL);
+  EXPECT_EQ(value_wrapper_.GetVariableProto()->type(), "");
+
+  // The value is resolved only once.
+  EXPECT_EQ(lazy_wrapper.PopulateValue(), E_INVALIDARG);
+}
+
+// Tests that PerformBFS only captures the members on the paths of a
+// capture mask in full.
+TEST_F(VariableWrapperTest, TestBFSCaptureMask) {
+  members_wrapper_.GetVariableProto()->set_name("order");
+  members_wrapper_2_.GetVariableProto()->set_name("Items");
+  value_wrapper_.GetVariableProto()->set_name("Count");
+  value_wrapper_2_.GetVariableProto()->set_name("Id");
+  AddMembers(&members_wrapper_, members_wrapper_2_);
+  AddMembers(&members_wrapper_, value_wrapper_2_);
+  AddMembers(&members_wrapper_2_, value_wrapper_);
+
+  CaptureMask mask;
+  ASSERT_TRUE(CaptureMask::Parse("order.Items:3", &mask));
+  // The members on the way to the target are expanded even though they
+  // are deeper than the evaluation depth, and the target is captured to
+  // the depth of its path.
+  CaptureLimits limits;
+  limits.max_depth = 1;
+
+  VariableQueue bfs_queue;
+  members_wrapper_.SetCaptureMask(mask.GetMember("order"));
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                           &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  CheckType(&members_wrapper_);
+  CheckType(&members_wrapper_2_);
+  CheckType(&value_wrapper_);
+  CheckValue(&value_wrapper_);
+
+  // Id is not on the path, so only its type is captured.
+  CheckType(&value_wrapper_2_);
+  EXPECT_EQ(value_wrapper_2_.GetVariableProto()->value(), "");
+}
+
+// Tests that a variable that is not on a path of the capture mask only
+// gets its type.
+TEST_F(VariableWrapperTest, TestBFSTypeOnly) {
+  AddMembers(&members_wrapper_, value_wrapper_);
+
+  VariableQueue bfs_queue;
+  members_wrapper_.SetTypeOnly();
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  CheckType(&members_wrapper_);
+  EXPECT_EQ(members_wrapper_.GetVariableProto()->members_size(), 0);
+  EXPECT_EQ(value_wrapper_.GetVariableProto()->type(), "");
+}
+
+// Tests that PerformBFS captures an object larger than max_object_bytes
+// with its type and size only.
+TEST_F(VariableWrapperTest, TestBFSObjectTooLarge) {
+  AddMembers(&members_wrapper_, value_wrapper_);
+  members_wrapper_.GetVariableValue()->SetObjectSize(1000);
+
+  CaptureLimits limits;
+  limits.max_object_bytes = 999;
+  VariableQueue bfs_queue;
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                           &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  const Variable *proto = members_wrapper_.GetVariableProto();
+  CheckType(&members_wrapper_);
+  EXPECT_EQ(value_wrapper_.GetVariableProto()->value(), "");
+  EXPECT_FALSE(proto->status().iserror());
+  EXPECT_EQ(proto->status().message(),
+            "Object of 1000 bytes is larger than the capture limit of 999 "
+            "bytes");
+
+  // An object within the limit is expanded.
+  Variable proto_2;
+  VariableWrapper wrapper_2(&proto_2, members_wrapper_.GetVariableValue());
+  limits.max_object_bytes = 1000;
+  bfs_queue.push(wrapper_2);
+  hr = VariableWrapper::PerformBFS(&bfs_queue, limits, &size_tracker,
+                                   &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+  EXPECT_FALSE(proto_2.has_status());
+  CheckValue(&value_wrapper_);
+}
+
+// Tests that PerformBFS does not expand an object again and refers to
+// the path of the variable it was expanded in instead.
+TEST_F(VariableWrapperTest, TestBFSExpandedObject) {
+  ICorDebugHandleValueMock root_handle;
+  ICorDebugHandleValueMock element_handle;
+  SetObject(&members_wrapper_, &root_handle, "root");
+  SetObject(&members_wrapper_2_, &element_handle, "[0]");
+  SetObject(&members_wrapper_3_, nullptr, "other");
+
+  // root[0] and root.other point back to root, and root.other also
+  // holds root[0].
+  Variable parent_proto;
+  parent_proto.set_name("parent");
+  VariableWrapper parent(&parent_proto, members_wrapper_.GetVariableValue());
+  Variable element_proto;
+  element_proto.set_name("element");
+  VariableWrapper element(&element_proto,
+                          members_wrapper_2_.GetVariableValue());
+  AddMembers(&members_wrapper_, members_wrapper_2_);
+  AddMembers(&members_wrapper_, members_wrapper_3_);
+  AddMembers(&members_wrapper_2_, parent);
+  AddMembers(&members_wrapper_3_, element);
+  AddMembers(&members_wrapper_3_, value_wrapper_);
+
+  VariableQueue bfs_queue;
+  bfs_queue.push(members_wrapper_);
+  SnapshotSizeTracker size_tracker(0, SIZE_MAX);
+  HRESULT hr = VariableWrapper::PerformBFS(&bfs_queue, CaptureLimits(),
+                                           &size_tracker, &eval_coordinator_);
+  EXPECT_TRUE(SUCCEEDED(hr)) << "Failed with hr: " << hr;
+
+  // The repeated objects get their type and a reference to the path.
+  CheckType(&parent);
+  EXPECT_EQ(parent_proto.value(), "see root");
+  EXPECT_FALSE(parent_proto.status().iserror());
+  CheckType(&element);
+  EXPECT_EQ(element_proto.value(), "see root[0]");
+
+  // The objects without a handle are expanded as before.
+  CheckValue(&value_wrapper_);
+}
+
+// Tests that the queue keeps the order of the variables when it wraps
+// around and grows.
+TEST_F(VariableWrapperTest, TestVariableQueue) {
+  vector<Variable> protos(200);
+  VariableQueue bfs_queue;
+  size_t next_push = 0;
+  size_t next_pop = 0;
+
+  // Pushes 2 variables and pops 1 until the queue has grown a few times.
+  while (next_push < protos.size()) {
+    bfs_queue.push(VariableWrapper(&protos[next_push++], nullptr));
+    bfs_queue.push(VariableWrapper(&protos[next_push++], nullptr));
+    EXPECT_EQ(bfs_queue.front().GetVariableProto(), &protos[next_pop++]);
+    bfs_queue.pop();
+    EXPECT_EQ(bfs_queue.size(), next_push - next_pop);
+  }
+
+  while (!bfs_queue.empty()) {
+    EXPECT_EQ(bfs_queue.front().GetVariableProto(), &protos[next_pop++]);
+    bfs_queue.pop();
+  }
+  EXPECT_EQ(next_pop, protos.size());
+
+  // Clearing keeps the memory of the queue.
+  size_t capacity = bfs_queue.capacity();
+  EXPECT_GE(capacity, protos.size() / 2);
+  bfs_queue.push(VariableWrapper(&protos[0], nullptr));
+  bfs_queue.clear();
+  EXPECT_TRUE(bfs_queue.empty());
+  EXPECT_EQ(bfs_queue.capacity(), capacity);
+}
+
 }  // namespace google_cloud_debugger_test
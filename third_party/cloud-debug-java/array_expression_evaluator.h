@@ -56,6 +56,11 @@ class IndexerAccessExpressionEvaluator : public ExpressionEvaluator {
       IDbgObjectFactory *obj_factory,
       std::ostream *err_stream) const override;
 
+  bool IsStaticOnly() const override {
+    return source_collection_->IsStaticOnly() &&
+           source_index_->IsStaticOnly();
+  }
+
  private:
   // Evaluates the expression when the source is an array.
   HRESULT EvaluateArrayIndex(
@@ -18,10 +18,13 @@
 
 #include <cmath>
 #include <limits>
+#include <sstream>
 #include "compiler_helpers.h"
+#include "condition_program.h"
 #include "dbg_primitive.h"
 #include "dbg_string.h"
 #include "error_messages.h"
+#include "string_evaluator.h"
 
 namespace google_cloud_debugger {
 
@@ -110,6 +113,184 @@ static bool IsDivisionOverflow(double_t value1, double_t value2) {
   return false;  // This condition does not apply to floating point.
 }
 
+namespace {
+
+// Operators of the kernels "Compile" selects. Each one implements a binary
+// operator on operands that were promoted to the same type.
+
+// Arithmetical and bitwise operators. Apply returns false if the operation
+// would trigger a "division by zero" or overflow signal.
+struct AddOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    *result = value1 + value2;
+    return true;
+  }
+};
+
+struct SubOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    *result = value1 - value2;
+    return true;
+  }
+};
+
+struct MulOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    *result = value1 * value2;
+    return true;
+  }
+};
+
+struct DivOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    if (IsDivisionByZero(value2) || IsDivisionOverflow(value1, value2)) {
+      return false;
+    }
+    *result = value1 / value2;
+    return true;
+  }
+};
+
+struct ModOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    if (IsDivisionByZero(value2) || IsDivisionOverflow(value1, value2)) {
+      return false;
+    }
+    *result = ComputeModulo(value1, value2);
+    return true;
+  }
+};
+
+struct BitwiseAndOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    *result = value1 & value2;
+    return true;
+  }
+};
+
+struct BitwiseOrOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    *result = value1 | value2;
+    return true;
+  }
+};
+
+struct BitwiseXorOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2, T *result) {
+    *result = value1 ^ value2;
+    return true;
+  }
+};
+
+// Shift operators. The shift count is already masked.
+struct ShiftLeftOperator {
+  template <typename T>
+  static T Apply(T value, int32_t count) {
+    return value << count;
+  }
+};
+
+struct ShiftRightOperator {
+  template <typename T>
+  static T Apply(T value, int32_t count) {
+    return value >> count;
+  }
+};
+
+// Relational operators, and conditional operators on booleans.
+struct EqualOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2) {
+    return value1 == value2;
+  }
+};
+
+struct NotEqualOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2) {
+    return value1 != value2;
+  }
+};
+
+struct LessOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2) {
+    return value1 < value2;
+  }
+};
+
+struct LessOrEqualOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2) {
+    return value1 <= value2;
+  }
+};
+
+struct GreaterOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2) {
+    return value1 > value2;
+  }
+};
+
+struct GreaterOrEqualOperator {
+  template <typename T>
+  static bool Apply(T value1, T value2) {
+    return value1 >= value2;
+  }
+};
+
+struct ConditionalAndOperator {
+  static bool Apply(bool value1, bool value2) { return value1 && value2; }
+};
+
+struct ConditionalOrOperator {
+  static bool Apply(bool value1, bool value2) { return value1 || value2; }
+};
+
+}  // namespace
+
+// Returns the content of "evaluator" if it is a string literal, otherwise
+// null.
+static const std::string *GetStringLiteral(ExpressionEvaluator *evaluator) {
+  StringEvaluator *literal = dynamic_cast<StringEvaluator *>(evaluator);
+  if (literal == nullptr) {
+    return nullptr;
+  }
+
+  return &literal->GetStringContent();
+}
+
+// Points "value" to the string "arg" evaluates to. If "literal" is set,
+// it is the content of "arg", which is not evaluated. Otherwise, the
+// string is held by "holder".
+static HRESULT EvaluateStringOperand(
+    const ExpressionEvaluator &arg, const std::string *literal,
+    std::shared_ptr<DbgObject> *holder, const std::string **value,
+    IEvalCoordinator *eval_coordinator, IDbgObjectFactory *obj_factory,
+    std::ostream *err_stream) {
+  if (literal != nullptr) {
+    *value = literal;
+    return S_OK;
+  }
+
+  HRESULT hr = arg.Evaluate(holder, eval_coordinator, obj_factory,
+                            err_stream);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  return DbgString::GetStringReference(holder->get(), value);
+}
+
 BinaryExpressionEvaluator::BinaryExpressionEvaluator(
     BinaryCSharpExpression::Type type, std::unique_ptr<ExpressionEvaluator> arg1,
     std::unique_ptr<ExpressionEvaluator> arg2)
@@ -117,6 +298,10 @@ BinaryExpressionEvaluator::BinaryExpressionEvaluator(
       arg1_(std::move(arg1)),
       arg2_(std::move(arg2)),
       computer_(nullptr),
+      primitive_computer_(nullptr),
+      compare_strings_(false),
+      string_literal1_(nullptr),
+      string_literal2_(nullptr),
       result_type_(TypeSignature::Object) {
 }
 
@@ -187,36 +372,32 @@ HRESULT BinaryExpressionEvaluator::CompileArithmetical(
     return hr;
   }
 
-  switch (result) {
-    case CorElementType::ELEMENT_TYPE_I4: {
-      computer_ = &BinaryExpressionEvaluator::ArithmeticComputer<int32_t>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_U4: {
-      computer_ = &BinaryExpressionEvaluator::ArithmeticComputer<uint32_t>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_I8: {
-      computer_ = &BinaryExpressionEvaluator::ArithmeticComputer<int64_t>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_U8: {
-      computer_ = &BinaryExpressionEvaluator::ArithmeticComputer<uint64_t>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_R4: {
-      computer_ = &BinaryExpressionEvaluator::ArithmeticComputer<float_t>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_R8: {
-      computer_ = &BinaryExpressionEvaluator::ArithmeticComputer<double_t>;
-      return S_OK;
-    }
-    default: {
-      *err_stream << kTypeMismatch;
-      return E_FAIL;
-    }
+  bool selected = false;
+  switch (type_) {
+    case BinaryCSharpExpression::Type::add:
+      selected = SelectArithmeticComputer<AddOperator>(result);
+      break;
+    case BinaryCSharpExpression::Type::sub:
+      selected = SelectArithmeticComputer<SubOperator>(result);
+      break;
+    case BinaryCSharpExpression::Type::mul:
+      selected = SelectArithmeticComputer<MulOperator>(result);
+      break;
+    case BinaryCSharpExpression::Type::div:
+      selected = SelectArithmeticComputer<DivOperator>(result);
+      break;
+    case BinaryCSharpExpression::Type::mod:
+      selected = SelectArithmeticComputer<ModOperator>(result);
+      break;
+    default:
+      break;
   }
+
+  if (!selected) {
+    *err_stream << kTypeMismatch;
+    return E_FAIL;
+  }
+  return S_OK;
 }
 
 HRESULT BinaryExpressionEvaluator::CompileRelational(std::ostream *err_stream) {
@@ -230,47 +411,40 @@ HRESULT BinaryExpressionEvaluator::CompileRelational(std::ostream *err_stream) {
       TypeCompilerHelper::IsNumericalType(signature2.cor_type)) {
     CorElementType result;
     if (!NumericCompilerHelper::BinaryNumericalPromotion(
-            signature1.cor_type, signature1.cor_type, &result, err_stream)) {
+            signature1.cor_type, signature2.cor_type, &result, err_stream)) {
       *err_stream << kTypeMismatch;
       return E_FAIL;
     }
 
-    switch (result) {
-      case CorElementType::ELEMENT_TYPE_I4: {
-        computer_ =
-            &BinaryExpressionEvaluator::NumericalComparisonComputer<int32_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_U4: {
-        computer_ =
-            &BinaryExpressionEvaluator::NumericalComparisonComputer<uint32_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_I8: {
-        computer_ =
-            &BinaryExpressionEvaluator::NumericalComparisonComputer<int64_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_U8: {
-        computer_ =
-            &BinaryExpressionEvaluator::NumericalComparisonComputer<uint64_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_R4: {
-        computer_ =
-            &BinaryExpressionEvaluator::NumericalComparisonComputer<float_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_R8: {
-        computer_ =
-            &BinaryExpressionEvaluator::NumericalComparisonComputer<double_t>;
-        return S_OK;
-      }
-      default: {
-        *err_stream << kTypeMismatch;
-        return E_FAIL;
-      }
+    bool selected = false;
+    switch (type_) {
+      case BinaryCSharpExpression::Type::eq:
+        selected = SelectRelationalComputer<EqualOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::ne:
+        selected = SelectRelationalComputer<NotEqualOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::le:
+        selected = SelectRelationalComputer<LessOrEqualOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::ge:
+        selected = SelectRelationalComputer<GreaterOrEqualOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::lt:
+        selected = SelectRelationalComputer<LessOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::gt:
+        selected = SelectRelationalComputer<GreaterOperator>(result);
+        break;
+      default:
+        break;
+    }
+
+    if (!selected) {
+      *err_stream << kTypeMismatch;
+      return E_FAIL;
     }
+    return S_OK;
   }
 
   // We don't support the other expressions if the types are not numeric.
@@ -288,7 +462,9 @@ HRESULT BinaryExpressionEvaluator::CompileRelational(std::ostream *err_stream) {
   // Conditional operations applied to objects.
   if (signature1.cor_type == CorElementType::ELEMENT_TYPE_STRING &&
       signature2.cor_type == CorElementType::ELEMENT_TYPE_STRING) {
-    computer_ = &BinaryExpressionEvaluator::ConditionalStringComputer;
+    compare_strings_ = true;
+    string_literal1_ = GetStringLiteral(arg1_.get());
+    string_literal2_ = GetStringLiteral(arg2_.get());
     return S_OK;
   } else if (!TypeCompilerHelper::IsNumericalType(signature1.cor_type) &&
              !TypeCompilerHelper::IsNumericalType(signature2.cor_type)) {
@@ -304,15 +480,39 @@ HRESULT BinaryExpressionEvaluator::CompileRelational(std::ostream *err_stream) {
 HRESULT BinaryExpressionEvaluator::CompileBooleanConditional(
     std::ostream *err_stream) {
   // Conditional operations that apply to boolean arguments.
-  if (arg1_->GetStaticType().cor_type == CorElementType::ELEMENT_TYPE_BOOLEAN &&
-      arg2_->GetStaticType().cor_type == CorElementType::ELEMENT_TYPE_BOOLEAN) {
-    computer_ = &BinaryExpressionEvaluator::ConditionalBooleanComputer;
-    result_type_ = {CorElementType::ELEMENT_TYPE_BOOLEAN, kBooleanClassName};
-    return S_OK;
+  if (arg1_->GetStaticType().cor_type != CorElementType::ELEMENT_TYPE_BOOLEAN ||
+      arg2_->GetStaticType().cor_type != CorElementType::ELEMENT_TYPE_BOOLEAN) {
+    *err_stream << kTypeMismatch;
+    return E_FAIL;
   }
 
-  *err_stream << kTypeMismatch;
-  return E_FAIL;
+  switch (type_) {
+    case BinaryCSharpExpression::Type::conditional_and:
+    case BinaryCSharpExpression::Type::bitwise_and:
+      primitive_computer_ = &BinaryExpressionEvaluator::RelationalComputer<
+          bool, ConditionalAndOperator>;
+      break;
+    case BinaryCSharpExpression::Type::conditional_or:
+    case BinaryCSharpExpression::Type::bitwise_or:
+      primitive_computer_ = &BinaryExpressionEvaluator::RelationalComputer<
+          bool, ConditionalOrOperator>;
+      break;
+    case BinaryCSharpExpression::Type::eq:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<bool, EqualOperator>;
+      break;
+    case BinaryCSharpExpression::Type::ne:
+    case BinaryCSharpExpression::Type::bitwise_xor:
+      primitive_computer_ = &BinaryExpressionEvaluator::RelationalComputer<
+          bool, NotEqualOperator>;
+      break;
+    default:
+      *err_stream << kTypeMismatch;
+      return E_FAIL;
+  }
+
+  result_type_ = {CorElementType::ELEMENT_TYPE_BOOLEAN, kBooleanClassName};
+  return S_OK;
 }
 
 HRESULT BinaryExpressionEvaluator::CompileLogical(std::ostream *err_stream) {
@@ -339,28 +539,26 @@ HRESULT BinaryExpressionEvaluator::CompileLogical(std::ostream *err_stream) {
       return hr;
     }
 
-    switch (result) {
-      case CorElementType::ELEMENT_TYPE_I4: {
-        computer_ = &BinaryExpressionEvaluator::BitwiseComputer<int32_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_U4: {
-        computer_ = &BinaryExpressionEvaluator::BitwiseComputer<uint32_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_I8: {
-        computer_ = &BinaryExpressionEvaluator::BitwiseComputer<int64_t>;
-        return S_OK;
-      }
-      case CorElementType::ELEMENT_TYPE_U8: {
-        computer_ = &BinaryExpressionEvaluator::BitwiseComputer<uint64_t>;
-        return S_OK;
-      }
-      default: {
-        *err_stream << kTypeMismatch;
-        return E_FAIL;
-      }
+    bool selected = false;
+    switch (type_) {
+      case BinaryCSharpExpression::Type::bitwise_and:
+        selected = SelectBitwiseComputer<BitwiseAndOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::bitwise_or:
+        selected = SelectBitwiseComputer<BitwiseOrOperator>(result);
+        break;
+      case BinaryCSharpExpression::Type::bitwise_xor:
+        selected = SelectBitwiseComputer<BitwiseXorOperator>(result);
+        break;
+      default:
+        break;
     }
+
+    if (!selected) {
+      *err_stream << kTypeMismatch;
+      return E_FAIL;
+    }
+    return S_OK;
   }
 
   // Otherwise, try to compile them as boolean.
@@ -394,33 +592,148 @@ HRESULT BinaryExpressionEvaluator::CompileShift(std::ostream *err_stream) {
     return hr;
   }
 
-  switch (arg1_type) {
-    case CorElementType::ELEMENT_TYPE_I4: {
-      computer_ = &BinaryExpressionEvaluator::ShiftComputer<int32_t, 0x1f>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_U4: {
-      computer_ = &BinaryExpressionEvaluator::ShiftComputer<uint32_t, 0x1f>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_I8: {
-      computer_ = &BinaryExpressionEvaluator::ShiftComputer<int64_t, 0x3f>;
-      return S_OK;
-    }
-    case CorElementType::ELEMENT_TYPE_U8: {
-      computer_ = &BinaryExpressionEvaluator::ShiftComputer<uint64_t, 0x3f>;
-      return S_OK;
-    }
-    default: {
-      *err_stream << kTypeMismatch;
+  // Both >> and >>> use the C++ >> operator of the type of arg1.
+  const bool selected =
+      type_ == BinaryCSharpExpression::Type::shl
+          ? SelectShiftComputer<ShiftLeftOperator>(arg1_type)
+          : SelectShiftComputer<ShiftRightOperator>(arg1_type);
+  if (!selected) {
+    *err_stream << kTypeMismatch;
+    return E_FAIL;
+  }
+  return S_OK;
+}
+
+template <typename Operator>
+bool BinaryExpressionEvaluator::SelectArithmeticComputer(
+    const CorElementType &type) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_I4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<int32_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<uint32_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_I8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<int64_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<uint64_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_R4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<float_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_R8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<double_t, Operator>;
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename Operator>
+bool BinaryExpressionEvaluator::SelectBitwiseComputer(
+    const CorElementType &type) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_I4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<int32_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<uint32_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_I8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<int64_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ArithmeticComputer<uint64_t, Operator>;
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename Operator>
+bool BinaryExpressionEvaluator::SelectShiftComputer(
+    const CorElementType &type) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_I4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ShiftComputer<int32_t, 0x1f, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ShiftComputer<uint32_t, 0x1f, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_I8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ShiftComputer<int64_t, 0x3f, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::ShiftComputer<uint64_t, 0x3f, Operator>;
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename Operator>
+bool BinaryExpressionEvaluator::SelectRelationalComputer(
+    const CorElementType &type) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_I4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<int32_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<uint32_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_I8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<int64_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_U8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<uint64_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_R4:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<float_t, Operator>;
+      return true;
+    case CorElementType::ELEMENT_TYPE_R8:
+      primitive_computer_ =
+          &BinaryExpressionEvaluator::RelationalComputer<double_t, Operator>;
+      return true;
+    default:
       return false;
-    }
   }
 }
 
 HRESULT BinaryExpressionEvaluator::Evaluate(
     std::shared_ptr<DbgObject> *dbg_object, IEvalCoordinator *eval_coordinator,
     IDbgObjectFactory *obj_factory, std::ostream *err_stream) const {
+  if (primitive_computer_ || compare_strings_) {
+    PrimitiveValue value;
+    HRESULT hr = EvaluatePrimitive(&value, eval_coordinator, obj_factory,
+                                   err_stream);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    return value.CreateDbgObject(dbg_object);
+  }
+
   std::shared_ptr<DbgObject> arg1_obj;
   HRESULT hr = arg1_->Evaluate(&arg1_obj, eval_coordinator,
                                obj_factory, err_stream);
@@ -429,158 +742,204 @@ HRESULT BinaryExpressionEvaluator::Evaluate(
     return hr;
   }
 
-  // For this special case, don't evaluate the second obj.
-  if (type_ == BinaryCSharpExpression::Type::conditional_and) {
-    bool boolean1;
-    HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<bool>(
-        arg1_obj.get(), &boolean1);
-    if (FAILED(hr)) {
-      return hr;
-    }
+  std::shared_ptr<DbgObject> arg2_obj;
+  hr = arg2_->Evaluate(&arg2_obj, eval_coordinator, obj_factory, err_stream);
+  if (FAILED(hr)) {
+    *err_stream << kFailedToEvalSecondSubExpr;
+    return hr;
+  }
 
-    // If arg1 in 'arg1 && arg2' is false, expression is false.
-    if (!boolean1) {
-      *dbg_object = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(false));
-      return S_OK;
-    }
-    // Otherwise, proceeds to evaluate the second operand.
+  return (this->*computer_)(arg1_obj, arg2_obj, dbg_object);
+}
+
+HRESULT BinaryExpressionEvaluator::EvaluatePrimitive(
+    PrimitiveValue *value, IEvalCoordinator *eval_coordinator,
+    IDbgObjectFactory *obj_factory, std::ostream *err_stream) const {
+  if (compare_strings_) {
+    return EvaluateStringComparison(value, eval_coordinator, obj_factory,
+                                    err_stream);
+  }
+
+  if (!primitive_computer_) {
+    return ExpressionEvaluator::EvaluatePrimitive(value, eval_coordinator,
+                                                  obj_factory, err_stream);
   }
-  else if (type_ == BinaryCSharpExpression::Type::conditional_or) {
+
+  PrimitiveValue value1;
+  HRESULT hr = arg1_->EvaluatePrimitive(&value1, eval_coordinator,
+                                        obj_factory, err_stream);
+  if (FAILED(hr)) {
+    *err_stream << kFailedToEvalFirstSubExpr;
+    return hr;
+  }
+
+  // For these special cases, don't always evaluate the second operand.
+  if (type_ == BinaryCSharpExpression::Type::conditional_and ||
+      type_ == BinaryCSharpExpression::Type::conditional_or) {
     bool boolean1;
-    HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<bool>(
-        arg1_obj.get(), &boolean1);
+    hr = value1.Get(&boolean1);
     if (FAILED(hr)) {
       return hr;
     }
 
+    // If arg1 in 'arg1 && arg2' is false, expression is false.
     // If arg1 in 'arg1 || arg2' is true, expression is true.
-    if (boolean1) {
-      *dbg_object = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(true));
+    if (boolean1 == (type_ == BinaryCSharpExpression::Type::conditional_or)) {
+      value->Set(boolean1);
       return S_OK;
     }
     // Otherwise, proceeds to evaluate the second operand.
   }
 
-  std::shared_ptr<DbgObject> arg2_obj;
-  hr = arg2_->Evaluate(&arg2_obj, eval_coordinator, obj_factory, err_stream);
+  PrimitiveValue value2;
+  hr = arg2_->EvaluatePrimitive(&value2, eval_coordinator, obj_factory,
+                                err_stream);
   if (FAILED(hr)) {
     *err_stream << kFailedToEvalSecondSubExpr;
     return hr;
   }
 
-  return (this->*computer_)(arg1_obj, arg2_obj, dbg_object);
+  return (this->*primitive_computer_)(value1, value2, value);
 }
 
-template <typename T>
-HRESULT BinaryExpressionEvaluator::ArithmeticComputer(
-    std::shared_ptr<DbgObject> arg1, std::shared_ptr<DbgObject> arg2,
-    std::shared_ptr<DbgObject> *result) const {
-  T value1;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg1.get(), &value1);
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  T value2;
-  hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg2.get(), &value2);
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  switch (type_) {
-    case BinaryCSharpExpression::Type::add: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 + value2));
-      return S_OK;
+bool BinaryExpressionEvaluator::Lower(ConditionProgram *program,
+                                      const CorElementType &type,
+                                      int dest) const {
+  typedef ConditionProgram::OpCode OpCode;
+  const CorElementType &arg1_type = arg1_->GetStaticType().cor_type;
+  const CorElementType &arg2_type = arg2_->GetStaticType().cor_type;
+  const bool boolean_args =
+      arg1_type == CorElementType::ELEMENT_TYPE_BOOLEAN &&
+      arg2_type == CorElementType::ELEMENT_TYPE_BOOLEAN;
+
+  // Short-circuits like "Evaluate" does.
+  if (type_ == BinaryCSharpExpression::Type::conditional_and ||
+      type_ == BinaryCSharpExpression::Type::conditional_or) {
+    if (type != CorElementType::ELEMENT_TYPE_BOOLEAN ||
+        !arg1_->Lower(program, type, dest)) {
+      return false;
     }
 
-    case BinaryCSharpExpression::Type::sub: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 - value2));
-      return S_OK;
+    int jump = program->EmitJump(
+        type_ == BinaryCSharpExpression::Type::conditional_and
+            ? OpCode::kJumpIfFalse
+            : OpCode::kJumpIfTrue,
+        dest);
+    if (jump < 0 || !arg2_->Lower(program, type, dest)) {
+      return false;
     }
 
-    case BinaryCSharpExpression::Type::mul: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 * value2));
-      return S_OK;
-    }
+    program->PatchJump(jump);
+    return true;
+  }
 
-    case BinaryCSharpExpression::Type::mod:
+  OpCode op;
+  CorElementType operand_type;
+  switch (type_) {
+    case BinaryCSharpExpression::Type::add:
+    case BinaryCSharpExpression::Type::sub:
+    case BinaryCSharpExpression::Type::mul:
     case BinaryCSharpExpression::Type::div:
-      if (IsDivisionByZero(value2)) {
-        return E_INVALIDARG;
-      }
+    case BinaryCSharpExpression::Type::mod: {
+      static const OpCode arithmetic_ops[] = {OpCode::kAdd, OpCode::kSub,
+                                              OpCode::kMul, OpCode::kDiv,
+                                              OpCode::kMod};
+      op = arithmetic_ops[static_cast<int>(type_) -
+                          static_cast<int>(BinaryCSharpExpression::Type::add)];
+      operand_type = result_type_.cor_type;
+      break;
+    }
 
-      if (IsDivisionOverflow(value1, value2)) {
-        return E_INVALIDARG;
+    case BinaryCSharpExpression::Type::eq:
+    case BinaryCSharpExpression::Type::ne:
+    case BinaryCSharpExpression::Type::le:
+    case BinaryCSharpExpression::Type::ge:
+    case BinaryCSharpExpression::Type::lt:
+    case BinaryCSharpExpression::Type::gt: {
+      static const OpCode relational_ops[] = {OpCode::kEq, OpCode::kNe,
+                                              OpCode::kLe, OpCode::kGe,
+                                              OpCode::kLt, OpCode::kGt};
+      op = relational_ops[static_cast<int>(type_) -
+                          static_cast<int>(BinaryCSharpExpression::Type::eq)];
+      // Compile already reported any type mismatch.
+      std::ostringstream err_stream;
+      if (boolean_args) {
+        operand_type = CorElementType::ELEMENT_TYPE_BOOLEAN;
+      } else if (!NumericCompilerHelper::BinaryNumericalPromotion(
+                     arg1_type, arg2_type, &operand_type, &err_stream)) {
+        return false;
       }
+      break;
+    }
 
-      if (type_ == BinaryCSharpExpression::Type::div) {
-        *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 / value2));
-        return S_OK;
-      } else {
-        *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(ComputeModulo(value1, value2)));
-        return S_OK;
+    case BinaryCSharpExpression::Type::bitwise_and:
+    case BinaryCSharpExpression::Type::bitwise_or:
+    case BinaryCSharpExpression::Type::bitwise_xor: {
+      // Only the boolean (non short-circuiting) forms are supported.
+      if (!boolean_args) {
+        return false;
       }
 
+      static const OpCode boolean_ops[] = {OpCode::kAnd, OpCode::kOr,
+                                           OpCode::kNe};
+      op = boolean_ops[static_cast<int>(type_) -
+                       static_cast<int>(
+                           BinaryCSharpExpression::Type::bitwise_and)];
+      operand_type = CorElementType::ELEMENT_TYPE_BOOLEAN;
+      break;
+    }
+
     default:
-      return E_NOTIMPL;
+      return false;
+  }
+
+  int operand = program->AllocateRegister();
+  if (operand < 0 || !arg1_->Lower(program, operand_type, dest) ||
+      !arg2_->Lower(program, operand_type, operand) ||
+      !program->EmitOperation(op, operand_type, dest, operand)) {
+    return false;
   }
+
+  return program->EmitConvert(result_type_.cor_type, type, dest);
 }
 
-template <typename T>
-HRESULT BinaryExpressionEvaluator::BitwiseComputer(
-    std::shared_ptr<DbgObject> arg1, std::shared_ptr<DbgObject> arg2,
-    std::shared_ptr<DbgObject> *result) const {
+template <typename T, typename Operator>
+HRESULT BinaryExpressionEvaluator::ArithmeticComputer(
+    const PrimitiveValue &arg1, const PrimitiveValue &arg2,
+    PrimitiveValue *result) const {
   T value1;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg1.get(), &value1);
+  HRESULT hr = arg1.Get(&value1);
   if (FAILED(hr)) {
     return hr;
   }
 
   T value2;
-  hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg2.get(), &value2);
+  hr = arg2.Get(&value2);
   if (FAILED(hr)) {
     return hr;
   }
 
-  switch (type_) {
-    case BinaryCSharpExpression::Type::bitwise_and: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 & value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::bitwise_or: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 | value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::bitwise_xor: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1 ^ value2));
-      return S_OK;
-    }
-
-    default:
-      return E_NOTIMPL;
+  T value;
+  if (!Operator::Apply(value1, value2, &value)) {
+    return E_INVALIDARG;
   }
+
+  result->Set(value);
+  return S_OK;
 }
 
-template <typename T, uint16_t Bitmask>
+template <typename T, uint16_t Bitmask, typename Operator>
 HRESULT BinaryExpressionEvaluator::ShiftComputer(
-    std::shared_ptr<DbgObject> arg1, std::shared_ptr<DbgObject> arg2,
-    std::shared_ptr<DbgObject> *result) const {
+    const PrimitiveValue &arg1, const PrimitiveValue &arg2,
+    PrimitiveValue *result) const {
   T value1;
-  HRESULT hr =
-      NumericCompilerHelper::ExtractPrimitiveValue<T>(arg1.get(), &value1);
+  HRESULT hr = arg1.Get(&value1);
   if (FAILED(hr)) {
     return hr;
   }
 
   int32_t value2 = 0;
-  hr = NumericCompilerHelper::ExtractPrimitiveValue<int32_t>(
-      arg2.get(), &value2);
+  hr = arg2.Get(&value2);
   if (FAILED(hr)) {
     return hr;
   }
@@ -596,23 +955,7 @@ HRESULT BinaryExpressionEvaluator::ShiftComputer(
   // Bitmask represents either 0x1F or 0x3F.
   value2 &= Bitmask;
 
-  switch (type_) {
-    case BinaryCSharpExpression::Type::shl: {
-      value1 = value1 << value2;
-      break;
-    }
-
-    case BinaryCSharpExpression::Type::shr_s:
-    case BinaryCSharpExpression::Type::shr_u: {
-      value1 = value1 >> value2;
-      break;
-    }
-
-    default:
-      return E_NOTIMPL;
-  }
-
-  *result = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(value1));
+  result->Set(static_cast<T>(Operator::Apply(value1, value2)));
   return S_OK;
 }
 
@@ -637,140 +980,63 @@ HRESULT BinaryExpressionEvaluator::ConditionalObjectComputer(
   }
 }
 
-HRESULT BinaryExpressionEvaluator::ConditionalStringComputer(
-    std::shared_ptr<DbgObject> arg1, std::shared_ptr<DbgObject> arg2,
-    std::shared_ptr<DbgObject> *result) const {
-  // Extracts out the 2 strings and compare them.
-  std::string first_string;
-  HRESULT hr = DbgString::GetString(arg1.get(), &first_string);
+HRESULT BinaryExpressionEvaluator::EvaluateStringComparison(
+    PrimitiveValue *value, IEvalCoordinator *eval_coordinator,
+    IDbgObjectFactory *obj_factory, std::ostream *err_stream) const {
+  std::shared_ptr<DbgObject> arg1_obj;
+  const std::string *first_string;
+  HRESULT hr = EvaluateStringOperand(*arg1_, string_literal1_, &arg1_obj,
+                                     &first_string, eval_coordinator,
+                                     obj_factory, err_stream);
   if (FAILED(hr)) {
+    *err_stream << kFailedToEvalFirstSubExpr;
     return hr;
   }
 
-  std::string second_string;
-  hr = DbgString::GetString(arg2.get(), &second_string);
+  std::shared_ptr<DbgObject> arg2_obj;
+  const std::string *second_string;
+  hr = EvaluateStringOperand(*arg2_, string_literal2_, &arg2_obj,
+                             &second_string, eval_coordinator, obj_factory,
+                             err_stream);
   if (FAILED(hr)) {
+    *err_stream << kFailedToEvalSecondSubExpr;
     return hr;
   }
 
-  const bool is_equal = first_string.compare(second_string) == 0;
+  const bool is_equal = *first_string == *second_string;
 
   switch (type_) {
-    case BinaryCSharpExpression::Type::eq: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(is_equal));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::ne: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(!is_equal));
-      return S_OK;
-    }
-
-    default:
-      return E_NOTIMPL;
-  }
-}
-
-HRESULT BinaryExpressionEvaluator::ConditionalBooleanComputer(
-    std::shared_ptr<DbgObject> arg1, std::shared_ptr<DbgObject> arg2,
-    std::shared_ptr<DbgObject> *result) const {
-  // Extracts out the booleans and perform the binary operator.
-  bool boolean1;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<bool>(
-      arg1.get(), &boolean1);
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  bool boolean2;
-  hr = NumericCompilerHelper::ExtractPrimitiveValue<bool>(
-      arg2.get(), &boolean2);
-  if (FAILED(hr)) {
-    return hr;
-  }
-
-  switch (type_) {
-    case BinaryCSharpExpression::Type::conditional_and:
-    case BinaryCSharpExpression::Type::bitwise_and: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(boolean1 && boolean2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::conditional_or:
-    case BinaryCSharpExpression::Type::bitwise_or: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(boolean1 || boolean2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::eq: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(boolean1 == boolean2));
+    case BinaryCSharpExpression::Type::eq:
+      value->Set(is_equal);
       return S_OK;
-    }
 
     case BinaryCSharpExpression::Type::ne:
-    case BinaryCSharpExpression::Type::bitwise_xor: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(boolean1 != boolean2));
+      value->Set(!is_equal);
       return S_OK;
-    }
 
     default:
       return E_NOTIMPL;
   }
 }
 
-template <typename T>
-HRESULT BinaryExpressionEvaluator::NumericalComparisonComputer(
-    std::shared_ptr<DbgObject> arg1, std::shared_ptr<DbgObject> arg2,
-    std::shared_ptr<DbgObject> *result) const {
+template <typename T, typename Operator>
+HRESULT BinaryExpressionEvaluator::RelationalComputer(
+    const PrimitiveValue &arg1, const PrimitiveValue &arg2,
+    PrimitiveValue *result) const {
   T value1;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg1.get(), &value1);
+  HRESULT hr = arg1.Get(&value1);
   if (FAILED(hr)) {
     return hr;
   }
 
   T value2;
-  hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg2.get(), &value2);
+  hr = arg2.Get(&value2);
   if (FAILED(hr)) {
     return hr;
   }
 
-  switch (type_) {
-    case BinaryCSharpExpression::Type::eq: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(value1 == value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::ne:
-    case BinaryCSharpExpression::Type::bitwise_xor: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(value1 != value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::le: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(value1 <= value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::ge: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(value1 >= value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::lt: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(value1 < value2));
-      return S_OK;
-    }
-
-    case BinaryCSharpExpression::Type::gt: {
-      *result = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(value1 > value2));
-      return S_OK;
-    }
-
-    default:
-      return E_NOTIMPL;
-  }
+  result->Set(Operator::Apply(value1, value2));
+  return S_OK;
 }
 
 }  // namespace google_cloud_debugger
@@ -52,12 +52,34 @@ class BinaryExpressionEvaluator : public ExpressionEvaluator {
   // evaluating the second subexpression (short-circuiting).
   // Otherwise, evaluates the second expression and perform
   // the binary function computer_ on both of them.
+  // Operators on numbers and booleans and comparisons of strings are
+  // evaluated with "EvaluatePrimitive", so only their final value is a
+  // new DbgObject.
   HRESULT Evaluate(
     std::shared_ptr<DbgObject> *dbg_object,
     IEvalCoordinator *eval_coordinator,
     IDbgObjectFactory *obj_factory,
     std::ostream *err_stream) const override;
 
+  // Evaluates operators on numbers and booleans from the primitive values
+  // of the subexpressions, with primitive_computer_, and comparisons of
+  // strings.
+  HRESULT EvaluatePrimitive(
+    PrimitiveValue *value,
+    IEvalCoordinator *eval_coordinator,
+    IDbgObjectFactory *obj_factory,
+    std::ostream *err_stream) const override;
+
+  // Lowers arithmetical operators and the relational and conditional
+  // operators on numbers and booleans. The operands are converted to
+  // the type they are promoted to as in "Compile".
+  bool Lower(ConditionProgram *program, const CorElementType &type,
+             int dest) const override;
+
+  bool IsStaticOnly() const override {
+    return arg1_->IsStaticOnly() && arg2_->IsStaticOnly();
+  }
+
  private:
   // Implements "Compile" for arithmetical operators (+, -, *, /, %).
   HRESULT CompileArithmetical(std::ostream* err_stream);
@@ -75,34 +97,39 @@ class BinaryExpressionEvaluator : public ExpressionEvaluator {
   // Implements "Compile" for shoft operators (<<, >>, >>>).
   HRESULT CompileShift(std::ostream* err_stream);
 
-  // Computes the value of the expression for arithmetical operators. The
-  // template type "T" is the type that both arguments were promoted into.
-  template <typename T>
+  // Sets primitive_computer_ to the kernel of Operator for arguments
+  // promoted to type. Returns false if Operator does not apply to type.
+  // Arithmetical and relational operators apply to int, uint, long, ulong,
+  // float and double; bitwise and shift operators to the integral ones.
+  template <typename Operator>
+  bool SelectArithmeticComputer(const CorElementType &type);
+  template <typename Operator>
+  bool SelectBitwiseComputer(const CorElementType &type);
+  template <typename Operator>
+  bool SelectShiftComputer(const CorElementType &type);
+  template <typename Operator>
+  bool SelectRelationalComputer(const CorElementType &type);
+
+  // Computes the value of the expression for arithmetical and bitwise
+  // operators with Operator::Apply. This does not include bitwise operators
+  // applied on booleans (which become conditional operators). The template
+  // type "T" is the type that both arguments were promoted into.
+  template <typename T, typename Operator>
   HRESULT ArithmeticComputer(
-      std::shared_ptr<DbgObject> arg1,
-      std::shared_ptr<DbgObject> arg2,
-      std::shared_ptr<DbgObject> *result) const;
-
-  // Computes the value of the expression for bitwise operators. This does not
-  // include bitwise operators applied on booleans (which become conditional
-  // operators). The template type "T" can be either any integral types.
-  // "T" is the type that both arguments were promoted too.
-  template <typename T>
-  HRESULT BitwiseComputer(
-      std::shared_ptr<DbgObject> arg1,
-      std::shared_ptr<DbgObject> arg2,
-      std::shared_ptr<DbgObject> *result) const;
-
-  // Computes the value of shift expression. The template type "T" denotes the
-  // type of the first argument (the shifted number). The type of
-  // the second argument must be int. "Bitmask" is applied to the
-  // second argument as per specifications:
+      const PrimitiveValue &arg1,
+      const PrimitiveValue &arg2,
+      PrimitiveValue *result) const;
+
+  // Computes the value of shift expression with Operator::Apply. The
+  // template type "T" denotes the type of the first argument (the shifted
+  // number). The type of the second argument must be int. "Bitmask" is
+  // applied to the second argument as per specifications:
   // https://docs.microsoft.com/en-us/dotnet/csharp/language-reference/language-specification/expressions#shift-operators
-  template <typename T, uint16_t Bitmask>
+  template <typename T, uint16_t Bitmask, typename Operator>
   HRESULT ShiftComputer(
-      std::shared_ptr<DbgObject> arg1,
-      std::shared_ptr<DbgObject> arg2,
-      std::shared_ptr<DbgObject> *result) const;
+      const PrimitiveValue &arg1,
+      const PrimitiveValue &arg2,
+      PrimitiveValue *result) const;
 
   // Implements comparison operator on .NET objects.
   // Objects are equal if they have the same address.
@@ -111,27 +138,25 @@ class BinaryExpressionEvaluator : public ExpressionEvaluator {
       std::shared_ptr<DbgObject> arg2,
       std::shared_ptr<DbgObject> *result) const;
 
-  // Compares two stringgs.
-  HRESULT ConditionalStringComputer(
-      std::shared_ptr<DbgObject> arg1,
-      std::shared_ptr<DbgObject> arg2,
-      std::shared_ptr<DbgObject> *result) const;
-
-  // Implements conditional operators. This method will extract out
-  // the boolean value from arg1 and arg2 and perform the binary operators
-  // on them. The result will be stored in result.
-  HRESULT ConditionalBooleanComputer(
-      std::shared_ptr<DbgObject> arg1,
-      std::shared_ptr<DbgObject> arg2,
-      std::shared_ptr<DbgObject> *result) const;
-
-  // Implements comparison operators for numerical types (i.e. not booleans).
-  // The two arguments are promoted to the same type and compared against each other.
-  template <typename T>
-  HRESULT NumericalComparisonComputer(
-      std::shared_ptr<DbgObject> arg1,
-      std::shared_ptr<DbgObject> arg2,
-      std::shared_ptr<DbgObject> *result) const;
+  // Implements "EvaluatePrimitive" for comparison operators on strings.
+  // The strings are compared where they are held, without copying them,
+  // and the operands that are string literals are not created in the
+  // debuggee.
+  HRESULT EvaluateStringComparison(
+      PrimitiveValue *value,
+      IEvalCoordinator *eval_coordinator,
+      IDbgObjectFactory *obj_factory,
+      std::ostream *err_stream) const;
+
+  // Implements comparison operators for numerical types and conditional
+  // operators on booleans with Operator::Apply. The two arguments are
+  // promoted to "T" ("bool" for conditional operators) and compared
+  // against each other.
+  template <typename T, typename Operator>
+  HRESULT RelationalComputer(
+      const PrimitiveValue &arg1,
+      const PrimitiveValue &arg2,
+      PrimitiveValue *result) const;
 
  private:
   // Binary expression type (e.g. + or <<).
@@ -144,12 +169,31 @@ class BinaryExpressionEvaluator : public ExpressionEvaluator {
   std::unique_ptr<ExpressionEvaluator> arg2_;
 
   // Pointer to a member function of this class to do the actual evaluation
-  // of the binary expression.
+  // of the binary expression on objects (e.g. string comparison).
   HRESULT (BinaryExpressionEvaluator::*computer_)(
       std::shared_ptr<DbgObject> arg1,
       std::shared_ptr<DbgObject> arg2,
       std::shared_ptr<DbgObject> *result) const;
 
+  // Pointer to a member function of this class to do the actual evaluation
+  // of the binary expression on numbers and booleans. "Compile" selects
+  // the kernel of the operator and promoted type, so evaluating it does
+  // not depend on type_. Only one of computer_ and primitive_computer_ is
+  // set by "Compile".
+  HRESULT (BinaryExpressionEvaluator::*primitive_computer_)(
+      const PrimitiveValue &arg1,
+      const PrimitiveValue &arg2,
+      PrimitiveValue *result) const;
+
+  // True if both operands are strings, which are compared by
+  // "EvaluateStringComparison".
+  bool compare_strings_;
+
+  // Content of the operands that are string literals, or null. They are
+  // owned by arg1_ and arg2_.
+  const std::string *string_literal1_;
+  const std::string *string_literal2_;
+
   // Statically computed resulting type of the expression. This is what
   // computer_ is supposed product.
   TypeSignature result_type_;
@@ -0,0 +1,637 @@
+/**
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "condition_program.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+#include "ccomptr.h"
+#include "compiler_helpers.h"
+#include "dbg_object.h"
+#include "i_dbg_stack_frame.h"
+#include "primitive_value.h"
+
+namespace google_cloud_debugger {
+
+namespace {
+
+typedef ConditionProgram::Value Value;
+
+// Returns the member of value that holds a numeric T.
+template <typename T>
+T *Slot(Value *value);
+
+template <>
+int32_t *Slot<int32_t>(Value *value) { return &value->int32; }
+
+template <>
+uint32_t *Slot<uint32_t>(Value *value) { return &value->uint32; }
+
+template <>
+int64_t *Slot<int64_t>(Value *value) { return &value->int64; }
+
+template <>
+uint64_t *Slot<uint64_t>(Value *value) { return &value->uint64; }
+
+template <>
+float_t *Slot<float_t>(Value *value) { return &value->float32; }
+
+template <>
+double_t *Slot<double_t>(Value *value) { return &value->float64; }
+
+// Reads value, which holds a type, as a T.
+template <typename T>
+T ReadAs(const CorElementType &type, Value *value) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      return static_cast<T>(value->boolean);
+    case CorElementType::ELEMENT_TYPE_I4:
+      return static_cast<T>(value->int32);
+    case CorElementType::ELEMENT_TYPE_U4:
+      return static_cast<T>(value->uint32);
+    case CorElementType::ELEMENT_TYPE_I8:
+      return static_cast<T>(value->int64);
+    case CorElementType::ELEMENT_TYPE_U8:
+      return static_cast<T>(value->uint64);
+    case CorElementType::ELEMENT_TYPE_R4:
+      return static_cast<T>(value->float32);
+    default:
+      return static_cast<T>(value->float64);
+  }
+}
+
+// Stores the value of primitive dbg_object converted to type in value.
+HRESULT ExtractValue(DbgObject *dbg_object, const CorElementType &type,
+                     Value *value) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      return NumericCompilerHelper::ExtractPrimitiveValue<bool>(
+          dbg_object, &value->boolean);
+    case CorElementType::ELEMENT_TYPE_I4:
+      return NumericCompilerHelper::ExtractPrimitiveValue<int32_t>(
+          dbg_object, &value->int32);
+    case CorElementType::ELEMENT_TYPE_U4:
+      return NumericCompilerHelper::ExtractPrimitiveValue<uint32_t>(
+          dbg_object, &value->uint32);
+    case CorElementType::ELEMENT_TYPE_I8:
+      return NumericCompilerHelper::ExtractPrimitiveValue<int64_t>(
+          dbg_object, &value->int64);
+    case CorElementType::ELEMENT_TYPE_U8:
+      return NumericCompilerHelper::ExtractPrimitiveValue<uint64_t>(
+          dbg_object, &value->uint64);
+    case CorElementType::ELEMENT_TYPE_R4:
+      return NumericCompilerHelper::ExtractPrimitiveValue<float_t>(
+          dbg_object, &value->float32);
+    case CorElementType::ELEMENT_TYPE_R8:
+      return NumericCompilerHelper::ExtractPrimitiveValue<double_t>(
+          dbg_object, &value->float64);
+    default:
+      return E_FAIL;
+  }
+}
+
+// Stores primitive converted to type in value.
+HRESULT StoreValue(const PrimitiveValue &primitive, const CorElementType &type,
+                   Value *value) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      return primitive.Get(&value->boolean);
+    case CorElementType::ELEMENT_TYPE_I4:
+      return primitive.Get(&value->int32);
+    case CorElementType::ELEMENT_TYPE_U4:
+      return primitive.Get(&value->uint32);
+    case CorElementType::ELEMENT_TYPE_I8:
+      return primitive.Get(&value->int64);
+    case CorElementType::ELEMENT_TYPE_U8:
+      return primitive.Get(&value->uint64);
+    case CorElementType::ELEMENT_TYPE_R4:
+      return primitive.Get(&value->float32);
+    case CorElementType::ELEMENT_TYPE_R8:
+      return primitive.Get(&value->float64);
+    default:
+      return E_FAIL;
+  }
+}
+
+// Reads the T held by generic_value into primitive.
+template <typename T>
+HRESULT ReadGenericPrimitive(ICorDebugGenericValue *generic_value,
+                             PrimitiveValue *primitive) {
+  ULONG32 size = 0;
+  HRESULT hr = generic_value->GetSize(&size);
+  if (FAILED(hr)) {
+    return hr;
+  }
+  if (size != sizeof(T)) {
+    return E_FAIL;
+  }
+
+  T raw_value;
+  hr = generic_value->GetValue(&raw_value);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  primitive->Set(raw_value);
+  return S_OK;
+}
+
+// Stores debug_value, which has to be a primitive of variable_type,
+// converted to type in value.
+HRESULT ReadGenericValue(ICorDebugValue *debug_value,
+                         const CorElementType &variable_type,
+                         const CorElementType &type, Value *value) {
+  CorElementType value_type;
+  HRESULT hr = debug_value->GetType(&value_type);
+  if (FAILED(hr)) {
+    return hr;
+  }
+  if (value_type != variable_type) {
+    return E_FAIL;
+  }
+
+  CComPtr<ICorDebugGenericValue> generic_value;
+  hr = debug_value->QueryInterface(__uuidof(ICorDebugGenericValue),
+                                   reinterpret_cast<void **>(&generic_value));
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  PrimitiveValue primitive;
+  switch (variable_type) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+      hr = ReadGenericPrimitive<bool>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_I1:
+      hr = ReadGenericPrimitive<int8_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_U1:
+      hr = ReadGenericPrimitive<uint8_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_I2:
+      hr = ReadGenericPrimitive<int16_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_U2:
+      hr = ReadGenericPrimitive<uint16_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_I4:
+      hr = ReadGenericPrimitive<int32_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_U4:
+      hr = ReadGenericPrimitive<uint32_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_I8:
+      hr = ReadGenericPrimitive<int64_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_U8:
+      hr = ReadGenericPrimitive<uint64_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_R4:
+      hr = ReadGenericPrimitive<float_t>(generic_value, &primitive);
+      break;
+    case CorElementType::ELEMENT_TYPE_R8:
+      hr = ReadGenericPrimitive<double_t>(generic_value, &primitive);
+      break;
+    default:
+      // Chars and pointer sized integers are left to DbgObject.
+      return E_FAIL;
+  }
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  return StoreValue(primitive, type, value);
+}
+
+// Returns true if a value of source_type can be converted to target_type.
+// Booleans only convert to booleans and numbers only to numbers.
+bool IsConvertible(const CorElementType &source_type,
+                   const CorElementType &target_type) {
+  bool source_boolean = source_type == CorElementType::ELEMENT_TYPE_BOOLEAN;
+  bool target_boolean = target_type == CorElementType::ELEMENT_TYPE_BOOLEAN;
+  if (source_boolean || target_boolean) {
+    return source_boolean && target_boolean;
+  }
+
+  return TypeCompilerHelper::IsNumericalType(source_type) &&
+         TypeCompilerHelper::IsNumericalType(target_type);
+}
+
+// Implementation of C# modulo (%) operator.
+template <typename T>
+T Modulo(T x, T y) {
+  return x % y;
+}
+
+template <>
+float_t Modulo<float_t>(float_t x, float_t y) {
+  return std::fmod(x, y);
+}
+
+template <>
+double_t Modulo<double_t>(double_t x, double_t y) {
+  return std::fmod(x, y);
+}
+
+// Returns true if dividing x by y would raise a signal: integral
+// division by zero or the minimum signed value divided by -1.
+template <typename T>
+bool IsInvalidDivision(T x, T y) {
+  if (!std::is_integral<T>::value) {
+    return false;
+  }
+
+  if (y == 0) {
+    return true;
+  }
+
+  return std::is_signed<T>::value && x == std::numeric_limits<T>::min() &&
+         y == static_cast<T>(-1);
+}
+
+// Computes numeric operation op on dest and operand, which hold T.
+template <typename T>
+HRESULT ComputeNumeric(ConditionProgram::OpCode op,
+                       const CorElementType &source_type, Value *dest,
+                       Value *operand) {
+  typedef ConditionProgram::OpCode OpCode;
+  T *result = Slot<T>(dest);
+  if (op == OpCode::kConvert) {
+    *result = ReadAs<T>(source_type, dest);
+    return S_OK;
+  }
+
+  if (op == OpCode::kNegate) {
+    *result = -*result;
+    return S_OK;
+  }
+
+  T value1 = *result;
+  T value2 = *Slot<T>(operand);
+  switch (op) {
+    case OpCode::kAdd:
+      *result = value1 + value2;
+      return S_OK;
+    case OpCode::kSub:
+      *result = value1 - value2;
+      return S_OK;
+    case OpCode::kMul:
+      *result = value1 * value2;
+      return S_OK;
+    case OpCode::kDiv:
+    case OpCode::kMod:
+      if (IsInvalidDivision(value1, value2)) {
+        return E_INVALIDARG;
+      }
+
+      *result = op == OpCode::kDiv ? value1 / value2 : Modulo(value1, value2);
+      return S_OK;
+    case OpCode::kEq:
+      dest->boolean = value1 == value2;
+      return S_OK;
+    case OpCode::kNe:
+      dest->boolean = value1 != value2;
+      return S_OK;
+    case OpCode::kLt:
+      dest->boolean = value1 < value2;
+      return S_OK;
+    case OpCode::kLe:
+      dest->boolean = value1 <= value2;
+      return S_OK;
+    case OpCode::kGt:
+      dest->boolean = value1 > value2;
+      return S_OK;
+    case OpCode::kGe:
+      dest->boolean = value1 >= value2;
+      return S_OK;
+    default:
+      return E_NOTIMPL;
+  }
+}
+
+// Computes boolean operation op on dest and operand.
+HRESULT ComputeBoolean(ConditionProgram::OpCode op, Value *dest,
+                       Value *operand) {
+  typedef ConditionProgram::OpCode OpCode;
+  switch (op) {
+    case OpCode::kConvert:
+      return S_OK;
+    case OpCode::kNot:
+      dest->boolean = !dest->boolean;
+      return S_OK;
+    case OpCode::kAnd:
+      dest->boolean = dest->boolean && operand->boolean;
+      return S_OK;
+    case OpCode::kOr:
+      dest->boolean = dest->boolean || operand->boolean;
+      return S_OK;
+    case OpCode::kEq:
+      dest->boolean = dest->boolean == operand->boolean;
+      return S_OK;
+    case OpCode::kNe:
+      dest->boolean = dest->boolean != operand->boolean;
+      return S_OK;
+    default:
+      return E_NOTIMPL;
+  }
+}
+
+}  // namespace
+
+int ConditionProgram::AllocateRegister() {
+  if (registers_ >= kMaxRegisters) {
+    return -1;
+  }
+
+  return registers_++;
+}
+
+bool ConditionProgram::EmitConstant(DbgObject *literal,
+                                    const CorElementType &type, int dest) {
+  if (!literal || !IsRegister(dest) || !IsSupportedType(type) ||
+      !IsConvertible(literal->GetCorElementType(), type)) {
+    return false;
+  }
+
+  Value value;
+  if (FAILED(ExtractValue(literal, type, &value))) {
+    return false;
+  }
+
+  constants_.push_back(value);
+  instructions_.push_back({OpCode::kLoadConstant, type, type, dest,
+                           static_cast<int>(constants_.size() - 1)});
+  return true;
+}
+
+bool ConditionProgram::EmitVariable(const std::string &name,
+                                    const CorElementType &variable_type,
+                                    const CorElementType &type, int dest,
+                                    const VariableSlot &slot) {
+  if (!IsRegister(dest) || !IsSupportedType(type) ||
+      !IsConvertible(variable_type, type)) {
+    return false;
+  }
+
+  variables_.push_back({name, slot, variable_type});
+  instructions_.push_back({OpCode::kLoadVariable, type, variable_type, dest,
+                           static_cast<int>(variables_.size() - 1)});
+  return true;
+}
+
+bool ConditionProgram::EmitConvert(const CorElementType &source_type,
+                                   const CorElementType &type, int dest) {
+  if (!IsRegister(dest) || !IsSupportedType(source_type) ||
+      !IsSupportedType(type) || !IsConvertible(source_type, type)) {
+    return false;
+  }
+
+  if (source_type != type) {
+    instructions_.push_back({OpCode::kConvert, type, source_type, dest, 0});
+  }
+  return true;
+}
+
+bool ConditionProgram::EmitOperation(OpCode op, const CorElementType &type,
+                                     int dest, int operand) {
+  bool unary = op == OpCode::kNot || op == OpCode::kNegate;
+  if (!IsRegister(dest) || (!unary && !IsRegister(operand)) ||
+      !IsSupportedType(type)) {
+    return false;
+  }
+
+  bool boolean = type == CorElementType::ELEMENT_TYPE_BOOLEAN;
+  switch (op) {
+    case OpCode::kAdd:
+    case OpCode::kSub:
+    case OpCode::kMul:
+    case OpCode::kDiv:
+    case OpCode::kMod:
+    case OpCode::kLt:
+    case OpCode::kLe:
+    case OpCode::kGt:
+    case OpCode::kGe:
+    case OpCode::kNegate:
+      if (boolean) {
+        return false;
+      }
+      break;
+    case OpCode::kAnd:
+    case OpCode::kOr:
+    case OpCode::kNot:
+      if (!boolean) {
+        return false;
+      }
+      break;
+    case OpCode::kEq:
+    case OpCode::kNe:
+      break;
+    default:
+      return false;
+  }
+
+  instructions_.push_back({op, type, type, dest, unary ? 0 : operand});
+  return true;
+}
+
+int ConditionProgram::EmitJump(OpCode op, int condition) {
+  if (!IsRegister(condition) ||
+      (op != OpCode::kJumpIfFalse && op != OpCode::kJumpIfTrue)) {
+    return -1;
+  }
+
+  instructions_.push_back({op, CorElementType::ELEMENT_TYPE_BOOLEAN,
+                           CorElementType::ELEMENT_TYPE_BOOLEAN, condition,
+                           0});
+  return instructions_.size() - 1;
+}
+
+void ConditionProgram::PatchJump(int jump) {
+  if (jump >= 0 && static_cast<size_t>(jump) < instructions_.size()) {
+    instructions_[jump].operand = instructions_.size();
+  }
+}
+
+template <typename LoadVariable>
+HRESULT ConditionProgram::Execute(const LoadVariable &load_variable,
+                                  bool *result) const {
+  if (!result || registers_ == 0) {
+    return E_INVALIDARG;
+  }
+
+  Value registers[kMaxRegisters];
+  size_t next = 0;
+  while (next < instructions_.size()) {
+    const Instruction &instruction = instructions_[next++];
+    Value *dest = &registers[instruction.dest];
+    HRESULT hr = S_OK;
+    switch (instruction.op) {
+      case OpCode::kLoadConstant:
+        *dest = constants_[instruction.operand];
+        break;
+      case OpCode::kLoadVariable:
+        hr = load_variable(variables_[instruction.operand], instruction.type,
+                           dest);
+        break;
+      case OpCode::kJumpIfFalse:
+        if (!dest->boolean) {
+          next = instruction.operand;
+        }
+        break;
+      case OpCode::kJumpIfTrue:
+        if (dest->boolean) {
+          next = instruction.operand;
+        }
+        break;
+      default: {
+        Value *operand = &registers[instruction.operand];
+        switch (instruction.type) {
+          case CorElementType::ELEMENT_TYPE_BOOLEAN:
+            hr = ComputeBoolean(instruction.op, dest, operand);
+            break;
+          case CorElementType::ELEMENT_TYPE_I4:
+            hr = ComputeNumeric<int32_t>(instruction.op,
+                                         instruction.source_type, dest,
+                                         operand);
+            break;
+          case CorElementType::ELEMENT_TYPE_U4:
+            hr = ComputeNumeric<uint32_t>(instruction.op,
+                                          instruction.source_type, dest,
+                                          operand);
+            break;
+          case CorElementType::ELEMENT_TYPE_I8:
+            hr = ComputeNumeric<int64_t>(instruction.op,
+                                         instruction.source_type, dest,
+                                         operand);
+            break;
+          case CorElementType::ELEMENT_TYPE_U8:
+            hr = ComputeNumeric<uint64_t>(instruction.op,
+                                          instruction.source_type, dest,
+                                          operand);
+            break;
+          case CorElementType::ELEMENT_TYPE_R4:
+            hr = ComputeNumeric<float_t>(instruction.op,
+                                         instruction.source_type, dest,
+                                         operand);
+            break;
+          default:
+            hr = ComputeNumeric<double_t>(instruction.op,
+                                          instruction.source_type, dest,
+                                          operand);
+            break;
+        }
+      }
+    }
+
+    if (FAILED(hr)) {
+      return hr;
+    }
+  }
+
+  *result = registers[0].boolean;
+  return S_OK;
+}
+
+HRESULT ConditionProgram::Run(IDbgStackFrame *stack_frame,
+                              bool *result) const {
+  if (!stack_frame) {
+    return E_INVALIDARG;
+  }
+
+  return Execute(
+      [stack_frame](const Variable &variable, const CorElementType &type,
+                    Value *value) -> HRESULT {
+        // The evaluators report the error if the variable is missing.
+        std::ostringstream err_stream;
+        std::shared_ptr<DbgObject> variable_object;
+        HRESULT hr;
+        if (variable.slot.kind != VariableSlot::Kind::kNone) {
+          hr = stack_frame->GetLocalVariableBySlot(variable.slot,
+                                                   &variable_object);
+        } else {
+          hr = stack_frame->GetLocalVariable(variable.name, &variable_object,
+                                             &err_stream);
+        }
+        if (hr != S_OK || !variable_object ||
+            variable_object->GetCorElementType() != variable.type) {
+          return E_FAIL;
+        }
+
+        return ExtractValue(variable_object.get(), type, value);
+      },
+      result);
+}
+
+bool ConditionProgram::CanRunOnFrame() const {
+  for (const Variable &variable : variables_) {
+    if (variable.slot.kind == VariableSlot::Kind::kNone) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+HRESULT ConditionProgram::RunOnFrame(ICorDebugILFrame *il_frame,
+                                     bool *result) const {
+  if (!il_frame) {
+    return E_INVALIDARG;
+  }
+
+  return Execute(
+      [il_frame](const Variable &variable, const CorElementType &type,
+                 Value *value) -> HRESULT {
+        CComPtr<ICorDebugValue> debug_value;
+        HRESULT hr;
+        switch (variable.slot.kind) {
+          case VariableSlot::Kind::kLocalVariable:
+            hr = il_frame->GetLocalVariable(variable.slot.index,
+                                            &debug_value);
+            break;
+          case VariableSlot::Kind::kMethodArgument:
+            hr = il_frame->GetArgument(variable.slot.index, &debug_value);
+            break;
+          default:
+            return E_FAIL;
+        }
+        if (FAILED(hr)) {
+          return hr;
+        }
+
+        return ReadGenericValue(debug_value, variable.type, type, value);
+      },
+      result);
+}
+
+bool ConditionProgram::IsSupportedType(const CorElementType &type) {
+  switch (type) {
+    case CorElementType::ELEMENT_TYPE_BOOLEAN:
+    case CorElementType::ELEMENT_TYPE_I4:
+    case CorElementType::ELEMENT_TYPE_U4:
+    case CorElementType::ELEMENT_TYPE_I8:
+    case CorElementType::ELEMENT_TYPE_U8:
+    case CorElementType::ELEMENT_TYPE_R4:
+    case CorElementType::ELEMENT_TYPE_R8:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,190 @@
+/**
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONDITION_PROGRAM_H_
+#define CONDITION_PROGRAM_H_
+
+#include <string>
+#include <vector>
+
+#include "common_headers.h"
+#include "variable_slot.h"
+
+namespace google_cloud_debugger {
+
+class DbgObject;
+class IDbgStackFrame;
+
+// Register based bytecode for conditions made of primitive local
+// variables, literals and numeric or boolean operators, for example
+// "userId == 42 && retries > 3". The operand types are fixed when the
+// program is built from compiled evaluators (see ExpressionEvaluator::Lower),
+// so running it only reads the variables and computes on typed registers
+// without creating a DbgObject for every subexpression.
+//
+// Registers and instructions are emitted by the evaluators. The value of
+// the condition is left in the first register allocated.
+class ConditionProgram {
+ public:
+  // Maximum number of registers a program can use.
+  static const int kMaxRegisters = 16;
+
+  // Operations of the instructions. Unless noted otherwise, an operation
+  // reads and writes registers of the type of the instruction.
+  enum class OpCode {
+    // dest = constants_[operand].
+    kLoadConstant,
+    // dest = variables_[operand] converted to the type of the instruction.
+    kLoadVariable,
+    // dest = dest converted from source_type.
+    kConvert,
+    // dest = dest op register operand.
+    kAdd,
+    kSub,
+    kMul,
+    kDiv,
+    kMod,
+    // dest = dest op register operand. dest becomes a boolean.
+    kEq,
+    kNe,
+    kLt,
+    kLe,
+    kGt,
+    kGe,
+    // dest = dest op register operand on booleans.
+    kAnd,
+    kOr,
+    // dest = op dest.
+    kNot,
+    kNegate,
+    // Jumps to instruction operand if boolean dest is false or true.
+    kJumpIfFalse,
+    kJumpIfTrue
+  };
+
+  // Allocates a register. Returns -1 if all of them are used.
+  int AllocateRegister();
+
+  // Emits an instruction that loads literal converted to type into dest.
+  // Returns false if literal is not a primitive that can be converted.
+  bool EmitConstant(DbgObject *literal, const CorElementType &type,
+                    int dest);
+
+  // Emits an instruction that loads local variable name, which has type
+  // variable_type, converted to type into dest. Returns false if the
+  // variable is not a primitive that can be converted. If slot is set, the
+  // variable is read from that slot instead of being looked up by name.
+  bool EmitVariable(const std::string &name,
+                    const CorElementType &variable_type,
+                    const CorElementType &type, int dest,
+                    const VariableSlot &slot = VariableSlot());
+
+  // Emits an instruction that converts dest from source_type to type.
+  // Emits nothing if the types are the same.
+  bool EmitConvert(const CorElementType &source_type,
+                   const CorElementType &type, int dest);
+
+  // Emits operation op on operands of type type in registers dest and
+  // operand (which is ignored by unary operations).
+  bool EmitOperation(OpCode op, const CorElementType &type, int dest,
+                     int operand);
+
+  // Emits a jump of kind op that is taken depending on boolean register
+  // condition. Returns the index of the jump for PatchJump, or -1.
+  int EmitJump(OpCode op, int condition);
+
+  // Makes jump go to the next instruction emitted.
+  void PatchJump(int jump);
+
+  // Runs the program with the variables of stack_frame and stores the
+  // value of the condition in result. Returns a failed HRESULT if a
+  // variable does not have the type the program was built for or the
+  // computation fails (for example, division by zero), in which case
+  // the caller should evaluate the condition with the evaluators instead.
+  HRESULT Run(IDbgStackFrame *stack_frame, bool *result) const;
+
+  // Returns true if every variable of the program has a slot, so that it
+  // can be run with RunOnFrame.
+  bool CanRunOnFrame() const;
+
+  // Runs the program like Run, but reads the variables straight from the
+  // values at their slots in il_frame, without a stack frame or a
+  // DbgObject for any of them. Returns a failed HRESULT like Run does,
+  // and if a variable is not a primitive of the type the program was
+  // built for.
+  HRESULT RunOnFrame(ICorDebugILFrame *il_frame, bool *result) const;
+
+  // Value of a register or a constant.
+  union Value {
+    bool boolean;
+    int32_t int32;
+    uint32_t uint32;
+    int64_t int64;
+    uint64_t uint64;
+    float_t float32;
+    double_t float64;
+  };
+
+ private:
+  struct Instruction {
+    OpCode op;
+
+    // Type of the operands of the operation.
+    CorElementType type;
+
+    // Type converted from by kConvert.
+    CorElementType source_type;
+
+    // Register the result is written to.
+    int dest;
+
+    // Register, constant, variable or instruction index, depending on op.
+    int operand;
+  };
+
+  // Local variable read by the program.
+  struct Variable {
+    std::string name;
+
+    // Slot of the variable, if it has one.
+    VariableSlot slot;
+
+    // Type of the variable when the program was built.
+    CorElementType type;
+  };
+
+  // Runs the program. load_variable(variable, type, value) stores the
+  // value of variable converted to type in value.
+  template <typename LoadVariable>
+  HRESULT Execute(const LoadVariable &load_variable, bool *result) const;
+
+  // Returns true if the program can have registers of type.
+  static bool IsSupportedType(const CorElementType &type);
+
+  // Returns true if register is allocated.
+  bool IsRegister(int reg) const { return reg >= 0 && reg < registers_; }
+
+  std::vector<Instruction> instructions_;
+  std::vector<Value> constants_;
+  std::vector<Variable> variables_;
+
+  // Number of registers allocated.
+  int registers_ = 0;
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // CONDITION_PROGRAM_H_
@@ -54,6 +54,11 @@ class ConditionalOperatorEvaluator : public ExpressionEvaluator {
       IDbgObjectFactory *obj_factory,
       std::ostream *err_stream) const override;
 
+  bool IsStaticOnly() const override {
+    return condition_->IsStaticOnly() && if_true_->IsStaticOnly() &&
+           if_false_->IsStaticOnly();
+  }
+
  private:
   // Compiles the conditional operator if both "if_true_" and "if_false_"
   // are boolean. Returns false if arguments are of other types.
@@ -17,6 +17,7 @@
 #include "csharp_expression.h"
 
 #include <iomanip>
+#include <sstream>
 #include "array_expression_evaluator.h"
 #include "binary_expression_evaluator.h"
 #include "conditional_operator_evaluator.h"
@@ -25,9 +26,11 @@
 #include "identifier_evaluator.h"
 #include "literal_evaluator.h"
 #include "method_call_evaluator.h"
+#include "shared_expression_evaluator.h"
 #include "string_evaluator.h"
 #include "type_cast_operator_evaluator.h"
 #include "unary_expression_evaluator.h"
+#include "compiler_helpers.h"
 #include "dbg_primitive.h"
 #include "dbg_null_object.h"
 #include "cor_debug_helper.h"
@@ -201,6 +204,63 @@ static void PrintCharacter(std::ostream* os, char ch) {
 }
 
 
+// Returns the literal of "evaluator" if it is a literal of a numeric or
+// boolean type, otherwise null. Expressions made only of such literals can
+// be compiled and evaluated without a stack frame or the debuggee.
+static std::shared_ptr<DbgObject> GetPrimitiveConstant(
+    ExpressionEvaluator* evaluator) {
+  LiteralEvaluator* literal = dynamic_cast<LiteralEvaluator*>(evaluator);
+  if (literal == nullptr) {
+    return nullptr;
+  }
+
+  const CorElementType& type = literal->GetStaticType().cor_type;
+  if (type != CorElementType::ELEMENT_TYPE_BOOLEAN &&
+      !TypeCompilerHelper::IsNumericalType(type)) {
+    return nullptr;
+  }
+
+  return literal->GetLiteral();
+}
+
+
+// Returns the string literal of "evaluator", or null if it is not one.
+static const string* GetStringConstant(ExpressionEvaluator* evaluator) {
+  StringEvaluator* literal = dynamic_cast<StringEvaluator*>(evaluator);
+  if (literal == nullptr) {
+    return nullptr;
+  }
+
+  return &literal->GetStringContent();
+}
+
+
+// Returns a literal evaluator for "value".
+static CompiledExpression ConstantExpression(std::shared_ptr<DbgObject> value) {
+  return {
+    std::unique_ptr<ExpressionEvaluator>(new LiteralEvaluator(value))
+  };
+}
+
+
+// Compiles and evaluates "evaluator", whose operands are all primitive
+// constants, and returns a literal of its value. Returns "evaluator" as it
+// is if that fails, so that the error is reported when the expression is
+// compiled or evaluated at the breakpoint.
+static CompiledExpression FoldConstant(
+    std::unique_ptr<ExpressionEvaluator> evaluator) {
+  std::ostringstream err_stream;
+  std::shared_ptr<DbgObject> value;
+  if (FAILED(evaluator->Compile(nullptr, nullptr, &err_stream)) ||
+      FAILED(evaluator->Evaluate(&value, nullptr, nullptr, &err_stream)) ||
+      value == nullptr) {
+    return { std::move(evaluator) };
+  }
+
+  return ConstantExpression(value);
+}
+
+
 ConditionalCSharpExpression::ConditionalCSharpExpression(
     CSharpExpression* condition,
     CSharpExpression* if_true,
@@ -234,6 +294,19 @@ CompiledExpression ConditionalCSharpExpression::CreateEvaluator() {
     return comp_condition;
   }
 
+  // Only one branch of a constant condition can ever be taken.
+  std::shared_ptr<DbgObject> constant_condition =
+      GetPrimitiveConstant(comp_condition.evaluator.get());
+  bool condition_value;
+  if (constant_condition != nullptr &&
+      constant_condition->GetCorElementType() ==
+          CorElementType::ELEMENT_TYPE_BOOLEAN &&
+      SUCCEEDED(NumericCompilerHelper::ExtractPrimitiveValue<bool>(
+          constant_condition.get(), &condition_value))) {
+    return condition_value ? if_true_->CreateEvaluator()
+                           : if_false_->CreateEvaluator();
+  }
+
   CompiledExpression comp_if_true = if_true_->CreateEvaluator();
   if (comp_if_true.evaluator == nullptr) {
     return comp_if_true;
@@ -365,18 +438,61 @@ CompiledExpression BinaryCSharpExpression::CreateEvaluator() {
     return arg1;
   }
 
+  // The second operand is never evaluated if a constant first operand
+  // already decides the value of "&&" or "||".
+  std::shared_ptr<DbgObject> constant1 =
+      GetPrimitiveConstant(arg1.evaluator.get());
+  if (constant1 != nullptr &&
+      constant1->GetCorElementType() == CorElementType::ELEMENT_TYPE_BOOLEAN &&
+      (type_ == Type::conditional_and || type_ == Type::conditional_or)) {
+    bool value1;
+    if (SUCCEEDED(NumericCompilerHelper::ExtractPrimitiveValue<bool>(
+            constant1.get(), &value1)) &&
+        value1 == (type_ == Type::conditional_or)) {
+      return arg1;
+    }
+  }
+
   CompiledExpression arg2 = b_->CreateEvaluator();
   if (arg2.evaluator == nullptr) {
     return arg2;
   }
 
-  return {
-    std::unique_ptr<ExpressionEvaluator>(
-        new BinaryExpressionEvaluator(
-            type_,
-            std::move(arg1.evaluator),
-            std::move(arg2.evaluator)))
-  };
+  // Concatenation and comparison of string literals. Strings are only
+  // created in the debuggee when evaluated, so they are folded here.
+  const string* string1 = GetStringConstant(arg1.evaluator.get());
+  const string* string2 = GetStringConstant(arg2.evaluator.get());
+  if (string1 != nullptr && string2 != nullptr) {
+    switch (type_) {
+      case Type::add:
+        return {
+          std::unique_ptr<ExpressionEvaluator>(
+              new StringEvaluator(*string1 + *string2))
+        };
+
+      case Type::eq:
+      case Type::ne:
+        return ConstantExpression(std::shared_ptr<DbgObject>(
+            new DbgPrimitive<bool>((*string1 == *string2) ==
+                                   (type_ == Type::eq))));
+
+      default:
+        break;
+    }
+  }
+
+  bool is_constant = constant1 != nullptr &&
+                     GetPrimitiveConstant(arg2.evaluator.get()) != nullptr;
+  std::unique_ptr<ExpressionEvaluator> evaluator(
+      new BinaryExpressionEvaluator(
+          type_,
+          std::move(arg1.evaluator),
+          std::move(arg2.evaluator)));
+  if (is_constant) {
+    return FoldConstant(std::move(evaluator));
+  }
+
+  return { std::move(evaluator) };
 }
 
 
@@ -415,10 +531,14 @@ CompiledExpression UnaryCSharpExpression::CreateEvaluator() {
     return arg;
   }
 
-  return {
-    std::unique_ptr<ExpressionEvaluator>(
-        new UnaryExpressionEvaluator(type_, std::move(arg.evaluator)))
-  };
+  bool is_constant = GetPrimitiveConstant(arg.evaluator.get()) != nullptr;
+  std::unique_ptr<ExpressionEvaluator> evaluator(
+      new UnaryExpressionEvaluator(type_, std::move(arg.evaluator)));
+  if (is_constant) {
+    return FoldConstant(std::move(evaluator));
+  }
+
+  return { std::move(evaluator) };
 }
 
 
@@ -684,10 +804,15 @@ CompiledExpression TypeCastCSharpExpression::CreateEvaluator() {
     return arg;
   }
 
-  return {
-    std::unique_ptr<ExpressionEvaluator>(
-        new TypeCastOperatorEvaluator(std::move(arg.evaluator), type_))
-  };
+  // Casts between primitive types do not need the stack frame to compile.
+  bool is_constant = GetPrimitiveConstant(arg.evaluator.get()) != nullptr;
+  std::unique_ptr<ExpressionEvaluator> evaluator(
+      new TypeCastOperatorEvaluator(std::move(arg.evaluator), type_));
+  if (is_constant) {
+    return FoldConstant(std::move(evaluator));
+  }
+
+  return { std::move(evaluator) };
 }
 
 
@@ -746,14 +871,21 @@ CompiledExpression CSharpExpressionMemberSelector::CreateEvaluator() {
   }
 
   std::shared_ptr<ICorDebugHelper> debug_helper(new CorDebugHelper());
+  std::unique_ptr<ExpressionEvaluator> field_evaluator(
+      new FieldEvaluator(
+          std::move(source_evaluator.evaluator),
+          std::move(identifier_name),
+          std::move(possible_class_name),
+          member_,
+          std::move(debug_helper)));
+
+  // Member accesses are shared by the breakpoints at the same location.
+  // The verbose form tells apart expressions that print the same.
+  std::ostringstream key;
+  Print(&key, false);
   return {
     std::unique_ptr<ExpressionEvaluator>(
-        new FieldEvaluator(
-            std::move(source_evaluator.evaluator),
-            std::move(identifier_name),
-            std::move(possible_class_name),
-            std::move(member_),
-            std::move(debug_helper))),
+        new SharedExpressionEvaluator(key.str(), std::move(field_evaluator))),
   };
 }
 
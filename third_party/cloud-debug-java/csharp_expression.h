@@ -48,6 +48,8 @@ class CSharpExpression {
   // Compiles the expression into executable format. The caller owns the
   // returned instance. If a particular language feature is not yet supported,
   // the function returns null and prints description in "error_message".
+  // The expression is left intact, so this can be called again to create
+  // another evaluator.
   virtual CompiledExpression CreateEvaluator() = 0;
 };
 
@@ -20,9 +20,11 @@
 #include <memory>
 
 #include "common_headers.h"
+#include "primitive_value.h"
 
 namespace google_cloud_debugger {
 
+class ConditionProgram;
 class DbgObject;
 class IDbgStackFrame;
 class IEvalCoordinator;
@@ -64,6 +66,43 @@ class ExpressionEvaluator {
       IEvalCoordinator *eval_coordinator,
       IDbgObjectFactory *obj_factory,
       std::ostream *err_stream) const = 0;
+
+  // Evaluates the current value of the expression into "value", for
+  // expressions of primitive types. Evaluators of operators on numbers
+  // and booleans override it to compute their result from the values of
+  // their subexpressions without creating a DbgObject for any of them;
+  // their "Evaluate" only creates the DbgObject of the final value. The
+  // default implementation extracts the value of the result of "Evaluate".
+  virtual HRESULT EvaluatePrimitive(
+      PrimitiveValue *value,
+      IEvalCoordinator *eval_coordinator,
+      IDbgObjectFactory *obj_factory,
+      std::ostream *err_stream) const {
+    std::shared_ptr<DbgObject> dbg_object;
+    HRESULT hr = Evaluate(&dbg_object, eval_coordinator, obj_factory,
+                          err_stream);
+    if (FAILED(hr)) {
+      return hr;
+    }
+
+    return value->SetFromDbgObject(dbg_object.get());
+  }
+
+  // Lowers the compiled expression into "program", so that it can be
+  // evaluated again without this tree. The emitted instructions leave the
+  // value of the expression converted to "type" in register "dest".
+  // Returns false if "ConditionProgram" does not support the expression;
+  // "Evaluate" has to be used then. Has to be called after "Compile".
+  virtual bool Lower(ConditionProgram *program, const CorElementType &type,
+                     int dest) const {
+    return false;
+  }
+
+  // Returns true if the compiled expression only reads constants and
+  // static members, so that its value does not depend on the frame it is
+  // evaluated in and only changes when the debuggee changes those members.
+  // Method calls are never static-only. Has to be called after "Compile".
+  virtual bool IsStaticOnly() const { return false; }
 };
 
 }  // namespace google_cloud_debugger
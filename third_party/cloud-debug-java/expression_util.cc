@@ -23,18 +23,29 @@
 #include "csharp_expression.h"
 #include "dbg_stack_frame.h"
 #include "expression_evaluator.h"
+#include "recursive_descent_parser.h"
 
 using std::cerr;
 
 namespace google_cloud_debugger {
 
-CompiledExpression CompileExpression(const std::string& string_expression) {
+std::unique_ptr<CSharpExpression> ParseExpression(
+    const std::string& string_expression) {
   if (string_expression.size() > kMaxExpressionLength) {
     std::cerr << "Expression can't be compiled because it is too long: "
               << string_expression.size();
-    return {nullptr, string_expression};
+    return nullptr;
   }
 
+#ifdef GOOGLE_CLOUD_DEBUGGER_ANTLR_PARSER
+  return ParseExpressionWithAntlr(string_expression);
+#else
+  return RecursiveDescentParser::Parse(string_expression);
+#endif
+}
+
+std::unique_ptr<CSharpExpression> ParseExpressionWithAntlr(
+    const std::string& string_expression) {
   // Parse the expression.
   std::istringstream input_stream(string_expression);
   CSharpExpressionLexer lexer(input_stream);
@@ -50,7 +61,7 @@ CompiledExpression CompileExpression(const std::string& string_expression) {
     std::cerr << "Expression parsing failed" << std::endl
               << "Input: " << string_expression << std::endl
               << "Parser error: " << parser.errors()[0];
-    return {nullptr, string_expression};
+    return nullptr;
   }
 
   // Transform ANTLR AST into "CSharpExpression" tree.
@@ -62,7 +73,15 @@ CompiledExpression CompileExpression(const std::string& string_expression) {
     cerr << "Tree walking on parsed expression failed" << std::endl
          << "Input: " << string_expression << std::endl
          << "AST: " << parser.getAST()->toStringTree();
+  }
 
+  return expression;
+}
+
+CompiledExpression CompileExpression(const std::string& string_expression) {
+  std::unique_ptr<CSharpExpression> expression =
+      ParseExpression(string_expression);
+  if (expression == nullptr) {
     return {nullptr, string_expression};
   }
 
@@ -72,7 +91,8 @@ CompiledExpression CompileExpression(const std::string& string_expression) {
   if (compiled_expression.evaluator == nullptr) {
     cerr << "Expression not supported by the evaluator" << std::endl
          << "Input: " << string_expression << std::endl
-         << "AST: " << parser.getAST()->toStringTree();
+         << "Expression: ";
+    expression->Print(&cerr, false);
   }
 
   return compiled_expression;
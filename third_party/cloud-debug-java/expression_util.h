@@ -23,6 +23,7 @@
 
 namespace google_cloud_debugger {
 
+class CSharpExpression;
 class ExpressionEvaluator;
 class DbgStackFrame;
 
@@ -47,6 +48,20 @@ struct CompiledExpression {
 // semantically incorrect expression). In such cases, "error_message" is
 // populated with a human readable parameterized description of why the
 // expression could not be compiled.
+// Parses "string_expression" into a "CSharpExpression" tree. Returns null
+// if the expression can't be parsed. Evaluating the same expression again
+// only needs another "CreateEvaluator" call on the tree. Expressions are
+// parsed by RecursiveDescentParser, or by the ANTLR generated parser when
+// built with GOOGLE_CLOUD_DEBUGGER_ANTLR_PARSER.
+std::unique_ptr<CSharpExpression> ParseExpression(
+    const std::string& string_expression);
+
+// Parses "string_expression" with the ANTLR generated lexer, parser and
+// tree walker of csharp_expression.g. Unlike "ParseExpression", it does
+// not check the length of the expression.
+std::unique_ptr<CSharpExpression> ParseExpressionWithAntlr(
+    const std::string& string_expression);
+
 CompiledExpression CompileExpression(const std::string& string_expression);
 
 }  // namespace google_cloud_debugger
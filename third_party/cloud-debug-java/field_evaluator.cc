@@ -54,6 +54,7 @@ HRESULT FieldEvaluator::Compile(IDbgStackFrame *stack_frame,
 
   hr = CompileUsingClassName(stack_frame, debug_frame, err_stream);
   if (SUCCEEDED(hr)) {
+    compiled_using_instance_source_ = false;
     return hr;
   }
 
@@ -246,9 +247,12 @@ HRESULT FieldEvaluator::EvaluateNonStaticMember(
   }
 
   // We can directly get the field/non-auto property without function
-  // evaluation.
+  // evaluation. The token of the field was resolved by "Compile" from the
+  // static type of the source, so it is only looked up by name again if
+  // the object turns out to be of another class.
   if (class_property_ == nullptr) {
-    return reference_object->GetNonStaticField(field_name_, result_object);
+    return reference_object->GetNonStaticFieldByToken(
+        field_name_, debug_module_, class_token_, field_def_, result_object);
   }
 
   if (!eval_coordinator) {
@@ -279,6 +283,14 @@ HRESULT FieldEvaluator::EvaluateNonStaticMember(
   return S_OK;
 }
 
+bool FieldEvaluator::IsStaticOnly() const {
+  if (!compiled_using_instance_source_) {
+    return is_static_;
+  }
+
+  return instance_source_ && instance_source_->IsStaticOnly();
+}
+
 HRESULT FieldEvaluator::Evaluate(std::shared_ptr<DbgObject> *dbg_object,
                                  IEvalCoordinator *eval_coordinator,
                                  IDbgObjectFactory *obj_factory,
@@ -50,6 +50,11 @@ class FieldEvaluator : public ExpressionEvaluator {
                    IDbgObjectFactory *obj_factory,
                    std::ostream *err_stream) const override;
 
+  // Returns true if the field is a static member of a class named in the
+  // expression, or a member of an object computed by a static-only
+  // instance source.
+  bool IsStaticOnly() const override;
+
  private:
   // Tries to compile the subexpression instance_source
   // and then uses that to extract out information about field
@@ -105,8 +110,9 @@ class FieldEvaluator : public ExpressionEvaluator {
   // Name of the instance field to read.
   std::string field_name_;
 
-  // The metadata token associated with this field. Not applicable
-  // for non-autoimplemented property.
+  // The metadata token associated with this field (or the backing field
+  // of an auto-implemented property), resolved once by "Compile". Not
+  // applicable for non-autoimplemented property.
   mdFieldDef field_def_;
 
   // Statically computed resulting type of the expression. This is what
@@ -15,6 +15,7 @@
  */
 
 #include "identifier_evaluator.h"
+#include "condition_program.h"
 #include "i_dbg_stack_frame.h"
 #include "i_eval_coordinator.h"
 #include "dbg_object.h"
@@ -45,7 +46,14 @@ HRESULT IdentifierEvaluator::Compile(
   }
 
   // S_FALSE means there is no match.
+  is_local_variable_ = hr != S_FALSE;
   if (SUCCEEDED(hr) && hr != S_FALSE) {
+    // Binds the variable to its slot so the condition program does not
+    // look it up by name on every hit.
+    if (stack_frame->GetLocalVariableSlot(identifier_name_, &variable_slot_) !=
+        S_OK) {
+      variable_slot_ = VariableSlot();
+    }
     return identifier_object_->GetTypeSignature(&result_type_);
   }
 
@@ -89,6 +97,10 @@ HRESULT IdentifierEvaluator::Compile(
   return stack_frame->GetCurrentClassTypeParameters(&generic_class_types_);
 }
 
+bool IdentifierEvaluator::IsStaticOnly() const {
+  return class_property_ != nullptr && class_property_->IsStatic();
+}
+
 HRESULT IdentifierEvaluator::Evaluate(
     std::shared_ptr<DbgObject> *dbg_object,
     IEvalCoordinator *eval_coordinator,
@@ -143,4 +155,14 @@ HRESULT IdentifierEvaluator::Evaluate(
   return S_OK;
 }
 
+bool IdentifierEvaluator::Lower(ConditionProgram *program,
+                                const CorElementType &type, int dest) const {
+  if (!is_local_variable_ || class_property_ != nullptr) {
+    return false;
+  }
+
+  return program->EmitVariable(identifier_name_, result_type_.cor_type, type,
+                               dest, variable_slot_);
+}
+
 }  // namespace google_cloud_debugger
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "expression_evaluator.h"
+#include "variable_slot.h"
 
 namespace google_cloud_debugger {
 
@@ -45,12 +46,28 @@ class IdentifierEvaluator : public ExpressionEvaluator {
       IDbgObjectFactory *obj_factory,
       std::ostream *err_stream) const override;
 
+  // Lowers the identifier if it is a local variable or a method argument.
+  bool Lower(ConditionProgram *program, const CorElementType &type,
+             int dest) const override;
+
+  // Returns true if the identifier is a static property of the class of
+  // the frame. Fields are read from the frame without telling static ones
+  // apart, so they are never static-only.
+  bool IsStaticOnly() const override;
+
  private:
   // Name of the identifier (whether it is local variable or something else).
   std::string identifier_name_;
 
   std::shared_ptr<DbgObject> identifier_object_;
 
+  // True if the identifier was compiled as a local variable or a method
+  // argument.
+  bool is_local_variable_ = false;
+
+  // Slot of the local variable or method argument, if it has one.
+  VariableSlot variable_slot_;
+
   std::shared_ptr<DbgObject> this_object_;
 
   std::unique_ptr<DbgClassProperty> class_property_;
@@ -20,6 +20,7 @@
 #include "expression_evaluator.h"
 #include "dbg_object.h"
 #include "compiler_helpers.h"
+#include "condition_program.h"
 
 namespace google_cloud_debugger {
 
@@ -29,6 +30,7 @@ class LiteralEvaluator : public ExpressionEvaluator {
   explicit LiteralEvaluator(std::shared_ptr<DbgObject> literal_obj) {
     n_ = literal_obj;
     literal_obj->GetTypeSignature(&result_type_);
+    value_hr_ = value_.SetFromDbgObject(literal_obj.get());
   }
 
   virtual HRESULT Compile(
@@ -47,10 +49,32 @@ class LiteralEvaluator : public ExpressionEvaluator {
     return S_OK;
   }
 
+  HRESULT EvaluatePrimitive(PrimitiveValue *value,
+      IEvalCoordinator *eval_coordinator,
+      IDbgObjectFactory *obj_factory,
+      std::ostream *err_stream) const override {
+    *value = value_;
+    return value_hr_;
+  }
+
+  bool Lower(ConditionProgram *program, const CorElementType &type,
+             int dest) const override {
+    return program->EmitConstant(n_.get(), type, dest);
+  }
+
+  bool IsStaticOnly() const override { return true; }
+
+  // Returns the literal value.
+  std::shared_ptr<DbgObject> GetLiteral() const { return n_; }
+
  private:
   // Literal value associated with this leaf.
   std::shared_ptr<google_cloud_debugger::DbgObject> n_;
 
+  // The value of n_ if it is a primitive, or why it is not.
+  PrimitiveValue value_;
+  HRESULT value_hr_;
+
   // Statically computed resulting type of the expression.
   TypeSignature result_type_;
 
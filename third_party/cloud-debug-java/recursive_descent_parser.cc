@@ -0,0 +1,832 @@
+/**
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "recursive_descent_parser.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "messages.h"
+
+namespace google_cloud_debugger {
+
+namespace {
+
+// Number of precedence levels of binary operators.
+constexpr int kBinaryPrecedenceLevels = 10;
+
+bool IsDecDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsOctDigit(char c) { return c >= '0' && c <= '7'; }
+
+bool IsHexDigit(char c) {
+  return IsDecDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool IsIdentifierStart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '$' ||
+         c == '_';
+}
+
+bool IsIdentifierPart(char c) { return IsIdentifierStart(c) || IsDecDigit(c); }
+
+bool IsLongSuffix(char c) { return c == 'l' || c == 'L'; }
+
+bool IsFloatSuffix(char c) {
+  return c == 'd' || c == 'D' || c == 'f' || c == 'F';
+}
+
+}  // namespace
+
+constexpr int RecursiveDescentParser::kMaxTreeDepth;
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::Parse(
+    const std::string& expression) {
+  RecursiveDescentParser parser(expression);
+  if (!parser.Tokenize()) {
+    std::cerr << "Expression parsing failed" << std::endl
+              << "Input: " << expression << std::endl
+              << "Lexer error: " << parser.error_;
+    return nullptr;
+  }
+
+  // The AST of ANTLR has a STATEMENT node above the expression.
+  int height = 0;
+  std::unique_ptr<CSharpExpression> result = parser.ParseExpression(&height);
+  if (result && parser.Expect(TokenType::kEnd) && height >= kMaxTreeDepth) {
+    parser.SetError(ExpressionTreeTooDeep);
+  }
+
+  if (parser.error_) {
+    std::cerr << "Expression parsing failed" << std::endl
+              << "Input: " << expression << std::endl
+              << "Parser error: " << parser.error_;
+    return nullptr;
+  }
+
+  return result;
+}
+
+bool RecursiveDescentParser::Tokenize() {
+  const std::string& s = expression_;
+  size_t size = s.size();
+
+  // Characters outside of the vocabulary of csharp_expression.g are never
+  // valid, not even in literals or comments.
+  for (char c : s) {
+    if (static_cast<unsigned char>(c) < 3) {
+      SetError("Unexpected character");
+      return false;
+    }
+  }
+
+  // Returns the character at "i", or '\0' past the end.
+  auto at = [&s, size](size_t i) { return i < size ? s[i] : '\0'; };
+
+  tokens_.reserve(size / 2 + 1);
+  size_t i = 0;
+  while (i < size) {
+    char c = s[i];
+    size_t begin = i;
+    TokenType type = TokenType::kEnd;
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      ++i;
+      continue;
+    }
+
+    if (c == '/' && at(i + 1) == '*') {
+      size_t end = s.find("*/", i + 2);
+      if (end == std::string::npos) {
+        SetError("Unterminated comment");
+        return false;
+      }
+      i = end + 2;
+      continue;
+    }
+
+    if (c == '/' && at(i + 1) == '/') {
+      while (i < size && s[i] != '\r' && s[i] != '\n') {
+        ++i;
+      }
+      continue;
+    }
+
+    if (IsDecDigit(c) || c == '.') {
+      // The alternatives of NumericLiteral are tried in the order of the
+      // grammar, like its syntactic predicates.
+      size_t digits_end = i;
+      while (IsDecDigit(at(digits_end))) {
+        ++digits_end;
+      }
+
+      if (c == '0' && at(i + 1) == 'x') {
+        i += 2;
+        if (!IsHexDigit(at(i))) {
+          SetError("Invalid hex literal");
+          return false;
+        }
+        while (IsHexDigit(at(i))) {
+          ++i;
+        }
+        i += IsLongSuffix(at(i)) ? 1 : 0;
+        type = TokenType::kHexLiteral;
+      } else if (c == '0' && IsOctDigit(at(i + 1))) {
+        ++i;
+        while (IsOctDigit(at(i))) {
+          ++i;
+        }
+        i += IsLongSuffix(at(i)) ? 1 : 0;
+        type = TokenType::kOctLiteral;
+      } else if (at(digits_end) == '.' && IsDecDigit(at(digits_end + 1))) {
+        i = digits_end + 1;
+        while (IsDecDigit(at(i))) {
+          ++i;
+        }
+        i += IsFloatSuffix(at(i)) ? 1 : 0;
+        type = TokenType::kFloatLiteral;
+      } else if (digits_end > i && IsFloatSuffix(at(digits_end))) {
+        i = digits_end + 1;
+        type = TokenType::kFloatLiteral;
+      } else if (digits_end > i) {
+        i = digits_end;
+        i += IsLongSuffix(at(i)) ? 1 : 0;
+        type = TokenType::kDecLiteral;
+      } else {
+        ++i;
+        type = TokenType::kDot;
+      }
+    } else if (IsIdentifierStart(c)) {
+      while (IsIdentifierPart(at(i))) {
+        ++i;
+      }
+      type = TokenType::kIdentifier;
+      if (s.compare(begin, i - begin, "null") == 0) {
+        type = TokenType::kNull;
+      } else if (s.compare(begin, i - begin, "true") == 0) {
+        type = TokenType::kTrue;
+      } else if (s.compare(begin, i - begin, "false") == 0) {
+        type = TokenType::kFalse;
+      }
+    } else if (c == '\'') {
+      ++i;
+      if (at(i) == '\\') {
+        if (!ReadEscapeSequence(&i)) {
+          return false;
+        }
+      } else if (i < size && at(i) != '\'') {
+        ++i;
+      }
+      if (at(i) != '\'' || i == begin + 1) {
+        SetError("Invalid character literal");
+        return false;
+      }
+      tokens_.push_back({TokenType::kCharLiteral,
+                         static_cast<std::uint32_t>(begin + 1),
+                         static_cast<std::uint32_t>(i - begin - 1)});
+      ++i;
+      continue;
+    } else if (c == '"') {
+      ++i;
+      while (i < size && s[i] != '"') {
+        if (s[i] == '\\') {
+          if (!ReadEscapeSequence(&i)) {
+            return false;
+          }
+        } else {
+          ++i;
+        }
+      }
+      if (i == size) {
+        SetError("Unterminated string literal");
+        return false;
+      }
+      tokens_.push_back({TokenType::kStringLiteral,
+                         static_cast<std::uint32_t>(begin + 1),
+                         static_cast<std::uint32_t>(i - begin - 1)});
+      ++i;
+      continue;
+    } else {
+      char next = at(i + 1);
+      size_t length = 1;
+      switch (c) {
+        case '(':
+          type = TokenType::kLeftParen;
+          break;
+        case ')':
+          type = TokenType::kRightParen;
+          break;
+        case '[':
+          type = TokenType::kLeftBracket;
+          break;
+        case ']':
+          type = TokenType::kRightBracket;
+          break;
+        case ',':
+          type = TokenType::kComma;
+          break;
+        case '?':
+          type = TokenType::kQuestion;
+          break;
+        case ':':
+          type = TokenType::kColon;
+          break;
+        case '~':
+          type = TokenType::kTilde;
+          break;
+        case '+':
+          type = TokenType::kAdd;
+          break;
+        case '-':
+          type = TokenType::kSub;
+          break;
+        case '*':
+          type = TokenType::kMul;
+          break;
+        case '/':
+          type = TokenType::kDiv;
+          break;
+        case '%':
+          type = TokenType::kMod;
+          break;
+        case '^':
+          type = TokenType::kCaret;
+          break;
+        case '!':
+          type = next == '=' ? TokenType::kNotEqual : TokenType::kBang;
+          length = next == '=' ? 2 : 1;
+          break;
+        case '=':
+          if (next != '=') {
+            SetError("Assignments are not supported");
+            return false;
+          }
+          type = TokenType::kEqual;
+          length = 2;
+          break;
+        case '&':
+          type = next == '&' ? TokenType::kAnd : TokenType::kBitAnd;
+          length = next == '&' ? 2 : 1;
+          break;
+        case '|':
+          type = next == '|' ? TokenType::kOr : TokenType::kBitOr;
+          length = next == '|' ? 2 : 1;
+          break;
+        case '<':
+          if (next == '=') {
+            type = TokenType::kLessEqual;
+            length = 2;
+          } else if (next == '<') {
+            type = TokenType::kShiftLeft;
+            length = 2;
+          } else {
+            type = TokenType::kLess;
+          }
+          break;
+        case '>':
+          if (next == '=') {
+            type = TokenType::kGreaterEqual;
+            length = 2;
+          } else if (next == '>' && at(i + 2) == '>') {
+            type = TokenType::kShiftRightUnsigned;
+            length = 3;
+          } else if (next == '>') {
+            type = TokenType::kShiftRight;
+            length = 2;
+          } else {
+            type = TokenType::kGreater;
+          }
+          break;
+        default:
+          SetError("Unexpected character");
+          return false;
+      }
+      i += length;
+    }
+
+    tokens_.push_back({type, static_cast<std::uint32_t>(begin),
+                       static_cast<std::uint32_t>(i - begin)});
+  }
+
+  tokens_.push_back({TokenType::kEnd, static_cast<std::uint32_t>(size), 0});
+  return true;
+}
+
+bool RecursiveDescentParser::ReadEscapeSequence(size_t* position) {
+  const std::string& s = expression_;
+  size_t i = *position + 1;
+  char c = i < s.size() ? s[i] : '\0';
+  switch (c) {
+    case 'b':
+    case 't':
+    case 'n':
+    case 'f':
+    case 'r':
+    case '"':
+    case '\'':
+    case '\\':
+      *position = i + 1;
+      return true;
+    case 'u':
+      for (size_t digit = i + 1; digit < i + 5; ++digit) {
+        if (digit >= s.size() || !IsHexDigit(s[digit])) {
+          SetError("Invalid unicode escape sequence");
+          return false;
+        }
+      }
+      *position = i + 5;
+      return true;
+    default:
+      // The first alternative of OctalEscape always wins, so an octal
+      // escape is a single digit and the digits after it are characters.
+      if (IsOctDigit(c)) {
+        *position = i + 1;
+        return true;
+      }
+      SetError("Invalid escape sequence");
+      return false;
+  }
+}
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::ParseExpression(
+    int* height) {
+  if (++nesting_ > kMaxTreeDepth) {
+    SetError(ExpressionTreeTooDeep);
+    return nullptr;
+  }
+
+  int condition_height = 0;
+  std::unique_ptr<CSharpExpression> condition =
+      ParseBinary(0, &condition_height);
+  if (!condition || Peek().type != TokenType::kQuestion) {
+    --nesting_;
+    *height = condition_height;
+    return condition;
+  }
+
+  // The AST is #(QUESTION condition if_true COLON if_false).
+  Next();
+  int if_true_height = 0;
+  std::unique_ptr<CSharpExpression> if_true = ParseExpression(&if_true_height);
+  if (!if_true || !Expect(TokenType::kColon)) {
+    return nullptr;
+  }
+  int if_false_height = 0;
+  std::unique_ptr<CSharpExpression> if_false =
+      ParseExpression(&if_false_height);
+  if (!if_false) {
+    return nullptr;
+  }
+
+  --nesting_;
+  *height = 1 + std::max({condition_height, if_true_height, 1,
+                          if_false_height});
+  return std::unique_ptr<CSharpExpression>(new ConditionalCSharpExpression(
+      condition.release(), if_true.release(), if_false.release()));
+}
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::ParseBinary(
+    int precedence, int* height) {
+  if (precedence == kBinaryPrecedenceLevels) {
+    return ParseUnary(height);
+  }
+
+  std::unique_ptr<CSharpExpression> a = ParseBinary(precedence + 1, height);
+  while (a) {
+    // The precedence levels from conditionalOrExpression down to
+    // multiplicativeExpression.
+    BinaryCSharpExpression::Type type;
+    int operator_precedence = -1;
+    switch (Peek().type) {
+      case TokenType::kOr:
+        type = BinaryCSharpExpression::Type::conditional_or;
+        operator_precedence = 0;
+        break;
+      case TokenType::kAnd:
+        type = BinaryCSharpExpression::Type::conditional_and;
+        operator_precedence = 1;
+        break;
+      case TokenType::kBitOr:
+        type = BinaryCSharpExpression::Type::bitwise_or;
+        operator_precedence = 2;
+        break;
+      case TokenType::kCaret:
+        type = BinaryCSharpExpression::Type::bitwise_xor;
+        operator_precedence = 3;
+        break;
+      case TokenType::kBitAnd:
+        type = BinaryCSharpExpression::Type::bitwise_and;
+        operator_precedence = 4;
+        break;
+      case TokenType::kEqual:
+        type = BinaryCSharpExpression::Type::eq;
+        operator_precedence = 5;
+        break;
+      case TokenType::kNotEqual:
+        type = BinaryCSharpExpression::Type::ne;
+        operator_precedence = 5;
+        break;
+      case TokenType::kLessEqual:
+        type = BinaryCSharpExpression::Type::le;
+        operator_precedence = 6;
+        break;
+      case TokenType::kGreaterEqual:
+        type = BinaryCSharpExpression::Type::ge;
+        operator_precedence = 6;
+        break;
+      case TokenType::kLess:
+        type = BinaryCSharpExpression::Type::lt;
+        operator_precedence = 6;
+        break;
+      case TokenType::kGreater:
+        type = BinaryCSharpExpression::Type::gt;
+        operator_precedence = 6;
+        break;
+      case TokenType::kShiftLeft:
+        type = BinaryCSharpExpression::Type::shl;
+        operator_precedence = 7;
+        break;
+      case TokenType::kShiftRight:
+        type = BinaryCSharpExpression::Type::shr_s;
+        operator_precedence = 7;
+        break;
+      case TokenType::kShiftRightUnsigned:
+        type = BinaryCSharpExpression::Type::shr_u;
+        operator_precedence = 7;
+        break;
+      case TokenType::kAdd:
+        type = BinaryCSharpExpression::Type::add;
+        operator_precedence = 8;
+        break;
+      case TokenType::kSub:
+        type = BinaryCSharpExpression::Type::sub;
+        operator_precedence = 8;
+        break;
+      case TokenType::kMul:
+        type = BinaryCSharpExpression::Type::mul;
+        operator_precedence = 9;
+        break;
+      case TokenType::kDiv:
+        type = BinaryCSharpExpression::Type::div;
+        operator_precedence = 9;
+        break;
+      case TokenType::kMod:
+        type = BinaryCSharpExpression::Type::mod;
+        operator_precedence = 9;
+        break;
+      default:
+        break;
+    }
+    if (operator_precedence != precedence) {
+      break;
+    }
+
+    // The AST is #(BINARY_EXPRESSION a operator b).
+    Next();
+    int b_height = 0;
+    std::unique_ptr<CSharpExpression> b =
+        ParseBinary(precedence + 1, &b_height);
+    if (!b) {
+      return nullptr;
+    }
+    a.reset(new BinaryCSharpExpression(type, a.release(), b.release()));
+    *height = 1 + std::max(*height, b_height);
+  }
+
+  return a;
+}
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::ParseUnary(
+    int* height) {
+  UnaryCSharpExpression::Type type;
+  switch (Peek().type) {
+    case TokenType::kAdd:
+      type = UnaryCSharpExpression::Type::plus;
+      break;
+    case TokenType::kSub:
+      type = UnaryCSharpExpression::Type::minus;
+      break;
+    case TokenType::kTilde:
+      type = UnaryCSharpExpression::Type::bitwise_complement;
+      break;
+    case TokenType::kBang:
+      type = UnaryCSharpExpression::Type::logical_complement;
+      break;
+    default:
+      return ParseUnaryNotPlusMinus(height);
+  }
+
+  // The AST is #(UNARY_EXPRESSION operator a).
+  Next();
+  if (++nesting_ > kMaxTreeDepth) {
+    SetError(ExpressionTreeTooDeep);
+    return nullptr;
+  }
+  int a_height = 0;
+  std::unique_ptr<CSharpExpression> a = ParseUnary(&a_height);
+  if (!a) {
+    return nullptr;
+  }
+
+  --nesting_;
+  *height = 1 + a_height;
+  return std::unique_ptr<CSharpExpression>(
+      new UnaryCSharpExpression(type, a.release()));
+}
+
+std::unique_ptr<CSharpExpression>
+RecursiveDescentParser::ParseUnaryNotPlusMinus(int* height) {
+  if (Peek().type == TokenType::kTilde || Peek().type == TokenType::kBang) {
+    return ParseUnary(height);
+  }
+
+  if (IsCast()) {
+    return ParseCast(height);
+  }
+
+  std::unique_ptr<CSharpExpression> source = ParsePrimary(height);
+  while (source) {
+    std::unique_ptr<CSharpExpressionSelector> selector;
+    int selector_height = 0;
+    if (Peek().type == TokenType::kDot) {
+      // The AST is #(DOT_SELECTOR Identifier) or
+      // #(DOT_SELECTOR #(METHOD_CALL Identifier arguments)).
+      Next();
+      const Token& member = Peek();
+      if (!Expect(TokenType::kIdentifier)) {
+        return nullptr;
+      }
+      if (Peek().type == TokenType::kLeftParen) {
+        int arguments_height = 0;
+        MethodArguments* arguments = ParseArguments(&arguments_height);
+        if (!arguments) {
+          return nullptr;
+        }
+        selector.reset(new MethodCallExpression(GetText(member), arguments));
+        selector_height = 2 + std::max(1, arguments_height);
+      } else {
+        selector.reset(new CSharpExpressionMemberSelector(GetText(member)));
+        selector_height = 2;
+      }
+    } else if (Peek().type == TokenType::kLeftBracket) {
+      // The AST is #(LBRACK index RBRACK).
+      Next();
+      int index_height = 0;
+      std::unique_ptr<CSharpExpression> index = ParseExpression(&index_height);
+      if (!index || !Expect(TokenType::kRightBracket)) {
+        return nullptr;
+      }
+      selector.reset(new CSharpExpressionIndexSelector(index.release()));
+      selector_height = 1 + index_height;
+    } else {
+      break;
+    }
+
+    // The AST is #(PRIMARY_SELECTOR source selector).
+    selector->set_source(source.release());
+    source = std::move(selector);
+    *height = 1 + std::max(*height, selector_height);
+  }
+
+  return source;
+}
+
+bool RecursiveDescentParser::IsCast() const {
+  // "(" classOrInterfaceType ")" followed by what can start
+  // unaryExpressionNotPlusMinus. Nothing of that can follow a complete
+  // primary, so no backtracking is needed to tell a cast from an
+  // expression in parentheses.
+  size_t i = position_;
+  if (tokens_[i].type != TokenType::kLeftParen ||
+      tokens_[i + 1].type != TokenType::kIdentifier) {
+    return false;
+  }
+  i += 2;
+  while (tokens_[i].type == TokenType::kDot &&
+         tokens_[i + 1].type == TokenType::kIdentifier) {
+    i += 2;
+  }
+  if (tokens_[i].type != TokenType::kRightParen) {
+    return false;
+  }
+
+  switch (tokens_[i + 1].type) {
+    case TokenType::kTilde:
+    case TokenType::kBang:
+    case TokenType::kLeftParen:
+    case TokenType::kIdentifier:
+    case TokenType::kHexLiteral:
+    case TokenType::kOctLiteral:
+    case TokenType::kFloatLiteral:
+    case TokenType::kDecLiteral:
+    case TokenType::kCharLiteral:
+    case TokenType::kStringLiteral:
+    case TokenType::kTrue:
+    case TokenType::kFalse:
+    case TokenType::kNull:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::ParseCast(
+    int* height) {
+  // The AST is #(TYPE_CAST #(TYPE_NAME Identifier #(TYPE_NAME ...)) a).
+  Next();
+  std::string type = GetText(Next());
+  int type_height = 2;
+  while (Peek().type == TokenType::kDot) {
+    Next();
+    type += '.';
+    type += GetText(Next());
+    ++type_height;
+  }
+  Next();
+
+  if (++nesting_ > kMaxTreeDepth) {
+    SetError(ExpressionTreeTooDeep);
+    return nullptr;
+  }
+  int source_height = 0;
+  std::unique_ptr<CSharpExpression> source =
+      ParseUnaryNotPlusMinus(&source_height);
+  if (!source) {
+    return nullptr;
+  }
+
+  --nesting_;
+  *height = 1 + std::max(type_height, source_height);
+  return std::unique_ptr<CSharpExpression>(
+      new TypeCastCSharpExpression(type, source.release()));
+}
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::ParsePrimary(
+    int* height) {
+  const Token& token = Peek();
+  if (token.type == TokenType::kLeftParen) {
+    // The AST is #(PARENTHESES_EXPRESSION expression).
+    Next();
+    int expression_height = 0;
+    std::unique_ptr<CSharpExpression> expression =
+        ParseExpression(&expression_height);
+    if (!expression || !Expect(TokenType::kRightParen)) {
+      return nullptr;
+    }
+    *height = 1 + expression_height;
+    return expression;
+  }
+
+  if (token.type == TokenType::kIdentifier) {
+    Next();
+    if (Peek().type != TokenType::kLeftParen) {
+      *height = 1;
+      return std::unique_ptr<CSharpExpression>(
+          new CSharpIdentifier(GetText(token)));
+    }
+
+    // The AST is #(METHOD_CALL Identifier arguments).
+    int arguments_height = 0;
+    MethodArguments* arguments = ParseArguments(&arguments_height);
+    if (!arguments) {
+      return nullptr;
+    }
+    *height = 1 + std::max(1, arguments_height);
+    return std::unique_ptr<CSharpExpression>(
+        new MethodCallExpression(GetText(token), arguments));
+  }
+
+  *height = 1;
+  return ParseLiteral();
+}
+
+std::unique_ptr<CSharpExpression> RecursiveDescentParser::ParseLiteral() {
+  const Token& token = Peek();
+  if (token.type == TokenType::kEnd) {
+    SetError(ExpressionParserError);
+    return nullptr;
+  }
+
+  Next();
+  switch (token.type) {
+    case TokenType::kHexLiteral:
+    case TokenType::kOctLiteral:
+    case TokenType::kDecLiteral: {
+      int base = 10;
+      if (token.type == TokenType::kHexLiteral) {
+        base = 16;
+      } else if (token.type == TokenType::kOctLiteral) {
+        base = 8;
+      }
+      std::unique_ptr<CSharpIntLiteral> literal(new CSharpIntLiteral());
+      if (!literal->ParseString(GetText(token), base)) {
+        SetError(ExpressionParserError);
+        return nullptr;
+      }
+      return std::move(literal);
+    }
+
+    case TokenType::kFloatLiteral: {
+      std::unique_ptr<CSharpFloatLiteral> literal(new CSharpFloatLiteral());
+      if (!literal->ParseString(GetText(token))) {
+        SetError(ExpressionParserError);
+        return nullptr;
+      }
+      return std::move(literal);
+    }
+
+    case TokenType::kCharLiteral: {
+      std::unique_ptr<CSharpCharLiteral> literal(new CSharpCharLiteral());
+      if (!literal->ParseString(GetText(token))) {
+        SetError("Invalid character");
+        return nullptr;
+      }
+      return std::move(literal);
+    }
+
+    case TokenType::kStringLiteral: {
+      std::unique_ptr<CSharpStringLiteral> literal(new CSharpStringLiteral());
+      if (!literal->ParseString(GetText(token))) {
+        SetError("Invalid string");
+        return nullptr;
+      }
+      return std::move(literal);
+    }
+
+    case TokenType::kTrue:
+      return std::unique_ptr<CSharpExpression>(new CSharpBooleanLiteral(true));
+
+    case TokenType::kFalse:
+      return std::unique_ptr<CSharpExpression>(
+          new CSharpBooleanLiteral(false));
+
+    case TokenType::kNull:
+      return std::unique_ptr<CSharpExpression>(new CSharpNullLiteral());
+
+    default:
+      SetError(ExpressionParserError);
+      return nullptr;
+  }
+}
+
+MethodArguments* RecursiveDescentParser::ParseArguments(int* height) {
+  Next();
+  std::vector<std::unique_ptr<CSharpExpression>> arguments;
+  std::vector<int> heights;
+  while (Peek().type != TokenType::kRightParen) {
+    if (!arguments.empty() && !Expect(TokenType::kComma)) {
+      return nullptr;
+    }
+    int argument_height = 0;
+    std::unique_ptr<CSharpExpression> argument =
+        ParseExpression(&argument_height);
+    if (!argument) {
+      return nullptr;
+    }
+    arguments.push_back(std::move(argument));
+    heights.push_back(argument_height);
+  }
+  if (!Expect(TokenType::kRightParen)) {
+    return nullptr;
+  }
+
+  // The AST nests every argument in one more EXPRESSION_LIST:
+  // #(EXPRESSION_LIST a #(EXPRESSION_LIST b ...)).
+  MethodArguments* result = new MethodArguments();
+  *height = 0;
+  for (size_t i = arguments.size(); i > 0; --i) {
+    result = new MethodArguments(arguments[i - 1].release(), result);
+    *height = 1 + std::max(heights[i - 1], *height);
+  }
+  return result;
+}
+
+bool RecursiveDescentParser::Expect(TokenType type) {
+  if (Peek().type != type) {
+    SetError(ExpressionParserError);
+    return false;
+  }
+  Next();
+  return true;
+}
+
+void RecursiveDescentParser::SetError(const char* error) {
+  if (!error_) {
+    error_ = error;
+  }
+}
+
+}  // namespace google_cloud_debugger
@@ -0,0 +1,168 @@
+/**
+ * Copyright 2017 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RECURSIVE_DESCENT_PARSER_H_
+#define RECURSIVE_DESCENT_PARSER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "csharp_expression.h"
+
+namespace google_cloud_debugger {
+
+// Parses the expressions of csharp_expression.g into the same
+// "CSharpExpression" trees as the ANTLR generated CSharpExpressionLexer,
+// CSharpExpressionParser and CSharpExpressionCompiler, without building
+// an ANTLR AST in between. The tokens are kept as offsets into the
+// expression, so the only allocations are the nodes of the tree.
+//
+// It also rejects the expressions whose ANTLR AST would be deeper than
+// CSharpExpressionCompiler::kMaxTreeDepth. The intended differences are
+// that string literals like "null" stay strings, while the ANTLR lexer
+// turns them into the keyword of the same name, and that an unterminated
+// comment after a parenthesized name is an error, while the ANTLR parser
+// loses the lexer error when it guesses whether the name is a cast.
+class RecursiveDescentParser {
+ public:
+  // Same as CSharpExpressionCompiler::kMaxTreeDepth.
+  static constexpr int kMaxTreeDepth = 25;
+
+  // Parses "expression". Returns null and prints the reason to cerr if it
+  // is not valid.
+  static std::unique_ptr<CSharpExpression> Parse(const std::string& expression);
+
+ private:
+  // Kinds of tokens. Tokens of csharp_expression.g that no rule of the
+  // parser accepts, like "=" or ";", are reported as lexer errors.
+  enum class TokenType : std::uint8_t {
+    kEnd,
+    kIdentifier,
+    kHexLiteral,
+    kOctLiteral,
+    kFloatLiteral,
+    kDecLiteral,
+    kCharLiteral,
+    kStringLiteral,
+    kTrue,
+    kFalse,
+    kNull,
+    kDot,
+    kLeftParen,
+    kRightParen,
+    kLeftBracket,
+    kRightBracket,
+    kComma,
+    kQuestion,
+    kColon,
+    kTilde,
+    kBang,
+    kOr,
+    kAnd,
+    kBitOr,
+    kCaret,
+    kBitAnd,
+    kEqual,
+    kNotEqual,
+    kLessEqual,
+    kGreaterEqual,
+    kLess,
+    kGreater,
+    kShiftLeft,
+    kShiftRight,
+    kShiftRightUnsigned,
+    kAdd,
+    kSub,
+    kMul,
+    kDiv,
+    kMod
+  };
+
+  // A token is a range of the expression. The range of character and
+  // string literals excludes their quotes.
+  struct Token {
+    TokenType type;
+    std::uint32_t begin;
+    std::uint32_t length;
+  };
+
+  explicit RecursiveDescentParser(const std::string& expression)
+      : expression_(expression) {}
+
+  // Splits the expression into tokens_. Returns false on a lexer error.
+  bool Tokenize();
+
+  // Moves "*position" past the escape sequence at it. Returns false if
+  // the escape sequence is not valid.
+  bool ReadEscapeSequence(size_t* position);
+
+  // The rules of the parser. Each returns null on an error and sets
+  // "*height" to the height of the ANTLR AST the rule would build.
+  std::unique_ptr<CSharpExpression> ParseExpression(int* height);
+  std::unique_ptr<CSharpExpression> ParseBinary(int precedence, int* height);
+  std::unique_ptr<CSharpExpression> ParseUnary(int* height);
+  std::unique_ptr<CSharpExpression> ParseUnaryNotPlusMinus(int* height);
+  std::unique_ptr<CSharpExpression> ParseCast(int* height);
+  std::unique_ptr<CSharpExpression> ParsePrimary(int* height);
+  std::unique_ptr<CSharpExpression> ParseLiteral();
+  MethodArguments* ParseArguments(int* height);
+
+  // Returns true if the tokens from the current one are a type cast.
+  bool IsCast() const;
+
+  // Returns the current token.
+  const Token& Peek() const { return tokens_[position_]; }
+
+  // Returns the current token and moves to the next one.
+  const Token& Next() { return tokens_[position_++]; }
+
+  // Moves to the next token if the current one is of "type". Otherwise
+  // records an error and returns false.
+  bool Expect(TokenType type);
+
+  // Returns the text of "token".
+  std::string GetText(const Token& token) const {
+    return expression_.substr(token.begin, token.length);
+  }
+
+  // Records "error" unless an error was recorded before.
+  void SetError(const char* error);
+
+  // The expression being parsed.
+  const std::string& expression_;
+
+  // Tokens of the expression, ending with a kEnd token.
+  std::vector<Token> tokens_;
+
+  // Index of the current token.
+  size_t position_ = 0;
+
+  // Number of nested rules that add a level to the AST. Parsing stops
+  // once it exceeds kMaxTreeDepth, so that very deep expressions cannot
+  // overflow the stack.
+  int nesting_ = 0;
+
+  // The first error, or null.
+  const char* error_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(RecursiveDescentParser);
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // RECURSIVE_DESCENT_PARSER_H_
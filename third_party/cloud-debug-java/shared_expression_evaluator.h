@@ -0,0 +1,83 @@
+/**
+ * Copyright 2018 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARED_EXPRESSION_EVALUATOR_H_
+#define SHARED_EXPRESSION_EVALUATOR_H_
+
+#include "expression_evaluator.h"
+#include "i_eval_coordinator.h"
+
+namespace google_cloud_debugger {
+
+// Evaluates a subexpression once per breakpoint hit for all the
+// breakpoints at the location. The result of the wrapped evaluator is kept
+// by IEvalCoordinator under "key", the printed subexpression, so the
+// conditions and the expressions of other breakpoints that contain the
+// same subexpression reuse it. Since every breakpoint of a hit is
+// evaluated on the same frame, the same text has the same value unless
+// the debuggee changes it during a function evaluation.
+class SharedExpressionEvaluator : public ExpressionEvaluator {
+ public:
+  SharedExpressionEvaluator(std::string key,
+                            std::unique_ptr<ExpressionEvaluator> evaluator)
+      : key_(std::move(key)), evaluator_(std::move(evaluator)) {}
+
+  HRESULT Compile(IDbgStackFrame *stack_frame, ICorDebugILFrame *debug_frame,
+                  std::ostream *err_stream) override {
+    return evaluator_->Compile(stack_frame, debug_frame, err_stream);
+  }
+
+  const TypeSignature &GetStaticType() const override {
+    return evaluator_->GetStaticType();
+  }
+
+  HRESULT Evaluate(std::shared_ptr<DbgObject> *dbg_object,
+                   IEvalCoordinator *eval_coordinator,
+                   IDbgObjectFactory *obj_factory,
+                   std::ostream *err_stream) const override {
+    if (eval_coordinator &&
+        eval_coordinator->GetCachedExpressionValue(key_, dbg_object)) {
+      return S_OK;
+    }
+
+    HRESULT hr = evaluator_->Evaluate(dbg_object, eval_coordinator,
+                                      obj_factory, err_stream);
+    if (SUCCEEDED(hr) && eval_coordinator) {
+      eval_coordinator->CacheExpressionValue(key_, *dbg_object);
+    }
+    return hr;
+  }
+
+  bool Lower(ConditionProgram *program, const CorElementType &type,
+             int dest) const override {
+    return evaluator_->Lower(program, type, dest);
+  }
+
+  bool IsStaticOnly() const override { return evaluator_->IsStaticOnly(); }
+
+ private:
+  // The printed subexpression.
+  const std::string key_;
+
+  // Evaluator of the subexpression.
+  std::unique_ptr<ExpressionEvaluator> evaluator_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedExpressionEvaluator);
+};
+
+}  // namespace google_cloud_debugger
+
+#endif  // SHARED_EXPRESSION_EVALUATOR_H_
@@ -46,6 +46,11 @@ class StringEvaluator : public ExpressionEvaluator {
                    IDbgObjectFactory *obj_factory,
                    std::ostream *err_stream) const override;
 
+  bool IsStaticOnly() const override { return true; }
+
+  // Returns the content of the string literal.
+  const std::string &GetStringContent() const { return string_content_; }
+
  private:
   // The underlying string content.
   std::string string_content_;
@@ -54,6 +54,8 @@ class TypeCastOperatorEvaluator : public ExpressionEvaluator {
                    IDbgObjectFactory *obj_factory,
                    std::ostream *err_stream) const override;
 
+  bool IsStaticOnly() const override { return source_->IsStaticOnly(); }
+
  private:
   // Compiles type cast expression when both the source
   // and target are numeric types.
@@ -17,8 +17,8 @@
 #include "unary_expression_evaluator.h"
 
 #include "compiler_helpers.h"
+#include "condition_program.h"
 #include "dbg_object.h"
-#include "dbg_primitive.h"
 #include "error_messages.h"
 #include "type_signature.h"
 
@@ -81,16 +81,28 @@ HRESULT UnaryExpressionEvaluator::CompilePlusMinusOperators(
   // For + operator, we do nothing.
   // TODO(quoct): Add support for Decimal.
   if (is_plus) {
-    if (cor_type == CorElementType::ELEMENT_TYPE_I4 ||
-        cor_type == CorElementType::ELEMENT_TYPE_U4 ||
-        cor_type == CorElementType::ELEMENT_TYPE_I8 ||
-        cor_type == CorElementType::ELEMENT_TYPE_U8 ||
-        cor_type == CorElementType::ELEMENT_TYPE_R4 ||
-        cor_type == CorElementType::ELEMENT_TYPE_R8) {
-      computer_ = DoNothingComputer;
-      return S_OK;
+    switch (cor_type) {
+      case CorElementType::ELEMENT_TYPE_I4:
+        computer_ = PlusOperatorComputer<int32_t>;
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_U4:
+        computer_ = PlusOperatorComputer<uint32_t>;
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_I8:
+        computer_ = PlusOperatorComputer<int64_t>;
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_U8:
+        computer_ = PlusOperatorComputer<uint64_t>;
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_R4:
+        computer_ = PlusOperatorComputer<float_t>;
+        return S_OK;
+      case CorElementType::ELEMENT_TYPE_R8:
+        computer_ = PlusOperatorComputer<double_t>;
+        return S_OK;
+      default:
+        return E_FAIL;
     }
-    return E_FAIL;
   }
 
   // - operator case.
@@ -179,77 +191,106 @@ HRESULT UnaryExpressionEvaluator::Evaluate(
       IEvalCoordinator *eval_coordinator,
       IDbgObjectFactory *obj_factory,
       std::ostream *err_stream) const {
-  std::shared_ptr<DbgObject> arg_obj;
-  HRESULT hr = arg_->Evaluate(&arg_obj, eval_coordinator,
-                              obj_factory, err_stream);
+  PrimitiveValue value;
+  HRESULT hr = EvaluatePrimitive(&value, eval_coordinator, obj_factory,
+                                 err_stream);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  return value.CreateDbgObject(dbg_object);
+}
+
+HRESULT UnaryExpressionEvaluator::EvaluatePrimitive(
+      PrimitiveValue *value,
+      IEvalCoordinator *eval_coordinator,
+      IDbgObjectFactory *obj_factory,
+      std::ostream *err_stream) const {
+  PrimitiveValue arg_value;
+  HRESULT hr = arg_->EvaluatePrimitive(&arg_value, eval_coordinator,
+                                       obj_factory, err_stream);
   if (FAILED(hr)) {
     *err_stream << kFailedToEvalFirstSubExpr;
     return hr;
   }
 
-  return computer_(arg_obj, dbg_object);
+  return computer_(arg_value, value);
 }
 
-HRESULT UnaryExpressionEvaluator::LogicalComplementComputer(
-    std::shared_ptr<DbgObject> arg_object,
-    std::shared_ptr<DbgObject> *dbg_object) {
-  if (!dbg_object) {
-    return E_INVALIDARG;
+bool UnaryExpressionEvaluator::Lower(ConditionProgram *program,
+                                     const CorElementType &type,
+                                     int dest) const {
+  const CorElementType &result_type = result_type_.cor_type;
+  switch (type_) {
+    case UnaryCSharpExpression::Type::plus:
+      return arg_->Lower(program, result_type, dest) &&
+             program->EmitConvert(result_type, type, dest);
+
+    case UnaryCSharpExpression::Type::minus:
+      return arg_->Lower(program, result_type, dest) &&
+             program->EmitOperation(ConditionProgram::OpCode::kNegate,
+                                    result_type, dest, 0) &&
+             program->EmitConvert(result_type, type, dest);
+
+    case UnaryCSharpExpression::Type::logical_complement:
+      return type == CorElementType::ELEMENT_TYPE_BOOLEAN &&
+             arg_->Lower(program, type, dest) &&
+             program->EmitOperation(ConditionProgram::OpCode::kNot, type,
+                                    dest, 0);
+
+    default:
+      return false;
   }
+}
 
+HRESULT UnaryExpressionEvaluator::LogicalComplementComputer(
+    const PrimitiveValue &arg_value, PrimitiveValue *result) {
   bool value;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<bool>(
-      arg_object.get(), &value);
+  HRESULT hr = arg_value.Get(&value);
   if (FAILED(hr)) {
     return hr;
   }
 
-  *dbg_object = std::shared_ptr<DbgObject>(new DbgPrimitive<bool>(!value));
+  result->Set(!value);
   return S_OK;
 }
 
-HRESULT UnaryExpressionEvaluator::DoNothingComputer(
-    std::shared_ptr<DbgObject> arg_object,
-    std::shared_ptr<DbgObject> *dbg_object) {
-  *dbg_object = arg_object;
+template <typename T>
+HRESULT UnaryExpressionEvaluator::PlusOperatorComputer(
+    const PrimitiveValue &arg_value, PrimitiveValue *result) {
+  T value;
+  HRESULT hr = arg_value.Get(&value);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  result->Set(value);
   return S_OK;
 }
 
 template <typename T>
 HRESULT UnaryExpressionEvaluator::MinusOperatorComputer(
-    std::shared_ptr<DbgObject> arg_object,
-    std::shared_ptr<DbgObject> *dbg_object) {
-  if (!dbg_object) {
-    return E_INVALIDARG;
-  }
-
+    const PrimitiveValue &arg_value, PrimitiveValue *result) {
   T value;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg_object.get(), &value);
+  HRESULT hr = arg_value.Get(&value);
   if (FAILED(hr)) {
     return hr;
   }
 
-  *dbg_object = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(-value));
+  result->Set(static_cast<T>(-value));
   return S_OK;
 }
 
 template <typename T>
 HRESULT UnaryExpressionEvaluator::BitwiseComplementComputer(
-    std::shared_ptr<DbgObject> arg_object,
-    std::shared_ptr<DbgObject> *dbg_object) {
-  if (!dbg_object) {
-    return E_INVALIDARG;
-  }
-
+    const PrimitiveValue &arg_value, PrimitiveValue *result) {
   T value;
-  HRESULT hr = NumericCompilerHelper::ExtractPrimitiveValue<T>(
-      arg_object.get(), &value);
+  HRESULT hr = arg_value.Get(&value);
   if (FAILED(hr)) {
     return hr;
   }
 
-  *dbg_object = std::shared_ptr<DbgObject>(new DbgPrimitive<T>(~value));
+  result->Set(static_cast<T>(~value));
   return S_OK;
 }
 
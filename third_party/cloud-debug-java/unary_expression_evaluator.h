@@ -46,13 +46,28 @@ class UnaryExpressionEvaluator : public ExpressionEvaluator {
   }
 
   // Evaluates the expression and stores the result in dbg_object.
-  // This simply calls computer_, which should have been assigned in Compile call. 
+  // This creates a DbgObject from the value of "EvaluatePrimitive".
   HRESULT Evaluate(
       std::shared_ptr<DbgObject> *dbg_object,
       IEvalCoordinator *eval_coordinator,
       IDbgObjectFactory *obj_factory,
       std::ostream *err_stream) const override;
 
+  // Evaluates the expression and stores the result in value.
+  // This simply calls computer_, which should have been assigned in Compile
+  // call, on the primitive value of the argument.
+  HRESULT EvaluatePrimitive(
+      PrimitiveValue *value,
+      IEvalCoordinator *eval_coordinator,
+      IDbgObjectFactory *obj_factory,
+      std::ostream *err_stream) const override;
+
+  // Lowers the unary plus, minus and logical complement operators.
+  bool Lower(ConditionProgram *program, const CorElementType &type,
+             int dest) const override;
+
+  bool IsStaticOnly() const override { return arg_->IsStaticOnly(); }
+
  private:
   // Tries to compile the expression for unary plus and minus operators.
   // Returns E_FAIL if the argument is not suitable.
@@ -73,28 +88,26 @@ class UnaryExpressionEvaluator : public ExpressionEvaluator {
   HRESULT CompileLogicalComplement(std::ostream *err_stream);
 
   // Computes the logical complement of a boolean argument (operator !).
-  // This extracts out value in arg_object and creates a DbgObject
-  // with value !value. Will returns failed HRESULT if arg_object is not
-  // a boolean.
-  static HRESULT LogicalComplementComputer(std::shared_ptr<DbgObject> arg_object,
-      std::shared_ptr<DbgObject> *dbg_object);
-
-  // NOP computer used for unary plus operator (+) that does nothing beyond.
-  // numeric promotion.
-  static HRESULT DoNothingComputer(std::shared_ptr<DbgObject> arg_object,
-      std::shared_ptr<DbgObject> *dbg_object);
-
-  // This extracts out value in arg_object and creates a DbgObject
-  // with value -value.
+  // This extracts out value in arg_value and stores !value in result.
+  // Will returns failed HRESULT if arg_value is not a boolean.
+  static HRESULT LogicalComplementComputer(const PrimitiveValue &arg_value,
+      PrimitiveValue *result);
+
+  // Computer used for unary plus operator (+) that does nothing beyond
+  // numeric promotion to T.
+  template <typename T>
+  static HRESULT PlusOperatorComputer(const PrimitiveValue &arg_value,
+      PrimitiveValue *result);
+
+  // This extracts out value in arg_value and stores -value in result.
   template <typename T>
-  static HRESULT MinusOperatorComputer(std::shared_ptr<DbgObject> arg_object,
-      std::shared_ptr<DbgObject> *dbg_object);
+  static HRESULT MinusOperatorComputer(const PrimitiveValue &arg_value,
+      PrimitiveValue *result);
 
-  // This extracts out value in arg_object and creates a DbgObject
-  // with value ~value.
+  // This extracts out value in arg_value and stores ~value in result.
   template <typename T>
-  static HRESULT BitwiseComplementComputer(std::shared_ptr<DbgObject> arg_object,
-      std::shared_ptr<DbgObject> *dbg_object);
+  static HRESULT BitwiseComplementComputer(const PrimitiveValue &arg_value,
+      PrimitiveValue *result);
 
  private:
   // Binary expression type (e.g. +, -, ~, !).
@@ -105,8 +118,8 @@ class UnaryExpressionEvaluator : public ExpressionEvaluator {
 
   // Pointer to a member function of this class to do the actual evaluation
   // of the unary expression.
-  HRESULT (*computer_)(std::shared_ptr<DbgObject> arg_object,
-      std::shared_ptr<DbgObject> *result_object);
+  HRESULT (*computer_)(const PrimitiveValue &arg_value,
+      PrimitiveValue *result);
 
   // Statically computed resulting type of the expression. This is what
   // computer_ is supposed product.